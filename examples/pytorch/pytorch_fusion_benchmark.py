@@ -0,0 +1,87 @@
+import argparse
+import timeit
+
+import numpy as np
+import torch
+import horovod.torch as hvd
+
+# Benchmark settings
+parser = argparse.ArgumentParser(description='PyTorch Tensor Fusion Benchmark',
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('--num-tensors', type=int, default=2000,
+                    help='number of tensors allreduced per step')
+parser.add_argument('--min-size', type=int, default=64,
+                    help='minimum number of elements of a tensor')
+parser.add_argument('--max-size', type=int, default=1 << 18,
+                    help='maximum number of elements of a tensor')
+parser.add_argument('--mixed-precision', action='store_true', default=False,
+                    help='interleave float16 and float32 tensors')
+
+parser.add_argument('--num-warmup-steps', type=int, default=10,
+                    help='number of warm-up steps that don\'t count towards benchmark')
+parser.add_argument('--num-steps-per-iter', type=int, default=10,
+                    help='number of steps per benchmark iteration')
+parser.add_argument('--num-iters', type=int, default=10,
+                    help='number of benchmark iterations')
+
+parser.add_argument('--no-cuda', action='store_true', default=False,
+                    help='disables CUDA')
+
+args = parser.parse_args()
+args.cuda = not args.no_cuda and torch.cuda.is_available()
+
+hvd.init()
+
+if args.cuda:
+    # Horovod: pin GPU to local rank.
+    torch.cuda.set_device(hvd.local_rank())
+
+# Sizes are log-uniform like the parameters of a real model, with the same
+# seed on every rank.
+rng = np.random.RandomState(42)
+sizes = np.exp(rng.uniform(np.log(args.min_size), np.log(args.max_size),
+                           args.num_tensors)).astype(np.int64)
+tensors = []
+for i, n in enumerate(sizes):
+    dtype = torch.float16 if args.mixed_precision and i % 2 else torch.float32
+    tensors.append(torch.randn(int(n)).to(dtype))
+if args.cuda:
+    tensors = [t.cuda() for t in tensors]
+
+
+def benchmark_step():
+    # Enqueue all tensors at once, as the backward pass of a model with many
+    # parameters does, so that every cycle has many ready tensors to fuse.
+    handles = [hvd.allreduce_async_(t, name='tensor.%d' % i)
+               for i, t in enumerate(tensors)]
+    hvd.synchronize_all(handles)
+
+
+def log(s, nl=True):
+    if hvd.rank() != 0:
+        return
+    print(s, end='\n' if nl else '')
+
+
+log('Number of tensors: %d' % args.num_tensors)
+log('Total size: %.1f MB' % (sum(t.numel() * t.element_size() for t in tensors) / 2**20))
+device = 'GPU' if args.cuda else 'CPU'
+log('Number of %ss: %d' % (device, hvd.size()))
+
+# Warm-up
+log('Running warmup...')
+timeit.timeit(benchmark_step, number=args.num_warmup_steps)
+
+# Benchmark
+log('Running benchmark...')
+step_times = []
+for x in range(args.num_iters):
+    time = timeit.timeit(benchmark_step, number=args.num_steps_per_iter)
+    step_ms = 1000 * time / args.num_steps_per_iter
+    log('Iter #%d: %.2f ms per step' % (x, step_ms))
+    step_times.append(step_ms)
+
+# Results
+step_mean = np.mean(step_times)
+step_conf = 1.96 * np.std(step_times)
+log('Time per step: %.2f +-%.2f ms' % (step_mean, step_conf))
@@ -0,0 +1,573 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Micro-benchmark of the Horovod collectives on raw buffers, without a
+// framework in the way. Every process is a Horovod rank, so it runs under
+// horovodrun like a training script:
+//
+//   horovodrun -np 4 horovod_benchmark --ops allreduce,allgather --num-tensors 8
+//
+// The backend is chosen as for training, e.g. with --gloo or --mpi and
+// HOROVOD_CPU_OPERATIONS / HOROVOD_GPU_OPERATIONS, and Adasum with
+// --reduce-op adasum.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if HAVE_CUDA
+#include <cuda_runtime.h>
+#endif
+
+#include "../common/common.h"
+#include "../common/message.h"
+#include "../common/metrics.h"
+#include "../common/operations.h"
+
+namespace horovod {
+namespace benchmark {
+
+using common::DataType;
+using common::Status;
+using common::TensorShape;
+
+struct Options {
+  std::vector<std::string> ops = {"allreduce"};
+  std::vector<DataType> dtypes = {common::HOROVOD_FLOAT32};
+  int64_t min_bytes = 8;
+  int64_t max_bytes = 64 << 20;
+  int64_t step_factor = 2;
+  int num_tensors = 1;
+  int warmup_iters = 5;
+  int iters = 20;
+  bool gpu = false;
+  common::ReduceOp reduce_op = common::ReduceOp::SUM;
+  bool help = false;
+};
+
+const char* USAGE =
+    "Usage: horovod_benchmark [options]\n"
+    "  --ops LIST          allreduce, allgather, broadcast, alltoall,\n"
+    "                      reducescatter (default: allreduce)\n"
+    "  --dtypes LIST       e.g. float32,float16,bfloat16 (default: float32)\n"
+    "  --min-bytes N       smallest tensor, suffixes K, M, G (default: 8)\n"
+    "  --max-bytes N       largest tensor (default: 64M)\n"
+    "  --step-factor N     size multiplier between runs (default: 2)\n"
+    "  --num-tensors N     tensors enqueued together per step (default: 1)\n"
+    "  --warmup-iters N    steps that are not timed (default: 5)\n"
+    "  --iters N           timed steps per size (default: 20)\n"
+    "  --device cpu|gpu    where the buffers live (default: cpu)\n"
+    "  --reduce-op OP      sum, adasum, min, max, product (default: sum)\n";
+
+// Memory of a tensor, on the host or on the current GPU.
+class Buffer {
+public:
+  Buffer(int64_t size, bool gpu) : size_(size), gpu_(gpu) {
+    size_t bytes = (size_t)std::max(size, (int64_t)1);
+    if (!gpu_) {
+      data_ = calloc(bytes, 1);
+      if (data_ == nullptr) {
+        throw std::bad_alloc();
+      }
+      return;
+    }
+#if HAVE_CUDA
+    if (cudaMalloc(&data_, bytes) != cudaSuccess ||
+        cudaMemset(data_, 0, bytes) != cudaSuccess) {
+      throw std::runtime_error("Failed to allocate " + std::to_string(bytes) +
+                               " bytes of GPU memory.");
+    }
+#else
+    throw std::logic_error("GPU buffers require a Horovod build with CUDA.");
+#endif
+  }
+
+  ~Buffer() {
+    if (!gpu_) {
+      free(data_);
+      return;
+    }
+#if HAVE_CUDA
+    cudaFree(data_);
+#endif
+  }
+
+  Buffer(const Buffer&) = delete;
+  Buffer& operator=(const Buffer&) = delete;
+
+  void* data() const { return data_; }
+  int64_t size() const { return size_; }
+
+private:
+  void* data_ = nullptr;
+  int64_t size_;
+  bool gpu_;
+};
+
+class BenchmarkTensor : public common::Tensor {
+public:
+  BenchmarkTensor(DataType dtype, TensorShape shape, bool gpu)
+      : dtype_(dtype), shape_(std::move(shape)),
+        buffer_(shape_.num_elements() * common::DataType_Size(dtype), gpu) {}
+
+  const DataType dtype() const override { return dtype_; }
+  const TensorShape shape() const override { return shape_; }
+  const void* data() const override { return buffer_.data(); }
+  int64_t size() const override { return buffer_.size(); }
+
+private:
+  DataType dtype_;
+  TensorShape shape_;
+  Buffer buffer_;
+};
+
+class BenchmarkPersistentBuffer : public common::PersistentBuffer {
+public:
+  BenchmarkPersistentBuffer(int64_t size, bool gpu) : buffer_(size, gpu) {}
+
+  const void*
+  AccessData(std::shared_ptr<common::OpContext> context) const override {
+    return buffer_.data();
+  }
+
+private:
+  Buffer buffer_;
+};
+
+// One context per tensor of a step. Outputs are kept for the next step with
+// the same shape, as the caching allocators of the frameworks would.
+class BenchmarkOpContext : public common::OpContext {
+public:
+  BenchmarkOpContext(DataType dtype, bool gpu) : dtype_(dtype), gpu_(gpu) {}
+
+  Status
+  AllocatePersistent(int64_t size,
+                     std::shared_ptr<common::PersistentBuffer>* tensor) override {
+    *tensor = std::make_shared<BenchmarkPersistentBuffer>(size, gpu_);
+    return Status::OK();
+  }
+
+  Status AllocateOutput(TensorShape shape,
+                        std::shared_ptr<common::Tensor>* tensor) override {
+    if (output_ == nullptr || output_->shape() != shape) {
+      output_ = std::make_shared<BenchmarkTensor>(dtype_, std::move(shape), gpu_);
+    }
+    *tensor = output_;
+    return Status::OK();
+  }
+
+  // Output 1 holds the splits received by alltoall, which are written on the
+  // host.
+  Status AllocateOutput(int output_index, TensorShape shape,
+                        std::shared_ptr<common::Tensor>* tensor) override {
+    if (output_index == 0) {
+      return AllocateOutput(std::move(shape), tensor);
+    }
+    *tensor = std::make_shared<BenchmarkTensor>(common::HOROVOD_INT32,
+                                                std::move(shape), false);
+    return Status::OK();
+  }
+
+  Status AllocateZeros(int64_t num_elements, DataType dtype,
+                       std::shared_ptr<common::Tensor>* tensor) override {
+    TensorShape shape;
+    shape.AddDim(num_elements);
+    *tensor = std::make_shared<BenchmarkTensor>(dtype, shape, gpu_);
+    return Status::OK();
+  }
+
+  // Only keys the fusion buffers, which are not shared with a framework here.
+  common::Framework framework() const override {
+    return common::Framework::PYTORCH;
+  }
+
+private:
+  DataType dtype_;
+  bool gpu_;
+  std::shared_ptr<common::Tensor> output_;
+};
+
+// Counts down the callbacks of the tensors of a step.
+class StepCompletion {
+public:
+  void Reset(int pending) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    pending_ = pending;
+    status_ = Status::OK();
+  }
+
+  common::StatusCallback Callback() {
+    return [this](const Status& status) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (!status.ok()) {
+        status_ = status;
+      }
+      --pending_;
+      cond_.notify_all();
+    };
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return pending_ == 0; });
+    if (!status_.ok()) {
+      throw std::runtime_error(status_.reason());
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  int pending_ = 0;
+  Status status_;
+};
+
+int64_t ParseBytes(const std::string& value) {
+  size_t end = 0;
+  int64_t bytes = std::stoll(value, &end);
+  std::string suffix = value.substr(end);
+  if (suffix == "K" || suffix == "k") {
+    bytes <<= 10;
+  } else if (suffix == "M" || suffix == "m") {
+    bytes <<= 20;
+  } else if (suffix == "G" || suffix == "g") {
+    bytes <<= 30;
+  } else if (!suffix.empty()) {
+    throw std::invalid_argument("Invalid size " + value + ".");
+  }
+  return bytes;
+}
+
+std::vector<std::string> SplitList(const std::string& value) {
+  std::vector<std::string> items;
+  std::stringstream ss(value);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+DataType ParseDataType(const std::string& name) {
+  for (int i = common::HOROVOD_UINT8; i <= common::HOROVOD_BFLOAT16; ++i) {
+    auto dtype = static_cast<DataType>(i);
+    if (dtype != common::HOROVOD_BOOL && common::DataType_Name(dtype) == name) {
+      return dtype;
+    }
+  }
+  throw std::invalid_argument("Unsupported dtype " + name + ".");
+}
+
+common::ReduceOp ParseReduceOp(const std::string& name) {
+  if (name == "sum") {
+    return common::ReduceOp::SUM;
+  } else if (name == "adasum") {
+    return common::ReduceOp::ADASUM;
+  } else if (name == "min") {
+    return common::ReduceOp::MIN;
+  } else if (name == "max") {
+    return common::ReduceOp::MAX;
+  } else if (name == "product") {
+    return common::ReduceOp::PRODUCT;
+  }
+  throw std::invalid_argument("Unsupported reduce op " + name + ".");
+}
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      options.help = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("Missing value of " + arg + ".");
+    }
+    std::string value = argv[++i];
+    if (arg == "--ops") {
+      options.ops = SplitList(value);
+      for (auto& op : options.ops) {
+        if (op != "allreduce" && op != "allgather" && op != "broadcast" &&
+            op != "alltoall" && op != "reducescatter") {
+          throw std::invalid_argument("Unsupported op " + op + ".");
+        }
+      }
+    } else if (arg == "--dtypes") {
+      options.dtypes.clear();
+      for (auto& name : SplitList(value)) {
+        options.dtypes.push_back(ParseDataType(name));
+      }
+    } else if (arg == "--min-bytes") {
+      options.min_bytes = ParseBytes(value);
+    } else if (arg == "--max-bytes") {
+      options.max_bytes = ParseBytes(value);
+    } else if (arg == "--step-factor") {
+      options.step_factor = std::stoll(value);
+    } else if (arg == "--num-tensors") {
+      options.num_tensors = std::stoi(value);
+    } else if (arg == "--warmup-iters") {
+      options.warmup_iters = std::stoi(value);
+    } else if (arg == "--iters") {
+      options.iters = std::stoi(value);
+    } else if (arg == "--device") {
+      if (value != "cpu" && value != "gpu") {
+        throw std::invalid_argument("Unsupported device " + value + ".");
+      }
+      options.gpu = value == "gpu";
+    } else if (arg == "--reduce-op") {
+      options.reduce_op = ParseReduceOp(value);
+    } else {
+      throw std::invalid_argument("Unknown option " + arg + ".");
+    }
+  }
+  if (options.ops.empty() || options.dtypes.empty() ||
+      options.min_bytes <= 0 || options.max_bytes < options.min_bytes ||
+      options.step_factor < 2 || options.num_tensors < 1 ||
+      options.warmup_iters < 0 || options.iters < 1) {
+    throw std::invalid_argument("Invalid benchmark options.");
+  }
+  return options;
+}
+
+// Ratio of the bytes every rank sends over its busiest link to the bytes of
+// the operation, as defined by nccl-tests, so that bus bandwidths can be
+// compared to the hardware peak.
+double BusBandwidthFactor(const std::string& op, int size) {
+  if (op == "allreduce") {
+    return 2.0 * (size - 1) / size;
+  } else if (op == "broadcast") {
+    return 1.0;
+  }
+  return (double)(size - 1) / size;
+}
+
+// Runs the timed steps of one op, dtype and tensor size.
+class BenchmarkCase {
+public:
+  BenchmarkCase(const Options& options, const std::string& op, DataType dtype,
+                int64_t num_elements, int device)
+      : options_(options), op_(op), dtype_(dtype), device_(device) {
+    TensorShape shape;
+    shape.AddDim(num_elements);
+    for (int i = 0; i < options.num_tensors; ++i) {
+      contexts_.push_back(
+          std::make_shared<BenchmarkOpContext>(dtype, options.gpu));
+      tensors_.push_back(
+          std::make_shared<BenchmarkTensor>(dtype, shape, options.gpu));
+      outputs_.push_back(op == "allreduce"
+                             ? std::make_shared<BenchmarkTensor>(dtype, shape,
+                                                                 options.gpu)
+                             : tensors_.back());
+      names_.push_back("benchmark." + op + "." + common::DataType_Name(dtype) +
+                       "." + std::to_string(num_elements) + "." +
+                       std::to_string(i));
+    }
+    // Empty splits divide the first dimension evenly among the ranks.
+    TensorShape splits_shape;
+    splits_shape.AddDim(0);
+    splits_ = std::make_shared<BenchmarkTensor>(common::HOROVOD_INT32,
+                                                splits_shape, false);
+  }
+
+  void Step() {
+    completion_.Reset(options_.num_tensors);
+    for (int i = 0; i < options_.num_tensors; ++i) {
+      Status status = Enqueue(i);
+      if (!status.ok()) {
+        throw std::runtime_error(status.reason());
+      }
+    }
+    completion_.Wait();
+#if HAVE_CUDA
+    // With async completion the callbacks only mean that the work is queued.
+    if (options_.gpu) {
+      cudaDeviceSynchronize();
+    }
+#endif
+  }
+
+private:
+  Status Enqueue(int i) {
+    common::ReadyEventList ready_events;
+    auto callback = completion_.Callback();
+    if (op_ == "allreduce") {
+      return common::EnqueueTensorAllreduce(
+          contexts_[i], tensors_[i], outputs_[i], ready_events, names_[i],
+          device_, callback, options_.reduce_op);
+    } else if (op_ == "allgather") {
+      return common::EnqueueTensorAllgather(contexts_[i], tensors_[i],
+                                            ready_events, names_[i], device_,
+                                            callback);
+    } else if (op_ == "broadcast") {
+      return common::EnqueueTensorBroadcast(contexts_[i], tensors_[i],
+                                            outputs_[i], 0, ready_events,
+                                            names_[i], device_, callback);
+    } else if (op_ == "alltoall") {
+      return common::EnqueueTensorAlltoall(contexts_[i], tensors_[i], splits_,
+                                           ready_events, names_[i], device_,
+                                           callback);
+    }
+    return common::EnqueueTensorReducescatter(
+        contexts_[i], tensors_[i], ready_events, names_[i], device_, callback,
+        options_.reduce_op);
+  }
+
+  const Options& options_;
+  std::string op_;
+  DataType dtype_;
+  int device_;
+  std::vector<std::shared_ptr<common::OpContext>> contexts_;
+  std::vector<std::shared_ptr<common::Tensor>> tensors_;
+  std::vector<std::shared_ptr<common::Tensor>> outputs_;
+  std::vector<std::string> names_;
+  std::shared_ptr<common::Tensor> splits_;
+  StepCompletion completion_;
+};
+
+std::vector<long long> GetMetrics() {
+  std::vector<long long> values(common::horovod_num_metrics());
+  common::horovod_get_metrics(values.data());
+  return values;
+}
+
+void Run(const Options& options) {
+  int rank = common::horovod_rank();
+  int size = common::horovod_size();
+  int device = CPU_DEVICE_ID;
+  if (options.gpu) {
+#if HAVE_CUDA
+    device = common::horovod_local_rank();
+    cudaSetDevice(device);
+#else
+    throw std::invalid_argument("--device gpu requires a Horovod build with CUDA.");
+#endif
+  }
+
+  if (rank == 0) {
+    printf("# ranks: %d, controller: %s, device: %s, reduce op: %s\n", size,
+           common::horovod_mpi_enabled() ? "mpi" : "gloo",
+           options.gpu ? "gpu" : "cpu",
+           common::ReduceOp_Name(options.reduce_op).c_str());
+    printf("# Sizes are per tensor and rank. Bandwidths are for all tensors of "
+           "a step, in GB/s.\n");
+    printf("%-14s %-9s %12s %8s %12s %10s %10s %12s %16s\n", "# op", "dtype",
+           "bytes", "tensors", "time(us)", "algbw", "busbw", "cycles/step",
+           "negotiate(us/cy)");
+  }
+
+  for (auto& op : options.ops) {
+    for (auto dtype : options.dtypes) {
+      int64_t element_size = common::DataType_Size(dtype);
+      // Tensors of alltoall and reducescatter are split evenly among ranks.
+      bool split = op == "alltoall" || op == "reducescatter";
+      int64_t last_elements = 0;
+      for (int64_t bytes = options.min_bytes; bytes <= options.max_bytes;
+           bytes *= options.step_factor) {
+        int64_t num_elements = std::max(bytes / element_size, (int64_t)1);
+        if (split) {
+          num_elements = (num_elements + size - 1) / size * size;
+        }
+        if (num_elements == last_elements) {
+          continue;
+        }
+        last_elements = num_elements;
+
+        BenchmarkCase benchmark_case(options, op, dtype, num_elements, device);
+        for (int i = 0; i < options.warmup_iters; ++i) {
+          benchmark_case.Step();
+        }
+
+        auto metrics_before = GetMetrics();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < options.iters; ++i) {
+          benchmark_case.Step();
+        }
+        double time_us = std::chrono::duration<double, std::micro>(
+                             std::chrono::steady_clock::now() - start)
+                             .count() /
+                         options.iters;
+        auto metrics_after = GetMetrics();
+
+        double cycles = metrics_after[common::METRIC_CYCLES] -
+                        metrics_before[common::METRIC_CYCLES];
+        double negotiation_us =
+            metrics_after[common::METRIC_NEGOTIATION_TIME_US] -
+            metrics_before[common::METRIC_NEGOTIATION_TIME_US];
+
+        // Allgather moves the tensors of all ranks, the others one tensor.
+        double step_bytes =
+            (double)num_elements * element_size * options.num_tensors;
+        if (op == "allgather") {
+          step_bytes *= size;
+        }
+        double algbw = step_bytes / time_us / 1e3;
+        if (rank == 0) {
+          printf("%-14s %-9s %12lld %8d %12.1f %10.3f %10.3f %12.2f %16.1f\n",
+                 op.c_str(), common::DataType_Name(dtype).c_str(),
+                 (long long)(num_elements * element_size), options.num_tensors,
+                 time_us, algbw, algbw * BusBandwidthFactor(op, size),
+                 cycles / options.iters,
+                 cycles > 0 ? negotiation_us / cycles : 0.0);
+          fflush(stdout);
+        }
+      }
+    }
+  }
+}
+
+} // namespace benchmark
+} // namespace horovod
+
+int main(int argc, char** argv) {
+  using namespace horovod;
+
+  benchmark::Options options;
+  try {
+    options = benchmark::ParseOptions(argc, argv);
+  } catch (const std::exception& e) {
+    fprintf(stderr, "%s\n%s", e.what(), benchmark::USAGE);
+    return 1;
+  }
+  if (options.help) {
+    printf("%s", benchmark::USAGE);
+    return 0;
+  }
+
+  if (!common::horovod_init(nullptr, 0, nullptr, nullptr, 0)) {
+    fprintf(stderr, "Horovod failed to initialize.\n");
+    return 1;
+  }
+  int result = 0;
+  try {
+    benchmark::Run(options);
+  } catch (const std::exception& e) {
+    fprintf(stderr, "Rank %d: %s\n", common::horovod_rank(), e.what());
+    result = 1;
+  }
+  common::horovod_shutdown();
+  return result;
+}
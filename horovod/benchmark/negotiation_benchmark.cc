@@ -0,0 +1,526 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Benchmark of the negotiation on the coordinator, with thousands of
+// simulated ranks in a single process. A controller without communication
+// plays rank 0 and receives the requests of the other ranks from simulated
+// workers, so that ComputeResponseList, the response cache and its
+// coordination, the fusion of responses and the stall inspector run as in a
+// job of that size:
+//
+//   horovod_negotiation_benchmark --ranks 64,1024,8192 --tensors 100,1000
+//
+// Workers that enqueue the same tensors send the same requests, so they are
+// serialized once per group of workers, while the coordinator decodes them
+// once per rank as it would in a job. Reported times are the CPU time of the
+// coordinator thread in ComputeResponseList, bytes are those it would receive
+// and send.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../common/common.h"
+#include "../common/controller.h"
+#include "../common/global_state.h"
+#include "../common/message.h"
+#include "../common/process_set.h"
+
+namespace horovod {
+namespace benchmark {
+
+using common::DataType;
+using common::Request;
+using common::RequestList;
+using common::ResponseList;
+using common::Status;
+using common::TensorShape;
+
+struct Options {
+  std::vector<int> ranks = {64, 512, 4096};
+  std::vector<int> tensors = {100, 1000};
+  int64_t tensor_bytes = 64 << 10;
+  int64_t fusion_threshold = 64 << 20;
+  int cache_capacity = 1024;
+  int stragglers = 0;
+  int stall_warning_seconds = 60;
+  int warmup_steps = 2;
+  int steps = 10;
+  bool help = false;
+};
+
+const char* USAGE =
+    "Usage: horovod_negotiation_benchmark [options]\n"
+    "  --ranks LIST                simulated ranks (default: 64,512,4096)\n"
+    "  --tensors LIST              tensors enqueued per step (default: "
+    "100,1000)\n"
+    "  --tensor-bytes N            bytes per tensor, suffixes K, M, G\n"
+    "                              (default: 64K)\n"
+    "  --fusion-threshold N        tensor fusion threshold (default: 64M)\n"
+    "  --cache-capacity N          response cache capacity, 0 disables it\n"
+    "                              (default: 1024)\n"
+    "  --stragglers N              ranks whose requests arrive one cycle "
+    "late,\n"
+    "                              requires --cache-capacity 0 (default: 0)\n"
+    "  --stall-warning-seconds N   stall check interval, 0 disables it\n"
+    "                              (default: 60)\n"
+    "  --warmup-steps N            steps that are not measured (default: 2)\n"
+    "  --steps N                   measured steps (default: 10)\n";
+
+// Only the shape of the tensors matters to the negotiation.
+class SimulatedTensor : public common::Tensor {
+public:
+  explicit SimulatedTensor(TensorShape shape) : shape_(std::move(shape)) {}
+
+  const DataType dtype() const override { return common::HOROVOD_FLOAT32; }
+  const TensorShape shape() const override { return shape_; }
+  const void* data() const override { return nullptr; }
+  int64_t size() const override {
+    return shape_.num_elements() * common::DataType_Size(dtype());
+  }
+
+private:
+  TensorShape shape_;
+};
+
+int64_t ParseBytes(const std::string& value) {
+  size_t end = 0;
+  int64_t bytes = std::stoll(value, &end);
+  std::string suffix = value.substr(end);
+  if (suffix == "K" || suffix == "k") {
+    bytes <<= 10;
+  } else if (suffix == "M" || suffix == "m") {
+    bytes <<= 20;
+  } else if (suffix == "G" || suffix == "g") {
+    bytes <<= 30;
+  } else if (!suffix.empty()) {
+    throw std::invalid_argument("Invalid size " + value + ".");
+  }
+  return bytes;
+}
+
+std::vector<int> ParseIntList(const std::string& value) {
+  std::vector<int> items;
+  std::stringstream ss(value);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(std::stoi(item));
+    }
+  }
+  return items;
+}
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      options.help = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("Missing value of " + arg + ".");
+    }
+    std::string value = argv[++i];
+    if (arg == "--ranks") {
+      options.ranks = ParseIntList(value);
+    } else if (arg == "--tensors") {
+      options.tensors = ParseIntList(value);
+    } else if (arg == "--tensor-bytes") {
+      options.tensor_bytes = ParseBytes(value);
+    } else if (arg == "--fusion-threshold") {
+      options.fusion_threshold = ParseBytes(value);
+    } else if (arg == "--cache-capacity") {
+      options.cache_capacity = std::stoi(value);
+    } else if (arg == "--stragglers") {
+      options.stragglers = std::stoi(value);
+    } else if (arg == "--stall-warning-seconds") {
+      options.stall_warning_seconds = std::stoi(value);
+    } else if (arg == "--warmup-steps") {
+      options.warmup_steps = std::stoi(value);
+    } else if (arg == "--steps") {
+      options.steps = std::stoi(value);
+    } else {
+      throw std::invalid_argument("Unknown option " + arg + ".");
+    }
+  }
+  if (options.ranks.empty() || options.tensors.empty() ||
+      options.tensor_bytes < 4 || options.fusion_threshold < 0 ||
+      options.cache_capacity < 0 || options.stragglers < 0 ||
+      options.stall_warning_seconds < 0 || options.warmup_steps < 0 ||
+      options.steps < 1) {
+    throw std::invalid_argument("Invalid benchmark options.");
+  }
+  for (int size : options.ranks) {
+    if (size < 2 || options.stragglers >= size) {
+      throw std::invalid_argument("Every run needs at least two ranks and "
+                                  "more ranks than stragglers.");
+    }
+  }
+  for (int num_tensors : options.tensors) {
+    if (num_tensors < 1) {
+      throw std::invalid_argument("Invalid number of tensors.");
+    }
+  }
+  // The cache bits of stragglers would differ from those of the other ranks,
+  // which the identity bitwise operations below cannot combine.
+  if (options.stragglers > 0 && options.cache_capacity > 0) {
+    throw std::invalid_argument("--stragglers requires --cache-capacity 0.");
+  }
+  return options;
+}
+
+// Counters of the messages of the coordinator.
+struct MessageStats {
+  int64_t request_bytes = 0;
+  int64_t response_bytes = 0;
+  int64_t sync_bytes = 0;
+};
+
+// Workers that send the same requests every cycle.
+class WorkerGroup {
+public:
+  // Serializes requests as each worker of the group would send them.
+  void Prepare(const std::vector<Request>& requests) {
+    RequestList request_list;
+    for (auto& request : requests) {
+      request_list.add_request(request);
+    }
+    compressor_.Compress(request_list);
+    RequestList::SerializeToString(request_list, bytes_);
+  }
+
+  const std::string& bytes() const { return bytes_; }
+
+private:
+  common::RequestCompressor compressor_;
+  std::string bytes_;
+};
+
+// Coordinator of a process set of simulated ranks, without communication.
+// Ranks 1 to size - stragglers - 1 enqueue their tensors together with rank
+// 0, the other ranks one cycle later.
+class SimulatedController : public common::Controller {
+public:
+  SimulatedController(int size, int stragglers, common::ProcessSet& process_set,
+                      common::HorovodGlobalState& state)
+      : common::Controller(process_set.response_cache,
+                           process_set.tensor_queue, state.timeline,
+                           state.parameter_manager, process_set.group_table,
+                           state.timeline_controller),
+        simulated_size_(size), stragglers_(stragglers) {}
+
+  // Requests that every rank enqueued since the last cycle. Must be called
+  // before each ComputeResponseList().
+  void BeginCycle(const std::vector<Request>& requests) {
+    // Workers only send requests that miss the cache, as rank 0 does.
+    std::vector<Request> uncached;
+    for (auto& request : requests) {
+      if (response_cache_.capacity() == 0 ||
+          response_cache_.cached(request) !=
+              common::ResponseCache::CacheState::HIT) {
+        uncached.push_back(request);
+      }
+    }
+    on_time_.Prepare(uncached);
+    if (stragglers_ > 0) {
+      stragglers_group_.Prepare(late_requests_);
+      late_requests_ = std::move(uncached);
+    }
+  }
+
+  MessageStats& stats() { return stats_; }
+
+  int GetTypeSize(DataType dtype) override {
+    return common::DataType_Size(dtype);
+  }
+
+  // Every rank has the same cache bits, so the result is the input.
+  void CrossRankBitwiseAnd(std::vector<long long>& bitvector,
+                           int count) override {
+    stats_.sync_bytes += count * (int64_t)sizeof(long long);
+  }
+
+  void CrossRankBitwiseOr(std::vector<long long>& bitvector,
+                          int count) override {
+    stats_.sync_bytes += count * (int64_t)sizeof(long long);
+  }
+
+  void Bcast(void* buffer, size_t size, int root_rank,
+             common::Communicator communicator) override {}
+
+  void AlltoallGetRecvSplits(const std::vector<int32_t>& splits,
+                             std::vector<int32_t>& recvsplits) override {
+    throw std::logic_error("Alltoall is not simulated.");
+  }
+
+  void Barrier(common::Communicator communicator) override {}
+
+  void Allgather2Ints(std::array<int, 2> values,
+                      std::vector<int>& recv_values) override {
+    recv_values.resize(2 * size_);
+    for (int i = 0; i < size_; ++i) {
+      recv_values[2 * i] = values[0];
+      recv_values[2 * i + 1] = values[1];
+    }
+  }
+
+  void AllgatherInt64s(const std::vector<int64_t>& values,
+                       std::vector<int64_t>& recv_values) override {
+    recv_values.clear();
+    recv_values.reserve(values.size() * size_);
+    for (int i = 0; i < size_; ++i) {
+      recv_values.insert(recv_values.end(), values.begin(), values.end());
+    }
+  }
+
+protected:
+  void DoInitialization() override {
+    rank_ = 0;
+    size_ = simulated_size_;
+    local_rank_ = 0;
+    local_size_ = 1;
+    cross_rank_ = 0;
+    cross_size_ = size_;
+    is_coordinator_ = true;
+    is_homogeneous_ = true;
+    local_comm_ranks_ = {0};
+    local_sizes_for_cross_rank_.assign(cross_size_, 1);
+    global_ranks_.resize(size_);
+    for (int r = 0; r < size_; ++r) {
+      global_ranks_[r] = r;
+      global_rank_to_controller_rank_[r] = r;
+    }
+  }
+
+  // Decodes the requests of every rank, as received from the network.
+  void RecvReadyTensors(std::vector<std::string>& ready_to_reduce,
+                        std::vector<RequestList>& ready_list) override {
+    ready_list.resize(size_);
+    int first_straggler = size_ - stragglers_;
+    for (int i = 1; i < size_; ++i) {
+      const auto& bytes = i < first_straggler ? on_time_.bytes()
+                                              : stragglers_group_.bytes();
+      RequestList::ParseFromBytes(ready_list[i], (const uint8_t*)bytes.c_str());
+      for (auto& request : ready_list[i].mutable_requests()) {
+        request.set_request_rank(i);
+      }
+      stats_.request_bytes += (int64_t)bytes.size();
+    }
+  }
+
+  void SendReadyTensors(RequestList& message_list) override {
+    throw std::logic_error("The simulated controller is the coordinator.");
+  }
+
+  void SendFinalTensors(ResponseList& response_list) override {
+    ResponseList::SerializeToString(response_list, encoded_message_);
+    stats_.response_bytes += (int64_t)encoded_message_.size();
+  }
+
+  void RecvFinalTensors(ResponseList& response_list) override {
+    throw std::logic_error("The simulated controller is the coordinator.");
+  }
+
+private:
+  int simulated_size_;
+  int stragglers_;
+  WorkerGroup on_time_;
+  WorkerGroup stragglers_group_;
+  // Requests the stragglers send in the next cycle.
+  std::vector<Request> late_requests_;
+  std::string encoded_message_;
+  MessageStats stats_;
+};
+
+double ThreadCpuTimeUs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+struct StepStats {
+  int64_t cycles = 0;
+  int64_t responses = 0;
+  double cpu_us = 0;
+};
+
+// Negotiates the steps of one number of ranks and tensors.
+class BenchmarkCase {
+public:
+  BenchmarkCase(const Options& options, int size, int num_tensors)
+      : num_tensors_(num_tensors), state_(new common::HorovodGlobalState()),
+        process_set_(new common::ProcessSet()) {
+    state_->cache_capacity = (uint32_t)options.cache_capacity;
+    state_->parameter_manager.SetTensorFusionThresholdBytes(
+        options.fusion_threshold, true);
+    process_set_->response_cache.set_capacity(state_->cache_capacity);
+
+    controller_ = std::make_shared<SimulatedController>(
+        size, options.stragglers, *process_set_, *state_);
+    auto& stall_inspector = controller_->GetStallInspector();
+    stall_inspector.SetPerformStallCheck(options.stall_warning_seconds > 0);
+    stall_inspector.SetStallWarningTimeSeconds(options.stall_warning_seconds);
+    process_set_->controller = controller_;
+    controller_->Initialize();
+
+    TensorShape shape;
+    shape.AddDim(options.tensor_bytes / common::DataType_Size(
+                                            common::HOROVOD_FLOAT32));
+    for (int i = 0; i < num_tensors; ++i) {
+      tensors_.push_back(std::make_shared<SimulatedTensor>(shape));
+      names_.push_back("negotiation." + std::to_string(i));
+    }
+  }
+
+  StepStats Step() {
+    std::vector<Request> requests;
+    requests.reserve(num_tensors_);
+    for (int i = 0; i < num_tensors_; ++i) {
+      Request message;
+      message.set_request_rank(0);
+      message.set_tensor_name(names_[i]);
+      message.set_tensor_type(tensors_[i]->dtype());
+      message.set_device(CPU_DEVICE_ID);
+      message.set_request_type(Request::ALLREDUCE);
+      message.set_reduce_op(common::ReduceOp::SUM);
+      message.set_tensor_shape(tensors_[i]->shape().to_vector());
+      requests.push_back(message);
+
+      common::TensorTableEntry e;
+      e.tensor_name = names_[i];
+      e.tensor = tensors_[i];
+      e.output = tensors_[i];
+      e.device = CPU_DEVICE_ID;
+      e.callback = [](const Status& status) {};
+      Status status = process_set_->tensor_queue.AddToTensorQueue(e, message);
+      if (!status.ok()) {
+        throw std::runtime_error(status.reason());
+      }
+    }
+
+    StepStats stats;
+    int completed = 0;
+    while (completed < num_tensors_) {
+      // Bounds the cycles in case the simulation misses a request.
+      if (stats.cycles > 100) {
+        throw std::runtime_error("Tensors did not complete after " +
+                                 std::to_string(stats.cycles) + " cycles.");
+      }
+      controller_->BeginCycle(stats.cycles == 0 ? requests
+                                                : std::vector<Request>());
+      double start = ThreadCpuTimeUs();
+      ResponseList response_list =
+          controller_->ComputeResponseList(false, *state_, *process_set_);
+      stats.cpu_us += ThreadCpuTimeUs() - start;
+      stats.cycles++;
+
+      for (auto& response : response_list.responses()) {
+        if (response.response_type() == common::Response::ERROR) {
+          throw std::runtime_error(response.error_message());
+        }
+        std::vector<common::TensorTableEntry> entries;
+        process_set_->tensor_queue.GetTensorEntriesFromResponse(response,
+                                                                entries);
+        completed += (int)entries.size();
+        stats.responses++;
+      }
+    }
+    return stats;
+  }
+
+  MessageStats& message_stats() { return controller_->stats(); }
+
+private:
+  int num_tensors_;
+  std::unique_ptr<common::HorovodGlobalState> state_;
+  std::unique_ptr<common::ProcessSet> process_set_;
+  std::shared_ptr<SimulatedController> controller_;
+  std::vector<std::shared_ptr<common::Tensor>> tensors_;
+  std::vector<std::string> names_;
+};
+
+void Run(const Options& options) {
+  printf("# tensor bytes: %lld, fusion threshold: %lld, cache capacity: %d, "
+         "stragglers: %d\n",
+         (long long)options.tensor_bytes, (long long)options.fusion_threshold,
+         options.cache_capacity, options.stragglers);
+  printf("# Times are CPU time of the coordinator, bytes are per cycle.\n");
+  printf("%-8s %8s %12s %12s %12s %15s %15s %12s\n", "# ranks", "tensors",
+         "cycles/step", "cpu(us/cy)", "cpu(us/step)", "requests(B/cy)",
+         "responses(B/cy)", "sync(B/cy)");
+
+  for (int size : options.ranks) {
+    for (int num_tensors : options.tensors) {
+      BenchmarkCase benchmark_case(options, size, num_tensors);
+      for (int i = 0; i < options.warmup_steps; ++i) {
+        benchmark_case.Step();
+      }
+
+      auto& message_stats = benchmark_case.message_stats();
+      message_stats = MessageStats();
+      StepStats total;
+      for (int i = 0; i < options.steps; ++i) {
+        auto stats = benchmark_case.Step();
+        total.cycles += stats.cycles;
+        total.responses += stats.responses;
+        total.cpu_us += stats.cpu_us;
+      }
+
+      double cycles = (double)total.cycles;
+      printf("%-8d %8d %12.2f %12.1f %12.1f %15.0f %15.0f %12.0f\n", size,
+             num_tensors, cycles / options.steps, total.cpu_us / cycles,
+             total.cpu_us / options.steps,
+             message_stats.request_bytes / cycles,
+             message_stats.response_bytes / cycles,
+             message_stats.sync_bytes / cycles);
+      fflush(stdout);
+    }
+  }
+}
+
+} // namespace benchmark
+} // namespace horovod
+
+int main(int argc, char** argv) {
+  using namespace horovod;
+
+  benchmark::Options options;
+  try {
+    options = benchmark::ParseOptions(argc, argv);
+  } catch (const std::exception& e) {
+    fprintf(stderr, "%s\n%s", e.what(), benchmark::USAGE);
+    return 1;
+  }
+  if (options.help) {
+    printf("%s", benchmark::USAGE);
+    return 0;
+  }
+
+  try {
+    benchmark::Run(options);
+  } catch (const std::exception& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -36,6 +36,9 @@ class HorovodBasics(object):
         self.Average = self.MPI_LIB_CTYPES.horovod_reduce_op_average()
         self.Sum = self.MPI_LIB_CTYPES.horovod_reduce_op_sum()
         self.Adasum = self.MPI_LIB_CTYPES.horovod_reduce_op_adasum()
+        self.Min = self.MPI_LIB_CTYPES.horovod_reduce_op_min()
+        self.Max = self.MPI_LIB_CTYPES.horovod_reduce_op_max()
+        self.Product = self.MPI_LIB_CTYPES.horovod_reduce_op_product()
 
         # These must be kept in sync with operations.cc (this might also be possible via ctypes)
         self.HOROVOD_PROCESS_SET_ERROR_INIT = -1
@@ -45,6 +48,14 @@ class HorovodBasics(object):
         self.HOROVOD_PROCESS_SET_ERROR_SHUTDOWN = -5
         self.HOROVOD_PROCESS_SET_ERROR_EXISTING_SET = -6
 
+        self.HOROVOD_BROADCAST_BYTES_ERROR_INIT = -1
+        self.HOROVOD_BROADCAST_BYTES_ERROR_UNSUPPORTED = -2
+
+        self.HOROVOD_BARRIER_ERROR_INIT = -1
+        self.HOROVOD_BARRIER_ERROR_UNSUPPORTED = -2
+        self.HOROVOD_BARRIER_ERROR_UNKNOWN_SET = -4
+        self.HOROVOD_BARRIER_ERROR_FOREIGN_SET = -5
+
     def init(self, comm: Optional[Union[Sequence[int], MPI.Comm]] = None,
              process_sets: Optional[Sequence[ProcessSet]] = None):
         """A function that initializes Horovod.
@@ -144,9 +155,19 @@ class HorovodBasics(object):
                 raise ValueError(
                     f"Horovod could not be initialized because process_sets entry number {ps_idx} is a duplicate: {ps}")
 
-    def shutdown(self):
-        """A function that shuts Horovod down."""
-        self.MPI_LIB_CTYPES.horovod_shutdown()
+    def shutdown(self, keep_state=False):
+        """A function that shuts Horovod down.
+
+        Args:
+          keep_state: Keep GPU buffers, NCCL communicators and tuned parameters
+                      for the next `init()` in this process, as elastic resets
+                      do. Communicators are only reused if all their members
+                      are still around.
+        """
+        if keep_state:
+            self.MPI_LIB_CTYPES.horovod_shutdown_for_reset()
+        else:
+            self.MPI_LIB_CTYPES.horovod_shutdown()
 
     def is_initialized(self):
         """Returns True if Horovod is initialized"""
@@ -369,6 +390,189 @@ class HorovodBasics(object):
         """
         return bool(self.MPI_LIB_CTYPES.horovod_rocm_built())
 
+    def register_gradient_arena(self, address: int, nbytes: int, alignment: int = 256) -> bool:
+        """Registers a contiguous buffer of gradients that are allreduced in place.
+
+        Every gradient must start at an offset from `address` that is a multiple of
+        `alignment` bytes. Fused allreduces of gradients from the same buffer are then
+        reduced directly in it, without copies through the fusion buffer.
+
+        Returns:
+          False if the buffer overlaps one that is already registered.
+        """
+        return bool(self.MPI_LIB_CTYPES.horovod_register_gradient_arena(
+            ctypes.c_void_p(address), ctypes.c_longlong(nbytes), ctypes.c_longlong(alignment)))
+
+    def unregister_gradient_arena(self, address: int) -> bool:
+        """Unregisters a buffer passed to `register_gradient_arena`.
+
+        Returns:
+          False if no buffer was registered at that address.
+        """
+        return bool(self.MPI_LIB_CTYPES.horovod_unregister_gradient_arena(
+            ctypes.c_void_p(address)))
+
+    def metrics(self) -> Dict[str, int]:
+        """Returns the cumulative performance counters of this process.
+
+        Counters are kept by the background thread at all times, unlike the
+        timeline. They include the number of cycles, time spent negotiating and
+        waiting in the tensor queue, response cache hits and misses, and the number
+        of responses, bytes and time per collective operation. Times are in
+        microseconds. Rates are obtained by sampling the counters periodically.
+
+        Returns:
+          A dictionary from counter name to value.
+        """
+        num_metrics = int(self.MPI_LIB_CTYPES.horovod_num_metrics())
+        values = (ctypes.c_longlong * num_metrics)()
+        if int(self.MPI_LIB_CTYPES.horovod_get_metrics(values)) != 0:
+            raise ValueError('Horovod has not been initialized; use hvd.init().')
+        self.MPI_LIB_CTYPES.horovod_metric_name.restype = ctypes.c_char_p
+        return {self.MPI_LIB_CTYPES.horovod_metric_name(ctypes.c_int(i)).decode(): int(values[i])
+                for i in range(num_metrics)}
+
+    def metrics_prometheus(self) -> str:
+        """Returns the counters of `metrics` in the Prometheus text exposition
+        format, labeled with the rank of this process."""
+        lines = []
+        rank = self.rank()
+        for name, value in self.metrics().items():
+            metric = 'horovod_{}'.format(name)
+            lines.append('# TYPE {} counter'.format(metric))
+            lines.append('{}{{rank="{}"}} {}'.format(metric, rank, value))
+        return '\n'.join(lines) + '\n'
+
+    def step_begin(self):
+        """Marks the start of a training step, e.g. before its forward pass.
+
+        Operations that complete until `step_end` are attributed to the step.
+        Reporting costs some time per operation from the first call on.
+        """
+        if int(self.MPI_LIB_CTYPES.horovod_step_begin()) != 0:
+            raise ValueError('Horovod has not been initialized; use hvd.init().')
+
+    def step_end(self, max_critical_tensors: int = 8) -> Dict[str, Any]:
+        """Ends the step started by `step_begin`, once the framework has waited
+        for its operations, e.g. after the optimizer step.
+
+        The step is taken to compute until its last tensor was enqueued.
+        Communication after that point was not overlapped with compute and is
+        reported as exposed.
+
+        Arguments:
+            max_critical_tensors: Maximum number of tensors reported under
+                `critical_tensors`.
+
+        Returns:
+          A dictionary with the times of the step in microseconds:
+          `step_time_us`, `compute_end_us` until the last tensor was enqueued,
+          `communication_time_us` while any operation ran,
+          `exposed_communication_us` of that after the compute end,
+          `exposed_time_us` from the compute end until the last tensor
+          completed, and `cycle_wait_us` tensors waited for the background
+          thread to wake up, as well as the number of `tensors` of the step.
+          `critical_tensors` lists the names of the tensors that completed
+          after the compute end, the last one first, with the microseconds
+          they completed after it.
+        """
+        num_values = int(self.MPI_LIB_CTYPES.horovod_step_num_values())
+        values = (ctypes.c_longlong * num_values)()
+        names = (ctypes.c_char_p * max_critical_tensors)()
+        times = (ctypes.c_longlong * max_critical_tensors)()
+        num_tensors = int(self.MPI_LIB_CTYPES.horovod_step_end(
+            values, names, times, ctypes.c_int(max_critical_tensors)))
+        if num_tensors == -1:
+            raise ValueError('No step has been started; use hvd.step_begin() after hvd.init().')
+        self.MPI_LIB_CTYPES.horovod_step_value_name.restype = ctypes.c_char_p
+        report = {self.MPI_LIB_CTYPES.horovod_step_value_name(ctypes.c_int(i)).decode(): int(values[i])
+                  for i in range(num_values)}
+        report['critical_tensors'] = [(names[i].decode(), int(times[i]))
+                                      for i in range(min(num_tensors, max_critical_tensors))]
+        return report
+
+    def memory_usage(self) -> Dict[Tuple[int, str], int]:
+        """Returns the bytes of the buffers Horovod keeps between operations,
+        such as fusion buffers, host staging buffers of GPU operations and
+        pooled output buffers.
+
+        Returns:
+          A dictionary from (device, category) to bytes, where device is -1 for
+          host memory.
+        """
+        max_entries = 0
+        while True:
+            devices = (ctypes.c_int * max_entries)()
+            categories = (ctypes.c_char_p * max_entries)()
+            sizes = (ctypes.c_longlong * max_entries)()
+            num_entries = int(self.MPI_LIB_CTYPES.horovod_memory_usage(
+                devices, categories, sizes, ctypes.c_int(max_entries)))
+            if num_entries == -1:
+                raise ValueError('Horovod has not been initialized; use hvd.init().')
+            if num_entries <= max_entries:
+                return {(int(devices[i]), categories[i].decode()): int(sizes[i])
+                        for i in range(num_entries)}
+            max_entries = num_entries
+
+    def release_buffers(self):
+        """Frees the buffers Horovod keeps between operations, e.g. before an
+        evaluation phase that needs the memory. They are allocated again by the
+        next operations that need them."""
+        if int(self.MPI_LIB_CTYPES.horovod_release_buffers()) != 0:
+            raise ValueError('Horovod has not been initialized; use hvd.init().')
+
+    def broadcast_bytes(self, data: Optional[bytes], root_rank: int) -> Optional[bytes]:
+        """Broadcasts bytes from root_rank to all Horovod processes in one blocking call,
+        without negotiation or tensors. Must be called by all processes in the same order.
+
+        Arguments:
+            data: Bytes to broadcast, only read on the root rank.
+            root_rank: The rank of the process that broadcasts data.
+
+        Returns:
+            The bytes of the root rank, or None if the controller cannot broadcast bytes
+            (Gloo, or MPI without multi-threading support).
+        """
+        data = data or b''
+        output = ctypes.c_void_p()
+        self.MPI_LIB_CTYPES.horovod_broadcast_bytes.restype = ctypes.c_longlong
+        result = int(self.MPI_LIB_CTYPES.horovod_broadcast_bytes(
+            ctypes.c_char_p(data), ctypes.c_longlong(len(data)), ctypes.c_int(root_rank),
+            ctypes.byref(output)))
+        if result == self.HOROVOD_BROADCAST_BYTES_ERROR_INIT:
+            raise ValueError('Horovod has not been initialized; use hvd.init().')
+        if result == self.HOROVOD_BROADCAST_BYTES_ERROR_UNSUPPORTED:
+            return None
+        if result < 0:
+            raise RuntimeError('Byte broadcast failed, see the Horovod log for details.')
+        return ctypes.string_at(output.value, result) if result > 0 else b''
+
+    def barrier(self, process_set: ProcessSet = global_process_set) -> bool:
+        """Waits until all processes of the process set have called barrier, in one blocking
+        call on the calling thread, without negotiation or tensors. Must be called by all
+        processes of the set in the same order.
+
+        Arguments:
+            process_set: Process set object to wait for. Defaults to the global process set.
+
+        Returns:
+            True, or False if the controller cannot wait outside of its background thread
+            (MPI without multi-threading support).
+        """
+        result = int(self.MPI_LIB_CTYPES.horovod_barrier(
+            ctypes.c_int(process_set.process_set_id)))
+        if result == self.HOROVOD_BARRIER_ERROR_INIT:
+            raise ValueError('Horovod has not been initialized; use hvd.init().')
+        if result == self.HOROVOD_BARRIER_ERROR_UNSUPPORTED:
+            return False
+        if result == self.HOROVOD_BARRIER_ERROR_FOREIGN_SET:
+            raise ValueError("Process is not part of provided process set.")
+        if result == self.HOROVOD_BARRIER_ERROR_UNKNOWN_SET:
+            raise ValueError("Process set does not exist or has not been registered.")
+        if result < 0:
+            raise RuntimeError('Barrier failed, see the Horovod log for details.')
+        return True
+
     def _add_process_set_impl(self, ranks: Sequence[int]) -> Optional[int]:
         """ Add a new process set and return its id. If a process set containing the same ranks exists already, return
          None.
@@ -391,6 +595,31 @@ class HorovodBasics(object):
             return None
         return result
 
+    def _add_process_sets_impl(self, rank_lists: Sequence[Sequence[int]]) -> Optional[List[int]]:
+        """ Add new process sets at once and return their ids. If a process set containing the same ranks as another
+        one or one added before exists, add none of them and return None.
+
+        Requires running with HOROVOD_DYNAMIC_PROCESS_SETS=1.
+        """
+        rank_lists = [list(ranks) for ranks in rank_lists]
+        num_sets = len(rank_lists)
+        ranks = [rank for ranks in rank_lists for rank in ranks]
+        ids = (ctypes.c_int * num_sets)()
+        result = int(self.MPI_LIB_CTYPES.horovod_add_process_sets(
+            (ctypes.c_int * len(ranks))(*ranks),
+            (ctypes.c_int * num_sets)(*[len(ranks) for ranks in rank_lists]),
+            ctypes.c_int(num_sets), ids))
+        if result == self.HOROVOD_PROCESS_SET_ERROR_INIT:
+            raise ValueError('Horovod has not been initialized; use hvd.init().')
+        elif result == self.HOROVOD_PROCESS_SET_ERROR_SHUTDOWN:
+            raise ValueError('Horovod is shutting down.')
+        elif result == self.HOROVOD_PROCESS_SET_ERROR_DYNAMIC:
+            raise ValueError(
+                "Set HOROVOD_DYNAMIC_PROCESS_SETS=1 to allow adding process sets after Horovod initialization.")
+        elif result == self.HOROVOD_PROCESS_SET_ERROR_EXISTING_SET:
+            return None
+        return list(ids)
+
     def _remove_process_set_impl(self, process_set_id: int) -> Optional[int]:
         """ Remove process set with given id. If removal is succesful, return process_set_id.
 
@@ -0,0 +1,112 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "bucket_table.h"
+
+#include <algorithm>
+
+namespace horovod {
+namespace common {
+
+void BucketTable::RegisterBuckets(const std::vector<std::string>& names,
+                                  const std::vector<int64_t>& sizes,
+                                  int64_t bucket_bytes) {
+  std::lock_guard<std::mutex> guard(mutex_);
+
+  // Drop names from the buckets they were in before.
+  for (auto& name : names) {
+    auto it = name_to_bucket_.find(name);
+    if (it != name_to_bucket_.end()) {
+      auto& old_names = buckets_[it->second].names;
+      old_names.erase(std::find(old_names.begin(), old_names.end(), name));
+      name_to_bucket_.erase(it);
+    }
+  }
+
+  int64_t bucket_size = 0;
+  bool open = false;
+  for (size_t i = names.size(); i-- > 0;) {
+    if (name_to_bucket_.find(names[i]) != name_to_bucket_.end()) {
+      // Registered twice in the same call.
+      continue;
+    }
+    if (!open || bucket_size + sizes[i] > bucket_bytes) {
+      buckets_.emplace_back();
+      bucket_size = 0;
+      open = true;
+    }
+    buckets_.back().names.push_back(names[i]);
+    bucket_size += sizes[i];
+    name_to_bucket_[names[i]] = buckets_.size() - 1;
+  }
+}
+
+bool BucketTable::Add(BucketedAllreduce&& allreduce,
+                      std::vector<BucketedAllreduce>& ready) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = name_to_bucket_.find(allreduce.name);
+  if (it == name_to_bucket_.end()) {
+    // Not in any bucket, goes out on its own.
+    ready.clear();
+    ready.push_back(std::move(allreduce));
+    return true;
+  }
+  auto& bucket = buckets_[it->second];
+  bucket.held.push_back(std::move(allreduce));
+  return Complete(bucket, ready);
+}
+
+bool BucketTable::Skip(const std::string& name,
+                       std::vector<BucketedAllreduce>& ready) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = name_to_bucket_.find(name);
+  if (it == name_to_bucket_.end()) {
+    return false;
+  }
+  return Complete(buckets_[it->second], ready);
+}
+
+bool BucketTable::Complete(Bucket& bucket,
+                           std::vector<BucketedAllreduce>& ready) {
+  if (++bucket.done < bucket.names.size()) {
+    return false;
+  }
+  ready = std::move(bucket.held);
+  bucket.held.clear();
+  bucket.done = 0;
+  return true;
+}
+
+std::vector<BucketedAllreduce> BucketTable::TakeAll() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::vector<BucketedAllreduce> held;
+  for (auto& bucket : buckets_) {
+    for (auto& allreduce : bucket.held) {
+      held.push_back(std::move(allreduce));
+    }
+    bucket.held.clear();
+    bucket.done = 0;
+  }
+  return held;
+}
+
+void BucketTable::Clear() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  name_to_bucket_.clear();
+  buckets_.clear();
+}
+
+} // namespace common
+} // namespace horovod
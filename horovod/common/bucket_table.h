@@ -0,0 +1,93 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_BUCKET_TABLE_H
+#define HOROVOD_BUCKET_TABLE_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+
+namespace horovod {
+namespace common {
+
+// An allreduce held back until the rest of its bucket has been enqueued.
+struct BucketedAllreduce {
+  std::shared_ptr<OpContext> context;
+  std::shared_ptr<Tensor> tensor;
+  std::shared_ptr<Tensor> output;
+  ReadyEventList ready_event_list;
+  std::string name;
+  int device = CPU_DEVICE_ID;
+  StatusCallback callback;
+  ReduceOp reduce_op = ReduceOp::SUM;
+  double prescale_factor = 1.0;
+  double postscale_factor = 1.0;
+  int32_t priority = 0;
+};
+
+// Assigns the allreduces of gradients to buckets of a fixed size, in the
+// order in which the backward pass produces them, so that each bucket can be
+// enqueued as one group the moment it is complete. Written by framework
+// threads.
+class BucketTable {
+public:
+  // Assigns names, given in the order their tensors were registered with the
+  // framework, to consecutive buckets of at most bucket_bytes in reverse
+  // order, like the backward pass visits them. A tensor of at least
+  // bucket_bytes gets a bucket of its own. Must not be called while
+  // allreduces of names are held.
+  void RegisterBuckets(const std::vector<std::string>& names,
+                       const std::vector<int64_t>& sizes,
+                       int64_t bucket_bytes);
+
+  // Holds back allreduce. Returns true once its bucket is complete, with the
+  // held allreduces of the bucket in ready. An allreduce outside of all
+  // buckets is ready at once.
+  bool Add(BucketedAllreduce&& allreduce,
+           std::vector<BucketedAllreduce>& ready);
+
+  // Completes name in its bucket for this pass without an allreduce, as it
+  // is reduced some other way. Returns like Add().
+  bool Skip(const std::string& name, std::vector<BucketedAllreduce>& ready);
+
+  // Hands out all held allreduces, for example to fail them on shutdown.
+  std::vector<BucketedAllreduce> TakeAll();
+
+  void Clear();
+
+private:
+  struct Bucket {
+    std::vector<std::string> names;
+    std::vector<BucketedAllreduce> held;
+    size_t done = 0;
+  };
+
+  bool Complete(Bucket& bucket, std::vector<BucketedAllreduce>& ready);
+
+  std::unordered_map<std::string, size_t> name_to_bucket_;
+  std::vector<Bucket> buckets_;
+
+  mutable std::mutex mutex_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_BUCKET_TABLE_H
@@ -145,9 +145,9 @@ void set_affinity(int affinity) {
 }
 #endif
 
-void parse_and_set_affinity(const char* affinity, int local_size, int local_rank) {
+int parse_and_set_affinity(const char* affinity, int local_size, int local_rank) {
   if (affinity == nullptr) {
-    return;
+    return -1;
   }
 
   size_t affinity_len = strlen(affinity);
@@ -189,14 +189,17 @@ void parse_and_set_affinity(const char* affinity, int local_size, int local_rank
     }
   }
     
+  int core = -1;
   if (count < local_size) {
     LOG(ERROR) << "Expected " << local_size << " core ids but got " << count << ". "
                << HOROVOD_THREAD_AFFINITY << "=" << affinity;
   } else {
-    set_affinity(core_ids[local_rank]);
+    core = core_ids[local_rank];
+    set_affinity(core);
   }
 
   free(affinity_copy);
+  return core;
 }
 
 void TensorTableEntry::FinishWithCallback(const Status& status) {
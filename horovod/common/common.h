@@ -18,12 +18,16 @@
 #ifndef HOROVOD_COMMON_H
 #define HOROVOD_COMMON_H
 
+#include <chrono>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 
+#include "completion.h"
+#include "inline_function.h"
 #include "message.h"
 #include "nvtx_op_range.h"
 
@@ -34,9 +38,11 @@ using gpuError_t = cudaError_t;
 using gpuEvent_t = cudaEvent_t;
 using gpuStream_t = cudaStream_t;
 #define gpuEventCreateWithFlags cudaEventCreateWithFlags
+#define gpuEventDestroy cudaEventDestroy
 #define gpuEventDisableTiming cudaEventDisableTiming
 #define gpuEventRecord cudaEventRecord
 #define gpuEventSynchronize cudaEventSynchronize
+#define gpuMemsetAsync cudaMemsetAsync
 #define gpuStreamWaitEvent cudaStreamWaitEvent
 #define HVD_GPU_CHECK(x)                                                                    \
   do {                                                                                      \
@@ -52,9 +58,11 @@ using gpuError_t = hipError_t;
 using gpuEvent_t = hipEvent_t;
 using gpuStream_t = hipStream_t;
 #define gpuEventCreateWithFlags hipEventCreateWithFlags
+#define gpuEventDestroy hipEventDestroy
 #define gpuEventDisableTiming hipEventDisableTiming
 #define gpuEventRecord hipEventRecord
 #define gpuEventSynchronize hipEventSynchronize
+#define gpuMemsetAsync hipMemsetAsync
 #define gpuStreamWaitEvent hipStreamWaitEvent
 #define HVD_GPU_CHECK(x)                                                                  \
   do {                                                                                    \
@@ -88,55 +96,106 @@ namespace common {
 #define MEMCPY_OUT_FUSION_BUFFER "MEMCPY_OUT_FUSION_BUFFER"
 #define MPI_BCAST "MPI_BCAST"
 #define MPI_ALLTOALL "MPI_ALLTOALL"
+#define MPI_REDUCESCATTER "MPI_REDUCESCATTER"
+#define MPI_REDUCE "MPI_REDUCE"
+#define MPI_GATHER "MPI_GATHER"
 #define NCCL_REDUCESCATTER "NCCL_REDUCESCATTER"
 #define NCCL_ALLGATHER "NCCL_ALLGATHER"
 #define NCCL_REDUCE "NCCL_REDUCE"
 #define NCCL_BCAST "NCCL_BCAST"
 #define NCCL_ALLTOALL "NCCL_ALLTOALL"
+#define NCCL_GATHER "NCCL_GATHER"
 #define COPY_ALLGATHER_OUTPUT "COPY_ALLGATHER_OUTPUT"
 #define ALLOCATE_SHARED_BUFFER "ALLOCATE_SHARED_BUFFER"
 #define CCL_ALLREDUCE "CCL_ALLREDUCE"
 #define CCL_ALLGATHER "CCL_ALLGATHER"
 #define CCL_BCAST "CCL_BCAST"
 #define CCL_ALLTOALL "CCL_ALLTOALL"
+#define CCL_REDUCESCATTER "CCL_REDUCESCATTER"
 #define GLOO_ALLREDUCE "GLOO_ALLREDUCE"
 #define GLOO_ALLGATHER "GLOO_ALLGATHER"
 #define GLOO_BCAST "GLOO_BCAST"
+#define GLOO_REDUCESCATTER "GLOO_REDUCESCATTER"
+#define GLOO_REDUCE "GLOO_REDUCE"
+#define GLOO_GATHER "GLOO_GATHER"
 #define HOROVOD_ELASTIC "HOROVOD_ELASTIC"
 
 // Horovod knobs.
 #define HOROVOD_MPI_THREADS_DISABLE "HOROVOD_MPI_THREADS_DISABLE"
 #define HOROVOD_TIMELINE "HOROVOD_TIMELINE"
 #define HOROVOD_TIMELINE_MARK_CYCLES "HOROVOD_TIMELINE_MARK_CYCLES"
+#define HOROVOD_TIMELINE_FORMAT "HOROVOD_TIMELINE_FORMAT"
+#define HOROVOD_TIMELINE_SAMPLE_CYCLES "HOROVOD_TIMELINE_SAMPLE_CYCLES"
+#define HOROVOD_TIMELINE_ALL_RANKS "HOROVOD_TIMELINE_ALL_RANKS"
 #define HOROVOD_AUTOTUNE "HOROVOD_AUTOTUNE"
 #define HOROVOD_AUTOTUNE_LOG "HOROVOD_AUTOTUNE_LOG"
+#define HOROVOD_AUTOTUNE_CACHE "HOROVOD_AUTOTUNE_CACHE"
+#define HOROVOD_AUTOTUNE_ADASUM "HOROVOD_AUTOTUNE_ADASUM"
 #define HOROVOD_AUTOTUNE_WARMUP_SAMPLES "HOROVOD_AUTOTUNE_WARMUP_SAMPLES"
 #define HOROVOD_AUTOTUNE_STEPS_PER_SAMPLE "HOROVOD_AUTOTUNE_STEPS_PER_SAMPLE"
 #define HOROVOD_AUTOTUNE_BAYES_OPT_MAX_SAMPLES "HOROVOD_AUTOTUNE_BAYES_OPT_MAX_SAMPLES"
 #define HOROVOD_AUTOTUNE_GAUSSIAN_PROCESS_NOISE "HOROVOD_AUTOTUNE_GAUSSIAN_PROCESS_NOISE"
 #define HOROVOD_FUSION_THRESHOLD "HOROVOD_FUSION_THRESHOLD"
 #define HOROVOD_CYCLE_TIME "HOROVOD_CYCLE_TIME"
+#define HOROVOD_FUSION_COMPRESSION "HOROVOD_FUSION_COMPRESSION"
+#define HOROVOD_EVENT_DRIVEN_LOOP "HOROVOD_EVENT_DRIVEN_LOOP"
 #define HOROVOD_STALL_CHECK_DISABLE "HOROVOD_STALL_CHECK_DISABLE"
 #define HOROVOD_STALL_CHECK_TIME_SECONDS "HOROVOD_STALL_CHECK_TIME_SECONDS"
 #define HOROVOD_STALL_SHUTDOWN_TIME_SECONDS "HOROVOD_STALL_SHUTDOWN_TIME_SECONDS"
 #define HOROVOD_HIERARCHICAL_ALLREDUCE "HOROVOD_HIERARCHICAL_ALLREDUCE"
 #define HOROVOD_HIERARCHICAL_ALLGATHER "HOROVOD_HIERARCHICAL_ALLGATHER"
+#define HOROVOD_HIERARCHICAL_ALLTOALL "HOROVOD_HIERARCHICAL_ALLTOALL"
+#define HOROVOD_HIERARCHICAL_NEGOTIATION "HOROVOD_HIERARCHICAL_NEGOTIATION"
 #define HOROVOD_CACHE_CAPACITY "HOROVOD_CACHE_CAPACITY"
+#define HOROVOD_CACHE_MAX_CAPACITY "HOROVOD_CACHE_MAX_CAPACITY"
+#define HOROVOD_FROZEN_SCHEDULE_STEPS "HOROVOD_FROZEN_SCHEDULE_STEPS"
 #define HOROVOD_BATCH_D2D_MEMCOPIES "HOROVOD_BATCH_D2D_MEMCOPIES"
 #define HOROVOD_NUM_NCCL_STREAMS "HOROVOD_NUM_NCCL_STREAMS"
+#define HOROVOD_NUM_CPU_THREADS "HOROVOD_NUM_CPU_THREADS"
+#define HOROVOD_MPI_CPU_SUM_KERNELS "HOROVOD_MPI_CPU_SUM_KERNELS"
+#define HOROVOD_CPU_FP32_ACCUMULATION "HOROVOD_CPU_FP32_ACCUMULATION"
+#define HOROVOD_SHM_ALLREDUCE "HOROVOD_SHM_ALLREDUCE"
+#define HOROVOD_NIC_RAILS "HOROVOD_NIC_RAILS"
+#define HOROVOD_BALANCE_NCCL_STREAMS "HOROVOD_BALANCE_NCCL_STREAMS"
+#define HOROVOD_GPU_STREAM_PRIORITY "HOROVOD_GPU_STREAM_PRIORITY"
+#define HOROVOD_GPU_MEMORY_POOL "HOROVOD_GPU_MEMORY_POOL"
+#define HOROVOD_NCCL_MAX_CTAS "HOROVOD_NCCL_MAX_CTAS"
+#define HOROVOD_CUDA_GRAPHS "HOROVOD_CUDA_GRAPHS"
+#define HOROVOD_NCCL_GROUP_RESPONSES "HOROVOD_NCCL_GROUP_RESPONSES"
+#define HOROVOD_GPU_COMPLETION_ENGINE "HOROVOD_GPU_COMPLETION_ENGINE"
+#define HOROVOD_POOLED_OUTPUTS "HOROVOD_POOLED_OUTPUTS"
 #define HOROVOD_CPU_OPERATIONS "HOROVOD_CPU_OPERATIONS"
 #define HOROVOD_CONTROLLER "HOROVOD_CONTROLLER"
 #define HOROVOD_CCL_CACHE "HOROVOD_CCL_CACHE"
+#define HOROVOD_CCL_MAX_OUTSTANDING "HOROVOD_CCL_MAX_OUTSTANDING"
 #define HOROVOD_GLOO_IFACE "HOROVOD_GLOO_IFACE"
+#define HOROVOD_GLOO_MAX_OUTSTANDING "HOROVOD_GLOO_MAX_OUTSTANDING"
+#define HOROVOD_GLOO_BCUBE_THRESHOLD "HOROVOD_GLOO_BCUBE_THRESHOLD"
+#define HOROVOD_GLOO_HALVING_DOUBLING_THRESHOLD "HOROVOD_GLOO_HALVING_DOUBLING_THRESHOLD"
 #define HOROVOD_MPI "MPI"
+#define HOROVOD_MPI_MAX_OUTSTANDING "HOROVOD_MPI_MAX_OUTSTANDING"
 #define HOROVOD_CCL "CCL"
 #define HOROVOD_GLOO "GLOO"
 #define HOROVOD_ADASUM_MPI_CHUNK_SIZE "HOROVOD_ADASUM_MPI_CHUNK_SIZE"
+#define HOROVOD_ADASUM_GPU_DIRECT "HOROVOD_ADASUM_GPU_DIRECT"
+#define HOROVOD_HIERARCHICAL_ALLREDUCE_CHUNK_SIZE "HOROVOD_HIERARCHICAL_ALLREDUCE_CHUNK_SIZE"
+#define HOROVOD_HIERARCHICAL_ALLREDUCE_COMPRESSION "HOROVOD_HIERARCHICAL_ALLREDUCE_COMPRESSION"
+#define HOROVOD_MPI_GPU_ALLREDUCE_CHUNK_SIZE "HOROVOD_MPI_GPU_ALLREDUCE_CHUNK_SIZE"
+#define HOROVOD_BROADCAST_TREE_THRESHOLD "HOROVOD_BROADCAST_TREE_THRESHOLD"
+#define HOROVOD_BROADCAST_CHUNK_SIZE "HOROVOD_BROADCAST_CHUNK_SIZE"
+#define HOROVOD_BROADCAST_SCATTER_ALLGATHER_THRESHOLD "HOROVOD_BROADCAST_SCATTER_ALLGATHER_THRESHOLD"
 #define HOROVOD_THREAD_AFFINITY "HOROVOD_THREAD_AFFINITY"
 #define HOROVOD_DISABLE_GROUP_FUSION "HOROVOD_DISABLE_GROUP_FUSION"
+#define HOROVOD_ZERO_COPY_THRESHOLD "HOROVOD_ZERO_COPY_THRESHOLD"
+#define HOROVOD_TENSOR_PARTITION_SIZE "HOROVOD_TENSOR_PARTITION_SIZE"
+#define HOROVOD_FUSION_LARGE_TENSOR_SIZE "HOROVOD_FUSION_LARGE_TENSOR_SIZE"
+#define HOROVOD_FUSION_THRESHOLD_LARGE "HOROVOD_FUSION_THRESHOLD_LARGE"
 #define HOROVOD_DISABLE_NVTX_RANGES "HOROVOD_DISABLE_NVTX_RANGES"
 #define HOROVOD_ENABLE_ASYNC_COMPLETION "HOROVOD_ENABLE_ASYNC_COMPLETION"
 #define HOROVOD_DYNAMIC_PROCESS_SETS "HOROVOD_DYNAMIC_PROCESS_SETS"
+#define HOROVOD_PROCESS_SET_THREADS "HOROVOD_PROCESS_SET_THREADS"
+#define HOROVOD_PIPELINE_DEPTH "HOROVOD_PIPELINE_DEPTH"
+#define HOROVOD_BUFFER_IDLE_TIMEOUT "HOROVOD_BUFFER_IDLE_TIMEOUT"
 
 // String constant for gloo interface.
 #define GLOO_DEFAULT_IFACE ""
@@ -153,7 +212,7 @@ namespace common {
 #define JOIN_TENSOR_NAME "join.noname"
 
 // List of supported frameworks.
-enum Framework { TENSORFLOW, PYTORCH, MXNET };
+enum Framework { TENSORFLOW, PYTORCH, MXNET, CPP };
 
 enum StatusType { OK, UNKNOWN_ERROR, PRECONDITION_ERROR, ABORTED, INVALID_ARGUMENT, IN_PROGRESS };
 
@@ -181,9 +240,11 @@ inline std::string CommunicatorName(Communicator comm) {
 struct Event {
   Event() = default;
 #if HAVE_GPU
-  Event(std::shared_ptr<gpuEvent_t> event, gpuStream_t stream) :
+  Event(gpuEvent_t* event, gpuStream_t stream) :
     event(event), stream(stream) {};
-  std::shared_ptr<gpuEvent_t> event;
+  // Owned by the GPU context, which records it again later on the same
+  // stream.
+  gpuEvent_t* event = nullptr;
   gpuStream_t stream = nullptr;
 #endif
 };
@@ -309,6 +370,21 @@ public:
   virtual ~Tensor() = default;
 };
 
+// Device memory owned by Horovod that outputs of ops can point into, see
+// OpContext::AdoptOutput. It is reused once the last output is gone.
+class OutputBlock {
+public:
+  virtual void* data() const = 0;
+  virtual size_t size() const = 0;
+#if HAVE_GPU
+  // Records that all work enqueued on stream so far is done reading the
+  // block. Horovod waits for the last recorded release before it writes to
+  // the block again.
+  virtual void RecordRelease(gpuStream_t stream) = 0;
+#endif
+  virtual ~OutputBlock() = default;
+};
+
 class OpContext {
 public:
   // These allocators are fully synchronous, unlike TensorFlow counterparts.
@@ -327,20 +403,36 @@ public:
   }
   virtual Status AllocateZeros(int64_t num_elements, DataType dtype,
                                 std::shared_ptr<Tensor>* tensor) = 0;
+  // Makes the output point at the shape elements at offset bytes into block
+  // instead of allocating it, the output keeps the block alive. Only used
+  // for ops enqueued without an output tensor.
+  virtual Status AdoptOutput(TensorShape shape, DataType dtype,
+                             std::shared_ptr<OutputBlock> block,
+                             int64_t offset, std::shared_ptr<Tensor>* tensor) {
+    return Status::PreconditionError(
+        "Outputs in Horovod memory are not supported by this framework.");
+  }
   virtual Framework framework() const = 0;
   virtual ~OpContext() = default;
 };
 
 // A callback to call after the communication completes. Since the
 // allreduce and allgather ops are asynchronous, this callback is what resumes
-// computation after the reduction is completed.
-using StatusCallback = std::function<void(const Status&)>;
+// computation after the reduction is completed. The callbacks of the
+// framework ops fit in place, so enqueueing a tensor does not allocate one.
+using StatusCallback = InlineFunction<void(const Status&), 64>;
+
+// Completion token of an op, to enqueue with Callback() instead of a callback
+// of its own.
+using Completion = BasicCompletion<Status>;
 
 // Table storing Tensors to be reduced, keyed by unique name.
 // This table contains everything necessary to do the distributed operation.
 struct TensorTableEntry {
   // Name of the tensor.
   std::string tensor_name;
+  // ID of the tensor name while the entry is in the tensor queue.
+  int32_t tensor_id = NULL_TENSOR_ID;
   // Operation context.
   std::shared_ptr<OpContext> context;
   // Input tensor.
@@ -349,6 +441,8 @@ struct TensorTableEntry {
   std::shared_ptr<Tensor> output;
   // Identifier for the subset of Horovod processes partaking in this operation.
   int32_t process_set_id = 0;
+  // Time the entry was added to the tensor queue.
+  std::chrono::steady_clock::time_point enqueue_time;
   // Root rank for broadcast operation (relative to process set).
   int root_rank = 0;
   // List of events indicating that data is ready.
@@ -368,15 +462,24 @@ struct TensorTableEntry {
   // on coordinator rank.
   std::vector<int32_t> splits;
   std::shared_ptr<Tensor> received_splits;
+  // Alltoall receive splits given by the caller, which are then not
+  // exchanged. Empty if unknown.
+  std::vector<int32_t> recvsplits;
 
   // Execute callback and end NVTX range
   void FinishWithCallback(const Status& status);
 };
 using TensorTable = std::unordered_map<std::string, TensorTableEntry>;
 
+// Bytes of the buffers Horovod keeps between operations, keyed by device
+// (CPU_DEVICE_ID for host memory) and category.
+using MemoryUsage = std::map<std::pair<int, std::string>, int64_t>;
+
 // Set affinity function
 void set_affinity(int affinity);
-void parse_and_set_affinity(const char* affinity, int local_size, int local_rank);
+// Pins the calling thread to the core of local_rank in the comma-separated
+// list affinity, and returns that core, or -1 if it set none.
+int parse_and_set_affinity(const char* affinity, int local_size, int local_rank);
 
 } // namespace common
 } // namespace horovod
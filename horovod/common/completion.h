@@ -0,0 +1,191 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_COMPLETION_H
+#define HOROVOD_COMPLETION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__has_include)
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#include <coroutine>
+#define HOROVOD_HAVE_COROUTINES 1
+#endif
+#endif
+
+#include "inline_function.h"
+
+namespace horovod {
+namespace common {
+
+// Completion token of an asynchronous op, as an alternative to a callback
+// per op. Whoever enqueues the op passes Callback() as the callback of the
+// op and keeps the token to poll it, wait for it, chain one continuation to
+// it or co_await it.
+//
+// The token shares one state with its copies and its callback. Completing,
+// polling and chaining only take atomic operations; the mutex and condition
+// variable are only used while a thread is blocked in Wait().
+template <class Result> class BasicCompletion {
+  struct State;
+
+public:
+  using Continuation = InlineFunction<void(const Result&), 48>;
+
+  // An empty token, see valid().
+  BasicCompletion() = default;
+
+  static BasicCompletion Make() {
+    BasicCompletion completion;
+    completion.state_ = std::make_shared<State>();
+    return completion;
+  }
+
+  // A token that is already completed with result, e.g. for errors of the
+  // enqueue call itself.
+  static BasicCompletion Ready(Result result) {
+    auto completion = Make();
+    completion.Complete(std::move(result));
+    return completion;
+  }
+
+  bool valid() const { return state_ != nullptr; }
+
+  // Completes the token with the result of the op. Must be called once.
+  void Complete(Result result) const { state_->Complete(std::move(result)); }
+
+  // Callback that completes the token, to pass to the enqueue functions. It
+  // only holds a reference to the state, so it fits an inline
+  // StatusCallback.
+  struct Completer {
+    std::shared_ptr<State> state;
+    void operator()(const Result& result) const { state->Complete(result); }
+  };
+
+  Completer Callback() const { return Completer{state_}; }
+
+  bool Poll() const {
+    return state_->state.load(std::memory_order_acquire) == DONE;
+  }
+
+  // Blocks until the token is completed.
+  void Wait() const { state_->Wait(); }
+
+  // The result, once Poll() returned true or Wait() returned.
+  const Result& result() const { return state_->result; }
+
+  // Runs continuation with the result once the token is completed: on the
+  // thread that completes it, or right away if it is already completed.
+  // Only one continuation can be chained to a token.
+  void Then(Continuation continuation) const {
+    state_->Then(std::move(continuation));
+  }
+
+#if HOROVOD_HAVE_COROUTINES
+  // Resumes the awaiting coroutine on the thread that completes the token.
+  struct Awaiter {
+    BasicCompletion completion;
+
+    bool await_ready() const { return completion.Poll(); }
+    // Returns false to resume right away if the token completed after
+    // await_ready(). Resuming from here instead could destroy the awaiter
+    // while this call still uses it.
+    bool await_suspend(std::coroutine_handle<> handle) const {
+      Continuation resume([handle](const Result&) { handle.resume(); });
+      return completion.state_->Chain(resume);
+    }
+    const Result& await_resume() const { return completion.result(); }
+  };
+
+  Awaiter operator co_await() const { return Awaiter{*this}; }
+#endif
+
+private:
+  enum : int { PENDING = 0, CHAINED = 1, DONE = 2 };
+
+  struct State {
+    std::atomic<int> state{PENDING};
+    // Written before state becomes DONE.
+    Result result;
+    // Written before state becomes CHAINED.
+    Continuation continuation;
+
+    std::atomic<int> num_waiters{0};
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    void Complete(Result value) {
+      result = std::move(value);
+      int previous = state.exchange(DONE, std::memory_order_acq_rel);
+      if (previous == CHAINED) {
+        continuation(result);
+      }
+      // Waiters register before they check the state, so either they see
+      // DONE or we see them here.
+      if (num_waiters.load() > 0) {
+        { std::lock_guard<std::mutex> guard(mutex); }
+        cond.notify_all();
+      }
+    }
+
+    void Then(Continuation next) {
+      if (!Chain(next)) {
+        next(result);
+      }
+    }
+
+    // Chains next to run on completion and returns true, or returns false
+    // and leaves next to the caller if the token is already completed.
+    bool Chain(Continuation& next) {
+      int current = state.load(std::memory_order_acquire);
+      if (current == CHAINED) {
+        throw std::logic_error("Completion already has a continuation.");
+      }
+      if (current == DONE) {
+        return false;
+      }
+      continuation = std::move(next);
+      if (state.compare_exchange_strong(current, CHAINED,
+                                        std::memory_order_acq_rel)) {
+        return true;
+      }
+      // Completed in between, the continuation is still ours.
+      next = std::move(continuation);
+      return false;
+    }
+
+    void Wait() {
+      if (state.load(std::memory_order_acquire) == DONE) {
+        return;
+      }
+      std::unique_lock<std::mutex> lock(mutex);
+      num_waiters.fetch_add(1);
+      cond.wait(lock, [this] { return state.load() == DONE; });
+      num_waiters.fetch_sub(1);
+    }
+  };
+
+  std::shared_ptr<State> state_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_COMPLETION_H
@@ -17,10 +17,12 @@
 
 #include "controller.h"
 
+#include <algorithm>
 #include <atomic>
 #include <map>
 #include <queue>
 #include <set>
+#include <tuple>
 #include <unordered_set>
 
 #include "global_state.h"
@@ -35,6 +37,21 @@
 namespace horovod {
 namespace common {
 
+namespace {
+
+// Number of bins per fusion key that still take tensors when packing
+// reductions. Older bins are closed, which keeps the packing linear in the
+// number of responses.
+constexpr size_t MAX_OPEN_FUSION_BINS = 8;
+
+bool IsReduction(const Response& response) {
+  return response.response_type() == Response::ResponseType::ALLREDUCE ||
+         response.response_type() == Response::ResponseType::ADASUM ||
+         response.response_type() == Response::ResponseType::REDUCESCATTER ||
+         response.response_type() == Response::ResponseType::REDUCE;
+}
+
+} // namespace
 
 void Controller::SynchronizeParameters() {
   ParameterManager::Params param;
@@ -62,11 +79,13 @@ Controller::Controller(ResponseCache& response_cache, TensorQueue& tensor_queue,
       group_table_(group_table) {}
 
 void Controller::Initialize() {
-  response_cache_.clear();
+  response_cache_.set_tensor_name_table(&tensor_queue_.tensor_name_table());
 
   // Initialize concrete implementations.
   DoInitialization();
 
+  request_compressor_.Reset(size_);
+
   is_initialized_ = true;
 }
 
@@ -78,7 +97,21 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
   // Update cache capacity if autotuning is active.
   if (parameter_manager_.IsAutoTuning()) {
     response_cache_.set_capacity((int)parameter_manager_.CacheEnabled() *
-                                 cache_capacity_);
+                                 state.cache_capacity);
+  }
+
+  bool freeze_schedule = state.frozen_schedule_steps > 0 &&
+                         response_cache_.capacity() > 0 &&
+                         !parameter_manager_.IsAutoTuning();
+  if (!freeze_schedule) {
+    frozen_schedule_.reset();
+  } else if (frozen_schedule_.frozen()) {
+    ResponseList response_list;
+    if (ComputeFrozenResponseList(this_process_requested_shutdown, state,
+                                  response_list)) {
+      return response_list;
+    }
+    // Some worker left the schedule, coordinate as usual from here on.
   }
 
   // Copy the data structures out from parameters.
@@ -86,6 +119,7 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
   // enqueued stream callbacks can continue.
 
   CacheCoordinator cache_coordinator(response_cache_.num_active_bits());
+  cache_coordinator.set_expected_hits(last_common_cache_hits_);
 
   // message queue used only in this cycle
   std::deque<Request> message_queue_tmp;
@@ -101,6 +135,7 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
     if (response_cache_.capacity() > 0) {
       auto cache_ = response_cache_.cached(message);
       if (cache_ == ResponseCache::CacheState::HIT) {
+        state.metrics.Add(METRIC_CACHE_HITS, 1);
         uint32_t cache_bit = response_cache_.peek_cache_bit(message);
         cache_coordinator.record_hit(cache_bit);
 
@@ -108,6 +143,7 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
         stall_inspector_.RecordCachedTensorStart(message.tensor_name());
 
       } else {
+        state.metrics.Add(METRIC_CACHE_MISSES, 1);
         if (cache_ == ResponseCache::CacheState::INVALID) {
           uint32_t cache_bit = response_cache_.peek_cache_bit(message);
           cache_coordinator.record_invalid_bit(cache_bit);
@@ -132,8 +168,10 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
   // Check for stalled tensors.
   if (stall_inspector_.ShouldPerformCheck()) {
     if (is_coordinator_) {
+      int64_t num_stalled = 0;
       should_shut_down |=
-          stall_inspector_.CheckForStalledTensors(global_ranks_);
+          stall_inspector_.CheckForStalledTensors(global_ranks_, &num_stalled);
+      state.metrics.Add(METRIC_STALLED_TENSORS, num_stalled);
     }
 
     if (response_cache_.capacity() > 0) {
@@ -150,6 +188,8 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
     // a shutdown. This function removes any invalid cache entries, if they
     // exist.
     CoordinateCacheAndState(cache_coordinator);
+    last_common_cache_hits_ = cache_coordinator.cache_hits().size();
+    ExchangeAllgatherSizes(cache_coordinator.cache_hits(), process_set.joined);
     // Remove uncommon cached tensors from queue and replace to state
     // queue for next cycle. Skip adding common cached tensors to
     // queue as they are handled separately.
@@ -203,49 +243,16 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
     // If all messages in queue have responses in cache, use fast path with
     // no additional coordination.
 
-    // If group fusion is disabled, fuse tensors in groups separately
-    if (state.disable_group_fusion && !group_table_.empty()) {
-      // Note: need group order to be based on position in cache for global consistency
-      std::vector<int> common_ready_groups;
-      std::unordered_set<int> processed;
-      for (auto bit : cache_coordinator.cache_hits()) {
-        const auto& tensor_name = response_cache_.peek_response(bit).tensor_names()[0];
-        int group_id = group_table_.GetGroupIDFromTensorName(tensor_name);
-        if (group_id != NULL_GROUP_ID && processed.find(group_id) == processed.end()) {
-          common_ready_groups.push_back(group_id);
-          processed.insert(group_id);
-        }
-      }
-
-      for (auto id : common_ready_groups) {
-        std::deque<Response> responses;
-        for (const auto &tensor_name : group_table_.GetGroupTensorNames(id)) {
-          auto bit = response_cache_.peek_cache_bit(tensor_name);
-          responses.push_back(response_cache_.get_response(bit));
-          // Erase cache hit to avoid processing a second time.
-          cache_coordinator.erase_hit(bit);
-        }
-
-        FuseResponses(responses, state, response_list);
-      }
+    if (freeze_schedule) {
+      frozen_schedule_.observe(cache_coordinator.cache_hits(),
+                               state.frozen_schedule_steps);
     }
-
-
-    std::deque<Response> responses;
-    // Convert cache hits to responses. Populate so that least
-    // recently used responses get priority. All workers call the code
-    // here so we use the get method here to consistently update the cache
-    // order.
-    for (auto bit : cache_coordinator.cache_hits()) {
-      responses.push_back(response_cache_.get_response(bit));
-    }
-
-    // Fuse responses as normal.
-    FuseResponses(responses, state, response_list);
+    FuseCachedResponses(cache_coordinator.cache_hits(), state, response_list);
     response_list.set_shutdown(cache_coordinator.should_shut_down());
   } else {
     // There are uncached messages coming in, need communication to figure out
     // whether those are ready to be reduced.
+    frozen_schedule_.reset();
 
     // Collect all tensors that are ready to be reduced. Record them in the
     // tensor count table (rank zero) or send them to rank zero to be
@@ -256,19 +263,22 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
       LOG(TRACE) << "Adding messages from process-set rank 0";
       while (!message_queue_tmp.empty()) {
         // Pop the first available message
-        Request message = message_queue_tmp.front();
+        Request message = std::move(message_queue_tmp.front());
         message_queue_tmp.pop_front();
 
         if (message.request_type() == Request::JOIN) {
           process_set.joined_size++;
+          joined_devices_[message.request_rank()] = message.device();
           continue;
         }
 
-        bool reduce = IncrementTensorCount(message, process_set.joined_size);
         stall_inspector_.RecordUncachedTensorStart(
             message.tensor_name(), message.request_rank(), size_);
+        const std::string* name = nullptr;
+        bool reduce = IncrementTensorCount(std::move(message),
+                                           process_set.joined_size, &name);
         if (reduce) {
-          ready_to_reduce.push_back(message.tensor_name());
+          ready_to_reduce.push_back(*name);
         }
       }
 
@@ -279,22 +289,24 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
       // Process messages.
       for (int i = 1; i < size_; ++i) {
         LOG(TRACE) << "Adding messages from process-set rank " << i;
-        auto received_message_list = ready_list[i];
-        for (auto& received_message : received_message_list.requests()) {
-          auto& received_name = received_message.tensor_name();
-
+        auto& received_message_list = ready_list[i];
+        request_compressor_.Decompress(i, received_message_list);
+        for (auto& received_message : received_message_list.mutable_requests()) {
           if (received_message.request_type() == Request::JOIN) {
             process_set.joined_size++;
+            joined_devices_[received_message.request_rank()] =
+                received_message.device();
             continue;
           }
 
-          bool reduce =
-              IncrementTensorCount(received_message, process_set.joined_size);
           stall_inspector_.RecordUncachedTensorStart(
               received_message.tensor_name(), received_message.request_rank(),
               size_);
+          const std::string* name = nullptr;
+          bool reduce = IncrementTensorCount(std::move(received_message),
+                                             process_set.joined_size, &name);
           if (reduce) {
-            ready_to_reduce.push_back(received_name);
+            ready_to_reduce.push_back(*name);
           }
         }
         if (received_message_list.shutdown()) {
@@ -376,10 +388,9 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
       std::deque<Response> responses;
 
       if (response_cache_.capacity() > 0) {
-        // Prepopulate response list with cached responses. Populate so that
-        // least recently used responses get priority. Since only the
-        // coordinator rank calls this code, use peek instead of get here to
-        // preserve cache order across workers.
+        // Prepopulate response list with cached responses, in cache bit
+        // order. Since only the coordinator rank calls this code, use peek
+        // instead of get here to preserve cache order across workers.
         // No need to do this when all ranks did Join.
         if (process_set.joined_size < size_) {
           for (auto bit : cache_coordinator.cache_hits()) {
@@ -407,6 +418,7 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
         join_response.add_tensor_name(JOIN_TENSOR_NAME);
         responses.push_back(std::move(join_response));
         process_set.joined_size = 0;
+        joined_devices_.clear();
       }
       FuseResponses(responses, state, response_list);
       response_list.set_shutdown(should_shut_down);
@@ -418,11 +430,12 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
       RequestList message_list;
       message_list.set_shutdown(should_shut_down);
       while (!message_queue_tmp.empty()) {
-        message_list.add_request(message_queue_tmp.front());
+        message_list.emplace_request(std::move(message_queue_tmp.front()));
         message_queue_tmp.pop_front();
       }
 
       // Send ready tensors to rank zero
+      request_compressor_.Compress(message_list);
       SendReadyTensors(message_list);
 
       // Receive final tensors to be processed from rank zero
@@ -447,7 +460,8 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
       if ((response.response_type() == Response::ResponseType::ALLREDUCE ||
            response.response_type() == Response::ResponseType::ALLGATHER ||
            response.response_type() == Response::ResponseType::ADASUM ||
-           response.response_type() == Response::ResponseType::ALLTOALL) &&
+           response.response_type() == Response::ResponseType::ALLTOALL ||
+           response.response_type() == Response::ResponseType::REDUCESCATTER) &&
           (int)response.devices().size() == size_) {
         response_cache_.put(response, tensor_queue_, process_set.joined);
       }
@@ -460,10 +474,161 @@ ResponseList Controller::ComputeResponseList(bool this_process_requested_shutdow
   return response_list;
 }
 
+void Controller::FuseCachedResponses(std::set<uint32_t> cache_hits,
+                                     HorovodGlobalState& state,
+                                     ResponseList& response_list) {
+  // If group fusion is disabled, fuse tensors in groups separately
+  if (state.disable_group_fusion && !group_table_.empty()) {
+    // Note: need group order to be based on position in cache for global consistency
+    std::vector<int> common_ready_groups;
+    std::unordered_set<int> processed;
+    for (auto bit : cache_hits) {
+      const auto& tensor_name = response_cache_.peek_response(bit).tensor_names()[0];
+      int group_id = group_table_.GetGroupIDFromTensorName(tensor_name);
+      if (group_id != NULL_GROUP_ID && processed.find(group_id) == processed.end()) {
+        common_ready_groups.push_back(group_id);
+        processed.insert(group_id);
+      }
+    }
+
+    for (auto id : common_ready_groups) {
+      std::deque<Response> responses;
+      for (const auto &tensor_name : group_table_.GetGroupTensorNames(id)) {
+        auto bit = response_cache_.peek_cache_bit(tensor_name);
+        responses.push_back(response_cache_.get_response(bit));
+        // Erase cache hit to avoid processing a second time.
+        cache_hits.erase(bit);
+      }
+
+      FuseResponses(responses, state, response_list);
+    }
+  }
+
+  std::deque<Response> responses;
+  // Convert cache hits to responses in cache bit order. Bits are stable and
+  // the same on all workers, so every worker builds the same list. All
+  // workers call the code here so we use the get method here to consistently
+  // update the cache order.
+  for (auto bit : cache_hits) {
+    responses.push_back(response_cache_.get_response(bit));
+  }
+
+  // Fuse responses as normal.
+  FuseResponses(responses, state, response_list);
+}
+
+bool Controller::ComputeFrozenResponseList(bool this_process_requested_shutdown,
+                                           HorovodGlobalState& state,
+                                           ResponseList& response_list) {
+  std::deque<Request> message_queue_tmp;
+  tensor_queue_.PopMessagesFromQueue(message_queue_tmp);
+
+  // Anything the schedule does not cover is left for regular coordination
+  // once all workers have reached the end of the step.
+  if (this_process_requested_shutdown) {
+    frozen_schedule_.set_mismatch();
+  }
+  std::set<uint32_t> enqueued_bits;
+  for (auto& message : message_queue_tmp) {
+    if (message.request_type() != Request::JOIN &&
+        response_cache_.cached(message) == ResponseCache::CacheState::HIT) {
+      uint32_t cache_bit = response_cache_.peek_cache_bit(message);
+      if (frozen_schedule_.contains(cache_bit)) {
+        enqueued_bits.insert(cache_bit);
+        continue;
+      }
+    }
+    frozen_schedule_.set_mismatch();
+  }
+
+  const auto& batch = frozen_schedule_.next_batch();
+  bool batch_ready = std::includes(enqueued_bits.begin(), enqueued_bits.end(),
+                                   batch.begin(), batch.end());
+
+  // Check whether this worker has been waiting for the batch for too long.
+  bool stalled = false;
+  bool should_shut_down = false;
+  if (batch_ready) {
+    frozen_batch_waiting_ = false;
+  } else {
+    if (!frozen_batch_waiting_) {
+      frozen_batch_waiting_ = true;
+      frozen_batch_wait_start_ = std::chrono::steady_clock::now();
+    }
+    if (stall_inspector_.ShouldPerformCheck()) {
+      std::vector<std::string> missing_tensors;
+      for (auto bit : batch) {
+        if (enqueued_bits.find(bit) == enqueued_bits.end()) {
+          missing_tensors.push_back(
+              response_cache_.peek_response(bit).tensor_names()[0]);
+        }
+      }
+      stalled = stall_inspector_.CheckForStalledFrozenBatch(
+          missing_tensors, frozen_batch_wait_start_, rank_, should_shut_down);
+      stall_inspector_.UpdateCheckTime();
+    }
+  }
+
+  if (frozen_schedule_.at_step_boundary()) {
+    if (!batch_ready && !frozen_schedule_.mismatch()) {
+      if (!stalled) {
+        tensor_queue_.PushMessagesToQueue(message_queue_tmp);
+        return true;
+      }
+      // The other workers wait in the check below at worst, so leave the
+      // schedule and let regular coordination sort out the step.
+      frozen_schedule_.set_mismatch();
+    }
+
+    // Single-word check that every worker is still following the schedule.
+    std::vector<long long> bitvector(1, frozen_schedule_.mismatch() ? 0 : 1);
+    CrossRankBitwiseAnd(bitvector, 1);
+    if (bitvector[0] == 0) {
+      LOG(DEBUG, rank_) << "Leaving frozen response schedule.";
+      frozen_schedule_.reset();
+      frozen_batch_waiting_ = false;
+      tensor_queue_.PushMessagesToQueue(message_queue_tmp);
+      return false;
+    }
+  }
+
+  if (!batch_ready) {
+    // Other workers may already be in the collective operations of this
+    // batch, so it cannot be left mid-step. A stall can only be reported
+    // and, past the stall shutdown time, end in a shutdown of this worker.
+    response_list.set_shutdown(should_shut_down);
+    tensor_queue_.PushMessagesToQueue(message_queue_tmp);
+    return true;
+  }
+
+  std::deque<Request> messages_to_replace;
+  for (auto& message : message_queue_tmp) {
+    if (message.request_type() != Request::JOIN &&
+        response_cache_.cached(message) == ResponseCache::CacheState::HIT &&
+        batch.find(response_cache_.peek_cache_bit(message)) != batch.end()) {
+      stall_inspector_.RemoveCachedTensor(message.tensor_name());
+    } else {
+      messages_to_replace.push_back(std::move(message));
+    }
+  }
+  tensor_queue_.PushMessagesToQueue(messages_to_replace);
+
+  ExchangeAllgatherSizes(batch, false);
+  FuseCachedResponses(batch, state, response_list);
+  frozen_schedule_.advance();
+  return true;
+}
+
 int64_t Controller::TensorFusionThresholdBytes() {
-  int64_t proposed_fusion_threshold =
-      parameter_manager_.TensorFusionThresholdBytes();
+  return AlignFusionThreshold(parameter_manager_.TensorFusionThresholdBytes());
+}
+
+int64_t Controller::LargeTensorFusionThresholdBytes() {
+  return AlignFusionThreshold(
+      parameter_manager_.LargeTensorFusionThresholdBytes());
+}
 
+int64_t Controller::AlignFusionThreshold(int64_t proposed_fusion_threshold) {
   // If the cluster is homogeneous,
   // adjust buffer size to make sure it is divisible by local_size to improve
   // performance for operations that perform local reductions by default such as Adasum.
@@ -523,10 +688,12 @@ Response Controller::ConstructResponse(const std::string& name, int joined_size)
     }
   }
 
-  // If we are doing an allreduce or broadcast, check that all tensor shapes are
-  // identical.
+  // If we are doing an allreduce, reducescatter, reduce or broadcast, check
+  // that all tensor shapes are identical.
   if (message_type == Request::ALLREDUCE ||
       message_type == Request::ADASUM ||
+      message_type == Request::REDUCESCATTER ||
+      message_type == Request::REDUCE ||
       message_type == Request::BROADCAST) {
     TensorShape tensor_shape;
     for (auto dim : requests[0].tensor_shape()) {
@@ -554,14 +721,19 @@ Response Controller::ConstructResponse(const std::string& name, int joined_size)
     }
   }
 
-  // If we are doing an allreduce, check that prescaling and postscaling factors
-  // are identical across ranks.
+  // If we are doing an allreduce, reducescatter or reduce, check that
+  // prescaling and postscaling factors and the reduce op are identical across
+  // ranks.
   double prescale_factor;
   double postscale_factor;
+  ReduceOp reduce_op = ReduceOp::SUM;
   if (message_type == Request::ALLREDUCE ||
-      message_type == Request::ADASUM) {
+      message_type == Request::ADASUM ||
+      message_type == Request::REDUCESCATTER ||
+      message_type == Request::REDUCE) {
     prescale_factor = requests[0].prescale_factor();
     postscale_factor = requests[0].postscale_factor();
+    reduce_op = requests[0].reduce_op();
 
     for (unsigned int i = 1; i < requests.size(); ++i) {
       if (error) {
@@ -581,25 +753,38 @@ Response Controller::ConstructResponse(const std::string& name, int joined_size)
             << ", " << request_postscale_factor << ").";
         break;
       }
+
+      if (reduce_op != requests[i].reduce_op()) {
+        error = true;
+        error_message_stream
+            << "Mismatched reduce ops: One rank requested "
+            << ReduceOp_Name(reduce_op) << ", but another rank requested "
+            << ReduceOp_Name(requests[i].reduce_op()) << ".";
+        break;
+      }
     }
   }
 
   std::vector<int64_t> tensor_sizes;
   if (message_type == Request::ALLGATHER ||
+      message_type == Request::GATHER ||
       message_type == Request::ALLTOALL) {
     if (joined_size > 0) {
       error = true;
       if (message_type == Request::ALLGATHER) {
         error_message_stream << "Allgather is not supported with Join at this time. "
                              << "Specify sparse_to_dense=True if using DistributedOptimizer";
+      } else if (message_type == Request::GATHER) {
+        error_message_stream << "Gather is not supported with Join at this time.";
       } else if (message_type == Request::ALLTOALL) {
         error_message_stream << "Alltoall is not supported with Join at this time.";
       }
     }
 
-    // If we are doing an allgather/alltoall, make sure all but the first dimension are
-    // the same. The first dimension may be different and the output tensor is
-    // the sum of the first dimension. Collect the sizes by rank for allgather only.
+    // If we are doing an allgather/gather/alltoall, make sure all but the
+    // first dimension are the same. The first dimension may be different and
+    // the output tensor is the sum of the first dimension. Collect the sizes
+    // by rank for allgather and gather only.
     tensor_sizes.resize(requests.size());
     TensorShape tensor_shape;
     for (auto dim : requests[0].tensor_shape()) {
@@ -654,13 +839,46 @@ Response Controller::ConstructResponse(const std::string& name, int joined_size)
       }
 
       // Collect first dimension sizes for allgather to use for fusion and allgather op.
-      if (message_type == Request::ALLGATHER) {
+      if (message_type == Request::ALLGATHER ||
+          message_type == Request::GATHER) {
         tensor_sizes[requests[i].request_rank()] = request_shape.dim_size(0);
       }
     }
   }
 
-  if (message_type == Request::ALLREDUCE || message_type == Request::ADASUM) {
+  if (message_type == Request::REDUCESCATTER) {
+    if (joined_size > 0) {
+      error = true;
+      error_message_stream << "Reducescatter is not supported with Join at this time.";
+    }
+
+    // The first dimension is split among the ranks of the process set, so
+    // the tensor needs at least one dimension.
+    if (requests[0].tensor_shape().empty()) {
+      error = true;
+      error_message_stream << "Process-set rank zero tried to "
+                           << Request::RequestType_Name(message_type)
+                           << " a rank-zero tensor.";
+    }
+  }
+
+  if (message_type == Request::ALLREDUCE && joined_size > 0 &&
+      reduce_op != ReduceOp::SUM) {
+    // Joined ranks contribute zeros, which is only neutral for a sum.
+    error = true;
+    error_message_stream << "Allreduce with reduce op "
+                         << ReduceOp_Name(reduce_op)
+                         << " is not supported with Join at this time.";
+  }
+
+  if (message_type == Request::REDUCE && joined_size > 0) {
+    error = true;
+    error_message_stream << "Reduce is not supported with Join at this time.";
+  }
+
+  if (message_type == Request::ALLREDUCE || message_type == Request::ADASUM ||
+      message_type == Request::REDUCESCATTER ||
+      message_type == Request::REDUCE) {
     TensorShape tensor_shape;
     for (auto dim : requests[0].tensor_shape()) {
       tensor_shape.AddDim(dim);
@@ -668,13 +886,15 @@ Response Controller::ConstructResponse(const std::string& name, int joined_size)
     tensor_sizes.push_back(tensor_shape.num_elements());
   }
 
-  if (message_type == Request::BROADCAST) {
-    if (joined_size > 0) {
-      error = true;
-      error_message_stream << "Broadcast is not supported with Join at this time.";
-    }
+  if (message_type == Request::BROADCAST && joined_size > 0) {
+    error = true;
+    error_message_stream << "Broadcast is not supported with Join at this time.";
+  }
 
-    // If we are doing a broadcast, check that all root ranks are identical.
+  // If we are doing a broadcast, reduce or gather, check that all root ranks
+  // are identical.
+  if (message_type == Request::BROADCAST || message_type == Request::REDUCE ||
+      message_type == Request::GATHER) {
     int first_root_rank = requests[0].root_rank();
     for (unsigned int i = 1; i < requests.size(); ++i) {
       if (error) {
@@ -715,9 +935,16 @@ Response Controller::ConstructResponse(const std::string& name, int joined_size)
       break;
     }
   }
-  std::vector<int32_t> devices(requests.size());
+  // Joined ranks did not send a request, their device comes from their join
+  // request. With a device for every rank the response can be cached.
+  std::vector<int32_t> devices(size_, requests[0].device());
+  for (auto& joined : joined_devices_) {
+    devices[joined.first] = joined.second;
+  }
+  int32_t priority = requests[0].priority();
   for (auto& request : requests) {
     devices[request.request_rank()] = request.device();
+    priority = std::max(priority, request.priority());
   }
 
   Response response;
@@ -739,8 +966,10 @@ Response Controller::ConstructResponse(const std::string& name, int joined_size)
     response.set_tensor_type(data_type);
     response.set_prescale_factor(prescale_factor);
     response.set_postscale_factor(postscale_factor);
+    response.set_reduce_op(reduce_op);
   } else if (message_type == Request::BROADCAST) {
     response.set_response_type(Response::BROADCAST);
+    response.set_root_rank(requests[0].root_rank());
   } else if (message_type == Request::ALLTOALL) {
     response.set_response_type(Response::ALLTOALL);
   } else if (message_type == Request::ADASUM) {
@@ -751,8 +980,35 @@ Response Controller::ConstructResponse(const std::string& name, int joined_size)
     response.set_tensor_type(data_type);
     response.set_prescale_factor(prescale_factor);
     response.set_postscale_factor(postscale_factor);
+  } else if (message_type == Request::REDUCESCATTER) {
+    response.set_response_type(Response::REDUCESCATTER);
+    for (auto dim : tensor_sizes) {
+      response.add_tensor_size(dim);
+    }
+    response.set_tensor_type(data_type);
+    response.set_prescale_factor(prescale_factor);
+    response.set_postscale_factor(postscale_factor);
+    response.set_reduce_op(reduce_op);
+  } else if (message_type == Request::REDUCE) {
+    response.set_response_type(Response::REDUCE);
+    for (auto dim : tensor_sizes) {
+      response.add_tensor_size(dim);
+    }
+    response.set_tensor_type(data_type);
+    response.set_prescale_factor(prescale_factor);
+    response.set_postscale_factor(postscale_factor);
+    response.set_reduce_op(reduce_op);
+    response.set_root_rank(requests[0].root_rank());
+  } else if (message_type == Request::GATHER) {
+    response.set_response_type(Response::GATHER);
+    for (auto dim : tensor_sizes) {
+      response.add_tensor_size(dim);
+    }
+    response.set_tensor_type(data_type);
+    response.set_root_rank(requests[0].root_rank());
   }
   response.set_devices(devices);
+  response.set_priority(priority);
 
   // Clear all queued up requests for this name. They are now taken care of
   // by the constructed response.
@@ -762,6 +1018,41 @@ Response Controller::ConstructResponse(const std::string& name, int joined_size)
   return response;
 }
 
+void Controller::ExchangeAllgatherSizes(const std::set<uint32_t>& cache_bits,
+                                        bool joined) {
+  // All workers agree on cache_bits, so they all take part or all skip.
+  std::vector<uint32_t> allgather_bits;
+  std::vector<int64_t> first_dims;
+  for (auto bit : cache_bits) {
+    auto& response = response_cache_.peek_response(bit);
+    if (response.response_type() != Response::ALLGATHER) {
+      continue;
+    }
+    allgather_bits.push_back(bit);
+    int64_t first_dim = 0;
+    if (!joined) {
+      const auto& entry =
+          tensor_queue_.GetTensorEntry(response.tensor_names()[0]);
+      first_dim = entry.tensor->shape().dim_size(0);
+    }
+    first_dims.push_back(first_dim);
+  }
+  if (allgather_bits.empty()) {
+    return;
+  }
+
+  std::vector<int64_t> all_first_dims;
+  AllgatherInt64s(first_dims, all_first_dims);
+  size_t num_bits = allgather_bits.size();
+  std::vector<int64_t> tensor_sizes(size_);
+  for (size_t i = 0; i < num_bits; ++i) {
+    for (int r = 0; r < size_; ++r) {
+      tensor_sizes[r] = all_first_dims[r * num_bits + i];
+    }
+    response_cache_.set_tensor_sizes(allgather_bits[i], tensor_sizes);
+  }
+}
+
 void Controller::CoordinateCacheAndState(CacheCoordinator& cache_coordinator) {
   // Sync cache and state information across workers.
   cache_coordinator.sync(shared_from_this(),
@@ -790,64 +1081,147 @@ void Controller::CoordinateCacheAndState(CacheCoordinator& cache_coordinator) {
   }
 }
 
+void Controller::PartitionResponse(Response response, int64_t partition_size,
+                                   std::deque<Response>& partitions) {
+  int64_t type_size = DataType_Size(response.tensor_type());
+  if (response.response_type() != Response::ResponseType::ALLREDUCE ||
+      response.num_partitions() != 1 ||
+      response.tensor_names().size() != 1 ||
+      response.tensor_sizes().size() != 1 ||
+      response.tensor_sizes()[0] * type_size <= partition_size) {
+    partitions.push_back(std::move(response));
+    return;
+  }
+
+  int64_t num_elements = response.tensor_sizes()[0];
+  int64_t partition_elements = std::max(partition_size / type_size, (int64_t)1);
+  int64_t num_partitions =
+      (num_elements + partition_elements - 1) / partition_elements;
+  for (int64_t offset = 0; offset < num_elements;
+       offset += partition_elements) {
+    Response partition = response;
+    partition.set_tensor_sizes(
+        {std::min(partition_elements, num_elements - offset)});
+    partition.set_partition_offset(offset);
+    partition.set_num_partitions((int32_t)num_partitions);
+    partitions.push_back(std::move(partition));
+  }
+}
+
 void Controller::FuseResponses(std::deque<Response>& responses,
                                HorovodGlobalState& state,
                                ResponseList& response_list) {
+  // Large allreduces are split first, so that their parts can be scheduled
+  // around other tensors. Cached responses are split on every rank, which
+  // needs the same partition size everywhere.
+  if (state.tensor_partition_size > 0) {
+    std::deque<Response> partitions;
+    for (auto& response : responses) {
+      PartitionResponse(std::move(response), state.tensor_partition_size,
+                        partitions);
+    }
+    responses = std::move(partitions);
+  }
+
+  // Schedule higher priority tensors first, e.g. the gradients of the first
+  // layers, which the next forward pass needs earliest. The sort is stable so
+  // that cache order is kept among equal priorities, and Join stays last.
+  std::stable_sort(responses.begin(), responses.end(),
+                   [](const Response& a, const Response& b) {
+                     if (a.response_type() == Response::JOIN ||
+                         b.response_type() == Response::JOIN) {
+                       return b.response_type() == Response::JOIN &&
+                              a.response_type() != Response::JOIN;
+                     }
+                     return a.priority() > b.priority();
+                   });
+
+  PackReductions(responses, state);
+
   while (!responses.empty()) {
 
-    auto response = responses.front();
-    assert(response.tensor_names().size() == 1);
+    auto response = std::move(responses.front());
+    assert(IsReduction(response) || response.tensor_names().size() == 1);
     responses.pop_front();
     int64_t tensor_size = 0;
-    if (response.response_type() == Response::ResponseType::ALLREDUCE ||
-        response.response_type() == Response::ResponseType::ADASUM) {
-      // Attempt to add more responses to this fused response.
-
-      tensor_size = response.tensor_sizes()[0] * GetTypeSize(response.tensor_type());
-#if HAVE_CUDA
-      if (state.batch_d2d_memcopies) {
-        // Add 16 byte pad for batched memcpy op
-        tensor_size = BATCHED_D2D_PADDING * ((tensor_size + BATCHED_D2D_PADDING - 1) / BATCHED_D2D_PADDING);
+    if (IsReduction(response)) {
+      // Reductions were packed into fused responses above.
+      for (auto size : response.tensor_sizes()) {
+        tensor_size += size * GetTypeSize(response.tensor_type());
       }
-#endif
+
+    } else if (response.response_type() == Response::ResponseType::ALLTOALL) {
+      // Fused alltoalls are exchanged as bytes, so tensors of different
+      // types go together. The inputs are packed into the fusion buffer.
+      tensor_size =
+          tensor_queue_.GetTensorEntry(response.tensor_names()[0]).tensor->size();
+
       std::deque<Response> skipped_responses;
       int64_t skipped_size = 0;
       while (!responses.empty()) {
         auto& new_response = responses.front();
+        if (new_response.response_type() != Response::ResponseType::ALLTOALL) {
+          // Only other alltoalls are worth looking ahead for.
+          break;
+        }
         assert(new_response.tensor_names().size() == 1);
+        int64_t new_tensor_size =
+            tensor_queue_.GetTensorEntry(new_response.tensor_names()[0])
+                .tensor->size();
+
+        if (response.devices() == new_response.devices() &&
+            tensor_size + new_tensor_size <= TensorFusionThresholdBytes()) {
+          // These tensors will fuse together well.
+          tensor_size += new_tensor_size;
+          response.add_tensor_name(std::move(new_response.tensor_names()[0]));
+          responses.pop_front();
+        } else {
+          skipped_size += new_tensor_size;
+          if (tensor_size + skipped_size <= TensorFusionThresholdBytes()) {
+            // Skip response and look ahead for more to fuse.
+            skipped_responses.push_back(std::move(new_response));
+            responses.pop_front();
+          } else {
+            break;
+          }
+        }
+      }
 
-        int64_t new_tensor_size = new_response.tensor_sizes().empty()
-                                      ? 0
-                                      : new_response.tensor_sizes()[0] *
-                                        GetTypeSize(new_response.tensor_type());
+      // Replace any skipped responses.
+      while (!skipped_responses.empty()) {
+        responses.push_front(std::move(skipped_responses.back()));
+        skipped_responses.pop_back();
+      }
 
-#if HAVE_CUDA
-        if (state.batch_d2d_memcopies) {
-          // Add 16 byte pad for batched memcpy op
-          new_tensor_size = BATCHED_D2D_PADDING * ((new_tensor_size + BATCHED_D2D_PADDING - 1) / BATCHED_D2D_PADDING);
+    } else if (response.response_type() == Response::ResponseType::BROADCAST) {
+      // Broadcasts from the same root are sent together, e.g. the parameters
+      // of a model at the start of training. They are sent as bytes, so
+      // tensors of different types go together.
+      const auto& entry =
+          tensor_queue_.GetTensorEntry(response.tensor_names()[0]);
+      tensor_size = entry.tensor->size();
+
+      std::deque<Response> skipped_responses;
+      int64_t skipped_size = 0;
+      while (!responses.empty()) {
+        auto& new_response = responses.front();
+        if (new_response.response_type() != Response::ResponseType::BROADCAST) {
+          // Only other broadcasts are worth looking ahead for.
+          break;
         }
-#endif
+        assert(new_response.tensor_names().size() == 1);
+        const auto& new_entry =
+            tensor_queue_.GetTensorEntry(new_response.tensor_names()[0]);
+        int64_t new_tensor_size = new_entry.tensor->size();
 
-        if (response.response_type() == new_response.response_type() &&
-            response.devices() == new_response.devices() &&
-            response.tensor_type() == new_response.tensor_type() &&
-            tensor_size + new_tensor_size <= TensorFusionThresholdBytes() &&
-            response.prescale_factor() == new_response.prescale_factor() &&
-            response.postscale_factor() == new_response.postscale_factor()) {
+        if (response.devices() == new_response.devices() &&
+            response.root_rank() == new_response.root_rank() &&
+            tensor_size + new_tensor_size <= TensorFusionThresholdBytes()) {
           // These tensors will fuse together well.
           tensor_size += new_tensor_size;
           response.add_tensor_name(std::move(new_response.tensor_names()[0]));
-          response.add_tensor_size(new_response.tensor_sizes()[0]);
           responses.pop_front();
         } else {
-          // In general, don't try to fuse additional tensors since they are
-          // usually computed in order of requests and skipping tensors may
-          // mean that the batch will have to wait longer while skipped
-          // tensors could be reduced at that time. However, mixed-precision
-          // training may yield requests of various dtype in a mixed-up
-          // sequence causing breakups in fusion. To counter this some look
-          // ahead is allowed.
-
           skipped_size += new_tensor_size;
           if (tensor_size + skipped_size <= TensorFusionThresholdBytes()) {
             // Skip response and look ahead for more to fuse.
@@ -858,6 +1232,7 @@ void Controller::FuseResponses(std::deque<Response>& responses,
           }
         }
       }
+
       // Replace any skipped responses.
       while (!skipped_responses.empty()) {
         responses.push_front(std::move(skipped_responses.back()));
@@ -878,7 +1253,8 @@ void Controller::FuseResponses(std::deque<Response>& responses,
       while (!responses.empty()) {
 
         auto& new_response = responses.front();
-        assert(new_response.tensor_names().size() == 1);
+        assert(IsReduction(new_response) ||
+               new_response.tensor_names().size() == 1);
         const auto& new_entry =
             tensor_queue_.GetTensorEntry(new_response.tensor_names()[0]);
 
@@ -896,6 +1272,15 @@ void Controller::FuseResponses(std::deque<Response>& responses,
           response.add_allgather_response(new_response);
           responses.pop_front();
 
+        } else if (response.response_type() == new_response.response_type() &&
+                   response.devices() == new_response.devices() &&
+                   entry.tensor->dtype() != new_entry.tensor->dtype()) {
+          // Allgathers of another type only differ in their segment of the
+          // fused output. They are left for a fused response of their own,
+          // built right after this one, so they do not limit the look ahead.
+          skipped_responses.push_back(std::move(new_response));
+          responses.pop_front();
+
         } else {
           // In general, don't try to fuse additional tensors since they are
           // usually computed in order of requests and skipping tensors may
@@ -929,6 +1314,90 @@ void Controller::FuseResponses(std::deque<Response>& responses,
   }
 }
 
+void Controller::PackReductions(std::deque<Response>& responses,
+                                HorovodGlobalState& state) {
+  int64_t threshold = TensorFusionThresholdBytes();
+  int64_t large_threshold = LargeTensorFusionThresholdBytes();
+  auto padded_size = [this, &state](const Response& r) {
+    int64_t size = r.tensor_sizes().empty()
+                       ? 0
+                       : r.tensor_sizes()[0] * GetTypeSize(r.tensor_type());
+#if HAVE_CUDA
+    if (state.parameter_manager.BatchD2DMemcopies()) {
+      // Add 16 byte pad for batched memcpy op
+      size = BATCHED_D2D_PADDING * ((size + BATCHED_D2D_PADDING - 1) / BATCHED_D2D_PADDING);
+    }
+#endif
+    return size;
+  };
+  // Allreduces above the zero copy threshold are left alone, so that they
+  // run directly on the framework buffers.
+  auto zero_copy = [&state](const Response& r, int64_t size) {
+    return r.response_type() == Response::ResponseType::ALLREDUCE &&
+           state.zero_copy_threshold > 0 && size >= state.zero_copy_threshold;
+  };
+
+  // Tensors fuse if all of these match, the last being the size class.
+  using FusionKey = std::tuple<int, std::vector<int32_t>, int, double, double,
+                               int, int, bool>;
+  struct Bin {
+    size_t slot;
+    int64_t size;
+  };
+  std::map<FusionKey, std::deque<Bin>> open_bins;
+
+  // Every response and every bin takes the slot of its first tensor, so no
+  // tensor is sent later than in priority order, while later tensors fill
+  // up the bins of earlier ones.
+  std::vector<Response> slots;
+  slots.reserve(responses.size());
+  for (auto& response : responses) {
+    if (!IsReduction(response)) {
+      slots.push_back(std::move(response));
+      continue;
+    }
+    assert(response.tensor_names().size() == 1);
+    int64_t size = padded_size(response);
+    // Parts of partitioned tensors are reduced on their own.
+    if (response.num_partitions() != 1 || zero_copy(response, size)) {
+      slots.push_back(std::move(response));
+      continue;
+    }
+
+    bool large = state.fusion_large_tensor_size > 0 &&
+                 size >= state.fusion_large_tensor_size;
+    int64_t bin_threshold = large ? large_threshold : threshold;
+    // Reduces only fuse with those to the same root.
+    auto& bins = open_bins[std::make_tuple(
+        (int)response.response_type(), response.devices(),
+        (int)response.tensor_type(), response.prescale_factor(),
+        response.postscale_factor(), (int)response.reduce_op(),
+        response.root_rank(), large)];
+    // First fit among the open bins.
+    auto bin = std::find_if(bins.begin(), bins.end(), [&](const Bin& b) {
+      return b.size + size <= bin_threshold;
+    });
+    if (bin != bins.end()) {
+      auto& fused = slots[bin->slot];
+      fused.add_tensor_name(std::move(response.tensor_names()[0]));
+      fused.add_tensor_size(response.tensor_sizes()[0]);
+      bin->size += size;
+      continue;
+    }
+
+    if (bins.size() == MAX_OPEN_FUSION_BINS) {
+      bins.pop_front();
+    }
+    bins.push_back(Bin{slots.size(), size});
+    slots.push_back(std::move(response));
+  }
+
+  responses.clear();
+  for (auto& response : slots) {
+    responses.push_back(std::move(response));
+  }
+}
+
 int64_t Controller::TotalByteSizeOfAllgatherOutput(
     const std::vector<int64_t>& tensor_sizes, const TensorTableEntry& entry) {
   int64_t total_dimension_size = 0;
@@ -955,21 +1424,24 @@ int Controller::GetLocalSizeAtCrossRank(int i) {
   return local_sizes_for_cross_rank_[i];
 }
 
-bool Controller::IncrementTensorCount(const Request& msg, int joined_size) {
-  auto& name = msg.tensor_name();
-  auto table_iter = message_table_.find(name);
+bool Controller::IncrementTensorCount(Request&& msg, int joined_size,
+                                      const std::string** table_name) {
+  auto table_iter = message_table_.find(msg.tensor_name());
   if (table_iter == message_table_.end()) {
-    std::vector<Request> messages = {msg};
+    std::vector<Request> messages;
     messages.reserve(static_cast<unsigned long>(size_));
-    message_table_.emplace(name, std::move(messages));
-    table_iter = message_table_.find(name);
-    timeline_.NegotiateStart(name, msg.request_type());
-  } else {
-    std::vector<Request>& messages = table_iter->second;
-    messages.push_back(msg);
+    table_iter =
+        message_table_.emplace(msg.tensor_name(), std::move(messages)).first;
+    timeline_.NegotiateStart(table_iter->first, msg.request_type());
+  }
+  auto& name = table_iter->first;
+  int32_t request_rank = msg.request_rank();
+  table_iter->second.push_back(std::move(msg));
+  if (table_name != nullptr) {
+    *table_name = &name;
   }
 
-  timeline_.NegotiateRankReady(name, msg.request_rank());
+  timeline_.NegotiateRankReady(name, request_rank);
 
   std::vector<Request>& messages = table_iter->second;
   int count = (int)messages.size();
@@ -17,13 +17,17 @@
 #ifndef HOROVOD_CONTROL_MANAGER_H
 #define HOROVOD_CONTROL_MANAGER_H
 
+#include <chrono>
 #include <iostream>
 #include <queue>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "global_state.h"
 #include "group_table.h"
 #include "parameter_manager.h"
+#include "request_compressor.h"
 #include "response_cache.h"
 #include "stall_inspector.h"
 #include "tensor_queue.h"
@@ -55,6 +59,8 @@ public:
   virtual void Bcast(void* buffer, size_t size, int root_rank,
                      Communicator communicator) = 0;
 
+  // Sends splits.size() / size splits to every rank, the first of them to
+  // rank 0, and receives as many from every rank into recvsplits.
   virtual void AlltoallGetRecvSplits(const std::vector<int32_t>& splits,
                                      std::vector<int32_t>& recvsplits) = 0;
 
@@ -63,6 +69,21 @@ public:
   virtual void Allgather2Ints(std::array<int, 2> values,
                               std::vector<int>& recv_values) = 0;
 
+  // Every rank contributes the same number of values, recv_values holds
+  // them ordered by rank.
+  virtual void AllgatherInt64s(const std::vector<int64_t>& values,
+                               std::vector<int64_t>& recv_values) = 0;
+
+  // Broadcasts data, whose size only root_rank knows, without negotiation and
+  // concurrently with the background thread. All ranks must call it in the
+  // same order. Returns false if this controller cannot do so.
+  virtual bool BcastBytes(std::string& data, int root_rank) { return false; }
+
+  // Waits until all ranks of the process set have called it, without
+  // negotiation and concurrently with the background thread. All ranks must
+  // call it in the same order. Returns false if this controller cannot do so.
+  virtual bool ImmediateBarrier() { return false; }
+
   //
   // Concrete controller functions
   //
@@ -113,6 +134,10 @@ public:
   // Get current tensors fusion threshold.
   int64_t TensorFusionThresholdBytes();
 
+  // Get current fusion threshold of the reductions of tensors of at least
+  // HOROVOD_FUSION_LARGE_TENSOR_SIZE bytes.
+  int64_t LargeTensorFusionThresholdBytes();
+
   int GetLocalSizeAtCrossRank(int i);
 
   int GetRank() const { return rank_; };
@@ -165,10 +190,48 @@ protected:
   // exist on any worker.
   void CoordinateCacheAndState(CacheCoordinator& cache_coordinator);
 
+  // Cached allgather responses only fix the trailing dimensions. Exchanges
+  // the first dimension of the tensors of the allgather responses among
+  // cache_bits and updates the cached responses with them.
+  void ExchangeAllgatherSizes(const std::set<uint32_t>& cache_bits,
+                              bool joined);
+
   void FuseResponses(std::deque<Response>& responses,
                      HorovodGlobalState& state,
                      ResponseList& response_list);
 
+  // Packs the allreduce, Adasum and reducescatter responses into fused
+  // responses of at most the fusion threshold in a single pass. Tensors with
+  // the same type, devices, dtype, scale factors and reduce op go into the
+  // first bin they fit in. Large tensors, if enabled, only go into bins of
+  // other large tensors, of at most the large tensor fusion threshold. Other
+  // responses keep their place.
+  void PackReductions(std::deque<Response>& responses,
+                      HorovodGlobalState& state);
+
+  // Splits an allreduce of a single tensor larger than partition_size bytes
+  // into responses for consecutive parts of it, which are appended to
+  // partitions. Other responses are appended unchanged.
+  void PartitionResponse(Response response, int64_t partition_size,
+                         std::deque<Response>& partitions);
+
+  // Rounds a fusion threshold up for local reductions, see
+  // TensorFusionThresholdBytes().
+  int64_t AlignFusionThreshold(int64_t proposed_fusion_threshold);
+
+  // Fuses the cached responses of a set of cache bits, consistently across
+  // workers.
+  void FuseCachedResponses(std::set<uint32_t> cache_hits,
+                           HorovodGlobalState& state,
+                           ResponseList& response_list);
+
+  // Replays the next batch of the frozen schedule once all of its tensors
+  // are enqueued. Returns false if workers have left the schedule and the
+  // cycle needs regular coordination.
+  bool ComputeFrozenResponseList(bool this_process_requested_shutdown,
+                                 HorovodGlobalState& state,
+                                 ResponseList& response_list);
+
   // Return the total byte size of the final allgathered output tensor
   int64_t
   TotalByteSizeOfAllgatherOutput(const std::vector<int64_t>& tensor_sizes,
@@ -176,8 +239,10 @@ protected:
 
   // Store the Request for a name, and return whether the total count of
   // Requests for that tensor is now equal to the HOROVOD size (and thus we are
-  // ready to reduce the tensor).
-  bool IncrementTensorCount(const Request& msg, int joined_size = 0);
+  // ready to reduce the tensor). The request is moved into the message table,
+  // table_name is set to the name it is stored under if given.
+  bool IncrementTensorCount(Request&& msg, int joined_size = 0,
+                            const std::string** table_name = nullptr);
 
   bool is_initialized_ = false;
 
@@ -203,7 +268,17 @@ protected:
   // Numbers of ranks running per node
   std::vector<int> local_sizes_for_cross_rank_;
 
-  uint32_t cache_capacity_ = 1024;
+  // Sequence of cached batches replayed without coordination once training
+  // steps repeat, see HOROVOD_FROZEN_SCHEDULE_STEPS.
+  FrozenSchedule frozen_schedule_;
+
+  // Whether and since when this worker has been waiting for all tensors of
+  // the next batch of the frozen schedule to be enqueued.
+  bool frozen_batch_waiting_ = false;
+  std::chrono::steady_clock::time_point frozen_batch_wait_start_;
+
+  // Common cache hits of the last cache sync, the same on all workers.
+  size_t last_common_cache_hits_ = 0;
 
   StallInspector stall_inspector_;
 
@@ -211,6 +286,13 @@ protected:
   // requests to allreduce every tensor (keyed by tensor name).
   MessageTable message_table_;
 
+  // Devices of the ranks that did Join(), keyed by rank, for the responses
+  // constructed while they are joined. Only used on the coordinator.
+  std::unordered_map<int, int32_t> joined_devices_;
+
+  // Interns the tensor names of requests sent to the coordinator.
+  RequestCompressor request_compressor_;
+
   // Outside dependencies
   TensorQueue& tensor_queue_;
 
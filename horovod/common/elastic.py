@@ -14,6 +14,7 @@
 # ==============================================================================
 
 import functools
+import os
 import queue
 
 from horovod.common.exceptions import HorovodInternalError, HostsUpdatedInterrupt
@@ -36,6 +37,7 @@ class State(object):
         self._host_messages = queue.Queue()
         self._last_updated_timestamp = 0
         self._reset_callbacks = []
+        self._commits = 0
 
     def register_reset_callbacks(self, callbacks):
         """Register callbacks that will be invoked following a reset event (worker added or removed).
@@ -68,6 +70,7 @@ class State(object):
         between per-batch execution time and lost training steps in the event of a worker failure.
         """
         self.save()
+        self._commits += 1
         self.check_host_updates()
 
     def check_host_updates(self):
@@ -112,6 +115,18 @@ class State(object):
         """Reset objects and variables following a reset event (before synchronization)."""
         pass
 
+    def _sync_root_ranks(self, allgather_object):
+        """Ranks to synchronize state from: rank 0, or with HOROVOD_ELASTIC_SHARDED_SYNC=1 every
+        worker holding the latest commit, each of which then sends a share of the state."""
+        if os.environ.get('HOROVOD_ELASTIC_SHARDED_SYNC') != '1':
+            return 0
+        commits = allgather_object(self._commits)
+        self._commits = max(commits)
+        if self._commits == 0:
+            # Nothing committed yet, the initial states of the workers may differ.
+            return 0
+        return [r for r, c in enumerate(commits) if c == self._commits]
+
 
 class ObjectState(State):
     """State for simple Python objects.
@@ -0,0 +1,109 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_EVENT_POOL_H
+#define HOROVOD_EVENT_POOL_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace horovod {
+namespace common {
+
+// Lock-free pool of GPU events per device, for the ready events framework
+// threads record for every enqueued tensor. Event is a handle type like
+// gpuEvent_t, where nullptr means no event.
+//
+// Every device has CAPACITY slots. Acquire() takes the event out of a full
+// slot and Release() puts one into an empty slot, each with one atomic
+// exchange, starting at the slot last used so that the search is short
+// while the pool serves as a stack.
+template <class Event, int CAPACITY = 128, int MAX_DEVICES = 64>
+class EventPool {
+public:
+  EventPool() {
+    for (auto& pool : pools_) {
+      for (auto& slot : pool.slots) {
+        slot.store(nullptr, std::memory_order_relaxed);
+      }
+    }
+  }
+  EventPool(const EventPool&) = delete;
+  EventPool& operator=(const EventPool&) = delete;
+
+  // Returns a pooled event of device, or nullptr if there is none and the
+  // caller has to create one.
+  Event Acquire(int device) {
+    if (device < 0 || device >= MAX_DEVICES) {
+      return nullptr;
+    }
+    auto& pool = pools_[device];
+    uint32_t start = pool.last.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < CAPACITY; ++i) {
+      uint32_t index = (start + CAPACITY - i) % CAPACITY;
+      auto& slot = pool.slots[index];
+      if (slot.load(std::memory_order_relaxed) == nullptr) {
+        continue;
+      }
+      Event event = slot.exchange(nullptr, std::memory_order_acquire);
+      if (event != nullptr) {
+        pool.last.store(index, std::memory_order_relaxed);
+        return event;
+      }
+    }
+    return nullptr;
+  }
+
+  // Returns event to the pool of device. Returns false if the pool is full
+  // and the caller has to destroy the event.
+  bool Release(int device, Event event) {
+    if (device < 0 || device >= MAX_DEVICES) {
+      return false;
+    }
+    auto& pool = pools_[device];
+    uint32_t start = pool.last.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < CAPACITY; ++i) {
+      uint32_t index = (start + i) % CAPACITY;
+      auto& slot = pool.slots[index];
+      if (slot.load(std::memory_order_relaxed) != nullptr) {
+        continue;
+      }
+      Event expected = nullptr;
+      if (slot.compare_exchange_strong(expected, event,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+        pool.last.store(index, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  // Devices are used by different framework threads, keep their slots on
+  // separate cache lines.
+  struct alignas(64) DevicePool {
+    std::array<std::atomic<Event>, CAPACITY> slots;
+    std::atomic<uint32_t> last{0};
+  };
+
+  std::array<DevicePool, MAX_DEVICES> pools_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_EVENT_POOL_H
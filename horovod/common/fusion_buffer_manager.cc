@@ -21,22 +21,34 @@ namespace common {
 Status FusionBufferManager::InitializeBuffer(int64_t threshold, int device, std::shared_ptr<OpContext> context,
                                              int stream_id,
                                              std::function<void()> on_start_init,
-                                             std::function<void()> on_end_init) {
-  auto& elem = tensor_fusion_buffers_[std::make_tuple(device, context->framework(), stream_id)];
+                                             std::function<void()> on_end_init,
+                                             const BufferAllocator& allocate) {
+  auto& elem =
+      allocate != nullptr
+          ? owned_fusion_buffers_[OwnedKey(device, stream_id)]
+          : tensor_fusion_buffers_[Key(device, context->framework(), stream_id)];
   auto& buffer = elem.first;
-  int64_t& size = elem.second;
-  if (size != threshold) {
+  int64_t& capacity = elem.second;
+  if (capacity < threshold) {
+    // Only grow the buffer, a smaller threshold keeps using the existing one.
     buffer.reset();
-    size = 0;
+    capacity = 0;
   }
 
   if (buffer == nullptr) {
     on_start_init();
-    size = threshold;
+    int64_t size = SizeClass(threshold);
 
     // Lazily allocate persistent buffer for Tensor Fusion and keep it
     // forever per device.
-    Status status = context->AllocatePersistent(threshold, &buffer);
+    Status status = allocate != nullptr
+                        ? allocate(size, &buffer)
+                        : context->AllocatePersistent(size, &buffer);
+    if (status.ok()) {
+      capacity = size;
+    } else {
+      buffer.reset();
+    }
     on_end_init();
 
     return status;
@@ -45,8 +57,62 @@ Status FusionBufferManager::InitializeBuffer(int64_t threshold, int device, std:
   return Status::OK();
 }
 
+int64_t FusionBufferManager::SizeClass(int64_t threshold) {
+  // Alternating between 2^k and 3 * 2^(k-1) wastes at most a third of the
+  // allocation.
+  int64_t size = 1024 * 1024;
+  while (size < threshold) {
+    if (size + size / 2 >= threshold) {
+      return size + size / 2;
+    }
+    size *= 2;
+  }
+  return size;
+}
+
 std::shared_ptr<PersistentBuffer> FusionBufferManager::GetBuffer(int device, Framework framework, int stream_id) {
-  return tensor_fusion_buffers_[std::make_tuple(device, framework, stream_id)].first;
+  auto owned = owned_fusion_buffers_.find(OwnedKey(device, stream_id));
+  if (owned != owned_fusion_buffers_.end()) {
+    return owned->second.first;
+  }
+  return tensor_fusion_buffers_[Key(device, framework, stream_id)].first;
+}
+
+void FusionBufferManager::AddMemoryUsage(MemoryUsage& usage) const {
+  for (auto& elem : tensor_fusion_buffers_) {
+    if (elem.second.first != nullptr) {
+      usage[std::make_pair(std::get<0>(elem.first), "fusion")] +=
+          elem.second.second;
+    }
+  }
+  for (auto& elem : owned_fusion_buffers_) {
+    if (elem.second.first != nullptr) {
+      usage[std::make_pair(std::get<0>(elem.first), "fusion")] +=
+          elem.second.second;
+    }
+  }
+}
+
+void FusionBufferManager::Release() {
+  tensor_fusion_buffers_.clear();
+  owned_fusion_buffers_.clear();
+}
+
+std::tuple<int, Framework, int> FusionBufferManager::Key(int device, Framework framework, int stream_id) const {
+  // Host buffers are not tied to a GPU stream but to the host slot. Ignoring
+  // the stream also keeps the key stable for CPU operations, which may run
+  // while another process set moves the current stream.
+  if (device == CPU_DEVICE_ID) {
+    stream_id = host_slot_;
+  }
+  return std::make_tuple(device, framework, stream_id);
+}
+
+std::tuple<int, int> FusionBufferManager::OwnedKey(int device, int stream_id) const {
+  if (device == CPU_DEVICE_ID) {
+    stream_id = host_slot_;
+  }
+  return std::make_tuple(device, stream_id);
 }
 
 } // namespace common
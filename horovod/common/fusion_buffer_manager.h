@@ -25,11 +25,24 @@
 namespace horovod {
 namespace common {
 
+using BufferAllocator =
+    std::function<Status(int64_t, std::shared_ptr<PersistentBuffer>*)>;
+
 // Encapsulates the process of creating and destroying fusion buffers as the requested
 // threshold is changed.
+//
+// Buffers are allocated in size classes and are only replaced when the threshold
+// grows beyond the capacity of the cached buffer, so that threshold changes made
+// by the autotuner do not cause a reallocation on every step. Each GPU stream has
+// its own buffer, which lets the fusion of a response on one stream overlap with
+// the collective of the previous response on another stream.
+//
+// Buffers allocated by the framework can only be accessed through an op context
+// of that framework, so every framework has buffers of its own. Buffers Horovod
+// allocates itself are shared by all frameworks using the device and stream.
 class FusionBufferManager {
 public:
-  // Initializes a buffer of the given threshold size if not already cached.
+  // Initializes a buffer of at least the given threshold size if not already cached.
   //
   // Args:
   //  threshold: Size of the buffer in bytes.
@@ -37,22 +50,51 @@ public:
   //  context: Framework used to create the buffer and associate it.
   //  on_start_init: Callback on starting buffer initialization.
   //  on_end_init: Callback on completing buffer initialization.
+  //  allocate: Allocates buffers of the given size instead of the framework
+  //            if set. Such buffers are not tied to the framework.
   Status InitializeBuffer(int64_t threshold,
                           int device, std::shared_ptr<OpContext> context,
                           int stream_id,
                           std::function<void()> on_start_init,
-                          std::function<void()> on_end_init);
+                          std::function<void()> on_end_init,
+                          const BufferAllocator& allocate = nullptr);
 
   // Returns the buffer associated with the given device and framework, or null.
   std::shared_ptr<PersistentBuffer> GetBuffer(int device, Framework framework, int stream_id);
 
+  // Returns the capacity allocated for a requested threshold: the smallest size
+  // class of the form 2^k or 3 * 2^(k-1) bytes that holds it, with a minimum of 1 MB.
+  static int64_t SizeClass(int64_t threshold);
+
+  // Adds the capacity of all buffers to usage.
+  void AddMemoryUsage(MemoryUsage& usage) const;
+
+  // Drops all buffers, InitializeBuffer() allocates them again. Buffers
+  // still used by operations in flight are freed once those are done.
+  void Release();
+
+  // Host buffers are keyed by this slot instead of the GPU stream, so that
+  // CPU operations completing asynchronously each fuse into a buffer of
+  // their own. Defaults to 0.
+  void SetHostSlot(int slot) { host_slot_ = slot; }
+  int HostSlot() const { return host_slot_; }
+
 private:
-  // Memory buffers for Tensor Fusion.  They are keyed off device ID and
-  // framework, and all are allocated tensor_fusion_threshold bytes if
-  // initialized.
+  std::tuple<int, Framework, int> Key(int device, Framework framework, int stream_id) const;
+  std::tuple<int, int> OwnedKey(int device, int stream_id) const;
+
+  int host_slot_ = 0;
+
+  // Memory buffers for Tensor Fusion.  They are keyed off device ID,
+  // framework and stream ID, and are stored with their capacity in bytes.
   std::unordered_map<
       std::tuple<int, Framework, int>,
       std::pair<std::shared_ptr<PersistentBuffer>, int64_t>> tensor_fusion_buffers_;
+
+  // Buffers allocated by Horovod, keyed off device ID and stream ID only.
+  std::unordered_map<
+      std::tuple<int, int>,
+      std::pair<std::shared_ptr<PersistentBuffer>, int64_t>> owned_fusion_buffers_;
 };
 
 } // namespace common
@@ -17,15 +17,26 @@
 #ifndef HOROVOD_GLOBAL_STATE_H
 #define HOROVOD_GLOBAL_STATE_H
 
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
 #include <queue>
 #include <thread>
 
+#include "bucket_table.h"
 #include "fusion_buffer_manager.h"
+#include "gradient_arena.h"
+#include "metrics.h"
 #include "group_table.h"
 #include "parameter_manager.h"
+#include "peer_queue.h"
 #include "process_set.h"
+#include "step_profiler.h"
+#include "thread_pool.h"
 #include "timeline.h"
 #include "utils/env_parser.h"
+#include "wakeup_signal.h"
 
 namespace horovod {
 namespace common {
@@ -47,9 +58,22 @@ struct HorovodGlobalState {
   // Whether the background thread should shutdown.
   std::atomic_bool shut_down{false};
 
+  // Whether the shutdown is an elastic reset, after which the background
+  // thread keeps its GPU buffers, NCCL communicators and tuned parameters for
+  // the next initialization.
+  bool keep_state = false;
+
+  // Tuned parameters kept by an elastic reset and the process layout they
+  // were tuned for, valid if kept_params_topology is not empty.
+  ParameterManager::Params kept_params;
+  std::string kept_params_topology;
+
   // Timeline writer.
   Timeline timeline;
 
+  // Whether every rank writes its own timeline, not only the coordinator.
+  bool timeline_all_ranks = false;
+
   TimelineController timeline_controller;
 
   // Flag indicating whether running elastic.
@@ -60,15 +84,53 @@ struct HorovodGlobalState {
 
   ParameterManager parameter_manager;
 
-  // Encapsulates the fusion buffers, handles resizing and auto-tuning of buffer
-  // size.
-  FusionBufferManager fusion_buffer;
+  // Always-on performance counters, see horovod_get_metrics().
+  Metrics metrics;
+
+  // Exposed communication per training step, see horovod_step_begin().
+  StepProfiler step_profiler;
 
   ProcessSetTable process_set_table;
 
   // Whether process sets can be added/removed after initialization.
   std::atomic_bool dynamic_process_sets{false};
 
+  // Number of threads running the cycles of process sets other than the
+  // global one concurrently with it. Zero runs all process sets one after
+  // another on the background thread.
+  int num_process_set_threads = 0;
+
+  ThreadPool process_set_thread_pool;
+
+  // Number of negotiated cycles the executor thread may be behind the
+  // background thread, which negotiates the next cycles meanwhile. Zero
+  // performs every cycle on the background thread right after negotiating it.
+  int pipeline_depth = 0;
+
+  ThreadPool executor_thread_pool;
+
+  // Cycles handed to the executor thread, oldest first.
+  std::deque<std::future<void>> pending_cycles;
+
+  // Buffer releases and memory reports asked for by framework threads, which
+  // the background thread serves between cycles. A request is served once
+  // memory_requests_served reaches the value memory_requests_issued had
+  // after it was made.
+  std::mutex memory_requests_mutex;
+  std::condition_variable memory_requests_cond;
+  bool release_buffers_requested = false;
+  bool memory_usage_requested = false;
+  uint64_t memory_requests_issued = 0;
+  uint64_t memory_requests_served = 0;
+  MemoryUsage memory_usage;
+
+  // Buffers are released once no tensor has been processed for this long,
+  // zero keeps them.
+  std::chrono::steady_clock::duration buffer_idle_timeout{0};
+  std::chrono::steady_clock::time_point last_tensor_time;
+  int64_t last_tensor_count = 0;
+  bool buffers_released_idle = false;
+
   // Rank storage for process sets requested in InitializeHorovodOnce to be
   // initialized in the background thread.
   std::vector<std::vector<int>> process_set_ranks_to_register;
@@ -76,6 +138,22 @@ struct HorovodGlobalState {
   // Time point when last cycle started.
   std::chrono::steady_clock::time_point last_cycle_start;
 
+  // Flag indicating whether the background thread should start a new cycle
+  // as soon as tensors are enqueued, using the cycle time only as an upper
+  // bound on how long it waits.
+  bool event_driven_loop = false;
+
+  // Notified by the tensor queues when event_driven_loop is enabled, and
+  // whenever a bucket of allreduces has been enqueued.
+  WakeupSignal wakeup_signal;
+
+  // Buckets of allreduces of the global process set, see
+  // EnqueueTensorBucketedAllreduce().
+  BucketTable bucket_table;
+
+  // Sends and receives between two ranks, see EnqueueTensorSend().
+  PeerQueue peer_queue;
+
   // Whether collective context has been completed on the background thread.
   std::atomic_bool initialization_done{false};
 
@@ -88,12 +166,60 @@ struct HorovodGlobalState {
   // Number of responses that can be cached (RepsonseCache lives in ProcessSet)
   uint32_t cache_capacity = 1024;
 
-  // Number of GPU streams to use
+  // Limit up to which a full response cache grows instead of evicting.
+  uint32_t cache_max_capacity = 16384;
+
+  // Number of identical steps served from the response cache after which
+  // the controllers replay them without coordination. Disabled if 0.
+  int frozen_schedule_steps = 0;
+
+  // Number of GPU streams allocated, of which the first
+  // parameter_manager.NumNcclStreams() are used.
   int num_nccl_streams = 1;
 
   // Index of current GPU stream to use
   int current_nccl_stream = 0;
 
+  // Whether GPU responses are placed on the least loaded stream instead of
+  // rotating through the streams.
+  bool balance_nccl_streams = false;
+
+  // Whether NCCL allreduces that repeat on the same buffers are replayed
+  // from captured CUDA graphs.
+  bool cuda_graphs = false;
+
+  // Whether consecutive GPU allreduces of a cycle that fit in the fusion
+  // buffer together are launched as one NCCL group.
+  bool group_nccl_responses = false;
+
+  // Whether GPU responses are completed by a single event polling thread
+  // instead of the finalizer thread pool.
+  bool gpu_completion_engine = false;
+
+  // Whether frameworks leave the outputs of GPU allreduces to Horovod, which
+  // writes the results to pooled device memory that the outputs point into.
+  bool pooled_outputs = false;
+
+  // Threads splitting CPU fusion buffer copies, scaling and float16
+  // reductions. The background thread is one of them.
+  WorkStealingThreadPool cpu_thread_pool;
+
+  // Whether CPU MPI allreduces sum with Horovod's SIMD kernels instead of
+  // MPI_SUM.
+  bool mpi_cpu_sum_kernels = true;
+
+  // Whether CPU MPI and Gloo allreduces sum float16 and bfloat16 as float32,
+  // rounding once at the end instead of after every addition.
+  bool cpu_fp32_accumulation = false;
+
+  // Whether CPU MPI allreduces are summed within each node in a shared memory
+  // segment, with only the cross-node part going through MPI.
+  bool shm_allreduce = false;
+
+  // Whether each global rank runs next to a NIC. The first such local rank
+  // of a node allocates the shared memory segments of the node.
+  std::vector<bool> near_nic_ranks;
+
   // A LibType indicating what framework we are using to perform CPU operations.
   LibType cpu_operation;
 
@@ -101,16 +227,59 @@ struct HorovodGlobalState {
   // operations.
   LibType control_operation;
 
-  // Chunk size for MPI send/recv in Adasum allreduce. Some versions of Intel MPI
-  // benefit from a smaller chunk size.
-  int64_t adasum_mpi_chunk_size = 1<<30;
+  // Whether GPU Adasum runs its cross-node reduction on device buffers, with
+  // CUDA kernels and CUDA-aware MPI, instead of staging through host memory.
+  bool adasum_gpu_direct = false;
+
+  // Chunk size in bytes for pipelining the device to host copy, the cross
+  // node MPI allreduce and the host to device copy in NCCL hierarchical
+  // allreduce. Zero disables pipelining.
+  int64_t hierarchical_allreduce_chunk_size = 4 * 1024 * 1024;
+
+  // Compression of the float32 data that NCCL hierarchical allreduce sums
+  // across nodes. The data stays in full precision within a node.
+  FusionCompression hierarchical_allreduce_compression = FusionCompression::NONE;
 
-  // Enable use of batched d2d memcopy kernel on GPU
-  bool batch_d2d_memcopies = true;
+  // Chunk size in bytes for pipelining the fusion buffer copies, scaling and
+  // non-blocking CUDA-aware MPI allreduce of GPU allreduces over MPI. Zero
+  // reduces the whole buffer with one blocking MPI_Allreduce.
+  int64_t mpi_gpu_allreduce_chunk_size = 0;
+
+  // MPI broadcasts of at least this many bytes are sent down a binary tree
+  // in chunks of broadcast_chunk_size bytes, pipelined across the levels of
+  // the tree. Zero leaves them to MPI_Bcast.
+  int64_t broadcast_tree_threshold = 1024 * 1024;
+  int64_t broadcast_chunk_size = 256 * 1024;
+
+  // MPI broadcasts of at least this many bytes are scattered from the root
+  // and allgathered. Zero disables this.
+  int64_t broadcast_scatter_allgather_threshold = 64 * 1024 * 1024;
+
+  // Name of the compressor of fused GPU allreduce data, applied while the
+  // data is copied into and out of the fusion buffer.
+  std::string fusion_compression = "none";
 
   // Flag indicating whether to prohibit groups from fusing
   bool disable_group_fusion = false;
 
+  // Allreduced tensors of at least this many bytes are never fused, they are
+  // reduced directly between the framework input and output buffers.
+  // Disabled if 0.
+  int64_t zero_copy_threshold = 0;
+
+  // Allreduced tensors larger than this many bytes are reduced in parts of
+  // this size, each scheduled as a response of its own. Disabled if 0.
+  int64_t tensor_partition_size = 0;
+
+  // Reduced tensors of at least this many bytes are fused among themselves
+  // only, up to the large tensor fusion threshold of the ParameterManager.
+  // Disabled if 0.
+  int64_t fusion_large_tensor_size = 0;
+
+  // Contiguous gradient buffers registered by the framework, fused
+  // allreduces of tensors inside one of them skip the fusion buffer.
+  GradientArenaTable gradient_arenas;
+
   // Flag indicating whether to enable async completion
   bool enable_async_completion = false;
 
@@ -24,6 +24,7 @@
 
 #include "gloo/allgather.h"
 #include "gloo/barrier.h"
+#include "gloo/config.h"
 #include "gloo/rendezvous/context.h"
 #include "gloo/rendezvous/file_store.h"
 #include "gloo/rendezvous/prefix_store.h"
@@ -39,12 +40,17 @@ using attr = gloo::transport::uv::attr;
 constexpr auto CreateDevice = gloo::transport::uv::CreateDevice;
 #endif
 
+#if GLOO_HAVE_TRANSPORT_IBVERBS
+#include "gloo/transport/ibverbs/device.h"
+#endif
+
 #if HAVE_MPI
 #include "gloo/mpi/context.h"
 #endif
 
 #include "http_store.h"
 #include "memory_store.h"
+#include "../topology.h"
 #include "../utils/env_parser.h"
 
 namespace horovod {
@@ -64,6 +70,58 @@ std::chrono::milliseconds GetTimeoutFromEnv() {
   return std::chrono::duration_cast<std::chrono::milliseconds>(s);
 }
 
+void GlooContext::ReadTransportsFromEnv() {
+  auto local_env = std::getenv(HOROVOD_GLOO_LOCAL_TRANSPORT);
+  if (local_env != nullptr && local_env[0] != '\0') {
+    local_transport_ = local_env;
+  }
+  auto cross_env = std::getenv(HOROVOD_GLOO_CROSS_TRANSPORT);
+  if (cross_env != nullptr && cross_env[0] != '\0') {
+    cross_transport_ = cross_env;
+  }
+  if (cross_transport_ == GLOO_TRANSPORT_LOOPBACK) {
+    throw std::runtime_error(std::string(HOROVOD_GLOO_CROSS_TRANSPORT) +
+                             "=loopback is only valid for the local context.");
+  }
+}
+
+std::shared_ptr<gloo::transport::Device>
+GlooContext::CreateTransportDevice(const std::string& transport,
+                                   bool local) const {
+  if (transport == GLOO_TRANSPORT_TCP) {
+    attr device_attr;
+    device_attr.iface = gloo_iface_;
+    device_attr.ai_family = AF_UNSPEC;
+    return CreateDevice(device_attr);
+  }
+  if (transport == GLOO_TRANSPORT_LOOPBACK && local) {
+    // Processes on the same host connect over the loopback device instead of
+    // the address of HOROVOD_GLOO_IFACE.
+    attr device_attr;
+    device_attr.hostname = "127.0.0.1";
+    device_attr.ai_family = AF_INET;
+    return CreateDevice(device_attr);
+  }
+  if (transport == GLOO_TRANSPORT_IBVERBS) {
+#if GLOO_HAVE_TRANSPORT_IBVERBS
+    gloo::transport::ibverbs::attr device_attr;
+    auto ib_device = std::getenv(HOROVOD_GLOO_IB_DEVICE);
+    // gloo picks the first device when no name is given.
+    device_attr.name = ib_device != nullptr ? ib_device : "";
+    device_attr.port = GetIntEnvOrDefault(HOROVOD_GLOO_IB_PORT, 1);
+    device_attr.index = GetIntEnvOrDefault(HOROVOD_GLOO_IB_GID_INDEX, 0);
+    return gloo::transport::ibverbs::CreateDevice(device_attr);
+#else
+    throw std::runtime_error(
+        "Gloo ibverbs transport requested, but Horovod was built without it. "
+        "Reinstall Horovod with HOROVOD_GLOO_WITH_IBVERBS=1.");
+#endif
+  }
+  throw std::runtime_error("Unsupported Gloo transport '" + transport +
+                           "' for the " + (local ? "local" : "cross") +
+                           " context.");
+}
+
 std::shared_ptr<gloo::Context> Rendezvous(const std::string& prefix,
                                           const char* server_addr_env, int server_port,
                                           int rank, int size,
@@ -108,6 +166,9 @@ void GlooContext::InitializeFromMPI(MPIContext& mpi_ctx,
   device_attr.ai_family = AF_UNSPEC;
   auto dev = CreateDevice(device_attr);
   timeout_ = GetTimeoutFromEnv();
+  ReadTransportsFromEnv();
+  auto local_dev = CreateTransportDevice(local_transport_, true);
+  auto cross_dev = CreateTransportDevice(cross_transport_, false);
 
   auto context =
       std::make_shared<gloo::mpi::Context>(mpi_ctx.GetMPICommunicator(GLOBAL));
@@ -120,13 +181,13 @@ void GlooContext::InitializeFromMPI(MPIContext& mpi_ctx,
   auto cross_context =
       std::make_shared<gloo::mpi::Context>(mpi_ctx.GetMPICommunicator(CROSS));
   cross_context->setTimeout(timeout_);
-  cross_context->connectFullMesh(dev);
+  cross_context->connectFullMesh(cross_dev);
   cross_ctx = cross_context;
 
   auto local_context =
       std::make_shared<gloo::mpi::Context>(mpi_ctx.GetMPICommunicator(LOCAL));
   local_context->setTimeout(timeout_);
-  local_context->connectFullMesh(dev);
+  local_context->connectFullMesh(local_dev);
   local_ctx = local_context;
 }
 #endif
@@ -146,6 +207,11 @@ void GlooContext::Initialize(const std::string& gloo_iface) {
   device_attr.ai_family = AF_UNSPEC;
   auto dev = CreateDevice(device_attr);
   timeout_ = GetTimeoutFromEnv();
+  ReadTransportsFromEnv();
+  auto local_dev = CreateTransportDevice(local_transport_, true);
+  auto cross_dev = CreateTransportDevice(cross_transport_, false);
+  LOG(DEBUG) << "Gloo transports: local=" << local_transport_
+             << ", cross=" << cross_transport_;
 
   auto host_env = std::getenv(HOROVOD_HOSTNAME);
   hostname_ = host_env != nullptr ? std::string(host_env) : std::string("localhost");
@@ -222,12 +288,12 @@ void GlooContext::Initialize(const std::string& gloo_iface) {
 
   local_ctx = Rendezvous(HOROVOD_GLOO_LOCAL_PREFIX + hostname_,
                          rendezvous_addr_env, rendezvous_port,
-                         local_rank, local_size, dev, timeout_);
+                         local_rank, local_size, local_dev, timeout_);
   LOG(DEBUG) << "Local Gloo context initialized.";
 
   cross_ctx = Rendezvous(HOROVOD_GLOO_CROSS_PREFIX + std::to_string(local_rank),
                          rendezvous_addr_env, rendezvous_port,
-                         cross_rank, cross_size, dev, timeout_);
+                         cross_rank, cross_size, cross_dev, timeout_);
   LOG(DEBUG) << "Cross-node Gloo context initialized.";
 }
 
@@ -286,6 +352,9 @@ void GlooContext::InitializeForProcessSet(const GlooContext& global_context,
   global_ctx = global_context.ctx;
   timeout_ = global_context.timeout_;
   hostname_ = global_context.hostname_;
+  gloo_iface_ = global_context.gloo_iface_;
+  local_transport_ = global_context.local_transport_;
+  cross_transport_ = global_context.cross_transport_;
 
   std::vector<int> ranks;
   if (registered_ranks.empty()) {
@@ -335,6 +404,10 @@ void GlooContext::InitializeForProcessSet(const GlooContext& global_context,
                    timeout_);
   LOG(DEBUG) << "Global Gloo context initialized for process set with hash "
              << process_set_hash << ".";
+  int max_outstanding = GetIntEnvOrDefault(HOROVOD_GLOO_MAX_OUTSTANDING, 2);
+  if (max_outstanding > 0) {
+    workers = std::make_shared<GlooWorkers>(max_outstanding);
+  }
 
   // 2) process-set-limited local context
   auto global_context_local_ranks =
@@ -353,7 +426,7 @@ void GlooContext::InitializeForProcessSet(const GlooContext& global_context,
     local_ctx =
         Rendezvous(HOROVOD_GLOO_LOCAL_PREFIX + hostname_ + process_set_suffix,
                    rendezvous_addr_env, rendezvous_port, local_rank, local_size,
-                   dev, timeout_);
+                   CreateTransportDevice(local_transport_, true), timeout_);
     LOG(DEBUG) << "Local Gloo context initialized for process set with hash "
                << process_set_hash << ".";
   }
@@ -375,18 +448,82 @@ void GlooContext::InitializeForProcessSet(const GlooContext& global_context,
     cross_ctx = Rendezvous(HOROVOD_GLOO_CROSS_PREFIX +
                                std::to_string(local_rank) + process_set_suffix,
                            rendezvous_addr_env, rendezvous_port, cross_rank,
-                           cross_size, dev, timeout_);
+                           cross_size,
+                           CreateTransportDevice(cross_transport_, false),
+                           timeout_);
     LOG(DEBUG) << "Cross-node Gloo context for process set with hash "
                << process_set_hash << ".";
   }
 }
 
 
+GlooWorkers::GlooWorkers(int num_slots) : slots_(num_slots) {}
+
+GlooWorkers::~GlooWorkers() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    running_ = false;
+  }
+  work_cond_.notify_all();
+  for (auto& slot : slots_) {
+    if (slot.thread.joinable()) {
+      slot.thread.join();
+    }
+  }
+}
+
+int GlooWorkers::AcquireSlot() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cond_.wait(lock, [this] { return !slots_[next_slot_].busy; });
+  int slot = next_slot_;
+  next_slot_ = (next_slot_ + 1) % (int)slots_.size();
+  return slot;
+}
+
+void GlooWorkers::Run(int slot, std::function<void()> work) {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    slots_[slot].work = std::move(work);
+    slots_[slot].busy = true;
+    if (!slots_[slot].thread.joinable()) {
+      slots_[slot].thread = std::thread(&GlooWorkers::Loop, this, slot);
+    }
+  }
+  work_cond_.notify_all();
+}
+
+void GlooWorkers::Loop(int slot) {
+  PlaceHelperThread();
+  while (true) {
+    std::function<void()> work;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // Run the outstanding collective before stopping.
+      work_cond_.wait(lock, [this, slot] {
+        return !running_ || slots_[slot].work != nullptr;
+      });
+      if (slots_[slot].work == nullptr) {
+        return;
+      }
+      work = std::move(slots_[slot].work);
+      slots_[slot].work = nullptr;
+    }
+    work();
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      slots_[slot].busy = false;
+    }
+    idle_cond_.notify_all();
+  }
+}
+
 void GlooContext::Finalize() {
   if (!enabled_) {
     return;
   }
 
+  // Outstanding collectives still use the contexts.
+  workers.reset();
   global_ctx.reset();
   ctx.reset();
   cross_ctx.reset();
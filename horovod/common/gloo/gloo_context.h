@@ -16,7 +16,14 @@
 #ifndef HOROVOD_GLOO_CONTEXT_H
 #define HOROVOD_GLOO_CONTEXT_H
 
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "gloo/context.h"
+#include "gloo/transport/device.h"
 
 #include "../common.h"
 #include "../logging.h"
@@ -41,9 +48,59 @@
 #define HOROVOD_CROSS_RANK "HOROVOD_CROSS_RANK"
 #define HOROVOD_CROSS_SIZE "HOROVOD_CROSS_SIZE"
 
+// Transports of the local and cross contexts: tcp (default), loopback (TCP
+// over 127.0.0.1, local context only) or ibverbs.
+#define HOROVOD_GLOO_LOCAL_TRANSPORT "HOROVOD_GLOO_LOCAL_TRANSPORT"
+#define HOROVOD_GLOO_CROSS_TRANSPORT "HOROVOD_GLOO_CROSS_TRANSPORT"
+#define HOROVOD_GLOO_IB_DEVICE "HOROVOD_GLOO_IB_DEVICE"
+#define HOROVOD_GLOO_IB_PORT "HOROVOD_GLOO_IB_PORT"
+#define HOROVOD_GLOO_IB_GID_INDEX "HOROVOD_GLOO_IB_GID_INDEX"
+#define GLOO_TRANSPORT_TCP "tcp"
+#define GLOO_TRANSPORT_LOOPBACK "loopback"
+#define GLOO_TRANSPORT_IBVERBS "ibverbs"
+
 namespace horovod {
 namespace common {
 
+// Threads of a process set running its Gloo collectives, one per slot, so
+// that several responses can be in flight while the background thread
+// negotiates the next ones. A slot runs its collectives one after another,
+// all with the tag of the slot. Every rank acquires the slots in the same
+// response order, so the tags of a collective match across ranks.
+class GlooWorkers {
+public:
+  explicit GlooWorkers(int num_slots);
+
+  // Waits for the outstanding collectives.
+  ~GlooWorkers();
+
+  // Returns the next slot, once its last collective has finished.
+  int AcquireSlot();
+
+  // Runs work on the thread of slot, started on first use.
+  void Run(int slot, std::function<void()> work);
+
+  // Tag of the collectives of slot. Those run by the background thread keep
+  // Gloo's default tag 0.
+  static uint32_t Tag(int slot) { return 1 + (uint32_t)slot; }
+
+private:
+  struct Slot {
+    std::thread thread;
+    std::function<void()> work;
+    bool busy = false;
+  };
+
+  void Loop(int slot);
+
+  std::vector<Slot> slots_;
+  int next_slot_ = 0;
+  bool running_ = true;
+  std::mutex mutex_;
+  std::condition_variable work_cond_;
+  std::condition_variable idle_cond_;
+};
+
 struct GlooContext {
 
 #if HAVE_MPI
@@ -73,7 +130,18 @@ struct GlooContext {
   std::shared_ptr<gloo::Context> cross_ctx = nullptr;
   std::shared_ptr<gloo::Context> local_ctx = nullptr;
 
+  // Up to HOROVOD_GLOO_MAX_OUTSTANDING (default 2) collectives of CPU
+  // tensors in flight, null if 0.
+  std::shared_ptr<GlooWorkers> workers;
+
 private:
+  // Creates the device of a context for HOROVOD_GLOO_LOCAL_TRANSPORT or
+  // HOROVOD_GLOO_CROSS_TRANSPORT, falling back to TCP on gloo_iface_.
+  std::shared_ptr<gloo::transport::Device>
+  CreateTransportDevice(const std::string& transport, bool local) const;
+
+  void ReadTransportsFromEnv();
+
   // Flag indicating whether gloo is enabled.
   bool enabled_ = false;
   bool reset_ = false;
@@ -81,6 +149,8 @@ private:
   std::chrono::milliseconds timeout_;
   std::string hostname_;
   std::string gloo_iface_;
+  std::string local_transport_ = GLOO_TRANSPORT_TCP;
+  std::string cross_transport_ = GLOO_TRANSPORT_TCP;
 };
 
 } // namespace common
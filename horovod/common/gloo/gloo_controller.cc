@@ -163,36 +163,33 @@ void GlooController::RecvReadyTensors(std::vector<std::string>& ready_to_reduce,
   }
 
   // 3. Collect messages from every rank.
-  std::unique_ptr<uint8_t[]> buffer(new uint8_t[total_size]);
+  recv_buffer_.resize(total_size);
 
   // do allgatherv
   {
-    auto input = new uint8_t[0];
+    uint8_t input = 0;
     gloo::AllgathervOptions opts(gloo_context_.ctx);
-    opts.setInput(input, 0);
+    opts.setInput(&input, 0);
     std::vector<size_t> count_vec(recvcounts.get(), recvcounts.get() + size_);
-    opts.setOutput(buffer.get(), count_vec);
+    opts.setOutput(recv_buffer_.data(), count_vec);
     gloo::allgatherv(opts);
   }
 
-  // 4. Process messages.
-  // create a dummy list for rank 0
-  ready_list.emplace_back();
+  // 4. Process messages, parsing every rank directly into its list. The list
+  // of rank 0 stays empty as a dummy.
+  ready_list.resize(size_);
   for (int i = 1; i < size_; ++i) {
-    auto rank_buffer_ptr = buffer.get() + displcmnts[i];
-    RequestList received_message_list;
-    RequestList::ParseFromBytes(received_message_list, rank_buffer_ptr);
-    ready_list.push_back(std::move(received_message_list));
+    RequestList::ParseFromBytes(ready_list[i],
+                                recv_buffer_.data() + displcmnts[i]);
   }
 }
 
 void GlooController::SendFinalTensors(ResponseList& response_list) {
   // Notify all nodes which tensors we'd like to reduce at this step.
-  std::string encoded_response;
-  ResponseList::SerializeToString(response_list, encoded_response);
+  ResponseList::SerializeToString(response_list, encoded_message_);
 
   // Boardcast the response length
-  int encoded_response_length = (int)encoded_response.length() + 1;
+  int encoded_response_length = (int)encoded_message_.length() + 1;
   {
     gloo::BroadcastOptions opts(gloo_context_.ctx);
     opts.setOutput(&encoded_response_length, 1);
@@ -203,7 +200,7 @@ void GlooController::SendFinalTensors(ResponseList& response_list) {
   // Boardcast the response
   {
     gloo::BroadcastOptions opts(gloo_context_.ctx);
-    opts.setOutput((uint8_t*)(encoded_response.c_str()),
+    opts.setOutput((uint8_t*)(encoded_message_.c_str()),
                    encoded_response_length);
     opts.setRoot(RANK_ZERO);
     gloo::broadcast(opts);
@@ -211,14 +208,13 @@ void GlooController::SendFinalTensors(ResponseList& response_list) {
 }
 
 void GlooController::SendReadyTensors(RequestList& message_list) {
-  std::string encoded_message;
-  RequestList::SerializeToString(message_list, encoded_message);
+  RequestList::SerializeToString(message_list, encoded_message_);
 
   // Gloo doesn't have the gatherv options, using allgatherv instead.
 
   // send message length to root
   std::unique_ptr<int[]> recvcounts(new int[size_]);
-  int encoded_message_length = (int)encoded_message.length() + 1;
+  int encoded_message_length = (int)encoded_message_.length() + 1;
   {
     gloo::AllgatherOptions opts(gloo_context_.ctx);
     opts.setInput(&encoded_message_length, 1);
@@ -238,13 +234,13 @@ void GlooController::SendReadyTensors(RequestList& message_list) {
   }
 
   // 3. Collect messages from every rank.
-  std::unique_ptr<uint8_t[]> buffer(new uint8_t[total_size]);
+  recv_buffer_.resize(total_size);
   // send message body to root
   {
     gloo::AllgathervOptions opts(gloo_context_.ctx);
-    opts.setInput((uint8_t*)encoded_message.c_str(), encoded_message_length);
+    opts.setInput((uint8_t*)encoded_message_.c_str(), encoded_message_length);
     std::vector<size_t> count_vec(recvcounts.get(), recvcounts.get() + size_);
-    opts.setOutput((uint8_t*)buffer.get(), count_vec);
+    opts.setOutput(recv_buffer_.data(), count_vec);
     gloo::allgatherv(opts);
   }
 }
@@ -259,16 +255,15 @@ void GlooController::RecvFinalTensors(ResponseList& response_list) {
     gloo::broadcast(opts);
   }
   // root broadcast final message to others
-  std::unique_ptr<uint8_t[]> buffer(new uint8_t[msg_length]);
-  memset(buffer.get(), 0, msg_length);
+  recv_buffer_.resize(msg_length);
   {
     gloo::BroadcastOptions opts(gloo_context_.ctx);
-    opts.setOutput((uint8_t*)buffer.get(), msg_length);
+    opts.setOutput(recv_buffer_.data(), msg_length);
     opts.setRoot(RANK_ZERO);
     gloo::broadcast(opts);
   }
 
-  ResponseList::ParseFromBytes(response_list, buffer.get());
+  ResponseList::ParseFromBytes(response_list, recv_buffer_.data());
 }
 
 void GlooController::Bcast(void* buffer, size_t size, int root_rank,
@@ -281,11 +276,11 @@ void GlooController::Bcast(void* buffer, size_t size, int root_rank,
 
 void GlooController::AlltoallGetRecvSplits(const std::vector<int32_t>& splits,
                                            std::vector<int32_t>& recvsplits) {
-  recvsplits.resize(size_);
+  recvsplits.resize(splits.size());
   gloo::AlltoallOptions opts(
       gloo_context_.GetGlooContext(Communicator::GLOBAL));
-  opts.setInput((int32_t*)splits.data(), size_);
-  opts.setOutput(recvsplits.data(), size_);
+  opts.setInput((int32_t*)splits.data(), splits.size());
+  opts.setOutput(recvsplits.data(), recvsplits.size());
   gloo::alltoall(opts);
 }
 
@@ -294,6 +289,16 @@ void GlooController::Barrier(Communicator communicator) {
   gloo::barrier(opts);
 }
 
+bool GlooController::ImmediateBarrier() {
+  // Gloo matches collectives by tag, so a tag the background thread and the
+  // Gloo workers never use keeps the barrier apart from their collectives.
+  const uint32_t immediate_barrier_tag = 0xffffffff;
+  gloo::BarrierOptions opts(gloo_context_.GetGlooContext(Communicator::GLOBAL));
+  opts.setTag(immediate_barrier_tag);
+  gloo::barrier(opts);
+  return true;
+}
+
 void GlooController::Allgather2Ints(std::array<int, 2> values,
                                     std::vector<int>& recv_values) {
   recv_values.resize(size_ * 2);
@@ -304,5 +309,15 @@ void GlooController::Allgather2Ints(std::array<int, 2> values,
   gloo::allgather(opts);
 }
 
+void GlooController::AllgatherInt64s(const std::vector<int64_t>& values,
+                                     std::vector<int64_t>& recv_values) {
+  recv_values.resize(size_ * values.size());
+  gloo::AllgatherOptions opts(
+      gloo_context_.GetGlooContext(Communicator::GLOBAL));
+  opts.setInput(const_cast<int64_t*>(values.data()), values.size());
+  opts.setOutput(recv_values.data(), recv_values.size());
+  gloo::allgather(opts);
+}
+
 } // namespace common
 } // namespace horovod
@@ -59,13 +59,23 @@ public:
 
   void Barrier(Communicator communicator) override;
 
+  bool ImmediateBarrier() override;
+
   void Allgather2Ints(std::array<int, 2> values,
                       std::vector<int>& recv_values) override;
 
+  void AllgatherInt64s(const std::vector<int64_t>& values,
+                       std::vector<int64_t>& recv_values) override;
+
 protected:
   void DoInitialization() override;
 
   GlooContext& gloo_context_;
+
+  // Negotiation buffers kept across cycles, so that the messages of every
+  // cycle are encoded and received without allocating once they have grown.
+  std::string encoded_message_;
+  std::vector<uint8_t> recv_buffer_;
 };
 
 template <typename T>
@@ -16,6 +16,7 @@
 #include "http_store.h"
 #include "gloo_context.h"
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <istream>
@@ -37,6 +38,10 @@ void HTTPStore::set(const std::string& key, const std::vector<char>& data) {
 }
 
 std::vector<char> HTTPStore::get(const std::string& key) {
+  auto it = fetched_.find(key);
+  if (it != fetched_.end()) {
+    return it->second;
+  }
   std::vector<char> result;
   HTTP_GET(key, result);
   return result;
@@ -46,7 +51,24 @@ void HTTPStore::wait(const std::vector<std::string>& keys,
                      const std::chrono::milliseconds& timeout) {
   const auto start = std::chrono::steady_clock::now();
 
-  while (!CheckKeys(keys)) {
+  while (true) {
+    std::vector<std::string> missing;
+    for (const auto& key : keys) {
+      if (fetched_.find(key) == fetched_.end()) {
+        missing.push_back(key);
+      }
+    }
+    if (missing.empty()) {
+      return;
+    }
+    if (batch_get_supported_) {
+      // The server holds the request until the keys are set, no need to
+      // sleep between requests.
+      batch_get_supported_ = HTTP_GET_BATCH(missing, BATCH_GET_WAIT_MILLSEC);
+    } else if (CheckKeys(missing)) {
+      return;
+    }
+
     const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::steady_clock::now() - start);
     if (timeout != gloo::kNoTimeout && elapsed > timeout) {
@@ -56,8 +78,10 @@ void HTTPStore::wait(const std::vector<std::string>& keys,
                                              ". You may want to increase the timeout via ",
                                              HOROVOD_GLOO_TIMEOUT_SECONDS));
     }
-    /* sleep override */
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (!batch_get_supported_) {
+      /* sleep override */
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
   }
 }
 
@@ -115,6 +139,50 @@ bool HTTPStore::HTTP_GET(const std::string& key, std::vector<char>& result) {
   return true;
 }
 
+bool HTTPStore::HTTP_GET_BATCH(const std::vector<std::string>& keys,
+                               int wait_ms) {
+  std::string url = url_prefix_ + "?keys=";
+  for (size_t i = 0; i < keys.size(); ++i) {
+    url += (i > 0 ? "," : "") + keys[i];
+  }
+  url += "&wait=" + std::to_string(wait_ms);
+  LOG(TRACE) << "Send batched GET request to " << url;
+  http::Request request(url);
+
+  http::Response response = PerformHTTP(request, HTTP_GET_METHOD);
+
+  // Servers without batched GETs look up the query as a key.
+  if (response.status == HTTP_NOT_FOUND) {
+    LOG(DEBUG) << "Rendezvous server does not support batched GETs, "
+                  "polling for keys instead.";
+    return false;
+  }
+
+  // Entries are "<key length>:<value length>:<key><value>".
+  auto& body = response.body;
+  size_t pos = 0;
+  while (pos < body.size()) {
+    size_t lengths[2];
+    for (auto& length : lengths) {
+      auto end = std::find(body.begin() + pos, body.end(), ':');
+      if (end == body.end()) {
+        throw std::runtime_error("Malformed batched GET response from " + url);
+      }
+      length = std::stoul(std::string(body.begin() + pos, end));
+      pos = end - body.begin() + 1;
+    }
+    if (pos + lengths[0] + lengths[1] > body.size()) {
+      throw std::runtime_error("Truncated batched GET response from " + url);
+    }
+    std::string key(body.begin() + pos, body.begin() + pos + lengths[0]);
+    pos += lengths[0];
+    fetched_[key] = std::vector<char>(body.begin() + pos,
+                                      body.begin() + pos + lengths[1]);
+    pos += lengths[1];
+  }
+  return true;
+}
+
 void HTTPStore::HTTP_PUT(const std::string& key,
                          const std::vector<char>& data) {
   std::string url = url_prefix_ + key;
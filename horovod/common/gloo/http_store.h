@@ -16,6 +16,8 @@
 #ifndef HOROVOD_GLOO_HTTP_STORE_H
 #define HOROVOD_GLOO_HTTP_STORE_H
 
+#include <unordered_map>
+
 #include "HTTPRequest.hpp"
 
 #include "gloo_store.h"
@@ -30,6 +32,8 @@ namespace common {
 #define HTTP_DELETE_METHOD "DELETE"
 #define HTTP_OK 200
 #define HTTP_NOT_FOUND 404
+// How long a single batched GET may wait on the server for missing keys.
+#define BATCH_GET_WAIT_MILLSEC 1000
 
 class HTTPStore : public GlooStore {
 public:
@@ -65,6 +69,11 @@ protected:
   // Return a bool representing whether the key is found in the store.
   bool HTTP_GET(const std::string& key, std::vector<char>& result);
 
+  // Batched long-polling GET of all keys, which the server answers once all
+  // keys are set or wait_ms passed. Found values are kept in fetched_.
+  // Returns false if the server does not support batched GETs.
+  bool HTTP_GET_BATCH(const std::vector<std::string>& keys, int wait_ms);
+
   // HTTP PUT: send HTTP PUT request to server with the key and value data.
   // The key is a string and will be embed into the url; the data is
   // the PUT body.
@@ -76,6 +85,11 @@ protected:
 
   std::string url_prefix_;
   int rank_;
+
+  // Values received by batched GETs, served by get() without another
+  // request. Rendezvous keys are written once per scope.
+  std::unordered_map<std::string, std::vector<char>> fetched_;
+  bool batch_get_supported_ = true;
 };
 
 } // namespace common
@@ -0,0 +1,98 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_GRADIENT_ARENA_H
+#define HOROVOD_GRADIENT_ARENA_H
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace horovod {
+namespace common {
+
+// A contiguous block of memory registered by a framework, which places the
+// gradients of a bucket in it at offsets that are multiples of alignment.
+// Bytes between two such gradients are padding, so a fused allreduce of
+// gradients from the same arena may reduce the whole span in place.
+struct GradientArena {
+  const uint8_t* data = nullptr;
+  int64_t size = 0;
+  int64_t alignment = 1;
+};
+
+// Registered arenas, written by framework threads and read by the background
+// thread.
+class GradientArenaTable {
+public:
+  // Returns false if the range overlaps an arena that is already registered.
+  bool Register(const void* data, int64_t size, int64_t alignment) {
+    auto begin = static_cast<const uint8_t*>(data);
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (auto& arena : arenas_) {
+      if (begin < arena.data + arena.size && arena.data < begin + size) {
+        return false;
+      }
+    }
+    GradientArena arena;
+    arena.data = begin;
+    arena.size = size;
+    arena.alignment = std::max(alignment, (int64_t)1);
+    arenas_.push_back(arena);
+    return true;
+  }
+
+  // Returns false if no arena starts at data.
+  bool Unregister(const void* data) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = std::find_if(arenas_.begin(), arenas_.end(),
+                           [data](const GradientArena& arena) {
+                             return arena.data == data;
+                           });
+    if (it == arenas_.end()) {
+      return false;
+    }
+    arenas_.erase(it);
+    return true;
+  }
+
+  // Looks up the arena that fully contains [data, data + size).
+  bool Find(const void* data, int64_t size, GradientArena& result) {
+    auto begin = static_cast<const uint8_t*>(data);
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (auto& arena : arenas_) {
+      if (arena.data <= begin && begin + size <= arena.data + arena.size) {
+        result = arena;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool Empty() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return arenas_.empty();
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<GradientArena> arenas_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_GRADIENT_ARENA_H
@@ -14,66 +14,326 @@
 // =============================================================================
 
 #include "half.h"
+#include "thread_pool.h"
+
+#include <algorithm>
 
 #if __AVX__ && __F16C__
 #include <cpuid.h>
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+// AVX-512 code is compiled for its own functions only and picked at runtime,
+// so the library still runs on CPUs without it.
+#define HOROVOD_AVX512_DISPATCH 1
+#include <immintrin.h>
+#elif __AVX__ && __F16C__
 #include <immintrin.h>
 #endif
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace horovod {
 namespace common {
 
 #if __AVX__ && __F16C__
 // Query CPUID to determine AVX and F16C runtime support.
 bool is_avx_and_f16c() {
-  static bool initialized = false;
-  static bool result = false;
-  if (!initialized) {
+  // Initialized once, as reductions may run on several threads.
+  static const bool result = [] {
     unsigned int eax, ebx, ecx, edx;
     if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
-      result = (ecx & bit_AVX) && (ecx & bit_F16C);
+      return (ecx & bit_AVX) && (ecx & bit_F16C);
     }
-    initialized = true;
-  }
+    return false;
+  }();
   return result;
 }
 #endif
 
-#if HAVE_MPI
-// float16 custom data type summation operation.
-void float16_sum(void* invec, void* inoutvec, int* len,
-                 MPI_Datatype* datatype) {
-  // cast invec and inoutvec to your float16 type
-  auto* in = (unsigned short*)invec;
-  auto* inout = (unsigned short*)inoutvec;
+namespace {
+
+// Values converted to float32 on the stack at a time.
+constexpr int64_t HALF_CHUNK = 256;
+
+#if HOROVOD_AVX512_DISPATCH
+bool is_avx512f() {
+  static const bool result = __builtin_cpu_supports("avx512f");
+  return result;
+}
+
+// Each converts the leading multiple of 16 values and returns how many.
+__attribute__((target("avx512f"))) int64_t
+HalfBits2FloatAvx512(const unsigned short* src, float* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(dest + i, _mm512_cvtph_ps(_mm256_loadu_si256(
+                                   (const __m256i*)(src + i))));
+  }
+  return i;
+}
+
+__attribute__((target("avx512f"))) int64_t
+Float2HalfBitsAvx512(const float* src, unsigned short* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm256_storeu_si256((__m256i*)(dest + i),
+                        _mm512_cvtps_ph(_mm512_loadu_ps(src + i), 0));
+  }
+  return i;
+}
+
+__attribute__((target("avx512f"))) int64_t
+BFloat16Bits2FloatAvx512(const unsigned short* src, float* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i bits = _mm512_cvtepu16_epi32(
+        _mm256_loadu_si256((const __m256i*)(src + i)));
+    _mm512_storeu_ps(dest + i,
+                     _mm512_castsi512_ps(_mm512_slli_epi32(bits, 16)));
+  }
+  return i;
+}
+
+// Rounds toward nearest even and keeps NaNs quiet, as Float2BFloat16Bits.
+__attribute__((target("avx512f"))) int64_t
+Float2BFloat16BitsAvx512(const float* src, unsigned short* dest, int64_t n) {
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i bias = _mm512_set1_epi32(0x7fff);
+  const __m512i quiet = _mm512_set1_epi32(0x0040);
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 f = _mm512_loadu_ps(src + i);
+    __m512i s = _mm512_castps_si512(f);
+    __m512i upper = _mm512_srli_epi32(s, 16);
+    __m512i rounding_bias =
+        _mm512_add_epi32(bias, _mm512_and_si512(upper, one));
+    __m512i rounded =
+        _mm512_srli_epi32(_mm512_add_epi32(s, rounding_bias), 16);
+    __mmask16 nan = _mm512_cmp_ps_mask(f, f, _CMP_UNORD_Q);
+    rounded = _mm512_mask_blend_epi32(nan, rounded,
+                                      _mm512_or_si512(upper, quiet));
+    _mm256_storeu_si256((__m256i*)(dest + i), _mm512_cvtepi32_epi16(rounded));
+  }
+  return i;
+}
+#endif
+
+#if __AVX__ && __F16C__
+// Four values at a time, in the integer and blend instructions that come
+// with AVX.
+inline __m128i Float2BFloat16Bits4(__m128 f) {
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i bias = _mm_set1_epi32(0x7fff);
+  const __m128i quiet = _mm_set1_epi32(0x0040);
+  __m128i s = _mm_castps_si128(f);
+  __m128i upper = _mm_srli_epi32(s, 16);
+  __m128i rounding_bias = _mm_add_epi32(bias, _mm_and_si128(upper, one));
+  __m128i rounded = _mm_srli_epi32(_mm_add_epi32(s, rounding_bias), 16);
+  __m128i nan = _mm_castps_si128(_mm_cmpunord_ps(f, f));
+  return _mm_blendv_epi8(rounded, _mm_or_si128(upper, quiet), nan);
+}
+#endif
+
+} // namespace
+
+void HalfBits2FloatN(const unsigned short* src, float* dest, int64_t n) {
+  int64_t i = 0;
+#if HOROVOD_AVX512_DISPATCH
+  if (is_avx512f()) {
+    i = HalfBits2FloatAvx512(src, dest, n);
+  }
+#endif
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    for (; i + 8 <= n; i += 8) {
+      _mm256_storeu_ps(dest + i,
+                       _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)(src + i))));
+    }
+  }
+#endif
+#if defined(__aarch64__)
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(dest + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+  }
+#endif
+  for (; i < n; ++i) {
+    HalfBits2Float(src + i, dest + i);
+  }
+}
+
+void Float2HalfBitsN(const float* src, unsigned short* dest, int64_t n) {
+  int64_t i = 0;
+#if HOROVOD_AVX512_DISPATCH
+  if (is_avx512f()) {
+    i = Float2HalfBitsAvx512(src, dest, n);
+  }
+#endif
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    for (; i + 8 <= n; i += 8) {
+      _mm_storeu_si128((__m128i*)(dest + i),
+                       _mm256_cvtps_ph(_mm256_loadu_ps(src + i), 0));
+    }
+  }
+#endif
+#if defined(__aarch64__)
+  for (; i + 4 <= n; i += 4) {
+    vst1_u16(dest + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+  }
+#endif
+  for (; i < n; ++i) {
+    Float2HalfBits(src + i, dest + i);
+  }
+}
 
-  int i = 0;
+void BFloat16Bits2FloatN(const unsigned short* src, float* dest, int64_t n) {
+  int64_t i = 0;
+#if HOROVOD_AVX512_DISPATCH
+  if (is_avx512f()) {
+    i = BFloat16Bits2FloatAvx512(src, dest, n);
+  }
+#endif
 #if __AVX__ && __F16C__
   if (is_avx_and_f16c()) {
-    for (; i < (*len / 8) * 8; i += 8) {
-      // convert in & inout to m256
-      __m256 in_m256 = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)(in + i)));
-      __m256 inout_m256 =
-          _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)(inout + i)));
-
-      // add them together to new_inout_m256
-      __m256 new_inout_m256 = _mm256_add_ps(in_m256, inout_m256);
-
-      // convert back and store in inout
-      __m128i new_inout_m128i = _mm256_cvtps_ph(new_inout_m256, 0);
-      _mm_storeu_si128((__m128i*)(inout + i), new_inout_m128i);
+    // Interleaving with zeros puts the bits in the upper half of each float.
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+      __m128i bits = _mm_loadu_si128((const __m128i*)(src + i));
+      _mm_storeu_si128((__m128i*)(dest + i), _mm_unpacklo_epi16(zero, bits));
+      _mm_storeu_si128((__m128i*)(dest + i + 4),
+                       _mm_unpackhi_epi16(zero, bits));
     }
   }
 #endif
-  for (; i < *len; ++i) {
-    float in_float;
-    float inout_float;
-    HalfBits2Float(in + i, &in_float);
-    HalfBits2Float(inout + i, &inout_float);
-    inout_float += in_float;
-    Float2HalfBits(&inout_float, inout + i);
+#if defined(__aarch64__)
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(dest + i, vreinterpretq_f32_u32(
+                            vshll_n_u16(vld1_u16(src + i), 16)));
+  }
+#endif
+  for (; i < n; ++i) {
+    BFloat16Bits2Float(src + i, dest + i);
+  }
+}
+
+void Float2BFloat16BitsN(const float* src, unsigned short* dest, int64_t n) {
+  int64_t i = 0;
+#if HOROVOD_AVX512_DISPATCH
+  if (is_avx512f()) {
+    i = Float2BFloat16BitsAvx512(src, dest, n);
+  }
+#endif
+#if __AVX__ && __F16C__
+  if (is_avx_and_f16c()) {
+    for (; i + 8 <= n; i += 8) {
+      __m128i lo = Float2BFloat16Bits4(_mm_loadu_ps(src + i));
+      __m128i hi = Float2BFloat16Bits4(_mm_loadu_ps(src + i + 4));
+      _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi32(lo, hi));
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    Float2BFloat16Bits(src + i, dest + i);
+  }
+}
+
+void Float16Sum(const unsigned short* a, const unsigned short* b,
+                unsigned short* c, int64_t n) {
+  float fa[HALF_CHUNK];
+  float fb[HALF_CHUNK];
+  for (int64_t i = 0; i < n; i += HALF_CHUNK) {
+    int64_t m = std::min(HALF_CHUNK, n - i);
+    HalfBits2FloatN(a + i, fa, m);
+    HalfBits2FloatN(b + i, fb, m);
+    for (int64_t j = 0; j < m; ++j) {
+      fa[j] += fb[j];
+    }
+    Float2HalfBitsN(fa, c + i, m);
+  }
+}
+
+void BFloat16Sum(const unsigned short* a, const unsigned short* b,
+                 unsigned short* c, int64_t n) {
+  float fa[HALF_CHUNK];
+  float fb[HALF_CHUNK];
+  for (int64_t i = 0; i < n; i += HALF_CHUNK) {
+    int64_t m = std::min(HALF_CHUNK, n - i);
+    BFloat16Bits2FloatN(a + i, fa, m);
+    BFloat16Bits2FloatN(b + i, fb, m);
+    for (int64_t j = 0; j < m; ++j) {
+      fa[j] += fb[j];
+    }
+    Float2BFloat16BitsN(fa, c + i, m);
   }
 }
+
+void ScaleHalfBits(const unsigned short* input, unsigned short* output,
+                   int64_t n, float scale_factor) {
+  float f[HALF_CHUNK];
+  for (int64_t i = 0; i < n; i += HALF_CHUNK) {
+    int64_t m = std::min(HALF_CHUNK, n - i);
+    HalfBits2FloatN(input + i, f, m);
+    for (int64_t j = 0; j < m; ++j) {
+      f[j] *= scale_factor;
+    }
+    Float2HalfBitsN(f, output + i, m);
+  }
+}
+
+#if HAVE_MPI
+namespace {
+
+WorkStealingThreadPool* half_sum_thread_pool = nullptr;
+
+// Only reductions of at least this many elements are split across threads.
+constexpr int64_t HALF_SUM_GRAIN = 1 << 16;
+
+void Float16SumImpl(const unsigned short* in, unsigned short* inout,
+                    int64_t len) {
+  Float16Sum(in, inout, inout, len);
+}
+
+void BFloat16SumImpl(const unsigned short* in, unsigned short* inout,
+                     int64_t len) {
+  BFloat16Sum(in, inout, inout, len);
+}
+
+template <typename F>
+void HalfSum(F impl, const unsigned short* in, unsigned short* inout,
+             int64_t len) {
+  if (half_sum_thread_pool == nullptr) {
+    impl(in, inout, len);
+    return;
+  }
+  half_sum_thread_pool->ParallelFor(
+      len, HALF_SUM_GRAIN, [&](int64_t begin, int64_t end) {
+        impl(in + begin, inout + begin, end - begin);
+      });
+}
+
+} // namespace
+
+void SetHalfSumThreadPool(WorkStealingThreadPool* thread_pool) {
+  half_sum_thread_pool = thread_pool;
+}
+
+// float16 custom data type summation operation.
+void float16_sum(void* invec, void* inoutvec, int* len,
+                 MPI_Datatype* datatype) {
+  // cast invec and inoutvec to your float16 type
+  HalfSum(Float16SumImpl, (const unsigned short*)invec,
+          (unsigned short*)inoutvec, *len);
+}
+
+// bfloat16 custom data type summation operation.
+void bfloat16_sum(void* invec, void* inoutvec, int* len,
+                  MPI_Datatype* datatype) {
+  HalfSum(BFloat16SumImpl, (const unsigned short*)invec,
+          (unsigned short*)inoutvec, *len);
+}
 #endif
 
 } // namespace common
@@ -138,8 +138,55 @@ inline void Float2HalfBits(const float* src, unsigned short* dest) {
   *dest = u;
 }
 
+inline void BFloat16Bits2Float(const unsigned short* src, float* res) {
+  // bfloat16 is the upper half of an IEEE float32
+  unsigned f = static_cast<unsigned>(*src) << 16;
+  *res = *reinterpret_cast<float const*>(&f);
+}
+
+inline void Float2BFloat16Bits(const float* src, unsigned short* dest) {
+  // software implementation rounds toward nearest even
+  unsigned const& s = *reinterpret_cast<unsigned const*>(src);
+  if ((s & 0x7fffffff) > 0x7f800000) {
+    // not a number, keep it quiet rather than rounding it to infinity
+    *dest = uint16_t((s >> 16) | 0x0040);
+    return;
+  }
+  unsigned rounding_bias = 0x7fff + ((s >> 16) & 1);
+  *dest = uint16_t((s + rounding_bias) >> 16);
+}
+
+// Bulk conversions of n values between float16 bits and float32, with the
+// widest of AVX-512, F16C and NEON conversions the CPU supports.
+void HalfBits2FloatN(const unsigned short* src, float* dest, int64_t n);
+void Float2HalfBitsN(const float* src, unsigned short* dest, int64_t n);
+
+// The same for bfloat16, with AVX-512, AVX and NEON integer instructions.
+void BFloat16Bits2FloatN(const unsigned short* src, float* dest, int64_t n);
+void Float2BFloat16BitsN(const float* src, unsigned short* dest, int64_t n);
+
+// c = a + b for n float16 values, added in float32. c may be a or b.
+void Float16Sum(const unsigned short* a, const unsigned short* b,
+                unsigned short* c, int64_t n);
+
+// c = a + b for n bfloat16 values, added in float32. c may be a or b.
+void BFloat16Sum(const unsigned short* a, const unsigned short* b,
+                 unsigned short* c, int64_t n);
+
+// output = scale_factor * input for n float16 values, scaled in float32.
+void ScaleHalfBits(const unsigned short* input, unsigned short* output,
+                   int64_t n, float scale_factor);
+
 #if HAVE_MPI
+class WorkStealingThreadPool;
+
+// Splits large float16_sum and bfloat16_sum reductions across the threads
+// of thread_pool. Pass nullptr to reduce on the calling thread only.
+void SetHalfSumThreadPool(WorkStealingThreadPool* thread_pool);
+
 void float16_sum(void* invec, void* inoutvec, int* len, MPI_Datatype* datatype);
+void bfloat16_sum(void* invec, void* inoutvec, int* len,
+                  MPI_Datatype* datatype);
 #endif
 
 } // namespace common
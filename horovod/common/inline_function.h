@@ -0,0 +1,204 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_INLINE_FUNCTION_H
+#define HOROVOD_INLINE_FUNCTION_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace horovod {
+namespace common {
+
+template <class Signature, size_t Capacity> class InlineFunction;
+
+// Drop-in for std::function that keeps callables of up to Capacity bytes in
+// place, so that wrapping a lambda with a few captures does not allocate.
+// Larger callables are allocated on the heap. Empty std::functions and null
+// function pointers make an empty InlineFunction, like they would make an
+// empty std::function.
+template <class R, class... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+public:
+  InlineFunction() = default;
+
+  InlineFunction(std::nullptr_t) {}
+
+  template <class F, class = typename std::enable_if<!std::is_same<
+                         typename std::decay<F>::type,
+                         InlineFunction>::value>::type>
+  InlineFunction(F&& f) {
+    using Callable = typename std::decay<F>::type;
+    if (!IsNull(f)) {
+      Emplace<Callable>(std::forward<F>(f),
+                        std::integral_constant<bool, Fits<Callable>()>());
+    }
+  }
+
+  InlineFunction(const InlineFunction& other) : ops_(other.ops_) {
+    if (ops_ != nullptr) {
+      ops_->copy(&other.storage_, &storage_);
+    }
+  }
+
+  InlineFunction(InlineFunction&& other) noexcept : ops_(other.ops_) {
+    if (ops_ != nullptr) {
+      ops_->move(&other.storage_, &storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  InlineFunction& operator=(const InlineFunction& other) {
+    if (this != &other) {
+      InlineFunction copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  InlineFunction& operator=(InlineFunction&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      if (other.ops_ != nullptr) {
+        other.ops_->move(&other.storage_, &storage_);
+        ops_ = other.ops_;
+        other.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  ~InlineFunction() { Reset(); }
+
+  R operator()(Args... args) const {
+    if (ops_ == nullptr) {
+      throw std::bad_function_call();
+    }
+    return ops_->call(const_cast<Storage*>(&storage_),
+                      std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  friend bool operator==(const InlineFunction& f, std::nullptr_t) {
+    return !f;
+  }
+  friend bool operator==(std::nullptr_t, const InlineFunction& f) {
+    return !f;
+  }
+  friend bool operator!=(const InlineFunction& f, std::nullptr_t) {
+    return static_cast<bool>(f);
+  }
+  friend bool operator!=(std::nullptr_t, const InlineFunction& f) {
+    return static_cast<bool>(f);
+  }
+
+private:
+  using Storage =
+      typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type;
+
+  struct Ops {
+    R (*call)(Storage* storage, Args&&... args);
+    void (*copy)(const Storage* from, Storage* to);
+    // Leaves from destroyed.
+    void (*move)(Storage* from, Storage* to);
+    void (*destroy)(Storage* storage);
+  };
+
+  template <class Callable> static constexpr bool Fits() {
+    return sizeof(Callable) <= Capacity &&
+           alignof(std::max_align_t) % alignof(Callable) == 0 &&
+           std::is_nothrow_move_constructible<Callable>::value;
+  }
+
+  template <class Callable> struct InlineOps {
+    static Callable* Get(Storage* storage) {
+      return reinterpret_cast<Callable*>(storage);
+    }
+    static R Call(Storage* storage, Args&&... args) {
+      return (*Get(storage))(std::forward<Args>(args)...);
+    }
+    static void Copy(const Storage* from, Storage* to) {
+      new (to) Callable(*reinterpret_cast<const Callable*>(from));
+    }
+    static void Move(Storage* from, Storage* to) {
+      new (to) Callable(std::move(*Get(from)));
+      Get(from)->~Callable();
+    }
+    static void Destroy(Storage* storage) { Get(storage)->~Callable(); }
+    static constexpr Ops ops = {&Call, &Copy, &Move, &Destroy};
+  };
+
+  template <class Callable> struct HeapOps {
+    static Callable*& Get(Storage* storage) {
+      return *reinterpret_cast<Callable**>(storage);
+    }
+    static R Call(Storage* storage, Args&&... args) {
+      return (*Get(storage))(std::forward<Args>(args)...);
+    }
+    static void Copy(const Storage* from, Storage* to) {
+      Get(to) = new Callable(**reinterpret_cast<Callable* const*>(from));
+    }
+    static void Move(Storage* from, Storage* to) { Get(to) = Get(from); }
+    static void Destroy(Storage* storage) { delete Get(storage); }
+    static constexpr Ops ops = {&Call, &Copy, &Move, &Destroy};
+  };
+
+  template <class F> static bool IsNull(const F&) { return false; }
+  template <class S> static bool IsNull(const std::function<S>& f) {
+    return !f;
+  }
+  template <class S> static bool IsNull(S* f) { return f == nullptr; }
+
+  template <class Callable, class F>
+  void Emplace(F&& f, std::true_type /* fits */) {
+    new (&storage_) Callable(std::forward<F>(f));
+    ops_ = &InlineOps<Callable>::ops;
+  }
+
+  template <class Callable, class F>
+  void Emplace(F&& f, std::false_type /* fits */) {
+    *reinterpret_cast<Callable**>(&storage_) = new Callable(std::forward<F>(f));
+    ops_ = &HeapOps<Callable>::ops;
+  }
+
+  void Reset() {
+    if (ops_ != nullptr) {
+      ops_->destroy(&storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  Storage storage_;
+  const Ops* ops_ = nullptr;
+};
+
+template <class R, class... Args, size_t Capacity>
+template <class Callable>
+constexpr typename InlineFunction<R(Args...), Capacity>::Ops
+    InlineFunction<R(Args...), Capacity>::InlineOps<Callable>::ops;
+
+template <class R, class... Args, size_t Capacity>
+template <class Callable>
+constexpr typename InlineFunction<R(Args...), Capacity>::Ops
+    InlineFunction<R(Args...), Capacity>::HeapOps<Callable>::ops;
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_INLINE_FUNCTION_H
@@ -2,18 +2,113 @@
 
 #include <chrono>
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
 #include <iomanip>
+#include <thread>
+
+#include "mpsc_queue.h"
 
 namespace horovod {
 namespace common {
 
+namespace {
+
+bool LogAsyncFromEnv() {
+  const char* env_var_val = getenv("HOROVOD_LOG_ASYNC");
+  return env_var_val != nullptr && std::strtol(env_var_val, nullptr, 10) > 0;
+}
+
+struct LogLine {
+  bool to_stderr;
+  std::string text;
+};
+
+// Writes queued lines on a thread of its own. Leaked on purpose, so that it
+// outlives the static objects that may still log while they are destroyed.
+class AsyncLogSink {
+ public:
+  static AsyncLogSink& Get() {
+    static AsyncLogSink* sink = new AsyncLogSink();
+    return *sink;
+  }
+
+  void Push(std::string&& text, bool to_stderr) {
+    queue_.Push(LogLine{to_stderr, std::move(text)});
+    pushed_.fetch_add(1, std::memory_order_release);
+  }
+
+  void Flush() {
+    auto target = pushed_.load(std::memory_order_acquire);
+    // Bounded, in case the process exits while the writer is stopped.
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (written_.load(std::memory_order_acquire) < target &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+ private:
+  AsyncLogSink() {
+    std::thread(&AsyncLogSink::Run, this).detach();
+    atexit([] { AsyncLogSink::Get().Flush(); });
+  }
+
+  void Run() {
+    LogLine line;
+    while (true) {
+      bool wrote = false;
+      while (queue_.Pop(line)) {
+        (line.to_stderr ? std::cerr : std::cout) << line.text;
+        written_.fetch_add(1, std::memory_order_release);
+        wrote = true;
+      }
+      if (wrote) {
+        std::cout.flush();
+        std::cerr.flush();
+      } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+  }
+
+  MPSCQueue<LogLine> queue_;
+  std::atomic<uint64_t> pushed_{0};
+  std::atomic<uint64_t> written_{0};
+};
+
+bool LogAsync() {
+  static const bool log_async = LogAsyncFromEnv();
+  return log_async;
+}
+
+} // namespace
+
+void WriteLogLine(std::string&& line, bool to_stderr) {
+  if (LogAsync()) {
+    AsyncLogSink::Get().Push(std::move(line), to_stderr);
+    return;
+  }
+  auto& os = to_stderr ? std::cerr : std::cout;
+  os << line;
+  os.flush();
+}
+
+void FlushLog() {
+  if (LogAsync()) {
+    AsyncLogSink::Get().Flush();
+  }
+}
+
 LogMessage::LogMessage(const char* fname, int line, LogLevel severity)
     : fname_(fname), line_(line), severity_(severity) {}
 
 void LogMessage::GenerateLogMessage(bool log_time) {
   bool use_cout = static_cast<int>(severity_) <= static_cast<int>(LogLevel::INFO);
-  std::ostream& os = use_cout ? std::cout : std::cerr;
+  // Formatted in full first, so that concurrent messages do not interleave.
+  std::ostringstream os;
   if (log_time) {
     auto now = std::chrono::system_clock::now();
     auto as_time_t = std::chrono::system_clock::to_time_t(now);
@@ -28,17 +123,24 @@ void LogMessage::GenerateLogMessage(bool log_time) {
              localtime(&as_time_t));
     os << "[" << time_buffer << "." << std::setw(6) << micros_remainder.count() 
               << ": " << LOG_LEVELS[static_cast<int>(severity_)] << " " 
-              << fname_ << ":" << line_ << "] " << str() << std::endl;
+              << fname_ << ":" << line_ << "] " << str() << "\n";
   } else {
     os << "[" << LOG_LEVELS[static_cast<int>(severity_)] << " " 
-              << fname_ << ":" << line_ << "] " << str() << std::endl;
+              << fname_ << ":" << line_ << "] " << str() << "\n";
+  }
+  if (severity_ == LogLevel::FATAL) {
+    // Written before the process aborts, after what is still queued.
+    FlushLog();
+    std::cerr << os.str();
+    std::cerr.flush();
+    return;
   }
+  WriteLogLine(os.str(), !use_cout);
 }
 
 LogMessage::~LogMessage() {
-  static LogLevel min_log_level = MinLogLevelFromEnv();
   static bool log_time = LogTimeFromEnv();
-  if (severity_ >= min_log_level) {
+  if (severity_ >= MinLogLevel()) {
     GenerateLogMessage(log_time);
   }
 }
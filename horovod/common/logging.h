@@ -13,6 +13,29 @@ enum class LogLevel {
 
 #define LOG_LEVELS "TDIWEF"
 
+// Statements below this level are compiled out, set at build time with
+// HOROVOD_MIN_LOG_LEVEL. Defaults to TRACE, which keeps all of them.
+#ifndef HOROVOD_MIN_LOG_LEVEL
+#define HOROVOD_MIN_LOG_LEVEL 0
+#endif
+
+LogLevel MinLogLevelFromEnv();
+bool LogTimeFromEnv();
+
+// HOROVOD_LOG_LEVEL, read once.
+inline LogLevel MinLogLevel() {
+  static const LogLevel min_log_level = MinLogLevelFromEnv();
+  return min_log_level;
+}
+
+// Writes a formatted line to stdout, or stderr if to_stderr is set. With
+// HOROVOD_LOG_ASYNC=1 the line is queued for a thread that writes it, so that
+// callers never wait on the terminal or on each other.
+void WriteLogLine(std::string&& line, bool to_stderr);
+
+// Waits until the lines queued so far have been written.
+void FlushLog();
+
 class LogMessage : public std::basic_ostringstream<char> {
  public:
   LogMessage(const char* fname, int line, LogLevel severity);
@@ -35,6 +58,20 @@ class LogMessageFatal : public LogMessage {
   ~LogMessageFatal();
 };
 
+// Makes the stream a void expression for the other branch of the conditional
+// in _HVD_LOG_IF. & binds more weakly than << and more strongly than ?:.
+class LogMessageVoidify {
+ public:
+  void operator&(const std::ostream&) {}
+};
+
+// The arguments of a disabled statement are not evaluated.
+#define _HVD_LOG_IF(severity)                                                  \
+  !(static_cast<int>(LogLevel::severity) >= HOROVOD_MIN_LOG_LEVEL &&           \
+    LogLevel::severity >= MinLogLevel())                                       \
+      ? (void)0                                                                \
+      : LogMessageVoidify() &
+
 #define _HVD_LOG_TRACE \
   LogMessage(__FILE__, __LINE__, LogLevel::TRACE)
 #define _HVD_LOG_DEBUG \
@@ -48,16 +85,14 @@ class LogMessageFatal : public LogMessage {
 #define _HVD_LOG_FATAL \
   LogMessageFatal(__FILE__, __LINE__)
 
-#define _LOG(severity) _HVD_LOG_##severity
+#define _LOG(severity) _HVD_LOG_IF(severity) _HVD_LOG_##severity
 
-#define _LOG_RANK(severity, rank) _HVD_LOG_##severity << "[" << rank << "]: "
+#define _LOG_RANK(severity, rank)                                              \
+  _HVD_LOG_IF(severity) _HVD_LOG_##severity << "[" << rank << "]: "
 
 #define GET_LOG(_1, _2, NAME, ...) NAME
 #define LOG(...) GET_LOG(__VA_ARGS__, _LOG_RANK, _LOG)(__VA_ARGS__)
 
-LogLevel MinLogLevelFromEnv();
-bool LogTimeFromEnv();
-
 }
 }
 
@@ -57,6 +57,9 @@ const std::string& DataType_Name(DataType value) {
     case HOROVOD_BOOL:
       static const std::string bool_("bool");
       return bool_;
+    case HOROVOD_BFLOAT16:
+      static const std::string bfloat16("bfloat16");
+      return bfloat16;
     default:
       static const std::string unknown("<unknown>");
       return unknown;
@@ -85,12 +88,40 @@ std::size_t DataType_Size(DataType value) {
       return sizeof(double);
     case HOROVOD_BOOL:
       return sizeof(bool);
+    case HOROVOD_BFLOAT16:
+      return 2;
     default:
       throw std::logic_error("Type " + DataType_Name(value) +
                              " is not supported.");
   }
 }
 
+const std::string& ReduceOp_Name(ReduceOp value) {
+  switch (value) {
+    case ReduceOp::AVERAGE:
+      static const std::string average("AVERAGE");
+      return average;
+    case ReduceOp::SUM:
+      static const std::string sum("SUM");
+      return sum;
+    case ReduceOp::ADASUM:
+      static const std::string adasum("ADASUM");
+      return adasum;
+    case ReduceOp::MIN:
+      static const std::string min("MIN");
+      return min;
+    case ReduceOp::MAX:
+      static const std::string max("MAX");
+      return max;
+    case ReduceOp::PRODUCT:
+      static const std::string product("PRODUCT");
+      return product;
+    default:
+      static const std::string unknown("<unknown>");
+      return unknown;
+  }
+}
+
 const std::string& Request::RequestType_Name(RequestType value) {
   switch (value) {
     case RequestType::ALLREDUCE:
@@ -111,6 +142,15 @@ const std::string& Request::RequestType_Name(RequestType value) {
     case RequestType::ALLTOALL:
       static const std::string alltoall("ALLTOALL");
       return alltoall;
+    case RequestType::REDUCESCATTER:
+      static const std::string reducescatter("REDUCESCATTER");
+      return reducescatter;
+    case RequestType::REDUCE:
+      static const std::string reduce("REDUCE");
+      return reduce;
+    case RequestType::GATHER:
+      static const std::string gather("GATHER");
+      return gather;
     default:
       static const std::string unknown("<unknown>");
       return unknown;
@@ -137,6 +177,10 @@ void Request::set_tensor_name(const std::string& value) {
   tensor_name_ = value;
 }
 
+void Request::set_tensor_name(std::string&& value) {
+  tensor_name_ = std::move(value);
+}
+
 int32_t Request::root_rank() const { return root_rank_; }
 
 void Request::set_root_rank(int32_t value) { root_rank_ = value; }
@@ -153,10 +197,30 @@ void Request::set_prescale_factor(const double prescale_factor) { prescale_facto
 
 void Request::set_postscale_factor(const double postscale_factor) { postscale_factor_ = postscale_factor; };
 
+ReduceOp Request::reduce_op() const { return reduce_op_; }
+
+void Request::set_reduce_op(ReduceOp value) { reduce_op_ = value; }
+
+int32_t Request::priority() const { return priority_; }
+
+void Request::set_priority(int32_t value) { priority_ = value; }
+
 int32_t Request::group_id() const { return group_id_; }
 
 void Request::set_group_id(int32_t value) { group_id_ = value; }
 
+int32_t Request::tensor_id() const { return tensor_id_; }
+
+void Request::set_tensor_id(int32_t value) { tensor_id_ = value; }
+
+int32_t Request::name_id() const { return name_id_; }
+
+void Request::set_name_id(int32_t value) { name_id_ = value; }
+
+bool Request::shape_unchanged() const { return shape_unchanged_; }
+
+void Request::set_shape_unchanged(bool value) { shape_unchanged_ = value; }
+
 const std::vector<int64_t>& Request::tensor_shape() const {
   return tensor_shape_;
 }
@@ -165,32 +229,60 @@ void Request::set_tensor_shape(const std::vector<int64_t>& value) {
   tensor_shape_ = value;
 }
 
+void Request::set_tensor_shape(std::vector<int64_t>&& value) {
+  tensor_shape_ = std::move(value);
+}
+
 void Request::add_tensor_shape(int64_t value) {
   tensor_shape_.push_back(value);
 }
 
 namespace {
 
+// Returns a builder of the calling thread that is cleared but keeps the memory
+// it allocated for previous messages, so that serializing the request and
+// response lists of every cycle does not allocate once the buffer has grown.
+flatbuffers::FlatBufferBuilder& ReusableBuilder() {
+  thread_local flatbuffers::FlatBufferBuilder builder(1024);
+  builder.Clear();
+  return builder;
+}
+
 void Request_ParseFromWire(Request& request,
                            const wire::Request* obj) {
   request.set_request_rank(obj->request_rank());
   request.set_request_type((Request::RequestType) obj->request_type());
   request.set_tensor_type((DataType) obj->tensor_type());
-  request.set_tensor_name(obj->tensor_name()->str());
+  // Compressed requests may leave out the name and the shape.
+  if (obj->tensor_name() != nullptr) {
+    request.set_tensor_name(obj->tensor_name()->str());
+  }
   request.set_root_rank(obj->root_rank());
   request.set_device(obj->device());
-  request.set_tensor_shape(std::vector<int64_t>(obj->tensor_shape()->begin(),
-                                                obj->tensor_shape()->end()));
+  if (obj->tensor_shape() != nullptr) {
+    request.set_tensor_shape(std::vector<int64_t>(
+        obj->tensor_shape()->begin(), obj->tensor_shape()->end()));
+  }
   request.set_prescale_factor(obj->prescale_factor());
   request.set_postscale_factor(obj->postscale_factor());
+  request.set_reduce_op((ReduceOp) obj->reduce_op());
+  request.set_priority(obj->priority());
+  request.set_name_id(obj->name_id());
+  request.set_shape_unchanged(obj->shape_unchanged());
 }
 
 void Request_SerializeToWire(const Request& request,
                              flatbuffers::FlatBufferBuilder& builder,
                              flatbuffers::Offset<wire::Request>& obj) {
   // FlatBuffers must be built bottom-up.
-  auto tensor_name_wire = builder.CreateString(request.tensor_name());
-  auto tensor_shape_wire = builder.CreateVector(request.tensor_shape());
+  flatbuffers::Offset<flatbuffers::String> tensor_name_wire;
+  if (!request.tensor_name().empty() || request.name_id() == NULL_NAME_ID) {
+    tensor_name_wire = builder.CreateString(request.tensor_name());
+  }
+  flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_shape_wire;
+  if (!request.shape_unchanged()) {
+    tensor_shape_wire = builder.CreateVector(request.tensor_shape());
+  }
 
   wire::RequestBuilder request_builder(builder);
   request_builder.add_request_rank(request.request_rank());
@@ -203,6 +295,10 @@ void Request_SerializeToWire(const Request& request,
   request_builder.add_tensor_shape(tensor_shape_wire);
   request_builder.add_prescale_factor(request.prescale_factor());
   request_builder.add_postscale_factor(request.postscale_factor());
+  request_builder.add_reduce_op((int32_t) request.reduce_op());
+  request_builder.add_priority(request.priority());
+  request_builder.add_name_id(request.name_id());
+  request_builder.add_shape_unchanged(request.shape_unchanged());
   obj = request_builder.Finish();
 }
 
@@ -215,20 +311,22 @@ void Request::ParseFromBytes(Request& request, const uint8_t* input) {
 
 void Request::SerializeToString(const Request& request,
                                 std::string& output) {
-  flatbuffers::FlatBufferBuilder builder(1024);
+  auto& builder = ReusableBuilder();
   flatbuffers::Offset<wire::Request> obj;
   Request_SerializeToWire(request, builder, obj);
   builder.Finish(obj);
 
   uint8_t* buf = builder.GetBufferPointer();
   auto size = builder.GetSize();
-  output = std::string((char*) buf, size);
+  output.assign((char*) buf, size);
 }
 
 const std::vector<Request>& RequestList::requests() const {
   return requests_;
 }
 
+std::vector<Request>& RequestList::mutable_requests() { return requests_; }
+
 void RequestList::set_requests(const std::vector<Request>& value) {
   requests_ = value;
 }
@@ -242,16 +340,17 @@ void RequestList::add_request(const Request& value) {
 }
 
 void RequestList::emplace_request(Request&& value) {
-  requests_.emplace_back(value);
+  requests_.emplace_back(std::move(value));
 }
 
 void RequestList::ParseFromBytes(RequestList& request_list,
                                  const uint8_t* input) {
   auto obj = flatbuffers::GetRoot<wire::RequestList>(input);
+  auto& requests = request_list.mutable_requests();
+  requests.reserve(requests.size() + obj->requests()->size());
   for (const auto& req_obj : *obj->requests()) {
-    Request request;
-    Request_ParseFromWire(request, req_obj);
-    request_list.emplace_request(std::move(request));
+    requests.emplace_back();
+    Request_ParseFromWire(requests.back(), req_obj);
   }
   request_list.set_shutdown(obj->shutdown());
 }
@@ -259,7 +358,7 @@ void RequestList::ParseFromBytes(RequestList& request_list,
 void RequestList::SerializeToString(const RequestList& request_list,
                                     std::string& output) {
   // FlatBuffers must be built bottom-up.
-  flatbuffers::FlatBufferBuilder builder(1024);
+  auto& builder = ReusableBuilder();
   std::vector<flatbuffers::Offset<wire::Request>> requests;
   requests.reserve(request_list.requests().size());
   for (const auto& req : request_list.requests()) {
@@ -277,7 +376,7 @@ void RequestList::SerializeToString(const RequestList& request_list,
 
   uint8_t* buf = builder.GetBufferPointer();
   auto size = builder.GetSize();
-  output = std::string((char*) buf, size);
+  output.assign((char*) buf, size);
 }
 
 const std::string& Response::ResponseType_Name(ResponseType value) {
@@ -300,6 +399,15 @@ const std::string& Response::ResponseType_Name(ResponseType value) {
     case ResponseType::ALLTOALL:
       static const std::string alltoall("ALLTOALL");
       return alltoall;
+    case ResponseType::REDUCESCATTER:
+      static const std::string reducescatter("REDUCESCATTER");
+      return reducescatter;
+    case ResponseType::REDUCE:
+      static const std::string reduce("REDUCE");
+      return reduce;
+    case ResponseType::GATHER:
+      static const std::string gather("GATHER");
+      return gather;
     case ResponseType::ERROR:
       static const std::string error("ERROR");
       return error;
@@ -343,6 +451,10 @@ void Response::set_tensor_names(const std::vector<std::string>& value) {
   tensor_names_ = value;
 }
 
+void Response::reserve_tensor_names(size_t count) {
+  tensor_names_.reserve(tensor_names_.size() + count);
+}
+
 void Response::add_tensor_name(const std::string& value) {
   tensor_names_.push_back(value);
 }
@@ -357,12 +469,20 @@ void Response::set_error_message(const std::string& value) {
   error_message_ = value;
 }
 
+void Response::set_error_message(std::string&& value) {
+  error_message_ = std::move(value);
+}
+
 const std::vector<int32_t>& Response::devices() const { return devices_; }
 
 void Response::set_devices(const std::vector<int32_t>& value) {
   devices_ = value;
 }
 
+void Response::set_devices(std::vector<int32_t>&& value) {
+  devices_ = std::move(value);
+}
+
 void Response::add_device(int32_t value) { devices_.push_back(value); }
 
 const std::vector<int64_t>& Response::tensor_sizes() const {
@@ -373,6 +493,10 @@ void Response::set_tensor_sizes(const std::vector<int64_t>& value) {
   tensor_sizes_ = value;
 }
 
+void Response::set_tensor_sizes(std::vector<int64_t>&& value) {
+  tensor_sizes_ = std::move(value);
+}
+
 void Response::add_tensor_size(int64_t value) {
   tensor_sizes_.push_back(value);
 }
@@ -395,9 +519,32 @@ void Response::set_prescale_factor(const double prescale_factor) { prescale_fact
 
 void Response::set_postscale_factor(const double postscale_factor) { postscale_factor_ = postscale_factor; };
 
+ReduceOp Response::reduce_op() const { return reduce_op_; }
+
+void Response::set_reduce_op(ReduceOp value) { reduce_op_ = value; }
+
+int32_t Response::priority() const { return priority_; }
+
+void Response::set_priority(int32_t value) { priority_ = value; }
+
+int64_t Response::partition_offset() const { return partition_offset_; }
+
+void Response::set_partition_offset(int64_t value) {
+  partition_offset_ = value;
+}
+
+int32_t Response::num_partitions() const { return num_partitions_; }
+
+void Response::set_num_partitions(int32_t value) { num_partitions_ = value; }
+
+int32_t Response::root_rank() const { return root_rank_; }
+
+void Response::set_root_rank(int32_t value) { root_rank_ = value; }
+
 void Response_ParseFromWire(Response& response,
                             const wire::Response* obj) {
   response.set_response_type((Response::ResponseType) obj->response_type());
+  response.reserve_tensor_names(obj->tensor_names()->size());
   for (const auto& tensor_name_obj : *obj->tensor_names()) {
     response.add_tensor_name(tensor_name_obj->str());
   }
@@ -409,6 +556,11 @@ void Response_ParseFromWire(Response& response,
                                                  obj->tensor_sizes()->end()));
   response.set_prescale_factor(obj->prescale_factor());
   response.set_postscale_factor(obj->postscale_factor());
+  response.set_reduce_op((ReduceOp) obj->reduce_op());
+  response.set_priority(obj->priority());
+  response.set_partition_offset(obj->partition_offset());
+  response.set_num_partitions(obj->num_partitions());
+  response.set_root_rank(obj->root_rank());
 }
 
 void Response::ParseFromBytes(Response& response, const uint8_t* input) {
@@ -437,19 +589,24 @@ void Response_SerializeToWire(const Response& response,
   response_builder.add_tensor_sizes(tensor_sizes_wire);
   response_builder.add_prescale_factor(response.prescale_factor());
   response_builder.add_postscale_factor(response.postscale_factor());
+  response_builder.add_reduce_op((int32_t) response.reduce_op());
+  response_builder.add_priority(response.priority());
+  response_builder.add_partition_offset(response.partition_offset());
+  response_builder.add_num_partitions(response.num_partitions());
+  response_builder.add_root_rank(response.root_rank());
   obj = response_builder.Finish();
 }
 
 void Response::SerializeToString(const Response& response,
                                  std::string& output) {
-  flatbuffers::FlatBufferBuilder builder(1024);
+  auto& builder = ReusableBuilder();
   flatbuffers::Offset<wire::Response> obj;
   Response_SerializeToWire(response, builder, obj);
   builder.Finish(obj);
 
   uint8_t* buf = builder.GetBufferPointer();
   auto size = builder.GetSize();
-  output = std::string((char*) buf, size);
+  output.assign((char*) buf, size);
 }
 
 const std::vector<Response>& ResponseList::responses() const {
@@ -473,7 +630,7 @@ void ResponseList::add_response(Response&& value) {
 }
 
 void ResponseList::emplace_response(Response&& value) {
-  responses_.emplace_back(value);
+  responses_.emplace_back(std::move(value));
 }
 
 void ResponseList::ParseFromBytes(ResponseList& response_list,
@@ -490,7 +647,7 @@ void ResponseList::ParseFromBytes(ResponseList& response_list,
 void ResponseList::SerializeToString(const ResponseList& response_list,
                                      std::string& output) {
   // FlatBuffers must be built bottom-up.
-  flatbuffers::FlatBufferBuilder builder(1024);
+  auto& builder = ReusableBuilder();
   std::vector<flatbuffers::Offset<wire::Response>> responses;
   responses.reserve(response_list.responses().size());
   for (const auto& resp : response_list.responses()) {
@@ -508,7 +665,7 @@ void ResponseList::SerializeToString(const ResponseList& response_list,
 
   uint8_t* buf = builder.GetBufferPointer();
   auto size = builder.GetSize();
-  output = std::string((char*) buf, size);
+  output.assign((char*) buf, size);
 }
 
 } // namespace common
@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "group_table.h"
+#include "tensor_name_table.h"
 
 namespace horovod {
 namespace common {
@@ -38,19 +39,35 @@ enum DataType {
   HOROVOD_FLOAT32 = 7,
   HOROVOD_FLOAT64 = 8,
   HOROVOD_BOOL = 9,
+  HOROVOD_BFLOAT16 = 10,
 };
 
 const std::string& DataType_Name(DataType value);
 
 std::size_t DataType_Size(DataType value);
 
+enum ReduceOp {
+    AVERAGE = 0, // This value should never appear past framework code, as
+                 // averaging is taken care of there.
+    SUM = 1,
+    ADASUM = 2,
+    MIN = 3,
+    MAX = 4,
+    PRODUCT = 5
+};
+
+const std::string& ReduceOp_Name(ReduceOp value);
+
+#define NULL_NAME_ID -1
+
 // A Request is a message sent from a rank greater than zero to the
 // coordinator (rank zero), informing the coordinator of an operation that
 // the rank wants to do and the tensor that it wants to apply the operation to.
 class Request {
 public:
   enum RequestType {
-    ALLREDUCE = 0, ALLGATHER = 1, BROADCAST = 2, JOIN = 3, ADASUM = 4, ALLTOALL = 5
+    ALLREDUCE = 0, ALLGATHER = 1, BROADCAST = 2, JOIN = 3, ADASUM = 4, ALLTOALL = 5,
+    REDUCESCATTER = 6, REDUCE = 7, GATHER = 8
   };
 
 
@@ -75,6 +92,8 @@ public:
 
   void set_tensor_name(const std::string& value);
 
+  void set_tensor_name(std::string&& value);
+
   // The root rank is counted relative to the process set.
   int32_t root_rank() const;
 
@@ -86,10 +105,16 @@ public:
 
   int32_t group_id() const;
   void set_group_id(int32_t value);
+
+  int32_t tensor_id() const;
+  void set_tensor_id(int32_t value);
+
   const std::vector<int64_t>& tensor_shape() const;
 
   void set_tensor_shape(const std::vector<int64_t>& value);
 
+  void set_tensor_shape(std::vector<int64_t>&& value);
+
   void add_tensor_shape(int64_t value);
 
   double prescale_factor() const;
@@ -100,6 +125,27 @@ public:
 
   void set_postscale_factor(double postscale_factor);
 
+  ReduceOp reduce_op() const;
+
+  void set_reduce_op(ReduceOp value);
+
+  int32_t priority() const;
+
+  void set_priority(int32_t value);
+
+  // ID that a worker and the coordinator agreed on for the tensor name, see
+  // RequestCompressor. The name is left out of requests that carry an ID the
+  // coordinator already knows.
+  int32_t name_id() const;
+
+  void set_name_id(int32_t value);
+
+  // Set when the tensor shape was left out because it did not change since
+  // the last request for the same tensor.
+  bool shape_unchanged() const;
+
+  void set_shape_unchanged(bool value);
+
   static void ParseFromBytes(Request& request, const uint8_t* input);
 
   static void SerializeToString(const Request& request, std::string& output);
@@ -114,16 +160,27 @@ private:
   // group_id is not included in flatbuffer as it does not
   // need to be shared between workers
   int32_t group_id_ = NULL_GROUP_ID;
+  // tensor_id is not included in flatbuffer either, it is only meaningful
+  // within the TensorNameTable of this process
+  int32_t tensor_id_ = NULL_TENSOR_ID;
   std::string tensor_name_;
   std::vector<int64_t> tensor_shape_;
   double prescale_factor_ = 1.0;
   double postscale_factor_ = 1.0;
+  ReduceOp reduce_op_ = ReduceOp::SUM;
+  // Requests with a higher priority are scheduled first.
+  int32_t priority_ = 0;
+  int32_t name_id_ = NULL_NAME_ID;
+  bool shape_unchanged_ = false;
 };
 
 class RequestList {
 public:
   const std::vector<Request>& requests() const;
 
+  // Lets the coordinator move received requests into its message table.
+  std::vector<Request>& mutable_requests();
+
   void set_requests(const std::vector<Request>& value);
 
   void add_request(const Request& value);
@@ -153,7 +210,8 @@ private:
 class Response {
 public:
   enum ResponseType {
-    ALLREDUCE = 0, ALLGATHER = 1, BROADCAST = 2, JOIN = 3, ADASUM = 4, ALLTOALL= 5, ERROR = 6
+    ALLREDUCE = 0, ALLGATHER = 1, BROADCAST = 2, JOIN = 3, ADASUM = 4, ALLTOALL= 5,
+    REDUCESCATTER = 6, REDUCE = 7, GATHER = 8, ERROR = 9
   };
 
   static const std::string& ResponseType_Name(ResponseType value);
@@ -173,6 +231,8 @@ public:
 
   void set_tensor_names(const std::vector<std::string>& value);
 
+  void reserve_tensor_names(size_t count);
+
   void add_tensor_name(const std::string& value);
 
   void add_tensor_name(std::string&& value);
@@ -182,19 +242,25 @@ public:
 
   void set_error_message(const std::string& value);
 
+  void set_error_message(std::string&& value);
+
   const std::vector<int32_t>& devices() const;
 
   void set_devices(const std::vector<int32_t>& value);
 
+  void set_devices(std::vector<int32_t>&& value);
+
   void add_device(int32_t value);
 
-  // Empty unless response_type is ALLGATHER.
-  // These tensor sizes are the dimension zero sizes of all the input matrices,
-  // indexed by the rank.
+  // For ALLGATHER and GATHER, the dimension zero sizes of all the input
+  // matrices, indexed by the rank. For reductions, the number of elements of
+  // every tensor.
   const std::vector<int64_t>& tensor_sizes() const;
 
   void set_tensor_sizes(const std::vector<int64_t>& value);
 
+  void set_tensor_sizes(std::vector<int64_t>&& value);
+
   void add_tensor_size(int64_t value);
 
   // To fuse multiple allgather responses
@@ -208,6 +274,30 @@ public:
 
   void set_postscale_factor(double postscale_factor);
 
+  ReduceOp reduce_op() const;
+
+  void set_reduce_op(ReduceOp value);
+
+  int32_t priority() const;
+
+  void set_priority(int32_t value);
+
+  // For a response that reduces one part of a large tensor, the element
+  // offset of that part and the number of parts of the tensor.
+  int64_t partition_offset() const;
+
+  void set_partition_offset(int64_t value);
+
+  int32_t num_partitions() const;
+
+  void set_num_partitions(int32_t value);
+
+  // Root rank of a broadcast, reduce or gather, which only fuse with those to
+  // the same root.
+  int32_t root_rank() const;
+
+  void set_root_rank(int32_t value);
+
   static void ParseFromBytes(Response& response, const uint8_t* input);
 
   static void SerializeToString(const Response& response,
@@ -222,6 +312,11 @@ private:
   std::vector<int64_t> tensor_sizes_;
   double prescale_factor_ = 1.0;
   double postscale_factor_ = 1.0;
+  ReduceOp reduce_op_ = ReduceOp::SUM;
+  int32_t priority_ = 0;
+  int64_t partition_offset_ = 0;
+  int32_t num_partitions_ = 1;
+  int32_t root_rank_ = 0;
 };
 
 class ResponseList {
@@ -0,0 +1,92 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "metrics.h"
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+const char* const METRIC_NAMES[] = {
+    "cycles",
+    "negotiation_time_us",
+    "tensors",
+    "queue_time_us",
+    "fusion_copy_time_us",
+    "cache_hits",
+    "cache_misses",
+    "stalled_tensors",
+    // Per operation, in the order of Response::ResponseType.
+    "allreduce_responses",
+    "allreduce_bytes",
+    "allreduce_time_us",
+    "allgather_responses",
+    "allgather_bytes",
+    "allgather_time_us",
+    "broadcast_responses",
+    "broadcast_bytes",
+    "broadcast_time_us",
+    "join_responses",
+    "join_bytes",
+    "join_time_us",
+    "adasum_responses",
+    "adasum_bytes",
+    "adasum_time_us",
+    "alltoall_responses",
+    "alltoall_bytes",
+    "alltoall_time_us",
+    "reducescatter_responses",
+    "reducescatter_bytes",
+    "reducescatter_time_us",
+    "reduce_responses",
+    "reduce_bytes",
+    "reduce_time_us",
+    "gather_responses",
+    "gather_bytes",
+    "gather_time_us",
+};
+
+static_assert(sizeof(METRIC_NAMES) / sizeof(METRIC_NAMES[0]) == NUM_METRICS,
+              "every metric needs a name");
+
+} // namespace
+
+Metrics::Metrics() {
+  for (auto& value : values_) {
+    value.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Metrics::AddOperation(Response::ResponseType type, int64_t bytes,
+                           std::chrono::steady_clock::time_point start) {
+  if (type >= NUM_METRIC_OPS) {
+    return;
+  }
+  int first = METRIC_FIRST_OP + METRICS_PER_OP * type;
+  Add(first, 1);
+  Add(first + 1, bytes);
+  AddTimeSince(first + 2, start);
+}
+
+const char* Metrics::Name(int index) {
+  if (index < 0 || index >= NUM_METRICS) {
+    return "";
+  }
+  return METRIC_NAMES[index];
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,87 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_METRICS_H
+#define HOROVOD_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "message.h"
+
+namespace horovod {
+namespace common {
+
+// Cumulative counters, indices into Metrics. Times are in microseconds. The
+// per operation counters come in groups of METRICS_PER_OP, in the order of
+// ResponseType.
+enum MetricIndex {
+  METRIC_CYCLES = 0,
+  METRIC_NEGOTIATION_TIME_US,
+  METRIC_TENSORS,
+  METRIC_QUEUE_TIME_US,
+  METRIC_FUSION_COPY_TIME_US,
+  METRIC_CACHE_HITS,
+  METRIC_CACHE_MISSES,
+  METRIC_STALLED_TENSORS,
+  METRIC_FIRST_OP
+};
+
+// Responses, bytes and time from the start of the operation until its last
+// tensor completed, per response type.
+constexpr int METRICS_PER_OP = 3;
+constexpr int NUM_METRIC_OPS = Response::ERROR;
+constexpr int NUM_METRICS = METRIC_FIRST_OP + METRICS_PER_OP * NUM_METRIC_OPS;
+
+// Always-on counters of the background thread, cheap enough to be left
+// enabled in production unlike the timeline. Updated from the background
+// thread, process set threads and GPU finalizer threads, and read by any
+// thread through horovod_get_metrics().
+class Metrics {
+public:
+  Metrics();
+  Metrics(const Metrics&) = delete;
+
+  inline void Add(int index, int64_t value) {
+    values_[index].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  // Adds the time since start.
+  inline void AddTimeSince(int index,
+                           std::chrono::steady_clock::time_point start) {
+    Add(index, std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now() - start)
+                   .count());
+  }
+
+  void AddOperation(Response::ResponseType type, int64_t bytes,
+                    std::chrono::steady_clock::time_point start);
+
+  inline int64_t Value(int index) const {
+    return values_[index].load(std::memory_order_relaxed);
+  }
+
+  // Stable name of the counter, e.g. "allreduce_bytes".
+  static const char* Name(int index);
+
+private:
+  std::atomic<int64_t> values_[NUM_METRICS];
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_METRICS_H
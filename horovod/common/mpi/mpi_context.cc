@@ -16,14 +16,21 @@
 
 #include "mpi_context.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <numeric>
+#include <string>
 #include <vector>
 
 #include "../common.h"
 #include "../half.h"
 #include "../logging.h"
+#include "../ops/cpu_kernels.h"
+#include "../topology.h"
+#include "../utils/env_parser.h"
 
 namespace horovod {
 namespace common {
@@ -48,6 +55,8 @@ MPI_Datatype MPIContext::GetMPIDataType(const DataType dtype) const {
     return MPI_INT64_T;
   case HOROVOD_FLOAT16:
     return mpi_float16_t;
+  case HOROVOD_BFLOAT16:
+    return mpi_bfloat16_t;
   case HOROVOD_FLOAT32:
     return MPI_FLOAT;
   case HOROVOD_FLOAT64:
@@ -61,7 +70,42 @@ MPI_Datatype MPIContext::GetMPIDataType(const DataType dtype) const {
 }
 
 MPI_Op MPIContext::GetMPISumOp(DataType dtype) const {
-  return dtype == HOROVOD_FLOAT16 ? mpi_float16_sum : MPI_SUM;
+  switch (dtype) {
+  case HOROVOD_FLOAT16:
+    return mpi_float16_sum;
+  case HOROVOD_BFLOAT16:
+    return mpi_bfloat16_sum;
+  default:
+    return MPI_SUM;
+  }
+}
+
+MPI_Op MPIContext::GetMPICPUSumOp(DataType dtype) const {
+  auto it = mpi_cpu_sum_ops.find(dtype);
+  return it != mpi_cpu_sum_ops.end() ? it->second : GetMPISumOp(dtype);
+}
+
+MPI_Op MPIContext::GetMPIOp(DataType dtype, ReduceOp reduce_op) const {
+  if (reduce_op == ReduceOp::SUM) {
+    return GetMPISumOp(dtype);
+  }
+  if (dtype == HOROVOD_FLOAT16 || dtype == HOROVOD_BFLOAT16) {
+    // Only summation is implemented for the custom 16-bit float types.
+    throw std::logic_error("Reduce op " + ReduceOp_Name(reduce_op) +
+                           " is not supported for type " +
+                           DataType_Name(dtype) + " in MPI mode.");
+  }
+  switch (reduce_op) {
+  case ReduceOp::MIN:
+    return MPI_MIN;
+  case ReduceOp::MAX:
+    return MPI_MAX;
+  case ReduceOp::PRODUCT:
+    return MPI_PROD;
+  default:
+    throw std::logic_error("Reduce op " + ReduceOp_Name(reduce_op) +
+                           " is not supported in MPI mode.");
+  }
 }
 
 MPI_Comm MPIContext::GetMPICommunicator(Communicator comm) const {
@@ -78,6 +122,23 @@ MPI_Comm MPIContext::GetMPICommunicator(Communicator comm) const {
   }
 }
 
+MPI_Comm MPIContext::GetControlCommunicator(Communicator comm) const {
+  if (control_comm == MPI_COMM_NULL) {
+    return GetMPICommunicator(comm);
+  }
+  switch (comm) {
+  case GLOBAL:
+    return control_comm;
+  case LOCAL:
+    return control_local_comm;
+  case CROSS:
+    return control_cross_comm;
+  default:
+    throw std::logic_error("Communicator " + CommunicatorName(comm) +
+                           " is not supported in MPI mode.");
+  }
+}
+
 int MPIContext::GetMPITypeSize(DataType dtype) const {
   int out;
   MPI_Type_size(GetMPIDataType(dtype), &out);
@@ -96,6 +157,33 @@ void CreateMPIFloat16TypeAndSumOp(MPI_Datatype& mpi_float16_t,
   MPI_Op_create(&float16_sum, 1, &mpi_float16_sum);
 }
 
+void CreateMPIBFloat16TypeAndSumOp(MPI_Datatype& mpi_bfloat16_t,
+                                   MPI_Op& mpi_bfloat16_sum) {
+  // Create custom MPI bfloat16 data type.
+  MPI_Type_contiguous(2, MPI_BYTE, &mpi_bfloat16_t);
+  MPI_Type_commit(&mpi_bfloat16_t);
+
+  // Create custom MPI bfloat16 summation op.
+  MPI_Op_create(&bfloat16_sum, 1, &mpi_bfloat16_sum);
+}
+
+template <typename T>
+void CPUSum(void* invec, void* inoutvec, int* len, MPI_Datatype* datatype) {
+  SumCPU(static_cast<const T*>(invec), static_cast<const T*>(inoutvec),
+         static_cast<T*>(inoutvec), *len);
+}
+
+void CreateMPICPUSumOps(std::map<DataType, MPI_Op>& mpi_cpu_sum_ops) {
+  MPI_Op_create(&CPUSum<uint8_t>, 1, &mpi_cpu_sum_ops[HOROVOD_UINT8]);
+  MPI_Op_create(&CPUSum<int8_t>, 1, &mpi_cpu_sum_ops[HOROVOD_INT8]);
+  MPI_Op_create(&CPUSum<uint16_t>, 1, &mpi_cpu_sum_ops[HOROVOD_UINT16]);
+  MPI_Op_create(&CPUSum<int16_t>, 1, &mpi_cpu_sum_ops[HOROVOD_INT16]);
+  MPI_Op_create(&CPUSum<int32_t>, 1, &mpi_cpu_sum_ops[HOROVOD_INT32]);
+  MPI_Op_create(&CPUSum<int64_t>, 1, &mpi_cpu_sum_ops[HOROVOD_INT64]);
+  MPI_Op_create(&CPUSum<float>, 1, &mpi_cpu_sum_ops[HOROVOD_FLOAT32]);
+  MPI_Op_create(&CPUSum<double>, 1, &mpi_cpu_sum_ops[HOROVOD_FLOAT64]);
+}
+
 void CreateMPILocalAndCrossComm(MPI_Comm mpi_comm, MPI_Comm& local_comm,
                                 MPI_Comm& cross_comm) {
   // Create local comm, Determine local rank by querying the local communicator.
@@ -113,6 +201,44 @@ void CreateMPILocalAndCrossComm(MPI_Comm mpi_comm, MPI_Comm& local_comm,
 
 } // namespace
 
+namespace {
+
+// Local rank as told by the launcher, as MPI is not initialized yet. -1 if
+// the launcher is not known.
+int LauncherLocalRank() {
+  for (auto name : {"OMPI_COMM_WORLD_LOCAL_RANK", "MPI_LOCALRANKID",
+                    "MV2_COMM_WORLD_LOCAL_RANK", "SLURM_LOCALID",
+                    "HOROVOD_LOCAL_RANK"}) {
+    auto value = std::getenv(name);
+    if (value != nullptr) {
+      return std::atoi(value);
+    }
+  }
+  return -1;
+}
+
+// Restricts UCX and the Open MPI openib BTL to the rail of this local rank,
+// unless the user already picked devices.
+void SelectRailDevice() {
+  int local_rank = LauncherLocalRank();
+  auto device = local_rank >= 0
+                    ? PickRailDevice(DiscoverHostTopology(), local_rank)
+                    : std::string();
+  if (device.empty()) {
+    LOG(WARNING) << HOROVOD_NIC_RAILS << " is set, but the local rank or the "
+                 << "RDMA devices of this host are unknown.";
+    return;
+  }
+  for (auto name : {"UCX_NET_DEVICES", "OMPI_MCA_btl_openib_if_include"}) {
+    if (std::getenv(name) == nullptr) {
+      SetEnv(name, device.c_str());
+    }
+  }
+  LOG(DEBUG) << "Local rank " << local_rank << " uses RDMA device " << device;
+}
+
+} // namespace
+
 void MPIContext::Initialize(MPIContextManager& ctx_manager) {
 
   if (!enabled_) {
@@ -148,6 +274,9 @@ void MPIContext::Initialize(MPIContextManager& ctx_manager) {
     }
   } else {
     // MPI environment has not been created, using manager to initialize.
+    if (GetBoolEnvOrDefault(HOROVOD_NIC_RAILS, false)) {
+      SelectRailDevice();
+    }
     ctx_manager.EnvInitialize(required);
     should_finalize = true;
   }
@@ -177,6 +306,8 @@ void MPIContext::Initialize(MPIContextManager& ctx_manager) {
   CreateMPILocalAndCrossComm(mpi_comm, local_comm, cross_comm);
 
   CreateMPIFloat16TypeAndSumOp(mpi_float16_t, mpi_float16_sum);
+  CreateMPIBFloat16TypeAndSumOp(mpi_bfloat16_t, mpi_bfloat16_sum);
+  CreateMPICPUSumOps(mpi_cpu_sum_ops);
 }
 
 void MPIContext::InitializeForProcessSet(const MPIContext& global_context,
@@ -184,30 +315,61 @@ void MPIContext::InitializeForProcessSet(const MPIContext& global_context,
   assert(global_context.IsEnabled());
   assert(global_context.global_comm != MPI_COMM_NULL);
 
-  enabled_ = true;
-  should_finalize = false;
-  MPI_Comm_dup(global_context.global_comm, &global_comm);
+  MPI_Comm new_global_comm;
+  MPI_Comm new_mpi_comm;
+  MPI_Comm_dup(global_context.global_comm, &new_global_comm);
   if (ranks.empty()) {
-    MPI_Comm_dup(global_comm, &(mpi_comm));
+    MPI_Comm_dup(new_global_comm, &new_mpi_comm);
   } else {
     // Create mpi_comm for this process set.
     MPI_Group world_group;
-    MPI_Comm_group(global_comm, &world_group);
+    MPI_Comm_group(new_global_comm, &world_group);
     MPI_Group work_group;
     MPI_Group_incl(world_group, ranks.size(), ranks.data(), &work_group);
-    MPI_Comm_create_group(global_comm, work_group, 0, &(mpi_comm));
+    MPI_Comm_create_group(new_global_comm, work_group, 0, &new_mpi_comm);
     MPI_Group_free(&world_group);
     MPI_Group_free(&work_group);
   }
+  InitializeForProcessSet(global_context, ranks, new_global_comm,
+                          new_mpi_comm);
+}
+
+void MPIContext::InitializeForProcessSet(const MPIContext& global_context,
+                                         const std::vector<int>& ranks,
+                                         MPI_Comm global_comm_dup,
+                                         MPI_Comm process_set_comm) {
+  enabled_ = true;
+  should_finalize = false;
+  int provided;
+  MPI_Query_thread(&provided);
+  global_comm = global_comm_dup;
+  mpi_comm = process_set_comm;
   if (mpi_comm == MPI_COMM_NULL) {
     // This process does not belong to the group.
     local_comm = MPI_COMM_NULL;
     cross_comm = MPI_COMM_NULL;
   } else {
     CreateMPILocalAndCrossComm(mpi_comm, local_comm, cross_comm);
+    if (global_context.separate_control_comms) {
+      MPI_Comm_dup(mpi_comm, &control_comm);
+      CreateMPILocalAndCrossComm(control_comm, control_local_comm,
+                                 control_cross_comm);
+    }
+    if (provided == MPI_THREAD_MULTIPLE) {
+      MPI_Comm_dup(mpi_comm, &barrier_comm);
+    }
+  }
+
+  if (ranks.empty()) {
+    if (provided == MPI_THREAD_MULTIPLE) {
+      MPI_Comm_dup(global_comm, &bytes_comm);
+    }
+    MPI_Comm_dup(global_comm, &peer_comm);
   }
 
   CreateMPIFloat16TypeAndSumOp(mpi_float16_t, mpi_float16_sum);
+  CreateMPIBFloat16TypeAndSumOp(mpi_bfloat16_t, mpi_bfloat16_sum);
+  CreateMPICPUSumOps(mpi_cpu_sum_ops);
 }
 
 void MPIContext::Finalize(MPIContextManager& ctx_manager) {
@@ -237,12 +399,40 @@ void MPIContext::FinalizeWithoutEnv() {
   if (cross_comm != MPI_COMM_NULL) {
     MPI_Comm_free(&cross_comm);
   }
+  if (bytes_comm != MPI_COMM_NULL) {
+    MPI_Comm_free(&bytes_comm);
+  }
+  if (peer_comm != MPI_COMM_NULL) {
+    MPI_Comm_free(&peer_comm);
+  }
+  if (barrier_comm != MPI_COMM_NULL) {
+    MPI_Comm_free(&barrier_comm);
+  }
+  if (control_comm != MPI_COMM_NULL) {
+    MPI_Comm_free(&control_comm);
+  }
+  if (control_local_comm != MPI_COMM_NULL) {
+    MPI_Comm_free(&control_local_comm);
+  }
+  if (control_cross_comm != MPI_COMM_NULL) {
+    MPI_Comm_free(&control_cross_comm);
+  }
   if (mpi_float16_t != MPI_DATATYPE_NULL) {
     MPI_Type_free(&mpi_float16_t);
   }
   if (mpi_float16_sum != MPI_OP_NULL) {
     MPI_Op_free(&mpi_float16_sum);
   }
+  if (mpi_bfloat16_t != MPI_DATATYPE_NULL) {
+    MPI_Type_free(&mpi_bfloat16_t);
+  }
+  if (mpi_bfloat16_sum != MPI_OP_NULL) {
+    MPI_Op_free(&mpi_bfloat16_sum);
+  }
+  for (auto& op : mpi_cpu_sum_ops) {
+    MPI_Op_free(&op.second);
+  }
+  mpi_cpu_sum_ops.clear();
 }
 
 void MPIContextManager::EnvInitialize(int mpi_threads_required) {
@@ -259,5 +449,223 @@ void MPIContextManager::EnvFinalize() {
   }
 }
 
+namespace {
+
+bool FitsInInt(const int64_t* values, int count) {
+  return std::all_of(values, values + count, [](int64_t v) {
+    return v <= std::numeric_limits<int>::max();
+  });
+}
+
+} // namespace
+
+int MPIAllgatherv(const void* sendbuf, int64_t sendcount, void* recvbuf,
+                  const int64_t* recvcounts, const int64_t* displs,
+                  MPI_Datatype datatype, MPI_Comm comm) {
+  int size;
+  int rank;
+  MPI_Comm_size(comm, &size);
+  MPI_Comm_rank(comm, &rank);
+#if MPI_VERSION >= 4
+  std::vector<MPI_Count> counts(recvcounts, recvcounts + size);
+  std::vector<MPI_Aint> offsets(displs, displs + size);
+  return MPI_Allgatherv_c(sendbuf, (MPI_Count)sendcount, datatype, recvbuf,
+                          counts.data(), offsets.data(), datatype, comm);
+#else
+  // Every rank knows all counts, so they agree on the path taken.
+  if (FitsInInt(recvcounts, size) && FitsInInt(displs, size)) {
+    std::vector<int> counts(recvcounts, recvcounts + size);
+    std::vector<int> offsets(displs, displs + size);
+    return MPI_Allgatherv(sendbuf, (int)sendcount, datatype, recvbuf,
+                          counts.data(), offsets.data(), datatype, comm);
+  }
+
+  MPI_Aint lb;
+  MPI_Aint extent;
+  MPI_Type_get_extent(datatype, &lb, &extent);
+  auto* output = static_cast<uint8_t*>(recvbuf);
+  if (sendbuf != MPI_IN_PLACE) {
+    // Buffers may be in device memory with CUDA-aware MPI, so the local
+    // block is copied by MPI as well.
+    auto* input = static_cast<const uint8_t*>(sendbuf);
+    for (int64_t offset = 0; offset < sendcount;
+         offset += MPI_LARGE_COUNT_CHUNK) {
+      int count =
+          (int)std::min((int64_t)MPI_LARGE_COUNT_CHUNK, sendcount - offset);
+      int ret_code = MPI_Sendrecv(
+          input + offset * extent, count, datatype, rank, 0,
+          output + (displs[rank] + offset) * extent, count, datatype, rank, 0,
+          comm, MPI_STATUS_IGNORE);
+      if (ret_code != MPI_SUCCESS) {
+        return ret_code;
+      }
+    }
+  }
+  for (int root = 0; root < size; ++root) {
+    for (int64_t offset = 0; offset < recvcounts[root];
+         offset += MPI_LARGE_COUNT_CHUNK) {
+      int count = (int)std::min((int64_t)MPI_LARGE_COUNT_CHUNK,
+                                recvcounts[root] - offset);
+      int ret_code = MPI_Bcast(output + (displs[root] + offset) * extent,
+                               count, datatype, root, comm);
+      if (ret_code != MPI_SUCCESS) {
+        return ret_code;
+      }
+    }
+  }
+  return MPI_SUCCESS;
+#endif
+}
+
+int MPIAlltoallv(const void* sendbuf, const int64_t* sendcounts,
+                 const int64_t* sdispls, void* recvbuf,
+                 const int64_t* recvcounts, const int64_t* rdispls,
+                 MPI_Datatype datatype, MPI_Comm comm) {
+  int size;
+  MPI_Comm_size(comm, &size);
+#if MPI_VERSION >= 4
+  std::vector<MPI_Count> scounts(sendcounts, sendcounts + size);
+  std::vector<MPI_Aint> soffsets(sdispls, sdispls + size);
+  std::vector<MPI_Count> rcounts(recvcounts, recvcounts + size);
+  std::vector<MPI_Aint> roffsets(rdispls, rdispls + size);
+  return MPI_Alltoallv_c(sendbuf, scounts.data(), soffsets.data(), datatype,
+                         recvbuf, rcounts.data(), roffsets.data(), datatype,
+                         comm);
+#else
+  // Ranks only know their own counts, so they have to agree on whether any
+  // of them is too large.
+  int large = !(FitsInInt(sendcounts, size) && FitsInInt(sdispls, size) &&
+                FitsInInt(recvcounts, size) && FitsInInt(rdispls, size));
+  int ret_code =
+      MPI_Allreduce(MPI_IN_PLACE, &large, 1, MPI_INT, MPI_LOR, comm);
+  if (ret_code != MPI_SUCCESS) {
+    return ret_code;
+  }
+  if (!large) {
+    std::vector<int> scounts(sendcounts, sendcounts + size);
+    std::vector<int> soffsets(sdispls, sdispls + size);
+    std::vector<int> rcounts(recvcounts, recvcounts + size);
+    std::vector<int> roffsets(rdispls, rdispls + size);
+    return MPI_Alltoallv(sendbuf, scounts.data(), soffsets.data(), datatype,
+                         recvbuf, rcounts.data(), roffsets.data(), datatype,
+                         comm);
+  }
+
+  // Both sides of a pair know the size of the block between them, so they
+  // split it into the same chunks. Messages between two ranks do not
+  // overtake each other and are matched in order.
+  MPI_Aint lb;
+  MPI_Aint extent;
+  MPI_Type_get_extent(datatype, &lb, &extent);
+  auto* input = static_cast<const uint8_t*>(sendbuf);
+  auto* output = static_cast<uint8_t*>(recvbuf);
+  std::vector<MPI_Request> requests;
+  for (int peer = 0; peer < size; ++peer) {
+    for (int64_t offset = 0; offset < recvcounts[peer];
+         offset += MPI_LARGE_COUNT_CHUNK) {
+      int count = (int)std::min((int64_t)MPI_LARGE_COUNT_CHUNK,
+                                recvcounts[peer] - offset);
+      requests.emplace_back();
+      ret_code = MPI_Irecv(output + (rdispls[peer] + offset) * extent, count,
+                           datatype, peer, 0, comm, &requests.back());
+      if (ret_code != MPI_SUCCESS) {
+        return ret_code;
+      }
+    }
+  }
+  for (int peer = 0; peer < size; ++peer) {
+    for (int64_t offset = 0; offset < sendcounts[peer];
+         offset += MPI_LARGE_COUNT_CHUNK) {
+      int count = (int)std::min((int64_t)MPI_LARGE_COUNT_CHUNK,
+                                sendcounts[peer] - offset);
+      requests.emplace_back();
+      ret_code = MPI_Isend(input + (sdispls[peer] + offset) * extent, count,
+                           datatype, peer, 0, comm, &requests.back());
+      if (ret_code != MPI_SUCCESS) {
+        return ret_code;
+      }
+    }
+  }
+  return MPI_Waitall((int)requests.size(), requests.data(),
+                     MPI_STATUSES_IGNORE);
+#endif
+}
+
+int MPIReduceScatter(const void* sendbuf, void* recvbuf,
+                     const int64_t* recvcounts, MPI_Datatype datatype,
+                     MPI_Op op, MPI_Comm comm) {
+  int size;
+  int rank;
+  MPI_Comm_size(comm, &size);
+  MPI_Comm_rank(comm, &rank);
+#if MPI_VERSION >= 4
+  std::vector<MPI_Count> counts(recvcounts, recvcounts + size);
+  return MPI_Reduce_scatter_c(sendbuf, recvbuf, counts.data(), datatype, op,
+                              comm);
+#else
+  // Every rank knows all counts, so they agree on the path taken.
+  int64_t total = std::accumulate(recvcounts, recvcounts + size, (int64_t)0);
+  if (total <= std::numeric_limits<int>::max()) {
+    std::vector<int> counts(recvcounts, recvcounts + size);
+    return MPI_Reduce_scatter(sendbuf, recvbuf, counts.data(), datatype, op,
+                              comm);
+  }
+
+  MPI_Aint lb;
+  MPI_Aint extent;
+  MPI_Type_get_extent(datatype, &lb, &extent);
+  bool in_place = sendbuf == MPI_IN_PLACE;
+  auto* input = static_cast<const uint8_t*>(in_place ? recvbuf : sendbuf);
+  auto* output = static_cast<uint8_t*>(recvbuf);
+  int64_t displacement = 0;
+  int64_t own_displacement = 0;
+  for (int root = 0; root < size; ++root) {
+    if (root == rank) {
+      own_displacement = displacement;
+    }
+    for (int64_t offset = 0; offset < recvcounts[root];
+         offset += MPI_LARGE_COUNT_CHUNK) {
+      int count = (int)std::min((int64_t)MPI_LARGE_COUNT_CHUNK,
+                                recvcounts[root] - offset);
+      const uint8_t* chunk = input + (displacement + offset) * extent;
+      int ret_code;
+      if (root != rank) {
+        ret_code = MPI_Reduce(chunk, nullptr, count, datatype, op, root, comm);
+      } else if (in_place) {
+        ret_code = MPI_Reduce(MPI_IN_PLACE, const_cast<uint8_t*>(chunk),
+                              count, datatype, op, root, comm);
+      } else {
+        ret_code = MPI_Reduce(chunk, output + offset * extent, count, datatype,
+                              op, root, comm);
+      }
+      if (ret_code != MPI_SUCCESS) {
+        return ret_code;
+      }
+    }
+    displacement += recvcounts[root];
+  }
+
+  // In place, the result is expected at the start of the buffer. It may be
+  // in device memory with CUDA-aware MPI, so MPI moves it, in chunks no
+  // longer than the displacement so that they never overlap.
+  if (in_place && own_displacement > 0) {
+    int64_t chunk_size =
+        std::min((int64_t)MPI_LARGE_COUNT_CHUNK, own_displacement);
+    for (int64_t offset = 0; offset < recvcounts[rank];
+         offset += chunk_size) {
+      int count = (int)std::min(chunk_size, recvcounts[rank] - offset);
+      int ret_code = MPI_Sendrecv(
+          output + (own_displacement + offset) * extent, count, datatype, rank,
+          0, output + offset * extent, count, datatype, rank, 0, comm,
+          MPI_STATUS_IGNORE);
+      if (ret_code != MPI_SUCCESS) {
+        return ret_code;
+      }
+    }
+  }
+  return MPI_SUCCESS;
+#endif
+}
+
 } // namespace common
 } // namespace horovod
@@ -18,6 +18,7 @@
 #define HOROVOD_MPI_CONTEXT_H
 
 #include <iostream>
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -61,6 +62,15 @@ struct MPIContext {
   void InitializeForProcessSet(const MPIContext& global_context,
                                const std::vector<int>& ranks);
 
+  // As above, taking over communicators created by the caller:
+  // global_comm_dup duplicates the global communicator, and process_set_comm
+  // is the communicator of the process set, MPI_COMM_NULL if this process
+  // does not belong to it.
+  void InitializeForProcessSet(const MPIContext& global_context,
+                               const std::vector<int>& ranks,
+                               MPI_Comm global_comm_dup,
+                               MPI_Comm process_set_comm);
+
   void FinalizeWithoutEnv();
 
   // Take an argument of context manager pointer that will take care of
@@ -73,11 +83,21 @@ struct MPIContext {
 
   MPI_Op GetMPISumOp(DataType dtype) const;
 
+  // Sum op for host buffers: Horovod's SIMD kernels where one exists for
+  // dtype, GetMPISumOp(dtype) otherwise.
+  MPI_Op GetMPICPUSumOp(DataType dtype) const;
+
+  MPI_Op GetMPIOp(DataType dtype, ReduceOp reduce_op) const;
+
   // Communicators handled here are restricted to a single process set.
   // If the running process is not part of that set, these communicators
   // remain MPI_COMM_NULL.
   MPI_Comm GetMPICommunicator(Communicator comm) const;
 
+  // Communicator the controller negotiates on: the control communicator if
+  // there is one, otherwise the one of the operations.
+  MPI_Comm GetControlCommunicator(Communicator comm) const;
+
   int GetMPITypeSize(DataType dtype) const;
 
   std::vector<int> ranks_;
@@ -89,6 +109,13 @@ struct MPIContext {
   MPI_Datatype mpi_float16_t;
   MPI_Op mpi_float16_sum;
 
+  // MPI custom data type for bfloat16.
+  MPI_Datatype mpi_bfloat16_t;
+  MPI_Op mpi_bfloat16_sum;
+
+  // MPI summation ops backed by Horovod's CPU kernels, keyed by data type.
+  std::map<DataType, MPI_Op> mpi_cpu_sum_ops;
+
   // Private MPI communicator for Horovod to ensure no collisions with other
   // threads using MPI, incorporates all processes known to Horovod.
   // Communicators for process subsets will be based on global_comm.
@@ -103,13 +130,64 @@ struct MPIContext {
   // Cross-node communicator for the process set for hierarchical allreduce.
   MPI_Comm cross_comm = MPI_COMM_NULL;
 
+  // Communicator of the global process set for byte broadcasts from framework
+  // threads, which run concurrently with the background thread. Only created
+  // with MPI_THREAD_MULTIPLE.
+  MPI_Comm bytes_comm = MPI_COMM_NULL;
+
+  // Communicator of the global process set for sends and receives between
+  // two ranks, which are not negotiated.
+  MPI_Comm peer_comm = MPI_COMM_NULL;
+
+  // Duplicate of mpi_comm for barriers from framework threads, which run
+  // concurrently with the background thread. Only created with
+  // MPI_THREAD_MULTIPLE.
+  MPI_Comm barrier_comm = MPI_COMM_NULL;
+
+  // Duplicates of mpi_comm, local_comm and cross_comm the controller
+  // negotiates on, so that negotiation can run while the operations of
+  // earlier cycles use the communicators above. Only created for process sets
+  // of a global context with separate_control_comms set.
+  MPI_Comm control_comm = MPI_COMM_NULL;
+  MPI_Comm control_local_comm = MPI_COMM_NULL;
+  MPI_Comm control_cross_comm = MPI_COMM_NULL;
+
+  // Whether the process sets of this global context get control
+  // communicators.
+  bool separate_control_comms = false;
+
   // MPI Window used for shared memory allgather
   MPI_Win window;
 
+  // MPI Window used for shared memory allreduce
+  MPI_Win shm_allreduce_window;
+
   // Whether mpi context should be finalized.
   bool should_finalize = false;
 };
 
+// MPI_Allgatherv, MPI_Alltoallv and MPI_Reduce_scatter with 64-bit element
+// counts and displacements. The large count collectives of MPI-4 are used if
+// available, the regular ones if all counts and displacements fit in an int.
+// Otherwise data is exchanged in chunks of at most MPI_LARGE_COUNT_CHUNK
+// elements, by one round of broadcasts per rank for allgatherv, by
+// point-to-point messages for alltoallv and by one round of reductions per
+// rank for reduce_scatter. Return MPI error codes like the MPI functions.
+#define MPI_LARGE_COUNT_CHUNK (1 << 30)
+
+int MPIAllgatherv(const void* sendbuf, int64_t sendcount, void* recvbuf,
+                  const int64_t* recvcounts, const int64_t* displs,
+                  MPI_Datatype datatype, MPI_Comm comm);
+
+int MPIAlltoallv(const void* sendbuf, const int64_t* sendcounts,
+                 const int64_t* sdispls, void* recvbuf,
+                 const int64_t* recvcounts, const int64_t* rdispls,
+                 MPI_Datatype datatype, MPI_Comm comm);
+
+int MPIReduceScatter(const void* sendbuf, void* recvbuf,
+                     const int64_t* recvcounts, MPI_Datatype datatype,
+                     MPI_Op op, MPI_Comm comm);
+
 } // namespace common
 } // namespace horovod
 
@@ -16,14 +16,53 @@
 
 #include "mpi_controller.h"
 
+#include <algorithm>
+#include <cstring>
 #include <numeric>
 
 #include "../common.h"
 #include "../logging.h"
+#include "../utils/env_parser.h"
 
 namespace horovod {
 namespace common {
 
+namespace {
+
+// Gathers messages of varying length on rank zero of comm. On rank zero,
+// recvbuf holds all messages back to back, in rank order, and displcmnts
+// holds the offset of each rank's message.
+void GathervBytes(const void* sendbuf, int sendcount, bool is_root,
+                  int comm_size, MPI_Comm comm, std::vector<uint8_t>& recvbuf,
+                  std::vector<int>& recvcounts, std::vector<int>& displcmnts) {
+  if (is_root) {
+    recvcounts.resize(comm_size);
+  }
+  int ret_code = MPI_Gather(&sendcount, 1, MPI_INT, recvcounts.data(), 1,
+                            MPI_INT, RANK_ZERO, comm);
+  if (ret_code != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Gather failed, see MPI output for details.");
+  }
+
+  if (is_root) {
+    displcmnts.resize(comm_size);
+    size_t total_size = 0;
+    for (int i = 0; i < comm_size; ++i) {
+      displcmnts[i] = (int)total_size;
+      total_size += recvcounts[i];
+    }
+    recvbuf.resize(total_size);
+  }
+  ret_code = MPI_Gatherv(sendbuf, sendcount, MPI_BYTE, recvbuf.data(),
+                         recvcounts.data(), displcmnts.data(), MPI_BYTE,
+                         RANK_ZERO, comm);
+  if (ret_code != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Gather failed, see MPI output for details.");
+  }
+}
+
+} // namespace
+
 // MPIController
 void MPIController::DoInitialization() {
   assert(mpi_ctx_.global_comm != MPI_COMM_NULL);
@@ -105,6 +144,20 @@ void MPIController::DoInitialization() {
     displacement += local_sizes[displacement];
   }
 
+  // Gathering through the local roots only pays off when there are several
+  // nodes with several processes each. All ranks must agree on it, which
+  // their own sizes alone do not guarantee on a heterogeneous cluster.
+  int hierarchical_negotiation =
+      GetBoolEnvOrDefault(HOROVOD_HIERARCHICAL_NEGOTIATION, false) &&
+      cross_size_ > 1 && local_size_ > 1;
+  MPI_Allreduce(MPI_IN_PLACE, &hierarchical_negotiation, 1, MPI_INT, MPI_LAND,
+                mpi_ctx_.mpi_comm);
+  hierarchical_negotiation_ = hierarchical_negotiation != 0;
+  if (is_coordinator_ && hierarchical_negotiation_) {
+    LOG(DEBUG) << "Using hierarchical negotiation across " << cross_size_
+               << " nodes.";
+  }
+
   LOG(DEBUG) << "MPI controller initialized.";
 }
 
@@ -114,8 +167,9 @@ int MPIController::GetTypeSize(DataType dtype) {
 
 void MPIController::CrossRankBitwiseAnd(std::vector<long long>& bitvector,
                                         int count) {
+  MPI_Comm comm = mpi_ctx_.GetControlCommunicator(Communicator::GLOBAL);
   int ret_code = MPI_Allreduce(MPI_IN_PLACE, bitvector.data(), count,
-                               MPI_LONG_LONG_INT, MPI_BAND, mpi_ctx_.mpi_comm);
+                               MPI_LONG_LONG_INT, MPI_BAND, comm);
   if (ret_code != MPI_SUCCESS) {
     throw std::runtime_error(
         "MPI_AllReduce failed, see MPI output for details.");
@@ -124,8 +178,9 @@ void MPIController::CrossRankBitwiseAnd(std::vector<long long>& bitvector,
 
 void MPIController::CrossRankBitwiseOr(std::vector<long long>& bitvector,
                                        int count) {
+  MPI_Comm comm = mpi_ctx_.GetControlCommunicator(Communicator::GLOBAL);
   int ret_code = MPI_Allreduce(MPI_IN_PLACE, bitvector.data(), count,
-                               MPI_LONG_LONG_INT, MPI_BOR, mpi_ctx_.mpi_comm);
+                               MPI_LONG_LONG_INT, MPI_BOR, comm);
   if (ret_code != MPI_SUCCESS) {
     throw std::runtime_error(
         "MPI_AllReduce failed, see MPI output for details.");
@@ -137,93 +192,141 @@ void MPIController::RecvReadyTensors(std::vector<std::string>& ready_to_reduce,
   // Rank zero has put all its own tensors in the tensor count table.
   // Now, it should count all the tensors that are coming from other
   // ranks at this tick.
-
-  // 1. Get message lengths from every rank.
-  auto recvcounts = new int[size_];
-  recvcounts[0] = 0;
-  MPI_Gather(MPI_IN_PLACE, 1, MPI_INT, recvcounts, 1, MPI_INT, RANK_ZERO,
-             mpi_ctx_.mpi_comm);
-
-  // 2. Compute displacements.
-  auto displcmnts = new int[size_];
-  size_t total_size = 0;
-  for (int i = 0; i < size_; ++i) {
-    if (i == 0) {
-      displcmnts[i] = 0;
-    } else {
-      displcmnts[i] = recvcounts[i - 1] + displcmnts[i - 1];
-    }
-    total_size += recvcounts[i];
+  if (hierarchical_negotiation_) {
+    HierarchicalGatherRequests(std::string(), ready_list);
+    return;
   }
 
-  // 3. Collect messages from every rank.
-  auto buffer = new uint8_t[total_size];
-  MPI_Gatherv(nullptr, 0, MPI_BYTE, buffer, recvcounts, displcmnts, MPI_BYTE,
-              RANK_ZERO, mpi_ctx_.mpi_comm);
+  // 1. Collect messages from every rank, rank zero sending an empty one.
+  MPI_Comm comm = mpi_ctx_.GetControlCommunicator(Communicator::GLOBAL);
+  GathervBytes(nullptr, 0, true, size_, comm, recv_buffer_, recvcounts_,
+               displcmnts_);
 
-  // 4. Process messages.
-  // create a dummy list for rank 0
-  ready_list.emplace_back();
+  // 2. Process messages, parsing every rank directly into its list. The list
+  // of rank 0 stays empty as a dummy.
+  ready_list.resize(size_);
   for (int i = 1; i < size_; ++i) {
-    auto rank_buffer_ptr = buffer + displcmnts[i];
-    RequestList received_message_list;
-    RequestList::ParseFromBytes(received_message_list, rank_buffer_ptr);
-    ready_list.push_back(std::move(received_message_list));
+    RequestList::ParseFromBytes(ready_list[i],
+                                recv_buffer_.data() + displcmnts_[i]);
   }
-
-  // 5. Free buffers.
-  delete[] recvcounts;
-  delete[] displcmnts;
-  delete[] buffer;
 }
 
 void MPIController::SendFinalTensors(ResponseList& response_list) {
   // Notify all nodes which tensors we'd like to reduce at this step.
-  std::string encoded_response;
-  ResponseList::SerializeToString(response_list, encoded_response);
-  int encoded_response_length = (int)encoded_response.length() + 1;
-  MPI_Bcast(&encoded_response_length, 1, MPI_INT, RANK_ZERO, mpi_ctx_.mpi_comm);
+  ResponseList::SerializeToString(response_list, encoded_message_);
+  int encoded_response_length = (int)encoded_message_.length() + 1;
+  MPI_Comm comm = mpi_ctx_.GetControlCommunicator(Communicator::GLOBAL);
+  MPI_Bcast(&encoded_response_length, 1, MPI_INT, RANK_ZERO, comm);
 
-  MPI_Bcast((void*)encoded_response.c_str(), encoded_response_length, MPI_BYTE,
-            RANK_ZERO, mpi_ctx_.mpi_comm);
+  MPI_Bcast((void*)encoded_message_.c_str(), encoded_response_length, MPI_BYTE,
+            RANK_ZERO, comm);
 }
 
 void MPIController::SendReadyTensors(RequestList& message_list) {
-  std::string encoded_message;
-  RequestList::SerializeToString(message_list, encoded_message);
-  int encoded_message_length = (int)encoded_message.length() + 1;
+  RequestList::SerializeToString(message_list, encoded_message_);
+  if (hierarchical_negotiation_) {
+    std::vector<RequestList> unused;
+    HierarchicalGatherRequests(encoded_message_, unused);
+    return;
+  }
+
+  MPI_Comm comm = mpi_ctx_.GetControlCommunicator(Communicator::GLOBAL);
+  int encoded_message_length = (int)encoded_message_.length() + 1;
   int ret_code = MPI_Gather(&encoded_message_length, 1, MPI_INT, nullptr, 1,
-                            MPI_INT, RANK_ZERO, mpi_ctx_.mpi_comm);
+                            MPI_INT, RANK_ZERO, comm);
   if (ret_code != MPI_SUCCESS) {
     throw std::runtime_error("MPI_Gather failed, see MPI output for details.");
   }
 
-  ret_code = MPI_Gatherv((void*)encoded_message.c_str(), encoded_message_length,
+  ret_code = MPI_Gatherv((void*)encoded_message_.c_str(), encoded_message_length,
                          MPI_BYTE, nullptr, nullptr, nullptr, MPI_BYTE,
-                         RANK_ZERO, mpi_ctx_.mpi_comm);
+                         RANK_ZERO, comm);
   if (ret_code != MPI_SUCCESS) {
     throw std::runtime_error("MPI_Gather failed, see MPI output for details.");
   }
 }
 
+void MPIController::HierarchicalGatherRequests(
+    const std::string& encoded_message, std::vector<RequestList>& ready_list) {
+  // Rank zero sends an empty message, like in the flat Gatherv.
+  int message_length =
+      encoded_message.empty() ? 0 : (int)encoded_message.length() + 1;
+
+  // 1. Collect the messages of this node on its local root.
+  bool is_local_root = local_rank_ == 0;
+  std::vector<uint8_t> local_buffer;
+  std::vector<int> local_recvcounts;
+  std::vector<int> local_displcmnts;
+  GathervBytes(encoded_message.c_str(), message_length, is_local_root,
+               local_size_,
+               mpi_ctx_.GetControlCommunicator(Communicator::LOCAL),
+               local_buffer,
+               local_recvcounts, local_displcmnts);
+  if (!is_local_root) {
+    return;
+  }
+
+  // 2. Pack them as (rank, length, bytes) records, so that rank zero does not
+  // need to know the node layout of the process set.
+  std::vector<uint8_t> node_buffer;
+  node_buffer.reserve(local_buffer.size() + 2 * sizeof(int) * local_size_);
+  for (int i = 0; i < local_size_; ++i) {
+    int header[2] = {local_comm_ranks_[i], local_recvcounts[i]};
+    auto header_ptr = reinterpret_cast<const uint8_t*>(header);
+    node_buffer.insert(node_buffer.end(), header_ptr,
+                       header_ptr + sizeof(header));
+    node_buffer.insert(node_buffer.end(),
+                       local_buffer.begin() + local_displcmnts[i],
+                       local_buffer.begin() + local_displcmnts[i] +
+                           local_recvcounts[i]);
+  }
+
+  // 3. Collect the node records on rank zero, which is the root of the cross
+  // communicator of local roots.
+  std::vector<uint8_t> buffer;
+  std::vector<int> recvcounts;
+  std::vector<int> displcmnts;
+  GathervBytes(node_buffer.data(), (int)node_buffer.size(), is_coordinator_,
+               cross_size_,
+               mpi_ctx_.GetControlCommunicator(Communicator::CROSS), buffer,
+               recvcounts, displcmnts);
+  if (!is_coordinator_) {
+    return;
+  }
+
+  // 4. Process messages.
+  ready_list.resize(size_);
+  size_t offset = 0;
+  while (offset < buffer.size()) {
+    int header[2];
+    std::memcpy(header, buffer.data() + offset, sizeof(header));
+    offset += sizeof(header);
+    if (header[1] > 0) {
+      RequestList::ParseFromBytes(ready_list[header[0]],
+                                  buffer.data() + offset);
+    }
+    offset += header[1];
+  }
+}
+
 void MPIController::RecvFinalTensors(ResponseList& response_list) {
+  MPI_Comm comm = mpi_ctx_.GetControlCommunicator(Communicator::GLOBAL);
   int msg_length;
   int ret_code =
-      MPI_Bcast(&msg_length, 1, MPI_INT, RANK_ZERO, mpi_ctx_.mpi_comm);
+      MPI_Bcast(&msg_length, 1, MPI_INT, RANK_ZERO, comm);
   if (ret_code != MPI_SUCCESS) {
     throw std::runtime_error(
         "MPI_Broadcast failed, see MPI output for details.");
   }
 
-  auto buffer = new uint8_t[msg_length];
-  ret_code =
-      MPI_Bcast(buffer, msg_length, MPI_BYTE, RANK_ZERO, mpi_ctx_.mpi_comm);
+  recv_buffer_.resize(msg_length);
+  ret_code = MPI_Bcast(recv_buffer_.data(), msg_length, MPI_BYTE, RANK_ZERO,
+                       comm);
   if (ret_code != MPI_SUCCESS) {
     throw std::runtime_error(
         "MPI_Broadcast failed, see MPI output for details.");
   }
-  ResponseList::ParseFromBytes(response_list, buffer);
-  delete[] buffer;
+  ResponseList::ParseFromBytes(response_list, recv_buffer_.data());
 }
 
 void MPIController::Bcast(void* buffer, size_t size, int root_rank,
@@ -238,10 +341,11 @@ void MPIController::Bcast(void* buffer, size_t size, int root_rank,
 
 void MPIController::AlltoallGetRecvSplits(const std::vector<int32_t>& splits,
                                           std::vector<int32_t>& recvsplits) {
-  recvsplits.resize(size_);
+  int count = (int)splits.size() / size_;
+  recvsplits.resize(splits.size());
   MPI_Comm comm = mpi_ctx_.GetMPICommunicator(Communicator::GLOBAL);
-  int ret_code = MPI_Alltoall(splits.data(), 1, MPI_INT,
-                              recvsplits.data(), 1, MPI_INT,
+  int ret_code = MPI_Alltoall(splits.data(), count, MPI_INT,
+                              recvsplits.data(), count, MPI_INT,
                               comm);
   if (ret_code != MPI_SUCCESS) {
     throw std::runtime_error(
@@ -260,7 +364,7 @@ void MPIController::Barrier(Communicator communicator) {
 void MPIController::Allgather2Ints(std::array<int, 2> values,
                                    std::vector<int>& recv_values) {
   recv_values.resize(size_ * 2);
-  MPI_Comm comm = mpi_ctx_.GetMPICommunicator(Communicator::GLOBAL);
+  MPI_Comm comm = mpi_ctx_.GetControlCommunicator(Communicator::GLOBAL);
   int ret_code = MPI_Allgather(values.data(), 2, MPI_INT,
                                recv_values.data(), 2, MPI_INT,
                                comm);
@@ -270,6 +374,70 @@ void MPIController::Allgather2Ints(std::array<int, 2> values,
   }
 }
 
+void MPIController::AllgatherInt64s(const std::vector<int64_t>& values,
+                                    std::vector<int64_t>& recv_values) {
+  recv_values.resize(size_ * values.size());
+  MPI_Comm comm = mpi_ctx_.GetControlCommunicator(Communicator::GLOBAL);
+  int ret_code = MPI_Allgather(values.data(), (int)values.size(), MPI_INT64_T,
+                               recv_values.data(), (int)values.size(),
+                               MPI_INT64_T, comm);
+  if (ret_code != MPI_SUCCESS) {
+    throw std::runtime_error(
+        "MPI_Allgather failed, see MPI output for details.");
+  }
+}
+
+bool MPIController::ImmediateBarrier() {
+  MPI_Comm comm = mpi_ctx_.barrier_comm;
+  if (comm == MPI_COMM_NULL) {
+    return false;
+  }
+  int ret_code = MPI_Barrier(comm);
+  if (ret_code != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Barrier failed, see MPI output for details.");
+  }
+  return true;
+}
+
+bool MPIController::BcastBytes(std::string& data, int root_rank) {
+  MPI_Comm comm = mpi_ctx_.bytes_comm;
+  if (comm == MPI_COMM_NULL) {
+    return false;
+  }
+  // The first message carries the size and the start of the data, which is
+  // all of it for most objects.
+  const int64_t head_size = 64 * 1024;
+  const int64_t head_data = head_size - (int64_t)sizeof(int64_t);
+  std::vector<char> head(head_size);
+  int64_t size = data.size();
+  if (rank_ == root_rank) {
+    std::memcpy(head.data(), &size, sizeof(size));
+    std::memcpy(head.data() + sizeof(size), data.data(),
+                std::min(size, head_data));
+  }
+  int ret_code =
+      MPI_Bcast(head.data(), (int)head_size, MPI_BYTE, root_rank, comm);
+  if (ret_code != MPI_SUCCESS) {
+    throw std::runtime_error(
+        "MPI_Broadcast failed, see MPI output for details.");
+  }
+  if (rank_ != root_rank) {
+    std::memcpy(&size, head.data(), sizeof(size));
+    data.assign(head.data() + sizeof(size), std::min(size, head_data));
+    data.resize(size);
+  }
+
+  for (int64_t offset = head_data; offset < size;
+       offset += MPI_LARGE_COUNT_CHUNK) {
+    int count = (int)std::min<int64_t>(size - offset, MPI_LARGE_COUNT_CHUNK);
+    ret_code = MPI_Bcast(&data[offset], count, MPI_BYTE, root_rank, comm);
+    if (ret_code != MPI_SUCCESS) {
+      throw std::runtime_error(
+          "MPI_Broadcast failed, see MPI output for details.");
+    }
+  }
+  return true;
+}
 
 } // namespace common
 } // namespace horovod
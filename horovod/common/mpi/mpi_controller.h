@@ -66,15 +66,39 @@ public:
   void Allgather2Ints(std::array<int, 2> values,
                       std::vector<int>& recv_values) override;
 
+  void AllgatherInt64s(const std::vector<int64_t>& values,
+                       std::vector<int64_t>& recv_values) override;
+
+  bool BcastBytes(std::string& data, int root_rank) override;
+
+  bool ImmediateBarrier() override;
+
   bool IsMpiThreadsSupported() const { return mpi_threads_supported_; }
 
 protected:
   void DoInitialization() override;
 
+  // Gathers the serialized request lists of all ranks on rank zero in two
+  // steps: first onto the local root of every node, then across the local
+  // roots. On rank zero, ready_list receives one entry per rank.
+  void HierarchicalGatherRequests(const std::string& encoded_message,
+                                  std::vector<RequestList>& ready_list);
+
   MPIContext& mpi_ctx_;
 
   // flag indicating whether MPI multi-threading is supported
   bool mpi_threads_supported_ = false;
+
+  // flag indicating whether requests are gathered through the local roots
+  // instead of directly on rank zero
+  bool hierarchical_negotiation_ = false;
+
+  // Negotiation buffers kept across cycles, so that the messages of every
+  // cycle are encoded and received without allocating once they have grown.
+  std::string encoded_message_;
+  std::vector<uint8_t> recv_buffer_;
+  std::vector<int> recvcounts_;
+  std::vector<int> displcmnts_;
 };
 
 } // namespace common
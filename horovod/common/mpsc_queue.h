@@ -0,0 +1,104 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_MPSC_QUEUE_H
+#define HOROVOD_MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+namespace horovod {
+namespace common {
+
+// Unbounded lock-free queue with any number of producers and a single
+// consumer. Producers never wait on each other or on the consumer: a push is
+// one atomic exchange plus one store.
+//
+// A push is visible to the consumer once it has returned. Elements that are
+// pushed concurrently with Pop() may only show up in a later call.
+template <class T> class MPSCQueue {
+public:
+  MPSCQueue() : head_(new Node()), tail_(head_.load()) {}
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  ~MPSCQueue() {
+    T value;
+    while (Pop(value)) {
+    }
+    delete tail_;
+  }
+
+  // Safe to call from any thread.
+  void Push(T&& value) {
+    Node* node = new Node(std::move(value));
+    Link(node, node);
+  }
+
+  // Pushes all elements in [begin, end) at once, so that the consumer sees
+  // either none or all of them. Safe to call from any thread.
+  template <class Iterator> void Push(Iterator begin, Iterator end) {
+    if (begin == end) {
+      return;
+    }
+    Node* first = new Node(std::move(*begin));
+    Node* last = first;
+    for (++begin; begin != end; ++begin) {
+      Node* node = new Node(std::move(*begin));
+      last->next.store(node, std::memory_order_relaxed);
+      last = node;
+    }
+    Link(first, last);
+  }
+
+  // Must only be called from the consumer thread. Returns false if no
+  // element is available.
+  bool Pop(T& value) {
+    Node* next = tail_->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    value = std::move(next->value);
+    // The popped node becomes the new sentinel.
+    delete tail_;
+    tail_ = next;
+    return true;
+  }
+
+private:
+  struct Node {
+    Node() = default;
+    explicit Node(T&& v) : value(std::move(v)) {}
+    std::atomic<Node*> next{nullptr};
+    T value;
+  };
+
+  void Link(Node* first, Node* last) {
+    Node* prev = head_.exchange(last, std::memory_order_acq_rel);
+    prev->next.store(first, std::memory_order_release);
+  }
+
+  // Most recently pushed node, shared by all producers.
+  std::atomic<Node*> head_;
+
+  // Sentinel node whose successor is the oldest element, owned by the
+  // consumer.
+  Node* tail_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_MPSC_QUEUE_H
@@ -14,6 +14,12 @@ NvtxOpsHandle::NvtxOpsHandle() noexcept
   REGISTER_STRING(HorovodAllgather);
   REGISTER_STRING(HorovodBroadcast);
   REGISTER_STRING(HorovodAlltoall);
+  REGISTER_STRING(HorovodReducescatter);
+  REGISTER_STRING(HorovodGroupedAlltoall);
+  REGISTER_STRING(HorovodGroupedAllgather);
+  REGISTER_STRING(HorovodGroupedBroadcast);
+  REGISTER_STRING(HorovodReduce);
+  REGISTER_STRING(HorovodGather);
 #undef REGISTER_STRING
 }
 
@@ -30,6 +36,32 @@ void NvtxOpsHandle::Disable() {
 
 NvtxOpsHandle NvtxOpRange::nvtx_ops_handle;
 
+NvtxPhasesHandle::NvtxPhasesHandle() noexcept
+    : domain_(nvtxDomainCreateA("HorovodPhases")), phase_names_{}
+{
+#define REGISTER_STRING(phase) phase_names_[static_cast<int>(RegisteredNvtxPhase::phase)] = nvtxDomainRegisterStringA(domain_, #phase)
+  REGISTER_STRING(FusionBufferMemcpyIn);
+  REGISTER_STRING(FusionBufferMemcpyOut);
+  REGISTER_STRING(ScaleBuffer);
+  REGISTER_STRING(HostStagingMemcpyIn);
+  REGISTER_STRING(HostStagingMemcpyOut);
+  REGISTER_STRING(FinalizerCallback);
+#undef REGISTER_STRING
+}
+
+NvtxPhasesHandle::~NvtxPhasesHandle() {
+  Disable();
+}
+
+void NvtxPhasesHandle::Disable() {
+  if (domain_ != nullptr) {
+    nvtxDomainDestroy(domain_);
+    domain_ = nullptr;
+  }
+}
+
+NvtxPhasesHandle NvtxPhaseRange::nvtx_phases_handle;
+
 } // namespace common
 } // namespace horovod
 
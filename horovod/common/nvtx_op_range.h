@@ -1,6 +1,8 @@
 #ifndef HOROVOD_NVTX_OP_RANGE_H
 #define HOROVOD_NVTX_OP_RANGE_H
 
+#include <cstdint>
+
 #if HAVE_NVTX
 #include <memory>
 #include <nvtx3/nvToolsExt.h>
@@ -15,6 +17,27 @@ enum class RegisteredNvtxOp {
   HorovodAllgather,
   HorovodBroadcast,
   HorovodAlltoall,
+  HorovodReducescatter,
+  HorovodGroupedAlltoall,
+  HorovodGroupedAllgather,
+  HorovodGroupedBroadcast,
+  HorovodReduce,
+  HorovodGather,
+  // Insert new enum values above this line
+  END,
+};
+
+// Phases within an operation, recorded in their own domain so that the
+// copies, kernels and callbacks show up separately from the op ranges. The
+// payload of a phase range is the correlation ID of the operation, which the
+// timeline also writes to the activities of the same operation.
+enum class RegisteredNvtxPhase {
+  FusionBufferMemcpyIn = 0,
+  FusionBufferMemcpyOut,
+  ScaleBuffer,
+  HostStagingMemcpyIn,
+  HostStagingMemcpyOut,
+  FinalizerCallback,
   // Insert new enum values above this line
   END,
 };
@@ -86,12 +109,72 @@ private:
   std::shared_ptr<NvtxOpRange> p_;
 };
 
+class NvtxPhasesHandle {
+public:
+  NvtxPhasesHandle() noexcept;
+  ~NvtxPhasesHandle();
+
+  inline nvtxRangeId_t StartRange(RegisteredNvtxPhase phase,
+                                  int64_t correlation_id) {
+    if (domain_ == nullptr) {
+      return NvtxOpsHandle::invalid_range_id;
+    }
+
+    nvtxEventAttributes_t eventAttrib = {0};
+    eventAttrib.version = NVTX_VERSION;
+    eventAttrib.size = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+    eventAttrib.messageType = NVTX_MESSAGE_TYPE_REGISTERED;
+    eventAttrib.message.registered = phase_names_[static_cast<int>(phase)];
+    if (correlation_id >= 0) {
+      eventAttrib.payloadType = NVTX_PAYLOAD_TYPE_INT64;
+      eventAttrib.payload.llValue = correlation_id;
+    }
+
+    return nvtxDomainRangeStartEx(domain_, &eventAttrib);
+  }
+
+  inline void EndRange(nvtxRangeId_t range_id) {
+    if (domain_ == nullptr || range_id == NvtxOpsHandle::invalid_range_id) {
+      return;
+    }
+    nvtxDomainRangeEnd(domain_, range_id);
+  }
+
+  void Disable();
+
+private:
+  nvtxDomainHandle_t domain_;   // nullptr if disabled
+  nvtxStringHandle_t phase_names_[static_cast<int>(RegisteredNvtxPhase::END)];
+};
+
+class NvtxPhaseRange {
+public:
+  NvtxPhaseRange(RegisteredNvtxPhase phase, int64_t correlation_id)
+      : range_id_(nvtx_phases_handle.StartRange(phase, correlation_id)) {
+  }
+
+  ~NvtxPhaseRange() { nvtx_phases_handle.EndRange(range_id_); }
+
+  NvtxPhaseRange(const NvtxPhaseRange&) = delete;
+  NvtxPhaseRange& operator=(const NvtxPhaseRange&) = delete;
+
+  static NvtxPhasesHandle nvtx_phases_handle;
+
+private:
+  nvtxRangeId_t range_id_;
+};
+
 #else // HAVE_NVTX
 class SharedNvtxOpRange {
 public:
   void Start(RegisteredNvtxOp msg, int64_t payload) { }
   void End() { }
 };
+
+class NvtxPhaseRange {
+public:
+  NvtxPhaseRange(RegisteredNvtxPhase phase, int64_t correlation_id) { }
+};
 #endif // HAVE_NVTX
 
 } // namespace common
@@ -19,9 +19,11 @@
 
 #include "operations.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <cstring>
+#include <future>
 #include <map>
 #include <numeric>
 #include <queue>
@@ -37,9 +39,11 @@
 #include "hashes.h"
 #include "logging.h"
 #include "message.h"
+#include "ops/cpu_kernels.h"
 #include "ops/operation_manager.h"
 #include "parameter_manager.h"
 #include "timeline.h"
+#include "topology.h"
 #include "utils/env_parser.h"
 #include "nvtx_op_range.h"
 
@@ -125,6 +129,7 @@ GlooContext global_gloo_context;
 
 #if HAVE_GPU
 GPUContext gpu_context;
+GPUAccumulator gpu_accumulator(&gpu_context);
 #endif
 
 #if HAVE_NCCL
@@ -141,6 +146,11 @@ CCLContext ccl_context;
 
 std::unique_ptr<OperationManager> op_manager;
 
+#if HAVE_MPI
+std::unique_ptr<MPIPeerOperations> mpi_peer_operations;
+MPICollectiveQueue mpi_collectives;
+#endif
+
 OperationManager* CreateOperationManager(HorovodGlobalState& state) {
   // Order of these operations is very important. Operations will be checked
   // sequentially from the first to the last. The first 'Enabled' operation will
@@ -150,6 +160,9 @@ OperationManager* CreateOperationManager(HorovodGlobalState& state) {
   std::vector<std::shared_ptr<BroadcastOp>> broadcast_ops;
   std::vector<std::shared_ptr<AllreduceOp>> adasum_ops;
   std::vector<std::shared_ptr<AlltoallOp>> alltoall_ops;
+  std::vector<std::shared_ptr<ReducescatterOp>> reducescatter_ops;
+  std::vector<std::shared_ptr<AllreduceOp>> reduce_ops;
+  std::vector<std::shared_ptr<GatherOp>> gather_ops;
 
 #if HAVE_MPI && HAVE_GPU
   if (global_mpi_context.IsEnabled()) {
@@ -180,12 +193,19 @@ OperationManager* CreateOperationManager(HorovodGlobalState& state) {
     alltoall_ops.push_back(std::shared_ptr<AlltoallOp>(
         new MPI_GPUAlltoall(&gpu_context, &state)));
 #endif
+
+#if HOROVOD_GPU_REDUCESCATTER == 'M'
+    reducescatter_ops.push_back(std::shared_ptr<ReducescatterOp>(
+        new MPI_GPUReducescatter(&gpu_context, &state)));
+#endif
   }
 #endif
 
 #if HAVE_NCCL && HOROVOD_GPU_ALLREDUCE == 'N'
   allreduce_ops.push_back(std::shared_ptr<AllreduceOp>(
       new NCCLAllreduce(&nccl_context, &gpu_context, &state)));
+  reduce_ops.push_back(std::shared_ptr<AllreduceOp>(
+      new NCCLReduce(&nccl_context, &gpu_context, &state)));
 #endif
 
 #if HAVE_NCCL && HOROVOD_GPU_BROADCAST == 'N'
@@ -194,17 +214,32 @@ OperationManager* CreateOperationManager(HorovodGlobalState& state) {
 #endif
 
 #if HAVE_NCCL && HOROVOD_GPU_ALLGATHER == 'N'
+  allgather_ops.push_back(std::shared_ptr<AllgatherOp>(
+      new NCCLHierarchicalAllgather(&nccl_context, &gpu_context, &state)));
   allgather_ops.push_back(std::shared_ptr<AllgatherOp>(
       new NCCLAllgather(&nccl_context, &gpu_context, &state)));
+#ifdef NCCL_P2P_SUPPORTED
+  gather_ops.push_back(std::shared_ptr<GatherOp>(
+      new NCCLGather(&nccl_context, &gpu_context, &state)));
+#endif
 #endif
 
 #if HAVE_NCCL && HOROVOD_GPU_ALLTOALL == 'N'
+  alltoall_ops.push_back(std::shared_ptr<AlltoallOp>(
+      new NCCLHierarchicalAlltoall(&nccl_context, &gpu_context, &state)));
   alltoall_ops.push_back(std::shared_ptr<AlltoallOp>(
       new NCCLAlltoall(&nccl_context, &gpu_context, &state)));
 #endif
 
+#if HAVE_NCCL && HOROVOD_GPU_REDUCESCATTER == 'N'
+  reducescatter_ops.push_back(std::shared_ptr<ReducescatterOp>(
+      new NCCLReducescatter(&nccl_context, &gpu_context, &state)));
+#endif
+
 #if HAVE_GLOO
   if (global_gloo_context.IsEnabled()) {
+    allreduce_ops.push_back(
+        std::shared_ptr<AllreduceOp>(new GlooHierarchicalAllreduce(&state)));
     allreduce_ops.push_back(
         std::shared_ptr<AllreduceOp>(new GlooAllreduce(&state)));
     allgather_ops.push_back(
@@ -213,6 +248,11 @@ OperationManager* CreateOperationManager(HorovodGlobalState& state) {
         std::shared_ptr<BroadcastOp>(new GlooBroadcast(&state)));
     alltoall_ops.push_back(
         std::shared_ptr<AlltoallOp>(new GlooAlltoall(&state)));
+    reducescatter_ops.push_back(
+        std::shared_ptr<ReducescatterOp>(new GlooReducescatter(&state)));
+    reduce_ops.push_back(
+        std::shared_ptr<AllreduceOp>(new GlooReduce(&state)));
+    gather_ops.push_back(std::shared_ptr<GatherOp>(new GlooGather(&state)));
   }
 #endif
 
@@ -226,6 +266,8 @@ OperationManager* CreateOperationManager(HorovodGlobalState& state) {
         std::make_shared<CCLBroadcast>(&ccl_context, &state));
     alltoall_ops.push_back(
         std::make_shared<CCLAlltoall>(&ccl_context, &state));
+    reducescatter_ops.push_back(
+        std::make_shared<CCLReducescatter>(&ccl_context, &state));
   }
 #endif
 
@@ -234,58 +276,236 @@ OperationManager* CreateOperationManager(HorovodGlobalState& state) {
     adasum_ops.push_back(
         std::shared_ptr<AllreduceOp>(new AdasumMPIAllreduceOp(&global_mpi_context, &state)));
     allreduce_ops.push_back(
-        std::shared_ptr<AllreduceOp>(new MPIAllreduce(&state)));
-    allgather_ops.push_back(
-        std::shared_ptr<AllgatherOp>(new MPIAllgather(&state)));
-    broadcast_ops.push_back(
-        std::shared_ptr<BroadcastOp>(new MPIBroadcast(&state)));
+        std::shared_ptr<AllreduceOp>(new MPISharedMemoryAllreduce(&state)));
+    allreduce_ops.push_back(std::shared_ptr<AllreduceOp>(
+        new MPIAllreduce(&state, &mpi_collectives)));
+    allgather_ops.push_back(std::shared_ptr<AllgatherOp>(
+        new MPIAllgather(&state, &mpi_collectives)));
+    broadcast_ops.push_back(std::shared_ptr<BroadcastOp>(
+        new MPIBroadcast(&state, &mpi_collectives)));
     alltoall_ops.push_back(
         std::shared_ptr<AlltoallOp>(new MPIAlltoall(&state)));
+    reducescatter_ops.push_back(
+        std::shared_ptr<ReducescatterOp>(new MPIReducescatter(&state)));
+    reduce_ops.push_back(std::shared_ptr<AllreduceOp>(new MPIReduce(&state)));
+    gather_ops.push_back(std::shared_ptr<GatherOp>(new MPIGather(&state)));
   }
 #endif
 
   std::shared_ptr<JoinOp> join_op(new JoinOp(&state));
   std::shared_ptr<ErrorOp> error_op(new ErrorOp(&state));
 
-  return new OperationManager(&state.parameter_manager, allreduce_ops,
+  return new OperationManager(&state.parameter_manager,
+                              &state.process_set_table, allreduce_ops,
                               allgather_ops, broadcast_ops, alltoall_ops,
+                              reducescatter_ops, reduce_ops, gather_ops,
                               join_op, adasum_ops, error_op);
 }
 
-// Process a Response by doing a reduction, a gather, a broadcast, or
-// raising an error.
-void PerformOperation(Response response, ProcessSet& process_set) {
-  std::vector<TensorTableEntry> entries;
+#if HAVE_GPU
+// Place a GPU response on the stream with the least recent load, so that a
+// small response does not queue up behind a large one on the same stream.
+// The load only depends on the response lists of this process set, which are
+// identical on all of its ranks, so every rank picks the same stream and
+// therefore the same NCCL communicator.
+void AssignGPUStream(const Response& response, ProcessSet& process_set) {
+  if (response.response_type() == Response::JOIN ||
+      response.response_type() == Response::ERROR ||
+      response.devices().empty() ||
+      response.devices()[0] == CPU_DEVICE_ID) {
+    return;
+  }
+
+  auto& load = process_set.gpu_stream_load;
+  int num_streams = horovod_global.parameter_manager.NumNcclStreams();
+  load.resize(num_streams, 0);
+
+  int64_t num_elements = 0;
+  for (auto size : response.tensor_sizes()) {
+    num_elements += size;
+  }
+  int64_t bytes =
+      std::max(num_elements, (int64_t)1) * DataType_Size(response.tensor_type());
+
+  // Ties go to the lowest index. The global current_nccl_stream cannot be
+  // used as a starting point, as other process sets advance it as well.
+  int stream = 0;
+  for (int i = 1; i < num_streams; ++i) {
+    if (load[i] < load[stream]) {
+      stream = i;
+    }
+  }
+  load[stream] += bytes;
+  horovod_global.current_nccl_stream = stream;
+}
+
+// Halve the recorded load at the start of every cycle, since work placed on
+// the streams in earlier cycles has probably made progress meanwhile.
+void DecayGPUStreamLoad(ProcessSet& process_set) {
+  auto& load = process_set.gpu_stream_load;
+  if (load.empty()) {
+    return;
+  }
+  int64_t min_load = *std::min_element(load.begin(), load.end());
+  for (auto& l : load) {
+    l = (l - min_load) / 2;
+  }
+}
+#endif
+
+// Takes the entries of a response from the tensor queue and readies them for
+// the operation: timeline, metrics, fusion buffer and outputs. Grouped
+// allreduces get their outputs from the framework. Returns false if the
+// entries were finished with an error instead.
+bool PrepareOperation(const Response& response, ProcessSet& process_set,
+                      std::vector<TensorTableEntry>& entries,
+                      std::chrono::steady_clock::time_point start,
+                      bool grouped) {
   auto& timeline = horovod_global.timeline;
+  auto& metrics = horovod_global.metrics;
   if (response.response_type() != Response::JOIN) {
     process_set.tensor_queue.GetTensorEntriesFromResponse(response, entries,
                                                           process_set.joined);
 
+    int64_t bytes = 0;
     for (auto& e : entries) {
-      timeline.Start(e.tensor_name, response.response_type(), e.tensor->size());
+      auto queue_time_us =
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              start - e.enqueue_time)
+              .count();
+      timeline.Start(e.tensor_name, response.response_type(), e.tensor->size(),
+                     queue_time_us);
+      bytes += e.tensor->size();
+      metrics.Add(METRIC_QUEUE_TIME_US, queue_time_us);
+    }
+    metrics.Add(METRIC_TENSORS, entries.size());
+
+    // The last entry is finished last, also when the operation completes
+    // asynchronously on a GPU finalizer thread.
+    if (!entries.empty()) {
+      auto response_type = response.response_type();
+      // Tensors of the operation for the step report, only once steps are
+      // reported.
+      std::shared_ptr<std::vector<StepProfiler::TensorTiming>> step_tensors;
+      if (horovod_global.step_profiler.enabled()) {
+        step_tensors =
+            std::make_shared<std::vector<StepProfiler::TensorTiming>>();
+        step_tensors->reserve(entries.size());
+        for (auto& e : entries) {
+          step_tensors->push_back({e.tensor_name, e.enqueue_time});
+        }
+      }
+      auto& last_entry = entries.back();
+      auto callback = std::move(last_entry.callback);
+      last_entry.callback = [callback, response_type, bytes, start,
+                             step_tensors](const Status& status) {
+        if (status.ok()) {
+          horovod_global.metrics.AddOperation(response_type, bytes, start);
+        }
+        if (step_tensors != nullptr) {
+          horovod_global.step_profiler.RecordOperation(
+              std::move(*step_tensors), start,
+              std::chrono::steady_clock::now());
+        }
+        if (callback != nullptr) {
+          callback(status);
+        }
+      };
     }
 
-    if (entries.size() > 1) {
+    if (op_manager->StagesInFusionBuffer(entries, response)) {
       auto first_entry = entries[0];
       // Note: it is OK for different entries to come from different frameworks
       // since buffer allocated here is guaranteed to survive at least till the
       // end of this operation.
-      Status status = horovod_global.fusion_buffer.InitializeBuffer(
-          process_set.controller->TensorFusionThresholdBytes(),
+      int64_t buffer_size = process_set.controller->TensorFusionThresholdBytes();
+      if (horovod_global.fusion_large_tensor_size > 0) {
+        buffer_size = std::max(
+            buffer_size,
+            process_set.controller->LargeTensorFusionThresholdBytes());
+      }
+      BufferAllocator allocate;
+#if HAVE_GPU
+      if (gpu_context.memory_pool && first_entry.device != CPU_DEVICE_ID) {
+        int device = first_entry.device;
+        int stream_id = horovod_global.current_nccl_stream;
+        allocate = [device, stream_id](int64_t size,
+                                       std::shared_ptr<PersistentBuffer>* buffer) {
+          try {
+            *buffer = gpu_context.AllocatePooled(
+                size, gpu_context.GetStream(stream_id, device));
+          } catch (const std::logic_error& e) {
+            return Status::UnknownError(e.what());
+          }
+          return Status::OK();
+        };
+      }
+#endif
+      Status status = process_set.fusion_buffer.InitializeBuffer(
+          buffer_size,
           first_entry.device, first_entry.context,
           horovod_global.current_nccl_stream,
           [&]() { timeline.ActivityStartAll(entries, INIT_FUSION_BUFFER); },
-          [&]() { timeline.ActivityEndAll(entries); });
+          [&]() { timeline.ActivityEndAll(entries); }, allocate);
       if (!status.ok()) {
         LOG(DEBUG, horovod_global.global_controller->GetRank()) << "InitializeBuffer Failed";
         for (auto& e : entries) {
           timeline.End(e.tensor_name, nullptr);
           e.FinishWithCallback(status);
         }
-        return;
+        return false;
+      }
+    }
+  }
+
+  // Ops may be enqueued without an output, which the allreduce then places
+  // in its own memory. Other operations get it allocated by the framework.
+  if ((response.response_type() == Response::ALLREDUCE &&
+       (grouped || !op_manager->AdoptsAllreduceOutputs(entries, response))) ||
+      response.response_type() == Response::ADASUM) {
+    for (auto& e : entries) {
+      if (e.output != nullptr) {
+        continue;
+      }
+      Status status = e.context->AllocateOutput(e.tensor->shape(), &e.output);
+      if (!status.ok()) {
+        for (auto& entry : entries) {
+          timeline.End(entry.tensor_name, nullptr);
+          entry.FinishWithCallback(status);
+        }
+        return false;
       }
     }
   }
+  return true;
+}
+
+// Finishes the entries of a response performed with status, unless the
+// operation completes them later.
+void FinishOperation(const Response& response,
+                     std::vector<TensorTableEntry>& entries,
+                     const Status& status,
+                     std::chrono::steady_clock::time_point start) {
+  if (!status.in_progress()) {
+    for (auto& e : entries) {
+      horovod_global.timeline.End(e.tensor_name,
+                                  status.ok() ? e.output : nullptr);
+      e.FinishWithCallback(status);
+    }
+    if (response.response_type() == Response::JOIN && status.ok()) {
+      horovod_global.metrics.AddOperation(Response::JOIN, 0, start);
+    }
+  }
+}
+
+// Process a Response by doing a reduction, a gather, a broadcast, or
+// raising an error.
+void PerformOperation(const Response& response, ProcessSet& process_set) {
+  std::vector<TensorTableEntry> entries;
+  auto start = std::chrono::steady_clock::now();
+  if (!PrepareOperation(response, process_set, entries, start, false)) {
+    return;
+  }
 
   Status status;
   try {
@@ -296,20 +516,64 @@ void PerformOperation(Response response, ProcessSet& process_set) {
     LOG(DEBUG, horovod_global.global_controller->GetRank()) << "ExecuteOperation Failed";
     status = Status::UnknownError(ex.what());
   }
+  FinishOperation(response, entries, status, start);
+}
 
-  if (!status.in_progress()) {
-    for (auto& e : entries) {
-      timeline.End(e.tensor_name, status.ok() ? e.output : nullptr);
-      e.FinishWithCallback(status);
+// Performs allreduce responses as one launch if the op executing them
+// supports it, or else one after the other.
+void PerformAllreduces(const std::vector<Response>& responses,
+                       ProcessSet& process_set) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<Response> prepared;
+  std::vector<std::vector<TensorTableEntry>> entries_list;
+  for (auto& response : responses) {
+    std::vector<TensorTableEntry> entries;
+    if (PrepareOperation(response, process_set, entries, start, true)) {
+      prepared.push_back(response);
+      entries_list.push_back(std::move(entries));
+    }
+  }
+
+  if (prepared.size() > 1 &&
+      op_manager->GroupsAllreduces(entries_list, prepared)) {
+    Status status;
+    try {
+      status = op_manager->ExecuteAllreduceGroup(entries_list, prepared);
+    } catch (const std::exception& ex) {
+      LOG(DEBUG, horovod_global.global_controller->GetRank()) << "ExecuteAllreduceGroup Failed";
+      status = Status::UnknownError(ex.what());
+    }
+    for (size_t i = 0; i < prepared.size(); ++i) {
+      FinishOperation(prepared[i], entries_list[i], status, start);
     }
+    return;
   }
+
+  for (size_t i = 0; i < prepared.size(); ++i) {
+    Status status;
+    try {
+      status = op_manager->ExecuteOperation(entries_list[i], prepared[i],
+                                            process_set);
+    } catch (const std::exception& ex) {
+      LOG(DEBUG, horovod_global.global_controller->GetRank()) << "ExecuteOperation Failed";
+      status = Status::UnknownError(ex.what());
+    }
+    FinishOperation(prepared[i], entries_list[i], status, start);
+  }
+}
+
+// The global process set uses the ParameterManager of the global state.
+ParameterManager& ProcessSetParameterManager(ProcessSet& process_set) {
+  return process_set.parameter_manager != nullptr
+             ? *process_set.parameter_manager
+             : horovod_global.parameter_manager;
 }
 
 #if HAVE_MPI
 void EnrichProcessSetWithMPIController(ProcessSet& process_set) {
   process_set.controller.reset(new MPIController(
       process_set.response_cache, process_set.tensor_queue,
-      horovod_global.timeline, horovod_global.parameter_manager,
+      horovod_global.timeline, ProcessSetParameterManager(process_set),
       process_set.group_table, horovod_global.timeline_controller,
       process_set.mpi_context));
 }
@@ -319,7 +583,7 @@ void EnrichProcessSetWithMPIController(ProcessSet& process_set) {
 void EnrichProcessSetWithGlooController(ProcessSet& process_set) {
   process_set.controller.reset(new GlooController(
       process_set.response_cache, process_set.tensor_queue,
-      horovod_global.timeline, horovod_global.parameter_manager,
+      horovod_global.timeline, ProcessSetParameterManager(process_set),
       process_set.group_table, horovod_global.timeline_controller,
       process_set.gloo_context));
 }
@@ -338,6 +602,8 @@ ProcessSet& GetProcessSetOrAddUnitialized(std::vector<int> ranks, int& id) {
   }
   id = horovod_global.process_set_table.RegisterProcessSet(std::move(ranks));
   auto& process_set = horovod_global.process_set_table.Get(id);
+  // Configured by the background thread before its first cycle.
+  process_set.parameter_manager.reset(new ParameterManager());
 #if HAVE_MPI
   if (horovod_global.control_operation == LibType::MPI) {
     EnrichProcessSetWithMPIController(process_set);
@@ -353,6 +619,8 @@ ProcessSet& GetProcessSetOrAddUnitialized(std::vector<int> ranks, int& id) {
   process_set.response_cache.set_capacity(
       (int)horovod_global.parameter_manager.CacheEnabled() *
       horovod_global.cache_capacity);
+  process_set.response_cache.set_max_capacity(
+      horovod_global.cache_max_capacity);
   return process_set;
 }
 
@@ -398,6 +666,13 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
   if (global_mpi_context.IsEnabled()) {
     global_mpi_context.Initialize(mpi_ctx_manager);
     if (state.control_operation == LibType::MPI) {
+      // With pipelining, negotiation runs alongside the operations and needs
+      // communicators of its own.
+      int provided;
+      MPI_Query_thread(&provided);
+      global_mpi_context.separate_control_comms =
+          provided == MPI_THREAD_MULTIPLE &&
+          GetIntEnvOrDefault(HOROVOD_PIPELINE_DEPTH, 0) > 0;
       // Initializes global controller
       state.process_set_table.Initialize(global_mpi_context);
     }
@@ -428,41 +703,172 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
   int local_size = state.global_controller->GetLocalSize();
   int local_rank = state.global_controller->GetLocalRank();
 
-  // Set background thread affinity
-  parse_and_set_affinity(std::getenv(HOROVOD_THREAD_AFFINITY), local_size, local_rank);
+  // Set background thread affinity. With "auto", it runs and stages data
+  // next to the NIC of this rank.
+  auto topology = DiscoverHostTopology();
+  auto horovod_thread_affinity = std::getenv(HOROVOD_THREAD_AFFINITY);
+  int affinity_node = -1;
+  if (horovod_thread_affinity != nullptr &&
+      std::strcmp(horovod_thread_affinity, "auto") == 0) {
+    int core = PickThreadCore(topology, local_rank);
+    if (core >= 0) {
+      set_affinity(core);
+    } else {
+      LOG(WARNING) << "Could not discover the host topology for "
+                   << HOROVOD_THREAD_AFFINITY << "=auto.";
+    }
+    affinity_node = NicNumaNode(topology, local_rank);
+  } else {
+    int core = parse_and_set_affinity(horovod_thread_affinity, local_size,
+                                      local_rank);
+    if (core >= 0) {
+      affinity_node = NumaNodeOfCpu(topology, core);
+    }
+  }
+  if (affinity_node >= 0) {
+    // The helper threads share the NUMA node of the background thread, and
+    // all of them, the background thread included, first-touch the host
+    // buffers they allocate there.
+    SetHelperThreadPlacement(AllowedNodeCpus(topology, affinity_node),
+                             affinity_node);
+    PreferNumaNode(affinity_node);
+#if HAVE_GPU
+    gpu_context.host_buffer_numa_node = affinity_node;
+#endif
+  }
+
+  // Find the ranks next to a NIC. All ranks take part, whatever their
+  // affinity.
+  std::vector<int64_t> near_nic;
+  state.global_controller->AllgatherInt64s({RunsNextToNic(topology) ? 1 : 0},
+                                           near_nic);
+  state.near_nic_ranks.assign(near_nic.begin(), near_nic.end());
 
 #if HAVE_GPU
-  // Set number of GPU streams to use
+  // Set number of GPU streams to use. If it is not set, the autotuner picks
+  // how many of MAX_TUNED_NCCL_STREAMS streams are used.
   auto horovod_num_nccl_streams =
       std::getenv(HOROVOD_NUM_NCCL_STREAMS);
   if (horovod_num_nccl_streams != nullptr &&
       std::stol(horovod_num_nccl_streams, nullptr, 10) > 0) {
     state.num_nccl_streams = std::atoi(horovod_num_nccl_streams);
+    state.parameter_manager.SetNumNcclStreams(state.num_nccl_streams, true);
+  } else if (GetBoolEnvOrDefault(HOROVOD_AUTOTUNE, false)) {
+    state.num_nccl_streams = ParameterManager::MAX_TUNED_NCCL_STREAMS;
+  } else {
+    state.parameter_manager.SetNumNcclStreams(state.num_nccl_streams, true);
+  }
+
+  // Place GPU responses on the least loaded stream rather than round-robin
+  state.balance_nccl_streams =
+      GetBoolEnvOrDefault(HOROVOD_BALANCE_NCCL_STREAMS, false);
+
+  // Take fusion and staging buffers from a stream-ordered pool
+  gpu_context.memory_pool = GetBoolEnvOrDefault(HOROVOD_GPU_MEMORY_POOL, false);
+
+  // Replay repeated NCCL allreduces from CUDA graphs
+  state.cuda_graphs = GetBoolEnvOrDefault(HOROVOD_CUDA_GRAPHS, false);
+
+  // Launch consecutive GPU allreduces of a cycle as one NCCL group
+  state.group_nccl_responses =
+      GetBoolEnvOrDefault(HOROVOD_NCCL_GROUP_RESPONSES, false);
+
+  // Priority of Horovod's streams: "high" by default, "normal" for the
+  // priority of compute streams, or a number within the device's range.
+  auto horovod_gpu_stream_priority = std::getenv(HOROVOD_GPU_STREAM_PRIORITY);
+  if (horovod_gpu_stream_priority != nullptr) {
+    std::string priority = horovod_gpu_stream_priority;
+    if (priority == "normal") {
+      gpu_context.stream_priority = 0;
+    } else if (priority != "high") {
+      try {
+        gpu_context.stream_priority = std::stoi(priority);
+      } catch (const std::exception&) {
+        LOG(WARNING) << "Ignoring " << HOROVOD_GPU_STREAM_PRIORITY << "="
+                     << priority << ", expected high, normal or a number.";
+      }
+    }
   }
 
 #if HAVE_NCCL
   nccl_context.nccl_comms.resize(state.num_nccl_streams);
+  // Limit the SMs NCCL kernels take from compute
+  nccl_context.max_ctas = GetIntEnvOrDefault(HOROVOD_NCCL_MAX_CTAS, 0);
 #endif
   gpu_context.streams.resize(state.num_nccl_streams);
 
   // Create finalizer thread pool (one thread per stream)
   gpu_context.finalizer_thread_pool.create(state.num_nccl_streams);
+
+  // Optionally poll the events of all responses from a single thread
+  state.gpu_completion_engine =
+      GetBoolEnvOrDefault(HOROVOD_GPU_COMPLETION_ENGINE, false);
+  if (state.gpu_completion_engine) {
+    gpu_context.StartCompletionEngine();
+  }
+
+  // Let frameworks leave GPU allreduce outputs to Horovod
+  state.pooled_outputs = GetBoolEnvOrDefault(HOROVOD_POOLED_OUTPUTS, false);
+#else
+  // No GPU streams to spread responses over
+  state.parameter_manager.SetNumNcclStreams(1, true);
+#endif
+
+  // Create CPU thread pool for large CPU buffers, disabled by default
+  state.cpu_thread_pool.create(GetIntEnvOrDefault(HOROVOD_NUM_CPU_THREADS, 1));
+#if HAVE_MPI
+  SetHalfSumThreadPool(&state.cpu_thread_pool);
+
+  // Sum CPU MPI allreduces with Horovod's SIMD kernels
+  state.mpi_cpu_sum_kernels =
+      GetBoolEnvOrDefault(HOROVOD_MPI_CPU_SUM_KERNELS, true);
+  state.shm_allreduce = GetBoolEnvOrDefault(HOROVOD_SHM_ALLREDUCE, false);
 #endif
+  state.cpu_fp32_accumulation =
+      GetBoolEnvOrDefault(HOROVOD_CPU_FP32_ACCUMULATION, false);
+  LOG(DEBUG) << "CPU reduction kernels use "
+             << CPUKernelISAName(GetCPUKernelISA()) << ".";
 
 #if HAVE_NVTX
   if (GetBoolEnvOrDefault(HOROVOD_DISABLE_NVTX_RANGES, false)) {
     NvtxOpRange::nvtx_ops_handle.Disable();
+    NvtxPhaseRange::nvtx_phases_handle.Disable();
     horovod_global.timeline.DisableNvtx();
   }
 #endif // HAVE_NVTX
 
-  // Open the timeline file on coordinator.
+  // Open the timeline file on coordinator, or on every rank with
+  // HOROVOD_TIMELINE_ALL_RANKS.
   bool should_enable_timeline = false;
   auto timeline_env = std::getenv(HOROVOD_TIMELINE);
   if (timeline_env) {
-    if (is_coordinator) {
+    SetBoolFromEnv(HOROVOD_TIMELINE_ALL_RANKS, state.timeline_all_ranks, true);
+    if (state.timeline_all_ranks) {
+      // Timestamps are relative to the end of this barrier on every rank,
+      // which aligns the timelines of different hosts.
+      state.global_controller->Barrier(Communicator::GLOBAL);
+      if (!is_coordinator) {
+        state.timeline.DisableNegotiation();
+      }
+    }
+    if (is_coordinator || state.timeline_all_ranks) {
+      auto timeline_format = std::getenv(HOROVOD_TIMELINE_FORMAT);
+      if (timeline_format != nullptr &&
+          std::string(timeline_format) == "binary") {
+        state.timeline.SetFormat(TimelineFormat::BINARY);
+      } else if (timeline_format != nullptr &&
+                 std::string(timeline_format) != "json") {
+        LOG(WARNING) << "Unknown " << HOROVOD_TIMELINE_FORMAT << " "
+                     << timeline_format << ", writing a JSON timeline.";
+      }
+      state.timeline.SetSampleCycles(static_cast<unsigned int>(std::max(
+          GetIntEnvOrDefault(HOROVOD_TIMELINE_SAMPLE_CYCLES, 1), 1)));
       auto horovod_timeline = std::string(timeline_env);
       if (horovod_timeline != "DYNAMIC") {
+        if (state.timeline_all_ranks) {
+          horovod_timeline = RankTimelineFile(
+              horovod_timeline, state.global_controller->GetRank());
+        }
         state.timeline.Initialize(horovod_timeline,
                                   static_cast<unsigned int>(size));
       } else {
@@ -492,6 +898,39 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
     state.parameter_manager.SetTensorFusionThresholdBytes(threshold, true);
   }
 
+  // Fuse the reductions of large tensors separately, with a threshold of
+  // their own that is only tuned if they are.
+  auto horovod_fusion_large_tensor_size =
+      std::getenv(HOROVOD_FUSION_LARGE_TENSOR_SIZE);
+  if (horovod_fusion_large_tensor_size != nullptr) {
+    state.fusion_large_tensor_size =
+        std::strtoll(horovod_fusion_large_tensor_size, nullptr, 10);
+  }
+  auto horovod_fusion_threshold_large =
+      std::getenv(HOROVOD_FUSION_THRESHOLD_LARGE);
+  if (horovod_fusion_threshold_large != nullptr) {
+    state.parameter_manager.SetLargeTensorFusionThresholdBytes(
+        std::strtoll(horovod_fusion_threshold_large, nullptr, 10), true);
+  } else if (state.fusion_large_tensor_size <= 0) {
+    state.parameter_manager.SetLargeTensorFusionThresholdBytes(
+        state.parameter_manager.LargeTensorFusionThresholdBytes(), true);
+  }
+
+  // Reduce large tensors without going through the fusion buffer
+  auto horovod_zero_copy_threshold = std::getenv(HOROVOD_ZERO_COPY_THRESHOLD);
+  if (horovod_zero_copy_threshold != nullptr) {
+    state.zero_copy_threshold =
+        std::strtoll(horovod_zero_copy_threshold, nullptr, 10);
+  }
+
+  // Split large allreduces into parts that are scheduled independently
+  auto horovod_tensor_partition_size =
+      std::getenv(HOROVOD_TENSOR_PARTITION_SIZE);
+  if (horovod_tensor_partition_size != nullptr) {
+    state.tensor_partition_size =
+        std::strtoll(horovod_tensor_partition_size, nullptr, 10);
+  }
+
   // Override the cycle time.
   state.parameter_manager.SetCycleTimeMs(1);
   auto horovod_cycle_time = std::getenv(HOROVOD_CYCLE_TIME);
@@ -500,6 +939,13 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
         std::strtof(horovod_cycle_time, nullptr), true);
   }
 
+  // Wake up the background thread as soon as tensors are enqueued instead of
+  // sleeping for the full cycle time.
+  SetBoolFromEnv(HOROVOD_EVENT_DRIVEN_LOOP, state.event_driven_loop, true);
+  if (state.event_driven_loop) {
+    state.process_set_table.SetWakeupSignal(&state.wakeup_signal);
+  }
+
   // Override response cache capacity, if it's set.
   state.parameter_manager.SetCacheEnabled(true);
   auto horovod_cache_capacity = std::getenv(HOROVOD_CACHE_CAPACITY);
@@ -508,8 +954,16 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
     state.cache_capacity = cache_capacity;
     state.parameter_manager.SetCacheEnabled(cache_capacity > 0, true);
   }
+  auto horovod_cache_max_capacity = std::getenv(HOROVOD_CACHE_MAX_CAPACITY);
+  if (horovod_cache_max_capacity != nullptr) {
+    state.cache_max_capacity =
+        std::strtol(horovod_cache_max_capacity, nullptr, 10);
+  }
   state.process_set_table.Get(0).response_cache.set_capacity(
       (int)state.parameter_manager.CacheEnabled() * state.cache_capacity);
+  state.process_set_table.Get(0).response_cache.set_max_capacity(
+      state.cache_max_capacity);
+  SetIntFromEnv(HOROVOD_FROZEN_SCHEDULE_STEPS, state.frozen_schedule_steps);
 
   // Set flag for hierarchical allgather. Ignore if Horovod is running on a
   // single node.
@@ -531,10 +985,21 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
                  (size != local_size);
     state.parameter_manager.SetHierarchicalAllreduce(value, true);
   }
+  // Set flag for hierarchical alltoall. Ignore if Horovod is running on a
+  // single node.
+  auto horovod_hierarchical_alltoall =
+      std::getenv(HOROVOD_HIERARCHICAL_ALLTOALL);
+  if (horovod_hierarchical_alltoall != nullptr) {
+    bool value = std::strtol(horovod_hierarchical_alltoall, nullptr, 10) > 0 &&
+                 (size != local_size);
+    state.parameter_manager.SetHierarchicalAlltoall(value);
+  }
 
 #if HOROVOD_GPU_ALLREDUCE != 'N' && HOROVOD_GPU_ALLREDUCE != 'D'
-  // Hierarchical allreduce is not supported without NCCL or DDL
-  state.parameter_manager.SetHierarchicalAllreduce(false, true);
+  // Hierarchical allreduce is not supported without NCCL, DDL or Gloo
+  if (state.cpu_operation != LibType::GLOO) {
+    state.parameter_manager.SetHierarchicalAllreduce(false, true);
+  }
 #endif
 
   // Issue warning if hierarchical allreduce is enabled in heterogeneous cluster
@@ -553,10 +1018,17 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
   // Set flag to control use of batched memcopy kernel on GPU
   auto horovod_batch_d2d_memcopies =
       std::getenv(HOROVOD_BATCH_D2D_MEMCOPIES);
-  if (horovod_batch_d2d_memcopies != nullptr &&
-      std::strtol(horovod_batch_d2d_memcopies, nullptr, 10) == 0) {
-    state.batch_d2d_memcopies = false;
+  if (horovod_batch_d2d_memcopies != nullptr) {
+    state.parameter_manager.SetBatchD2DMemcopies(
+        std::strtol(horovod_batch_d2d_memcopies, nullptr, 10) != 0, true);
   }
+#if !HAVE_CUDA
+  // The batched memcopy kernel only exists for CUDA, nothing to tune
+  state.parameter_manager.SetBatchD2DMemcopies(true, true);
+#endif
+
+  // Check if fused GPU allreduce data should be compressed
+  state.fusion_compression = ParseFusionCompressionFromEnv();
 
   // Check if group fusion should be disabled
   SetBoolFromEnv(HOROVOD_DISABLE_GROUP_FUSION, state.disable_group_fusion, true);
@@ -564,7 +1036,9 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
   // Check if async completion should be enabled
   SetBoolFromEnv(HOROVOD_ENABLE_ASYNC_COMPLETION, state.enable_async_completion, true);
 
-  // Enable auto-tuning.
+  // Enable auto-tuning. Results only carry over to runs with the same
+  // process layout.
+  std::string autotune_topology;
   auto horovod_autotune = std::getenv(HOROVOD_AUTOTUNE);
   if (horovod_autotune != nullptr &&
       std::strtol(horovod_autotune, nullptr, 10) > 0) {
@@ -573,20 +1047,200 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
         state.global_controller->GetRank(), RANK_ZERO,
         horovod_autotune_log != nullptr ? std::string(horovod_autotune_log)
                                         : "");
+    std::stringstream topology;
+    topology << "np" << size << "_local" << local_size << "_cross"
+             << state.global_controller->GetCrossSize();
+    autotune_topology = topology.str();
+    auto horovod_autotune_cache = std::getenv(HOROVOD_AUTOTUNE_CACHE);
+    if (horovod_autotune_cache != nullptr) {
+      state.parameter_manager.InitializeCache(horovod_autotune_cache,
+                                              autotune_topology);
+    }
     state.parameter_manager.SetAutoTuning(true);
   }
 
-  // Set chunk size for MPI based Adasum allreduce algorithms
+  // Pick up what an elastic reset kept. Processes that joined with the reset
+  // kept nothing, so all processes agree on what to reuse first.
+  if (state.elastic_enabled) {
+    int64_t uid = 0;
+    bool comm_error = false;
+#if HAVE_NCCL
+    uid = (int64_t)nccl_context.uid;
+    comm_error = nccl_context.comm_error;
+#endif
+    bool kept_params = !autotune_topology.empty() &&
+                       state.kept_params_topology == autotune_topology;
+    std::vector<int64_t> values;
+    state.global_controller->AllgatherInt64s(
+        {uid, comm_error ? 1 : 0, kept_params ? 1 : 0}, values);
+
+    std::vector<uint64_t> rank_uids(size);
+    int params_root = -1;
+    for (int i = 0; i < size; ++i) {
+      rank_uids[i] = (uint64_t)values[3 * i];
+      comm_error = comm_error || values[3 * i + 1] != 0;
+      if (params_root < 0 && values[3 * i + 2] != 0) {
+        params_root = i;
+      }
+    }
+#if HAVE_NCCL
+    nccl_context.AttachComms(std::move(rank_uids), comm_error);
+#endif
+    if (params_root >= 0) {
+      auto params = state.kept_params;
+      state.global_controller->Bcast(&params, sizeof(params), params_root,
+                                     Communicator::GLOBAL);
+      state.parameter_manager.SetParams(params);
+      LOG(INFO, state.global_controller->GetRank())
+          << "Reusing the parameters tuned before the elastic reset.";
+    }
+  }
+  state.kept_params_topology.clear();
+
+  // Set chunk size for MPI based Adasum allreduce algorithms. Only tuned on
+  // request, since most jobs never run Adasum.
   auto horovod_adasum_mpi_chunk_size = std::getenv(HOROVOD_ADASUM_MPI_CHUNK_SIZE);
   if (horovod_adasum_mpi_chunk_size != nullptr) {
-    state.adasum_mpi_chunk_size = std::strtol(horovod_adasum_mpi_chunk_size, nullptr, 10);
+    state.parameter_manager.SetAdasumMPIChunkSize(
+        std::strtoll(horovod_adasum_mpi_chunk_size, nullptr, 10), true);
+  } else if (!GetBoolEnvOrDefault(HOROVOD_AUTOTUNE_ADASUM, false)) {
+    state.parameter_manager.SetAdasumMPIChunkSize(
+        state.parameter_manager.AdasumMPIChunkSize(), true);
+  }
+
+  // Set the sizes below which Gloo allreduces use bcube and halving-doubling
+  // instead of ring. Only tuned when Gloo runs the CPU collectives.
+  auto horovod_gloo_bcube_threshold = std::getenv(HOROVOD_GLOO_BCUBE_THRESHOLD);
+  if (horovod_gloo_bcube_threshold != nullptr) {
+    state.parameter_manager.SetGlooBcubeThreshold(
+        std::strtoll(horovod_gloo_bcube_threshold, nullptr, 10), true);
+  } else if (state.cpu_operation != LibType::GLOO) {
+    state.parameter_manager.SetGlooBcubeThreshold(
+        state.parameter_manager.GlooBcubeThreshold(), true);
+  }
+  auto horovod_gloo_halving_doubling_threshold =
+      std::getenv(HOROVOD_GLOO_HALVING_DOUBLING_THRESHOLD);
+  if (horovod_gloo_halving_doubling_threshold != nullptr) {
+    state.parameter_manager.SetGlooHalvingDoublingThreshold(
+        std::strtoll(horovod_gloo_halving_doubling_threshold, nullptr, 10),
+        true);
+  } else if (state.cpu_operation != LibType::GLOO) {
+    state.parameter_manager.SetGlooHalvingDoublingThreshold(
+        state.parameter_manager.GlooHalvingDoublingThreshold(), true);
+  }
+
+  // Keep GPU Adasum data on the device, requires CUDA-aware MPI
+  state.adasum_gpu_direct = GetBoolEnvOrDefault(HOROVOD_ADASUM_GPU_DIRECT, false);
+
+  // Set chunk size for pipelining NCCL hierarchical allreduce
+  auto horovod_hierarchical_allreduce_chunk_size =
+      std::getenv(HOROVOD_HIERARCHICAL_ALLREDUCE_CHUNK_SIZE);
+  if (horovod_hierarchical_allreduce_chunk_size != nullptr) {
+    state.hierarchical_allreduce_chunk_size =
+        std::strtol(horovod_hierarchical_allreduce_chunk_size, nullptr, 10);
+  }
+  state.hierarchical_allreduce_compression =
+      ParseHierarchicalAllreduceCompressionFromEnv();
+
+  // Set chunk size for pipelining GPU allreduce over CUDA-aware MPI
+  auto horovod_mpi_gpu_allreduce_chunk_size =
+      std::getenv(HOROVOD_MPI_GPU_ALLREDUCE_CHUNK_SIZE);
+  if (horovod_mpi_gpu_allreduce_chunk_size != nullptr) {
+    state.mpi_gpu_allreduce_chunk_size =
+        std::strtol(horovod_mpi_gpu_allreduce_chunk_size, nullptr, 10);
+  }
+
+  // Set the sizes from which MPI broadcasts use a pipelined tree or a
+  // scatter and allgather
+  auto horovod_broadcast_tree_threshold =
+      std::getenv(HOROVOD_BROADCAST_TREE_THRESHOLD);
+  if (horovod_broadcast_tree_threshold != nullptr) {
+    state.broadcast_tree_threshold =
+        std::strtol(horovod_broadcast_tree_threshold, nullptr, 10);
+  }
+  auto horovod_broadcast_chunk_size = std::getenv(HOROVOD_BROADCAST_CHUNK_SIZE);
+  if (horovod_broadcast_chunk_size != nullptr &&
+      std::strtol(horovod_broadcast_chunk_size, nullptr, 10) > 0) {
+    state.broadcast_chunk_size =
+        std::strtol(horovod_broadcast_chunk_size, nullptr, 10);
+  }
+  auto horovod_broadcast_scatter_allgather_threshold =
+      std::getenv(HOROVOD_BROADCAST_SCATTER_ALLGATHER_THRESHOLD);
+  if (horovod_broadcast_scatter_allgather_threshold != nullptr) {
+    state.broadcast_scatter_allgather_threshold = std::strtol(
+        horovod_broadcast_scatter_allgather_threshold, nullptr, 10);
   }
 
   op_manager.reset(CreateOperationManager(state));
 
+#if HAVE_MPI
+  if (state.control_operation == LibType::MPI) {
+    mpi_peer_operations.reset(new MPIPeerOperations(
+        &state.process_set_table.Get(0).mpi_context));
+  }
+#endif
+
   state.dynamic_process_sets =
       GetBoolEnvOrDefault(HOROVOD_DYNAMIC_PROCESS_SETS, false);
 
+  // Optionally run the cycles of non-global process sets on their own threads
+  state.num_process_set_threads =
+      std::max(GetIntEnvOrDefault(HOROVOD_PROCESS_SET_THREADS, 0), 0);
+#if HAVE_MPI
+  int mpi_thread_level = MPI_THREAD_MULTIPLE;
+  if (global_mpi_context.IsEnabled()) {
+    MPI_Query_thread(&mpi_thread_level);
+  }
+  if (state.num_process_set_threads > 0 &&
+      mpi_thread_level < MPI_THREAD_MULTIPLE) {
+    LOG(WARNING, state.global_controller->GetRank())
+        << HOROVOD_PROCESS_SET_THREADS
+        << " requires MPI with multi-threading support "
+           "(MPI_THREAD_MULTIPLE), process sets will run one after another.";
+    state.num_process_set_threads = 0;
+  }
+  // Optionally negotiate the next cycles while an executor thread performs
+  // the previous ones.
+  state.pipeline_depth =
+      std::max(GetIntEnvOrDefault(HOROVOD_PIPELINE_DEPTH, 0), 0);
+  if (state.pipeline_depth > 0) {
+    std::string reason;
+    if (state.control_operation != LibType::MPI) {
+      reason = "requires the MPI controller";
+    } else if (mpi_thread_level < MPI_THREAD_MULTIPLE) {
+      reason = "requires MPI with multi-threading support "
+               "(MPI_THREAD_MULTIPLE)";
+    } else if (state.num_process_set_threads > 0) {
+      reason = "cannot be combined with " +
+               std::string(HOROVOD_PROCESS_SET_THREADS);
+    } else if (state.parameter_manager.IsAutoTuning()) {
+      reason = "cannot be combined with autotuning";
+    }
+    if (!reason.empty()) {
+      LOG(WARNING, state.global_controller->GetRank())
+          << HOROVOD_PIPELINE_DEPTH << " " << reason
+          << ", cycles will be performed as they are negotiated.";
+      state.pipeline_depth = 0;
+    }
+  }
+  state.buffer_idle_timeout = std::chrono::seconds(
+      std::max(GetIntEnvOrDefault(HOROVOD_BUFFER_IDLE_TIMEOUT, 0), 0));
+  state.last_tensor_time = std::chrono::steady_clock::now();
+  // Collectives of process sets running on their own threads would be
+  // posted and finished from several threads, so they stay blocking then.
+  if (state.cpu_operation == LibType::MPI &&
+      state.num_process_set_threads == 0) {
+    mpi_collectives.Initialize(
+        std::max(GetIntEnvOrDefault(HOROVOD_MPI_MAX_OUTSTANDING, 2), 0));
+  }
+#endif // HAVE_MPI
+  if (state.num_process_set_threads > 0) {
+    state.process_set_thread_pool.create(state.num_process_set_threads);
+  }
+  if (state.pipeline_depth > 0) {
+    state.executor_thread_pool.create(1);
+  }
+
   // Register and initialize any non-global process set requested during Horovod
   // initialization.
   try {
@@ -636,16 +1290,64 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
   }
 
 shutdown:
+  // Let the executor thread perform the cycles negotiated before shutdown.
+  for (auto& cycle : state.pending_cycles) {
+    cycle.wait();
+  }
+  state.pending_cycles.clear();
+  state.executor_thread_pool.reset();
+
   // Finalize all contexts
 #if HAVE_NCCL
-  nccl_context.ShutDown();
+  if (state.keep_state) {
+    nccl_context.DetachComms();
+  } else {
+    nccl_context.ShutDown();
+  }
 #endif
 
+  if (state.keep_state && !autotune_topology.empty() &&
+      !state.parameter_manager.IsAutoTuning()) {
+    state.kept_params = state.parameter_manager.GetParams();
+    state.kept_params_topology = autotune_topology;
+  }
+
   LOG(DEBUG, horovod_global.global_controller->GetRank())
       << "Shutting down background thread";
 
   // Signal that shutdown has been requested.
   state.shut_down = true;
+  {
+    // Release and memory usage requests will not be served anymore.
+    std::lock_guard<std::mutex> guard(state.memory_requests_mutex);
+    state.memory_requests_served = state.memory_requests_issued;
+  }
+  state.memory_requests_cond.notify_all();
+  // Nor will process sets be added or removed.
+  state.process_set_table.NotifyWaiters();
+
+  // Fail the sends and receives that have not completed.
+  for (auto& operation : state.peer_queue.TakeAll()) {
+    operation.entry.FinishWithCallback(SHUT_DOWN_ERROR);
+  }
+#if HAVE_MPI
+  if (mpi_peer_operations) {
+    mpi_peer_operations->Abort(SHUT_DOWN_ERROR);
+    mpi_peer_operations.reset();
+  }
+  // Collectives cannot be cancelled, every rank posted them so they
+  // complete.
+  mpi_collectives.Drain();
+#endif
+
+  // Fail the allreduces still held back by incomplete buckets. The buckets
+  // themselves survive a reset that keeps state.
+  for (auto& allreduce : state.bucket_table.TakeAll()) {
+    allreduce.callback(SHUT_DOWN_ERROR);
+  }
+  if (!state.keep_state) {
+    state.bucket_table.Clear();
+  }
 
   // For each process set: Notify all outstanding operations that Horovod has
   // been shut down, finalize tensor queue and communicators.
@@ -664,8 +1366,15 @@ shutdown:
   }
 #endif // HAVE_GLOO
 
+#if HAVE_MPI
+  SetHalfSumThreadPool(nullptr);
+#endif
+  state.cpu_thread_pool.reset();
+  state.process_set_thread_pool.reset();
+
 #if HAVE_GPU
-  gpu_context.Finalize();
+  gpu_accumulator.Reset();
+  gpu_context.Finalize(state.keep_state);
 #endif
 
 #if HAVE_GLOO
@@ -684,123 +1393,562 @@ shutdown:
 
 }
 
-bool RunLoopOnce(HorovodGlobalState& state) {
-  // This delay determines thread frequency and communication message latency
-  auto start_time = std::chrono::steady_clock::now();
-  auto sleep_duration = state.last_cycle_start +
-                        std::chrono::microseconds(long(
-                            state.parameter_manager.CycleTimeMs() * 1000.)) -
-                        start_time;
-  if (sleep_duration > std::chrono::steady_clock::duration::zero()) {
-    std::this_thread::sleep_for(sleep_duration);
+// CPU operations executed by MPI or Gloo only touch the communicators and
+// fusion buffers of their own process set, so those of different process sets
+// may run at the same time. Everything else shares GPU streams, op contexts or
+// library state and runs on the background thread after the other process
+// sets.
+bool CanRunConcurrently(const Response& response) {
+  if (response.response_type() == Response::JOIN ||
+      response.response_type() == Response::ADASUM ||
+      horovod_global.cpu_operation == LibType::CCL ||
+      response.devices().empty()) {
+    return false;
   }
-  state.last_cycle_start = std::chrono::steady_clock::now();
-
-  if (state.mark_cycles_in_timeline) {
-    // Mark start of the new cycle.
-    state.timeline.MarkCycleStart();
+  for (auto device : response.devices()) {
+    if (device != CPU_DEVICE_ID) {
+      return false;
+    }
   }
+  return true;
+}
 
-  bool this_process_requested_shutdown = state.shut_down;
-
-  if (state.dynamic_process_sets) {
-    // Initialize any newly added process set that has been registered by all
-    // Horovod processes and remove a process set that has been marked for
-    // removal by all Horovod processes.
-#if HAVE_MPI
-    if (state.control_operation == LibType::MPI) {
-      state.process_set_table.InitializeRegisteredAndRemoveMarkedIfReady(
-          global_mpi_context);
+#if HAVE_GPU
+// Number of responses from first on that are GPU allreduces on the same
+// devices and together fit in the fusion buffer, so that they can be
+// launched as one NCCL group. At least one.
+size_t GroupableAllreduces(const std::vector<Response>& responses,
+                           size_t first, ProcessSet& process_set) {
+  auto groupable = [&](const Response& response) {
+    return response.response_type() == Response::ALLREDUCE &&
+           response.num_partitions() <= 1 && !response.devices().empty() &&
+           response.devices()[0] != CPU_DEVICE_ID &&
+           response.devices() == responses[first].devices();
+  };
+  if (process_set.joined) {
+    return 1;
+  }
+  int64_t threshold = process_set.controller->TensorFusionThresholdBytes();
+  int64_t bytes = 0;
+  size_t count = 0;
+  for (size_t i = first; i < responses.size() && groupable(responses[i]);
+       ++i) {
+    for (auto size : responses[i].tensor_sizes()) {
+      bytes += size * DataType_Size(responses[i].tensor_type());
     }
-#endif // HAVE_MPI
-#if HAVE_GLOO
-    if (state.control_operation == LibType::GLOO) {
-      state.process_set_table.InitializeRegisteredAndRemoveMarkedIfReady(
-          global_gloo_context);
+    if (bytes > threshold) {
+      break;
     }
-#endif // HAVE_GLOO
+    ++count;
   }
+  return std::max(count, (size_t)1);
+}
+#endif
 
-  bool should_shutdown = false;
-  for (auto process_set_id : state.process_set_table.Ids()) {
-    if (should_shutdown) {
-      break;
-    }
-    auto& process_set = state.process_set_table.Get(process_set_id);
-    if (!process_set.initialization_done) {
+// Performs the responses negotiated for one process set in a cycle. All nodes
+// in the process set should end up performing the same operations. If
+// deferred is given, the responses that cannot run concurrently with other
+// process sets are added to it instead, to be performed after them.
+void PerformResponses(HorovodGlobalState& state, ProcessSet& process_set,
+                      int32_t process_set_id,
+                      const ResponseList& response_list,
+                      ResponseList* deferred = nullptr) {
+  int global_rank = state.global_controller->GetRank();
+#if HAVE_GPU
+  bool balance_streams =
+      state.balance_nccl_streams &&
+      state.parameter_manager.NumNcclStreams() > 1;
+  if (balance_streams) {
+    DecayGPUStreamLoad(process_set);
+  }
+  int partition_stream = -1;
+#endif
+  auto& responses = response_list.responses();
+  for (size_t i = 0; i < responses.size(); ++i) {
+    auto& response = responses[i];
+    if (deferred != nullptr && !CanRunConcurrently(response)) {
+      deferred->add_response(response);
       continue;
     }
-    auto response_list =
-        process_set.IsCurrentProcessIncluded()
-            ? process_set.controller->ComputeResponseList(
-                  this_process_requested_shutdown, state, process_set)
-            : ResponseList();
-
-    if (process_set_id == 0) {
-      state.mark_cycles_in_timeline =
-          state.timeline_controller.MarkCyclesInTimelinePending();
+    if (!process_set.group_table.empty()) {
+      // Deregister any completed groups
+      process_set.group_table.DeregisterGroups(response.tensor_names());
     }
 
-    // Get tensor name and size data for autotuning. // TODO: extend for all process sets?
-    int64_t total_tensor_size = 0;
-    std::vector<std::string> tensor_names;
-    if (process_set_id == 0 && state.parameter_manager.IsAutoTuning()) {
-      total_tensor_size = process_set.tensor_queue.GetTensorDataForAutotuner(
-          response_list, tensor_names);
-    }
+    LOG(TRACE, global_rank) << "Process set id " << process_set_id;
+    LOG(TRACE, global_rank)
+        << "Performing " << response.tensor_names_string();
+    LOG(TRACE, global_rank)
+        << "Processing " << response.tensor_names().size() << " tensors";
 
-    // Perform the collective operation. All nodes in the process set should end
-    // up performing the same operation.
-    if (process_set.IsCurrentProcessIncluded()) {
-      int global_rank = state.global_controller->GetRank();
-      for (auto& response : response_list.responses()) {
+#if HAVE_GPU
+    // All parts of a partitioned tensor run on the stream of the first
+    // one, so that the event reported with the last part covers them.
+    if (response.num_partitions() > 1 && response.partition_offset() > 0 &&
+        partition_stream >= 0) {
+      state.current_nccl_stream = partition_stream;
+    } else if (balance_streams) {
+      AssignGPUStream(response, process_set);
+    }
+    partition_stream = state.current_nccl_stream;
+
+    // Allreduces that follow on the same devices join the launch of this
+    // one, and its stream.
+    size_t group_size = state.group_nccl_responses
+                            ? GroupableAllreduces(responses, i, process_set)
+                            : 1;
+    if (group_size > 1) {
+      std::vector<Response> group(responses.begin() + i,
+                                  responses.begin() + i + group_size);
+      for (size_t j = 1; j < group.size(); ++j) {
         if (!process_set.group_table.empty()) {
-          // Deregister any completed groups
-          process_set.group_table.DeregisterGroups(response.tensor_names());
+          process_set.group_table.DeregisterGroups(group[j].tensor_names());
         }
-
-        LOG(TRACE, global_rank) << "Process set id " << process_set_id;
         LOG(TRACE, global_rank)
-            << "Performing " << response.tensor_names_string();
-        LOG(TRACE, global_rank)
-            << "Processing " << response.tensor_names().size() << " tensors";
-        PerformOperation(response, process_set);
-        LOG(TRACE, global_rank)
-            << "Finished performing " << response.tensor_names_string();
+            << "Grouping " << group[j].tensor_names_string();
       }
+      PerformAllreduces(group, process_set);
+      i += group_size - 1;
+      LOG(TRACE, global_rank)
+          << "Finished performing " << group_size << " grouped responses";
+      continue;
+    }
+#endif
+    // CPU responses of CCL, and of MPI and Gloo with outstanding
+    // collectives, complete asynchronously. Each one in flight fuses into
+    // the host buffer of its own slot.
+    int host_slot = -1;
+    bool cpu_response = !response.devices().empty() &&
+                        response.devices()[0] == CPU_DEVICE_ID;
+#if HAVE_CCL
+    if (cpu_response && state.cpu_operation == LibType::CCL) {
+      host_slot = ccl_context.AcquireSlot();
+    }
+#endif
+#if HAVE_MPI
+    if (cpu_response && state.cpu_operation == LibType::MPI &&
+        mpi_collectives.Enabled()) {
+      host_slot = mpi_collectives.AcquireSlot();
+    }
+#endif
+#if HAVE_GLOO
+    if (cpu_response && state.cpu_operation == LibType::GLOO &&
+        process_set.gloo_context.workers != nullptr) {
+      host_slot = process_set.gloo_context.workers->AcquireSlot();
     }
+#endif
+    if (host_slot >= 0) {
+      process_set.fusion_buffer.SetHostSlot(host_slot);
+    }
+    PerformOperation(response, process_set);
+    if (host_slot >= 0) {
+      process_set.fusion_buffer.SetHostSlot(0);
+    }
+    LOG(TRACE, global_rank)
+        << "Finished performing " << response.tensor_names_string();
+  }
+}
+
+// Responses of one process set negotiated in a cycle.
+struct NegotiatedResponses {
+  ProcessSet* process_set;
+  int32_t process_set_id;
+  ResponseList response_list;
+};
 
-    if (process_set_id == 0 && state.parameter_manager.IsAutoTuning()) {
-      bool should_sync =
-          state.parameter_manager.Update(tensor_names, total_tensor_size);
+// Negotiates and performs the operations of one process set for the current
+// cycle. Returns true if shutdown was requested. Tensor names and size for the
+// autotuner are only returned for the global process set, the other process
+// sets are tuned here on their own. If negotiated is given, the responses are
+// added to it to be performed later instead. If deferred is given, the
+// responses that cannot run concurrently are added to it.
+bool RunProcessSetCycle(
+    HorovodGlobalState& state, ProcessSet& process_set, int32_t process_set_id,
+    bool this_process_requested_shutdown, int64_t& total_tensor_size,
+    std::vector<std::string>& tensor_names,
+    std::vector<NegotiatedResponses>* negotiated = nullptr,
+    ResponseList* deferred = nullptr) {
+  auto* parameter_manager = process_set.parameter_manager.get();
+  if (parameter_manager != nullptr && !parameter_manager->IsInitialized() &&
+      process_set.IsCurrentProcessIncluded()) {
+    parameter_manager->InitializeForProcessSet(
+        state.parameter_manager, process_set.controller->GetRank());
+  }
+
+  auto negotiation_start = std::chrono::steady_clock::now();
+  auto response_list =
+      process_set.IsCurrentProcessIncluded()
+          ? process_set.controller->ComputeResponseList(
+                this_process_requested_shutdown, state, process_set)
+          : ResponseList();
+  state.metrics.AddTimeSince(METRIC_NEGOTIATION_TIME_US, negotiation_start);
 
-      if (should_sync) {
-        process_set.controller->SynchronizeParameters();
-      }
+  if (process_set_id == 0) {
+    state.mark_cycles_in_timeline =
+        state.timeline_controller.MarkCyclesInTimelinePending();
+  }
+
+  // Get tensor name and size data for autotuning.
+  if (process_set_id == 0 && state.parameter_manager.IsAutoTuning()) {
+    total_tensor_size = process_set.tensor_queue.GetTensorDataForAutotuner(
+        response_list, tensor_names);
+  }
+  int64_t process_set_tensor_size = 0;
+  std::vector<std::string> process_set_tensor_names;
+  if (parameter_manager != nullptr && parameter_manager->IsAutoTuning()) {
+    process_set_tensor_size =
+        process_set.tensor_queue.GetTensorDataForAutotuner(
+            response_list, process_set_tensor_names);
+  }
+
+  if (process_set.IsCurrentProcessIncluded()) {
+    if (negotiated != nullptr) {
+      negotiated->push_back(
+          NegotiatedResponses{&process_set, process_set_id, response_list});
+    } else {
+      PerformResponses(state, process_set, process_set_id, response_list,
+                       deferred);
     }
+  }
 
-    should_shutdown |= response_list.shutdown();
+  if (parameter_manager != nullptr && parameter_manager->IsAutoTuning() &&
+      parameter_manager->Update(process_set_tensor_names,
+                                process_set_tensor_size)) {
+    process_set.controller->SynchronizeParameters();
   }
 
-  return !should_shutdown;
+  return response_list.shutdown();
 }
 
-// Start Horovod background thread. Ensure that this is
-// only done once no matter how many times this function is called.
-// Returns false if initialization failed, otherwise true.
-bool InitializeHorovodOnce(
-    const std::vector<int>& ranks,
-    const std::vector<std::vector<int>>& process_set_ranks) {
-  // Ensure background thread is only started once.
-  if (!horovod_global.initialize_flag.test_and_set()) {
-    horovod_global.control_operation = ParseControllerOpsFromEnv();
-    horovod_global.cpu_operation = ParseCPUOpsFromEnv();
-#if HAVE_MPI
-    // Enable mpi if it's used either in cpu data transfer or controller
-    if (horovod_global.cpu_operation == LibType::MPI ||
-        horovod_global.control_operation == LibType::MPI) {
-      global_mpi_context.Enable(ranks);
-    }
+// Waits until at most max_pending cycles are left to the executor thread.
+// Raises the error of the first cycle that failed.
+void WaitForPendingCycles(HorovodGlobalState& state, size_t max_pending) {
+  while (state.pending_cycles.size() > max_pending) {
+    auto cycle = std::move(state.pending_cycles.front());
+    state.pending_cycles.pop_front();
+    cycle.get();
+  }
+}
+
+// Hands the responses negotiated in a cycle to the executor thread, which
+// performs the cycles in the order they were negotiated, and so the operations
+// of every process set in the same order on all of its ranks.
+void SubmitCycle(HorovodGlobalState& state,
+                 std::vector<NegotiatedResponses>&& negotiated) {
+  bool join = false;
+  for (auto& responses : negotiated) {
+    for (auto& response : responses.response_list.responses()) {
+      join |= response.response_type() == Response::JOIN;
+    }
+  }
+  auto cycle = std::make_shared<std::packaged_task<void()>>(
+      [&state, negotiated]() {
+        for (auto& responses : negotiated) {
+          PerformResponses(state, *responses.process_set,
+                           responses.process_set_id, responses.response_list);
+        }
+#if HAVE_MPI
+        mpi_collectives.Progress();
+#endif
+      });
+  state.pending_cycles.push_back(cycle->get_future());
+  state.executor_thread_pool.execute([cycle]() { (*cycle)(); });
+  // The join state of a process set is reset by performing its join, which
+  // the next negotiation has to see.
+  WaitForPendingCycles(state, join ? 0 : state.pipeline_depth);
+}
+
+// Frees the buffers Horovod keeps between operations, they are allocated
+// again when next needed. Buffers of operations in flight are freed once
+// these finish.
+void ReleaseBuffers(HorovodGlobalState& state) {
+  for (auto process_set_id : state.process_set_table.Ids()) {
+    state.process_set_table.Get(process_set_id).fusion_buffer.Release();
+  }
+  op_manager->ReleaseBuffers();
+#if HAVE_GPU
+  gpu_context.ReleaseBuffers();
+#endif
+}
+
+MemoryUsage CollectMemoryUsage(HorovodGlobalState& state) {
+  MemoryUsage usage;
+  for (auto process_set_id : state.process_set_table.Ids()) {
+    auto& process_set = state.process_set_table.Get(process_set_id);
+    process_set.fusion_buffer.AddMemoryUsage(usage);
+    // Allocated collectively by the local ranks, so it is kept.
+    if (process_set.shared_buffer != nullptr) {
+      usage[{CPU_DEVICE_ID, "shared_memory"}] += process_set.shared_buffer_size;
+    }
+  }
+  op_manager->AddMemoryUsage(usage);
+#if HAVE_GPU
+  gpu_context.AddMemoryUsage(usage);
+#endif
+  return usage;
+}
+
+// Serves the requests of horovod_release_buffers and horovod_memory_usage,
+// and releases the buffers once idle for state.buffer_idle_timeout.
+void ServeMemoryRequests(HorovodGlobalState& state) {
+  bool release_idle = false;
+  if (state.buffer_idle_timeout.count() > 0) {
+    auto now = std::chrono::steady_clock::now();
+    int64_t tensor_count = state.metrics.Value(METRIC_TENSORS);
+    if (tensor_count != state.last_tensor_count) {
+      state.last_tensor_count = tensor_count;
+      state.last_tensor_time = now;
+      state.buffers_released_idle = false;
+    } else if (!state.buffers_released_idle &&
+               now - state.last_tensor_time >= state.buffer_idle_timeout) {
+      release_idle = true;
+      state.buffers_released_idle = true;
+    }
+  }
+
+  bool release, report;
+  uint64_t issued;
+  {
+    std::lock_guard<std::mutex> guard(state.memory_requests_mutex);
+    release = state.release_buffers_requested;
+    report = state.memory_usage_requested;
+    issued = state.memory_requests_issued;
+    state.release_buffers_requested = false;
+    state.memory_usage_requested = false;
+  }
+  if (!release && !report && !release_idle) {
+    return;
+  }
+
+  // Cycles on the executor thread use the buffers.
+  WaitForPendingCycles(state, 0);
+  if (release || release_idle) {
+    LOG(DEBUG, state.global_controller->GetRank())
+        << "Releasing buffers" << (release_idle ? " after idle timeout" : "");
+    ReleaseBuffers(state);
+  }
+  MemoryUsage usage;
+  if (report) {
+    usage = CollectMemoryUsage(state);
+  }
+  {
+    std::lock_guard<std::mutex> guard(state.memory_requests_mutex);
+    if (report) {
+      state.memory_usage = std::move(usage);
+    }
+    state.memory_requests_served = issued;
+  }
+  state.memory_requests_cond.notify_all();
+}
+
+// Reports the time tensors were waiting for the background thread to wake
+// up to the step profiler.
+void RecordCycleWait(HorovodGlobalState& state,
+                     std::chrono::steady_clock::time_point wait_start) {
+  bool pending = false;
+  std::chrono::steady_clock::time_point first_enqueue;
+  for (auto process_set_id : state.process_set_table.Ids()) {
+    auto& process_set = state.process_set_table.Get(process_set_id);
+    std::chrono::steady_clock::time_point time;
+    if (process_set.tensor_queue.TakeFirstEnqueueTime(time) &&
+        (!pending || time < first_enqueue)) {
+      first_enqueue = time;
+      pending = true;
+    }
+  }
+  if (pending) {
+    state.step_profiler.RecordCycleWait(wait_start, first_enqueue,
+                                        state.last_cycle_start);
+  }
+}
+
+bool RunLoopOnce(HorovodGlobalState& state) {
+  // This delay determines thread frequency and communication message latency
+  auto cycle_end = state.last_cycle_start +
+                   std::chrono::microseconds(long(
+                       state.parameter_manager.CycleTimeMs() * 1000.));
+  // With event_driven_loop, start the next cycle as soon as new tensors have
+  // been enqueued. Otherwise only complete buckets of allreduces cut the
+  // wait short. The cycle time is an upper bound either way.
+  auto wait_start = std::chrono::steady_clock::now();
+  state.wakeup_signal.WaitUntil(cycle_end);
+  state.last_cycle_start = std::chrono::steady_clock::now();
+  state.metrics.Add(METRIC_CYCLES, 1);
+  if (state.step_profiler.enabled()) {
+    RecordCycleWait(state, wait_start);
+  }
+
+  state.timeline.StartCycle();
+  if (state.mark_cycles_in_timeline) {
+    // Mark start of the new cycle.
+    state.timeline.MarkCycleStart();
+  }
+
+  bool this_process_requested_shutdown = state.shut_down;
+
+  if (state.dynamic_process_sets) {
+    // Initialize any newly added process set that has been registered by all
+    // Horovod processes and remove a process set that has been marked for
+    // removal by all Horovod processes. Pending cycles may reference a removed
+    // process set.
+    WaitForPendingCycles(state, 0);
+#if HAVE_MPI
+    if (state.control_operation == LibType::MPI) {
+      // Collectives in flight may use the communicator of a removed process
+      // set.
+      mpi_collectives.Drain();
+      state.process_set_table.InitializeRegisteredAndRemoveMarkedIfReady(
+          global_mpi_context);
+    }
+#endif // HAVE_MPI
+#if HAVE_GLOO
+    if (state.control_operation == LibType::GLOO) {
+      state.process_set_table.InitializeRegisteredAndRemoveMarkedIfReady(
+          global_gloo_context);
+    }
+#endif // HAVE_GLOO
+#if HAVE_NCCL
+    nccl_context.SplitProcessSetComms(state.process_set_table, gpu_context);
+#endif
+  }
+
+#if HAVE_MPI
+  // Sends and receives are not negotiated, they are posted as soon as their
+  // inputs are ready.
+  if (mpi_peer_operations) {
+    std::vector<PeerOperation> ready;
+    state.peer_queue.PopReady(ready);
+    mpi_peer_operations->Post(ready);
+    mpi_peer_operations->Progress();
+  }
+  // With pipelining, the executor thread progresses them after every cycle.
+  if (state.pipeline_depth == 0) {
+    mpi_collectives.Progress();
+  }
+#endif
+
+  // Tensor name and size data of the global process set for autotuning.
+  int64_t total_tensor_size = 0;
+  std::vector<std::string> tensor_names;
+
+  bool should_shutdown = false;
+  if (state.num_process_set_threads > 0) {
+    // Run the other process sets on the thread pool while the global one runs
+    // here, and wait for all of them before the next cycle. Responses that
+    // cannot run concurrently, like NCCL, Adasum or Join, are held back and
+    // performed here afterwards in the order of the process set ids. Ranks
+    // shared by several process sets then issue their blocking collectives
+    // in the same order, whatever the timing of the threads.
+    auto process_set_ids = state.process_set_table.Ids();
+    std::sort(process_set_ids.begin(), process_set_ids.end());
+    std::vector<NegotiatedResponses> deferred;
+    deferred.reserve(process_set_ids.size());
+    for (auto process_set_id : process_set_ids) {
+      auto& process_set = state.process_set_table.Get(process_set_id);
+      if (process_set.initialization_done) {
+        deferred.push_back(
+            NegotiatedResponses{&process_set, process_set_id, ResponseList()});
+      }
+    }
+    std::vector<std::future<bool>> pending;
+    NegotiatedResponses* global_deferred = nullptr;
+    for (auto& responses : deferred) {
+      if (responses.process_set_id == 0) {
+        global_deferred = &responses;
+        continue;
+      }
+      auto* process_set_deferred = &responses;
+      auto task = std::make_shared<std::packaged_task<bool()>>(
+          [&state, process_set_deferred, this_process_requested_shutdown]() {
+            std::vector<std::string> names;
+            int64_t size = 0;
+            return RunProcessSetCycle(
+                state, *process_set_deferred->process_set,
+                process_set_deferred->process_set_id,
+                this_process_requested_shutdown, size, names, nullptr,
+                &process_set_deferred->response_list);
+          });
+      pending.push_back(task->get_future());
+      state.process_set_thread_pool.execute([task]() { (*task)(); });
+    }
+    std::exception_ptr error;
+    try {
+      if (global_deferred != nullptr) {
+        should_shutdown = RunProcessSetCycle(
+            state, *global_deferred->process_set, 0,
+            this_process_requested_shutdown, total_tensor_size, tensor_names,
+            nullptr, &global_deferred->response_list);
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    // Tasks reference the process sets, so all of them must have finished
+    // before an error is raised.
+    for (auto& f : pending) {
+      f.wait();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    for (auto& f : pending) {
+      should_shutdown |= f.get();
+    }
+    for (auto& responses : deferred) {
+      if (!responses.response_list.responses().empty()) {
+        PerformResponses(state, *responses.process_set,
+                         responses.process_set_id, responses.response_list);
+      }
+    }
+  } else {
+    std::vector<NegotiatedResponses> negotiated;
+    for (auto process_set_id : state.process_set_table.Ids()) {
+      if (should_shutdown) {
+        break;
+      }
+      auto& process_set = state.process_set_table.Get(process_set_id);
+      if (!process_set.initialization_done) {
+        continue;
+      }
+      should_shutdown |= RunProcessSetCycle(
+          state, process_set, process_set_id, this_process_requested_shutdown,
+          total_tensor_size, tensor_names,
+          state.pipeline_depth > 0 ? &negotiated : nullptr);
+    }
+    if (state.pipeline_depth > 0) {
+      SubmitCycle(state, std::move(negotiated));
+    }
+  }
+
+  if (state.parameter_manager.IsAutoTuning()) {
+    bool should_sync =
+        state.parameter_manager.Update(tensor_names, total_tensor_size);
+
+    if (should_sync) {
+      state.process_set_table.Get(0).controller->SynchronizeParameters();
+    }
+  }
+
+  ServeMemoryRequests(state);
+
+  return !should_shutdown;
+}
+
+// Start Horovod background thread. Ensure that this is
+// only done once no matter how many times this function is called.
+// Returns false if initialization failed, otherwise true.
+bool InitializeHorovodOnce(
+    const std::vector<int>& ranks,
+    const std::vector<std::vector<int>>& process_set_ranks) {
+  // Ensure background thread is only started once.
+  if (!horovod_global.initialize_flag.test_and_set()) {
+    horovod_global.control_operation = ParseControllerOpsFromEnv();
+    horovod_global.cpu_operation = ParseCPUOpsFromEnv();
+#if HAVE_MPI
+    // Enable mpi if it's used either in cpu data transfer or controller
+    if (horovod_global.cpu_operation == LibType::MPI ||
+        horovod_global.control_operation == LibType::MPI) {
+      global_mpi_context.Enable(ranks);
+    }
 
     if (horovod_global.control_operation == LibType::MPI) {
       auto& global_process_set = horovod_global.process_set_table.Get(0);
@@ -864,6 +2012,8 @@ Status CheckInitialized() {
   return Status::OK();
 }
 
+bool PooledOutputsEnabled() { return horovod_global.pooled_outputs; }
+
 extern "C" {
 
 bool horovod_init(const int* ranks, int nranks, const int* process_set_ranks,
@@ -995,6 +2145,7 @@ void horovod_shutdown() {
   if (horovod_global.background_thread.joinable()) {
     horovod_global.timeline.Shutdown();
     horovod_global.shut_down = true;
+    horovod_global.wakeup_signal.Notify();
     horovod_global.background_thread.join();
 
     // Reset the initialization flag to allow restarting with horovod_init(...)
@@ -1004,6 +2155,12 @@ void horovod_shutdown() {
   }
 }
 
+void horovod_shutdown_for_reset() {
+  horovod_global.keep_state = true;
+  horovod_shutdown();
+  horovod_global.keep_state = false;
+}
+
 bool horovod_is_initialized() {
   return horovod_global.initialization_done;
 }
@@ -1016,10 +2173,15 @@ int horovod_start_timeline(const char* file_name, bool mark_cycles) {
     return -2;
   }
   bool is_coordinator = horovod_global.global_controller->IsCoordinator();
-  if (is_coordinator) {
+  if (is_coordinator || horovod_global.timeline_all_ranks) {
+    auto timeline_file = std::string(file_name);
+    if (horovod_global.timeline_all_ranks) {
+      timeline_file = RankTimelineFile(
+          timeline_file, horovod_global.global_controller->GetRank());
+    }
     horovod_global.timeline.Initialize(
-        std::string(file_name), horovod_global.global_controller->GetSize());
-    horovod_global.timeline.SetPendingTimelineFile(std::string(file_name));
+        timeline_file, horovod_global.global_controller->GetSize());
+    horovod_global.timeline.SetPendingTimelineFile(timeline_file);
   }
   horovod_global.timeline_controller.SetMarkCyclesInTimelinePending(mark_cycles);
   return 1;
@@ -1034,7 +2196,7 @@ int horovod_stop_timeline() {
     return 1;
   }
   bool is_coordinator = horovod_global.global_controller->IsCoordinator();
-  if (is_coordinator) {
+  if (is_coordinator || horovod_global.timeline_all_ranks) {
       horovod_global.timeline.SetPendingTimelineFile(std::string(""));
   }
   return 1;
@@ -1184,6 +2346,197 @@ int horovod_reduce_op_adasum() {
   return ReduceOp::ADASUM;
 }
 
+int horovod_reduce_op_min() {
+  return ReduceOp::MIN;
+}
+
+int horovod_reduce_op_max() {
+  return ReduceOp::MAX;
+}
+
+int horovod_reduce_op_product() {
+  return ReduceOp::PRODUCT;
+}
+
+bool horovod_register_gradient_arena(const void* data, long long size,
+                                     long long alignment) {
+  return horovod_global.gradient_arenas.Register(data, size, alignment);
+}
+
+bool horovod_unregister_gradient_arena(const void* data) {
+  return horovod_global.gradient_arenas.Unregister(data);
+}
+
+int horovod_num_metrics() {
+  return NUM_METRICS;
+}
+
+const char* horovod_metric_name(int index) {
+  return Metrics::Name(index);
+}
+
+int horovod_get_metrics(long long* values_prealloc) {
+  if (!horovod_global.initialization_done) {
+    return -1;
+  }
+  for (int i = 0; i < NUM_METRICS; ++i) {
+    values_prealloc[i] = horovod_global.metrics.Value(i);
+  }
+  return 0;
+}
+
+int horovod_step_begin() {
+  if (!horovod_global.initialization_done) {
+    return -1;
+  }
+  horovod_global.step_profiler.Begin();
+  return 0;
+}
+
+int horovod_step_num_values() {
+  return NUM_STEP_VALUES;
+}
+
+const char* horovod_step_value_name(int index) {
+  return StepProfiler::Name(index);
+}
+
+int horovod_step_end(long long* values_prealloc, const char** tensor_names,
+                     long long* tensor_times_us, int max_tensors) {
+  if (!horovod_global.initialization_done) {
+    return -1;
+  }
+  thread_local StepReport report;
+  if (!horovod_global.step_profiler.End(report)) {
+    return -1;
+  }
+  for (int i = 0; i < NUM_STEP_VALUES; ++i) {
+    values_prealloc[i] = report.values[i];
+  }
+  int num_tensors = (int)report.critical_tensors.size();
+  for (int i = 0; i < std::min(num_tensors, max_tensors); ++i) {
+    tensor_names[i] = report.critical_tensors[i].first.c_str();
+    tensor_times_us[i] = report.critical_tensors[i].second;
+  }
+  return num_tensors;
+}
+
+namespace {
+
+// Makes the background thread serve a memory request and waits for it.
+// Returns false if Horovod shut down before.
+bool WaitForMemoryRequest(bool release) {
+  auto& state = horovod_global;
+  std::unique_lock<std::mutex> lock(state.memory_requests_mutex);
+  if (state.shut_down) {
+    return false;
+  }
+  if (release) {
+    state.release_buffers_requested = true;
+  } else {
+    state.memory_usage_requested = true;
+  }
+  uint64_t ticket = ++state.memory_requests_issued;
+  state.wakeup_signal.Notify();
+  state.memory_requests_cond.wait(lock, [&state, ticket] {
+    return state.memory_requests_served >= ticket;
+  });
+  return !state.shut_down;
+}
+
+} // namespace
+
+int horovod_memory_usage(int* devices, const char** categories,
+                         long long* bytes, int max_entries) {
+  if (!horovod_global.initialization_done ||
+      !WaitForMemoryRequest(/*release=*/false)) {
+    return -1;
+  }
+  thread_local MemoryUsage usage;
+  {
+    std::lock_guard<std::mutex> guard(horovod_global.memory_requests_mutex);
+    usage = horovod_global.memory_usage;
+  }
+  int i = 0;
+  for (auto& entry : usage) {
+    if (i < max_entries) {
+      devices[i] = entry.first.first;
+      categories[i] = entry.first.second.c_str();
+      bytes[i] = entry.second;
+    }
+    ++i;
+  }
+  return i;
+}
+
+int horovod_release_buffers() {
+  if (!horovod_global.initialization_done ||
+      !WaitForMemoryRequest(/*release=*/true)) {
+    return -1;
+  }
+  return 0;
+}
+
+const int HOROVOD_BROADCAST_BYTES_ERROR_INIT = -1;
+const int HOROVOD_BROADCAST_BYTES_ERROR_UNSUPPORTED = -2;
+const int HOROVOD_BROADCAST_BYTES_ERROR_FAILED = -3;
+
+long long horovod_broadcast_bytes(const char* data, long long size,
+                                  int root_rank, const char** output) {
+  if (!horovod_global.initialization_done) {
+    return HOROVOD_BROADCAST_BYTES_ERROR_INIT;
+  }
+  // Valid until the next broadcast of this thread.
+  thread_local std::string buffer;
+  try {
+    if (horovod_global.global_controller->GetRank() == root_rank) {
+      buffer.assign(data, size);
+    }
+    if (!horovod_global.global_controller->BcastBytes(buffer, root_rank)) {
+      return HOROVOD_BROADCAST_BYTES_ERROR_UNSUPPORTED;
+    }
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Byte broadcast failed: " << ex.what();
+    return HOROVOD_BROADCAST_BYTES_ERROR_FAILED;
+  }
+  *output = buffer.data();
+  return buffer.size();
+}
+
+const int HOROVOD_BARRIER_ERROR_INIT = -1;
+const int HOROVOD_BARRIER_ERROR_UNSUPPORTED = -2;
+const int HOROVOD_BARRIER_ERROR_FAILED = -3;
+const int HOROVOD_BARRIER_ERROR_UNKNOWN_SET = -4;
+const int HOROVOD_BARRIER_ERROR_FOREIGN_SET = -5;
+
+int horovod_barrier(int process_set_id) {
+  if (!horovod_global.initialization_done) {
+    return HOROVOD_BARRIER_ERROR_INIT;
+  }
+  ProcessSet* process_set;
+  {
+    // The table is not held while waiting, the background thread needs it.
+    std::lock_guard<std::recursive_mutex> table_lock(
+        horovod_global.process_set_table.mutex);
+    if (!horovod_global.process_set_table.Contains(process_set_id)) {
+      return HOROVOD_BARRIER_ERROR_UNKNOWN_SET;
+    }
+    process_set = &horovod_global.process_set_table.Get(process_set_id);
+    if (!process_set->IsCurrentProcessIncluded()) {
+      return HOROVOD_BARRIER_ERROR_FOREIGN_SET;
+    }
+  }
+  try {
+    if (!process_set->controller->ImmediateBarrier()) {
+      return HOROVOD_BARRIER_ERROR_UNSUPPORTED;
+    }
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Barrier failed: " << ex.what();
+    return HOROVOD_BARRIER_ERROR_FAILED;
+  }
+  return 0;
+}
+
 const int HOROVOD_PROCESS_SET_ERROR_INIT = -1;
 const int HOROVOD_PROCESS_SET_ERROR_DYNAMIC = -2;
 const int HOROVOD_PROCESS_SET_ERROR_UNKNOWN_SET = -3;
@@ -1192,6 +2545,13 @@ const int HOROVOD_PROCESS_SET_ERROR_SHUTDOWN = -5;
 const int HOROVOD_PROCESS_SET_ERROR_EXISTING_SET = -6;
 
 int horovod_add_process_set(const int* ranks, int nrank) {
+  int id;
+  int result = horovod_add_process_sets(ranks, &nrank, 1, &id);
+  return result < 0 ? result : id;
+}
+
+int horovod_add_process_sets(const int* ranks, const int* nranks, int num_sets,
+                             int* ids) {
   if (!horovod_global.initialization_done) {
     return HOROVOD_PROCESS_SET_ERROR_INIT;
   }
@@ -1199,33 +2559,51 @@ int horovod_add_process_set(const int* ranks, int nrank) {
     return HOROVOD_PROCESS_SET_ERROR_DYNAMIC;
   }
 
-  int id;
-  ProcessSet* process_set = nullptr;
+  auto& table = horovod_global.process_set_table;
+  std::vector<ProcessSet*> process_sets;
   {
-    // Lock the table so the background thread will not initialize a newly added
-    // process set before we leave this critical section.
-    std::lock_guard<std::recursive_mutex> table_lock(
-        horovod_global.process_set_table.mutex);
-    process_set = &GetProcessSetOrAddUnitialized(
-        ranks && nrank > 0 ? std::vector<int>(ranks, ranks + nrank)
-                           : std::vector<int>(),
-        id);
-    if (process_set->initialization_done) {
-      // A process set with these ranks existed before.
-      return HOROVOD_PROCESS_SET_ERROR_EXISTING_SET;
+    // Lock the table so the background thread will not initialize some of
+    // the newly added process sets before we leave this critical section.
+    std::lock_guard<std::recursive_mutex> table_lock(table.mutex);
+    std::vector<std::vector<int>> rank_lists;
+    std::set<std::vector<int>> distinct;
+    for (int i = 0, offset = 0; i < num_sets; offset += nranks[i++]) {
+      rank_lists.push_back(ranks && nranks[i] > 0
+                               ? std::vector<int>(ranks + offset,
+                                                  ranks + offset + nranks[i])
+                               : std::vector<int>());
+      auto sorted = rank_lists.back();
+      std::sort(sorted.begin(), sorted.end());
+      int id = table.FindId(sorted);
+      if (!distinct.insert(sorted).second ||
+          (id >= 0 && table.Get(id).initialization_done)) {
+        // A process set with these ranks existed before.
+        return HOROVOD_PROCESS_SET_ERROR_EXISTING_SET;
+      }
+    }
+    for (int i = 0; i < num_sets; ++i) {
+      process_sets.push_back(
+          &GetProcessSetOrAddUnitialized(std::move(rank_lists[i]), ids[i]));
     }
   }
+  // Start the next cycle, which initializes them once all processes have
+  // registered them.
+  horovod_global.wakeup_signal.Notify();
 
-  // Block until the background thread has initialized the process set.
-  while (true) {
-    if (process_set->initialization_done) {
-      return id;
-    }
+  // Block until the background thread has initialized the process sets.
+  bool done = false;
+  table.WaitUntil([&]() {
+    // Process sets are removed while shutting down.
     if (horovod_global.shut_down) {
-      return HOROVOD_PROCESS_SET_ERROR_SHUTDOWN;
+      return true;
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-  }
+    done = std::all_of(process_sets.begin(), process_sets.end(),
+                       [](const ProcessSet* process_set) {
+                         return (bool)process_set->initialization_done;
+                       });
+    return done;
+  });
+  return done ? 0 : HOROVOD_PROCESS_SET_ERROR_SHUTDOWN;
 }
 
 int horovod_remove_process_set(int process_set_id) {
@@ -1247,16 +2625,15 @@ int horovod_remove_process_set(int process_set_id) {
     horovod_global.process_set_table.MarkProcessSetForRemoval(process_set_id);
   }
 
+  horovod_global.wakeup_signal.Notify();
+
   // Block until the background thread has removed the process set.
-  while (true) {
-    if (horovod_global.process_set_table.ProcessSetHasJustBeenRemoved()) {
-      return process_set_id;
-    }
-    if (horovod_global.shut_down) {
-      return HOROVOD_PROCESS_SET_ERROR_SHUTDOWN;
-    }
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-  }
+  bool removed = false;
+  horovod_global.process_set_table.WaitUntil([&]() {
+    removed = horovod_global.process_set_table.ProcessSetHasJustBeenRemoved();
+    return removed || horovod_global.shut_down;
+  });
+  return removed ? process_set_id : HOROVOD_PROCESS_SET_ERROR_SHUTDOWN;
 }
 
 int horovod_process_set_rank(int process_set_id) {
@@ -1348,7 +2725,8 @@ Status EnqueueTensorAllreduce(std::shared_ptr<OpContext> context,
                               ReduceOp reduce_op,
                               double prescale_factor,
                               double postscale_factor,
-                              int32_t process_set_id) {
+                              int32_t process_set_id,
+                              int32_t priority) {
   // Wrap inputs in std::vector and pass onto multi tensor implementation
   std::vector<std::shared_ptr<OpContext>> contexts;
   std::vector<std::shared_ptr<Tensor>> tensors;
@@ -1367,7 +2745,7 @@ Status EnqueueTensorAllreduce(std::shared_ptr<OpContext> context,
   return EnqueueTensorAllreduces(contexts, tensors, outputs, ready_event_lists,
                                  names, device, callbacks, reduce_op,
                                  prescale_factor, postscale_factor,
-                                 process_set_id);
+                                 process_set_id, priority);
 }
 
 Status EnqueueTensorAllreduces(std::vector<std::shared_ptr<OpContext>>& contexts,
@@ -1380,7 +2758,8 @@ Status EnqueueTensorAllreduces(std::vector<std::shared_ptr<OpContext>>& contexts
                                ReduceOp reduce_op,
                                double prescale_factor,
                                double postscale_factor,
-                               int32_t process_set_id) {
+                               int32_t process_set_id,
+                               int32_t priority) {
   if (horovod_global.cpu_operation == LibType::CCL && process_set_id > 0 &&
         device == CPU_DEVICE_ID) {
       return Status::InvalidArgument(
@@ -1408,6 +2787,13 @@ Status EnqueueTensorAllreduces(std::vector<std::shared_ptr<OpContext>>& contexts
       postscale_factor /= process_set.controller->GetLocalSize();
     }
 #endif
+  } else if (reduce_op == ReduceOp::MIN || reduce_op == ReduceOp::MAX ||
+             reduce_op == ReduceOp::PRODUCT) {
+    if (prescale_factor != 1.0 || postscale_factor != 1.0) {
+      return Status::InvalidArgument(
+          "Prescale and postscale factors are only supported with the Sum, "
+          "Average and Adasum reduce ops.");
+    }
   }
 
   std::vector<Request> messages;
@@ -1423,11 +2809,15 @@ Status EnqueueTensorAllreduces(std::vector<std::shared_ptr<OpContext>>& contexts
     message.set_device(device);
     message.set_prescale_factor(prescale_factor);
     message.set_postscale_factor(postscale_factor);
+    message.set_priority(priority);
 
     if (reduce_op == ReduceOp::ADASUM) {
       message.set_request_type(Request::ADASUM);
     } else {
       message.set_request_type(Request::ALLREDUCE);
+      // Averaging has already been folded into the postscale factor.
+      message.set_reduce_op(reduce_op == ReduceOp::AVERAGE ? ReduceOp::SUM
+                                                           : reduce_op);
     }
 
     message.set_tensor_shape(tensors[n]->shape().to_vector());
@@ -1499,14 +2889,212 @@ Status EnqueueTensorAllreduces(std::vector<std::shared_ptr<OpContext>>& contexts
   return status;
 }
 
+void RegisterAllreduceBuckets(const std::vector<std::string>& names,
+                              const std::vector<int64_t>& sizes,
+                              int64_t bucket_bytes) {
+  horovod_global.bucket_table.RegisterBuckets(names, sizes, bucket_bytes);
+}
+
+namespace {
+
+// Enqueues a complete bucket as one group per device and set of reduction
+// arguments, and starts the next cycle right away. Failures are reported
+// through the callbacks, as most of the bucket was enqueued earlier.
+void EnqueueBucket(std::vector<BucketedAllreduce>& bucket) {
+  std::vector<bool> enqueued(bucket.size(), false);
+  for (size_t i = 0; i < bucket.size(); ++i) {
+    if (enqueued[i]) {
+      continue;
+    }
+    auto& first = bucket[i];
+    std::vector<std::shared_ptr<OpContext>> contexts;
+    std::vector<std::shared_ptr<Tensor>> tensors;
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    std::vector<ReadyEventList> ready_event_lists;
+    std::vector<std::string> names;
+    std::vector<StatusCallback> callbacks;
+    int32_t priority = first.priority;
+    for (size_t j = i; j < bucket.size(); ++j) {
+      auto& e = bucket[j];
+      if (enqueued[j] || e.device != first.device ||
+          e.reduce_op != first.reduce_op ||
+          e.prescale_factor != first.prescale_factor ||
+          e.postscale_factor != first.postscale_factor) {
+        continue;
+      }
+      enqueued[j] = true;
+      contexts.push_back(e.context);
+      tensors.push_back(e.tensor);
+      outputs.push_back(e.output);
+      ready_event_lists.push_back(e.ready_event_list);
+      names.push_back(e.name);
+      callbacks.push_back(e.callback);
+      priority = std::max(priority, e.priority);
+    }
+    auto status = EnqueueTensorAllreduces(
+        contexts, tensors, outputs, ready_event_lists, names, first.device,
+        callbacks, first.reduce_op, first.prescale_factor,
+        first.postscale_factor, 0, priority);
+    if (!status.ok()) {
+      for (auto& callback : callbacks) {
+        callback(status);
+      }
+    }
+  }
+  horovod_global.wakeup_signal.Notify();
+}
+
+} // namespace
+
 // Contexts and controller must be initialized and the background thread
 // must be running before this function is called.
-Status EnqueueTensorAllgather(std::shared_ptr<OpContext> context,
-                              std::shared_ptr<Tensor> tensor,
-                              ReadyEventList ready_event_list,
-                              const std::string& name, const int device,
-                              StatusCallback callback,
-                              int32_t process_set_id) {
+Status EnqueueTensorBucketedAllreduce(std::shared_ptr<OpContext> context,
+                                      std::shared_ptr<Tensor> tensor,
+                                      std::shared_ptr<Tensor> output,
+                                      ReadyEventList ready_event_list,
+                                      const std::string& name,
+                                      const int device,
+                                      StatusCallback callback,
+                                      ReduceOp reduce_op,
+                                      double prescale_factor,
+                                      double postscale_factor,
+                                      int32_t priority) {
+  if (horovod_global.shut_down) {
+    return SHUT_DOWN_ERROR;
+  }
+  BucketedAllreduce allreduce;
+  allreduce.context = std::move(context);
+  allreduce.tensor = std::move(tensor);
+  allreduce.output = std::move(output);
+  allreduce.ready_event_list = std::move(ready_event_list);
+  allreduce.name = name;
+  allreduce.device = device;
+  allreduce.callback = std::move(callback);
+  allreduce.reduce_op = reduce_op;
+  allreduce.prescale_factor = prescale_factor;
+  allreduce.postscale_factor = postscale_factor;
+  allreduce.priority = priority;
+
+  std::vector<BucketedAllreduce> bucket;
+  if (horovod_global.bucket_table.Add(std::move(allreduce), bucket)) {
+    EnqueueBucket(bucket);
+  }
+  return Status::OK();
+}
+
+Status SkipBucketedAllreduce(const std::string& name) {
+  if (horovod_global.shut_down) {
+    return SHUT_DOWN_ERROR;
+  }
+  std::vector<BucketedAllreduce> bucket;
+  if (horovod_global.bucket_table.Skip(name, bucket)) {
+    EnqueueBucket(bucket);
+  }
+  return Status::OK();
+}
+
+// Contexts must be initialized before this function is called.
+Status AccumulateTensor(std::shared_ptr<Tensor> tensor,
+                        ReadyEventList ready_event_list,
+                        const std::string& name, const int device,
+                        Event& event) {
+  if (horovod_global.shut_down) {
+    return SHUT_DOWN_ERROR;
+  }
+#if HAVE_GPU
+  if (device != CPU_DEVICE_ID) {
+    return gpu_accumulator.Add(name, *tensor, device, ready_event_list, event);
+  }
+#endif
+  return Status::InvalidArgument(
+      "Accumulation in Horovod is only supported for GPU tensors.");
+}
+
+// Contexts and controller must be initialized and the background thread
+// must be running before this function is called.
+Status EnqueueTensorAccumulatedAllreduce(std::shared_ptr<OpContext> context,
+                                         std::shared_ptr<Tensor> tensor,
+                                         std::shared_ptr<Tensor> output,
+                                         ReadyEventList ready_event_list,
+                                         const std::string& name,
+                                         const int device,
+                                         StatusCallback callback,
+                                         ReduceOp reduce_op,
+                                         double prescale_factor,
+                                         double postscale_factor,
+                                         int32_t process_set_id,
+                                         int32_t priority) {
+#if HAVE_GPU
+  Event added;
+  auto status =
+      AccumulateTensor(tensor, std::move(ready_event_list), name, device, added);
+  if (!status.ok()) {
+    return status;
+  }
+  std::shared_ptr<Tensor> sum;
+  std::shared_ptr<ReadyEvent> sum_ready;
+  status = gpu_accumulator.Take(name, sum, sum_ready);
+  if (!status.ok()) {
+    return status;
+  }
+  ReadyEventList sum_ready_list;
+  sum_ready_list.AddReadyEvent(sum_ready);
+  status = EnqueueTensorAllreduce(
+      context, sum, output, sum_ready_list, name, device,
+      [name, callback](const Status& status) {
+        gpu_accumulator.Release(name, status.event);
+        callback(status);
+      },
+      reduce_op, prescale_factor, postscale_factor, process_set_id, priority);
+  if (!status.ok()) {
+    gpu_accumulator.Release(name, Event());
+  }
+  return status;
+#else
+  return Status::InvalidArgument(
+      "Accumulation in Horovod is only supported for GPU tensors.");
+#endif
+}
+
+// Contexts and controller must be initialized and the background thread
+// must be running before this function is called.
+Status EnqueueTensorAllgather(std::shared_ptr<OpContext> context,
+                              std::shared_ptr<Tensor> tensor,
+                              ReadyEventList ready_event_list,
+                              const std::string& name, const int device,
+                              StatusCallback callback,
+                              int32_t process_set_id,
+                              std::shared_ptr<Tensor> output) {
+  // Wrap inputs in std::vector and pass onto multi tensor implementation
+  std::vector<std::shared_ptr<OpContext>> contexts;
+  std::vector<std::shared_ptr<Tensor>> tensors;
+  std::vector<ReadyEventList> ready_event_lists;
+  std::vector<std::string> names;
+  std::vector<StatusCallback> callbacks;
+  std::vector<std::shared_ptr<Tensor>> outputs;
+
+  contexts.emplace_back(std::move(context));
+  tensors.emplace_back(std::move(tensor));
+  ready_event_lists.emplace_back(std::move(ready_event_list));
+  names.emplace_back(name);
+  callbacks.emplace_back(std::move(callback));
+  if (output != nullptr) {
+    outputs.emplace_back(std::move(output));
+  }
+
+  return EnqueueTensorAllgathers(contexts, tensors, ready_event_lists, names,
+                                 device, callbacks, process_set_id,
+                                 std::move(outputs));
+}
+
+Status EnqueueTensorAllgathers(std::vector<std::shared_ptr<OpContext>>& contexts,
+                               std::vector<std::shared_ptr<Tensor>>& tensors,
+                               std::vector<ReadyEventList>& ready_event_lists,
+                               std::vector<std::string>& names,
+                               const int device,
+                               std::vector<StatusCallback>& callbacks,
+                               int32_t process_set_id,
+                               std::vector<std::shared_ptr<Tensor>> outputs) {
   if (horovod_global.cpu_operation == LibType::CCL && process_set_id > 0 &&
       device == CPU_DEVICE_ID) {
     return Status::InvalidArgument(
@@ -1525,32 +3113,74 @@ Status EnqueueTensorAllgather(std::shared_ptr<OpContext> context,
         " is not a member of the provided process set.");
   }
 
-  Request message;
-  message.set_request_rank(process_set.controller->GetRank());
-  message.set_tensor_name(name);
-  message.set_tensor_type(tensor->dtype());
-  message.set_device(device);
-  message.set_request_type(Request::ALLGATHER);
-  for (int i = 0; i < tensor->shape().dims(); ++i) {
-    message.add_tensor_shape((int64_t)tensor->shape().dim_size(i));
+  std::vector<Request> messages;
+  std::vector<TensorTableEntry> entries;
+  messages.reserve(tensors.size());
+  entries.reserve(tensors.size());
+
+  for (int n = 0; n < (int)tensors.size(); ++n) {
+    Request message;
+    message.set_request_rank(process_set.controller->GetRank());
+    message.set_tensor_name(names[n]);
+    message.set_tensor_type(tensors[n]->dtype());
+    message.set_device(device);
+    message.set_request_type(Request::ALLGATHER);
+    for (int i = 0; i < tensors[n]->shape().dims(); ++i) {
+      message.add_tensor_shape((int64_t)tensors[n]->shape().dim_size(i));
+    }
+    messages.push_back(std::move(message));
+
+    TensorTableEntry e;
+    e.tensor_name = names[n];
+    e.context = std::move(contexts[n]);
+    e.tensor = std::move(tensors[n]);
+    if (!outputs.empty()) {
+      e.output = std::move(outputs[n]);
+    }
+    e.process_set_id = process_set_id;
+    e.ready_event_list = std::move(ready_event_lists[n]);
+    e.device = device;
+    e.callback = std::move(callbacks[n]);
+    entries.push_back(std::move(e));
   }
 
-  TensorTableEntry e;
-  e.tensor_name = name;
-  e.context = context;
-  e.tensor = tensor;
-  e.process_set_id = process_set_id;
-  e.ready_event_list = ready_event_list;
-  e.device = device;
-  e.callback = callback;
-  e.nvtx_op_range.Start(RegisteredNvtxOp::HorovodAllgather, e.tensor->size());
+  // Start appropriate NVTX range
+  if (entries.size() == 1) {
+    auto& e = entries[0];
+    e.nvtx_op_range.Start(RegisteredNvtxOp::HorovodAllgather, e.tensor->size());
+  } else {
+    auto total_size =
+        std::accumulate(entries.begin(), entries.end(), 0ll,
+                        [](int64_t size_sum, const TensorTableEntry& e) {
+                          return size_sum + e.tensor->size();
+                        });
+    SharedNvtxOpRange range;
+    range.Start(RegisteredNvtxOp::HorovodGroupedAllgather, total_size);
+    for (auto& e : entries) {
+      e.nvtx_op_range = range;
+    }
+  }
+
+  std::string tensors_enqueued;
+  for (const auto& n : names) {
+    tensors_enqueued += n + "; ";
+  }
+
+  // Only create groups larger than 1 tensor, unless disable_group_fusion is requested.
+  // In that case, even single tensor groups are created to enforce disabling fusion.
+  if (names.size() > 1 || horovod_global.disable_group_fusion) {
+    auto group_id = process_set.group_table.RegisterGroup(std::move(names));
+    for (auto& message : messages) {
+      message.set_group_id(group_id);
+    }
+  }
 
   if (horovod_global.shut_down) {
     return SHUT_DOWN_ERROR;
   }
-  Status status = process_set.tensor_queue.AddToTensorQueue(e, message);
+  Status status = process_set.tensor_queue.AddToTensorQueueMulti(entries, messages);
   if (status.ok()) {
-    LOG(TRACE, horovod_global.global_controller->GetRank()) << "Enqueued " << name;
+    LOG(TRACE, horovod_global.global_controller->GetRank()) << "Enqueued " << tensors_enqueued;
   }
   return status;
 }
@@ -1564,6 +3194,35 @@ Status EnqueueTensorBroadcast(std::shared_ptr<OpContext> context,
                               const std::string& name, const int device,
                               StatusCallback callback,
                               int32_t process_set_id) {
+  // Wrap inputs in std::vector and pass onto multi tensor implementation
+  std::vector<std::shared_ptr<OpContext>> contexts;
+  std::vector<std::shared_ptr<Tensor>> tensors;
+  std::vector<std::shared_ptr<Tensor>> outputs;
+  std::vector<ReadyEventList> ready_event_lists;
+  std::vector<std::string> names;
+  std::vector<StatusCallback> callbacks;
+
+  contexts.emplace_back(std::move(context));
+  tensors.emplace_back(std::move(tensor));
+  outputs.emplace_back(std::move(output));
+  ready_event_lists.emplace_back(std::move(ready_event_list));
+  names.emplace_back(name);
+  callbacks.emplace_back(std::move(callback));
+
+  return EnqueueTensorBroadcasts(contexts, tensors, outputs, root_rank,
+                                 ready_event_lists, names, device, callbacks,
+                                 process_set_id);
+}
+
+Status EnqueueTensorBroadcasts(std::vector<std::shared_ptr<OpContext>>& contexts,
+                               std::vector<std::shared_ptr<Tensor>>& tensors,
+                               std::vector<std::shared_ptr<Tensor>>& outputs,
+                               int root_rank,
+                               std::vector<ReadyEventList>& ready_event_lists,
+                               std::vector<std::string>& names,
+                               const int device,
+                               std::vector<StatusCallback>& callbacks,
+                               int32_t process_set_id) {
   if (horovod_global.cpu_operation == LibType::CCL && process_set_id > 0 &&
       device == CPU_DEVICE_ID) {
     return Status::InvalidArgument(
@@ -1585,28 +3244,53 @@ Status EnqueueTensorBroadcast(std::shared_ptr<OpContext> context,
         " for provided process set");
   }
 
-  Request message;
-  message.set_request_rank(process_set.controller->GetRank());
-  message.set_tensor_name(name);
-  message.set_tensor_type(tensor->dtype());
-  message.set_root_rank(root_rank_in_process_set);
-  message.set_device(device);
-  message.set_request_type(Request::BROADCAST);
-  for (int i = 0; i < tensor->shape().dims(); ++i) {
-    message.add_tensor_shape((int64_t)tensor->shape().dim_size(i));
+  std::vector<Request> messages;
+  std::vector<TensorTableEntry> entries;
+  messages.reserve(tensors.size());
+  entries.reserve(tensors.size());
+
+  for (int n = 0; n < (int)tensors.size(); ++n) {
+    Request message;
+    message.set_request_rank(process_set.controller->GetRank());
+    message.set_tensor_name(names[n]);
+    message.set_tensor_type(tensors[n]->dtype());
+    message.set_root_rank(root_rank_in_process_set);
+    message.set_device(device);
+    message.set_request_type(Request::BROADCAST);
+    for (int i = 0; i < tensors[n]->shape().dims(); ++i) {
+      message.add_tensor_shape((int64_t)tensors[n]->shape().dim_size(i));
+    }
+    messages.push_back(std::move(message));
+
+    TensorTableEntry e;
+    e.tensor_name = names[n];
+    e.context = std::move(contexts[n]);
+    e.tensor = std::move(tensors[n]);
+    e.output = std::move(outputs[n]);
+    e.process_set_id = process_set_id;
+    e.root_rank = root_rank_in_process_set;
+    e.ready_event_list = std::move(ready_event_lists[n]);
+    e.device = device;
+    e.callback = std::move(callbacks[n]);
+    entries.push_back(std::move(e));
   }
 
-  TensorTableEntry e;
-  e.tensor_name = name;
-  e.context = context;
-  e.tensor = tensor;
-  e.output = output;
-  e.process_set_id = process_set_id;
-  e.root_rank = root_rank_in_process_set;
-  e.ready_event_list = ready_event_list;
-  e.device = device;
-  e.callback = callback;
-  e.nvtx_op_range.Start(RegisteredNvtxOp::HorovodBroadcast, e.tensor->size());
+  // Start appropriate NVTX range
+  if (entries.size() == 1) {
+    auto& e = entries[0];
+    e.nvtx_op_range.Start(RegisteredNvtxOp::HorovodBroadcast, e.tensor->size());
+  } else {
+    auto total_size =
+        std::accumulate(entries.begin(), entries.end(), 0ll,
+                        [](int64_t size_sum, const TensorTableEntry& e) {
+                          return size_sum + e.tensor->size();
+                        });
+    SharedNvtxOpRange range;
+    range.Start(RegisteredNvtxOp::HorovodGroupedBroadcast, total_size);
+    for (auto& e : entries) {
+      e.nvtx_op_range = range;
+    }
+  }
 
   if (!process_set.IsCurrentProcessIncluded()) {
     return Status::InvalidArgument(
@@ -1615,12 +3299,26 @@ Status EnqueueTensorBroadcast(std::shared_ptr<OpContext> context,
         " is not a member of the provided process set.");
   }
 
+  std::string tensors_enqueued;
+  for (const auto& n : names) {
+    tensors_enqueued += n + "; ";
+  }
+
+  // Only create groups larger than 1 tensor, unless disable_group_fusion is requested.
+  // In that case, even single tensor groups are created to enforce disabling fusion.
+  if (names.size() > 1 || horovod_global.disable_group_fusion) {
+    auto group_id = process_set.group_table.RegisterGroup(std::move(names));
+    for (auto& message : messages) {
+      message.set_group_id(group_id);
+    }
+  }
+
   if (horovod_global.shut_down) {
     return SHUT_DOWN_ERROR;
   }
-  Status status = process_set.tensor_queue.AddToTensorQueue(e, message);
+  Status status = process_set.tensor_queue.AddToTensorQueueMulti(entries, messages);
   if (status.ok()) {
-    LOG(TRACE, horovod_global.global_controller->GetRank()) << "Enqueued " << name;
+    LOG(TRACE, horovod_global.global_controller->GetRank()) << "Enqueued " << tensors_enqueued;
   }
   return status;
 }
@@ -1633,7 +3331,42 @@ Status EnqueueTensorAlltoall(std::shared_ptr<OpContext> context,
                              ReadyEventList ready_event_list,
                              const std::string& name, const int device,
                              StatusCallback callback,
-                             int32_t process_set_id) {
+                             int32_t process_set_id,
+                             std::shared_ptr<Tensor> recv_splits) {
+  // Wrap inputs in std::vector and pass onto multi tensor implementation
+  std::vector<std::shared_ptr<OpContext>> contexts;
+  std::vector<std::shared_ptr<Tensor>> tensors;
+  std::vector<std::shared_ptr<Tensor>> splits_list;
+  std::vector<std::shared_ptr<Tensor>> recv_splits_list;
+  std::vector<ReadyEventList> ready_event_lists;
+  std::vector<std::string> names;
+  std::vector<StatusCallback> callbacks;
+
+  contexts.emplace_back(std::move(context));
+  tensors.emplace_back(std::move(tensor));
+  splits_list.emplace_back(std::move(splits));
+  if (recv_splits != nullptr) {
+    recv_splits_list.emplace_back(std::move(recv_splits));
+  }
+  ready_event_lists.emplace_back(std::move(ready_event_list));
+  names.emplace_back(name);
+  callbacks.emplace_back(std::move(callback));
+
+  return EnqueueTensorAlltoalls(contexts, tensors, splits_list,
+                                ready_event_lists, names, device, callbacks,
+                                process_set_id, recv_splits_list);
+}
+
+Status EnqueueTensorAlltoalls(std::vector<std::shared_ptr<OpContext>>& contexts,
+                              std::vector<std::shared_ptr<Tensor>>& tensors,
+                              std::vector<std::shared_ptr<Tensor>>& splits,
+                              std::vector<ReadyEventList>& ready_event_lists,
+                              std::vector<std::string>& names,
+                              const int device,
+                              std::vector<StatusCallback>& callbacks,
+                              int32_t process_set_id,
+                              const std::vector<std::shared_ptr<Tensor>>&
+                                  recv_splits) {
   if (horovod_global.cpu_operation == LibType::CCL && process_set_id > 0 &&
       device == CPU_DEVICE_ID) {
     return Status::InvalidArgument(
@@ -1645,12 +3378,162 @@ Status EnqueueTensorAlltoall(std::shared_ptr<OpContext> context,
   }
   auto& process_set = horovod_global.process_set_table.Get(process_set_id);
 
-  // Check arguments
-  if (splits->shape().dims() > 1) {
-    return Status::InvalidArgument("alltoall expects a 1D splits tensor");
+  if (!process_set.IsCurrentProcessIncluded()) {
+    return Status::InvalidArgument(
+        "Alltoall: Rank " +
+        std::to_string(horovod_global.global_controller->GetRank()) +
+        " is not a member of the provided process set.");
   }
-  if (splits->dtype() != HOROVOD_INT32) {
-    return Status::InvalidArgument("alltoall expects splits to contain 32-bit integer elements.");
+  int world_size = process_set.controller->GetSize();
+
+  std::vector<Request> messages;
+  std::vector<TensorTableEntry> entries;
+  messages.reserve(tensors.size());
+  entries.reserve(tensors.size());
+
+  for (int n = 0; n < (int)tensors.size(); ++n) {
+    auto& tensor = tensors[n];
+    auto& tensor_splits = splits[n];
+
+    // Check arguments
+    if (tensor_splits->shape().dims() > 1) {
+      return Status::InvalidArgument("alltoall expects a 1D splits tensor");
+    }
+    if (tensor_splits->dtype() != HOROVOD_INT32) {
+      return Status::InvalidArgument("alltoall expects splits to contain 32-bit integer elements.");
+    }
+
+    Request message;
+    message.set_request_rank(process_set.controller->GetRank());
+    message.set_tensor_name(names[n]);
+    message.set_tensor_type(tensor->dtype());
+    message.set_device(device);
+    message.set_request_type(Request::ALLTOALL);
+    for (int i = 0; i < tensor->shape().dims(); ++i) {
+      message.add_tensor_shape((int64_t)tensor->shape().dim_size(i));
+    }
+
+    TensorTableEntry e;
+    e.tensor_name = names[n];
+    e.context = std::move(contexts[n]);
+    e.tensor = tensor;
+    e.process_set_id = process_set_id;
+    e.ready_event_list = std::move(ready_event_lists[n]);
+    e.device = device;
+    e.callback = std::move(callbacks[n]);
+
+    int64_t splits_first_dim = tensor_splits->shape().dim_size(0);
+    int64_t tensor_first_dim = tensor->shape().dim_size(0);
+    if (splits_first_dim == world_size) {
+      auto splits_data = static_cast<const int32_t*>(tensor_splits->data());
+      auto sum = std::accumulate(splits_data, splits_data + splits_first_dim, 0);
+      if (sum > tensor_first_dim) {
+        return Status::InvalidArgument("Sum of splits entries is greater than the first dimension of tensor.");
+      }
+      e.splits.assign(splits_data,
+                      splits_data + tensor_splits->shape().num_elements());
+    } else if (splits_first_dim == 0) {
+      if (tensor_first_dim % world_size != 0) {
+        return Status::InvalidArgument("splits not provided, but first dimension of tensor is not an even "
+                                       "multiple of the number of workers.");
+      }
+      e.splits.resize(world_size, tensor_first_dim / world_size);
+    } else {
+        return Status::InvalidArgument("Number of entries in splits does not equal number of workers.");
+    }
+
+    if (!recv_splits.empty()) {
+      auto& tensor_recv_splits = recv_splits[n];
+      if (tensor_recv_splits->dtype() != HOROVOD_INT32 ||
+          tensor_recv_splits->shape().num_elements() != world_size) {
+        return Status::InvalidArgument(
+            "alltoall expects recv_splits to contain one 32-bit integer per "
+            "worker.");
+      }
+      auto recv_splits_data =
+          static_cast<const int32_t*>(tensor_recv_splits->data());
+      e.recvsplits.assign(recv_splits_data, recv_splits_data + world_size);
+    }
+
+    messages.push_back(std::move(message));
+    entries.push_back(std::move(e));
+  }
+
+  // Start appropriate NVTX range
+  if (entries.size() == 1) {
+    auto& e = entries[0];
+    e.nvtx_op_range.Start(RegisteredNvtxOp::HorovodAlltoall, e.tensor->size());
+  } else {
+    auto total_size =
+        std::accumulate(entries.begin(), entries.end(), 0ll,
+                        [](int64_t size_sum, const TensorTableEntry& e) {
+                          return size_sum + e.tensor->size();
+                        });
+    SharedNvtxOpRange range;
+    range.Start(RegisteredNvtxOp::HorovodGroupedAlltoall, total_size);
+    for (auto& e : entries) {
+      e.nvtx_op_range = range;
+    }
+  }
+
+  std::string tensors_enqueued;
+  for (const auto& n : names) {
+    tensors_enqueued += n + "; ";
+  }
+
+  // Only create groups larger than 1 tensor, unless disable_group_fusion is requested.
+  // In that case, even single tensor groups are created to enforce disabling fusion.
+  if (tensors.size() > 1 || horovod_global.disable_group_fusion) {
+    auto group_id = process_set.group_table.RegisterGroup(std::move(names));
+    for (auto& message : messages) {
+      message.set_group_id(group_id);
+    }
+  }
+
+  if (horovod_global.shut_down) {
+    return SHUT_DOWN_ERROR;
+  }
+  Status status = process_set.tensor_queue.AddToTensorQueueMulti(entries, messages);
+  if (status.ok()) {
+    LOG(TRACE, horovod_global.global_controller->GetRank()) << "Enqueued " << tensors_enqueued;
+  }
+  return status;
+}
+
+// Contexts and controller must be initialized and the background thread
+// must be running before this function is called.
+Status EnqueueTensorReducescatter(std::shared_ptr<OpContext> context,
+                                  std::shared_ptr<Tensor> tensor,
+                                  ReadyEventList ready_event_list,
+                                  const std::string& name, const int device,
+                                  StatusCallback callback,
+                                  ReduceOp reduce_op,
+                                  int32_t process_set_id) {
+  if (horovod_global.cpu_operation == LibType::CCL && process_set_id > 0 &&
+      device == CPU_DEVICE_ID) {
+    return Status::InvalidArgument(
+        "Process sets are not supported yet with oneCCL operations.");
+  }
+  if (!horovod_global.process_set_table.Contains(process_set_id)) {
+    return Status::InvalidArgument("Reducescatter: Process set provided does "
+                                   "not exist, or has not been registered.");
+  }
+  auto& process_set = horovod_global.process_set_table.Get(process_set_id);
+
+  if (!process_set.IsCurrentProcessIncluded()) {
+    return Status::InvalidArgument(
+        "Reducescatter: Rank " +
+        std::to_string(horovod_global.global_controller->GetRank()) +
+        " is not a member of the provided process set.");
+  }
+
+  double postscale_factor = 1.0;
+  if (reduce_op == ReduceOp::AVERAGE) {
+    // Averaging happens via postscale_factor
+    postscale_factor /= process_set.controller->GetSize();
+  } else if (reduce_op != ReduceOp::SUM) {
+    return Status::InvalidArgument(
+        "Reducescatter only supports the Sum and Average reduce ops.");
   }
 
   Request message;
@@ -1658,7 +3541,8 @@ Status EnqueueTensorAlltoall(std::shared_ptr<OpContext> context,
   message.set_tensor_name(name);
   message.set_tensor_type(tensor->dtype());
   message.set_device(device);
-  message.set_request_type(Request::ALLTOALL);
+  message.set_request_type(Request::REDUCESCATTER);
+  message.set_postscale_factor(postscale_factor);
   for (int i = 0; i < tensor->shape().dims(); ++i) {
     message.add_tensor_shape((int64_t)tensor->shape().dim_size(i));
   }
@@ -1671,34 +3555,163 @@ Status EnqueueTensorAlltoall(std::shared_ptr<OpContext> context,
   e.ready_event_list = ready_event_list;
   e.device = device;
   e.callback = callback;
-  e.nvtx_op_range.Start(RegisteredNvtxOp::HorovodAlltoall, e.tensor->size());
+  e.nvtx_op_range.Start(RegisteredNvtxOp::HorovodReducescatter, e.tensor->size());
+
+  if (horovod_global.shut_down) {
+    return SHUT_DOWN_ERROR;
+  }
+  Status status = process_set.tensor_queue.AddToTensorQueue(e, message);
+  if (status.ok()) {
+    LOG(TRACE, horovod_global.global_controller->GetRank()) << "Enqueued " << name;
+  }
+  return status;
+}
+
+// Contexts and controller must be initialized and the background thread
+// must be running before this function is called.
+Status EnqueueTensorReduce(std::shared_ptr<OpContext> context,
+                           std::shared_ptr<Tensor> tensor,
+                           std::shared_ptr<Tensor> output, int root_rank,
+                           ReadyEventList ready_event_list,
+                           const std::string& name, const int device,
+                           StatusCallback callback, ReduceOp reduce_op,
+                           double prescale_factor, double postscale_factor,
+                           int32_t process_set_id) {
+  if (horovod_global.cpu_operation == LibType::CCL &&
+      device == CPU_DEVICE_ID) {
+    return Status::InvalidArgument(
+        "Reduce is not supported yet with oneCCL operations.");
+  }
+  if (!horovod_global.process_set_table.Contains(process_set_id)) {
+    return Status::InvalidArgument("Reduce: Process set provided does not "
+                                   "exist, or has not been registered.");
+  }
+  auto& process_set = horovod_global.process_set_table.Get(process_set_id);
 
-  int64_t splits_first_dim = splits->shape().dim_size(0);
-  int64_t tensor_first_dim = tensor->shape().dim_size(0);
-  int world_size = process_set.controller->GetSize();
   if (!process_set.IsCurrentProcessIncluded()) {
     return Status::InvalidArgument(
-        "Alltoall: Rank " +
+        "Reduce: Rank " +
         std::to_string(horovod_global.global_controller->GetRank()) +
         " is not a member of the provided process set.");
-  } else if (splits_first_dim == world_size) {
-    auto splits_data = static_cast<const int32_t*>(splits->data());
-    auto sum = std::accumulate(splits_data, splits_data + splits_first_dim, 0);
-    if (sum > tensor_first_dim) {
-      return Status::InvalidArgument("Sum of splits entries is greater than the first dimension of tensor.");
-    }
-    e.splits.assign(splits_data,
-                    splits_data + splits->shape().num_elements());
-  } else if (splits_first_dim == 0) {
-    if (tensor_first_dim % world_size != 0) {
-      return Status::InvalidArgument("splits not provided, but first dimension of tensor is not an even "
-                                     "multiple of the number of workers.");
-    }
-    e.splits.resize(world_size, tensor_first_dim / world_size);
-  } else {
-      return Status::InvalidArgument("Number of entries in splits does not equal number of workers.");
   }
 
+  int root_rank_in_process_set;
+  try {
+    root_rank_in_process_set =
+        process_set.controller->GetGlobalRankToControllerRank().at(root_rank);
+  } catch (const std::out_of_range& e) {
+    return Status::InvalidArgument(
+        "reduce received invalid root rank " + std::to_string(root_rank) +
+        " for provided process set");
+  }
+  if (root_rank_in_process_set == process_set.controller->GetRank() &&
+      output == nullptr) {
+    return Status::InvalidArgument("Reduce: The root rank needs an output.");
+  }
+
+  if (reduce_op == ReduceOp::AVERAGE) {
+    // Averaging happens via postscale_factor
+    postscale_factor /= process_set.controller->GetSize();
+  } else if (reduce_op == ReduceOp::ADASUM) {
+    return Status::InvalidArgument("Reduce does not support Adasum.");
+  } else if (reduce_op != ReduceOp::SUM &&
+             (prescale_factor != 1.0 || postscale_factor != 1.0)) {
+    return Status::InvalidArgument(
+        "Prescale and postscale factors are only supported with the Sum and "
+        "Average reduce ops.");
+  }
+
+  Request message;
+  message.set_request_rank(process_set.controller->GetRank());
+  message.set_tensor_name(name);
+  message.set_tensor_type(tensor->dtype());
+  message.set_root_rank(root_rank_in_process_set);
+  message.set_device(device);
+  message.set_request_type(Request::REDUCE);
+  message.set_prescale_factor(prescale_factor);
+  message.set_postscale_factor(postscale_factor);
+  // Averaging has already been folded into the postscale factor.
+  message.set_reduce_op(reduce_op == ReduceOp::AVERAGE ? ReduceOp::SUM
+                                                       : reduce_op);
+  message.set_tensor_shape(tensor->shape().to_vector());
+
+  TensorTableEntry e;
+  e.tensor_name = name;
+  e.context = std::move(context);
+  e.tensor = std::move(tensor);
+  e.output = std::move(output);
+  e.process_set_id = process_set_id;
+  e.root_rank = root_rank_in_process_set;
+  e.ready_event_list = std::move(ready_event_list);
+  e.device = device;
+  e.callback = std::move(callback);
+  e.nvtx_op_range.Start(RegisteredNvtxOp::HorovodReduce, e.tensor->size());
+
+  if (horovod_global.shut_down) {
+    return SHUT_DOWN_ERROR;
+  }
+  Status status = process_set.tensor_queue.AddToTensorQueue(e, message);
+  if (status.ok()) {
+    LOG(TRACE, horovod_global.global_controller->GetRank()) << "Enqueued " << name;
+  }
+  return status;
+}
+
+// Contexts and controller must be initialized and the background thread
+// must be running before this function is called.
+Status EnqueueTensorGather(std::shared_ptr<OpContext> context,
+                           std::shared_ptr<Tensor> tensor, int root_rank,
+                           ReadyEventList ready_event_list,
+                           const std::string& name, const int device,
+                           StatusCallback callback, int32_t process_set_id) {
+  if (horovod_global.cpu_operation == LibType::CCL &&
+      device == CPU_DEVICE_ID) {
+    return Status::InvalidArgument(
+        "Gather is not supported yet with oneCCL operations.");
+  }
+  if (!horovod_global.process_set_table.Contains(process_set_id)) {
+    return Status::InvalidArgument("Gather: Process set provided does not "
+                                   "exist, or has not been registered.");
+  }
+  auto& process_set = horovod_global.process_set_table.Get(process_set_id);
+
+  if (!process_set.IsCurrentProcessIncluded()) {
+    return Status::InvalidArgument(
+        "Gather: Rank " +
+        std::to_string(horovod_global.global_controller->GetRank()) +
+        " is not a member of the provided process set.");
+  }
+
+  int root_rank_in_process_set;
+  try {
+    root_rank_in_process_set =
+        process_set.controller->GetGlobalRankToControllerRank().at(root_rank);
+  } catch (const std::out_of_range& e) {
+    return Status::InvalidArgument(
+        "gather received invalid root rank " + std::to_string(root_rank) +
+        " for provided process set");
+  }
+
+  Request message;
+  message.set_request_rank(process_set.controller->GetRank());
+  message.set_tensor_name(name);
+  message.set_tensor_type(tensor->dtype());
+  message.set_root_rank(root_rank_in_process_set);
+  message.set_device(device);
+  message.set_request_type(Request::GATHER);
+  message.set_tensor_shape(tensor->shape().to_vector());
+
+  TensorTableEntry e;
+  e.tensor_name = name;
+  e.context = std::move(context);
+  e.tensor = std::move(tensor);
+  e.process_set_id = process_set_id;
+  e.root_rank = root_rank_in_process_set;
+  e.ready_event_list = std::move(ready_event_list);
+  e.device = device;
+  e.callback = std::move(callback);
+  e.nvtx_op_range.Start(RegisteredNvtxOp::HorovodGather, e.tensor->size());
+
   if (horovod_global.shut_down) {
     return SHUT_DOWN_ERROR;
   }
@@ -1709,6 +3722,75 @@ Status EnqueueTensorAlltoall(std::shared_ptr<OpContext> context,
   return status;
 }
 
+namespace {
+
+Status EnqueuePeerOperation(std::shared_ptr<OpContext> context,
+                            std::shared_ptr<Tensor> tensor, bool send,
+                            int peer_rank, ReadyEventList ready_event_list,
+                            const std::string& name, const int device,
+                            StatusCallback callback) {
+  if (horovod_global.control_operation != LibType::MPI) {
+    return Status::PreconditionError(
+        "Send and receive require the MPI controller.");
+  }
+  auto& controller = *horovod_global.global_controller;
+  if (peer_rank < 0 || peer_rank >= controller.GetSize() ||
+      peer_rank == controller.GetRank()) {
+    return Status::InvalidArgument(
+        std::string(send ? "Send" : "Receive") + " received invalid rank " +
+        std::to_string(peer_rank));
+  }
+
+  PeerOperation operation;
+  operation.send = send;
+  auto& e = operation.entry;
+  e.tensor_name = name;
+  e.context = std::move(context);
+  if (send) {
+    e.tensor = std::move(tensor);
+  } else {
+    e.output = std::move(tensor);
+  }
+  e.root_rank = peer_rank;
+  e.ready_event_list = std::move(ready_event_list);
+  e.device = device;
+  e.callback = std::move(callback);
+
+  if (horovod_global.shut_down) {
+    return SHUT_DOWN_ERROR;
+  }
+  horovod_global.peer_queue.Add(std::move(operation));
+  horovod_global.wakeup_signal.Notify();
+  LOG(TRACE, controller.GetRank()) << "Enqueued " << name;
+  return Status::OK();
+}
+
+} // namespace
+
+// Contexts and controller must be initialized and the background thread
+// must be running before this function is called.
+Status EnqueueTensorSend(std::shared_ptr<OpContext> context,
+                         std::shared_ptr<Tensor> tensor, int dst_rank,
+                         ReadyEventList ready_event_list,
+                         const std::string& name, const int device,
+                         StatusCallback callback) {
+  return EnqueuePeerOperation(std::move(context), std::move(tensor), true,
+                              dst_rank, std::move(ready_event_list), name,
+                              device, std::move(callback));
+}
+
+// Contexts and controller must be initialized and the background thread
+// must be running before this function is called.
+Status EnqueueTensorRecv(std::shared_ptr<OpContext> context,
+                         std::shared_ptr<Tensor> output, int src_rank,
+                         ReadyEventList ready_event_list,
+                         const std::string& name, const int device,
+                         StatusCallback callback) {
+  return EnqueuePeerOperation(std::move(context), std::move(output), false,
+                              src_rank, std::move(ready_event_list), name,
+                              device, std::move(callback));
+}
+
 // Contexts and controller must be initialized and the background thread
 // must be running before this function is called.
 Status EnqueueJoin(std::shared_ptr<OpContext> context,
@@ -1741,5 +3823,163 @@ Status EnqueueJoin(std::shared_ptr<OpContext> context,
   return status;
 }
 
+#if HAVE_NCCL
+int CapturableAllreduceIdSize() { return sizeof(ncclUniqueId); }
+
+Status CapturableAllreduceId(void* id) {
+  auto nccl_result = ncclGetUniqueId((ncclUniqueId*)id);
+  if (nccl_result != ncclSuccess) {
+    return Status::UnknownError(std::string("ncclGetUniqueId failed: ") +
+                                ncclGetErrorString(nccl_result));
+  }
+  return Status::OK();
+}
+
+Status InitCapturableAllreduce(const void* id, int device,
+                               int32_t process_set_id) {
+  if (!horovod_global.initialization_done) {
+    return NOT_INITIALIZED_ERROR;
+  }
+  int size;
+  int rank;
+  {
+    std::lock_guard<std::recursive_mutex> table_lock(
+        horovod_global.process_set_table.mutex);
+    if (!horovod_global.process_set_table.Contains(process_set_id)) {
+      return Status::InvalidArgument("Unknown process set id " +
+                                     std::to_string(process_set_id) + ".");
+    }
+    auto& process_set = horovod_global.process_set_table.Get(process_set_id);
+    if (!process_set.IsCurrentProcessIncluded()) {
+      return Status::InvalidArgument(
+          "This process is not part of process set " +
+          std::to_string(process_set_id) + ".");
+    }
+    size = process_set.controller->GetSize();
+    rank = process_set.controller->GetRank();
+  }
+
+  std::lock_guard<std::mutex> guard(nccl_context.capture_mutex);
+  auto key = std::make_pair(process_set_id, device);
+  if (nccl_context.capture_comms.count(key) > 0) {
+    return Status::OK();
+  }
+  gpu_context.SetDevice(device);
+  ncclComm_t nccl_comm;
+  auto nccl_result = nccl_context.CommInitRank(
+      &nccl_comm, size, *(const ncclUniqueId*)id, rank);
+  if (nccl_result != ncclSuccess) {
+    return Status::UnknownError(std::string("ncclCommInitRank failed: ") +
+                                ncclGetErrorString(nccl_result));
+  }
+  nccl_context.capture_comms[key] = nccl_comm;
+  return Status::OK();
+}
+
+Status CapturableAllreduce(const std::vector<std::shared_ptr<Tensor>>& tensors,
+                           const std::vector<std::shared_ptr<Tensor>>& outputs,
+                           ReduceOp reduce_op, double prescale_factor,
+                           double postscale_factor, int device, void* stream,
+                           int32_t process_set_id) {
+  // Averages divide by the size of the communicator of the process set.
+  bool average = reduce_op == ReduceOp::AVERAGE;
+  if (average) {
+    reduce_op = ReduceOp::SUM;
+  }
+  if (reduce_op != ReduceOp::SUM &&
+      (prescale_factor != 1.0 || postscale_factor != 1.0)) {
+    return Status::InvalidArgument(
+        "Prescaling and postscaling are only supported for Sum and Average.");
+  }
+  if (reduce_op == ReduceOp::ADASUM) {
+    return Status::InvalidArgument(
+        "Adasum is not supported by capturable allreduces.");
+  }
+
+  std::lock_guard<std::mutex> guard(nccl_context.capture_mutex);
+  auto it = nccl_context.capture_comms.find(
+      std::make_pair(process_set_id, device));
+  if (it == nccl_context.capture_comms.end()) {
+    return Status::PreconditionError(
+        "InitCapturableAllreduce() was not called for process set " +
+        std::to_string(process_set_id) + " on device " +
+        std::to_string(device) + ".");
+  }
+  if (average) {
+    int size;
+    auto nccl_result = ncclCommCount(it->second, &size);
+    if (nccl_result != ncclSuccess) {
+      return Status::UnknownError(std::string("ncclCommCount failed: ") +
+                                  ncclGetErrorString(nccl_result));
+    }
+    postscale_factor /= size;
+  }
+  auto gpu_stream = (gpuStream_t)stream;
+  gpu_context.SetDevice(device);
+
+  // Prescaling writes to the outputs, which are then reduced in place.
+  for (size_t i = 0; i < tensors.size() && prescale_factor != 1.0; ++i) {
+    gpu_context.ScaleBufferImpl(
+        tensors[i]->data(), (void*)outputs[i]->data(),
+        tensors[i]->shape().num_elements(), prescale_factor,
+        tensors[i]->dtype(), gpu_stream);
+  }
+  // A group makes NCCL launch the allreduces together, in place of copying
+  // them into a fusion buffer.
+  auto nccl_result = ncclGroupStart();
+  if (nccl_result != ncclSuccess) {
+    return Status::UnknownError(std::string("ncclGroupStart failed: ") +
+                                ncclGetErrorString(nccl_result));
+  }
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    auto input = prescale_factor != 1.0 ? outputs[i]->data()
+                                        : tensors[i]->data();
+    nccl_result = ncclAllReduce(input, (void*)outputs[i]->data(),
+                                (size_t)tensors[i]->shape().num_elements(),
+                                GetNCCLDataType(tensors[i]),
+                                GetNCCLReduceOp(reduce_op), it->second,
+                                gpu_stream);
+    if (nccl_result != ncclSuccess) {
+      // The group still has to be closed, which drops what it holds.
+      ncclGroupEnd();
+      return Status::UnknownError(std::string("ncclAllReduce failed: ") +
+                                  ncclGetErrorString(nccl_result));
+    }
+  }
+  nccl_result = ncclGroupEnd();
+  if (nccl_result != ncclSuccess) {
+    return Status::UnknownError(std::string("ncclGroupEnd failed: ") +
+                                ncclGetErrorString(nccl_result));
+  }
+  for (size_t i = 0; i < outputs.size() && postscale_factor != 1.0; ++i) {
+    gpu_context.ScaleBufferImpl(
+        outputs[i]->data(), (void*)outputs[i]->data(),
+        outputs[i]->shape().num_elements(), postscale_factor,
+        outputs[i]->dtype(), gpu_stream);
+  }
+  return Status::OK();
+}
+#else
+int CapturableAllreduceIdSize() { return 0; }
+
+Status CapturableAllreduceId(void* id) {
+  return Status::PreconditionError(
+      "Capturable allreduces require Horovod to be built with NCCL.");
+}
+
+Status InitCapturableAllreduce(const void* id, int device,
+                               int32_t process_set_id) {
+  return CapturableAllreduceId(nullptr);
+}
+
+Status CapturableAllreduce(const std::vector<std::shared_ptr<Tensor>>& tensors,
+                           const std::vector<std::shared_ptr<Tensor>>& outputs,
+                           ReduceOp reduce_op, double prescale_factor,
+                           double postscale_factor, int device, void* stream,
+                           int32_t process_set_id) {
+  return CapturableAllreduceId(nullptr);
+}
+#endif
+
 } // namespace common
 } // namespace horovod
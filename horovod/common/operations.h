@@ -32,12 +32,9 @@ namespace common {
 // Check that Horovod is initialized.
 Status CheckInitialized();
 
-enum ReduceOp {
-    AVERAGE = 0, // This value should never appear past framework code, as
-                 // averaging is taken care of there.
-    SUM = 1,
-    ADASUM = 2
-};
+// Whether GPU allreduces may be enqueued without an output tensor, see
+// OpContext::AdoptOutput. Only valid once Horovod is initialized.
+bool PooledOutputsEnabled();
 
 extern "C" {
 
@@ -58,6 +55,11 @@ bool horovod_init_multi_comm(MPI_Comm* comm, int ncomms,
 // C interface to shut down Horovod.
 void horovod_shutdown();
 
+// C interface to shut down Horovod for an elastic reset, keeping GPU buffers,
+// NCCL communicators and tuned parameters that the next initialization in
+// this process can reuse.
+void horovod_shutdown_for_reset();
+
 // C interface to get index of current Horovod process.
 // Returns -1 if Horovod is not initialized.
 int horovod_rank();
@@ -115,6 +117,111 @@ int horovod_reduce_op_sum();
 // C interface to return value of the ReduceOp::ADASUM enum field.
 int horovod_reduce_op_adasum();
 
+// C interface to return value of the ReduceOp::MIN enum field.
+int horovod_reduce_op_min();
+
+// C interface to return value of the ReduceOp::MAX enum field.
+int horovod_reduce_op_max();
+
+// C interface to return value of the ReduceOp::PRODUCT enum field.
+int horovod_reduce_op_product();
+
+// C interface to register a contiguous buffer holding gradients that are
+// allreduced in place, each of them placed at an offset that is a multiple
+// of alignment bytes. Fused allreduces of tensors from the same buffer are
+// then reduced directly in it, without fusion buffer copies. Returns false if
+// the buffer overlaps one that is already registered.
+bool horovod_register_gradient_arena(const void* data, long long size,
+                                     long long alignment);
+
+// C interface to unregister a buffer previously passed to
+// horovod_register_gradient_arena. Returns false if it is unknown.
+bool horovod_unregister_gradient_arena(const void* data);
+
+// C interface to return the number of counters reported by
+// horovod_get_metrics.
+int horovod_num_metrics();
+
+// C interface to return the name of the counter at index, or an empty string
+// if the index is out of range.
+const char* horovod_metric_name(int index);
+
+// C interface to copy the current value of all counters into the
+// preallocated array of horovod_num_metrics() elements. Returns 0, or -1 if
+// Horovod is not initialized.
+int horovod_get_metrics(long long* values_prealloc);
+
+// C interface to mark the start of a training step, e.g. before its forward
+// pass. Operations that complete until horovod_step_end are attributed to
+// the step. Returns 0, or -1 if Horovod is not initialized.
+int horovod_step_begin();
+
+// C interface to return the number of values reported by horovod_step_end.
+int horovod_step_num_values();
+
+// C interface to return the name of the step value at index, or an empty
+// string if the index is out of range.
+const char* horovod_step_value_name(int index);
+
+// C interface to end the step started by horovod_step_begin, once the
+// framework has waited for its operations. Copies the horovod_step_num_values()
+// values of the step into the preallocated values_prealloc, and the names of
+// up to max_tensors tensors that completed after the last tensor of the step
+// was enqueued, the last one first, with the microseconds they completed
+// after it. Returns the number of those tensors, which may be larger than
+// max_tensors, or -1 if Horovod is not initialized or no step was started.
+// The names stay valid until the next call from this thread.
+int horovod_step_end(long long* values_prealloc, const char** tensor_names,
+                     long long* tensor_times_us, int max_tensors);
+
+// C interface to report the bytes of the buffers Horovod keeps between
+// operations, by device (CPU_DEVICE_ID for host memory) and category. Fills
+// up to max_entries elements of the preallocated arrays and returns the
+// number of entries, which may be larger, or -1 if Horovod is not
+// initialized. The category names stay valid until the next call from this
+// thread.
+int horovod_memory_usage(int* devices, const char** categories,
+                         long long* bytes, int max_entries);
+
+// C interface to free the buffers Horovod keeps between operations, which are
+// allocated again when next needed. Returns 0 once they are freed, or -1 if
+// Horovod is not initialized.
+int horovod_release_buffers();
+
+extern const int HOROVOD_BROADCAST_BYTES_ERROR_INIT;
+extern const int HOROVOD_BROADCAST_BYTES_ERROR_UNSUPPORTED;
+extern const int HOROVOD_BROADCAST_BYTES_ERROR_FAILED;
+
+// C interface to broadcast size bytes of data from root_rank to all Horovod
+// processes (blocking), bypassing negotiation and the tensor queue. Must be
+// called by all processes in the same order; data is only read on the root.
+// Returns the number of bytes broadcast and points output to them until the
+// next call from this thread, or an error code:
+// HOROVOD_BROADCAST_BYTES_ERROR_INIT if Horovod is not initialized,
+// HOROVOD_BROADCAST_BYTES_ERROR_UNSUPPORTED if the controller cannot
+// broadcast bytes, like Gloo or MPI without multi-threading support,
+// HOROVOD_BROADCAST_BYTES_ERROR_FAILED if the broadcast failed.
+long long horovod_broadcast_bytes(const char* data, long long size,
+                                  int root_rank, const char** output);
+
+extern const int HOROVOD_BARRIER_ERROR_INIT;
+extern const int HOROVOD_BARRIER_ERROR_UNSUPPORTED;
+extern const int HOROVOD_BARRIER_ERROR_FAILED;
+extern const int HOROVOD_BARRIER_ERROR_UNKNOWN_SET;
+extern const int HOROVOD_BARRIER_ERROR_FOREIGN_SET;
+
+// C interface to wait until all processes of the process set have called it
+// (blocking), on the calling thread and bypassing negotiation and the tensor
+// queue. Must be called by all processes of the set in the same order.
+// Returns 0, or an error code:
+// HOROVOD_BARRIER_ERROR_INIT if Horovod is not initialized,
+// HOROVOD_BARRIER_ERROR_UNSUPPORTED if the controller cannot wait outside of
+// the background thread, like MPI without multi-threading support,
+// HOROVOD_BARRIER_ERROR_FAILED if the barrier failed,
+// HOROVOD_BARRIER_ERROR_UNKNOWN_SET if the process set is not registered,
+// HOROVOD_BARRIER_ERROR_FOREIGN_SET if this process is not in it.
+int horovod_barrier(int process_set_id);
+
 extern const int HOROVOD_PROCESS_SET_ERROR_INIT;
 extern const int HOROVOD_PROCESS_SET_ERROR_DYNAMIC;
 extern const int HOROVOD_PROCESS_SET_ERROR_UNKNOWN_SET;
@@ -131,6 +238,15 @@ extern const int HOROVOD_PROCESS_SET_ERROR_SHUTDOWN;
 // HOROVOD_PROCESS_SET_ERROR_DYNAMIC if dynamic process sets are not enabled,
 int horovod_add_process_set(const int *ranks, int nranks);
 
+// C interface to register num_sets new process sets at once (blocking), which
+// are initialized together. The ranks of all of them are concatenated in
+// ranks, with nranks[i] of them for the i-th. Fills ids with their process set
+// ids and returns 0, or returns an error code as horovod_add_process_set,
+// without registering any of them if one contains the same ranks as another
+// one or one added before.
+int horovod_add_process_sets(const int* ranks, const int* nranks, int num_sets,
+                             int* ids);
+
 // C interface to deregister a previously registered process set (blocking).
 // Returns process_set_id or an error code:
 // HOROVOD_PROCESS_SET_ERROR_INIT if Horovod is not initialized,
@@ -189,7 +305,54 @@ Status EnqueueTensorAllreduce(std::shared_ptr<OpContext> context,
                               ReduceOp reduce_op = ReduceOp::SUM,
                               double prescale_factor = 1.0,
                               double postscale_factor = 1.0,
-                              int32_t process_set_id = 0);
+                              int32_t process_set_id = 0,
+                              int32_t priority = 0);
+
+// Assigns the allreduces of names, in the order their tensors were
+// registered with the framework, to buckets of about bucket_bytes, see
+// BucketTable. Buckets are kept across resets of elastic Horovod.
+void RegisterAllreduceBuckets(const std::vector<std::string>& names,
+                              const std::vector<int64_t>& sizes,
+                              int64_t bucket_bytes);
+
+// Holds the allreduce back until all allreduces of its bucket have been
+// enqueued, then enqueues them as a group and starts a cycle right away.
+// Allreduces outside of all buckets are enqueued at once. Global process
+// set only.
+Status EnqueueTensorBucketedAllreduce(std::shared_ptr<OpContext> context,
+                                      std::shared_ptr<Tensor> tensor,
+                                      std::shared_ptr<Tensor> output,
+                                      ReadyEventList ready_event_list,
+                                      const std::string& name, int device,
+                                      StatusCallback callback,
+                                      ReduceOp reduce_op = ReduceOp::SUM,
+                                      double prescale_factor = 1.0,
+                                      double postscale_factor = 1.0,
+                                      int32_t priority = 0);
+
+// Counts name as done in its bucket for this pass, for a tensor that is
+// reduced without EnqueueTensorBucketedAllreduce().
+Status SkipBucketedAllreduce(const std::string& name);
+
+// Adds tensor to a sum kept by Horovod under name, see GPUAccumulator. event
+// completes once tensor has been read.
+Status AccumulateTensor(std::shared_ptr<Tensor> tensor,
+                        ReadyEventList ready_event_list,
+                        const std::string& name, int device, Event& event);
+
+// Adds tensor to the sum accumulated under name and allreduces the sum into
+// output. The next accumulation under name starts a new sum.
+Status EnqueueTensorAccumulatedAllreduce(std::shared_ptr<OpContext> context,
+                                         std::shared_ptr<Tensor> tensor,
+                                         std::shared_ptr<Tensor> output,
+                                         ReadyEventList ready_event_list,
+                                         const std::string& name, int device,
+                                         StatusCallback callback,
+                                         ReduceOp reduce_op = ReduceOp::SUM,
+                                         double prescale_factor = 1.0,
+                                         double postscale_factor = 1.0,
+                                         int32_t process_set_id = 0,
+                                         int32_t priority = 0);
 
 Status EnqueueTensorAllreduces(std::vector<std::shared_ptr<OpContext>>& contexts,
                                std::vector<std::shared_ptr<Tensor>>& tensors,
@@ -201,14 +364,31 @@ Status EnqueueTensorAllreduces(std::vector<std::shared_ptr<OpContext>>& contexts
                                ReduceOp reduce_op = ReduceOp::SUM,
                                double prescale_factor = 1.0,
                                double postscale_factor = 1.0,
-                               int32_t process_set_id = 0);
+                               int32_t process_set_id = 0,
+                               int32_t priority = 0);
 
+// A non-null output must have the shape of the result, which is gathered
+// into it instead of into an output allocated by the context, e.g. for
+// allgathers of the same shape every step. Unfused allgathers write straight
+// into it.
 Status EnqueueTensorAllgather(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> tensor,
                               ReadyEventList ready_event_list,
                               const std::string& name, int device,
                               StatusCallback callback,
-                              int32_t process_set_id = 0);
+                              int32_t process_set_id = 0,
+                              std::shared_ptr<Tensor> output = nullptr);
+
+// Outputs, if not empty, are preallocated as the output of
+// EnqueueTensorAllgather, with null ones allocated by their context.
+Status EnqueueTensorAllgathers(std::vector<std::shared_ptr<OpContext>>& contexts,
+                               std::vector<std::shared_ptr<Tensor>>& tensors,
+                               std::vector<ReadyEventList>& ready_event_lists,
+                               std::vector<std::string>& names,
+                               int device,
+                               std::vector<StatusCallback>& callbacks,
+                               int32_t process_set_id = 0,
+                               std::vector<std::shared_ptr<Tensor>> outputs = {});
 
 Status EnqueueTensorBroadcast(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> tensor,
@@ -218,13 +398,71 @@ Status EnqueueTensorBroadcast(std::shared_ptr<OpContext> context,
                               StatusCallback callback,
                               int32_t process_set_id = 0);
 
+// All tensors of a group are broadcast from the same root rank.
+Status EnqueueTensorBroadcasts(std::vector<std::shared_ptr<OpContext>>& contexts,
+                               std::vector<std::shared_ptr<Tensor>>& tensors,
+                               std::vector<std::shared_ptr<Tensor>>& outputs,
+                               int root_rank,
+                               std::vector<ReadyEventList>& ready_event_lists,
+                               std::vector<std::string>& names,
+                               int device,
+                               std::vector<StatusCallback>& callbacks,
+                               int32_t process_set_id = 0);
+
+// If recv_splits holds the number of slices every rank sends to this one, the
+// splits are not exchanged before the alltoall. It must then be given on all
+// ranks.
 Status EnqueueTensorAlltoall(std::shared_ptr<OpContext> context,
                              std::shared_ptr<Tensor> tensor,
                              std::shared_ptr<Tensor> splits,
                              ReadyEventList ready_event_list,
                              const std::string& name, int device,
                              StatusCallback callback,
-                             int32_t process_set_id = 0);
+                             int32_t process_set_id = 0,
+                             std::shared_ptr<Tensor> recv_splits = nullptr);
+
+Status EnqueueTensorAlltoalls(std::vector<std::shared_ptr<OpContext>>& contexts,
+                              std::vector<std::shared_ptr<Tensor>>& tensors,
+                              std::vector<std::shared_ptr<Tensor>>& splits,
+                              std::vector<ReadyEventList>& ready_event_lists,
+                              std::vector<std::string>& names,
+                              int device,
+                              std::vector<StatusCallback>& callbacks,
+                              int32_t process_set_id = 0,
+                              const std::vector<std::shared_ptr<Tensor>>&
+                                  recv_splits = {});
+
+Status EnqueueTensorReducescatter(std::shared_ptr<OpContext> context,
+                                  std::shared_ptr<Tensor> tensor,
+                                  ReadyEventList ready_event_list,
+                                  const std::string& name, int device,
+                                  StatusCallback callback,
+                                  ReduceOp reduce_op = ReduceOp::SUM,
+                                  int32_t process_set_id = 0);
+
+// Reduces tensor over the process set into output on root_rank only. The
+// other ranks pass no output and receive nothing, so that they neither
+// allocate nor receive the result.
+Status EnqueueTensorReduce(std::shared_ptr<OpContext> context,
+                           std::shared_ptr<Tensor> tensor,
+                           std::shared_ptr<Tensor> output, int root_rank,
+                           ReadyEventList ready_event_list,
+                           const std::string& name, int device,
+                           StatusCallback callback,
+                           ReduceOp reduce_op = ReduceOp::SUM,
+                           double prescale_factor = 1.0,
+                           double postscale_factor = 1.0,
+                           int32_t process_set_id = 0);
+
+// Concatenates tensor of all ranks along the first dimension like an
+// allgather, but only on root_rank. Outputs are allocated by the op: the
+// full result on the root, a first dimension of zero on the other ranks.
+Status EnqueueTensorGather(std::shared_ptr<OpContext> context,
+                           std::shared_ptr<Tensor> tensor, int root_rank,
+                           ReadyEventList ready_event_list,
+                           const std::string& name, int device,
+                           StatusCallback callback,
+                           int32_t process_set_id = 0);
 
 Status EnqueueJoin(std::shared_ptr<OpContext> context,
                    ReadyEventList ready_event_list,
@@ -232,6 +470,47 @@ Status EnqueueJoin(std::shared_ptr<OpContext> context,
                    StatusCallback callback,
                    int32_t process_set_id = 0);
 
+// Sends tensor to the process of global rank dst_rank, which receives it
+// with EnqueueTensorRecv into an output of the same size. Sends and receives
+// are not negotiated with the other ranks: between two ranks they are
+// matched in the order they are enqueued. Requires the MPI controller.
+Status EnqueueTensorSend(std::shared_ptr<OpContext> context,
+                         std::shared_ptr<Tensor> tensor, int dst_rank,
+                         ReadyEventList ready_event_list,
+                         const std::string& name, int device,
+                         StatusCallback callback);
+
+Status EnqueueTensorRecv(std::shared_ptr<OpContext> context,
+                         std::shared_ptr<Tensor> output, int src_rank,
+                         ReadyEventList ready_event_list,
+                         const std::string& name, int device,
+                         StatusCallback callback);
+
+// Size in bytes of the ids InitCapturableAllreduce() takes, 0 if Horovod was
+// built without NCCL.
+int CapturableAllreduceIdSize();
+
+// Writes a new id for InitCapturableAllreduce() to id.
+Status CapturableAllreduceId(void* id);
+
+// Creates the communicator CapturableAllreduce() uses on device for the
+// process set, from an id made by one of its ranks and sent to the others.
+// All ranks of the process set must call this together.
+Status InitCapturableAllreduce(const void* id, int device,
+                               int32_t process_set_id = 0);
+
+// Allreduces tensors into outputs over the process set with NCCL on stream,
+// a gpuStream_t, from the calling thread. Nothing is negotiated or handed to
+// the background thread, so the calls can be captured into a CUDA graph, and
+// the small allreduces of e.g. tensor-parallel inference do not wait for a
+// cycle. All ranks of the process set must make the same calls in the same
+// order.
+Status CapturableAllreduce(const std::vector<std::shared_ptr<Tensor>>& tensors,
+                           const std::vector<std::shared_ptr<Tensor>>& outputs,
+                           ReduceOp reduce_op, double prescale_factor,
+                           double postscale_factor, int device, void* stream,
+                           int32_t process_set_id = 0);
+
 } // namespace common
 } // namespace horovod
 
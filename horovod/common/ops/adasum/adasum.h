@@ -16,8 +16,11 @@
 #ifndef HOROVOD_ADASUM_H
 #define HOROVOD_ADASUM_H
 
+#include <algorithm>
 #include <cstring>
 #include <float.h>
+#include <functional>
+#include <utility>
 
 #if __AVX__ && __F16C__ && __FMA__
 #include <emmintrin.h>
@@ -26,6 +29,7 @@
 
 #include "../../common.h"
 #include "../../global_state.h"
+#include "../cpu_kernels.h"
 
 namespace horovod {
 namespace common {
@@ -34,6 +38,48 @@ static inline bool IsPowerOfTwo(uint64_t x) {
   return (x != 0) && ((x & (x - 1)) == 0);
 }
 
+// Adasum reduces within groups of ranks whose sizes are the powers of two that
+// sum up to size, largest first, e.g. ranks 0-7 and 8-11 of 12 ranks. All
+// groups run the vector-halving, distance-doubling (VHDD) reduction at the
+// same time, and their results are then combined while they are still
+// scattered over the ranks of each group.
+static inline void GetAdasumGroup(int rank, int size, int& group_offset,
+                                  int& group_size) {
+  group_offset = 0;
+  group_size = 1;
+  while ((group_size << 1) <= size) {
+    group_size <<= 1;
+  }
+  for (; group_size > 0; group_size >>= 1) {
+    if ((size & group_size) == 0) {
+      continue;
+    }
+    if (rank < group_offset + group_size) {
+      return;
+    }
+    group_offset += group_size;
+  }
+}
+
+// Elements [begin, begin + count) of total_count that local_rank of a group of
+// group_size ranks owns after the reduce-scatter half of VHDD. The slice of a
+// rank of a smaller group is the union of the slices of the ranks of a larger
+// group that have the same local rank modulo its size.
+static inline void GetVHDDSlice(int total_count, int local_rank,
+                                int group_size, int& begin, int& count) {
+  begin = 0;
+  count = total_count;
+  for (int level = 1; level < group_size; level <<= 1) {
+    int first_half = count >> 1;
+    if ((local_rank & level) != 0) {
+      begin += first_half;
+      count -= first_half;
+    } else {
+      count = first_half;
+    }
+  }
+}
+
 // Interface for Adasum algorithm
 template <typename Communicator_type> class Adasum {
 public:
@@ -60,6 +106,26 @@ protected:
                                     int tag, Communicator_type communicator,
                                     HorovodGlobalState* global_state) = 0;
 
+  // Same exchange as PointToPointSendRecv, calling on_recv_chunk with the
+  // range [begin, end) of elements of output_data_buffer each time a part of
+  // it has arrived, so that it can be processed while the rest is in flight.
+  virtual void PointToPointSendRecvPipelined(
+      void* input_data_buffer, int64_t input_buffer_length,
+      void* output_data_buffer, int64_t output_buffer_length,
+      DataType horovod_datatype, int dst_src_rank, int tag,
+      Communicator_type communicator, HorovodGlobalState* global_state,
+      const std::function<void(int64_t, int64_t)>& on_recv_chunk) {
+    PointToPointSendRecv(input_data_buffer, input_buffer_length,
+                         output_data_buffer, output_buffer_length,
+                         horovod_datatype, dst_src_rank, tag, communicator,
+                         global_state);
+    on_recv_chunk(0, output_buffer_length / DataType_Size(horovod_datatype));
+  }
+
+  // Whether dot products and norms can be computed on the chunks delivered by
+  // PointToPointSendRecvPipelined with DispatchComputeDotAndNormSqrds.
+  virtual bool PipelineDotProducts() const { return true; }
+
   virtual void SumAllreduceWithComm(std::vector<TensorTableEntry>& entries,
                                     void* data, int num_elements,
                                     DataType horovod_datatype,
@@ -139,6 +205,85 @@ protected:
     }
   }
 
+  // Computes the dot product and squared norms of every tensor in the fused
+  // buffers a and b, tensor i is written to dots_and_norms[3 * i] (dot
+  // product), dots_and_norms[3 * i + 1] (norm of a) and
+  // dots_and_norms[3 * i + 2] (norm of b).
+  virtual void DispatchFusedComputeDotAndNormSqrds(
+      uint8_t* a, uint8_t* b, DataType horovod_datatype,
+      const std::vector<int>& tensor_counts,
+      std::vector<double>& dots_and_norms, int layerid) {
+    int per_element_size = DataType_Size(horovod_datatype);
+    int bytesSoFar = 0;
+    for (size_t i = 0; i < tensor_counts.size(); i++) {
+      DispatchComputeDotAndNormSqrds(&a[bytesSoFar], &b[bytesSoFar],
+                                     horovod_datatype, tensor_counts[i],
+                                     dots_and_norms[i * 3],
+                                     dots_and_norms[i * 3 + 1],
+                                     dots_and_norms[i * 3 + 2], layerid);
+      bytesSoFar += tensor_counts[i] * per_element_size;
+    }
+  }
+
+  // Adds the dot products and squared norms of elements [begin, end) of the
+  // fused buffers a and b to dots_and_norms, using the layout of
+  // DispatchFusedComputeDotAndNormSqrds.
+  void AccumulateDotAndNormSqrds(uint8_t* a, uint8_t* b,
+                                 DataType horovod_datatype,
+                                 const std::vector<int>& tensor_counts,
+                                 int64_t begin, int64_t end,
+                                 std::vector<double>& dots_and_norms,
+                                 int layerid) {
+    int per_element_size = DataType_Size(horovod_datatype);
+    int64_t tensor_begin = 0;
+    for (size_t i = 0; i < tensor_counts.size() && tensor_begin < end; i++) {
+      int64_t tensor_end = tensor_begin + tensor_counts[i];
+      int64_t lo = std::max(begin, tensor_begin);
+      int64_t hi = std::min(end, tensor_end);
+      if (lo < hi) {
+        double dotProduct = 0.;
+        double anormsq = 0.;
+        double bnormsq = 0.;
+        DispatchComputeDotAndNormSqrds(&a[lo * per_element_size],
+                                       &b[lo * per_element_size],
+                                       horovod_datatype, (int)(hi - lo),
+                                       dotProduct, anormsq, bnormsq, layerid);
+        dots_and_norms[i * 3] += dotProduct;
+        dots_and_norms[i * 3 + 1] += anormsq;
+        dots_and_norms[i * 3 + 2] += bnormsq;
+      }
+      tensor_begin = tensor_end;
+    }
+  }
+
+  // Replaces every tensor in the fused buffer a by coefficients[2 * i] * a +
+  // coefficients[2 * i + 1] * b.
+  virtual void DispatchFusedScaledAdd(DataType horovod_datatype,
+                                      const std::vector<int>& tensor_counts,
+                                      const std::vector<double>& coefficients,
+                                      uint8_t* a, uint8_t* b, int layerid) {
+    int per_element_size = DataType_Size(horovod_datatype);
+    int bytesSoFar = 0;
+    for (size_t i = 0; i < tensor_counts.size(); i++) {
+      DispatchScaledAdd(horovod_datatype, tensor_counts[i], coefficients[i * 2],
+                        &a[bytesSoFar], coefficients[i * 2 + 1],
+                        &b[bytesSoFar], layerid);
+      bytesSoFar += tensor_counts[i] * per_element_size;
+    }
+  }
+
+  // Bytes of the receive buffer, which is kept between operations.
+  uint64_t RecvBufferBytes() const {
+    return recv_buffer_ != nullptr ? current_recv_buffer_length : 0;
+  }
+
+  // Frees the receive buffer, GetRecvBuffer() allocates it again.
+  void ReleaseRecvBuffer() {
+    free(recv_buffer_);
+    recv_buffer_ = nullptr;
+    current_recv_buffer_length = 0;
+  }
+
   // Get recv buffer
   uint8_t* GetRecvBuffer(int buffer_length) {
     return CheckBufferAndReallocate(&recv_buffer_, buffer_length,
@@ -206,21 +351,24 @@ private:
 
     int per_element_size =
         process_set.controller->GetTypeSize(horovod_datatype);
-    int rank = GetLocalRankWithComm(communicator);
-    int size = GetSizeWithComm(communicator);
+    int global_rank = GetLocalRankWithComm(communicator);
+    int orgSize = GetSizeWithComm(communicator);
 
     std::vector<std::vector<int>> nghrCountVec;
     std::vector<double> normAndDots(tensor_counts.size() * 3 * 2);
 
-    int nearest_power_2 = 1;
-    for (nearest_power_2 = 1; (nearest_power_2 << 1) <= size;
-         nearest_power_2 = (nearest_power_2 << 1)) {
+    // Ranks run VHDD within their group, see GetAdasumGroup.
+    int group_offset;
+    int size;
+    GetAdasumGroup(global_rank, orgSize, group_offset, size);
+    int rank = global_rank - group_offset;
+    if (size != orgSize && start_level > 1) {
+      throw std::logic_error("Adasum with start_level > 1 requires a power "
+                             "of two number of ranks.");
     }
     int level;
 
     int nghrCountVec_index = 0;
-    int orgSize = size;
-    size = nearest_power_2;
 
     int total_counts_sum = 0;
     for (size_t i = 0; i < tensor_counts.size(); i++)
@@ -233,7 +381,7 @@ private:
         continue;
       }
 
-      int neighbor_rank = rank ^ level;
+      int neighbor_rank = group_offset + (rank ^ level);
       int nghrCount = 0;
       int sendOffset = 0;
       int recvOffset = 0;
@@ -297,10 +445,28 @@ private:
 
       nghrCountVec_index++;
 
-      this->PointToPointSendRecv(
-          (char*)(&grad_buffer[sendOffset]), nghrCount * per_element_size,
-          (char*)(&recv_buffer[recvOffset]), myCount * per_element_size,
-          horovod_datatype, neighbor_rank, tag, communicator, global_state);
+      bool pipelined = PipelineDotProducts();
+      if (pipelined) {
+        // The half kept by this rank and the matching received half, which
+        // are the inputs of the pairwise reduction below.
+        uint8_t* a = (uint8_t*)((rank & level) != 0 ? &grad_buffer[nghrCount]
+                                                    : grad_buffer);
+        uint8_t* b = (uint8_t*)(&recv_buffer[recvOffset]);
+        std::fill(normAndDots.begin(), normAndDots.end(), 0.);
+        this->PointToPointSendRecvPipelined(
+            (char*)(&grad_buffer[sendOffset]), nghrCount * per_element_size,
+            (char*)(&recv_buffer[recvOffset]), myCount * per_element_size,
+            horovod_datatype, neighbor_rank, tag, communicator, global_state,
+            [&](int64_t begin, int64_t end) {
+              AccumulateDotAndNormSqrds(a, b, horovod_datatype, tensor_counts,
+                                        begin, end, normAndDots, tag);
+            });
+      } else {
+        this->PointToPointSendRecv(
+            (char*)(&grad_buffer[sendOffset]), nghrCount * per_element_size,
+            (char*)(&recv_buffer[recvOffset]), myCount * per_element_size,
+            horovod_datatype, neighbor_rank, tag, communicator, global_state);
+      }
       if ((rank & level) != 0) {
         grad_buffer = &grad_buffer[nghrCount];
         recv_buffer = &recv_buffer[nghrCount];
@@ -308,14 +474,21 @@ private:
       FusedPairwiseReduceWithComm(
           entries, (uint8_t*)grad_buffer, (uint8_t*)recv_buffer,
           horovod_datatype, tensor_counts, tag, reduction_comms[comm_index],
-          (rank & level) == 0, normAndDots, global_state);
+          (rank & level) == 0, normAndDots, pipelined, global_state);
+    }
+
+    if (size != orgSize) {
+      FusedCombineGroups(entries, grad_buffer, recv_buffer, horovod_datatype,
+                         tensor_counts, total_counts_sum, global_rank, orgSize,
+                         communicator, tag, reduction_comms, normAndDots,
+                         global_state);
     }
 
     for (level = (size >> 1); level > 0; level = (level >> 1)) {
       if (level < start_level) {
         continue;
       }
-      int neighbor_rank = rank ^ level;
+      int neighbor_rank = group_offset + (rank ^ level);
 
       nghrCountVec_index--;
       int nghrCount = 0;
@@ -338,7 +511,83 @@ private:
       }
       myCount += nghrCount;
     }
-    size = orgSize;
+  }
+
+  // Combines the results of the groups of GetAdasumGroup in order, while each
+  // is scattered over the ranks of its group as left by the reduce-scatter
+  // half of VHDD. Every rank k of the first group receives the part of its
+  // slice from rank k % group_size of every other group, reduces it into its
+  // own slice and sends the result back, so that the ranks of all groups only
+  // exchange slices and the groups then allgather in parallel.
+  template <typename T>
+  void FusedCombineGroups(std::vector<TensorTableEntry>& entries,
+                          T* grad_buffer, T* recv_buffer,
+                          DataType horovod_datatype,
+                          std::vector<int>& tensor_counts, int total_count,
+                          int rank, int size, Communicator_type communicator,
+                          int tag, Communicator_type* reduction_comms,
+                          std::vector<double>& normAndDots,
+                          HorovodGlobalState* global_state) {
+    int per_element_size = DataType_Size(horovod_datatype);
+    int group_offset;
+    int group_size;
+    GetAdasumGroup(rank, size, group_offset, group_size);
+    int local_rank = rank - group_offset;
+    int my_begin;
+    int my_count;
+    GetVHDDSlice(total_count, local_rank, group_size, my_begin, my_count);
+
+    int first_offset;
+    int first_size;
+    GetAdasumGroup(0, size, first_offset, first_size);
+    int other_offset;
+    int other_size;
+
+    if (group_offset == 0) {
+      // The reduction comm of the last VHDD level spans the first group.
+      int comm_index = 0;
+      while ((2 << comm_index) < first_size) {
+        comm_index++;
+      }
+      for (int offset = first_size; offset < size; offset += other_size) {
+        GetAdasumGroup(offset, size, other_offset, other_size);
+        this->PointToPointSendRecv(
+            grad_buffer, 0, recv_buffer, my_count * per_element_size,
+            horovod_datatype, offset + local_rank % other_size, tag,
+            communicator, global_state);
+        FusedPairwiseReduceWithComm(entries, (uint8_t*)grad_buffer,
+                                    (uint8_t*)recv_buffer, horovod_datatype,
+                                    tensor_counts, tag,
+                                    reduction_comms[comm_index], true,
+                                    normAndDots, false, global_state);
+      }
+      for (int offset = first_size; offset < size; offset += other_size) {
+        GetAdasumGroup(offset, size, other_offset, other_size);
+        this->PointToPointSendRecv(
+            grad_buffer, my_count * per_element_size, recv_buffer, 0,
+            horovod_datatype, offset + local_rank % other_size, tag,
+            communicator, global_state);
+      }
+      return;
+    }
+
+    // Serve the ranks of the first group whose slices are part of ours.
+    int begin;
+    int count;
+    for (int k = local_rank; k < first_size; k += group_size) {
+      GetVHDDSlice(total_count, k, first_size, begin, count);
+      this->PointToPointSendRecv(&grad_buffer[begin - my_begin],
+                                 count * per_element_size, recv_buffer, 0,
+                                 horovod_datatype, k, tag, communicator,
+                                 global_state);
+    }
+    for (int k = local_rank; k < first_size; k += group_size) {
+      GetVHDDSlice(total_count, k, first_size, begin, count);
+      this->PointToPointSendRecv(grad_buffer, 0,
+                                 &grad_buffer[begin - my_begin],
+                                 count * per_element_size, horovod_datatype, k,
+                                 tag, communicator, global_state);
+    }
   }
 
   void FusedPairwiseReduceWithComm(std::vector<TensorTableEntry>& entries,
@@ -347,41 +596,27 @@ private:
                                    std::vector<int>& tensor_counts, int layerid,
                                    Communicator_type& comm, bool isLeftNeighbor,
                                    std::vector<double>& normAndDots,
+                                   bool normAndDotsComputed,
                                    HorovodGlobalState* global_state) {
     assert(!entries.empty());
-    auto& first_entry = entries[0];
-    assert(first_entry.process_set_id == 0);  // TODO: generalize
-    auto& process_set =
-      global_state->process_set_table.Get(first_entry.process_set_id);
+    assert(entries[0].process_set_id == 0);  // TODO: generalize
 
     static double sqrt_double_min = std::sqrt(DBL_MIN);
-    int per_element_size =
-        process_set.controller->GetTypeSize(horovod_datatype);
-    int bytesSoFar = 0;
-    for (size_t i = 0; i < tensor_counts.size(); i++) {
-      double dotProduct = 0.;
-      double anormsq = 0.;
-      double bnormsq = 0.;
-
-      DispatchComputeDotAndNormSqrds(&a[bytesSoFar], &b[bytesSoFar],
-                                     horovod_datatype, tensor_counts[i],
-                                     dotProduct, anormsq, bnormsq, layerid);
-      normAndDots[i * 3] = dotProduct;
-      if (isLeftNeighbor) {
-        normAndDots[i * 3 + 1] = anormsq;
-        normAndDots[i * 3 + 2] = bnormsq;
-      } else {
-        normAndDots[i * 3 + 1] = bnormsq;
-        normAndDots[i * 3 + 2] = anormsq;
+    if (!normAndDotsComputed) {
+      DispatchFusedComputeDotAndNormSqrds(a, b, horovod_datatype,
+                                          tensor_counts, normAndDots, layerid);
+    }
+    if (!isLeftNeighbor) {
+      for (size_t i = 0; i < tensor_counts.size(); i++) {
+        std::swap(normAndDots[i * 3 + 1], normAndDots[i * 3 + 2]);
       }
-      bytesSoFar += tensor_counts[i] * per_element_size;
     }
 
     SumAllreduceWithComm(entries, (void*)normAndDots.data(),
                          3 * tensor_counts.size(), DataType::HOROVOD_FLOAT64,
                          comm, global_state);
 
-    bytesSoFar = 0;
+    std::vector<double> coefficients(tensor_counts.size() * 2);
     for (size_t i = 0; i < tensor_counts.size(); i++) {
       double dotProduct = normAndDots[i * 3];
       double anormsq;
@@ -402,36 +637,28 @@ private:
       if (bnormsq >= sqrt_double_min) {
         bcoeff = 1.0 - dotProduct / bnormsq * 0.5;
       }
-
-      DispatchScaledAdd(horovod_datatype, tensor_counts[i], acoeff,
-                        &a[bytesSoFar], bcoeff, &b[bytesSoFar], layerid);
-      bytesSoFar += tensor_counts[i] * per_element_size;
+      coefficients[i * 2] = acoeff;
+      coefficients[i * 2 + 1] = bcoeff;
     }
+
+    DispatchFusedScaledAdd(horovod_datatype, tensor_counts, coefficients, a, b,
+                           layerid);
   }
 
   // Given two vectors compute their dot product and the squared norm for each.
+  // Runs on the SIMD kernels selected for the host CPU.
   template <typename T>
   void ComputeDotAndNormSqrds(const T* __restrict__ a, const T* __restrict__ b,
                               int count, double& dotProduct, double& anormsq,
                               double& bnormsq, int layerid) {
-    dotProduct = 0.;
-    anormsq = 0.;
-    bnormsq = 0.;
-
-    for (int i = 0; i < count; i++) {
-      dotProduct += (double)a[i] * (double)b[i];
-      anormsq += (double)a[i] * (double)a[i];
-      bnormsq += (double)b[i] * (double)b[i];
-    }
+    DotAndNormSqrdsCPU(a, b, count, dotProduct, anormsq, bnormsq);
   }
 
   // Update a vector to a linear combination of itself and another vector.
   template <typename T>
   void ScaledAdd(int n, double acoeff, T* __restrict__ a, double bcoeff,
                  T* __restrict__ b, int layerid) {
-    for (int i = 0; i < n; i++) {
-      a[i] = acoeff * a[i] + bcoeff * b[i];
-    }
+    ScaledAddCPU(a, b, n, (T)acoeff, (T)bcoeff);
   }
 
 
@@ -39,7 +39,9 @@ void AdasumMPI::InitializeVHDDReductionComms() {
   // subsequent groups grow to include any ranks the previous group
   // communicates with. Thus the sizes of the groups are 2,4,8... up to the
   // size of MPI_COMM_WORLD. In essence, a reduction group includes all nodes
-  // that a tensor may be split across.
+  // that a tensor may be split across. For a size that is not a power of two
+  // the groups stop at the size of the VHDD group of this rank, see
+  // GetAdasumGroup, and the remaining communicators are MPI_COMM_NULL.
   MPI_Group world_group;
   MPI_Comm_group(MPI_COMM_WORLD, &world_group);
   int nearest_power_2 = 1;
@@ -47,13 +49,20 @@ void AdasumMPI::InitializeVHDDReductionComms() {
   for (nearest_power_2 = 1, log_size = 0; (nearest_power_2 << 1) <= size;
         nearest_power_2 = (nearest_power_2 << 1), log_size++)
     ;
+  int group_offset;
+  int group_size;
+  GetAdasumGroup(rank, size, group_offset, group_size);
   int shift_val;
   int level;
   reduction_comms_ = new MPI_Comm[log_size];
+  for (int i = 0; i < log_size; i++) {
+    reduction_comms_[i] = MPI_COMM_NULL;
+  }
   int* node_rank = new int[size];
-  for (level = 1, shift_val = 1; level < nearest_power_2;
+  for (level = 1, shift_val = 1; level < group_size;
         level = (level << 1), shift_val++) {
-    int base_rank = ((rank >> shift_val) << shift_val);
+    int base_rank = group_offset +
+                    (((rank - group_offset) >> shift_val) << shift_val);
     for (int i = 0; i < (level << 1); i++) {
       node_rank[i] = (base_rank + i);
     }
@@ -106,7 +115,7 @@ void AdasumMPI::PointToPointSendRecv(
   int input_count = input_buffer_length / element_size;
   int output_count = output_buffer_length / element_size;
   int chunk_count =
-      std::max((int)(global_state->adasum_mpi_chunk_size / element_size), 1);
+      std::max((int)(global_state->parameter_manager.AdasumMPIChunkSize() / element_size), 1);
 
   for (int i = 0; i < std::max(input_count, output_count); i += chunk_count) {
     status = MPI_Sendrecv((char*)input_data_buffer + i * element_size,
@@ -123,5 +132,57 @@ void AdasumMPI::PointToPointSendRecv(
     }
   }
 }
+
+void AdasumMPI::PointToPointSendRecvPipelined(
+    void* input_data_buffer, int64_t input_buffer_length,
+    void* output_data_buffer, int64_t output_buffer_length,
+    DataType horovod_datatype, int dst_src_rank, int tag, MPI_Comm communicator,
+    HorovodGlobalState* global_state,
+    const std::function<void(int64_t, int64_t)>& on_recv_chunk) {
+  int element_size =
+      global_state->global_controller->GetTypeSize(horovod_datatype);
+  int input_count = input_buffer_length / element_size;
+  int output_count = output_buffer_length / element_size;
+  int chunk_count =
+      std::max((int)(global_state->parameter_manager.AdasumMPIChunkSize() / element_size), 1);
+  auto mpi_datatype = mpi_context_->GetMPIDataType(horovod_datatype);
+
+  // Post every chunk up front. Messages between two ranks with the same tag
+  // are matched in order, so chunk i of the sender lands in chunk i here.
+  std::vector<MPI_Request> recv_requests;
+  for (int i = 0; i < output_count; i += chunk_count) {
+    recv_requests.emplace_back();
+    if (MPI_Irecv((char*)output_data_buffer + (int64_t)i * element_size,
+                  std::min(chunk_count, output_count - i), mpi_datatype,
+                  dst_src_rank, tag, communicator,
+                  &recv_requests.back()) != MPI_SUCCESS) {
+      throw std::logic_error("MPI_Irecv failed, see MPI output for details.");
+    }
+  }
+  std::vector<MPI_Request> send_requests;
+  for (int i = 0; i < input_count; i += chunk_count) {
+    send_requests.emplace_back();
+    if (MPI_Isend((char*)input_data_buffer + (int64_t)i * element_size,
+                  std::min(chunk_count, input_count - i), mpi_datatype,
+                  dst_src_rank, tag, communicator,
+                  &send_requests.back()) != MPI_SUCCESS) {
+      throw std::logic_error("MPI_Isend failed, see MPI output for details.");
+    }
+  }
+
+  // Hand out each chunk as soon as it has arrived, the following ones keep
+  // moving in the meantime.
+  for (size_t k = 0; k < recv_requests.size(); k++) {
+    if (MPI_Wait(&recv_requests[k], MPI_STATUS_IGNORE) != MPI_SUCCESS) {
+      throw std::logic_error("MPI_Wait failed, see MPI output for details.");
+    }
+    int64_t begin = (int64_t)k * chunk_count;
+    on_recv_chunk(begin, std::min(begin + chunk_count, (int64_t)output_count));
+  }
+  if (MPI_Waitall((int)send_requests.size(), send_requests.data(),
+                  MPI_STATUSES_IGNORE) != MPI_SUCCESS) {
+    throw std::logic_error("MPI_Waitall failed, see MPI output for details.");
+  }
+}
 } // namespace common
 } // namespace horovod
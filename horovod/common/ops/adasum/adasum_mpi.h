@@ -42,6 +42,13 @@ protected:
                             int tag, MPI_Comm communicator,
                             HorovodGlobalState* global_state) override;
 
+  void PointToPointSendRecvPipelined(
+      void* input_data_buffer, int64_t input_buffer_length,
+      void* output_data_buffer, int64_t output_buffer_length,
+      DataType horovod_datatype, int dst_src_rank, int tag,
+      MPI_Comm communicator, HorovodGlobalState* global_state,
+      const std::function<void(int64_t, int64_t)>& on_recv_chunk) override;
+
   int GetLocalRankWithComm(MPI_Comm local_comm) override;
 
   int GetSizeWithComm(MPI_Comm comm) override;
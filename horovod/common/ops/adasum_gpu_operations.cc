@@ -15,9 +15,40 @@
 
 #include "adasum_gpu_operations.h"
 
+#if HAVE_CUDA
+#include "cuda/cuda_kernels.h"
+#endif
+
 namespace horovod {
 namespace common {
 
+#if HAVE_CUDA
+namespace {
+
+// Layout of the device workspace for capacity tensors.
+int64_t* WorkspaceOffsets(void* workspace) { return (int64_t*)workspace; }
+
+double* WorkspaceCoefficients(void* workspace, size_t capacity) {
+  return (double*)(WorkspaceOffsets(workspace) + capacity + 1);
+}
+
+double* WorkspacePartials(void* workspace, size_t capacity) {
+  return WorkspaceCoefficients(workspace, capacity) + 2 * capacity;
+}
+
+double* WorkspaceDotsAndNorms(void* workspace, size_t capacity) {
+  return WorkspacePartials(workspace, capacity) +
+         3 * ADASUM_BLOCKS_PER_TENSOR * capacity;
+}
+
+size_t WorkspaceBytes(size_t capacity) {
+  return sizeof(int64_t) * (capacity + 1) +
+         sizeof(double) * (2 + 3 * ADASUM_BLOCKS_PER_TENSOR + 3) * capacity;
+}
+
+} // namespace
+#endif
+
 AdasumGpuAllreduceOp::AdasumGpuAllreduceOp(MPIContext* mpi_context,
                                            NCCLContext* nccl_context,
                                            GPUContext* gpu_context,
@@ -35,6 +66,14 @@ AdasumGpuAllreduceOp::~AdasumGpuAllreduceOp() {
   if (gpu_op_context_.host_buffer != nullptr) {
     free(gpu_op_context_.host_buffer);
   }
+#if HAVE_CUDA
+  if (device_recv_buffer_ != nullptr) {
+    cudaFree(device_recv_buffer_);
+  }
+  if (device_workspace_ != nullptr) {
+    cudaFree(device_workspace_);
+  }
+#endif
 }
 
 void AdasumGpuAllreduceOp::WaitForData(std::vector<TensorTableEntry>& entries) {
@@ -61,6 +100,108 @@ uint8_t* AdasumGpuAllreduceOp::GetHostBuffer(uint64_t buffer_length) {
                                   buffer_length, current_host_buffer_length);
 }
 
+#if HAVE_CUDA
+uint8_t* AdasumGpuAllreduceOp::GetDeviceRecvBuffer(uint64_t buffer_length) {
+  if (buffer_length > current_device_recv_buffer_length_) {
+    if (device_recv_buffer_ != nullptr) {
+      gpu_context_->ErrorCheck("cudaFree", cudaFree(device_recv_buffer_));
+      device_recv_buffer_ = nullptr;
+    }
+    gpu_context_->ErrorCheck("cudaMalloc",
+                             cudaMalloc(&device_recv_buffer_, buffer_length));
+    current_device_recv_buffer_length_ = buffer_length;
+  }
+  return (uint8_t*)device_recv_buffer_;
+}
+
+void AdasumGpuAllreduceOp::UploadTensorOffsets(
+    const std::vector<int>& tensor_counts) {
+  size_t num_tensors = tensor_counts.size();
+  if (num_tensors > workspace_num_tensors_) {
+    if (device_workspace_ != nullptr) {
+      gpu_context_->ErrorCheck("cudaFree", cudaFree(device_workspace_));
+      device_workspace_ = nullptr;
+    }
+    gpu_context_->ErrorCheck(
+        "cudaMalloc",
+        cudaMalloc(&device_workspace_, WorkspaceBytes(num_tensors)));
+    workspace_num_tensors_ = num_tensors;
+  }
+  tensor_offsets_.resize(num_tensors + 1);
+  tensor_offsets_[0] = 0;
+  for (size_t i = 0; i < num_tensors; i++) {
+    tensor_offsets_[i + 1] = tensor_offsets_[i] + tensor_counts[i];
+  }
+  gpu_context_->MemcpyAsyncH2D(WorkspaceOffsets(device_workspace_),
+                               tensor_offsets_.data(),
+                               sizeof(int64_t) * tensor_offsets_.size(),
+                               *gpu_op_context_.stream);
+}
+
+void AdasumGpuAllreduceOp::PointToPointSendRecv(
+    void* input_data_buffer, int64_t input_buffer_length,
+    void* output_data_buffer, int64_t output_buffer_length,
+    DataType horovod_datatype, int dst_src_rank, int tag, MPI_Comm communicator,
+    HorovodGlobalState* global_state) {
+  if (device_buffers_) {
+    // MPI reads the device buffers directly, so the kernels writing them
+    // must have completed.
+    gpu_context_->StreamSynchronize(*gpu_op_context_.stream);
+  }
+  AdasumMPI::PointToPointSendRecv(input_data_buffer, input_buffer_length,
+                                  output_data_buffer, output_buffer_length,
+                                  horovod_datatype, dst_src_rank, tag,
+                                  communicator, global_state);
+}
+
+void AdasumGpuAllreduceOp::DispatchFusedComputeDotAndNormSqrds(
+    uint8_t* a, uint8_t* b, DataType horovod_datatype,
+    const std::vector<int>& tensor_counts, std::vector<double>& dots_and_norms,
+    int layerid) {
+  if (!device_buffers_) {
+    AdasumMPI::DispatchFusedComputeDotAndNormSqrds(
+        a, b, horovod_datatype, tensor_counts, dots_and_norms, layerid);
+    return;
+  }
+  auto& stream = *gpu_op_context_.stream;
+  int num_tensors = (int)tensor_counts.size();
+  UploadTensorOffsets(tensor_counts);
+  AdasumDotAndNormSqrdsCudaImpl(
+      a, b, WorkspaceOffsets(device_workspace_), num_tensors,
+      WorkspacePartials(device_workspace_, workspace_num_tensors_),
+      WorkspaceDotsAndNorms(device_workspace_, workspace_num_tensors_),
+      horovod_datatype, stream);
+  gpu_context_->ErrorCheck("AdasumDotAndNormSqrdsCudaImpl", cudaGetLastError());
+  gpu_context_->MemcpyAsyncD2H(
+      dots_and_norms.data(),
+      WorkspaceDotsAndNorms(device_workspace_, workspace_num_tensors_),
+      sizeof(double) * 3 * num_tensors, stream);
+  gpu_context_->StreamSynchronize(stream);
+}
+
+void AdasumGpuAllreduceOp::DispatchFusedScaledAdd(
+    DataType horovod_datatype, const std::vector<int>& tensor_counts,
+    const std::vector<double>& coefficients, uint8_t* a, uint8_t* b,
+    int layerid) {
+  if (!device_buffers_) {
+    AdasumMPI::DispatchFusedScaledAdd(horovod_datatype, tensor_counts,
+                                      coefficients, a, b, layerid);
+    return;
+  }
+  auto& stream = *gpu_op_context_.stream;
+  UploadTensorOffsets(tensor_counts);
+  double* device_coefficients =
+      WorkspaceCoefficients(device_workspace_, workspace_num_tensors_);
+  gpu_context_->MemcpyAsyncH2D(device_coefficients, coefficients.data(),
+                               sizeof(double) * 2 * tensor_counts.size(),
+                               stream);
+  AdasumScaledAddCudaImpl(a, b, WorkspaceOffsets(device_workspace_),
+                          device_coefficients, (int)tensor_counts.size(),
+                          horovod_datatype, stream);
+  gpu_context_->ErrorCheck("AdasumScaledAddCudaImpl", cudaGetLastError());
+}
+#endif
+
 Status
 AdasumGpuAllreduceOp::NcclHierarchical(std::vector<TensorTableEntry>& entries,
                                        const Response& response) {
@@ -82,7 +223,7 @@ AdasumGpuAllreduceOp::NcclHierarchical(std::vector<TensorTableEntry>& entries,
   const void* fused_input_data;
   void* buffer_data;
   size_t buffer_len;
-  uint8_t* host_buffer;
+  uint8_t* host_buffer = nullptr;
   // Copy memory into the fusion buffer.
   if (entries.size() > 1) {
     MemcpyInFusionBuffer(entries, fused_input_data, buffer_data, buffer_len);
@@ -195,22 +336,33 @@ AdasumGpuAllreduceOp::NcclHierarchical(std::vector<TensorTableEntry>& entries,
   }
 
   if (process_set.controller->IsHomogeneous() || is_root_rank) {
-    // cudaHostAlloc is significantly slower than malloc.  Pre-allocating
-    // a buffer is not safe since the tensor can be arbitrarily large.
-    host_buffer = GetHostBuffer((uint64_t)total_buffer_len);
+#if HAVE_CUDA
+    // Reduce across nodes in place on the device with CUDA-aware MPI.
+    bool gpu_direct = global_state_->adasum_gpu_direct;
+#else
+    bool gpu_direct = false;
+#endif
     // Synchronize.
     gpu_context_->WaitForEvents(gpu_op_context_.event_queue, entries,
                                  timeline, nullptr, global_state_->elastic_enabled);
 
-    // According to https://docs.nvidia.com/cuda/cuda-runtime-api/
-    // api-sync-behavior.html#api-sync-behavior__memcpy-async,
-    // cudaMemcpyAsync is synchronous with respect to the host, so we
-    // memcpy (effectively) synchronously to generate an accurate timeline
-    timeline.ActivityStartAll(entries, MEMCPY_IN_HOST_BUFFER);
-    gpu_context_->MemcpyAsyncD2H(host_buffer, buffer_data_at_rank_offset,
-                                 total_buffer_len, *gpu_op_context_.stream);
-
-    timeline.ActivityEndAll(entries);
+    void* adasum_buffer = buffer_data_at_rank_offset;
+    if (!gpu_direct) {
+      // cudaHostAlloc is significantly slower than malloc.  Pre-allocating
+      // a buffer is not safe since the tensor can be arbitrarily large.
+      host_buffer = GetHostBuffer((uint64_t)total_buffer_len);
+
+      // According to https://docs.nvidia.com/cuda/cuda-runtime-api/
+      // api-sync-behavior.html#api-sync-behavior__memcpy-async,
+      // cudaMemcpyAsync is synchronous with respect to the host, so we
+      // memcpy (effectively) synchronously to generate an accurate timeline
+      timeline.ActivityStartAll(entries, MEMCPY_IN_HOST_BUFFER);
+      gpu_context_->MemcpyAsyncD2H(host_buffer, buffer_data_at_rank_offset,
+                                   total_buffer_len, *gpu_op_context_.stream);
+
+      timeline.ActivityEndAll(entries);
+      adasum_buffer = host_buffer;
+    }
 
     timeline.ActivityStartAll(entries, MPI_ADASUM_ALLREDUCE);
 
@@ -258,21 +410,32 @@ AdasumGpuAllreduceOp::NcclHierarchical(std::vector<TensorTableEntry>& entries,
       }
     }
 
+#if HAVE_CUDA
+    auto recv_buffer = gpu_direct ? GetDeviceRecvBuffer(total_buffer_len)
+                                  : GetRecvBuffer(total_buffer_len);
+    device_buffers_ = gpu_direct;
+#else
     auto recv_buffer = GetRecvBuffer(total_buffer_len);
+#endif
     DispatchFusedAllreduce(
-        entries, (void*)host_buffer, (void*)recv_buffer, tensor_counts,
+        entries, adasum_buffer, (void*)recv_buffer, tensor_counts,
         local_size, // start_level
         mpi_context_->GetMPICommunicator(process_set.controller->IsHomogeneous()
                                     ? Communicator::GLOBAL
                                     : Communicator::CROSS),
         0, reduction_comms_, first_entry.tensor->dtype(), global_state_);
+#if HAVE_CUDA
+    device_buffers_ = false;
+#endif
     timeline.ActivityEndAll(entries);
 
-    timeline.ActivityStartAll(entries, MEMCPY_OUT_HOST_BUFFER);
-    gpu_context_->MemcpyAsyncH2D(buffer_data_at_rank_offset,
-                                 host_buffer, total_buffer_len,
-                                 *gpu_op_context_.stream);
-    timeline.ActivityEndAll(entries);
+    if (!gpu_direct) {
+      timeline.ActivityStartAll(entries, MEMCPY_OUT_HOST_BUFFER);
+      gpu_context_->MemcpyAsyncH2D(buffer_data_at_rank_offset,
+                                   host_buffer, total_buffer_len,
+                                   *gpu_op_context_.stream);
+      timeline.ActivityEndAll(entries);
+    }
   }
 
   if (num_elements_per_rank > 0) {
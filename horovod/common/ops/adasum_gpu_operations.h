@@ -38,6 +38,12 @@ public:
   Status Execute(std::vector<TensorTableEntry>& entries,
                  const Response& response) override;
 
+  void AddMemoryUsage(MemoryUsage& usage) const override {
+    usage[std::make_pair(CPU_DEVICE_ID, "adasum")] += RecvBufferBytes();
+  }
+
+  void ReleaseBuffers() override { ReleaseRecvBuffer(); }
+
 protected:
   void WaitForData(std::vector<TensorTableEntry>& entries) override;
 
@@ -47,8 +53,52 @@ protected:
   // Get host buffer
   uint8_t* GetHostBuffer(uint64_t buffer_length);
 
+#if HAVE_CUDA
+  void PointToPointSendRecv(void* input_data_buffer,
+                            int64_t input_buffer_length,
+                            void* output_data_buffer,
+                            int64_t output_buffer_length,
+                            DataType horovod_datatype, int dst_src_rank,
+                            int tag, MPI_Comm communicator,
+                            HorovodGlobalState* global_state) override;
+
+  // Device buffers are reduced by one kernel launch per level instead.
+  bool PipelineDotProducts() const override { return !device_buffers_; }
+
+  void DispatchFusedComputeDotAndNormSqrds(
+      uint8_t* a, uint8_t* b, DataType horovod_datatype,
+      const std::vector<int>& tensor_counts,
+      std::vector<double>& dots_and_norms, int layerid) override;
+
+  void DispatchFusedScaledAdd(DataType horovod_datatype,
+                              const std::vector<int>& tensor_counts,
+                              const std::vector<double>& coefficients,
+                              uint8_t* a, uint8_t* b, int layerid) override;
+
+  // Get device buffer used as recv buffer by GPU-direct Adasum
+  uint8_t* GetDeviceRecvBuffer(uint64_t buffer_length);
+
+  // Copies the element offsets of tensor_counts to the device workspace,
+  // growing it as needed.
+  void UploadTensorOffsets(const std::vector<int>& tensor_counts);
+#endif
+
 private:
   uint64_t current_host_buffer_length;
+
+#if HAVE_CUDA
+  // Whether the buffers passed to the Adasum algorithm live on the device.
+  bool device_buffers_ = false;
+
+  void* device_recv_buffer_ = nullptr;
+  uint64_t current_device_recv_buffer_length_ = 0;
+
+  // Device storage for tensor offsets, coefficients and the partial and
+  // final dot products and norms of up to workspace_num_tensors_ tensors.
+  void* device_workspace_ = nullptr;
+  size_t workspace_num_tensors_ = 0;
+  std::vector<int64_t> tensor_offsets_;
+#endif
 };
 } // namespace common
 } // namespace horovod
@@ -36,6 +36,12 @@ public:
   bool Enabled(const ParameterManager& param_manager,
                const std::vector<TensorTableEntry>& entries,
                const Response& response) const override;
+
+  void AddMemoryUsage(MemoryUsage& usage) const override {
+    usage[std::make_pair(CPU_DEVICE_ID, "adasum")] += RecvBufferBytes();
+  }
+
+  void ReleaseBuffers() override { ReleaseRecvBuffer(); }
 };
 
 } // namespace common
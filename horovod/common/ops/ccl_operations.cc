@@ -17,6 +17,10 @@
 
 #include "ccl_operations.h"
 
+#include <algorithm>
+
+#include "../topology.h"
+
 namespace horovod {
 namespace common {
 
@@ -31,7 +35,8 @@ struct ccl4hvd {
   ccl::communicator comm_;
 };
 
-// We assume there is only a single thread executing the CollOps.
+// We assume there is only a single thread executing the CollOps. The
+// completion thread only uses the stateless copy helpers.
 class CCLOpContext {
 public:
   // We use this for temporarily storing the queue between calls
@@ -120,10 +125,25 @@ void CCLContext::Initialize() {
   opctxt_ = NewOpContext();
   enable_cache = GetBoolEnvOrDefault(HOROVOD_CCL_CACHE, false);
 
-  LOG(DEBUG) << "CCL context initialized, enable_cache " << enable_cache;
+  int max_outstanding = GetIntEnvOrDefault(HOROVOD_CCL_MAX_OUTSTANDING, 2);
+  slot_busy_.assign(std::max(max_outstanding, 1), false);
+  next_slot_ = 0;
+  completion_running_ = true;
+  completion_thread_ = std::thread(&CCLContext::CompletionLoop, this);
+
+  LOG(DEBUG) << "CCL context initialized, enable_cache " << enable_cache
+             << ", max_outstanding " << slot_busy_.size();
 }
 
 void CCLContext::Finalize() {
+  if (completion_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> guard(completion_mutex_);
+      completion_running_ = false;
+    }
+    completion_cond_.notify_one();
+    completion_thread_.join();
+  }
   if (opctxt_) {
     delete opctxt_;
     opctxt_ = nullptr;
@@ -133,6 +153,82 @@ void CCLContext::Finalize() {
 
 CCLOpContext* CCLContext::NewOpContext() { return new CCLOpContext(); }
 
+int CCLContext::AcquireSlot() {
+  std::unique_lock<std::mutex> lock(completion_mutex_);
+  slot_cond_.wait(lock, [this] { return !slot_busy_[next_slot_]; });
+  int slot = next_slot_;
+  next_slot_ = (next_slot_ + 1) % (int)slot_busy_.size();
+  return slot;
+}
+
+void CCLContext::EnqueueCompletion(CCLCompletion&& completion) {
+  {
+    std::lock_guard<std::mutex> guard(completion_mutex_);
+    if (completion.slot >= (int)slot_busy_.size()) {
+      completion.slot = -1;
+    }
+    if (completion.slot >= 0) {
+      slot_busy_[completion.slot] = true;
+    }
+    completions_.push_back(std::move(completion));
+  }
+  completion_cond_.notify_one();
+}
+
+void CCLContext::CompletionLoop() {
+  PlaceHelperThread();
+  while (true) {
+    CCLCompletion completion;
+    {
+      std::unique_lock<std::mutex> lock(completion_mutex_);
+      // Drain the outstanding requests before stopping.
+      completion_cond_.wait(lock, [this] {
+        return !completion_running_ || !completions_.empty();
+      });
+      if (completions_.empty()) {
+        return;
+      }
+      completion = std::move(completions_.front());
+      completions_.pop_front();
+    }
+
+    // CCL progresses requests on its own worker threads, so blocking on the
+    // oldest one costs no more than polling all of them.
+    Status status = Status::OK();
+    try {
+      for (auto& event : completion.events) {
+        event.wait();
+      }
+    } catch (const std::exception& ex) {
+      status = Status::UnknownError(ex.what());
+    }
+    completion.timeline->ActivityEndAll(completion.entries);
+
+    if (status.ok() && completion.finalize) {
+      try {
+        completion.finalize(completion.entries);
+      } catch (const std::exception& ex) {
+        status = Status::UnknownError(ex.what());
+      }
+    }
+
+    for (auto& e : completion.entries) {
+      completion.timeline->End(e.tensor_name,
+                               status.ok() ? e.output : nullptr);
+      e.FinishWithCallback(status);
+    }
+
+    completion.fusion_buffer.reset();
+    if (completion.slot >= 0) {
+      {
+        std::lock_guard<std::mutex> guard(completion_mutex_);
+        slot_busy_[completion.slot] = false;
+      }
+      slot_cond_.notify_one();
+    }
+  }
+}
+
 // ************************************************************************************
 // ************************************************************************************
 
@@ -162,6 +258,22 @@ inline ccl::datatype GetCCLDataType(const std::shared_ptr<Tensor>& tensor) {
   }
 }
 
+inline ccl::reduction GetCCLReduction(ReduceOp reduce_op) {
+  switch (reduce_op) {
+  case ReduceOp::SUM:
+    return ccl::reduction::sum;
+  case ReduceOp::MIN:
+    return ccl::reduction::min;
+  case ReduceOp::MAX:
+    return ccl::reduction::max;
+  case ReduceOp::PRODUCT:
+    return ccl::reduction::prod;
+  default:
+    throw std::logic_error("Reduce op " + ReduceOp_Name(reduce_op) +
+                           " is not supported in CCL.");
+  }
+}
+
 // ************************************************************************************
 // ************************************************************************************
 
@@ -191,6 +303,30 @@ memcpyEntryOutFusionBuffer(const std::vector<TensorTableEntry>& entries,
                     buffer_data_at_offset, entry_size);
 }
 
+// Hands the entries over to the completion thread, which finishes them once
+// events have completed. The fusion buffer of the current slot is kept until
+// then.
+Status CompleteAsync(
+    CCLContext* ccl_context, HorovodGlobalState* global_state,
+    std::vector<TensorTableEntry>& entries, std::vector<ccl::event>&& events,
+    std::function<void(std::vector<TensorTableEntry>&)> finalize = nullptr) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state->process_set_table.Get(first_entry.process_set_id);
+
+  CCLCompletion completion;
+  completion.events = std::move(events);
+  completion.entries = entries;
+  completion.timeline = &global_state->timeline;
+  completion.finalize = std::move(finalize);
+  completion.fusion_buffer = process_set.fusion_buffer.GetBuffer(
+      first_entry.device, first_entry.context->framework(),
+      global_state->current_nccl_stream);
+  completion.slot = process_set.fusion_buffer.HostSlot();
+  ccl_context->EnqueueCompletion(std::move(completion));
+  return Status::InProgress();
+}
+
 } // namespace
 
 // ************************************************************************************
@@ -281,6 +417,14 @@ Status CCLAllreduce::Execute(std::vector<TensorTableEntry>& entries,
     for (size_t idx = 0; idx < entries.size(); idx++) {
       match_id += "_" + entries[idx].tensor_name;
     }
+    // A fused response always finds the fusion buffer of its slot in the
+    // cached operation.
+    if (entries.size() > 1) {
+      auto& process_set =
+          global_state_->process_set_table.Get(entries[0].process_set_id);
+      match_id +=
+          "_slot_" + std::to_string(process_set.fusion_buffer.HostSlot());
+    }
 
     attr.set<ccl::operation_attr_id::match_id>(ccl::string_class(match_id));
     attr.set<ccl::operation_attr_id::to_cache>(true);
@@ -295,29 +439,32 @@ Status CCLAllreduce::Execute(std::vector<TensorTableEntry>& entries,
     attr.set<ccl::operation_attr_id::to_cache>(false);
   }
 
-  ccl::allreduce((void*)sendbuf, buffer_data, num_elements,
-                 GetCCLDataType(first_entry.tensor), ccl::reduction::sum,
-                 c4h.comm_, c4h.stream_, attr)
-      .wait();
-  timeline.ActivityEndAll(entries);
-
-  if (response.postscale_factor() != 1.0) {
-    // Execute postscaling op
-    ScaleBuffer(response.postscale_factor(), entries, buffer_data, buffer_data,
-                num_elements);
-  }
-
-  // Copy memory out of the fusion buffer.
-  if (entries.size() > 1) {
-    timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
-    MemcpyOutFusionBuffer(buffer_data, entries);
-    this->ccl_context_->opctxt_->wait();
-    timeline.ActivityEndAll(entries);
-  }
-
-  LOG(DEBUG) << "CCLAllreduce::Execute done";
-
-  return Status::OK();
+  std::vector<ccl::event> events;
+  events.push_back(ccl::allreduce((void*)sendbuf, buffer_data, num_elements,
+                                  GetCCLDataType(first_entry.tensor),
+                                  GetCCLReduction(response.reduce_op()),
+                                  c4h.comm_, c4h.stream_, attr));
+
+  LOG(DEBUG) << "CCLAllreduce::Execute launched";
+
+  // Postscale and copy out of the fusion buffer once the allreduce is done.
+  double postscale_factor = response.postscale_factor();
+  return CompleteAsync(
+      this->ccl_context_, global_state_, entries, std::move(events),
+      [this, buffer_data, num_elements,
+       postscale_factor](std::vector<TensorTableEntry>& entries) {
+        if (postscale_factor != 1.0) {
+          ScaleBuffer(postscale_factor, entries, buffer_data, buffer_data,
+                      num_elements);
+        }
+        if (entries.size() > 1) {
+          auto& timeline = global_state_->timeline;
+          timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+          MemcpyOutFusionBuffer(buffer_data, entries);
+          this->ccl_context_->opctxt_->wait();
+          timeline.ActivityEndAll(entries);
+        }
+      });
 }
 
 // ************************************************************************************
@@ -360,95 +507,78 @@ Status CCLAllgather::Execute(std::vector<TensorTableEntry>& entries,
   // shortcut for single rank
   if (global_state_->global_controller->GetSize() == 1) {
     int64_t** entry_component_sizes = nullptr;
-    int* recvcounts = nullptr;
+    int64_t* recvcounts = nullptr;
     status =
         AllocateOutput(entries, response, entry_component_sizes, recvcounts);
     return status.ok() ? cpyIn2Out(entries, this->ccl_context_->opctxt_)
                        : status;
   }
 
-  // Sizes of subcomponents of each entry from all ranks
-  auto** entry_component_sizes = new int64_t*[entries.size()];
-
-  // Offset of each subcomponent of every entry in the final buffer after
-  // allgatherv
-  auto** entry_component_offsets = new int64_t*[entries.size()];
-
   int global_size = global_state_->global_controller->GetSize();
-  auto* recvcounts = new int[global_size]();
-  auto* displcmnts = new int[global_size]();
-
-  for (size_t ec = 0; ec < entries.size(); ++ec) {
-    entry_component_sizes[ec] = new int64_t[global_size]();
-    entry_component_offsets[ec] = new int64_t[global_size]();
-  }
+  auto layout = std::make_shared<AllgatherLayout>(entries.size(), global_size);
 
   timeline.ActivityStartAll(entries, ALLOCATE_OUTPUT);
-  status = AllocateOutput(entries, response, entry_component_sizes, recvcounts);
-  if (status.ok()) {
-    timeline.ActivityEndAll(entries);
-    SetDisplacements(recvcounts, displcmnts, global_size);
-    SetEntryComponentOffsets(entries, entry_component_sizes, recvcounts,
-                             entry_component_offsets);
-
-    int element_size = global_state_->global_controller->GetTypeSize(
-        first_entry.tensor->dtype());
-
-    const void* sendbuf = nullptr;
-    void* buffer_data;
-    int64_t num_elements = NumElements(entries);
-    int64_t gather_size = 0;
-
-    if (entries.size() > 1) {
-      timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
-      MemcpyInFusionBuffer(entries, displcmnts, element_size, buffer_data);
-      this->ccl_context_->opctxt_->wait();
-      timeline.ActivityEndAll(entries);
-    } else {
-      if (first_entry.tensor->data() == first_entry.output->data()) {
-        throw std::logic_error(
-            "inplace allgather with single entry not implemented yet.");
-      }
-      sendbuf = first_entry.tensor->data();
-      buffer_data = const_cast<void*>(first_entry.output->data());
-    }
+  status = AllocateOutput(entries, response, layout->entry_component_sizes,
+                          layout->recvcounts);
+  if (!status.ok()) {
+    return status;
+  }
+  timeline.ActivityEndAll(entries);
+  SetDisplacements(layout->recvcounts, layout->displcmnts, global_size);
+  SetEntryComponentOffsets(entries, layout->entry_component_sizes,
+                           layout->recvcounts,
+                           layout->entry_component_offsets);
 
-    std::vector<size_t> rcounts(global_size);
-    for (unsigned int rc = 0; rc < global_size; rc++) {
-      rcounts[rc] = recvcounts[rc] * element_size;
-      gather_size += rcounts[rc];
-    }
+  int element_size = global_state_->global_controller->GetTypeSize(
+      first_entry.tensor->dtype());
 
-    global_state_->timeline.ActivityStartAll(entries, CCL_ALLGATHER);
-    ccl::allgatherv(sendbuf != nullptr ? (void*)sendbuf : buffer_data,
-                    num_elements * element_size, buffer_data, rcounts,
-                    ccl::datatype::int8, c4h.comm_, c4h.stream_)
-        .wait();
-    global_state_->timeline.ActivityEndAll(entries);
+  const void* sendbuf = nullptr;
+  void* buffer_data;
+  int64_t num_elements = NumElements(entries);
 
-    if (entries.size() > 1) {
-      timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
-      MemcpyOutFusionBuffer(entry_component_offsets, entry_component_sizes,
-                            buffer_data, element_size, entries);
-      this->ccl_context_->opctxt_->wait();
-      timeline.ActivityEndAll(entries);
+  if (entries.size() > 1) {
+    timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+    MemcpyInFusionBuffer(entries, layout->displcmnts, element_size,
+                         buffer_data);
+    this->ccl_context_->opctxt_->wait();
+    timeline.ActivityEndAll(entries);
+  } else {
+    if (first_entry.tensor->data() == first_entry.output->data()) {
+      throw std::logic_error(
+          "inplace allgather with single entry not implemented yet.");
     }
-    status = Status::OK();
+    sendbuf = first_entry.tensor->data();
+    buffer_data = const_cast<void*>(first_entry.output->data());
   }
 
-  /* Cleanup */
-  for (size_t ec = 0; ec < entries.size(); ++ec) {
-    delete[] entry_component_sizes[ec];
-    delete[] entry_component_offsets[ec];
+  std::vector<size_t> rcounts(global_size);
+  for (int rc = 0; rc < global_size; rc++) {
+    rcounts[rc] = layout->recvcounts[rc] * element_size;
   }
-  delete[] entry_component_sizes;
-  delete[] entry_component_offsets;
-  delete[] recvcounts;
-  delete[] displcmnts;
 
-  LOG(DEBUG) << "CCLAllgather::Execute done";
-
-  return status;
+  timeline.ActivityStartAll(entries, CCL_ALLGATHER);
+  std::vector<ccl::event> events;
+  events.push_back(
+      ccl::allgatherv(sendbuf != nullptr ? (void*)sendbuf : buffer_data,
+                      num_elements * element_size, buffer_data, rcounts,
+                      ccl::datatype::int8, c4h.comm_, c4h.stream_));
+
+  LOG(DEBUG) << "CCLAllgather::Execute launched";
+
+  return CompleteAsync(
+      this->ccl_context_, global_state_, entries, std::move(events),
+      [this, layout, buffer_data,
+       element_size](std::vector<TensorTableEntry>& entries) {
+        if (entries.size() > 1) {
+          auto& timeline = global_state_->timeline;
+          timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+          MemcpyOutFusionBuffer(layout->entry_component_offsets,
+                                layout->entry_component_sizes, buffer_data,
+                                element_size, entries);
+          this->ccl_context_->opctxt_->wait();
+          timeline.ActivityEndAll(entries);
+        }
+      });
 }
 
 // ************************************************************************************
@@ -458,31 +588,36 @@ Status CCLBroadcast::Execute(std::vector<TensorTableEntry>& entries,
                              const Response& response) {
   WaitForData(entries);
 
-  assert(entries.size() == 1);
-  auto& e = entries[0];
-  assert(e.process_set_id == 0);  // TODO: generalize
+  assert(!entries.empty());
+  auto& first_entry = entries[0];
+  assert(first_entry.process_set_id == 0);  // TODO: generalize
   LOG(DEBUG) << "CCLBroadcast::Execute #entries: " << entries.size()
-             << " device " << e.device;
-  auto& c4h = this->ccl_context_->opctxt_->GetCCL4HVD(e, global_state_);
+             << " device " << first_entry.device;
+  auto& c4h = this->ccl_context_->opctxt_->GetCCL4HVD(first_entry, global_state_);
+
+  // shortcut for single rank
+  if (global_state_->global_controller->GetSize() == 1) {
+    return Status::OK();
+  }
 
   global_state_->timeline.ActivityStartAll(entries, CCL_BCAST);
 
-  // shortcut for single rank
-  if (global_state_->global_controller->GetSize() > 1) {
-    // On root rank, CCL_Bcast sends data, on other ranks it receives data.
+  // On root rank, CCL_Bcast sends data, on other ranks it receives data.
+  // Fused entries are broadcast one after the other, all in flight at once.
+  std::vector<ccl::event> events;
+  for (auto& e : entries) {
     const bool amroot = global_state_->global_controller->GetRank() == e.root_rank;
     size_t size = e.tensor->size();
     void* data_ptr = const_cast<void*>((amroot ? e.tensor : e.output)->data());
 
-    ccl::broadcast(data_ptr, size, ccl::datatype::int8, e.root_rank, c4h.comm_,
-                   c4h.stream_)
-        .wait();
+    events.push_back(ccl::broadcast(data_ptr, size, ccl::datatype::int8,
+                                    e.root_rank, c4h.comm_, c4h.stream_));
   }
 
-  global_state_->timeline.ActivityEndAll(entries);
-  LOG(DEBUG) << "CCLBroadcast::Execute done";
+  LOG(DEBUG) << "CCLBroadcast::Execute launched";
 
-  return Status::OK();
+  return CompleteAsync(this->ccl_context_, global_state_, entries,
+                       std::move(events));
 }
 
 // ************************************************************************************
@@ -512,14 +647,66 @@ Status CCLAlltoall::Execute(std::vector<TensorTableEntry>& entries,
   const void* sendbuf = e.tensor->data();
   void* buffer_data = (void*)e.output->data();
 
-  ccl::alltoallv(sendbuf, sendcounts, buffer_data, recvcounts,
-                 GetCCLDataType(e.tensor), c4h.comm_, c4h.stream_)
-      .wait();
+  std::vector<ccl::event> events;
+  events.push_back(ccl::alltoallv(sendbuf, sendcounts, buffer_data, recvcounts,
+                                  GetCCLDataType(e.tensor), c4h.comm_,
+                                  c4h.stream_));
 
-  global_state_->timeline.ActivityEndAll(entries);
-  LOG(DEBUG) << "CCLAlltoall::Execute done";
+  LOG(DEBUG) << "CCLAlltoall::Execute launched";
 
-  return Status::OK();
+  return CompleteAsync(this->ccl_context_, global_state_, entries,
+                       std::move(events));
+}
+
+// ************************************************************************************
+// ************************************************************************************
+
+Status CCLReducescatter::Execute(std::vector<TensorTableEntry>& entries,
+                                 const Response& response) {
+  WaitForData(entries);
+
+  assert(entries.size() == 1);
+  auto& e = entries[0];
+  LOG(DEBUG) << "CCLReducescatter::Execute #entries: " << entries.size()
+             << " device " << e.device;
+  auto& c4h = this->ccl_context_->opctxt_->GetCCL4HVD(e, global_state_);
+
+  auto& timeline = global_state_->timeline;
+  int global_size = global_state_->global_controller->GetSize();
+  auto output_shapes = ComputeOutputShapes(entries, global_size);
+
+  timeline.ActivityStartAll(entries, ALLOCATE_OUTPUT);
+  Status status = AllocateOutput(entries, output_shapes);
+  if (!status.ok()) {
+    return status;
+  }
+  timeline.ActivityEndAll(entries);
+
+  // All ranks receive the same count, see Enabled().
+  int64_t recv_count = output_shapes[0][0].num_elements();
+  void* buffer_data = (void*)e.output->data();
+
+  timeline.ActivityStartAll(entries, CCL_REDUCESCATTER);
+  std::vector<ccl::event> events;
+  events.push_back(ccl::reduce_scatter(
+      e.tensor->data(), buffer_data, (size_t)recv_count,
+      GetCCLDataType(e.tensor), ccl::reduction::sum, c4h.comm_, c4h.stream_));
+
+  LOG(DEBUG) << "CCLReducescatter::Execute launched";
+
+  // The input can't be scaled out of place into the smaller output, fold
+  // prescaling into postscaling instead.
+  double postscale_factor =
+      response.prescale_factor() * response.postscale_factor();
+  return CompleteAsync(
+      this->ccl_context_, global_state_, entries, std::move(events),
+      [this, buffer_data, recv_count,
+       postscale_factor](std::vector<TensorTableEntry>& entries) {
+        if (postscale_factor != 1.0) {
+          ScaleBuffer(postscale_factor, entries, buffer_data, buffer_data,
+                      recv_count);
+        }
+      });
 }
 
 } // namespace common
@@ -18,8 +18,14 @@
 #ifndef HOROVOD_CCL_OPERATIONS_H
 #define HOROVOD_CCL_OPERATIONS_H
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <mutex>
 #include <pthread.h>
+#include <thread>
+#include <vector>
 
 #include "oneapi/ccl.hpp"
 
@@ -34,20 +40,58 @@ namespace common {
 // Context used for internal machinery
 class CCLOpContext;
 
+// Work left to do once the CCL requests launched for a response have
+// completed.
+struct CCLCompletion {
+  std::vector<ccl::event> events;
+  std::vector<TensorTableEntry> entries;
+  Timeline* timeline = nullptr;
+
+  // Runs on the completion thread once all events have completed, for
+  // example to copy the result out of the fusion buffer.
+  std::function<void(std::vector<TensorTableEntry>&)> finalize;
+
+  // Released once the response has completed.
+  std::shared_ptr<PersistentBuffer> fusion_buffer;
+  int slot = -1;
+};
+
 // CCL Context used to control CCL as a whole from the outside
 class CCLContext {
 public:
   CCLContext();
   void Initialize();
+  // Waits for the outstanding requests before shutting down.
   void Finalize();
   bool IsInited() { return opctxt_ != nullptr; }
 
+  // Returns the next of the HOROVOD_CCL_MAX_OUTSTANDING request slots, once
+  // the request last launched from it has completed. A response fuses into
+  // the host fusion buffer of its slot, so that buffer is never overwritten
+  // while a request still reads from it.
+  int AcquireSlot();
+
+  // Finishes the entries of completion on the completion thread. Responses
+  // complete in the order they were launched, like CCL runs them.
+  void EnqueueCompletion(CCLCompletion&& completion);
+
   bool enable_cache;
 
   CCLOpContext* opctxt_;
 
 private:
   CCLOpContext* NewOpContext();
+
+  void CompletionLoop();
+
+  std::thread completion_thread_;
+  std::deque<CCLCompletion> completions_;
+  std::vector<bool> slot_busy_;
+  int next_slot_ = 0;
+  bool completion_running_ = false;
+  std::mutex completion_mutex_;
+  std::condition_variable completion_cond_;
+  std::condition_variable slot_cond_;
 };
 
 // Common operation base class
@@ -125,6 +169,41 @@ public:
 
   Status Execute(std::vector<TensorTableEntry>& entries,
                  const Response& response) override;
+
+protected:
+  // Fused alltoalls are left to the MPI implementation.
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override {
+    return entries.size() == 1 &&
+           CCLOp<AlltoallOp>::Enabled(param_manager, entries, response);
+  }
+};
+
+class CCLReducescatter : public CCLOp<ReducescatterOp> {
+public:
+  using CCLOp<ReducescatterOp>::CCLOp;
+
+  Status Execute(std::vector<TensorTableEntry>& entries,
+                 const Response& response) override;
+
+protected:
+  // ccl::reduce_scatter needs the same count on every rank. Fused
+  // reducescatters and first dimensions that do not divide evenly are left
+  // to the MPI or Gloo implementation.
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override {
+    if (entries.size() != 1 || entries[0].process_set_id != 0 ||
+        !CCLOp<ReducescatterOp>::Enabled(param_manager, entries, response)) {
+      return false;
+    }
+    const auto& shape = entries[0].tensor->shape();
+    return shape.dims() > 0 &&
+           shape.dim_size(0) %
+                   this->global_state_->global_controller->GetSize() ==
+               0;
+  }
 };
 
 } // namespace common
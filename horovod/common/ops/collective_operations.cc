@@ -16,6 +16,7 @@
 // =============================================================================
 
 #include "collective_operations.h"
+#include "cpu_kernels.h"
 #include "../message.h"
 
 namespace horovod {
@@ -32,6 +33,22 @@ int64_t HorovodOp::NumElements(std::vector<TensorTableEntry>& entries) {
   return num_elements;
 }
 
+void HorovodOp::MemcpyCPU(void* dst, const void* src, size_t count) {
+  global_state_->cpu_thread_pool.ParallelFor(
+      (int64_t)count, CPU_MEMCPY_GRAIN, [&](int64_t begin, int64_t end) {
+        std::memcpy((uint8_t*)dst + begin, (const uint8_t*)src + begin,
+                    (size_t)(end - begin));
+      });
+}
+
+void HorovodOp::RecordFusionCopyTime(
+    const std::vector<TensorTableEntry>& entries,
+    std::chrono::steady_clock::time_point start) {
+  if (!entries.empty() && entries[0].device == CPU_DEVICE_ID) {
+    global_state_->metrics.AddTimeSince(METRIC_FUSION_COPY_TIME_US, start);
+  }
+}
+
 void HorovodOp::WaitForData(std::vector<TensorTableEntry>& entries) {
   // On GPU data readiness is signalled by ready_event.
   auto& timeline = global_state_->timeline;
@@ -68,9 +85,12 @@ AllreduceOp::AllreduceOp(HorovodGlobalState* global_state)
 void AllreduceOp::MemcpyInFusionBuffer(
     const std::vector<TensorTableEntry>& entries, const void*& fused_input_data,
     void*& buffer_data, size_t& buffer_len) {
+  auto start = std::chrono::steady_clock::now();
   // Access the fusion buffer.
   auto& first_entry = entries[0];
-  auto buffer = global_state_->fusion_buffer.GetBuffer(
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto buffer = process_set.fusion_buffer.GetBuffer(
       first_entry.device, first_entry.context->framework(), global_state_->current_nccl_stream);
   buffer_data = const_cast<void*>(buffer->AccessData(first_entry.context));
 
@@ -80,6 +100,7 @@ void AllreduceOp::MemcpyInFusionBuffer(
     MemcpyEntryInFusionBuffer(entries, e, buffer_data_at_offset);
     offset += e.tensor->size();
   }
+  RecordFusionCopyTime(entries, start);
 
   buffer_len = (size_t)offset;
 
@@ -89,55 +110,147 @@ void AllreduceOp::MemcpyInFusionBuffer(
 
 void AllreduceOp::MemcpyOutFusionBuffer(
     const void* buffer_data, std::vector<TensorTableEntry>& entries) {
+  auto start = std::chrono::steady_clock::now();
   int64_t offset = 0;
   for (auto& e : entries) {
     void* buffer_data_at_offset = (uint8_t*)buffer_data + offset;
     MemcpyEntryOutFusionBuffer(entries, buffer_data_at_offset, e);
     offset += e.output->size();
   }
+  RecordFusionCopyTime(entries, start);
 }
 
 void AllreduceOp::MemcpyEntryInFusionBuffer(
     const std::vector<TensorTableEntry>& entries, const TensorTableEntry& e,
     void* buffer_data_at_offset) {
-  std::memcpy(buffer_data_at_offset, e.tensor->data(),
-              (size_t)e.tensor->size());
+  MemcpyCPU(buffer_data_at_offset, e.tensor->data(), (size_t)e.tensor->size());
 }
 
 void AllreduceOp::MemcpyEntryOutFusionBuffer(
     const std::vector<TensorTableEntry>& entries,
     const void* buffer_data_at_offset, TensorTableEntry& e) {
-  std::memcpy((void*)e.output->data(), buffer_data_at_offset,
-              (size_t)e.output->size());
+  MemcpyCPU((void*)e.output->data(), buffer_data_at_offset,
+            (size_t)e.output->size());
 }
 
 void AllreduceOp::ScaleBuffer(
     double scale_factor, const std::vector<TensorTableEntry>& entries,
     const void* fused_input_data, void* buffer_data,
     int64_t num_elements) {
+  auto dtype = entries[0].tensor->dtype();
+  auto element_size = DataType_Size(dtype);
+  global_state_->cpu_thread_pool.ParallelFor(
+      num_elements, CPU_SCALE_GRAIN, [&](int64_t begin, int64_t end) {
+        ScaleBufferCPU((const uint8_t*)fused_input_data + begin * element_size,
+                       (uint8_t*)buffer_data + begin * element_size,
+                       end - begin, scale_factor, dtype);
+      });
+}
+
+bool AllreduceOp::GetZeroCopySpan(const std::vector<TensorTableEntry>& entries,
+                                  void*& span_data, size_t& span_len) const {
+  if (entries.size() < 2) {
+    return false;
+  }
+  auto element_size = DataType_Size(entries[0].tensor->dtype());
+  auto first = (const uint8_t*)entries[0].output->data();
+  const uint8_t* end = first;
+  bool back_to_back = true;
+  for (auto& e : entries) {
+    auto data = (const uint8_t*)e.output->data();
+    if ((const void*)data != e.tensor->data() || data < end ||
+        (data - first) % element_size != 0) {
+      return false;
+    }
+    back_to_back = back_to_back && data == end;
+    end = data + e.output->size();
+  }
+
+  if (!back_to_back) {
+    // Every tensor of an arena starts at a multiple of its alignment, so a
+    // gap shorter than that can only be padding.
+    GradientArena arena;
+    if (!global_state_->gradient_arenas.Find(first, end - first, arena)) {
+      return false;
+    }
+    const uint8_t* prev_end = first;
+    for (auto& e : entries) {
+      auto data = (const uint8_t*)e.output->data();
+      if (data != prev_end && ((data - arena.data) % arena.alignment != 0 ||
+                               data - prev_end >= arena.alignment)) {
+        return false;
+      }
+      prev_end = data + e.output->size();
+    }
+  }
+
+  span_data = (void*)first;
+  span_len = (size_t)(end - first);
+  return true;
+}
 
-  DataType dtype = entries[0].tensor->dtype();
+bool AllreduceOp::FoldPrescale(const std::vector<TensorTableEntry>& entries,
+                               const Response& response) const {
+  auto dtype = entries[0].tensor->dtype();
+  return response.prescale_factor() != 1.0 &&
+         (response.reduce_op() == ReduceOp::SUM ||
+          response.reduce_op() == ReduceOp::AVERAGE) &&
+         (dtype == HOROVOD_FLOAT32 || dtype == HOROVOD_FLOAT64);
+}
+
+bool AllreduceOp::AccumulatesInFloat32(
+    const std::vector<TensorTableEntry>& entries,
+    const Response& response) const {
+  auto dtype = entries[0].tensor->dtype();
+  return global_state_->cpu_fp32_accumulation &&
+         response.reduce_op() == ReduceOp::SUM &&
+         (dtype == HOROVOD_FLOAT16 || dtype == HOROVOD_BFLOAT16);
+}
+
+void WidenToFloat32(const void* input, float* output, int64_t num_elements,
+                    DataType dtype) {
+  if (dtype == HOROVOD_BFLOAT16) {
+    BFloat16Bits2FloatN((const unsigned short*)input, output, num_elements);
+  } else {
+    HalfBits2FloatN((const unsigned short*)input, output, num_elements);
+  }
+}
+
+void NarrowFromFloat32(const float* input, void* output, int64_t num_elements,
+                       DataType dtype) {
+  if (dtype == HOROVOD_BFLOAT16) {
+    Float2BFloat16BitsN(input, (unsigned short*)output, num_elements);
+  } else {
+    Float2HalfBitsN(input, (unsigned short*)output, num_elements);
+  }
+}
+
+void ScaleBufferCPU(const void* input, void* output, int64_t num_elements,
+                    double scale_factor, DataType dtype) {
   switch (dtype) {
     case HOROVOD_UINT8:
-      ScaleBufferCPUImpl((const uint8_t*) fused_input_data, (uint8_t*) buffer_data, num_elements, scale_factor);
+      ScaleBufferCPUImpl((const uint8_t*) input, (uint8_t*) output, num_elements, scale_factor);
       break;
     case HOROVOD_INT8:
-      ScaleBufferCPUImpl((const int8_t*) fused_input_data, (int8_t*) buffer_data, num_elements, scale_factor);
+      ScaleBufferCPUImpl((const int8_t*) input, (int8_t*) output, num_elements, scale_factor);
       break;
     case HOROVOD_INT32:
-      ScaleBufferCPUImpl((const int32_t*) fused_input_data, (int32_t*) buffer_data, num_elements, scale_factor);
+      ScaleBufferCPUImpl((const int32_t*) input, (int32_t*) output, num_elements, scale_factor);
       break;
     case HOROVOD_INT64:
-      ScaleBufferCPUImpl((const int64_t*) fused_input_data, (int64_t*) buffer_data, num_elements, scale_factor);
+      ScaleBufferCPUImpl((const int64_t*) input, (int64_t*) output, num_elements, scale_factor);
       break;
     case HOROVOD_FLOAT16:
-      ScaleBufferCPUImpl((const unsigned short*) fused_input_data, (unsigned short*) buffer_data, num_elements, (float) scale_factor);
+      ScaleBufferCPUImpl((const unsigned short*) input, (unsigned short*) output, num_elements, (float) scale_factor);
+      break;
+    case HOROVOD_BFLOAT16:
+      ScaleBufferCPUBFloat16Impl((const unsigned short*) input, (unsigned short*) output, num_elements, (float) scale_factor);
       break;
     case HOROVOD_FLOAT32:
-      ScaleBufferCPUImpl((const float*) fused_input_data, (float*) buffer_data, num_elements, (float) scale_factor);
+      ScaleCPU((const float*) input, (float*) output, num_elements, (float) scale_factor);
       break;
     case HOROVOD_FLOAT64:
-      ScaleBufferCPUImpl((const double*) fused_input_data, (double*) buffer_data, num_elements, scale_factor);
+      ScaleCPU((const double*) input, (double*) output, num_elements, scale_factor);
       break;
     default:
       throw std::logic_error("Type " + DataType_Name(dtype) +
@@ -152,7 +265,7 @@ AllgatherOp::AllgatherOp(HorovodGlobalState* global_state)
 Status AllgatherOp::AllocateOutput(std::vector<TensorTableEntry>& entries,
                                    const Response& response,
                                    int64_t**& entry_component_sizes,
-                                   int*& recvcounts) {
+                                   int64_t*& recvcounts) {
   for (size_t ec = 0; ec < entries.size(); ++ec) {
     auto& e = entries[ec];
     auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
@@ -189,6 +302,16 @@ Status AllgatherOp::AllocateOutput(std::vector<TensorTableEntry>& entries,
     output_shape.AddDim((int64_t)total_entry_dimension_size);
     output_shape.AppendShape(single_slice_shape);
 
+    if (e.output != nullptr) {
+      // Preallocated by the framework.
+      if (e.output->shape() != output_shape) {
+        return Status::InvalidArgument(
+            "Allgather: output of " + e.tensor_name + " has shape " +
+            e.output->shape().DebugString() + ", but the result has shape " +
+            output_shape.DebugString() + ".");
+      }
+      continue;
+    }
     Status status = e.context->AllocateOutput(output_shape, &e.output);
     if (!status.ok()) {
       return status;
@@ -198,8 +321,8 @@ Status AllgatherOp::AllocateOutput(std::vector<TensorTableEntry>& entries,
   return Status::OK();
 }
 
-void AllgatherOp::SetDisplacements(const int* recvcounts, int*& displcmnts,
-                                   int global_size) {
+void AllgatherOp::SetDisplacements(const int64_t* recvcounts,
+                                   int64_t*& displcmnts, int global_size) {
   for (int rc = 0; rc < global_size; ++rc) {
     if (rc == 0) {
       displcmnts[rc] = 0;
@@ -211,12 +334,12 @@ void AllgatherOp::SetDisplacements(const int* recvcounts, int*& displcmnts,
 
 void AllgatherOp::SetEntryComponentOffsets(
     const std::vector<TensorTableEntry>& entries,
-    const int64_t* const* entry_component_sizes, const int* recvcounts,
+    const int64_t* const* entry_component_sizes, const int64_t* recvcounts,
     int64_t**& entry_component_offsets) {
   assert(!entries.empty());
   auto& process_set =
       global_state_->process_set_table.Get(entries[0].process_set_id);
-  unsigned int rank_displacement = 0;
+  int64_t rank_displacement = 0;
   int global_size = process_set.controller->GetSize();
   for (int rc = 0; rc < global_size; ++rc) {
     for (size_t ec = 0; ec < entries.size(); ++ec) {
@@ -232,29 +355,32 @@ void AllgatherOp::SetEntryComponentOffsets(
 }
 
 void AllgatherOp::MemcpyInFusionBuffer(
-    const std::vector<TensorTableEntry>& entries, const int* displcmnts,
+    const std::vector<TensorTableEntry>& entries, const int64_t* displcmnts,
     int element_size, void*& buffer_data) {
   assert(!entries.empty());
+  auto start = std::chrono::steady_clock::now();
   // Access the fusion buffer.
   auto& first_entry = entries[0];
-  auto buffer = global_state_->fusion_buffer.GetBuffer(
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto buffer = process_set.fusion_buffer.GetBuffer(
       first_entry.device, first_entry.context->framework(), global_state_->current_nccl_stream);
   buffer_data = const_cast<void*>(buffer->AccessData(first_entry.context));
 
-  auto& process_set =
-      global_state_->process_set_table.Get(first_entry.process_set_id);
   int64_t offset = displcmnts[process_set.controller->GetRank()] * element_size;
   for (auto& e : entries) {
     void* buffer_data_at_offset = (uint8_t*)buffer_data + offset;
     MemcpyEntryInFusionBuffer(entries, e, buffer_data_at_offset);
     offset += e.tensor->size();
   }
+  RecordFusionCopyTime(entries, start);
 }
 
 void AllgatherOp::MemcpyOutFusionBuffer(
     const int64_t* const* entry_component_offsets,
     const int64_t* const* entry_component_sizes, const void* buffer_data,
     int element_size, std::vector<TensorTableEntry>& entries) {
+  auto start = std::chrono::steady_clock::now();
   // Copy memory out of the fusion buffer.
   for (size_t ec = 0; ec < entries.size(); ++ec) {
     auto& e = entries[ec];
@@ -270,30 +396,380 @@ void AllgatherOp::MemcpyOutFusionBuffer(
       copy_offset += entry_size;
     }
   }
+  RecordFusionCopyTime(entries, start);
 }
 
 void AllgatherOp::MemcpyEntryInFusionBuffer(
     const std::vector<TensorTableEntry>& entries, const TensorTableEntry& e,
     void* buffer_data_at_offset) {
-  std::memcpy(buffer_data_at_offset, e.tensor->data(),
-              (size_t)e.tensor->size());
+  MemcpyCPU(buffer_data_at_offset, e.tensor->data(), (size_t)e.tensor->size());
 }
 
 void AllgatherOp::MemcpyEntryOutFusionBuffer(
     const std::vector<TensorTableEntry>& entries,
     const void* buffer_data_at_offset, TensorTableEntry& e,
     int64_t entry_offset, size_t entry_size) {
-  std::memcpy((uint8_t*)e.output->data() + entry_offset,
-              buffer_data_at_offset, entry_size);
+  MemcpyCPU((uint8_t*)e.output->data() + entry_offset, buffer_data_at_offset,
+            entry_size);
 }
 
 BroadcastOp::BroadcastOp(HorovodGlobalState* global_state)
     : HorovodOp(global_state) {}
 
+void BroadcastOp::MemcpyInFusionBuffer(
+    const std::vector<TensorTableEntry>& entries, void* buffer_data) {
+  auto start = std::chrono::steady_clock::now();
+  int64_t offset = 0;
+  for (auto& e : entries) {
+    MemcpyCPU((uint8_t*)buffer_data + offset, e.tensor->data(),
+              (size_t)e.tensor->size());
+    offset += e.tensor->size();
+  }
+  RecordFusionCopyTime(entries, start);
+}
+
+void BroadcastOp::MemcpyOutFusionBuffer(
+    const void* buffer_data, std::vector<TensorTableEntry>& entries) {
+  auto start = std::chrono::steady_clock::now();
+  int64_t offset = 0;
+  for (auto& e : entries) {
+    MemcpyCPU((void*)e.output->data(), (const uint8_t*)buffer_data + offset,
+              (size_t)e.tensor->size());
+    offset += e.tensor->size();
+  }
+  RecordFusionCopyTime(entries, start);
+}
+
 AlltoallOp::AlltoallOp(HorovodGlobalState* global_state)
     : HorovodOp(global_state) {}
 
+Status AlltoallOp::PrepareFusedOutputAndParams(
+    std::vector<TensorTableEntry>& entries,
+    std::vector<int64_t>& entry_sendcounts,
+    std::vector<int64_t>& entry_recvcounts, std::vector<int64_t>& sdispls,
+    std::vector<int64_t>& rdispls, std::vector<int64_t>& sendcounts,
+    std::vector<int64_t>& recvcounts) {
+  auto& process_set =
+      global_state_->process_set_table.Get(entries[0].process_set_id);
+  int world_size = process_set.controller->GetSize();
+  int num_entries = (int)entries.size();
+
+  // Splits of all entries for rank 0 come first, so that one exchange tells
+  // every rank what it receives for each entry.
+  std::vector<int32_t> splits(num_entries * world_size);
+  std::vector<int32_t> recvsplits(num_entries * world_size);
+  bool recvsplits_known = true;
+  for (int n = 0; n < num_entries; ++n) {
+    recvsplits_known &= !entries[n].recvsplits.empty();
+    for (int i = 0; i < world_size; ++i) {
+      splits[i * num_entries + n] = entries[n].splits[i];
+      if (recvsplits_known) {
+        recvsplits[i * num_entries + n] = entries[n].recvsplits[i];
+      }
+    }
+  }
+  if (!recvsplits_known) {
+    process_set.controller->AlltoallGetRecvSplits(splits, recvsplits);
+  }
+
+  entry_sendcounts.assign(num_entries * world_size, 0);
+  entry_recvcounts.assign(num_entries * world_size, 0);
+  for (int n = 0; n < num_entries; ++n) {
+    auto& e = entries[n];
+    TensorShape slice_shape;
+    for (int i = 1; i < e.tensor->shape().dims(); ++i) {
+      slice_shape.AddDim(e.tensor->shape().dim_size(i));
+    }
+    int64_t slice_size =
+        slice_shape.num_elements() * DataType_Size(e.tensor->dtype());
+
+    std::vector<int32_t> entry_recvsplits(world_size);
+    int64_t output_first_dim = 0;
+    for (int i = 0; i < world_size; ++i) {
+      entry_recvsplits[i] = recvsplits[i * num_entries + n];
+      entry_sendcounts[n * world_size + i] = e.splits[i] * slice_size;
+      entry_recvcounts[n * world_size + i] = entry_recvsplits[i] * slice_size;
+      output_first_dim += entry_recvsplits[i];
+    }
+
+    TensorShape output_shape;
+    output_shape.AddDim(output_first_dim);
+    output_shape.AppendShape(slice_shape);
+    Status status = e.context->AllocateOutput(output_shape, &e.output);
+    if (!status.ok()) {
+      return status;
+    }
+
+    TensorShape received_splits_shape;
+    received_splits_shape.AddDim(world_size);
+    status = e.context->AllocateOutput(1, received_splits_shape,
+                                       &e.received_splits);
+    if (!status.ok()) {
+      return status;
+    }
+    auto* target_pointer = reinterpret_cast<int32_t*>(
+        const_cast<void*>(e.received_splits->data()));
+    std::copy(entry_recvsplits.cbegin(), entry_recvsplits.cend(),
+              target_pointer);
+  }
+
+  sendcounts.assign(world_size, 0);
+  recvcounts.assign(world_size, 0);
+  for (int i = 0; i < world_size; ++i) {
+    for (int n = 0; n < num_entries; ++n) {
+      sendcounts[i] += entry_sendcounts[n * world_size + i];
+      recvcounts[i] += entry_recvcounts[n * world_size + i];
+    }
+  }
+  sdispls.assign(world_size, 0);
+  rdispls.assign(world_size, 0);
+  for (int i = 1; i < world_size; ++i) {
+    sdispls[i] = sdispls[i - 1] + sendcounts[i - 1];
+    rdispls[i] = rdispls[i - 1] + recvcounts[i - 1];
+  }
+
+  return Status::OK();
+}
+
+void AlltoallOp::MemcpyInFusionBuffer(
+    const std::vector<TensorTableEntry>& entries,
+    const std::vector<int64_t>& entry_sendcounts, void* buffer_data) {
+  auto start = std::chrono::steady_clock::now();
+  int num_entries = (int)entries.size();
+  int world_size = (int)entry_sendcounts.size() / num_entries;
+  std::vector<int64_t> entry_offsets(num_entries, 0);
+  int64_t offset = 0;
+  for (int i = 0; i < world_size; ++i) {
+    for (int n = 0; n < num_entries; ++n) {
+      int64_t count = entry_sendcounts[n * world_size + i];
+      if (count > 0) {
+        MemcpyEntryInFusionBuffer(
+            entries[n], (const uint8_t*)entries[n].tensor->data() + entry_offsets[n],
+            (size_t)count, (uint8_t*)buffer_data + offset);
+      }
+      entry_offsets[n] += count;
+      offset += count;
+    }
+  }
+  RecordFusionCopyTime(entries, start);
+}
+
+void AlltoallOp::MemcpyOutFusionBuffer(
+    const void* buffer_data, const std::vector<int64_t>& entry_recvcounts,
+    std::vector<TensorTableEntry>& entries) {
+  auto start = std::chrono::steady_clock::now();
+  int num_entries = (int)entries.size();
+  int world_size = (int)entry_recvcounts.size() / num_entries;
+  std::vector<int64_t> entry_offsets(num_entries, 0);
+  int64_t offset = 0;
+  for (int i = 0; i < world_size; ++i) {
+    for (int n = 0; n < num_entries; ++n) {
+      int64_t count = entry_recvcounts[n * world_size + i];
+      if (count > 0) {
+        MemcpyEntryOutFusionBuffer(
+            (const uint8_t*)buffer_data + offset, (size_t)count, entries[n],
+            (uint8_t*)entries[n].output->data() + entry_offsets[n]);
+      }
+      entry_offsets[n] += count;
+      offset += count;
+    }
+  }
+  RecordFusionCopyTime(entries, start);
+}
+
+void AlltoallOp::MemcpyEntryInFusionBuffer(const TensorTableEntry& e,
+                                           const void* entry_data_at_offset,
+                                           size_t size,
+                                           void* buffer_data_at_offset) {
+  MemcpyCPU(buffer_data_at_offset, entry_data_at_offset, size);
+}
+
+void AlltoallOp::MemcpyEntryOutFusionBuffer(const void* buffer_data_at_offset,
+                                            size_t size, TensorTableEntry& e,
+                                            void* output_data_at_offset) {
+  MemcpyCPU(output_data_at_offset, buffer_data_at_offset, size);
+}
+
+Status AlltoallOp::GetFusedRecvBuffer(const TensorTableEntry& e, int64_t size,
+                                      void*& buffer) {
+  auto& elem = fused_recv_buffers_[std::make_tuple(e.device,
+                                                   e.context->framework())];
+  auto& recv_buffer = elem.first;
+  int64_t& capacity = elem.second;
+  if (capacity < size) {
+    recv_buffer.reset();
+    capacity = 0;
+    Status status = e.context->AllocatePersistent(size, &recv_buffer);
+    if (!status.ok()) {
+      recv_buffer.reset();
+      return status;
+    }
+    capacity = size;
+  }
+  buffer = const_cast<void*>(recv_buffer->AccessData(e.context));
+  return Status::OK();
+}
+
+// Reducescatter
+ReducescatterOp::ReducescatterOp(HorovodGlobalState* global_state)
+    : HorovodOp(global_state) {}
+
+std::vector<std::vector<TensorShape>> ReducescatterOp::ComputeOutputShapes(
+    const std::vector<TensorTableEntry>& entries, int process_set_size) const {
+  std::vector<std::vector<TensorShape>> output_shapes;
+  output_shapes.reserve(entries.size());
+  for (auto& e : entries) {
+    const auto& tensor_shape = e.tensor->shape();
+    TensorShape single_slice_shape;
+    for (int i = 1; i < tensor_shape.dims(); ++i) {
+      single_slice_shape.AddDim(tensor_shape.dim_size(i));
+    }
+
+    int64_t first_dim = tensor_shape.dim_size(0);
+    int64_t slices_per_rank = first_dim / process_set_size;
+    int64_t remainder = first_dim % process_set_size;
+
+    std::vector<TensorShape> rank_shapes;
+    rank_shapes.reserve(process_set_size);
+    for (int rc = 0; rc < process_set_size; ++rc) {
+      TensorShape rank_shape;
+      rank_shape.AddDim(slices_per_rank + (rc < remainder ? 1 : 0));
+      rank_shape.AppendShape(single_slice_shape);
+      rank_shapes.push_back(std::move(rank_shape));
+    }
+    output_shapes.push_back(std::move(rank_shapes));
+  }
+  return output_shapes;
+}
+
+std::vector<int64_t> ReducescatterOp::ComputeReceiveCounts(
+    const std::vector<std::vector<TensorShape>>& output_shapes) const {
+  assert(!output_shapes.empty());
+  std::vector<int64_t> recvcounts(output_shapes[0].size(), 0);
+  for (auto& rank_shapes : output_shapes) {
+    for (size_t rc = 0; rc < rank_shapes.size(); ++rc) {
+      recvcounts[rc] += rank_shapes[rc].num_elements();
+    }
+  }
+  return recvcounts;
+}
+
+Status ReducescatterOp::AllocateOutput(
+    std::vector<TensorTableEntry>& entries,
+    const std::vector<std::vector<TensorShape>>& output_shapes) {
+  for (size_t ec = 0; ec < entries.size(); ++ec) {
+    auto& e = entries[ec];
+    auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
+    int rank = process_set.controller->GetRank();
+    Status status = e.context->AllocateOutput(output_shapes[ec][rank], &e.output);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  return Status::OK();
+}
+
+void ReducescatterOp::MemcpyInFusionBuffer(
+    const std::vector<TensorTableEntry>& entries,
+    const std::vector<std::vector<TensorShape>>& output_shapes,
+    size_t element_size, void*& buffer_data) {
+  assert(!entries.empty());
+  auto start = std::chrono::steady_clock::now();
+  // Access the fusion buffer.
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto buffer = process_set.fusion_buffer.GetBuffer(
+      first_entry.device, first_entry.context->framework(), global_state_->current_nccl_stream);
+  buffer_data = const_cast<void*>(buffer->AccessData(first_entry.context));
+
+  size_t process_set_size = output_shapes[0].size();
+  std::vector<int64_t> entry_offsets(entries.size(), 0);
+  int64_t offset = 0;
+  for (size_t rc = 0; rc < process_set_size; ++rc) {
+    for (size_t ec = 0; ec < entries.size(); ++ec) {
+      auto entry_size =
+          (size_t)output_shapes[ec][rc].num_elements() * element_size;
+      void* buffer_data_at_offset = (uint8_t*)buffer_data + offset;
+      MemcpyEntryInFusionBuffer(entries[ec], entry_offsets[ec], entry_size,
+                                buffer_data_at_offset);
+      entry_offsets[ec] += entry_size;
+      offset += entry_size;
+    }
+  }
+  RecordFusionCopyTime(entries, start);
+}
+
+void ReducescatterOp::MemcpyOutFusionBuffer(
+    const void* buffer_data, std::vector<TensorTableEntry>& entries) {
+  auto start = std::chrono::steady_clock::now();
+  int64_t offset = 0;
+  for (auto& e : entries) {
+    const void* buffer_data_at_offset = (uint8_t*)buffer_data + offset;
+    MemcpyEntryOutFusionBuffer(buffer_data_at_offset, e);
+    offset += e.output->size();
+  }
+  RecordFusionCopyTime(entries, start);
+}
+
+void ReducescatterOp::MemcpyEntryInFusionBuffer(const TensorTableEntry& e,
+                                                int64_t entry_offset,
+                                                size_t entry_size,
+                                                void* buffer_data_at_offset) {
+  MemcpyCPU(buffer_data_at_offset, (uint8_t*)e.tensor->data() + entry_offset,
+            entry_size);
+}
+
+void ReducescatterOp::MemcpyEntryOutFusionBuffer(
+    const void* buffer_data_at_offset, TensorTableEntry& e) {
+  MemcpyCPU((void*)e.output->data(), buffer_data_at_offset,
+            (size_t)e.output->size());
+}
+
+void ReducescatterOp::ScaleBuffer(
+    double scale_factor, const std::vector<TensorTableEntry>& entries,
+    const void* fused_input_data, void* buffer_data, int64_t num_elements) {
+  ScaleBufferCPU(fused_input_data, buffer_data, num_elements, scale_factor,
+                 entries[0].tensor->dtype());
+}
+
 // Join
+GatherOp::GatherOp(HorovodGlobalState* global_state)
+    : HorovodOp(global_state) {}
+
+Status GatherOp::PrepareOutputAndParams(TensorTableEntry& e,
+                                        const Response& response,
+                                        std::vector<int64_t>& recvcounts,
+                                        std::vector<int64_t>& displcmnts) {
+  auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
+  int size = process_set.controller->GetSize();
+  bool is_root = process_set.controller->GetRank() == e.root_rank;
+
+  TensorShape slice_shape;
+  for (int i = 1; i < e.tensor->shape().dims(); ++i) {
+    slice_shape.AddDim(e.tensor->shape().dim_size(i));
+  }
+  int64_t slice_num_elements = slice_shape.num_elements();
+
+  recvcounts.assign(size, 0);
+  displcmnts.assign(size, 0);
+  int64_t first_dim = 0;
+  const auto& tensor_sizes = response.tensor_sizes();
+  for (int rc = 0; rc < size; ++rc) {
+    recvcounts[rc] = tensor_sizes[rc] * slice_num_elements;
+    if (rc > 0) {
+      displcmnts[rc] = displcmnts[rc - 1] + recvcounts[rc - 1];
+    }
+    first_dim += tensor_sizes[rc];
+  }
+
+  TensorShape output_shape;
+  output_shape.AddDim(is_root ? first_dim : 0);
+  output_shape.AppendShape(slice_shape);
+  return e.context->AllocateOutput(output_shape, &e.output);
+}
+
 JoinOp::JoinOp(HorovodGlobalState* global_state) : HorovodOp(global_state) {}
 
 Status JoinOp::Execute(std::vector<TensorTableEntry>& entries,
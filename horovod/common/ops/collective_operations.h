@@ -42,11 +42,30 @@ public:
   virtual Status Execute(std::vector<TensorTableEntry>& entries,
                          const Response& response) = 0;
 
+  // Adds the buffers the op keeps between operations to usage.
+  virtual void AddMemoryUsage(MemoryUsage& usage) const {}
+
+  // Frees the buffers the op keeps between operations, which are allocated
+  // again on next use.
+  virtual void ReleaseBuffers() {}
+
 protected:
   int64_t NumElements(std::vector<TensorTableEntry>& entries);
 
   virtual void WaitForData(std::vector<TensorTableEntry>& entries);
 
+  // Host memcpy, split across global_state_->cpu_thread_pool.
+  void MemcpyCPU(void* dst, const void* src, size_t count);
+
+  // Adds the time since start to the fusion copy metric. Only host copies
+  // are counted, copies on a GPU stream complete asynchronously.
+  void RecordFusionCopyTime(const std::vector<TensorTableEntry>& entries,
+                            std::chrono::steady_clock::time_point start);
+
+  // Minimum number of bytes copied and elements scaled per CPU thread.
+  static constexpr int64_t CPU_MEMCPY_GRAIN = 1 << 20;
+  static constexpr int64_t CPU_SCALE_GRAIN = 1 << 16;
+
   HorovodGlobalState* global_state_;
 };
 
@@ -63,6 +82,34 @@ public:
                        const std::vector<TensorTableEntry>& entries,
                        const Response& response) const = 0;
 
+  // Whether Execute places the outputs of entries enqueued without one in
+  // its own memory. Otherwise they are allocated by the framework first.
+  virtual bool AdoptsOutputs(const std::vector<TensorTableEntry>& entries,
+                             const Response& response) const {
+    return false;
+  }
+
+  // Whether Execute copies entries through the fusion buffer, which is then
+  // initialized before.
+  virtual bool StagesInFusionBuffer(const std::vector<TensorTableEntry>& entries,
+                                    const Response& response) const {
+    return entries.size() > 1;
+  }
+
+  // Whether ExecuteGroup can perform the responses, all of them enabled for
+  // this op, in one launch.
+  virtual bool Groups(const std::vector<std::vector<TensorTableEntry>>& entries_list,
+                      const std::vector<Response>& responses) const {
+    return false;
+  }
+
+  // Performs the responses like Execute would one by one, completing the
+  // entries of all of them together.
+  virtual Status ExecuteGroup(std::vector<std::vector<TensorTableEntry>>& entries_list,
+                              const std::vector<Response>& responses) {
+    return Status::PreconditionError("Allreduce op does not group responses.");
+  }
+
 protected:
   virtual void
   MemcpyInFusionBuffer(const std::vector<TensorTableEntry>& entries,
@@ -86,8 +133,33 @@ protected:
   ScaleBuffer(double scale_factor, const std::vector<TensorTableEntry>& entries,
               const void* fused_input_data, void* buffer_data, int64_t num_elements);
 
+  // Returns true if all entries are reduced in place, in increasing address
+  // order, and either lie back to back or inside one registered gradient
+  // arena. The collective then runs directly on the span_len bytes at
+  // span_data, without fusion buffer copies. Padding inside the span is
+  // reduced along with the tensors.
+  bool GetZeroCopySpan(const std::vector<TensorTableEntry>& entries,
+                       void*& span_data, size_t& span_len) const;
+
+  // Returns true if the prescale factor of the response can be applied
+  // together with the postscale factor after the collective, which saves a
+  // pass over the data. Only done for sums of float32 and float64, float16
+  // keeps prescaling before the reduction to avoid overflow.
+  bool FoldPrescale(const std::vector<TensorTableEntry>& entries,
+                    const Response& response) const;
+
+  // Returns true if a CPU allreduce of entries should reduce float32 copies
+  // of float16 or bfloat16 data, see HOROVOD_CPU_FP32_ACCUMULATION.
+  bool AccumulatesInFloat32(const std::vector<TensorTableEntry>& entries,
+                            const Response& response) const;
+
 };
 
+// Scales num_elements values of the given data type on the CPU, in place if
+// input and output are the same buffer.
+void ScaleBufferCPU(const void* input, void* output, int64_t num_elements,
+                    double scale_factor, DataType dtype);
+
 template <typename T, typename TS>
 void ScaleBufferCPUImpl(const T* input, T* output, int64_t num_elements, TS scale_factor) {
   for (int64_t i = 0; i < num_elements; ++i) {
@@ -98,33 +170,64 @@ void ScaleBufferCPUImpl(const T* input, T* output, int64_t num_elements, TS scal
 // Specialization for float16
 template <> inline
 void ScaleBufferCPUImpl(const unsigned short* input, unsigned short* output, int64_t num_elements, float scale_factor) {
-  int64_t i = 0;
+  ScaleHalfBits(input, output, num_elements, scale_factor);
+}
 
-#if __AVX__ && __F16C__
-  if (is_avx_and_f16c()) {
-    __m256 scale_factor_m256 = _mm256_broadcast_ss(&scale_factor);
-    for (; i < (num_elements / 8) * 8; i += 8) {
-      // convert input to m256
-      __m256 input_m256 = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)(input + i)));
-
-      // scale and store result in output_m256
-      __m256 output_m256 = _mm256_mul_ps(input_m256, scale_factor_m256);
-
-      // convert back and store in output
-      __m128i output_m128i = _mm256_cvtps_ph(output_m256, 0);
-      _mm_storeu_si128((__m128i*)(output + i), output_m128i);
+// Converts num_elements float16 or bfloat16 values to float32, and back.
+void WidenToFloat32(const void* input, float* output, int64_t num_elements,
+                    DataType dtype);
+void NarrowFromFloat32(const float* input, void* output, int64_t num_elements,
+                       DataType dtype);
+
+// bfloat16 shares its storage type with float16, so it cannot use a
+// specialization of ScaleBufferCPUImpl.
+inline void ScaleBufferCPUBFloat16Impl(const unsigned short* input,
+                                       unsigned short* output,
+                                       int64_t num_elements,
+                                       float scale_factor) {
+  for (int64_t i = 0; i < num_elements; ++i) {
+    float in_float;
+    BFloat16Bits2Float(input + i, &in_float);
+    float out_float = scale_factor * in_float;
+    Float2BFloat16Bits(&out_float, output + i);
+  }
+}
+
+// Sizes and offsets of the components of every entry of an allgather, kept
+// until its result has been copied out of the fusion buffer.
+struct AllgatherLayout {
+  AllgatherLayout(size_t num_entries, int global_size)
+      : num_entries(num_entries) {
+    // Sizes of subcomponents of each entry from all ranks
+    entry_component_sizes = new int64_t*[num_entries];
+    // Offset of each subcomponent of every entry in the final buffer after
+    // allgatherv
+    entry_component_offsets = new int64_t*[num_entries];
+    recvcounts = new int64_t[global_size]();
+    displcmnts = new int64_t[global_size]();
+    for (size_t ec = 0; ec < num_entries; ++ec) {
+      entry_component_sizes[ec] = new int64_t[global_size]();
+      entry_component_offsets[ec] = new int64_t[global_size]();
     }
   }
-#endif
 
-  for (; i < num_elements; ++i) {
-    float in_float;
-    HalfBits2Float(input + i, &in_float);
-    float out_float = scale_factor * in_float;
-    Float2HalfBits(&out_float, output + i);
+  ~AllgatherLayout() {
+    for (size_t ec = 0; ec < num_entries; ++ec) {
+      delete[] entry_component_sizes[ec];
+      delete[] entry_component_offsets[ec];
+    }
+    delete[] entry_component_sizes;
+    delete[] entry_component_offsets;
+    delete[] recvcounts;
+    delete[] displcmnts;
   }
 
-}
+  size_t num_entries;
+  int64_t** entry_component_sizes;
+  int64_t** entry_component_offsets;
+  int64_t* recvcounts;
+  int64_t* displcmnts;
+};
 
 class AllgatherOp : public HorovodOp {
 public:
@@ -143,20 +246,20 @@ protected:
   virtual Status AllocateOutput(std::vector<TensorTableEntry>& entries,
                                 const Response& response,
                                 int64_t**& entry_component_sizes,
-                                int*& recvcounts);
+                                int64_t*& recvcounts);
 
-  virtual void SetDisplacements(const int* recvcounts, int*& displcmnts,
-                                int global_size);
+  virtual void SetDisplacements(const int64_t* recvcounts,
+                                int64_t*& displcmnts, int global_size);
 
   virtual void
   SetEntryComponentOffsets(const std::vector<TensorTableEntry>& entries,
                            const int64_t* const* entry_component_sizes,
-                           const int* recvcounts,
+                           const int64_t* recvcounts,
                            int64_t**& entry_component_offsets);
 
   virtual void
   MemcpyInFusionBuffer(const std::vector<TensorTableEntry>& entries,
-                       const int* displcmnts, int element_size,
+                       const int64_t* displcmnts, int element_size,
                        void*& buffer_data);
 
   virtual void
@@ -190,6 +293,16 @@ public:
   virtual bool Enabled(const ParameterManager& param_manager,
                        const std::vector<TensorTableEntry>& entries,
                        const Response& response) const = 0;
+
+protected:
+  // Fused broadcasts send the entries back to back in the fusion buffer. The
+  // root copies its inputs in, the other ranks copy the result out to their
+  // outputs. Both only handle host memory.
+  void MemcpyInFusionBuffer(const std::vector<TensorTableEntry>& entries,
+                            void* buffer_data);
+
+  void MemcpyOutFusionBuffer(const void* buffer_data,
+                             std::vector<TensorTableEntry>& entries);
 };
 
 class AlltoallOp : public HorovodOp {
@@ -216,9 +329,11 @@ protected:
     auto world_size = process_set.controller->GetSize();
 
     const auto& splits = e.splits;
-    std::vector<int32_t> recvsplits;
-    // Perform alltoall of splits to get expected receive splits
-    process_set.controller->AlltoallGetRecvSplits(splits, recvsplits);
+    std::vector<int32_t> recvsplits = e.recvsplits;
+    if (recvsplits.empty()) {
+      // Perform alltoall of splits to get expected receive splits
+      process_set.controller->AlltoallGetRecvSplits(splits, recvsplits);
+    }
 
     // Every tensor participating in Alltoall operation may have different
     // first dimension size, but the rest of dimensions are same for all
@@ -270,6 +385,127 @@ protected:
 
     return Status::OK();
   }
+
+  // Exchanges the splits of all fused entries at once and allocates their
+  // outputs. entry_sendcounts[n * size + i] is the number of bytes entry n
+  // sends to rank i, entry_recvcounts the number it receives from rank i.
+  // The fused counts and displacements are in bytes as well, for a buffer
+  // holding the blocks of all entries for rank 0, then those for rank 1, etc.
+  Status PrepareFusedOutputAndParams(std::vector<TensorTableEntry>& entries,
+                                     std::vector<int64_t>& entry_sendcounts,
+                                     std::vector<int64_t>& entry_recvcounts,
+                                     std::vector<int64_t>& sdispls,
+                                     std::vector<int64_t>& rdispls,
+                                     std::vector<int64_t>& sendcounts,
+                                     std::vector<int64_t>& recvcounts);
+
+  void MemcpyInFusionBuffer(const std::vector<TensorTableEntry>& entries,
+                            const std::vector<int64_t>& entry_sendcounts,
+                            void* buffer_data);
+
+  void MemcpyOutFusionBuffer(const void* buffer_data,
+                             const std::vector<int64_t>& entry_recvcounts,
+                             std::vector<TensorTableEntry>& entries);
+
+  virtual void MemcpyEntryInFusionBuffer(const TensorTableEntry& e,
+                                         const void* entry_data_at_offset,
+                                         size_t size,
+                                         void* buffer_data_at_offset);
+
+  virtual void MemcpyEntryOutFusionBuffer(const void* buffer_data_at_offset,
+                                          size_t size, TensorTableEntry& e,
+                                          void* output_data_at_offset);
+
+  // Returns a buffer of at least size bytes that receives a fused alltoall,
+  // kept per device and framework. The send side uses the fusion buffer.
+  Status GetFusedRecvBuffer(const TensorTableEntry& e, int64_t size,
+                            void*& buffer);
+
+  std::unordered_map<std::tuple<int, Framework>,
+                     std::pair<std::shared_ptr<PersistentBuffer>, int64_t>>
+      fused_recv_buffers_;
+};
+
+// Reduces tensors across the process set and scatters the result along the
+// first dimension. The first dimension is split as evenly as possible: with
+// a first dimension of size N in a process set of size P, the first N % P
+// ranks receive N / P + 1 slices and the others N / P slices.
+class ReducescatterOp : public HorovodOp {
+public:
+  explicit ReducescatterOp(HorovodGlobalState* global_state);
+
+  virtual ~ReducescatterOp() = default;
+
+  virtual Status Execute(std::vector<TensorTableEntry>& entries,
+                         const Response& response) = 0;
+
+  virtual bool Enabled(const ParameterManager& param_manager,
+                       const std::vector<TensorTableEntry>& entries,
+                       const Response& response) const = 0;
+
+protected:
+  // Shape of the output each rank receives, indexed by [entry][rank].
+  virtual std::vector<std::vector<TensorShape>>
+  ComputeOutputShapes(const std::vector<TensorTableEntry>& entries,
+                      int process_set_size) const;
+
+  // Number of elements each rank receives summed over all entries.
+  virtual std::vector<int64_t> ComputeReceiveCounts(
+      const std::vector<std::vector<TensorShape>>& output_shapes) const;
+
+  virtual Status
+  AllocateOutput(std::vector<TensorTableEntry>& entries,
+                 const std::vector<std::vector<TensorShape>>& output_shapes);
+
+  // The fusion buffer is laid out rank by rank, so that the part of every
+  // entry that is destined for the same rank is contiguous.
+  virtual void
+  MemcpyInFusionBuffer(const std::vector<TensorTableEntry>& entries,
+                       const std::vector<std::vector<TensorShape>>& output_shapes,
+                       size_t element_size, void*& buffer_data);
+
+  // Copies this rank's reduced part of all entries, which starts at
+  // buffer_data, into the entry outputs.
+  virtual void MemcpyOutFusionBuffer(const void* buffer_data,
+                                     std::vector<TensorTableEntry>& entries);
+
+  virtual void MemcpyEntryInFusionBuffer(const TensorTableEntry& e,
+                                         int64_t entry_offset,
+                                         size_t entry_size,
+                                         void* buffer_data_at_offset);
+
+  virtual void MemcpyEntryOutFusionBuffer(const void* buffer_data_at_offset,
+                                          TensorTableEntry& e);
+
+  virtual void
+  ScaleBuffer(double scale_factor, const std::vector<TensorTableEntry>& entries,
+              const void* fused_input_data, void* buffer_data, int64_t num_elements);
+};
+
+// Concatenates a tensor of every rank along the first dimension, like an
+// allgather, but only on the root rank of the entry. Gathers are not fused,
+// every response holds a single entry.
+class GatherOp : public HorovodOp {
+public:
+  explicit GatherOp(HorovodGlobalState* global_state);
+
+  virtual ~GatherOp() = default;
+
+  virtual Status Execute(std::vector<TensorTableEntry>& entries,
+                         const Response& response) = 0;
+
+  virtual bool Enabled(const ParameterManager& param_manager,
+                       const std::vector<TensorTableEntry>& entries,
+                       const Response& response) const = 0;
+
+protected:
+  // Allocates the output of e, the whole result on the root and a first
+  // dimension of zero on the other ranks, and returns the number of elements
+  // the root receives from every rank and their offsets in the output.
+  virtual Status PrepareOutputAndParams(TensorTableEntry& e,
+                                        const Response& response,
+                                        std::vector<int64_t>& recvcounts,
+                                        std::vector<int64_t>& displcmnts);
 };
 
 class JoinOp : public HorovodOp {
@@ -0,0 +1,646 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "cpu_kernels.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+// The AVX2 and AVX-512 kernels are compiled for their own target with
+// function attributes, so the library still loads on hosts without them.
+#define HOROVOD_CPU_KERNELS_X86 1
+#define HOROVOD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define HOROVOD_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+// NEON is part of the AArch64 base ISA, no runtime check is needed.
+#define HOROVOD_CPU_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+CPUKernelISA DetectCPUKernelISA() {
+#if HOROVOD_CPU_KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+    return CPUKernelISA::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return CPUKernelISA::AVX2;
+  }
+  return CPUKernelISA::SCALAR;
+#elif HOROVOD_CPU_KERNELS_NEON
+  return CPUKernelISA::NEON;
+#else
+  return CPUKernelISA::SCALAR;
+#endif
+}
+
+// Scalar kernels, also used for the tails of the vectorized ones.
+template <typename T>
+inline void SumScalar(const T* a, const T* b, T* out, int64_t count) {
+  for (int64_t i = 0; i < count; ++i) {
+    out[i] = a[i] + b[i];
+  }
+}
+
+template <typename T>
+inline void ScaleScalar(const T* input, T* output, int64_t count,
+                        T scale_factor) {
+  for (int64_t i = 0; i < count; ++i) {
+    output[i] = scale_factor * input[i];
+  }
+}
+
+template <typename T>
+inline void ScaledAddScalar(T* a, const T* b, int64_t count, T acoeff,
+                            T bcoeff) {
+  for (int64_t i = 0; i < count; ++i) {
+    a[i] = acoeff * a[i] + bcoeff * b[i];
+  }
+}
+
+template <typename T>
+inline void DotAndNormSqrdsScalar(const T* a, const T* b, int64_t count,
+                                  double& dot_product, double& anormsq,
+                                  double& bnormsq) {
+  for (int64_t i = 0; i < count; ++i) {
+    dot_product += (double)a[i] * (double)b[i];
+    anormsq += (double)a[i] * (double)a[i];
+    bnormsq += (double)b[i] * (double)b[i];
+  }
+}
+
+#if HOROVOD_CPU_KERNELS_X86
+
+// Integer sums are left to the vectorizer, which emits AVX2 code for this
+// target.
+template <typename T>
+HOROVOD_TARGET_AVX2 void SumAVX2(const T* a, const T* b, T* out,
+                                 int64_t count) {
+  for (int64_t i = 0; i < count; ++i) {
+    out[i] = a[i] + b[i];
+  }
+}
+
+template <>
+HOROVOD_TARGET_AVX2 void SumAVX2(const float* a, const float* b, float* out,
+                                 int64_t count) {
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i),
+                                            _mm256_loadu_ps(b + i)));
+  }
+  SumScalar(a + i, b + i, out + i, count - i);
+}
+
+template <>
+HOROVOD_TARGET_AVX2 void SumAVX2(const double* a, const double* b,
+                                 double* out, int64_t count) {
+  int64_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i),
+                                            _mm256_loadu_pd(b + i)));
+  }
+  SumScalar(a + i, b + i, out + i, count - i);
+}
+
+HOROVOD_TARGET_AVX2 void ScaleAVX2(const float* input, float* output,
+                                   int64_t count, float scale_factor) {
+  __m256 scale = _mm256_set1_ps(scale_factor);
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_loadu_ps(input + i), scale));
+  }
+  ScaleScalar(input + i, output + i, count - i, scale_factor);
+}
+
+HOROVOD_TARGET_AVX2 void ScaleAVX2(const double* input, double* output,
+                                   int64_t count, double scale_factor) {
+  __m256d scale = _mm256_set1_pd(scale_factor);
+  int64_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm256_storeu_pd(output + i, _mm256_mul_pd(_mm256_loadu_pd(input + i), scale));
+  }
+  ScaleScalar(input + i, output + i, count - i, scale_factor);
+}
+
+HOROVOD_TARGET_AVX2 void ScaledAddAVX2(float* a, const float* b, int64_t count,
+                                       float acoeff, float bcoeff) {
+  __m256 acoeff_m256 = _mm256_set1_ps(acoeff);
+  __m256 bcoeff_m256 = _mm256_set1_ps(bcoeff);
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 scaled_b = _mm256_mul_ps(_mm256_loadu_ps(b + i), bcoeff_m256);
+    _mm256_storeu_ps(a + i, _mm256_fmadd_ps(_mm256_loadu_ps(a + i),
+                                            acoeff_m256, scaled_b));
+  }
+  ScaledAddScalar(a + i, b + i, count - i, acoeff, bcoeff);
+}
+
+HOROVOD_TARGET_AVX2 void ScaledAddAVX2(double* a, const double* b,
+                                       int64_t count, double acoeff,
+                                       double bcoeff) {
+  __m256d acoeff_m256d = _mm256_set1_pd(acoeff);
+  __m256d bcoeff_m256d = _mm256_set1_pd(bcoeff);
+  int64_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d scaled_b = _mm256_mul_pd(_mm256_loadu_pd(b + i), bcoeff_m256d);
+    _mm256_storeu_pd(a + i, _mm256_fmadd_pd(_mm256_loadu_pd(a + i),
+                                            acoeff_m256d, scaled_b));
+  }
+  ScaledAddScalar(a + i, b + i, count - i, acoeff, bcoeff);
+}
+
+HOROVOD_TARGET_AVX2 inline double HorizontalSumAVX2(__m256d v) {
+  __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(v),
+                           _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+
+// Accumulates four doubles at a time: float inputs are widened first so the
+// result matches the precision of the scalar kernel.
+HOROVOD_TARGET_AVX2 inline void
+AccumulateDotAndNormSqrdsAVX2(__m256d a, __m256d b, __m256d& dot,
+                              __m256d& anormsq, __m256d& bnormsq) {
+  dot = _mm256_fmadd_pd(a, b, dot);
+  anormsq = _mm256_fmadd_pd(a, a, anormsq);
+  bnormsq = _mm256_fmadd_pd(b, b, bnormsq);
+}
+
+HOROVOD_TARGET_AVX2 void DotAndNormSqrdsAVX2(const float* a, const float* b,
+                                             int64_t count,
+                                             double& dot_product,
+                                             double& anormsq, double& bnormsq) {
+  __m256d dot = _mm256_setzero_pd();
+  __m256d an = _mm256_setzero_pd();
+  __m256d bn = _mm256_setzero_pd();
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 a_m256 = _mm256_loadu_ps(a + i);
+    __m256 b_m256 = _mm256_loadu_ps(b + i);
+    AccumulateDotAndNormSqrdsAVX2(
+        _mm256_cvtps_pd(_mm256_castps256_ps128(a_m256)),
+        _mm256_cvtps_pd(_mm256_castps256_ps128(b_m256)), dot, an, bn);
+    AccumulateDotAndNormSqrdsAVX2(
+        _mm256_cvtps_pd(_mm256_extractf128_ps(a_m256, 1)),
+        _mm256_cvtps_pd(_mm256_extractf128_ps(b_m256, 1)), dot, an, bn);
+  }
+  dot_product = HorizontalSumAVX2(dot);
+  anormsq = HorizontalSumAVX2(an);
+  bnormsq = HorizontalSumAVX2(bn);
+  DotAndNormSqrdsScalar(a + i, b + i, count - i, dot_product, anormsq, bnormsq);
+}
+
+HOROVOD_TARGET_AVX2 void DotAndNormSqrdsAVX2(const double* a, const double* b,
+                                             int64_t count,
+                                             double& dot_product,
+                                             double& anormsq, double& bnormsq) {
+  __m256d dot = _mm256_setzero_pd();
+  __m256d an = _mm256_setzero_pd();
+  __m256d bn = _mm256_setzero_pd();
+  int64_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    AccumulateDotAndNormSqrdsAVX2(_mm256_loadu_pd(a + i),
+                                  _mm256_loadu_pd(b + i), dot, an, bn);
+  }
+  dot_product = HorizontalSumAVX2(dot);
+  anormsq = HorizontalSumAVX2(an);
+  bnormsq = HorizontalSumAVX2(bn);
+  DotAndNormSqrdsScalar(a + i, b + i, count - i, dot_product, anormsq, bnormsq);
+}
+
+template <typename T>
+HOROVOD_TARGET_AVX512 void SumAVX512(const T* a, const T* b, T* out,
+                                     int64_t count) {
+  for (int64_t i = 0; i < count; ++i) {
+    out[i] = a[i] + b[i];
+  }
+}
+
+template <>
+HOROVOD_TARGET_AVX512 void SumAVX512(const float* a, const float* b,
+                                     float* out, int64_t count) {
+  int64_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_loadu_ps(a + i),
+                                            _mm512_loadu_ps(b + i)));
+  }
+  SumScalar(a + i, b + i, out + i, count - i);
+}
+
+template <>
+HOROVOD_TARGET_AVX512 void SumAVX512(const double* a, const double* b,
+                                     double* out, int64_t count) {
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm512_storeu_pd(out + i, _mm512_add_pd(_mm512_loadu_pd(a + i),
+                                            _mm512_loadu_pd(b + i)));
+  }
+  SumScalar(a + i, b + i, out + i, count - i);
+}
+
+HOROVOD_TARGET_AVX512 void ScaleAVX512(const float* input, float* output,
+                                       int64_t count, float scale_factor) {
+  __m512 scale = _mm512_set1_ps(scale_factor);
+  int64_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    _mm512_storeu_ps(output + i, _mm512_mul_ps(_mm512_loadu_ps(input + i), scale));
+  }
+  ScaleScalar(input + i, output + i, count - i, scale_factor);
+}
+
+HOROVOD_TARGET_AVX512 void ScaleAVX512(const double* input, double* output,
+                                       int64_t count, double scale_factor) {
+  __m512d scale = _mm512_set1_pd(scale_factor);
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm512_storeu_pd(output + i, _mm512_mul_pd(_mm512_loadu_pd(input + i), scale));
+  }
+  ScaleScalar(input + i, output + i, count - i, scale_factor);
+}
+
+HOROVOD_TARGET_AVX512 void ScaledAddAVX512(float* a, const float* b,
+                                           int64_t count, float acoeff,
+                                           float bcoeff) {
+  __m512 acoeff_m512 = _mm512_set1_ps(acoeff);
+  __m512 bcoeff_m512 = _mm512_set1_ps(bcoeff);
+  int64_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m512 scaled_b = _mm512_mul_ps(_mm512_loadu_ps(b + i), bcoeff_m512);
+    _mm512_storeu_ps(a + i, _mm512_fmadd_ps(_mm512_loadu_ps(a + i),
+                                            acoeff_m512, scaled_b));
+  }
+  ScaledAddScalar(a + i, b + i, count - i, acoeff, bcoeff);
+}
+
+HOROVOD_TARGET_AVX512 void ScaledAddAVX512(double* a, const double* b,
+                                           int64_t count, double acoeff,
+                                           double bcoeff) {
+  __m512d acoeff_m512d = _mm512_set1_pd(acoeff);
+  __m512d bcoeff_m512d = _mm512_set1_pd(bcoeff);
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m512d scaled_b = _mm512_mul_pd(_mm512_loadu_pd(b + i), bcoeff_m512d);
+    _mm512_storeu_pd(a + i, _mm512_fmadd_pd(_mm512_loadu_pd(a + i),
+                                            acoeff_m512d, scaled_b));
+  }
+  ScaledAddScalar(a + i, b + i, count - i, acoeff, bcoeff);
+}
+
+HOROVOD_TARGET_AVX512 inline double HorizontalSumAVX512(__m512d v) {
+  alignas(64) double lanes[8];
+  _mm512_store_pd(lanes, v);
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+         ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+HOROVOD_TARGET_AVX512 inline void
+AccumulateDotAndNormSqrdsAVX512(__m512d a, __m512d b, __m512d& dot,
+                                __m512d& anormsq, __m512d& bnormsq) {
+  dot = _mm512_fmadd_pd(a, b, dot);
+  anormsq = _mm512_fmadd_pd(a, a, anormsq);
+  bnormsq = _mm512_fmadd_pd(b, b, bnormsq);
+}
+
+HOROVOD_TARGET_AVX512 void DotAndNormSqrdsAVX512(const float* a,
+                                                 const float* b, int64_t count,
+                                                 double& dot_product,
+                                                 double& anormsq,
+                                                 double& bnormsq) {
+  __m512d dot = _mm512_setzero_pd();
+  __m512d an = _mm512_setzero_pd();
+  __m512d bn = _mm512_setzero_pd();
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    AccumulateDotAndNormSqrdsAVX512(
+        _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(a + i)),
+        _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(b + i)), dot, an, bn);
+  }
+  dot_product = HorizontalSumAVX512(dot);
+  anormsq = HorizontalSumAVX512(an);
+  bnormsq = HorizontalSumAVX512(bn);
+  DotAndNormSqrdsScalar(a + i, b + i, count - i, dot_product, anormsq, bnormsq);
+}
+
+HOROVOD_TARGET_AVX512 void DotAndNormSqrdsAVX512(const double* a,
+                                                 const double* b, int64_t count,
+                                                 double& dot_product,
+                                                 double& anormsq,
+                                                 double& bnormsq) {
+  __m512d dot = _mm512_setzero_pd();
+  __m512d an = _mm512_setzero_pd();
+  __m512d bn = _mm512_setzero_pd();
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    AccumulateDotAndNormSqrdsAVX512(_mm512_loadu_pd(a + i),
+                                    _mm512_loadu_pd(b + i), dot, an, bn);
+  }
+  dot_product = HorizontalSumAVX512(dot);
+  anormsq = HorizontalSumAVX512(an);
+  bnormsq = HorizontalSumAVX512(bn);
+  DotAndNormSqrdsScalar(a + i, b + i, count - i, dot_product, anormsq, bnormsq);
+}
+
+#elif HOROVOD_CPU_KERNELS_NEON
+
+// Integer sums are left to the vectorizer, NEON is always enabled on AArch64.
+template <typename T>
+void SumNEON(const T* a, const T* b, T* out, int64_t count) {
+  SumScalar(a, b, out, count);
+}
+
+template <>
+void SumNEON(const float* a, const float* b, float* out, int64_t count) {
+  int64_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(out + i, vaddq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+  }
+  SumScalar(a + i, b + i, out + i, count - i);
+}
+
+template <>
+void SumNEON(const double* a, const double* b, double* out, int64_t count) {
+  int64_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    vst1q_f64(out + i, vaddq_f64(vld1q_f64(a + i), vld1q_f64(b + i)));
+  }
+  SumScalar(a + i, b + i, out + i, count - i);
+}
+
+void ScaleNEON(const float* input, float* output, int64_t count,
+               float scale_factor) {
+  int64_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(output + i, vmulq_n_f32(vld1q_f32(input + i), scale_factor));
+  }
+  ScaleScalar(input + i, output + i, count - i, scale_factor);
+}
+
+void ScaleNEON(const double* input, double* output, int64_t count,
+               double scale_factor) {
+  int64_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    vst1q_f64(output + i, vmulq_n_f64(vld1q_f64(input + i), scale_factor));
+  }
+  ScaleScalar(input + i, output + i, count - i, scale_factor);
+}
+
+void ScaledAddNEON(float* a, const float* b, int64_t count, float acoeff,
+                   float bcoeff) {
+  float32x4_t acoeff_f32 = vdupq_n_f32(acoeff);
+  int64_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    float32x4_t scaled_b = vmulq_n_f32(vld1q_f32(b + i), bcoeff);
+    vst1q_f32(a + i, vfmaq_f32(scaled_b, vld1q_f32(a + i), acoeff_f32));
+  }
+  ScaledAddScalar(a + i, b + i, count - i, acoeff, bcoeff);
+}
+
+void ScaledAddNEON(double* a, const double* b, int64_t count, double acoeff,
+                   double bcoeff) {
+  float64x2_t acoeff_f64 = vdupq_n_f64(acoeff);
+  int64_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    float64x2_t scaled_b = vmulq_n_f64(vld1q_f64(b + i), bcoeff);
+    vst1q_f64(a + i, vfmaq_f64(scaled_b, vld1q_f64(a + i), acoeff_f64));
+  }
+  ScaledAddScalar(a + i, b + i, count - i, acoeff, bcoeff);
+}
+
+inline void AccumulateDotAndNormSqrdsNEON(float64x2_t a, float64x2_t b,
+                                          float64x2_t& dot,
+                                          float64x2_t& anormsq,
+                                          float64x2_t& bnormsq) {
+  dot = vfmaq_f64(dot, a, b);
+  anormsq = vfmaq_f64(anormsq, a, a);
+  bnormsq = vfmaq_f64(bnormsq, b, b);
+}
+
+void DotAndNormSqrdsNEON(const float* a, const float* b, int64_t count,
+                         double& dot_product, double& anormsq,
+                         double& bnormsq) {
+  float64x2_t dot = vdupq_n_f64(0.0);
+  float64x2_t an = vdupq_n_f64(0.0);
+  float64x2_t bn = vdupq_n_f64(0.0);
+  int64_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    float32x4_t a_f32 = vld1q_f32(a + i);
+    float32x4_t b_f32 = vld1q_f32(b + i);
+    AccumulateDotAndNormSqrdsNEON(vcvt_f64_f32(vget_low_f32(a_f32)),
+                                  vcvt_f64_f32(vget_low_f32(b_f32)), dot, an,
+                                  bn);
+    AccumulateDotAndNormSqrdsNEON(vcvt_high_f64_f32(a_f32),
+                                  vcvt_high_f64_f32(b_f32), dot, an, bn);
+  }
+  dot_product = vaddvq_f64(dot);
+  anormsq = vaddvq_f64(an);
+  bnormsq = vaddvq_f64(bn);
+  DotAndNormSqrdsScalar(a + i, b + i, count - i, dot_product, anormsq, bnormsq);
+}
+
+void DotAndNormSqrdsNEON(const double* a, const double* b, int64_t count,
+                         double& dot_product, double& anormsq,
+                         double& bnormsq) {
+  float64x2_t dot = vdupq_n_f64(0.0);
+  float64x2_t an = vdupq_n_f64(0.0);
+  float64x2_t bn = vdupq_n_f64(0.0);
+  int64_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    AccumulateDotAndNormSqrdsNEON(vld1q_f64(a + i), vld1q_f64(b + i), dot, an,
+                                  bn);
+  }
+  dot_product = vaddvq_f64(dot);
+  anormsq = vaddvq_f64(an);
+  bnormsq = vaddvq_f64(bn);
+  DotAndNormSqrdsScalar(a + i, b + i, count - i, dot_product, anormsq, bnormsq);
+}
+
+#endif
+
+template <typename T>
+void DispatchSum(const T* a, const T* b, T* out, int64_t count) {
+  switch (GetCPUKernelISA()) {
+#if HOROVOD_CPU_KERNELS_X86
+  case CPUKernelISA::AVX512:
+    SumAVX512(a, b, out, count);
+    return;
+  case CPUKernelISA::AVX2:
+    SumAVX2(a, b, out, count);
+    return;
+#elif HOROVOD_CPU_KERNELS_NEON
+  case CPUKernelISA::NEON:
+    SumNEON(a, b, out, count);
+    return;
+#endif
+  default:
+    SumScalar(a, b, out, count);
+  }
+}
+
+template <typename T>
+void DispatchScale(const T* input, T* output, int64_t count, T scale_factor) {
+  switch (GetCPUKernelISA()) {
+#if HOROVOD_CPU_KERNELS_X86
+  case CPUKernelISA::AVX512:
+    ScaleAVX512(input, output, count, scale_factor);
+    return;
+  case CPUKernelISA::AVX2:
+    ScaleAVX2(input, output, count, scale_factor);
+    return;
+#elif HOROVOD_CPU_KERNELS_NEON
+  case CPUKernelISA::NEON:
+    ScaleNEON(input, output, count, scale_factor);
+    return;
+#endif
+  default:
+    ScaleScalar(input, output, count, scale_factor);
+  }
+}
+
+template <typename T>
+void DispatchScaledAdd(T* a, const T* b, int64_t count, T acoeff, T bcoeff) {
+  switch (GetCPUKernelISA()) {
+#if HOROVOD_CPU_KERNELS_X86
+  case CPUKernelISA::AVX512:
+    ScaledAddAVX512(a, b, count, acoeff, bcoeff);
+    return;
+  case CPUKernelISA::AVX2:
+    ScaledAddAVX2(a, b, count, acoeff, bcoeff);
+    return;
+#elif HOROVOD_CPU_KERNELS_NEON
+  case CPUKernelISA::NEON:
+    ScaledAddNEON(a, b, count, acoeff, bcoeff);
+    return;
+#endif
+  default:
+    ScaledAddScalar(a, b, count, acoeff, bcoeff);
+  }
+}
+
+template <typename T>
+void DispatchDotAndNormSqrds(const T* a, const T* b, int64_t count,
+                             double& dot_product, double& anormsq,
+                             double& bnormsq) {
+  switch (GetCPUKernelISA()) {
+#if HOROVOD_CPU_KERNELS_X86
+  case CPUKernelISA::AVX512:
+    DotAndNormSqrdsAVX512(a, b, count, dot_product, anormsq, bnormsq);
+    return;
+  case CPUKernelISA::AVX2:
+    DotAndNormSqrdsAVX2(a, b, count, dot_product, anormsq, bnormsq);
+    return;
+#elif HOROVOD_CPU_KERNELS_NEON
+  case CPUKernelISA::NEON:
+    DotAndNormSqrdsNEON(a, b, count, dot_product, anormsq, bnormsq);
+    return;
+#endif
+  default:
+    dot_product = 0.;
+    anormsq = 0.;
+    bnormsq = 0.;
+    DotAndNormSqrdsScalar(a, b, count, dot_product, anormsq, bnormsq);
+  }
+}
+
+} // namespace
+
+CPUKernelISA GetCPUKernelISA() {
+  static const CPUKernelISA isa = DetectCPUKernelISA();
+  return isa;
+}
+
+const char* CPUKernelISAName(CPUKernelISA isa) {
+  switch (isa) {
+  case CPUKernelISA::AVX2:
+    return "AVX2";
+  case CPUKernelISA::AVX512:
+    return "AVX-512";
+  case CPUKernelISA::NEON:
+    return "NEON";
+  default:
+    return "scalar";
+  }
+}
+
+void SumCPU(const uint8_t* a, const uint8_t* b, uint8_t* out, int64_t count) {
+  DispatchSum(a, b, out, count);
+}
+
+void SumCPU(const int8_t* a, const int8_t* b, int8_t* out, int64_t count) {
+  DispatchSum(a, b, out, count);
+}
+
+void SumCPU(const uint16_t* a, const uint16_t* b, uint16_t* out,
+            int64_t count) {
+  DispatchSum(a, b, out, count);
+}
+
+void SumCPU(const int16_t* a, const int16_t* b, int16_t* out, int64_t count) {
+  DispatchSum(a, b, out, count);
+}
+
+void SumCPU(const int32_t* a, const int32_t* b, int32_t* out, int64_t count) {
+  DispatchSum(a, b, out, count);
+}
+
+void SumCPU(const int64_t* a, const int64_t* b, int64_t* out, int64_t count) {
+  DispatchSum(a, b, out, count);
+}
+
+void SumCPU(const float* a, const float* b, float* out, int64_t count) {
+  DispatchSum(a, b, out, count);
+}
+
+void SumCPU(const double* a, const double* b, double* out, int64_t count) {
+  DispatchSum(a, b, out, count);
+}
+
+void ScaleCPU(const float* input, float* output, int64_t count,
+              float scale_factor) {
+  DispatchScale(input, output, count, scale_factor);
+}
+
+void ScaleCPU(const double* input, double* output, int64_t count,
+              double scale_factor) {
+  DispatchScale(input, output, count, scale_factor);
+}
+
+void ScaledAddCPU(float* a, const float* b, int64_t count, float acoeff,
+                  float bcoeff) {
+  DispatchScaledAdd(a, b, count, acoeff, bcoeff);
+}
+
+void ScaledAddCPU(double* a, const double* b, int64_t count, double acoeff,
+                  double bcoeff) {
+  DispatchScaledAdd(a, b, count, acoeff, bcoeff);
+}
+
+void DotAndNormSqrdsCPU(const float* a, const float* b, int64_t count,
+                        double& dot_product, double& anormsq,
+                        double& bnormsq) {
+  DispatchDotAndNormSqrds(a, b, count, dot_product, anormsq, bnormsq);
+}
+
+void DotAndNormSqrdsCPU(const double* a, const double* b, int64_t count,
+                        double& dot_product, double& anormsq,
+                        double& bnormsq) {
+  DispatchDotAndNormSqrds(a, b, count, dot_product, anormsq, bnormsq);
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,63 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_CPU_KERNELS_H
+#define HOROVOD_CPU_KERNELS_H
+
+#include <cstdint>
+
+namespace horovod {
+namespace common {
+
+// Instruction set used by the CPU reduction kernels below. It is detected
+// once per process, the widest one supported by the host wins.
+enum class CPUKernelISA { SCALAR, AVX2, AVX512, NEON };
+
+CPUKernelISA GetCPUKernelISA();
+
+const char* CPUKernelISAName(CPUKernelISA isa);
+
+// Element-wise out[i] = a[i] + b[i]. out may alias a or b.
+void SumCPU(const uint8_t* a, const uint8_t* b, uint8_t* out, int64_t count);
+void SumCPU(const int8_t* a, const int8_t* b, int8_t* out, int64_t count);
+void SumCPU(const uint16_t* a, const uint16_t* b, uint16_t* out, int64_t count);
+void SumCPU(const int16_t* a, const int16_t* b, int16_t* out, int64_t count);
+void SumCPU(const int32_t* a, const int32_t* b, int32_t* out, int64_t count);
+void SumCPU(const int64_t* a, const int64_t* b, int64_t* out, int64_t count);
+void SumCPU(const float* a, const float* b, float* out, int64_t count);
+void SumCPU(const double* a, const double* b, double* out, int64_t count);
+
+// Element-wise output[i] = scale_factor * input[i]. output may alias input.
+void ScaleCPU(const float* input, float* output, int64_t count,
+              float scale_factor);
+void ScaleCPU(const double* input, double* output, int64_t count,
+              double scale_factor);
+
+// Element-wise a[i] = acoeff * a[i] + bcoeff * b[i].
+void ScaledAddCPU(float* a, const float* b, int64_t count, float acoeff,
+                  float bcoeff);
+void ScaledAddCPU(double* a, const double* b, int64_t count, double acoeff,
+                  double bcoeff);
+
+// Dot product of a and b and the squared norm of each, accumulated in double.
+void DotAndNormSqrdsCPU(const float* a, const float* b, int64_t count,
+                        double& dot_product, double& anormsq, double& bnormsq);
+void DotAndNormSqrdsCPU(const double* a, const double* b, int64_t count,
+                        double& dot_product, double& anormsq, double& bnormsq);
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_CPU_KERNELS_H
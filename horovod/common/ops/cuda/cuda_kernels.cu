@@ -15,8 +15,12 @@
 
 #include "cuda_kernels.h"
 
+#include <algorithm>
 #include <stdexcept>
 #include <cuda_fp16.h>
+#if CUDART_VERSION >= 11000
+#include <cuda_bf16.h>
+#endif
 
 namespace horovod {
 namespace common {
@@ -41,6 +45,44 @@ __device__ void batched_memcpy_d(size_t idx, const void* in, void* out, size_t s
   }
 }
 
+// Widest alignment, up to 16 bytes, that input and output reach after
+// skipping the same number of bytes. head is set to that number.
+__device__ size_t batched_memcpy_alignment(const void* input, const void* output, size_t size, size_t& head) {
+  size_t in_addr = reinterpret_cast<size_t>(input);
+  size_t diff = (in_addr ^ reinterpret_cast<size_t>(output)) % 16;
+  size_t align = diff == 0 ? 16 : diff & (~diff + 1);
+  head = (align - in_addr % align) % align;
+  if (head > size) {
+    head = size;
+  }
+  return align;
+}
+
+// Copies size bytes without requiring any alignment. Bytes before the common
+// alignment of input and output are copied one by one, the rest with loads and
+// stores as wide as that alignment.
+template<int blocks_per_copy>
+__device__ void batched_memcpy_unaligned_d(size_t idx, const void* input, void* output, size_t size) {
+  size_t head;
+  size_t align = batched_memcpy_alignment(input, output, size, head);
+  batched_memcpy_d<unsigned char, blocks_per_copy>(idx, input, output, head);
+  input = reinterpret_cast<const unsigned char*>(input) + head;
+  output = reinterpret_cast<unsigned char*>(output) + head;
+  size -= head;
+
+  if (align == 16) {
+    batched_memcpy_d<ulonglong2, blocks_per_copy>(idx, input, output, size);
+  } else if (align == 8) {
+    batched_memcpy_d<unsigned long long, blocks_per_copy>(idx, input, output, size);
+  } else if (align == 4) {
+    batched_memcpy_d<unsigned int, blocks_per_copy>(idx, input, output, size);
+  } else if (align == 2) {
+    batched_memcpy_d<unsigned short, blocks_per_copy>(idx, input, output, size);
+  } else {
+    batched_memcpy_d<unsigned char, blocks_per_copy>(idx, input, output, size);
+  }
+}
+
 template<int blocks_per_copy>
 __global__ void batched_memcpy_k(BatchedD2DParams params) {
   const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
@@ -49,30 +91,15 @@ __global__ void batched_memcpy_k(BatchedD2DParams params) {
   const void* input = params.in[blockIdx.x / blocks_per_copy];
   void* output = params.out[blockIdx.x / blocks_per_copy];
 
-  // Check alignment relative to 16 bytes
-  size_t align_in = reinterpret_cast<size_t>(input) % BATCHED_D2D_PADDING;
-  size_t align_out = reinterpret_cast<size_t>(output) % BATCHED_D2D_PADDING;
+  batched_memcpy_unaligned_d<blocks_per_copy>(idx, input, output, size);
+}
 
-  // Select load/store size based on the misaligned buffer
-  size_t align = (align_out == 0) ? align_in : align_out;
-  if (align_in && align_out) {
-    // If both are misaligned, use unsigned char (this should not occur
-    // as fusion buffer locations should be aligned by applying BATCH_D2D_PADDING
-    // during construction.)
-    align = 1;
-  }
+template<int blocks_per_copy>
+__global__ void batched_memcpy_table_k(const BatchedD2DCopy* copies) {
+  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
 
-  if (align % 16 == 0) {
-    batched_memcpy_d<ulonglong2, blocks_per_copy>(idx, input, output, size);
-  } else if (align % 8 == 0) {
-    batched_memcpy_d<unsigned long long, blocks_per_copy>(idx, input, output, size);
-  } else if (align % 4 == 0) {
-    batched_memcpy_d<unsigned int, blocks_per_copy>(idx, input, output, size);
-  } else if (align % 2 == 0) {
-    batched_memcpy_d<unsigned short, blocks_per_copy>(idx, input, output, size);
-  } else {
-    batched_memcpy_d<unsigned char, blocks_per_copy>(idx, input, output, size);
-  }
+  const BatchedD2DCopy copy = copies[blockIdx.x / blocks_per_copy];
+  batched_memcpy_unaligned_d<blocks_per_copy>(idx, copy.in, copy.out, copy.size);
 }
 
 #define NTHREADS_D2D_KERNEL 1024
@@ -83,6 +110,15 @@ void BatchedD2DMemcpyCudaImpl(BatchedD2DParams& params, int num_copies, cudaStre
                                                   NTHREADS_D2D_KERNEL, 0, stream>>>(params);
 }
 
+void BatchedD2DMemcpyTableCudaImpl(const BatchedD2DCopy* copies, int num_copies, cudaStream_t stream)
+{
+   if (num_copies == 0) {
+     return;
+   }
+   batched_memcpy_table_k<BLOCKS_PER_COPY_D2D_KERNEL><<<(int64_t)num_copies * BLOCKS_PER_COPY_D2D_KERNEL,
+                                                        NTHREADS_D2D_KERNEL, 0, stream>>>(copies);
+}
+
 template<typename T, typename TS>
 __global__ void scale_buffer_k(const T* input, T* output, int64_t num_elements, const TS scale_factor) {
 
@@ -135,6 +171,20 @@ __global__ void scale_buffer_k(const __half* input, __half* output, int64_t num_
 #endif
 }
 
+#if CUDART_VERSION >= 11000
+// Specialization for bfloat16, scaled in float32
+template<>
+__global__ void scale_buffer_k(const __nv_bfloat16* input, __nv_bfloat16* output, int64_t num_elements,
+                               const float scale_factor) {
+
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  for (size_t i = idx; i < num_elements; i += gridDim.x * blockDim.x) {
+    output[i] = __float2bfloat16(scale_factor * __bfloat162float(input[i]));
+  }
+}
+#endif
+
 #define NTHREADS_SCALE_BUFFER_KERNEL 512
 void ScaleBufferCudaImpl(const void* fused_input_data, void* buffer_data, const int64_t num_elements, double scale_factor,
                          DataType dtype, cudaStream_t stream) {
@@ -172,6 +222,12 @@ void ScaleBufferCudaImpl(const void* fused_input_data, void* buffer_data, const
      }
       break;
     }
+#if CUDART_VERSION >= 11000
+    case HOROVOD_BFLOAT16:
+      scale_buffer_k<<<blocks, threads, 0, stream>>>((const __nv_bfloat16*) fused_input_data,
+                                                     (__nv_bfloat16*) buffer_data, num_elements, (float) scale_factor);
+      break;
+#endif
     case HOROVOD_FLOAT32:
       scale_buffer_k<<<blocks, threads, 0, stream>>>((const float*) fused_input_data, (float*) buffer_data,
                                                      num_elements, (float) scale_factor);
@@ -186,6 +242,88 @@ void ScaleBufferCudaImpl(const void* fused_input_data, void* buffer_data, const
   }
 }
 
+template<typename T, typename TS>
+__global__ void scaled_add_buffer_k(const T* input, T* buffer, int64_t num_elements, const TS scale_factor) {
+
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  for (size_t i = idx; i < num_elements; i += gridDim.x * blockDim.x) {
+    buffer[i] += scale_factor * input[i];
+  }
+}
+
+// Specialization for half, added in float32
+template<>
+__global__ void scaled_add_buffer_k(const __half* input, __half* buffer, int64_t num_elements,
+                                    const float scale_factor) {
+
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  for (size_t i = idx; i < num_elements; i += gridDim.x * blockDim.x) {
+    buffer[i] = __float2half(__half2float(buffer[i]) + scale_factor * __half2float(input[i]));
+  }
+}
+
+#if CUDART_VERSION >= 11000
+// Specialization for bfloat16, added in float32
+template<>
+__global__ void scaled_add_buffer_k(const __nv_bfloat16* input, __nv_bfloat16* buffer, int64_t num_elements,
+                                    const float scale_factor) {
+
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  for (size_t i = idx; i < num_elements; i += gridDim.x * blockDim.x) {
+    buffer[i] = __float2bfloat16(__bfloat162float(buffer[i]) + scale_factor * __bfloat162float(input[i]));
+  }
+}
+#endif
+
+void ScaledAddBufferCudaImpl(const void* input_data, void* buffer_data, const int64_t num_elements,
+                             double scale_factor, DataType dtype, cudaStream_t stream) {
+  const int64_t blocks = (num_elements + NTHREADS_SCALE_BUFFER_KERNEL - 1) / NTHREADS_SCALE_BUFFER_KERNEL;
+  const int threads = NTHREADS_SCALE_BUFFER_KERNEL;
+  switch (dtype) {
+    case HOROVOD_UINT8:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const uint8_t*) input_data, (uint8_t*) buffer_data,
+                                                          num_elements, scale_factor);
+      break;
+    case HOROVOD_INT8:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const int8_t*) input_data, (int8_t*) buffer_data,
+                                                          num_elements, scale_factor);
+      break;
+    case HOROVOD_INT32:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const int32_t*) input_data, (int32_t*) buffer_data,
+                                                          num_elements, scale_factor);
+      break;
+    case HOROVOD_INT64:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const int64_t*) input_data, (int64_t*) buffer_data,
+                                                          num_elements, scale_factor);
+      break;
+    case HOROVOD_FLOAT16:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const __half*) input_data, (__half*) buffer_data,
+                                                          num_elements, (float) scale_factor);
+      break;
+#if CUDART_VERSION >= 11000
+    case HOROVOD_BFLOAT16:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const __nv_bfloat16*) input_data,
+                                                          (__nv_bfloat16*) buffer_data, num_elements,
+                                                          (float) scale_factor);
+      break;
+#endif
+    case HOROVOD_FLOAT32:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const float*) input_data, (float*) buffer_data,
+                                                          num_elements, (float) scale_factor);
+      break;
+    case HOROVOD_FLOAT64:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const double*) input_data, (double*) buffer_data,
+                                                          num_elements, scale_factor);
+      break;
+    default:
+      throw std::logic_error("Type " + DataType_Name(dtype) +
+                             " not supported by ScaledAddBufferCudaImpl.");
+  }
+}
+
 template<typename TL, int blocks_per_copy, typename T, typename TS>
 __device__ void batched_scaled_memcpy_d(size_t idx, const T* input, T* output, size_t size, const TS scale_factor) {
 
@@ -253,39 +391,84 @@ __device__ void batched_scaled_memcpy_d(size_t idx, const __half* input, __half*
   }
 }
 
-template<typename T, int blocks_per_copy, typename TS>
-__global__ void batched_scaled_memcpy_k(BatchedD2DParams params, TS scale_factor) {
-  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
+#if CUDART_VERSION >= 11000
+// Specialization for bfloat16, scaled in float32
+template<typename TL, int blocks_per_copy>
+__device__ void batched_scaled_memcpy_d(size_t idx, const __nv_bfloat16* input, __nv_bfloat16* output, size_t size,
+                                        const float scale_factor) {
 
-  const size_t size = params.sizes[blockIdx.x / blocks_per_copy];
-  const T* input = reinterpret_cast<const T*>(params.in[blockIdx.x / blocks_per_copy]);
-  T* output = reinterpret_cast<T*>(params.out[blockIdx.x / blocks_per_copy]);
+  const int64_t num_words = size / sizeof(TL);
+  const TL* read_ptr = reinterpret_cast<const TL*>(input);
+  TL* write_ptr = reinterpret_cast<TL*>(output);
+  for (size_t i = idx; i < num_words; i += blockDim.x * blocks_per_copy) {
+    // Load word
+    TL word = read_ptr[i];
+    __nv_bfloat16* val = reinterpret_cast<__nv_bfloat16*>(&word);
 
-  // Check alignment relative to 16 bytes
-  size_t align_in = reinterpret_cast<size_t>(input) % BATCHED_D2D_PADDING;
-  size_t align_out = reinterpret_cast<size_t>(output) % BATCHED_D2D_PADDING;
+    // Scale elements in word
+    for (int j = 0; j < sizeof(TL) / sizeof(__nv_bfloat16); ++j) {
+      val[j] = __float2bfloat16(scale_factor * __bfloat162float(val[j]));
+    }
 
-  // Select load/store size based on the misaligned buffer
-  size_t align = (align_out == 0) ? align_in : align_out;
-  if (align_in && align_out) {
+    // Write word
+    write_ptr[i] = word;
+  }
 
-    // If both are misaligned, use datatype size
-    align = sizeof(T);
+  // Deal with any remaining elements
+  size_t remainder = (size % sizeof(TL)) / sizeof(__nv_bfloat16);
+  if (remainder > 0 && idx < remainder) {
+    const __nv_bfloat16* input_r = reinterpret_cast<const __nv_bfloat16*>(read_ptr + num_words);
+    __nv_bfloat16* output_r = reinterpret_cast<__nv_bfloat16*>(write_ptr + num_words);
+    output_r[idx] = __float2bfloat16(scale_factor * __bfloat162float(input_r[idx]));
   }
+}
+#endif
 
-  if (align % 16 == 0) {
+// As batched_memcpy_unaligned_d, for element-aligned input and output. The
+// common alignment is then never narrower than an element.
+template<int blocks_per_copy, typename T, typename TS>
+__device__ void batched_scaled_memcpy_unaligned_d(size_t idx, const T* input, T* output, size_t size,
+                                                  const TS scale_factor) {
+  size_t head;
+  size_t align = batched_memcpy_alignment(input, output, size, head);
+  batched_scaled_memcpy_d<T, blocks_per_copy>(idx, input, output, head, scale_factor);
+  input += head / sizeof(T);
+  output += head / sizeof(T);
+  size -= head;
+
+  if (align == 16) {
     batched_scaled_memcpy_d<ulonglong2, blocks_per_copy>(idx, input, output, size, scale_factor);
-  } else if (align % 8 == 0) {
+  } else if (align == 8) {
     batched_scaled_memcpy_d<unsigned long long, blocks_per_copy>(idx, input, output, size, scale_factor);
-  } else if (align % 4 == 0) {
+  } else if (align == 4) {
     batched_scaled_memcpy_d<unsigned int, blocks_per_copy>(idx, input, output, size, scale_factor);
-  } else if (align % 2 == 0) {
+  } else if (align == 2) {
     batched_scaled_memcpy_d<unsigned short, blocks_per_copy>(idx, input, output, size, scale_factor);
   } else {
     batched_scaled_memcpy_d<unsigned char, blocks_per_copy>(idx, input, output, size, scale_factor);
   }
 }
 
+template<typename T, int blocks_per_copy, typename TS>
+__global__ void batched_scaled_memcpy_k(BatchedD2DParams params, TS scale_factor) {
+  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
+
+  const size_t size = params.sizes[blockIdx.x / blocks_per_copy];
+  const T* input = reinterpret_cast<const T*>(params.in[blockIdx.x / blocks_per_copy]);
+  T* output = reinterpret_cast<T*>(params.out[blockIdx.x / blocks_per_copy]);
+
+  batched_scaled_memcpy_unaligned_d<blocks_per_copy>(idx, input, output, size, scale_factor);
+}
+
+template<typename T, int blocks_per_copy, typename TS>
+__global__ void batched_scaled_memcpy_table_k(const BatchedD2DCopy* copies, TS scale_factor) {
+  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
+
+  const BatchedD2DCopy copy = copies[blockIdx.x / blocks_per_copy];
+  batched_scaled_memcpy_unaligned_d<blocks_per_copy>(idx, reinterpret_cast<const T*>(copy.in),
+                                                     reinterpret_cast<T*>(copy.out), copy.size, scale_factor);
+}
+
 void BatchedScaledD2DMemcpyCudaImpl(BatchedD2DParams& params, int num_copies, double scale_factor,
                                     DataType dtype, cudaStream_t stream) {
   const int64_t blocks = num_copies * BLOCKS_PER_COPY_D2D_KERNEL;
@@ -308,6 +491,11 @@ void BatchedScaledD2DMemcpyCudaImpl(BatchedD2DParams& params, int num_copies, do
      batched_scaled_memcpy_k<__half, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(params, scale_factor_half);
      break;
    }
+#if CUDART_VERSION >= 11000
+   case HOROVOD_BFLOAT16:
+     batched_scaled_memcpy_k<__nv_bfloat16, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(params, (float) scale_factor);
+     break;
+#endif
    case HOROVOD_FLOAT32:
      batched_scaled_memcpy_k<float, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(params, (float) scale_factor);
      break;
@@ -320,6 +508,355 @@ void BatchedScaledD2DMemcpyCudaImpl(BatchedD2DParams& params, int num_copies, do
   }
 }
 
+void BatchedScaledD2DMemcpyTableCudaImpl(const BatchedD2DCopy* copies, int num_copies, double scale_factor,
+                                         DataType dtype, cudaStream_t stream) {
+  if (num_copies == 0) {
+    return;
+  }
+  const int64_t blocks = (int64_t)num_copies * BLOCKS_PER_COPY_D2D_KERNEL;
+  const int threads = NTHREADS_D2D_KERNEL;
+  switch (dtype) {
+   case HOROVOD_UINT8:
+     batched_scaled_memcpy_table_k<uint8_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor);
+     break;
+   case HOROVOD_INT8:
+     batched_scaled_memcpy_table_k<int8_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor);
+     break;
+   case HOROVOD_INT32:
+     batched_scaled_memcpy_table_k<int32_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor);
+     break;
+   case HOROVOD_INT64:
+     batched_scaled_memcpy_table_k<int64_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor);
+     break;
+   case HOROVOD_FLOAT16: {
+     __half scale_factor_half = __float2half((float) scale_factor);
+     batched_scaled_memcpy_table_k<__half, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor_half);
+     break;
+   }
+#if CUDART_VERSION >= 11000
+   case HOROVOD_BFLOAT16:
+     batched_scaled_memcpy_table_k<__nv_bfloat16, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, (float) scale_factor);
+     break;
+#endif
+   case HOROVOD_FLOAT32:
+     batched_scaled_memcpy_table_k<float, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, (float) scale_factor);
+     break;
+   case HOROVOD_FLOAT64:
+     batched_scaled_memcpy_table_k<double, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor);
+     break;
+   default:
+     throw std::logic_error("Type " + DataType_Name(dtype) +
+                            " not supported by BatchedScaledD2DMemcpyTableCudaImpl.");
+  }
+}
+
+template<typename T>
+__device__ float cast_to_float(T value);
+
+template<>
+__device__ float cast_to_float(float value) {
+  return value;
+}
+
+template<>
+__device__ float cast_to_float(__half value) {
+  return __half2float(value);
+}
+
+template<typename T>
+__device__ T cast_from_float(float value);
+
+template<>
+__device__ float cast_from_float(float value) {
+  return value;
+}
+
+template<>
+__device__ __half cast_from_float(float value) {
+  return __float2half(value);
+}
+
+#if CUDART_VERSION >= 11000
+template<>
+__device__ float cast_to_float(__nv_bfloat16 value) {
+  return __bfloat162float(value);
+}
+
+template<>
+__device__ __nv_bfloat16 cast_from_float(float value) {
+  return __float2bfloat16(value);
+}
+#endif
+
+template<typename TIn, typename TOut, int blocks_per_copy>
+__global__ void batched_scaled_cast_memcpy_k(BatchedD2DParams params, float scale_factor) {
+  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
+
+  const size_t num_elements = params.sizes[blockIdx.x / blocks_per_copy];
+  const TIn* input = reinterpret_cast<const TIn*>(params.in[blockIdx.x / blocks_per_copy]);
+  TOut* output = reinterpret_cast<TOut*>(params.out[blockIdx.x / blocks_per_copy]);
+
+  // Scaling is done in float32 so that the float16 range is only hit by the
+  // scaled value.
+  for (size_t i = idx; i < num_elements; i += blockDim.x * blocks_per_copy) {
+    output[i] = cast_from_float<TOut>(scale_factor * cast_to_float(input[i]));
+  }
+}
+
+void BatchedScaledCastD2DMemcpyCudaImpl(BatchedD2DParams& params, int num_copies, double scale_factor,
+                                        DataType in_dtype, DataType out_dtype, cudaStream_t stream) {
+  const int64_t blocks = num_copies * BLOCKS_PER_COPY_D2D_KERNEL;
+  const int threads = NTHREADS_D2D_KERNEL;
+  if (in_dtype == HOROVOD_FLOAT32 && out_dtype == HOROVOD_FLOAT16) {
+    batched_scaled_cast_memcpy_k<float, __half, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(
+        params, (float) scale_factor);
+  } else if (in_dtype == HOROVOD_FLOAT16 && out_dtype == HOROVOD_FLOAT32) {
+    batched_scaled_cast_memcpy_k<__half, float, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(
+        params, (float) scale_factor);
+  } else {
+    throw std::logic_error("Conversion from " + DataType_Name(in_dtype) + " to " + DataType_Name(out_dtype) +
+                           " not supported by BatchedScaledCastD2DMemcpyCudaImpl.");
+  }
+}
+
+template<typename TOut, int blocks_per_copy>
+__global__ void batched_scaled_cast_memcpy_ef_k(BatchedCastEFParams params, float scale_factor) {
+  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
+
+  const size_t num_elements = params.sizes[blockIdx.x / blocks_per_copy];
+  const float* input = reinterpret_cast<const float*>(params.in[blockIdx.x / blocks_per_copy]);
+  TOut* output = reinterpret_cast<TOut*>(params.out[blockIdx.x / blocks_per_copy]);
+  float* residual = params.residuals[blockIdx.x / blocks_per_copy];
+
+  for (size_t i = idx; i < num_elements; i += blockDim.x * blocks_per_copy) {
+    float value = scale_factor * input[i] + residual[i];
+    TOut compressed = cast_from_float<TOut>(value);
+    residual[i] = value - cast_to_float(compressed);
+    output[i] = compressed;
+  }
+}
+
+void BatchedScaledCastEFD2DMemcpyCudaImpl(BatchedCastEFParams& params, int num_copies, double scale_factor,
+                                          DataType out_dtype, cudaStream_t stream) {
+  const int64_t blocks = num_copies * BLOCKS_PER_COPY_D2D_KERNEL;
+  const int threads = NTHREADS_D2D_KERNEL;
+  if (out_dtype == HOROVOD_FLOAT16) {
+    batched_scaled_cast_memcpy_ef_k<__half, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(
+        params, (float) scale_factor);
+  } else {
+    throw std::logic_error("Conversion to " + DataType_Name(out_dtype) +
+                           " not supported by BatchedScaledCastEFD2DMemcpyCudaImpl.");
+  }
+}
+
+template<typename TIn, typename TOut>
+__global__ void scaled_cast_buffer_k(const TIn* input, TOut* output, int64_t num_elements, float scale_factor) {
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  for (size_t i = idx; i < num_elements; i += gridDim.x * blockDim.x) {
+    output[i] = cast_from_float<TOut>(scale_factor * cast_to_float(input[i]));
+  }
+}
+
+void ScaledCastBufferCudaImpl(const void* input_data, void* buffer_data, const int64_t num_elements,
+                              double scale_factor, DataType in_dtype, DataType out_dtype, cudaStream_t stream) {
+  const int64_t blocks = (num_elements + NTHREADS_SCALE_BUFFER_KERNEL - 1) / NTHREADS_SCALE_BUFFER_KERNEL;
+  const int threads = NTHREADS_SCALE_BUFFER_KERNEL;
+  if (in_dtype == HOROVOD_FLOAT32 && out_dtype == HOROVOD_FLOAT16) {
+    scaled_cast_buffer_k<<<blocks, threads, 0, stream>>>((const float*) input_data, (__half*) buffer_data,
+                                                         num_elements, (float) scale_factor);
+  } else if (in_dtype == HOROVOD_FLOAT16 && out_dtype == HOROVOD_FLOAT32) {
+    scaled_cast_buffer_k<<<blocks, threads, 0, stream>>>((const __half*) input_data, (float*) buffer_data,
+                                                         num_elements, (float) scale_factor);
+#if CUDART_VERSION >= 11000
+  } else if (in_dtype == HOROVOD_FLOAT32 && out_dtype == HOROVOD_BFLOAT16) {
+    scaled_cast_buffer_k<<<blocks, threads, 0, stream>>>((const float*) input_data, (__nv_bfloat16*) buffer_data,
+                                                         num_elements, (float) scale_factor);
+  } else if (in_dtype == HOROVOD_BFLOAT16 && out_dtype == HOROVOD_FLOAT32) {
+    scaled_cast_buffer_k<<<blocks, threads, 0, stream>>>((const __nv_bfloat16*) input_data, (float*) buffer_data,
+                                                         num_elements, (float) scale_factor);
+#endif
+  } else {
+    throw std::logic_error("Conversion from " + DataType_Name(in_dtype) + " to " + DataType_Name(out_dtype) +
+                           " not supported by ScaledCastBufferCudaImpl.");
+  }
+}
+
+template<typename T>
+__device__ double adasum_to_double(T value) {
+  return (double) value;
+}
+
+template<>
+__device__ double adasum_to_double(__half value) {
+  return (double) __half2float(value);
+}
+
+#define NTHREADS_ADASUM_KERNEL 256
+// The grid y dimension is limited to 65535 blocks per launch.
+#define MAX_ADASUM_TENSORS_PER_LAUNCH 65535
+
+template<typename T>
+__global__ void adasum_dot_and_norm_sqrds_k(const T* a, const T* b, const int64_t* offsets, int first_tensor,
+                                            double* partials) {
+  __shared__ double dot_s[NTHREADS_ADASUM_KERNEL];
+  __shared__ double anormsq_s[NTHREADS_ADASUM_KERNEL];
+  __shared__ double bnormsq_s[NTHREADS_ADASUM_KERNEL];
+
+  const int tensor = first_tensor + blockIdx.y;
+  const int64_t begin = offsets[tensor];
+  const int64_t end = offsets[tensor + 1];
+
+  double dot = 0.0;
+  double anormsq = 0.0;
+  double bnormsq = 0.0;
+  for (int64_t i = begin + static_cast<int64_t>(blockDim.x) * blockIdx.x + threadIdx.x; i < end;
+       i += static_cast<int64_t>(blockDim.x) * gridDim.x) {
+    double a_i = adasum_to_double(a[i]);
+    double b_i = adasum_to_double(b[i]);
+    dot += a_i * b_i;
+    anormsq += a_i * a_i;
+    bnormsq += b_i * b_i;
+  }
+  dot_s[threadIdx.x] = dot;
+  anormsq_s[threadIdx.x] = anormsq;
+  bnormsq_s[threadIdx.x] = bnormsq;
+  __syncthreads();
+
+  for (int stride = blockDim.x / 2; stride > 0; stride /= 2) {
+    if (threadIdx.x < stride) {
+      dot_s[threadIdx.x] += dot_s[threadIdx.x + stride];
+      anormsq_s[threadIdx.x] += anormsq_s[threadIdx.x + stride];
+      bnormsq_s[threadIdx.x] += bnormsq_s[threadIdx.x + stride];
+    }
+    __syncthreads();
+  }
+
+  if (threadIdx.x == 0) {
+    double* out = partials + 3 * (static_cast<int64_t>(tensor) * gridDim.x + blockIdx.x);
+    out[0] = dot_s[0];
+    out[1] = anormsq_s[0];
+    out[2] = bnormsq_s[0];
+  }
+}
+
+// Sums the partial results of each tensor in a fixed order, so that results
+// do not depend on block scheduling.
+__global__ void adasum_sum_partials_k(const double* partials, int num_tensors, double* dots_and_norms) {
+  const int tensor = blockDim.x * blockIdx.x + threadIdx.x;
+  if (tensor >= num_tensors) {
+    return;
+  }
+  double dot = 0.0;
+  double anormsq = 0.0;
+  double bnormsq = 0.0;
+  const double* in = partials + 3 * static_cast<int64_t>(tensor) * ADASUM_BLOCKS_PER_TENSOR;
+  for (int i = 0; i < ADASUM_BLOCKS_PER_TENSOR; ++i) {
+    dot += in[3 * i];
+    anormsq += in[3 * i + 1];
+    bnormsq += in[3 * i + 2];
+  }
+  dots_and_norms[3 * tensor] = dot;
+  dots_and_norms[3 * tensor + 1] = anormsq;
+  dots_and_norms[3 * tensor + 2] = bnormsq;
+}
+
+template<typename T>
+void AdasumDotAndNormSqrdsCudaImplT(const T* a, const T* b, const int64_t* offsets, int num_tensors,
+                                    double* partials, double* dots_and_norms, cudaStream_t stream) {
+  for (int first = 0; first < num_tensors; first += MAX_ADASUM_TENSORS_PER_LAUNCH) {
+    dim3 blocks(ADASUM_BLOCKS_PER_TENSOR, std::min(num_tensors - first, MAX_ADASUM_TENSORS_PER_LAUNCH));
+    adasum_dot_and_norm_sqrds_k<<<blocks, NTHREADS_ADASUM_KERNEL, 0, stream>>>(a, b, offsets, first, partials);
+  }
+  const int sum_blocks = (num_tensors + NTHREADS_ADASUM_KERNEL - 1) / NTHREADS_ADASUM_KERNEL;
+  adasum_sum_partials_k<<<sum_blocks, NTHREADS_ADASUM_KERNEL, 0, stream>>>(partials, num_tensors, dots_and_norms);
+}
+
+void AdasumDotAndNormSqrdsCudaImpl(const void* a, const void* b, const int64_t* offsets, int num_tensors,
+                                   double* partials, double* dots_and_norms, DataType dtype,
+                                   cudaStream_t stream) {
+  if (num_tensors == 0) {
+    return;
+  }
+  switch (dtype) {
+    case HOROVOD_FLOAT16:
+      AdasumDotAndNormSqrdsCudaImplT((const __half*) a, (const __half*) b, offsets, num_tensors, partials,
+                                     dots_and_norms, stream);
+      break;
+    case HOROVOD_FLOAT32:
+      AdasumDotAndNormSqrdsCudaImplT((const float*) a, (const float*) b, offsets, num_tensors, partials,
+                                     dots_and_norms, stream);
+      break;
+    case HOROVOD_FLOAT64:
+      AdasumDotAndNormSqrdsCudaImplT((const double*) a, (const double*) b, offsets, num_tensors, partials,
+                                     dots_and_norms, stream);
+      break;
+    default:
+      throw std::logic_error("Type " + DataType_Name(dtype) +
+                             " not supported by AdasumDotAndNormSqrdsCudaImpl.");
+  }
+}
+
+template<typename T, typename TC>
+__device__ T adasum_scaled_add_d(T a, T b, TC acoeff, TC bcoeff) {
+  return acoeff * a + bcoeff * b;
+}
+
+// Specialization for half, computed in float32
+template<>
+__device__ __half adasum_scaled_add_d(__half a, __half b, float acoeff, float bcoeff) {
+  return __float2half(acoeff * __half2float(a) + bcoeff * __half2float(b));
+}
+
+template<typename T, typename TC>
+__global__ void adasum_scaled_add_k(T* a, const T* b, const int64_t* offsets, const double* coefficients,
+                                    int first_tensor) {
+  const int tensor = first_tensor + blockIdx.y;
+  const int64_t begin = offsets[tensor];
+  const int64_t end = offsets[tensor + 1];
+  const TC acoeff = (TC) coefficients[2 * tensor];
+  const TC bcoeff = (TC) coefficients[2 * tensor + 1];
+
+  for (int64_t i = begin + static_cast<int64_t>(blockDim.x) * blockIdx.x + threadIdx.x; i < end;
+       i += static_cast<int64_t>(blockDim.x) * gridDim.x) {
+    a[i] = adasum_scaled_add_d(a[i], b[i], acoeff, bcoeff);
+  }
+}
+
+template<typename T, typename TC>
+void AdasumScaledAddCudaImplT(T* a, const T* b, const int64_t* offsets, const double* coefficients,
+                              int num_tensors, cudaStream_t stream) {
+  for (int first = 0; first < num_tensors; first += MAX_ADASUM_TENSORS_PER_LAUNCH) {
+    dim3 blocks(ADASUM_BLOCKS_PER_TENSOR, std::min(num_tensors - first, MAX_ADASUM_TENSORS_PER_LAUNCH));
+    adasum_scaled_add_k<T, TC><<<blocks, NTHREADS_ADASUM_KERNEL, 0, stream>>>(a, b, offsets, coefficients,
+                                                                              first);
+  }
+}
+
+void AdasumScaledAddCudaImpl(void* a, const void* b, const int64_t* offsets, const double* coefficients,
+                             int num_tensors, DataType dtype, cudaStream_t stream) {
+  if (num_tensors == 0) {
+    return;
+  }
+  switch (dtype) {
+    case HOROVOD_FLOAT16:
+      AdasumScaledAddCudaImplT<__half, float>((__half*) a, (const __half*) b, offsets, coefficients,
+                                              num_tensors, stream);
+      break;
+    case HOROVOD_FLOAT32:
+      AdasumScaledAddCudaImplT<float, float>((float*) a, (const float*) b, offsets, coefficients,
+                                             num_tensors, stream);
+      break;
+    case HOROVOD_FLOAT64:
+      AdasumScaledAddCudaImplT<double, double>((double*) a, (const double*) b, offsets, coefficients,
+                                               num_tensors, stream);
+      break;
+    default:
+      throw std::logic_error("Type " + DataType_Name(dtype) +
+                             " not supported by AdasumScaledAddCudaImpl.");
+  }
+}
+
 } // namespace common
 } // namespace horovod
 
@@ -22,6 +22,7 @@
 
 #define BATCHED_D2D_CAPACITY 160
 #define BATCHED_D2D_PADDING 16
+#define BATCHED_CAST_EF_CAPACITY 120
 
 namespace horovod {
 namespace common {
@@ -35,13 +36,81 @@ struct BatchedD2DParams {
 // Performs a batched d2d memcopy
 void BatchedD2DMemcpyCudaImpl(BatchedD2DParams& params, int num_copies, cudaStream_t stream);
 
+// Copy of a batched d2d memcopy whose descriptors live in device memory, so
+// that a single launch covers any number of them.
+struct BatchedD2DCopy {
+  void* out;
+  const void* in;
+  size_t size;
+};
+
+// Performs the num_copies d2d memcopies in the device array copies. Buffers
+// need not be aligned: the bytes up to the widest alignment input and output
+// share are copied first, the rest with loads and stores of up to 16 bytes.
+void BatchedD2DMemcpyTableCudaImpl(const BatchedD2DCopy* copies, int num_copies, cudaStream_t stream);
+
 // Scales buffer by scalar
 void ScaleBufferCudaImpl(const void* fused_input_data, void* buffer_data, const int64_t num_elements,
                          double scale_factor, DataType dtype, cudaStream_t stream);
 
+// Adds input scaled by scalar to buffer
+void ScaledAddBufferCudaImpl(const void* input_data, void* buffer_data, const int64_t num_elements,
+                             double scale_factor, DataType dtype, cudaStream_t stream);
+
 void BatchedScaledD2DMemcpyCudaImpl(BatchedD2DParams& params, int num_copies, double scale_factor,
                                     DataType dtype, cudaStream_t stream);
 
+// As BatchedD2DMemcpyTableCudaImpl, also scaling the elements by scale_factor.
+// Sizes are in bytes.
+void BatchedScaledD2DMemcpyTableCudaImpl(const BatchedD2DCopy* copies, int num_copies, double scale_factor,
+                                         DataType dtype, cudaStream_t stream);
+
+// Performs a batched d2d memcopy that also scales and converts between float32 and
+// float16. Unlike the other batched kernels, params.sizes holds element counts.
+void BatchedScaledCastD2DMemcpyCudaImpl(BatchedD2DParams& params, int num_copies, double scale_factor,
+                                        DataType in_dtype, DataType out_dtype, cudaStream_t stream);
+
+// Copies of a batched d2d memcopy with error feedback, see
+// BatchedScaledCastEFD2DMemcpyCudaImpl. Sizes are element counts.
+struct BatchedCastEFParams {
+  void* out[BATCHED_CAST_EF_CAPACITY];
+  const void* in[BATCHED_CAST_EF_CAPACITY];
+  float* residuals[BATCHED_CAST_EF_CAPACITY];
+  size_t sizes[BATCHED_CAST_EF_CAPACITY];
+};
+
+// Performs a batched d2d memcopy from float32 to float16 with error feedback:
+// each input element is scaled, the residual left by the previous conversion
+// is added to it, and the part lost in the conversion to float16 is stored as
+// the new residual.
+void BatchedScaledCastEFD2DMemcpyCudaImpl(BatchedCastEFParams& params, int num_copies, double scale_factor,
+                                          DataType out_dtype, cudaStream_t stream);
+
+// Scales buffer by scalar while converting it between float32 and float16 or
+// bfloat16. Input and output must not overlap.
+void ScaledCastBufferCudaImpl(const void* input_data, void* buffer_data, const int64_t num_elements,
+                              double scale_factor, DataType in_dtype, DataType out_dtype, cudaStream_t stream);
+
+// Number of partial results per tensor produced by the first pass of
+// AdasumDotAndNormSqrdsCudaImpl.
+#define ADASUM_BLOCKS_PER_TENSOR 32
+
+// For each tensor i of the fused buffers a and b, covering elements
+// [offsets[i], offsets[i + 1]), writes the dot product of a and b and the
+// squared norms of a and b to dots_and_norms[3 * i .. 3 * i + 2]. Results are
+// accumulated in double. offsets, partials and dots_and_norms are device
+// buffers, partials must hold 3 * ADASUM_BLOCKS_PER_TENSOR * num_tensors
+// doubles.
+void AdasumDotAndNormSqrdsCudaImpl(const void* a, const void* b, const int64_t* offsets, int num_tensors,
+                                   double* partials, double* dots_and_norms, DataType dtype,
+                                   cudaStream_t stream);
+
+// For each tensor i of the fused buffers a and b, sets
+// a = coefficients[2 * i] * a + coefficients[2 * i + 1] * b. offsets and
+// coefficients are device buffers.
+void AdasumScaledAddCudaImpl(void* a, const void* b, const int64_t* offsets, const double* coefficients,
+                             int num_tensors, DataType dtype, cudaStream_t stream);
+
 } // namespace common
 } // namespace horovod
 
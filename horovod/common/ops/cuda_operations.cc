@@ -18,98 +18,35 @@
 #include "cuda/cuda_kernels.h"
 #include "../message.h"
 #include "../hashes.h"
+#include "../topology.h"
 
+#include <algorithm>
 #include <thread>
 
+#if HAVE_NVTX
+#include <nvtx3/nvToolsExtCudaRt.h>
+#endif // HAVE_NVTX
+
 namespace horovod {
 namespace common {
 class GPUContext::impl {
 public:
-  cudaError_t GetGpuEvent(Event* event, cudaStream_t stream) {
-    int device;
-    auto status = cudaGetDevice(&device);
-    if (status != cudaSuccess) {
-      return status;
-    }
-
-    auto& mutex = cuda_events_mutex;
-    {
-      std::lock_guard<std::mutex> guard(mutex);
-      auto key = std::make_pair(device, stream);
-      auto& queue = cuda_events[key];
-      if (!prepopulated[key]) {
-        // On first call for device and stream pair, prepopulate event queue.
-        // This is to minimize event reuse of callback events passed to framework.
-        for (int i = 0; i < N_CUDA_EVENTS_PREPOPULATE; ++i) {
-          cudaEvent_t ev;
-          status = cudaEventCreateWithFlags(&ev, cudaEventDisableTiming);
-          queue.emplace(std::make_shared<cudaEvent_t>(ev), stream);
-        }
-        prepopulated[key] = true;
-      }
-      if (!queue.empty()) {
-        *event = queue.front();
-        queue.pop();
-        return cudaSuccess;
-      }
-    }
-
-    cudaEvent_t ev;
-    status = cudaEventCreateWithFlags(&ev, cudaEventDisableTiming);
-    event->event = std::make_shared<cudaEvent_t>(ev);
-    event->stream = stream;
-
-    return status;
-  }
-
-  cudaError_t ReleaseGpuEvent(Event event) {
-    int device;
-    auto status = cudaGetDevice(&device);
-    if (status != cudaSuccess) {
-      return status;
-    }
-
-    auto& mutex = cuda_events_mutex;
-    {
-      std::lock_guard<std::mutex> guard(mutex);
-      auto& queue = cuda_events[std::make_pair(device, event.stream)];
-      queue.push(event);
-    }
-
-    return cudaSuccess;
-  }
-
   void ErrorCheck(std::string op_name, cudaError_t cuda_result) {
     if (cuda_result != cudaSuccess) {
       throw std::logic_error(std::string(op_name) + " failed: " + cudaGetErrorString(cuda_result));
     }
   }
 
-  void RecordEvent(std::queue<std::pair<std::string, Event>>& event_queue, std::string name, cudaStream_t& stream) {
-    Event event;
-    ErrorCheck("GetGpuEvent", GetGpuEvent(&event, stream));
-    ErrorCheck("cudaEventRecord", cudaEventRecord(*(event.event), event.stream));
-    event_queue.emplace(name, event);
-  }
-
-  Event RecordEvent(cudaStream_t& stream) {
-    Event event;
-    ErrorCheck("GetGpuEvent", GetGpuEvent(&event, stream));
-    ErrorCheck("cudaEventRecord", cudaEventRecord(*(event.event), event.stream));
-    return event;
-  }
-
-  void WaitForEvents(std::queue<std::pair<std::string, Event>>& event_queue,
+  void WaitForEvents(GPUEventQueue& event_queue,
       const std::vector<TensorTableEntry>& entries, Timeline& timeline,
       const std::function<void()>& error_check_callback,
       bool elastic) {
     while (!event_queue.empty()) {
-      std::string name;
-      Event event;
-      std::tie(name, event) = event_queue.front();
+      const char* phase = event_queue.front().first;
+      Event event = event_queue.front().second;
       event_queue.pop();
-      if (name != "") {
-        timeline.ActivityStartAll(entries, name);
+      if (phase[0] != '\0') {
+        timeline.ActivityStartAll(entries, phase);
       }
 
       // Check for async (networking) errors while waiting for the event to complete
@@ -140,39 +77,51 @@ public:
         }
       }
 
-      if (name != "") {
+      if (phase[0] != '\0') {
         timeline.ActivityEndAll(entries);
       }
-      ErrorCheck("ReleaseGpuEvent", ReleaseGpuEvent(event));
     }
   }
 
-  void ClearEvents(std::queue<std::pair<std::string, Event>>& event_queue,
+  void ClearEvents(GPUEventQueue& event_queue,
       const std::vector<TensorTableEntry>& entries, Timeline& timeline,
       const std::function<void()>& error_check_callback,
       bool elastic) {
     while (!event_queue.empty()) {
-      std::string name;
-      Event event;
-      std::tie(name, event) = event_queue.front();
+      const char* phase = event_queue.front().first;
       event_queue.pop();
-      if (name != "") {
-        timeline.ActivityStartAll(entries, name);
+      if (phase[0] != '\0') {
+        timeline.ActivityStartAll(entries, phase);
       }
 
-      if (name != "") {
+      if (phase[0] != '\0') {
         timeline.ActivityEndAll(entries);
       }
-      ErrorCheck("ReleaseGpuEvent", ReleaseGpuEvent(event));
     }
   }
 
-  void StreamCreate(cudaStream_t *stream) {
-    int greatest_priority;
+  bool EventCompleted(Event event) {
+    cudaError_t cuda_result = cudaEventQuery(*(event.event));
+    if (cuda_result == cudaErrorNotReady) {
+      return false;
+    }
+    ErrorCheck("cudaEventQuery", cuda_result);
+    return true;
+  }
+
+  void StreamCreate(cudaStream_t *stream, int priority) {
+    int least_priority, greatest_priority;
     ErrorCheck("cudaDeviceGetStreamPriorityRange",
-        cudaDeviceGetStreamPriorityRange(NULL, &greatest_priority));
+        cudaDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+    priority = std::min(std::max(priority, greatest_priority), least_priority);
     ErrorCheck("cudaStreamCreateWithPriority",
-        cudaStreamCreateWithPriority(stream, cudaStreamNonBlocking, greatest_priority));
+        cudaStreamCreateWithPriority(stream, cudaStreamNonBlocking, priority));
+  }
+
+  void StreamSetName(cudaStream_t stream, const std::string& name) {
+#if HAVE_NVTX
+    nvtxNameCudaStreamA(stream, name.c_str());
+#endif // HAVE_NVTX
   }
 
   void StreamSynchronize(cudaStream_t stream) {
@@ -201,6 +150,67 @@ public:
     ErrorCheck("cudaMemcpyAsync", cudaMemcpyAsync(dst, src, count, cudaMemcpyDeviceToHost, stream));
   }
 
+  void* HostAlloc(size_t size) {
+    void* buffer;
+    ErrorCheck("cudaHostAlloc", cudaHostAlloc(&buffer, size, cudaHostAllocDefault));
+    return buffer;
+  }
+
+  void HostFree(void* buffer) {
+    ErrorCheck("cudaFreeHost", cudaFreeHost(buffer));
+  }
+
+  void* DeviceAlloc(size_t size) {
+    void* buffer;
+    ErrorCheck("cudaMalloc", cudaMalloc(&buffer, size));
+    return buffer;
+  }
+
+  void DeviceFree(void* buffer) {
+    ErrorCheck("cudaFree", cudaFree(buffer));
+  }
+
+  // Allocates from a memory pool of Horovod's own on the current device, in
+  // order with the work on stream. Freed memory stays in the pool.
+  void* DeviceAllocAsync(size_t size, cudaStream_t stream) {
+    void* buffer;
+#if CUDART_VERSION >= 11020
+    ErrorCheck("cudaMallocFromPoolAsync",
+               cudaMallocFromPoolAsync(&buffer, size, MemPool(), stream));
+#else
+    ErrorCheck("cudaMalloc", cudaMalloc(&buffer, size));
+#endif
+    return buffer;
+  }
+
+  // Frees once the work queued on stream so far is done.
+  void DeviceFreeAsync(void* buffer, cudaStream_t stream) {
+#if CUDART_VERSION >= 11020
+    ErrorCheck("cudaFreeAsync", cudaFreeAsync(buffer, stream));
+#else
+    // Synchronizes the device, so queued readers are done with it.
+    ErrorCheck("cudaFree", cudaFree(buffer));
+#endif
+  }
+
+  cudaEvent_t EventCreate() {
+    cudaEvent_t event;
+    ErrorCheck("cudaEventCreateWithFlags", cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    return event;
+  }
+
+  void EventDestroy(cudaEvent_t event) {
+    ErrorCheck("cudaEventDestroy", cudaEventDestroy(event));
+  }
+
+  void EventRecord(cudaEvent_t event, cudaStream_t stream) {
+    ErrorCheck("cudaEventRecord", cudaEventRecord(event, stream));
+  }
+
+  void StreamWaitEvent(cudaStream_t stream, cudaEvent_t event) {
+    ErrorCheck("cudaStreamWaitEvent", cudaStreamWaitEvent(stream, event, 0));
+  }
+
   void ScaleBufferImpl(const void* fused_input_data, void* buffer_data, int64_t num_elements,
                        double scale_factor, DataType dtype, cudaStream_t stream) {
     ScaleBufferCudaImpl(fused_input_data, buffer_data, num_elements, scale_factor, dtype, stream);
@@ -209,13 +219,41 @@ public:
     //ErrorCheck("ScaleBufferCudaImpl", cudaGetLastError());
   }
 
+  void ScaledAddBufferImpl(const void* input_data, void* buffer_data, int64_t num_elements,
+                           double scale_factor, DataType dtype, cudaStream_t stream) {
+    ScaledAddBufferCudaImpl(input_data, buffer_data, num_elements, scale_factor, dtype, stream);
+  }
+
+  void ScaledCastBufferImpl(const void* input_data, void* buffer_data, int64_t num_elements,
+                            double scale_factor, DataType in_dtype, DataType out_dtype,
+                            cudaStream_t stream) {
+    ScaledCastBufferCudaImpl(input_data, buffer_data, num_elements, scale_factor, in_dtype, out_dtype, stream);
+  }
+
 private:
-  // We reuse CUDA events as it appears that their creation carries non-zero cost.
-  std::unordered_map<std::pair<int, cudaStream_t>, std::queue<Event>> cuda_events;
-  std::unordered_map<std::pair<int, cudaStream_t>, bool> prepopulated;
-  std::mutex cuda_events_mutex;
+#if CUDART_VERSION >= 11020
+  cudaMemPool_t MemPool() {
+    int device = GetDevice();
+    std::lock_guard<std::mutex> guard(mem_pools_mutex_);
+    auto& pool = mem_pools_[device];
+    if (pool == nullptr) {
+      // Not the default pool, which frameworks may release memory of.
+      cudaMemPoolProps props = {};
+      props.allocType = cudaMemAllocationTypePinned;
+      props.location.type = cudaMemLocationTypeDevice;
+      props.location.id = device;
+      ErrorCheck("cudaMemPoolCreate", cudaMemPoolCreate(&pool, &props));
+      uint64_t threshold = std::numeric_limits<uint64_t>::max();
+      ErrorCheck("cudaMemPoolSetAttribute",
+                 cudaMemPoolSetAttribute(
+                     pool, cudaMemPoolAttrReleaseThreshold, &threshold));
+    }
+    return pool;
+  }
 
-  static constexpr int N_CUDA_EVENTS_PREPOPULATE = 128;
+  std::unordered_map<int, cudaMemPool_t> mem_pools_;
+  std::mutex mem_pools_mutex_;
+#endif
 };
 
 #include "gpu_context_impl.cc"
@@ -48,6 +48,9 @@ Status DDLAllreduce::Execute(std::vector<TensorTableEntry>& entries, const Respo
   if (ddl_context_->ddl_local_device_id != first_entry.device) {
     throw std::logic_error("DDL does not support more than one GPU device per process.");
   }
+  if (response.reduce_op() != ReduceOp::SUM) {
+    throw std::logic_error("DDL only supports the Sum and Average reduce ops.");
+  }
 
   const void* fused_input_data;
   void* buffer_data;
@@ -15,71 +15,305 @@
 
 #include "gloo_operations.h"
 
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+
 #include "gloo/allgather.h"
 #include "gloo/allgatherv.h"
 #include "gloo/allreduce.h"
+#include "gloo/allreduce_halving_doubling.h"
 #include "gloo/alltoallv.h"
 #include "gloo/broadcast.h"
+#include "gloo/gatherv.h"
 #include "gloo/math.h"
+#include "gloo/reduce.h"
+#include "gloo/reduce_scatter.h"
 #include "gloo/types.h"
 
 #include "../common.h"
 #include "../global_state.h"
+#include "../half.h"
+#include "cpu_kernels.h"
 
 namespace horovod {
 namespace common {
 
+namespace {
+
+// bfloat16 for the Gloo templates, which has no type of its own for it.
+// Reductions are computed in float32.
+struct GlooBFloat16 {
+  unsigned short bits;
+};
+
+inline float ToFloat(GlooBFloat16 value) {
+  float result;
+  BFloat16Bits2Float(&value.bits, &result);
+  return result;
+}
+
+inline GlooBFloat16 FromFloat(float value) {
+  GlooBFloat16 result;
+  Float2BFloat16Bits(&value, &result.bits);
+  return result;
+}
+
+inline GlooBFloat16 operator+(GlooBFloat16 a, GlooBFloat16 b) {
+  return FromFloat(ToFloat(a) + ToFloat(b));
+}
+
+inline GlooBFloat16 operator*(GlooBFloat16 a, GlooBFloat16 b) {
+  return FromFloat(ToFloat(a) * ToFloat(b));
+}
+
+inline bool operator<(GlooBFloat16 a, GlooBFloat16 b) {
+  return ToFloat(a) < ToFloat(b);
+}
+
+inline bool operator>(GlooBFloat16 a, GlooBFloat16 b) {
+  return ToFloat(a) > ToFloat(b);
+}
+
+} // namespace
+
 IGlooAlgorithms* GetAlgorithmsForType(DataType dtype,
-                                      GlooContext* gloo_context) {
+                                      GlooContext* gloo_context,
+                                      uint32_t tag = 0) {
   switch (dtype) {
   case HOROVOD_UINT8:
-    return new GlooAlgorithms<u_int8_t>(gloo_context);
+    return new GlooAlgorithms<u_int8_t>(gloo_context, tag);
   case HOROVOD_INT8:
-    return new GlooAlgorithms<int8_t>(gloo_context);
+    return new GlooAlgorithms<int8_t>(gloo_context, tag);
   case HOROVOD_UINT16:
-    return new GlooAlgorithms<u_int16_t>(gloo_context);
+    return new GlooAlgorithms<u_int16_t>(gloo_context, tag);
   case HOROVOD_INT16:
-    return new GlooAlgorithms<int16_t>(gloo_context);
+    return new GlooAlgorithms<int16_t>(gloo_context, tag);
   case HOROVOD_INT32:
-    return new GlooAlgorithms<int32_t>(gloo_context);
+    return new GlooAlgorithms<int32_t>(gloo_context, tag);
   case HOROVOD_INT64:
-    return new GlooAlgorithms<int64_t>(gloo_context);
+    return new GlooAlgorithms<int64_t>(gloo_context, tag);
   case HOROVOD_FLOAT16:
-    return new GlooAlgorithms<gloo::float16>(gloo_context);
+    return new GlooAlgorithms<gloo::float16>(gloo_context, tag);
+  case HOROVOD_BFLOAT16:
+    return new GlooAlgorithms<GlooBFloat16>(gloo_context, tag);
   case HOROVOD_FLOAT32:
-    return new GlooAlgorithms<float>(gloo_context);
+    return new GlooAlgorithms<float>(gloo_context, tag);
   case HOROVOD_FLOAT64:
-    return new GlooAlgorithms<double>(gloo_context);
+    return new GlooAlgorithms<double>(gloo_context, tag);
   case HOROVOD_BOOL:
-    return new GlooAlgorithms<bool>(gloo_context);
+    return new GlooAlgorithms<bool>(gloo_context, tag);
   default:
     throw std::logic_error("Type " + DataType_Name(dtype) +
                            " is not supported in Gloo mode.");
   }
 }
 
+namespace {
+
+// Gloo reduce function summing with Horovod's SIMD kernels.
+template <typename T>
+void CPUSum(void* c, const void* a, const void* b, size_t n) {
+  SumCPU(static_cast<const T*>(a), static_cast<const T*>(b), static_cast<T*>(c),
+         (int64_t)n);
+}
+
+// Added in float32, with the vectorized conversions of half.h.
+template <>
+void CPUSum<gloo::float16>(void* c, const void* a, const void* b, size_t n) {
+  Float16Sum(static_cast<const unsigned short*>(a),
+             static_cast<const unsigned short*>(b),
+             static_cast<unsigned short*>(c), (int64_t)n);
+}
+
+template <>
+void CPUSum<GlooBFloat16>(void* c, const void* a, const void* b, size_t n) {
+  BFloat16Sum(static_cast<const unsigned short*>(a),
+              static_cast<const unsigned short*>(b),
+              static_cast<unsigned short*>(c), (int64_t)n);
+}
+
+// No Horovod kernel for bool, fall back to gloo's.
+template <>
+void CPUSum<bool>(void* c, const void* a, const void* b, size_t n) {
+  ::gloo::sum<bool>(c, a, b, n);
+}
+
+template <typename T>
+gloo::AllreduceOptions::Func GetReduceFunction(ReduceOp reduce_op) {
+  void (*func)(void*, const void*, const void*, size_t);
+  switch (reduce_op) {
+  case ReduceOp::SUM:
+    func = &CPUSum<T>;
+    break;
+  case ReduceOp::MIN:
+    func = &::gloo::min<T>;
+    break;
+  case ReduceOp::MAX:
+    func = &::gloo::max<T>;
+    break;
+  case ReduceOp::PRODUCT:
+    func = &::gloo::product<T>;
+    break;
+  default:
+    throw std::logic_error("Reduce op " + ReduceOp_Name(reduce_op) +
+                           " is not supported in Gloo mode.");
+  }
+  return gloo::AllreduceOptions::Func(func);
+}
+
+template <typename T>
+const gloo::ReductionFunction<T>* GetReductionFunction(ReduceOp reduce_op) {
+  switch (reduce_op) {
+  case ReduceOp::SUM:
+    return gloo::ReductionFunction<T>::sum;
+  case ReduceOp::MIN:
+    return gloo::ReductionFunction<T>::min;
+  case ReduceOp::MAX:
+    return gloo::ReductionFunction<T>::max;
+  case ReduceOp::PRODUCT:
+    return gloo::ReductionFunction<T>::product;
+  default:
+    throw std::logic_error("Reduce op " + ReduceOp_Name(reduce_op) +
+                           " is not supported in Gloo mode.");
+  }
+}
+
+// Whether the collective of entries runs on a worker of the process set
+// rather than on the background thread.
+bool RunsOnWorker(const GlooContext& gloo_context,
+                  const std::vector<TensorTableEntry>& entries) {
+  return gloo_context.workers != nullptr &&
+         entries[0].device == CPU_DEVICE_ID;
+}
+
+// Runs collective on the worker of the current host slot, which finishes the
+// entries once it has returned. The fusion buffer of the slot is kept until
+// then.
+Status RunOnWorker(
+    HorovodGlobalState* global_state, std::vector<TensorTableEntry>& entries,
+    std::function<void(std::vector<TensorTableEntry>&)> collective) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state->process_set_table.Get(first_entry.process_set_id);
+  auto fusion_buffer = process_set.fusion_buffer.GetBuffer(
+      first_entry.device, first_entry.context->framework(),
+      global_state->current_nccl_stream);
+  auto* timeline = &global_state->timeline;
+  process_set.gloo_context.workers->Run(
+      process_set.fusion_buffer.HostSlot(),
+      [entries, fusion_buffer, timeline, collective]() mutable {
+        Status status = Status::OK();
+        try {
+          collective(entries);
+        } catch (const std::exception& ex) {
+          status = Status::UnknownError(ex.what());
+        }
+        for (auto& e : entries) {
+          timeline->End(e.tensor_name, status.ok() ? e.output : nullptr);
+          e.FinishWithCallback(status);
+        }
+      });
+  return Status::InProgress();
+}
+
+} // namespace
+
+GlooAllreduceAlgorithm
+SelectGlooAllreduceAlgorithm(int64_t num_bytes, int size,
+                             int64_t bcube_threshold,
+                             int64_t halving_doubling_threshold,
+                             bool background_thread) {
+  bool power_of_two = size > 1 && (size & (size - 1)) == 0;
+  if (power_of_two && num_bytes < bcube_threshold) {
+    return GlooAllreduceAlgorithm::BCUBE;
+  }
+  if (size > 1 && num_bytes < halving_doubling_threshold) {
+    if (background_thread) {
+      return GlooAllreduceAlgorithm::HALVING_DOUBLING;
+    }
+    // Still fewer steps than ring on the workers.
+    if (power_of_two) {
+      return GlooAllreduceAlgorithm::BCUBE;
+    }
+  }
+  return GlooAllreduceAlgorithm::RING;
+}
+
 template <typename T>
-GlooAlgorithms<T>::GlooAlgorithms(GlooContext* gloo_context)
-    : gloo_context_(gloo_context) {}
+GlooAlgorithms<T>::GlooAlgorithms(GlooContext* gloo_context, uint32_t tag)
+    : gloo_context_(gloo_context), tag_(tag) {}
 
 template <typename T>
-void GlooAlgorithms<T>::Allreduce(void* buffer_data, int num_elements) {
+void GlooAlgorithms<T>::Allreduce(void* buffer_data, int num_elements,
+                                  ReduceOp reduce_op,
+                                  GlooAllreduceAlgorithm algorithm) {
+  if (algorithm == GlooAllreduceAlgorithm::HALVING_DOUBLING) {
+    std::vector<T*> ptrs{static_cast<T*>(buffer_data)};
+    gloo::AllreduceHalvingDoubling<T> allreduce(
+        gloo_context_->ctx, ptrs, num_elements,
+        GetReductionFunction<T>(reduce_op));
+    allreduce.run();
+    return;
+  }
+
   gloo::AllreduceOptions opts(gloo_context_->ctx);
+  opts.setTag(tag_);
   opts.setOutput<T>(static_cast<T*>(buffer_data), (size_t) num_elements);
-
-  void (*func)(void*, const void*, const void*, size_t) = &::gloo::sum<T>;
-  opts.setReduceFunction(gloo::AllreduceOptions::Func(func));
+  opts.setReduceFunction(GetReduceFunction<T>(reduce_op));
+  if (algorithm == GlooAllreduceAlgorithm::BCUBE) {
+    opts.setAlgorithm(gloo::AllreduceOptions::Algorithm::BCUBE);
+  }
 
   gloo::allreduce(opts);
 }
 
+template <typename T>
+void GlooAlgorithms<T>::HierarchicalAllreduce(void* buffer_data,
+                                              int num_elements,
+                                              ReduceOp reduce_op) {
+  auto& local_ctx = gloo_context_->local_ctx;
+  auto& cross_ctx = gloo_context_->cross_ctx;
+  int local_size = local_ctx->size;
+  int local_rank = local_ctx->rank;
+  auto data = static_cast<T*>(buffer_data);
+
+  // Every local rank owns one block, the same on all hosts of a homogeneous
+  // process set.
+  std::vector<int> counts(local_size, num_elements / local_size);
+  for (int i = 0; i < num_elements % local_size; ++i) {
+    ++counts[i];
+  }
+  int offset = std::accumulate(counts.begin(), counts.begin() + local_rank, 0);
+
+  // The reduced block of every local rank is left in place at its offset.
+  gloo::ReduceScatterHalvingDoubling<T> reducescatter(
+      local_ctx, {data}, num_elements, counts,
+      GetReductionFunction<T>(reduce_op));
+  reducescatter.run();
+
+  gloo::AllreduceOptions cross_opts(cross_ctx);
+  cross_opts.setOutput<T>(data + offset, (size_t)counts[local_rank]);
+  cross_opts.setReduceFunction(GetReduceFunction<T>(reduce_op));
+  gloo::allreduce(cross_opts);
+
+  gloo::AllgathervOptions local_opts(local_ctx);
+  local_opts.setInput<T>(data + offset, (size_t)counts[local_rank]);
+  local_opts.setOutput<T>(data,
+                          std::vector<size_t>(counts.begin(), counts.end()));
+  gloo::allgatherv(local_opts);
+}
+
 template <typename T>
 void GlooAlgorithms<T>::Allgather(void* buffer_data, void* buffer_out,
-                                  int* recvcounts, int* displcmnts) {
+                                  int64_t* recvcounts, int64_t* displcmnts) {
   // create count index
   std::vector<size_t> counts(recvcounts, recvcounts + gloo_context_->ctx->size);
 
   gloo::AllgathervOptions opts(gloo_context_->ctx);
+  opts.setTag(tag_);
   opts.setInput<T>(static_cast<T*>(buffer_data) +
                        displcmnts[gloo_context_->ctx->rank],
                    counts[gloo_context_->ctx->rank]);
@@ -92,6 +326,7 @@ template <typename T>
 void GlooAlgorithms<T>::Broadcast(void* buffer_data, int num_elements,
                                   int root_rank) {
   gloo::BroadcastOptions opts(gloo_context_->ctx);
+  opts.setTag(tag_);
   opts.setRoot(root_rank);
   opts.setOutput<T>(static_cast<T*>(buffer_data), (size_t) num_elements);
   gloo::broadcast(opts);
@@ -108,6 +343,56 @@ void GlooAlgorithms<T>::Alltoall(void* buffer_data, void* buffer_out,
   gloo::alltoallv(opts);
 }
 
+template <typename T>
+void GlooAlgorithms<T>::Reducescatter(void* buffer_data,
+                                      std::vector<int64_t>& recvcounts) {
+  // The reduced part of every rank is left in place at its displacement.
+  int64_t num_elements =
+      std::accumulate(recvcounts.begin(), recvcounts.end(), (int64_t)0);
+  // Gloo's reduce-scatter counts elements with an int.
+  if (num_elements > std::numeric_limits<int>::max()) {
+    throw std::logic_error("Gloo reducescatter does not support more than " +
+                           std::to_string(std::numeric_limits<int>::max()) +
+                           " elements, got " + std::to_string(num_elements) +
+                           ".");
+  }
+  std::vector<int> recv_elements(recvcounts.begin(), recvcounts.end());
+  gloo::ReduceScatterHalvingDoubling<T> reducescatter(
+      gloo_context_->ctx, {static_cast<T*>(buffer_data)}, (int)num_elements,
+      recv_elements);
+  reducescatter.run();
+}
+
+template <typename T>
+void GlooAlgorithms<T>::Reduce(void* buffer_data, int num_elements,
+                               ReduceOp reduce_op, int root_rank) {
+  gloo::ReduceOptions opts(gloo_context_->ctx);
+  opts.setTag(tag_);
+  opts.setRoot(root_rank);
+  opts.setOutput<T>(static_cast<T*>(buffer_data), (size_t)num_elements);
+  opts.setReduceFunction(GetReduceFunction<T>(reduce_op));
+
+  gloo::reduce(opts);
+}
+
+template <typename T>
+void GlooAlgorithms<T>::Gather(const void* buffer_data, void* buffer_out,
+                               std::vector<int64_t>& recvcounts,
+                               int root_rank) {
+  int rank = gloo_context_->ctx->rank;
+  gloo::GathervOptions opts(gloo_context_->ctx);
+  opts.setTag(tag_);
+  opts.setRoot(root_rank);
+  opts.setInput<T>(const_cast<T*>(static_cast<const T*>(buffer_data)),
+                   (size_t)recvcounts[rank]);
+  if (rank == root_rank) {
+    opts.setOutput<T>(static_cast<T*>(buffer_out),
+                      std::vector<size_t>(recvcounts.begin(), recvcounts.end()));
+  }
+
+  gloo::gatherv(opts);
+}
+
 template <typename T> int GlooAlgorithms<T>::ElementSize() const {
   return sizeof(T);
 }
@@ -128,43 +413,100 @@ Status GlooAllreduce::Execute(std::vector<TensorTableEntry>& entries,
   void* buffer_data;
   int num_elements = (int)NumElements(entries);
 
+  // Tensors that already sit next to each other are reduced where they are.
+  bool fused = entries.size() > 1;
+  void* span_data = nullptr;
+  size_t span_len = 0;
+  bool zero_copy = fused && GetZeroCopySpan(entries, span_data, span_len);
+  double prescale_factor = response.prescale_factor();
+  double postscale_factor = response.postscale_factor();
+  if ((!fused || zero_copy) && FoldPrescale(entries, response)) {
+    postscale_factor *= prescale_factor;
+    prescale_factor = 1.0;
+  }
+
   // Copy memory into the fusion buffer.
   auto& timeline = global_state_->timeline;
-  if (entries.size() > 1) {
+  if (zero_copy) {
+    fused_input_data = span_data;
+    buffer_data = span_data;
+    num_elements =
+        (int)(span_len / DataType_Size(first_entry.tensor->dtype()));
+  } else if (fused) {
     timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
     size_t buffer_len;
     MemcpyInFusionBuffer(entries, fused_input_data, buffer_data, buffer_len);
     timeline.ActivityEndAll(entries);
   } else {
     buffer_data = (void*)first_entry.output->data();
-    std::memcpy(buffer_data, first_entry.tensor->data(),
-                (size_t)first_entry.tensor->size());
-    fused_input_data = buffer_data;
+    fused_input_data = first_entry.tensor->data();
+    if (prescale_factor == 1.0 && fused_input_data != buffer_data) {
+      std::memcpy(buffer_data, fused_input_data,
+                  (size_t)first_entry.tensor->size());
+      fused_input_data = buffer_data;
+    }
   }
 
-  if (response.prescale_factor() != 1.0) {
-    // Execute prescaling op
-    ScaleBuffer(response.prescale_factor(), entries, fused_input_data, buffer_data, num_elements);
+  if (prescale_factor != 1.0) {
+    // Execute prescaling op, for unfused tensors this also copies the input
+    // into the output.
+    ScaleBuffer(prescale_factor, entries, fused_input_data, buffer_data, num_elements);
   }
 
   // Do allreduce.
   timeline.ActivityStartAll(entries, GLOO_ALLREDUCE);
-  std::unique_ptr<IGlooAlgorithms> gloo_algos(
-      GetAlgorithmsForType(first_entry.tensor->dtype(), &gloo_context));
-  gloo_algos->Allreduce(buffer_data, num_elements);
-  timeline.ActivityEndAll(entries);
+  bool on_worker = RunsOnWorkers() && RunsOnWorker(gloo_context, entries);
+  uint32_t tag =
+      on_worker ? GlooWorkers::Tag(process_set.fusion_buffer.HostSlot()) : 0;
+  bool accumulate = AccumulatesInFloat32(entries, response);
+  auto reduce_op = response.reduce_op();
+  auto& param_manager = global_state_->parameter_manager;
+  int64_t num_bytes =
+      (int64_t)num_elements *
+      (accumulate ? sizeof(float) : DataType_Size(first_entry.tensor->dtype()));
+  auto algorithm = SelectGlooAllreduceAlgorithm(
+      num_bytes, gloo_context.ctx->size, param_manager.GlooBcubeThreshold(),
+      param_manager.GlooHalvingDoublingThreshold(), !on_worker);
+  auto* context = &gloo_context;
+  auto allreduce = [this, context, tag, buffer_data, num_elements, accumulate,
+                    reduce_op, algorithm, postscale_factor, fused,
+                    zero_copy](std::vector<TensorTableEntry>& entries) {
+    auto& timeline = global_state_->timeline;
+    auto dtype = entries[0].tensor->dtype();
+    if (accumulate) {
+      thread_local std::vector<float> widened;
+      widened.resize(num_elements);
+      WidenToFloat32(buffer_data, widened.data(), num_elements, dtype);
+      std::unique_ptr<IGlooAlgorithms> gloo_algos(
+          GetAlgorithmsForType(HOROVOD_FLOAT32, context, tag));
+      DoAllreduce(*gloo_algos, widened.data(), num_elements, reduce_op,
+                  algorithm);
+      NarrowFromFloat32(widened.data(), buffer_data, num_elements, dtype);
+    } else {
+      std::unique_ptr<IGlooAlgorithms> gloo_algos(
+          GetAlgorithmsForType(dtype, context, tag));
+      DoAllreduce(*gloo_algos, buffer_data, num_elements, reduce_op,
+                  algorithm);
+    }
+    timeline.ActivityEndAll(entries);
 
-  if (response.postscale_factor() != 1.0) {
-    // Execute postscaling op
-    ScaleBuffer(response.postscale_factor(), entries, buffer_data, buffer_data, num_elements);
-  }
+    if (postscale_factor != 1.0) {
+      // Execute postscaling op
+      ScaleBuffer(postscale_factor, entries, buffer_data, buffer_data,
+                  num_elements);
+    }
 
-  // Copy memory out of the fusion buffer.
-  if (entries.size() > 1) {
-    timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
-    MemcpyOutFusionBuffer(buffer_data, entries);
-    timeline.ActivityEndAll(entries);
+    // Copy memory out of the fusion buffer.
+    if (fused && !zero_copy) {
+      timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+      MemcpyOutFusionBuffer(buffer_data, entries);
+      timeline.ActivityEndAll(entries);
+    }
+  };
+  if (on_worker) {
+    return RunOnWorker(global_state_, entries, allreduce);
   }
+  allreduce(entries);
 
   return Status::OK();
 }
@@ -175,6 +517,49 @@ bool GlooAllreduce::Enabled(const ParameterManager& param_manager,
   return true;
 }
 
+void GlooAllreduce::DoAllreduce(IGlooAlgorithms& gloo_algos, void* buffer_data,
+                                int num_elements, ReduceOp reduce_op,
+                                GlooAllreduceAlgorithm algorithm) {
+  gloo_algos.Allreduce(buffer_data, num_elements, reduce_op, algorithm);
+}
+
+GlooHierarchicalAllreduce::GlooHierarchicalAllreduce(
+    HorovodGlobalState* global_state)
+    : GlooAllreduce(global_state) {}
+
+bool GlooHierarchicalAllreduce::Enabled(
+    const ParameterManager& param_manager,
+    const std::vector<TensorTableEntry>& entries,
+    const Response& response) const {
+  if (!param_manager.HierarchicalAllreduce()) {
+    return false;
+  }
+  auto& process_set =
+      global_state_->process_set_table.Get(entries[0].process_set_id);
+  auto& gloo_context = process_set.gloo_context;
+  // Blocks only line up across hosts if every host has the same number of
+  // ranks.
+  if (gloo_context.local_ctx == nullptr || gloo_context.cross_ctx == nullptr ||
+      gloo_context.local_ctx->size < 2 || gloo_context.cross_ctx->size < 2 ||
+      !process_set.controller->IsHomogeneous()) {
+    return false;
+  }
+  // Tiny tensors would leave some local ranks without a block.
+  int64_t num_elements = 0;
+  for (auto& e : entries) {
+    num_elements += e.tensor->shape().num_elements();
+  }
+  return num_elements >= gloo_context.local_ctx->size;
+}
+
+void GlooHierarchicalAllreduce::DoAllreduce(IGlooAlgorithms& gloo_algos,
+                                            void* buffer_data,
+                                            int num_elements,
+                                            ReduceOp reduce_op,
+                                            GlooAllreduceAlgorithm algorithm) {
+  gloo_algos.HierarchicalAllreduce(buffer_data, num_elements, reduce_op);
+}
+
 GlooAllgather::GlooAllgather(HorovodGlobalState* global_state)
     : AllgatherOp(global_state) {}
 
@@ -195,46 +580,28 @@ Status GlooAllgather::Execute(std::vector<TensorTableEntry>& entries,
   auto& gloo_context = process_set.gloo_context;
   auto& timeline = global_state_->timeline;
 
-  // Sizes of subcomponents of each entry from all ranks
-  auto** entry_component_sizes = new int64_t*[entries.size()];
-
-  // Offset of each subcomponent of every entry in the final buffer after
-  // allgatherv
-  auto** entry_component_offsets = new int64_t*[entries.size()];
-
   int global_size = process_set.controller->GetSize();
-  auto* recvcounts = new int[global_size]();
-  auto* displcmnts = new int[global_size]();
-
-  for (size_t ec = 0; ec < entries.size(); ++ec) {
-    entry_component_sizes[ec] = new int64_t[global_size]();
-    entry_component_offsets[ec] = new int64_t[global_size]();
-  }
-
+  auto layout = std::make_shared<AllgatherLayout>(entries.size(), global_size);
 
   timeline.ActivityStartAll(entries, ALLOCATE_OUTPUT);
-  Status status =
-      AllocateOutput(entries, response, entry_component_sizes, recvcounts);
+  Status status = AllocateOutput(entries, response,
+                                 layout->entry_component_sizes,
+                                 layout->recvcounts);
   if (!status.ok()) {
-    /* Cleanup */
-    for (size_t ec = 0; ec < entries.size(); ++ec) {
-      delete[] entry_component_sizes[ec];
-      delete[] entry_component_offsets[ec];
-    }   
-    delete[] entry_component_sizes;
-    delete[] entry_component_offsets;
-    delete[] recvcounts;
-    delete[] displcmnts;
     return status;
   }
   timeline.ActivityEndAll(entries);
 
-  SetDisplacements(recvcounts, displcmnts, global_size);
-  SetEntryComponentOffsets(entries, entry_component_sizes, recvcounts,
-                           entry_component_offsets);
+  SetDisplacements(layout->recvcounts, layout->displcmnts, global_size);
+  SetEntryComponentOffsets(entries, layout->entry_component_sizes,
+                           layout->recvcounts,
+                           layout->entry_component_offsets);
 
-  std::unique_ptr<IGlooAlgorithms> gloo_algos(
-      GetAlgorithmsForType(first_entry.tensor->dtype(), &gloo_context));
+  bool on_worker = RunsOnWorker(gloo_context, entries);
+  uint32_t tag =
+      on_worker ? GlooWorkers::Tag(process_set.fusion_buffer.HostSlot()) : 0;
+  std::shared_ptr<IGlooAlgorithms> gloo_algos(
+      GetAlgorithmsForType(first_entry.tensor->dtype(), &gloo_context, tag));
   int element_size = gloo_algos->ElementSize();
 
   void* sendbuf = nullptr;
@@ -242,14 +609,16 @@ Status GlooAllgather::Execute(std::vector<TensorTableEntry>& entries,
 
   if (entries.size() > 1) {
     timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
-    MemcpyInFusionBuffer(entries, displcmnts, element_size, buffer_data);
+    MemcpyInFusionBuffer(entries, layout->displcmnts, element_size,
+                         buffer_data);
     sendbuf = buffer_data;
     timeline.ActivityEndAll(entries);
   } else {
     // need to move input data to its corresponding location in the output
     sendbuf = (void*)first_entry.tensor->data();
     buffer_data = (void*)first_entry.output->data();
-    int buffer_offset = displcmnts[gloo_context.ctx->rank] * element_size;
+    int64_t buffer_offset =
+        layout->displcmnts[gloo_context.ctx->rank] * element_size;
     std::memcpy((uint8_t*)buffer_data + buffer_offset, sendbuf,
                 (size_t)first_entry.tensor->size());
     sendbuf = buffer_data;
@@ -257,26 +626,26 @@ Status GlooAllgather::Execute(std::vector<TensorTableEntry>& entries,
 
   // call gloo allgather api
   timeline.ActivityStartAll(entries, GLOO_ALLGATHER);
-  gloo_algos->Allgather(sendbuf, buffer_data, recvcounts, displcmnts);
-  timeline.ActivityEndAll(entries);
-
-  // if multiple tensors are gathered, restore the sequence from output
-  if (entries.size() > 1) {
-    timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
-    MemcpyOutFusionBuffer(entry_component_offsets, entry_component_sizes,
-                          buffer_data, element_size, entries);
+  auto allgather = [this, gloo_algos, layout, sendbuf, buffer_data,
+                    element_size](std::vector<TensorTableEntry>& entries) {
+    auto& timeline = global_state_->timeline;
+    gloo_algos->Allgather(sendbuf, buffer_data, layout->recvcounts,
+                          layout->displcmnts);
     timeline.ActivityEndAll(entries);
-  }
 
-  delete[] recvcounts;
-  delete[] displcmnts;
-
-  for (size_t ec = 0; ec < entries.size(); ++ec) {
-    delete[] entry_component_sizes[ec];
-    delete[] entry_component_offsets[ec];
+    // if multiple tensors are gathered, restore the sequence from output
+    if (entries.size() > 1) {
+      timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+      MemcpyOutFusionBuffer(layout->entry_component_offsets,
+                            layout->entry_component_sizes, buffer_data,
+                            element_size, entries);
+      timeline.ActivityEndAll(entries);
+    }
+  };
+  if (on_worker) {
+    return RunOnWorker(global_state_, entries, allgather);
   }
-  delete[] entry_component_sizes;
-  delete[] entry_component_offsets;
+  allgather(entries);
 
   return Status::OK();
 }
@@ -288,7 +657,10 @@ Status GlooBroadcast::Execute(std::vector<TensorTableEntry>& entries,
                               const Response& response) {
   WaitForData(entries);
 
-  assert(entries.size() == 1);
+  if (entries.size() > 1) {
+    return ExecuteFused(entries);
+  }
+
   auto e = entries[0];
   auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
   auto& gloo_context = process_set.gloo_context;
@@ -302,12 +674,74 @@ Status GlooBroadcast::Execute(std::vector<TensorTableEntry>& entries,
     data_ptr = (void*)e.output->data();
   }
 
+  bool on_worker = RunsOnWorker(gloo_context, entries);
+  uint32_t tag =
+      on_worker ? GlooWorkers::Tag(process_set.fusion_buffer.HostSlot()) : 0;
+  std::shared_ptr<IGlooAlgorithms> gloo_algos(
+      GetAlgorithmsForType(e.tensor->dtype(), &gloo_context, tag));
+  int num_elements = (int)e.tensor->shape().num_elements();
+  int root_rank = e.root_rank;
+
   global_state_->timeline.ActivityStartAll(entries, GLOO_BCAST);
-  std::unique_ptr<IGlooAlgorithms> gloo_algos(
-      GetAlgorithmsForType(e.tensor->dtype(), &gloo_context));
-  gloo_algos->Broadcast(data_ptr, (int)e.tensor->shape().num_elements(),
-                        e.root_rank);
-  global_state_->timeline.ActivityEndAll(entries);
+  auto broadcast = [this, gloo_algos, data_ptr, num_elements,
+                    root_rank](std::vector<TensorTableEntry>& entries) {
+    gloo_algos->Broadcast(data_ptr, num_elements, root_rank);
+    global_state_->timeline.ActivityEndAll(entries);
+  };
+  if (on_worker) {
+    return RunOnWorker(global_state_, entries, broadcast);
+  }
+  broadcast(entries);
+
+  return Status::OK();
+}
+
+Status GlooBroadcast::ExecuteFused(std::vector<TensorTableEntry>& entries) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto& gloo_context = process_set.gloo_context;
+  bool is_root = process_set.controller->GetRank() == first_entry.root_rank;
+
+  auto buffer = process_set.fusion_buffer.GetBuffer(
+      first_entry.device, first_entry.context->framework(),
+      global_state_->current_nccl_stream);
+  void* buffer_data = const_cast<void*>(buffer->AccessData(first_entry.context));
+  int64_t buffer_len = 0;
+  for (auto& e : entries) {
+    buffer_len += e.tensor->size();
+  }
+
+  if (is_root) {
+    global_state_->timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+    MemcpyInFusionBuffer(entries, buffer_data);
+    global_state_->timeline.ActivityEndAll(entries);
+  }
+
+  bool on_worker = RunsOnWorker(gloo_context, entries);
+  uint32_t tag =
+      on_worker ? GlooWorkers::Tag(process_set.fusion_buffer.HostSlot()) : 0;
+  std::shared_ptr<IGlooAlgorithms> gloo_algos(
+      GetAlgorithmsForType(HOROVOD_UINT8, &gloo_context, tag));
+  int root_rank = first_entry.root_rank;
+
+  global_state_->timeline.ActivityStartAll(entries, GLOO_BCAST);
+  auto broadcast = [this, gloo_algos, buffer_data, buffer_len, root_rank,
+                    is_root](std::vector<TensorTableEntry>& entries) {
+    auto& timeline = global_state_->timeline;
+    gloo_algos->Broadcast(buffer_data, (int)buffer_len, root_rank);
+    timeline.ActivityEndAll(entries);
+
+    if (!is_root) {
+      timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+      MemcpyOutFusionBuffer(buffer_data, entries);
+      timeline.ActivityEndAll(entries);
+    }
+  };
+  if (on_worker) {
+    return RunOnWorker(global_state_, entries, broadcast);
+  }
+  broadcast(entries);
 
   return Status::OK();
 }
@@ -324,7 +758,10 @@ GlooAlltoall::GlooAlltoall(HorovodGlobalState* global_state)
 Status GlooAlltoall::Execute(std::vector<TensorTableEntry>& entries, const Response& response) {
   WaitForData(entries);
 
-  assert(entries.size() == 1);
+  if (entries.size() > 1) {
+    return ExecuteFused(entries);
+  }
+
   auto e = entries[0];
   auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
   auto& gloo_context = process_set.gloo_context;
@@ -347,11 +784,255 @@ Status GlooAlltoall::Execute(std::vector<TensorTableEntry>& entries, const Respo
   return Status::OK();
 }
 
+Status GlooAlltoall::ExecuteFused(std::vector<TensorTableEntry>& entries) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto& gloo_context = process_set.gloo_context;
+
+  std::vector<int64_t> entry_sendcounts, entry_recvcounts;
+  std::vector<int64_t> sdispls, rdispls;
+  std::vector<int64_t> sendcounts, recvcounts;
+  Status status = PrepareFusedOutputAndParams(entries, entry_sendcounts,
+                                              entry_recvcounts, sdispls,
+                                              rdispls, sendcounts, recvcounts);
+  if (!status.ok()) {
+    return status;
+  }
+
+  auto buffer = process_set.fusion_buffer.GetBuffer(
+      first_entry.device, first_entry.context->framework(),
+      global_state_->current_nccl_stream);
+  void* send_data = const_cast<void*>(buffer->AccessData(first_entry.context));
+  void* recv_data = nullptr;
+  status = GetFusedRecvBuffer(first_entry, rdispls.back() + recvcounts.back(),
+                              recv_data);
+  if (!status.ok()) {
+    return status;
+  }
+
+  global_state_->timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+  MemcpyInFusionBuffer(entries, entry_sendcounts, send_data);
+  global_state_->timeline.ActivityEndAll(entries);
+
+  // The fused blocks can mix data types, so they are exchanged as bytes.
+  global_state_->timeline.ActivityStartAll(entries, MPI_ALLTOALL);
+  std::unique_ptr<IGlooAlgorithms> gloo_algos(
+      GetAlgorithmsForType(HOROVOD_UINT8, &gloo_context));
+  gloo_algos->Alltoall(send_data, recv_data, sendcounts, recvcounts);
+  global_state_->timeline.ActivityEndAll(entries);
+
+  global_state_->timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+  MemcpyOutFusionBuffer(recv_data, entry_recvcounts, entries);
+  global_state_->timeline.ActivityEndAll(entries);
+
+  return Status::OK();
+}
+
 bool GlooAlltoall::Enabled(const ParameterManager& param_manager,
                            const std::vector<TensorTableEntry>& entries,
                            const Response& response) const {
   return true;
 }
 
+GlooReducescatter::GlooReducescatter(HorovodGlobalState* global_state)
+    : ReducescatterOp(global_state) {}
+
+Status GlooReducescatter::Execute(std::vector<TensorTableEntry>& entries,
+                                  const Response& response) {
+  assert(!entries.empty());
+  WaitForData(entries);
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto& gloo_context = process_set.gloo_context;
+  auto& timeline = global_state_->timeline;
+
+  int global_size = process_set.controller->GetSize();
+  int global_rank = process_set.controller->GetRank();
+  auto output_shapes = ComputeOutputShapes(entries, global_size);
+  std::vector<int64_t> recvcounts = ComputeReceiveCounts(output_shapes);
+
+  timeline.ActivityStartAll(entries, ALLOCATE_OUTPUT);
+  Status status = AllocateOutput(entries, output_shapes);
+  if (!status.ok()) {
+    return status;
+  }
+  timeline.ActivityEndAll(entries);
+
+  size_t element_size = DataType_Size(first_entry.tensor->dtype());
+  int64_t num_elements = NumElements(entries);
+  void* buffer_data;
+  std::unique_ptr<uint8_t[]> unfused_buffer;
+
+  // Copy memory into the fusion buffer. Gloo reduces in place, so a single
+  // entry needs a scratch copy of its input.
+  if (entries.size() > 1) {
+    timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+    MemcpyInFusionBuffer(entries, output_shapes, element_size, buffer_data);
+    timeline.ActivityEndAll(entries);
+  } else {
+    unfused_buffer.reset(new uint8_t[first_entry.tensor->size()]);
+    buffer_data = unfused_buffer.get();
+    std::memcpy(buffer_data, first_entry.tensor->data(),
+                (size_t)first_entry.tensor->size());
+  }
+
+  if (response.prescale_factor() != 1.0) {
+    // Execute prescaling op
+    ScaleBuffer(response.prescale_factor(), entries, buffer_data, buffer_data,
+                num_elements);
+  }
+
+  // Do reducescatter.
+  timeline.ActivityStartAll(entries, GLOO_REDUCESCATTER);
+  std::unique_ptr<IGlooAlgorithms> gloo_algos(
+      GetAlgorithmsForType(first_entry.tensor->dtype(), &gloo_context));
+  gloo_algos->Reducescatter(buffer_data, recvcounts);
+  timeline.ActivityEndAll(entries);
+
+  int64_t displacement = 0;
+  for (int rc = 0; rc < global_rank; ++rc) {
+    displacement += recvcounts[rc];
+  }
+  void* output_data = (uint8_t*)buffer_data + displacement * element_size;
+
+  if (response.postscale_factor() != 1.0) {
+    // Execute postscaling op
+    ScaleBuffer(response.postscale_factor(), entries, output_data, output_data,
+                recvcounts[global_rank]);
+  }
+
+  // Copy memory out of the fusion buffer.
+  timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+  MemcpyOutFusionBuffer(output_data, entries);
+  timeline.ActivityEndAll(entries);
+
+  return Status::OK();
+}
+
+bool GlooReducescatter::Enabled(const ParameterManager& param_manager,
+                                const std::vector<TensorTableEntry>& entries,
+                                const Response& response) const {
+  return true;
+}
+
+GlooReduce::GlooReduce(HorovodGlobalState* global_state)
+    : AllreduceOp(global_state) {}
+
+Status GlooReduce::Execute(std::vector<TensorTableEntry>& entries,
+                           const Response& response) {
+  assert(!entries.empty());
+  WaitForData(entries);
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto& gloo_context = process_set.gloo_context;
+  auto& timeline = global_state_->timeline;
+  bool is_root = process_set.controller->GetRank() == first_entry.root_rank;
+
+  int num_elements = (int)NumElements(entries);
+  void* buffer_data;
+  std::unique_ptr<uint8_t[]> unfused_buffer;
+
+  // Copy memory into the fusion buffer. Gloo reduces in place, so a single
+  // entry is reduced in the output of the root and in a scratch copy of its
+  // input elsewhere.
+  bool fused = entries.size() > 1;
+  if (fused) {
+    const void* fused_input_data;
+    size_t buffer_len;
+    timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+    MemcpyInFusionBuffer(entries, fused_input_data, buffer_data, buffer_len);
+    timeline.ActivityEndAll(entries);
+  } else {
+    if (is_root) {
+      buffer_data = (void*)first_entry.output->data();
+    } else {
+      unfused_buffer.reset(new uint8_t[first_entry.tensor->size()]);
+      buffer_data = unfused_buffer.get();
+    }
+    if (buffer_data != first_entry.tensor->data()) {
+      std::memcpy(buffer_data, first_entry.tensor->data(),
+                  (size_t)first_entry.tensor->size());
+    }
+  }
+
+  if (response.prescale_factor() != 1.0) {
+    // Execute prescaling op
+    ScaleBuffer(response.prescale_factor(), entries, buffer_data, buffer_data,
+                num_elements);
+  }
+
+  // Do reduce.
+  timeline.ActivityStartAll(entries, GLOO_REDUCE);
+  std::unique_ptr<IGlooAlgorithms> gloo_algos(
+      GetAlgorithmsForType(first_entry.tensor->dtype(), &gloo_context));
+  gloo_algos->Reduce(buffer_data, num_elements, response.reduce_op(),
+                     first_entry.root_rank);
+  timeline.ActivityEndAll(entries);
+
+  if (!is_root) {
+    return Status::OK();
+  }
+  if (response.postscale_factor() != 1.0) {
+    // Execute postscaling op
+    ScaleBuffer(response.postscale_factor(), entries, buffer_data, buffer_data,
+                num_elements);
+  }
+
+  // Copy memory out of the fusion buffer.
+  if (fused) {
+    timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+    MemcpyOutFusionBuffer(buffer_data, entries);
+    timeline.ActivityEndAll(entries);
+  }
+
+  return Status::OK();
+}
+
+bool GlooReduce::Enabled(const ParameterManager& param_manager,
+                         const std::vector<TensorTableEntry>& entries,
+                         const Response& response) const {
+  return true;
+}
+
+GlooGather::GlooGather(HorovodGlobalState* global_state)
+    : GatherOp(global_state) {}
+
+Status GlooGather::Execute(std::vector<TensorTableEntry>& entries,
+                           const Response& response) {
+  assert(entries.size() == 1);
+  WaitForData(entries);
+  auto& e = entries[0];
+  auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
+  auto& gloo_context = process_set.gloo_context;
+  auto& timeline = global_state_->timeline;
+
+  std::vector<int64_t> recvcounts;
+  std::vector<int64_t> displcmnts;
+  timeline.ActivityStartAll(entries, ALLOCATE_OUTPUT);
+  Status status = PrepareOutputAndParams(e, response, recvcounts, displcmnts);
+  if (!status.ok()) {
+    return status;
+  }
+  timeline.ActivityEndAll(entries);
+
+  timeline.ActivityStartAll(entries, GLOO_GATHER);
+  std::unique_ptr<IGlooAlgorithms> gloo_algos(
+      GetAlgorithmsForType(e.tensor->dtype(), &gloo_context));
+  gloo_algos->Gather(e.tensor->data(), (void*)e.output->data(), recvcounts,
+                     e.root_rank);
+  timeline.ActivityEndAll(entries);
+
+  return Status::OK();
+}
+
+bool GlooGather::Enabled(const ParameterManager& param_manager,
+                         const std::vector<TensorTableEntry>& entries,
+                         const Response& response) const {
+  return true;
+}
+
 } // namespace common
 } // namespace horovod
@@ -25,12 +25,34 @@
 namespace horovod {
 namespace common {
 
+// Allreduce algorithms of Gloo. Ring moves the least data per rank but takes
+// 2 * (size - 1) steps, bcube and halving-doubling take 2 * log2(size) steps,
+// which is faster for small messages.
+enum class GlooAllreduceAlgorithm { RING, BCUBE, HALVING_DOUBLING };
+
+// Picks bcube below bcube_threshold bytes, halving-doubling below
+// halving_doubling_threshold bytes and ring above. Bcube needs a power of two
+// size, halving-doubling takes its slots from the context in call order and
+// so is only picked on the background thread.
+GlooAllreduceAlgorithm
+SelectGlooAllreduceAlgorithm(int64_t num_bytes, int size,
+                             int64_t bcube_threshold,
+                             int64_t halving_doubling_threshold,
+                             bool background_thread);
+
 class IGlooAlgorithms {
 public:
-  virtual void Allreduce(void* buffer_data, int num_elements) = 0;
+  virtual void Allreduce(void* buffer_data, int num_elements,
+                         ReduceOp reduce_op,
+                         GlooAllreduceAlgorithm algorithm) = 0;
+
+  // Reduce-scatter within the host, allreduce of each block across hosts by
+  // the ranks with the same local rank, then allgather within the host.
+  virtual void HierarchicalAllreduce(void* buffer_data, int num_elements,
+                                     ReduceOp reduce_op) = 0;
 
-  virtual void Allgather(void* buffer_data, void* buffer_out, int* recvcounts,
-                         int* displcmnts) = 0;
+  virtual void Allgather(void* buffer_data, void* buffer_out,
+                         int64_t* recvcounts, int64_t* displcmnts) = 0;
 
   virtual void Broadcast(void* buffer_data, int num_elements,
                          int root_rank) = 0;
@@ -39,19 +61,35 @@ public:
                         std::vector<int64_t>& sendcounts,
                         std::vector<int64_t>& recvcounts) = 0;
 
+  virtual void Reducescatter(void* buffer_data,
+                             std::vector<int64_t>& recvcounts) = 0;
+
+  // Reduces buffer_data in place, the result is only left on root_rank.
+  virtual void Reduce(void* buffer_data, int num_elements, ReduceOp reduce_op,
+                      int root_rank) = 0;
+
+  virtual void Gather(const void* buffer_data, void* buffer_out,
+                      std::vector<int64_t>& recvcounts, int root_rank) = 0;
+
   virtual int ElementSize() const = 0;
 };
 
 template <typename T> class GlooAlgorithms : public IGlooAlgorithms {
 public:
-  explicit GlooAlgorithms(GlooContext* gloo_context);
+  // Allreduce, Allgather and Broadcast use tag, so that collectives on
+  // different tags can run concurrently.
+  explicit GlooAlgorithms(GlooContext* gloo_context, uint32_t tag = 0);
 
   ~GlooAlgorithms() = default;
 
-  void Allreduce(void* buffer_data, int num_elements) override;
+  void Allreduce(void* buffer_data, int num_elements, ReduceOp reduce_op,
+                 GlooAllreduceAlgorithm algorithm) override;
+
+  void HierarchicalAllreduce(void* buffer_data, int num_elements,
+                             ReduceOp reduce_op) override;
 
-  void Allgather(void* buffer_data, void* buffer_out, int* recvcounts,
-                 int* displcmnts) override;
+  void Allgather(void* buffer_data, void* buffer_out, int64_t* recvcounts,
+                 int64_t* displcmnts) override;
 
   void Broadcast(void* buffer_data, int num_elements, int root_rank) override;
 
@@ -59,10 +97,20 @@ public:
                 std::vector<int64_t>& sendcounts,
                 std::vector<int64_t>& recvcounts) override;
 
+  void Reducescatter(void* buffer_data,
+                     std::vector<int64_t>& recvcounts) override;
+
+  void Reduce(void* buffer_data, int num_elements, ReduceOp reduce_op,
+              int root_rank) override;
+
+  void Gather(const void* buffer_data, void* buffer_out,
+              std::vector<int64_t>& recvcounts, int root_rank) override;
+
   int ElementSize() const override;
 
 private:
   GlooContext* gloo_context_;
+  uint32_t tag_;
 };
 
 class GlooAllreduce : public AllreduceOp {
@@ -77,6 +125,32 @@ public:
   bool Enabled(const ParameterManager& param_manager,
                const std::vector<TensorTableEntry>& entries,
                const Response& response) const override;
+
+protected:
+  virtual void DoAllreduce(IGlooAlgorithms& gloo_algos, void* buffer_data,
+                           int num_elements, ReduceOp reduce_op,
+                           GlooAllreduceAlgorithm algorithm);
+
+  // Whether DoAllreduce may run on the workers of the process set.
+  virtual bool RunsOnWorkers() const { return true; }
+};
+
+class GlooHierarchicalAllreduce : public GlooAllreduce {
+public:
+  explicit GlooHierarchicalAllreduce(HorovodGlobalState* global_state);
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+
+protected:
+  void DoAllreduce(IGlooAlgorithms& gloo_algos, void* buffer_data,
+                   int num_elements, ReduceOp reduce_op,
+                   GlooAllreduceAlgorithm algorithm) override;
+
+  // The halving-doubling reduce-scatter takes its slots from the context in
+  // call order, which only holds on the background thread.
+  bool RunsOnWorkers() const override { return false; }
 };
 
 class GlooAllgather : public AllgatherOp {
@@ -101,12 +175,57 @@ public:
   bool Enabled(const ParameterManager& param_manager,
                const std::vector<TensorTableEntry>& entries,
                const Response& response) const override;
+
+protected:
+  // Packs the entries into the fusion buffer and broadcasts them as bytes.
+  Status ExecuteFused(std::vector<TensorTableEntry>& entries);
 };
 
 class GlooAlltoall : public AlltoallOp {
 public:
   explicit GlooAlltoall(HorovodGlobalState* global_state);
 
+  Status Execute(std::vector<TensorTableEntry>& entries,
+                 const Response& response) override;
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+
+protected:
+  // Packs the entries into the fusion buffer and exchanges them in a single
+  // alltoallv of bytes.
+  Status ExecuteFused(std::vector<TensorTableEntry>& entries);
+};
+
+class GlooReducescatter : public ReducescatterOp {
+public:
+  explicit GlooReducescatter(HorovodGlobalState* global_state);
+
+  Status Execute(std::vector<TensorTableEntry>& entries,
+                 const Response& response) override;
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+};
+
+class GlooReduce : public AllreduceOp {
+public:
+  explicit GlooReduce(HorovodGlobalState* global_state);
+
+  Status Execute(std::vector<TensorTableEntry>& entries,
+                 const Response& response) override;
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+};
+
+class GlooGather : public GatherOp {
+public:
+  explicit GlooGather(HorovodGlobalState* global_state);
+
   Status Execute(std::vector<TensorTableEntry>& entries,
                  const Response& response) override;
 
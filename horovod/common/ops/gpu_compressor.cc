@@ -0,0 +1,219 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "gpu_compressor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#if HAVE_CUDA
+#include "cuda/cuda_kernels.h"
+#elif HAVE_ROCM
+#include "rocm/hip_kernels.h"
+#endif
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+std::string ToLower(std::string name) {
+  std::transform(name.begin(), name.end(), name.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return name;
+}
+
+void BatchedScaledCastMemcpy(BatchedD2DParams& params, int num_copies,
+                             double scale_factor, DataType in_dtype,
+                             DataType out_dtype, gpuStream_t stream) {
+#if HAVE_CUDA
+  BatchedScaledCastD2DMemcpyCudaImpl(params, num_copies, scale_factor,
+                                     in_dtype, out_dtype, stream);
+#elif HAVE_ROCM
+  BatchedScaledCastD2DMemcpyROCmImpl(params, num_copies, scale_factor,
+                                     in_dtype, out_dtype, stream);
+#endif
+}
+
+// Converts float32 entries to float16 and back.
+class FP16Compressor : public GPUFusionCompressor {
+public:
+  DataType CompressedDataType(DataType dtype) const override {
+    return dtype == HOROVOD_FLOAT32 ? HOROVOD_FLOAT16 : dtype;
+  }
+
+  void CompressIn(const std::vector<TensorTableEntry>& entries,
+                  const std::vector<int64_t>& offsets, void* buffer_data,
+                  double scale_factor, gpuStream_t stream) override {
+    BatchedD2DParams params;
+    int count = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      auto& e = entries[i];
+      params.out[count] = (uint8_t*)buffer_data + offsets[i];
+      params.in[count] = (void*)e.tensor->data();
+      params.sizes[count] = e.tensor->shape().num_elements();
+      if (++count == BATCHED_D2D_CAPACITY || i + 1 == entries.size()) {
+        BatchedScaledCastMemcpy(params, count, scale_factor, HOROVOD_FLOAT32,
+                                HOROVOD_FLOAT16, stream);
+        count = 0;
+      }
+    }
+  }
+
+  void DecompressOut(const void* buffer_data,
+                     const std::vector<int64_t>& offsets, double scale_factor,
+                     std::vector<TensorTableEntry>& entries,
+                     gpuStream_t stream) override {
+    BatchedD2DParams params;
+    int count = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      auto& e = entries[i];
+      params.out[count] = (void*)e.output->data();
+      params.in[count] = (uint8_t*)buffer_data + offsets[i];
+      params.sizes[count] = e.tensor->shape().num_elements();
+      if (++count == BATCHED_D2D_CAPACITY || i + 1 == entries.size()) {
+        BatchedScaledCastMemcpy(params, count, scale_factor, HOROVOD_FLOAT16,
+                                HOROVOD_FLOAT32, stream);
+        count = 0;
+      }
+    }
+  }
+};
+
+// FP16Compressor with error feedback: what the conversion to float16 loses
+// of a tensor is added to it the next time it is compressed, so that the
+// rounding errors do not add up over the steps. Keeps a float32 residual per
+// tensor name on the device.
+class FP16ErrorFeedbackCompressor : public FP16Compressor {
+public:
+  void CompressIn(const std::vector<TensorTableEntry>& entries,
+                  const std::vector<int64_t>& offsets, void* buffer_data,
+                  double scale_factor, gpuStream_t stream) override {
+    BatchedCastEFParams params;
+    int count = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      auto& e = entries[i];
+      params.out[count] = (uint8_t*)buffer_data + offsets[i];
+      params.in[count] = e.tensor->data();
+      params.residuals[count] = Residual(e, stream);
+      params.sizes[count] = e.tensor->shape().num_elements();
+      if (++count == BATCHED_CAST_EF_CAPACITY || i + 1 == entries.size()) {
+#if HAVE_CUDA
+        BatchedScaledCastEFD2DMemcpyCudaImpl(params, count, scale_factor,
+                                             HOROVOD_FLOAT16, stream);
+#elif HAVE_ROCM
+        BatchedScaledCastEFD2DMemcpyROCmImpl(params, count, scale_factor,
+                                             HOROVOD_FLOAT16, stream);
+#endif
+        count = 0;
+      }
+    }
+  }
+
+  bool Stateful() const override { return true; }
+
+private:
+  struct ResidualBuffer {
+    std::shared_ptr<PersistentBuffer> buffer;
+    int64_t num_elements = 0;
+    int device = CPU_DEVICE_ID;
+  };
+
+  // Returns the residual of e, zeroed when it is first used or the tensor
+  // changed its size or device.
+  float* Residual(const TensorTableEntry& e, gpuStream_t stream) {
+    int64_t num_elements = e.tensor->shape().num_elements();
+    if (num_elements == 0) {
+      return nullptr;
+    }
+    auto& residual = residuals_[std::make_pair(e.process_set_id, e.tensor_name)];
+    if (residual.buffer == nullptr || residual.num_elements != num_elements ||
+        residual.device != e.device) {
+      residual.buffer.reset();
+      int64_t size = num_elements * (int64_t)sizeof(float);
+      Status status = e.context->AllocatePersistent(size, &residual.buffer);
+      if (!status.ok()) {
+        residual.buffer.reset();
+        throw std::runtime_error(
+            "Failed to allocate the error feedback residual of " +
+            e.tensor_name + ": " + status.reason());
+      }
+      residual.num_elements = num_elements;
+      residual.device = e.device;
+      HVD_GPU_CHECK(gpuMemsetAsync(
+          const_cast<void*>(residual.buffer->AccessData(e.context)), 0,
+          (size_t)size, stream));
+    }
+    return (float*)residual.buffer->AccessData(e.context);
+  }
+
+  // Keyed by process set ID and tensor name.
+  std::map<std::pair<int32_t, std::string>, ResidualBuffer> residuals_;
+};
+
+std::mutex& RegistryMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<std::string, GPUFusionCompressorFactory>& Registry() {
+  static std::map<std::string, GPUFusionCompressorFactory> registry{
+      {"fp16", [] { return std::make_shared<FP16Compressor>(); }},
+      {"fp16_ef",
+       [] { return std::make_shared<FP16ErrorFeedbackCompressor>(); }}};
+  return registry;
+}
+
+} // namespace
+
+void RegisterGPUFusionCompressor(const std::string& name,
+                                 GPUFusionCompressorFactory factory) {
+  std::lock_guard<std::mutex> guard(RegistryMutex());
+  Registry()[ToLower(name)] = std::move(factory);
+}
+
+std::shared_ptr<GPUFusionCompressor>
+CreateGPUFusionCompressor(const std::string& name) {
+  auto key = ToLower(name);
+  if (key.empty() || key == "none") {
+    return nullptr;
+  }
+
+  GPUFusionCompressorFactory factory;
+  std::string supported = "none";
+  {
+    std::lock_guard<std::mutex> guard(RegistryMutex());
+    auto& registry = Registry();
+    auto it = registry.find(key);
+    if (it != registry.end()) {
+      factory = it->second;
+    }
+    for (auto& entry : registry) {
+      supported += ", " + entry.first;
+    }
+  }
+  if (!factory) {
+    throw std::runtime_error("Unsupported fusion compression " + name +
+                             ", supported are " + supported);
+  }
+  return factory();
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,83 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_GPU_COMPRESSOR_H
+#define HOROVOD_GPU_COMPRESSOR_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../common.h"
+
+namespace horovod {
+namespace common {
+
+// Compresses the entries of a fused GPU allreduce while they are copied into
+// the fusion buffer, and decompresses the reduced data while it is copied
+// out, see HOROVOD_FUSION_COMPRESSION. The allreduce sums the compressed data
+// of all ranks, so a compressor needs a representation that can be summed,
+// such as a narrower floating point type.
+class GPUFusionCompressor {
+public:
+  virtual ~GPUFusionCompressor() = default;
+
+  // Data type entries of type dtype are reduced in, dtype itself for entries
+  // the compressor leaves alone.
+  virtual DataType CompressedDataType(DataType dtype) const = 0;
+
+  // Writes each of entries, scaled by scale_factor and compressed, to
+  // buffer_data + offsets[i] with work queued on stream. The entries are all
+  // of the same data type, which the compressor does not leave alone.
+  virtual void CompressIn(const std::vector<TensorTableEntry>& entries,
+                          const std::vector<int64_t>& offsets,
+                          void* buffer_data, double scale_factor,
+                          gpuStream_t stream) = 0;
+
+  // Writes the reduced data at buffer_data + offsets[i], decompressed and
+  // scaled by scale_factor, to the output of each of entries.
+  virtual void DecompressOut(const void* buffer_data,
+                             const std::vector<int64_t>& offsets,
+                             double scale_factor,
+                             std::vector<TensorTableEntry>& entries,
+                             gpuStream_t stream) = 0;
+
+  // Whether compression depends on state kept from earlier allreduces of the
+  // same tensors, such as the residuals of error feedback. Such allreduces
+  // are not captured in CUDA graphs.
+  virtual bool Stateful() const { return false; }
+};
+
+using GPUFusionCompressorFactory =
+    std::function<std::shared_ptr<GPUFusionCompressor>()>;
+
+// Makes the compressors factory creates selectable with
+// HOROVOD_FUSION_COMPRESSION=name, in place of one registered under the same
+// name before. Names are not case sensitive. Compressors are created when
+// Horovod is initialized, so a library that brings its own registers them
+// before, e.g. from a static initializer that runs when it is loaded.
+void RegisterGPUFusionCompressor(const std::string& name,
+                                 GPUFusionCompressorFactory factory);
+
+// Returns a new compressor registered as name, nullptr for "none". Throws
+// for names nothing is registered as.
+std::shared_ptr<GPUFusionCompressor>
+CreateGPUFusionCompressor(const std::string& name);
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_GPU_COMPRESSOR_H
@@ -1,46 +1,163 @@
 GPUContext::GPUContext() : pimpl{new impl} {}
 GPUContext::~GPUContext() = default;
 
-void GPUContext::Finalize() {
+void GPUContext::Finalize(bool keep_buffers) {
   finalizer_thread_pool.reset();
+
+  if (completion_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> guard(completion_mutex_);
+      completion_engine_running_ = false;
+    }
+    completion_cond_.notify_one();
+    completion_thread_.join();
+  }
+
+  if (keep_buffers) {
+    return;
+  }
+  ReleaseBuffers();
+}
+
+void GPUContext::AddMemoryUsage(MemoryUsage& usage) {
+  {
+    std::lock_guard<std::mutex> guard(host_buffers_mutex_);
+    for (auto& buffer : host_buffer_sizes_) {
+      usage[std::make_pair(CPU_DEVICE_ID, "host_staging")] += buffer.second;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> guard(device_buffers_mutex_);
+    for (auto& free_buffer : free_device_buffers_) {
+      usage[std::make_pair(free_buffer.first.first, "output_blocks")] +=
+          free_buffer.first.second;
+    }
+  }
+  std::lock_guard<std::mutex> guard(device_tables_mutex_);
+  for (auto& table : device_tables_) {
+    usage[std::make_pair(std::get<0>(table.first), "device_tables")] +=
+        table.second.capacity;
+  }
+}
+
+void GPUContext::ReleaseBuffers() {
+  std::lock_guard<std::mutex> guard(host_buffers_mutex_);
+  for (auto& free_buffer : free_host_buffers_) {
+    pimpl->HostFree(free_buffer.second);
+    host_buffer_sizes_.erase(free_buffer.second);
+  }
+  free_host_buffers_.clear();
+  free_host_buffer_bytes_ = 0;
+
+  std::lock_guard<std::mutex> device_guard(device_buffers_mutex_);
+  for (auto& free_buffer : free_device_buffers_) {
+    pimpl->DeviceFree(free_buffer.second.data);
+    pimpl->EventDestroy(free_buffer.second.release_event);
+  }
+  free_device_buffers_.clear();
+  free_device_buffer_bytes_ = 0;
+
+  // Freeing device memory synchronizes the device, so no kernel reads the
+  // tables anymore.
+  std::lock_guard<std::mutex> tables_guard(device_tables_mutex_);
+  for (auto& table : device_tables_) {
+    pimpl->DeviceFree(table.second.data);
+  }
+  device_tables_.clear();
 }
 
 void GPUContext::ErrorCheck(std::string op_name, gpuError_t gpu_result) {
   pimpl->ErrorCheck(op_name, gpu_result);
 }
 
-void GPUContext::RecordEvent(std::queue<std::pair<std::string, Event>>& event_queue, std::string name, gpuStream_t& stream) {
-  pimpl->RecordEvent(event_queue, name, stream);
+Event GPUContext::NextEvent(gpuStream_t stream) {
+  int device = pimpl->GetDevice();
+  int num_rings = num_event_rings_.load(std::memory_order_acquire);
+  EventRing* ring = nullptr;
+  for (int i = 0; i < num_rings; ++i) {
+    if (event_rings_[i]->stream == stream && event_rings_[i]->device == device) {
+      ring = event_rings_[i].get();
+      break;
+    }
+  }
+
+  if (ring == nullptr) {
+    std::lock_guard<std::mutex> guard(event_rings_mutex_);
+    num_rings = num_event_rings_.load(std::memory_order_relaxed);
+    for (int i = 0; i < num_rings; ++i) {
+      if (event_rings_[i]->stream == stream && event_rings_[i]->device == device) {
+        ring = event_rings_[i].get();
+        break;
+      }
+    }
+    if (ring == nullptr) {
+      if (num_rings == MAX_EVENT_RINGS) {
+        throw std::logic_error("Events were recorded on more than " +
+                               std::to_string(MAX_EVENT_RINGS) +
+                               " GPU streams.");
+      }
+      // Creating events carries a non-zero cost, so all of them are created
+      // up front.
+      event_rings_[num_rings].reset(new EventRing());
+      ring = event_rings_[num_rings].get();
+      ring->device = device;
+      ring->stream = stream;
+      for (auto& event : ring->events) {
+        event = pimpl->EventCreate();
+      }
+      num_event_rings_.store(num_rings + 1, std::memory_order_release);
+    }
+  }
+
+  auto index = ring->next.fetch_add(1, std::memory_order_relaxed);
+  return Event(&ring->events[index % EVENT_RING_SIZE], stream);
 }
 
-Event GPUContext::RecordEvent(gpuStream_t& stream) {
-  return pimpl->RecordEvent(stream);
+void GPUContext::RecordEvent(GPUEventQueue& event_queue, const char* phase, gpuStream_t& stream) {
+  event_queue.push(phase, RecordEvent(stream));
 }
 
-void GPUContext::ReleaseEvent(Event event) {
-  pimpl->ErrorCheck("ReleaseGpuEvent", pimpl->ReleaseGpuEvent(event));
+Event GPUContext::RecordEvent(gpuStream_t& stream) {
+  auto event = NextEvent(stream);
+  pimpl->EventRecord(*event.event, stream);
+  return event;
 }
 
-void GPUContext::WaitForEvents(std::queue<std::pair<std::string, Event>>& event_queue, const std::vector<TensorTableEntry>& entries,
+void GPUContext::WaitForEvents(GPUEventQueue& event_queue, const std::vector<TensorTableEntry>& entries,
                                Timeline& timeline, const std::function<void()>& error_check_callback,
                                bool elastic) {
   pimpl->WaitForEvents(event_queue, entries, timeline, error_check_callback, elastic);
 }
 
-void GPUContext::ClearEvents(std::queue<std::pair<std::string, Event>>& event_queue, const std::vector<TensorTableEntry>& entries,
+void GPUContext::ClearEvents(GPUEventQueue& event_queue, const std::vector<TensorTableEntry>& entries,
                              Timeline& timeline, const std::function<void()>& error_check_callback,
                              bool elastic) {
   pimpl->ClearEvents(event_queue, entries, timeline, error_check_callback, elastic);
 }
 
 void GPUContext::StreamCreate(gpuStream_t *stream) {
-  pimpl->StreamCreate(stream);
+  pimpl->StreamCreate(stream, stream_priority);
+}
+
+gpuStream_t GPUContext::GetStream(int stream_id, int device) {
+  pimpl->SetDevice(device);
+  gpuStream_t& stream = streams[stream_id][device];
+  if (stream == nullptr) {
+    StreamCreate(&stream);
+    StreamSetName(stream, "Horovod stream " + std::to_string(stream_id) +
+                              " (device " + std::to_string(device) + ")");
+  }
+  return stream;
 }
 
 void GPUContext::StreamSynchronize(gpuStream_t stream) {
   pimpl->StreamSynchronize(stream);
 }
 
+void GPUContext::StreamSetName(gpuStream_t stream, const std::string& name) {
+  pimpl->StreamSetName(stream, name);
+}
+
 int GPUContext::GetDevice() {
   return pimpl->GetDevice();
 }
@@ -61,8 +178,285 @@ void GPUContext::MemcpyAsyncD2H(void* dst, const void* src, size_t count, gpuStr
   pimpl->MemcpyAsyncD2H(dst, src, count, stream);
 }
 
+void* GPUContext::AcquireHostBuffer(size_t size) {
+  // Round up to a power of two so that buffers can be reused across
+  // slightly different response sizes.
+  size_t capacity = MIN_HOST_BUFFER_SIZE;
+  while (capacity < size) {
+    capacity <<= 1;
+  }
+
+  std::lock_guard<std::mutex> guard(host_buffers_mutex_);
+  auto it = free_host_buffers_.find(capacity);
+  if (it != free_host_buffers_.end()) {
+    void* buffer = it->second;
+    free_host_buffers_.erase(it);
+    free_host_buffer_bytes_ -= capacity;
+    return buffer;
+  }
+
+  // Page-locking touches the pages, placing them under the current policy.
+  int previous_node = PreferredNumaNode();
+  PreferNumaNode(host_buffer_numa_node);
+  void* buffer = pimpl->HostAlloc(capacity);
+  PreferNumaNode(previous_node);
+  host_buffer_sizes_[buffer] = capacity;
+  return buffer;
+}
+
+void GPUContext::ReleaseHostBuffer(void* buffer) {
+  std::lock_guard<std::mutex> guard(host_buffers_mutex_);
+  auto capacity = host_buffer_sizes_.at(buffer);
+  if (free_host_buffer_bytes_ + capacity > MAX_FREE_HOST_BUFFER_BYTES) {
+    // Don't keep an unbounded amount of page-locked memory around.
+    pimpl->HostFree(buffer);
+    host_buffer_sizes_.erase(buffer);
+    return;
+  }
+  free_host_buffers_.emplace(capacity, buffer);
+  free_host_buffer_bytes_ += capacity;
+}
+
+class GPUOutputBlock : public OutputBlock {
+public:
+  GPUOutputBlock(GPUContext* context, GPUContext::DeviceBuffer buffer)
+      : context_(context), buffer_(buffer) {}
+
+  ~GPUOutputBlock() override { context_->ReleaseDeviceBuffer(buffer_); }
+
+  void* data() const override { return buffer_.data; }
+
+  size_t size() const override { return buffer_.capacity; }
+
+  void RecordRelease(gpuStream_t stream) override {
+    // Outputs are released from framework threads. Recording under the lock
+    // keeps the last recorded release the latest one on the stream.
+    std::lock_guard<std::mutex> guard(mutex_);
+    context_->pimpl->EventRecord(buffer_.release_event, stream);
+    buffer_.release_recorded = true;
+  }
+
+private:
+  GPUContext* context_;
+  GPUContext::DeviceBuffer buffer_;
+  std::mutex mutex_;
+};
+
+std::shared_ptr<OutputBlock>
+GPUContext::AcquireOutputBlock(size_t size, int device, gpuStream_t stream) {
+  size_t capacity = MIN_DEVICE_BUFFER_SIZE;
+  while (capacity < size) {
+    capacity <<= 1;
+  }
+
+  DeviceBuffer buffer;
+  {
+    std::lock_guard<std::mutex> guard(device_buffers_mutex_);
+    auto it = free_device_buffers_.find(std::make_pair(device, capacity));
+    if (it != free_device_buffers_.end()) {
+      buffer = it->second;
+      free_device_buffers_.erase(it);
+      free_device_buffer_bytes_ -= capacity;
+    }
+  }
+
+  if (buffer.data == nullptr) {
+    buffer.data = pimpl->DeviceAlloc(capacity);
+    buffer.capacity = capacity;
+    buffer.device = device;
+    buffer.release_event = pimpl->EventCreate();
+  } else if (buffer.release_recorded) {
+    // Readers of the previous outputs may still be running on the framework
+    // stream.
+    pimpl->StreamWaitEvent(stream, buffer.release_event);
+    buffer.release_recorded = false;
+  }
+  return std::make_shared<GPUOutputBlock>(this, buffer);
+}
+
+void GPUContext::ReleaseDeviceBuffer(DeviceBuffer buffer) {
+  std::lock_guard<std::mutex> guard(device_buffers_mutex_);
+  if (free_device_buffer_bytes_ + buffer.capacity >
+      MAX_FREE_DEVICE_BUFFER_BYTES) {
+    // Freeing device memory synchronizes the device, so pending readers are
+    // done with it.
+    pimpl->DeviceFree(buffer.data);
+    pimpl->EventDestroy(buffer.release_event);
+    return;
+  }
+  free_device_buffers_.emplace(std::make_pair(buffer.device, buffer.capacity),
+                               buffer);
+  free_device_buffer_bytes_ += buffer.capacity;
+}
+
+class GPUPooledBuffer : public PersistentBuffer {
+public:
+  GPUPooledBuffer(GPUContext* context, size_t size, gpuStream_t stream)
+      : context_(context), stream_(stream),
+        data_(context->pimpl->DeviceAllocAsync(size, stream)) {}
+
+  ~GPUPooledBuffer() override {
+    try {
+      context_->pimpl->DeviceFreeAsync(data_, stream_);
+    } catch (const std::exception&) {
+      // The GPU runtime may be gone at exit.
+    }
+  }
+
+  const void* AccessData(std::shared_ptr<OpContext> context) const override {
+    return data_;
+  }
+
+private:
+  GPUContext* context_;
+  gpuStream_t stream_;
+  void* data_;
+};
+
+std::shared_ptr<PersistentBuffer> GPUContext::AllocatePooled(size_t size,
+                                                             gpuStream_t stream) {
+  return std::make_shared<GPUPooledBuffer>(this, size, stream);
+}
+
+const void* GPUContext::UploadTable(const void* data, size_t bytes, int slot,
+                                    gpuStream_t stream) {
+  std::lock_guard<std::mutex> guard(device_tables_mutex_);
+  auto& table =
+      device_tables_[std::make_tuple(pimpl->GetDevice(), stream, slot)];
+  auto begin = static_cast<const uint8_t*>(data);
+  if (table.data != nullptr && table.contents.size() == bytes &&
+      std::equal(begin, begin + bytes, table.contents.begin())) {
+    return table.data;
+  }
+  if (bytes > table.capacity) {
+    // Freeing device memory synchronizes the device, so tables only grow.
+    if (table.data != nullptr) {
+      pimpl->DeviceFree(table.data);
+    }
+    table.capacity = std::max(bytes, 2 * table.capacity);
+    table.data = pimpl->DeviceAlloc(table.capacity);
+  }
+  // Kernels still reading the previous contents ran earlier on stream.
+  table.contents.assign(begin, begin + bytes);
+  pimpl->MemcpyAsyncH2D(table.data, table.contents.data(), bytes, stream);
+  return table.data;
+}
+
 void GPUContext::ScaleBufferImpl(const void* fused_input_data, void* buffer_data, int64_t num_elements,
                                  double scale_factor, DataType dtype, gpuStream_t stream) {
   pimpl->ScaleBufferImpl(fused_input_data, buffer_data, num_elements, scale_factor, dtype, stream);
 }
 
+void GPUContext::ScaledAddBufferImpl(const void* input_data, void* buffer_data, int64_t num_elements,
+                                     double scale_factor, DataType dtype, gpuStream_t stream) {
+  pimpl->ScaledAddBufferImpl(input_data, buffer_data, num_elements, scale_factor, dtype, stream);
+}
+
+void GPUContext::ScaledCastBufferImpl(const void* input_data, void* buffer_data, int64_t num_elements,
+                                      double scale_factor, DataType in_dtype, DataType out_dtype,
+                                      gpuStream_t stream) {
+  pimpl->ScaledCastBufferImpl(input_data, buffer_data, num_elements, scale_factor, in_dtype, out_dtype, stream);
+}
+
+bool GPUContext::EventCompleted(const Event& event) {
+  return pimpl->EventCompleted(event);
+}
+
+void GPUContext::StartCompletionEngine() {
+  completion_engine_running_ = true;
+  completion_thread_ = std::thread(&GPUContext::CompletionLoop, this);
+}
+
+void GPUContext::EnqueueCompletion(GPUCompletion&& completion) {
+  {
+    std::lock_guard<std::mutex> guard(completion_mutex_);
+    new_completions_.push_back(std::move(completion));
+  }
+  completion_cond_.notify_one();
+}
+
+void GPUContext::CompletionLoop() {
+  PlaceHelperThread();
+  std::vector<GPUCompletion> completions;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(completion_mutex_);
+      if (completions.empty()) {
+        // Nothing to poll, sleep until the next response is enqueued.
+        completion_cond_.wait(lock, [this] {
+          return !completion_engine_running_ || !new_completions_.empty();
+        });
+      }
+      if (!completion_engine_running_) {
+        return;
+      }
+      for (auto& completion : new_completions_) {
+        completions.push_back(std::move(completion));
+      }
+      new_completions_.clear();
+    }
+
+    // One query per outstanding event, rather than one blocked thread each.
+    auto it = completions.begin();
+    while (it != completions.end()) {
+      if (ProgressCompletion(*it)) {
+        it = completions.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    if (!completions.empty()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+bool GPUContext::ProgressCompletion(GPUCompletion& completion) {
+  SetDevice(completion.device);
+
+  auto& event_queue = completion.event_queue;
+  auto& timeline = *completion.timeline;
+  while (!event_queue.empty()) {
+    const char* phase = event_queue.front().first;
+    Event event = event_queue.front().second;
+    if (phase[0] != '\0' && !completion.activity_started) {
+      timeline.ActivityStartAll(completion.entries, phase);
+      completion.activity_started = true;
+    }
+
+    if (!pimpl->EventCompleted(event)) {
+      // Check for async (networking) errors while waiting for the event.
+      if (completion.elastic && completion.error_check_callback) {
+        completion.error_check_callback();
+      }
+      return false;
+    }
+
+    if (!completion.elastic && completion.error_check_callback) {
+      completion.error_check_callback();
+    }
+    if (phase[0] != '\0') {
+      timeline.ActivityEndAll(completion.entries);
+      completion.activity_started = false;
+    }
+    event_queue.pop();
+  }
+
+  if (completion.host_buffer != nullptr) {
+    if (completion.host_buffer_pinned) {
+      ReleaseHostBuffer(completion.host_buffer);
+    } else {
+      free(completion.host_buffer);
+    }
+  }
+
+  NvtxPhaseRange finalizer_range(RegisteredNvtxPhase::FinalizerCallback,
+                                 completion.correlation_id);
+  for (auto& e : completion.entries) {
+    timeline.End(e.tensor_name, e.output);
+    e.FinishWithCallback(Status::OK());
+  }
+  return true;
+}
+
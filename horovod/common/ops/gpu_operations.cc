@@ -15,38 +15,228 @@
 // =============================================================================
 
 #include "gpu_operations.h"
+#include "gpu_compressor.h"
 #if HAVE_CUDA
 #include "cuda/cuda_kernels.h"
+#elif HAVE_ROCM
+#include "rocm/hip_kernels.h"
 #endif
 
 #include <thread>
+#include <unordered_set>
 
 namespace horovod {
 namespace common {
 
-GPUOpContext::GPUOpContext(GPUContext* context, HorovodGlobalState* global_state)
-    : gpu_context_(context), global_state_(global_state) {}
+namespace {
+
+// Slots of GPUContext::UploadTable() for the copies into and out of fusion
+// buffers.
+constexpr int COPY_IN_TABLE = 0;
+constexpr int COPY_OUT_TABLE = 1;
+
+// Performs copies with a single launch, scaling elements of dtype unless
+// scale_factor is 1.
+void BatchedMemcpy(GPUContext* gpu_context,
+                   const std::vector<BatchedD2DCopy>& copies, int slot,
+                   double scale_factor, DataType dtype, gpuStream_t stream) {
+  auto table = static_cast<const BatchedD2DCopy*>(gpu_context->UploadTable(
+      copies.data(), sizeof(BatchedD2DCopy) * copies.size(), slot, stream));
+  int num_copies = (int)copies.size();
+#if HAVE_CUDA
+  if (scale_factor == 1.0) {
+    BatchedD2DMemcpyTableCudaImpl(table, num_copies, stream);
+  } else {
+    BatchedScaledD2DMemcpyTableCudaImpl(table, num_copies, scale_factor, dtype,
+                                        stream);
+  }
+#elif HAVE_ROCM
+  if (scale_factor == 1.0) {
+    BatchedD2DMemcpyTableROCmImpl(table, num_copies, stream);
+  } else {
+    BatchedScaledD2DMemcpyTableROCmImpl(table, num_copies, scale_factor, dtype,
+                                        stream);
+  }
+#endif
+  // TODO: https://github.com/horovod/horovod/issues/2230
+  //gpu_context->ErrorCheck("BatchedD2DMemcpyTableCudaImpl", cudaGetLastError());
+}
 
-void GPUOpContext::InitGPU(const std::vector<TensorTableEntry>& entries) {
-  auto& first_entry = entries[0];
-  gpu_context_->SetDevice(first_entry.device);
+class GPUSumTensor : public Tensor {
+public:
+  GPUSumTensor(std::shared_ptr<OutputBlock> block, DataType dtype,
+               TensorShape shape)
+      : block_(std::move(block)), dtype_(dtype), shape_(std::move(shape)) {}
+  const DataType dtype() const override { return dtype_; }
+  const TensorShape shape() const override { return shape_; }
+  const void* data() const override { return block_->data(); }
+  int64_t size() const override {
+    return shape_.num_elements() * DataType_Size(dtype_);
+  }
 
-  // Ensure stream is in the map before executing reduction.
-  gpuStream_t& stream = gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device];
+private:
+  std::shared_ptr<OutputBlock> block_;
+  DataType dtype_;
+  TensorShape shape_;
+};
+
+class GPUSumReadyEvent : public ReadyEvent {
+public:
+  GPUSumReadyEvent(GPUContext* gpu_context, Event event)
+      : gpu_context_(gpu_context), event_(std::move(event)) {}
+  bool Ready() const override { return gpu_context_->EventCompleted(event_); }
+  gpuEvent_t event() const override { return *event_.event; }
+
+private:
+  GPUContext* gpu_context_;
+  Event event_;
+};
+
+// Offsets of the entries in a fusion buffer of elements of dtype, each padded
+// like the batched copies do. Returns the length of the buffer in bytes.
+size_t CompressedOffsets(const std::vector<TensorTableEntry>& entries, DataType dtype,
+                         std::vector<int64_t>& offsets) {
+  auto element_size = DataType_Size(dtype);
+  int64_t offset = 0;
+  offsets.clear();
+  offsets.reserve(entries.size());
+  for (auto& e : entries) {
+    offsets.push_back(offset);
+    int64_t num_elements = e.tensor->shape().num_elements();
+    offset += BATCHED_D2D_PADDING * ((num_elements * element_size + BATCHED_D2D_PADDING - 1) / BATCHED_D2D_PADDING);
+  }
+  return (size_t)offset;
+}
+
+} // namespace
+
+Status GPUAccumulator::Add(const std::string& name, const Tensor& tensor,
+                           int device, ReadyEventList& ready_event_list,
+                           Event& event) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto& sum = sums_[name];
+  if (sum.taken) {
+    return Status::PreconditionError(
+        "Tensor " + name + " was accumulated while its sum is allreduced.");
+  }
+  if (!sum.empty && (sum.dtype != tensor.dtype() ||
+                     sum.shape != tensor.shape() || sum.device != device)) {
+    return Status::PreconditionError(
+        "Accumulated tensors " + name +
+        " differ in type, shape or device between backward passes.");
+  }
+
+  gpu_context_->SetDevice(device);
+  auto& stream = streams_[device];
   if (stream == nullptr) {
     gpu_context_->StreamCreate(&stream);
+    gpu_context_->StreamSetName(stream, "Horovod accumulation");
+  }
+
+  std::unordered_set<gpuEvent_t> ready_events;
+  ready_event_list.PushEventsToSet(ready_events);
+  for (auto ev : ready_events) {
+    HVD_GPU_CHECK(gpuStreamWaitEvent(stream, ev, 0));
+  }
+  if (sum.release_event.event != nullptr) {
+    HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *sum.release_event.event, 0));
+    sum.release_event = Event();
+  }
+
+  if (sum.empty) {
+    auto size = (size_t)tensor.size();
+    if (sum.block == nullptr || sum.block->size() < size ||
+        sum.device != device) {
+      if (sum.block != nullptr) {
+        sum.block->RecordRelease(streams_[sum.device]);
+      }
+      sum.block = gpu_context_->AcquireOutputBlock(size, device, stream);
+    }
+    gpu_context_->MemcpyAsyncD2D(sum.block->data(), tensor.data(), size,
+                                 stream);
+    sum.dtype = tensor.dtype();
+    sum.shape = tensor.shape();
+    sum.device = device;
+    sum.empty = false;
+  } else {
+    gpu_context_->ScaledAddBufferImpl(tensor.data(), sum.block->data(),
+                                      tensor.shape().num_elements(), 1.0,
+                                      tensor.dtype(), stream);
+  }
+
+  sum.last_add = gpu_context_->RecordEvent(stream);
+  event = sum.last_add;
+  return Status::OK();
+}
+
+Status GPUAccumulator::Take(const std::string& name,
+                            std::shared_ptr<Tensor>& sum,
+                            std::shared_ptr<ReadyEvent>& ready_event) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = sums_.find(name);
+  if (it == sums_.end() || it->second.empty || it->second.taken) {
+    return Status::PreconditionError("Nothing was accumulated for tensor " +
+                                     name + ".");
+  }
+  it->second.taken = true;
+  sum = std::make_shared<GPUSumTensor>(it->second.block, it->second.dtype,
+                                       it->second.shape);
+  ready_event =
+      std::make_shared<GPUSumReadyEvent>(gpu_context_, it->second.last_add);
+  return Status::OK();
+}
+
+void GPUAccumulator::Release(const std::string& name,
+                             const Event& release_event) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = sums_.find(name);
+  if (it == sums_.end()) {
+    return;
   }
+  it->second.taken = false;
+  it->second.empty = true;
+  it->second.release_event = release_event;
+}
+
+void GPUAccumulator::Reset() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  sums_.clear();
+}
+
+GPUOpContext::GPUOpContext(GPUContext* context, HorovodGlobalState* global_state)
+    : gpu_context_(context), global_state_(global_state) {}
+
+void GPUOpContext::InitGPU(const std::vector<TensorTableEntry>& entries) {
+  // Ensure stream is in the map before executing reduction.
+  gpu_context_->GetStream(global_state_->current_nccl_stream,
+                          entries[0].device);
 }
 
 void GPUOpContext::InitGPUQueue(const std::vector<TensorTableEntry>& entries, const Response& response) {
-  event_queue = std::queue<std::pair<std::string, Event>>();
+  event_queue.clear();
   stream = &gpu_context_->streams[global_state_->current_nccl_stream][entries[0].device];
+  correlation_id = gpu_context_->NextCorrelationId();
 
   if (global_state_->timeline.Initialized()) {
+    global_state_->timeline.SetCorrelationId(entries, correlation_id);
     gpu_context_->RecordEvent(event_queue, QUEUE, *stream);
   }
 }
 
+void GPUOpContext::WaitForData(std::vector<TensorTableEntry>& entries) {
+  // Push events to set to deduplicate entries
+  std::unordered_set<gpuEvent_t> event_set;
+  for (auto& e : entries) {
+    e.ready_event_list.PushEventsToSet(event_set);
+  }
+  for (auto& ev : event_set) {
+    HVD_GPU_CHECK(gpuStreamWaitEvent(*stream, ev, 0));
+  }
+  if (!event_set.empty() && global_state_->timeline.Initialized()) {
+    gpu_context_->RecordEvent(event_queue, WAIT_FOR_DATA, *stream);
+  }
+}
+
 Status GPUOpContext::FinalizeGPUQueue(std::vector<TensorTableEntry>& entries, bool free_host_buffer /*= true*/,
                                       const std::function<void()>& error_check_callback) {
   // Use completion marker via event because it's faster than
@@ -57,56 +247,89 @@ Status GPUOpContext::FinalizeGPUQueue(std::vector<TensorTableEntry>& entries, bo
 
   auto& first_entry = entries[0];
   void* cpu_buffer = host_buffer;
+  bool cpu_buffer_pinned = host_buffer_pinned;
+  if (free_host_buffer) {
+    host_buffer = nullptr;
+    host_buffer_pinned = false;
+  }
   auto& evt_queue = event_queue;
   auto& timeline = global_state_->timeline;
   auto& gpu_context = gpu_context_;
 
   // Claim a std::shared_ptr to the fusion buffer to prevent its memory from being reclaimed
   // during finalization.
-  auto fusion_buffer = global_state_->fusion_buffer.GetBuffer(
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto fusion_buffer = process_set.fusion_buffer.GetBuffer(
       first_entry.device, first_entry.context->framework(), global_state_->current_nccl_stream);
 
   bool elastic = global_state_->elastic_enabled;
+  int64_t op_correlation_id = correlation_id;
   bool enable_async_completion = global_state_->enable_async_completion;
-  auto current_stream = *stream;
-  gpu_context_->finalizer_thread_pool.execute([entries, first_entry, cpu_buffer, fusion_buffer, free_host_buffer,
-                                               evt_queue, &timeline, &gpu_context, error_check_callback,
-                                               elastic, enable_async_completion, current_stream]() mutable {
-    gpu_context->SetDevice(first_entry.device);
-
-    Event event;
-    if (!enable_async_completion || timeline.Initialized()) {
-      // If timeline is enabled, wait for events on CPU for accurate timings.
-      gpu_context->WaitForEvents(evt_queue, entries, timeline, error_check_callback, elastic);
-    } else {
-      gpu_context->ClearEvents(evt_queue, entries, timeline, error_check_callback, elastic);
-      event = gpu_context->RecordEvent(current_stream);
+  if (global_state_->gpu_completion_engine &&
+      (!enable_async_completion || timeline.Initialized())) {
+    // Wait for the events on the polling thread shared by all responses.
+    GPUCompletion completion;
+    completion.event_queue = std::move(event_queue);
+    completion.entries = entries;
+    completion.error_check_callback = error_check_callback;
+    completion.timeline = &timeline;
+    completion.device = first_entry.device;
+    completion.elastic = elastic;
+    completion.correlation_id = op_correlation_id;
+    if (free_host_buffer) {
+      completion.host_buffer = cpu_buffer;
+      completion.host_buffer_pinned = cpu_buffer_pinned;
     }
+    completion.fusion_buffer = std::move(fusion_buffer);
+    gpu_context_->EnqueueCompletion(std::move(completion));
+  } else {
+    auto current_stream = *stream;
+    gpu_context_->finalizer_thread_pool.execute([entries, first_entry, cpu_buffer, cpu_buffer_pinned,
+                                                 fusion_buffer, free_host_buffer, evt_queue,
+                                                 &timeline, &gpu_context, error_check_callback,
+                                                 elastic, enable_async_completion, current_stream,
+                                                 op_correlation_id]() mutable {
+      gpu_context->SetDevice(first_entry.device);
+
+      Event event;
+      if (!enable_async_completion || timeline.Initialized()) {
+        // If timeline is enabled, wait for events on CPU for accurate timings.
+        gpu_context->WaitForEvents(evt_queue, entries, timeline, error_check_callback, elastic);
+      } else {
+        gpu_context->ClearEvents(evt_queue, entries, timeline, error_check_callback, elastic);
+        event = gpu_context->RecordEvent(current_stream);
+      }
 
-    if (free_host_buffer && cpu_buffer != nullptr) {
-      free(cpu_buffer);
-    }
+      if (free_host_buffer && cpu_buffer != nullptr) {
+        if (cpu_buffer_pinned) {
+          gpu_context->ReleaseHostBuffer(cpu_buffer);
+        } else {
+          free(cpu_buffer);
+        }
+      }
 
-    for (auto& e : entries) {
-      timeline.End(e.tensor_name, e.output);
-      auto status = Status::OK();
-      status.event = event;
-      e.FinishWithCallback(status);
-    }
-    if (enable_async_completion) {
-      gpu_context->ReleaseEvent(event);
-    }
-  });
+      NvtxPhaseRange finalizer_range(RegisteredNvtxPhase::FinalizerCallback,
+                                     op_correlation_id);
+      for (auto& e : entries) {
+        timeline.End(e.tensor_name, e.output);
+        auto status = Status::OK();
+        status.event = event;
+        e.FinishWithCallback(status);
+      }
+    });
+  }
 
   // Update current stream
   global_state_->current_nccl_stream = (global_state_->current_nccl_stream + 1) %
-                                  global_state_->num_nccl_streams;
+                                  global_state_->parameter_manager.NumNcclStreams();
 
   return Status::InProgress();
 }
 
 GPUAllreduce::GPUAllreduce(GPUContext* context, HorovodGlobalState* global_state)
-    : AllreduceOp(global_state), gpu_context_(context), gpu_op_context_(context, global_state) {}
+    : AllreduceOp(global_state), gpu_context_(context), gpu_op_context_(context, global_state),
+      fusion_compressor_(CreateGPUFusionCompressor(global_state->fusion_compression)) {}
 
 bool GPUAllreduce::Enabled(const ParameterManager& param_manager,
                             const std::vector<TensorTableEntry>& entries,
@@ -114,42 +337,30 @@ bool GPUAllreduce::Enabled(const ParameterManager& param_manager,
   return entries[0].device != CPU_DEVICE_ID;
 }
 
-#if HAVE_CUDA
 void GPUAllreduce::MemcpyInFusionBuffer(const std::vector<TensorTableEntry>& entries, const void*& fused_input_data,
                                         void*& buffer_data, size_t& buffer_len) {
+  NvtxPhaseRange range(RegisteredNvtxPhase::FusionBufferMemcpyIn,
+                       gpu_op_context_.correlation_id);
   // Access the fusion buffer.
   auto& first_entry = entries[0];
-  auto buffer = global_state_->fusion_buffer.GetBuffer(
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto buffer = process_set.fusion_buffer.GetBuffer(
       first_entry.device, first_entry.context->framework(), global_state_->current_nccl_stream);
   buffer_data = const_cast<void*>(buffer->AccessData(first_entry.context));
 
-  if (global_state_->batch_d2d_memcopies) {
+  if (global_state_->parameter_manager.BatchD2DMemcopies()) {
     int64_t offset = 0;
-    int idx = 0;
-    int count = 0;
-
-    BatchedD2DParams d2d_params;
-    auto& first_entry = entries[0];
+    std::vector<BatchedD2DCopy> copies;
+    copies.reserve(entries.size());
     for (auto& e : entries) {
-      void* buffer_data_at_offset = (uint8_t*)buffer_data + offset;
-
-      // Set input/output pointers and sizes
-      d2d_params.out[idx % BATCHED_D2D_CAPACITY] = buffer_data_at_offset;
-      d2d_params.in[idx % BATCHED_D2D_CAPACITY] = (void*) e.tensor->data();
-      d2d_params.sizes[idx % BATCHED_D2D_CAPACITY] = e.tensor->size();
-
+      copies.push_back({(uint8_t*)buffer_data + offset, e.tensor->data(),
+                        (size_t)e.tensor->size()});
       offset += BATCHED_D2D_PADDING * ((e.tensor->size() + BATCHED_D2D_PADDING - 1) / BATCHED_D2D_PADDING);
-      idx++;
-      count++;
-
-      if (idx % BATCHED_D2D_CAPACITY == 0 || idx == (int) entries.size()) {
-        // Perform batched d2d memcpy
-        BatchedD2DMemcpyCudaImpl(d2d_params, count, gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device]);
-        // TODO: https://github.com/horovod/horovod/issues/2230
-        //gpu_context_->ErrorCheck("BatchedD2DMemcpyCudaImpl", cudaGetLastError());
-        count = 0;
-      }
     }
+    BatchedMemcpy(gpu_context_, copies, COPY_IN_TABLE, 1.0,
+                  first_entry.tensor->dtype(),
+                  gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device]);
     buffer_len = (size_t)offset;
 
   } else {
@@ -166,44 +377,41 @@ void GPUAllreduce::MemcpyInFusionBuffer(const std::vector<TensorTableEntry>& ent
   // Set the input data to originate from the buffer.
   fused_input_data = buffer_data;
 }
-#endif
 
-#if HAVE_CUDA
 void GPUAllreduce::ScaleMemcpyInFusionBuffer(const std::vector<TensorTableEntry>& entries, const void*& fused_input_data,
                                              void*& buffer_data, size_t& buffer_len, double scale_factor) {
   auto& first_entry = entries[0];
   // Access the fusion buffer.
-  auto buffer = global_state_->fusion_buffer.GetBuffer(
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto buffer = process_set.fusion_buffer.GetBuffer(
       first_entry.device, first_entry.context->framework(), global_state_->current_nccl_stream);
   buffer_data = const_cast<void*>(buffer->AccessData(first_entry.context));
 
-  if (global_state_->batch_d2d_memcopies) {
-    int64_t offset = 0;
-    int idx = 0;
-    int count = 0;
+  ScaleMemcpyInBuffer(entries, buffer_data, buffer_len, scale_factor);
 
-    BatchedD2DParams d2d_params;
-    for (auto& e : entries) {
-      void* buffer_data_at_offset = (uint8_t*)buffer_data + offset;
+  // Set the input data to originate from the buffer.
+  fused_input_data = buffer_data;
+}
 
-      // Set input/output pointers and sizes
-      d2d_params.out[idx % BATCHED_D2D_CAPACITY] = buffer_data_at_offset;
-      d2d_params.in[idx % BATCHED_D2D_CAPACITY] = (void*) e.tensor->data();
-      d2d_params.sizes[idx % BATCHED_D2D_CAPACITY] = e.tensor->size();
+void GPUAllreduce::ScaleMemcpyInBuffer(const std::vector<TensorTableEntry>& entries, void* buffer_data,
+                                       size_t& buffer_len, double scale_factor) {
+  NvtxPhaseRange range(RegisteredNvtxPhase::FusionBufferMemcpyIn,
+                       gpu_op_context_.correlation_id);
+  auto& first_entry = entries[0];
 
-      offset += BATCHED_D2D_PADDING * ((e.tensor->size() + BATCHED_D2D_PADDING - 1) / BATCHED_D2D_PADDING);
-      idx++;
-      count++;
-
-      if (idx % BATCHED_D2D_CAPACITY == 0 || idx == (int) entries.size()) {
-        // Perform batched d2d memcpy
-        BatchedScaledD2DMemcpyCudaImpl(d2d_params, count, scale_factor, first_entry.tensor->dtype(),
-                                       gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device]);
-        // TODO: https://github.com/horovod/horovod/issues/2230
-        //gpu_context_->ErrorCheck("BatchedScaledD2DMemcpyCudaImpl", cudaGetLastError());
-        count = 0;
-      }
+  if (global_state_->parameter_manager.BatchD2DMemcopies()) {
+    int64_t offset = 0;
+    std::vector<BatchedD2DCopy> copies;
+    copies.reserve(entries.size());
+    for (auto& e : entries) {
+      copies.push_back({(uint8_t*)buffer_data + offset, e.tensor->data(),
+                        (size_t)e.tensor->size()});
+      offset += FusionBufferEntrySize(e);
     }
+    BatchedMemcpy(gpu_context_, copies, COPY_IN_TABLE, scale_factor,
+                  first_entry.tensor->dtype(),
+                  gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device]);
     buffer_len = (size_t)offset;
 
   } else {
@@ -211,7 +419,7 @@ void GPUAllreduce::ScaleMemcpyInFusionBuffer(const std::vector<TensorTableEntry>
     for (auto& e : entries) {
       void* buffer_data_at_offset = (uint8_t*) buffer_data + offset;
       MemcpyEntryInFusionBuffer(entries, e, buffer_data_at_offset);
-      offset += e.tensor->size();
+      offset += FusionBufferEntrySize(e);
     }
 
     buffer_len = (size_t) offset;
@@ -220,12 +428,50 @@ void GPUAllreduce::ScaleMemcpyInFusionBuffer(const std::vector<TensorTableEntry>
       ScaleBuffer(scale_factor, entries, buffer_data, buffer_data, num_elements);
     }
   }
+}
+
+
+DataType GPUAllreduce::FusionBufferDataType(const std::vector<TensorTableEntry>& entries) const {
+  auto dtype = entries[0].tensor->dtype();
+  if (fusion_compressor_ != nullptr) {
+    return fusion_compressor_->CompressedDataType(dtype);
+  }
+  return dtype;
+}
+
+bool GPUAllreduce::StatefulFusionCompression(const std::vector<TensorTableEntry>& entries) const {
+  return entries.size() > 1 && fusion_compressor_ != nullptr && fusion_compressor_->Stateful() &&
+         FusionBufferDataType(entries) != entries[0].tensor->dtype();
+}
+
+void GPUAllreduce::CompressMemcpyInFusionBuffer(const std::vector<TensorTableEntry>& entries,
+                                                const void*& fused_input_data, void*& buffer_data,
+                                                size_t& buffer_len, double scale_factor) {
+  auto& first_entry = entries[0];
+  // Access the fusion buffer.
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto buffer = process_set.fusion_buffer.GetBuffer(
+      first_entry.device, first_entry.context->framework(), global_state_->current_nccl_stream);
+  buffer_data = const_cast<void*>(buffer->AccessData(first_entry.context));
+
+  std::vector<int64_t> offsets;
+  buffer_len = CompressedOffsets(entries, FusionBufferDataType(entries), offsets);
+  fusion_compressor_->CompressIn(entries, offsets, buffer_data, scale_factor,
+                                 gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device]);
 
   // Set the input data to originate from the buffer.
   fused_input_data = buffer_data;
 }
-#endif
 
+void GPUAllreduce::DecompressMemcpyOutFusionBuffer(const void* buffer_data, double scale_factor,
+                                                   std::vector<TensorTableEntry>& entries) {
+  auto& first_entry = entries[0];
+  std::vector<int64_t> offsets;
+  CompressedOffsets(entries, FusionBufferDataType(entries), offsets);
+  fusion_compressor_->DecompressOut(buffer_data, offsets, scale_factor, entries,
+                                    gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device]);
+}
 
 void GPUAllreduce::MemcpyEntryInFusionBuffer(const std::vector<TensorTableEntry>& entries,
                                              const TensorTableEntry& e, void* buffer_data_at_offset) {
@@ -234,35 +480,22 @@ void GPUAllreduce::MemcpyEntryInFusionBuffer(const std::vector<TensorTableEntry>
                                gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device]);
 }
 
-#if HAVE_CUDA
 void GPUAllreduce::MemcpyOutFusionBuffer(const void* buffer_data, std::vector<TensorTableEntry>& entries) {
-  if (global_state_->batch_d2d_memcopies) {
+  NvtxPhaseRange range(RegisteredNvtxPhase::FusionBufferMemcpyOut,
+                       gpu_op_context_.correlation_id);
+  if (global_state_->parameter_manager.BatchD2DMemcopies()) {
     int64_t offset = 0;
-    int idx = 0;
-    int count = 0;
-
-    BatchedD2DParams d2d_params;
+    std::vector<BatchedD2DCopy> copies;
+    copies.reserve(entries.size());
     auto& first_entry = entries[0];
     for (auto& e : entries) {
-      void* buffer_data_at_offset = (uint8_t*)buffer_data + offset;
-
-      // Set input/output pointers and sizes
-      d2d_params.out[idx % BATCHED_D2D_CAPACITY] = (void*)(e.output->data());
-      d2d_params.in[idx % BATCHED_D2D_CAPACITY] = buffer_data_at_offset;
-      d2d_params.sizes[idx % BATCHED_D2D_CAPACITY] = e.tensor->size();
-
+      copies.push_back({(void*)e.output->data(), (uint8_t*)buffer_data + offset,
+                        (size_t)e.tensor->size()});
       offset += BATCHED_D2D_PADDING * ((e.tensor->size() + BATCHED_D2D_PADDING - 1) / BATCHED_D2D_PADDING);
-      idx++;
-      count++;
-
-      if (idx % BATCHED_D2D_CAPACITY == 0 || idx == (int) entries.size()) {
-        // Perform batched d2d memcpy
-        BatchedD2DMemcpyCudaImpl(d2d_params, count, gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device]);
-        // TODO: https://github.com/horovod/horovod/issues/2230
-        //gpu_context_->ErrorCheck("BatchedD2DMemcpyCudaImpl", cudaGetLastError());
-        count = 0;
-      }
     }
+    BatchedMemcpy(gpu_context_, copies, COPY_OUT_TABLE, 1.0,
+                  first_entry.tensor->dtype(),
+                  gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device]);
 
   } else {
     int64_t offset = 0;
@@ -273,40 +506,25 @@ void GPUAllreduce::MemcpyOutFusionBuffer(const void* buffer_data, std::vector<Te
     }
   }
 }
-#endif
 
-#if HAVE_CUDA
 void GPUAllreduce::ScaleMemcpyOutFusionBuffer(void* buffer_data, size_t buffer_len, double scale_factor,
                                               std::vector<TensorTableEntry>& entries) {
+  NvtxPhaseRange range(RegisteredNvtxPhase::FusionBufferMemcpyOut,
+                       gpu_op_context_.correlation_id);
   auto& first_entry = entries[0];
 
-  if (global_state_->batch_d2d_memcopies) {
+  if (global_state_->parameter_manager.BatchD2DMemcopies()) {
     int64_t offset = 0;
-    int idx = 0;
-    int count = 0;
-
-    BatchedD2DParams d2d_params;
+    std::vector<BatchedD2DCopy> copies;
+    copies.reserve(entries.size());
     for (auto& e : entries) {
-      void* buffer_data_at_offset = (uint8_t*)buffer_data + offset;
-
-      // Set input/output pointers and sizes
-      d2d_params.out[idx % BATCHED_D2D_CAPACITY] = (void*)(e.output->data());
-      d2d_params.in[idx % BATCHED_D2D_CAPACITY] = buffer_data_at_offset;
-      d2d_params.sizes[idx % BATCHED_D2D_CAPACITY] = e.tensor->size();
-
+      copies.push_back({(void*)e.output->data(), (uint8_t*)buffer_data + offset,
+                        (size_t)e.tensor->size()});
       offset += BATCHED_D2D_PADDING * ((e.tensor->size() + BATCHED_D2D_PADDING - 1) / BATCHED_D2D_PADDING);
-      idx++;
-      count++;
-
-      if (idx % BATCHED_D2D_CAPACITY == 0 || idx == (int) entries.size()) {
-        // Perform batched d2d memcpy
-        BatchedScaledD2DMemcpyCudaImpl(d2d_params, count, scale_factor, first_entry.tensor->dtype(),
-                                       gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device]);
-        // TODO: https://github.com/horovod/horovod/issues/2230
-        //gpu_context_->ErrorCheck("BatchedD2DMemcpyCudaImpl", cudaGetLastError());
-        count = 0;
-      }
     }
+    BatchedMemcpy(gpu_context_, copies, COPY_OUT_TABLE, scale_factor,
+                  first_entry.tensor->dtype(),
+                  gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device]);
 
   } else {
     int64_t num_elements = buffer_len / DataType_Size(first_entry.tensor->dtype());
@@ -322,7 +540,6 @@ void GPUAllreduce::ScaleMemcpyOutFusionBuffer(void* buffer_data, size_t buffer_l
     }
   }
 }
-#endif
 
 void GPUAllreduce::MemcpyEntryOutFusionBuffer(const std::vector<TensorTableEntry>& entries,
                                                const void* buffer_data_at_offset, TensorTableEntry& e) {
@@ -333,11 +550,44 @@ void GPUAllreduce::MemcpyEntryOutFusionBuffer(const std::vector<TensorTableEntry
 
 void GPUAllreduce::ScaleBuffer(double scale_factor, const std::vector<TensorTableEntry>& entries,
                                const void* fused_input_data, void* buffer_data, int64_t num_elements) {
+  NvtxPhaseRange range(RegisteredNvtxPhase::ScaleBuffer,
+                       gpu_op_context_.correlation_id);
   gpu_context_->ScaleBufferImpl(fused_input_data, buffer_data, num_elements, scale_factor, entries[0].tensor->dtype(),
                                 gpu_context_->streams[global_state_->current_nccl_stream][entries[0].device]);
 
 }
 
+size_t GPUAllreduce::FusionBufferEntrySize(const TensorTableEntry& e) const {
+  if (global_state_->parameter_manager.BatchD2DMemcopies()) {
+    return BATCHED_D2D_PADDING *
+           ((e.tensor->size() + BATCHED_D2D_PADDING - 1) / BATCHED_D2D_PADDING);
+  }
+  return (size_t)e.tensor->size();
+}
+
+void GPUAllreduce::AdoptOutputs(std::vector<TensorTableEntry>& entries,
+                                void*& buffer_data, size_t& buffer_len) {
+  auto& first_entry = entries[0];
+  buffer_len = 0;
+  for (auto& e : entries) {
+    buffer_len += entries.size() > 1 ? FusionBufferEntrySize(e)
+                                     : (size_t)e.tensor->size();
+  }
+  auto block = gpu_context_->AcquireOutputBlock(
+      buffer_len, first_entry.device, *gpu_op_context_.stream);
+  buffer_data = block->data();
+
+  int64_t offset = 0;
+  for (auto& e : entries) {
+    auto status = e.context->AdoptOutput(e.tensor->shape(), e.tensor->dtype(),
+                                         block, offset, &e.output);
+    if (!status.ok()) {
+      throw std::logic_error(status.reason());
+    }
+    offset += FusionBufferEntrySize(e);
+  }
+}
+
 GPUAllgather::GPUAllgather(GPUContext* context, HorovodGlobalState* global_state)
     : AllgatherOp(global_state), gpu_context_(context), gpu_op_context_(context, global_state) {}
 
@@ -372,6 +622,16 @@ bool GPUBroadcast::Enabled(const ParameterManager& param_manager,
   return entries[0].device != CPU_DEVICE_ID;
 }
 
+GPUGather::GPUGather(GPUContext* context, HorovodGlobalState* global_state)
+    : GatherOp(global_state), gpu_context_(context),
+      gpu_op_context_(context, global_state) {}
+
+bool GPUGather::Enabled(const ParameterManager& param_manager,
+                        const std::vector<TensorTableEntry>& entries,
+                        const Response& response) const {
+  return entries[0].device != CPU_DEVICE_ID;
+}
+
 GPUAlltoall::GPUAlltoall(GPUContext* context,
 		         HorovodGlobalState* global_state)
     : AlltoallOp(global_state), gpu_context_(context), gpu_op_context_(context, global_state) {}
@@ -382,5 +642,50 @@ bool GPUAlltoall::Enabled(const ParameterManager& param_manager,
   return entries[0].device != CPU_DEVICE_ID;
 }
 
+void GPUAlltoall::MemcpyEntryInFusionBuffer(const TensorTableEntry& e,
+                                            const void* entry_data_at_offset,
+                                            size_t size,
+                                            void* buffer_data_at_offset) {
+  gpu_context_->MemcpyAsyncD2D(buffer_data_at_offset, entry_data_at_offset, size,
+                               gpu_context_->streams[global_state_->current_nccl_stream][e.device]);
+}
+
+void GPUAlltoall::MemcpyEntryOutFusionBuffer(const void* buffer_data_at_offset,
+                                             size_t size, TensorTableEntry& e,
+                                             void* output_data_at_offset) {
+  gpu_context_->MemcpyAsyncD2D(output_data_at_offset, buffer_data_at_offset, size,
+                               gpu_context_->streams[global_state_->current_nccl_stream][e.device]);
+}
+
+GPUReducescatter::GPUReducescatter(GPUContext* context,
+                                   HorovodGlobalState* global_state)
+    : ReducescatterOp(global_state), gpu_context_(context), gpu_op_context_(context, global_state) {}
+
+bool GPUReducescatter::Enabled(const ParameterManager& param_manager,
+                               const std::vector<TensorTableEntry>& entries,
+                               const Response& response) const {
+  return entries[0].device != CPU_DEVICE_ID;
+}
+
+void GPUReducescatter::MemcpyEntryInFusionBuffer(const TensorTableEntry& e, int64_t entry_offset,
+                                                 size_t entry_size, void* buffer_data_at_offset) {
+  gpu_context_->MemcpyAsyncD2D(buffer_data_at_offset, (int8_t*)e.tensor->data() + entry_offset, entry_size,
+                               gpu_context_->streams[global_state_->current_nccl_stream][e.device]);
+}
+
+void GPUReducescatter::MemcpyEntryOutFusionBuffer(const void* buffer_data_at_offset,
+                                                  TensorTableEntry& e) {
+  gpu_context_->MemcpyAsyncD2D((void*) e.output->data(), buffer_data_at_offset, (size_t) e.output->size(),
+                               gpu_context_->streams[global_state_->current_nccl_stream][e.device]);
+}
+
+void GPUReducescatter::ScaleBuffer(double scale_factor, const std::vector<TensorTableEntry>& entries,
+                                   const void* fused_input_data, void* buffer_data, int64_t num_elements) {
+  NvtxPhaseRange range(RegisteredNvtxPhase::ScaleBuffer,
+                       gpu_op_context_.correlation_id);
+  gpu_context_->ScaleBufferImpl(fused_input_data, buffer_data, num_elements, scale_factor, entries[0].tensor->dtype(),
+                                gpu_context_->streams[global_state_->current_nccl_stream][entries[0].device]);
+}
+
 } // namespace common
 } // namespace horovod
@@ -18,7 +18,15 @@
 #ifndef HOROVOD_GPU_OPERATIONS_H
 #define HOROVOD_GPU_OPERATIONS_H
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <queue>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -41,12 +49,87 @@ using gpuStream_t = hipStream_t;
 namespace horovod {
 namespace common {
 
+class GPUFusionCompressor;
+class GPUOutputBlock;
+
+// Events recorded on a GPU stream in order, each with the timeline activity
+// it ends: one of the phase names such as NCCL_ALLREDUCE, or "" for none.
+// Holds the few events of an operation without allocating.
+class GPUEventQueue {
+public:
+  bool empty() const { return head_ == size_; }
+
+  void push(const char* phase, const Event& event) {
+    if (size_ < INLINE_CAPACITY) {
+      inline_[size_] = std::make_pair(phase, event);
+    } else {
+      spilled_.emplace_back(phase, event);
+    }
+    ++size_;
+  }
+
+  const std::pair<const char*, Event>& front() const {
+    return head_ < INLINE_CAPACITY ? inline_[head_]
+                                   : spilled_[head_ - INLINE_CAPACITY];
+  }
+
+  void pop() {
+    if (++head_ == size_) {
+      clear();
+    }
+  }
+
+  void clear() {
+    head_ = 0;
+    size_ = 0;
+    spilled_.clear();
+  }
+
+private:
+  static constexpr size_t INLINE_CAPACITY = 8;
+  std::array<std::pair<const char*, Event>, INLINE_CAPACITY> inline_;
+  std::vector<std::pair<const char*, Event>> spilled_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+// Work left to do once all events recorded for a response have completed.
+struct GPUCompletion {
+  GPUEventQueue event_queue;
+  std::vector<TensorTableEntry> entries;
+  std::function<void()> error_check_callback;
+  Timeline* timeline = nullptr;
+  int device = CPU_DEVICE_ID;
+  bool elastic = false;
+
+  // Released once the response has completed.
+  void* host_buffer = nullptr;
+  bool host_buffer_pinned = false;
+  std::shared_ptr<PersistentBuffer> fusion_buffer;
+
+  // Whether the timeline activity of the first event has been started.
+  bool activity_started = false;
+
+  // Payload of the NVTX range around the finalization of the entries.
+  int64_t correlation_id = -1;
+};
+
 class GPUContext {
 public:
   GPUContext();
   ~GPUContext();
 
-  void Finalize();
+  // Stops the finalizer and completion threads. The pooled host and device
+  // buffers are freed unless they are kept for the next initialization.
+  void Finalize(bool keep_buffers = false);
+
+  // Adds the page-locked host buffers, the unused output blocks and the
+  // device tables to usage.
+  void AddMemoryUsage(MemoryUsage& usage);
+
+  // Frees the unused pooled host buffers and output blocks, and the device
+  // tables. Buffers in use return to the pool as before.
+  void ReleaseBuffers();
 
   // The GPU stream used for data transfers and within-allreduce operations.
   // A naive implementation would use the TensorFlow StreamExecutor GPU
@@ -66,26 +149,41 @@ public:
 
   void ErrorCheck(std::string op_name, gpuError_t gpu_result);
 
-  void RecordEvent(std::queue<std::pair<std::string, Event>>& event_queue, std::string name,
+  // Events come from a ring per device and stream, and are recorded again
+  // once the ring wraps around. Whoever still waits for the previous record
+  // then at most waits for later work on the same stream, so events are
+  // never released.
+  void RecordEvent(GPUEventQueue& event_queue, const char* phase,
                    gpuStream_t& stream);
 
   Event RecordEvent(gpuStream_t& stream);
 
-  void ReleaseEvent(Event event);
-
-  void WaitForEvents(std::queue<std::pair<std::string, Event>>& event_queue,
+  void WaitForEvents(GPUEventQueue& event_queue,
                      const std::vector<TensorTableEntry>& entries, Timeline& timeline,
                      const std::function<void()>& error_check_callback = nullptr,
                      bool elastic = false);
 
-  void ClearEvents(std::queue<std::pair<std::string, Event>>& event_queue,
+  void ClearEvents(GPUEventQueue& event_queue,
                    const std::vector<TensorTableEntry>& entries, Timeline& timeline,
                    const std::function<void()>& error_check_callback = nullptr,
                    bool elastic = false);
 
+  // Creates a non-blocking stream with stream_priority.
   void StreamCreate(gpuStream_t *stream);
+
+  // Makes device current and returns Horovod's stream stream_id on it,
+  // created on first use.
+  gpuStream_t GetStream(int stream_id, int device);
   void StreamSynchronize(gpuStream_t stream);
 
+  // Names the stream in profilers with NVTX support, so that the work of
+  // every stream shows up on its own track.
+  void StreamSetName(gpuStream_t stream, const std::string& name);
+
+  // Returns a new ID that links the NVTX phase ranges of an operation to
+  // its timeline activities.
+  int64_t NextCorrelationId() { return ++last_correlation_id_; }
+
   int GetDevice();
 
   void SetDevice(int device);
@@ -97,12 +195,194 @@ public:
   void ScaleBufferImpl(const void* fused_input_data, void* buffer_data, int64_t num_elements,
                        double scale_factor, DataType dtype, gpuStream_t stream);
 
+  // buffer += scale_factor * input
+  void ScaledAddBufferImpl(const void* input_data, void* buffer_data, int64_t num_elements,
+                           double scale_factor, DataType dtype, gpuStream_t stream);
+
+  // buffer = scale_factor * input, converted from in_dtype to out_dtype, one
+  // of them float32 and the other float16 or bfloat16.
+  void ScaledCastBufferImpl(const void* input_data, void* buffer_data, int64_t num_elements,
+                            double scale_factor, DataType in_dtype, DataType out_dtype,
+                            gpuStream_t stream);
+
+  bool EventCompleted(const Event& event);
+
+  // Returns a page-locked host buffer of at least size bytes. Buffers are
+  // pooled, as allocating page-locked memory is much slower than malloc.
+  void* AcquireHostBuffer(size_t size);
+
+  // Priority of the streams StreamCreate() creates, clamped to the range of
+  // the device. Lower is higher, the default is the highest one, so that
+  // communication is not held up behind compute kernels. 0 is the priority
+  // of default streams.
+  int stream_priority = std::numeric_limits<int>::min();
+
+  // NUMA node AcquireHostBuffer() places new buffers on, -1 for wherever the
+  // calling thread runs.
+  int host_buffer_numa_node = -1;
+
+  // Returns a buffer from AcquireHostBuffer() to the pool. Safe to call from
+  // the finalizer threads.
+  void ReleaseHostBuffer(void* buffer);
+
+  // Returns device memory of at least size bytes on the current device,
+  // pooled like the host buffers. Before handing out reused memory, stream
+  // is made to wait for the last release recorded on the block. The memory
+  // returns to the pool once the block is gone.
+  std::shared_ptr<OutputBlock> AcquireOutputBlock(size_t size, int device,
+                                                  gpuStream_t stream);
+
+  // Whether fusion and staging buffers come from AllocatePooled() rather
+  // than from the framework.
+  bool memory_pool = false;
+
+  // Returns a buffer of size bytes on the current device, allocated from a
+  // memory pool of Horovod's own in order with the work on stream. Once the
+  // buffer is gone, its memory returns to the pool after the work queued on
+  // stream by then, without waiting for it.
+  std::shared_ptr<PersistentBuffer> AllocatePooled(size_t size,
+                                                   gpuStream_t stream);
+
+  // Returns a copy of the bytes bytes at data in memory of the current
+  // device, for kernels queued on stream afterwards. There is one table per
+  // device, stream and slot, which is only uploaded again when its contents
+  // change, e.g. not while a cached response fuses the same tensors.
+  const void* UploadTable(const void* data, size_t bytes, int slot,
+                          gpuStream_t stream);
+
   // Thread pool for finalizer threads
   ThreadPool finalizer_thread_pool;
 
+  // Starts a single thread that polls the events of all outstanding
+  // completions in one loop, as an alternative to finalizer_thread_pool.
+  void StartCompletionEngine();
+
+  // Hands a completion to the thread started by StartCompletionEngine().
+  void EnqueueCompletion(GPUCompletion&& completion);
+
 private:
+  void CompletionLoop();
+
+  // Retires the completed events of completion. Returns true once all of
+  // them have completed and the entries have been finished.
+  bool ProgressCompletion(GPUCompletion& completion);
+
   class impl;
   std::unique_ptr<impl> pimpl;
+
+  std::thread completion_thread_;
+  std::vector<GPUCompletion> new_completions_;
+  std::mutex completion_mutex_;
+  std::condition_variable completion_cond_;
+  bool completion_engine_running_ = false;
+
+  std::atomic<int64_t> last_correlation_id_{0};
+
+  // Returns the next event of the ring of the current device and stream.
+  // Lock-free once the ring exists.
+  Event NextEvent(gpuStream_t stream);
+
+  static constexpr uint32_t EVENT_RING_SIZE = 512;
+  static constexpr int MAX_EVENT_RINGS = 256;
+
+  struct EventRing {
+    int device;
+    gpuStream_t stream;
+    std::array<gpuEvent_t, EVENT_RING_SIZE> events;
+    std::atomic<uint32_t> next{0};
+  };
+
+  // The first num_event_rings_ entries are set and never change again.
+  std::array<std::unique_ptr<EventRing>, MAX_EVENT_RINGS> event_rings_;
+  std::atomic<int> num_event_rings_{0};
+  std::mutex event_rings_mutex_;
+
+  // Unused page-locked host buffers, keyed by capacity.
+  std::multimap<size_t, void*> free_host_buffers_;
+  // Capacity of every buffer handed out by AcquireHostBuffer().
+  std::unordered_map<void*, size_t> host_buffer_sizes_;
+  size_t free_host_buffer_bytes_ = 0;
+  std::mutex host_buffers_mutex_;
+
+  static constexpr size_t MIN_HOST_BUFFER_SIZE = 1 << 20;
+  static constexpr size_t MAX_FREE_HOST_BUFFER_BYTES = (size_t)1 << 30;
+
+  struct DeviceBuffer {
+    void* data = nullptr;
+    size_t capacity = 0;
+    int device = CPU_DEVICE_ID;
+    // Recorded after the last reader of the previous outputs.
+    gpuEvent_t release_event = nullptr;
+    bool release_recorded = false;
+  };
+
+  friend class GPUOutputBlock;
+  friend class GPUPooledBuffer;
+
+  // Returns the buffer of a block that is gone to the pool. Safe to call
+  // from any thread.
+  void ReleaseDeviceBuffer(DeviceBuffer buffer);
+
+  // Unused device buffers of AcquireOutputBlock(), keyed by device and
+  // capacity.
+  std::multimap<std::pair<int, size_t>, DeviceBuffer> free_device_buffers_;
+  size_t free_device_buffer_bytes_ = 0;
+  std::mutex device_buffers_mutex_;
+
+  struct DeviceTable {
+    std::vector<uint8_t> contents;
+    void* data = nullptr;
+    size_t capacity = 0;
+  };
+
+  // Tables of UploadTable(), keyed by device, stream and slot.
+  std::map<std::tuple<int, gpuStream_t, int>, DeviceTable> device_tables_;
+  std::mutex device_tables_mutex_;
+
+  static constexpr size_t MIN_DEVICE_BUFFER_SIZE = 1 << 16;
+  static constexpr size_t MAX_FREE_DEVICE_BUFFER_BYTES = (size_t)1 << 30;
+};
+
+// Sums the contributions to an allreduce over several backward passes in
+// device memory owned by Horovod, so that only the last pass communicates.
+// Sums are keyed by the name of the allreduce. Called from framework threads.
+class GPUAccumulator {
+public:
+  explicit GPUAccumulator(GPUContext* gpu_context)
+      : gpu_context_(gpu_context) {}
+
+  // Adds tensor to the sum of name on a stream of the device, after the
+  // events of ready_event_list. event completes once tensor has been read.
+  Status Add(const std::string& name, const Tensor& tensor, int device,
+             ReadyEventList& ready_event_list, Event& event);
+
+  // Hands out the sum of name as the input of its allreduce, ready once the
+  // last addition is done. The sum is left alone until Release().
+  Status Take(const std::string& name, std::shared_ptr<Tensor>& sum,
+              std::shared_ptr<ReadyEvent>& ready_event);
+
+  // Starts a new sum of name, written to once release_event, if any, has
+  // completed.
+  void Release(const std::string& name, const Event& release_event);
+
+  void Reset();
+
+private:
+  struct Sum {
+    std::shared_ptr<OutputBlock> block;
+    DataType dtype = HOROVOD_FLOAT32;
+    TensorShape shape;
+    int device = CPU_DEVICE_ID;
+    bool empty = true;
+    bool taken = false;
+    Event last_add;
+    Event release_event;
+  };
+
+  GPUContext* gpu_context_;
+  std::unordered_map<std::string, Sum> sums_;
+  std::unordered_map<int, gpuStream_t> streams_;
+  std::mutex mutex_;
 };
 
 class GPUOpContext {
@@ -114,6 +394,15 @@ public:
 
   void InitGPUQueue(const std::vector<TensorTableEntry>& entries, const Response& response);
 
+  // Makes the stream wait for the ready events of the entries, instead of
+  // blocking the calling thread until they have completed. With the timeline
+  // enabled, the wait is recorded as WAIT_FOR_DATA from the event queue.
+  // Must be called after InitGPUQueue.
+  void WaitForData(std::vector<TensorTableEntry>& entries);
+
+  // If free_host_buffer is set, host_buffer is released once the queue has
+  // finished, either back to the pinned pool (see host_buffer_pinned) or with
+  // free().
   Status FinalizeGPUQueue(std::vector<TensorTableEntry>& entries, bool free_host_buffer = true,
                           const std::function<void()>& error_check_callback = nullptr);
 
@@ -126,11 +415,17 @@ public:
   //
   // For more information of CUDA Events, see:
   // https://devblogs.nvidia.com/how-implement-performance-metrics-cuda-cc/
-  std::queue<std::pair<std::string, Event>> event_queue;
+  GPUEventQueue event_queue;
 
   gpuStream_t* stream;
   void* host_buffer = nullptr;
 
+  // Whether host_buffer was taken from GPUContext::AcquireHostBuffer().
+  bool host_buffer_pinned = false;
+
+  // Set by InitGPUQueue, see GPUContext::NextCorrelationId().
+  int64_t correlation_id = -1;
+
 private:
   GPUContext* gpu_context_;
   HorovodGlobalState* global_state_;
@@ -146,7 +441,6 @@ public:
                const Response& response) const override;
 
 protected:
-#if HAVE_CUDA
   void MemcpyInFusionBuffer(const std::vector<TensorTableEntry>& entries, const void*& fused_input_data,
                             void*& buffer_data, size_t& buffer_len) override;
 
@@ -154,9 +448,28 @@ protected:
 
   void ScaleMemcpyInFusionBuffer(const std::vector<TensorTableEntry>& entries, const void*& fused_input_data,
                                  void*& buffer_data, size_t& buffer_len, double scale_factor);
+  // Like ScaleMemcpyInFusionBuffer, but into buffer_data laid out like the
+  // fusion buffer, see AdoptOutputs.
+  void ScaleMemcpyInBuffer(const std::vector<TensorTableEntry>& entries, void* buffer_data,
+                           size_t& buffer_len, double scale_factor);
   void ScaleMemcpyOutFusionBuffer(void* buffer_data, size_t buffer_len, double scale_factor,
                                   std::vector<TensorTableEntry>& entries);
-#endif
+
+  // Returns the data type of the fusion buffer contents, which differs from the
+  // type of the entries if fusion_compressor_ applies to them.
+  DataType FusionBufferDataType(const std::vector<TensorTableEntry>& entries) const;
+
+  // Whether fusion_compressor_ applies to entries and keeps state for them.
+  bool StatefulFusionCompression(const std::vector<TensorTableEntry>& entries) const;
+
+  // Like ScaleMemcpyInFusionBuffer/ScaleMemcpyOutFusionBuffer, but compressing
+  // the entries to and from the data type returned by FusionBufferDataType
+  // with fusion_compressor_ in the same pass. buffer_len is in bytes of the
+  // fusion buffer data type.
+  void CompressMemcpyInFusionBuffer(const std::vector<TensorTableEntry>& entries, const void*& fused_input_data,
+                                    void*& buffer_data, size_t& buffer_len, double scale_factor);
+  void DecompressMemcpyOutFusionBuffer(const void* buffer_data, double scale_factor,
+                                       std::vector<TensorTableEntry>& entries);
 
   void MemcpyEntryInFusionBuffer(const std::vector<TensorTableEntry>& entries,
                                  const TensorTableEntry& e, void* buffer_data_at_offset) override;
@@ -167,9 +480,23 @@ protected:
   void ScaleBuffer(double scale_factor, const std::vector<TensorTableEntry>& entries,
                    const void* fused_input_data, void* buffer_data, int64_t num_elements);
 
+  // Points the outputs of entries enqueued without one into a pooled device
+  // block, laid out like the fusion buffer if there are several, so that a
+  // fused allreduce writes its results in place instead of copying them out
+  // of the fusion buffer. Returns the block data and the length of the
+  // layout in bytes.
+  void AdoptOutputs(std::vector<TensorTableEntry>& entries, void*& buffer_data,
+                    size_t& buffer_len);
+
+  // Bytes taken by the entry in the fusion buffer layout.
+  size_t FusionBufferEntrySize(const TensorTableEntry& e) const;
+
   GPUContext* gpu_context_;
   GPUOpContext gpu_op_context_;
 
+  // Compressor of fused entries selected by HOROVOD_FUSION_COMPRESSION,
+  // nullptr if there is none.
+  std::shared_ptr<GPUFusionCompressor> fusion_compressor_;
 };
 
 class GPUAllgather : public AllgatherOp {
@@ -207,6 +534,19 @@ protected:
   GPUOpContext gpu_op_context_;
 };
 
+class GPUGather : public GatherOp {
+public:
+  GPUGather(GPUContext* context, HorovodGlobalState* global_state);
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+
+protected:
+  struct GPUContext* gpu_context_;
+  GPUOpContext gpu_op_context_;
+};
+
 class GPUAlltoall : public AlltoallOp {
 public:
   GPUAlltoall(GPUContext* context,
@@ -215,6 +555,37 @@ public:
                const std::vector<TensorTableEntry>& entries,
                const Response& response) const override;
 protected:
+  void MemcpyEntryInFusionBuffer(const TensorTableEntry& e,
+                                 const void* entry_data_at_offset, size_t size,
+                                 void* buffer_data_at_offset) override;
+
+  void MemcpyEntryOutFusionBuffer(const void* buffer_data_at_offset,
+                                  size_t size, TensorTableEntry& e,
+                                  void* output_data_at_offset) override;
+
+  GPUContext* gpu_context_;
+  GPUOpContext gpu_op_context_;
+};
+
+class GPUReducescatter : public ReducescatterOp {
+public:
+  GPUReducescatter(GPUContext* context,
+                   HorovodGlobalState* global_state);
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+
+protected:
+  void MemcpyEntryInFusionBuffer(const TensorTableEntry& e, int64_t entry_offset,
+                                 size_t entry_size, void* buffer_data_at_offset) override;
+
+  void MemcpyEntryOutFusionBuffer(const void* buffer_data_at_offset,
+                                  TensorTableEntry& e) override;
+
+  void ScaleBuffer(double scale_factor, const std::vector<TensorTableEntry>& entries,
+                   const void* fused_input_data, void* buffer_data, int64_t num_elements) override;
+
   GPUContext* gpu_context_;
   GPUOpContext gpu_op_context_;
 };
@@ -15,8 +15,11 @@
 // =============================================================================
 
 #include "gpu_operations.h"
+#include "rocm/hip_kernels.h"
 #include "../message.h"
+#include "../topology.h"
 
+#include <algorithm>
 #include <thread>
 
 namespace horovod {
@@ -24,74 +27,28 @@ namespace common {
 
 class GPUContext::impl {
 public:
-  hipError_t GetGpuEvent(hipEvent_t* event) {
-    int device;
-    auto status = hipGetDevice(&device);
-    if (status != hipSuccess) {
-      return status;
-    }
-
-    auto& mutex = hip_events_mutex;
-    {
-      std::lock_guard<std::mutex> guard(mutex);
-      auto& queue = hip_events[device];
-      if (!queue.empty()) {
-        *event = queue.front();
-        queue.pop();
-        return hipSuccess;
-      }
-    }
-
-    return hipEventCreateWithFlags(event, hipEventDisableTiming);
-  }
-
-  hipError_t ReleaseGpuEvent(hipEvent_t event) {
-    int device;
-    auto status = hipGetDevice(&device);
-    if (status != hipSuccess) {
-      return status;
-    }
-
-    auto& mutex = hip_events_mutex;
-    {
-      std::lock_guard<std::mutex> guard(mutex);
-      auto& queue = hip_events[device];
-      queue.push(event);
-    }
-
-    return hipSuccess;
-  }
-
   void ErrorCheck(std::string op_name, hipError_t hip_result) {
     if (hip_result != hipSuccess) {
       throw std::logic_error(std::string(op_name) + " failed: " + hipGetErrorString(hip_result));
     }
   }
 
-  void RecordEvent(std::queue<std::pair<std::string, hipEvent_t>>& event_queue, std::string name, hipStream_t& stream) {
-    hipEvent_t event;
-    ErrorCheck("GetGpuEvent", GetGpuEvent(&event));
-    ErrorCheck("hipEventRecord", hipEventRecord(event, stream));
-    event_queue.emplace(name, event);
-  }
-
-  void WaitForEvents(std::queue<std::pair<std::string, hipEvent_t>>& event_queue,
+  void WaitForEvents(GPUEventQueue& event_queue,
       const std::vector<TensorTableEntry>& entries, Timeline& timeline,
       const std::function<void()>& error_check_callback,
       bool elastic) {
     while (!event_queue.empty()) {
-      std::string name;
-      hipEvent_t event;
-      std::tie(name, event) = event_queue.front();
+      const char* phase = event_queue.front().first;
+      Event event = event_queue.front().second;
       event_queue.pop();
-      if (name != "") {
-        timeline.ActivityStartAll(entries, name);
+      if (phase[0] != '\0') {
+        timeline.ActivityStartAll(entries, phase);
       }
 
       // Check for async (networking) errors while waiting for the event to complete
       hipError_t hip_result;
       while (true) {
-        hip_result = hipEventQuery(event);
+        hip_result = hipEventQuery(*(event.event));
         if (hip_result == hipSuccess) {
           break;
         }
@@ -106,21 +63,46 @@ public:
         std::this_thread::yield();
       }
 
-      if (name != "") {
+      if (phase[0] != '\0') {
         timeline.ActivityEndAll(entries);
       }
-      ErrorCheck("ReleaseGpuEvent", ReleaseGpuEvent(event));
     }
   }
 
-  void StreamCreate(hipStream_t *stream) {
-    int greatest_priority;
+  void ClearEvents(GPUEventQueue& event_queue,
+      const std::vector<TensorTableEntry>& entries, Timeline& timeline,
+      const std::function<void()>& error_check_callback,
+      bool elastic) {
+    while (!event_queue.empty()) {
+      const char* phase = event_queue.front().first;
+      event_queue.pop();
+      if (phase[0] != '\0') {
+        timeline.ActivityStartAll(entries, phase);
+        timeline.ActivityEndAll(entries);
+      }
+    }
+  }
+
+  bool EventCompleted(Event event) {
+    hipError_t hip_result = hipEventQuery(*(event.event));
+    if (hip_result == hipErrorNotReady) {
+      return false;
+    }
+    ErrorCheck("hipEventQuery", hip_result);
+    return true;
+  }
+
+  void StreamCreate(hipStream_t *stream, int priority) {
+    int least_priority, greatest_priority;
     ErrorCheck("hipDeviceGetStreamPriorityRange",
-        hipDeviceGetStreamPriorityRange(NULL, &greatest_priority));
+        hipDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+    priority = std::min(std::max(priority, greatest_priority), least_priority);
     ErrorCheck("hipStreamCreateWithPriority",
-        hipStreamCreateWithPriority(stream, hipStreamNonBlocking, greatest_priority));
+        hipStreamCreateWithPriority(stream, hipStreamNonBlocking, priority));
   }
 
+  void StreamSetName(hipStream_t stream, const std::string& name) {}
+
   void StreamSynchronize(hipStream_t stream) {
     ErrorCheck("hipStreamSynchronize", hipStreamSynchronize(stream));
   }
@@ -147,15 +129,71 @@ public:
     ErrorCheck("hipMemcpyAsync", hipMemcpyAsync(dst, src, count, hipMemcpyDeviceToHost, stream));
   }
 
+  void* HostAlloc(size_t size) {
+    void* buffer;
+    ErrorCheck("hipHostMalloc", hipHostMalloc(&buffer, size, hipHostMallocDefault));
+    return buffer;
+  }
+
+  void HostFree(void* buffer) {
+    ErrorCheck("hipHostFree", hipHostFree(buffer));
+  }
+
+  void* DeviceAlloc(size_t size) {
+    void* buffer;
+    ErrorCheck("hipMalloc", hipMalloc(&buffer, size));
+    return buffer;
+  }
+
+  void DeviceFree(void* buffer) {
+    ErrorCheck("hipFree", hipFree(buffer));
+  }
+
+  // Stream-ordered allocation of the CUDA build. HIP memory pools are not
+  // used yet, so this allocates right away.
+  void* DeviceAllocAsync(size_t size, hipStream_t stream) {
+    return DeviceAlloc(size);
+  }
+
+  void DeviceFreeAsync(void* buffer, hipStream_t stream) {
+    ErrorCheck("hipStreamSynchronize", hipStreamSynchronize(stream));
+    DeviceFree(buffer);
+  }
+
+  hipEvent_t EventCreate() {
+    hipEvent_t event;
+    ErrorCheck("hipEventCreateWithFlags", hipEventCreateWithFlags(&event, hipEventDisableTiming));
+    return event;
+  }
+
+  void EventDestroy(hipEvent_t event) {
+    ErrorCheck("hipEventDestroy", hipEventDestroy(event));
+  }
+
+  void EventRecord(hipEvent_t event, hipStream_t stream) {
+    ErrorCheck("hipEventRecord", hipEventRecord(event, stream));
+  }
+
+  void StreamWaitEvent(hipStream_t stream, hipEvent_t event) {
+    ErrorCheck("hipStreamWaitEvent", hipStreamWaitEvent(stream, event, 0));
+  }
+
   void ScaleBufferImpl(const void* fused_input_data, void* buffer_data, int64_t num_elements,
-                   double scale_factor, DataType dtype, hipStream_t stream) {
-    throw std::logic_error("ScaleBuffer not implemented for AMD GPUs.");
+                       double scale_factor, DataType dtype, hipStream_t stream) {
+    ScaleBufferROCmImpl(fused_input_data, buffer_data, num_elements, scale_factor, dtype, stream);
+  }
+
+  void ScaledAddBufferImpl(const void* input_data, void* buffer_data, int64_t num_elements,
+                           double scale_factor, DataType dtype, hipStream_t stream) {
+    ScaledAddBufferROCmImpl(input_data, buffer_data, num_elements, scale_factor, dtype, stream);
+  }
+
+  void ScaledCastBufferImpl(const void* input_data, void* buffer_data, int64_t num_elements,
+                            double scale_factor, DataType in_dtype, DataType out_dtype,
+                            hipStream_t stream) {
+    ScaledCastBufferROCmImpl(input_data, buffer_data, num_elements, scale_factor, in_dtype, out_dtype, stream);
   }
 
-private:
-  // We reuse HIP events as it appears that their creation carries non-zero cost.
-  std::unordered_map<int, std::queue<hipEvent_t>> hip_events;
-  std::mutex hip_events_mutex;
 };
 
 #include "gpu_context_impl.cc"
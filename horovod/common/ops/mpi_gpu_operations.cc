@@ -18,6 +18,8 @@
 #include "mpi_gpu_operations.h"
 #include "../mpi/mpi_context.h"
 
+#include <algorithm>
+
 namespace horovod {
 namespace common {
 
@@ -35,6 +37,11 @@ Status MPI_GPUAllreduce::Execute(std::vector<TensorTableEntry>& entries, const R
 
   WaitForData(entries);
 
+  if (global_state_->mpi_gpu_allreduce_chunk_size > 0) {
+    PipelinedAllreduce(entries, response);
+    return Status::OK();
+  }
+
   const void* fused_input_data;
   void* buffer_data;
   size_t buffer_len;
@@ -69,7 +76,8 @@ Status MPI_GPUAllreduce::Execute(std::vector<TensorTableEntry>& entries, const R
   int op =
       MPI_Allreduce(sendbuf, buffer_data, (int)num_elements,
                     mpi_context.GetMPIDataType(first_entry.tensor),
-                    mpi_context.GetMPISumOp(first_entry.tensor->dtype()),
+                    mpi_context.GetMPIOp(first_entry.tensor->dtype(),
+                                         response.reduce_op()),
                     mpi_context.GetMPICommunicator(Communicator::GLOBAL));
   if (op != MPI_SUCCESS) {
     throw std::runtime_error("MPI_Allreduce failed, see MPI output for details.");
@@ -94,6 +102,161 @@ Status MPI_GPUAllreduce::Execute(std::vector<TensorTableEntry>& entries, const R
   return Status::OK();
 }
 
+void MPI_GPUAllreduce::PipelinedAllreduce(std::vector<TensorTableEntry>& entries,
+                                          const Response& response) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  const auto& mpi_context = process_set.mpi_context;
+  auto& timeline = global_state_->timeline;
+  auto& stream =
+      gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device];
+
+  bool fused = entries.size() > 1;
+  const void* input_data = first_entry.tensor->data();
+  void* buffer_data = (void*)first_entry.output->data();
+  size_t buffer_len = (size_t)first_entry.output->size();
+  if (fused) {
+    auto buffer = process_set.fusion_buffer.GetBuffer(
+        first_entry.device, first_entry.context->framework(),
+        global_state_->current_nccl_stream);
+    buffer_data = const_cast<void*>(buffer->AccessData(first_entry.context));
+    buffer_len = 0;
+    for (auto& e : entries) {
+      buffer_len += (size_t)e.tensor->size();
+    }
+    input_data = buffer_data;
+  }
+
+  int element_size = mpi_context.GetMPITypeSize(first_entry.tensor->dtype());
+  int64_t num_elements = (int64_t)buffer_len / element_size;
+  int64_t chunk_elements = std::max(
+      global_state_->mpi_gpu_allreduce_chunk_size / element_size, (int64_t)1);
+  int64_t num_chunks = (num_elements + chunk_elements - 1) / chunk_elements;
+  auto chunk_begin = [&](int64_t i) {
+    return (size_t)(i * chunk_elements) * element_size;
+  };
+  auto chunk_end = [&](int64_t i) {
+    return (size_t)std::min((i + 1) * chunk_elements, num_elements) *
+           element_size;
+  };
+
+  // Queue the copies and prescaling of all chunks up front, with an event
+  // after each chunk to tell when it can be reduced.
+  timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+  std::vector<Event> chunk_events;
+  chunk_events.reserve(num_chunks);
+  for (int64_t i = 0; i < num_chunks; ++i) {
+    size_t begin = chunk_begin(i);
+    size_t end = chunk_end(i);
+    if (fused) {
+      MemcpyChunk(entries, buffer_data, begin, end, true, stream);
+    }
+    if (response.prescale_factor() != 1.0) {
+      // Unfused chunks are scaled out of place into the output
+      ScaleBuffer(response.prescale_factor(), entries,
+                  (const uint8_t*)input_data + begin,
+                  (uint8_t*)buffer_data + begin,
+                  (int64_t)(end - begin) / element_size);
+    }
+    chunk_events.push_back(gpu_context_->RecordEvent(stream));
+  }
+  timeline.ActivityEndAll(entries);
+
+  const void* sendbuf = input_data;
+  if (fused || response.prescale_factor() != 1.0) {
+    sendbuf = buffer_data;
+  }
+
+  // Chunks reduced so far get postscaled and copied out on the stream,
+  // while the later ones are still being reduced.
+  std::vector<MPI_Request> requests(num_chunks, MPI_REQUEST_NULL);
+  int64_t next_done = 0;
+  auto finish_chunk = [&](int64_t i) {
+    size_t begin = chunk_begin(i);
+    size_t end = chunk_end(i);
+    if (response.postscale_factor() != 1.0) {
+      ScaleBuffer(response.postscale_factor(), entries,
+                  (uint8_t*)buffer_data + begin, (uint8_t*)buffer_data + begin,
+                  (int64_t)(end - begin) / element_size);
+    }
+    if (fused) {
+      MemcpyChunk(entries, buffer_data, begin, end, false, stream);
+    }
+  };
+
+  timeline.ActivityStartAll(entries, MPI_ALLREDUCE);
+  for (int64_t i = 0; i < num_chunks; ++i) {
+    GPUEventQueue chunk_queue;
+    chunk_queue.push("", chunk_events[i]);
+    gpu_context_->WaitForEvents(chunk_queue, entries, timeline, nullptr,
+                                global_state_->elastic_enabled);
+
+    size_t begin = chunk_begin(i);
+    const void* chunk_sendbuf = sendbuf == buffer_data
+                                    ? MPI_IN_PLACE
+                                    : (const uint8_t*)sendbuf + begin;
+    int op = MPI_Iallreduce(
+        chunk_sendbuf, (uint8_t*)buffer_data + begin,
+        (int)((chunk_end(i) - begin) / element_size),
+        mpi_context.GetMPIDataType(first_entry.tensor),
+        mpi_context.GetMPIOp(first_entry.tensor->dtype(), response.reduce_op()),
+        mpi_context.GetMPICommunicator(Communicator::GLOBAL), &requests[i]);
+    if (op != MPI_SUCCESS) {
+      throw std::runtime_error("MPI_Iallreduce failed, see MPI output for details.");
+    }
+
+    // Progress the outstanding requests and retire the ones done in order.
+    while (next_done <= i) {
+      int done = 0;
+      if (MPI_Test(&requests[next_done], &done, MPI_STATUS_IGNORE) !=
+          MPI_SUCCESS) {
+        throw std::runtime_error("MPI_Test failed, see MPI output for details.");
+      }
+      if (!done) {
+        break;
+      }
+      finish_chunk(next_done++);
+    }
+  }
+  for (; next_done < num_chunks; ++next_done) {
+    if (MPI_Wait(&requests[next_done], MPI_STATUS_IGNORE) != MPI_SUCCESS) {
+      throw std::runtime_error("MPI_Wait failed, see MPI output for details.");
+    }
+    finish_chunk(next_done);
+  }
+
+  // The outputs are read as soon as this returns.
+  gpu_context_->StreamSynchronize(stream);
+  timeline.ActivityEndAll(entries);
+}
+
+void MPI_GPUAllreduce::MemcpyChunk(std::vector<TensorTableEntry>& entries,
+                                   void* buffer, size_t begin, size_t end,
+                                   bool in, gpuStream_t stream) {
+  size_t offset = 0;
+  for (auto& e : entries) {
+    size_t size = (size_t)e.tensor->size();
+    size_t lo = std::max(begin, offset);
+    size_t hi = std::min(end, offset + size);
+    if (lo < hi) {
+      if (in) {
+        gpu_context_->MemcpyAsyncD2D((uint8_t*)buffer + lo,
+                                     (const uint8_t*)e.tensor->data() + (lo - offset),
+                                     hi - lo, stream);
+      } else {
+        gpu_context_->MemcpyAsyncD2D((uint8_t*)e.output->data() + (lo - offset),
+                                     (const uint8_t*)buffer + lo, hi - lo,
+                                     stream);
+      }
+    }
+    if (offset + size >= end) {
+      break;
+    }
+    offset += size;
+  }
+}
+
 MPI_GPUAllgather::MPI_GPUAllgather(GPUContext* gpu_context,
                                    HorovodGlobalState* global_state)
     : GPUAllgather(gpu_context, global_state) {}
@@ -119,8 +282,8 @@ Status MPI_GPUAllgather::Execute(std::vector<TensorTableEntry>& entries, const R
   auto** entry_component_offsets = new int64_t* [entries.size()];
 
   int global_size = process_set.controller->GetSize();
-  auto* recvcounts = new int[global_size]();
-  auto* displcmnts = new int[global_size]();
+  auto* recvcounts = new int64_t[global_size]();
+  auto* displcmnts = new int64_t[global_size]();
 
   for (size_t ec = 0; ec < entries.size(); ++ec) {
     entry_component_sizes[ec] = new int64_t[global_size]();
@@ -157,14 +320,13 @@ Status MPI_GPUAllgather::Execute(std::vector<TensorTableEntry>& entries, const R
 
   global_state_->timeline.ActivityStartAll(entries, MPI_ALLGATHER);
   auto dtype = mpi_context.GetMPIDataType(first_entry.tensor->dtype());
-  int op = MPI_Allgatherv(sendbuf != nullptr ? sendbuf : MPI_IN_PLACE,
-                          (int) total_num_elements,
-                          dtype,
-                          buffer_data,
-                          recvcounts,
-                          displcmnts,
-                          dtype,
-                          mpi_context.GetMPICommunicator(Communicator::GLOBAL));
+  int op = MPIAllgatherv(sendbuf != nullptr ? sendbuf : MPI_IN_PLACE,
+                         total_num_elements,
+                         buffer_data,
+                         recvcounts,
+                         displcmnts,
+                         dtype,
+                         mpi_context.GetMPICommunicator(Communicator::GLOBAL));
   if (op != MPI_SUCCESS) {
     throw std::runtime_error("MPI_Allgatherv failed, see MPI output for details.");
   }
@@ -198,18 +360,20 @@ MPI_GPUAlltoall::MPI_GPUAlltoall(GPUContext* gpu_context,
     : GPUAlltoall(gpu_context, global_state) {}
 
 Status MPI_GPUAlltoall::Execute(std::vector<TensorTableEntry>& entries, const Response& response) {
-  assert(entries.size() == 1);
-
   gpu_op_context_.InitGPU(entries);
 
   WaitForData(entries);
 
+  if (entries.size() > 1) {
+    return ExecuteFused(entries);
+  }
+
   auto e = entries[0];
   auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
   const auto& mpi_context = process_set.mpi_context;
 
-  std::vector<int32_t> sdispls, rdispls;
-  std::vector<int32_t> sendcounts, recvcounts;
+  std::vector<int64_t> sdispls, rdispls;
+  std::vector<int64_t> sendcounts, recvcounts;
   Status status = PrepareOutputAndParams(e, sdispls, rdispls, sendcounts, recvcounts);
   if (!status.ok()) {
     return status;
@@ -220,16 +384,154 @@ Status MPI_GPUAlltoall::Execute(std::vector<TensorTableEntry>& entries, const Re
   global_state_->timeline.ActivityStartAll(entries, MPI_ALLTOALL);
 
   int op =
-      MPI_Alltoallv(sendbuf, sendcounts.data(), sdispls.data(),
-                    mpi_context.GetMPIDataType(e.tensor->dtype()), buffer_data,
-                    recvcounts.data(), rdispls.data(),
-                    mpi_context.GetMPIDataType(e.output->dtype()),
-                    mpi_context.GetMPICommunicator(Communicator::GLOBAL));
+      MPIAlltoallv(sendbuf, sendcounts.data(), sdispls.data(), buffer_data,
+                   recvcounts.data(), rdispls.data(),
+                   mpi_context.GetMPIDataType(e.tensor->dtype()),
+                   mpi_context.GetMPICommunicator(Communicator::GLOBAL));
+  if (op != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Alltoallv failed, see MPI output for details.");
+  }
+  global_state_->timeline.ActivityEndAll(entries);
+
+  return Status::OK();
+}
+
+Status MPI_GPUAlltoall::ExecuteFused(std::vector<TensorTableEntry>& entries) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  const auto& mpi_context = process_set.mpi_context;
+  auto& stream =
+      gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device];
+
+  std::vector<int64_t> entry_sendcounts, entry_recvcounts;
+  std::vector<int64_t> sdispls, rdispls;
+  std::vector<int64_t> sendcounts, recvcounts;
+  Status status = PrepareFusedOutputAndParams(entries, entry_sendcounts,
+                                              entry_recvcounts, sdispls,
+                                              rdispls, sendcounts, recvcounts);
+  if (!status.ok()) {
+    return status;
+  }
+
+  auto buffer = process_set.fusion_buffer.GetBuffer(
+      first_entry.device, first_entry.context->framework(),
+      global_state_->current_nccl_stream);
+  void* send_data = const_cast<void*>(buffer->AccessData(first_entry.context));
+  void* recv_data = nullptr;
+  status = GetFusedRecvBuffer(first_entry, rdispls.back() + recvcounts.back(),
+                              recv_data);
+  if (!status.ok()) {
+    return status;
+  }
+
+  global_state_->timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+  MemcpyInFusionBuffer(entries, entry_sendcounts, send_data);
+  gpu_context_->StreamSynchronize(stream);
+  global_state_->timeline.ActivityEndAll(entries);
+
+  global_state_->timeline.ActivityStartAll(entries, MPI_ALLTOALL);
+  int op = MPIAlltoallv(send_data, sendcounts.data(), sdispls.data(),
+                        recv_data, recvcounts.data(), rdispls.data(), MPI_BYTE,
+                        mpi_context.GetMPICommunicator(Communicator::GLOBAL));
   if (op != MPI_SUCCESS) {
     throw std::runtime_error("MPI_Alltoallv failed, see MPI output for details.");
   }
   global_state_->timeline.ActivityEndAll(entries);
 
+  // The outputs are read as soon as this returns, and the receive buffer may
+  // be replaced by the next fused alltoall.
+  global_state_->timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+  MemcpyOutFusionBuffer(recv_data, entry_recvcounts, entries);
+  gpu_context_->StreamSynchronize(stream);
+  global_state_->timeline.ActivityEndAll(entries);
+
+  return Status::OK();
+}
+
+MPI_GPUReducescatter::MPI_GPUReducescatter(GPUContext* gpu_context,
+                                           HorovodGlobalState* global_state)
+    : GPUReducescatter(gpu_context, global_state) {}
+
+Status MPI_GPUReducescatter::Execute(std::vector<TensorTableEntry>& entries, const Response& response) {
+  assert(!entries.empty());
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  const auto& mpi_context = process_set.mpi_context;
+
+  auto& timeline = global_state_->timeline;
+
+  gpu_op_context_.InitGPU(entries);
+
+  WaitForData(entries);
+
+  int global_size = process_set.controller->GetSize();
+  int global_rank = process_set.controller->GetRank();
+  auto output_shapes = ComputeOutputShapes(entries, global_size);
+  std::vector<int64_t> recvcounts = ComputeReceiveCounts(output_shapes);
+
+  timeline.ActivityStartAll(entries, ALLOCATE_OUTPUT);
+  Status status = AllocateOutput(entries, output_shapes);
+  if (!status.ok()) {
+    return status;
+  }
+  timeline.ActivityEndAll(entries);
+
+  size_t element_size = DataType_Size(first_entry.tensor->dtype());
+  double postscale_factor = response.postscale_factor();
+  auto& stream = gpu_context_->streams[global_state_->current_nccl_stream][first_entry.device];
+
+  const void* sendbuf;
+  void* buffer_data;
+
+  // Copy memory into the fusion buffer.
+  if (entries.size() > 1) {
+    timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+    MemcpyInFusionBuffer(entries, output_shapes, element_size, buffer_data);
+    if (response.prescale_factor() != 1.0) {
+      ScaleBuffer(response.prescale_factor(), entries, buffer_data,
+                  buffer_data, NumElements(entries));
+    }
+
+    gpu_context_->StreamSynchronize(stream);
+
+    timeline.ActivityEndAll(entries);
+    sendbuf = MPI_IN_PLACE;
+  } else {
+    sendbuf = first_entry.tensor->data();
+    buffer_data = (void*) first_entry.output->data();
+    // The input can't be scaled out of place into the smaller output, fold
+    // prescaling into postscaling instead.
+    postscale_factor *= response.prescale_factor();
+  }
+
+  // Do reducescatter.
+  timeline.ActivityStartAll(entries, MPI_REDUCESCATTER);
+  int op = MPIReduceScatter(sendbuf, buffer_data, recvcounts.data(),
+                            mpi_context.GetMPIDataType(first_entry.tensor),
+                            mpi_context.GetMPISumOp(first_entry.tensor->dtype()),
+                            mpi_context.GetMPICommunicator(Communicator::GLOBAL));
+  if (op != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Reduce_scatter failed, see MPI output for details.");
+  }
+  timeline.ActivityEndAll(entries);
+
+  if (postscale_factor != 1.0) {
+    // Execute postscaling op
+    ScaleBuffer(postscale_factor, entries, buffer_data, buffer_data,
+                recvcounts[global_rank]);
+  }
+
+  // Copy memory out of the fusion buffer.
+  if (entries.size() > 1) {
+    timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+    MemcpyOutFusionBuffer(buffer_data, entries);
+    timeline.ActivityEndAll(entries);
+  }
+
+  gpu_context_->StreamSynchronize(stream);
+
   return Status::OK();
 }
 
@@ -29,6 +29,20 @@ public:
   virtual ~MPI_GPUAllreduce()=default;
 
   Status Execute(std::vector<TensorTableEntry>& entries, const Response& response) override;
+
+protected:
+  // Reduces the data in chunks of mpi_gpu_allreduce_chunk_size bytes with
+  // MPI_Iallreduce on device memory. The copies into the fusion buffer and
+  // prescaling of later chunks, and the postscaling and copies out of earlier
+  // chunks, run on the stream while a chunk is being reduced.
+  void PipelinedAllreduce(std::vector<TensorTableEntry>& entries,
+                          const Response& response);
+
+  // Enqueues copies between the entries and the bytes [begin, end) of buffer,
+  // in which the entries lie back to back. Into buffer if in is true, out of
+  // it into the outputs otherwise.
+  void MemcpyChunk(std::vector<TensorTableEntry>& entries, void* buffer,
+                   size_t begin, size_t end, bool in, gpuStream_t stream);
 };
 
 class MPI_GPUAllgather : public GPUAllgather {
@@ -46,6 +60,17 @@ public:
   MPI_GPUAlltoall(GPUContext* gpu_context, HorovodGlobalState* global_state);
   virtual ~MPI_GPUAlltoall()=default;
 
+  Status Execute(std::vector<TensorTableEntry>& entries, const Response& response) override;
+
+protected:
+  Status ExecuteFused(std::vector<TensorTableEntry>& entries);
+};
+
+class MPI_GPUReducescatter : public GPUReducescatter {
+public:
+  MPI_GPUReducescatter(GPUContext* gpu_context, HorovodGlobalState* global_state);
+  virtual ~MPI_GPUReducescatter()=default;
+
   Status Execute(std::vector<TensorTableEntry>& entries, const Response& response) override;
 };
 
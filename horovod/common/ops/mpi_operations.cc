@@ -17,29 +17,177 @@
 
 #include "mpi_operations.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "cpu_kernels.h"
+
 namespace horovod {
 namespace common {
 
-MPIAllreduce::MPIAllreduce(HorovodGlobalState* global_state)
-    : AllreduceOp(global_state) {}
+void MPICollectiveQueue::Initialize(int max_outstanding) {
+  slot_busy_.assign(max_outstanding, false);
+  next_slot_ = 0;
+}
+
+int MPICollectiveQueue::AcquireSlot() {
+  if (slot_busy_[next_slot_]) {
+    auto it = std::find_if(posted_.begin(), posted_.end(),
+                           [this](const MPIPendingCollective& collective) {
+                             return collective.slot == next_slot_;
+                           });
+    int ret_code = MPI_Waitall((int)it->requests.size(), it->requests.data(),
+                               MPI_STATUSES_IGNORE);
+    Finish(*it, ret_code == MPI_SUCCESS
+                    ? Status::OK()
+                    : Status::UnknownError(
+                          "MPI_Waitall failed, see MPI output for details."));
+    posted_.erase(it);
+  }
+  int slot = next_slot_;
+  next_slot_ = (next_slot_ + 1) % (int)slot_busy_.size();
+  return slot;
+}
+
+void MPICollectiveQueue::Post(MPIPendingCollective&& collective) {
+  if (collective.slot >= 0) {
+    slot_busy_[collective.slot] = true;
+  }
+  posted_.push_back(std::move(collective));
+}
+
+void MPICollectiveQueue::Progress() {
+  for (auto it = posted_.begin(); it != posted_.end();) {
+    int done = 0;
+    int ret_code = MPI_Testall((int)it->requests.size(), it->requests.data(),
+                               &done, MPI_STATUSES_IGNORE);
+    if (ret_code == MPI_SUCCESS && !done) {
+      ++it;
+      continue;
+    }
+    Finish(*it, ret_code == MPI_SUCCESS
+                    ? Status::OK()
+                    : Status::UnknownError(
+                          "MPI_Testall failed, see MPI output for details."));
+    it = posted_.erase(it);
+  }
+}
+
+void MPICollectiveQueue::Drain() {
+  for (auto& collective : posted_) {
+    int ret_code =
+        MPI_Waitall((int)collective.requests.size(),
+                    collective.requests.data(), MPI_STATUSES_IGNORE);
+    Finish(collective, ret_code == MPI_SUCCESS
+                           ? Status::OK()
+                           : Status::UnknownError(
+                                 "MPI_Waitall failed, see MPI output for "
+                                 "details."));
+  }
+  posted_.clear();
+}
+
+void MPICollectiveQueue::Finish(MPIPendingCollective& collective,
+                                Status status) {
+  collective.timeline->ActivityEndAll(collective.entries);
+  if (status.ok() && collective.finalize) {
+    try {
+      collective.finalize(collective.entries);
+    } catch (const std::exception& ex) {
+      status = Status::UnknownError(ex.what());
+    }
+  }
+  for (auto& e : collective.entries) {
+    collective.timeline->End(e.tensor_name, status.ok() ? e.output : nullptr);
+    e.FinishWithCallback(status);
+  }
+  collective.fusion_buffer.reset();
+  if (collective.slot >= 0) {
+    slot_busy_[collective.slot] = false;
+  }
+}
+
+namespace {
+
+// Whether the collective of entries is posted to collectives rather than
+// run to completion. Every rank takes the same decision, as non-blocking
+// collectives do not match blocking ones.
+bool PostsCollective(const MPICollectiveQueue* collectives,
+                     const std::vector<TensorTableEntry>& entries) {
+  return collectives != nullptr && collectives->Enabled() &&
+         entries[0].device == CPU_DEVICE_ID;
+}
+
+// Hands requests over to collectives, which finishes the entries once they
+// have completed.
+Status PostCollective(
+    MPICollectiveQueue* collectives, HorovodGlobalState* global_state,
+    std::vector<TensorTableEntry>& entries,
+    std::vector<MPI_Request>&& requests,
+    std::function<void(std::vector<TensorTableEntry>&)> finalize) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state->process_set_table.Get(first_entry.process_set_id);
+
+  MPIPendingCollective collective;
+  collective.requests = std::move(requests);
+  collective.entries = entries;
+  collective.timeline = &global_state->timeline;
+  collective.finalize = std::move(finalize);
+  collective.fusion_buffer = process_set.fusion_buffer.GetBuffer(
+      first_entry.device, first_entry.context->framework(),
+      global_state->current_nccl_stream);
+  collective.slot = process_set.fusion_buffer.HostSlot();
+  collectives->Post(std::move(collective));
+  return Status::InProgress();
+}
+
+MPI_Op AllreduceMPIOp(const HorovodGlobalState& state,
+                      const MPIContext& mpi_context, DataType dtype,
+                      ReduceOp reduce_op) {
+  return reduce_op == ReduceOp::SUM && state.mpi_cpu_sum_kernels
+             ? mpi_context.GetMPICPUSumOp(dtype)
+             : mpi_context.GetMPIOp(dtype, reduce_op);
+}
+
+} // namespace
+
+MPIAllreduce::MPIAllreduce(HorovodGlobalState* global_state,
+                           MPICollectiveQueue* collectives)
+    : AllreduceOp(global_state), collectives_(collectives) {}
 
 Status MPIAllreduce::Execute(std::vector<TensorTableEntry>& entries, const Response& response) {
   assert(!entries.empty());
   WaitForData(entries);
 
   auto& first_entry = entries[0];
-  auto& process_set =
-      global_state_->process_set_table.Get(first_entry.process_set_id);
-  const auto& mpi_context = process_set.mpi_context;
 
   const void* fused_input_data;
   void* buffer_data;
   size_t buffer_len;
   int64_t num_elements = NumElements(entries);
+  auto dtype = first_entry.tensor->dtype();
+
+  // Tensors that already sit next to each other are reduced where they are.
+  bool fused = entries.size() > 1;
+  void* span_data = nullptr;
+  size_t span_len = 0;
+  bool zero_copy = fused && GetZeroCopySpan(entries, span_data, span_len);
+  double prescale_factor = response.prescale_factor();
+  double postscale_factor = response.postscale_factor();
+  if ((!fused || zero_copy) && FoldPrescale(entries, response)) {
+    postscale_factor *= prescale_factor;
+    prescale_factor = 1.0;
+  }
 
   // Copy memory into the fusion buffer.
   auto& timeline = global_state_->timeline;
-  if (entries.size() > 1) {
+  if (zero_copy) {
+    fused_input_data = span_data;
+    buffer_data = span_data;
+    buffer_len = span_len;
+    num_elements = (int64_t)span_len / DataType_Size(dtype);
+  } else if (fused) {
     timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
     MemcpyInFusionBuffer(entries, fused_input_data, buffer_data, buffer_len);
     timeline.ActivityEndAll(entries);
@@ -49,33 +197,60 @@ Status MPIAllreduce::Execute(std::vector<TensorTableEntry>& entries, const Respo
     buffer_len = (size_t) first_entry.output->size();
   }
 
-  if (response.prescale_factor() != 1.0) {
+  if (prescale_factor != 1.0) {
     // Execute prescaling op
-    ScaleBuffer(response.prescale_factor(), entries, fused_input_data, buffer_data, num_elements);
+    ScaleBuffer(prescale_factor, entries, fused_input_data, buffer_data, num_elements);
     fused_input_data = buffer_data; // for unfused, scale is done out of place
   }
 
   // Do allreduce.
   timeline.ActivityStartAll(entries, MPI_ALLREDUCE);
-  const void* sendbuf = entries.size() > 1 || fused_input_data == buffer_data
-                        ? MPI_IN_PLACE : fused_input_data;
-  int op =
-      MPI_Allreduce(sendbuf, buffer_data, (int)num_elements,
-                    mpi_context.GetMPIDataType(first_entry.tensor),
-                    mpi_context.GetMPISumOp(first_entry.tensor->dtype()),
-                    mpi_context.GetMPICommunicator(Communicator::GLOBAL));
-  if (op != MPI_SUCCESS) {
-    throw std::runtime_error("MPI_Allreduce failed, see MPI output for details.");
+  if (PostsCollective(collectives_, entries) &&
+      !AccumulatesInFloat32(entries, response)) {
+    auto& process_set =
+        global_state_->process_set_table.Get(first_entry.process_set_id);
+    const auto& mpi_context = process_set.mpi_context;
+    const void* sendbuf = fused || fused_input_data == buffer_data
+                              ? MPI_IN_PLACE
+                              : fused_input_data;
+    std::vector<MPI_Request> requests(1);
+    int op = MPI_Iallreduce(
+        sendbuf, buffer_data, (int)num_elements,
+        mpi_context.GetMPIDataType(dtype),
+        AllreduceMPIOp(*global_state_, mpi_context, dtype,
+                       response.reduce_op()),
+        mpi_context.GetMPICommunicator(Communicator::GLOBAL), &requests[0]);
+    if (op != MPI_SUCCESS) {
+      throw std::runtime_error(
+          "MPI_Iallreduce failed, see MPI output for details.");
+    }
+    return PostCollective(
+        collectives_, global_state_, entries, std::move(requests),
+        [this, buffer_data, num_elements, postscale_factor, fused,
+         zero_copy](std::vector<TensorTableEntry>& entries) {
+          if (postscale_factor != 1.0) {
+            ScaleBuffer(postscale_factor, entries, buffer_data, buffer_data,
+                        num_elements);
+          }
+          if (fused && !zero_copy) {
+            auto& timeline = global_state_->timeline;
+            timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+            MemcpyOutFusionBuffer(buffer_data, entries);
+            timeline.ActivityEndAll(entries);
+          }
+        });
   }
+  DoAllreduce(entries, fused ? buffer_data : fused_input_data, buffer_data,
+              num_elements, response);
   timeline.ActivityEndAll(entries);
 
-  if (response.postscale_factor() != 1.0) {
+  if (postscale_factor != 1.0) {
     // Execute postscaling op
-    ScaleBuffer(response.postscale_factor(), entries, buffer_data, buffer_data, num_elements);
+    ScaleBuffer(postscale_factor, entries, buffer_data, buffer_data, num_elements);
   }
 
   // Copy memory out of the fusion buffer.
-  if (entries.size() > 1) {
+  if (fused && !zero_copy) {
     timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
     MemcpyOutFusionBuffer(buffer_data, entries);
     timeline.ActivityEndAll(entries);
@@ -90,8 +265,232 @@ bool MPIAllreduce::Enabled(const ParameterManager& param_manager,
   return true;
 }
 
-MPIAllgather::MPIAllgather(HorovodGlobalState* global_state)
-    : AllgatherOp(global_state) {}
+void MPIAllreduce::DoAllreduce(std::vector<TensorTableEntry>& entries,
+                               const void* fused_input_data, void* buffer_data,
+                               int64_t num_elements,
+                               const Response& response) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  const auto& mpi_context = process_set.mpi_context;
+  auto dtype = first_entry.tensor->dtype();
+
+  const void* sendbuf =
+      fused_input_data == buffer_data ? MPI_IN_PLACE : fused_input_data;
+  void* recvbuf = buffer_data;
+  auto reduce_dtype = dtype;
+  thread_local std::vector<float> widened;
+  if (AccumulatesInFloat32(entries, response)) {
+    widened.resize(num_elements);
+    WidenToFloat32(fused_input_data, widened.data(), num_elements, dtype);
+    sendbuf = MPI_IN_PLACE;
+    recvbuf = widened.data();
+    reduce_dtype = HOROVOD_FLOAT32;
+  }
+  MPI_Op mpi_op = AllreduceMPIOp(*global_state_, mpi_context, reduce_dtype,
+                                 response.reduce_op());
+  int op =
+      MPI_Allreduce(sendbuf, recvbuf, (int)num_elements,
+                    mpi_context.GetMPIDataType(reduce_dtype), mpi_op,
+                    mpi_context.GetMPICommunicator(Communicator::GLOBAL));
+  if (op != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Allreduce failed, see MPI output for details.");
+  }
+  if (recvbuf != buffer_data) {
+    NarrowFromFloat32(widened.data(), buffer_data, num_elements, dtype);
+  }
+}
+
+namespace {
+
+// Slots and slices start on their own cache line, so that local ranks
+// summing neighbouring slices do not write to the same line.
+constexpr int64_t SHM_ALLREDUCE_ALIGNMENT = 64;
+
+int64_t RoundUp(int64_t value, int64_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+template <typename T>
+void SumSlots(uint8_t* buffer, int64_t slot_size, int num_slots,
+              int64_t offset, int64_t count) {
+  auto dst = reinterpret_cast<T*>(buffer + offset);
+  for (int i = 1; i < num_slots; ++i) {
+    auto src = reinterpret_cast<const T*>(buffer + i * slot_size + offset);
+    SumCPU(dst, src, dst, count);
+  }
+}
+
+// Local rank that allocates the shared memory segments of the node, so that
+// their pages sit next to the NIC moving them across nodes: the first local
+// rank running next to a NIC, or local rank 0.
+int SharedSegmentOwner(const HorovodGlobalState& state,
+                       const ProcessSet& process_set) {
+  auto& controller = process_set.controller;
+  auto& local_comm_ranks = controller->GetLocalCommRanks();
+  for (size_t i = 0; i < local_comm_ranks.size(); ++i) {
+    int global_rank = controller->GetGlobalRanks()[local_comm_ranks[i]];
+    if (global_rank < (int)state.near_nic_ranks.size() &&
+        state.near_nic_ranks[global_rank]) {
+      return (int)i;
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+MPISharedMemoryAllreduce::MPISharedMemoryAllreduce(
+    HorovodGlobalState* global_state)
+    : MPIAllreduce(global_state) {}
+
+bool MPISharedMemoryAllreduce::Enabled(
+    const ParameterManager& param_manager,
+    const std::vector<TensorTableEntry>& entries,
+    const Response& response) const {
+  if (!global_state_->shm_allreduce ||
+      response.reduce_op() != ReduceOp::SUM) {
+    return false;
+  }
+  switch (entries[0].tensor->dtype()) {
+  case HOROVOD_UINT8:
+  case HOROVOD_INT8:
+  case HOROVOD_UINT16:
+  case HOROVOD_INT16:
+  case HOROVOD_INT32:
+  case HOROVOD_INT64:
+  case HOROVOD_FLOAT32:
+  case HOROVOD_FLOAT64:
+    break;
+  default:
+    return false;
+  }
+  auto& process_set =
+      global_state_->process_set_table.Get(entries[0].process_set_id);
+  auto& controller = process_set.controller;
+  // Slices only line up across nodes if every node has the same number of
+  // ranks.
+  return controller->GetLocalSize() > 1 &&
+         (controller->IsHomogeneous() || controller->GetCrossSize() == 1);
+}
+
+void MPISharedMemoryAllreduce::DoAllreduce(
+    std::vector<TensorTableEntry>& entries, const void* fused_input_data,
+    void* buffer_data, int64_t num_elements, const Response& response) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  auto& mpi_context = process_set.mpi_context;
+  auto& controller = process_set.controller;
+  auto dtype = first_entry.tensor->dtype();
+  int element_size = DataType_Size(dtype);
+  int local_size = controller->GetLocalSize();
+  int local_rank = controller->GetLocalRank();
+  int64_t buffer_len = num_elements * element_size;
+
+  // If the shared segment is not allocated or too small, reallocate. All
+  // local ranks see the same response, so they do this together.
+  int64_t slot_size = RoundUp(buffer_len, SHM_ALLREDUCE_ALIGNMENT);
+  if (process_set.shm_allreduce_buffer == nullptr ||
+      process_set.shm_allreduce_slot_size < slot_size) {
+    if (process_set.shm_allreduce_buffer != nullptr) {
+      MPI_Win_free(&mpi_context.shm_allreduce_window);
+      process_set.shm_allreduce_buffer = nullptr;
+    }
+    slot_size = std::max(slot_size, process_set.shm_allreduce_slot_size * 2);
+    int owner = SharedSegmentOwner(*global_state_, process_set);
+    MPI_Aint window_size = local_rank == owner ? slot_size * local_size : 0;
+    MPI_Win_allocate_shared(window_size, 1, MPI_INFO_NULL,
+                            mpi_context.GetMPICommunicator(Communicator::LOCAL),
+                            &process_set.shm_allreduce_buffer,
+                            &mpi_context.shm_allreduce_window);
+    if (local_rank != owner) {
+      int disp_unit;
+      MPI_Aint winsize;
+      MPI_Win_shared_query(mpi_context.shm_allreduce_window, owner, &winsize,
+                           &disp_unit, &process_set.shm_allreduce_buffer);
+    }
+    process_set.shm_allreduce_slot_size = slot_size;
+  }
+  slot_size = process_set.shm_allreduce_slot_size;
+  auto shm = static_cast<uint8_t*>(process_set.shm_allreduce_buffer);
+
+  std::memcpy(shm + local_rank * slot_size, fused_input_data,
+              (size_t)buffer_len);
+  LocalBarrier(process_set);
+
+  // Local rank i sums slice i of all slots into slot 0.
+  int64_t slice_elements =
+      RoundUp((num_elements + local_size - 1) / local_size,
+              SHM_ALLREDUCE_ALIGNMENT / element_size);
+  int64_t slice_begin = std::min(local_rank * slice_elements, num_elements);
+  int64_t slice_count =
+      std::min(slice_begin + slice_elements, num_elements) - slice_begin;
+  int64_t slice_offset = slice_begin * element_size;
+  if (slice_count > 0) {
+    switch (dtype) {
+    case HOROVOD_UINT8:
+      SumSlots<uint8_t>(shm, slot_size, local_size, slice_offset, slice_count);
+      break;
+    case HOROVOD_INT8:
+      SumSlots<int8_t>(shm, slot_size, local_size, slice_offset, slice_count);
+      break;
+    case HOROVOD_UINT16:
+      SumSlots<uint16_t>(shm, slot_size, local_size, slice_offset, slice_count);
+      break;
+    case HOROVOD_INT16:
+      SumSlots<int16_t>(shm, slot_size, local_size, slice_offset, slice_count);
+      break;
+    case HOROVOD_INT32:
+      SumSlots<int32_t>(shm, slot_size, local_size, slice_offset, slice_count);
+      break;
+    case HOROVOD_INT64:
+      SumSlots<int64_t>(shm, slot_size, local_size, slice_offset, slice_count);
+      break;
+    case HOROVOD_FLOAT32:
+      SumSlots<float>(shm, slot_size, local_size, slice_offset, slice_count);
+      break;
+    case HOROVOD_FLOAT64:
+      SumSlots<double>(shm, slot_size, local_size, slice_offset, slice_count);
+      break;
+    default:
+      throw std::logic_error("Type " + DataType_Name(dtype) +
+                             " is not supported by shared memory allreduce.");
+    }
+  }
+
+  // Every slice is summed across nodes by the ranks that summed it locally.
+  if (controller->GetCrossSize() > 1) {
+    MPI_Op mpi_op = global_state_->mpi_cpu_sum_kernels
+                        ? mpi_context.GetMPICPUSumOp(dtype)
+                        : mpi_context.GetMPISumOp(dtype);
+    int op = MPI_Allreduce(MPI_IN_PLACE, shm + slice_offset, (int)slice_count,
+                           mpi_context.GetMPIDataType(dtype), mpi_op,
+                           mpi_context.GetMPICommunicator(Communicator::CROSS));
+    if (op != MPI_SUCCESS) {
+      throw std::runtime_error(
+          "MPI_Allreduce failed, see MPI output for details.");
+    }
+  }
+  LocalBarrier(process_set);
+
+  std::memcpy(buffer_data, shm, (size_t)buffer_len);
+  // Slot 0 must not be overwritten by the next allreduce before every local
+  // rank copied the result out.
+  LocalBarrier(process_set);
+}
+
+void MPISharedMemoryAllreduce::LocalBarrier(const ProcessSet& process_set) {
+  int op = MPI_Barrier(
+      process_set.mpi_context.GetMPICommunicator(Communicator::LOCAL));
+  if (op != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Barrier failed, see MPI output for details.");
+  }
+}
+
+MPIAllgather::MPIAllgather(HorovodGlobalState* global_state,
+                           MPICollectiveQueue* collectives)
+    : AllgatherOp(global_state), collectives_(collectives) {}
 
 bool MPIAllgather::Enabled(const ParameterManager& param_manager,
                            const std::vector<TensorTableEntry>& entries,
@@ -110,40 +509,22 @@ Status MPIAllgather::Execute(std::vector<TensorTableEntry>& entries, const Respo
 
   auto& timeline = global_state_->timeline;
 
-  // Sizes of subcomponents of each entry from all ranks
-  auto** entry_component_sizes = new int64_t* [entries.size()];
-
-  // Offset of each subcomponent of every entry in the final buffer after
-  // allgatherv
-  auto** entry_component_offsets = new int64_t* [entries.size()];
-
   int global_size = process_set.controller->GetSize();
-  auto* recvcounts = new int[global_size]();
-  auto* displcmnts = new int[global_size]();
-
-  for (size_t ec = 0; ec < entries.size(); ++ec) {
-    entry_component_sizes[ec] = new int64_t[global_size]();
-    entry_component_offsets[ec] = new int64_t[global_size]();
-  }
+  auto layout = std::make_shared<AllgatherLayout>(entries.size(), global_size);
 
   timeline.ActivityStartAll(entries, ALLOCATE_OUTPUT);
-  Status status = AllocateOutput(entries, response, entry_component_sizes, recvcounts);
+  Status status = AllocateOutput(entries, response,
+                                 layout->entry_component_sizes,
+                                 layout->recvcounts);
   if (!status.ok()) {
-    /* Cleanup */
-    for (size_t ec = 0; ec < entries.size(); ++ec) {
-      delete[] entry_component_sizes[ec];
-      delete[] entry_component_offsets[ec];
-    }
-    delete[] entry_component_sizes;
-    delete[] entry_component_offsets;
-    delete[] recvcounts;
-    delete[] displcmnts;
     return status;
   }
   timeline.ActivityEndAll(entries);
 
-  SetDisplacements(recvcounts, displcmnts, global_size);
-  SetEntryComponentOffsets(entries, entry_component_sizes, recvcounts, entry_component_offsets);
+  SetDisplacements(layout->recvcounts, layout->displcmnts, global_size);
+  SetEntryComponentOffsets(entries, layout->entry_component_sizes,
+                           layout->recvcounts,
+                           layout->entry_component_offsets);
 
   int element_size = mpi_context.GetMPITypeSize(first_entry.tensor->dtype());
 
@@ -153,7 +534,8 @@ Status MPIAllgather::Execute(std::vector<TensorTableEntry>& entries, const Respo
 
   if (entries.size() > 1) {
     timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
-    MemcpyInFusionBuffer(entries, displcmnts, element_size, buffer_data);
+    MemcpyInFusionBuffer(entries, layout->displcmnts, element_size,
+                         buffer_data);
     timeline.ActivityEndAll(entries);
   } else {
     sendbuf = first_entry.tensor->data();
@@ -162,35 +544,60 @@ Status MPIAllgather::Execute(std::vector<TensorTableEntry>& entries, const Respo
 
   global_state_->timeline.ActivityStartAll(entries, MPI_ALLGATHER);
   auto dtype = mpi_context.GetMPIDataType(first_entry.tensor->dtype());
-  int op = MPI_Allgatherv(sendbuf != nullptr ? sendbuf : MPI_IN_PLACE,
-                          (int) total_num_elements,
-                          dtype,
-                          buffer_data,
-                          recvcounts,
-                          displcmnts,
-                          dtype,
-                          mpi_context.GetMPICommunicator(Communicator::GLOBAL));
+  auto comm = mpi_context.GetMPICommunicator(Communicator::GLOBAL);
+  auto copy_out = [this, layout, buffer_data,
+                   element_size](std::vector<TensorTableEntry>& entries) {
+    if (entries.size() > 1) {
+      auto& timeline = global_state_->timeline;
+      timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+      MemcpyOutFusionBuffer(layout->entry_component_offsets,
+                            layout->entry_component_sizes, buffer_data,
+                            element_size, entries);
+      timeline.ActivityEndAll(entries);
+    }
+  };
+
+  // Every rank knows all counts, so they agree on whether the allgather
+  // fits the int counts of MPI_Iallgatherv.
+  auto total_elements =
+      layout->displcmnts[global_size - 1] + layout->recvcounts[global_size - 1];
+  if (PostsCollective(collectives_, entries) &&
+      total_elements <= std::numeric_limits<int>::max()) {
+    // MPI_Iallgatherv reads the counts until it has completed.
+    auto int_recvcounts = std::make_shared<std::vector<int>>(
+        layout->recvcounts, layout->recvcounts + global_size);
+    auto int_displcmnts = std::make_shared<std::vector<int>>(
+        layout->displcmnts, layout->displcmnts + global_size);
+    std::vector<MPI_Request> requests(1);
+    int op = MPI_Iallgatherv(
+        sendbuf != nullptr ? sendbuf : MPI_IN_PLACE, (int)total_num_elements,
+        dtype, buffer_data, int_recvcounts->data(), int_displcmnts->data(),
+        dtype, comm, &requests[0]);
+    if (op != MPI_SUCCESS) {
+      throw std::runtime_error(
+          "MPI_Iallgatherv failed, see MPI output for details.");
+    }
+    return PostCollective(
+        collectives_, global_state_, entries, std::move(requests),
+        [copy_out, int_recvcounts,
+         int_displcmnts](std::vector<TensorTableEntry>& entries) {
+          copy_out(entries);
+        });
+  }
+
+  int op = MPIAllgatherv(sendbuf != nullptr ? sendbuf : MPI_IN_PLACE,
+                         total_num_elements,
+                         buffer_data,
+                         layout->recvcounts,
+                         layout->displcmnts,
+                         dtype,
+                         comm);
   if (op != MPI_SUCCESS) {
     throw std::runtime_error("MPI_Allgatherv failed, see MPI output for details.");
   }
   global_state_->timeline.ActivityEndAll(entries);
 
-  if (entries.size() > 1) {
-    timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
-    MemcpyOutFusionBuffer(entry_component_offsets, entry_component_sizes,
-                          buffer_data, element_size, entries);
-    timeline.ActivityEndAll(entries);
-  }
-
-  delete[] recvcounts;
-  delete[] displcmnts;
-
-  for (size_t ec = 0; ec < entries.size(); ++ec) {
-    delete[] entry_component_sizes[ec];
-    delete[] entry_component_offsets[ec];
-  }
-  delete[] entry_component_sizes;
-  delete[] entry_component_offsets;
+  copy_out(entries);
 
   return Status::OK();
 }
@@ -218,8 +625,8 @@ Status MPIHierarchicalAllgather::Execute(std::vector<TensorTableEntry>& entries,
   auto** entry_component_offsets = new int64_t* [entries.size()];
 
   int global_size = process_set.controller->GetSize();
-  auto* recvcounts = new int[global_size]();
-  auto* displcmnts = new int[global_size]();
+  auto* recvcounts = new int64_t[global_size]();
+  auto* displcmnts = new int64_t[global_size]();
 
   for (size_t ec = 0; ec < entries.size(); ++ec) {
     entry_component_sizes[ec] = new int64_t[global_size]();
@@ -262,18 +669,20 @@ Status MPIHierarchicalAllgather::Execute(std::vector<TensorTableEntry>& entries,
 
     // Allocate shared memory, give each rank their respective pointer
     timeline.ActivityStartAll(entries, ALLOCATE_SHARED_BUFFER);
-    int64_t window_size = process_set.controller->GetLocalRank() == 0 ? total_size_in_bytes : 0;
+    int owner = SharedSegmentOwner(*global_state_, process_set);
+    int64_t window_size =
+        process_set.controller->GetLocalRank() == owner ? total_size_in_bytes : 0;
     MPI_Win_allocate_shared(window_size,
                             element_size,
                             MPI_INFO_NULL,
                             mpi_context.GetMPICommunicator(Communicator::LOCAL),
                             &process_set.shared_buffer,
                             &mpi_context.window);
-    if (process_set.controller->GetLocalRank() != 0) {
+    if (process_set.controller->GetLocalRank() != owner) {
       int disp_unit;
       MPI_Aint winsize;
       MPI_Win_shared_query(mpi_context.window,
-                           0,
+                           owner,
                            &winsize,
                            &disp_unit,
                            &process_set.shared_buffer);
@@ -287,8 +696,8 @@ Status MPIHierarchicalAllgather::Execute(std::vector<TensorTableEntry>& entries,
   int cross_size = process_set.controller->GetCrossSize();
   int local_size = process_set.controller->GetLocalSize();
   int local_rank = process_set.controller->GetLocalRank();
-  auto* cross_recvcounts = new int[cross_size]();
-  auto* cross_displcmnts = new int[cross_size]();
+  auto* cross_recvcounts = new int64_t[cross_size]();
+  auto* cross_displcmnts = new int64_t[cross_size]();
 
   if (process_set.controller->IsHomogeneous()) {
     for (int i = 0; i < process_set.controller->GetCrossSize(); ++i) {
@@ -328,14 +737,13 @@ Status MPIHierarchicalAllgather::Execute(std::vector<TensorTableEntry>& entries,
   // local ranks participate, otherwise local rank 0 handles all data
   global_state_->timeline.ActivityStartAll(entries, MPI_CROSS_ALLGATHER);
   if (process_set.controller->IsHomogeneous() || process_set.controller->GetLocalRank() == 0) {
-    int op = MPI_Allgatherv(MPI_IN_PLACE,
-                            0,
-                            MPI_DATATYPE_NULL,
-                            process_set.shared_buffer,
-                            cross_recvcounts,
-                            cross_displcmnts,
-                            mpi_context.GetMPIDataType(first_entry.tensor->dtype()),
-                            mpi_context.GetMPICommunicator(Communicator::CROSS));
+    int op = MPIAllgatherv(MPI_IN_PLACE,
+                           0,
+                           process_set.shared_buffer,
+                           cross_recvcounts,
+                           cross_displcmnts,
+                           mpi_context.GetMPIDataType(first_entry.tensor->dtype()),
+                           mpi_context.GetMPICommunicator(Communicator::CROSS));
     if (op != MPI_SUCCESS) {
       throw std::runtime_error("MPI_Allgatherv failed, see MPI output for details.");
     }
@@ -371,14 +779,18 @@ void MPIHierarchicalAllgather::Barrier(const ProcessSet& process_set) {
   }
 }
 
-MPIBroadcast::MPIBroadcast(HorovodGlobalState* global_state)
-    : BroadcastOp(global_state) {}
+MPIBroadcast::MPIBroadcast(HorovodGlobalState* global_state,
+                           MPICollectiveQueue* collectives)
+    : BroadcastOp(global_state), collectives_(collectives) {}
 
 Status MPIBroadcast::Execute(std::vector<TensorTableEntry>& entries,
                              const Response& response) {
   WaitForData(entries);
 
-  assert(entries.size() == 1);
+  if (entries.size() > 1) {
+    return ExecuteFused(entries);
+  }
+
   auto e = entries[0];
   auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
   const auto& mpi_context = process_set.mpi_context;
@@ -391,20 +803,209 @@ Status MPIBroadcast::Execute(std::vector<TensorTableEntry>& entries,
     data_ptr = (void*) e.output->data();
   }
 
+  auto comm = mpi_context.GetMPICommunicator(Communicator::GLOBAL);
   global_state_->timeline.ActivityStartAll(entries, MPI_BCAST);
-  int op = MPI_Bcast(data_ptr,
-                     (int) e.tensor->shape().num_elements(),
-                     mpi_context.GetMPIDataType(e.tensor->dtype()),
-                     e.root_rank,
-                     mpi_context.GetMPICommunicator(Communicator::GLOBAL));
-  if (op != MPI_SUCCESS) {
-    throw std::runtime_error("MPI_Broadcast failed, see MPI output for details.");
+  if (PostBroadcast(entries, data_ptr, e.tensor->size(), e.root_rank, comm)) {
+    return Status::InProgress();
+  }
+  Broadcast(data_ptr, e.tensor->size(), e.root_rank, comm);
+  global_state_->timeline.ActivityEndAll(entries);
+
+  return Status::OK();
+}
+
+Status MPIBroadcast::ExecuteFused(std::vector<TensorTableEntry>& entries) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  const auto& mpi_context = process_set.mpi_context;
+  auto comm = mpi_context.GetMPICommunicator(Communicator::GLOBAL);
+  bool is_root = process_set.controller->GetRank() == first_entry.root_rank;
+
+  if (first_entry.device != CPU_DEVICE_ID) {
+    // GPU tensors are broadcast by CUDA-aware MPI in place, one after the
+    // other, since the fusion buffer copies only handle host memory.
+    global_state_->timeline.ActivityStartAll(entries, MPI_BCAST);
+    for (auto& e : entries) {
+      void* data_ptr = is_root ? (void*)e.tensor->data() : (void*)e.output->data();
+      Broadcast(data_ptr, e.tensor->size(), e.root_rank, comm);
+    }
+    global_state_->timeline.ActivityEndAll(entries);
+    return Status::OK();
   }
+
+  auto buffer = process_set.fusion_buffer.GetBuffer(
+      first_entry.device, first_entry.context->framework(),
+      global_state_->current_nccl_stream);
+  void* buffer_data = const_cast<void*>(buffer->AccessData(first_entry.context));
+  int64_t buffer_len = 0;
+  for (auto& e : entries) {
+    buffer_len += e.tensor->size();
+  }
+
+  if (is_root) {
+    global_state_->timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+    MemcpyInFusionBuffer(entries, buffer_data);
+    global_state_->timeline.ActivityEndAll(entries);
+  }
+
+  auto copy_out = [this, is_root,
+                   buffer_data](std::vector<TensorTableEntry>& entries) {
+    if (!is_root) {
+      auto& timeline = global_state_->timeline;
+      timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+      MemcpyOutFusionBuffer(buffer_data, entries);
+      timeline.ActivityEndAll(entries);
+    }
+  };
+
+  global_state_->timeline.ActivityStartAll(entries, MPI_BCAST);
+  if (PostBroadcast(entries, buffer_data, buffer_len, first_entry.root_rank,
+                    comm, copy_out)) {
+    return Status::InProgress();
+  }
+  Broadcast(buffer_data, buffer_len, first_entry.root_rank, comm);
   global_state_->timeline.ActivityEndAll(entries);
 
+  copy_out(entries);
+
   return Status::OK();
 }
 
+namespace {
+
+const int64_t MAX_BROADCAST_SEGMENT = 1 << 30;
+const int BROADCAST_TAG = 0;
+
+} // namespace
+
+void MPIBroadcast::Broadcast(void* data, int64_t num_bytes, int root_rank,
+                             MPI_Comm comm) {
+  int size;
+  MPI_Comm_size(comm, &size);
+  auto bytes = static_cast<uint8_t*>(data);
+  // MPI counts are ints, so large payloads go out in several segments.
+  for (int64_t offset = 0; offset < num_bytes;
+       offset += MAX_BROADCAST_SEGMENT) {
+    int64_t len = std::min(num_bytes - offset, MAX_BROADCAST_SEGMENT);
+    auto scatter_allgather_threshold =
+        global_state_->broadcast_scatter_allgather_threshold;
+    auto tree_threshold = global_state_->broadcast_tree_threshold;
+    if (size > 2 && scatter_allgather_threshold > 0 &&
+        len >= scatter_allgather_threshold) {
+      ScatterAllgatherBroadcast(bytes + offset, len, root_rank, comm);
+    } else if (size > 2 && tree_threshold > 0 && len >= tree_threshold) {
+      TreeBroadcast(bytes + offset, len, root_rank, comm);
+    } else {
+      int op = MPI_Bcast(bytes + offset, (int)len, MPI_BYTE, root_rank, comm);
+      if (op != MPI_SUCCESS) {
+        throw std::runtime_error(
+            "MPI_Broadcast failed, see MPI output for details.");
+      }
+    }
+  }
+}
+
+bool MPIBroadcast::PostBroadcast(
+    std::vector<TensorTableEntry>& entries, void* data, int64_t num_bytes,
+    int root_rank, MPI_Comm comm,
+    std::function<void(std::vector<TensorTableEntry>&)> finalize) {
+  if (!PostsCollective(collectives_, entries) ||
+      num_bytes > MAX_BROADCAST_SEGMENT) {
+    return false;
+  }
+  int size;
+  MPI_Comm_size(comm, &size);
+  auto scatter_allgather_threshold =
+      global_state_->broadcast_scatter_allgather_threshold;
+  auto tree_threshold = global_state_->broadcast_tree_threshold;
+  if (size > 2 && ((scatter_allgather_threshold > 0 &&
+                    num_bytes >= scatter_allgather_threshold) ||
+                   (tree_threshold > 0 && num_bytes >= tree_threshold))) {
+    // Left to the tree or scatter and allgather of Broadcast.
+    return false;
+  }
+  std::vector<MPI_Request> requests(1);
+  int op = MPI_Ibcast(data, (int)num_bytes, MPI_BYTE, root_rank, comm,
+                      &requests[0]);
+  if (op != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Ibcast failed, see MPI output for details.");
+  }
+  PostCollective(collectives_, global_state_, entries, std::move(requests),
+                 std::move(finalize));
+  return true;
+}
+
+void MPIBroadcast::TreeBroadcast(uint8_t* data, int64_t num_bytes,
+                                 int root_rank, MPI_Comm comm) {
+  int rank, size;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  // Binary tree over the ranks counted from the root.
+  int relative_rank = (rank - root_rank + size) % size;
+  int parent = ((relative_rank - 1) / 2 + root_rank) % size;
+  std::vector<int> children;
+  for (int child = 2 * relative_rank + 1;
+       child <= 2 * relative_rank + 2 && child < size; ++child) {
+    children.push_back((child + root_rank) % size);
+  }
+
+  // A chunk is passed on as soon as it arrived, while the parent already
+  // sends the next one.
+  int64_t chunk_size = global_state_->broadcast_chunk_size;
+  std::vector<MPI_Request> requests;
+  requests.reserve(children.size() * (num_bytes / chunk_size + 1));
+  for (int64_t offset = 0; offset < num_bytes; offset += chunk_size) {
+    int len = (int)std::min(chunk_size, num_bytes - offset);
+    if (relative_rank != 0) {
+      int op = MPI_Recv(data + offset, len, MPI_BYTE, parent, BROADCAST_TAG,
+                        comm, MPI_STATUS_IGNORE);
+      if (op != MPI_SUCCESS) {
+        throw std::runtime_error(
+            "MPI_Recv failed, see MPI output for details.");
+      }
+    }
+    for (int child : children) {
+      requests.emplace_back();
+      MPI_Isend(data + offset, len, MPI_BYTE, child, BROADCAST_TAG, comm,
+                &requests.back());
+    }
+  }
+  if (MPI_Waitall((int)requests.size(), requests.data(),
+                  MPI_STATUSES_IGNORE) != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Isend failed, see MPI output for details.");
+  }
+}
+
+void MPIBroadcast::ScatterAllgatherBroadcast(uint8_t* data, int64_t num_bytes,
+                                             int root_rank, MPI_Comm comm) {
+  int rank, size;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  // Every rank receives one block from the root, then all blocks are
+  // gathered everywhere.
+  int64_t block = (num_bytes + size - 1) / size;
+  std::vector<int> counts(size);
+  std::vector<int> displs(size);
+  for (int i = 0; i < size; ++i) {
+    int64_t begin = std::min(i * block, num_bytes);
+    displs[i] = (int)begin;
+    counts[i] = (int)(std::min(begin + block, num_bytes) - begin);
+  }
+  int op = MPI_Scatterv(data, counts.data(), displs.data(), MPI_BYTE,
+                        rank == root_rank ? MPI_IN_PLACE : data + displs[rank],
+                        counts[rank], MPI_BYTE, root_rank, comm);
+  if (op != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Scatterv failed, see MPI output for details.");
+  }
+  op = MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, data, counts.data(),
+                      displs.data(), MPI_BYTE, comm);
+  if (op != MPI_SUCCESS) {
+    throw std::runtime_error(
+        "MPI_Allgatherv failed, see MPI output for details.");
+  }
+}
+
 bool MPIBroadcast::Enabled(const ParameterManager& param_manager,
                            const std::vector<TensorTableEntry>& entries,
                            const Response& response) const {
@@ -417,13 +1018,16 @@ MPIAlltoall::MPIAlltoall(HorovodGlobalState* global_state)
 Status MPIAlltoall::Execute(std::vector<TensorTableEntry>& entries, const Response& response) {
   WaitForData(entries);
 
-  assert(entries.size() == 1);
+  if (entries.size() > 1) {
+    return ExecuteFused(entries);
+  }
+
   auto e = entries[0];
   auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
   const auto& mpi_context = process_set.mpi_context;
 
-  std::vector<int32_t> sdispls, rdispls;
-  std::vector<int32_t> sendcounts, recvcounts;
+  std::vector<int64_t> sdispls, rdispls;
+  std::vector<int64_t> sendcounts, recvcounts;
   Status status = PrepareOutputAndParams(e, sdispls, rdispls, sendcounts, recvcounts);
   if (!status.ok()) {
     return status;
@@ -433,11 +1037,10 @@ Status MPIAlltoall::Execute(std::vector<TensorTableEntry>& entries, const Respon
   void* buffer_data = (void*) e.output->data();
   global_state_->timeline.ActivityStartAll(entries, MPI_ALLTOALL);
 
-  int op = MPI_Alltoallv(sendbuf, sendcounts.data(), sdispls.data(),
-                         mpi_context.GetMPIDataType(e.tensor->dtype()),
-                         buffer_data, recvcounts.data(), rdispls.data(),
-                         mpi_context.GetMPIDataType(e.output->dtype()),
-                         mpi_context.GetMPICommunicator(Communicator::GLOBAL));
+  int op = MPIAlltoallv(sendbuf, sendcounts.data(), sdispls.data(),
+                        buffer_data, recvcounts.data(), rdispls.data(),
+                        mpi_context.GetMPIDataType(e.tensor->dtype()),
+                        mpi_context.GetMPICommunicator(Communicator::GLOBAL));
   if (op != MPI_SUCCESS) {
     throw std::runtime_error("MPI_Alltoallv failed, see MPI output for details.");
   }
@@ -446,11 +1049,343 @@ Status MPIAlltoall::Execute(std::vector<TensorTableEntry>& entries, const Respon
   return Status::OK();
 }
 
+Status MPIAlltoall::ExecuteFused(std::vector<TensorTableEntry>& entries) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  const auto& mpi_context = process_set.mpi_context;
+
+  std::vector<int64_t> entry_sendcounts, entry_recvcounts;
+  std::vector<int64_t> sdispls, rdispls;
+  std::vector<int64_t> sendcounts, recvcounts;
+  Status status = PrepareFusedOutputAndParams(entries, entry_sendcounts,
+                                              entry_recvcounts, sdispls,
+                                              rdispls, sendcounts, recvcounts);
+  if (!status.ok()) {
+    return status;
+  }
+
+  auto buffer = process_set.fusion_buffer.GetBuffer(
+      first_entry.device, first_entry.context->framework(),
+      global_state_->current_nccl_stream);
+  void* send_data = const_cast<void*>(buffer->AccessData(first_entry.context));
+  void* recv_data = nullptr;
+  status = GetFusedRecvBuffer(first_entry, rdispls.back() + recvcounts.back(),
+                              recv_data);
+  if (!status.ok()) {
+    return status;
+  }
+
+  global_state_->timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+  MemcpyInFusionBuffer(entries, entry_sendcounts, send_data);
+  global_state_->timeline.ActivityEndAll(entries);
+
+  global_state_->timeline.ActivityStartAll(entries, MPI_ALLTOALL);
+  int op = MPIAlltoallv(send_data, sendcounts.data(), sdispls.data(),
+                        recv_data, recvcounts.data(), rdispls.data(), MPI_BYTE,
+                        mpi_context.GetMPICommunicator(Communicator::GLOBAL));
+  if (op != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Alltoallv failed, see MPI output for details.");
+  }
+  global_state_->timeline.ActivityEndAll(entries);
+
+  global_state_->timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+  MemcpyOutFusionBuffer(recv_data, entry_recvcounts, entries);
+  global_state_->timeline.ActivityEndAll(entries);
+
+  return Status::OK();
+}
+
 bool MPIAlltoall::Enabled(const ParameterManager& param_manager,
                            const std::vector<TensorTableEntry>& entries,
                            const Response& response) const {
   return true;
 }
 
+MPIReducescatter::MPIReducescatter(HorovodGlobalState* global_state)
+    : ReducescatterOp(global_state) {}
+
+Status MPIReducescatter::Execute(std::vector<TensorTableEntry>& entries,
+                                 const Response& response) {
+  assert(!entries.empty());
+  WaitForData(entries);
+
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  const auto& mpi_context = process_set.mpi_context;
+
+  auto& timeline = global_state_->timeline;
+
+  int global_size = process_set.controller->GetSize();
+  int global_rank = process_set.controller->GetRank();
+  auto output_shapes = ComputeOutputShapes(entries, global_size);
+  std::vector<int64_t> recvcounts = ComputeReceiveCounts(output_shapes);
+
+  timeline.ActivityStartAll(entries, ALLOCATE_OUTPUT);
+  Status status = AllocateOutput(entries, output_shapes);
+  if (!status.ok()) {
+    return status;
+  }
+  timeline.ActivityEndAll(entries);
+
+  size_t element_size = DataType_Size(first_entry.tensor->dtype());
+  int64_t num_elements = NumElements(entries);
+  double postscale_factor = response.postscale_factor();
+
+  const void* sendbuf;
+  void* buffer_data;
+
+  // Copy memory into the fusion buffer.
+  if (entries.size() > 1) {
+    timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+    MemcpyInFusionBuffer(entries, output_shapes, element_size, buffer_data);
+    timeline.ActivityEndAll(entries);
+
+    if (response.prescale_factor() != 1.0) {
+      // Execute prescaling op
+      ScaleBuffer(response.prescale_factor(), entries, buffer_data,
+                  buffer_data, num_elements);
+    }
+    // The reduced part of this rank ends up at the start of the buffer.
+    sendbuf = MPI_IN_PLACE;
+  } else {
+    sendbuf = first_entry.tensor->data();
+    buffer_data = (void*)first_entry.output->data();
+    // The input can't be scaled out of place into the smaller output, fold
+    // prescaling into postscaling instead.
+    postscale_factor *= response.prescale_factor();
+  }
+
+  // Do reducescatter.
+  timeline.ActivityStartAll(entries, MPI_REDUCESCATTER);
+  int op = MPIReduceScatter(sendbuf, buffer_data, recvcounts.data(),
+                            mpi_context.GetMPIDataType(first_entry.tensor),
+                            mpi_context.GetMPISumOp(first_entry.tensor->dtype()),
+                            mpi_context.GetMPICommunicator(Communicator::GLOBAL));
+  if (op != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Reduce_scatter failed, see MPI output for details.");
+  }
+  timeline.ActivityEndAll(entries);
+
+  if (postscale_factor != 1.0) {
+    // Execute postscaling op
+    ScaleBuffer(postscale_factor, entries, buffer_data, buffer_data,
+                recvcounts[global_rank]);
+  }
+
+  // Copy memory out of the fusion buffer.
+  if (entries.size() > 1) {
+    timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+    MemcpyOutFusionBuffer(buffer_data, entries);
+    timeline.ActivityEndAll(entries);
+  }
+
+  return Status::OK();
+}
+
+bool MPIReducescatter::Enabled(const ParameterManager& param_manager,
+                               const std::vector<TensorTableEntry>& entries,
+                               const Response& response) const {
+  return true;
+}
+
+MPIReduce::MPIReduce(HorovodGlobalState* global_state)
+    : AllreduceOp(global_state) {}
+
+Status MPIReduce::Execute(std::vector<TensorTableEntry>& entries,
+                          const Response& response) {
+  assert(!entries.empty());
+  WaitForData(entries);
+
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  const auto& mpi_context = process_set.mpi_context;
+  bool is_root = process_set.controller->GetRank() == first_entry.root_rank;
+  auto dtype = first_entry.tensor->dtype();
+  int64_t num_elements = NumElements(entries);
+  double postscale_factor = response.postscale_factor();
+
+  auto& timeline = global_state_->timeline;
+  const void* sendbuf;
+  void* buffer_data = nullptr;
+  bool fused = entries.size() > 1;
+  if (fused) {
+    const void* fused_input_data;
+    size_t buffer_len;
+    timeline.ActivityStartAll(entries, MEMCPY_IN_FUSION_BUFFER);
+    MemcpyInFusionBuffer(entries, fused_input_data, buffer_data, buffer_len);
+    timeline.ActivityEndAll(entries);
+    if (response.prescale_factor() != 1.0) {
+      ScaleBuffer(response.prescale_factor(), entries, buffer_data,
+                  buffer_data, num_elements);
+    }
+    sendbuf = is_root ? MPI_IN_PLACE : buffer_data;
+  } else {
+    sendbuf = first_entry.tensor->data();
+    if (is_root) {
+      buffer_data = (void*)first_entry.output->data();
+      if (sendbuf == buffer_data) {
+        sendbuf = MPI_IN_PLACE;
+      }
+    }
+    // Only the root has a buffer to scale, fold prescaling into postscaling
+    // instead.
+    postscale_factor *= response.prescale_factor();
+  }
+
+  // Do reduce.
+  timeline.ActivityStartAll(entries, MPI_REDUCE);
+  int op = MPI_Reduce(sendbuf, buffer_data, (int)num_elements,
+                      mpi_context.GetMPIDataType(dtype),
+                      AllreduceMPIOp(*global_state_, mpi_context, dtype,
+                                     response.reduce_op()),
+                      first_entry.root_rank,
+                      mpi_context.GetMPICommunicator(Communicator::GLOBAL));
+  if (op != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Reduce failed, see MPI output for details.");
+  }
+  timeline.ActivityEndAll(entries);
+
+  if (!is_root) {
+    return Status::OK();
+  }
+  if (postscale_factor != 1.0) {
+    // Execute postscaling op
+    ScaleBuffer(postscale_factor, entries, buffer_data, buffer_data,
+                num_elements);
+  }
+
+  // Copy memory out of the fusion buffer.
+  if (fused) {
+    timeline.ActivityStartAll(entries, MEMCPY_OUT_FUSION_BUFFER);
+    MemcpyOutFusionBuffer(buffer_data, entries);
+    timeline.ActivityEndAll(entries);
+  }
+
+  return Status::OK();
+}
+
+bool MPIReduce::Enabled(const ParameterManager& param_manager,
+                        const std::vector<TensorTableEntry>& entries,
+                        const Response& response) const {
+  return entries[0].device == CPU_DEVICE_ID;
+}
+
+MPIGather::MPIGather(HorovodGlobalState* global_state)
+    : GatherOp(global_state) {}
+
+Status MPIGather::Execute(std::vector<TensorTableEntry>& entries,
+                          const Response& response) {
+  assert(entries.size() == 1);
+  WaitForData(entries);
+
+  auto& e = entries[0];
+  auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
+  const auto& mpi_context = process_set.mpi_context;
+  auto& timeline = global_state_->timeline;
+
+  std::vector<int64_t> recvcounts;
+  std::vector<int64_t> displcmnts;
+  timeline.ActivityStartAll(entries, ALLOCATE_OUTPUT);
+  Status status = PrepareOutputAndParams(e, response, recvcounts, displcmnts);
+  if (!status.ok()) {
+    return status;
+  }
+  timeline.ActivityEndAll(entries);
+
+  std::vector<int> counts(recvcounts.begin(), recvcounts.end());
+  std::vector<int> displs(displcmnts.begin(), displcmnts.end());
+  timeline.ActivityStartAll(entries, MPI_GATHER);
+  int op = MPI_Gatherv(e.tensor->data(),
+                       (int)e.tensor->shape().num_elements(),
+                       mpi_context.GetMPIDataType(e.tensor), (void*)e.output->data(),
+                       counts.data(), displs.data(),
+                       mpi_context.GetMPIDataType(e.tensor), e.root_rank,
+                       mpi_context.GetMPICommunicator(Communicator::GLOBAL));
+  if (op != MPI_SUCCESS) {
+    throw std::runtime_error("MPI_Gatherv failed, see MPI output for details.");
+  }
+  timeline.ActivityEndAll(entries);
+
+  return Status::OK();
+}
+
+bool MPIGather::Enabled(const ParameterManager& param_manager,
+                        const std::vector<TensorTableEntry>& entries,
+                        const Response& response) const {
+  return entries[0].device == CPU_DEVICE_ID;
+}
+
+MPIPeerOperations::MPIPeerOperations(MPIContext* mpi_context)
+    : mpi_context_(mpi_context) {}
+
+void MPIPeerOperations::Post(std::vector<PeerOperation>& operations) {
+  // Receives go first, so that two ranks sending to each other do not wait
+  // for eager sends to be buffered.
+  std::stable_partition(
+      operations.begin(), operations.end(),
+      [](const PeerOperation& operation) { return !operation.send; });
+  for (auto& operation : operations) {
+    posted_.emplace_back();
+    auto& posted = posted_.back();
+    posted.entry = std::move(operation.entry);
+    auto& e = posted.entry;
+    auto data = static_cast<uint8_t*>(
+        operation.send ? const_cast<void*>(e.tensor->data())
+                       : const_cast<void*>(e.output->data()));
+    int64_t size = operation.send ? e.tensor->size() : e.output->size();
+    // Both ranks split the message into the same chunks, as the sizes of a
+    // send and its receive have to match.
+    for (int64_t offset = 0; offset < size; offset += MPI_LARGE_COUNT_CHUNK) {
+      int count = (int)std::min<int64_t>(size - offset, MPI_LARGE_COUNT_CHUNK);
+      posted.requests.emplace_back();
+      int op = operation.send
+                   ? MPI_Isend(data + offset, count, MPI_BYTE, e.root_rank, 0,
+                               mpi_context_->peer_comm,
+                               &posted.requests.back())
+                   : MPI_Irecv(data + offset, count, MPI_BYTE, e.root_rank, 0,
+                               mpi_context_->peer_comm,
+                               &posted.requests.back());
+      if (op != MPI_SUCCESS) {
+        throw std::runtime_error(
+            std::string(operation.send ? "MPI_Isend" : "MPI_Irecv") +
+            " failed, see MPI output for details.");
+      }
+    }
+  }
+}
+
+void MPIPeerOperations::Progress() {
+  for (auto it = posted_.begin(); it != posted_.end();) {
+    int done = 0;
+    if (MPI_Testall((int)it->requests.size(), it->requests.data(), &done,
+                    MPI_STATUSES_IGNORE) != MPI_SUCCESS) {
+      throw std::runtime_error(
+          "MPI_Testall failed, see MPI output for details.");
+    }
+    if (!done) {
+      ++it;
+      continue;
+    }
+    it->entry.FinishWithCallback(Status::OK());
+    it = posted_.erase(it);
+  }
+}
+
+void MPIPeerOperations::Abort(const Status& status) {
+  for (auto& posted : posted_) {
+    for (auto& request : posted.requests) {
+      if (request != MPI_REQUEST_NULL) {
+        MPI_Cancel(&request);
+        MPI_Request_free(&request);
+      }
+    }
+    posted.entry.FinishWithCallback(status);
+  }
+  posted_.clear();
+}
+
 } // namespace common
 } // namespace horovod
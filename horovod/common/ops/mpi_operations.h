@@ -18,7 +18,10 @@
 #ifndef HOROVOD_MPI_OPERATIONS_H
 #define HOROVOD_MPI_OPERATIONS_H
 
+#include <functional>
 #include <iostream>
+#include <list>
+#include <memory>
 
 #include "mpi.h"
 
@@ -30,9 +33,57 @@
 namespace horovod {
 namespace common {
 
+// Non-blocking collective posted by one of the MPI operations.
+struct MPIPendingCollective {
+  std::vector<MPI_Request> requests;
+  std::vector<TensorTableEntry> entries;
+  Timeline* timeline = nullptr;
+
+  // Runs once the requests have completed, for example to copy the result
+  // out of the fusion buffer.
+  std::function<void(std::vector<TensorTableEntry>&)> finalize;
+
+  // Released once the collective has completed.
+  std::shared_ptr<PersistentBuffer> fusion_buffer;
+  int slot = -1;
+};
+
+// Collectives of CPU tensors that MPIAllreduce, MPIAllgather and MPIBroadcast
+// post with MPI_Iallreduce, MPI_Iallgatherv and MPI_Ibcast instead of
+// blocking the background thread, which finishes them once MPI has completed
+// them. Each one in flight fuses into the buffer of its own slot, passed in
+// place of the GPU stream. Only used by the background thread.
+class MPICollectiveQueue {
+public:
+  // Allows up to max_outstanding collectives in flight, 0 keeps the
+  // operations blocking.
+  void Initialize(int max_outstanding);
+
+  bool Enabled() const { return !slot_busy_.empty(); }
+
+  // Returns the next slot, after finishing the collective that holds it.
+  int AcquireSlot();
+
+  void Post(MPIPendingCollective&& collective);
+
+  // Finishes the posted collectives that have completed.
+  void Progress();
+
+  // Waits for all posted collectives and finishes them.
+  void Drain();
+
+private:
+  void Finish(MPIPendingCollective& collective, Status status);
+
+  std::list<MPIPendingCollective> posted_;
+  std::vector<bool> slot_busy_;
+  int next_slot_ = 0;
+};
+
 class MPIAllreduce : public AllreduceOp {
 public:
-  MPIAllreduce(HorovodGlobalState* global_state);
+  MPIAllreduce(HorovodGlobalState* global_state,
+               MPICollectiveQueue* collectives = nullptr);
 
   virtual ~MPIAllreduce() = default;
 
@@ -41,17 +92,51 @@ public:
   bool Enabled(const ParameterManager& param_manager,
                const std::vector<TensorTableEntry>& entries,
                const Response& response) const override;
+
+protected:
+  // Reduces fused_input_data into buffer_data across the process set, the
+  // two are the same buffer if the reduction is in place.
+  virtual void DoAllreduce(std::vector<TensorTableEntry>& entries,
+                           const void* fused_input_data, void* buffer_data,
+                           int64_t num_elements, const Response& response);
+
+  MPICollectiveQueue* collectives_;
+};
+
+// Sums CPU tensors within each node in a shared memory segment: every local
+// rank copies its buffer into its slot and sums one slice of all slots with
+// the SIMD kernels. The ranks with the same local rank then allreduce their
+// slice across nodes and every rank copies the result out.
+class MPISharedMemoryAllreduce : public MPIAllreduce {
+public:
+  MPISharedMemoryAllreduce(HorovodGlobalState* global_state);
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+
+protected:
+  void DoAllreduce(std::vector<TensorTableEntry>& entries,
+                   const void* fused_input_data, void* buffer_data,
+                   int64_t num_elements, const Response& response) override;
+
+private:
+  static void LocalBarrier(const ProcessSet& process_set);
 };
 
 class MPIAllgather : public AllgatherOp {
 public:
-  MPIAllgather(HorovodGlobalState* global_state);
+  MPIAllgather(HorovodGlobalState* global_state,
+               MPICollectiveQueue* collectives = nullptr);
 
   Status Execute(std::vector<TensorTableEntry>& entries, const Response& response) override;
 
   bool Enabled(const ParameterManager& param_manager,
                const std::vector<TensorTableEntry>& entries,
                const Response& response) const override;
+
+protected:
+  MPICollectiveQueue* collectives_;
 };
 
 class MPIHierarchicalAllgather : public MPIAllgather {
@@ -70,13 +155,38 @@ private:
 
 class MPIBroadcast : public BroadcastOp {
 public:
-  MPIBroadcast(HorovodGlobalState* global_state);
+  MPIBroadcast(HorovodGlobalState* global_state,
+               MPICollectiveQueue* collectives = nullptr);
 
   Status Execute(std::vector<TensorTableEntry>& entries, const Response& response) override;
 
   bool Enabled(const ParameterManager& param_manager,
                const std::vector<TensorTableEntry>& entries,
                const Response& response) const override;
+
+protected:
+  // Broadcasts all entries of a fused response in one call.
+  Status ExecuteFused(std::vector<TensorTableEntry>& entries);
+
+  // Broadcasts num_bytes bytes of data from root_rank with MPI_Bcast, a
+  // pipelined binary tree or a scatter and allgather, depending on the size.
+  void Broadcast(void* data, int64_t num_bytes, int root_rank, MPI_Comm comm);
+
+  void TreeBroadcast(uint8_t* data, int64_t num_bytes, int root_rank,
+                     MPI_Comm comm);
+
+  void ScatterAllgatherBroadcast(uint8_t* data, int64_t num_bytes,
+                                 int root_rank, MPI_Comm comm);
+
+  // Posts an MPI_Ibcast of the entries if the queue is enabled and
+  // Broadcast would make a single MPI_Bcast of num_bytes, with data already
+  // in place. Returns whether it did.
+  bool PostBroadcast(std::vector<TensorTableEntry>& entries, void* data,
+                     int64_t num_bytes, int root_rank, MPI_Comm comm,
+                     std::function<void(std::vector<TensorTableEntry>&)>
+                         finalize = nullptr);
+
+  MPICollectiveQueue* collectives_;
 };
 
 class MPIAlltoall : public AlltoallOp {
@@ -88,6 +198,74 @@ public:
   bool Enabled(const ParameterManager& param_manager,
                const std::vector<TensorTableEntry>& entries,
                const Response& response) const override;
+
+protected:
+  // Packs the entries into the fusion buffer and exchanges them in a single
+  // MPI_Alltoallv of bytes.
+  Status ExecuteFused(std::vector<TensorTableEntry>& entries);
+};
+
+class MPIReducescatter : public ReducescatterOp {
+public:
+  MPIReducescatter(HorovodGlobalState* global_state);
+
+  Status Execute(std::vector<TensorTableEntry>& entries, const Response& response) override;
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+};
+
+// Reduces CPU tensors into the output of the root rank with MPI_Reduce. The
+// other ranks only send, fused entries from the fusion buffer.
+class MPIReduce : public AllreduceOp {
+public:
+  MPIReduce(HorovodGlobalState* global_state);
+
+  Status Execute(std::vector<TensorTableEntry>& entries, const Response& response) override;
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+};
+
+// Gathers a CPU tensor of every rank into the output of the root rank with
+// MPI_Gatherv.
+class MPIGather : public GatherOp {
+public:
+  MPIGather(HorovodGlobalState* global_state);
+
+  Status Execute(std::vector<TensorTableEntry>& entries, const Response& response) override;
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+};
+
+// Posts sends and receives between two ranks with MPI_Isend and MPI_Irecv on
+// the peer communicator and finishes them once MPI has completed them. Only
+// used by the background thread.
+class MPIPeerOperations {
+public:
+  explicit MPIPeerOperations(MPIContext* mpi_context);
+
+  // Posts operations, the receives before the sends.
+  void Post(std::vector<PeerOperation>& operations);
+
+  // Finishes the posted operations that have completed.
+  void Progress();
+
+  // Cancels the posted operations and fails them with status.
+  void Abort(const Status& status);
+
+private:
+  struct Posted {
+    TensorTableEntry entry;
+    std::vector<MPI_Request> requests;
+  };
+
+  MPIContext* mpi_context_;
+  std::list<Posted> posted_;
 };
 
 } // namespace common
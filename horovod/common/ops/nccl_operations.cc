@@ -17,6 +17,12 @@
 
 #include "nccl_operations.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+
+#include "../half.h"
 #if HAVE_MPI
 #include "../mpi/mpi_context.h"
 #endif
@@ -25,7 +31,11 @@ namespace horovod {
 namespace common {
 
 ncclDataType_t GetNCCLDataType(const std::shared_ptr<Tensor> tensor) {
-  switch (tensor->dtype()) {
+  return GetNCCLDataType(tensor->dtype());
+}
+
+ncclDataType_t GetNCCLDataType(DataType dtype) {
+  switch (dtype) {
     case HOROVOD_UINT8:
       return ncclUint8;
     case HOROVOD_INT8:
@@ -36,30 +46,280 @@ ncclDataType_t GetNCCLDataType(const std::shared_ptr<Tensor> tensor) {
       return ncclInt64;
     case HOROVOD_FLOAT16:
       return ncclFloat16;
+#if NCCL_VERSION_CODE >= NCCL_VERSION(2, 10, 0)
+    case HOROVOD_BFLOAT16:
+      return ncclBfloat16;
+#endif
     case HOROVOD_FLOAT32:
       return ncclFloat32;
     case HOROVOD_FLOAT64:
       return ncclFloat64;
     default:
-      throw std::logic_error("Type " + DataType_Name(tensor->dtype()) +
+      throw std::logic_error("Type " + DataType_Name(dtype) +
+                             " is not supported in NCCL mode.");
+  }
+}
+
+ncclRedOp_t GetNCCLReduceOp(ReduceOp reduce_op) {
+  switch (reduce_op) {
+    case ReduceOp::SUM:
+      return ncclSum;
+    case ReduceOp::MIN:
+      return ncclMin;
+    case ReduceOp::MAX:
+      return ncclMax;
+    case ReduceOp::PRODUCT:
+      return ncclProd;
+    default:
+      throw std::logic_error("Reduce op " + ReduceOp_Name(reduce_op) +
                              " is not supported in NCCL mode.");
   }
 }
 
+#ifdef NCCL_PREMULSUM_SUPPORTED
+namespace {
+
+bool PreMulSumSupported(DataType dtype) {
+  return dtype == HOROVOD_FLOAT16 || dtype == HOROVOD_BFLOAT16 ||
+         dtype == HOROVOD_FLOAT32 || dtype == HOROVOD_FLOAT64;
+}
+
+// Reduction that sums the inputs multiplied by factor. Returns ncclAvg when
+// that is what it amounts to, which need not be destroyed.
+ncclRedOp_t CreatePreMulSum(double factor, DataType dtype, ncclComm_t comm,
+                            NCCLContext* nccl_context) {
+  int nranks;
+  nccl_context->ErrorCheck("ncclCommCount", ncclCommCount(comm, &nranks), comm);
+  if (factor == 1.0 / nranks) {
+    return ncclAvg;
+  }
+
+  // The scalar has the type of the data.
+  union {
+    double f64;
+    float f32;
+    unsigned short f16;
+  } scalar;
+  float f32 = (float)factor;
+  if (dtype == HOROVOD_FLOAT64) {
+    scalar.f64 = factor;
+  } else if (dtype == HOROVOD_FLOAT32) {
+    scalar.f32 = f32;
+  } else if (dtype == HOROVOD_FLOAT16) {
+    Float2HalfBits(&f32, &scalar.f16);
+  } else {
+    Float2BFloat16Bits(&f32, &scalar.f16);
+  }
+  ncclRedOp_t op;
+  nccl_context->ErrorCheck("ncclRedOpCreatePreMulSum",
+                           ncclRedOpCreatePreMulSum(&op, &scalar,
+                                                    GetNCCLDataType(dtype),
+                                                    ncclScalarHostImmediate,
+                                                    comm),
+                           comm);
+  return op;
+}
+
+} // namespace
+#endif
+
+NCCLContext::NCCLContext() {
+  std::random_device device;
+  std::mt19937_64 engine(
+      ((uint64_t)device() << 32) ^ device() ^
+      std::chrono::steady_clock::now().time_since_epoch().count());
+  uid = engine();
+}
+
 void NCCLContext::ErrorCheck(std::string op_name, ncclResult_t nccl_result, ncclComm_t& nccl_comm) {
   if (nccl_result != ncclSuccess) {
     ncclCommAbort(nccl_comm);
+    nccl_comm = nullptr;
+    comm_error = true;
     throw std::logic_error(std::string(op_name) + " failed: " + ncclGetErrorString(nccl_result));
   }
 }
 
+ncclResult_t NCCLContext::CommInitRank(ncclComm_t* comm, int nranks,
+                                       ncclUniqueId id, int rank) {
+#ifdef NCCL_MAX_CTAS_SUPPORTED
+  ncclConfig_t config = NCCL_CONFIG_INITIALIZER;
+  if (max_ctas > 0) {
+    config.maxCTAs = max_ctas;
+  }
+  return ncclCommInitRankConfig(comm, nranks, id, rank, &config);
+#else
+  if (max_ctas > 0) {
+    // Older NCCL only reads the limit from the environment, one CTA per
+    // channel. A value the user set takes precedence.
+    setenv("NCCL_MAX_NCHANNELS", std::to_string(max_ctas).c_str(), 0);
+  }
+  return ncclCommInitRank(comm, nranks, id, rank);
+#endif
+}
+
+void NCCLContext::DestroyCaptureComms() {
+  std::lock_guard<std::mutex> guard(capture_mutex);
+  for (auto& entry : capture_comms) {
+    ncclCommDestroy(entry.second);
+  }
+  capture_comms.clear();
+}
+
+void NCCLContext::SplitProcessSetComms(ProcessSetTable& process_set_table,
+                                       GPUContext& gpu_context) {
+  auto ids = process_set_table.Ids();
+  // Ids of removed process sets may be handed out again.
+  for (auto it = split_process_set_ids_.begin();
+       it != split_process_set_ids_.end();) {
+    if (std::find(ids.begin(), ids.end(), *it) == ids.end()) {
+      it = split_process_set_ids_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  auto& global_process_set = process_set_table.Get(0);
+  auto& global_ranks = global_process_set.registered_global_ranks;
+  int global_rank = global_process_set.controller->GetRank();
+  for (auto id : ids) {
+    auto& process_set = process_set_table.Get(id);
+    if (id == 0 || !process_set.initialization_done ||
+        !split_process_set_ids_.insert(id).second) {
+      continue;
+    }
+#ifdef NCCL_COMM_SPLIT_SUPPORTED
+    // registered_global_ranks is sorted
+    auto& ranks = process_set.registered_global_ranks;
+    auto rank_it = std::lower_bound(ranks.begin(), ranks.end(), global_rank);
+    bool included = rank_it != ranks.end() && *rank_it == global_rank;
+
+    // Every process iterates the communicators in the same order: all of
+    // them ran the same operations of the global process set.
+    for (auto& stream_comms : nccl_comms) {
+      std::vector<std::pair<std::vector<int32_t>, ncclComm_t>> parents;
+      for (auto& entry : stream_comms) {
+        if (std::get<0>(entry.first) == global_ranks &&
+            std::get<1>(entry.first) == Communicator::GLOBAL) {
+          parents.emplace_back(std::get<2>(entry.first), entry.second);
+        }
+      }
+      std::sort(parents.begin(), parents.end(),
+                [](const std::pair<std::vector<int32_t>, ncclComm_t>& a,
+                   const std::pair<std::vector<int32_t>, ncclComm_t>& b) {
+                  return a.first < b.first;
+                });
+
+      for (auto& parent : parents) {
+        auto& parent_devices = parent.first;
+        std::vector<int32_t> devices;
+        devices.reserve(ranks.size());
+        for (auto rank : ranks) {
+          devices.push_back(parent_devices[rank]);
+        }
+        // Members that still hold the communicator of an earlier process set
+        // with the same ranks all hold it, and all of them sit the split out.
+        auto key = std::make_tuple(ranks, (int32_t)Communicator::GLOBAL,
+                                   std::move(devices));
+        bool cached = included && stream_comms.count(key) > 0;
+        int color = included && !cached ? 0 : NCCL_SPLIT_NOCOLOR;
+
+        gpu_context.SetDevice(parent_devices[global_rank]);
+        ncclComm_t new_nccl_comm = nullptr;
+        auto nccl_result =
+            ncclCommSplit(parent.second, color, global_rank, &new_nccl_comm,
+                          nullptr);
+        ErrorCheck("ncclCommSplit", nccl_result, parent.second);
+        if (color != NCCL_SPLIT_NOCOLOR) {
+          stream_comms[key] = new_nccl_comm;
+        }
+      }
+    }
+#endif
+  }
+}
+
+void NCCLContext::DetachComms() {
+  // Their ranks do not survive a reset.
+  DestroyCaptureComms();
+  for (size_t stream = 0; stream < nccl_comms.size(); ++stream) {
+    for (auto& entry : nccl_comms[stream]) {
+      if (entry.second == nullptr) {
+        continue;
+      }
+      // NCCL ranks of LOCAL and CROSS communicators depend on the placement
+      // of all processes, so only GLOBAL ones are worth keeping.
+      if (rank_uids_.empty() ||
+          std::get<1>(entry.first) != Communicator::GLOBAL) {
+        ncclCommDestroy(entry.second);
+        continue;
+      }
+      DetachedComm comm;
+      comm.stream = stream;
+      for (auto rank : std::get<0>(entry.first)) {
+        comm.member_uids.push_back(rank_uids_[rank]);
+      }
+      comm.devices = std::get<2>(entry.first);
+      comm.nccl_comm = entry.second;
+      detached_comms_.push_back(std::move(comm));
+    }
+  }
+  nccl_comms.clear();
+  split_process_set_ids_.clear();
+}
+
+void NCCLContext::AttachComms(std::vector<uint64_t> rank_uids, bool discard) {
+  rank_uids_ = std::move(rank_uids);
+  std::unordered_map<uint64_t, int32_t> ranks_by_uid;
+  for (int32_t rank = 0; rank < (int32_t)rank_uids_.size(); ++rank) {
+    ranks_by_uid[rank_uids_[rank]] = rank;
+  }
+
+  for (auto& comm : detached_comms_) {
+    // The NCCL rank of a member is its index in the sorted ranks of the
+    // process set, which has to stay the same.
+    bool survived = !discard && comm.stream < nccl_comms.size();
+    std::vector<int32_t> ranks;
+    for (auto member_uid : comm.member_uids) {
+      auto it = ranks_by_uid.find(member_uid);
+      survived = survived && it != ranks_by_uid.end() &&
+                 (ranks.empty() || it->second > ranks.back());
+      if (!survived) {
+        break;
+      }
+      ranks.push_back(it->second);
+    }
+
+    if (survived) {
+      nccl_comms[comm.stream][std::make_tuple(std::move(ranks),
+                                              (int32_t)Communicator::GLOBAL,
+                                              std::move(comm.devices))] =
+          comm.nccl_comm;
+    } else {
+      ncclCommDestroy(comm.nccl_comm);
+    }
+  }
+  detached_comms_.clear();
+  comm_error = false;
+}
+
 void NCCLContext::ShutDown(){
   for(auto it = nccl_comms.begin(); it != nccl_comms.end(); ++it) {
     for (auto entry = it->begin(); entry != it->end(); ++entry) {
-      ncclCommDestroy(entry->second);
+      if (entry->second != nullptr) {
+        ncclCommDestroy(entry->second);
+      }
     }
   }
   nccl_comms.clear();
+  for (auto& comm : detached_comms_) {
+    ncclCommDestroy(comm.nccl_comm);
+  }
+  detached_comms_.clear();
+  DestroyCaptureComms();
+  split_process_set_ids_.clear();
+  rank_uids_.clear();
+  comm_error = false;
 }
 
 void NCCLOpContext::InitNCCLComm(const std::vector<TensorTableEntry>& entries,
@@ -68,13 +328,16 @@ void NCCLOpContext::InitNCCLComm(const std::vector<TensorTableEntry>& entries,
   auto process_set_id = entries[0].process_set_id;
   auto& process_set = global_state_->process_set_table.Get(process_set_id);
   // Ensure NCCL communicator is in the map before executing operation.
-  // We need to maintain one map per process_set_id to avoid deadlocks
-  // in situations where one process has already built nccl_comm, but
-  // another has not done so yet.
+  // We need to maintain one map per rank list to avoid deadlocks in
+  // situations where one process has already built nccl_comm, but another
+  // has not done so yet. All members of a process set have run the same
+  // operations on it and any earlier one with the same ranks.
   ncclComm_t& nccl_comm =
       nccl_context_
           ->nccl_comms[global_state_->current_nccl_stream]
-                      [std::make_tuple(process_set_id, nccl_device_map)];
+                      [std::make_tuple(process_set.registered_global_ranks,
+                                       (int32_t)communicator_type_,
+                                       nccl_device_map)];
   if (nccl_comm == nullptr) {
     auto& timeline = global_state_->timeline;
     timeline.ActivityStartAll(entries, INIT_NCCL);
@@ -93,7 +356,8 @@ void NCCLOpContext::InitNCCLComm(const std::vector<TensorTableEntry>& entries,
                                   nccl_id_bcast_comm);
 
     ncclComm_t new_nccl_comm;
-    auto nccl_result = ncclCommInitRank(&new_nccl_comm, nccl_size, nccl_id, nccl_rank);
+    auto nccl_result = nccl_context_->CommInitRank(&new_nccl_comm, nccl_size,
+                                                   nccl_id, nccl_rank);
     nccl_context_->ErrorCheck("ncclCommInitRank", nccl_result, nccl_comm);
     nccl_comm = new_nccl_comm;
 
@@ -115,6 +379,7 @@ void NCCLOpContext::AsyncErrorCheck() {
 
   if (nccl_async_err != ncclSuccess) {
     ncclCommAbort(*nccl_comm_);
+    nccl_context_->comm_error = true;
     throw std::logic_error(std::string("NCCL async error: ") + ncclGetErrorString(nccl_async_err));
   }
 
@@ -130,6 +395,9 @@ void NCCLOpContext::PopulateNCCLCommStrategy(int& nccl_rank, int& nccl_size,
   } else if (communicator_type_ == Communicator::LOCAL) {
     nccl_rank = process_set.controller->GetLocalRank();
     nccl_size = process_set.controller->GetLocalSize();
+  } else if (communicator_type_ == Communicator::CROSS) {
+    nccl_rank = process_set.controller->GetCrossRank();
+    nccl_size = process_set.controller->GetCrossSize();
   } else {
     throw std::logic_error("Communicator type " + std::to_string(communicator_type_) +
                             " is not supported in NCCL mode.");
@@ -138,96 +406,427 @@ void NCCLOpContext::PopulateNCCLCommStrategy(int& nccl_rank, int& nccl_size,
 }
 
 void NCCLAllreduce::WaitForData(std::vector<TensorTableEntry>& entries) {
-  if (global_state_->timeline.Initialized()) {
-    // If timeline is initialized, need to use normal CPU syncing path
-    HorovodOp::WaitForData(entries);
-  } else {
-    // Push events to set to deduplicate entries
-    std::unordered_set<gpuEvent_t> event_set;
-    for (auto& e : entries) {
-      e.ready_event_list.PushEventsToSet(event_set);
-    }
-    for (auto& ev : event_set) {
-      HVD_GPU_CHECK(gpuStreamWaitEvent(*gpu_op_context_.stream, ev, 0));
-    }
-  }
+  gpu_op_context_.WaitForData(entries);
 }
 
 Status NCCLAllreduce::Execute(std::vector<TensorTableEntry>& entries,
                               const Response& response) {
-  auto& first_entry = entries[0];
-
   gpu_op_context_.InitGPU(entries);
   nccl_op_context_.InitNCCLComm(entries, response.devices());
   gpu_op_context_.InitGPUQueue(entries, response);
 
   WaitForData(entries);
 
+#ifdef NCCL_GRAPHS_SUPPORTED
+  // Timeline activities need events recorded between the launches, and
+  // compressor state may need allocating, which a capture cannot include.
+  if (global_state_->cuda_graphs && !global_state_->timeline.Initialized() &&
+      !StatefulFusionCompression(entries)) {
+    EnqueueAllreduceGraph(entries, response);
+  } else {
+    EnqueueAllreduce(entries, response);
+  }
+#else
+  EnqueueAllreduce(entries, response);
+#endif
+
+  return gpu_op_context_.FinalizeGPUQueue(entries, true, nccl_op_context_.error_check_callback_);
+}
+
+void NCCLAllreduce::EnqueueAllreduce(std::vector<TensorTableEntry>& entries,
+                                     const Response& response) {
+  auto& first_entry = entries[0];
+
   const void* fused_input_data;
   void* buffer_data;
   size_t buffer_len;
+  auto dtype = first_entry.tensor->dtype();
+  // Fused entries may be compressed on their way into the fusion buffer.
+  bool compressed = entries.size() > 1 && FusionBufferDataType(entries) != dtype;
+
+  // Uncompressed tensors that already sit next to each other are reduced
+  // where they are.
+  bool fused = entries.size() > 1;
+  // Outputs left to Horovod are placed in a pooled block laid out like the
+  // fusion buffer, which the allreduce then reduces in place.
+  bool adopted = first_entry.output == nullptr;
+  void* span_data = nullptr;
+  size_t span_len = 0;
+  bool zero_copy = fused && !compressed && !adopted &&
+                   GetZeroCopySpan(entries, span_data, span_len);
+  double prescale_factor = response.prescale_factor();
+  double postscale_factor = response.postscale_factor();
+  if ((!fused || zero_copy) && FoldPrescale(entries, response)) {
+    postscale_factor *= prescale_factor;
+    prescale_factor = 1.0;
+  }
+  // Factor the allreduce multiplies the inputs by before summing them.
+  double reduce_factor = 1.0;
+#ifdef NCCL_PREMULSUM_SUPPORTED
+  // Scaling that is not part of a copy through the fusion buffer would take
+  // a pass of its own over the data, NCCL does it inside the allreduce.
+  if (!compressed && (!fused || zero_copy || adopted) &&
+      response.reduce_op() == ReduceOp::SUM && PreMulSumSupported(dtype)) {
+    reduce_factor = postscale_factor;
+    if (!fused || zero_copy) {
+      reduce_factor *= prescale_factor;
+      prescale_factor = 1.0;
+    }
+    postscale_factor = 1.0;
+  }
+#endif
 
   // Copy (and possibly scale) tensors into the fusion buffer.
-  if (entries.size() > 1) {
+  if (compressed) {
+    dtype = FusionBufferDataType(entries);
+    CompressMemcpyInFusionBuffer(entries, fused_input_data, buffer_data, buffer_len, response.prescale_factor());
+    if (global_state_->timeline.Initialized()) {
+      gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_IN_FUSION_BUFFER, *gpu_op_context_.stream);
+    }
+  } else if (zero_copy) {
+    fused_input_data = span_data;
+    buffer_data = span_data;
+    buffer_len = span_len;
+    if (prescale_factor != 1.0) {
+      ScaleBuffer(prescale_factor, entries, buffer_data, buffer_data,
+                  (int64_t)(buffer_len / DataType_Size(dtype)));
+    }
+  } else if (fused && adopted) {
+    AdoptOutputs(entries, buffer_data, buffer_len);
+    ScaleMemcpyInBuffer(entries, buffer_data, buffer_len, response.prescale_factor());
+    fused_input_data = buffer_data;
+    if (global_state_->timeline.Initialized()) {
+      gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_IN_FUSION_BUFFER, *gpu_op_context_.stream);
+    }
+  } else if (fused) {
     ScaleMemcpyInFusionBuffer(entries, fused_input_data, buffer_data, buffer_len, response.prescale_factor());
     if (global_state_->timeline.Initialized()) {
       gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_IN_FUSION_BUFFER, *gpu_op_context_.stream);
     }
   } else {
+    if (adopted) {
+      AdoptOutputs(entries, buffer_data, buffer_len);
+    }
     fused_input_data = first_entry.tensor->data();
     buffer_data = (void*) first_entry.output->data();
     buffer_len = (size_t) first_entry.output->size();
     int64_t num_elements = buffer_len / DataType_Size(first_entry.tensor->dtype());
-    if (response.prescale_factor() != 1.0) {
+    if (prescale_factor != 1.0) {
       // Execute prescaling op
-      ScaleBuffer(response.prescale_factor(), entries, fused_input_data, buffer_data, num_elements);
+      ScaleBuffer(prescale_factor, entries, fused_input_data, buffer_data, num_elements);
       fused_input_data = buffer_data; // for unfused, scale is done out of place
     }
   }
 
   // Do allreduce.
-  int64_t num_elements = buffer_len / DataType_Size(first_entry.tensor->dtype());
+  int64_t num_elements = buffer_len / DataType_Size(dtype);
+  auto reduce_op = GetNCCLReduceOp(response.reduce_op());
+#ifdef NCCL_PREMULSUM_SUPPORTED
+  if (reduce_factor != 1.0) {
+    reduce_op = CreatePreMulSum(reduce_factor, dtype,
+                                *nccl_op_context_.nccl_comm_, nccl_context_);
+  }
+#endif
   auto nccl_result = ncclAllReduce(fused_input_data, buffer_data,
                                    (size_t) num_elements,
-                                   GetNCCLDataType(first_entry.tensor), ncclSum,
+                                   GetNCCLDataType(dtype),
+                                   reduce_op,
                                    *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream);
+#ifdef NCCL_PREMULSUM_SUPPORTED
+  // Only needed until the allreduce is enqueued.
+  if (reduce_factor != 1.0 && reduce_op != ncclAvg) {
+    ncclRedOpDestroy(reduce_op, *nccl_op_context_.nccl_comm_);
+  }
+#endif
   nccl_context_->ErrorCheck("ncclAllReduce", nccl_result, *nccl_op_context_.nccl_comm_);
   if (global_state_->timeline.Initialized()) {
     gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_ALLREDUCE, *gpu_op_context_.stream);
   }
 
   // Copy (and possible scale) tensors out of the fusion buffer.
-  if (entries.size() > 1) {
+  if (compressed) {
+    DecompressMemcpyOutFusionBuffer(buffer_data, response.postscale_factor(), entries);
+    if (global_state_->timeline.Initialized()) {
+      gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_OUT_FUSION_BUFFER, *gpu_op_context_.stream);
+    }
+  } else if (fused && !zero_copy && !adopted) {
     ScaleMemcpyOutFusionBuffer(buffer_data, buffer_len, response.postscale_factor(), entries);
 
     if (global_state_->timeline.Initialized()) {
       gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_OUT_FUSION_BUFFER, *gpu_op_context_.stream);
     }
   } else {
-    if (response.postscale_factor() != 1.0) {
+    if (postscale_factor != 1.0) {
       // Execute postscaling op
-      ScaleBuffer(response.postscale_factor(), entries, buffer_data, buffer_data, num_elements);
+      ScaleBuffer(postscale_factor, entries, buffer_data, buffer_data, num_elements);
     }
   }
+}
 
-  return gpu_op_context_.FinalizeGPUQueue(entries, true, nccl_op_context_.error_check_callback_);
+bool NCCLAllreduce::AdoptsOutputs(const std::vector<TensorTableEntry>& entries,
+                                  const Response& response) const {
+  for (auto& e : entries) {
+    if (e.output != nullptr) {
+      return false;
+    }
+  }
+#ifdef NCCL_GRAPHS_SUPPORTED
+  // Graphs are keyed on the output addresses, which would change every time.
+  if (global_state_->cuda_graphs && !global_state_->timeline.Initialized()) {
+    return false;
+  }
+#endif
+  if (entries.size() > 1) {
+    // Only the batched copies pad fused entries, which keeps the outputs
+    // aligned within the block.
+    return FusionBufferDataType(entries) == entries[0].tensor->dtype() &&
+           global_state_->parameter_manager.BatchD2DMemcopies();
+  }
+  return true;
 }
 
-#if HAVE_MPI
-void NCCLHierarchicalAllreduce::WaitForData(std::vector<TensorTableEntry>& entries) {
+namespace {
+
+// Alignment of the part of the fusion buffer each response of a group
+// stages in, whatever the data type of the one before.
+constexpr size_t GROUP_STAGING_ALIGNMENT = 256;
+
+size_t AlignGroupStaging(size_t offset) {
+  return (offset + GROUP_STAGING_ALIGNMENT - 1) / GROUP_STAGING_ALIGNMENT *
+         GROUP_STAGING_ALIGNMENT;
+}
+
+} // namespace
+
+bool NCCLAllreduce::Groups(
+    const std::vector<std::vector<TensorTableEntry>>& entries_list,
+    const std::vector<Response>& responses) const {
+#ifdef NCCL_GRAPHS_SUPPORTED
+  // Repeated responses are replayed from their own graphs instead.
+  if (global_state_->cuda_graphs && !global_state_->timeline.Initialized()) {
+    return false;
+  }
+#endif
+  auto& first_entry = entries_list[0][0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  size_t staged = 0;
+  for (size_t i = 0; i < responses.size(); ++i) {
+    auto& entries = entries_list[i];
+    if (responses[i].devices() != responses[0].devices() ||
+        entries[0].device != first_entry.device ||
+        entries[0].context->framework() != first_entry.context->framework() ||
+        FusionBufferDataType(entries) != entries[0].tensor->dtype()) {
+      return false;
+    }
+    if (entries.size() > 1) {
+      for (auto& e : entries) {
+        staged += FusionBufferEntrySize(e);
+      }
+      staged = AlignGroupStaging(staged);
+    }
+  }
+  return staged <= (size_t)process_set.controller->TensorFusionThresholdBytes();
+}
+
+Status NCCLAllreduce::ExecuteGroup(
+    std::vector<std::vector<TensorTableEntry>>& entries_list,
+    const std::vector<Response>& responses) {
+  std::vector<TensorTableEntry> all_entries;
+  for (auto& entries : entries_list) {
+    all_entries.insert(all_entries.end(), entries.begin(), entries.end());
+  }
+  auto& first_entry = all_entries[0];
+
+  gpu_op_context_.InitGPU(all_entries);
+  nccl_op_context_.InitNCCLComm(all_entries, responses[0].devices());
+  gpu_op_context_.InitGPUQueue(all_entries, responses[0]);
+
+  WaitForData(all_entries);
+
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  uint8_t* fusion_data = nullptr;
+  std::vector<const void*> inputs(responses.size());
+  std::vector<void*> outputs(responses.size());
+  std::vector<size_t> lengths(responses.size());
+  std::vector<double> postscale_factors(responses.size());
+  size_t offset = 0;
+  for (size_t i = 0; i < responses.size(); ++i) {
+    auto& entries = entries_list[i];
+    auto& response = responses[i];
+    postscale_factors[i] = response.postscale_factor();
+    if (entries.size() > 1) {
+      if (fusion_data == nullptr) {
+        auto buffer = process_set.fusion_buffer.GetBuffer(
+            first_entry.device, first_entry.context->framework(),
+            global_state_->current_nccl_stream);
+        fusion_data =
+            (uint8_t*)const_cast<void*>(buffer->AccessData(first_entry.context));
+      }
+      outputs[i] = fusion_data + offset;
+      ScaleMemcpyInBuffer(entries, outputs[i], lengths[i],
+                          response.prescale_factor());
+      inputs[i] = outputs[i];
+      offset = AlignGroupStaging(offset + lengths[i]);
+    } else {
+      auto& e = entries[0];
+      inputs[i] = e.tensor->data();
+      outputs[i] = (void*)e.output->data();
+      lengths[i] = (size_t)e.output->size();
+      double prescale_factor = response.prescale_factor();
+      if (FoldPrescale(entries, response)) {
+        postscale_factors[i] *= prescale_factor;
+        prescale_factor = 1.0;
+      }
+      if (prescale_factor != 1.0) {
+        ScaleBuffer(prescale_factor, entries, inputs[i], outputs[i],
+                    (int64_t)(lengths[i] / DataType_Size(e.tensor->dtype())));
+        inputs[i] = outputs[i];
+      }
+    }
+  }
+  if (fusion_data != nullptr && global_state_->timeline.Initialized()) {
+    gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_IN_FUSION_BUFFER, *gpu_op_context_.stream);
+  }
+
+  auto& comm = *nccl_op_context_.nccl_comm_;
+  nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(), comm);
+  for (size_t i = 0; i < responses.size(); ++i) {
+    auto dtype = entries_list[i][0].tensor->dtype();
+    auto nccl_result = ncclAllReduce(inputs[i], outputs[i],
+                                     lengths[i] / DataType_Size(dtype),
+                                     GetNCCLDataType(dtype),
+                                     GetNCCLReduceOp(responses[i].reduce_op()),
+                                     comm, *gpu_op_context_.stream);
+    nccl_context_->ErrorCheck("ncclAllReduce", nccl_result, comm);
+  }
+  nccl_context_->ErrorCheck("ncclGroupEnd", ncclGroupEnd(), comm);
   if (global_state_->timeline.Initialized()) {
-    // If timeline is initialized, need to use normal CPU syncing path
-    HorovodOp::WaitForData(entries);
-  } else {
-    // Push events to set to deduplicate entries
-    std::unordered_set<gpuEvent_t> event_set;
-    for (auto& e : entries) {
-      e.ready_event_list.PushEventsToSet(event_set);
+    gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_ALLREDUCE, *gpu_op_context_.stream);
+  }
+
+  for (size_t i = 0; i < responses.size(); ++i) {
+    auto& entries = entries_list[i];
+    if (entries.size() > 1) {
+      ScaleMemcpyOutFusionBuffer(outputs[i], lengths[i], postscale_factors[i],
+                                 entries);
+    } else if (postscale_factors[i] != 1.0) {
+      ScaleBuffer(postscale_factors[i], entries, outputs[i], outputs[i],
+                  (int64_t)(lengths[i] /
+                            DataType_Size(entries[0].tensor->dtype())));
+    }
+  }
+  if (fusion_data != nullptr && global_state_->timeline.Initialized()) {
+    gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_OUT_FUSION_BUFFER, *gpu_op_context_.stream);
+  }
+
+  return gpu_op_context_.FinalizeGPUQueue(all_entries, true, nccl_op_context_.error_check_callback_);
+}
+
+#ifdef NCCL_GRAPHS_SUPPORTED
+std::vector<int64_t>
+NCCLAllreduce::GraphSignature(const std::vector<TensorTableEntry>& entries,
+                              const Response& response) {
+  auto& first_entry = entries[0];
+  double prescale_factor = response.prescale_factor();
+  double postscale_factor = response.postscale_factor();
+  int64_t prescale_bits, postscale_bits;
+  std::memcpy(&prescale_bits, &prescale_factor, sizeof(prescale_bits));
+  std::memcpy(&postscale_bits, &postscale_factor, sizeof(postscale_bits));
+
+  std::vector<int64_t> signature{
+      first_entry.device,
+      global_state_->current_nccl_stream,
+      (int64_t)(intptr_t)*nccl_op_context_.nccl_comm_,
+      (int64_t)first_entry.tensor->dtype(),
+      (int64_t)response.reduce_op(),
+      prescale_bits,
+      postscale_bits,
+      (int64_t)global_state_->parameter_manager.BatchD2DMemcopies()};
+  signature.reserve(signature.size() + 2 + 3 * entries.size());
+  if (entries.size() > 1) {
+    auto& process_set =
+        global_state_->process_set_table.Get(first_entry.process_set_id);
+    auto buffer = process_set.fusion_buffer.GetBuffer(
+        first_entry.device, first_entry.context->framework(),
+        global_state_->current_nccl_stream);
+    signature.push_back(
+        (int64_t)(intptr_t)buffer->AccessData(first_entry.context));
+    signature.push_back((int64_t)FusionBufferDataType(entries));
+  }
+  for (auto& e : entries) {
+    signature.push_back((int64_t)(intptr_t)e.tensor->data());
+    signature.push_back((int64_t)(intptr_t)e.output->data());
+    signature.push_back(e.tensor->size());
+  }
+  return signature;
+}
+
+void NCCLAllreduce::EnqueueAllreduceGraph(std::vector<TensorTableEntry>& entries,
+                                          const Response& response) {
+  auto key = std::make_pair(entries[0].process_set_id,
+                            response.tensor_names_string());
+  auto it = graphs_.find(key);
+  if (it == graphs_.end()) {
+    if (graphs_.size() >= MAX_CAPTURED_GRAPHS) {
+      EnqueueAllreduce(entries, response);
+      return;
     }
-    for (auto& ev : event_set) {
-      HVD_GPU_CHECK(gpuStreamWaitEvent(*gpu_op_context_.stream, ev, 0));
+    it = graphs_.emplace(key, CapturedGraph()).first;
+  }
+  auto& graph = it->second;
+  if (graph.recaptures > MAX_GRAPH_RECAPTURES) {
+    EnqueueAllreduce(entries, response);
+    return;
+  }
+
+  auto& stream = *gpu_op_context_.stream;
+  auto signature = GraphSignature(entries, response);
+  if (signature != graph.signature) {
+    if (graph.exec != nullptr) {
+      // The previous launch of this graph may still be running.
+      gpu_context_->StreamSynchronize(stream);
+      HVD_GPU_CHECK(cudaGraphExecDestroy(graph.exec));
+      graph.exec = nullptr;
+    }
+    if (!graph.signature.empty()) {
+      ++graph.recaptures;
+    }
+    graph.signature = std::move(signature);
+    graph.uses = 0;
+  }
+
+  // Only capture responses that have already run once on the same buffers.
+  if (graph.exec == nullptr && ++graph.uses < 2) {
+    EnqueueAllreduce(entries, response);
+    return;
+  }
+
+  if (graph.exec == nullptr) {
+    cudaGraph_t captured;
+    HVD_GPU_CHECK(cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+    try {
+      EnqueueAllreduce(entries, response);
+    } catch (...) {
+      if (cudaStreamEndCapture(stream, &captured) == cudaSuccess) {
+        cudaGraphDestroy(captured);
+      }
+      throw;
     }
+    HVD_GPU_CHECK(cudaStreamEndCapture(stream, &captured));
+    auto result = cudaGraphInstantiateWithFlags(&graph.exec, captured, 0);
+    cudaGraphDestroy(captured);
+    HVD_GPU_CHECK(result);
   }
+
+  HVD_GPU_CHECK(cudaGraphLaunch(graph.exec, stream));
+}
+#endif
+
+#if HAVE_MPI
+void NCCLHierarchicalAllreduce::WaitForData(std::vector<TensorTableEntry>& entries) {
+  gpu_op_context_.WaitForData(entries);
 }
 
 Status
@@ -257,7 +856,8 @@ NCCLHierarchicalAllreduce::Execute(std::vector<TensorTableEntry>& entries,
   size_t buffer_len;
 
   // Copy memory into the fusion buffer.
-  if (entries.size() > 1) {
+  bool staged = StagesInFusionBuffer(entries, response);
+  if (staged) {
     MemcpyInFusionBuffer(entries, fused_input_data, buffer_data, buffer_len);
 
     if (global_state_->timeline.Initialized()) {
@@ -286,11 +886,8 @@ NCCLHierarchicalAllreduce::Execute(std::vector<TensorTableEntry>& entries,
   // dummy elements from the buffer (if necessary) to make sure the data
   // is divisible by local_size. This is always possible since we
   // set the fusion buffer size divisible by local_size.
-  if (process_set.controller->IsHomogeneous() && entries.size() > 1) {
-    // Making sure the number of elements is divisible by
-    // FUSION_BUFFER_ATOMIC_UNIT for improved performance
-    int div = local_size * FUSION_BUFFER_ATOMIC_UNIT;
-    num_elements = ((num_elements + div - 1) / div) * div;
+  if (process_set.controller->IsHomogeneous() && staged) {
+    num_elements = PaddedNumElements(num_elements, local_size);
     buffer_len = num_elements * element_size;
   }
 
@@ -319,8 +916,6 @@ NCCLHierarchicalAllreduce::Execute(std::vector<TensorTableEntry>& entries,
                                        ? num_elements % local_size
                                        : num_elements;
 
-  size_t buffer_len_remaining = element_size * num_elements_remaining;
-
   void* buffer_data_remainder =
       (uint8_t*)buffer_data + buffer_len_per_rank * local_size;
 
@@ -333,9 +928,6 @@ NCCLHierarchicalAllreduce::Execute(std::vector<TensorTableEntry>& entries,
   int64_t total_num_elements =
       is_root_rank ? num_elements_per_rank + num_elements_remaining
                    : num_elements_per_rank;
-  int64_t total_buffer_len = is_root_rank
-                                 ? buffer_len_per_rank + buffer_len_remaining
-                                 : buffer_len_per_rank;
 
   auto& timeline = global_state_->timeline;
   if (num_elements_per_rank > 0) {
@@ -343,7 +935,8 @@ NCCLHierarchicalAllreduce::Execute(std::vector<TensorTableEntry>& entries,
                                          buffer_data_at_rank_offset,
                                          (size_t) num_elements_per_rank,
                                          GetNCCLDataType(first_entry.tensor),
-                                         ncclSum, *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream);
+                                         GetNCCLReduceOp(response.reduce_op()),
+                                         *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream);
     nccl_context_->ErrorCheck("ncclReduceScatter", nccl_result, *nccl_op_context_.nccl_comm_);
     if (global_state_->timeline.Initialized()) {
       gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_REDUCESCATTER, *gpu_op_context_.stream);
@@ -356,7 +949,8 @@ NCCLHierarchicalAllreduce::Execute(std::vector<TensorTableEntry>& entries,
     auto nccl_result = ncclReduce(fused_input_data_remainder,
                                   buffer_data_remainder,
                                   (size_t) num_elements_remaining,
-                                  GetNCCLDataType(first_entry.tensor), ncclSum,
+                                  GetNCCLDataType(first_entry.tensor),
+                                  GetNCCLReduceOp(response.reduce_op()),
                                   root_rank, *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream);
     nccl_context_->ErrorCheck("ncclReduce", nccl_result, *nccl_op_context_.nccl_comm_);
     if (global_state_->timeline.Initialized()) {
@@ -365,38 +959,12 @@ NCCLHierarchicalAllreduce::Execute(std::vector<TensorTableEntry>& entries,
   }
 
   if (process_set.controller->IsHomogeneous() || is_root_rank) {
-    // cudaHostAlloc is significantly slower than malloc.  Pre-allocating
-    // a buffer is not safe since the tensor can be arbitrarily large.
-    gpu_op_context_.host_buffer = malloc(total_buffer_len);
-
     // Synchronize.
     gpu_context_->WaitForEvents(gpu_op_context_.event_queue, entries, timeline, nccl_op_context_.error_check_callback_,
                                 global_state_->elastic_enabled);
 
-    // According to https://docs.nvidia.com/cuda/cuda-runtime-api/
-    // api-sync-behavior.html#api-sync-behavior__memcpy-async,
-    // cudaMemcpyAsync is synchronous with respect to the host, so we
-    // memcpy (effectively) synchronously to generate an accurate timeline
-    timeline.ActivityStartAll(entries, MEMCPY_IN_HOST_BUFFER);
-    gpu_context_->MemcpyAsyncD2H(gpu_op_context_.host_buffer, buffer_data_at_rank_offset,
-                                 total_buffer_len, *gpu_op_context_.stream);
-    timeline.ActivityEndAll(entries);
-
-    timeline.ActivityStartAll(entries, MPI_ALLREDUCE);
-    int op = MPI_Allreduce(MPI_IN_PLACE, gpu_op_context_.host_buffer,
-                           (int) total_num_elements,
-                           mpi_context.GetMPIDataType(first_entry.tensor),
-                           mpi_context.GetMPISumOp(first_entry.tensor->dtype()),
-                           mpi_context.GetMPICommunicator(Communicator::CROSS));
-    if (op != MPI_SUCCESS) {
-      throw std::runtime_error("MPI_Allreduce failed, see MPI output for details.");
-    }
-    timeline.ActivityEndAll(entries);
-
-    timeline.ActivityStartAll(entries, MEMCPY_OUT_HOST_BUFFER);
-    gpu_context_->MemcpyAsyncH2D(buffer_data_at_rank_offset, gpu_op_context_.host_buffer,
-                                 total_buffer_len, *gpu_op_context_.stream);
-    timeline.ActivityEndAll(entries);
+    PipelinedCrossAllreduce(entries, response, buffer_data_at_rank_offset,
+                            total_num_elements);
   }
 
   if (num_elements_per_rank > 0) {
@@ -428,7 +996,7 @@ NCCLHierarchicalAllreduce::Execute(std::vector<TensorTableEntry>& entries,
   }
 
   // Copy memory out of the fusion buffer.
-  if (entries.size() > 1) {
+  if (staged) {
     MemcpyOutFusionBuffer(buffer_data, entries);
 
     if (global_state_->timeline.Initialized()) {
@@ -439,86 +1007,186 @@ NCCLHierarchicalAllreduce::Execute(std::vector<TensorTableEntry>& entries,
   return gpu_op_context_.FinalizeGPUQueue(entries, true, nccl_op_context_.error_check_callback_);
 }
 
-bool NCCLHierarchicalAllreduce::Enabled(const ParameterManager& param_manager,
-                                        const std::vector<TensorTableEntry>& entries,
-                                        const Response& response) const {
-  if (!NCCLAllreduce::Enabled(param_manager, entries, response)) {
+bool NCCLHierarchicalAllreduce::StagesInFusionBuffer(
+    const std::vector<TensorTableEntry>& entries,
+    const Response& response) const {
+  if (entries.size() > 1) {
+    return true;
+  }
+  auto& e = entries[0];
+  auto& controller =
+      *global_state_->process_set_table.Get(e.process_set_id).controller;
+  int local_size = controller.GetLocalSize();
+  int64_t num_elements = e.tensor->shape().num_elements();
+  if (!controller.IsHomogeneous() || num_elements % local_size == 0) {
     return false;
   }
-  return param_manager.HierarchicalAllreduce();
+  // The fusion buffer holds at least the fusion threshold.
+  return PaddedNumElements(num_elements, local_size) *
+             DataType_Size(e.tensor->dtype()) <=
+         controller.TensorFusionThresholdBytes();
 }
-#endif
 
-void NCCLBroadcast::WaitForData(std::vector<TensorTableEntry>& entries) {
-  if (global_state_->timeline.Initialized()) {
-    // If timeline is initialized, need to use normal CPU syncing path
-    HorovodOp::WaitForData(entries);
-  } else {
-    // Push events to set to deduplicate entries
-    std::unordered_set<gpuEvent_t> event_set;
-    for (auto& e : entries) {
-      e.ready_event_list.PushEventsToSet(event_set);
+int64_t NCCLHierarchicalAllreduce::PaddedNumElements(int64_t num_elements,
+                                                     int local_size) {
+  // Making sure the number of elements is divisible by
+  // FUSION_BUFFER_ATOMIC_UNIT for improved performance
+  int64_t div = local_size * FUSION_BUFFER_ATOMIC_UNIT;
+  return ((num_elements + div - 1) / div) * div;
+}
+
+void NCCLHierarchicalAllreduce::PipelinedCrossAllreduce(
+    std::vector<TensorTableEntry>& entries, const Response& response,
+    void* buffer, int64_t num_elements) {
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+  const auto& mpi_context = process_set.mpi_context;
+  auto& timeline = global_state_->timeline;
+  auto& stream = *gpu_op_context_.stream;
+
+  // Only the data sent across nodes is compressed, into a device buffer
+  // that the reduced data is decompressed from again.
+  auto dtype = CrossNodeDataType(entries, response);
+  std::shared_ptr<OutputBlock> compressed;
+  double compression_scale = 1.0;
+  void* full_buffer = buffer;
+  if (dtype != first_entry.tensor->dtype() && num_elements > 0) {
+    compressed = gpu_context_->AcquireOutputBlock(
+        (size_t)num_elements * DataType_Size(dtype), first_entry.device,
+        stream);
+    if (dtype == HOROVOD_FLOAT16) {
+      // So that the sum does not overflow float16 where the inputs do not.
+      compression_scale = 1.0 / process_set.controller->GetCrossSize();
     }
-    for (auto& ev : event_set) {
-      HVD_GPU_CHECK(gpuStreamWaitEvent(*gpu_op_context_.stream, ev, 0));
+    gpu_context_->ScaledCastBufferImpl(full_buffer, compressed->data(),
+                                       num_elements, compression_scale,
+                                       first_entry.tensor->dtype(), dtype,
+                                       stream);
+    buffer = compressed->data();
+  }
+
+  int element_size = mpi_context.GetMPITypeSize(dtype);
+  size_t buffer_len = (size_t)num_elements * element_size;
+
+  // The staging buffer is page-locked, so that the copies are truly
+  // asynchronous. It is returned to the pool by FinalizeGPUQueue.
+  gpu_op_context_.host_buffer = gpu_context_->AcquireHostBuffer(buffer_len);
+  gpu_op_context_.host_buffer_pinned = true;
+  auto host_buffer = (uint8_t*)gpu_op_context_.host_buffer;
+
+  int64_t chunk_elements = num_elements;
+  if (global_state_->hierarchical_allreduce_chunk_size > 0) {
+    chunk_elements = std::max(
+        global_state_->hierarchical_allreduce_chunk_size / element_size,
+        (int64_t)1);
+  }
+  int64_t num_chunks =
+      num_elements > 0 ? (num_elements + chunk_elements - 1) / chunk_elements
+                       : 0;
+
+  auto& h2d_stream = host_to_device_streams_[first_entry.device];
+  if (h2d_stream == nullptr) {
+    gpu_context_->StreamCreate(&h2d_stream);
+    gpu_context_->StreamSetName(
+        h2d_stream, "Horovod host staging (device " +
+                        std::to_string(first_entry.device) + ")");
+  }
+
+  // Queue all device to host copies up front, with an event after each
+  // chunk to tell when it has arrived.
+  timeline.ActivityStartAll(entries, MEMCPY_IN_HOST_BUFFER);
+  std::vector<Event> chunk_events;
+  chunk_events.reserve(num_chunks);
+  {
+    NvtxPhaseRange range(RegisteredNvtxPhase::HostStagingMemcpyIn,
+                         gpu_op_context_.correlation_id);
+    for (int64_t i = 0; i < num_chunks; ++i) {
+      size_t offset = (size_t)(i * chunk_elements) * element_size;
+      size_t len =
+          (size_t)std::min(chunk_elements, num_elements - i * chunk_elements) *
+          element_size;
+      gpu_context_->MemcpyAsyncD2H(host_buffer + offset,
+                                   (uint8_t*)buffer + offset, len, stream);
+      chunk_events.push_back(gpu_context_->RecordEvent(stream));
     }
   }
-}
+  timeline.ActivityEndAll(entries);
 
-Status NCCLBroadcast::Execute(std::vector<TensorTableEntry>& entries,
-                              const Response& response) {
-  assert(entries.size() == 1);
-  auto e = entries[0];
-  auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
+  timeline.ActivityStartAll(entries, MPI_ALLREDUCE);
+  for (int64_t i = 0; i < num_chunks; ++i) {
+    size_t offset = (size_t)(i * chunk_elements) * element_size;
+    int64_t count = std::min(chunk_elements, num_elements - i * chunk_elements);
 
-  gpu_op_context_.InitGPU(entries);
-  nccl_op_context_.InitNCCLComm(entries, response.devices());
-  gpu_op_context_.InitGPUQueue(entries, response);
+    GPUEventQueue chunk_queue;
+    chunk_queue.push("", chunk_events[i]);
+    gpu_context_->WaitForEvents(chunk_queue, entries, timeline,
+                                nccl_op_context_.error_check_callback_,
+                                global_state_->elastic_enabled);
 
-  WaitForData(entries);
+    int op = MPI_Allreduce(MPI_IN_PLACE, host_buffer + offset, (int)count,
+                           mpi_context.GetMPIDataType(dtype),
+                           mpi_context.GetMPIOp(dtype, response.reduce_op()),
+                           mpi_context.GetMPICommunicator(Communicator::CROSS));
+    if (op != MPI_SUCCESS) {
+      throw std::runtime_error("MPI_Allreduce failed, see MPI output for details.");
+    }
 
-  // On root rank, ncclbcast sends data, on other ranks it receives data.
-  void* data_ptr;
-  if (process_set.controller->GetRank() == e.root_rank) {
-    data_ptr = (void*) e.tensor->data();
-  } else {
-    data_ptr = (void*) e.output->data();
-  }
-
-  // We only use 'ncclChar' for this operation because the type format does not matter for a
-  // broadcast, only the size of the data.
-  nccl_context_->ErrorCheck("ncclBcast",
-                            ncclBcast(data_ptr,
-                                      e.tensor->shape().num_elements() *
-                                      DataType_Size(e.tensor->dtype()),
-                                      ncclChar, e.root_rank,
-                                      *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream),
-                            *nccl_op_context_.nccl_comm_);
-  if (global_state_->timeline.Initialized()) {
-    gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_BCAST, *gpu_op_context_.stream);
+    NvtxPhaseRange range(RegisteredNvtxPhase::HostStagingMemcpyOut,
+                         gpu_op_context_.correlation_id);
+    gpu_context_->MemcpyAsyncH2D((uint8_t*)buffer + offset,
+                                 host_buffer + offset,
+                                 (size_t)count * element_size, h2d_stream);
   }
+  timeline.ActivityEndAll(entries);
+
+  // Later work on the op stream must see the reduced data.
+  auto h2d_done = gpu_context_->RecordEvent(h2d_stream);
+  HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *h2d_done.event, 0));
+
+  if (compressed) {
+    gpu_context_->ScaledCastBufferImpl(compressed->data(), full_buffer,
+                                       num_elements, 1.0 / compression_scale,
+                                       dtype, first_entry.tensor->dtype(),
+                                       stream);
+    compressed->RecordRelease(stream);
+  }
+}
 
-  return gpu_op_context_.FinalizeGPUQueue(entries, true, nccl_op_context_.error_check_callback_);
+DataType NCCLHierarchicalAllreduce::CrossNodeDataType(
+    const std::vector<TensorTableEntry>& entries,
+    const Response& response) const {
+  auto dtype = entries[0].tensor->dtype();
+  // The custom MPI ops of the 16-bit types only sum.
+  if (dtype != HOROVOD_FLOAT32 || response.reduce_op() != ReduceOp::SUM) {
+    return dtype;
+  }
+  switch (global_state_->hierarchical_allreduce_compression) {
+  case FusionCompression::FP16:
+    return HOROVOD_FLOAT16;
+  case FusionCompression::BF16:
+    return HOROVOD_BFLOAT16;
+  default:
+    return dtype;
+  }
 }
 
-void NCCLAllgather::WaitForData(std::vector<TensorTableEntry>& entries) {
-  if (global_state_->timeline.Initialized()) {
-    // If timeline is initialized, need to use normal CPU syncing path
-    HorovodOp::WaitForData(entries);
-  } else {
-    // Push events to set to deduplicate entries
-    std::unordered_set<gpuEvent_t> event_set;
-    for (auto& e : entries) {
-      e.ready_event_list.PushEventsToSet(event_set);
-    }
-    for (auto& ev : event_set) {
-      HVD_GPU_CHECK(gpuStreamWaitEvent(*gpu_op_context_.stream, ev, 0));
-    }
+bool NCCLHierarchicalAllreduce::Enabled(const ParameterManager& param_manager,
+                                        const std::vector<TensorTableEntry>& entries,
+                                        const Response& response) const {
+  if (!NCCLAllreduce::Enabled(param_manager, entries, response)) {
+    return false;
   }
+  return param_manager.HierarchicalAllreduce();
 }
+#endif
 
-Status NCCLAllgather::Execute(std::vector<TensorTableEntry>& entries,
-                                const Response& response) {
+void NCCLReduce::WaitForData(std::vector<TensorTableEntry>& entries) {
+  gpu_op_context_.WaitForData(entries);
+}
+
+Status NCCLReduce::Execute(std::vector<TensorTableEntry>& entries,
+                           const Response& response) {
   assert(!entries.empty());
   auto& first_entry = entries[0];
   auto& process_set =
@@ -530,17 +1198,199 @@ Status NCCLAllgather::Execute(std::vector<TensorTableEntry>& entries,
 
   WaitForData(entries);
 
-  // Sizes of subcomponents of each entry from all ranks
-  auto** entry_component_sizes = new int64_t* [entries.size()];
+  bool is_root = process_set.controller->GetRank() == first_entry.root_rank;
+  auto dtype = first_entry.tensor->dtype();
+  double postscale_factor = response.postscale_factor();
 
-  // Offset of each subcomponent of every entry in the final buffer after
+  const void* fused_input_data;
+  void* buffer_data;
+  size_t buffer_len;
+  bool fused = entries.size() > 1;
+  if (fused) {
+    ScaleMemcpyInFusionBuffer(entries, fused_input_data, buffer_data,
+                              buffer_len, response.prescale_factor());
+    if (global_state_->timeline.Initialized()) {
+      gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_IN_FUSION_BUFFER, *gpu_op_context_.stream);
+    }
+  } else {
+    // The other ranks reduce "in place", ncclReduce only writes on the root.
+    fused_input_data = first_entry.tensor->data();
+    buffer_data = is_root ? (void*)first_entry.output->data()
+                          : (void*)first_entry.tensor->data();
+    buffer_len = (size_t)first_entry.tensor->size();
+    // Only the root has a buffer to scale, fold prescaling into postscaling
+    // instead.
+    postscale_factor *= response.prescale_factor();
+  }
+
+  int64_t num_elements = buffer_len / DataType_Size(dtype);
+  auto nccl_result = ncclReduce(fused_input_data, buffer_data,
+                                (size_t)num_elements, GetNCCLDataType(dtype),
+                                GetNCCLReduceOp(response.reduce_op()),
+                                first_entry.root_rank,
+                                *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream);
+  nccl_context_->ErrorCheck("ncclReduce", nccl_result, *nccl_op_context_.nccl_comm_);
+  if (global_state_->timeline.Initialized()) {
+    gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_REDUCE, *gpu_op_context_.stream);
+  }
+
+  if (is_root && fused) {
+    ScaleMemcpyOutFusionBuffer(buffer_data, buffer_len, postscale_factor, entries);
+    if (global_state_->timeline.Initialized()) {
+      gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_OUT_FUSION_BUFFER, *gpu_op_context_.stream);
+    }
+  } else if (is_root && postscale_factor != 1.0) {
+    ScaleBuffer(postscale_factor, entries, buffer_data, buffer_data, num_elements);
+  }
+
+  return gpu_op_context_.FinalizeGPUQueue(entries, true, nccl_op_context_.error_check_callback_);
+}
+
+#ifdef NCCL_P2P_SUPPORTED
+void NCCLGather::WaitForData(std::vector<TensorTableEntry>& entries) {
+  gpu_op_context_.WaitForData(entries);
+}
+
+Status NCCLGather::Execute(std::vector<TensorTableEntry>& entries,
+                           const Response& response) {
+  assert(entries.size() == 1);
+  auto& e = entries[0];
+  auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
+
+  gpu_op_context_.InitGPU(entries);
+  nccl_op_context_.InitNCCLComm(entries, response.devices());
+  gpu_op_context_.InitGPUQueue(entries, response);
+
+  WaitForData(entries);
+
+  std::vector<int64_t> recvcounts;
+  std::vector<int64_t> displcmnts;
+  Status status = PrepareOutputAndParams(e, response, recvcounts, displcmnts);
+  if (!status.ok()) {
+    return status;
+  }
+
+  auto& comm = *nccl_op_context_.nccl_comm_;
+  auto& stream = *gpu_op_context_.stream;
+  int size = process_set.controller->GetSize();
+  int rank = process_set.controller->GetRank();
+  size_t element_size = DataType_Size(e.tensor->dtype());
+  if (rank == e.root_rank) {
+    auto block = [&](int rc) {
+      return (uint8_t*)e.output->data() + displcmnts[rc] * element_size;
+    };
+    gpu_context_->MemcpyAsyncD2D(block(rank), e.tensor->data(),
+                                 recvcounts[rank] * element_size, stream);
+    nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(), comm);
+    for (int rc = 0; rc < size; ++rc) {
+      if (rc == rank || recvcounts[rc] == 0) {
+        continue;
+      }
+      nccl_context_->ErrorCheck(
+          "ncclRecv",
+          ncclRecv(block(rc), recvcounts[rc] * element_size, ncclChar, rc,
+                   comm, stream),
+          comm);
+    }
+    nccl_context_->ErrorCheck("ncclGroupEnd", ncclGroupEnd(), comm);
+  } else if (recvcounts[rank] > 0) {
+    nccl_context_->ErrorCheck(
+        "ncclSend",
+        ncclSend(e.tensor->data(), recvcounts[rank] * element_size, ncclChar,
+                 e.root_rank, comm, stream),
+        comm);
+  }
+  if (global_state_->timeline.Initialized()) {
+    gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_GATHER, stream);
+  }
+
+  return gpu_op_context_.FinalizeGPUQueue(entries, true, nccl_op_context_.error_check_callback_);
+}
+#endif
+
+void NCCLBroadcast::WaitForData(std::vector<TensorTableEntry>& entries) {
+  gpu_op_context_.WaitForData(entries);
+}
+
+Status NCCLBroadcast::Execute(std::vector<TensorTableEntry>& entries,
+                              const Response& response) {
+  assert(!entries.empty());
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+
+  gpu_op_context_.InitGPU(entries);
+  nccl_op_context_.InitNCCLComm(entries, response.devices());
+  gpu_op_context_.InitGPUQueue(entries, response);
+
+  WaitForData(entries);
+
+  bool is_root = process_set.controller->GetRank() == first_entry.root_rank;
+
+  // Fused entries are broadcast in place within one group, which NCCL
+  // launches together, so no fusion buffer copies are needed.
+  if (entries.size() > 1) {
+    nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(),
+                              *nccl_op_context_.nccl_comm_);
+  }
+  for (auto& e : entries) {
+    // On root rank, ncclbcast sends data, on other ranks it receives data.
+    void* data_ptr;
+    if (is_root) {
+      data_ptr = (void*) e.tensor->data();
+    } else {
+      data_ptr = (void*) e.output->data();
+    }
+
+    // We only use 'ncclChar' for this operation because the type format does not matter for a
+    // broadcast, only the size of the data.
+    nccl_context_->ErrorCheck("ncclBcast",
+                              ncclBcast(data_ptr,
+                                        e.tensor->shape().num_elements() *
+                                        DataType_Size(e.tensor->dtype()),
+                                        ncclChar, e.root_rank,
+                                        *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream),
+                              *nccl_op_context_.nccl_comm_);
+  }
+  if (entries.size() > 1) {
+    nccl_context_->ErrorCheck("ncclGroupEnd", ncclGroupEnd(),
+                              *nccl_op_context_.nccl_comm_);
+  }
+  if (global_state_->timeline.Initialized()) {
+    gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_BCAST, *gpu_op_context_.stream);
+  }
+
+  return gpu_op_context_.FinalizeGPUQueue(entries, true, nccl_op_context_.error_check_callback_);
+}
+
+void NCCLAllgather::WaitForData(std::vector<TensorTableEntry>& entries) {
+  gpu_op_context_.WaitForData(entries);
+}
+
+Status NCCLAllgather::Execute(std::vector<TensorTableEntry>& entries,
+                                const Response& response) {
+  assert(!entries.empty());
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+
+  gpu_op_context_.InitGPU(entries);
+  InitNCCLComms(entries, response);
+  gpu_op_context_.InitGPUQueue(entries, response);
+
+  WaitForData(entries);
+
+  // Sizes of subcomponents of each entry from all ranks
+  auto** entry_component_sizes = new int64_t* [entries.size()];
+
+  // Offset of each subcomponent of every entry in the final buffer after
   // allgatherv
   auto** entry_component_offsets = new int64_t* [entries.size()];
 
   int global_size = process_set.controller->GetSize();
   int global_rank = process_set.controller->GetRank();
-  auto* recvcounts = new int[global_size]();
-  auto* displcmnts = new int[global_size]();
+  auto* recvcounts = new int64_t[global_size]();
+  auto* displcmnts = new int64_t[global_size]();
 
   for (size_t ec = 0; ec < entries.size(); ++ec) {
     entry_component_sizes[ec] = new int64_t[global_size]();
@@ -583,6 +1433,57 @@ Status NCCLAllgather::Execute(std::vector<TensorTableEntry>& entries,
     buffer_data = (void*) first_entry.output->data();
   }
 
+  // Do allgather.
+  GatherBuffer(entries, response, fused_input_data, buffer_data, recvcounts,
+               displcmnts, element_size);
+
+  // Copy memory out of the fusion buffer.
+  if (entries.size() > 1) {
+    MemcpyOutFusionBuffer(entry_component_offsets, entry_component_sizes,
+                          buffer_data, element_size, entries);
+
+    if (global_state_->timeline.Initialized()) {
+      gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_OUT_FUSION_BUFFER, *gpu_op_context_.stream);
+    }
+  }
+
+  delete[] recvcounts;
+  delete[] displcmnts;
+
+  for (size_t ec = 0; ec < entries.size(); ++ec) {
+    delete[] entry_component_sizes[ec];
+    delete[] entry_component_offsets[ec];
+  }
+  delete[] entry_component_sizes;
+  delete[] entry_component_offsets;
+
+  return gpu_op_context_.FinalizeGPUQueue(entries, true, ErrorCheckCallback());
+}
+
+void NCCLAllgather::InitNCCLComms(const std::vector<TensorTableEntry>& entries,
+                                  const Response& response) {
+  nccl_op_context_.InitNCCLComm(entries, response.devices());
+}
+
+#ifdef NCCL_P2P_SUPPORTED
+namespace {
+
+// Bytes a link moves in the time a step of send/recv takes to set up.
+constexpr int64_t NCCL_STEP_LATENCY_BYTES = 256 * 1024;
+
+} // namespace
+#endif
+
+void NCCLAllgather::GatherBuffer(std::vector<TensorTableEntry>& entries,
+                                 const Response& response,
+                                 const void* fused_input_data, void* buffer_data,
+                                 const int64_t* recvcounts,
+                                 const int64_t* displcmnts,
+                                 size_t element_size) {
+  auto& process_set =
+      global_state_->process_set_table.Get(entries[0].process_set_id);
+  int global_size = process_set.controller->GetSize();
+
   bool same_shape = true;
   const auto& tensor_sizes = response.tensor_sizes();
   for (size_t ec = 0; ec < entries.size(); ++ec) {
@@ -597,7 +1498,6 @@ Status NCCLAllgather::Execute(std::vector<TensorTableEntry>& entries,
     }
   }
 
-  // Do allgather.
   if (same_shape) {
     auto nccl_result = ncclAllGather(fused_input_data, buffer_data,
                                      recvcounts[0] * element_size,
@@ -610,6 +1510,76 @@ Status NCCLAllgather::Execute(std::vector<TensorTableEntry>& entries,
       gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_ALLGATHER, *gpu_op_context_.stream);
     }
   } else {
+#ifdef NCCL_P2P_SUPPORTED
+    auto& comm = *nccl_op_context_.nccl_comm_;
+    auto& stream = *gpu_op_context_.stream;
+    int rank = process_set.controller->GetRank();
+    auto block = [&](int rc) {
+      return (uint8_t*)buffer_data + displcmnts[rc] * element_size;
+    };
+    if (fused_input_data != block(rank)) {
+      gpu_context_->MemcpyAsyncD2D(block(rank), fused_input_data,
+                                   recvcounts[rank] * element_size, stream);
+    }
+
+    int64_t max_count = 0;
+    int64_t total_count = 0;
+    for (int rc = 0; rc < global_size; ++rc) {
+      max_count = std::max(max_count, recvcounts[rc]);
+      total_count += recvcounts[rc];
+    }
+    // Sending straight to every peer takes one step, but each rank sends its
+    // data global_size - 1 times. A ring sends every block over each link
+    // once, in global_size - 1 steps. Send straight while the extra bytes
+    // cost less than the steps the ring would add.
+    int64_t extra_bytes =
+        ((global_size - 1) * max_count - total_count) * (int64_t)element_size;
+    if (extra_bytes <= (global_size - 2) * NCCL_STEP_LATENCY_BYTES) {
+      nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(), comm);
+      for (int rc = 0; rc < global_size; ++rc) {
+        if (rc == rank) {
+          continue;
+        }
+        if (recvcounts[rank] > 0) {
+          auto nccl_result = ncclSend(block(rank), recvcounts[rank] * element_size,
+                                      ncclChar, rc, comm, stream);
+          nccl_context_->ErrorCheck("ncclSend", nccl_result, comm);
+        }
+        if (recvcounts[rc] > 0) {
+          auto nccl_result = ncclRecv(block(rc), recvcounts[rc] * element_size,
+                                      ncclChar, rc, comm, stream);
+          nccl_context_->ErrorCheck("ncclRecv", nccl_result, comm);
+        }
+      }
+      nccl_context_->ErrorCheck("ncclGroupEnd", ncclGroupEnd(), comm);
+    } else {
+      // At each step, pass on the block received in the previous one.
+      int next = (rank + 1) % global_size;
+      int prev = (rank + global_size - 1) % global_size;
+      for (int step = 0; step < global_size - 1; ++step) {
+        int send_rc = (rank + global_size - step) % global_size;
+        int recv_rc = (prev + global_size - step) % global_size;
+        nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(), comm);
+        if (recvcounts[send_rc] > 0) {
+          auto nccl_result = ncclSend(block(send_rc),
+                                      recvcounts[send_rc] * element_size,
+                                      ncclChar, next, comm, stream);
+          nccl_context_->ErrorCheck("ncclSend", nccl_result, comm);
+        }
+        if (recvcounts[recv_rc] > 0) {
+          auto nccl_result = ncclRecv(block(recv_rc),
+                                      recvcounts[recv_rc] * element_size,
+                                      ncclChar, prev, comm, stream);
+          nccl_context_->ErrorCheck("ncclRecv", nccl_result, comm);
+        }
+        nccl_context_->ErrorCheck("ncclGroupEnd", ncclGroupEnd(), comm);
+      }
+    }
+
+    if (global_state_->timeline.Initialized()) {
+      gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_ALLGATHER, stream);
+    }
+#else
     nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(), *nccl_op_context_.nccl_comm_);
     for (int rc = 0; rc < global_size; ++rc) {
       void* new_buffer_data = (uint8_t*)buffer_data + displcmnts[rc] * element_size;
@@ -624,59 +1594,133 @@ Status NCCLAllgather::Execute(std::vector<TensorTableEntry>& entries,
     if (global_state_->timeline.Initialized()) {
       gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_BCAST, *gpu_op_context_.stream);
     }
+#endif
   }
+}
 
-  // Copy memory out of the fusion buffer.
-  if (entries.size() > 1) {
-    MemcpyOutFusionBuffer(entry_component_offsets, entry_component_sizes,
-                          buffer_data, element_size, entries);
+bool NCCLAllgather::Enabled(const ParameterManager& param_manager,
+                              const std::vector<TensorTableEntry>& entries,
+                              const Response& response) const {
+  return entries[0].device != CPU_DEVICE_ID;
+}
 
-    if (global_state_->timeline.Initialized()) {
-      gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_OUT_FUSION_BUFFER, *gpu_op_context_.stream);
-    }
+NCCLHierarchicalAllgather::NCCLHierarchicalAllgather(
+    NCCLContext* nccl_context, GPUContext* gpu_context,
+    HorovodGlobalState* global_state)
+    : NCCLAllgather(nccl_context, gpu_context, global_state),
+      local_nccl_op_context_(nccl_context, global_state, Communicator::LOCAL),
+      cross_nccl_op_context_(nccl_context, global_state, Communicator::CROSS) {
+  error_check_callback_ = [this]() {
+    local_nccl_op_context_.AsyncErrorCheck();
+    cross_nccl_op_context_.AsyncErrorCheck();
+  };
+}
+
+void NCCLHierarchicalAllgather::InitNCCLComms(
+    const std::vector<TensorTableEntry>& entries, const Response& response) {
+  auto& process_set =
+      global_state_->process_set_table.Get(entries[0].process_set_id);
+  int local_size = process_set.controller->GetLocalSize();
+  int local_rank = process_set.controller->GetLocalRank();
+  int cross_size = process_set.controller->GetCrossSize();
+
+  // Determine GPU IDs of the devices participating in each communicator.
+  std::vector<int32_t> local_device_map;
+  local_device_map.reserve(local_size);
+  for (int rank : process_set.controller->GetLocalCommRanks()) {
+    local_device_map.push_back(response.devices()[rank]);
+  }
+  std::vector<int32_t> cross_device_map;
+  cross_device_map.reserve(cross_size);
+  for (int node = 0; node < cross_size; ++node) {
+    cross_device_map.push_back(
+        response.devices()[node * local_size + local_rank]);
   }
 
-  delete[] recvcounts;
-  delete[] displcmnts;
+  local_nccl_op_context_.InitNCCLComm(entries, local_device_map);
+  cross_nccl_op_context_.InitNCCLComm(entries, cross_device_map);
+}
 
-  for (size_t ec = 0; ec < entries.size(); ++ec) {
-    delete[] entry_component_sizes[ec];
-    delete[] entry_component_offsets[ec];
+void NCCLHierarchicalAllgather::GatherBuffer(
+    std::vector<TensorTableEntry>& entries, const Response& response,
+    const void* fused_input_data, void* buffer_data, const int64_t* recvcounts,
+    const int64_t* displcmnts, size_t element_size) {
+  auto& process_set =
+      global_state_->process_set_table.Get(entries[0].process_set_id);
+  int local_size = process_set.controller->GetLocalSize();
+  int local_rank = process_set.controller->GetLocalRank();
+  int cross_size = process_set.controller->GetCrossSize();
+  auto& local_comm = *local_nccl_op_context_.nccl_comm_;
+  auto& cross_comm = *cross_nccl_op_context_.nccl_comm_;
+
+  // Gather the data of the ranks with the same local rank on every node.
+  nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(), cross_comm);
+  for (int node = 0; node < cross_size; ++node) {
+    int rank = node * local_size + local_rank;
+    if (recvcounts[rank] == 0) {
+      continue;
+    }
+    void* new_buffer_data =
+        (uint8_t*)buffer_data + displcmnts[rank] * element_size;
+    auto nccl_result = ncclBroadcast(fused_input_data, new_buffer_data,
+                                     recvcounts[rank] * element_size, ncclChar,
+                                     node, cross_comm, *gpu_op_context_.stream);
+    nccl_context_->ErrorCheck("ncclBroadcast", nccl_result, cross_comm);
   }
-  delete[] entry_component_sizes;
-  delete[] entry_component_offsets;
+  nccl_context_->ErrorCheck("ncclGroupEnd", ncclGroupEnd(), cross_comm);
+
+  // Every local rank now holds one block per node, share them within the node.
+  nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(), local_comm);
+  for (int root = 0; root < local_size; ++root) {
+    for (int node = 0; node < cross_size; ++node) {
+      int rank = node * local_size + root;
+      if (recvcounts[rank] == 0) {
+        continue;
+      }
+      void* new_buffer_data =
+          (uint8_t*)buffer_data + displcmnts[rank] * element_size;
+      auto nccl_result = ncclBroadcast(new_buffer_data, new_buffer_data,
+                                       recvcounts[rank] * element_size,
+                                       ncclChar, root, local_comm,
+                                       *gpu_op_context_.stream);
+      nccl_context_->ErrorCheck("ncclBroadcast", nccl_result, local_comm);
+    }
+  }
+  nccl_context_->ErrorCheck("ncclGroupEnd", ncclGroupEnd(), local_comm);
 
-  return gpu_op_context_.FinalizeGPUQueue(entries, true, nccl_op_context_.error_check_callback_);
+  if (global_state_->timeline.Initialized()) {
+    gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_ALLGATHER,
+                              *gpu_op_context_.stream);
+  }
 }
 
-bool NCCLAllgather::Enabled(const ParameterManager& param_manager,
-                              const std::vector<TensorTableEntry>& entries,
-                              const Response& response) const {
-  return entries[0].device != CPU_DEVICE_ID;
+bool NCCLHierarchicalAllgather::Enabled(
+    const ParameterManager& param_manager,
+    const std::vector<TensorTableEntry>& entries,
+    const Response& response) const {
+  if (!NCCLAllgather::Enabled(param_manager, entries, response) ||
+      !param_manager.HierarchicalAllgather()) {
+    return false;
+  }
+  // The two-level exchange relies on every node hosting the same number of
+  // ranks, with global rank = cross rank * local size + local rank.
+  auto& process_set =
+      global_state_->process_set_table.Get(entries[0].process_set_id);
+  return process_set.controller->IsHomogeneous() &&
+         process_set.controller->GetLocalSize() > 1 &&
+         process_set.controller->GetCrossSize() > 1;
 }
 
 void NCCLAlltoall::WaitForData(std::vector<TensorTableEntry>& entries) {
-  if (global_state_->timeline.Initialized()) {
-    // If timeline is initialized, need to use normal CPU syncing path
-    HorovodOp::WaitForData(entries);
-  } else {
-    // Push events to set to deduplicate entries
-    std::unordered_set<gpuEvent_t> event_set;
-    for (auto& e : entries) {
-      e.ready_event_list.PushEventsToSet(event_set);
-    }
-    for (auto& ev : event_set) {
-      HVD_GPU_CHECK(gpuStreamWaitEvent(*gpu_op_context_.stream, ev, 0));
-    }
-  }
+  gpu_op_context_.WaitForData(entries);
 }
 
 Status NCCLAlltoall::Execute(std::vector<TensorTableEntry>& entries,
                              const Response& response) {
 #ifdef NCCL_P2P_SUPPORTED
-  assert(entries.size() == 1);
-  auto e = entries[0];
-  auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
 
   gpu_op_context_.InitGPU(entries);
   nccl_op_context_.InitNCCLComm(entries, response.devices());
@@ -684,30 +1728,58 @@ Status NCCLAlltoall::Execute(std::vector<TensorTableEntry>& entries,
 
   WaitForData(entries);
 
-  std::vector<int32_t> sdispls, rdispls;
-  std::vector<int32_t> sendcounts, recvcounts;
-  Status status = PrepareOutputAndParams(e, sdispls, rdispls, sendcounts, recvcounts);
+  auto world_size = process_set.controller->GetSize();
+  int num_entries = (int)entries.size();
+
+  // Bytes entry n sends to and receives from rank i, at [n * size + i].
+  std::vector<int64_t> entry_sendcounts, entry_recvcounts;
+  std::vector<int64_t> sdispls, rdispls;
+  std::vector<int64_t> sendcounts, recvcounts;
+  Status status;
+  if (num_entries > 1) {
+    // Fused entries need no buffer, the sends and receives of all of them
+    // are issued directly on their data within a single NCCL group.
+    status = PrepareFusedOutputAndParams(entries, entry_sendcounts,
+                                         entry_recvcounts, sdispls, rdispls,
+                                         sendcounts, recvcounts);
+  } else {
+    status = PrepareOutputAndParams(first_entry, sdispls, rdispls, sendcounts,
+                                    recvcounts);
+    auto element_size = DataType_Size(first_entry.tensor->dtype());
+    for (int i = 0; i < world_size; ++i) {
+      entry_sendcounts.push_back(sendcounts[i] * element_size);
+      entry_recvcounts.push_back(recvcounts[i] * element_size);
+    }
+  }
   if (!status.ok()) {
     return status;
   }
 
-  auto world_size = process_set.controller->GetSize();
+  std::vector<int64_t> entry_soffsets(num_entries, 0);
+  std::vector<int64_t> entry_roffsets(num_entries, 0);
 
   nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(), *nccl_op_context_.nccl_comm_);
 
   for (int i = 0; i < world_size; ++i) {
-    if (recvcounts[i] > 0) {
-      auto nccl_result = ncclRecv((uint8_t*) e.output->data() + rdispls[i] * DataType_Size(e.tensor->dtype()),
-                                  recvcounts[i] * DataType_Size(e.tensor->dtype()), ncclChar, i,
-                                  *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream);
-      nccl_context_->ErrorCheck("ncclRecv", nccl_result, *nccl_op_context_.nccl_comm_);
-    }
-
-    if (sendcounts[i] > 0) {
-      auto nccl_result = ncclSend((uint8_t*) e.tensor->data() + sdispls[i] * DataType_Size(e.tensor->dtype()),
-                             sendcounts[i] * DataType_Size(e.tensor->dtype()), ncclChar, i,
-                             *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream);
-      nccl_context_->ErrorCheck("ncclSend", nccl_result, *nccl_op_context_.nccl_comm_);
+    for (int n = 0; n < num_entries; ++n) {
+      auto& e = entries[n];
+      int64_t recv_count = entry_recvcounts[n * world_size + i];
+      if (recv_count > 0) {
+        auto nccl_result = ncclRecv((uint8_t*) e.output->data() + entry_roffsets[n],
+                                    recv_count, ncclChar, i,
+                                    *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream);
+        nccl_context_->ErrorCheck("ncclRecv", nccl_result, *nccl_op_context_.nccl_comm_);
+      }
+      entry_roffsets[n] += recv_count;
+
+      int64_t send_count = entry_sendcounts[n * world_size + i];
+      if (send_count > 0) {
+        auto nccl_result = ncclSend((uint8_t*) e.tensor->data() + entry_soffsets[n],
+                                    send_count, ncclChar, i,
+                                    *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream);
+        nccl_context_->ErrorCheck("ncclSend", nccl_result, *nccl_op_context_.nccl_comm_);
+      }
+      entry_soffsets[n] += send_count;
     }
   }
   nccl_context_->ErrorCheck("ncclGroupEnd", ncclGroupEnd(), *nccl_op_context_.nccl_comm_);
@@ -726,5 +1798,316 @@ Status NCCLAlltoall::Execute(std::vector<TensorTableEntry>& entries,
 #endif
 }
 
+NCCLHierarchicalAlltoall::NCCLHierarchicalAlltoall(
+    NCCLContext* nccl_context, GPUContext* gpu_context,
+    HorovodGlobalState* global_state)
+    : NCCLAlltoall(nccl_context, gpu_context, global_state),
+      local_nccl_op_context_(nccl_context, global_state, Communicator::LOCAL),
+      cross_nccl_op_context_(nccl_context, global_state, Communicator::CROSS) {
+  error_check_callback_ = [this]() {
+    local_nccl_op_context_.AsyncErrorCheck();
+    cross_nccl_op_context_.AsyncErrorCheck();
+  };
+}
+
+Status NCCLHierarchicalAlltoall::GetStagingBuffer(const TensorTableEntry& entry,
+                                                  int64_t size,
+                                                  void*& buffer) {
+  auto& elem = staging_buffers_[std::make_tuple(
+      entry.device, entry.context->framework(),
+      global_state_->current_nccl_stream)];
+  auto& staging_buffer = elem.first;
+  int64_t& capacity = elem.second;
+  if (capacity < size) {
+    if (gpu_context_->memory_pool) {
+      // Freed after the earlier alltoalls queued on this stream.
+      staging_buffer = gpu_context_->AllocatePooled(size, *gpu_op_context_.stream);
+      capacity = size;
+      buffer = const_cast<void*>(staging_buffer->AccessData(entry.context));
+      return Status::OK();
+    }
+    if (staging_buffer != nullptr) {
+      // Earlier alltoalls queued on this stream may still be using it.
+      gpu_context_->StreamSynchronize(*gpu_op_context_.stream);
+    }
+    staging_buffer.reset();
+    capacity = 0;
+    Status status = entry.context->AllocatePersistent(size, &staging_buffer);
+    if (!status.ok()) {
+      staging_buffer.reset();
+      return status;
+    }
+    capacity = size;
+  }
+  buffer = const_cast<void*>(staging_buffer->AccessData(entry.context));
+  return Status::OK();
+}
+
+Status NCCLHierarchicalAlltoall::Execute(std::vector<TensorTableEntry>& entries,
+                                         const Response& response) {
+#ifdef NCCL_P2P_SUPPORTED
+  assert(entries.size() == 1);
+  auto e = entries[0];
+  auto& process_set = global_state_->process_set_table.Get(e.process_set_id);
+  int world_size = process_set.controller->GetSize();
+  int local_size = process_set.controller->GetLocalSize();
+  int local_rank = process_set.controller->GetLocalRank();
+  int cross_size = process_set.controller->GetCrossSize();
+
+  // Determine GPU IDs of the devices participating in each communicator.
+  std::vector<int32_t> local_device_map;
+  local_device_map.reserve(local_size);
+  for (int rank : process_set.controller->GetLocalCommRanks()) {
+    local_device_map.push_back(response.devices()[rank]);
+  }
+  std::vector<int32_t> cross_device_map;
+  cross_device_map.reserve(cross_size);
+  for (int node = 0; node < cross_size; ++node) {
+    cross_device_map.push_back(
+        response.devices()[node * local_size + local_rank]);
+  }
+
+  gpu_op_context_.InitGPU(entries);
+  local_nccl_op_context_.InitNCCLComm(entries, local_device_map);
+  cross_nccl_op_context_.InitNCCLComm(entries, cross_device_map);
+  gpu_op_context_.InitGPUQueue(entries, response);
+
+  WaitForData(entries);
+
+  std::vector<int64_t> sdispls, rdispls;
+  std::vector<int64_t> sendcounts, recvcounts;
+  Status status = PrepareOutputAndParams(e, sdispls, rdispls, sendcounts, recvcounts);
+  if (!status.ok()) {
+    return status;
+  }
+
+  // Every rank needs to know how much each local peer forwards on its behalf,
+  // so share the send counts of all ranks within the node.
+  std::vector<int64_t> local_sendcounts(local_size * world_size);
+  std::copy(sendcounts.begin(), sendcounts.end(),
+            local_sendcounts.begin() + local_rank * world_size);
+  for (int root = 0; root < local_size; ++root) {
+    process_set.controller->Bcast(&local_sendcounts[root * world_size],
+                                  world_size * sizeof(int64_t), root,
+                                  Communicator::LOCAL);
+  }
+
+  // Data forwarded by local rank l for the ranks on node m, laid out by node
+  // and then by local rank so that each node's share is contiguous.
+  std::vector<int64_t> stage_displs(cross_size * local_size);
+  std::vector<int64_t> stage_counts(cross_size, 0);
+  int64_t stage_size = 0;
+  for (int node = 0; node < cross_size; ++node) {
+    for (int l = 0; l < local_size; ++l) {
+      stage_displs[node * local_size + l] = stage_size;
+      int64_t count =
+          local_sendcounts[l * world_size + node * local_size + local_rank];
+      stage_counts[node] += count;
+      stage_size += count;
+    }
+  }
+
+  auto element_size = DataType_Size(e.tensor->dtype());
+  void* stage_data = nullptr;
+  if (stage_size > 0) {
+    status = GetStagingBuffer(e, stage_size * element_size, stage_data);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  auto& local_comm = *local_nccl_op_context_.nccl_comm_;
+  auto& cross_comm = *cross_nccl_op_context_.nccl_comm_;
+
+  // Hand each local peer the data for the ranks sharing its local rank.
+  nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(), local_comm);
+  for (int l = 0; l < local_size; ++l) {
+    for (int node = 0; node < cross_size; ++node) {
+      int rank = node * local_size + l;
+      if (sendcounts[rank] > 0) {
+        auto nccl_result = ncclSend((uint8_t*) e.tensor->data() + sdispls[rank] * element_size,
+                                    sendcounts[rank] * element_size, ncclChar, l,
+                                    local_comm, *gpu_op_context_.stream);
+        nccl_context_->ErrorCheck("ncclSend", nccl_result, local_comm);
+      }
+    }
+    for (int node = 0; node < cross_size; ++node) {
+      int64_t count =
+          local_sendcounts[l * world_size + node * local_size + local_rank];
+      if (count > 0) {
+        auto nccl_result = ncclRecv((uint8_t*) stage_data + stage_displs[node * local_size + l] * element_size,
+                                    count * element_size, ncclChar, l,
+                                    local_comm, *gpu_op_context_.stream);
+        nccl_context_->ErrorCheck("ncclRecv", nccl_result, local_comm);
+      }
+    }
+  }
+  nccl_context_->ErrorCheck("ncclGroupEnd", ncclGroupEnd(), local_comm);
+
+  // Exchange one message per node with the equal local rank there. What
+  // arrives from a node is ordered by source local rank, as in the output.
+  nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(), cross_comm);
+  for (int node = 0; node < cross_size; ++node) {
+    int64_t recv_count = 0;
+    for (int l = 0; l < local_size; ++l) {
+      recv_count += recvcounts[node * local_size + l];
+    }
+    if (recv_count > 0) {
+      auto nccl_result = ncclRecv((uint8_t*) e.output->data() + rdispls[node * local_size] * element_size,
+                                  recv_count * element_size, ncclChar, node,
+                                  cross_comm, *gpu_op_context_.stream);
+      nccl_context_->ErrorCheck("ncclRecv", nccl_result, cross_comm);
+    }
+
+    if (stage_counts[node] > 0) {
+      auto nccl_result = ncclSend((uint8_t*) stage_data + stage_displs[node * local_size] * element_size,
+                                  stage_counts[node] * element_size, ncclChar, node,
+                                  cross_comm, *gpu_op_context_.stream);
+      nccl_context_->ErrorCheck("ncclSend", nccl_result, cross_comm);
+    }
+  }
+  nccl_context_->ErrorCheck("ncclGroupEnd", ncclGroupEnd(), cross_comm);
+
+  if (global_state_->timeline.Initialized()) {
+    gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_ALLTOALL, *gpu_op_context_.stream);
+  }
+
+  return gpu_op_context_.FinalizeGPUQueue(entries, true, error_check_callback_);
+#else
+  throw std::runtime_error("NCCLHierarchicalAlltoall requires NCCL version >= 2.7.0.");
+#endif
+}
+
+bool NCCLHierarchicalAlltoall::Enabled(
+    const ParameterManager& param_manager,
+    const std::vector<TensorTableEntry>& entries,
+    const Response& response) const {
+  // Fused alltoalls are exchanged by NCCLAlltoall in a single group.
+  if (entries.size() > 1 ||
+      !NCCLAlltoall::Enabled(param_manager, entries, response) ||
+      !param_manager.HierarchicalAlltoall()) {
+    return false;
+  }
+  // The two-level exchange relies on every node hosting the same number of
+  // ranks, with global rank = cross rank * local size + local rank.
+  auto& process_set =
+      global_state_->process_set_table.Get(entries[0].process_set_id);
+  return process_set.controller->IsHomogeneous() &&
+         process_set.controller->GetLocalSize() > 1 &&
+         process_set.controller->GetCrossSize() > 1;
+}
+
+void NCCLReducescatter::WaitForData(std::vector<TensorTableEntry>& entries) {
+  gpu_op_context_.WaitForData(entries);
+}
+
+Status NCCLReducescatter::Execute(std::vector<TensorTableEntry>& entries,
+                                  const Response& response) {
+  assert(!entries.empty());
+  auto& first_entry = entries[0];
+  auto& process_set =
+      global_state_->process_set_table.Get(first_entry.process_set_id);
+
+  gpu_op_context_.InitGPU(entries);
+  nccl_op_context_.InitNCCLComm(entries, response.devices());
+  gpu_op_context_.InitGPUQueue(entries, response);
+
+  WaitForData(entries);
+
+  int global_size = process_set.controller->GetSize();
+  int global_rank = process_set.controller->GetRank();
+  auto output_shapes = ComputeOutputShapes(entries, global_size);
+  std::vector<int64_t> recvcounts = ComputeReceiveCounts(output_shapes);
+  std::vector<int64_t> displcmnts(global_size, 0);
+  for (int rc = 1; rc < global_size; ++rc) {
+    displcmnts[rc] = displcmnts[rc - 1] + recvcounts[rc - 1];
+  }
+
+  global_state_->timeline.ActivityStartAll(entries, ALLOCATE_OUTPUT);
+  Status status = AllocateOutput(entries, output_shapes);
+  if (!status.ok()) {
+    return status;
+  }
+  global_state_->timeline.ActivityEndAll(entries);
+
+  size_t element_size = DataType_Size(first_entry.tensor->dtype());
+  double postscale_factor = response.postscale_factor();
+
+  const void* fused_input_data;
+  void* buffer_data;
+
+  // Copy (and possibly scale) tensors into the fusion buffer. The reduced
+  // part of this rank is written in place at its displacement.
+  if (entries.size() > 1) {
+    MemcpyInFusionBuffer(entries, output_shapes, element_size, buffer_data);
+    if (response.prescale_factor() != 1.0) {
+      ScaleBuffer(response.prescale_factor(), entries, buffer_data,
+                  buffer_data, NumElements(entries));
+    }
+    fused_input_data = buffer_data;
+    buffer_data = (uint8_t*)buffer_data + displcmnts[global_rank] * element_size;
+
+    if (global_state_->timeline.Initialized()) {
+      gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_IN_FUSION_BUFFER, *gpu_op_context_.stream);
+    }
+  } else {
+    fused_input_data = first_entry.tensor->data();
+    buffer_data = (void*) first_entry.output->data();
+    // The input can't be scaled out of place into the smaller output, fold
+    // prescaling into postscaling instead.
+    postscale_factor *= response.prescale_factor();
+  }
+
+  bool same_recvcounts = std::all_of(
+      recvcounts.begin(), recvcounts.end(),
+      [&recvcounts](int64_t count) { return count == recvcounts[0]; });
+
+  // Do reducescatter.
+  if (same_recvcounts) {
+    auto nccl_result = ncclReduceScatter(fused_input_data, buffer_data,
+                                         (size_t) recvcounts[0],
+                                         GetNCCLDataType(first_entry.tensor), ncclSum,
+                                         *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream);
+    nccl_context_->ErrorCheck("ncclReduceScatter", nccl_result, *nccl_op_context_.nccl_comm_);
+
+    if (global_state_->timeline.Initialized()) {
+      gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_REDUCESCATTER, *gpu_op_context_.stream);
+    }
+  } else {
+    // ncclReduceScatter needs equal counts, reduce each rank's part to that
+    // rank instead.
+    nccl_context_->ErrorCheck("ncclGroupStart", ncclGroupStart(), *nccl_op_context_.nccl_comm_);
+    for (int rc = 0; rc < global_size; ++rc) {
+      const void* send_data_at_offset = (uint8_t*)fused_input_data + displcmnts[rc] * element_size;
+      auto nccl_result = ncclReduce(send_data_at_offset, buffer_data,
+                                    (size_t) recvcounts[rc],
+                                    GetNCCLDataType(first_entry.tensor), ncclSum, rc,
+                                    *nccl_op_context_.nccl_comm_, *gpu_op_context_.stream);
+      nccl_context_->ErrorCheck("ncclReduce", nccl_result, *nccl_op_context_.nccl_comm_);
+    }
+    nccl_context_->ErrorCheck("ncclGroupEnd", ncclGroupEnd(), *nccl_op_context_.nccl_comm_);
+
+    if (global_state_->timeline.Initialized()) {
+      gpu_context_->RecordEvent(gpu_op_context_.event_queue, NCCL_REDUCE, *gpu_op_context_.stream);
+    }
+  }
+
+  if (postscale_factor != 1.0) {
+    ScaleBuffer(postscale_factor, entries, buffer_data, buffer_data,
+                recvcounts[global_rank]);
+  }
+
+  // Copy tensors out of the fusion buffer.
+  if (entries.size() > 1) {
+    MemcpyOutFusionBuffer(buffer_data, entries);
+
+    if (global_state_->timeline.Initialized()) {
+      gpu_context_->RecordEvent(gpu_op_context_.event_queue, MEMCPY_OUT_FUSION_BUFFER, *gpu_op_context_.stream);
+    }
+  }
+
+  return gpu_op_context_.FinalizeGPUQueue(entries, true, nccl_op_context_.error_check_callback_);
+}
+
 } // namespace common
 } // namespace horovod
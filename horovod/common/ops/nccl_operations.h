@@ -23,6 +23,18 @@
 #if NCCL_VERSION_CODE >= NCCL_VERSION(2, 7, 0)
 #define NCCL_P2P_SUPPORTED
 #endif
+#if NCCL_VERSION_CODE >= NCCL_VERSION(2, 11, 0)
+#define NCCL_PREMULSUM_SUPPORTED
+#endif
+#if NCCL_VERSION_CODE >= NCCL_VERSION(2, 9, 6) && CUDART_VERSION >= 11040
+#define NCCL_GRAPHS_SUPPORTED
+#endif
+#if NCCL_VERSION_CODE >= NCCL_VERSION(2, 17, 0)
+#define NCCL_MAX_CTAS_SUPPORTED
+#endif
+#if NCCL_VERSION_CODE >= NCCL_VERSION(2, 18, 0)
+#define NCCL_COMM_SPLIT_SUPPORTED
+#endif
 #elif HAVE_ROCM
 #include <rccl.h>
 #endif
@@ -30,22 +42,92 @@
 #include "gpu_operations.h"
 #include "../hashes.h"
 
+#include <atomic>
 #include <functional>
+#include <map>
+#include <mutex>
+#include <unordered_set>
 
 namespace horovod {
 namespace common {
 
 ncclDataType_t GetNCCLDataType(const std::shared_ptr<Tensor> tensor);
 
+ncclDataType_t GetNCCLDataType(DataType dtype);
+
+ncclRedOp_t GetNCCLReduceOp(ReduceOp reduce_op);
+
 struct NCCLContext {
-  // indexed by [nccl stream][{process set id, device id vector}]
-  std::vector<
-      std::unordered_map<std::tuple<int32_t, std::vector<int32_t>>, ncclComm_t>>
+  NCCLContext();
+
+  // indexed by [nccl stream][{global ranks of the process set, communicator
+  // type, device id vector}]. Keyed by ranks rather than process set id, so
+  // that a process set removed and added again reuses its communicators.
+  std::vector<std::unordered_map<
+      std::tuple<std::vector<int32_t>, int32_t, std::vector<int32_t>>,
+      ncclComm_t>>
       nccl_comms;
 
   void ErrorCheck(std::string op_name, ncclResult_t nccl_result, ncclComm_t& nccl_comm);
 
+  // Identifies this process across elastic resets, which renumber ranks.
+  uint64_t uid;
+
+  // Set once a communicator has been aborted.
+  std::atomic_bool comm_error{false};
+
+  // Upper bound on the CTAs, and so the SMs, the kernels of new
+  // communicators run on, 0 for NCCL's default. Leaves SMs to compute
+  // kernels that run at the same time.
+  int max_ctas = 0;
+
+  // Communicators of CapturableAllreduce(), by process set id and device.
+  // Kept apart from nccl_comms as they are used from framework threads, not
+  // the background thread. Guarded by capture_mutex.
+  std::map<std::pair<int32_t, int>, ncclComm_t> capture_comms;
+  std::mutex capture_mutex;
+
+  // ncclCommInitRank honoring max_ctas.
+  ncclResult_t CommInitRank(ncclComm_t* comm, int nranks, ncclUniqueId id,
+                            int rank);
+
+  // Derives the global communicators of newly initialized process sets from
+  // the ones of the global process set with ncclCommSplit, instead of
+  // creating them with ncclCommInitRank on first use. All processes must
+  // call this at the same point, right after initializing process sets.
+  void SplitProcessSetComms(ProcessSetTable& process_set_table,
+                            GPUContext& gpu_context);
+
+  // Keeps the GLOBAL communicators across an elastic reset, under the uids
+  // of their members instead of their ranks, and destroys the others.
+  void DetachComms();
+
+  // Reinstates the communicators kept by DetachComms() whose members all
+  // survived the reset in the same order under their new ranks, given the
+  // uid of every rank, and destroys the others. All of them are destroyed
+  // on discard, e.g. after a communicator was aborted on any process. All
+  // processes must call this with the same arguments.
+  void AttachComms(std::vector<uint64_t> rank_uids, bool discard);
+
   void ShutDown();
+
+private:
+  void DestroyCaptureComms();
+
+  struct DetachedComm {
+    size_t stream;
+    std::vector<uint64_t> member_uids;
+    std::vector<int32_t> devices;
+    ncclComm_t nccl_comm;
+  };
+
+  // Process sets SplitProcessSetComms has already seen.
+  std::unordered_set<int32_t> split_process_set_ids_;
+
+  // Uid of every global rank, set by AttachComms().
+  std::vector<uint64_t> rank_uids_;
+
+  std::vector<DetachedComm> detached_comms_;
 };
 
 class NCCLOpContext {
@@ -89,6 +171,102 @@ public:
   Status Execute(std::vector<TensorTableEntry>& entries,
                  const Response& response) override;
 
+  // Outputs are adopted unless the response is compressed or replayed from
+  // a CUDA graph.
+  bool AdoptsOutputs(const std::vector<TensorTableEntry>& entries,
+                     const Response& response) const override;
+
+  // Responses on the same devices and framework, none of them compressed,
+  // whose fused tensors fit in the fusion buffer together. Each fused one
+  // is staged in its own part of it.
+  bool Groups(const std::vector<std::vector<TensorTableEntry>>& entries_list,
+              const std::vector<Response>& responses) const override;
+
+  // Enqueues one allreduce per response inside a single NCCL group, and
+  // completes all entries with one event.
+  Status ExecuteGroup(std::vector<std::vector<TensorTableEntry>>& entries_list,
+                      const std::vector<Response>& responses) override;
+
+protected:
+  void WaitForData(std::vector<TensorTableEntry>& entries) override;
+
+  // Enqueues the copies into the fusion buffer, scaling, allreduce and
+  // copies out of the fusion buffer on the op's stream.
+  void EnqueueAllreduce(std::vector<TensorTableEntry>& entries,
+                        const Response& response);
+
+  NCCLContext* nccl_context_;
+  NCCLOpContext nccl_op_context_;
+  HorovodGlobalState* global_state_;
+
+#ifdef NCCL_GRAPHS_SUPPORTED
+private:
+  // Replays the work of EnqueueAllreduce() from a CUDA graph captured the
+  // last time the response ran on the same buffers, or captures it.
+  void EnqueueAllreduceGraph(std::vector<TensorTableEntry>& entries,
+                             const Response& response);
+
+  // Everything a captured graph depends on: communicator, stream, scaling
+  // and the addresses and sizes of all buffers.
+  std::vector<int64_t> GraphSignature(const std::vector<TensorTableEntry>& entries,
+                                      const Response& response);
+
+  struct CapturedGraph {
+    std::vector<int64_t> signature;
+    cudaGraphExec_t exec = nullptr;
+    // Executions in a row with the current signature.
+    int uses = 0;
+    // Number of times the signature has changed.
+    int recaptures = 0;
+  };
+
+  // Keyed by process set and tensor names of the response.
+  std::unordered_map<std::pair<int32_t, std::string>, CapturedGraph> graphs_;
+
+  static constexpr size_t MAX_CAPTURED_GRAPHS = 1024;
+  // Responses whose buffers keep moving are not worth capturing.
+  static constexpr int MAX_GRAPH_RECAPTURES = 4;
+#endif
+};
+
+// Reduces GPU tensors into the output of the root rank with ncclReduce.
+// Fused entries are reduced in the fusion buffer, which only the root copies
+// out of.
+class NCCLReduce : public GPUAllreduce {
+public:
+  NCCLReduce(NCCLContext* nccl_context, GPUContext* gpu_context,
+             HorovodGlobalState* global_state)
+      : GPUAllreduce(gpu_context, global_state),
+        nccl_context_(nccl_context),
+        nccl_op_context_(nccl_context, global_state, Communicator::GLOBAL),
+        global_state_(global_state){};
+
+  Status Execute(std::vector<TensorTableEntry>& entries,
+                 const Response& response) override;
+
+protected:
+  void WaitForData(std::vector<TensorTableEntry>& entries) override;
+
+  NCCLContext* nccl_context_;
+  NCCLOpContext nccl_op_context_;
+  HorovodGlobalState* global_state_;
+};
+
+#ifdef NCCL_P2P_SUPPORTED
+// Gathers a GPU tensor of every rank into the output of the root rank, which
+// receives the blocks of all other ranks in one group of ncclRecv.
+class NCCLGather : public GPUGather {
+public:
+  NCCLGather(NCCLContext* nccl_context, GPUContext* gpu_context,
+             HorovodGlobalState* global_state)
+      : GPUGather(gpu_context, global_state),
+        nccl_context_(nccl_context),
+        nccl_op_context_(nccl_context, global_state, Communicator::GLOBAL),
+        global_state_(global_state){};
+
+  Status Execute(std::vector<TensorTableEntry>& entries,
+                 const Response& response) override;
+
 protected:
   void WaitForData(std::vector<TensorTableEntry>& entries) override;
 
@@ -96,6 +274,7 @@ protected:
   NCCLOpContext nccl_op_context_;
   HorovodGlobalState* global_state_;
 };
+#endif
 
 class NCCLBroadcast : public GPUBroadcast {
 public:
@@ -137,6 +316,37 @@ protected:
   HorovodGlobalState* global_state_;
 };
 
+// Alltoall that first exchanges data within each node, so that every rank
+// holds what its node sends to the equal local rank of each other node, and
+// then sends one coalesced message per node pair between equal local ranks.
+// Requires a homogeneous cluster.
+class NCCLHierarchicalAlltoall : public NCCLAlltoall {
+public:
+  NCCLHierarchicalAlltoall(NCCLContext* nccl_context, GPUContext* gpu_context,
+                           HorovodGlobalState* global_state);
+
+  Status Execute(std::vector<TensorTableEntry>& entries,
+                 const Response& response) override;
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+
+private:
+  // Returns a device buffer of at least size bytes for the data exchanged
+  // within the node, kept per device, framework and stream.
+  Status GetStagingBuffer(const TensorTableEntry& entry, int64_t size,
+                          void*& buffer);
+
+  NCCLOpContext local_nccl_op_context_;
+  NCCLOpContext cross_nccl_op_context_;
+  std::function<void()> error_check_callback_;
+
+  std::unordered_map<std::tuple<int, Framework, int>,
+                     std::pair<std::shared_ptr<PersistentBuffer>, int64_t>>
+      staging_buffers_;
+};
+
 #if HAVE_MPI
 class NCCLHierarchicalAllreduce : public NCCLAllreduce {
 public:
@@ -152,11 +362,47 @@ public:
                const std::vector<TensorTableEntry>& entries,
                const Response& response) const override;
 
+  bool AdoptsOutputs(const std::vector<TensorTableEntry>& entries,
+                     const Response& response) const override {
+    return false;
+  }
+
+  bool Groups(const std::vector<std::vector<TensorTableEntry>>& entries_list,
+              const std::vector<Response>& responses) const override {
+    return false;
+  }
+
+  // A tensor whose elements do not split evenly across the local ranks is
+  // padded in the fusion buffer when it fits there, like fused tensors, so
+  // that every local rank reduces an equal shard.
+  bool StagesInFusionBuffer(const std::vector<TensorTableEntry>& entries,
+                            const Response& response) const override;
+
 protected:
   void WaitForData(std::vector<TensorTableEntry>& entries) override;
 
 private:
+  // Number of elements padded to a multiple of local_size times
+  // FUSION_BUFFER_ATOMIC_UNIT.
+  static int64_t PaddedNumElements(int64_t num_elements, int local_size);
+
+  // Runs the cross node MPI allreduce of the host copy of buffer in chunks,
+  // overlapping the device to host copy of the next chunk and the host to
+  // device copy of the previous one.
+  void PipelinedCrossAllreduce(std::vector<TensorTableEntry>& entries,
+                               const Response& response, void* buffer,
+                               int64_t num_elements);
+
+  // Type the cross node allreduce sends the data as, see
+  // HOROVOD_HIERARCHICAL_ALLREDUCE_COMPRESSION.
+  DataType CrossNodeDataType(const std::vector<TensorTableEntry>& entries,
+                             const Response& response) const;
+
   MPIContext* mpi_context_;
+
+  // Per device streams for copying reduced chunks back to the GPU, so that
+  // they do not queue up behind the device to host copies.
+  std::unordered_map<int, gpuStream_t> host_to_device_streams_;
 };
 #endif
 
@@ -178,11 +424,76 @@ public:
 protected:
   void WaitForData(std::vector<TensorTableEntry>& entries) override;
 
+  virtual void InitNCCLComms(const std::vector<TensorTableEntry>& entries,
+                             const Response& response);
+
+  // Gathers the data of every rank into buffer_data, at the displacements
+  // given in elements. fused_input_data holds the data of this rank.
+  virtual void GatherBuffer(std::vector<TensorTableEntry>& entries,
+                            const Response& response,
+                            const void* fused_input_data, void* buffer_data,
+                            const int64_t* recvcounts,
+                            const int64_t* displcmnts, size_t element_size);
+
+  virtual const std::function<void()>& ErrorCheckCallback() const {
+    return nccl_op_context_.error_check_callback_;
+  }
+
   NCCLContext* nccl_context_;
   NCCLOpContext nccl_op_context_;
   HorovodGlobalState* global_state_;
 };
 
+// Allgather that first gathers across nodes between equal local ranks and
+// then within each node, so that the slow cross node links carry one message
+// per node pair and local rank. Requires a homogeneous cluster.
+class NCCLHierarchicalAllgather : public NCCLAllgather {
+public:
+  NCCLHierarchicalAllgather(NCCLContext* nccl_context, GPUContext* gpu_context,
+                            HorovodGlobalState* global_state);
+
+  bool Enabled(const ParameterManager& param_manager,
+               const std::vector<TensorTableEntry>& entries,
+               const Response& response) const override;
+
+protected:
+  void InitNCCLComms(const std::vector<TensorTableEntry>& entries,
+                     const Response& response) override;
+
+  void GatherBuffer(std::vector<TensorTableEntry>& entries,
+                    const Response& response, const void* fused_input_data,
+                    void* buffer_data, const int64_t* recvcounts,
+                    const int64_t* displcmnts, size_t element_size) override;
+
+  const std::function<void()>& ErrorCheckCallback() const override {
+    return error_check_callback_;
+  }
+
+private:
+  NCCLOpContext local_nccl_op_context_;
+  NCCLOpContext cross_nccl_op_context_;
+  std::function<void()> error_check_callback_;
+};
+
+class NCCLReducescatter : public GPUReducescatter {
+public:
+  NCCLReducescatter(NCCLContext* nccl_context, GPUContext* gpu_context,
+                    HorovodGlobalState* global_state)
+      : GPUReducescatter(gpu_context, global_state),
+        nccl_context_(nccl_context),
+        nccl_op_context_(nccl_context, global_state, Communicator::GLOBAL),
+        global_state_(global_state) {}
+
+  Status Execute(std::vector<TensorTableEntry>& entries,
+                 const Response& response) override;
+
+protected:
+  void WaitForData(std::vector<TensorTableEntry>& entries) override;
+
+  NCCLContext* nccl_context_;
+  NCCLOpContext nccl_op_context_;
+  HorovodGlobalState* global_state_;
+};
 
 } // namespace common
 } // namespace horovod
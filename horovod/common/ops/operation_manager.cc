@@ -17,22 +17,32 @@
 
 #include "operation_manager.h"
 
+#include <algorithm>
+
 namespace horovod {
 namespace common {
 
 OperationManager::OperationManager(ParameterManager* param_manager,
+                                   ProcessSetTable* process_set_table,
                                    std::vector<std::shared_ptr<AllreduceOp>> allreduce_ops,
                                    std::vector<std::shared_ptr<AllgatherOp>> allgather_ops,
                                    std::vector<std::shared_ptr<BroadcastOp>> broadcast_ops,
                                    std::vector<std::shared_ptr<AlltoallOp>> alltoall_ops,
+                                   std::vector<std::shared_ptr<ReducescatterOp>> reducescatter_ops,
+                                   std::vector<std::shared_ptr<AllreduceOp>> reduce_ops,
+                                   std::vector<std::shared_ptr<GatherOp>> gather_ops,
                                    std::shared_ptr<JoinOp> join_op,
                                    std::vector<std::shared_ptr<AllreduceOp>> adasum_ops,
                                    std::shared_ptr<ErrorOp> error_op)
     : param_manager_(param_manager),
+      process_set_table_(process_set_table),
       allreduce_ops_(std::move(allreduce_ops)),
       allgather_ops_(std::move(allgather_ops)),
       broadcast_ops_(std::move(broadcast_ops)),
       alltoall_ops_(std::move(alltoall_ops)),
+      reducescatter_ops_(std::move(reducescatter_ops)),
+      reduce_ops_(std::move(reduce_ops)),
+      gather_ops_(std::move(gather_ops)),
       join_op_(std::move(join_op)),
       adasum_ops_(std::move(adasum_ops)),
       error_op_(std::move(error_op)) {}
@@ -40,17 +50,87 @@ OperationManager::OperationManager(ParameterManager* param_manager,
 Status OperationManager::ExecuteAllreduce(std::vector<TensorTableEntry>& entries,
                                           const Response& response) const {
   for (auto& op : allreduce_ops_) {
-    if (op->Enabled(*param_manager_, entries, response)) {
+    if (op->Enabled(Params(entries), entries, response)) {
       return op->Execute(entries, response);
     }
   }
   throw std::logic_error("No Allreduce operation enabled");
 }
 
+bool OperationManager::AdoptsAllreduceOutputs(
+    const std::vector<TensorTableEntry>& entries,
+    const Response& response) const {
+  for (auto& op : allreduce_ops_) {
+    if (op->Enabled(Params(entries), entries, response)) {
+      return op->AdoptsOutputs(entries, response);
+    }
+  }
+  return false;
+}
+
+bool OperationManager::StagesInFusionBuffer(
+    const std::vector<TensorTableEntry>& entries,
+    const Response& response) const {
+  if (entries.size() > 1) {
+    return true;
+  }
+  // Only allreduces stage single tensors.
+  if (response.response_type() == Response::ALLREDUCE) {
+    for (auto& op : allreduce_ops_) {
+      if (op->Enabled(Params(entries), entries, response)) {
+        return op->StagesInFusionBuffer(entries, response);
+      }
+    }
+  }
+  return false;
+}
+
+AllreduceOp* OperationManager::GroupingAllreduceOp(
+    const std::vector<std::vector<TensorTableEntry>>& entries_list,
+    const std::vector<Response>& responses) const {
+  AllreduceOp* grouping_op = nullptr;
+  for (size_t i = 0; i < responses.size(); ++i) {
+    auto& entries = entries_list[i];
+    AllreduceOp* enabled_op = nullptr;
+    for (auto& op : allreduce_ops_) {
+      if (op->Enabled(Params(entries), entries, responses[i])) {
+        enabled_op = op.get();
+        break;
+      }
+    }
+    if (enabled_op == nullptr ||
+        (grouping_op != nullptr && enabled_op != grouping_op)) {
+      return nullptr;
+    }
+    grouping_op = enabled_op;
+  }
+  if (grouping_op == nullptr ||
+      !grouping_op->Groups(entries_list, responses)) {
+    return nullptr;
+  }
+  return grouping_op;
+}
+
+bool OperationManager::GroupsAllreduces(
+    const std::vector<std::vector<TensorTableEntry>>& entries_list,
+    const std::vector<Response>& responses) const {
+  return GroupingAllreduceOp(entries_list, responses) != nullptr;
+}
+
+Status OperationManager::ExecuteAllreduceGroup(
+    std::vector<std::vector<TensorTableEntry>>& entries_list,
+    const std::vector<Response>& responses) const {
+  auto op = GroupingAllreduceOp(entries_list, responses);
+  if (op == nullptr) {
+    throw std::logic_error("No Allreduce operation groups the responses");
+  }
+  return op->ExecuteGroup(entries_list, responses);
+}
+
 Status OperationManager::ExecuteAllgather(std::vector<TensorTableEntry>& entries,
                                           const Response& response) const {
   for (auto& op : allgather_ops_) {
-    if (op->Enabled(*param_manager_, entries, response)) {
+    if (op->Enabled(Params(entries), entries, response)) {
       return op->Execute(entries, response);
     }
   }
@@ -60,7 +140,7 @@ Status OperationManager::ExecuteAllgather(std::vector<TensorTableEntry>& entries
 Status OperationManager::ExecuteBroadcast(std::vector<TensorTableEntry>& entries,
                                           const Response& response) const {
   for (auto& op : broadcast_ops_) {
-    if (op->Enabled(*param_manager_, entries, response)) {
+    if (op->Enabled(Params(entries), entries, response)) {
       return op->Execute(entries, response);
     }
   }
@@ -70,13 +150,43 @@ Status OperationManager::ExecuteBroadcast(std::vector<TensorTableEntry>& entries
 Status OperationManager::ExecuteAlltoall(std::vector<TensorTableEntry>& entries,
                                          const Response& response) const {
   for (auto& op : alltoall_ops_) {
-    if (op->Enabled(*param_manager_, entries, response)) {
+    if (op->Enabled(Params(entries), entries, response)) {
       return op->Execute(entries, response);
     }
   }
   throw std::logic_error("No Alltoall operation enabled");
 }
 
+Status OperationManager::ExecuteReducescatter(std::vector<TensorTableEntry>& entries,
+                                              const Response& response) const {
+  for (auto& op : reducescatter_ops_) {
+    if (op->Enabled(Params(entries), entries, response)) {
+      return op->Execute(entries, response);
+    }
+  }
+  throw std::logic_error("No Reducescatter operation enabled");
+}
+
+Status OperationManager::ExecuteReduce(std::vector<TensorTableEntry>& entries,
+                                       const Response& response) const {
+  for (auto& op : reduce_ops_) {
+    if (op->Enabled(Params(entries), entries, response)) {
+      return op->Execute(entries, response);
+    }
+  }
+  throw std::logic_error("No Reduce operation enabled");
+}
+
+Status OperationManager::ExecuteGather(std::vector<TensorTableEntry>& entries,
+                                       const Response& response) const {
+  for (auto& op : gather_ops_) {
+    if (op->Enabled(Params(entries), entries, response)) {
+      return op->Execute(entries, response);
+    }
+  }
+  throw std::logic_error("No Gather operation enabled");
+}
+
 Status OperationManager::ExecuteJoin(std::vector<TensorTableEntry>& entries,
                                      const Response& response,
                                      ProcessSet& process_set) const {
@@ -86,7 +196,7 @@ Status OperationManager::ExecuteJoin(std::vector<TensorTableEntry>& entries,
 Status OperationManager::ExecuteAdasum(std::vector<TensorTableEntry>& entries,
                                           const Response& response) const {
   for (auto& op : adasum_ops_) {
-    if (op->Enabled(*param_manager_, entries, response)) {
+    if (op->Enabled(Params(entries), entries, response)) {
       return op->Execute(entries, response);
     }
   }
@@ -98,6 +208,17 @@ Status OperationManager::ExecuteError(std::vector<TensorTableEntry>& entries,
   return error_op_->Execute(entries, response);
 }
 
+const ParameterManager&
+OperationManager::Params(const std::vector<TensorTableEntry>& entries) const {
+  if (!entries.empty() && entries[0].process_set_id != 0) {
+    auto& process_set = process_set_table_->Get(entries[0].process_set_id);
+    if (process_set.parameter_manager != nullptr) {
+      return *process_set.parameter_manager;
+    }
+  }
+  return *param_manager_;
+}
+
 Status OperationManager::ExecuteOperation(std::vector<TensorTableEntry>& entries,
                                           const Response& response,
                                           ProcessSet& process_set) const {
@@ -113,6 +234,12 @@ Status OperationManager::ExecuteOperation(std::vector<TensorTableEntry>& entries
     return ExecuteJoin(entries, response, process_set);
   } else if (response.response_type() == Response::ADASUM) {
     return ExecuteAdasum(entries, response);
+  } else if (response.response_type() == Response::REDUCESCATTER) {
+    return ExecuteReducescatter(entries, response);
+  } else if (response.response_type() == Response::REDUCE) {
+    return ExecuteReduce(entries, response);
+  } else if (response.response_type() == Response::GATHER) {
+    return ExecuteGather(entries, response);
   } else if (response.response_type() == Response::ERROR) {
     return ExecuteError(entries, response);
   } else {
@@ -120,5 +247,37 @@ Status OperationManager::ExecuteOperation(std::vector<TensorTableEntry>& entries
   }
 }
 
+std::vector<HorovodOp*> OperationManager::AllOps() const {
+  std::vector<HorovodOp*> ops;
+  auto add = [&ops](HorovodOp* op) {
+    if (op != nullptr && std::find(ops.begin(), ops.end(), op) == ops.end()) {
+      ops.push_back(op);
+    }
+  };
+  for (auto& op : allreduce_ops_) add(op.get());
+  for (auto& op : allgather_ops_) add(op.get());
+  for (auto& op : broadcast_ops_) add(op.get());
+  for (auto& op : alltoall_ops_) add(op.get());
+  for (auto& op : reducescatter_ops_) add(op.get());
+  for (auto& op : reduce_ops_) add(op.get());
+  for (auto& op : gather_ops_) add(op.get());
+  for (auto& op : adasum_ops_) add(op.get());
+  add(join_op_.get());
+  add(error_op_.get());
+  return ops;
+}
+
+void OperationManager::AddMemoryUsage(MemoryUsage& usage) const {
+  for (auto op : AllOps()) {
+    op->AddMemoryUsage(usage);
+  }
+}
+
+void OperationManager::ReleaseBuffers() {
+  for (auto op : AllOps()) {
+    op->ReleaseBuffers();
+  }
+}
+
 } // namespace common
 } // namespace horovod
@@ -27,10 +27,14 @@ namespace common {
 class OperationManager {
 public:
   OperationManager(ParameterManager* param_manager,
+                   ProcessSetTable* process_set_table,
                    std::vector<std::shared_ptr<AllreduceOp>> allreduce_ops,
                    std::vector<std::shared_ptr<AllgatherOp>> allgather_ops,
                    std::vector<std::shared_ptr<BroadcastOp>> broadcast_ops,
                    std::vector<std::shared_ptr<AlltoallOp>> alltoall_ops,
+                   std::vector<std::shared_ptr<ReducescatterOp>> reducescatter_ops,
+                   std::vector<std::shared_ptr<AllreduceOp>> reduce_ops,
+                   std::vector<std::shared_ptr<GatherOp>> gather_ops,
                    std::shared_ptr<JoinOp> join_op,
                    std::vector<std::shared_ptr<AllreduceOp>> adasum_ops,
                    std::shared_ptr<ErrorOp> error_op);
@@ -39,12 +43,37 @@ public:
 
   Status ExecuteAllreduce(std::vector<TensorTableEntry>& entries, const Response& response) const;
 
+  // Whether the allreduce op that executes the response places outputs that
+  // were left to Horovod itself.
+  bool AdoptsAllreduceOutputs(const std::vector<TensorTableEntry>& entries,
+                              const Response& response) const;
+
+  // Whether the op that executes the response needs the fusion buffer.
+  bool StagesInFusionBuffer(const std::vector<TensorTableEntry>& entries,
+                            const Response& response) const;
+
+  // Whether one allreduce op executes all responses and can perform them
+  // together with ExecuteAllreduceGroup.
+  bool GroupsAllreduces(
+      const std::vector<std::vector<TensorTableEntry>>& entries_list,
+      const std::vector<Response>& responses) const;
+
+  Status ExecuteAllreduceGroup(
+      std::vector<std::vector<TensorTableEntry>>& entries_list,
+      const std::vector<Response>& responses) const;
+
   Status ExecuteAllgather(std::vector<TensorTableEntry>& entries, const Response& response) const;
 
   Status ExecuteBroadcast(std::vector<TensorTableEntry>& entries, const Response& response) const;
 
   Status ExecuteAlltoall(std::vector<TensorTableEntry>& entries, const Response& response) const;
 
+  Status ExecuteReducescatter(std::vector<TensorTableEntry>& entries, const Response& response) const;
+
+  Status ExecuteReduce(std::vector<TensorTableEntry>& entries, const Response& response) const;
+
+  Status ExecuteGather(std::vector<TensorTableEntry>& entries, const Response& response) const;
+
   Status ExecuteError(std::vector<TensorTableEntry>& entries, const Response& response) const;
 
   Status ExecuteJoin(std::vector<TensorTableEntry>& entries,
@@ -56,13 +85,34 @@ public:
                           const Response& response,
                           ProcessSet& process_set) const;
 
+  // Adds the buffers all ops keep between operations to usage.
+  void AddMemoryUsage(MemoryUsage& usage) const;
+
+  // Frees the buffers all ops keep between operations.
+  void ReleaseBuffers();
+
 private:
+  // The allreduce op that executes all responses, if it groups them.
+  AllreduceOp* GroupingAllreduceOp(
+      const std::vector<std::vector<TensorTableEntry>>& entries_list,
+      const std::vector<Response>& responses) const;
+
+  // All ops, each one once.
+  std::vector<HorovodOp*> AllOps() const;
+
+  // Parameters of the process set the entries belong to.
+  const ParameterManager& Params(const std::vector<TensorTableEntry>& entries) const;
+
   ParameterManager* param_manager_;
+  ProcessSetTable* process_set_table_;
 
   std::vector<std::shared_ptr<AllreduceOp>> allreduce_ops_;
   std::vector<std::shared_ptr<AllgatherOp>> allgather_ops_;
   std::vector<std::shared_ptr<BroadcastOp>> broadcast_ops_;
   std::vector<std::shared_ptr<AlltoallOp>> alltoall_ops_;
+  std::vector<std::shared_ptr<ReducescatterOp>> reducescatter_ops_;
+  std::vector<std::shared_ptr<AllreduceOp>> reduce_ops_;
+  std::vector<std::shared_ptr<GatherOp>> gather_ops_;
   std::shared_ptr<JoinOp> join_op_;
   std::vector<std::shared_ptr<AllreduceOp>> adasum_ops_;
   std::shared_ptr<ErrorOp> error_op_;
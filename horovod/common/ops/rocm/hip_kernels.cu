@@ -0,0 +1,608 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "hip_kernels.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <hip/hip_bfloat16.h>
+#include <hip/hip_fp16.h>
+
+namespace horovod {
+namespace common {
+
+template<typename T, int blocks_per_copy>
+__device__ void batched_memcpy_d(size_t idx, const void* in, void* out, size_t size) {
+
+  const T* input = reinterpret_cast<const T *>(in);
+  T* output = reinterpret_cast<T *>(out);
+  const size_t num_elements = size / sizeof(T);
+
+  for (size_t i = idx; i < num_elements; i += blockDim.x * blocks_per_copy) {
+    output[i] = input[i];
+  }
+
+  // Deal with any remaining bytes
+  size_t remainder = size % sizeof(T);
+  if (remainder > 0 && idx < remainder) {
+    const unsigned char* input_r = reinterpret_cast<const unsigned char *>(input + num_elements);
+    unsigned char* output_r = reinterpret_cast<unsigned char *>(output + num_elements);
+    output_r[idx] = input_r[idx];
+  }
+}
+
+// Widest alignment, up to 16 bytes, that input and output reach after
+// skipping the same number of bytes. head is set to that number.
+__device__ size_t batched_memcpy_alignment(const void* input, const void* output, size_t size, size_t& head) {
+  size_t in_addr = reinterpret_cast<size_t>(input);
+  size_t diff = (in_addr ^ reinterpret_cast<size_t>(output)) % 16;
+  size_t align = diff == 0 ? 16 : diff & (~diff + 1);
+  head = (align - in_addr % align) % align;
+  if (head > size) {
+    head = size;
+  }
+  return align;
+}
+
+// Copies size bytes without requiring any alignment. Bytes before the common
+// alignment of input and output are copied one by one, the rest with loads and
+// stores as wide as that alignment.
+template<int blocks_per_copy>
+__device__ void batched_memcpy_unaligned_d(size_t idx, const void* input, void* output, size_t size) {
+  size_t head;
+  size_t align = batched_memcpy_alignment(input, output, size, head);
+  batched_memcpy_d<unsigned char, blocks_per_copy>(idx, input, output, head);
+  input = reinterpret_cast<const unsigned char*>(input) + head;
+  output = reinterpret_cast<unsigned char*>(output) + head;
+  size -= head;
+
+  if (align == 16) {
+    batched_memcpy_d<ulonglong2, blocks_per_copy>(idx, input, output, size);
+  } else if (align == 8) {
+    batched_memcpy_d<unsigned long long, blocks_per_copy>(idx, input, output, size);
+  } else if (align == 4) {
+    batched_memcpy_d<unsigned int, blocks_per_copy>(idx, input, output, size);
+  } else if (align == 2) {
+    batched_memcpy_d<unsigned short, blocks_per_copy>(idx, input, output, size);
+  } else {
+    batched_memcpy_d<unsigned char, blocks_per_copy>(idx, input, output, size);
+  }
+}
+
+template<int blocks_per_copy>
+__global__ void batched_memcpy_k(BatchedD2DParams params) {
+  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
+
+  const size_t size = params.sizes[blockIdx.x / blocks_per_copy];
+  const void* input = params.in[blockIdx.x / blocks_per_copy];
+  void* output = params.out[blockIdx.x / blocks_per_copy];
+
+  batched_memcpy_unaligned_d<blocks_per_copy>(idx, input, output, size);
+}
+
+template<int blocks_per_copy>
+__global__ void batched_memcpy_table_k(const BatchedD2DCopy* copies) {
+  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
+
+  const BatchedD2DCopy copy = copies[blockIdx.x / blocks_per_copy];
+  batched_memcpy_unaligned_d<blocks_per_copy>(idx, copy.in, copy.out, copy.size);
+}
+
+// Older ROCm compilers only allow kernels without __launch_bounds__ to be
+// launched with up to 256 threads per block, so each copy is spread over more
+// blocks than in the CUDA build instead.
+#define NTHREADS_D2D_KERNEL 256
+#define BLOCKS_PER_COPY_D2D_KERNEL 32
+void BatchedD2DMemcpyROCmImpl(BatchedD2DParams& params, int num_copies, hipStream_t stream)
+{
+   batched_memcpy_k<BLOCKS_PER_COPY_D2D_KERNEL><<<num_copies * BLOCKS_PER_COPY_D2D_KERNEL,
+                                                  NTHREADS_D2D_KERNEL, 0, stream>>>(params);
+}
+
+void BatchedD2DMemcpyTableROCmImpl(const BatchedD2DCopy* copies, int num_copies, hipStream_t stream)
+{
+   if (num_copies == 0) {
+     return;
+   }
+   batched_memcpy_table_k<BLOCKS_PER_COPY_D2D_KERNEL><<<(int64_t)num_copies * BLOCKS_PER_COPY_D2D_KERNEL,
+                                                        NTHREADS_D2D_KERNEL, 0, stream>>>(copies);
+}
+
+template<typename T, typename TS>
+__global__ void scale_buffer_k(const T* input, T* output, int64_t num_elements, const TS scale_factor) {
+
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  for (size_t i = idx; i < num_elements; i += gridDim.x * blockDim.x) {
+    output[i] = scale_factor * input[i];
+  }
+}
+
+// Specialization for half2, all AMD GPUs supported by ROCm compute in half
+__global__ void scale_buffer_half2_k(const __half* input, __half* output, int64_t num_elements, const __half scale_factor) {
+
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  const __half2* input_h2 = reinterpret_cast<const __half2 *>(input);
+  __half2* output_h2 = reinterpret_cast<__half2 *>(output);
+  const __half2 scale_factor_h2 = __halves2half2(scale_factor, scale_factor);
+
+  for (size_t i = idx; i < num_elements / 2; i += gridDim.x * blockDim.x) {
+    output_h2[i] = __hmul2(scale_factor_h2, input_h2[i]);
+  }
+
+  // Deal with last element if num_elements is odd
+  if (idx == 0 && num_elements % 2) {
+    output[num_elements - 1] = __hmul(scale_factor, input[num_elements - 1]);
+  }
+}
+
+// Specialization for bfloat16, scaled in float32
+template<>
+__global__ void scale_buffer_k(const hip_bfloat16* input, hip_bfloat16* output, int64_t num_elements,
+                               const float scale_factor) {
+
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  for (size_t i = idx; i < num_elements; i += gridDim.x * blockDim.x) {
+    output[i] = hip_bfloat16(scale_factor * static_cast<float>(input[i]));
+  }
+}
+
+#define NTHREADS_SCALE_BUFFER_KERNEL 256
+void ScaleBufferROCmImpl(const void* fused_input_data, void* buffer_data, const int64_t num_elements, double scale_factor,
+                         DataType dtype, hipStream_t stream) {
+  const int64_t blocks = (num_elements + NTHREADS_SCALE_BUFFER_KERNEL - 1) / NTHREADS_SCALE_BUFFER_KERNEL;
+  const int threads = NTHREADS_SCALE_BUFFER_KERNEL;
+  switch (dtype) {
+    case HOROVOD_UINT8:
+      scale_buffer_k<<<blocks, threads, 0, stream>>>((const uint8_t*) fused_input_data, (uint8_t*) buffer_data,
+                                                     num_elements, scale_factor);
+      break;
+    case HOROVOD_INT8:
+      scale_buffer_k<<<blocks, threads, 0, stream>>>((const int8_t*) fused_input_data, (int8_t*) buffer_data,
+                                                     num_elements, scale_factor);
+      break;
+    case HOROVOD_INT32:
+      scale_buffer_k<<<blocks, threads, 0, stream>>>((const int32_t*) fused_input_data, (int32_t*) buffer_data,
+                                                     num_elements, scale_factor);
+      break;
+    case HOROVOD_INT64:
+      scale_buffer_k<<<blocks, threads, 0, stream>>>((const int64_t*) fused_input_data, (int64_t*) buffer_data,
+                                                     num_elements, scale_factor);
+      break;
+    case HOROVOD_FLOAT16:
+    {
+      __half scale_factor_half = __float2half((float) scale_factor);
+      if ((size_t) fused_input_data % 4 == 0 && (size_t) buffer_data % 4 == 0) {
+        // If alignment allows, use half2 specialized kernel
+        int64_t num_elements_h2 = (num_elements + 1) / 2;
+        int64_t blocks_h2 = (num_elements_h2 + NTHREADS_SCALE_BUFFER_KERNEL - 1) / NTHREADS_SCALE_BUFFER_KERNEL;
+        scale_buffer_half2_k<<<blocks_h2, threads, 0, stream>>>((const __half*) fused_input_data, (__half*) buffer_data,
+                                                          num_elements, scale_factor_half);
+      } else {
+        scale_buffer_k<<<blocks, threads, 0, stream>>>((const __half*) fused_input_data, (__half*) buffer_data,
+                                                       num_elements, scale_factor_half);
+     }
+      break;
+    }
+    case HOROVOD_BFLOAT16:
+      scale_buffer_k<<<blocks, threads, 0, stream>>>((const hip_bfloat16*) fused_input_data,
+                                                     (hip_bfloat16*) buffer_data, num_elements, (float) scale_factor);
+      break;
+    case HOROVOD_FLOAT32:
+      scale_buffer_k<<<blocks, threads, 0, stream>>>((const float*) fused_input_data, (float*) buffer_data,
+                                                     num_elements, (float) scale_factor);
+      break;
+    case HOROVOD_FLOAT64:
+      scale_buffer_k<<<blocks, threads, 0, stream>>>((const double*) fused_input_data, (double*) buffer_data,
+                                                     num_elements, scale_factor);
+      break;
+    default:
+      throw std::logic_error("Type " + DataType_Name(dtype) +
+                             " not supported by ScaleBufferROCmImpl.");
+  }
+}
+
+template<typename T, typename TS>
+__global__ void scaled_add_buffer_k(const T* input, T* buffer, int64_t num_elements, const TS scale_factor) {
+
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  for (size_t i = idx; i < num_elements; i += gridDim.x * blockDim.x) {
+    buffer[i] += scale_factor * input[i];
+  }
+}
+
+// Specialization for half, added in float32
+template<>
+__global__ void scaled_add_buffer_k(const __half* input, __half* buffer, int64_t num_elements,
+                                    const float scale_factor) {
+
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  for (size_t i = idx; i < num_elements; i += gridDim.x * blockDim.x) {
+    buffer[i] = __float2half(__half2float(buffer[i]) + scale_factor * __half2float(input[i]));
+  }
+}
+
+// Specialization for bfloat16, added in float32
+template<>
+__global__ void scaled_add_buffer_k(const hip_bfloat16* input, hip_bfloat16* buffer, int64_t num_elements,
+                                    const float scale_factor) {
+
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  for (size_t i = idx; i < num_elements; i += gridDim.x * blockDim.x) {
+    buffer[i] = hip_bfloat16(static_cast<float>(buffer[i]) + scale_factor * static_cast<float>(input[i]));
+  }
+}
+
+void ScaledAddBufferROCmImpl(const void* input_data, void* buffer_data, const int64_t num_elements,
+                             double scale_factor, DataType dtype, hipStream_t stream) {
+  const int64_t blocks = (num_elements + NTHREADS_SCALE_BUFFER_KERNEL - 1) / NTHREADS_SCALE_BUFFER_KERNEL;
+  const int threads = NTHREADS_SCALE_BUFFER_KERNEL;
+  switch (dtype) {
+    case HOROVOD_UINT8:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const uint8_t*) input_data, (uint8_t*) buffer_data,
+                                                          num_elements, scale_factor);
+      break;
+    case HOROVOD_INT8:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const int8_t*) input_data, (int8_t*) buffer_data,
+                                                          num_elements, scale_factor);
+      break;
+    case HOROVOD_INT32:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const int32_t*) input_data, (int32_t*) buffer_data,
+                                                          num_elements, scale_factor);
+      break;
+    case HOROVOD_INT64:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const int64_t*) input_data, (int64_t*) buffer_data,
+                                                          num_elements, scale_factor);
+      break;
+    case HOROVOD_FLOAT16:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const __half*) input_data, (__half*) buffer_data,
+                                                          num_elements, (float) scale_factor);
+      break;
+    case HOROVOD_BFLOAT16:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const hip_bfloat16*) input_data,
+                                                          (hip_bfloat16*) buffer_data, num_elements,
+                                                          (float) scale_factor);
+      break;
+    case HOROVOD_FLOAT32:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const float*) input_data, (float*) buffer_data,
+                                                          num_elements, (float) scale_factor);
+      break;
+    case HOROVOD_FLOAT64:
+      scaled_add_buffer_k<<<blocks, threads, 0, stream>>>((const double*) input_data, (double*) buffer_data,
+                                                          num_elements, scale_factor);
+      break;
+    default:
+      throw std::logic_error("Type " + DataType_Name(dtype) +
+                             " not supported by ScaledAddBufferROCmImpl.");
+  }
+}
+
+template<typename TL, int blocks_per_copy, typename T, typename TS>
+__device__ void batched_scaled_memcpy_d(size_t idx, const T* input, T* output, size_t size, const TS scale_factor) {
+
+  const int64_t num_words = size / sizeof(TL);
+  const TL* read_ptr = reinterpret_cast<const TL*>(input);
+  TL* write_ptr = reinterpret_cast<TL*>(output);
+  for (size_t i = idx; i < num_words; i += blockDim.x * blocks_per_copy) {
+    // Load word
+    TL word = read_ptr[i];
+    T* val = reinterpret_cast<T*>(&word);
+
+    // Scale elements in word
+    for (int j = 0; j < sizeof(TL) / sizeof(T); ++j) {
+      val[j] *= scale_factor;
+    }
+
+    // Write word
+    write_ptr[i] = word;
+  }
+
+  // Deal with any remaining elements
+  size_t remainder = (size % sizeof(TL)) / sizeof(T);
+  if (remainder > 0 && idx < remainder) {
+    const T* input_r = reinterpret_cast<const T*>(read_ptr + num_words);
+    T* output_r = reinterpret_cast<T*>(write_ptr + num_words);
+    output_r[idx] = scale_factor * input_r[idx];
+  }
+}
+
+// Specialization for bfloat16, scaled in float32
+template<typename TL, int blocks_per_copy>
+__device__ void batched_scaled_memcpy_d(size_t idx, const hip_bfloat16* input, hip_bfloat16* output, size_t size,
+                                        const float scale_factor) {
+
+  const int64_t num_words = size / sizeof(TL);
+  const TL* read_ptr = reinterpret_cast<const TL*>(input);
+  TL* write_ptr = reinterpret_cast<TL*>(output);
+  for (size_t i = idx; i < num_words; i += blockDim.x * blocks_per_copy) {
+    // Load word
+    TL word = read_ptr[i];
+    hip_bfloat16* val = reinterpret_cast<hip_bfloat16*>(&word);
+
+    // Scale elements in word
+    for (int j = 0; j < sizeof(TL) / sizeof(hip_bfloat16); ++j) {
+      val[j] = hip_bfloat16(scale_factor * static_cast<float>(val[j]));
+    }
+
+    // Write word
+    write_ptr[i] = word;
+  }
+
+  // Deal with any remaining elements
+  size_t remainder = (size % sizeof(TL)) / sizeof(hip_bfloat16);
+  if (remainder > 0 && idx < remainder) {
+    const hip_bfloat16* input_r = reinterpret_cast<const hip_bfloat16*>(read_ptr + num_words);
+    hip_bfloat16* output_r = reinterpret_cast<hip_bfloat16*>(write_ptr + num_words);
+    output_r[idx] = hip_bfloat16(scale_factor * static_cast<float>(input_r[idx]));
+  }
+}
+
+// As batched_memcpy_unaligned_d, for element-aligned input and output. The
+// common alignment is then never narrower than an element.
+template<int blocks_per_copy, typename T, typename TS>
+__device__ void batched_scaled_memcpy_unaligned_d(size_t idx, const T* input, T* output, size_t size,
+                                                  const TS scale_factor) {
+  size_t head;
+  size_t align = batched_memcpy_alignment(input, output, size, head);
+  batched_scaled_memcpy_d<T, blocks_per_copy>(idx, input, output, head, scale_factor);
+  input += head / sizeof(T);
+  output += head / sizeof(T);
+  size -= head;
+
+  if (align == 16) {
+    batched_scaled_memcpy_d<ulonglong2, blocks_per_copy>(idx, input, output, size, scale_factor);
+  } else if (align == 8) {
+    batched_scaled_memcpy_d<unsigned long long, blocks_per_copy>(idx, input, output, size, scale_factor);
+  } else if (align == 4) {
+    batched_scaled_memcpy_d<unsigned int, blocks_per_copy>(idx, input, output, size, scale_factor);
+  } else if (align == 2) {
+    batched_scaled_memcpy_d<unsigned short, blocks_per_copy>(idx, input, output, size, scale_factor);
+  } else {
+    batched_scaled_memcpy_d<unsigned char, blocks_per_copy>(idx, input, output, size, scale_factor);
+  }
+}
+
+template<typename T, int blocks_per_copy, typename TS>
+__global__ void batched_scaled_memcpy_k(BatchedD2DParams params, TS scale_factor) {
+  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
+
+  const size_t size = params.sizes[blockIdx.x / blocks_per_copy];
+  const T* input = reinterpret_cast<const T*>(params.in[blockIdx.x / blocks_per_copy]);
+  T* output = reinterpret_cast<T*>(params.out[blockIdx.x / blocks_per_copy]);
+
+  batched_scaled_memcpy_unaligned_d<blocks_per_copy>(idx, input, output, size, scale_factor);
+}
+
+template<typename T, int blocks_per_copy, typename TS>
+__global__ void batched_scaled_memcpy_table_k(const BatchedD2DCopy* copies, TS scale_factor) {
+  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
+
+  const BatchedD2DCopy copy = copies[blockIdx.x / blocks_per_copy];
+  batched_scaled_memcpy_unaligned_d<blocks_per_copy>(idx, reinterpret_cast<const T*>(copy.in),
+                                                     reinterpret_cast<T*>(copy.out), copy.size, scale_factor);
+}
+
+void BatchedScaledD2DMemcpyROCmImpl(BatchedD2DParams& params, int num_copies, double scale_factor,
+                                    DataType dtype, hipStream_t stream) {
+  const int64_t blocks = num_copies * BLOCKS_PER_COPY_D2D_KERNEL;
+  const int threads = NTHREADS_D2D_KERNEL;
+  switch (dtype) {
+   case HOROVOD_UINT8:
+     batched_scaled_memcpy_k<uint8_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(params, scale_factor);
+     break;
+   case HOROVOD_INT8:
+     batched_scaled_memcpy_k<int8_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(params, scale_factor);
+     break;
+   case HOROVOD_INT32:
+     batched_scaled_memcpy_k<int32_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(params, scale_factor);
+     break;
+   case HOROVOD_INT64:
+     batched_scaled_memcpy_k<int64_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(params, scale_factor);
+     break;
+   case HOROVOD_FLOAT16: {
+     __half scale_factor_half = __float2half((float) scale_factor);
+     batched_scaled_memcpy_k<__half, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(params, scale_factor_half);
+     break;
+   }
+   case HOROVOD_BFLOAT16:
+     batched_scaled_memcpy_k<hip_bfloat16, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(params, (float) scale_factor);
+     break;
+   case HOROVOD_FLOAT32:
+     batched_scaled_memcpy_k<float, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(params, (float) scale_factor);
+     break;
+   case HOROVOD_FLOAT64:
+     batched_scaled_memcpy_k<double, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(params, scale_factor);
+     break;
+   default:
+     throw std::logic_error("Type " + DataType_Name(dtype) +
+                            " not supported by BatchedScaledD2DMemcpyROCmImpl.");
+  }
+}
+
+void BatchedScaledD2DMemcpyTableROCmImpl(const BatchedD2DCopy* copies, int num_copies, double scale_factor,
+                                         DataType dtype, hipStream_t stream) {
+  if (num_copies == 0) {
+    return;
+  }
+  const int64_t blocks = (int64_t)num_copies * BLOCKS_PER_COPY_D2D_KERNEL;
+  const int threads = NTHREADS_D2D_KERNEL;
+  switch (dtype) {
+   case HOROVOD_UINT8:
+     batched_scaled_memcpy_table_k<uint8_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor);
+     break;
+   case HOROVOD_INT8:
+     batched_scaled_memcpy_table_k<int8_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor);
+     break;
+   case HOROVOD_INT32:
+     batched_scaled_memcpy_table_k<int32_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor);
+     break;
+   case HOROVOD_INT64:
+     batched_scaled_memcpy_table_k<int64_t, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor);
+     break;
+   case HOROVOD_FLOAT16: {
+     __half scale_factor_half = __float2half((float) scale_factor);
+     batched_scaled_memcpy_table_k<__half, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor_half);
+     break;
+   }
+   case HOROVOD_BFLOAT16:
+     batched_scaled_memcpy_table_k<hip_bfloat16, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, (float) scale_factor);
+     break;
+   case HOROVOD_FLOAT32:
+     batched_scaled_memcpy_table_k<float, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, (float) scale_factor);
+     break;
+   case HOROVOD_FLOAT64:
+     batched_scaled_memcpy_table_k<double, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(copies, scale_factor);
+     break;
+   default:
+     throw std::logic_error("Type " + DataType_Name(dtype) +
+                            " not supported by BatchedScaledD2DMemcpyTableROCmImpl.");
+  }
+}
+
+template<typename T>
+__device__ float cast_to_float(T value);
+
+template<>
+__device__ float cast_to_float(float value) {
+  return value;
+}
+
+template<>
+__device__ float cast_to_float(__half value) {
+  return __half2float(value);
+}
+
+template<typename T>
+__device__ T cast_from_float(float value);
+
+template<>
+__device__ float cast_from_float(float value) {
+  return value;
+}
+
+template<>
+__device__ __half cast_from_float(float value) {
+  return __float2half(value);
+}
+
+template<>
+__device__ float cast_to_float(hip_bfloat16 value) {
+  return static_cast<float>(value);
+}
+
+template<>
+__device__ hip_bfloat16 cast_from_float(float value) {
+  return hip_bfloat16(value);
+}
+
+template<typename TIn, typename TOut, int blocks_per_copy>
+__global__ void batched_scaled_cast_memcpy_k(BatchedD2DParams params, float scale_factor) {
+  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
+
+  const size_t num_elements = params.sizes[blockIdx.x / blocks_per_copy];
+  const TIn* input = reinterpret_cast<const TIn*>(params.in[blockIdx.x / blocks_per_copy]);
+  TOut* output = reinterpret_cast<TOut*>(params.out[blockIdx.x / blocks_per_copy]);
+
+  // Scaling is done in float32 so that the float16 range is only hit by the
+  // scaled value.
+  for (size_t i = idx; i < num_elements; i += blockDim.x * blocks_per_copy) {
+    output[i] = cast_from_float<TOut>(scale_factor * cast_to_float(input[i]));
+  }
+}
+
+void BatchedScaledCastD2DMemcpyROCmImpl(BatchedD2DParams& params, int num_copies, double scale_factor,
+                                        DataType in_dtype, DataType out_dtype, hipStream_t stream) {
+  const int64_t blocks = num_copies * BLOCKS_PER_COPY_D2D_KERNEL;
+  const int threads = NTHREADS_D2D_KERNEL;
+  if (in_dtype == HOROVOD_FLOAT32 && out_dtype == HOROVOD_FLOAT16) {
+    batched_scaled_cast_memcpy_k<float, __half, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(
+        params, (float) scale_factor);
+  } else if (in_dtype == HOROVOD_FLOAT16 && out_dtype == HOROVOD_FLOAT32) {
+    batched_scaled_cast_memcpy_k<__half, float, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(
+        params, (float) scale_factor);
+  } else {
+    throw std::logic_error("Conversion from " + DataType_Name(in_dtype) + " to " + DataType_Name(out_dtype) +
+                           " not supported by BatchedScaledCastD2DMemcpyROCmImpl.");
+  }
+}
+
+template<typename TOut, int blocks_per_copy>
+__global__ void batched_scaled_cast_memcpy_ef_k(BatchedCastEFParams params, float scale_factor) {
+  const size_t idx = blockDim.x * (blockIdx.x % blocks_per_copy) + threadIdx.x;
+
+  const size_t num_elements = params.sizes[blockIdx.x / blocks_per_copy];
+  const float* input = reinterpret_cast<const float*>(params.in[blockIdx.x / blocks_per_copy]);
+  TOut* output = reinterpret_cast<TOut*>(params.out[blockIdx.x / blocks_per_copy]);
+  float* residual = params.residuals[blockIdx.x / blocks_per_copy];
+
+  for (size_t i = idx; i < num_elements; i += blockDim.x * blocks_per_copy) {
+    float value = scale_factor * input[i] + residual[i];
+    TOut compressed = cast_from_float<TOut>(value);
+    residual[i] = value - cast_to_float(compressed);
+    output[i] = compressed;
+  }
+}
+
+void BatchedScaledCastEFD2DMemcpyROCmImpl(BatchedCastEFParams& params, int num_copies, double scale_factor,
+                                          DataType out_dtype, hipStream_t stream) {
+  const int64_t blocks = num_copies * BLOCKS_PER_COPY_D2D_KERNEL;
+  const int threads = NTHREADS_D2D_KERNEL;
+  if (out_dtype == HOROVOD_FLOAT16) {
+    batched_scaled_cast_memcpy_ef_k<__half, BLOCKS_PER_COPY_D2D_KERNEL><<<blocks, threads, 0, stream>>>(
+        params, (float) scale_factor);
+  } else {
+    throw std::logic_error("Conversion to " + DataType_Name(out_dtype) +
+                           " not supported by BatchedScaledCastEFD2DMemcpyROCmImpl.");
+  }
+}
+
+template<typename TIn, typename TOut>
+__global__ void scaled_cast_buffer_k(const TIn* input, TOut* output, int64_t num_elements, float scale_factor) {
+  const size_t idx = static_cast<size_t>(blockDim.x) * blockIdx.x + threadIdx.x;
+
+  for (size_t i = idx; i < num_elements; i += gridDim.x * blockDim.x) {
+    output[i] = cast_from_float<TOut>(scale_factor * cast_to_float(input[i]));
+  }
+}
+
+void ScaledCastBufferROCmImpl(const void* input_data, void* buffer_data, const int64_t num_elements,
+                              double scale_factor, DataType in_dtype, DataType out_dtype, hipStream_t stream) {
+  const int64_t blocks = (num_elements + NTHREADS_SCALE_BUFFER_KERNEL - 1) / NTHREADS_SCALE_BUFFER_KERNEL;
+  const int threads = NTHREADS_SCALE_BUFFER_KERNEL;
+  if (in_dtype == HOROVOD_FLOAT32 && out_dtype == HOROVOD_FLOAT16) {
+    scaled_cast_buffer_k<<<blocks, threads, 0, stream>>>((const float*) input_data, (__half*) buffer_data,
+                                                         num_elements, (float) scale_factor);
+  } else if (in_dtype == HOROVOD_FLOAT16 && out_dtype == HOROVOD_FLOAT32) {
+    scaled_cast_buffer_k<<<blocks, threads, 0, stream>>>((const __half*) input_data, (float*) buffer_data,
+                                                         num_elements, (float) scale_factor);
+  } else if (in_dtype == HOROVOD_FLOAT32 && out_dtype == HOROVOD_BFLOAT16) {
+    scaled_cast_buffer_k<<<blocks, threads, 0, stream>>>((const float*) input_data, (hip_bfloat16*) buffer_data,
+                                                         num_elements, (float) scale_factor);
+  } else if (in_dtype == HOROVOD_BFLOAT16 && out_dtype == HOROVOD_FLOAT32) {
+    scaled_cast_buffer_k<<<blocks, threads, 0, stream>>>((const hip_bfloat16*) input_data, (float*) buffer_data,
+                                                         num_elements, (float) scale_factor);
+  } else {
+    throw std::logic_error("Conversion from " + DataType_Name(in_dtype) + " to " + DataType_Name(out_dtype) +
+                           " not supported by ScaledCastBufferROCmImpl.");
+  }
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,91 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HIP_KERNELS_H
+#define HIP_KERNELS_H
+
+#include <hip/hip_runtime.h>
+
+#include "../../message.h"
+
+#define BATCHED_D2D_CAPACITY 160
+#define BATCHED_D2D_PADDING 16
+#define BATCHED_CAST_EF_CAPACITY 120
+
+namespace horovod {
+namespace common {
+
+// HIP builds of the kernels in cuda/cuda_kernels.h, with the same semantics.
+
+struct BatchedD2DParams {
+  void* out[BATCHED_D2D_CAPACITY];
+  void* in[BATCHED_D2D_CAPACITY];
+  size_t sizes[BATCHED_D2D_CAPACITY];
+};
+
+// Performs a batched d2d memcopy
+void BatchedD2DMemcpyROCmImpl(BatchedD2DParams& params, int num_copies, hipStream_t stream);
+
+// Copy of a batched d2d memcopy whose descriptors live in device memory, so
+// that a single launch covers any number of them.
+struct BatchedD2DCopy {
+  void* out;
+  const void* in;
+  size_t size;
+};
+
+// Performs the num_copies d2d memcopies in the device array copies. Buffers
+// need not be aligned: the bytes up to the widest alignment input and output
+// share are copied first, the rest with loads and stores of up to 16 bytes.
+void BatchedD2DMemcpyTableROCmImpl(const BatchedD2DCopy* copies, int num_copies, hipStream_t stream);
+
+// Scales buffer by scalar
+void ScaleBufferROCmImpl(const void* fused_input_data, void* buffer_data, const int64_t num_elements,
+                         double scale_factor, DataType dtype, hipStream_t stream);
+
+// Adds input scaled by scalar to buffer
+void ScaledAddBufferROCmImpl(const void* input_data, void* buffer_data, const int64_t num_elements,
+                             double scale_factor, DataType dtype, hipStream_t stream);
+
+void BatchedScaledD2DMemcpyROCmImpl(BatchedD2DParams& params, int num_copies, double scale_factor,
+                                    DataType dtype, hipStream_t stream);
+
+// As BatchedD2DMemcpyTableROCmImpl, also scaling the elements by scale_factor.
+// Sizes are in bytes.
+void BatchedScaledD2DMemcpyTableROCmImpl(const BatchedD2DCopy* copies, int num_copies, double scale_factor,
+                                         DataType dtype, hipStream_t stream);
+
+// Performs a batched d2d memcopy that also scales and converts between float32 and
+// float16. Unlike the other batched kernels, params.sizes holds element counts.
+void BatchedScaledCastD2DMemcpyROCmImpl(BatchedD2DParams& params, int num_copies, double scale_factor,
+                                        DataType in_dtype, DataType out_dtype, hipStream_t stream);
+
+struct BatchedCastEFParams {
+  void* out[BATCHED_CAST_EF_CAPACITY];
+  const void* in[BATCHED_CAST_EF_CAPACITY];
+  float* residuals[BATCHED_CAST_EF_CAPACITY];
+  size_t sizes[BATCHED_CAST_EF_CAPACITY];
+};
+
+void BatchedScaledCastEFD2DMemcpyROCmImpl(BatchedCastEFParams& params, int num_copies, double scale_factor,
+                                          DataType out_dtype, hipStream_t stream);
+
+void ScaledCastBufferROCmImpl(const void* input_data, void* buffer_data, const int64_t num_elements,
+                              double scale_factor, DataType in_dtype, DataType out_dtype, hipStream_t stream);
+
+} // namespace common
+} // namespace horovod
+
+#endif // HIP_KERNELS_H
@@ -16,9 +16,12 @@
 
 #include "bayesian_optimization.h"
 
+#include <algorithm>
 #include <cmath>
+#include <exception>
 #include <iostream>
 #include <numeric>
+#include <thread>
 
 #include <Eigen/LU>
 #include "LBFGS.h"
@@ -85,8 +88,15 @@ VectorXd BayesianOptimization::NextSample(bool normalize) {
     y_sample.row(i) = y_i;
   }
 
-  // Generate the posterior distribution for the GP given the observed data.
-  gpr_.Fit(&x_sample, &y_sample);
+  // Generate the posterior distribution for the GP given the observed data. Fitting the kernel
+  // parameters dominates the cost of a new sample, so in between refits the new samples only
+  // extend the factorization of the kernel matrix.
+  if (fit_samples_ == 0 || x_samples_.size() >= 2 * fit_samples_) {
+    gpr_.Fit(&x_sample, &y_sample);
+    fit_samples_ = x_samples_.size();
+  } else {
+    gpr_.Update(x_sample, y_sample);
+  }
 
   // Return the next proposed location that maximizes the expected improvement.
   return ProposeLocation(x_sample, y_sample);
@@ -95,12 +105,21 @@ VectorXd BayesianOptimization::NextSample(bool normalize) {
 void BayesianOptimization::Clear() {
   x_samples_.clear();
   y_samples_.clear();
+  fit_samples_ = 0;
 }
 
 VectorXd BayesianOptimization::ProposeLocation(const MatrixXd& x_sample, const MatrixXd& y_sample, int n_restarts) {
+  // Needed for noise-based model, otherwise use y_sample.maxCoeff().
+  // See also section 2.4 in https://arxiv.org/pdf/1012.2599.pdf:
+  // Eric Brochu, Vlad M. Cora, Nando de Freitas,
+  // A Tutorial on Bayesian Optimization of Expensive Cost Functions
+  Eigen::VectorXd mu_sample;
+  gpr_.Predict(x_sample, mu_sample);
+  double mu_sample_opt = mu_sample.maxCoeff();
+
   // Objective function we wish to minimize, the negative acquisition function.
   auto f = [&](const VectorXd& x) {
-    return -ExpectedImprovement(x.transpose(), x_sample)[0];
+    return -ExpectedImprovement(x.transpose(), mu_sample_opt)[0];
   };
 
   // Minimization routine. To approximate bounded LBFGS, we set to infinity the value of any input outside of bound.
@@ -115,26 +134,47 @@ VectorXd BayesianOptimization::ProposeLocation(const MatrixXd& x_sample, const M
   LBFGSpp::LBFGSParam<double> param;
   param.epsilon = 1e-5;
   param.max_iterations = 100;
-  LBFGSpp::LBFGSSolver<double> solver(param);
 
-  // Optimize with random restarts to avoid getting stuck in local minimum.
-  VectorXd x_next = VectorXd::Zero(d_);
-  double fx_min = std::numeric_limits<double>::max();
-  for (int i = 0; i < n_restarts; ++i) {
-    // Generate a random starting point by drawing from our bounded distributions.
-    VectorXd x = VectorXd::Zero(d_);
+  // Optimize with random restarts to avoid getting stuck in local minimum. The starting points
+  // are generated by drawing from our bounded distributions up front, so that the restarts can
+  // run in parallel.
+  std::vector<VectorXd> xs(n_restarts, VectorXd::Zero(d_));
+  for (auto& x : xs) {
     for (unsigned int j = 0; j < d_; ++j) {
       x[j] = dists_[j](gen_);
     }
+  }
+  std::vector<double> fxs(n_restarts, std::numeric_limits<double>::max());
+
+  // Minimize the objective function from every n_threads-th starting point per thread.
+  int n_threads = std::max(1, std::min<int>(n_restarts, std::thread::hardware_concurrency()));
+  auto minimize = [&](int first) {
+    LBFGSpp::LBFGSSolver<double> solver(param);
+    for (int i = first; i < n_restarts; i += n_threads) {
+      try {
+        solver.minimize(min_obj, xs[i], fxs[i]);
+      } catch (const std::exception& e) {
+        // A failed line search must not escape the thread, the restart is dropped instead.
+        fxs[i] = std::numeric_limits<double>::max();
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int t = 1; t < n_threads; ++t) {
+    threads.emplace_back(minimize, t);
+  }
+  minimize(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
 
-    // Minimize the objective function.
-    double fx;
-    solver.minimize(min_obj, x, fx);
-
-    // Update the new minimum among all attempts.
-    if (fx < fx_min) {
-      fx_min = fx;
-      x_next = x;
+  // Take the minimum among all attempts.
+  VectorXd x_next = VectorXd::Zero(d_);
+  double fx_min = std::numeric_limits<double>::max();
+  for (int i = 0; i < n_restarts; ++i) {
+    if (fxs[i] < fx_min) {
+      fx_min = fxs[i];
+      x_next = xs[i];
     }
   }
 
@@ -142,22 +182,12 @@ VectorXd BayesianOptimization::ProposeLocation(const MatrixXd& x_sample, const M
   return x_next;
 }
 
-VectorXd BayesianOptimization::ExpectedImprovement(const MatrixXd& x, const MatrixXd& x_sample) {
+VectorXd BayesianOptimization::ExpectedImprovement(const MatrixXd& x, double mu_sample_opt) const {
   // Compute sufficient statistics for the proposed locations.
   Eigen::VectorXd mu;
   Eigen::VectorXd sigma;
   gpr_.Predict(x, mu, &sigma);
 
-  // Compute sufficient statistics for the observed locations.
-  Eigen::VectorXd mu_sample;
-  gpr_.Predict(x_sample, mu_sample);
-
-  // Needed for noise-based model, otherwise use y_sample.maxCoeff().
-  // See also section 2.4 in https://arxiv.org/pdf/1012.2599.pdf:
-  // Eric Brochu, Vlad M. Cora, Nando de Freitas,
-  // A Tutorial on Bayesian Optimization of Expensive Cost Functions
-  double mu_sample_opt = mu_sample.maxCoeff();
-
   // Probability density function of the standard normal distribution.
   auto pdf = [](double x) {
     return std::exp(-(x * x) / 2.0) / NORM_PDF_C;
@@ -181,7 +211,7 @@ VectorXd BayesianOptimization::ExpectedImprovement(const MatrixXd& x, const Matr
   return ei;
 }
 
-bool BayesianOptimization::CheckBounds(const Eigen::VectorXd& x) {
+bool BayesianOptimization::CheckBounds(const Eigen::VectorXd& x) const {
   for (int i = 0; i < x.size(); ++i) {
     if (x[i] < bounds_[i].first || x[i] > bounds_[i].second) {
       return false;
@@ -63,7 +63,9 @@ public:
   void AddSample(const Eigen::VectorXd& x, double y);
 
   // Provides the next sample point to evaluate subject to maximizing the
-  // expected improvement of the target acquisition function.
+  // expected improvement of the target acquisition function. The kernel parameters are
+  // only refit once the number of samples has doubled since the last fit, new samples are
+  // added to the existing fit otherwise. The random restarts run on all cores.
   Eigen::VectorXd NextSample(bool normalize=true);
 
   // Reset the state of the optimizer by clearing all samples.
@@ -87,13 +89,13 @@ private:
   //
   // Args:
   //  x: Proposed points at which EI shall be computed (m x d).
-  //  x_sample: Sample locations observed (n x d).
+  //  mu_sample_opt: Highest predicted mean at the sample locations observed.
   //
   // Returns: Expected improvements at points X.
-  Eigen::VectorXd ExpectedImprovement(const Eigen::MatrixXd& x, const Eigen::MatrixXd& x_sample);
+  Eigen::VectorXd ExpectedImprovement(const Eigen::MatrixXd& x, double mu_sample_opt) const;
 
   // Returns true if all elements of the vector are within the respective bounds for its dimension.
-  bool CheckBounds(const Eigen::VectorXd& x);
+  bool CheckBounds(const Eigen::VectorXd& x) const;
 
   unsigned long d_;  // Dimension of the input data.
   std::vector<std::pair<double, double>> bounds_;
@@ -106,6 +108,9 @@ private:
   GaussianProcessRegressor gpr_;
   std::vector<Eigen::VectorXd> x_samples_;
   std::vector<double> y_samples_;
+
+  // Number of samples the kernel parameters of gpr_ were last fit to, 0 if not fit yet.
+  size_t fit_samples_ = 0;
 };
 
 } // namespace common
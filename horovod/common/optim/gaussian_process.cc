@@ -17,6 +17,7 @@
 
 #include "gaussian_process.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -44,8 +45,8 @@ GaussianProcessRegressor::GaussianProcessRegressor(double alpha) : alpha_(alpha)
 
 void GaussianProcessRegressor::Fit(MatrixXd* x_train, MatrixXd* y_train) {
   // Cache the last used training inputs and outputs for later prediction
-  x_train_ = x_train;
-  y_train_ = y_train;
+  x_train_ = *x_train;
+  y_train_ = *y_train;
 
   // This function will apply the natural logarithm element-wise to a matrix
   auto ln = [](double x) {
@@ -55,16 +56,16 @@ void GaussianProcessRegressor::Fit(MatrixXd* x_train, MatrixXd* y_train) {
   // f(x): the objective function to be minimized by our optimizer.
   // Computes the negative log-likelihood for training data x_train and y_train and given noise level.
   double a2 = alpha_ * alpha_;
-  double d3 = 0.5 * x_train_->rows() * std::log(2 * M_PI);
+  double d3 = 0.5 * x_train_.rows() * std::log(2 * M_PI);
   auto f = [&, a2, d3](const VectorXd& x) {
-    int64_t m = x_train_->rows();
-    MatrixXd k = Kernel(*x_train_, *x_train_, x[0], x[1]) + (a2 * MatrixXd::Identity(m, m));
-    MatrixXd k_inv = k.inverse();
+    int64_t m = x_train_.rows();
+    MatrixXd k = Kernel(x_train_, x_train_, x[0], x[1]) + (a2 * MatrixXd::Identity(m, m));
 
-    // Compute determinant via Cholesky decomposition
-    MatrixXd l = k.llt().matrixL().toDenseMatrix();
+    // Compute determinant and solve via Cholesky decomposition
+    Eigen::LLT<MatrixXd> llt(k);
+    MatrixXd l = llt.matrixL().toDenseMatrix();
     double d1 = l.diagonal().unaryExpr(ln).sum();
-    MatrixXd d2 = 0.5 * (y_train_->transpose() * (k_inv * (*y_train_)));
+    MatrixXd d2 = 0.5 * (y_train_.transpose() * llt.solve(y_train_));
     MatrixXd cov = d2.array() + (d1 + d3);
 
     return cov(0, 0);
@@ -109,19 +110,62 @@ void GaussianProcessRegressor::Fit(MatrixXd* x_train, MatrixXd* y_train) {
     length_ = x_min[0];
     sigma_f_ = x_min[1];
   }
+
+  Factorize(0);
+}
+
+void GaussianProcessRegressor::Update(const MatrixXd& x_train, const MatrixXd& y_train) {
+  int64_t from = x_train_.rows();
+  x_train_ = x_train;
+  y_train_ = y_train;
+  Factorize(from);
+}
+
+void GaussianProcessRegressor::Factorize(int64_t from) {
+  int64_t m = x_train_.rows();
+  int64_t n = m - from;
+  double a2 = alpha_ * alpha_;
+
+  // For the kernel matrix [[k11, k12], [k12^T, k22]] with k11 = l11 l11^T already factorized,
+  // the factor of the whole matrix is [[l11, 0], [l21, l22]] with l21 = (l11^-1 k12)^T and
+  // l22 the factor of k22 - l21 l21^T.
+  MatrixXd l = MatrixXd::Zero(m, m);
+  MatrixXd x_new = x_train_.bottomRows(n);
+  MatrixXd k22 = Kernel(x_new, x_new, length_, sigma_f_) + (a2 * MatrixXd::Identity(n, n));
+  if (from > 0) {
+    l.topLeftCorner(from, from) = l_;
+    MatrixXd k12 = Kernel(x_train_.topRows(from), x_new, length_, sigma_f_);
+    MatrixXd l21 = l_.triangularView<Eigen::Lower>().solve(k12).transpose();
+    l.bottomLeftCorner(n, from) = l21;
+    k22 -= l21 * l21.transpose();
+  }
+  if (n > 0) {
+    l.bottomRightCorner(n, n) = k22.llt().matrixL().toDenseMatrix();
+  }
+  l_ = l;
+
+  // k^-1 y, solved with the two triangular factors.
+  weights_ = l_.triangularView<Eigen::Lower>().solve(y_train_);
+  weights_ = l_.transpose().triangularView<Eigen::Upper>().solve(weights_);
 }
 
 void GaussianProcessRegressor::Predict(const MatrixXd& x, VectorXd& mu, VectorXd* sigma) const {
-  MatrixXd cov;
-  PosteriorPrediction(x, *x_train_, *y_train_, mu, cov, length_, sigma_f_, alpha_);
+  // Same as PosteriorPrediction, but with the kernel matrix of the training data factorized once
+  // instead of inverted on every call.
+  MatrixXd k_s = Kernel(x_train_, x, length_, sigma_f_);
+  mu = k_s.transpose() * weights_;
 
   // Only compute standard deviation if it was requested
   if (sigma != nullptr) {
-    // Extract the standard deviation from the covariance matrix
+    // The diagonal of the posterior covariance k_ss - k_s^T k^-1 k_s, where the squared exponential
+    // kernel of a point with itself is sigma_f^2.
+    MatrixXd v = l_.triangularView<Eigen::Lower>().solve(k_s);
+    VectorXd var =
+        ((sigma_f_ * sigma_f_ + 1e-8) - v.colwise().squaredNorm().transpose().array()).matrix();
     auto sqrt = [](double x) {
-      return std::sqrt(x);
+      return std::sqrt(std::max(x, 0.0));
     };
-    *sigma = cov.diagonal().unaryExpr(sqrt);
+    *sigma = var.unaryExpr(sqrt);
   }
 }
 
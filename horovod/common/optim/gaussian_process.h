@@ -57,10 +57,16 @@ public:
 
   ~GaussianProcessRegressor() {}
 
-  // Solve for the parameters (length, sigma_f) that best fit the observed training data given.
+  // Solve for the parameters (length, sigma_f) that best fit the observed training data given,
+  // and factorize the kernel matrix of the training data for prediction.
   void Fit(Eigen::MatrixXd* x_train, Eigen::MatrixXd* y_train);
 
-  // Evaluate mean and (optional) variance at a point.
+  // Add the rows of x_train beyond those given to the last Fit or Update to the factorization
+  // of the kernel matrix, one bordered Cholesky update instead of a refit, and replace the
+  // training targets. The kernel parameters are kept, and the earlier rows must be unchanged.
+  void Update(const Eigen::MatrixXd& x_train, const Eigen::MatrixXd& y_train);
+
+  // Evaluate mean and (optional) variance at a point. Safe to call from several threads.
   void Predict(const Eigen::MatrixXd& x, Eigen::VectorXd& mu, Eigen::VectorXd* sigma=nullptr) const;
 
   // Computes the suffifient statistics of the GP posterior predictive distribution
@@ -94,6 +100,10 @@ public:
   Eigen::MatrixXd Kernel(const Eigen::MatrixXd& x1, const Eigen::MatrixXd& x2, double l=1.0, double sigma_f=1.0) const;
 
 private:
+  // Extends the Cholesky factor l_ of the kernel matrix from its first `from` training points
+  // to all of them, and solves for the weights of the training targets.
+  void Factorize(int64_t from);
+
   // Kernel parameter for noise. Higher values make more coarse approximations which avoids overfitting to noisy data.
   double alpha_;
 
@@ -106,9 +116,12 @@ private:
   // confidence intervals.
   double sigma_f_;
 
-  // These pointers are not owned.
-  Eigen::MatrixXd* x_train_;
-  Eigen::MatrixXd* y_train_;
+  Eigen::MatrixXd x_train_;
+  Eigen::MatrixXd y_train_;
+
+  // Lower Cholesky factor of the kernel matrix of x_train_, and its inverse applied to y_train_.
+  Eigen::MatrixXd l_;
+  Eigen::MatrixXd weights_;
 };
 
 } // namespace common
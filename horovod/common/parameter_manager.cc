@@ -17,7 +17,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <iomanip>
 #include <limits>
+#include <sstream>
 
 #include "logging.h"
 #include "utils/env_parser.h"
@@ -44,6 +47,14 @@ ParameterManager::ParameterManager() :
     hierarchical_allreduce_(CategoricalParameter<bool>(std::vector<bool>{false, true})),
     hierarchical_allgather_(CategoricalParameter<bool>(std::vector<bool>{false, true})),
     cache_enabled_(CategoricalParameter<bool>(std::vector<bool>{false, true})),
+    num_nccl_streams_(CategoricalParameter<int>(std::vector<int>{1, 2, MAX_TUNED_NCCL_STREAMS})),
+    batch_d2d_memcopies_(CategoricalParameter<bool>(std::vector<bool>{true, false})),
+    adasum_mpi_chunk_size_(CategoricalParameter<int64_t>(
+      std::vector<int64_t>{1 << 30, 64 * 1024 * 1024, 16 * 1024 * 1024, 4 * 1024 * 1024})),
+    gloo_bcube_threshold_(CategoricalParameter<int64_t>(
+      std::vector<int64_t>{64 * 1024, 0, 256 * 1024})),
+    gloo_halving_doubling_threshold_(CategoricalParameter<int64_t>(
+      std::vector<int64_t>{1024 * 1024, 0, 8 * 1024 * 1024})),
     joint_params_(BayesianParameter(
       std::vector<BayesianVariableConfig>{
         { BayesianVariable::fusion_buffer_threshold_mb, std::pair<double, double>(0, 64) },
@@ -57,14 +68,20 @@ ParameterManager::ParameterManager() :
       },
       GetIntEnvOrDefault(HOROVOD_AUTOTUNE_BAYES_OPT_MAX_SAMPLES, DEFAULT_BAYES_OPT_MAX_SAMPLES),
       GetDoubleEnvOrDefault(HOROVOD_AUTOTUNE_GAUSSIAN_PROCESS_NOISE, DEFAULT_GAUSSIAN_PROCESS_NOISE))),
-    parameter_chain_(std::vector<ITunableParameter*>{&joint_params_, &hierarchical_allreduce_, &hierarchical_allgather_,
-                                                     &cache_enabled_}),
+    large_tensor_fusion_threshold_(CategoricalParameter<int64_t>(
+      std::vector<int64_t>{16 * 1024 * 1024, 4 * 1024 * 1024, 64 * 1024 * 1024})),
+    parameter_chain_(std::vector<ITunableParameter*>{&joint_params_, &large_tensor_fusion_threshold_,
+                                                     &hierarchical_allreduce_, &hierarchical_allgather_,
+                                                     &cache_enabled_, &num_nccl_streams_, &batch_d2d_memcopies_,
+                                                     &adasum_mpi_chunk_size_, &gloo_bcube_threshold_,
+                                                     &gloo_halving_doubling_threshold_}),
     active_(false),
     warmup_remaining_(warmups_),
     sample_(0),
     rank_(-1),
     root_rank_(0),
-    writing_(false) {
+    writing_(false),
+    cache_checked_(false) {
   Reset();
 }
 
@@ -73,17 +90,67 @@ void ParameterManager::Initialize(int32_t rank, int32_t root_rank,
   rank_ = rank;
   root_rank_ = root_rank;
   if (rank_ == root_rank) {
-    LOG(INFO) << "Autotuner: Tunable params [hierarchical_allreduce,hierarchical_allgather,cache_enabled,cycle_time_ms,tensor_fusion_threshold] score";
+    LOG(INFO) << "Autotuner: Tunable params [hierarchical_allreduce,hierarchical_allgather,cache_enabled,"
+                 "num_nccl_streams,batch_d2d_memcopies,adasum_mpi_chunk_size,gloo_bcube_threshold,"
+                 "gloo_halving_doubling_threshold,cycle_time_ms,tensor_fusion_threshold,"
+                 "large_tensor_fusion_threshold] score";
   }
   if (rank_ == root_rank && !file_name.empty()) {
     file_.open(file_name, std::ios::out | std::ios::trunc);
     if (file_.good()) {
-      file_ << "hierarchical_allreduce,hierarchical_allgather,cache_enabled,cycle_time_ms,tensor_fusion_threshold,score" << std::endl;
+      file_ << "hierarchical_allreduce,hierarchical_allgather,cache_enabled,num_nccl_streams,batch_d2d_memcopies,"
+               "adasum_mpi_chunk_size,gloo_bcube_threshold,gloo_halving_doubling_threshold,cycle_time_ms,"
+               "tensor_fusion_threshold,large_tensor_fusion_threshold,score"
+            << std::endl;
       writing_ = true;
     }
   }
 }
 
+void ParameterManager::InitializeForProcessSet(const ParameterManager& global,
+                                              int32_t rank) {
+  hierarchical_allreduce_.SetValue(global.hierarchical_allreduce_.BestValue(),
+                                   !global.hierarchical_allreduce_.IsTunable());
+  hierarchical_allgather_.SetValue(global.hierarchical_allgather_.BestValue(),
+                                   !global.hierarchical_allgather_.IsTunable());
+  hierarchical_alltoall_ = global.hierarchical_alltoall_;
+  joint_params_.SetValue(
+      fusion_buffer_threshold_mb,
+      global.joint_params_.BestValue(fusion_buffer_threshold_mb),
+      global.joint_params_.IsFixed(fusion_buffer_threshold_mb));
+  large_tensor_fusion_threshold_.SetValue(
+      global.large_tensor_fusion_threshold_.BestValue(),
+      !global.large_tensor_fusion_threshold_.IsTunable());
+
+  // Process sets share the background thread and the devices.
+  joint_params_.SetValue(cycle_time_ms,
+                         global.joint_params_.BestValue(cycle_time_ms), true);
+  cache_enabled_.SetValue(global.cache_enabled_.BestValue(), true);
+  num_nccl_streams_.SetValue(global.num_nccl_streams_.BestValue(), true);
+  batch_d2d_memcopies_.SetValue(global.batch_d2d_memcopies_.BestValue(), true);
+  adasum_mpi_chunk_size_.SetValue(global.adasum_mpi_chunk_size_.BestValue(),
+                                  true);
+  gloo_bcube_threshold_.SetValue(global.gloo_bcube_threshold_.BestValue(),
+                                 true);
+  gloo_halving_doubling_threshold_.SetValue(
+      global.gloo_halving_doubling_threshold_.BestValue(), true);
+
+  if (global.IsInitialized()) {
+    // Tuning was requested. Log files and the cache only cover the global
+    // process set.
+    Initialize(rank, 0, "");
+    SetAutoTuning(true);
+  } else {
+    rank_ = rank;
+  }
+}
+
+void ParameterManager::InitializeCache(const std::string& file_name,
+                                       const std::string& topology) {
+  cache_file_ = file_name;
+  topology_ = topology;
+}
+
 void ParameterManager::SetAutoTuning(bool active) {
   if (active != active_) {
     warmup_remaining_ = warmups_;
@@ -107,6 +174,14 @@ void ParameterManager::SetHierarchicalAllgather(bool value, bool fixed) {
   hierarchical_allgather_.SetValue(value, fixed);
 }
 
+bool ParameterManager::HierarchicalAlltoall() const {
+  return hierarchical_alltoall_;
+}
+
+void ParameterManager::SetHierarchicalAlltoall(bool value) {
+  hierarchical_alltoall_ = value;
+}
+
 bool ParameterManager::CacheEnabled() const {
   return active_ ? cache_enabled_.Value() : cache_enabled_.BestValue();
 };
@@ -115,6 +190,47 @@ void ParameterManager::SetCacheEnabled(bool enabled, bool fixed) {
   cache_enabled_.SetValue(enabled, fixed);
 }
 
+int ParameterManager::NumNcclStreams() const {
+  return active_ ? num_nccl_streams_.Value() : num_nccl_streams_.BestValue();
+}
+
+void ParameterManager::SetNumNcclStreams(int value, bool fixed) {
+  num_nccl_streams_.SetValue(value, fixed);
+}
+
+bool ParameterManager::BatchD2DMemcopies() const {
+  return active_ ? batch_d2d_memcopies_.Value() : batch_d2d_memcopies_.BestValue();
+}
+
+void ParameterManager::SetBatchD2DMemcopies(bool value, bool fixed) {
+  batch_d2d_memcopies_.SetValue(value, fixed);
+}
+
+int64_t ParameterManager::AdasumMPIChunkSize() const {
+  return active_ ? adasum_mpi_chunk_size_.Value() : adasum_mpi_chunk_size_.BestValue();
+}
+
+void ParameterManager::SetAdasumMPIChunkSize(int64_t value, bool fixed) {
+  adasum_mpi_chunk_size_.SetValue(value, fixed);
+}
+
+int64_t ParameterManager::GlooBcubeThreshold() const {
+  return active_ ? gloo_bcube_threshold_.Value() : gloo_bcube_threshold_.BestValue();
+}
+
+void ParameterManager::SetGlooBcubeThreshold(int64_t value, bool fixed) {
+  gloo_bcube_threshold_.SetValue(value, fixed);
+}
+
+int64_t ParameterManager::GlooHalvingDoublingThreshold() const {
+  return active_ ? gloo_halving_doubling_threshold_.Value()
+                 : gloo_halving_doubling_threshold_.BestValue();
+}
+
+void ParameterManager::SetGlooHalvingDoublingThreshold(int64_t value, bool fixed) {
+  gloo_halving_doubling_threshold_.SetValue(value, fixed);
+}
+
 int64_t ParameterManager::TensorFusionThresholdBytes() const {
   double b = active_ ?
       joint_params_.Value(fusion_buffer_threshold_mb) :
@@ -126,6 +242,14 @@ void ParameterManager::SetTensorFusionThresholdBytes(int64_t threshold, bool fix
   joint_params_.SetValue(fusion_buffer_threshold_mb, double(threshold) / (1024 * 1024), fixed);
 }
 
+int64_t ParameterManager::LargeTensorFusionThresholdBytes() const {
+  return active_ ? large_tensor_fusion_threshold_.Value() : large_tensor_fusion_threshold_.BestValue();
+}
+
+void ParameterManager::SetLargeTensorFusionThresholdBytes(int64_t threshold, bool fixed) {
+  large_tensor_fusion_threshold_.SetValue(threshold, fixed);
+}
+
 double ParameterManager::CycleTimeMs() const {
   return active_ ? joint_params_.Value(cycle_time_ms) : joint_params_.BestValue(cycle_time_ms);
 };
@@ -159,6 +283,10 @@ bool ParameterManager::Update(const std::vector<std::string>& tensor_names,
     }
   }
 
+  if (!cache_file_.empty() && !cache_checked_) {
+    observed_tensors_.insert(tensor_names.begin(), tensor_names.end());
+  }
+
   total_bytes_ += bytes;
 
   if (sample_ >= SAMPLES) {
@@ -181,6 +309,20 @@ bool ParameterManager::Tune(double score) {
       LOG(INFO) << "Autotuner: Warming up (" << warmup_remaining_ << " remaining)";
     }
   } else {
+    if (!cache_file_.empty() && !cache_checked_) {
+      // All tensors of a step have been seen by now, so the model can be
+      // identified. Every rank returns true from here on, so the coordinator
+      // may stop tuning without the others knowing in advance.
+      cache_checked_ = true;
+      fingerprint_ = Fingerprint();
+      if (rank_ == root_rank_ && LoadCachedParameters()) {
+        LOG(INFO) << "Autotuner: Using cached parameters for " << fingerprint_;
+        SetAutoTuning(false);
+        LogBestParameters();
+        return true;
+      }
+    }
+
     // Log the last parameter values before updating.
     LogParameters(score);
 
@@ -202,6 +344,7 @@ bool ParameterManager::Tune(double score) {
       if (finished_tuning) {
         SetAutoTuning(false);
         LogBestParameters();
+        SaveCachedParameters();
       }
     }
 
@@ -221,17 +364,30 @@ ParameterManager::Params ParameterManager::GetParams() {
     params.hierarchical_allreduce = hierarchical_allreduce_.Value();
     params.hierarchical_allgather = hierarchical_allgather_.Value();
     params.cache_enabled = cache_enabled_.Value();
+    params.num_nccl_streams = num_nccl_streams_.Value();
+    params.batch_d2d_memcopies = batch_d2d_memcopies_.Value();
+    params.adasum_mpi_chunk_size = adasum_mpi_chunk_size_.Value();
+    params.gloo_bcube_threshold = gloo_bcube_threshold_.Value();
+    params.gloo_halving_doubling_threshold = gloo_halving_doubling_threshold_.Value();
     params.tensor_fusion_threshold = joint_params_.Value(fusion_buffer_threshold_mb);
+    params.large_tensor_fusion_threshold = large_tensor_fusion_threshold_.Value();
     params.cycle_time = joint_params_.Value(cycle_time_ms);
   } else {
     // Tuning has completed, so send the best value.
     params.hierarchical_allreduce = hierarchical_allreduce_.BestValue();
     params.hierarchical_allgather = hierarchical_allgather_.BestValue();
     params.cache_enabled = cache_enabled_.BestValue();
+    params.num_nccl_streams = num_nccl_streams_.BestValue();
+    params.batch_d2d_memcopies = batch_d2d_memcopies_.BestValue();
+    params.adasum_mpi_chunk_size = adasum_mpi_chunk_size_.BestValue();
+    params.gloo_bcube_threshold = gloo_bcube_threshold_.BestValue();
+    params.gloo_halving_doubling_threshold = gloo_halving_doubling_threshold_.BestValue();
     params.tensor_fusion_threshold = joint_params_.BestValue(fusion_buffer_threshold_mb);
+    params.large_tensor_fusion_threshold = large_tensor_fusion_threshold_.BestValue();
     params.cycle_time = joint_params_.BestValue(cycle_time_ms);
   }
 
+  params.hierarchical_alltoall = hierarchical_alltoall_;
   params.active = active_;
 
   return params;
@@ -240,8 +396,15 @@ ParameterManager::Params ParameterManager::GetParams() {
 void ParameterManager::SetParams(const Params& newParams) {
   hierarchical_allreduce_.SetValue(newParams.hierarchical_allreduce, true);
   hierarchical_allgather_.SetValue(newParams.hierarchical_allgather, true);
+  hierarchical_alltoall_ = newParams.hierarchical_alltoall;
   cache_enabled_.SetValue(newParams.cache_enabled, true);
+  num_nccl_streams_.SetValue(newParams.num_nccl_streams, true);
+  batch_d2d_memcopies_.SetValue(newParams.batch_d2d_memcopies, true);
+  adasum_mpi_chunk_size_.SetValue(newParams.adasum_mpi_chunk_size, true);
+  gloo_bcube_threshold_.SetValue(newParams.gloo_bcube_threshold, true);
+  gloo_halving_doubling_threshold_.SetValue(newParams.gloo_halving_doubling_threshold, true);
   joint_params_.SetValue(fusion_buffer_threshold_mb, newParams.tensor_fusion_threshold, true);
+  large_tensor_fusion_threshold_.SetValue(newParams.large_tensor_fusion_threshold, true);
   joint_params_.SetValue(cycle_time_ms, newParams.cycle_time, true);
   active_ = newParams.active;
 }
@@ -259,15 +422,27 @@ void ParameterManager::LogParameters(double score) {
               << hierarchical_allreduce_.Value() << ", "
               << hierarchical_allgather_.Value() << ", "
               << cache_enabled_.Value() << ", "
+              << num_nccl_streams_.Value() << ", "
+              << batch_d2d_memcopies_.Value() << ", "
+              << adasum_mpi_chunk_size_.Value() << ", "
+              << gloo_bcube_threshold_.Value() << ", "
+              << gloo_halving_doubling_threshold_.Value() << ", "
               << joint_params_.Value(cycle_time_ms) << " ms, "
-              << joint_params_.Value(fusion_buffer_threshold_mb) << " mb] "
+              << joint_params_.Value(fusion_buffer_threshold_mb) << " mb, "
+              << large_tensor_fusion_threshold_.Value() / (1024 * 1024) << " mb] "
               << score;
     if (writing_ && file_.good()) {
       file_ << hierarchical_allreduce_.Value() << ","
             << hierarchical_allgather_.Value() << ","
             << cache_enabled_.Value() << ","
+            << num_nccl_streams_.Value() << ","
+            << batch_d2d_memcopies_.Value() << ","
+            << adasum_mpi_chunk_size_.Value() << ","
+            << gloo_bcube_threshold_.Value() << ","
+            << gloo_halving_doubling_threshold_.Value() << ","
             << joint_params_.Value(cycle_time_ms) << ","
             << joint_params_.Value(fusion_buffer_threshold_mb) << ","
+            << large_tensor_fusion_threshold_.Value() << ","
             << score
             << std::endl;
     }
@@ -280,21 +455,194 @@ void ParameterManager::LogBestParameters() {
               << hierarchical_allreduce_.BestValue() << ", "
               << hierarchical_allgather_.BestValue() << ", "
               << cache_enabled_.BestValue() << ", "
+              << num_nccl_streams_.BestValue() << ", "
+              << batch_d2d_memcopies_.BestValue() << ", "
+              << adasum_mpi_chunk_size_.BestValue() << ", "
+              << gloo_bcube_threshold_.BestValue() << ", "
+              << gloo_halving_doubling_threshold_.BestValue() << ", "
               << joint_params_.BestValue(cycle_time_ms) << " ms, "
-              << joint_params_.BestValue(fusion_buffer_threshold_mb) << " mb] "
+              << joint_params_.BestValue(fusion_buffer_threshold_mb) << " mb, "
+              << large_tensor_fusion_threshold_.BestValue() / (1024 * 1024) << " mb] "
               << hierarchical_allreduce_.BestScore();
     if (writing_ && file_.good()) {
       file_ << hierarchical_allreduce_.BestValue() << ","
             << hierarchical_allgather_.BestValue() << ","
             << cache_enabled_.BestValue() << ","
+            << num_nccl_streams_.BestValue() << ","
+            << batch_d2d_memcopies_.BestValue() << ","
+            << adasum_mpi_chunk_size_.BestValue() << ","
+            << gloo_bcube_threshold_.BestValue() << ","
+            << gloo_halving_doubling_threshold_.BestValue() << ","
             << joint_params_.BestValue(cycle_time_ms) << ","
             << joint_params_.BestValue(fusion_buffer_threshold_mb) << ","
+            << large_tensor_fusion_threshold_.BestValue() << ","
             << hierarchical_allreduce_.BestScore()
             << std::endl;
     }
   }
 }
 
+std::string ParameterManager::Fingerprint() const {
+  // 64-bit FNV-1a, which unlike std::hash is stable across builds.
+  uint64_t hash = 14695981039346656037ULL;
+  for (auto& name : observed_tensors_) {
+    for (char c : name + "\n") {
+      hash ^= (uint8_t)c;
+      hash *= 1099511628211ULL;
+    }
+  }
+  std::stringstream ss;
+  ss << topology_ << "_" << std::hex << std::setw(16) << std::setfill('0')
+     << hash;
+  return ss.str();
+}
+
+bool ParameterManager::LoadCachedParameters() {
+  std::ifstream file(cache_file_);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::stringstream ss(line);
+    std::vector<std::string> fields;
+    std::string field;
+    while (std::getline(ss, field, ',')) {
+      fields.push_back(field);
+    }
+    // Entries written before the large tensor fusion threshold was tuned
+    // have one field less, entries written before the Gloo thresholds were
+    // tuned also lack those two.
+    if ((fields.size() != 10 && fields.size() != 11 && fields.size() != 13) ||
+        fields[0] != fingerprint_) {
+      continue;
+    }
+    bool has_gloo_thresholds = fields.size() == 13;
+    size_t next = has_gloo_thresholds ? 9 : 7;
+
+    bool hierarchical_allreduce, hierarchical_allgather, cache_enabled,
+        batch_d2d_memcopies;
+    int num_nccl_streams;
+    int64_t adasum_mpi_chunk_size;
+    int64_t gloo_bcube_threshold = 0, gloo_halving_doubling_threshold = 0;
+    int64_t large_tensor_fusion_threshold = 0;
+    double cycle_time, tensor_fusion_threshold;
+    try {
+      hierarchical_allreduce = std::stoi(fields[1]) != 0;
+      hierarchical_allgather = std::stoi(fields[2]) != 0;
+      cache_enabled = std::stoi(fields[3]) != 0;
+      num_nccl_streams = std::stoi(fields[4]);
+      batch_d2d_memcopies = std::stoi(fields[5]) != 0;
+      adasum_mpi_chunk_size = std::stoll(fields[6]);
+      if (has_gloo_thresholds) {
+        gloo_bcube_threshold = std::stoll(fields[7]);
+        gloo_halving_doubling_threshold = std::stoll(fields[8]);
+      }
+      cycle_time = std::stod(fields[next]);
+      tensor_fusion_threshold = std::stod(fields[next + 1]);
+      if (fields.size() != 10) {
+        large_tensor_fusion_threshold = std::stoll(fields[next + 2]);
+      }
+    } catch (const std::exception&) {
+      LOG(WARNING) << "Autotuner: Ignoring malformed entry in " << cache_file_;
+      continue;
+    }
+
+    // Parameters fixed by the user keep their values.
+    if (hierarchical_allreduce_.IsTunable()) {
+      hierarchical_allreduce_.SetValue(hierarchical_allreduce, false);
+    }
+    if (hierarchical_allgather_.IsTunable()) {
+      hierarchical_allgather_.SetValue(hierarchical_allgather, false);
+    }
+    if (cache_enabled_.IsTunable()) {
+      cache_enabled_.SetValue(cache_enabled, false);
+    }
+    if (num_nccl_streams_.IsTunable()) {
+      num_nccl_streams_.SetValue(
+          std::max(std::min(num_nccl_streams, MAX_TUNED_NCCL_STREAMS), 1),
+          false);
+    }
+    if (batch_d2d_memcopies_.IsTunable()) {
+      batch_d2d_memcopies_.SetValue(batch_d2d_memcopies, false);
+    }
+    if (adasum_mpi_chunk_size_.IsTunable()) {
+      adasum_mpi_chunk_size_.SetValue(adasum_mpi_chunk_size, false);
+    }
+    if (has_gloo_thresholds && gloo_bcube_threshold_.IsTunable()) {
+      gloo_bcube_threshold_.SetValue(gloo_bcube_threshold, false);
+    }
+    if (has_gloo_thresholds && gloo_halving_doubling_threshold_.IsTunable()) {
+      gloo_halving_doubling_threshold_.SetValue(gloo_halving_doubling_threshold,
+                                                false);
+    }
+    if (!joint_params_.IsFixed(cycle_time_ms)) {
+      joint_params_.SetValue(cycle_time_ms, cycle_time, false);
+    }
+    if (!joint_params_.IsFixed(fusion_buffer_threshold_mb)) {
+      joint_params_.SetValue(fusion_buffer_threshold_mb,
+                             tensor_fusion_threshold, false);
+    }
+    if (large_tensor_fusion_threshold_.IsTunable() &&
+        large_tensor_fusion_threshold > 0) {
+      large_tensor_fusion_threshold_.SetValue(large_tensor_fusion_threshold,
+                                              false);
+    }
+    return true;
+  }
+  return false;
+}
+
+void ParameterManager::SaveCachedParameters() {
+  if (cache_file_.empty() || fingerprint_.empty()) {
+    return;
+  }
+
+  // Keep the entries of other runs, and replace the file at once so that a
+  // job reading it concurrently never sees a partial write.
+  std::vector<std::string> lines;
+  {
+    std::ifstream file(cache_file_);
+    std::string line;
+    while (std::getline(file, line)) {
+      auto key = line.substr(0, line.find(','));
+      if (key != "fingerprint" && key != fingerprint_ && !line.empty()) {
+        lines.push_back(line);
+      }
+    }
+  }
+
+  std::string tmp_file = cache_file_ + ".tmp";
+  {
+    std::ofstream file(tmp_file, std::ios::out | std::ios::trunc);
+    file << "fingerprint,hierarchical_allreduce,hierarchical_allgather,cache_enabled,num_nccl_streams,"
+            "batch_d2d_memcopies,adasum_mpi_chunk_size,gloo_bcube_threshold,gloo_halving_doubling_threshold,"
+            "cycle_time_ms,tensor_fusion_threshold,large_tensor_fusion_threshold,score" << std::endl;
+    for (auto& line : lines) {
+      file << line << std::endl;
+    }
+    file << std::setprecision(std::numeric_limits<double>::max_digits10)
+         << fingerprint_ << ","
+         << hierarchical_allreduce_.BestValue() << ","
+         << hierarchical_allgather_.BestValue() << ","
+         << cache_enabled_.BestValue() << ","
+         << num_nccl_streams_.BestValue() << ","
+         << batch_d2d_memcopies_.BestValue() << ","
+         << adasum_mpi_chunk_size_.BestValue() << ","
+         << gloo_bcube_threshold_.BestValue() << ","
+         << gloo_halving_doubling_threshold_.BestValue() << ","
+         << joint_params_.BestValue(cycle_time_ms) << ","
+         << joint_params_.BestValue(fusion_buffer_threshold_mb) << ","
+         << large_tensor_fusion_threshold_.BestValue() << ","
+         << hierarchical_allreduce_.BestScore()
+         << std::endl;
+    if (!file.good()) {
+      LOG(WARNING) << "Autotuner: Failed to write " << tmp_file;
+      return;
+    }
+  }
+  if (std::rename(tmp_file.c_str(), cache_file_.c_str()) != 0) {
+    LOG(WARNING) << "Autotuner: Failed to replace " << cache_file_;
+  }
+}
+
 // TunableParameter
 template <class T>
 ParameterManager::TunableParameter<T>::TunableParameter(T initial_value) :
@@ -435,6 +783,10 @@ void ParameterManager::BayesianParameter::SetValue(BayesianVariable variable, do
   }
 }
 
+bool ParameterManager::BayesianParameter::IsFixed(BayesianVariable variable) const {
+  return fixed_values_.find(variable) != fixed_values_.end();
+}
+
 double ParameterManager::BayesianParameter::Value(BayesianVariable variable) const {
   auto elem = fixed_values_.find(variable);
   if (elem != fixed_values_.end()) {
@@ -452,13 +804,32 @@ double ParameterManager::BayesianParameter::BestValue(BayesianVariable variable)
 }
 
 void ParameterManager::BayesianParameter::OnTune(double score, Eigen::VectorXd& value) {
-  bayes_->AddSample(value, score);
+  queued_samples_.emplace_back(value, score);
+
+  Eigen::VectorXd proposed;
+  if (proposal_.valid() &&
+      proposal_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    proposed = proposal_.get();
+  }
 
   ++iteration_;
+  if (!proposal_.valid()) {
+    for (auto& sample : queued_samples_) {
+      bayes_->AddSample(sample.first, sample.second);
+    }
+    queued_samples_.clear();
+
+    // Start proposing one window early, while the last test point is sampled.
+    if (iteration_ + 1 >= test_points_.size()) {
+      auto* bayes = bayes_.get();
+      proposal_ = std::async(std::launch::async, [bayes]() { return bayes->NextSample(); });
+    }
+  }
+
   if (iteration_ < test_points_.size()) {
     value = FilterTestPoint(iteration_);
-  } else {
-    value = bayes_->NextSample();
+  } else if (proposed.size() > 0) {
+    value = proposed;
   }
 }
 
@@ -467,11 +838,13 @@ bool ParameterManager::BayesianParameter::IsDoneTuning() const {
 }
 
 void ParameterManager::BayesianParameter::ResetState() {
+  WaitForProposal();
   iteration_ = 0;
   bayes_->Clear();
 }
 
 void ParameterManager::BayesianParameter::ResetBayes() {
+  WaitForProposal();
   index_.clear();
 
   std::vector<std::pair<double, double>> bounds;
@@ -487,6 +860,14 @@ void ParameterManager::BayesianParameter::ResetBayes() {
   bayes_.reset(new BayesianOptimization(bounds, gaussian_process_noise_));
 }
 
+void ParameterManager::BayesianParameter::WaitForProposal() {
+  if (proposal_.valid()) {
+    proposal_.wait();
+    proposal_ = std::future<Eigen::VectorXd>();
+  }
+  queued_samples_.clear();
+}
+
 Eigen::VectorXd ParameterManager::BayesianParameter::FilterTestPoint(int i) {
   Eigen::VectorXd& test_point = test_points_[i];
   Eigen::VectorXd filtered_point(test_point.size() - fixed_values_.size());
@@ -18,8 +18,10 @@
 
 #include <chrono>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <set>
 #include <unordered_map>
 #include <vector>
 
@@ -47,6 +49,25 @@ public:
   // Initializes this manager if auto tuning was requested.
   void Initialize(int32_t rank, int32_t root_rank, const std::string& file_name);
 
+  // Initializes this manager for a process set other than the global one,
+  // whose rank in that process set is given. It starts from the parameters of
+  // global, keeps the ones fixed there fixed, and is tuned on the traffic of
+  // its process set if global is. The cycle time, response cache, NCCL
+  // streams, batched memcopies and Adasum chunk size are shared by all
+  // process sets and fixed to the values of global.
+  void InitializeForProcessSet(const ParameterManager& global, int32_t rank);
+
+  // Whether Initialize or InitializeForProcessSet has been called.
+  inline bool IsInitialized() const {
+    return rank_ >= 0;
+  }
+
+  // Warm-starts tuning from the best parameters recorded in the given file by
+  // an earlier run, and records the result of this run there. Entries are
+  // keyed by the topology string and the names of the tensors processed
+  // before the first sample is scored.
+  void InitializeCache(const std::string& file_name, const std::string& topology);
+
   // Starts or stop the auto tuning procedure.
   void SetAutoTuning(bool active);
 
@@ -63,11 +84,22 @@ public:
   bool HierarchicalAllgather() const;
   void SetHierarchicalAllgather(bool value, bool fixed=false);
 
+  // Do hierarchical alltoall. Not tuned, as the autotuner only scores
+  // allreduce throughput.
+  bool HierarchicalAlltoall() const;
+  void SetHierarchicalAlltoall(bool value);
+
   // Threshold for Tensor Fusion.  All tensors that occupy memory beyond this
   // threshold will be fused.
   int64_t TensorFusionThresholdBytes() const;
   void SetTensorFusionThresholdBytes(int64_t threshold, bool fixed=false);
 
+  // Threshold for Tensor Fusion of the reductions of large tensors, which are
+  // fused separately from the small ones, so that they can go out in smaller
+  // buckets while the small ones fill large buffers.
+  int64_t LargeTensorFusionThresholdBytes() const;
+  void SetLargeTensorFusionThresholdBytes(int64_t threshold, bool fixed=false);
+
   // Background thread cycle time in milliseconds.  Fractional numbers are
   // permitted.
   double CycleTimeMs() const;
@@ -77,6 +109,29 @@ public:
   bool CacheEnabled() const;
   void SetCacheEnabled (bool enabled, bool fixed=false);
 
+  // Number of GPU streams that responses are spread over. Never more than the
+  // number of streams allocated at startup, which is MAX_TUNED_NCCL_STREAMS
+  // while this is tuned.
+  int NumNcclStreams() const;
+  void SetNumNcclStreams(int value, bool fixed=false);
+
+  // Use the batched memcopy kernel for fusion buffer copies on GPU.
+  bool BatchD2DMemcopies() const;
+  void SetBatchD2DMemcopies(bool value, bool fixed=false);
+
+  // Size in bytes of the chunks sent by MPI based Adasum allreduce algorithms.
+  int64_t AdasumMPIChunkSize() const;
+  void SetAdasumMPIChunkSize(int64_t value, bool fixed=false);
+
+  // Gloo allreduces below these sizes in bytes use the bcube and the
+  // halving-doubling algorithm instead of ring.
+  int64_t GlooBcubeThreshold() const;
+  void SetGlooBcubeThreshold(int64_t value, bool fixed=false);
+  int64_t GlooHalvingDoublingThreshold() const;
+  void SetGlooHalvingDoublingThreshold(int64_t value, bool fixed=false);
+
+  static constexpr int MAX_TUNED_NCCL_STREAMS = 4;
+
   // Observes that the given tensors have been processed (e.g., allreduced) over the given number of microseconds.
   //
   // Args:
@@ -90,9 +145,16 @@ public:
   struct Params {
     bool hierarchical_allreduce;
     bool hierarchical_allgather;
+    bool hierarchical_alltoall;
     bool cache_enabled;
     double tensor_fusion_threshold;
+    int64_t large_tensor_fusion_threshold;
     double cycle_time;
+    int num_nccl_streams;
+    bool batch_d2d_memcopies;
+    int64_t adasum_mpi_chunk_size;
+    int64_t gloo_bcube_threshold;
+    int64_t gloo_halving_doubling_threshold;
     bool active;
   };
 
@@ -112,6 +174,16 @@ private:
   void LogParameters(double score);
   void LogBestParameters();
 
+  // Identifies this run in the cache file by its topology and model.
+  std::string Fingerprint() const;
+
+  // Makes the cached parameters of this run the best values. Returns false
+  // if the cache file has no entry for it.
+  bool LoadCachedParameters();
+
+  // Replaces the entry of this run in the cache file with the best values.
+  void SaveCachedParameters();
+
   // Interface used to represent a parameter (or group of parameters) being tuned.
   class ITunableParameter {
   public:
@@ -183,12 +255,18 @@ private:
   };
 
   // A set of numerical parameters optimized jointly using Bayesian Optimization.
+  //
+  // The next sample is proposed on a helper thread, so that tuning never blocks the background
+  // thread. Until the proposal is ready, the current value is sampled again, and the samples
+  // observed meanwhile are queued. A proposal therefore misses the samples of the windows that
+  // ran while it was computed.
   class BayesianParameter : public TunableParameter<Eigen::VectorXd> {
   public:
     BayesianParameter(std::vector<BayesianVariableConfig> variables, std::vector<Eigen::VectorXd> test_points,
                       int max_samples, double gaussian_process_noise);
 
     void SetValue(BayesianVariable variable, double value, bool fixed);
+    bool IsFixed(BayesianVariable variable) const;
     double Value(BayesianVariable variable) const;
     double BestValue(BayesianVariable variable) const;
 
@@ -197,6 +275,7 @@ private:
     bool IsDoneTuning() const;
     void ResetState();
     void ResetBayes();
+    void WaitForProposal();
     Eigen::VectorXd FilterTestPoint(int i);
     Eigen::VectorXd Remove(const Eigen::VectorXd& v, int index);
 
@@ -217,6 +296,11 @@ private:
     std::unique_ptr<BayesianOptimization> bayes_;
     std::unordered_map<BayesianVariable, double, EnumClassHash> fixed_values_;
     std::unordered_map<BayesianVariable, int32_t, EnumClassHash> index_;
+
+    // Samples not yet added to bayes_, which is only touched by the helper thread while a
+    // proposal is pending. Declared last to be destroyed, and so waited for, first.
+    std::vector<std::pair<Eigen::VectorXd, double>> queued_samples_;
+    std::future<Eigen::VectorXd> proposal_;
   };
 
   int warmups_;
@@ -224,8 +308,15 @@ private:
 
   CategoricalParameter<bool> hierarchical_allreduce_;
   CategoricalParameter<bool> hierarchical_allgather_;
+  bool hierarchical_alltoall_ = false;
   CategoricalParameter<bool> cache_enabled_;
+  CategoricalParameter<int> num_nccl_streams_;
+  CategoricalParameter<bool> batch_d2d_memcopies_;
+  CategoricalParameter<int64_t> adasum_mpi_chunk_size_;
+  CategoricalParameter<int64_t> gloo_bcube_threshold_;
+  CategoricalParameter<int64_t> gloo_halving_doubling_threshold_;
   BayesianParameter joint_params_;
+  CategoricalParameter<int64_t> large_tensor_fusion_threshold_;
 
   std::vector<ITunableParameter*> parameter_chain_;
   bool active_;
@@ -243,6 +334,12 @@ private:
   int32_t root_rank_;
   std::ofstream file_;
   bool writing_;
+
+  std::string cache_file_;
+  std::string topology_;
+  std::string fingerprint_;
+  bool cache_checked_;
+  std::set<std::string> observed_tensors_;
 };
 
 } // namespace common
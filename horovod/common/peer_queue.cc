@@ -0,0 +1,55 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "peer_queue.h"
+
+#include <set>
+#include <utility>
+
+namespace horovod {
+namespace common {
+
+void PeerQueue::Add(PeerOperation&& operation) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  queue_.push_back(std::move(operation));
+}
+
+void PeerQueue::PopReady(std::vector<PeerOperation>& ready) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::set<std::pair<int, bool>> blocked;
+  for (auto it = queue_.begin(); it != queue_.end();) {
+    auto key = std::make_pair(it->entry.root_rank, it->send);
+    if (blocked.count(key) > 0 || !it->entry.ready_event_list.Ready()) {
+      blocked.insert(key);
+      ++it;
+      continue;
+    }
+    ready.push_back(std::move(*it));
+    it = queue_.erase(it);
+  }
+}
+
+std::vector<PeerOperation> PeerQueue::TakeAll() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::vector<PeerOperation> operations;
+  for (auto& operation : queue_) {
+    operations.push_back(std::move(operation));
+  }
+  queue_.clear();
+  return operations;
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,59 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_PEER_QUEUE_H
+#define HOROVOD_PEER_QUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "common.h"
+
+namespace horovod {
+namespace common {
+
+// A send to or receive from one other rank of the global process set.
+struct PeerOperation {
+  // The tensor to send, or the output to receive into. root_rank holds the
+  // global rank of the peer.
+  TensorTableEntry entry;
+  bool send = true;
+};
+
+// Sends and receives enqueued by framework threads. They bypass the
+// coordinator: the operations between two ranks are matched in the order both
+// of them enqueue them.
+class PeerQueue {
+public:
+  void Add(PeerOperation&& operation);
+
+  // Moves the operations whose ready events have completed to ready. An
+  // operation waits for the earlier ones in the same direction with the same
+  // peer, so that they are posted in the order they were enqueued.
+  void PopReady(std::vector<PeerOperation>& ready);
+
+  // Removes and returns all queued operations.
+  std::vector<PeerOperation> TakeAll();
+
+private:
+  std::mutex mutex_;
+  std::deque<PeerOperation> queue_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_PEER_QUEUE_H
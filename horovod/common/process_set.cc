@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <array>
 #include <utility>
 
 #if HAVE_GLOO
@@ -32,6 +33,151 @@ std::string RanksString(const std::vector<int>& ranks) {
   return oss_ranks.str();
 }
 
+#if HAVE_MPI
+// Initializes the controller of a process set whose communicators are set up.
+void CompleteMPIInitialization(ProcessSet& process_set, int global_size) {
+  if (process_set.mpi_context.GetMPICommunicator(Communicator::GLOBAL) !=
+      MPI_COMM_NULL) {
+    // The running process is part of this process set.
+    process_set.controller->Initialize();
+  }
+  auto& ranks = process_set.registered_global_ranks;
+  if (ranks.empty()) {
+    ranks.resize(global_size);
+    std::iota(ranks.begin(), ranks.end(), 0);
+  }
+  process_set.initialization_done = true;
+}
+
+// Whether every process passed the same values. Reduces the values and their
+// negations with one MPI_MAX, which yields both their maximum and minimum.
+bool AgreeOnAllRanks(const std::vector<int>& values, MPI_Comm comm) {
+  auto n = values.size();
+  std::vector<int> buf(2 * n);
+  for (size_t i = 0; i < n; ++i) {
+    buf[i] = values[i];
+    buf[n + i] = -values[i];
+  }
+  MPI_Allreduce(MPI_IN_PLACE, buf.data(), (int)buf.size(), MPI_INT, MPI_MAX,
+                comm);
+  for (size_t i = 0; i < n; ++i) {
+    if (buf[i] != values[i] || -buf[n + i] != values[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Includes(const ProcessSet& process_set, int rank) {
+  auto& ranks = process_set.registered_global_ranks;
+  return ranks.empty() ||
+         std::find(ranks.begin(), ranks.end(), rank) != ranks.end();
+}
+
+// Initializes process sets registered but not initialized yet, all in one
+// round: their ranks are verified together, the duplicates of the global
+// communicator are made at once, and the communicators of process sets no
+// process belongs to two of are split off the global communicator together.
+// Hybrid parallel jobs, whose groups of each kind partition the ranks, need
+// one split per kind of group.
+int32_t InitializeProcessSets(const std::vector<ProcessSet*>& process_sets,
+                              const MPIContext& global_mpi_context) {
+  MPI_Comm comm = global_mpi_context.global_comm;
+  int size;
+  int rank;
+  MPI_Comm_size(comm, &size);
+  MPI_Comm_rank(comm, &rank);
+  auto n = process_sets.size();
+
+  // Verify that each process has registered the same sets of processes.
+  std::vector<int> lengths;
+  std::vector<int> all_ranks;
+  for (auto* process_set : process_sets) {
+    auto& ranks = process_set->registered_global_ranks;
+    assert((int)ranks.size() <= size);
+    lengths.push_back((int)ranks.size());
+    all_ranks.insert(all_ranks.end(), ranks.begin(), ranks.end());
+  }
+  if (!AgreeOnAllRanks(lengths, comm)) {
+    throw std::logic_error("Attempted to register process set with "
+                           "mismatching size on different ranks");
+  }
+  if (!AgreeOnAllRanks(all_ranks, comm)) {
+    throw std::logic_error("Attempted to register process set with "
+                           "mismatching values on different ranks");
+  }
+
+  std::vector<MPI_Comm> global_comms(n, MPI_COMM_NULL);
+  std::vector<MPI_Request> requests(n);
+  for (size_t i = 0; i < n; ++i) {
+    MPI_Comm_idup(comm, &global_comms[i], &requests[i]);
+  }
+  MPI_Waitall((int)n, requests.data(), MPI_STATUSES_IGNORE);
+
+  // Assign the process sets to rounds in which no process belongs to two of
+  // them, first fit in registration order, so the same on every process.
+  std::vector<std::vector<size_t>> rounds;
+  std::vector<std::vector<bool>> round_members;
+  for (size_t i = 0; i < n; ++i) {
+    size_t r = 0;
+    for (; r < rounds.size(); ++r) {
+      bool disjoint = true;
+      for (int other = 0; other < size && disjoint; ++other) {
+        disjoint = !(round_members[r][other] && Includes(*process_sets[i], other));
+      }
+      if (disjoint) {
+        break;
+      }
+    }
+    if (r == rounds.size()) {
+      rounds.emplace_back();
+      round_members.emplace_back(size, false);
+    }
+    rounds[r].push_back(i);
+    for (int other = 0; other < size; ++other) {
+      if (Includes(*process_sets[i], other)) {
+        round_members[r][other] = true;
+      }
+    }
+  }
+
+  std::vector<MPI_Comm> process_set_comms(n, MPI_COMM_NULL);
+  for (auto& round : rounds) {
+    int color = MPI_UNDEFINED;
+    for (auto i : round) {
+      if (Includes(*process_sets[i], rank)) {
+        color = (int)i;
+      }
+    }
+    // Ordered by global rank, as registered_global_ranks is.
+    MPI_Comm split;
+    MPI_Comm_split(comm, color, rank, &split);
+    if (color != MPI_UNDEFINED) {
+      process_set_comms[color] = split;
+    }
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    process_sets[i]->InitializeWithComms(global_mpi_context, global_comms[i],
+                                         process_set_comms[i]);
+  }
+  return (int32_t)n;
+}
+#endif // HAVE_MPI
+
+#if HAVE_GLOO
+int32_t InitializeProcessSets(const std::vector<ProcessSet*>& process_sets,
+                              const GlooContext& global_gloo_context) {
+  int32_t initialized_count = 0;
+  for (auto* process_set : process_sets) {
+    if (process_set->Initialize(global_gloo_context)) {
+      ++initialized_count;
+    }
+  }
+  return initialized_count;
+}
+#endif // HAVE_GLOO
+
 } // namespace
 
 #if HAVE_MPI
@@ -69,17 +215,23 @@ bool ProcessSet::Initialize(const MPIContext& global_mpi_context) {
   }
   mpi_context.InitializeForProcessSet(global_mpi_context,
                                       registered_global_ranks);
-  if (mpi_context.GetMPICommunicator(Communicator::GLOBAL) != MPI_COMM_NULL) {
-    // The running process is part of this process set.
-    controller->Initialize();
-  }
-  if (registered_global_ranks.empty()) {
-    registered_global_ranks.resize(size);
-    std::iota(registered_global_ranks.begin(), registered_global_ranks.end(), 0);
-  }
-  initialization_done = true;
+  CompleteMPIInitialization(*this, size);
   return true;
 }
+
+void ProcessSet::InitializeWithComms(const MPIContext& global_mpi_context,
+                                     MPI_Comm global_comm_dup,
+                                     MPI_Comm process_set_comm) {
+  LOG(TRACE) << "Initializing new process set with MPI: "
+             << RanksString(registered_global_ranks);
+  assert(controller != nullptr);
+  int size;
+  MPI_Comm_size(global_comm_dup, &size);
+  mpi_context.InitializeForProcessSet(global_mpi_context,
+                                      registered_global_ranks, global_comm_dup,
+                                      process_set_comm);
+  CompleteMPIInitialization(*this, size);
+}
 #endif // HAVE_MPI
 
 #if HAVE_GLOO
@@ -205,10 +357,17 @@ int32_t ProcessSetTable::InitializeRegisteredAndRemoveMarkedIfReady_(
   // 1) Initialize registered process sets if all processes are ready to do so:
   int32_t initialized_count = 0;
   if (registered_count_agreement) {
+    std::vector<int32_t> pending_ids;
+    std::vector<ProcessSet*> pending;
     for (auto id : Ids()) {
-      bool newly_registered = Get(id).Initialize(global_context);
-      if (newly_registered) {
-        ++initialized_count;
+      if (!Get(id).initialization_done) {
+        pending_ids.push_back(id);
+        pending.push_back(&Get(id));
+      }
+    }
+    if (!pending.empty()) {
+      initialized_count = InitializeProcessSets(pending, global_context);
+      for (auto id : pending_ids) {
         LOG(TRACE, global_controller.GetRank())
             << "Initialized process set with id " << id;
       }
@@ -230,6 +389,10 @@ int32_t ProcessSetTable::InitializeRegisteredAndRemoveMarkedIfReady_(
     }
   }
 
+  if (initialized_count > 0 || id_to_be_removed_ == SUCCESSFUL_REMOVAL) {
+    changed_.notify_all();
+  }
+
   // Return count from 1)
   return initialized_count;
 }
@@ -337,6 +500,7 @@ int32_t ProcessSetTable::RegisterProcessSet(std::vector<int> global_ranks) {
                              std::forward_as_tuple(id),
                              std::forward_as_tuple(global_ranks));
   ids_.push_back(id);
+  id_to_process_set_.at(id).tensor_queue.SetWakeupSignal(wakeup_signal_);
 
   return id;
 }
@@ -389,6 +553,20 @@ void ProcessSetTable::MarkProcessSetForRemoval(int32_t process_set_id) {
   id_to_be_removed_ = process_set_id;
 }
 
+void ProcessSetTable::WaitUntil(const std::function<bool()>& done) {
+  std::unique_lock<std::recursive_mutex> lock(mutex);
+  changed_.wait(lock, done);
+}
+
+void ProcessSetTable::NotifyWaiters() {
+  {
+    // Waiters evaluate their condition with the table locked, so that it
+    // cannot change in between and the notification not be missed.
+    std::lock_guard<std::recursive_mutex> guard(mutex);
+  }
+  changed_.notify_all();
+}
+
 bool ProcessSetTable::ProcessSetHasJustBeenRemoved() {
   std::lock_guard<std::recursive_mutex> guard(mutex);
   if (id_to_be_removed_ == SUCCESSFUL_REMOVAL) {
@@ -398,5 +576,13 @@ bool ProcessSetTable::ProcessSetHasJustBeenRemoved() {
   return false;
 }
 
+void ProcessSetTable::SetWakeupSignal(WakeupSignal* wakeup_signal) {
+  std::lock_guard<std::recursive_mutex> guard(mutex);
+  wakeup_signal_ = wakeup_signal;
+  for (auto& id_process_set : id_to_process_set_) {
+    id_process_set.second.tensor_queue.SetWakeupSignal(wakeup_signal);
+  }
+}
+
 } // common
 } // horovod
@@ -2,10 +2,15 @@
 #define HOROVOD_PROCESS_SET_H
 
 #include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <list>
+#include <memory>
 #include <queue>
 #include <unordered_map>
 
+#include "fusion_buffer_manager.h"
+#include "parameter_manager.h"
 #include "response_cache.h"
 #include "tensor_queue.h"
 
@@ -34,6 +39,15 @@ struct ProcessSet {
   // Information on registered groups.
   GroupTable group_table;
 
+  // Fusion buffers of this process set, so that process sets running their
+  // operations concurrently never share one.
+  FusionBufferManager fusion_buffer;
+
+  // Fusion threshold and hierarchical flags of this process set, tuned on its
+  // own traffic. Null for the global process set, which uses the
+  // ParameterManager of the global state.
+  std::unique_ptr<ParameterManager> parameter_manager;
+
   // If this is empty before initialization, all Horovod
   // processes will belong to this set. After initialization this always
   // enumerates all ranks belonging to the proces set.
@@ -53,6 +67,15 @@ struct ProcessSet {
   // Current shared buffer size
   int64_t shared_buffer_size = 0;
 
+  // Shared memory segment of the node for shared memory allreduce, with one
+  // slot of shm_allreduce_slot_size bytes per local rank.
+  void* shm_allreduce_buffer = nullptr;
+  int64_t shm_allreduce_slot_size = 0;
+
+  // Decayed number of bytes recently placed on each GPU stream, used when
+  // balancing responses across streams.
+  std::vector<int64_t> gpu_stream_load;
+
 #if HAVE_MPI
   MPIContext mpi_context;
 
@@ -60,6 +83,13 @@ struct ProcessSet {
   // Returns true if it newly initializes the process set, false if it was
   // already intialized before.
   bool Initialize(const MPIContext& global_mpi_context);
+
+  // As Initialize, for a process set whose registered ranks have been
+  // verified and whose communicators have been created by the caller, see
+  // MPIContext::InitializeForProcessSet.
+  void InitializeWithComms(const MPIContext& global_mpi_context,
+                           MPI_Comm global_comm_dup,
+                           MPI_Comm process_set_comm);
 #endif // HAVE_MPI
 
 #if HAVE_GLOO
@@ -98,7 +128,7 @@ public:
 #endif
 
   // To be called in the background thread: 1) Initialize any process sets
-  // that have been registered by all processes.
+  // that have been registered by all processes, together in one round.
   // 2) Deregister a process set (just one) that has been marked for removal by
   // all processes.
   // Returns the number of newly initialized process sets (may be zero) from 1).
@@ -136,6 +166,19 @@ public:
 
   bool ProcessSetHasJustBeenRemoved();
 
+  // Tensor queues of all current and future process sets will notify this
+  // signal when new tensors are enqueued.
+  void SetWakeupSignal(WakeupSignal* wakeup_signal);
+
+  // Blocks until done() returns true. It is evaluated with the table locked,
+  // whenever process sets have been initialized or removed and whenever
+  // NotifyWaiters() is called.
+  void WaitUntil(const std::function<bool()>& done);
+
+  // Wakes up WaitUntil() callers to evaluate their condition, e.g. once
+  // Horovod shuts down.
+  void NotifyWaiters();
+
   // Guard access to the table by this mutex
   mutable std::recursive_mutex mutex;
 
@@ -165,6 +208,10 @@ private:
   static constexpr int32_t NO_PENDING_REMOVAL = -1;
   static constexpr int32_t SUCCESSFUL_REMOVAL = -2;
   int32_t id_to_be_removed_ = NO_PENDING_REMOVAL;
+
+  WakeupSignal* wakeup_signal_ = nullptr;
+
+  std::condition_variable_any changed_;
 };
 
 } // namespace common
@@ -142,6 +142,30 @@ def add_process_set(process_set: Union[ProcessSet, Sequence[int]]) -> ProcessSet
     return process_set
 
 
+def add_process_sets(process_sets: Sequence[Union[ProcessSet, Sequence[int]]]) -> List[ProcessSet]:
+    """ Add several new process_sets after Horovod initialization and return them.
+
+    Unlike repeated calls of `add_process_set`, all of them are initialized together, e.g. the tensor, pipeline and data
+    parallel groups of a hybrid parallel job. Requires running with HOROVOD_DYNAMIC_PROCESS_SETS=1. No two of them, and
+    no process set added before, may contain the same ranks. The returned process sets will be fully initialized.
+    """
+    assert _basics is not None
+    process_sets = [ps if isinstance(ps, ProcessSet) else ProcessSet(ps) for ps in process_sets]
+    for process_set in process_sets:
+        if process_set.ranks is None and process_set.mpi_comm is not None:
+            raise NotImplementedError(
+                "Dynamically adding process sets defined by an MPI communicator is not implemented. "
+                "Please build the process set via a list of ranks.")
+        assert process_set.ranks is not None
+
+    process_set_ids = _basics._add_process_sets_impl([ps.ranks for ps in process_sets])
+    if process_set_ids is None:
+        raise ValueError(f"Attempted to add a duplicate process set: {process_sets}")
+    for process_set, process_set_id in zip(process_sets, process_set_ids):
+        process_set.process_set_id = process_set_id
+    return process_sets
+
+
 def remove_process_set(process_set: ProcessSet) -> bool:
     """ Attempt to remove process set and return whether this attempt is successful.
 
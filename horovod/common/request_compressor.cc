@@ -0,0 +1,93 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "request_compressor.h"
+
+#include <stdexcept>
+
+namespace horovod {
+namespace common {
+
+void RequestCompressor::Reset(int size) {
+  sent_.clear();
+  received_.clear();
+  received_.resize(size);
+}
+
+void RequestCompressor::Compress(RequestList& request_list) {
+  for (auto& request : request_list.mutable_requests()) {
+    if (request.request_type() == Request::JOIN ||
+        request.tensor_name().empty()) {
+      continue;
+    }
+
+    auto it = sent_.find(request.tensor_name());
+    if (it == sent_.end()) {
+      // First request for this tensor, sent in full along with its new ID.
+      if (sent_.size() < MAX_NAME_IDS) {
+        auto name_id = (int32_t)sent_.size();
+        sent_.emplace(request.tensor_name(),
+                      TensorState{name_id, request.tensor_shape()});
+        request.set_name_id(name_id);
+      }
+      continue;
+    }
+
+    auto& state = it->second;
+    request.set_name_id(state.name_id);
+    request.set_tensor_name(std::string());
+    if (request.tensor_shape() == state.shape) {
+      request.set_shape_unchanged(true);
+    } else {
+      state.shape = request.tensor_shape();
+    }
+  }
+}
+
+void RequestCompressor::Decompress(int rank, RequestList& request_list) {
+  auto& known = received_[rank];
+  for (auto& request : request_list.mutable_requests()) {
+    auto name_id = request.name_id();
+    if (name_id == NULL_NAME_ID) {
+      continue;
+    }
+
+    if (!request.tensor_name().empty()) {
+      // First request for this tensor, remember it under its ID.
+      if ((size_t)name_id >= known.size()) {
+        known.resize(name_id + 1);
+      }
+      known[name_id] = KnownTensor{request.tensor_name(),
+                                   request.tensor_shape()};
+      continue;
+    }
+
+    if ((size_t)name_id >= known.size() || known[name_id].name.empty()) {
+      throw std::logic_error("Received request for unknown tensor ID " +
+                             std::to_string(name_id) + " from rank " +
+                             std::to_string(rank) + ".");
+    }
+    auto& tensor = known[name_id];
+    request.set_tensor_name(tensor.name);
+    if (request.shape_unchanged()) {
+      request.set_tensor_shape(tensor.shape);
+    } else {
+      tensor.shape = request.tensor_shape();
+    }
+  }
+}
+
+} // namespace common
+} // namespace horovod
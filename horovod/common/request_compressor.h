@@ -0,0 +1,74 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_REQUEST_COMPRESSOR_H
+#define HOROVOD_REQUEST_COMPRESSOR_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "message.h"
+
+namespace horovod {
+namespace common {
+
+// Shrinks the request lists that workers send to the coordinator when only a
+// few tensors miss the response cache, e.g. tensors with a dynamic shape.
+//
+// A worker sends the full name of a tensor only with its first request and
+// assigns it an ID in order of first appearance. The coordinator assigns the
+// same IDs while decoding the requests of that worker, so no acknowledgement
+// is needed. Later requests carry the ID instead of the name, and leave out
+// the shape when it equals the shape of the last request for the tensor.
+class RequestCompressor {
+public:
+  // Forgets all IDs. Must be called on all ranks of a controller together,
+  // before their first negotiation.
+  void Reset(int size);
+
+  // Worker side, before the requests are sent to the coordinator.
+  void Compress(RequestList& request_list);
+
+  // Coordinator side, restores the requests that the rank compressed.
+  void Decompress(int rank, RequestList& request_list);
+
+private:
+  struct TensorState {
+    int32_t name_id;
+    std::vector<int64_t> shape;
+  };
+
+  struct KnownTensor {
+    std::string name;
+    std::vector<int64_t> shape;
+  };
+
+  // Bounds the memory of long jobs with ever new tensor names. Requests of
+  // names beyond the limit are sent in full.
+  static constexpr size_t MAX_NAME_IDS = 1 << 16;
+
+  // Tensors sent by this worker.
+  std::unordered_map<std::string, TensorState> sent_;
+
+  // Tensors received by the coordinator, indexed by rank and ID.
+  std::vector<std::vector<KnownTensor>> received_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_REQUEST_COMPRESSOR_H
@@ -15,6 +15,7 @@
 
 #include "response_cache.h"
 
+#include <algorithm>
 #include <climits>
 #include <cstring>
 
@@ -39,6 +40,12 @@ static Response::ResponseType RequestTypeToResponseType(Request::RequestType val
       return Response::ResponseType::ADASUM;
     case Request::RequestType::ALLTOALL:
       return Response::ResponseType::ALLTOALL;
+    case Request::RequestType::REDUCESCATTER:
+      return Response::ResponseType::REDUCESCATTER;
+    case Request::RequestType::REDUCE:
+      return Response::ResponseType::REDUCE;
+    case Request::RequestType::GATHER:
+      return Response::ResponseType::GATHER;
     default:
       throw std::logic_error("No corresponding ResponseType for provided RequestType.");
   }
@@ -46,39 +53,116 @@ static Response::ResponseType RequestTypeToResponseType(Request::RequestType val
 
 void ResponseCache::clear() {
   bits_outdated_ = false;
+  for (auto& entry : cache_) {
+    release_tensor_id_(entry.second);
+  }
   cache_.clear();
   cache_iters_.clear();
+  free_bits_.clear();
   tensor_name_to_bit_.clear();
+  tensor_id_to_bit_.clear();
 }
 
 void ResponseCache::set_capacity(uint32_t capacity) {
   // Clear cache in case set_capacity is called multiple times if autotuning.
-  // Only clear if capacity is modified.
-  if (capacity != capacity_) {
+  // Only clear if capacity is modified, growth does not count.
+  if (capacity != base_capacity_) {
     this->clear();
+    capacity_ = capacity;
   }
 
-  capacity_ = capacity;
-  cache_iters_.reserve(capacity);
+  base_capacity_ = capacity;
+  cache_iters_.reserve(capacity_);
+}
+
+void ResponseCache::set_max_capacity(uint32_t max_capacity) {
+  max_capacity_ = max_capacity;
 }
 
 uint32_t ResponseCache::capacity() const { return capacity_; }
 
 size_t ResponseCache::num_active_bits() const { return cache_iters_.size(); }
 
-ResponseCache::CacheState ResponseCache::cached(const Request& message) const {
+void ResponseCache::set_tensor_name_table(TensorNameTable* tensor_name_table) {
+  this->clear();
+  tensor_name_table_ = tensor_name_table;
+}
+
+bool ResponseCache::find_cache_bit_(const Request& message,
+                                    uint32_t& cache_bit) const {
+  if (tensor_name_table_ != nullptr &&
+      message.tensor_id() != NULL_TENSOR_ID) {
+    // The request holds a reference on its ID through its tensor queue
+    // entry, so the ID cannot have been reassigned to another name.
+    auto tensor_id = (size_t)message.tensor_id();
+    if (tensor_id >= tensor_id_to_bit_.size() ||
+        tensor_id_to_bit_[tensor_id] == NO_CACHE_BIT) {
+      return false;
+    }
+    cache_bit = tensor_id_to_bit_[tensor_id];
+    return true;
+  }
+
   auto it = tensor_name_to_bit_.find(message.tensor_name());
-  if (it != tensor_name_to_bit_.end()) {
+  if (it == tensor_name_to_bit_.end()) {
+    return false;
+  }
+  cache_bit = it->second;
+  return true;
+}
+
+void ResponseCache::set_tensor_id_bit_(int32_t tensor_id,
+                                       uint32_t cache_bit) {
+  if (tensor_id == NULL_TENSOR_ID) {
+    return;
+  }
+  if ((size_t)tensor_id >= tensor_id_to_bit_.size()) {
+    tensor_id_to_bit_.resize(tensor_id + 1, NO_CACHE_BIT);
+  }
+  tensor_id_to_bit_[tensor_id] = cache_bit;
+}
+
+void ResponseCache::release_tensor_id_(TensorParams& params) {
+  if (params.tensor_id == NULL_TENSOR_ID) {
+    return;
+  }
+  set_tensor_id_bit_(params.tensor_id, NO_CACHE_BIT);
+  tensor_name_table_->Release(params.tensor_id);
+  params.tensor_id = NULL_TENSOR_ID;
+}
+
+namespace {
+
+// Allgather responses are reused for any first dimension, which is exchanged
+// separately, so only the trailing dimensions have to match.
+bool SameCachedShape(const std::vector<int64_t>& cached_shape,
+                     const std::vector<int64_t>& shape,
+                     Response::ResponseType response_type) {
+  if (response_type != Response::ALLGATHER) {
+    return cached_shape == shape;
+  }
+  return !shape.empty() && cached_shape.size() == shape.size() &&
+         std::equal(cached_shape.begin() + 1, cached_shape.end(),
+                    shape.begin() + 1);
+}
+
+} // namespace
+
+ResponseCache::CacheState ResponseCache::cached(const Request& message) const {
+  uint32_t cache_bit;
+  if (find_cache_bit_(message, cache_bit)) {
     // If entry associated with this request already exists in cache, check
     // if tensor parameters match. If not, return that entry is invalid.
-    uint32_t cache_bit = it->second;
     auto& cache_response = std::get<0>(*cache_iters_[cache_bit]);
     auto& cache_params = std::get<1>(*cache_iters_[cache_bit]);
     return (cache_params.device == message.device() &&
             cache_params.dtype == message.tensor_type() &&
-            cache_params.shape == message.tensor_shape() &&
+            SameCachedShape(cache_params.shape, message.tensor_shape(),
+                            cache_response.response_type()) &&
             cache_response.prescale_factor() == message.prescale_factor() &&
             cache_response.postscale_factor() == message.postscale_factor() &&
+            cache_response.reduce_op() == message.reduce_op() &&
+            cache_response.root_rank() == message.root_rank() &&
             cache_response.response_type() == RequestTypeToResponseType(message.request_type()))
                ? CacheState::HIT
                : CacheState::INVALID;
@@ -108,13 +192,16 @@ ResponseCache::cached(const Response& response,
       };
       same_shape = (product(cache_params.shape) == product(params.shape));
     } else {
-      same_shape = (cache_params.shape == params.shape);
+      same_shape = SameCachedShape(cache_params.shape, params.shape,
+                                   cache_response.response_type());
     }
 
     return (cache_params.device == params.device &&
             cache_params.dtype == params.dtype && same_shape &&
             cache_response.prescale_factor() == response.prescale_factor() &&
             cache_response.postscale_factor() == response.postscale_factor() &&
+            cache_response.reduce_op() == response.reduce_op() &&
+            cache_response.root_rank() == response.root_rank() &&
             cache_response.response_type() == response.response_type())
                ? CacheState::HIT
                : CacheState::INVALID;
@@ -124,8 +211,6 @@ ResponseCache::cached(const Response& response,
 }
 
 void ResponseCache::put_(const Response& response, TensorParams& params, bool joined) {
-  // Note: This method invalidates all previously returned cache bit positions.
-
   uint32_t cache_bit;
   auto cache_state = this->cached(response, params, joined);
 
@@ -145,13 +230,13 @@ void ResponseCache::put_(const Response& response, TensorParams& params, bool jo
     auto it = cache_iters_[cache_bit];
     cache_.push_front(std::move(*it));
     cache_.erase(it);
-  } else if (cache_.size() == capacity_) {
+  } else if (cache_.size() >= capacity_ && capacity_ >= max_capacity_) {
     if (print_warning_) {
       std::stringstream message;
       message << "A response has been evicted from cache which may indicate "
                  "reduced performance. Better performance may be obtained by "
                  "disabling caching (HOROVOD_CACHE_CAPACITY=0) or increasing "
-                 "the cache capacity (HOROVOD_CACHE_CAPACITY>"
+                 "the cache capacity (HOROVOD_CACHE_MAX_CAPACITY>"
               << std::to_string(capacity_) << ").";
       LOG(WARNING) << message.str();
       print_warning_ = false;
@@ -163,29 +248,69 @@ void ResponseCache::put_(const Response& response, TensorParams& params, bool jo
     auto& entry = cache_.back().first;
     cache_bit = tensor_name_to_bit_[entry.tensor_names()[0]];
     tensor_name_to_bit_.erase(entry.tensor_names()[0]);
+    release_tensor_id_(cache_.back().second);
     cache_.pop_back();
+    if (tensor_name_table_ != nullptr) {
+      params.tensor_id =
+          tensor_name_table_->Acquire(response.tensor_names()[0]);
+    }
     cache_.push_front(std::make_pair(response, std::move(params)));
   } else {
+    if (cache_.size() >= capacity_) {
+      capacity_ = std::min(2 * capacity_, max_capacity_);
+      cache_iters_.reserve(capacity_);
+      LOG(DEBUG) << "Response cache is full, growing its capacity to "
+                 << capacity_ << ".";
+    }
+
     // New entry added to front of cache_. Entry is associated with
-    // the next available position in cache_iters_ vector.
-    cache_bit = cache_iters_.size();
-    cache_iters_.resize(cache_bit + 1);
+    // the lowest freed bit, or the next position in cache_iters_ vector.
+    if (!free_bits_.empty()) {
+      cache_bit = *free_bits_.begin();
+      free_bits_.erase(free_bits_.begin());
+    } else {
+      cache_bit = cache_iters_.size();
+      cache_iters_.resize(cache_bit + 1);
+    }
+    if (tensor_name_table_ != nullptr) {
+      params.tensor_id =
+          tensor_name_table_->Acquire(response.tensor_names()[0]);
+    }
     cache_.push_front(std::make_pair(response, std::move(params)));
   }
 
   cache_iters_[cache_bit] = cache_.begin();
   tensor_name_to_bit_[response.tensor_names()[0]] = cache_bit;
+  set_tensor_id_bit_(cache_.front().second.tensor_id, cache_bit);
 
 }
 
 void ResponseCache::put(const Response& response, TensorQueue& tensor_queue, bool joined) {
-  // Note: This method invalidates all previously returned cache bit positions
-  // if evictions occur.
-
   if (capacity_ == 0) {
     return;
   }
 
+  if (response.num_partitions() > 1) {
+    // Cache the whole tensor with its first part, so that the cached
+    // response is partitioned again when it is reused.
+    if (joined || response.partition_offset() > 0) {
+      return;
+    }
+    const auto& tensor_entry =
+        tensor_queue.GetTensorEntry(response.tensor_names()[0]);
+    Response whole_response = response;
+    whole_response.set_tensor_sizes(
+        {tensor_entry.tensor->shape().num_elements()});
+    whole_response.set_num_partitions(1);
+
+    TensorParams params;
+    params.device = tensor_entry.device;
+    params.dtype = tensor_entry.tensor->dtype();
+    params.shape = tensor_entry.tensor->shape().to_vector();
+    this->put_(whole_response, params, joined);
+    return;
+  }
+
   std::vector<TensorTableEntry> entries_for_join;
   if (joined) {
     tensor_queue.GetTensorEntriesFromResponse(response, entries_for_join,
@@ -209,6 +334,9 @@ void ResponseCache::put(const Response& response, TensorQueue& tensor_queue, boo
       new_response.set_tensor_type(response.tensor_type());
       new_response.set_prescale_factor(response.prescale_factor());
       new_response.set_postscale_factor(response.postscale_factor());
+      new_response.set_reduce_op(response.reduce_op());
+      new_response.set_root_rank(response.root_rank());
+      new_response.set_priority(response.priority());
 
       // Populate tensor parameters from tensor_queue entry
       TensorParams params;
@@ -255,7 +383,9 @@ const Response& ResponseCache::peek_response(uint32_t cache_bit) const {
 
 uint32_t ResponseCache::peek_cache_bit(const Request& message) const {
   assert(this->cached(message));
-  return tensor_name_to_bit_.at(message.tensor_name());
+  uint32_t cache_bit = 0;
+  find_cache_bit_(message, cache_bit);
+  return cache_bit;
 }
 
 uint32_t ResponseCache::peek_cache_bit(const std::string& tensor_name) const {
@@ -274,44 +404,39 @@ void ResponseCache::erase_response(uint32_t cache_bit) {
   assert(cache_bit < cache_iters_.size());
 
   // Erase entry from iterator at cache_bit position and set
-  // iterator at cache_bit position to a null value.
-  // We do not resize/compact cache_iters_ vector here to preserve
-  // cache bit positions of existing entries. cache_iters_ is resized
-  // and cache bit posiions are reset *only* when update_cache_bits
-  // function is called.
+  // iterator at cache_bit position to a null value. The bit is reused by
+  // the next new entry, the bits of other entries never change.
   auto it = cache_iters_[cache_bit];
   tensor_name_to_bit_.erase(it->first.tensor_names()[0]);
+  release_tensor_id_(it->second);
   cache_.erase(it);
 
   cache_iters_[cache_bit] = cache_.end();
+  free_bits_.insert(cache_bit);
 
-  // Set flag to trigger update_cache_bits to remove empty
-  // positions in cache_iters_ vector
+  // Set flag to trigger update_cache_bits to drop freed bits at the end
+  // of cache_iters_ vector
   bits_outdated_ = true;
 }
 
-void ResponseCache::update_cache_bits() {
-  // Note: This method invalidates all previously returned cache bit positions.
+void ResponseCache::set_tensor_sizes(uint32_t cache_bit,
+                                     const std::vector<int64_t>& tensor_sizes) {
+  assert(cache_bit < cache_iters_.size());
+  std::get<0>(*cache_iters_[cache_bit]).set_tensor_sizes(tensor_sizes);
+}
 
+void ResponseCache::update_cache_bits() {
   if (!bits_outdated_) {
     return;
   }
 
-  // Iterate over current cache_ list and reassign cache bits by current
-  // position. This is done by updating iterators in cache_iters_ vector
-  // and tensor name to cache bit pairings in tensor_name_to_bit_ map.
-  // Cache bits are assigned to least recently used get lower indices.
-  auto it = --cache_.end();
-  for (int i = 0; i < (int)cache_.size(); ++i) {
-    cache_iters_[i] = it;
-    tensor_name_to_bit_[it->first.tensor_names()[0]] = i;
-    --it;
+  // Bits of live entries are kept, only trailing freed bits are released.
+  while (!free_bits_.empty() &&
+         *free_bits_.rbegin() + 1 == cache_iters_.size()) {
+    free_bits_.erase(std::prev(free_bits_.end()));
+    cache_iters_.pop_back();
   }
 
-  // Erased entries may result in unused positions in cache_iters_ vector.
-  // Resize to contain only valid bit positions.
-  cache_iters_.resize(cache_.size());
-
   bits_outdated_ = false;
 }
 
@@ -345,6 +470,11 @@ void CacheCoordinator::set_uncached_in_queue(bool uncached_in_queue) {
   uncached_in_queue_ = uncached_in_queue;
 }
 
+void CacheCoordinator::set_expected_hits(size_t expected_hits) {
+  assert(!synced_);
+  expected_hits_ = expected_hits;
+}
+
 const std::set<uint32_t>& CacheCoordinator::cache_hits() const {
   assert(synced_);
   return cache_hits_;
@@ -419,8 +549,15 @@ void CacheCoordinator::sync(std::shared_ptr<Controller> controller,
     }
   }
 
-  // Global AND operation to get intersected bit array.
-  controller->CrossRankBitwiseAnd(bitvector_, fullcount);
+  // Global AND operation to get intersected bit array. Large caches with few
+  // expected hits only exchange words that can hold common hits. The choice
+  // depends on state that is identical on all workers.
+  if (!timeline_enabled && count >= COMPACT_SYNC_MIN_WORDS &&
+      expected_hits_ * 8 < (size_t)nbits) {
+    compact_bitwise_and_(*controller, count);
+  } else {
+    controller->CrossRankBitwiseAnd(bitvector_, fullcount);
+  }
 
   // Search for flipped bits to populate common cache hit set. There will never
   // be invalid bits in this set.
@@ -497,5 +634,108 @@ void CacheCoordinator::sync(std::shared_ptr<Controller> controller,
   synced_ = true;
 }
 
+void CacheCoordinator::compact_bitwise_and_(Controller& controller,
+                                            int count) {
+  const int word_bits = sizeof(long long) * CHAR_BIT;
+
+  // Summary of non-zero words. The first word holds the status bits, which
+  // are always exchanged.
+  int summary_count = (count + word_bits - 1) / word_bits;
+  std::vector<long long> summary(summary_count, 0);
+  for (int i = 0; i < count; ++i) {
+    if (i == 0 || bitvector_[i] != 0) {
+      summary[i / word_bits] |= (1ull << (i % word_bits));
+    }
+  }
+  controller.CrossRankBitwiseAnd(summary, summary_count);
+
+  // Exchange the words that are non-zero on every worker.
+  std::vector<int> word_index;
+  std::vector<long long> words;
+  for (int i = 0; i < count; ++i) {
+    if (summary[i / word_bits] & (1ull << (i % word_bits))) {
+      word_index.push_back(i);
+      words.push_back(bitvector_[i]);
+    }
+  }
+  controller.CrossRankBitwiseAnd(words, (int)words.size());
+
+  std::memset(&bitvector_[0], 0, count * sizeof(long long));
+  for (size_t j = 0; j < word_index.size(); ++j) {
+    bitvector_[word_index[j]] = words[j];
+  }
+}
+
+void FrozenSchedule::observe(const std::set<uint32_t>& cache_hits,
+                             int freeze_after_steps) {
+  bool step_done = false;
+  for (auto bit : cache_hits) {
+    if (current_step_bits_.find(bit) != current_step_bits_.end()) {
+      step_done = true;
+      break;
+    }
+  }
+
+  if (step_done) {
+    if (current_step_ == last_step_) {
+      ++repeats_;
+    } else {
+      last_step_ = std::move(current_step_);
+      repeats_ = 1;
+    }
+    current_step_.clear();
+    current_step_bits_.clear();
+
+    // The batch that started this step has already been executed, so replay
+    // continues from the second batch.
+    if (repeats_ >= freeze_after_steps && cache_hits == last_step_[0]) {
+      frozen_ = true;
+      position_ = 1 % last_step_.size();
+      mismatch_ = false;
+      schedule_bits_.clear();
+      for (auto& batch : last_step_) {
+        schedule_bits_.insert(batch.begin(), batch.end());
+      }
+      return;
+    }
+  }
+
+  current_step_.push_back(cache_hits);
+  current_step_bits_.insert(cache_hits.begin(), cache_hits.end());
+}
+
+void FrozenSchedule::reset() {
+  current_step_.clear();
+  current_step_bits_.clear();
+  last_step_.clear();
+  repeats_ = 0;
+  frozen_ = false;
+  position_ = 0;
+  schedule_bits_.clear();
+  mismatch_ = false;
+}
+
+bool FrozenSchedule::frozen() const { return frozen_; }
+
+const std::set<uint32_t>& FrozenSchedule::next_batch() const {
+  assert(frozen_);
+  return last_step_[position_];
+}
+
+bool FrozenSchedule::at_step_boundary() const { return position_ == 0; }
+
+bool FrozenSchedule::contains(uint32_t bit) const {
+  return schedule_bits_.find(bit) != schedule_bits_.end();
+}
+
+void FrozenSchedule::advance() {
+  assert(frozen_);
+  position_ = (position_ + 1) % last_step_.size();
+}
+
+void FrozenSchedule::set_mismatch() { mismatch_ = true; }
+
+bool FrozenSchedule::mismatch() const { return mismatch_; }
+
 } // namespace common
 } // namespace horovod
@@ -17,6 +17,7 @@
 #define HOROVOD_RESPONSE_CACHE_H
 
 #include <cassert>
+#include <cstdint>
 #include <list>
 #include <set>
 #include <unordered_map>
@@ -28,6 +29,10 @@
 
 #define NUM_STATUS_BITS 3
 
+// Bit vectors of at least this many words are synced in compact form when
+// few cache hits are expected.
+#define COMPACT_SYNC_MIN_WORDS 32
+
 namespace horovod {
 namespace common {
 
@@ -39,9 +44,15 @@ struct TensorParams {
   DataType dtype;
   std::vector<int64_t> shape;
   int32_t device;
+  // Reference held by the cache on the ID of the tensor name.
+  int32_t tensor_id = NULL_TENSOR_ID;
 };
 
 // LRU cache of Responses
+//
+// Every entry keeps its cache bit until it is erased or evicted, and freed
+// bits are reused lowest first. All workers put and erase the same responses
+// in the same order, so they assign the same bits without coordination.
 class ResponseCache {
 public:
   ResponseCache() = default;
@@ -53,8 +64,18 @@ public:
 
   void set_capacity(uint32_t capacity);
 
+  // Instead of evicting, a full cache doubles its capacity up to this limit.
+  // Growth is triggered by the same put on every worker, so their caches stay
+  // consistent without a resync.
+  void set_max_capacity(uint32_t max_capacity);
+
+  // Current capacity, which may have grown past the configured one.
   uint32_t capacity() const;
 
+  // Lets requests carrying a tensor ID be looked up without hashing their
+  // name. The cache holds a reference on the IDs of the cached names.
+  void set_tensor_name_table(TensorNameTable* tensor_name_table);
+
   size_t num_active_bits() const;
 
   CacheState cached(const Request& message) const;
@@ -77,25 +98,55 @@ public:
 
   void erase_response(uint32_t cache_bit);
 
+  // Replaces the tensor sizes of a cached response, e.g. the first
+  // dimensions of an allgather that changed since it was cached.
+  void set_tensor_sizes(uint32_t cache_bit,
+                        const std::vector<int64_t>& tensor_sizes);
+
+  // Drops freed bits at the end of the bit range, so that the bit vectors
+  // exchanged by CacheCoordinator do not stay larger than needed.
   void update_cache_bits();
 
 private:
   void put_(const Response& response, TensorParams& params,
             bool joined = false);
 
+  // Returns false if no cache bit is assigned to the request's tensor.
+  bool find_cache_bit_(const Request& message, uint32_t& cache_bit) const;
+
+  void set_tensor_id_bit_(int32_t tensor_id, uint32_t cache_bit);
+
+  void release_tensor_id_(TensorParams& params);
+
   uint32_t capacity_ = 0;
 
+  // Capacity set through set_capacity(), before any growth.
+  uint32_t base_capacity_ = 0;
+
+  uint32_t max_capacity_ = 0;
+
   // List containing cached entries. Each entry in the cache is a pair
   // of a Response and a TensorParams struct.
   std::list<std::pair<Response, TensorParams>> cache_;
 
-  // Vector of iterators to cache entries. Indexed by cache bit.
+  // Vector of iterators to cache entries. Indexed by cache bit. Freed bits
+  // point to the end of cache_.
   std::vector<std::list<std::pair<Response, TensorParams>>::iterator>
       cache_iters_;
 
+  // Freed bits below cache_iters_.size(), reused lowest first.
+  std::set<uint32_t> free_bits_;
+
   // Lookup table mapping tensor names to assigned cache bits.
   std::unordered_map<std::string, uint32_t> tensor_name_to_bit_;
 
+  // Same as above, indexed by tensor ID. Unassigned IDs map to NO_CACHE_BIT.
+  std::vector<uint32_t> tensor_id_to_bit_;
+
+  static constexpr uint32_t NO_CACHE_BIT = UINT32_MAX;
+
+  TensorNameTable* tensor_name_table_ = nullptr;
+
   bool bits_outdated_ = false;
 
   bool print_warning_ = true;
@@ -118,6 +169,10 @@ public:
 
   void set_uncached_in_queue(bool uncached_in_queue);
 
+  // Number of common cache hits found by the previous sync, which must be
+  // the same on all workers. Chooses how the bit vector is exchanged.
+  void set_expected_hits(size_t expected_hits);
+
   const std::set<uint32_t>& cache_hits() const;
 
   const std::set<uint32_t>& invalid_bits() const;
@@ -132,6 +187,12 @@ public:
   void sync(std::shared_ptr<Controller> controller, bool timeline_enabled);
 
 private:
+  // Intersects the first count words of the bit vector across workers in
+  // two rounds: a summary with one bit per word that is non-zero, and then
+  // only the words that are non-zero on every worker. All other words are
+  // zero in the result anyway.
+  void compact_bitwise_and_(Controller& controller, int count);
+
   enum StatusBit {
     SHOULD_SHUT_DOWN = 0,
     UNCACHED_IN_QUEUE = 1,
@@ -159,6 +220,8 @@ private:
   bool should_shut_down_ = false;
   bool uncached_in_queue_ = false;
 
+  size_t expected_hits_ = 0;
+
   // State used internally to trigger second bit vector communication
   // to sync invalid bits.
   bool invalid_in_queue_ = false;
@@ -168,6 +231,51 @@ private:
   bool synced_ = false;
 };
 
+// Records the batches of cache bits that workers agreed on in cycles served
+// entirely from the cache. A step ends when a bit repeats. Once the same
+// sequence of batches has been observed for a number of consecutive steps,
+// the schedule is frozen and workers can replay it without coordination.
+//
+// All decisions are derived from synced cache hits, so every worker freezes
+// and advances the schedule at the same point.
+class FrozenSchedule {
+public:
+  // Records the common cache hits of a cycle that needed no coordination.
+  void observe(const std::set<uint32_t>& cache_hits, int freeze_after_steps);
+
+  // Forgets observed steps, e.g. after a cycle needed coordination.
+  void reset();
+
+  bool frozen() const;
+
+  // Cache bits of the batch to execute next. Only valid while frozen.
+  const std::set<uint32_t>& next_batch() const;
+
+  bool at_step_boundary() const;
+
+  bool contains(uint32_t bit) const;
+
+  void advance();
+
+  // Set when this worker saw requests outside of the schedule. Workers check
+  // for mismatches on any of them at the next step boundary.
+  void set_mismatch();
+
+  bool mismatch() const;
+
+private:
+  std::vector<std::set<uint32_t>> current_step_;
+  std::set<uint32_t> current_step_bits_;
+
+  std::vector<std::set<uint32_t>> last_step_;
+  int repeats_ = 0;
+
+  bool frozen_ = false;
+  size_t position_ = 0;
+  std::set<uint32_t> schedule_bits_;
+  bool mismatch_ = false;
+};
+
 } // namespace common
 } // namespace horovod
 
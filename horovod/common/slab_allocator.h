@@ -0,0 +1,129 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_SLAB_ALLOCATOR_H
+#define HOROVOD_SLAB_ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace horovod {
+namespace common {
+
+// Blocks of one size carved from slabs, which are only freed with the pool.
+// Freed blocks are kept for reuse, so that a container allocating and
+// freeing nodes at a steady rate stops allocating. The block size is that of
+// the first allocation; others go to the heap. Not thread-safe.
+class SlabPool {
+public:
+  SlabPool() = default;
+  SlabPool(const SlabPool&) = delete;
+  SlabPool& operator=(const SlabPool&) = delete;
+
+  // Whether allocations of size bytes come from the slabs.
+  bool Holds(size_t size) {
+    if (block_size_ == 0) {
+      block_size_ = size;
+    }
+    return size == block_size_;
+  }
+
+  void* Allocate() {
+    if (free_ == nullptr) {
+      Grow();
+    }
+    auto block = free_;
+    free_ = block->next;
+    return block;
+  }
+
+  void Deallocate(void* p) {
+    auto block = static_cast<FreeBlock*>(p);
+    block->next = free_;
+    free_ = block;
+  }
+
+private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static constexpr size_t BLOCKS_PER_SLAB = 64;
+
+  void Grow() {
+    size_t stride = (std::max(block_size_, sizeof(FreeBlock)) +
+                     alignof(std::max_align_t) - 1) /
+                    alignof(std::max_align_t) * alignof(std::max_align_t);
+    // new[] of char is aligned for any fundamental type.
+    slabs_.emplace_back(new char[stride * BLOCKS_PER_SLAB]);
+    char* slab = slabs_.back().get();
+    for (size_t i = BLOCKS_PER_SLAB; i-- > 0;) {
+      Deallocate(slab + i * stride);
+    }
+  }
+
+  size_t block_size_ = 0;
+  FreeBlock* free_ = nullptr;
+  std::vector<std::unique_ptr<char[]>> slabs_;
+};
+
+// Allocator of node-based containers taking single objects from a SlabPool
+// shared by its copies. Arrays, like the buckets of a hash map, come from
+// the heap. Only as thread-safe as the container using it.
+template <class T> class SlabAllocator {
+public:
+  using value_type = T;
+
+  SlabAllocator() : pool_(std::make_shared<SlabPool>()) {}
+
+  template <class U>
+  SlabAllocator(const SlabAllocator<U>& other) : pool_(other.pool_) {}
+
+  T* allocate(size_t n) {
+    if (n == 1 && pool_->Holds(sizeof(T))) {
+      return static_cast<T*>(pool_->Allocate());
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    if (n == 1 && pool_->Holds(sizeof(T))) {
+      pool_->Deallocate(p);
+      return;
+    }
+    ::operator delete(p);
+  }
+
+  template <class U> bool operator==(const SlabAllocator<U>& other) const {
+    return pool_ == other.pool_;
+  }
+
+  template <class U> bool operator!=(const SlabAllocator<U>& other) const {
+    return pool_ != other.pool_;
+  }
+
+private:
+  template <class U> friend class SlabAllocator;
+
+  std::shared_ptr<SlabPool> pool_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_SLAB_ALLOCATOR_H
@@ -15,6 +15,8 @@
 
 #include "stall_inspector.h"
 
+#include <algorithm>
+#include <iterator>
 #include <map>
 #include <unordered_set>
 
@@ -24,7 +26,7 @@ namespace horovod {
 namespace common {
 
 bool StallInspector::CheckForStalledTensors(
-    const std::vector<int>& global_ranks) {
+    const std::vector<int>& global_ranks, int64_t* num_stalled) {
   bool should_shut_down = false;
   auto now = std::chrono::steady_clock::now();
   std::map<int32_t, std::set<std::string>> missing_ranks;
@@ -39,31 +41,40 @@ bool StallInspector::CheckForStalledTensors(
     stall_shutdown_time = std::chrono::seconds(0);
   }
 
-  for (auto& m : uncached_tensor_table) {
-    auto tensor_name = m.first;
-    std::vector<int>& ranks = std::get<0>(m.second);
-    std::chrono::steady_clock::time_point start_at = std::get<1>(m.second);
-    auto lag = now - start_at;
-
-    if (lag > stall_warning_time) {
-      std::unordered_set<int32_t> ready_ranks;
-      for (auto rank : ranks) {
-        ready_ranks.insert(rank);
-      }
+  // Only tensors pending for longer than the warning time are visited.
+  auto process_set_size = global_ranks.size();
+  std::vector<bool> ready_ranks(process_set_size);
+  uncached_tensor_table.ForEachStartedBefore(
+      now - stall_warning_time,
+      [&](const std::string& tensor_name,
+          std::chrono::steady_clock::time_point start_at,
+          const std::vector<int>& ranks) {
+        auto lag = now - start_at;
+        if (num_stalled != nullptr) {
+          ++*num_stalled;
+        }
+        std::fill(ready_ranks.begin(), ready_ranks.end(), false);
+        for (auto rank : ranks) {
+          ready_ranks[rank] = true;
+        }
 
-      auto process_set_size = global_ranks.size();
-      for (int32_t rank = 0; rank < static_cast<int32_t>(process_set_size); ++rank) {
-        if (ready_ranks.find(rank) == ready_ranks.end()) {
-          missing_ranks[rank].insert(tensor_name);
-          if (stall_shutdown_time > std::chrono::seconds(0) &&
-              lag > stall_shutdown_time) {
-            shutdown_ranks.insert(rank);
-            should_shut_down = true;
+        for (int32_t rank = 0; rank < static_cast<int32_t>(process_set_size);
+             ++rank) {
+          if (!ready_ranks[rank]) {
+            // Only the first names are reported, keep no more of them.
+            auto& names = missing_ranks[rank];
+            names.insert(tensor_name);
+            if (names.size() > MAX_REPORTED_TENSORS) {
+              names.erase(std::prev(names.end()));
+            }
+            if (stall_shutdown_time > std::chrono::seconds(0) &&
+                lag > stall_shutdown_time) {
+              shutdown_ranks.insert(rank);
+              should_shut_down = true;
+            }
           }
         }
-      }
-    }
-  }
+      });
 
   if (!missing_ranks.empty()) {
     std::stringstream message;
@@ -88,7 +99,7 @@ bool StallInspector::CheckForStalledTensors(
       int count = 0;
       while (++it != kv.second.end()) {
         message << ", " << *it;
-        if (++count == 5) {
+        if (++count == MAX_REPORTED_TENSORS - 1) {
           message << " ...";
           break;
         }
@@ -111,52 +122,95 @@ bool StallInspector::CheckForStalledTensors(
   return should_shut_down;
 }
 
+bool StallInspector::CheckForStalledFrozenBatch(
+    const std::vector<std::string>& missing_tensors,
+    std::chrono::steady_clock::time_point wait_start, int rank,
+    bool& should_shut_down) {
+  should_shut_down = false;
+  auto lag = std::chrono::steady_clock::now() - wait_start;
+  std::chrono::seconds stall_warning_time(stall_warning_time_seconds);
+  std::chrono::seconds stall_shutdown_time(stall_shutdown_time_seconds);
+  if (lag <= stall_warning_time) {
+    return false;
+  }
+  if (stall_shutdown_time > stall_warning_time && lag > stall_shutdown_time) {
+    should_shut_down = true;
+  }
+
+  std::stringstream message;
+  message << "Rank " << rank << " has been waiting for tensors of the frozen "
+          << "response schedule for more than " << stall_warning_time.count()
+          << " seconds. This may indicate that this rank stopped submitting "
+             "the tensors of previous steps, which will cause deadlock. "
+          << std::endl
+          << "Missing tensors: [";
+  size_t count = 0;
+  for (auto& tensor_name : missing_tensors) {
+    if (count > 0) {
+      message << ", ";
+    }
+    if (count++ == MAX_REPORTED_TENSORS) {
+      message << "...";
+      break;
+    }
+    message << tensor_name;
+  }
+  message << "]";
+
+  if (should_shut_down) {
+    message << std::endl
+            << "Rank " << rank << " is stalled for longer than "
+            << stall_shutdown_time.count() << " seconds. Will shutdown.";
+    LOG(ERROR) << message.str();
+  } else {
+    LOG(WARNING) << message.str();
+  }
+  return true;
+}
+
 void StallInspector::InvalidateStalledCachedTensors(
     CacheCoordinator& cache_coordinator) {
   auto now = std::chrono::steady_clock::now();
   std::chrono::seconds stall_warning_time(stall_warning_time_seconds);
 
-  for (auto& entry : cached_tensor_table) {
-    // If pending time for cached tensor exceeds stall_warning_time, mark entry
-    // for global removal from cache to trigger stall messaging.
-    if (now - entry.second > stall_warning_time) {
-      uint32_t cache_bit = response_cache_.peek_cache_bit(entry.first);
-      cache_coordinator.record_invalid_bit(cache_bit);
-      cache_coordinator.set_uncached_in_queue(true);
-    }
-  }
+  // If pending time for cached tensor exceeds stall_warning_time, mark entry
+  // for global removal from cache to trigger stall messaging.
+  cached_tensor_table.ForEachStartedBefore(
+      now - stall_warning_time,
+      [&](const std::string& tensor_name,
+          std::chrono::steady_clock::time_point, const CachedTensor&) {
+        uint32_t cache_bit = response_cache_.peek_cache_bit(tensor_name);
+        cache_coordinator.record_invalid_bit(cache_bit);
+        cache_coordinator.set_uncached_in_queue(true);
+      });
 }
 
 void StallInspector::RecordUncachedTensorStart(const std::string& tensor_name,
                                                int rank, int process_set_size) {
-  auto table_iter = uncached_tensor_table.find(tensor_name);
-  if (table_iter == uncached_tensor_table.end()) {
-    std::vector<int> ranks = {rank};
+  bool inserted = false;
+  auto& ranks = uncached_tensor_table.Insert(
+      tensor_name, std::chrono::steady_clock::now(), &inserted);
+  if (inserted) {
     ranks.reserve(static_cast<unsigned long>(process_set_size));
-    auto now = std::chrono::steady_clock::now();
-    uncached_tensor_table.emplace(tensor_name,
-                                  std::make_tuple(std::move(ranks), now));
-  } else {
-    std::vector<int>& ranks = std::get<0>(table_iter->second);
-    ranks.push_back(rank);
   }
+  ranks.push_back(rank);
 }
 
 void StallInspector::RecordCachedTensorStart(const std::string& tensor_name) {
-  if (perform_stall_check &&
-      cached_tensor_table.find(tensor_name) == cached_tensor_table.end()) {
-    cached_tensor_table[tensor_name] = std::chrono::steady_clock::now();
+  if (perform_stall_check && !cached_tensor_table.Contains(tensor_name)) {
+    cached_tensor_table.Insert(tensor_name, std::chrono::steady_clock::now(),
+                               nullptr);
   }
 }
 
 void StallInspector::RemoveCachedTensor(const std::string& tensor_name) {
   if (perform_stall_check) {
-    cached_tensor_table.erase(tensor_name);
+    cached_tensor_table.Erase(tensor_name);
   }
 }
 
 void StallInspector::RemoveUncachedTensor(const std::string& tensor_name) {
-  uncached_tensor_table.erase(tensor_name);
+  uncached_tensor_table.Erase(tensor_name);
 }
 
 bool StallInspector::ShouldPerformCheck() {
@@ -17,8 +17,12 @@
 #define HOROVOD_STALL_INSPECTOR_H
 
 #include <chrono>
+#include <cstdint>
+#include <deque>
 #include <iostream>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "response_cache.h"
 
@@ -27,6 +31,95 @@ namespace common {
 
 class ResponseCache;
 
+// Table of pending tensors that also keeps them in the order they were first
+// seen, so that stall checks visit only the entries older than the deadline
+// instead of the whole table. Erased entries are dropped lazily from the
+// order, which is compacted once it holds mostly erased entries.
+template <typename T> class PendingTensorTable {
+public:
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  // Returns the value of the tensor, adding one that starts at now if the
+  // tensor is not pending yet.
+  T& Insert(const std::string& tensor_name, TimePoint now, bool* inserted) {
+    auto result = entries_.emplace(tensor_name, Entry());
+    if (inserted != nullptr) {
+      *inserted = result.second;
+    }
+    auto& entry = result.first->second;
+    if (result.second) {
+      entry.start = now;
+      entry.sequence = next_sequence_++;
+      order_.push_back(Order{now, entry.sequence, tensor_name});
+    }
+    return entry.value;
+  }
+
+  bool Contains(const std::string& tensor_name) const {
+    return entries_.find(tensor_name) != entries_.end();
+  }
+
+  void Erase(const std::string& tensor_name) {
+    if (entries_.erase(tensor_name) == 0) {
+      return;
+    }
+    if (order_.size() > 2 * entries_.size() + MIN_COMPACT_SIZE) {
+      std::deque<Order> live;
+      for (auto& order : order_) {
+        if (IsLive(order)) {
+          live.push_back(std::move(order));
+        }
+      }
+      order_.swap(live);
+    }
+  }
+
+  // Calls fn(tensor_name, start, value) for the entries that started before
+  // the deadline, oldest first.
+  template <typename Fn> void ForEachStartedBefore(TimePoint deadline, Fn fn) {
+    while (!order_.empty() && !IsLive(order_.front())) {
+      order_.pop_front();
+    }
+    for (auto& order : order_) {
+      if (order.start >= deadline) {
+        break;
+      }
+      auto it = entries_.find(order.tensor_name);
+      if (it != entries_.end() && it->second.sequence == order.sequence) {
+        fn(order.tensor_name, order.start, it->second.value);
+      }
+    }
+  }
+
+private:
+  struct Entry {
+    T value;
+    TimePoint start;
+    uint64_t sequence = 0;
+  };
+
+  struct Order {
+    TimePoint start;
+    uint64_t sequence;
+    std::string tensor_name;
+  };
+
+  bool IsLive(const Order& order) const {
+    auto it = entries_.find(order.tensor_name);
+    return it != entries_.end() && it->second.sequence == order.sequence;
+  }
+
+  static constexpr size_t MIN_COMPACT_SIZE = 64;
+
+  std::unordered_map<std::string, Entry> entries_;
+
+  // Entries by start time. The clock is monotonic, so this is also the order
+  // in which they were inserted.
+  std::deque<Order> order_;
+
+  uint64_t next_sequence_ = 0;
+};
+
 class StallInspector {
 public:
   StallInspector() = delete;
@@ -38,7 +131,18 @@ public:
   // by some ranks but not others in the same process set and are waiting for
   // long time to get processed.
   // global_ranks contains the global process rank of each expected process.
-  bool CheckForStalledTensors(const std::vector<int>& global_ranks);
+  // The number of tensors reported is added to num_stalled if given.
+  bool CheckForStalledTensors(const std::vector<int>& global_ranks,
+                              int64_t* num_stalled = nullptr);
+
+  // Report tensors of a frozen response schedule batch that this worker has
+  // been waiting for since wait_start. Returns true if the wait is longer
+  // than the warning time, should_shut_down is set if it is also longer than
+  // the shutdown time.
+  bool CheckForStalledFrozenBatch(
+      const std::vector<std::string>& missing_tensors,
+      std::chrono::steady_clock::time_point wait_start, int rank,
+      bool& should_shut_down);
 
   // Invalidate cached tensors that have been pending for a long time.
   void InvalidateStalledCachedTensors(CacheCoordinator& cache_coordinator);
@@ -68,6 +172,9 @@ public:
   void SetStallShutdownTimeSeconds(int value);
 
 protected:
+  // Number of stalled tensor names reported for every missing rank.
+  static constexpr size_t MAX_REPORTED_TENSORS = 6;
+
   // Time point when coordinator last checked for stalled tensors.
   std::chrono::steady_clock::time_point last_stall_check;
 
@@ -84,15 +191,12 @@ protected:
 
   // Initial time cached tensors are seen in queue. Used for stall message
   // handling.
-  std::unordered_map<std::string, std::chrono::steady_clock::time_point>
-      cached_tensor_table;
-
-  // Initial time that tensors are seen in the normal message queue. The value
-  // consists of a list of ready ranks and the starting point.
-  std::unordered_map<
-      std::string,
-      std::tuple<std::vector<int>, std::chrono::steady_clock::time_point>>
-      uncached_tensor_table;
+  struct CachedTensor {};
+  PendingTensorTable<CachedTensor> cached_tensor_table;
+
+  // Initial time that tensors are seen in the normal message queue, with the
+  // list of ready ranks.
+  PendingTensorTable<std::vector<int>> uncached_tensor_table;
 
   // Outside dependencies
   ResponseCache& response_cache_;
@@ -0,0 +1,181 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "step_profiler.h"
+
+#include <algorithm>
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+const char* const STEP_VALUE_NAMES[] = {
+    "step_time_us",
+    "compute_end_us",
+    "communication_time_us",
+    "exposed_communication_us",
+    "exposed_time_us",
+    "cycle_wait_us",
+    "tensors",
+};
+
+static_assert(sizeof(STEP_VALUE_NAMES) / sizeof(STEP_VALUE_NAMES[0]) ==
+                  NUM_STEP_VALUES,
+              "every step value needs a name");
+
+int64_t Microseconds(StepProfiler::Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+      .count();
+}
+
+} // namespace
+
+void StepProfiler::Begin() {
+  enabled_.store(true, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> guard(mutex_);
+  in_step_ = true;
+  step_start_ = Clock::now();
+  operations_.clear();
+  cycle_wait_ = Clock::duration(0);
+}
+
+bool StepProfiler::End(StepReport& report) {
+  auto step_end = Clock::now();
+  std::vector<Operation> operations;
+  Clock::time_point step_start;
+  Clock::duration cycle_wait;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!in_step_) {
+      return false;
+    }
+    in_step_ = false;
+    operations.swap(operations_);
+    step_start = step_start_;
+    cycle_wait = cycle_wait_;
+  }
+
+  report = StepReport();
+  auto compute_end = step_start;
+  auto last_completion = step_start;
+  int64_t num_tensors = 0;
+  for (auto& operation : operations) {
+    bool of_step = false;
+    for (auto& tensor : operation.tensors) {
+      if (tensor.enqueue_time >= step_start) {
+        compute_end = std::max(compute_end, tensor.enqueue_time);
+        ++num_tensors;
+        of_step = true;
+      }
+    }
+    if (of_step) {
+      last_completion = std::max(last_completion, operation.end);
+    }
+  }
+  compute_end = std::min(compute_end, step_end);
+  last_completion = std::min(last_completion, step_end);
+
+  // Merge the operations, which run concurrently on several streams or
+  // process sets, into disjoint intervals within the step.
+  std::vector<std::pair<Clock::time_point, Clock::time_point>> intervals;
+  for (auto& operation : operations) {
+    auto start = std::max(operation.start, step_start);
+    auto end = std::min(operation.end, step_end);
+    if (end > start) {
+      intervals.emplace_back(start, end);
+    }
+  }
+  std::sort(intervals.begin(), intervals.end());
+  Clock::duration communication(0);
+  Clock::duration exposed_communication(0);
+  auto add_interval = [&](Clock::time_point start, Clock::time_point end) {
+    communication += end - start;
+    auto exposed_start = std::max(start, compute_end);
+    if (end > exposed_start) {
+      exposed_communication += end - exposed_start;
+    }
+  };
+  for (size_t i = 0; i < intervals.size();) {
+    auto start = intervals[i].first;
+    auto end = intervals[i].second;
+    for (++i; i < intervals.size() && intervals[i].first <= end; ++i) {
+      end = std::max(end, intervals[i].second);
+    }
+    add_interval(start, end);
+  }
+
+  for (auto& operation : operations) {
+    if (operation.end <= compute_end || operation.end > step_end) {
+      continue;
+    }
+    for (auto& tensor : operation.tensors) {
+      report.critical_tensors.emplace_back(
+          std::move(tensor.name), Microseconds(operation.end - compute_end));
+    }
+  }
+  std::stable_sort(report.critical_tensors.begin(),
+                   report.critical_tensors.end(),
+                   [](const std::pair<std::string, int64_t>& a,
+                      const std::pair<std::string, int64_t>& b) {
+                     return a.second > b.second;
+                   });
+
+  report.values[STEP_TIME_US] = Microseconds(step_end - step_start);
+  report.values[STEP_COMPUTE_END_US] = Microseconds(compute_end - step_start);
+  report.values[STEP_COMMUNICATION_TIME_US] = Microseconds(communication);
+  report.values[STEP_EXPOSED_COMMUNICATION_US] =
+      Microseconds(exposed_communication);
+  report.values[STEP_EXPOSED_TIME_US] =
+      last_completion > compute_end
+          ? Microseconds(last_completion - compute_end)
+          : 0;
+  report.values[STEP_CYCLE_WAIT_US] = Microseconds(cycle_wait);
+  report.values[STEP_TENSORS] = num_tensors;
+  return true;
+}
+
+void StepProfiler::RecordOperation(std::vector<TensorTiming> tensors,
+                                   Clock::time_point start,
+                                   Clock::time_point end) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!in_step_) {
+    return;
+  }
+  operations_.push_back(Operation{std::move(tensors), start, end});
+}
+
+void StepProfiler::RecordCycleWait(Clock::time_point wait_start,
+                                   Clock::time_point first_enqueue,
+                                   Clock::time_point wakeup) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!in_step_) {
+    return;
+  }
+  auto idle_start = std::max({wait_start, first_enqueue, step_start_});
+  if (wakeup > idle_start) {
+    cycle_wait_ += wakeup - idle_start;
+  }
+}
+
+const char* StepProfiler::Name(int index) {
+  if (index < 0 || index >= NUM_STEP_VALUES) {
+    return "";
+  }
+  return STEP_VALUE_NAMES[index];
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,118 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_STEP_PROFILER_H
+#define HOROVOD_STEP_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace horovod {
+namespace common {
+
+// Values of a step report, indices into StepReport::values. Times are in
+// microseconds.
+enum StepValueIndex {
+  // From the start to the end of the step.
+  STEP_TIME_US = 0,
+  // From the start of the step until its last tensor was enqueued, after
+  // which the framework has no more compute to overlap communication with.
+  STEP_COMPUTE_END_US,
+  // Time any operation of the step was running, from its start after
+  // negotiation until it completed.
+  STEP_COMMUNICATION_TIME_US,
+  // Part of the communication time after the compute end.
+  STEP_EXPOSED_COMMUNICATION_US,
+  // From the compute end until the last tensor of the step completed, which
+  // includes negotiation and cycle waits.
+  STEP_EXPOSED_TIME_US,
+  // Time tensors of the step were waiting for the background thread to wake
+  // up for the next cycle.
+  STEP_CYCLE_WAIT_US,
+  // Tensors enqueued and completed during the step.
+  STEP_TENSORS,
+  NUM_STEP_VALUES
+};
+
+struct StepReport {
+  int64_t values[NUM_STEP_VALUES] = {};
+  // Tensors that completed after the compute end, the last one first, with
+  // the time from the compute end until they completed. They are what the
+  // framework waited for at the end of the step.
+  std::vector<std::pair<std::string, int64_t>> critical_tensors;
+};
+
+// Attributes the communication between horovod_step_begin() and
+// horovod_step_end() to the training step, so that the communication that
+// was not overlapped with compute can be told apart from the rest. Only
+// costs time once a step has been started.
+class StepProfiler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct TensorTiming {
+    std::string name;
+    Clock::time_point enqueue_time;
+  };
+
+  StepProfiler() = default;
+  StepProfiler(const StepProfiler&) = delete;
+
+  // Whether steps are reported, from the first Begin() on.
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  void Begin();
+
+  // Ends the step started by Begin() and returns false if there was none.
+  bool End(StepReport& report);
+
+  // An operation of tensors that ran from start until end.
+  void RecordOperation(std::vector<TensorTiming> tensors,
+                       Clock::time_point start, Clock::time_point end);
+
+  // The background thread waited from wait_start until wakeup, with tensors
+  // in the queue since first_enqueue.
+  void RecordCycleWait(Clock::time_point wait_start,
+                       Clock::time_point first_enqueue,
+                       Clock::time_point wakeup);
+
+  // Name of the step value at index, e.g. "exposed_communication_us".
+  static const char* Name(int index);
+
+private:
+  struct Operation {
+    std::vector<TensorTiming> tensors;
+    Clock::time_point start;
+    Clock::time_point end;
+  };
+
+  std::atomic_bool enabled_{false};
+
+  std::mutex mutex_;
+  bool in_step_ = false;
+  Clock::time_point step_start_;
+  std::vector<Operation> operations_;
+  Clock::duration cycle_wait_{0};
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_STEP_PROFILER_H
@@ -0,0 +1,85 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "tensor_name_table.h"
+
+#include <assert.h>
+
+namespace horovod {
+namespace common {
+
+int32_t TensorNameTable::Acquire(const std::string& tensor_name) {
+  int32_t shard_index =
+      (int32_t)(std::hash<std::string>()(tensor_name) % NUM_SHARDS);
+  auto& shard = shards_[shard_index];
+  std::lock_guard<std::mutex> guard(shard.mutex);
+
+  int32_t slot;
+  auto it = shard.name_to_slot.find(tensor_name);
+  if (it != shard.name_to_slot.end()) {
+    slot = it->second;
+    shard.ref_counts[slot]++;
+  } else {
+    if (!shard.free_slots.empty()) {
+      slot = shard.free_slots.front();
+      shard.free_slots.pop();
+      shard.names[slot] = tensor_name;
+      shard.ref_counts[slot] = 1;
+    } else {
+      slot = (int32_t)shard.names.size();
+      shard.names.push_back(tensor_name);
+      shard.ref_counts.push_back(1);
+    }
+    shard.name_to_slot.emplace(tensor_name, slot);
+  }
+  return slot * NUM_SHARDS + shard_index;
+}
+
+void TensorNameTable::AddRef(int32_t tensor_id) {
+  assert(tensor_id != NULL_TENSOR_ID);
+  auto& shard = shards_[tensor_id % NUM_SHARDS];
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  int32_t slot = tensor_id / NUM_SHARDS;
+  assert(shard.ref_counts[slot] > 0);
+  shard.ref_counts[slot]++;
+}
+
+void TensorNameTable::Release(int32_t tensor_id) {
+  assert(tensor_id != NULL_TENSOR_ID);
+  auto& shard = shards_[tensor_id % NUM_SHARDS];
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  int32_t slot = tensor_id / NUM_SHARDS;
+  assert(shard.ref_counts[slot] > 0);
+  if (--shard.ref_counts[slot] == 0) {
+    shard.name_to_slot.erase(shard.names[slot]);
+    shard.names[slot].clear();
+    shard.free_slots.push(slot);
+  }
+}
+
+int32_t TensorNameTable::Find(const std::string& tensor_name) const {
+  int32_t shard_index =
+      (int32_t)(std::hash<std::string>()(tensor_name) % NUM_SHARDS);
+  auto& shard = shards_[shard_index];
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto it = shard.name_to_slot.find(tensor_name);
+  if (it == shard.name_to_slot.end()) {
+    return NULL_TENSOR_ID;
+  }
+  return it->second * NUM_SHARDS + shard_index;
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,76 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_TENSOR_NAME_TABLE_H
+#define HOROVOD_TENSOR_NAME_TABLE_H
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Null tensor ID used when no ID is assigned.
+#define NULL_TENSOR_ID -1
+
+namespace horovod {
+namespace common {
+
+// Interns tensor names into small integer IDs, so that per-cycle lookups can
+// index a vector instead of hashing the full name.
+//
+// An ID stays assigned to its name as long as at least one reference to it
+// is held, and is reused for another name afterwards. IDs are local to this
+// process and must never be sent to other ranks.
+class TensorNameTable {
+public:
+  TensorNameTable() = default;
+  TensorNameTable(const TensorNameTable&) = delete;
+
+  // Returns the ID of the name, assigning a new one if needed, and takes a
+  // reference to it.
+  int32_t Acquire(const std::string& tensor_name);
+
+  // Takes another reference to an ID returned by Acquire().
+  void AddRef(int32_t tensor_id);
+
+  // Drops a reference. The ID is freed once no reference is left.
+  void Release(int32_t tensor_id);
+
+  // Returns the ID currently assigned to the name or NULL_TENSOR_ID.
+  int32_t Find(const std::string& tensor_name) const;
+
+private:
+  // Names are sharded by hash, with IDs assigned as
+  // slot * NUM_SHARDS + shard index.
+  struct Shard {
+    std::unordered_map<std::string, int32_t> name_to_slot;
+    std::vector<std::string> names;
+    std::vector<int32_t> ref_counts;
+    std::queue<int32_t> free_slots;
+    mutable std::mutex mutex;
+  };
+
+  static constexpr int32_t NUM_SHARDS = 16;
+
+  std::array<Shard, NUM_SHARDS> shards_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_TENSOR_NAME_TABLE_H
@@ -23,40 +23,169 @@
 namespace horovod {
 namespace common {
 
+namespace {
+
+// View of the elements [offset, offset + count) of a tensor, which is
+// treated as flat.
+class TensorPartition : public Tensor {
+public:
+  TensorPartition(std::shared_ptr<Tensor> tensor, int64_t offset,
+                  int64_t count)
+      : tensor_(std::move(tensor)), offset_(offset), count_(count) {}
+
+  const DataType dtype() const override { return tensor_->dtype(); }
+
+  const TensorShape shape() const override {
+    TensorShape shape;
+    shape.AddDim(count_);
+    return shape;
+  }
+
+  const void* data() const override {
+    return static_cast<const uint8_t*>(tensor_->data()) +
+           offset_ * DataType_Size(dtype());
+  }
+
+  int64_t size() const override { return count_ * DataType_Size(dtype()); }
+
+private:
+  std::shared_ptr<Tensor> tensor_;
+  int64_t offset_;
+  int64_t count_;
+};
+
+// Replaces the callback of an entry by one that has to be called once for
+// each of its num_partitions parts. The original callback runs with the
+// status of the last part, or with the first error of any part.
+void WrapPartitionedCallback(TensorTableEntry& entry, int32_t num_partitions) {
+  struct PartitionState {
+    std::mutex mutex;
+    int32_t remaining;
+    Status error;
+  };
+  auto state = std::make_shared<PartitionState>();
+  state->remaining = num_partitions;
+  auto callback = std::move(entry.callback);
+  entry.callback = [state, callback](const Status& status) {
+    Status result = status;
+    {
+      std::lock_guard<std::mutex> guard(state->mutex);
+      if (!status.ok() && state->error.ok()) {
+        state->error = status;
+      }
+      if (--state->remaining > 0) {
+        return;
+      }
+      if (!state->error.ok()) {
+        result = state->error;
+      }
+    }
+    if (callback != nullptr) {
+      callback(result);
+    }
+  };
+}
+
+} // namespace
+
+TensorQueue::TensorTableShard&
+TensorQueue::GetShard(const std::string& tensor_name) {
+  return tensor_table_[std::hash<std::string>()(tensor_name) %
+                       NUM_TENSOR_TABLE_SHARDS];
+}
+
+const TensorQueue::TensorTableShard&
+TensorQueue::GetShard(const std::string& tensor_name) const {
+  return tensor_table_[std::hash<std::string>()(tensor_name) %
+                       NUM_TENSOR_TABLE_SHARDS];
+}
+
 // Add a TensorTableEntry as well as its message to the queue.
 Status TensorQueue::AddToTensorQueue(TensorTableEntry& e, Request& message) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  if (tensor_table_.find(e.tensor_name) != tensor_table_.end()) {
-    return DUPLICATE_NAME_ERROR;
+  {
+    auto& shard = GetShard(e.tensor_name);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    if (shard.entries.find(e.tensor_name) != shard.entries.end()) {
+      return DUPLICATE_NAME_ERROR;
+    }
+    e.tensor_id = tensor_name_table_.Acquire(e.tensor_name);
+    e.enqueue_time = std::chrono::steady_clock::now();
+    NoteEnqueueTime(e.enqueue_time);
+    message.set_tensor_id(e.tensor_id);
+    shard.entries.emplace(e.tensor_name, std::move(e));
+  }
+  // The entry has to be in the table before the background thread can see
+  // its message.
+  message_queue_.Push(std::move(message));
+  auto wakeup_signal = wakeup_signal_.load(std::memory_order_acquire);
+  if (wakeup_signal != nullptr) {
+    wakeup_signal->Notify();
   }
-  tensor_table_.emplace(e.tensor_name, std::move(e));
-  message_queue_.push(std::move(message));
   return Status::OK();
 }
 
 Status TensorQueue::AddToTensorQueueMulti(std::vector<TensorTableEntry>& entries,
                                           std::vector<Request>& messages) {
-  std::lock_guard<std::mutex> guard(mutex_);
-
-  for (int i = 0; i < entries.size(); ++i) {
-    if (tensor_table_.find(entries[i].tensor_name) != tensor_table_.end()) {
+  for (size_t i = 0; i < entries.size(); ++i) {
+    bool duplicate = false;
+    {
+      auto& shard = GetShard(entries[i].tensor_name);
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      if (shard.entries.find(entries[i].tensor_name) != shard.entries.end()) {
+        duplicate = true;
+      } else {
+        entries[i].tensor_id = tensor_name_table_.Acquire(entries[i].tensor_name);
+        entries[i].enqueue_time = std::chrono::steady_clock::now();
+        NoteEnqueueTime(entries[i].enqueue_time);
+        messages[i].set_tensor_id(entries[i].tensor_id);
+        shard.entries.emplace(entries[i].tensor_name, std::move(entries[i]));
+      }
+    }
+    if (duplicate) {
+      // Take back the entries added so far, none of their messages have been
+      // queued yet.
+      for (size_t j = 0; j < i; ++j) {
+        auto& shard = GetShard(messages[j].tensor_name());
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        shard.entries.erase(messages[j].tensor_name());
+        tensor_name_table_.Release(messages[j].tensor_id());
+        messages[j].set_tensor_id(NULL_TENSOR_ID);
+      }
       return DUPLICATE_NAME_ERROR;
     }
-    tensor_table_.emplace(entries[i].tensor_name, std::move(entries[i]));
-    message_queue_.push(std::move(messages[i]));
+  }
+  // Queue the messages of the group together, so that they are all popped in
+  // the same cycle.
+  message_queue_.Push(messages.begin(), messages.end());
+  auto wakeup_signal = wakeup_signal_.load(std::memory_order_acquire);
+  if (wakeup_signal != nullptr) {
+    wakeup_signal->Notify();
   }
   return Status::OK();
 }
 
 // Execute callback for each tensor and clear tensor queue
 void TensorQueue::FinalizeTensorQueue(const Status& status) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  for (auto& e : tensor_table_) {
-    e.second.FinishWithCallback(status);
+  for (auto& shard : tensor_table_) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    for (auto& e : shard.entries) {
+      // Partitioned tensors are done once all parts that were not handed out
+      // have reported the status as well.
+      auto it = partitions_.find(e.first);
+      if (it != partitions_.end()) {
+        for (int32_t i = it->second.dispatched + 1;
+             i < it->second.num_partitions; ++i) {
+          e.second.callback(status);
+        }
+      }
+      e.second.FinishWithCallback(status);
+      tensor_name_table_.Release(e.second.tensor_id);
+    }
+    shard.entries.clear();
   }
-  tensor_table_.clear();
-  while (!message_queue_.empty()) {
-    message_queue_.pop();
+  partitions_.clear();
+  Request message;
+  while (message_queue_.Pop(message)) {
   }
 }
 
@@ -68,10 +197,14 @@ TensorQueue::GetTensorDataForAutotuner(const ResponseList& response_list,
   int64_t total_tensor_size = 0;
   for (auto& response : response_list.responses()) {
     if (response.response_type() == Response::ResponseType::ALLREDUCE) {
+      if (response.partition_offset() > 0) {
+        // The whole tensor is counted with its first part.
+        continue;
+      }
       for (auto& tensor_name : response.tensor_names()) {
         tensor_names.push_back(tensor_name);
         LOG(TRACE) << "Looking for tensor with name " << tensor_name;
-        auto& entry = tensor_table_.at(tensor_name);
+        auto& entry = GetTensorEntry(tensor_name);
         LOG(TRACE) << "Found tensor with name " << tensor_name;
         total_tensor_size += entry.tensor->size();
       }
@@ -87,55 +220,101 @@ void TensorQueue::GetTensorEntriesFromResponse(
     bool joined) {
   // Reserve to save re-allocation costs, as we know the size before.
   entries.reserve(response.tensor_names().size());
-  {
-    // Lock on the tensor table.
-    std::lock_guard<std::mutex> guard(mutex_);
-    int64_t i = 0;
-    for (auto& name : response.tensor_names()) {
-      assert(response.response_type() == Response::ALLREDUCE ||
-             response.response_type() == Response::ALLGATHER ||
-             response.response_type() == Response::BROADCAST ||
-             response.response_type() == Response::ALLTOALL ||
-             response.response_type() == Response::ADASUM ||
-             response.response_type() == Response::ERROR);
-
-      if (!joined) {
-        // We should never fail at finding this key in the tensor table.
-        auto iter = tensor_table_.find(name);
-        assert(iter != tensor_table_.end());
-
-        entries.push_back(std::move(iter->second));
-
-        // Clear the tensor table of this tensor.
-        tensor_table_.erase(iter);
-      } else if (response.response_type() != Response::ERROR) {
-
-        // Find Join tensor to use its context.
-        auto join_iter = tensor_table_.find(JOIN_TENSOR_NAME);
-        assert(join_iter != tensor_table_.end());
-
-        TensorTableEntry entry;
-        join_iter->second.context->AllocateZeros(response.tensor_sizes()[i],
-                                                 response.tensor_type(),
-                                                 &(entry.tensor));
-
-        entry.output = entry.tensor;
-        entry.device = join_iter->second.device;
-        entry.context = join_iter->second.context;
-        entry.tensor_name = name;
-        entries.push_back(std::move(entry));
+  int64_t i = 0;
+  for (auto& name : response.tensor_names()) {
+    assert(response.response_type() == Response::ALLREDUCE ||
+           response.response_type() == Response::ALLGATHER ||
+           response.response_type() == Response::BROADCAST ||
+           response.response_type() == Response::ALLTOALL ||
+           response.response_type() == Response::ADASUM ||
+           response.response_type() == Response::REDUCESCATTER ||
+           response.response_type() == Response::REDUCE ||
+           response.response_type() == Response::GATHER ||
+           response.response_type() == Response::ERROR);
+
+    if (!joined) {
+      // Lock on the shard holding this tensor.
+      auto& shard = GetShard(name);
+      std::lock_guard<std::mutex> guard(shard.mutex);
+
+      // We should never fail at finding this key in the tensor table.
+      auto iter = shard.entries.find(name);
+      assert(iter != shard.entries.end());
+
+      if (response.num_partitions() > 1) {
+        // Hand out a view of this part, and keep the entry in the table
+        // until the last part.
+        auto& progress = partitions_[name];
+        if (progress.dispatched == 0) {
+          progress.num_partitions = response.num_partitions();
+          WrapPartitionedCallback(iter->second, progress.num_partitions);
+        }
+        progress.dispatched++;
+        TensorTableEntry partition = iter->second;
+        partition.tensor_id = NULL_TENSOR_ID;
+        partition.tensor_name = name + "_part" +
+                                std::to_string(progress.dispatched) + "of" +
+                                std::to_string(progress.num_partitions);
+        partition.tensor = std::make_shared<TensorPartition>(
+            iter->second.tensor, response.partition_offset(),
+            response.tensor_sizes()[0]);
+        partition.output = std::make_shared<TensorPartition>(
+            iter->second.output, response.partition_offset(),
+            response.tensor_sizes()[0]);
+        entries.push_back(std::move(partition));
+        if (progress.dispatched == progress.num_partitions) {
+          partitions_.erase(name);
+          tensor_name_table_.Release(iter->second.tensor_id);
+          shard.entries.erase(iter);
+        }
+        i++;
+        continue;
+      }
+
+      tensor_name_table_.Release(iter->second.tensor_id);
+      iter->second.tensor_id = NULL_TENSOR_ID;
+      entries.push_back(std::move(iter->second));
+
+      // Clear the tensor table of this tensor.
+      shard.entries.erase(iter);
+    } else if (response.response_type() != Response::ERROR) {
+
+      // Find Join tensor to use its context.
+      auto& join_entry = GetTensorEntry(JOIN_TENSOR_NAME);
+
+      auto num_elements = response.tensor_sizes()[i];
+      auto& join_tensors =
+          join_tensors_[name + "@" +
+                        std::to_string(response.partition_offset())];
+      if (join_tensors.zeros == nullptr ||
+          join_tensors.zeros->dtype() != response.tensor_type() ||
+          join_tensors.zeros->shape().num_elements() != num_elements) {
+        join_entry.context->AllocateZeros(num_elements, response.tensor_type(),
+                                          &join_tensors.zeros);
+        join_entry.context->AllocateZeros(num_elements, response.tensor_type(),
+                                          &join_tensors.output);
       }
-      i++;
+
+      TensorTableEntry entry;
+      entry.tensor = join_tensors.zeros;
+      entry.output = join_tensors.output;
+      entry.device = join_entry.device;
+      entry.context = join_entry.context;
+      entry.tensor_name = name;
+      entries.push_back(std::move(entry));
     }
+    i++;
   }
 }
 
 // Get tensor entry given a tensor name
 const TensorTableEntry&
 TensorQueue::GetTensorEntry(const std::string& tensor_name) const{
-  // Lock on the tensor table.
-  std::lock_guard<std::mutex> guard(mutex_);
-  auto& iter = tensor_table_.at(tensor_name);
+  // Lock on the shard holding this tensor. The returned reference stays
+  // valid until the background thread itself removes the entry.
+  auto& shard = GetShard(tensor_name);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto& iter = shard.entries.at(tensor_name);
 
   return iter;
 }
@@ -143,40 +322,62 @@ TensorQueue::GetTensorEntry(const std::string& tensor_name) const{
 // Pop out all the messages from the queue
 void TensorQueue::PopMessagesFromQueue(
     std::deque<Request>& message_queue_buffer) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  while (!message_queue_.empty()) {
-    Request& message = message_queue_.front();
+  Request message;
+  while (message_queue_.Pop(message)) {
     message_queue_buffer.push_back(std::move(message));
-    message_queue_.pop();
   }
 }
 
 // Push a message to message queue
 void TensorQueue::PushMessageToQueue(Request& message) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  message_queue_.push(std::move(message));
+  message_queue_.Push(std::move(message));
 }
 
 // Push messages to message queue
 void TensorQueue::PushMessagesToQueue(
     std::deque<Request>& messages) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  while (!messages.empty()) {
-    Request& message = messages.front();
-    message_queue_.push(std::move(message));
-    messages.pop_front();
-  }
+  message_queue_.Push(messages.begin(), messages.end());
+  messages.clear();
 }
 
 // Remove JoinOp tensor from the table and execute the callback
 void TensorQueue::RemoveJoinTensor() {
-  // Lock on the tensor table.
-  std::lock_guard<std::mutex> guard(mutex_);
-  auto iter = tensor_table_.find(JOIN_TENSOR_NAME);
-  assert(iter != tensor_table_.end());
+  // Lock on the shard holding the join tensor.
+  auto& shard = GetShard(JOIN_TENSOR_NAME);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto iter = shard.entries.find(JOIN_TENSOR_NAME);
+  assert(iter != shard.entries.end());
   auto& e = iter->second;
   e.FinishWithCallback(Status::OK());
-  tensor_table_.erase(iter);
+  tensor_name_table_.Release(e.tensor_id);
+  shard.entries.erase(iter);
+  join_tensors_.clear();
+}
+
+void TensorQueue::SetWakeupSignal(WakeupSignal* wakeup_signal) {
+  wakeup_signal_.store(wakeup_signal, std::memory_order_release);
+}
+
+bool TensorQueue::TakeFirstEnqueueTime(
+    std::chrono::steady_clock::time_point& time) {
+  int64_t ticks = first_enqueue_ticks_.exchange(0, std::memory_order_relaxed);
+  if (ticks == 0) {
+    return false;
+  }
+  time = std::chrono::steady_clock::time_point(
+      std::chrono::steady_clock::duration(ticks));
+  return true;
+}
+
+void TensorQueue::NoteEnqueueTime(std::chrono::steady_clock::time_point time) {
+  // Only the first enqueue after a TakeFirstEnqueueTime() writes.
+  if (first_enqueue_ticks_.load(std::memory_order_relaxed) != 0) {
+    return;
+  }
+  int64_t expected = 0;
+  first_enqueue_ticks_.compare_exchange_strong(
+      expected, (int64_t)time.time_since_epoch().count(),
+      std::memory_order_relaxed);
 }
 
 } // namespace common
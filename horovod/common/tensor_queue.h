@@ -16,11 +16,20 @@
 #ifndef HOROVOD_TENSOR_QUEUE_H
 #define HOROVOD_TENSOR_QUEUE_H
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <mutex>
 #include <queue>
+#include <string>
+#include <unordered_map>
 
 #include "common.h"
+#include "mpsc_queue.h"
+#include "slab_allocator.h"
+#include "tensor_name_table.h"
+#include "wakeup_signal.h"
 
 namespace horovod {
 namespace common {
@@ -51,16 +60,71 @@ public:
 
   void RemoveJoinTensor();
 
-protected:
-  // Tensors waiting to be allreduced or allgathered.
-  std::unordered_map<std::string, TensorTableEntry> tensor_table_;
+  // If set, the signal is notified whenever new tensors are added to the
+  // queue.
+  void SetWakeupSignal(WakeupSignal* wakeup_signal);
+
+  // Sets time to the enqueue time of the first tensor added since the last
+  // call. Returns false if no tensor has been added since.
+  bool TakeFirstEnqueueTime(std::chrono::steady_clock::time_point& time);
 
-  // Queue of MPI requests waiting to be sent to the coordinator node.
-  std::queue<Request> message_queue_;
+  // IDs of the names of the tensors in this queue. Entries and their
+  // requests hold a reference to their ID until the entry is removed.
+  TensorNameTable& tensor_name_table() { return tensor_name_table_; }
 
-  // A mutex that needs to be used whenever operations on message queue are
-  // done.
-  mutable std::mutex mutex_;
+protected:
+  // Tensors waiting to be allreduced or allgathered. The table is split into
+  // shards with their own lock, so that framework threads enqueueing
+  // different tensors rarely contend with each other or with the background
+  // thread. Entries are kept in nodes from a slab of the shard, which are
+  // reused once the entry is removed.
+  struct TensorTableShard {
+    std::unordered_map<
+        std::string, TensorTableEntry, std::hash<std::string>,
+        std::equal_to<std::string>,
+        SlabAllocator<std::pair<const std::string, TensorTableEntry>>>
+        entries;
+    mutable std::mutex mutex;
+  };
+
+  static constexpr size_t NUM_TENSOR_TABLE_SHARDS = 16;
+
+  TensorTableShard& GetShard(const std::string& tensor_name);
+  const TensorTableShard& GetShard(const std::string& tensor_name) const;
+
+  std::array<TensorTableShard, NUM_TENSOR_TABLE_SHARDS> tensor_table_;
+
+  // Tensors that are reduced in several parts stay in the table until their
+  // last part has been handed out. Only used by the background thread.
+  struct PartitionProgress {
+    int32_t dispatched = 0;
+    int32_t num_partitions = 1;
+  };
+  std::unordered_map<std::string, PartitionProgress> partitions_;
+
+  // Zeros a joined rank contributes to the responses of other ranks, and
+  // where it receives their results, kept until the join completes so that
+  // they are allocated once per tensor instead of once per response. Inputs
+  // are never written to. Only used by the background thread.
+  struct JoinTensors {
+    std::shared_ptr<Tensor> zeros;
+    std::shared_ptr<Tensor> output;
+  };
+  std::unordered_map<std::string, JoinTensors> join_tensors_;
+
+  // Queue of MPI requests waiting to be sent to the coordinator node. Pushed
+  // by framework threads, popped only by the background thread.
+  MPSCQueue<Request> message_queue_;
+
+  std::atomic<WakeupSignal*> wakeup_signal_{nullptr};
+
+  void NoteEnqueueTime(std::chrono::steady_clock::time_point time);
+
+  // Enqueue time of the first tensor added since TakeFirstEnqueueTime(), in
+  // ticks of the steady clock, or 0 if there is none.
+  std::atomic<int64_t> first_enqueue_ticks_{0};
+
+  TensorNameTable tensor_name_table_;
 };
 
 } // namespace common
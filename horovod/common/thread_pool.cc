@@ -14,6 +14,10 @@
 
 #include "thread_pool.h"
 
+#include <algorithm>
+
+#include "topology.h"
+
 namespace horovod {
 namespace common {
 
@@ -50,6 +54,7 @@ void ThreadPool::reset() {
 }
 
 void ThreadPool::loop() {
+  PlaceHelperThread();
   while (running_) {
     std::unique_lock<std::mutex> lock(mutex_);
     cond_.wait(lock, [this] {return !(running_ && work_queue_.empty());});
@@ -63,5 +68,127 @@ void ThreadPool::loop() {
   }
 }
 
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  reset();
+}
+
+void WorkStealingThreadPool::create(int num_threads) {
+  running_ = true;
+  queues_.clear();
+  for (int i = 0; i < std::max(num_threads, 1); ++i) {
+    queues_.emplace_back(new RangeQueue());
+  }
+  // Queue zero belongs to the thread calling ParallelFor().
+  for (int i = 1; i < num_threads; ++i) {
+    threads_.emplace_back(&WorkStealingThreadPool::loop, this, i);
+  }
+}
+
+void WorkStealingThreadPool::reset() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  running_ = false;
+  cond_.notify_all();
+  lock.unlock();
+
+  for (auto& thread: threads_) {
+    thread.join();
+  }
+  threads_.clear();
+}
+
+int WorkStealingThreadPool::num_threads() const {
+  return (int)threads_.size() + 1;
+}
+
+void WorkStealingThreadPool::ParallelFor(
+    int64_t size, int64_t grain,
+    const std::function<void(int64_t, int64_t)>& fn) {
+  grain = std::max(grain, (int64_t)1);
+  if (threads_.empty() || size <= grain) {
+    if (size > 0) {
+      fn(0, size);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> guard(parallel_for_mutex_);
+
+  // A few ranges per thread leave room for balancing through stealing.
+  int64_t num_ranges = std::min((size + grain - 1) / grain,
+                                (int64_t)queues_.size() * 4);
+  int64_t range_size = (size + num_ranges - 1) / num_ranges;
+  num_ranges = (size + range_size - 1) / range_size;
+
+  fn_ = &fn;
+  pending_ranges_ = num_ranges;
+  for (int64_t i = 0; i < num_ranges; ++i) {
+    auto& queue = *queues_[i % queues_.size()];
+    std::lock_guard<std::mutex> queue_guard(queue.mutex);
+    queue.ranges.emplace_back(i * range_size,
+                              std::min((i + 1) * range_size, size));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+  }
+  cond_.notify_all();
+
+  while (RunRange(0)) {
+  }
+  // Wait for ranges that other threads are still running.
+  while (pending_ranges_.load() > 0) {
+    std::this_thread::yield();
+  }
+  fn_ = nullptr;
+}
+
+bool WorkStealingThreadPool::RunRange(int index) {
+  std::pair<int64_t, int64_t> range;
+  bool found = false;
+  {
+    auto& queue = *queues_[index];
+    std::lock_guard<std::mutex> guard(queue.mutex);
+    if (!queue.ranges.empty()) {
+      range = queue.ranges.front();
+      queue.ranges.pop_front();
+      found = true;
+    }
+  }
+  for (size_t i = 1; !found && i < queues_.size(); ++i) {
+    auto& queue = *queues_[(index + i) % queues_.size()];
+    std::lock_guard<std::mutex> guard(queue.mutex);
+    if (!queue.ranges.empty()) {
+      range = queue.ranges.back();
+      queue.ranges.pop_back();
+      found = true;
+    }
+  }
+  if (!found) {
+    return false;
+  }
+
+  (*fn_)(range.first, range.second);
+  --pending_ranges_;
+  return true;
+}
+
+void WorkStealingThreadPool::loop(int index) {
+  PlaceHelperThread();
+  uint64_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this, generation] {
+        return !running_ || generation_ != generation;
+      });
+      if (!running_) break;
+      generation = generation_;
+    }
+
+    while (RunRange(index)) {
+    }
+  }
+}
+
 } // namespace common
 } // namespace horovod
@@ -15,8 +15,12 @@
 #ifndef HOROVOD_THREAD_POOL_H
 #define HOROVOD_THREAD_POOL_H
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <queue>
 #include <thread>
 #include <vector>
@@ -39,6 +43,52 @@ class ThreadPool {
     std::vector<std::thread> threads_;
 };
 
+// Splits loops over large CPU buffers across cores. Every thread, including
+// the caller, owns a queue of index ranges; threads that run out of work
+// steal ranges from the back of the other queues.
+class WorkStealingThreadPool {
+  public:
+    ~WorkStealingThreadPool();
+
+    // Uses num_threads threads in total, the calling thread included.
+    void create(int num_threads);
+    void reset();
+
+    int num_threads() const;
+
+    // Calls fn(begin, end) on disjoint ranges covering [0, size), each at
+    // least grain long where possible, and returns once all have run. Runs
+    // on the calling thread alone if the pool has no workers.
+    void ParallelFor(int64_t size, int64_t grain,
+                     const std::function<void(int64_t, int64_t)>& fn);
+
+  private:
+    struct RangeQueue {
+      std::mutex mutex;
+      std::deque<std::pair<int64_t, int64_t>> ranges;
+    };
+
+    void loop(int index);
+
+    // Runs one range from the queue of thread index, or one stolen from
+    // another queue. Returns false if no ranges are left.
+    bool RunRange(int index);
+
+    std::vector<std::unique_ptr<RangeQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    const std::function<void(int64_t, int64_t)>* fn_ = nullptr;
+    std::atomic<int64_t> pending_ranges_{0};
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    uint64_t generation_ = 0;
+    bool running_ = false;
+
+    // Serializes concurrent ParallelFor() calls.
+    std::mutex parallel_for_mutex_;
+};
+
 } // namespace common
 } // namespace horovod
 
@@ -15,6 +15,7 @@
 
 #include "timeline.h"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <sstream>
@@ -24,6 +25,7 @@
 #endif
 
 #include "logging.h"
+#include "topology.h"
 
 namespace horovod {
 namespace common {
@@ -65,6 +67,11 @@ void TimelineWriter::SetPendingTimelineFile(const std::string& filename) {
   }
 }
 
+void TimelineWriter::SetFormat(TimelineFormat format) {
+  std::lock_guard<std::recursive_mutex> guard(writer_mutex_);
+  format_ = format;
+}
+
 std::string TimelineWriter::PendingTimelineFile() {
   std::lock_guard<std::recursive_mutex> guard(writer_mutex_);
   return new_pending_filename_;
@@ -88,11 +95,11 @@ void TimelineWriter::SetTimelineFile(const std::string& filename) {
       return;
     }
     if (file_.is_open()) {
-      file_.flush();
-      file_.close();
+      CloseFile();
       LOG(INFO) << "Closed timeline file:" << cur_filename_;
     }
     tensor_table_.clear();
+    string_table_.clear();
   }
   // if new filename is empty, we need to stop accepting activities. This would
   // stopping timeline
@@ -111,7 +118,14 @@ void TimelineWriter::SetTimelineFile(const std::string& filename) {
     return;
   }
   // all other cases, need to create a new file
-  file_.open(filename, std::ios::out | std::ios::trunc);
+  file_format_ = format_;
+  if (file_format_ == TimelineFormat::BINARY) {
+    file_.open(filename, std::ios::out | std::ios::trunc | std::ios::binary);
+    binary_buffer_.reserve(BINARY_BUFFER_FLUSH_BYTES + 4096);
+    last_ts_micros_ = 0;
+  } else {
+    file_.open(filename, std::ios::out | std::ios::trunc);
+  }
   if (file_.good()) {
     LOG(INFO) << "Opened new timeline file" << filename
               << " Set active and healthy to true";
@@ -163,10 +177,16 @@ void TimelineWriter::Shutdown() {
   }
 
   if (!cur_filename_.empty() && file_.is_open()) {
-    file_.flush();
-    file_.close();
+    CloseFile();
   }
   tensor_table_.clear();
+  string_table_.clear();
+}
+
+void TimelineWriter::CloseFile() {
+  FlushBinaryBuffer();
+  file_.flush();
+  file_.close();
 }
 
 short TimelineWriter::active() { return active_.fetch_and(1); }
@@ -295,16 +315,139 @@ void TimelineWriter::DoWriteMarker(const TimelineRecord& r) {
   file_ << "}]";
 }
 
+// Binary timeline layout. All integers are unsigned LEB128 varints, and
+// timestamps are zigzag encoded differences to the previous record.
+//
+//   header: "HVDTL" 0x01 0x00 0x00, start time since epoch in microseconds
+//   BINARY_TENSOR: id, name length, name
+//   BINARY_STRING: id, length, bytes
+//   BINARY_EVENT:  phase, tensor id, op name id, args id, timestamp
+//   BINARY_MARKER: name id, timestamp
+//
+// Ids are assigned from 1 in order of definition, id 0 is the empty string.
+// Definitions always precede their first use, a string id may be defined
+// again with a different value.
+namespace {
+
+const char BINARY_MAGIC[8] = {'H', 'V', 'D', 'T', 'L', 1, 0, 0};
+
+enum BinaryRecordType : char {
+  BINARY_TENSOR = 1,
+  BINARY_STRING = 2,
+  BINARY_EVENT = 3,
+  BINARY_MARKER = 4
+};
+
+} // namespace
+
+void TimelineWriter::WriteVarint(uint64_t value) {
+  while (value >= 0x80) {
+    binary_buffer_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  binary_buffer_.push_back(static_cast<char>(value));
+}
+
+void TimelineWriter::WriteTimestampDelta(long ts_micros) {
+  int64_t delta = static_cast<int64_t>(ts_micros) - last_ts_micros_;
+  last_ts_micros_ = ts_micros;
+  WriteVarint((static_cast<uint64_t>(delta) << 1) ^
+              static_cast<uint64_t>(delta >> 63));
+}
+
+void TimelineWriter::WriteBinaryHeader() {
+  binary_buffer_.insert(binary_buffer_.end(), BINARY_MAGIC,
+                        BINARY_MAGIC + sizeof(BINARY_MAGIC));
+  WriteVarint(static_cast<uint64_t>(start_time_since_epoch_utc_micros_));
+}
+
+int TimelineWriter::InternBinaryString(const std::string& value) {
+  if (value.empty()) {
+    return 0;
+  }
+  auto it = string_table_.find(value);
+  if (it != string_table_.end()) {
+    return it->second;
+  }
+  // Once the table is full, e.g. with distinct arguments, further strings
+  // are defined again on every use under one scratch id.
+  int id = (int)MAX_BINARY_STRINGS + 1;
+  if (string_table_.size() < MAX_BINARY_STRINGS) {
+    id = (int)string_table_.size() + 1;
+    string_table_.emplace(value, id);
+  }
+  binary_buffer_.push_back(BINARY_STRING);
+  WriteVarint(id);
+  WriteVarint(value.size());
+  binary_buffer_.insert(binary_buffer_.end(), value.begin(), value.end());
+  return id;
+}
+
+void TimelineWriter::DoWriteBinaryEvent(const TimelineRecord& r) {
+  assert(r.type == TimelineRecordType::EVENT);
+  if (is_new_file_) {
+    WriteBinaryHeader();
+    is_new_file_ = false;
+  }
+  auto& tensor_idx = tensor_table_[r.tensor_name];
+  if (tensor_idx == 0) {
+    tensor_idx = (int)tensor_table_.size();
+    binary_buffer_.push_back(BINARY_TENSOR);
+    WriteVarint(tensor_idx);
+    WriteVarint(r.tensor_name.size());
+    binary_buffer_.insert(binary_buffer_.end(), r.tensor_name.begin(),
+                          r.tensor_name.end());
+  }
+  int op_idx = r.phase != 'E' ? InternBinaryString(r.op_name) : 0;
+  int args_idx = InternBinaryString(r.args);
+  binary_buffer_.push_back(BINARY_EVENT);
+  binary_buffer_.push_back(r.phase);
+  WriteVarint(tensor_idx);
+  WriteVarint(op_idx);
+  WriteVarint(args_idx);
+  WriteTimestampDelta(r.ts_micros);
+  if (binary_buffer_.size() >= BINARY_BUFFER_FLUSH_BYTES) {
+    FlushBinaryBuffer();
+  }
+}
+
+void TimelineWriter::DoWriteBinaryMarker(const TimelineRecord& r) {
+  assert(r.type == TimelineRecordType::MARKER);
+  if (is_new_file_) {
+    WriteBinaryHeader();
+    is_new_file_ = false;
+  }
+  int name_idx = InternBinaryString(r.marker_name);
+  binary_buffer_.push_back(BINARY_MARKER);
+  WriteVarint(name_idx);
+  WriteTimestampDelta(r.ts_micros);
+  if (binary_buffer_.size() >= BINARY_BUFFER_FLUSH_BYTES) {
+    FlushBinaryBuffer();
+  }
+}
+
+void TimelineWriter::FlushBinaryBuffer() {
+  if (binary_buffer_.empty()) {
+    return;
+  }
+  if (file_.is_open()) {
+    file_.write(binary_buffer_.data(), binary_buffer_.size());
+  }
+  binary_buffer_.clear();
+}
+
 void TimelineWriter::WriterLoop() {
+  PlaceHelperThread();
   while (healthy()) {
     while (healthy() && !record_queue_.empty()) {
       auto& r = record_queue_.front();
+      bool binary = file_format_ == TimelineFormat::BINARY;
       switch (r.type) {
       case TimelineRecordType::EVENT:
-        DoWriteEvent(r);
+        binary ? DoWriteBinaryEvent(r) : DoWriteEvent(r);
         break;
       case TimelineRecordType::MARKER:
-        DoWriteMarker(r);
+        binary ? DoWriteBinaryMarker(r) : DoWriteMarker(r);
         break;
       default:
         throw std::logic_error("Unknown event type provided.");
@@ -366,12 +509,14 @@ public:
   }
 
   void StartActivityRange(const std::string& tensor_name,
-                          const std::string& activity) {
+                          const std::string& activity,
+                          int64_t correlation_id = -1) {
     if (activity_domain_ == nullptr) {
       return;
     }
     const auto message = activity + " " + tensor_name;
-    nvtxRangeId_t range_id = NvtxStartDomainRange(activity_domain_, message);
+    nvtxRangeId_t range_id =
+        NvtxStartDomainRange(activity_domain_, message, correlation_id);
     activity_tensor_nvtx_range_.emplace(tensor_name, range_id);
   }
 
@@ -431,7 +576,8 @@ public:
                   int64_t tensor_size_payload = -1) {}
   void EndRange(const std::string& tensor_name) {}
   void StartActivityRange(const std::string& tensor_name,
-                          const std::string& activity) {}
+                          const std::string& activity,
+                          int64_t correlation_id = -1) {}
   void EndActivityRange(const std::string& tensor_name) {}
   void Disable() {}
 };
@@ -465,6 +611,7 @@ void Timeline::Shutdown() {
   initialized_.exchange(0);
   writer_.Shutdown();
   tensor_states_.clear();
+  unsampled_tensors_.clear();
 }
 
 Timeline::~Timeline() = default;
@@ -481,6 +628,9 @@ void Timeline::WriteEvent(const std::string& tensor_name, const char phase,
   if (!Initialized() || !writer_.active()) {
     return;
   }
+  if (sample_cycles_ > 1 && unsampled_tensors_.count(tensor_name) != 0) {
+    return;
+  }
   auto ts_micros = TimeSinceStartMicros();
   writer_.EnqueueWriteEvent(tensor_name, phase, op_name, args, ts_micros);
 }
@@ -495,7 +645,7 @@ void Timeline::WriteMarker(const std::string& name) {
 
 void Timeline::NegotiateStart(const std::string& tensor_name,
                               const Request::RequestType request_type) {
-  if (!Initialized() || !writer_.active()) {
+  if (!record_negotiation_ || !Initialized() || !writer_.active()) {
     return;
   }
 
@@ -511,6 +661,9 @@ void Timeline::NegotiateStart(const std::string& tensor_name,
   }
 
   assert(tensor_states_[tensor_name] == TimelineState::UNKNOWN);
+  if (!sampled_cycle_) {
+    unsampled_tensors_.insert(tensor_name);
+  }
   auto event_category = "NEGOTIATE_" + Request::RequestType_Name(request_type);
   nvtx_handle_->StartRange(tensor_name, event_category);
   WriteEvent(tensor_name, 'B', event_category);
@@ -519,7 +672,7 @@ void Timeline::NegotiateStart(const std::string& tensor_name,
 
 void Timeline::NegotiateRankReady(const std::string& tensor_name,
                                   const int rank) {
-  if (!Initialized() || !writer_.active()) {
+  if (!record_negotiation_ || !Initialized() || !writer_.active()) {
     return;
   }
 
@@ -529,7 +682,7 @@ void Timeline::NegotiateRankReady(const std::string& tensor_name,
 }
 
 void Timeline::NegotiateEnd(const std::string& tensor_name) {
-  if (!Initialized() || !writer_.active()) {
+  if (!record_negotiation_ || !Initialized() || !writer_.active()) {
     return;
   }
 
@@ -538,19 +691,28 @@ void Timeline::NegotiateEnd(const std::string& tensor_name) {
   nvtx_handle_->EndRange(tensor_name);
   WriteEvent(tensor_name, 'E');
   tensor_states_.erase(tensor_name);
+  unsampled_tensors_.erase(tensor_name);
 }
 
 void Timeline::Start(const std::string& tensor_name,
                      const Response::ResponseType response_type,
-                     int64_t tensor_size) {
+                     int64_t tensor_size, int64_t queue_time_us) {
   if (!Initialized() || !writer_.active()) {
     return;
   }
 
   std::lock_guard<std::recursive_mutex> guard(mutex_);
   assert(tensor_states_[tensor_name] == TimelineState::UNKNOWN);
+  if (!sampled_cycle_) {
+    unsampled_tensors_.insert(tensor_name);
+  }
   auto event_category = Response::ResponseType_Name(response_type);
-  WriteEvent(tensor_name, 'B', event_category);
+  if (queue_time_us >= 0) {
+    WriteEvent(tensor_name, 'B', event_category,
+               "\"queue_time_us\": " + std::to_string(queue_time_us));
+  } else {
+    WriteEvent(tensor_name, 'B', event_category);
+  }
   nvtx_handle_->StartRange(tensor_name, event_category, tensor_size);
   tensor_states_[tensor_name] = TimelineState::TOP_LEVEL;
 }
@@ -573,11 +735,30 @@ void Timeline::ActivityStart(const std::string& tensor_name,
 
   std::lock_guard<std::recursive_mutex> guard(mutex_);
   assert(tensor_states_[tensor_name] == TimelineState::TOP_LEVEL);
-  nvtx_handle_->StartActivityRange(tensor_name, activity);
-  WriteEvent(tensor_name, 'B', activity);
+  auto it = correlation_ids_.find(tensor_name);
+  if (it != correlation_ids_.end()) {
+    nvtx_handle_->StartActivityRange(tensor_name, activity, it->second);
+    WriteEvent(tensor_name, 'B', activity,
+               "\"correlation_id\": " + std::to_string(it->second));
+  } else {
+    nvtx_handle_->StartActivityRange(tensor_name, activity);
+    WriteEvent(tensor_name, 'B', activity);
+  }
   tensor_states_[tensor_name] = TimelineState::ACTIVITY;
 }
 
+void Timeline::SetCorrelationId(const std::vector<TensorTableEntry>& entries,
+                                int64_t correlation_id) {
+  if (!Initialized() || !writer_.active()) {
+    return;
+  }
+
+  std::lock_guard<std::recursive_mutex> guard(mutex_);
+  for (auto& e : entries) {
+    correlation_ids_[e.tensor_name] = correlation_id;
+  }
+}
+
 void Timeline::ActivityEndAll(const std::vector<TensorTableEntry>& entries) {
   for (auto& e : entries) {
     ActivityEnd(e.tensor_name);
@@ -618,6 +799,8 @@ void Timeline::End(const std::string& tensor_name,
   }
   WriteEvent(tensor_name, 'E', "", args.str());
   tensor_states_.erase(tensor_name);
+  unsampled_tensors_.erase(tensor_name);
+  correlation_ids_.erase(tensor_name);
 }
 
 void Timeline::MarkCycleStart() {
@@ -626,7 +809,35 @@ void Timeline::MarkCycleStart() {
   }
 
   std::lock_guard<std::recursive_mutex> guard(mutex_);
-  WriteMarker("CYCLE_START");
+  if (sampled_cycle_) {
+    WriteMarker("CYCLE_START");
+  }
+}
+
+void Timeline::StartCycle() {
+  if (sample_cycles_ <= 1 || !Initialized()) {
+    return;
+  }
+
+  std::lock_guard<std::recursive_mutex> guard(mutex_);
+  sampled_cycle_ = cycle_ % sample_cycles_ == 0;
+  ++cycle_;
+}
+
+void Timeline::SetFormat(TimelineFormat format) {
+  writer_.SetFormat(format);
+}
+
+void Timeline::DisableNegotiation() {
+  std::lock_guard<std::recursive_mutex> guard(mutex_);
+  record_negotiation_ = false;
+}
+
+void Timeline::SetSampleCycles(unsigned int sample_cycles) {
+  std::lock_guard<std::recursive_mutex> guard(mutex_);
+  sample_cycles_ = std::max(sample_cycles, 1u);
+  sampled_cycle_ = true;
+  cycle_ = 0;
 }
 
 void Timeline::SetPendingTimelineFile(const std::string& filename) {
@@ -638,6 +849,17 @@ void Timeline::DisableNvtx() {
   nvtx_handle_->Disable();
 }
 
+std::string RankTimelineFile(const std::string& file_name, int rank) {
+  auto slash = file_name.find_last_of('/');
+  auto dot = file_name.find_last_of('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash) ||
+      dot == (slash == std::string::npos ? 0 : slash + 1)) {
+    return file_name + "." + std::to_string(rank);
+  }
+  return file_name.substr(0, dot) + "." + std::to_string(rank) +
+         file_name.substr(dot);
+}
+
 void TimelineController::SetTimelineEnabled(bool value) {
   std::lock_guard<std::recursive_mutex> guard(timeline_mutex_);
   timeline_enabled_pending_ = value;
@@ -23,6 +23,7 @@
 #include <mutex>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <boost/lockfree/spsc_queue.hpp>
@@ -35,6 +36,11 @@ namespace common {
 
 enum TimelineRecordType { EVENT, MARKER };
 
+// JSON is the Chrome Tracing format. BINARY interns tensor names and strings
+// and delta-encodes timestamps, see timeline_converter.py for the layout and
+// the conversion to JSON.
+enum class TimelineFormat { JSON, BINARY };
+
 struct TimelineRecord {
   TimelineRecordType type;
   std::string tensor_name;
@@ -55,6 +61,8 @@ public:
                          long ts_micros);
   void EnqueueWriteMarker(const std::string& name, long ts_micros);
   void SetPendingTimelineFile(const std::string& filename);
+  // Applies to files opened afterwards.
+  void SetFormat(TimelineFormat format);
   short active();
   short healthy();
   TimelineWriter();
@@ -68,6 +76,14 @@ private:
   void DoWriteMarker(const TimelineRecord& r);
   void WriterLoop();
   void WriteAtFileStart();
+  void DoWriteBinaryEvent(const TimelineRecord& r);
+  void DoWriteBinaryMarker(const TimelineRecord& r);
+  void WriteBinaryHeader();
+  int InternBinaryString(const std::string& value);
+  void WriteVarint(uint64_t value);
+  void WriteTimestampDelta(long ts_micros);
+  void FlushBinaryBuffer();
+  void CloseFile();
   std::string PendingTimelineFile();
   void SetTimelineFile(const std::string& filename);
 
@@ -89,6 +105,20 @@ private:
   // timeline file.
   std::unordered_map<std::string, int> tensor_table_;
 
+  // Requested format, and the format of the open file.
+  TimelineFormat format_ = TimelineFormat::JSON;
+  TimelineFormat file_format_ = TimelineFormat::JSON;
+
+  // Binary format only: interned operation names, markers and arguments,
+  // the timestamp of the previous record and the pending output. The buffer
+  // is written to the file in one call once it reaches
+  // BINARY_BUFFER_FLUSH_BYTES.
+  std::unordered_map<std::string, int> string_table_;
+  long last_ts_micros_ = 0;
+  std::vector<char> binary_buffer_;
+  static constexpr size_t BINARY_BUFFER_FLUSH_BYTES = 4 * 1024 * 1024;
+  static constexpr size_t MAX_BINARY_STRINGS = 1 << 16;
+
   std::thread writer_thread_;
   std::string cur_filename_;
   std::string new_pending_filename_;
@@ -116,20 +146,37 @@ public:
                       Request::RequestType request_type);
   void NegotiateRankReady(const std::string& tensor_name, int rank);
   void NegotiateEnd(const std::string& tensor_name);
+  // queue_time_us is the time the tensor waited since it was enqueued, if
+  // known.
   void Start(const std::string& tensor_name,
              Response::ResponseType response_type,
-             int64_t tensor_size = -1);
+             int64_t tensor_size = -1, int64_t queue_time_us = -1);
   void ActivityStartAll(const std::vector<TensorTableEntry>& entries,
                         const std::string& activity);
   void ActivityStart(const std::string& tensor_name,
                      const std::string& activity);
   void ActivityEndAll(const std::vector<TensorTableEntry>& entries);
+  // Tags the following activities of the entries, until they end, with the
+  // correlation ID that the NVTX phase ranges of their operation carry as
+  // payload.
+  void SetCorrelationId(const std::vector<TensorTableEntry>& entries,
+                        int64_t correlation_id);
   void ActivityEnd(const std::string& tensor_name);
   void End(const std::string& tensor_name,
            const std::shared_ptr<Tensor>& output_tensor);
   void MarkCycleStart();
+  // Called by the background thread at the start of every cycle, whether or
+  // not cycles are marked.
+  void StartCycle();
   void SetPendingTimelineFile(const std::string& filename);
   void DisableNvtx();
+  void SetFormat(TimelineFormat format);
+  // Negotiation is only known to the coordinator, the timelines of other
+  // ranks leave it out.
+  void DisableNegotiation();
+  // Only operations that start in one of every sample_cycles cycles are
+  // recorded, each of them from start to end.
+  void SetSampleCycles(unsigned int sample_cycles);
 
 private:
   long TimeSinceStartMicros() const;
@@ -155,6 +202,18 @@ private:
   // Current state of each tensor in the timeline.
   std::unordered_map<std::string, TimelineState> tensor_states_;
 
+  // Correlation ID of the operation each tensor is in, if set.
+  std::unordered_map<std::string, int64_t> correlation_ids_;
+
+  // Step sampling: tensors that started in a cycle that is not recorded are
+  // skipped until they are back in the UNKNOWN state.
+  bool record_negotiation_ = true;
+
+  unsigned int sample_cycles_ = 1;
+  uint64_t cycle_ = 0;
+  bool sampled_cycle_ = true;
+  std::unordered_set<std::string> unsampled_tensors_;
+
   // Map of ranks to their string representations.
   // std::to_string() is very slow.
   std::vector<std::string> rank_strings_;
@@ -162,6 +221,10 @@ private:
   std::unique_ptr<TimelineNvtxHandle> nvtx_handle_;
 };
 
+// Name of the timeline file of a rank when every rank writes one, e.g.
+// timeline.3.json for timeline.json.
+std::string RankTimelineFile(const std::string& file_name, int rank);
+
 class TimelineController {
 public:
   TimelineController() = default;
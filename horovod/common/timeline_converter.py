@@ -0,0 +1,155 @@
+# Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# =============================================================================
+"""Converts a timeline written with HOROVOD_TIMELINE_FORMAT=binary to the
+Chrome Tracing JSON format of the default timeline.
+
+Usage: python -m horovod.common.timeline_converter timeline.bin timeline.json
+"""
+
+import argparse
+import json
+import sys
+
+MAGIC = b'HVDTL\x01\x00\x00'
+
+BINARY_TENSOR = 1
+BINARY_STRING = 2
+BINARY_EVENT = 3
+BINARY_MARKER = 4
+
+
+class _Reader(object):
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def done(self):
+        return self.pos >= len(self.data)
+
+    def byte(self):
+        value = self.data[self.pos]
+        self.pos += 1
+        return value
+
+    def varint(self):
+        result = 0
+        shift = 0
+        while True:
+            b = self.byte()
+            result |= (b & 0x7f) << shift
+            if b < 0x80:
+                return result
+            shift += 7
+
+    def timestamp_delta(self):
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def bytes(self, length):
+        value = self.data[self.pos:self.pos + length]
+        if len(value) != length:
+            raise IndexError('truncated record')
+        self.pos += length
+        return value.decode('utf-8', errors='replace')
+
+
+def read_binary_timeline(data):
+    """Yields the events of a binary timeline as dictionaries in the Chrome
+    Tracing format, beginning with the process metadata of the JSON timeline.
+
+    A timeline that was cut short, e.g. because the job was killed, is decoded
+    up to its last complete record.
+    """
+    if not data.startswith(MAGIC):
+        raise ValueError('not a binary Horovod timeline')
+    reader = _Reader(data)
+    reader.pos = len(MAGIC)
+    start_time = reader.varint()
+    yield {'name': 'process_name', 'ph': 'M', 'pid': 0,
+           'args': {'start_time_since_epoch_in_micros': start_time}}
+    yield {'name': 'process_sort_index', 'ph': 'M', 'pid': 0,
+           'args': {'sort_index': 0}}
+
+    tensors = {}
+    strings = {0: ''}
+    announced = set()
+    ts = 0
+    while not reader.done():
+        try:
+            record_type = reader.byte()
+            if record_type == BINARY_TENSOR:
+                idx = reader.varint()
+                tensors[idx] = reader.bytes(reader.varint())
+            elif record_type == BINARY_STRING:
+                idx = reader.varint()
+                strings[idx] = reader.bytes(reader.varint())
+            elif record_type == BINARY_EVENT:
+                phase = chr(reader.byte())
+                tensor_idx = reader.varint()
+                op_name = strings[reader.varint()]
+                args = strings[reader.varint()]
+                ts += reader.timestamp_delta()
+                if tensor_idx not in announced:
+                    announced.add(tensor_idx)
+                    yield {'name': 'process_name', 'ph': 'M', 'pid': tensor_idx,
+                           'args': {'name': tensors[tensor_idx]}}
+                    yield {'name': 'process_sort_index', 'ph': 'M', 'pid': tensor_idx,
+                           'args': {'sort_index': tensor_idx}}
+                event = {'ph': phase}
+                if phase != 'E':
+                    event['name'] = op_name
+                event['ts'] = ts
+                event['pid'] = tensor_idx
+                if phase == 'X':
+                    event['dur'] = 0
+                if args:
+                    event['args'] = json.loads('{' + args + '}')
+                yield event
+            elif record_type == BINARY_MARKER:
+                name = strings[reader.varint()]
+                ts += reader.timestamp_delta()
+                yield {'ph': 'i', 'name': name, 'ts': ts, 's': 'g'}
+            else:
+                raise ValueError('unknown record type {} at offset {}'
+                                 .format(record_type, reader.pos - 1))
+        except IndexError:
+            return
+
+
+def convert(input_path, output_path):
+    with open(input_path, 'rb') as f:
+        data = f.read()
+    with open(output_path, 'w') as out:
+        out.write('[\n')
+        first = True
+        for event in read_binary_timeline(data):
+            if not first:
+                out.write(',\n')
+            out.write(json.dumps(event))
+            first = False
+        out.write(']\n')
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(
+        description='Convert a binary Horovod timeline to Chrome Tracing JSON.')
+    parser.add_argument('input', help='timeline written with HOROVOD_TIMELINE_FORMAT=binary')
+    parser.add_argument('output', help='JSON file to write')
+    args = parser.parse_args(argv)
+    convert(args.input, args.output)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
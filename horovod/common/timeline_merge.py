@@ -0,0 +1,208 @@
+# Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# =============================================================================
+"""Merges the timelines written by every rank with HOROVOD_TIMELINE_ALL_RANKS=1
+into one Chrome Tracing file with a process per rank, and reports which ranks
+delayed the collective operations.
+
+Usage: python -m horovod.common.timeline_merge timeline.*.json -o merged.json
+
+A rank delays an operation when it enqueues its tensor after the other ranks,
+since nobody can complete the collective before it arrives. For every operation
+that appears on all ranks, the lateness of a rank is the time between the first
+rank and this rank enqueuing the tensor.
+"""
+
+import argparse
+import json
+import re
+import statistics
+import sys
+
+from horovod.common.timeline_converter import MAGIC, read_binary_timeline
+
+_RANK_PATTERN = re.compile(r'\.(\d+)(\.[^./]*)?$')
+
+
+def load_timeline(path):
+    """Returns the events of a JSON or binary timeline file."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data.startswith(MAGIC):
+        return list(read_binary_timeline(data))
+    return json.loads(data.decode('utf-8'))
+
+
+def rank_of(path, default):
+    match = _RANK_PATTERN.search(path)
+    return int(match.group(1)) if match else default
+
+
+def _start_time(events):
+    for event in events:
+        if event.get('ph') == 'M' and event.get('pid') == 0 and \
+                'start_time_since_epoch_in_micros' in event.get('args', {}):
+            return event['args']['start_time_since_epoch_in_micros']
+    return 0
+
+
+def collect_operations(events):
+    """Returns a dictionary from (tensor name, occurrence) to the start, end
+    and queue time of each operation of a single rank timeline."""
+    names = {}
+    depth = {}
+    open_ops = {}
+    counts = {}
+    operations = {}
+    for event in events:
+        if event.get('ph') == 'M':
+            if event.get('name') == 'process_name' and 'name' in event.get('args', {}):
+                names[event['pid']] = event['args']['name']
+            continue
+        pid = event.get('pid')
+        if pid not in names:
+            continue
+        phase = event['ph']
+        if phase == 'B':
+            level = depth.get(pid, 0)
+            depth[pid] = level + 1
+            if level == 0 and not event['name'].startswith('NEGOTIATE_'):
+                queue_time = event.get('args', {}).get('queue_time_us', 0)
+                open_ops[pid] = {'op': event['name'], 'start': event['ts'],
+                                 'enqueue': event['ts'] - queue_time}
+        elif phase == 'E':
+            depth[pid] = max(depth.get(pid, 0) - 1, 0)
+            if depth[pid] == 0 and pid in open_ops:
+                op = open_ops.pop(pid)
+                op['end'] = event['ts']
+                name = names[pid]
+                occurrence = counts.get(name, 0)
+                counts[name] = occurrence + 1
+                operations[(name, occurrence)] = op
+    return operations
+
+
+def straggler_stats(operations_by_rank):
+    """Aggregates the lateness of every rank over the operations found on all
+    ranks. Returns a dictionary from rank to its statistics."""
+    ranks = sorted(operations_by_rank)
+    common = set.intersection(*[set(ops) for ops in operations_by_rank.values()])
+    lateness = {rank: [] for rank in ranks}
+    durations = {rank: [] for rank in ranks}
+    times_last = {rank: 0 for rank in ranks}
+    waited = {rank: 0.0 for rank in ranks}
+    for key in common:
+        enqueues = {rank: operations_by_rank[rank][key]['enqueue'] for rank in ranks}
+        first = min(enqueues.values())
+        last_rank = max(ranks, key=lambda r: enqueues[r])
+        median = statistics.median(enqueues.values())
+        times_last[last_rank] += 1
+        waited[last_rank] += enqueues[last_rank] - median
+        for rank in ranks:
+            op = operations_by_rank[rank][key]
+            lateness[rank].append(enqueues[rank] - first)
+            durations[rank].append(op['end'] - op['start'])
+
+    stats = {}
+    for rank in ranks:
+        stats[rank] = {
+            'operations': len(common),
+            'times_last': times_last[rank],
+            'mean_lateness_us': statistics.mean(lateness[rank]) if common else 0,
+            'max_lateness_us': max(lateness[rank]) if common else 0,
+            # Time the median rank waited for this rank when it arrived last.
+            'delay_caused_us': waited[rank],
+            'mean_duration_us': statistics.mean(durations[rank]) if common else 0,
+        }
+    return stats
+
+
+def merge(timelines, align='barrier'):
+    """Merges {rank: events} into a single list of events, with one process per
+    rank and one thread per tensor.
+
+    With align='barrier' the timestamps are used as recorded, since every rank
+    starts its clock after a common barrier. With align='epoch' they are shifted
+    by the difference of the wall clock start times, for timelines that were not
+    started together.
+    """
+    ranks = sorted(timelines)
+    base = _start_time(timelines[ranks[0]])
+    merged = []
+    for rank in ranks:
+        events = timelines[rank]
+        offset = _start_time(events) - base if align == 'epoch' else 0
+        merged.append({'name': 'process_name', 'ph': 'M', 'pid': rank,
+                       'args': {'name': 'rank {}'.format(rank)}})
+        merged.append({'name': 'process_sort_index', 'ph': 'M', 'pid': rank,
+                       'args': {'sort_index': rank}})
+        for event in events:
+            if event.get('ph') == 'M':
+                if event.get('pid', 0) != 0 and event.get('name') == 'process_name':
+                    merged.append({'name': 'thread_name', 'ph': 'M', 'pid': rank,
+                                   'tid': event['pid'], 'args': event['args']})
+                continue
+            event = dict(event)
+            event['ts'] = event['ts'] + offset
+            if event['ph'] == 'i':
+                event['pid'] = rank
+                event['s'] = 'p'
+            else:
+                event['tid'] = event['pid']
+                event['pid'] = rank
+            merged.append(event)
+    return merged
+
+
+def format_stats(stats):
+    lines = ['{:>6} {:>10} {:>10} {:>16} {:>15} {:>18} {:>15}'.format(
+        'rank', 'ops', 'last', 'mean late (us)', 'max late (us)',
+        'delay caused (us)', 'mean dur (us)')]
+    for rank in sorted(stats, key=lambda r: -stats[r]['delay_caused_us']):
+        s = stats[rank]
+        lines.append('{:>6} {:>10} {:>10} {:>16.1f} {:>15.1f} {:>18.1f} {:>15.1f}'.format(
+            rank, s['operations'], s['times_last'], s['mean_lateness_us'],
+            s['max_lateness_us'], s['delay_caused_us'], s['mean_duration_us']))
+    return '\n'.join(lines)
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(
+        description='Merge per-rank Horovod timelines and report stragglers.')
+    parser.add_argument('timelines', nargs='+',
+                        help='timeline of every rank, e.g. timeline.0.json timeline.1.json')
+    parser.add_argument('-o', '--output', help='merged Chrome Tracing JSON file to write')
+    parser.add_argument('--stats', help='JSON file to write the straggler statistics to')
+    parser.add_argument('--align', choices=['barrier', 'epoch'], default='barrier',
+                        help='how timestamps of different ranks are aligned (default: barrier)')
+    args = parser.parse_args(argv)
+
+    timelines = {}
+    for i, path in enumerate(args.timelines):
+        timelines[rank_of(path, i)] = load_timeline(path)
+
+    if args.output:
+        with open(args.output, 'w') as out:
+            json.dump(merge(timelines, args.align), out)
+
+    stats = straggler_stats({rank: collect_operations(events)
+                             for rank, events in timelines.items()})
+    print(format_stats(stats))
+    if args.stats:
+        with open(args.stats, 'w') as out:
+            json.dump({str(rank): s for rank, s in stats.items()}, out, indent=2)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,366 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "topology.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "logging.h"
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+// Set by SetHelperThreadPlacement().
+std::mutex helper_placement_mutex;
+std::vector<int> helper_cpus;
+int helper_node = -1;
+
+// Set by PreferNumaNode().
+thread_local int preferred_node = -1;
+
+} // namespace
+
+int PreferredNumaNode() { return preferred_node; }
+
+void SetHelperThreadPlacement(const std::vector<int>& cpus, int node) {
+  std::lock_guard<std::mutex> guard(helper_placement_mutex);
+  helper_cpus = cpus;
+  helper_node = node;
+}
+
+#ifdef __linux__
+namespace {
+
+bool ReadLine(const std::string& path, std::string& line) {
+  std::ifstream file(path);
+  return file && std::getline(file, line);
+}
+
+// Names of the entries of dir, other than "." and "..".
+std::vector<std::string> ListDir(const std::string& dir) {
+  std::vector<std::string> names;
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    return names;
+  }
+  while (auto* entry = readdir(d)) {
+    std::string name = entry->d_name;
+    if (name != "." && name != "..") {
+      names.push_back(name);
+    }
+  }
+  closedir(d);
+  return names;
+}
+
+// Parses a list like "0-3,8-11".
+std::vector<int> ParseCpuList(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first
+                                         : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+// NUMA nodes of the devices in class_dir, like /sys/class/infiniband.
+std::set<int> DeviceNodes(const std::string& class_dir) {
+  std::set<int> nodes;
+  for (auto& name : ListDir(class_dir)) {
+    std::string line;
+    // Virtual interfaces have no device and so no numa_node.
+    if (ReadLine(class_dir + "/" + name + "/device/numa_node", line)) {
+      int node = std::stoi(line);
+      // -1 on hosts without NUMA.
+      nodes.insert(std::max(node, 0));
+    }
+  }
+  return nodes;
+}
+
+// Ports of the RDMA device in /sys/class/infiniband/name that are up.
+std::vector<std::string> ActivePorts(const std::string& name) {
+  std::vector<std::string> ports;
+  auto dir = "/sys/class/infiniband/" + name + "/ports";
+  for (auto& port : ListDir(dir)) {
+    std::string state;
+    // Like "4: ACTIVE".
+    if (ReadLine(dir + "/" + port + "/state", state) &&
+        state.find("ACTIVE") != std::string::npos) {
+      ports.push_back(port);
+    }
+  }
+  std::sort(ports.begin(), ports.end());
+  return ports;
+}
+
+std::vector<int> AllowedCpus() {
+  std::vector<int> cpus;
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) != 0) {
+    return cpus;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &cpuset)) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+// NUMA node all of cpus belong to, or -1 if they span several.
+int NodeOfCpus(const HostTopology& topology, const std::vector<int>& cpus) {
+  for (auto& node : topology.node_cpus) {
+    auto& node_cpus = node.second;
+    if (!cpus.empty() &&
+        std::all_of(cpus.begin(), cpus.end(), [&](int cpu) {
+          return std::binary_search(node_cpus.begin(), node_cpus.end(), cpu);
+        })) {
+      return node.first;
+    }
+  }
+  return -1;
+}
+
+} // namespace
+
+HostTopology DiscoverHostTopology() {
+  HostTopology topology;
+  const std::string node_dir = "/sys/devices/system/node";
+  for (auto& name : ListDir(node_dir)) {
+    std::string line;
+    if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+        !std::all_of(name.begin() + 4, name.end(), ::isdigit) ||
+        !ReadLine(node_dir + "/" + name + "/cpulist", line)) {
+      continue;
+    }
+    auto cpus = ParseCpuList(line);
+    std::sort(cpus.begin(), cpus.end());
+    if (!cpus.empty()) {
+      topology.node_cpus[std::stoi(name.substr(4))] = std::move(cpus);
+    }
+  }
+
+  for (auto& name : ListDir("/sys/class/infiniband")) {
+    std::string line;
+    int node = 0;
+    if (ReadLine("/sys/class/infiniband/" + name + "/device/numa_node",
+                 line)) {
+      node = std::max(std::stoi(line), 0);
+    }
+    for (auto& port : ActivePorts(name)) {
+      topology.rdma_devices.push_back(RdmaDevice{name + ":" + port, node});
+    }
+  }
+  std::sort(topology.rdma_devices.begin(), topology.rdma_devices.end(),
+            [](const RdmaDevice& a, const RdmaDevice& b) {
+              return a.node != b.node ? a.node < b.node : a.name < b.name;
+            });
+
+  auto nic_nodes = DeviceNodes("/sys/class/infiniband");
+  if (nic_nodes.empty()) {
+    nic_nodes = DeviceNodes("/sys/class/net");
+  }
+  for (int node : nic_nodes) {
+    // Ignore NICs of nodes without CPUs.
+    if (topology.node_cpus.count(node) > 0) {
+      topology.nic_nodes.push_back(node);
+    }
+  }
+  return topology;
+}
+
+int NicNumaNode(const HostTopology& topology, int local_rank) {
+  if (topology.node_cpus.empty()) {
+    return -1;
+  }
+  int bound_node = NodeOfCpus(topology, AllowedCpus());
+  if (bound_node >= 0) {
+    return bound_node;
+  }
+  if (!topology.nic_nodes.empty()) {
+    return topology.nic_nodes[local_rank % topology.nic_nodes.size()];
+  }
+  auto it = topology.node_cpus.begin();
+  std::advance(it, local_rank % topology.node_cpus.size());
+  return it->first;
+}
+
+int PickThreadCore(const HostTopology& topology, int local_rank) {
+  int node = NicNumaNode(topology, local_rank);
+  if (node < 0) {
+    return -1;
+  }
+  auto& node_cpus = topology.node_cpus.at(node);
+  std::vector<int> cpus;
+  for (int cpu : AllowedCpus()) {
+    if (std::binary_search(node_cpus.begin(), node_cpus.end(), cpu)) {
+      cpus.push_back(cpu);
+    }
+  }
+  if (cpus.empty()) {
+    return -1;
+  }
+  if (cpus.size() < node_cpus.size()) {
+    // Bound by the launcher, the cores are this rank's alone.
+    return cpus.back();
+  }
+  // Local ranks that share the node are every nic_nodes.size()-th one.
+  size_t sharing = std::max<size_t>(topology.nic_nodes.size(), 1);
+  return cpus[cpus.size() - 1 - (local_rank / sharing) % cpus.size()];
+}
+
+std::string PickRailDevice(const HostTopology& topology, int local_rank) {
+  auto& devices = topology.rdma_devices;
+  if (devices.empty()) {
+    return "";
+  }
+  int bound_node = NodeOfCpus(topology, AllowedCpus());
+  std::vector<std::string> names;
+  for (auto& device : devices) {
+    if (device.node == bound_node) {
+      names.push_back(device.name);
+    }
+  }
+  if (!names.empty()) {
+    return names[local_rank % names.size()];
+  }
+  return devices[local_rank % devices.size()].name;
+}
+
+bool RunsNextToNic(const HostTopology& topology) {
+  auto cpus = AllowedCpus();
+  if (cpus.empty() || topology.nic_nodes.empty()) {
+    return false;
+  }
+  return std::all_of(cpus.begin(), cpus.end(), [&](int cpu) {
+    return std::any_of(
+        topology.nic_nodes.begin(), topology.nic_nodes.end(), [&](int node) {
+          auto& node_cpus = topology.node_cpus.at(node);
+          return std::binary_search(node_cpus.begin(), node_cpus.end(), cpu);
+        });
+  });
+}
+
+void PreferNumaNode(int node) {
+  preferred_node = node;
+  const size_t bits = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> mask(node < 0 ? 1 : node / bits + 1, 0);
+  if (node >= 0) {
+    mask[node / bits] |= 1UL << (node % bits);
+  }
+  // The kernel reads one bit less than maxnode.
+  if (syscall(SYS_set_mempolicy, node < 0 ? MPOL_DEFAULT : MPOL_PREFERRED,
+              node < 0 ? nullptr : mask.data(), mask.size() * bits + 1) != 0) {
+    LOG(DEBUG) << "Failed to prefer NUMA node " << node;
+  }
+}
+
+int NumaNodeOfCpu(const HostTopology& topology, int cpu) {
+  return NodeOfCpus(topology, {cpu});
+}
+
+std::vector<int> AllowedNodeCpus(const HostTopology& topology, int node) {
+  std::vector<int> cpus;
+  auto it = topology.node_cpus.find(node);
+  if (it == topology.node_cpus.end()) {
+    return cpus;
+  }
+  for (int cpu : AllowedCpus()) {
+    if (std::binary_search(it->second.begin(), it->second.end(), cpu)) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+void PlaceHelperThread() {
+  std::vector<int> cpus;
+  int node;
+  {
+    std::lock_guard<std::mutex> guard(helper_placement_mutex);
+    cpus = helper_cpus;
+    node = helper_node;
+  }
+  if (!cpus.empty()) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (int cpu : cpus) {
+      CPU_SET(cpu, &cpuset);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) !=
+        0) {
+      LOG(DEBUG) << "Failed to set the affinity of a helper thread";
+    }
+  }
+  if (node >= 0) {
+    PreferNumaNode(node);
+  }
+}
+
+#else
+HostTopology DiscoverHostTopology() { return HostTopology(); }
+
+int NicNumaNode(const HostTopology& topology, int local_rank) { return -1; }
+
+int PickThreadCore(const HostTopology& topology, int local_rank) { return -1; }
+
+std::string PickRailDevice(const HostTopology& topology, int local_rank) {
+  return "";
+}
+
+bool RunsNextToNic(const HostTopology& topology) { return false; }
+
+void PreferNumaNode(int node) { preferred_node = node; }
+
+int NumaNodeOfCpu(const HostTopology& topology, int cpu) { return -1; }
+
+std::vector<int> AllowedNodeCpus(const HostTopology& topology, int node) {
+  return {};
+}
+
+void PlaceHelperThread() {}
+#endif
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,95 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_TOPOLOGY_H
+#define HOROVOD_TOPOLOGY_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace horovod {
+namespace common {
+
+struct RdmaDevice {
+  // Device and port, like "mlx5_0:1".
+  std::string name;
+  int node;
+};
+
+// Locality of the CPUs and NICs of this host, read from /sys. Empty where it
+// cannot be discovered, like on macOS.
+struct HostTopology {
+  // CPUs of every NUMA node, keyed by node.
+  std::map<int, std::vector<int>> node_cpus;
+
+  // NUMA nodes with at least one NIC attached, ascending. RDMA devices are
+  // preferred, network interfaces are only looked at if there are none.
+  std::vector<int> nic_nodes;
+
+  // Active ports of the RDMA devices, ordered by NUMA node and name.
+  std::vector<RdmaDevice> rdma_devices;
+};
+
+HostTopology DiscoverHostTopology();
+
+// NUMA node of the NIC local_rank should use: the node it is bound to if the
+// launcher bound it to one, otherwise the NIC nodes are shared out by local
+// rank. -1 if the topology is unknown.
+int NicNumaNode(const HostTopology& topology, int local_rank);
+
+// Core to pin the background thread of local_rank to, on its NIC NUMA node
+// and within the CPUs the calling thread may run on. Local ranks sharing a
+// node get different cores, counting down from its last one, as the first
+// cores tend to be busy with framework threads. -1 if there is none.
+int PickThreadCore(const HostTopology& topology, int local_rank);
+
+// RDMA device port local_rank sends its cross-node traffic over, so that the
+// same local rank of every host uses the same rail: one on the node the
+// launcher bound it to, otherwise the ports are shared out by local rank in
+// order. Empty if there is none.
+std::string PickRailDevice(const HostTopology& topology, int local_rank);
+
+// Whether the calling thread only runs on CPUs of NUMA nodes with a NIC.
+bool RunsNextToNic(const HostTopology& topology);
+
+// Makes the calling thread place the memory it touches first on node if it
+// can, or anywhere again for -1.
+void PreferNumaNode(int node);
+
+// Node the calling thread last preferred with PreferNumaNode(), or -1.
+int PreferredNumaNode();
+
+// NUMA node of cpu, or -1 if the topology is unknown.
+int NumaNodeOfCpu(const HostTopology& topology, int cpu);
+
+// CPUs of node the calling thread may run on, ascending.
+std::vector<int> AllowedNodeCpus(const HostTopology& topology, int node);
+
+// Makes the helper threads of Horovod, like thread pools, completion loops and
+// the timeline writer, run on cpus and place the memory they touch first on
+// node once they call PlaceHelperThread(). Empty cpus and node -1 leave them
+// where they are.
+void SetHelperThreadPlacement(const std::vector<int>& cpus, int node);
+
+// Places the calling thread as set by SetHelperThreadPlacement(). Called by
+// every helper thread when it starts, as threads otherwise inherit the single
+// core of the background thread that creates most of them.
+void PlaceHelperThread();
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_TOPOLOGY_H
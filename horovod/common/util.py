@@ -235,8 +235,7 @@ def get_average_backwards_compatibility_fun(reduce_ops):
 def num_rank_is_power_2(num_rank):
     """
     Tests if the given number of ranks is of power of 2. This check is required
-    for Adasum allreduce.
-    TODO support non-power of 2 ranks.
+    for GPU Adasum allreduce, which runs over the nodes.
     """
     return num_rank != 0 and ((num_rank & (num_rank -1)) == 0)
 
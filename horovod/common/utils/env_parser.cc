@@ -117,6 +117,36 @@ const char* ParseGlooIface() {
   return gloo_iface;
 }
 
+std::string ParseFusionCompressionFromEnv() {
+  // Checked against the registered compressors when the GPU operations are
+  // created, which libraries may add to.
+  const char* user_compression = std::getenv(HOROVOD_FUSION_COMPRESSION);
+  if (user_compression == nullptr || *user_compression == '\0') {
+    return "none";
+  }
+  return user_compression;
+}
+
+FusionCompression ParseHierarchicalAllreduceCompressionFromEnv() {
+  FusionCompression compression = FusionCompression::NONE;
+  const char* user_compression =
+      std::getenv(HOROVOD_HIERARCHICAL_ALLREDUCE_COMPRESSION);
+  if (user_compression != nullptr) {
+    if (strcasecmp(user_compression, "none") == 0) {
+      compression = FusionCompression::NONE;
+    } else if (strcasecmp(user_compression, "fp16") == 0) {
+      compression = FusionCompression::FP16;
+    } else if (strcasecmp(user_compression, "bf16") == 0) {
+      compression = FusionCompression::BF16;
+    } else {
+      throw std::runtime_error("Unsupported hierarchical allreduce "
+                               "compression, only none, fp16 and bf16 are "
+                               "supported");
+    }
+  }
+  return compression;
+}
+
 void ParseStallInspectorFromEnv(StallInspector& stall_inspector) {
   auto env_value = std::getenv(HOROVOD_STALL_CHECK_DISABLE);
   if (env_value != nullptr && std::strtol(env_value, nullptr, 10) > 0) {
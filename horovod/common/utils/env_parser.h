@@ -17,6 +17,7 @@
 #define HOROVOD_ENV_PARSER_H
 
 #include <iostream>
+#include <string>
 
 #include "../stall_inspector.h"
 
@@ -25,6 +26,10 @@ namespace common {
 
 enum class LibType { MPI = 0, CCL = 1, GLOO = 2 };
 
+// Lossy compression of the cross node data of float32 hierarchical
+// allreduces.
+enum class FusionCompression { NONE = 0, FP16 = 1, BF16 = 2 };
+
 std::string TypeName(LibType type);
 
 LibType ParseCPUOpsFromEnv();
@@ -33,6 +38,12 @@ LibType ParseControllerOpsFromEnv();
 
 const char* ParseGlooIface();
 
+// Returns the name of the compressor of fused GPU allreduce data, see
+// CreateGPUFusionCompressor(), "none" if it is not set.
+std::string ParseFusionCompressionFromEnv();
+
+FusionCompression ParseHierarchicalAllreduceCompressionFromEnv();
+
 void ParseStallInspectorFromEnv(StallInspector& stall_inspector);
 
 void SetBoolFromEnv(const char* env, bool& val, bool value_if_set);
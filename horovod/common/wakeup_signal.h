@@ -0,0 +1,56 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_WAKEUP_SIGNAL_H
+#define HOROVOD_WAKEUP_SIGNAL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace horovod {
+namespace common {
+
+// Lets framework threads wake the background thread as soon as new work has
+// been enqueued, instead of waiting for the end of the current cycle.
+class WakeupSignal {
+public:
+  void Notify() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      pending_ = true;
+    }
+    cond_.notify_one();
+  }
+
+  // Blocks until Notify() has been called since the last wait, or until
+  // deadline is reached. Returns true if woken by a notification.
+  bool WaitUntil(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool notified = cond_.wait_until(lock, deadline, [this] { return pending_; });
+    pending_ = false;
+    return notified;
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool pending_ = false;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_WAKEUP_SIGNAL_H
@@ -45,11 +45,12 @@ enum DataType {
   DataType_HOROVOD_FLOAT32 = 7,
   DataType_HOROVOD_FLOAT64 = 8,
   DataType_HOROVOD_BOOL = 9,
+  DataType_HOROVOD_BFLOAT16 = 10,
   DataType_MIN = DataType_HOROVOD_UINT8,
-  DataType_MAX = DataType_HOROVOD_BOOL
+  DataType_MAX = DataType_HOROVOD_BFLOAT16
 };
 
-inline const DataType (&EnumValuesDataType())[10] {
+inline const DataType (&EnumValuesDataType())[11] {
   static const DataType values[] = {
     DataType_HOROVOD_UINT8,
     DataType_HOROVOD_INT8,
@@ -60,13 +61,14 @@ inline const DataType (&EnumValuesDataType())[10] {
     DataType_HOROVOD_FLOAT16,
     DataType_HOROVOD_FLOAT32,
     DataType_HOROVOD_FLOAT64,
-    DataType_HOROVOD_BOOL
+    DataType_HOROVOD_BOOL,
+    DataType_HOROVOD_BFLOAT16
   };
   return values;
 }
 
 inline const char * const *EnumNamesDataType() {
-  static const char * const names[11] = {
+  static const char * const names[12] = {
     "HOROVOD_UINT8",
     "HOROVOD_INT8",
     "HOROVOD_UINT16",
@@ -77,13 +79,14 @@ inline const char * const *EnumNamesDataType() {
     "HOROVOD_FLOAT32",
     "HOROVOD_FLOAT64",
     "HOROVOD_BOOL",
+    "HOROVOD_BFLOAT16",
     nullptr
   };
   return names;
 }
 
 inline const char *EnumNameDataType(DataType e) {
-  if (e < DataType_HOROVOD_UINT8 || e > DataType_HOROVOD_BOOL) return "";
+  if (e < DataType_HOROVOD_UINT8 || e > DataType_HOROVOD_BFLOAT16) return "";
   const size_t index = static_cast<size_t>(e);
   return EnumNamesDataType()[index];
 }
@@ -93,33 +96,48 @@ enum RequestType {
   RequestType_ALLGATHER = 1,
   RequestType_BROADCAST = 2,
   RequestType_JOIN = 3,
+  RequestType_ADASUM = 4,
+  RequestType_ALLTOALL = 5,
+  RequestType_REDUCESCATTER = 6,
+  RequestType_REDUCE = 7,
+  RequestType_GATHER = 8,
   RequestType_MIN = RequestType_ALLREDUCE,
-  RequestType_MAX = RequestType_JOIN
+  RequestType_MAX = RequestType_GATHER
 };
 
-inline const RequestType (&EnumValuesRequestType())[4] {
+inline const RequestType (&EnumValuesRequestType())[9] {
   static const RequestType values[] = {
     RequestType_ALLREDUCE,
     RequestType_ALLGATHER,
     RequestType_BROADCAST,
-    RequestType_JOIN
+    RequestType_JOIN,
+    RequestType_ADASUM,
+    RequestType_ALLTOALL,
+    RequestType_REDUCESCATTER,
+    RequestType_REDUCE,
+    RequestType_GATHER
   };
   return values;
 }
 
 inline const char * const *EnumNamesRequestType() {
-  static const char * const names[5] = {
+  static const char * const names[10] = {
     "ALLREDUCE",
     "ALLGATHER",
     "BROADCAST",
     "JOIN",
+    "ADASUM",
+    "ALLTOALL",
+    "REDUCESCATTER",
+    "REDUCE",
+    "GATHER",
     nullptr
   };
   return names;
 }
 
 inline const char *EnumNameRequestType(RequestType e) {
-  if (e < RequestType_ALLREDUCE || e > RequestType_JOIN) return "";
+  if (e < RequestType_ALLREDUCE || e > RequestType_GATHER) return "";
   const size_t index = static_cast<size_t>(e);
   return EnumNamesRequestType()[index];
 }
@@ -130,30 +148,42 @@ enum ResponseType {
   ResponseType_BROADCAST = 2,
   ResponseType_JOIN = 3,
   ResponseType_ADASUM = 4,
-  ResponseType_ERROR = 5,
+  ResponseType_ALLTOALL = 5,
+  ResponseType_REDUCESCATTER = 6,
+  ResponseType_REDUCE = 7,
+  ResponseType_GATHER = 8,
+  ResponseType_ERROR = 9,
   ResponseType_MIN = ResponseType_ALLREDUCE,
   ResponseType_MAX = ResponseType_ERROR
 };
 
-inline const ResponseType (&EnumValuesResponseType())[6] {
+inline const ResponseType (&EnumValuesResponseType())[10] {
   static const ResponseType values[] = {
     ResponseType_ALLREDUCE,
     ResponseType_ALLGATHER,
     ResponseType_BROADCAST,
     ResponseType_JOIN,
     ResponseType_ADASUM,
+    ResponseType_ALLTOALL,
+    ResponseType_REDUCESCATTER,
+    ResponseType_REDUCE,
+    ResponseType_GATHER,
     ResponseType_ERROR
   };
   return values;
 }
 
 inline const char * const *EnumNamesResponseType() {
-  static const char * const names[7] = {
+  static const char * const names[11] = {
     "ALLREDUCE",
     "ALLGATHER",
     "BROADCAST",
     "JOIN",
     "ADASUM",
+    "ALLTOALL",
+    "REDUCESCATTER",
+    "REDUCE",
+    "GATHER",
     "ERROR",
     nullptr
   };
@@ -176,7 +206,11 @@ struct Request FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
     VT_DEVICE = 14,
     VT_TENSOR_SHAPE = 16,
     VT_PRESCALE_FACTOR = 18,
-    VT_POSTSCALE_FACTOR = 20
+    VT_POSTSCALE_FACTOR = 20,
+    VT_REDUCE_OP = 22,
+    VT_PRIORITY = 24,
+    VT_NAME_ID = 26,
+    VT_SHAPE_UNCHANGED = 28
   };
   int32_t request_rank() const {
     return GetField<int32_t>(VT_REQUEST_RANK, 0);
@@ -205,6 +239,18 @@ struct Request FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   double postscale_factor() const {
     return GetField<double>(VT_POSTSCALE_FACTOR, 0.0);
   }
+  int32_t reduce_op() const {
+    return GetField<int32_t>(VT_REDUCE_OP, 0);
+  }
+  int32_t priority() const {
+    return GetField<int32_t>(VT_PRIORITY, 0);
+  }
+  int32_t name_id() const {
+    return GetField<int32_t>(VT_NAME_ID, -1);
+  }
+  bool shape_unchanged() const {
+    return GetField<uint8_t>(VT_SHAPE_UNCHANGED, 0) != 0;
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<int32_t>(verifier, VT_REQUEST_RANK) &&
@@ -218,6 +264,10 @@ struct Request FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            verifier.VerifyVector(tensor_shape()) &&
            VerifyField<double>(verifier, VT_PRESCALE_FACTOR) &&
            VerifyField<double>(verifier, VT_POSTSCALE_FACTOR) &&
+           VerifyField<int32_t>(verifier, VT_REDUCE_OP) &&
+           VerifyField<int32_t>(verifier, VT_PRIORITY) &&
+           VerifyField<int32_t>(verifier, VT_NAME_ID) &&
+           VerifyField<uint8_t>(verifier, VT_SHAPE_UNCHANGED) &&
            verifier.EndTable();
   }
 };
@@ -252,6 +302,18 @@ struct RequestBuilder {
   void add_postscale_factor(double postscale_factor) {
     fbb_.AddElement<double>(Request::VT_POSTSCALE_FACTOR, postscale_factor, 0.0);
   }
+  void add_reduce_op(int32_t reduce_op) {
+    fbb_.AddElement<int32_t>(Request::VT_REDUCE_OP, reduce_op, 0);
+  }
+  void add_priority(int32_t priority) {
+    fbb_.AddElement<int32_t>(Request::VT_PRIORITY, priority, 0);
+  }
+  void add_name_id(int32_t name_id) {
+    fbb_.AddElement<int32_t>(Request::VT_NAME_ID, name_id, -1);
+  }
+  void add_shape_unchanged(bool shape_unchanged) {
+    fbb_.AddElement<uint8_t>(Request::VT_SHAPE_UNCHANGED, static_cast<uint8_t>(shape_unchanged), 0);
+  }
   explicit RequestBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -274,10 +336,17 @@ inline flatbuffers::Offset<Request> CreateRequest(
     int32_t device = 0,
     flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_shape = 0,
     double prescale_factor = 0.0,
-    double postscale_factor = 0.0) {
+    double postscale_factor = 0.0,
+    int32_t reduce_op = 0,
+    int32_t priority = 0,
+    int32_t name_id = -1,
+    bool shape_unchanged = false) {
   RequestBuilder builder_(_fbb);
   builder_.add_postscale_factor(postscale_factor);
   builder_.add_prescale_factor(prescale_factor);
+  builder_.add_name_id(name_id);
+  builder_.add_priority(priority);
+  builder_.add_reduce_op(reduce_op);
   builder_.add_tensor_shape(tensor_shape);
   builder_.add_device(device);
   builder_.add_root_rank(root_rank);
@@ -285,6 +354,7 @@ inline flatbuffers::Offset<Request> CreateRequest(
   builder_.add_request_rank(request_rank);
   builder_.add_tensor_type(tensor_type);
   builder_.add_request_type(request_type);
+  builder_.add_shape_unchanged(shape_unchanged);
   return builder_.Finish();
 }
 
@@ -298,7 +368,11 @@ inline flatbuffers::Offset<Request> CreateRequestDirect(
     int32_t device = 0,
     const std::vector<int64_t> *tensor_shape = nullptr,
     double prescale_factor = 0.0,
-    double postscale_factor = 0.0) {
+    double postscale_factor = 0.0,
+    int32_t reduce_op = 0,
+    int32_t priority = 0,
+    int32_t name_id = -1,
+    bool shape_unchanged = false) {
   auto tensor_name__ = tensor_name ? _fbb.CreateString(tensor_name) : 0;
   auto tensor_shape__ = tensor_shape ? _fbb.CreateVector<int64_t>(*tensor_shape) : 0;
   return horovod::common::wire::CreateRequest(
@@ -311,7 +385,11 @@ inline flatbuffers::Offset<Request> CreateRequestDirect(
       device,
       tensor_shape__,
       prescale_factor,
-      postscale_factor);
+      postscale_factor,
+      reduce_op,
+      priority,
+      name_id,
+      shape_unchanged);
 }
 
 struct RequestList FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
@@ -386,7 +464,12 @@ struct Response FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
     VT_TENSOR_SIZES = 12,
     VT_TENSOR_TYPE = 14,
     VT_PRESCALE_FACTOR = 16,
-    VT_POSTSCALE_FACTOR = 18
+    VT_POSTSCALE_FACTOR = 18,
+    VT_REDUCE_OP = 20,
+    VT_PRIORITY = 22,
+    VT_PARTITION_OFFSET = 24,
+    VT_NUM_PARTITIONS = 26,
+    VT_ROOT_RANK = 28
   };
   horovod::common::wire::ResponseType response_type() const {
     return static_cast<horovod::common::wire::ResponseType>(GetField<int8_t>(VT_RESPONSE_TYPE, 0));
@@ -412,6 +495,21 @@ struct Response FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   double postscale_factor() const {
     return GetField<double>(VT_POSTSCALE_FACTOR, 0.0);
   }
+  int32_t reduce_op() const {
+    return GetField<int32_t>(VT_REDUCE_OP, 0);
+  }
+  int32_t priority() const {
+    return GetField<int32_t>(VT_PRIORITY, 0);
+  }
+  int64_t partition_offset() const {
+    return GetField<int64_t>(VT_PARTITION_OFFSET, 0);
+  }
+  int32_t num_partitions() const {
+    return GetField<int32_t>(VT_NUM_PARTITIONS, 1);
+  }
+  int32_t root_rank() const {
+    return GetField<int32_t>(VT_ROOT_RANK, 0);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<int8_t>(verifier, VT_RESPONSE_TYPE) &&
@@ -427,6 +525,11 @@ struct Response FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            VerifyField<int8_t>(verifier, VT_TENSOR_TYPE) &&
            VerifyField<double>(verifier, VT_PRESCALE_FACTOR) &&
            VerifyField<double>(verifier, VT_POSTSCALE_FACTOR) &&
+           VerifyField<int32_t>(verifier, VT_REDUCE_OP) &&
+           VerifyField<int32_t>(verifier, VT_PRIORITY) &&
+           VerifyField<int64_t>(verifier, VT_PARTITION_OFFSET) &&
+           VerifyField<int32_t>(verifier, VT_NUM_PARTITIONS) &&
+           VerifyField<int32_t>(verifier, VT_ROOT_RANK) &&
            verifier.EndTable();
   }
 };
@@ -458,6 +561,21 @@ struct ResponseBuilder {
   void add_postscale_factor(double postscale_factor) {
     fbb_.AddElement<double>(Response::VT_POSTSCALE_FACTOR, postscale_factor, 0.0);
   }
+  void add_reduce_op(int32_t reduce_op) {
+    fbb_.AddElement<int32_t>(Response::VT_REDUCE_OP, reduce_op, 0);
+  }
+  void add_priority(int32_t priority) {
+    fbb_.AddElement<int32_t>(Response::VT_PRIORITY, priority, 0);
+  }
+  void add_partition_offset(int64_t partition_offset) {
+    fbb_.AddElement<int64_t>(Response::VT_PARTITION_OFFSET, partition_offset, 0);
+  }
+  void add_num_partitions(int32_t num_partitions) {
+    fbb_.AddElement<int32_t>(Response::VT_NUM_PARTITIONS, num_partitions, 1);
+  }
+  void add_root_rank(int32_t root_rank) {
+    fbb_.AddElement<int32_t>(Response::VT_ROOT_RANK, root_rank, 0);
+  }
   explicit ResponseBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -479,10 +597,20 @@ inline flatbuffers::Offset<Response> CreateResponse(
     flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_sizes = 0,
     horovod::common::wire::DataType tensor_type = horovod::common::wire::DataType_HOROVOD_UINT8,
     double prescale_factor = 0.0,
-    double postscale_factor = 0.0) {
+    double postscale_factor = 0.0,
+    int32_t reduce_op = 0,
+    int32_t priority = 0,
+    int64_t partition_offset = 0,
+    int32_t num_partitions = 1,
+    int32_t root_rank = 0) {
   ResponseBuilder builder_(_fbb);
+  builder_.add_partition_offset(partition_offset);
   builder_.add_postscale_factor(postscale_factor);
   builder_.add_prescale_factor(prescale_factor);
+  builder_.add_root_rank(root_rank);
+  builder_.add_num_partitions(num_partitions);
+  builder_.add_priority(priority);
+  builder_.add_reduce_op(reduce_op);
   builder_.add_tensor_sizes(tensor_sizes);
   builder_.add_devices(devices);
   builder_.add_error_message(error_message);
@@ -501,7 +629,12 @@ inline flatbuffers::Offset<Response> CreateResponseDirect(
     const std::vector<int64_t> *tensor_sizes = nullptr,
     horovod::common::wire::DataType tensor_type = horovod::common::wire::DataType_HOROVOD_UINT8,
     double prescale_factor = 0.0,
-    double postscale_factor = 0.0) {
+    double postscale_factor = 0.0,
+    int32_t reduce_op = 0,
+    int32_t priority = 0,
+    int64_t partition_offset = 0,
+    int32_t num_partitions = 1,
+    int32_t root_rank = 0) {
   auto tensor_names__ = tensor_names ? _fbb.CreateVector<flatbuffers::Offset<flatbuffers::String>>(*tensor_names) : 0;
   auto error_message__ = error_message ? _fbb.CreateString(error_message) : 0;
   auto devices__ = devices ? _fbb.CreateVector<int32_t>(*devices) : 0;
@@ -515,7 +648,12 @@ inline flatbuffers::Offset<Response> CreateResponseDirect(
       tensor_sizes__,
       tensor_type,
       prescale_factor,
-      postscale_factor);
+      postscale_factor,
+      reduce_op,
+      priority,
+      partition_offset,
+      num_partitions,
+      root_rank);
 }
 
 struct ResponseList FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
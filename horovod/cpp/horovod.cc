@@ -0,0 +1,518 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "horovod.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "../common/common.h"
+#include "../common/event_pool.h"
+#include "../common/operations.h"
+
+namespace horovod {
+namespace cpp {
+
+namespace {
+
+class DefaultAllocator : public Allocator {
+public:
+  void* Allocate(size_t size, int device) override {
+    size = std::max(size, (size_t)1);
+    if (device == CPU_DEVICE) {
+      return malloc(size);
+    }
+#if HAVE_CUDA
+    int restore_device;
+    if (cudaGetDevice(&restore_device) != cudaSuccess ||
+        cudaSetDevice(device) != cudaSuccess) {
+      return nullptr;
+    }
+    void* data = nullptr;
+    if (cudaMalloc(&data, size) != cudaSuccess) {
+      data = nullptr;
+    }
+    cudaSetDevice(restore_device);
+    return data;
+#else
+    return nullptr;
+#endif
+  }
+
+  void Free(void* data, size_t size, int device) override {
+    if (device == CPU_DEVICE) {
+      free(data);
+      return;
+    }
+#if HAVE_CUDA
+    cudaFree(data);
+#endif
+  }
+};
+
+std::shared_ptr<Allocator> global_allocator =
+    std::make_shared<DefaultAllocator>();
+
+std::shared_ptr<Allocator> GetAllocator() {
+  return std::atomic_load(&global_allocator);
+}
+
+Status ConvertStatus(const common::Status& status) {
+  if (status.ok()) {
+    return Status::OK();
+  }
+  return Status::Error(status.reason());
+}
+
+common::TensorShape ConvertShape(const std::vector<int64_t>& dims) {
+  common::TensorShape shape;
+  for (auto dim : dims) {
+    shape.AddDim(dim);
+  }
+  return shape;
+}
+
+// Views a caller's buffer, or one owned by Horovod if owner is set.
+class CppTensor : public common::Tensor {
+public:
+  explicit CppTensor(TensorView view, std::shared_ptr<void> owner = nullptr)
+      : view_(std::move(view)), owner_(std::move(owner)) {}
+
+  const common::DataType dtype() const override {
+    return static_cast<common::DataType>(view_.dtype);
+  }
+  const common::TensorShape shape() const override {
+    return ConvertShape(view_.shape);
+  }
+  const void* data() const override { return view_.data; }
+  int64_t size() const override { return view_.size(); }
+
+private:
+  TensorView view_;
+  std::shared_ptr<void> owner_;
+};
+
+class CppPersistentBuffer : public common::PersistentBuffer {
+public:
+  CppPersistentBuffer(std::shared_ptr<Allocator> allocator, int64_t size,
+                      int device)
+      : buffer_(std::move(allocator), DataType::INT8, {size}, device) {}
+
+  const void*
+  AccessData(std::shared_ptr<common::OpContext> context) const override {
+    return buffer_.view().data;
+  }
+
+private:
+  OutputTensor buffer_;
+};
+
+class CppOpContext : public common::OpContext {
+public:
+  CppOpContext(DataType dtype, int device, std::shared_ptr<Allocator> allocator)
+      : dtype_(dtype), device_(device), allocator_(std::move(allocator)) {}
+
+  common::Status
+  AllocatePersistent(int64_t size,
+                     std::shared_ptr<common::PersistentBuffer>* tensor) override {
+    try {
+      *tensor = std::make_shared<CppPersistentBuffer>(allocator_, size, device_);
+    } catch (const std::bad_alloc&) {
+      return OutOfMemory(size);
+    }
+    return common::Status::OK();
+  }
+
+  common::Status
+  AllocateOutput(common::TensorShape shape,
+                 std::shared_ptr<common::Tensor>* tensor) override {
+    return Allocate(dtype_, shape, device_, &output_, tensor);
+  }
+
+  // Output 1 holds the splits received by alltoall, which are written on the
+  // host.
+  common::Status
+  AllocateOutput(int output_index, common::TensorShape shape,
+                 std::shared_ptr<common::Tensor>* tensor) override {
+    if (output_index == 0) {
+      return AllocateOutput(std::move(shape), tensor);
+    }
+    std::shared_ptr<OutputTensor> splits;
+    return Allocate(DataType::INT32, shape, CPU_DEVICE, &splits, tensor);
+  }
+
+  common::Status
+  AllocateZeros(int64_t num_elements, common::DataType dtype,
+                std::shared_ptr<common::Tensor>* tensor) override {
+    common::TensorShape shape;
+    shape.AddDim(num_elements);
+    std::shared_ptr<OutputTensor> zeros;
+    auto status = Allocate(static_cast<DataType>(dtype), shape, device_,
+                           &zeros, tensor);
+    if (!status.ok()) {
+      return status;
+    }
+    auto& view = zeros->view();
+    if (device_ == CPU_DEVICE) {
+      memset(view.data, 0, view.size());
+    } else {
+#if HAVE_CUDA
+      int restore_device;
+      HVD_GPU_CHECK(cudaGetDevice(&restore_device));
+      HVD_GPU_CHECK(cudaSetDevice(device_));
+      HVD_GPU_CHECK(cudaMemset(view.data, 0, view.size()));
+      HVD_GPU_CHECK(cudaSetDevice(restore_device));
+#endif
+    }
+    return common::Status::OK();
+  }
+
+  common::Framework framework() const override {
+    return common::Framework::CPP;
+  }
+
+  const std::shared_ptr<OutputTensor>& output() const { return output_; }
+
+private:
+  common::Status Allocate(DataType dtype, const common::TensorShape& shape,
+                          int device, std::shared_ptr<OutputTensor>* output,
+                          std::shared_ptr<common::Tensor>* tensor) {
+    try {
+      *output = std::make_shared<OutputTensor>(allocator_, dtype,
+                                               shape.to_vector(), device);
+    } catch (const std::bad_alloc&) {
+      return OutOfMemory(shape.num_elements() *
+                         (int64_t)DataTypeSize(dtype));
+    }
+    *tensor = std::make_shared<CppTensor>((*output)->view(), *output);
+    return common::Status::OK();
+  }
+
+  common::Status OutOfMemory(int64_t size) const {
+    return common::Status::UnknownError(
+        "Failed to allocate " + std::to_string(size) + " bytes on device " +
+        std::to_string(device_) + ".");
+  }
+
+  DataType dtype_;
+  int device_;
+  std::shared_ptr<Allocator> allocator_;
+  std::shared_ptr<OutputTensor> output_;
+};
+
+#if HAVE_GPU
+common::EventPool<gpuEvent_t> ready_event_pool;
+
+// Completes once the work enqueued on the stream of the caller before the op
+// is done.
+class CppReadyEvent : public common::ReadyEvent {
+public:
+  CppReadyEvent(int device, gpuStream_t stream) : device_(device) {
+    event_ = ready_event_pool.Acquire(device_);
+    if (event_ == nullptr) {
+      HVD_GPU_CHECK(gpuEventCreateWithFlags(&event_, gpuEventDisableTiming));
+    }
+    HVD_GPU_CHECK(gpuEventRecord(event_, stream));
+  }
+
+  ~CppReadyEvent() {
+    if (!ready_event_pool.Release(device_, event_)) {
+      gpuEventDestroy(event_);
+    }
+  }
+
+  bool Ready() const override {
+    HVD_GPU_CHECK(gpuEventSynchronize(event_));
+    return true;
+  }
+
+  gpuEvent_t event() const override { return event_; }
+
+private:
+  int device_;
+  gpuEvent_t event_;
+};
+#endif
+
+common::ReadyEventList ReadyEvents(int device, void* stream) {
+  common::ReadyEventList ready_events;
+#if HAVE_GPU
+  if (device != CPU_DEVICE) {
+    ready_events.AddReadyEvent(std::make_shared<CppReadyEvent>(
+        device, static_cast<gpuStream_t>(stream)));
+  }
+#endif
+  return ready_events;
+}
+
+// Makes stream wait for the op, whose GPU work may still be queued with
+// HOROVOD_ENABLE_ASYNC_COMPLETION.
+void WaitOnStream(const common::Status& status, void* stream) {
+#if HAVE_GPU
+  if (status.event.event != nullptr) {
+    HVD_GPU_CHECK(gpuStreamWaitEvent(static_cast<gpuStream_t>(stream),
+                                     *status.event.event, 0));
+  }
+#endif
+}
+
+Status CheckArguments(const TensorView& tensor, const OpOptions& options) {
+  if (options.name.empty()) {
+    return Status::Error("Ops require a name.");
+  }
+  if (tensor.data == nullptr && tensor.num_elements() > 0) {
+    return Status::Error("Tensor of " + options.name + " has no data.");
+  }
+#if !HAVE_GPU
+  if (tensor.device != CPU_DEVICE) {
+    return Status::Error("GPU tensors require a Horovod build with GPU "
+                         "support.");
+  }
+#endif
+  return Status::OK();
+}
+
+Status EnqueueWithOutput(
+    const TensorView& input, const OpOptions& options, OutputCallback callback,
+    const std::function<common::Status(std::shared_ptr<CppOpContext>,
+                                       common::ReadyEventList,
+                                       common::StatusCallback)>& enqueue) {
+  auto status = CheckArguments(input, options);
+  if (!status.ok()) {
+    return status;
+  }
+  auto context =
+      std::make_shared<CppOpContext>(input.dtype, input.device, GetAllocator());
+  void* stream = options.stream;
+  return ConvertStatus(enqueue(
+      context, ReadyEvents(input.device, stream),
+      [context, stream, callback](const common::Status& status) {
+        WaitOnStream(status, stream);
+        callback(ConvertStatus(status),
+                 status.ok() ? context->output() : nullptr);
+      }));
+}
+
+// Completes future with the result of an op enqueued with enqueue.
+Future EnqueueFuture(const std::function<Status(DoneCallback)>& enqueue) {
+  auto future = Future::Make();
+  auto status = enqueue(future.Callback());
+  if (!status.ok()) {
+    future.Complete(status);
+  }
+  return future;
+}
+
+OutputFuture
+EnqueueOutputFuture(const std::function<Status(OutputCallback)>& enqueue) {
+  auto future = OutputFuture::Make();
+  auto status = enqueue(
+      [future](const Status& status, std::shared_ptr<OutputTensor> output) {
+        future.Complete(OutputResult{status, std::move(output)});
+      });
+  if (!status.ok()) {
+    future.Complete(OutputResult{status, nullptr});
+  }
+  return future;
+}
+
+} // namespace
+
+size_t DataTypeSize(DataType dtype) {
+  return common::DataType_Size(static_cast<common::DataType>(dtype));
+}
+
+int64_t TensorView::num_elements() const {
+  int64_t result = 1;
+  for (auto dim : shape) {
+    result *= dim;
+  }
+  return result;
+}
+
+int64_t TensorView::size() const {
+  return num_elements() * (int64_t)DataTypeSize(dtype);
+}
+
+void SetAllocator(std::shared_ptr<Allocator> allocator) {
+  std::atomic_store(&global_allocator, std::move(allocator));
+}
+
+OutputTensor::OutputTensor(std::shared_ptr<Allocator> allocator,
+                           DataType dtype, std::vector<int64_t> shape,
+                           int device)
+    : allocator_(std::move(allocator)) {
+  view_.dtype = dtype;
+  view_.shape = std::move(shape);
+  view_.device = device;
+  view_.data = allocator_->Allocate(view_.size(), device);
+  if (view_.data == nullptr) {
+    throw std::bad_alloc();
+  }
+}
+
+OutputTensor::~OutputTensor() {
+  allocator_->Free(view_.data, view_.size(), view_.device);
+}
+
+bool Init() { return common::horovod_init(nullptr, 0, nullptr, nullptr, 0); }
+
+void Shutdown() { common::horovod_shutdown(); }
+
+bool IsInitialized() { return common::CheckInitialized().ok(); }
+
+int Rank() { return common::horovod_rank(); }
+
+int Size() { return common::horovod_size(); }
+
+int LocalRank() { return common::horovod_local_rank(); }
+
+int LocalSize() { return common::horovod_local_size(); }
+
+Status Allreduce(const TensorView& input, const TensorView& output,
+                 const OpOptions& options, DoneCallback callback) {
+  auto status = CheckArguments(input, options);
+  if (!status.ok()) {
+    return status;
+  }
+  if (output.dtype != input.dtype || output.shape != input.shape ||
+      output.device != input.device) {
+    return Status::Error("Output of " + options.name +
+                         " must have the dtype, shape and device of the "
+                         "input.");
+  }
+  auto context =
+      std::make_shared<CppOpContext>(input.dtype, input.device, GetAllocator());
+  void* stream = options.stream;
+  return ConvertStatus(common::EnqueueTensorAllreduce(
+      context, std::make_shared<CppTensor>(input),
+      std::make_shared<CppTensor>(output), ReadyEvents(input.device, stream),
+      options.name, input.device,
+      [stream, callback](const common::Status& status) {
+        WaitOnStream(status, stream);
+        callback(ConvertStatus(status));
+      },
+      static_cast<common::ReduceOp>(options.reduce_op),
+      options.prescale_factor, options.postscale_factor,
+      options.process_set_id, options.priority));
+}
+
+Status Broadcast(const TensorView& tensor, int root_rank,
+                 const OpOptions& options, DoneCallback callback) {
+  auto status = CheckArguments(tensor, options);
+  if (!status.ok()) {
+    return status;
+  }
+  auto context = std::make_shared<CppOpContext>(tensor.dtype, tensor.device,
+                                                GetAllocator());
+  auto hvd_tensor = std::make_shared<CppTensor>(tensor);
+  void* stream = options.stream;
+  return ConvertStatus(common::EnqueueTensorBroadcast(
+      context, hvd_tensor, hvd_tensor, root_rank,
+      ReadyEvents(tensor.device, stream), options.name, tensor.device,
+      [stream, callback](const common::Status& status) {
+        WaitOnStream(status, stream);
+        callback(ConvertStatus(status));
+      },
+      options.process_set_id));
+}
+
+Status Allgather(const TensorView& input, const OpOptions& options,
+                 OutputCallback callback) {
+  return EnqueueWithOutput(
+      input, options, std::move(callback),
+      [&](std::shared_ptr<CppOpContext> context,
+          common::ReadyEventList ready_events,
+          common::StatusCallback done) {
+        return common::EnqueueTensorAllgather(
+            context, std::make_shared<CppTensor>(input), ready_events,
+            options.name, input.device, std::move(done),
+            options.process_set_id);
+      });
+}
+
+Status Reducescatter(const TensorView& input, const OpOptions& options,
+                     OutputCallback callback) {
+  return EnqueueWithOutput(
+      input, options, std::move(callback),
+      [&](std::shared_ptr<CppOpContext> context,
+          common::ReadyEventList ready_events,
+          common::StatusCallback done) {
+        return common::EnqueueTensorReducescatter(
+            context, std::make_shared<CppTensor>(input), ready_events,
+            options.name, input.device, std::move(done),
+            static_cast<common::ReduceOp>(options.reduce_op),
+            options.process_set_id);
+      });
+}
+
+Status Alltoall(const TensorView& input, const std::vector<int32_t>& splits,
+                const OpOptions& options, OutputCallback callback) {
+  auto splits_data = std::make_shared<std::vector<int32_t>>(splits);
+  TensorView splits_view;
+  splits_view.data = splits_data->data();
+  splits_view.dtype = DataType::INT32;
+  splits_view.shape = {(int64_t)splits_data->size()};
+  auto splits_tensor = std::make_shared<CppTensor>(splits_view, splits_data);
+  return EnqueueWithOutput(
+      input, options, std::move(callback),
+      [&](std::shared_ptr<CppOpContext> context,
+          common::ReadyEventList ready_events,
+          common::StatusCallback done) {
+        return common::EnqueueTensorAlltoall(
+            context, std::make_shared<CppTensor>(input), splits_tensor,
+            ready_events, options.name, input.device, std::move(done),
+            options.process_set_id);
+      });
+}
+
+Future Allreduce(const TensorView& input, const TensorView& output,
+                 const OpOptions& options) {
+  return EnqueueFuture([&](DoneCallback callback) {
+    return Allreduce(input, output, options, std::move(callback));
+  });
+}
+
+Future Broadcast(const TensorView& tensor, int root_rank,
+                 const OpOptions& options) {
+  return EnqueueFuture([&](DoneCallback callback) {
+    return Broadcast(tensor, root_rank, options, std::move(callback));
+  });
+}
+
+OutputFuture Allgather(const TensorView& input, const OpOptions& options) {
+  return EnqueueOutputFuture([&](OutputCallback callback) {
+    return Allgather(input, options, std::move(callback));
+  });
+}
+
+OutputFuture Reducescatter(const TensorView& input, const OpOptions& options) {
+  return EnqueueOutputFuture([&](OutputCallback callback) {
+    return Reducescatter(input, options, std::move(callback));
+  });
+}
+
+OutputFuture Alltoall(const TensorView& input,
+                      const std::vector<int32_t>& splits,
+                      const OpOptions& options) {
+  return EnqueueOutputFuture([&](OutputCallback callback) {
+    return Alltoall(input, splits, options, std::move(callback));
+  });
+}
+
+} // namespace cpp
+} // namespace horovod
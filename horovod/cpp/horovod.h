@@ -0,0 +1,207 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// C++ API of Horovod for processes without a Python framework, e.g. serving
+// or training engines written in C++. Ops run on raw host or GPU buffers and
+// go through the same negotiation, fusion and response cache as the ops of
+// the frameworks.
+//
+// This header only depends on the standard library and the header-only
+// completion token of horovod/common, so that it can be used without the
+// Horovod build flags. Link with libhorovod_cpp, built with
+// HOROVOD_WITH_CPP=1.
+
+#ifndef HOROVOD_CPP_HOROVOD_H
+#define HOROVOD_CPP_HOROVOD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../common/completion.h"
+
+namespace horovod {
+namespace cpp {
+
+// Device of host buffers. GPU buffers have the index of their CUDA device.
+constexpr int CPU_DEVICE = -1;
+
+// Values match the data types of the frameworks' bindings.
+enum class DataType {
+  UINT8 = 0,
+  INT8 = 1,
+  UINT16 = 2,
+  INT16 = 3,
+  INT32 = 4,
+  INT64 = 5,
+  FLOAT16 = 6,
+  FLOAT32 = 7,
+  FLOAT64 = 8,
+  BOOL = 9,
+  BFLOAT16 = 10,
+};
+
+size_t DataTypeSize(DataType dtype);
+
+enum class ReduceOp {
+  SUM = 1,
+  ADASUM = 2,
+  MIN = 3,
+  MAX = 4,
+  PRODUCT = 5,
+};
+
+class Status {
+public:
+  Status() = default;
+  static Status OK() { return Status(); }
+  static Status Error(std::string reason) { return Status(std::move(reason)); }
+
+  bool ok() const { return ok_; }
+  const std::string& reason() const { return reason_; }
+
+private:
+  explicit Status(std::string reason)
+      : ok_(false), reason_(std::move(reason)) {}
+
+  bool ok_ = true;
+  std::string reason_;
+};
+
+// A buffer owned by the caller, which must keep it alive until the op
+// completes.
+struct TensorView {
+  void* data = nullptr;
+  DataType dtype = DataType::FLOAT32;
+  std::vector<int64_t> shape;
+  int device = CPU_DEVICE;
+
+  int64_t num_elements() const;
+  int64_t size() const;
+};
+
+// Allocates the outputs whose shape is only known once the op runs, and the
+// fusion buffers. The default one uses malloc and cudaMalloc; replace it to
+// allocate from a caching allocator of the engine.
+class Allocator {
+public:
+  virtual void* Allocate(size_t size, int device) = 0;
+  virtual void Free(void* data, size_t size, int device) = 0;
+  virtual ~Allocator() = default;
+};
+
+// Sets the allocator of all later ops. Not thread-safe with enqueued ops.
+void SetAllocator(std::shared_ptr<Allocator> allocator);
+
+// An output allocated by Horovod, freed with the last reference.
+class OutputTensor {
+public:
+  OutputTensor(std::shared_ptr<Allocator> allocator, DataType dtype,
+               std::vector<int64_t> shape, int device);
+  ~OutputTensor();
+  OutputTensor(const OutputTensor&) = delete;
+  OutputTensor& operator=(const OutputTensor&) = delete;
+
+  const TensorView& view() const { return view_; }
+
+private:
+  std::shared_ptr<Allocator> allocator_;
+  TensorView view_;
+};
+
+struct OpOptions {
+  // Names the op across ranks. All ranks must enqueue an op of the same name,
+  // which must be unique among the ops in flight.
+  std::string name;
+  int process_set_id = 0;
+  // cudaStream_t that produces the input of GPU ops, or null for the
+  // default stream. Horovod waits for the work enqueued on it so far before
+  // it reads the input, and makes it wait for the op before the callback
+  // runs, so that work enqueued on it from the callback sees the output.
+  void* stream = nullptr;
+  ReduceOp reduce_op = ReduceOp::SUM;
+  double prescale_factor = 1.0;
+  double postscale_factor = 1.0;
+  int priority = 0;
+};
+
+// Callbacks run on a Horovod thread once the op completes and must not
+// block. The returned status of the enqueue functions only reports errors
+// of the arguments, errors of the op go to the callback.
+using DoneCallback = std::function<void(const Status&)>;
+using OutputCallback =
+    std::function<void(const Status&, std::shared_ptr<OutputTensor>)>;
+
+struct OutputResult {
+  Status status;
+  // Null if the op failed.
+  std::shared_ptr<OutputTensor> output;
+};
+
+// Completion tokens returned by the overloads without a callback, which can
+// be polled, waited for, chained with Then() or co_awaited in C++20.
+// Errors of the arguments complete them right away.
+using Future = common::BasicCompletion<Status>;
+using OutputFuture = common::BasicCompletion<OutputResult>;
+
+// Initializes Horovod with all ranks of the job, as launched by horovodrun or
+// mpirun. Returns false on failure.
+bool Init();
+void Shutdown();
+bool IsInitialized();
+
+int Rank();
+int Size();
+int LocalRank();
+int LocalSize();
+
+// Reduces input over the process set into output, which has the shape of
+// input and may be input itself.
+Status Allreduce(const TensorView& input, const TensorView& output,
+                 const OpOptions& options, DoneCallback callback);
+Future Allreduce(const TensorView& input, const TensorView& output,
+                 const OpOptions& options);
+
+// Broadcasts tensor of root_rank into tensor of the other ranks.
+Status Broadcast(const TensorView& tensor, int root_rank,
+                 const OpOptions& options, DoneCallback callback);
+Future Broadcast(const TensorView& tensor, int root_rank,
+                 const OpOptions& options);
+
+// Concatenates input of all ranks along the first dimension.
+Status Allgather(const TensorView& input, const OpOptions& options,
+                 OutputCallback callback);
+OutputFuture Allgather(const TensorView& input, const OpOptions& options);
+
+// Reduces input and scatters the result along the first dimension.
+Status Reducescatter(const TensorView& input, const OpOptions& options,
+                     OutputCallback callback);
+OutputFuture Reducescatter(const TensorView& input, const OpOptions& options);
+
+// Sends splits[i] slices of the first dimension of input to rank i, or equal
+// parts if splits is empty, and concatenates the slices received.
+Status Alltoall(const TensorView& input, const std::vector<int32_t>& splits,
+                const OpOptions& options, OutputCallback callback);
+OutputFuture Alltoall(const TensorView& input,
+                      const std::vector<int32_t>& splits,
+                      const OpOptions& options);
+
+} // namespace cpp
+} // namespace horovod
+
+#endif // HOROVOD_CPP_HOROVOD_H
@@ -23,7 +23,8 @@ from horovod.mxnet.functions import allgather_object, broadcast_object
 from horovod.mxnet.mpi_ops import allgather
 from horovod.mxnet.mpi_ops import allreduce, allreduce_, grouped_allreduce, grouped_allreduce_
 from horovod.mxnet.mpi_ops import alltoall
-from horovod.mxnet.mpi_ops import broadcast, broadcast_
+from horovod.mxnet.mpi_ops import broadcast, broadcast_, grouped_broadcast_
+from horovod.mxnet.mpi_ops import reducescatter
 from horovod.mxnet.mpi_ops import init, shutdown
 from horovod.mxnet.mpi_ops import is_initialized, start_timeline, stop_timeline
 from horovod.mxnet.mpi_ops import size, local_size, cross_size, rank, local_rank, cross_rank
@@ -253,6 +254,11 @@ def broadcast_parameters(params, root_rank=0, prefix=None):
     else:
         raise ValueError('invalid params of type: %s' % type(params))
 
-    # Run broadcasts.
+    # Run one grouped broadcast per device and type, each a single engine operation.
+    entries_by_key = defaultdict(list)
     for tensor, name in zip(tensors, names):
-        broadcast_(tensor, root_rank, name=name)
+        entries_by_key[(str(tensor.context), tensor.dtype)].append((tensor, name))
+    for entries in entries_by_key.values():
+        group_tensors, group_names = zip(*entries)
+        grouped_broadcast_(list(group_tensors), root_rank,
+                           name="{}:{}".format(group_names[0], group_names[-1]))
@@ -20,7 +20,7 @@ import io
 import cloudpickle
 import mxnet as mx
 
-from horovod.mxnet.mpi_ops import allgather, broadcast_
+from horovod.mxnet.mpi_ops import allgather, broadcast_, broadcast_bytes
 from horovod.mxnet.mpi_ops import rank, size
 
 
@@ -40,6 +40,11 @@ def broadcast_object(obj, root_rank=0, name=None):
     if name is None:
         name = type(obj).__name__
 
+    data = cloudpickle.dumps(obj) if rank() == root_rank else None
+    data = broadcast_bytes(data, root_rank)
+    if data is not None:
+        return obj if rank() == root_rank else cloudpickle.loads(data)
+
     if rank() == root_rank:
         b = io.BytesIO()
         cloudpickle.dump(obj, b)
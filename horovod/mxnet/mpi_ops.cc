@@ -15,6 +15,8 @@
 // =============================================================================
 
 #include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 #include "../common/operations.h"
 #include "cuda_util.h"
@@ -35,6 +37,28 @@ std::string GetOpName(const char* prefix, const char* name) {
   op_count.fetch_add(1);
   return std::string(prefix) + ".noname." + std::to_string(op_count);
 }
+
+#if HAVE_CUDA
+// Page-locked host arrays that named operations are staged through when
+// their GPU tensors are reduced on the CPU, kept across calls. The engine
+// orders every reuse of an array after the operations still using it.
+std::mutex staging_mutex;
+std::unordered_map<std::string, std::shared_ptr<::mxnet::NDArray>> staging_arrays;
+
+std::shared_ptr<::mxnet::NDArray> GetStagingArray(const std::string& op_name,
+                                                  ::mxnet::NDArray* tensor) {
+  std::lock_guard<std::mutex> guard(staging_mutex);
+  auto& staging = staging_arrays[op_name];
+  if (staging == nullptr || staging->dtype() != tensor->dtype() ||
+      staging->shape() != tensor->shape()) {
+    // Never resized in place, as pending operations may still read it.
+    staging = std::make_shared<::mxnet::NDArray>(
+        ::mxnet::Context::CPUPinned(tensor->ctx().real_dev_id()),
+        tensor->dtype());
+  }
+  return staging;
+}
+#endif
 } // namespace
 
 static const auto MX_EXEC_CTX = Context();
@@ -43,6 +67,7 @@ static const char* ALLREDUCE_OP_TYPE_NAME = "horovod_allreduce";
 static const char* ALLGATHER_OP_TYPE_NAME = "horovod_allgather";
 static const char* BROADCAST_OP_TYPE_NAME = "horovod_broadcast";
 static const char* ALLTOALL_OP_TYPE_NAME = "horovod_alltoall";
+static const char* REDUCESCATTER_OP_TYPE_NAME = "horovod_reducescatter";
 
 inline void InvokeCompleteCallback(CallbackOnComplete on_complete, const Status& status) {
   if (status.ok()) {
@@ -63,6 +88,8 @@ inline const char* GetOpTypeName(OperationType op_type) {
       return BROADCAST_OP_TYPE_NAME;
     case OperationType::ALLTOALL:
       return ALLTOALL_OP_TYPE_NAME;
+    case OperationType::REDUCESCATTER:
+      return REDUCESCATTER_OP_TYPE_NAME;
     default:
       throw std::logic_error("Unsupported Horovod operation type.");
   }
@@ -147,16 +174,17 @@ void DoHorovodOperation(void*, void* on_complete_ptr, void* param) {
           callbacks[0]);
       break;
     case OperationType::BROADCAST:
-      if (horovod_rank() != ops_param->root_rank) {
-        hvd_outputs.emplace_back(std::make_shared<MXTensor>(ops_param->output_tensors[0].get()));
-      } else {
-        hvd_outputs.emplace_back(nullptr);
+      for (int i = 0; i < num_tensors; ++i) {
+        if (horovod_rank() != ops_param->root_rank) {
+          hvd_outputs.emplace_back(std::make_shared<MXTensor>(ops_param->output_tensors[i].get()));
+        } else {
+          hvd_outputs.emplace_back(nullptr);
+        }
       }
 
-      enqueue_result = EnqueueTensorBroadcast(
-          hvd_contexts[0], hvd_tensors[0], hvd_outputs[0], ops_param->root_rank,
-          ready_event_lists[0], ops_param->op_names[0], device,
-          callbacks[0]);
+      enqueue_result = EnqueueTensorBroadcasts(
+          hvd_contexts, hvd_tensors, hvd_outputs, ops_param->root_rank,
+          ready_event_lists, ops_param->op_names, device, callbacks);
       break;
     case OperationType::ALLTOALL:
     {
@@ -166,6 +194,11 @@ void DoHorovodOperation(void*, void* on_complete_ptr, void* param) {
           device, callbacks[0]);
       break;
     }
+    case OperationType::REDUCESCATTER:
+      enqueue_result = EnqueueTensorReducescatter(
+          hvd_contexts[0], hvd_tensors[0], ready_event_lists[0], ops_param->op_names[0], device,
+          callbacks[0], (average) ? ReduceOp::AVERAGE : ReduceOp::SUM);
+      break;
     default:
       throw std::logic_error("Unsupported Horovod operation type.");
   }
@@ -335,10 +368,9 @@ void DoHorovodOperationCudaOnCPU(void*, void* on_complete_ptr, void* param) {
           callbacks[0]);
       break;
     case OperationType::BROADCAST:
-      enqueue_result = EnqueueTensorBroadcast(
-          hvd_contexts[0], hvd_cpu_buffers[0], hvd_cpu_buffers[0], ops_param->root_rank,
-          ready_event_lists[0], ops_param->op_names[0], device,
-          callbacks[0]);
+      enqueue_result = EnqueueTensorBroadcasts(
+          hvd_contexts, hvd_cpu_buffers, hvd_cpu_buffers, ops_param->root_rank,
+          ready_event_lists, ops_param->op_names, device, callbacks);
       break;
     case OperationType::ALLTOALL:
     {
@@ -348,6 +380,11 @@ void DoHorovodOperationCudaOnCPU(void*, void* on_complete_ptr, void* param) {
           device, callbacks[0]);
       break;
     }
+    case OperationType::REDUCESCATTER:
+      enqueue_result = EnqueueTensorReducescatter(
+          hvd_contexts[0], hvd_cpu_buffers[0], ready_event_lists[0], ops_param->op_names[0], device,
+          callbacks[0], (average) ? ReduceOp::AVERAGE : ReduceOp::SUM);
+      break;
     default:
       throw std::logic_error("Unsupported Horovod operation type.");
   }
@@ -378,19 +415,22 @@ inline void PushHorovodOperationCudaOnCPU(OperationType op_type, NDArray* const
 
   auto base_name = GetOpName(op_type_name, name);
   for (int i = 0; i < num_tensors; ++i) {
-    cpu_input_tensors.emplace_back(std::make_shared<NDArray>(Context::Create(Context::kCPU, 0),
-    inputs[i]->dtype()));
-    cpu_output_tensors.emplace_back(std::make_shared<NDArray>(Context::Create(Context::kCPU, 0),
-    inputs[i]->dtype()));
-
-    // Make async copy of input tensor to CPU tensor.
-    TensorUtil::AsyncCopyCudaToCPU(inputs[i], cpu_input_tensors[i].get());
-
     if (num_tensors > 1) {
       op_names.emplace_back(base_name + "_" + std::to_string(i+1) + "of" + std::to_string(num_tensors));
     } else {
       op_names.emplace_back(base_name);
     }
+
+    auto pinned = Context::CPUPinned(inputs[i]->ctx().real_dev_id());
+    if (name != nullptr) {
+      cpu_input_tensors.emplace_back(GetStagingArray(op_names[i], inputs[i]));
+    } else {
+      cpu_input_tensors.emplace_back(std::make_shared<NDArray>(pinned, inputs[i]->dtype()));
+    }
+    cpu_output_tensors.emplace_back(std::make_shared<NDArray>(pinned, inputs[i]->dtype()));
+
+    // Make async copy of input tensor to CPU tensor.
+    TensorUtil::AsyncCopyCudaToCPU(inputs[i], cpu_input_tensors[i].get());
   }
 
   std::shared_ptr<NDArray> splits_tensor;
@@ -427,13 +467,15 @@ inline void PushHorovodOperationCudaOnCPU(OperationType op_type, NDArray* const
   }
 
   if (op_type == OperationType::ALLGATHER ||
-      op_type == OperationType::ALLTOALL) {
+      op_type == OperationType::ALLTOALL ||
+      op_type == OperationType::REDUCESCATTER) {
     if (splits) {
       // Add splits tensor to input list to enforce dependency on possible async D2H copy
       cpu_input_vars.push_back(splits_tensor->var());
       cpu_output_vars.push_back(received_splits_tensor->var());
     }
-    // Use out-of-place path for operations that have unknown output size (allgather)
+    // Use out-of-place path for operations that have unknown output size
+    // (allgather, alltoall, reducescatter)
     MXEnginePushAsync(DoHorovodOperationCudaOnCPU, ops_param, DeleteMpiOpsParam,
                       &MX_EXEC_CTX, cpu_input_vars.data(), cpu_input_vars.size(), cpu_output_vars.data(), cpu_output_vars.size(),
                       &MX_FUNC_PROP, priority, op_type_name);
@@ -523,24 +565,24 @@ extern "C" int horovod_mxnet_allgather_async(NDArray* input,
   MX_API_END();
 }
 
-extern "C" int horovod_mxnet_broadcast_async(NDArray* input,
-                                             NDArray* output,
+extern "C" int horovod_mxnet_broadcast_async(NDArray* const * inputs,
+                                             NDArray* const * outputs,
                                              const char* name, int root_rank,
-                                             int priority) {
+                                             int priority, int num_tensors) {
   MX_API_BEGIN();
 
 #if HAVE_CUDA && !HOROVOD_GPU_BROADCAST
-  if (IsTensorOnCPU(input) && IsTensorOnCPU(output)) {
-    PushHorovodOperation(OperationType::BROADCAST, &input, &output,
-                         name, priority, 1, root_rank);
+  if (IsTensorOnCPU(inputs[0]) && IsTensorOnCPU(outputs[0])) {
+    PushHorovodOperation(OperationType::BROADCAST, inputs, outputs,
+                         name, priority, num_tensors, root_rank);
 
   } else {
-    PushHorovodOperationCudaOnCPU(OperationType::BROADCAST, &input, &output,
-                                  name, priority, 1, root_rank);
+    PushHorovodOperationCudaOnCPU(OperationType::BROADCAST, inputs, outputs,
+                                  name, priority, num_tensors, root_rank);
   }
 #else
-  PushHorovodOperation(OperationType::BROADCAST, &input, &output,
-                       name, priority, 1, root_rank);
+  PushHorovodOperation(OperationType::BROADCAST, inputs, outputs,
+                       name, priority, num_tensors, root_rank);
 #endif
 
   MX_API_END();
@@ -573,5 +615,27 @@ extern "C" int horovod_mxnet_alltoall_async(NDArray* input,
   MX_API_END();
 }
 
+extern "C" int horovod_mxnet_reducescatter_async(NDArray* input,
+                                                 NDArray* output,
+                                                 const char* name, bool average,
+                                                 int priority) {
+  MX_API_BEGIN();
+
+#if HAVE_CUDA && !HOROVOD_GPU_REDUCESCATTER
+  if (IsTensorOnCPU(input) && IsTensorOnCPU(output)) {
+    PushHorovodOperation(OperationType::REDUCESCATTER, &input, &output,
+                         name, priority, 1, -1, average);
+  } else {
+    PushHorovodOperationCudaOnCPU(OperationType::REDUCESCATTER, &input, &output,
+                                  name, priority, 1, -1, average);
+  }
+#else
+  PushHorovodOperation(OperationType::REDUCESCATTER, &input, &output,
+                       name, priority, 1, -1, average);
+#endif
+
+  MX_API_END();
+}
+
 } // namespace mxnet
 } // namespace horovod
@@ -113,16 +113,20 @@ extern "C" int horovod_mxnet_allreduce_async(NDArray* const * inputs,
 extern "C" int horovod_mxnet_allgather_async(NDArray* input,
                                              NDArray* output,
                                              const char* name, int priority);
-extern "C" int horovod_mxnet_broadcast_async(NDArray* input,
-                                             NDArray* output,
+extern "C" int horovod_mxnet_broadcast_async(NDArray* const * inputs,
+                                             NDArray* const * outputs,
                                              const char* name, int root_rank,
-                                             int priority);
+                                             int priority, int num_tensors);
 extern "C" int horovod_mxnet_alltoall_async(NDArray* input,
                                             NDArray* output,
                                             const char* name,
                                             NDArray* splits,
                                             NDArray* output_received_splits,
                                             int priority);
+extern "C" int horovod_mxnet_reducescatter_async(NDArray* input,
+                                                 NDArray* output,
+                                                 const char* name, bool average,
+                                                 int priority);
 
 } // namespace mxnet
 } // namespace horovod
@@ -58,6 +58,7 @@ ddl_built = _basics.ddl_built
 ccl_built = _basics.ccl_built
 cuda_built = _basics.cuda_built
 rocm_built = _basics.rocm_built
+broadcast_bytes = _basics.broadcast_bytes
 
 dll_path = os.path.join(os.path.dirname(__file__),
                         'mpi_lib' + get_ext_suffix())
@@ -312,16 +313,16 @@ def broadcast(tensor, root_rank, name=None, priority=0):
     else:
         output = mx.nd.zeros(shape=tensor.shape, ctx=tensor.context,
                              dtype=tensor.dtype)
-    c_in = tensor.handle
-    c_out = output.handle
+    c_in = c_handle_array([tensor])
+    c_out = c_handle_array([output])
     if isinstance(name, string_types):
         check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_broadcast_async(
             c_in, c_out, c_str(name), ctypes.c_int(root_rank),
-            ctypes.c_int(priority)))
+            ctypes.c_int(priority), ctypes.c_int(1)))
     else:
         check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_broadcast_async(
             c_in, c_out, name, ctypes.c_int(root_rank),
-            ctypes.c_int(priority)))
+            ctypes.c_int(priority), ctypes.c_int(1)))
     return output
 
 
@@ -346,18 +347,52 @@ def broadcast_(tensor, root_rank, name=None, priority=0):
         A tensor of the same shape and type as `tensor`, with the value
         broadcasted from root rank.
     """
-    c_in = tensor.handle
-    c_out = tensor.handle
+    c_in = c_handle_array([tensor])
+    c_out = c_handle_array([tensor])
     if isinstance(name, string_types):
         check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_broadcast_async(
             c_in, c_out, c_str(name), ctypes.c_int(root_rank),
-            ctypes.c_int(priority)))
+            ctypes.c_int(priority), ctypes.c_int(1)))
     else:
         check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_broadcast_async(
             c_in, c_out, name, ctypes.c_int(root_rank),
-            ctypes.c_int(priority)))
+            ctypes.c_int(priority), ctypes.c_int(1)))
     return tensor
 
+
+def grouped_broadcast_(tensors, root_rank, name=None, priority=0):
+    """
+    A function that broadcasts the input tensors on root rank to the same
+    input tensors on all other Horovod processes. The operation is performed
+    in-place, as one engine operation and one Horovod group.
+
+    The broadcast operations are keyed by the base name. If a base name is not
+    provided, an incremented auto-generated base name is used. The tensor type
+    and shape must be the same on all Horovod processes for tensors sharing
+    positions in the input tensor list. All tensors must be on the same device.
+
+    Arguments:
+        tensors: A list of tensors to broadcast.
+        root_rank: The rank to broadcast the values from.
+        name: A base name to use for the group broadcast operation.
+        priority: The priority of this operation. Higher priority operations
+                  are likely to be executed before other operations.
+
+    Returns:
+        The list of tensors, with the values broadcasted from root rank.
+    """
+    if not tensors:
+        return tensors
+
+    c_in = c_handle_array(tensors)
+    c_out = c_handle_array(tensors)
+    c_name = c_str(name) if isinstance(name, string_types) else ctypes.c_char_p(None)
+
+    check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_broadcast_async(
+        c_in, c_out, c_name, ctypes.c_int(root_rank),
+        ctypes.c_int(priority), ctypes.c_int(len(tensors))))
+    return tensors
+
 def alltoall(tensor, splits=None, name=None, priority=0):
     """
     A function that scatters slices of the input tensor to all other Horovod processes
@@ -417,3 +452,45 @@ def alltoall(tensor, splits=None, name=None, priority=0):
         return output, output_received_splits
     else:
         return output
+
+
+def reducescatter(tensor, average=True, name=None, priority=0):
+    """
+    A function that reduces the input tensor across all Horovod processes and
+    scatters the result along the first dimension, so that each process
+    receives a distinct slice. The input tensor is not modified.
+
+    The input tensors on the different processes must have the same shape. If
+    the first dimension is not divisible by the number of processes, the lower
+    ranks receive one extra slice each.
+
+    Arguments:
+        tensor: A tensor to reduce and scatter.
+        average: If True, computes the average over all ranks.
+                 Otherwise, computes the sum over all ranks.
+        name: A name of the reducescatter operation.
+        priority: The priority of this operation. Higher priority operations
+                  are likely to be executed before other operations.
+
+    Returns:
+        A tensor of the same type as `tensor`, reduced across all processes.
+        The shape is identical to the input shape, except for the first
+        dimension, which holds only the slice owned by this process.
+    """
+    assert(isinstance(tensor, mx.nd.NDArray))
+    # Size of output is unknown, create output array that
+    # will be resized during Horovod operation
+    output = mx.nd.empty(shape=[1], ctx=tensor.context,
+                         dtype=tensor.dtype)
+    c_in = tensor.handle
+    c_out = output.handle
+    if isinstance(name, string_types):
+        check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_reducescatter_async(
+            c_in, c_out, c_str(name), ctypes.c_bool(average), ctypes.c_int(priority)))
+    else:
+        check_call(MPI_MXNET_LIB_CTYPES.horovod_mxnet_reducescatter_async(
+            c_in, c_out, name, ctypes.c_bool(average), ctypes.c_int(priority)))
+
+    # Need to block here so changes to output tensor are visible
+    output.wait_to_read()
+    return output
@@ -20,6 +20,7 @@ class _HorovodArgs(object):
         self.check_build = None
         self.ssh_port = None
         self.ssh_identity_file = None
+        self.ssh_launch_fanout = None
         self.disable_cache = None
         self.start_timeout = None
         self.nic = None
@@ -35,14 +36,17 @@ class _HorovodArgs(object):
         self.fusion_threshold_mb = None
         self.cycle_time_ms = None,
         self.cache_capacity = None,
+        self.cache_max_capacity = None
 
         # hierarchy
         self.hierarchical_allreduce = None
         self.hierarchical_allgather = None
+        self.hierarchical_alltoall = None
 
         # autotune arguments
         self.autotune = None
         self.autotune_log_file = None
+        self.autotune_cache_file = None
         self.autotune_warmup_samples = None
         self.autotune_steps_per_sample = None
         self.autotune_bayes_opt_max_samples = None
@@ -58,6 +62,9 @@ class _HorovodArgs(object):
         # timeline arguments
         self.timeline_filename = None
         self.timeline_mark_cycles = None
+        self.timeline_format = None
+        self.timeline_sample_cycles = None
+        self.timeline_all_ranks = None
 
         # stall check arguments
         self.no_stall_check = None
@@ -72,6 +79,8 @@ class _HorovodArgs(object):
         self.num_nccl_streams = None
         self.thread_affinity = None
         self.gloo_timeout_seconds = None
+        self.gloo_local_transport = None
+        self.gloo_cross_transport = None
 
         # logging arguments
         self.log_level = None
@@ -19,12 +19,15 @@ import logging
 HOROVOD_FUSION_THRESHOLD = 'HOROVOD_FUSION_THRESHOLD'
 HOROVOD_CYCLE_TIME = 'HOROVOD_CYCLE_TIME'
 HOROVOD_CACHE_CAPACITY = 'HOROVOD_CACHE_CAPACITY'
+HOROVOD_CACHE_MAX_CAPACITY = 'HOROVOD_CACHE_MAX_CAPACITY'
 HOROVOD_HIERARCHICAL_ALLREDUCE = 'HOROVOD_HIERARCHICAL_ALLREDUCE'
 HOROVOD_HIERARCHICAL_ALLGATHER = 'HOROVOD_HIERARCHICAL_ALLGATHER'
+HOROVOD_HIERARCHICAL_ALLTOALL = 'HOROVOD_HIERARCHICAL_ALLTOALL'
 
 # Autotune knobs
 HOROVOD_AUTOTUNE = 'HOROVOD_AUTOTUNE'
 HOROVOD_AUTOTUNE_LOG = 'HOROVOD_AUTOTUNE_LOG'
+HOROVOD_AUTOTUNE_CACHE = 'HOROVOD_AUTOTUNE_CACHE'
 HOROVOD_AUTOTUNE_WARMUP_SAMPLES = 'HOROVOD_AUTOTUNE_WARMUP_SAMPLES'
 HOROVOD_AUTOTUNE_STEPS_PER_SAMPLE = 'HOROVOD_AUTOTUNE_STEPS_PER_SAMPLE'
 HOROVOD_AUTOTUNE_BAYES_OPT_MAX_SAMPLES = 'HOROVOD_AUTOTUNE_BAYES_OPT_MAX_SAMPLES'
@@ -33,6 +36,9 @@ HOROVOD_AUTOTUNE_GAUSSIAN_PROCESS_NOISE = 'HOROVOD_AUTOTUNE_GAUSSIAN_PROCESS_NOI
 # Timeline knobs
 HOROVOD_TIMELINE = 'HOROVOD_TIMELINE'
 HOROVOD_TIMELINE_MARK_CYCLES = 'HOROVOD_TIMELINE_MARK_CYCLES'
+HOROVOD_TIMELINE_FORMAT = 'HOROVOD_TIMELINE_FORMAT'
+HOROVOD_TIMELINE_SAMPLE_CYCLES = 'HOROVOD_TIMELINE_SAMPLE_CYCLES'
+HOROVOD_TIMELINE_ALL_RANKS = 'HOROVOD_TIMELINE_ALL_RANKS'
 
 # Stall check knobs
 HOROVOD_STALL_CHECK_DISABLE = 'HOROVOD_STALL_CHECK_DISABLE'
@@ -45,6 +51,10 @@ HOROVOD_NUM_NCCL_STREAMS = 'HOROVOD_NUM_NCCL_STREAMS'
 NCCL_IB_DISABLE = 'NCCL_IB_DISABLE'
 HOROVOD_THREAD_AFFINITY = 'HOROVOD_THREAD_AFFINITY'
 HOROVOD_GLOO_TIMEOUT_SECONDS = 'HOROVOD_GLOO_TIMEOUT_SECONDS'
+HOROVOD_GLOO_LOCAL_TRANSPORT = 'HOROVOD_GLOO_LOCAL_TRANSPORT'
+HOROVOD_GLOO_CROSS_TRANSPORT = 'HOROVOD_GLOO_CROSS_TRANSPORT'
+GLOO_LOCAL_TRANSPORTS = ['tcp', 'loopback', 'ibverbs']
+GLOO_CROSS_TRANSPORTS = ['tcp', 'ibverbs']
 
 # Logging knobs
 HOROVOD_LOG_LEVEL = 'HOROVOD_LOG_LEVEL'
@@ -79,14 +89,17 @@ def set_args_from_config(args, config, override_args):
         _set_arg_from_config(args, 'fusion_threshold_mb', override_args, params)
         _set_arg_from_config(args, 'cycle_time_ms', override_args, params)
         _set_arg_from_config(args, 'cache_capacity', override_args, params)
+        _set_arg_from_config(args, 'cache_max_capacity', override_args, params)
         _set_arg_from_config(args, 'hierarchical_allreduce', override_args, params)
         _set_arg_from_config(args, 'hierarchical_allgather', override_args, params)
+        _set_arg_from_config(args, 'hierarchical_alltoall', override_args, params)
 
     # Autotune
     autotune = config.get('autotune')
     if autotune:
         args.autotune = autotune.get('enabled', False) if 'autotune' not in override_args else args.autotune
         _set_arg_from_config(args, 'log_file', override_args, autotune, arg_prefix='autotune_')
+        _set_arg_from_config(args, 'cache_file', override_args, autotune, arg_prefix='autotune_')
         _set_arg_from_config(args, 'warmup_samples', override_args, autotune, arg_prefix='autotune_')
         _set_arg_from_config(args, 'steps_per_sample', override_args, autotune, arg_prefix='autotune_')
         _set_arg_from_config(args, 'bayes_opt_max_samples', override_args, autotune, arg_prefix='autotune_')
@@ -97,6 +110,9 @@ def set_args_from_config(args, config, override_args):
     if timeline:
         _set_arg_from_config(args, 'filename', override_args, timeline, arg_prefix='timeline_')
         _set_arg_from_config(args, 'mark_cycles', override_args, timeline, arg_prefix='timeline_')
+        _set_arg_from_config(args, 'format', override_args, timeline, arg_prefix='timeline_')
+        _set_arg_from_config(args, 'sample_cycles', override_args, timeline, arg_prefix='timeline_')
+        _set_arg_from_config(args, 'all_ranks', override_args, timeline, arg_prefix='timeline_')
 
     # Stall Check
     stall_check = config.get('stall_check')
@@ -113,6 +129,8 @@ def set_args_from_config(args, config, override_args):
         _set_arg_from_config(args, 'num_nccl_streams', override_args, library_options)
         _set_arg_from_config(args, 'thread_affinity', override_args, library_options)
         _set_arg_from_config(args, 'gloo_timeout_seconds', override_args, library_options)
+        _set_arg_from_config(args, 'gloo_local_transport', override_args, library_options)
+        _set_arg_from_config(args, 'gloo_cross_transport', override_args, library_options)
 
     # Logging
     logging = config.get('logging')
@@ -131,6 +149,7 @@ def validate_config_args(args):
     _validate_arg_nonnegative(args, 'fusion_threshold_mb')
     _validate_arg_nonnegative(args, 'cycle_time_ms')
     _validate_arg_nonnegative(args, 'cache_capacity')
+    _validate_arg_nonnegative(args, 'cache_max_capacity')
     _validate_arg_nonnegative(args, 'autotune_warmup_samples')
     _validate_arg_nonnegative(args, 'autotune_steps_per_sample')
     _validate_arg_nonnegative(args, 'autotune_bayes_opt_max_samples')
@@ -166,13 +185,16 @@ def set_env_from_args(env, args):
     _add_arg_to_env(env, HOROVOD_FUSION_THRESHOLD, args.fusion_threshold_mb, lambda v: v * 1024 * 1024)
     _add_arg_to_env(env, HOROVOD_CYCLE_TIME, args.cycle_time_ms)
     _add_arg_to_env(env, HOROVOD_CACHE_CAPACITY, args.cache_capacity)
+    _add_arg_to_env(env, HOROVOD_CACHE_MAX_CAPACITY, args.cache_max_capacity)
     _add_arg_to_env(env, HOROVOD_HIERARCHICAL_ALLREDUCE, args.hierarchical_allreduce, identity)
     _add_arg_to_env(env, HOROVOD_HIERARCHICAL_ALLGATHER, args.hierarchical_allgather, identity)
+    _add_arg_to_env(env, HOROVOD_HIERARCHICAL_ALLTOALL, args.hierarchical_alltoall, identity)
 
     # Autotune
     if args.autotune:
         _add_arg_to_env(env, HOROVOD_AUTOTUNE, args.autotune, identity)
         _add_arg_to_env(env, HOROVOD_AUTOTUNE_LOG, args.autotune_log_file)
+        _add_arg_to_env(env, HOROVOD_AUTOTUNE_CACHE, args.autotune_cache_file)
         _add_arg_to_env(env, HOROVOD_AUTOTUNE_WARMUP_SAMPLES, args.autotune_warmup_samples)
         _add_arg_to_env(env, HOROVOD_AUTOTUNE_STEPS_PER_SAMPLE, args.autotune_steps_per_sample)
         _add_arg_to_env(env, HOROVOD_AUTOTUNE_BAYES_OPT_MAX_SAMPLES, args.autotune_bayes_opt_max_samples)
@@ -182,6 +204,9 @@ def set_env_from_args(env, args):
     if args.timeline_filename:
         _add_arg_to_env(env, HOROVOD_TIMELINE, args.timeline_filename)
         _add_arg_to_env(env, HOROVOD_TIMELINE_MARK_CYCLES, args.timeline_mark_cycles, identity)
+        _add_arg_to_env(env, HOROVOD_TIMELINE_FORMAT, args.timeline_format)
+        _add_arg_to_env(env, HOROVOD_TIMELINE_SAMPLE_CYCLES, args.timeline_sample_cycles)
+        _add_arg_to_env(env, HOROVOD_TIMELINE_ALL_RANKS, args.timeline_all_ranks, identity)
 
     # Stall Check
     _add_arg_to_env(env, HOROVOD_STALL_CHECK_DISABLE, args.no_stall_check, identity)
@@ -194,6 +219,8 @@ def set_env_from_args(env, args):
     _add_arg_to_env(env, NCCL_IB_DISABLE, 1 if args.tcp_flag else None)
     _add_arg_to_env(env, HOROVOD_THREAD_AFFINITY, args.thread_affinity)
     _add_arg_to_env(env, HOROVOD_GLOO_TIMEOUT_SECONDS, args.gloo_timeout_seconds)
+    _add_arg_to_env(env, HOROVOD_GLOO_LOCAL_TRANSPORT, args.gloo_local_transport)
+    _add_arg_to_env(env, HOROVOD_GLOO_CROSS_TRANSPORT, args.gloo_cross_transport)
 
     # Logging
     _add_arg_to_env(env, HOROVOD_LOG_LEVEL, args.log_level)
@@ -17,7 +17,8 @@
 class BaseSettings(object):
     def __init__(self, num_proc=None, verbose=0, ssh_port=None, ssh_identity_file=None, extra_mpi_args=None,
                  tcp_flag=None, binding_args=None, key=None, start_timeout=None, output_filename=None,
-                 run_func_mode=None, nics=None, elastic=False, prefix_output_with_timestamp=False):
+                 run_func_mode=None, nics=None, elastic=False, prefix_output_with_timestamp=False,
+                 launch_fanout=0):
         """
         :param num_proc: number of horovod processes (-np)
         :type num_proc: int
@@ -47,6 +48,9 @@ class BaseSettings(object):
         :type elastic: boolean
         :param prefix_output_with_timestamp: shows timestamp in stdout/stderr forwarding on the driver
         :type prefix_output_with_timestamp: boolean
+        :param launch_fanout: number of hosts the driver and each host launch the task servers of the
+                              interface check on over ssh, 0 to launch all of them from the driver
+        :type launch_fanout: int
         """
         self.num_proc = num_proc
         self.verbose = verbose
@@ -62,6 +66,7 @@ class BaseSettings(object):
         self.nics = nics
         self.elastic = elastic
         self.prefix_output_with_timestamp = prefix_output_with_timestamp
+        self.launch_fanout = launch_fanout
 
 
 class Settings(BaseSettings):
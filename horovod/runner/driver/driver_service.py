@@ -46,6 +46,74 @@ class HorovodRunDriverClient(driver_service.BasicDriverClient):
             match_intf=match_intf)
 
 
+def _exec_command(command):
+    host_output = io.StringIO()
+    try:
+        exit_code = safe_shell_exec.execute(command,
+                                            stdout=host_output,
+                                            stderr=host_output)
+        if exit_code != 0:
+            print(
+                'Launching horovod task function was not '
+                'successful:\n{host_output}'
+                .format(host_output=host_output.getvalue()))
+            os._exit(exit_code)
+    finally:
+        host_output.close()
+    return exit_code
+
+
+def _task_fn_command(index, num_hosts, driver_addresses, settings,
+                     subtree=None):
+    command = \
+        '{python} -m horovod.runner.task_fn {index} {num_hosts} ' \
+        '{driver_addresses} {settings}' \
+        .format(python=sys.executable,
+                index=codec.dumps_base64(index),
+                num_hosts=codec.dumps_base64(num_hosts),
+                driver_addresses=codec.dumps_base64(driver_addresses),
+                settings=codec.dumps_base64(settings))
+    if subtree:
+        command += ' ' + codec.dumps_base64(subtree)
+    return command
+
+
+def _split_subtrees(hosts, fanout):
+    """
+    Splits hosts, a list of (index, host name) pairs, into at most fanout
+    contiguous parts of about the same size. The first host of each part is
+    launched over ssh and launches the rest of its part in turn.
+    """
+    num_parts = min(fanout, len(hosts))
+    parts = []
+    start = 0
+    for part in range(num_parts):
+        end = start + (len(hosts) - start) // (num_parts - part)
+        parts.append(hosts[start:end])
+        start = end
+    return parts
+
+
+def _subtree_commands(subtrees, num_hosts, driver_addresses, settings):
+    """
+    Commands that launch the task function on the first host of each of
+    subtrees over ssh, passing it the rest of its subtree.
+    """
+    args_list = []
+    for subtree in subtrees:
+        index, host_name = subtree[0]
+        command = _task_fn_command(index, num_hosts, driver_addresses,
+                                   settings, subtree[1:])
+        command = get_remote_command(command,
+                                     host=host_name,
+                                     port=settings.ssh_port,
+                                     identity_file=settings.ssh_identity_file)
+        if settings.verbose >= 2:
+            print('Launching horovod task function: {}'.format(command))
+        args_list.append([command])
+    return args_list
+
+
 def _launch_task_servers(all_host_names, local_host_names, driver_addresses,
                          settings):
     """
@@ -72,44 +140,27 @@ def _launch_task_servers(all_host_names, local_host_names, driver_addresses,
     :return:
     :rtype:
     """
-
-    def _exec_command(command):
-        host_output = io.StringIO()
-        try:
-            exit_code = safe_shell_exec.execute(command,
-                                                stdout=host_output,
-                                                stderr=host_output)
-            if exit_code != 0:
-                print(
-                    'Launching horovod task function was not '
-                    'successful:\n{host_output}'
-                    .format(host_output=host_output.getvalue()))
-                os._exit(exit_code)
-        finally:
-            host_output.close()
-        return exit_code
-
     args_list = []
+    remote_hosts = []
     num_hosts = len(all_host_names)
     for index in range(num_hosts):
         host_name = all_host_names[index]
-        command = \
-            '{python} -m horovod.runner.task_fn {index} {num_hosts} ' \
-            '{driver_addresses} {settings}' \
-            .format(python=sys.executable,
-                    index=codec.dumps_base64(index),
-                    num_hosts=codec.dumps_base64(num_hosts),
-                    driver_addresses=codec.dumps_base64(driver_addresses),
-                    settings=codec.dumps_base64(settings))
         if host_name not in local_host_names:
-            command = get_remote_command(command,
-                                         host=host_name,
-                                         port=settings.ssh_port,
-                                         identity_file=settings.ssh_identity_file)
-
+            remote_hosts.append((index, host_name))
+            continue
+        command = _task_fn_command(index, num_hosts, driver_addresses, settings)
         if settings.verbose >= 2:
             print('Launching horovod task function: {}'.format(command))
         args_list.append([command])
+
+    # With a fanout, the remote hosts launch each other in a tree, so that
+    # the driver only opens that many ssh sessions.
+    if settings.launch_fanout > 0:
+        subtrees = _split_subtrees(remote_hosts, settings.launch_fanout)
+    else:
+        subtrees = [[host] for host in remote_hosts]
+    args_list += _subtree_commands(subtrees, num_hosts, driver_addresses,
+                                   settings)
     # Each thread will use ssh command to launch the server on one task. If an
     # error occurs in one thread, entire process will be terminated. Otherwise,
     # threads will keep running and ssh session -- and the the task server --
@@ -248,8 +299,10 @@ def get_common_interfaces(settings, all_host_names, remote_host_names=None, fn_c
             if settings.verbose >= 2:
                 print('Testing interfaces on all the hosts.')
 
+            # Sorted so that the cached result is found for any order of the
+            # same hosts.
             local_host_names = set(all_host_names) - set(remote_host_names)
-            nics = _driver_fn(all_host_names, local_host_names, settings, fn_cache=fn_cache)
+            nics = _driver_fn(sorted(all_host_names), local_host_names, settings, fn_cache=fn_cache)
 
             if settings.verbose >= 2:
                 print('Interfaces on all the hosts were successfully checked.')
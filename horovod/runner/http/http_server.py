@@ -20,6 +20,7 @@ import socketserver
 import threading
 
 from http.server import HTTPServer, SimpleHTTPRequestHandler
+from urllib.parse import parse_qs, urlsplit
 
 from horovod.runner.util.network import find_port
 from horovod.runner.util.threads import in_thread
@@ -31,6 +32,10 @@ BAD_REQUEST = 400
 TIMEOUT = 408
 OK = 200
 
+# Longest time a batched GET waits for its keys before answering with the
+# keys present so far
+MAX_WAIT_MILLISECONDS = 5000
+
 
 class KVStoreHandler(SimpleHTTPRequestHandler):
     # Set timeout
@@ -105,11 +110,52 @@ class KVStoreHandler(SimpleHTTPRequestHandler):
         with self.server.cache_lock:
             scope_dict = self.server.cache.setdefault(scope, {})
             scope_dict[key] = value
+            self.server.cache_cond.notify_all()
             if self.server.verbose:
                 logging.info('scope %s has keys %s', scope, list(self.server.cache[scope].keys()))
 
 
 class RendezvousHandler(KVStoreHandler):
+    # Override GET handler to add batched, long-polling GETs:
+    #   GET /<scope>/?keys=<key>,<key>,...&wait=<milliseconds>
+    # waits until all keys are set or the wait time passed and responds with
+    # the keys found, each encoded as "<key length>:<value length>:<key><value>".
+    def do_GET(self):
+        if '?' not in self.path:
+            return super(RendezvousHandler, self).do_GET()
+
+        url = urlsplit(self.path)
+        paths = url.path.split('/')
+        query = parse_qs(url.query)
+        if len(paths) < 2 or 'keys' not in query:
+            logging.error(
+                'Rendezvous ERROR: Invalid request path: {path}.'.format(
+                    path=self.path))
+            self.send_status_code(BAD_REQUEST)
+            return
+
+        scope = paths[1]
+        keys = [key for key in query['keys'][0].split(',') if key]
+        try:
+            wait = min(int(query.get('wait', ['0'])[0]), MAX_WAIT_MILLISECONDS)
+        except ValueError:
+            self.send_status_code(BAD_REQUEST)
+            return
+
+        with self.server.cache_cond:
+            self.server.cache_cond.wait_for(
+                lambda: all(key in self.server.cache.get(scope, {}) for key in keys),
+                timeout=wait / 1000.0)
+            scope_dict = self.server.cache.get(scope, {})
+            found = [(key, scope_dict[key]) for key in keys if key in scope_dict]
+
+        body = b''.join(b'%d:%d:' % (len(key.encode()), len(value)) + key.encode() + value
+                        for key, value in found)
+        self.send_response(OK)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
     # Override DELETE handler
     def do_DELETE(self):
         paths = self.path.split('/')
@@ -157,6 +203,7 @@ class RendezvousHTTPServer(socketserver.ThreadingMixIn, HTTPServer, object):
 
         # Cache that provides the store
         self.cache_lock = threading.Lock()
+        self.cache_cond = threading.Condition(self.cache_lock)
         self.cache = {}
 
         self.verbose = verbose
@@ -224,6 +271,7 @@ class KVStoreHTTPServer(HTTPServer, object):
 
         # Cache that provides the store
         self.cache_lock = threading.Lock()
+        self.cache_cond = threading.Condition(self.cache_lock)
         self.cache = {}
 
         self.verbose = verbose
@@ -300,6 +300,12 @@ def parse_args():
                            type=int, help='SSH port on all the hosts.')
     group_ssh.add_argument('-i', '--ssh-identity-file', action='store', dest='ssh_identity_file',
                            help='File on the driver from which the identity (private key) is read.')
+    group_ssh.add_argument('--ssh-launch-fanout', action='store', dest='ssh_launch_fanout',
+                           type=int, default=0,
+                           help='Number of hosts the driver starts the interface check on over ssh, '
+                                'each of which starts it on as many of the remaining hosts, and so on. '
+                                'Shortens startup on many hosts, but requires ssh between the hosts. '
+                                'By default, the driver starts it on all hosts.')
 
     group_params = parser.add_argument_group('tuneable parameter arguments')
     group_params.add_argument('--fusion-threshold-mb', action=make_override_action(override_args), type=int,
@@ -316,6 +322,9 @@ def parse_args():
                               help='Maximum number of tensor names that will be cached to reduce amount '
                                    'of coordination required between workers before performing allreduce / '
                                    'allgather. (default: 1024')
+    group_params.add_argument('--cache-max-capacity', action=make_override_action(override_args), type=int,
+                              help='Capacity up to which a full response cache doubles in size instead '
+                                   'of evicting responses. (default: 16384)')
 
     group_hierarchical_allreduce = group_params.add_mutually_exclusive_group()
     group_hierarchical_allreduce.add_argument('--hierarchical-allreduce',
@@ -340,6 +349,16 @@ def parse_args():
                                               help='Explicitly disable hierarchical allgather to prevent autotuning '
                                                    'from adjusting it.')
 
+    group_hierarchical_alltoall = group_params.add_mutually_exclusive_group()
+    group_hierarchical_alltoall.add_argument('--hierarchical-alltoall',
+                                             action=make_override_true_action(override_args),
+                                             help='Perform hierarchical alltoall between workers with NCCL. Data '
+                                                  'is first exchanged within a host, then each local rank sends one '
+                                                  'coalesced message per remote host to its equal local rank there.')
+    group_hierarchical_alltoall.add_argument('--no-hierarchical-alltoall', dest='hierarchical_alltoall',
+                                             action=make_override_false_action(override_args),
+                                             help='Explicitly disable hierarchical alltoall.')
+
     group_autotune = parser.add_argument_group('autotune arguments')
     group_autotune_enabled = group_autotune.add_mutually_exclusive_group()
     group_autotune_enabled.add_argument('--autotune', action=make_override_true_action(override_args),
@@ -352,6 +371,10 @@ def parse_args():
                                 help='Comma-separated log of trials containing each hyperparameter and the '
                                      'score of the trial. The last row will always contain the best value '
                                      'found.')
+    group_autotune.add_argument('--autotune-cache-file', action=make_override_action(override_args),
+                                help='File with the best parameters of earlier runs. If it has an entry for the '
+                                     'same model and number of processes per node, autotuning uses those values '
+                                     'instead of searching. Otherwise the result of this run is added to it.')
     group_autotune.add_argument('--autotune-warmup-samples', action=make_override_action(override_args),
                                 type=int,
                                 help='Number of samples to discard before beginning the optimization process '
@@ -404,6 +427,23 @@ def parse_args():
                                             'is provided.')
     group_timeline_cycles.add_argument('--no-timeline-mark-cycles', dest='timeline_mark_cycles',
                                        action=make_override_false_action(override_args), help=argparse.SUPPRESS)
+    group_timeline.add_argument('--timeline-format', action=make_override_action(override_args),
+                                choices=['json', 'binary'],
+                                help='Format of the timeline file. The binary format is much smaller and '
+                                     'cheaper to write, and is converted to JSON with '
+                                     '`python -m horovod.common.timeline_converter`. (default: json)')
+    group_timeline.add_argument('--timeline-sample-cycles', action=make_override_action(override_args),
+                                type=int,
+                                help='Only record the operations started in one of every N cycles. '
+                                     '(default: 1)')
+    group_timeline_ranks = group_timeline.add_mutually_exclusive_group()
+    group_timeline_ranks.add_argument('--timeline-all-ranks', action=make_override_true_action(override_args),
+                                      help='Write a timeline on every rank, named after the timeline filename '
+                                           'with the rank inserted before the extension, instead of only on '
+                                           'rank 0. Merge them with `python -m horovod.common.timeline_merge` '
+                                           'to find straggling ranks.')
+    group_timeline_ranks.add_argument('--no-timeline-all-ranks', dest='timeline_all_ranks',
+                                      action=make_override_false_action(override_args), help=argparse.SUPPRESS)
 
     group_stall_check = parser.add_argument_group('stall check arguments')
     group_stall_check_enabled = group_stall_check.add_mutually_exclusive_group()
@@ -450,6 +490,16 @@ def parse_args():
                                        type=int,
                                        help='Timeout in seconds for Gloo operations to complete. '
                                             '(default: 30')
+    group_library_options.add_argument('--gloo-local-transport', action=make_override_action(override_args),
+                                       choices=config_parser.GLOO_LOCAL_TRANSPORTS,
+                                       help='Gloo transport between processes on the same host. loopback connects '
+                                            'over 127.0.0.1, ibverbs requires Horovod built with '
+                                            'HOROVOD_GLOO_WITH_IBVERBS=1. (default: tcp)')
+    group_library_options.add_argument('--gloo-cross-transport', action=make_override_action(override_args),
+                                       choices=config_parser.GLOO_CROSS_TRANSPORTS,
+                                       help='Gloo transport between processes on different hosts. ibverbs '
+                                            'requires Horovod built with HOROVOD_GLOO_WITH_IBVERBS=1. '
+                                            '(default: tcp)')
 
     group_logging = parser.add_argument_group('logging arguments')
     group_logging.add_argument('--log-level', action=make_override_action(override_args),
@@ -551,12 +601,14 @@ def _run_static(args):
                                      output_filename=args.output_filename,
                                      run_func_mode=args.run_func is not None,
                                      nics=args.nics,
-                                     prefix_output_with_timestamp=args.prefix_output_with_timestamp)
+                                     prefix_output_with_timestamp=args.prefix_output_with_timestamp,
+                                     launch_fanout=args.ssh_launch_fanout or 0)
 
     # This cache stores the results of checks performed by horovod
     # during the initialization step. It can be disabled by setting
     # --disable-cache flag.
     fn_cache = None
+    nics_cache = None
     if not args.disable_cache:
         params = ''
         if args.np:
@@ -570,6 +622,12 @@ def _run_static(args):
         parameters_hash = hashlib.md5(params.encode('utf-8')).hexdigest()
         fn_cache = cache.Cache(CACHE_FOLDER, CACHE_STALENESS_THRESHOLD_MINUTES,
                                parameters_hash)
+        # The common interfaces only depend on the set of hosts, so they are
+        # kept apart from the checks that change with -np and the slots.
+        nics_params = '{} {}'.format(args.ssh_port, args.ssh_identity_file)
+        nics_cache = cache.Cache(os.path.join(CACHE_FOLDER, 'nics'),
+                                 CACHE_STALENESS_THRESHOLD_MINUTES,
+                                 hashlib.md5(nics_params.encode('utf-8')).hexdigest())
 
     all_host_names, _ = hosts.parse_hosts_and_slots(args.hosts)
     if settings.verbose >= 2:
@@ -589,7 +647,7 @@ def _run_static(args):
             print('SSH was successful into all the remote hosts.')
 
     nics = driver_service.get_common_interfaces(settings, all_host_names,
-                                                remote_host_names, fn_cache)
+                                                remote_host_names, nics_cache)
 
     if args.run_func:
         # get the driver IPv4 address
@@ -657,7 +715,8 @@ def _run_elastic(args):
                                                 output_filename=args.output_filename,
                                                 run_func_mode=args.run_func is not None,
                                                 nics=args.nics,
-                                                prefix_output_with_timestamp=args.prefix_output_with_timestamp)
+                                                prefix_output_with_timestamp=args.prefix_output_with_timestamp,
+                                                launch_fanout=args.ssh_launch_fanout or 0)
 
     if not gloo_built(verbose=(settings.verbose >= 2)):
         raise ValueError('Gloo support is required to use elastic training, but has not been built.  Ensure CMake is '
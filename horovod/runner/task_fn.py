@@ -18,9 +18,22 @@ import sys
 from horovod.runner.common.util import codec, host_hash
 from horovod.runner.driver import driver_service
 from horovod.runner.task import task_service
+from horovod.runner.util import threads
 
 
-def _task_fn(index, num_hosts, driver_addresses, settings):
+def _task_fn(index, num_hosts, driver_addresses, settings, subtree=None):
+    # Launches the task function on the hosts of subtree, which this host is
+    # the root of, and waits for them before exiting so that their ssh
+    # sessions stay open.
+    launcher = None
+    if subtree:
+        args_list = driver_service._subtree_commands(
+            driver_service._split_subtrees(subtree, settings.launch_fanout),
+            num_hosts, driver_addresses, settings)
+        launcher = threads.in_thread(
+            threads.execute_function_multithreaded,
+            (driver_service._exec_command, args_list), daemon=False)
+
     task = task_service.HorovodRunTaskService(index, settings.key, settings.nics)
     try:
         driver = driver_service.HorovodRunDriverClient(
@@ -52,15 +65,19 @@ def _task_fn(index, num_hosts, driver_addresses, settings):
     finally:
         task.shutdown()
 
+    if launcher:
+        launcher.join()
+
 
 if __name__ == '__main__':
-    if len(sys.argv) != 5:
-        print('Usage: {} <index> <num_hosts> <driver_addresses> <settings>'.format(sys.argv[0]))
+    if len(sys.argv) not in (5, 6):
+        print('Usage: {} <index> <num_hosts> <driver_addresses> <settings> [<subtree>]'.format(sys.argv[0]))
         sys.exit(1)
 
     index = codec.loads_base64(sys.argv[1])
     num_hosts = codec.loads_base64(sys.argv[2])
     driver_addresses = codec.loads_base64(sys.argv[3])
     settings = codec.loads_base64(sys.argv[4])
+    subtree = codec.loads_base64(sys.argv[5]) if len(sys.argv) == 6 else None
 
-    _task_fn(index, num_hosts, driver_addresses, settings)
+    _task_fn(index, num_hosts, driver_addresses, settings, subtree)
@@ -29,6 +29,10 @@ class EstimatorParams(Params):
     val_reader_num_workers = Param(Params._dummy(), 'val_reader_num_workers',
                                    'number of parallel worker processes to read validation data')
     reader_pool_type = Param(Params._dummy(), 'reader_pool_type', 'type of worker pool to read data')
+    disk_cache_path = Param(Params._dummy(), 'disk_cache_path',
+                            'local directory in which workers cache the data they read')
+    disk_cache_size = Param(Params._dummy(), 'disk_cache_size',
+                            'size limit in bytes of the local disk cache of every reader')
     optimizer = Param(Params._dummy(), 'optimizer', 'optimizer')
     model = Param(Params._dummy(), 'model', 'model')
     backend = Param(Params._dummy(), 'backend', 'backend')
@@ -124,6 +128,8 @@ class EstimatorParams(Params):
             train_reader_num_workers=2,
             val_reader_num_workers=2,
             reader_pool_type='process',
+            disk_cache_path=None,
+            disk_cache_size=10 * 1024 ** 3,
             label_shapes=None)
 
     def _check_params(self, metadata):
@@ -317,6 +323,18 @@ class EstimatorParams(Params):
     def getReaderPoolType(self):
         return self.getOrDefault(self.reader_pool_type)
 
+    def setDiskCachePath(self, value):
+        return self._set(disk_cache_path=value)
+
+    def getDiskCachePath(self):
+        return self.getOrDefault(self.disk_cache_path)
+
+    def setDiskCacheSize(self, value):
+        return self._set(disk_cache_size=value)
+
+    def getDiskCacheSize(self):
+        return self.getOrDefault(self.disk_cache_size)
+
     def setLabelShapes(self, value):
         return self._set(label_shapes=value)
 
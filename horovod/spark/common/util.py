@@ -696,6 +696,21 @@ def to_list(var, length):
     return var
 
 
+def disk_cache_reader_kwargs(disk_cache_path, disk_cache_size, avg_row_size, name):
+    """
+    Returns the Petastorm reader arguments that cache the row groups a reader decodes in
+    disk_cache_path/name, so that later epochs read them from local disk instead of the store.
+    Empty if disk_cache_path is not set.
+    """
+    if not disk_cache_path:
+        return dict()
+    return dict(cache_type='local-disk',
+                cache_location=os.path.join(disk_cache_path, name),
+                cache_size_limit=disk_cache_size,
+                cache_row_size_estimate=max(int(avg_row_size), 1),
+                cache_extra_settings=dict(cleanup=True))
+
+
 def _get_assigned_gpu_or_default(default):
     from horovod.spark.task import get_available_devices
     available_devices = get_available_devices()
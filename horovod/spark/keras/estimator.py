@@ -160,6 +160,10 @@ class KerasEstimator(HorovodEstimator, KerasEstimatorParamsReadable,
         val_reader_num_workers: Similar to the train_reader_num_workers.
         reader_pool_type: Type of worker pool used to parallelize reading data from the dataset.
                           Should be one of ['thread', 'process']. Defaults to 'process'.
+        disk_cache_path: Local directory in which every worker caches the row groups it decodes,
+                         so that the epochs after the first one read them from local disk
+                         instead of the store. Defaults to None, no cache.
+        disk_cache_size: Size limit in bytes of the disk cache of every reader. Defaults to 10 GiB.
         inmemory_cache_all: boolean value. Cache the data in memory for training and validation. Default: False.
         backend_env: dict to add to the environment of the backend.  Defaults to setting the java heap size to
                      2G min and max for libhdfs through petastorm
@@ -205,6 +209,8 @@ class KerasEstimator(HorovodEstimator, KerasEstimatorParamsReadable,
                  train_reader_num_workers=None,
                  val_reader_num_workers=None,
                  reader_pool_type=None,
+                 disk_cache_path=None,
+                 disk_cache_size=None,
                  label_shapes=None,
                  checkpoint_callback=None,
                  inmemory_cache_all=False,
@@ -25,7 +25,7 @@ from distutils.version import LooseVersion
 
 from horovod.spark.common import constants
 from horovod.spark.common.store import DBFSLocalStore
-from horovod.spark.common.util import _get_assigned_gpu_or_default
+from horovod.spark.common.util import _get_assigned_gpu_or_default, disk_cache_reader_kwargs
 from horovod.runner.common.util import codec
 
 
@@ -56,6 +56,8 @@ def RemoteTrainer(estimator, metadata, keras_utils, run_id, dataset_idx):
     train_reader_worker_count = estimator.getTrainReaderNumWorker()
     val_reader_worker_count = estimator.getValReaderNumWorker()
     reader_pool_type = estimator.getReaderPoolType()
+    disk_cache_path = estimator.getDiskCachePath()
+    disk_cache_size = estimator.getDiskCacheSize()
 
     # Model parameters
     input_shapes, output_shapes = estimator.get_model_shapes()
@@ -220,6 +222,9 @@ def RemoteTrainer(estimator, metadata, keras_utils, run_id, dataset_idx):
                                 schema_fields=schema_fields,
                                 transform_spec=transform_spec,
                                 storage_options=storage_options,
+                                **disk_cache_reader_kwargs(
+                                    disk_cache_path, disk_cache_size, avg_row_size,
+                                    '{}_train_{}'.format(run_id, hvd.rank())),
                                 **reader_factory_kwargs) as train_reader:
                 with reader_factory(remote_store.val_data_path,
                                     num_epochs=1,
@@ -231,6 +236,9 @@ def RemoteTrainer(estimator, metadata, keras_utils, run_id, dataset_idx):
                                     schema_fields=schema_fields,
                                     transform_spec=transform_spec,
                                     storage_options=storage_options,
+                                    **disk_cache_reader_kwargs(
+                                        disk_cache_path, disk_cache_size, avg_row_size,
+                                        '{}_val_{}'.format(run_id, hvd.rank())),
                                     **reader_factory_kwargs) \
                     if should_validate else empty_batch_reader() as val_reader:
 
@@ -108,6 +108,11 @@ class TorchEstimator(HorovodEstimator, TorchEstimatorParamsWritable,
         batch_size: Number of rows from the DataFrame per batch.
         data_loader_class:  (Optional) Class of the custom data loader, if not set, lightning
                             trainer will use PythonAsyncDataLoader as default.
+        disk_cache_path:    (Optional) Local directory in which every worker caches the row
+                            groups it decodes, so that the epochs after the first one read them
+                            from local disk instead of the store.
+        disk_cache_size:    (Optional) Size limit in bytes of the disk cache of every reader.
+                            Defaults to 10 GiB.
         epochs:     Number of epochs to train.
         feature_cols:   Column names used as feature inputs to the model. Must be a list with
                         each feature mapping to a sequential argument in the model's forward()
@@ -231,6 +236,8 @@ class TorchEstimator(HorovodEstimator, TorchEstimatorParamsWritable,
                  train_reader_num_workers=None,
                  val_reader_num_workers=None,
                  reader_pool_type=None,
+                 disk_cache_path=None,
+                 disk_cache_size=None,
                  label_shapes=None,
                  inmemory_cache_all=False,
                  num_gpus=None,
@@ -27,7 +27,7 @@ from pytorch_lightning.callbacks.model_checkpoint import ModelCheckpoint
 from pytorch_lightning.loggers import TensorBoardLogger
 
 from horovod.spark.common import constants
-from horovod.spark.common.util import _get_assigned_gpu_or_default
+from horovod.spark.common.util import _get_assigned_gpu_or_default, disk_cache_reader_kwargs
 from horovod.spark.lightning.util import deserialize_fn
 
 PETASTORM_HDFS_DRIVER = constants.PETASTORM_HDFS_DRIVER
@@ -66,6 +66,8 @@ def RemoteTrainer(estimator, metadata, ckpt_bytes, run_id, dataset_idx, train_ro
     train_reader_worker_count = estimator.getTrainReaderNumWorker()
     val_reader_worker_count = estimator.getValReaderNumWorker()
     reader_pool_type = estimator.getReaderPoolType()
+    disk_cache_path = estimator.getDiskCachePath()
+    disk_cache_size = estimator.getDiskCacheSize()
 
     # Utility functions
     deserialize = deserialize_fn()
@@ -84,7 +86,8 @@ def RemoteTrainer(estimator, metadata, ckpt_bytes, run_id, dataset_idx, train_ro
 
     set_data_loader = _set_data_loader_fn(transformation, schema_fields, batch_size,
                                           data_loader_cls, loader_num_epochs, store,
-                                          epochs, inmemory_cache_all, verbose)
+                                          epochs, inmemory_cache_all, verbose,
+                                          disk_cache_path, disk_cache_size, avg_row_size, run_id)
 
     def train(serialized_model):
         import horovod.torch as hvd
@@ -220,7 +223,8 @@ def _make_reset_callbacks():
 
 
 def _set_data_loader_fn(transformation, schema_fields, batch_size, data_loader_cls,
-                        loader_num_epochs, store, epochs, inmemory_cache_all=False, verbose=False):
+                        loader_num_epochs, store, epochs, inmemory_cache_all=False, verbose=False,
+                        disk_cache_path=None, disk_cache_size=None, avg_row_size=0, run_id=None):
     storage_options = store.storage_options
 
     @contextlib.contextmanager
@@ -270,6 +274,9 @@ def _set_data_loader_fn(transformation, schema_fields, batch_size, data_loader_c
                             schema_fields=schema_fields,
                             transform_spec=transform_spec,
                             storage_options=storage_options,
+                            **disk_cache_reader_kwargs(
+                                disk_cache_path, disk_cache_size, avg_row_size,
+                                '{}_{}_{}'.format(run_id, name, hvd.rank())),
                             **reader_factory_kwargs) as reader:
             def dataloader_fn():
                 kwargs = dict(reader=reader, batch_size=batch_size,
@@ -144,6 +144,10 @@ class TorchEstimator(HorovodEstimator, TorchEstimatorParamsWritable,
         val_reader_num_workers: Similar to the train_reader_num_workers.
         reader_pool_type: Type of worker pool used to parallelize reading data from the dataset.
                           Should be one of ['thread', 'process']. Defaults to 'process'.
+        disk_cache_path: Local directory in which every worker caches the row groups it decodes,
+                         so that the epochs after the first one read them from local disk
+                         instead of the store. Defaults to None, no cache.
+        disk_cache_size: Size limit in bytes of the disk cache of every reader. Defaults to 10 GiB.
     """
 
     input_shapes = Param(Params._dummy(), 'input_shapes', 'input layer shapes')
@@ -188,6 +192,8 @@ class TorchEstimator(HorovodEstimator, TorchEstimatorParamsWritable,
                  train_reader_num_workers=None,
                  val_reader_num_workers=None,
                  reader_pool_type=None,
+                 disk_cache_path=None,
+                 disk_cache_size=None,
                  label_shapes=None,
                  inmemory_cache_all=False):
 
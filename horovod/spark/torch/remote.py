@@ -23,7 +23,8 @@ import torch
 from torch.utils.tensorboard import SummaryWriter
 
 from horovod.spark.common import constants
-from horovod.spark.common.util import _get_assigned_gpu_or_default, to_list
+from horovod.spark.common.util import _get_assigned_gpu_or_default, disk_cache_reader_kwargs, \
+    to_list
 from horovod.spark.common.store import DBFSLocalStore
 from horovod.spark.torch.util import deserialize_fn
 
@@ -74,6 +75,8 @@ def RemoteTrainer(estimator, metadata, last_checkpoint_state, run_id, dataset_id
     train_reader_worker_count = estimator.getTrainReaderNumWorker()
     val_reader_worker_count = estimator.getValReaderNumWorker()
     reader_pool_type = estimator.getReaderPoolType()
+    disk_cache_path = estimator.getDiskCachePath()
+    disk_cache_size = estimator.getDiskCacheSize()
 
     # Utility functions
     deserialize = deserialize_fn()
@@ -238,6 +241,9 @@ def RemoteTrainer(estimator, metadata, last_checkpoint_state, run_id, dataset_id
                                 schema_fields=schema_fields,
                                 transform_spec=transform_spec,
                                 storage_options=storage_options,
+                                **disk_cache_reader_kwargs(
+                                    disk_cache_path, disk_cache_size, avg_row_size,
+                                    '{}_train_{}'.format(run_id, hvd.rank())),
                                 **reader_factory_kwargs) as train_reader:
                 with reader_factory(remote_store.val_data_path,
                                     num_epochs=None,
@@ -249,6 +255,9 @@ def RemoteTrainer(estimator, metadata, last_checkpoint_state, run_id, dataset_id
                                     schema_fields=schema_fields,
                                     transform_spec=transform_spec,
                                     storage_options=storage_options,
+                                    **disk_cache_reader_kwargs(
+                                        disk_cache_path, disk_cache_size, avg_row_size,
+                                        '{}_val_{}'.format(run_id, hvd.rank())),
                                     **reader_factory_kwargs) \
                     if should_validate else empty_batch_reader() as val_reader:
 
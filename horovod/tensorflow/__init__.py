@@ -27,15 +27,19 @@ from horovod.tensorflow import elastic
 from horovod.tensorflow.compression import Compression
 from horovod.tensorflow.functions import allgather_object, broadcast_object, broadcast_object_fn, broadcast_variables
 from horovod.tensorflow.mpi_ops import allgather, broadcast, _allreduce, _grouped_allreduce, alltoall
+from horovod.tensorflow.mpi_ops import reducescatter
 from horovod.tensorflow.mpi_ops import init, shutdown
 from horovod.tensorflow.mpi_ops import is_initialized, start_timeline, stop_timeline
+from horovod.tensorflow.mpi_ops import metrics, metrics_prometheus
+from horovod.tensorflow.mpi_ops import step_begin, step_end
+from horovod.tensorflow.mpi_ops import memory_usage, release_buffers
 from horovod.tensorflow.mpi_ops import size, local_size, cross_size, rank, local_rank, cross_rank, is_homogeneous
 from horovod.tensorflow.mpi_ops import rank_op, local_rank_op, size_op, local_size_op, process_set_included_op
 from horovod.tensorflow.mpi_ops import mpi_threads_supported, mpi_enabled, mpi_built
 from horovod.tensorflow.mpi_ops import gloo_enabled, gloo_built
 from horovod.tensorflow.mpi_ops import nccl_built, ddl_built, ccl_built, cuda_built, rocm_built
-from horovod.tensorflow.mpi_ops import ProcessSet, global_process_set, add_process_set, remove_process_set
-from horovod.tensorflow.mpi_ops import Average, Sum, Adasum
+from horovod.tensorflow.mpi_ops import ProcessSet, global_process_set, add_process_set, add_process_sets, remove_process_set
+from horovod.tensorflow.mpi_ops import Average, Sum, Adasum, Min, Max, Product
 from horovod.tensorflow.mpi_ops import handle_average_backwards_compatibility, check_num_rank_power_of_2
 from horovod.tensorflow.util import _executing_eagerly, _make_subgraph, _cache, vars_to_refs, refs_to_vars
 from horovod.tensorflow.mpi_ops import join
@@ -52,10 +56,51 @@ if tf.__version__.startswith('2.2.'):
   device_compatibility_check.log_device_compatibility_check = lambda policy_name, skip_local: None
 
 
+def _allreduce_indexed_slices(tensor, op, process_set):
+    horovod_size = tf.cast(size_op(process_set_id=process_set.process_set_id)
+                           if int(os.environ.get("HOROVOD_ELASTIC", 0)) else process_set.size(),
+                           dtype=tensor.values.dtype)
+    if os.environ.get('HOROVOD_SPARSE_ALLREDUCE', 'allgather').lower() == 'alltoall':
+        values, indices = _sparse_allreduce_alltoall(tensor, process_set)
+    else:
+        # For IndexedSlices, do two allgathers instead of an allreduce.
+        values = allgather(tensor.values, process_set=process_set)
+        indices = allgather(tensor.indices, process_set=process_set)
+
+    # To make this operation into an average, divide allgathered values by
+    # the Horovod size.
+    new_values = (values / horovod_size) if op == Average else values
+    return tf.IndexedSlices(new_values, indices,
+                            dense_shape=tensor.dense_shape)
+
+
+def _sparse_allreduce_alltoall(tensor, process_set):
+    """Sums the rows of an IndexedSlices across ranks by sending every row to the rank
+    that owns it (row index modulo the number of ranks) with an alltoall. The owners
+    sum duplicate rows and only the reduced rows are allgathered, so the result grows
+    with the number of unique rows instead of with the number of ranks."""
+    num_owners = tf.cast(size_op(process_set_id=process_set.process_set_id)
+                         if int(os.environ.get("HOROVOD_ELASTIC", 0)) else process_set.size(),
+                         dtype=tf.int32)
+    indices = tf.cast(tensor.indices, tf.int64)
+    owners = tf.cast(tf.math.floormod(indices, tf.cast(num_owners, tf.int64)), tf.int32)
+    order = tf.argsort(owners, stable=True)
+    splits = tf.math.bincount(owners, minlength=num_owners, maxlength=num_owners,
+                              dtype=tf.int32)
+    values, _ = alltoall(tf.gather(tensor.values, order), splits=splits, process_set=process_set)
+    indices, _ = alltoall(tf.gather(indices, order), splits=splits, process_set=process_set)
+
+    unique_indices, positions = tf.unique(indices)
+    values = tf.math.unsorted_segment_sum(values, positions, tf.size(unique_indices))
+    values = allgather(values, process_set=process_set)
+    indices = allgather(unique_indices, process_set=process_set)
+    return values, tf.cast(indices, tensor.indices.dtype)
+
+
 def allreduce(tensor, average=None, device_dense='', device_sparse='',
               compression=Compression.none, op=None,
               prescale_factor=1.0, postscale_factor=1.0,
-              name=None, process_set=global_process_set):
+              name=None, process_set=global_process_set, priority=0):
     """Perform an allreduce on a tf.Tensor or tf.IndexedSlices.
 
     This function performs a bandwidth-optimal ring allreduce on the input
@@ -79,12 +124,16 @@ def allreduce(tensor, average=None, device_dense='', device_sparse='',
                      sent and received by each worker node.  Defaults to not
                      using compression.
         op: The reduction operation to combine tensors across different ranks.
-            Defaults to Average if None is given.
+            Defaults to Average if None is given. Min, Max and Product do not
+            support prescale_factor, postscale_factor or sparse tensors.
         prescale_factor: Multiplicative factor to scale tensor before allreduce.
         postscale_factor: Multiplicative factor to scale tensor after allreduce.
         process_set: Process set object to limit this operation to a subset of
             Horovod processes. Default is the global process set.
         name: A name of the allreduce operation
+        priority: Scheduling priority of the allreduce. When several tensors are
+                  ready at the same time, those with a higher priority are
+                  reduced first. Ignored for tf.IndexedSlices.
 
     Returns:
         A tensor of the same shape and type as `tensor`, summed across all
@@ -97,19 +146,10 @@ def allreduce(tensor, average=None, device_dense='', device_sparse='',
         if op == Adasum:
             raise NotImplementedError('The Adasum reduction does not currently support sparse tensors. As a '
                                       'workaround please pass sparse_as_dense=True to DistributedOptimizer')
+        if op in (Min, Max, Product):
+            raise NotImplementedError('The Min, Max and Product reductions do not support sparse tensors.')
         with tf.device(device_sparse):
-            # For IndexedSlices, do two allgathers instead of an allreduce.
-            horovod_size = tf.cast(size_op(process_set_id=process_set.process_set_id)
-                                   if int(os.environ.get("HOROVOD_ELASTIC", 0)) else process_set.size(),
-                                   dtype=tensor.values.dtype)
-            values = allgather(tensor.values, process_set=process_set)
-            indices = allgather(tensor.indices, process_set=process_set)
-
-            # To make this operation into an average, divide allgathered values by
-            # the Horovod size.
-            new_values = (values / horovod_size) if op == Average else values
-        return tf.IndexedSlices(new_values, indices,
-                                dense_shape=tensor.dense_shape)
+            return _allreduce_indexed_slices(tensor, op, process_set)
     else:
         average_in_framework = False
         if rocm_built():
@@ -125,7 +165,8 @@ def allreduce(tensor, average=None, device_dense='', device_sparse='',
             summed_tensor_compressed = _allreduce(tensor_compressed, op=op,
                                                   prescale_factor=prescale_factor,
                                                   postscale_factor=postscale_factor,
-                                                  name=name, process_set=process_set)
+                                                  name=name, process_set=process_set,
+                                                  priority=priority)
             summed_tensor = compression.decompress(summed_tensor_compressed, ctx)
             if op == Adasum:
                 if process_set != global_process_set:
@@ -150,8 +191,6 @@ def allreduce(tensor, average=None, device_dense='', device_sparse='',
                                       'compile Horovod with HOROVOD_GPU_OPERATIONS=NCCL.')
                         new_tensor = summed_tensor
                 else:
-                    if not check_num_rank_power_of_2(size()):
-                        raise NotImplementedError('Running Adasum with non-power of 2 ranks is not supported yet.')
                     new_tensor = summed_tensor
             else:
                 if rocm_built():
@@ -163,7 +202,7 @@ def allreduce(tensor, average=None, device_dense='', device_sparse='',
 def grouped_allreduce(tensors, average=None, device_dense='', device_sparse='',
                       compression=Compression.none, op=None,
                       prescale_factor=1.0, postscale_factor=1.0,
-                      process_set=global_process_set):
+                      process_set=global_process_set, priority=0):
     if not tensors:
         return tensors
 
@@ -180,28 +219,18 @@ def grouped_allreduce(tensors, average=None, device_dense='', device_sparse='',
         if op == Adasum:
             raise NotImplementedError('The Adasum reduction does not currently support sparse tensors. As a '
                                       'workaround please pass sparse_as_dense=True to DistributedOptimizer')
+        if op in (Min, Max, Product):
+            raise NotImplementedError('The Min, Max and Product reductions do not support sparse tensors.')
         with tf.device(device_sparse):
-            new_values = []
-            for tensor in tensors:
-                # For IndexedSlices, do two allgathers instead of an allreduce.
-                horovod_size = tf.cast(size_op(process_set_id=process_set.process_set_id)
-                                       if int(os.environ.get("HOROVOD_ELASTIC", 0)) else process_set.size(),
-                                       dtype=tensor.values.dtype)
-                values = allgather(tensor.values, process_set=process_set)
-                indices = allgather(tensor.indices, process_set=process_set)
-
-                # To make this operation into an average, divide allgathered values by
-                # the Horovod size.
-                new_values += (values / horovod_size) if op == Average else values
-        return [tf.IndexedSlices(x, indices,
-                                 dense_shape=t.dense_shape) for x,t in zip(new_values, tensors)]
+            return [_allreduce_indexed_slices(tensor, op, process_set) for tensor in tensors]
     else:
         with tf.device(device_dense):
             tensors_compressed, ctxs = zip(*[compression.compress(tensor) for tensor in tensors])
             summed_tensors_compressed = _grouped_allreduce(tensors_compressed, op=op,
                                                            prescale_factor=prescale_factor,
                                                            postscale_factor=postscale_factor,
-                                                           process_set=process_set)
+                                                           process_set=process_set,
+                                                           priority=priority)
             summed_tensors = [compression.decompress(t, ctx) for t, ctx in zip(summed_tensors_compressed, ctxs)]
             if op == Adasum:
                 if process_set != global_process_set:
@@ -228,8 +257,6 @@ def grouped_allreduce(tensors, average=None, device_dense='', device_sparse='',
                                       'compile Horovod with HOROVOD_GPU_OPERATIONS=NCCL.')
                         new_tensors = summed_tensors
                 else:
-                    if not check_num_rank_power_of_2(size()):
-                        raise NotImplementedError('Running Adasum with non-power of 2 ranks is not supported yet.')
                     new_tensors = summed_tensors
             else:
                 if rocm_built():
@@ -405,11 +432,14 @@ def _make_cached_allreduce_grads_fn(name, device_dense, device_sparse,
                                                                op=op,
                                                                prescale_factor=prescale_factor,
                                                                postscale_factor=postscale_factor,
-                                                               process_set=process_set)
+                                                               process_set=process_set,
+                                                               priority=len(grads) - min(index_group))
                     for i in range(len(index_group)):
                         reduce_ops[index_group[i]] = reduce_ops_group[i]
                 return reduce_ops
 
+            # Gradients of the first layers are needed first by the next
+            # forward pass, so they get the highest scheduling priority.
             return [_allreduce_cond(grad,
                                     device_dense=device_dense,
                                     device_sparse=device_sparse,
@@ -417,9 +447,10 @@ def _make_cached_allreduce_grads_fn(name, device_dense, device_sparse,
                                     op=op,
                                     prescale_factor=prescale_factor,
                                     postscale_factor=postscale_factor,
-                                    process_set=process_set)
+                                    process_set=process_set,
+                                    priority=len(grads) - i)
                     if grad is not None else grad
-                    for grad in grads]
+                    for i, grad in enumerate(grads)]
 
     if _executing_eagerly():
         return _make_subgraph(allreduce_grads)
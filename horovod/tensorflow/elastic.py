@@ -62,7 +62,7 @@ def run(func):
 
 
 def _reset():
-    shutdown()
+    shutdown(keep_state=True)
     init()
 
 
@@ -21,7 +21,7 @@ import tensorflow as tf
 
 from tensorflow.python.framework import ops
 
-from horovod.tensorflow.mpi_ops import allgather, broadcast
+from horovod.tensorflow.mpi_ops import allgather, broadcast, broadcast_bytes
 from horovod.tensorflow.mpi_ops import rank, size
 from horovod.tensorflow.util import _cache, _executing_eagerly, _make_subgraph
 
@@ -80,6 +80,11 @@ def broadcast_object(obj, root_rank=0, session=None, name=None):
         else:
             return v.numpy()
 
+    data = cloudpickle.dumps(obj) if rank() == root_rank else None
+    data = broadcast_bytes(data, root_rank)
+    if data is not None:
+        return obj if rank() == root_rank else cloudpickle.loads(data)
+
     if rank() == root_rank:
         b = io.BytesIO()
         cloudpickle.dump(obj, b)
@@ -112,6 +117,11 @@ def broadcast_object_fn(root_rank=0, session=None, name=None):
     session = session or ops.get_default_session()
 
     def _bcast(obj):
+        data = cloudpickle.dumps(obj) if rank() == root_rank else None
+        data = broadcast_bytes(data, root_rank)
+        if data is not None:
+            return obj if rank() == root_rank else cloudpickle.loads(data)
+
         if rank() == root_rank:
             b = io.BytesIO()
             cloudpickle.dump(obj, b)
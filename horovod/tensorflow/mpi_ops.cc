@@ -17,15 +17,16 @@
 // =============================================================================
 
 #include <memory>
-#include <queue>
 #include <thread>
 #include <unordered_map>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/shape_inference.h"
 
 #include "../common/common.h"
+#include "../common/event_pool.h"
 
 #define EIGEN_USE_THREADS
 
@@ -77,6 +78,8 @@ namespace {
     return DT_INT64;
   case common::HOROVOD_FLOAT16:
     return DT_HALF;
+  case common::HOROVOD_BFLOAT16:
+    return DT_BFLOAT16;
   case common::HOROVOD_FLOAT32:
     return DT_FLOAT;
   case common::HOROVOD_FLOAT64:
@@ -125,12 +128,7 @@ common::Status ConvertStatus(const Status& status) {
 int GetDeviceID(OpKernelContext* context);
 
 #if HAVE_GPU
-struct ReadyEventRegistry {
-  std::unordered_map<int, std::queue<gpuEvent_t>> gpu_events;
-  std::mutex mutex;
-};
-
-static ReadyEventRegistry ready_event_registry;
+static common::EventPool<gpuEvent_t> ready_event_pool;
 
 class TFReadyEvent : public common::ReadyEvent {
 public:
@@ -168,9 +166,30 @@ protected:
   ::tensorflow::Tensor tensor_;
 };
 
+#if HAVE_GPU
+// Points into a Horovod output block. The last reader of the tensor was
+// enqueued on stream when the buffer goes away.
+class TFOutputBuffer : public TensorBuffer {
+public:
+  TFOutputBuffer(std::shared_ptr<common::OutputBlock> block, int64_t offset,
+                 size_t size, GpuStreamHandle stream);
+  ~TFOutputBuffer() override;
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override;
+  bool OwnsMemory() const override { return false; }
+
+private:
+  std::shared_ptr<common::OutputBlock> block_;
+  size_t size_;
+  GpuStreamHandle stream_;
+};
+#endif
+
 class TFOpContext : public common::OpContext {
 public:
-  TFOpContext(OpKernelContext* context);
+  // output_index is the output of the op the entry of this context produces.
+  TFOpContext(OpKernelContext* context, int output_index = 0);
   virtual common::Status AllocatePersistent(
       int64_t size, std::shared_ptr<common::PersistentBuffer>* tensor) override;
   virtual common::Status
@@ -182,25 +201,26 @@ public:
   virtual common::Status
   AllocateZeros(int64_t num_elements, common::DataType dtype,
                 std::shared_ptr<common::Tensor>* tensor) override;
+#if HAVE_GPU
+  virtual common::Status
+  AdoptOutput(common::TensorShape shape, common::DataType dtype,
+              std::shared_ptr<common::OutputBlock> block, int64_t offset,
+              std::shared_ptr<common::Tensor>* tensor) override;
+#endif
   virtual common::Framework framework() const override;
   OpKernelContext* GetKernelContext() const;
 
 private:
   OpKernelContext* context_ = nullptr;
+  int output_index_ = 0;
 };
 
 #if HAVE_GPU
 TFReadyEvent::TFReadyEvent(OpKernelContext* context) {
   device_ = GetDeviceID(context);
-  {
-    std::lock_guard<std::mutex> guard(ready_event_registry.mutex);
-    auto& queue = ready_event_registry.gpu_events[device_];
-    if (!queue.empty()) {
-      event_ = queue.front();
-      queue.pop();
-    } else {
-      HVD_GPU_CHECK(gpuEventCreateWithFlags(&event_, gpuEventDisableTiming));
-    }
+  event_ = ready_event_pool.Acquire(device_);
+  if (event_ == nullptr) {
+    HVD_GPU_CHECK(gpuEventCreateWithFlags(&event_, gpuEventDisableTiming));
   }
   auto device_context = context->op_device_context();
   auto stream = stream_executor::gpu::AsGpuStreamValue(device_context->stream());
@@ -217,10 +237,8 @@ gpuEvent_t TFReadyEvent::event() const {
 }
 
 TFReadyEvent::~TFReadyEvent() {
-  {
-    std::lock_guard<std::mutex> guard(ready_event_registry.mutex);
-    auto& queue = ready_event_registry.gpu_events[device_];
-    queue.push(event_);
+  if (!ready_event_pool.Release(device_, event_)) {
+    gpuEventDestroy(event_);
   }
 }
 
@@ -267,6 +285,8 @@ const common::DataType TFTensor::dtype() const {
     return common::HOROVOD_INT64;
   case DT_HALF:
     return common::HOROVOD_FLOAT16;
+  case DT_BFLOAT16:
+    return common::HOROVOD_BFLOAT16;
   case DT_FLOAT:
     return common::HOROVOD_FLOAT32;
   case DT_DOUBLE:
@@ -292,7 +312,25 @@ int64_t TFTensor::size() const { return (int64_t)tensor_.tensor_data().size(); }
 
 const ::tensorflow::Tensor*  TFTensor::tensor() const { return &tensor_; }
 
-TFOpContext::TFOpContext(OpKernelContext* context) : context_(context) {}
+#if HAVE_GPU
+TFOutputBuffer::TFOutputBuffer(std::shared_ptr<common::OutputBlock> block,
+                               int64_t offset, size_t size,
+                               GpuStreamHandle stream)
+    : TensorBuffer((uint8_t*)block->data() + offset), block_(std::move(block)),
+      size_(size), stream_(stream) {}
+
+TFOutputBuffer::~TFOutputBuffer() { block_->RecordRelease(stream_); }
+
+void TFOutputBuffer::FillAllocationDescription(
+    AllocationDescription* proto) const {
+  proto->set_requested_bytes(size_);
+  proto->set_allocated_bytes(size_);
+  proto->set_allocator_name("horovod_output_pool");
+}
+#endif
+
+TFOpContext::TFOpContext(OpKernelContext* context, int output_index)
+    : context_(context), output_index_(output_index) {}
 
 common::Status TFOpContext::AllocatePersistent(
     int64_t size, std::shared_ptr<common::PersistentBuffer>* tensor) {
@@ -307,7 +345,7 @@ common::Status TFOpContext::AllocatePersistent(
 common::Status
 TFOpContext::AllocateOutput(common::TensorShape shape,
                             std::shared_ptr<common::Tensor>* tensor) {
-  return TFOpContext::AllocateOutput(0, shape, tensor);
+  return TFOpContext::AllocateOutput(output_index_, shape, tensor);
 }
 
 common::Status
@@ -377,6 +415,29 @@ TFOpContext::AllocateZeros(int64_t num_elements, common::DataType dtype,
   return ConvertStatus(status);
 }
 
+#if HAVE_GPU
+common::Status
+TFOpContext::AdoptOutput(common::TensorShape shape, common::DataType dtype,
+                         std::shared_ptr<common::OutputBlock> block,
+                         int64_t offset,
+                         std::shared_ptr<common::Tensor>* tensor) {
+  TensorShape tf_shape;
+  for (int idx = 0; idx < shape.dims(); ++idx) {
+    tf_shape.AddDim(shape.dim_size(idx));
+  }
+  auto stream = stream_executor::gpu::AsGpuStreamValue(
+      context_->op_device_context()->stream());
+  auto buffer = new TFOutputBuffer(
+      std::move(block), offset,
+      (size_t)shape.num_elements() * common::DataType_Size(dtype), stream);
+  Tensor tf_tensor(GetTFDataType(dtype), tf_shape, buffer);
+  buffer->Unref();
+  context_->set_output(output_index_, tf_tensor);
+  *tensor = std::make_shared<TFTensor>(tf_tensor);
+  return common::Status::OK();
+}
+#endif
+
 common::Framework TFOpContext::framework() const {
   return common::Framework::TENSORFLOW;
 }
@@ -392,6 +453,20 @@ int GetDeviceID(OpKernelContext* context) {
   return device;
 }
 
+// Makes input index the output index if no other op reads it, so that it is
+// reduced in place. Returns the output, or nullptr if it was not forwarded.
+Tensor* ForwardInput(OpKernelContext* context, int index) {
+  auto& input = context->input(index);
+  std::unique_ptr<Tensor> forwarded = context->forward_input(
+      index, index, input.dtype(), input.shape(),
+      context->output_memory_type(index), context->output_alloc_attr(index));
+  if (forwarded == nullptr) {
+    return nullptr;
+  }
+  context->set_output(index, *forwarded);
+  return context->mutable_output(index);
+}
+
 // On GPU this event will signal that data is ready, and tensors are
 // allocated.
 #if HAVE_GPU
@@ -415,6 +490,7 @@ public:
     OP_REQUIRES_OK(context, context->GetAttr("postscale_factor", &postscale_factor_));
     OP_REQUIRES_OK(context, context->GetAttr("ignore_name_scope", &ignore_name_scope_));
     OP_REQUIRES_OK(context, context->GetAttr("process_set_id", &process_set_id_));
+    OP_REQUIRES_OK(context, context->GetAttr("priority", &priority_));
   }
 
   void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
@@ -429,11 +505,23 @@ public:
       }
     }
     auto device = GetDeviceID(context);
-    auto tensor = context->input(0);
     horovod::common::ReduceOp reduce_op = static_cast<horovod::common::ReduceOp>(reduce_op_);
-    Tensor* output;
-    OP_REQUIRES_OK_ASYNC(
-        context, context->allocate_output(0, tensor.shape(), &output), done);
+    // With pooled outputs Horovod sets the output when it executes the op,
+    // otherwise an input dead after the op is reduced in place. The two are
+    // not mixed, as the entries of a fused response are pooled all or none.
+    bool pooled_output =
+        device != CPU_DEVICE_ID && common::PooledOutputsEnabled();
+    Tensor* output = nullptr;
+    if (!pooled_output) {
+      // Before copying the input, whose second reference to the buffer would
+      // keep it from being forwarded.
+      output = ForwardInput(context, 0);
+    }
+    auto tensor = context->input(0);
+    if (!pooled_output && output == nullptr) {
+      OP_REQUIRES_OK_ASYNC(
+          context, context->allocate_output(0, tensor.shape(), &output), done);
+    }
     // ReadyEvent makes sure input tensor is ready, and output is allocated.
     common::ReadyEventList ready_event_list;
 #if HAVE_GPU
@@ -441,7 +529,10 @@ public:
 #endif
     auto hvd_context = std::make_shared<TFOpContext>(context);
     auto hvd_tensor = std::make_shared<TFTensor>(tensor);
-    auto hvd_output = std::make_shared<TFTensor>(*output);
+    std::shared_ptr<common::Tensor> hvd_output;
+    if (output != nullptr) {
+      hvd_output = std::make_shared<TFTensor>(*output);
+    }
     auto enqueue_result = EnqueueTensorAllreduce(
         hvd_context, hvd_tensor, hvd_output, ready_event_list, node_name, device,
         [context, done](const common::Status& status) {
@@ -459,7 +550,7 @@ public:
           done();
         },
         reduce_op, (double)prescale_factor_, (double)postscale_factor_,
-        process_set_id_);
+        process_set_id_, priority_);
     OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
   }
 
@@ -470,6 +561,7 @@ private:
   float postscale_factor_;
   bool ignore_name_scope_;
   int process_set_id_;
+  int priority_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("HorovodAllreduce").Device(DEVICE_CPU),
@@ -480,12 +572,13 @@ REGISTER_KERNEL_BUILDER(Name("HorovodAllreduce").Device(DEVICE_GPU),
 #endif
 
 REGISTER_OP("HorovodAllreduce")
-    .Attr("T: {int32, int64, float16, float32, float64}")
+    .Attr("T: {int32, int64, bfloat16, float16, float32, float64}")
     .Attr("reduce_op: int")
     .Attr("prescale_factor: float")
     .Attr("postscale_factor: float")
     .Attr("ignore_name_scope: bool = False")
     .Attr("process_set_id: int = 0")
+    .Attr("priority: int = 0")
     .Input("tensor: T")
     .Output("sum: T")
     .SetShapeFn([](shape_inference::InferenceContext* c) {
@@ -515,6 +608,7 @@ public:
     OP_REQUIRES_OK(context, context->GetAttr("ignore_name_scope", &ignore_name_scope_));
     OP_REQUIRES_OK(context, context->GetAttr("num_tensors", &num_tensors_));
     OP_REQUIRES_OK(context, context->GetAttr("process_set_id", &process_set_id_));
+    OP_REQUIRES_OK(context, context->GetAttr("priority", &priority_));
   }
 
   void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
@@ -548,11 +642,19 @@ public:
     auto callback_count = std::make_shared<int>(0);
     int num_tensors = num_tensors_;
 
-    for (int i = 0; i < num_tensors_; ++i) {
-      auto tensor = context->input(i);
-      OP_REQUIRES_OK_ASYNC(
-          context, context->allocate_output(i, tensor.shape(), &outputs[i]),
-          done);
+    // With pooled outputs Horovod sets the outputs when it executes the op,
+    // otherwise inputs dead after the op are reduced in place.
+    bool pooled_outputs =
+        device != CPU_DEVICE_ID && common::PooledOutputsEnabled();
+    for (int i = 0; i < num_tensors_ && !pooled_outputs; ++i) {
+      // Not a copy, which would keep the input from being forwarded.
+      const Tensor& tensor = context->input(i);
+      outputs[i] = ForwardInput(context, i);
+      if (outputs[i] == nullptr) {
+        OP_REQUIRES_OK_ASYNC(
+            context, context->allocate_output(i, tensor.shape(), &outputs[i]),
+            done);
+      }
     }
 
     // ReadyEvent makes sure input tensors are ready, and outputs are allocated.
@@ -564,11 +666,12 @@ public:
     for (int i = 0; i < num_tensors_; ++i) {
       auto tensor = context->input(i);
       ready_event_lists.emplace_back(ready_event_list); // Same for all tensors in group
-      hvd_contexts.emplace_back(std::make_shared<TFOpContext>(context));
+      hvd_contexts.emplace_back(std::make_shared<TFOpContext>(context, i));
       hvd_tensors.emplace_back(std::make_shared<TFTensor>(tensor));
       names.emplace_back(node_name + "_" + std::to_string(i + 1) + "of" +
                          std::to_string(num_tensors));
-      hvd_outputs.emplace_back(std::make_shared<TFTensor>(*outputs[i]));
+      hvd_outputs.emplace_back(
+          pooled_outputs ? nullptr : std::make_shared<TFTensor>(*outputs[i]));
       callbacks.emplace_back(
           [context, done, callback_mutex, callback_count, num_tensors]
           (const common::Status& status) {
@@ -595,7 +698,7 @@ public:
     auto enqueue_result = EnqueueTensorAllreduces(
         hvd_contexts, hvd_tensors, hvd_outputs, ready_event_lists, names, device,
         callbacks, reduce_op, (double)prescale_factor_,
-        (double)postscale_factor_, process_set_id_);
+        (double)postscale_factor_, process_set_id_, priority_);
     OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
   }
 
@@ -607,6 +710,7 @@ private:
   bool ignore_name_scope_;
   int num_tensors_;
   int process_set_id_;
+  int priority_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("HorovodGroupedAllreduce").Device(DEVICE_CPU),
@@ -617,13 +721,14 @@ REGISTER_KERNEL_BUILDER(Name("HorovodGroupedAllreduce").Device(DEVICE_GPU),
 #endif
 
 REGISTER_OP("HorovodGroupedAllreduce")
-    .Attr("T: {int32, int64, float16, float32, float64}")
+    .Attr("T: {int32, int64, bfloat16, float16, float32, float64}")
     .Attr("reduce_op: int")
     .Attr("prescale_factor: float")
     .Attr("postscale_factor: float")
     .Attr("ignore_name_scope: bool = False")
     .Attr("num_tensors: int")
     .Attr("process_set_id: int = 0")
+    .Attr("priority: int = 0")
     .Input("tensors: num_tensors*T")
     .Output("sum: num_tensors*T")
     .SetShapeFn([](shape_inference::InferenceContext* c) {
@@ -709,7 +814,7 @@ REGISTER_KERNEL_BUILDER(Name("HorovodAllgather").Device(DEVICE_GPU),
 
 REGISTER_OP("HorovodAllgather")
     .Attr(
-        "T: {uint8, int8, uint16, int16, int32, int64, float16, float32, float64, bool}")
+        "T: {uint8, int8, uint16, int16, int32, int64, bfloat16, float16, float32, float64, bool}")
     .Attr("ignore_name_scope: bool = False")
     .Attr("process_set_id: int = 0")
     .Input("tensor: T")
@@ -733,6 +838,98 @@ Output
     gathered:    A tensor with the same shape as `tensor` except for the first dimension.
 )doc");
 
+class HorovodReducescatterOp : public AsyncOpKernel {
+public:
+  explicit HorovodReducescatterOp(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("reduce_op", &reduce_op_));
+    OP_REQUIRES_OK(context, context->GetAttr("ignore_name_scope", &ignore_name_scope_));
+    OP_REQUIRES_OK(context, context->GetAttr("process_set_id", &process_set_id_));
+  }
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(common::CheckInitialized()),
+                         done);
+
+    auto node_name = name();
+    if (ignore_name_scope_) {
+      auto pos = node_name.find_last_of('/');
+      if (pos != std::string::npos) {
+        node_name = node_name.substr(pos + 1);
+      }
+    }
+    auto device = GetDeviceID(context);
+    auto tensor = context->input(0);
+    horovod::common::ReduceOp reduce_op = static_cast<horovod::common::ReduceOp>(reduce_op_);
+    // ReadyEvent makes sure input tensor is ready.  Output is allocated once
+    // the slice of the first dimension owned by this rank is known.
+    common::ReadyEventList ready_event_list;
+#if HAVE_GPU
+    ready_event_list.AddReadyEvent(std::shared_ptr<common::ReadyEvent>(RecordReadyEvent(context)));
+#endif
+    auto hvd_context = std::make_shared<TFOpContext>(context);
+    auto hvd_tensor = std::make_shared<TFTensor>(tensor);
+    auto enqueue_result = EnqueueTensorReducescatter(
+        hvd_context, hvd_tensor, ready_event_list, node_name, device,
+        [context, done](const common::Status& status) {
+#if HAVE_GPU
+          auto hvd_event = status.event;
+          if (hvd_event.event) {
+            auto device_context = context->op_device_context();
+            if (device_context != nullptr) {
+                auto stream = stream_executor::gpu::AsGpuStreamValue(device_context->stream());
+                HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
+            }
+          }
+#endif
+          context->SetStatus(ConvertStatus(status));
+          done();
+        },
+        reduce_op, process_set_id_);
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
+  }
+
+private:
+  int reduce_op_;
+  bool ignore_name_scope_;
+  int process_set_id_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("HorovodReducescatter").Device(DEVICE_CPU),
+                        HorovodReducescatterOp);
+#if HOROVOD_GPU_REDUCESCATTER
+REGISTER_KERNEL_BUILDER(Name("HorovodReducescatter").Device(DEVICE_GPU),
+                        HorovodReducescatterOp);
+#endif
+
+REGISTER_OP("HorovodReducescatter")
+    .Attr("T: {int32, int64, bfloat16, float16, float32, float64}")
+    .Attr("reduce_op: int")
+    .Attr("ignore_name_scope: bool = False")
+    .Attr("process_set_id: int = 0")
+    .Input("tensor: T")
+    .Output("output: T")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle output;
+      TF_RETURN_IF_ERROR(
+          c->ReplaceDim(c->input(0), 0, c->UnknownDim(), &output));
+      c->set_output(0, output);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Perform an MPI Reducescatter on a tensor. All other processes that do a
+reduction on a tensor with the same name must have the same shape for that
+tensor. The reduced tensor is split along the first dimension and each process
+receives one part, with lower ranks receiving one extra slice when the first
+dimension is not divisible by the number of processes.
+
+Arguments
+    tensor:     A tensor to reduce and scatter.
+
+Output
+    output:    A tensor with the same shape as `tensor` except for the first dimension.
+)doc");
+
 class HorovodBroadcastOp : public AsyncOpKernel {
 public:
   explicit HorovodBroadcastOp(OpKernelConstruction* context)
@@ -808,7 +1005,7 @@ REGISTER_KERNEL_BUILDER(Name("HorovodBroadcast").Device(DEVICE_GPU),
 
 REGISTER_OP("HorovodBroadcast")
     .Attr(
-        "T: {uint8, int8, uint16, int16, int32, int64, float16, float32, float64, bool}")
+        "T: {uint8, int8, uint16, int16, int32, int64, bfloat16, float16, float32, float64, bool}")
     .Attr("root_rank: int")
     .Attr("ignore_name_scope: bool = False")
     .Attr("process_set_id: int = 0")
@@ -1111,7 +1308,7 @@ REGISTER_KERNEL_BUILDER(Name("HorovodAlltoall")
 
 REGISTER_OP("HorovodAlltoall")
     .Attr(
-        "T: {uint8, int8, uint16, int16, int32, int64, float16, float32, float64, bool}")
+        "T: {uint8, int8, uint16, int16, int32, int64, bfloat16, float16, float32, float64, bool}")
     .Attr("ignore_name_scope: bool = False")
     .Attr("process_set_id: int = 0")
     .Input("tensor: T")
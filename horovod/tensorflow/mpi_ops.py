@@ -27,8 +27,8 @@ from horovod.common.util import check_installed_version, get_ext_suffix, \
     get_average_backwards_compatibility_fun, gpu_available, num_rank_is_power_2
 from horovod.common.basics import HorovodBasics as _HorovodBasics
 from horovod.common.process_sets import _setup as _setup_process_sets
-from horovod.common.process_sets import ProcessSet, global_process_set, add_process_set, remove_process_set, \
-    _temp_process_set_object
+from horovod.common.process_sets import ProcessSet, global_process_set, add_process_set, add_process_sets, \
+    remove_process_set, _temp_process_set_object
 from horovod.tensorflow.util import _executing_eagerly
 
 
@@ -78,11 +78,21 @@ ddl_built = _basics.ddl_built
 ccl_built = _basics.ccl_built
 cuda_built = _basics.cuda_built
 rocm_built = _basics.rocm_built
+metrics = _basics.metrics
+metrics_prometheus = _basics.metrics_prometheus
+step_begin = _basics.step_begin
+step_end = _basics.step_end
+memory_usage = _basics.memory_usage
+release_buffers = _basics.release_buffers
+broadcast_bytes = _basics.broadcast_bytes
 
 # import reduction op values
 Average = _basics.Average
 Sum = _basics.Sum
 Adasum = _basics.Adasum
+Min = _basics.Min
+Max = _basics.Max
+Product = _basics.Product
 
 is_homogeneous = _basics.is_homogeneous
 
@@ -106,7 +116,7 @@ def _normalize_name(name):
 
 
 def _allreduce(tensor, name=None, op=Sum, prescale_factor=1.0, postscale_factor=1.0,
-               ignore_name_scope=False, process_set=global_process_set):
+               ignore_name_scope=False, process_set=global_process_set, priority=0):
     """An op which reduces an input tensor over all the Horovod processes. The
     default reduction is a sum.
 
@@ -124,7 +134,8 @@ def _allreduce(tensor, name=None, op=Sum, prescale_factor=1.0, postscale_factor=
                                      prescale_factor=prescale_factor,
                                      postscale_factor=postscale_factor,
                                      ignore_name_scope=ignore_name_scope,
-                                     process_set_id=process_set.process_set_id)
+                                     process_set_id=process_set.process_set_id,
+                                     priority=priority)
 
 
 @ops.RegisterGradient('HorovodAllreduce')
@@ -143,6 +154,14 @@ def _allreduce_grad(op, grad):
     postscale_factor = op.get_attr('postscale_factor')
     ignore_name_scope = op.get_attr('ignore_name_scope')
     process_set_id = op.get_attr('process_set_id')
+    if reduce_op in (Min, Max):
+        # The gradient flows to the ranks that hold the selected value.
+        summed = _allreduce(grad, op=Sum, ignore_name_scope=ignore_name_scope,
+                            process_set=_temp_process_set_object(process_set_id))
+        selected = tf.cast(tf.equal(op.inputs[0], op.outputs[0]), dtype=grad.dtype)
+        return summed * selected
+    if reduce_op == Product:
+        raise NotImplementedError('The gradient of a Product allreduce is not supported.')
     return _allreduce(grad, op=reduce_op, prescale_factor=prescale_factor,
                       postscale_factor=postscale_factor,
                       ignore_name_scope=ignore_name_scope,
@@ -150,7 +169,7 @@ def _allreduce_grad(op, grad):
 
 
 def _grouped_allreduce(tensors, name=None, op=Sum, prescale_factor=1.0, postscale_factor=1.0,
-                       ignore_name_scope=False, process_set=global_process_set):
+                       ignore_name_scope=False, process_set=global_process_set, priority=0):
     """An op which reduces input tensors over all the Horovod processes. The
     default reduction is a sum.
 
@@ -174,7 +193,8 @@ def _grouped_allreduce(tensors, name=None, op=Sum, prescale_factor=1.0, postscal
                                              prescale_factor=prescale_factor,
                                              postscale_factor=postscale_factor,
                                              ignore_name_scope=ignore_name_scope,
-                                             process_set_id=process_set.process_set_id)
+                                             process_set_id=process_set.process_set_id,
+                                             priority=priority)
 
 
 @ops.RegisterGradient('HorovodGroupedAllreduce')
@@ -193,6 +213,8 @@ def _grouped_allreduce_grad(op, *grads):
     postscale_factor = op.get_attr('postscale_factor')
     ignore_name_scope = op.get_attr('ignore_name_scope')
     process_set_id = op.get_attr('process_set_id')
+    if reduce_op in (Min, Max, Product):
+        raise NotImplementedError('The gradient of a grouped Min, Max or Product allreduce is not supported.')
     # TODO(joshr): should this be done as separate allreduce ops?
     return _grouped_allreduce(list(grads), op=reduce_op, prescale_factor=prescale_factor,
                               postscale_factor=postscale_factor,
@@ -253,6 +275,51 @@ def _allgather_grad(op, grad):
     return splits[temp_process_set_object.rank()]
 
 
+def reducescatter(tensor, name=None, op=Average, ignore_name_scope=False,
+                  process_set=global_process_set):
+    """An op which reduces the input tensor across all Horovod processes and
+    scatters the result along the first dimension, so that each process receives
+    a distinct slice.
+
+    The input tensors on the different processes must have the same shape. If the
+    first dimension is not divisible by the number of processes, the lower ranks
+    receive one extra slice each. Only the Average and Sum reduce ops are
+    supported.
+
+    Returns:
+      A tensor of the same type as `tensor`, reduced across all processes. The
+      shape is identical to the input shape, except for the first dimension, which
+      holds only the slice owned by this process.
+    """
+    if name is None and not _executing_eagerly():
+        name = 'HorovodReducescatter_%s' % _normalize_name(tensor.name)
+    return MPI_LIB.horovod_reducescatter(tensor, name=name, reduce_op=op,
+                                         ignore_name_scope=ignore_name_scope,
+                                         process_set_id=process_set.process_set_id)
+
+
+@ops.RegisterGradient('HorovodReducescatter')
+def _reducescatter_grad(op, grad):
+    """Gradient for reducescatter op.
+
+    Args:
+      op: An operation.
+      grad: `Tensor` gradient with respect to the output of the op.
+
+    Returns:
+      The gradient with respect to the input of the op.
+    """
+    reduce_op = op.get_attr('reduce_op')
+    ignore_name_scope = op.get_attr('ignore_name_scope')
+    process_set_id = op.get_attr('process_set_id')
+    temp_process_set_object = _temp_process_set_object(process_set_id)
+    grad = allgather(grad, ignore_name_scope=ignore_name_scope,
+                     process_set=temp_process_set_object)
+    if reduce_op == Average:
+        grad = grad / tf.cast(temp_process_set_object.size(), dtype=grad.dtype)
+    return grad
+
+
 def broadcast(tensor, root_rank, name=None, ignore_name_scope=False, process_set=global_process_set):
     """An op which broadcasts the input tensor on root rank to the same input tensor
     on all other Horovod processes.
@@ -0,0 +1,533 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// XLA kernels of HorovodAllreduce, HorovodAllgather and HorovodBroadcast, so
+// that functions compiled with XLA keep the collectives inside their clusters.
+//
+// Every op is lowered to two custom calls on the XLA stream. The first one
+// records a ready event and enqueues the tensor into the Horovod runtime,
+// which runs the collective on its own stream like for the regular kernels.
+// The second one takes the input and output buffers of the first, so that
+// XLA keeps them alive and unchanged until it returns, waits for the
+// collective to finish and returns the output buffer in place. Work that does
+// not depend on the result is free to run in between.
+
+#if HAVE_CUDA
+
+#include <condition_variable>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cuda_runtime.h>
+
+#include "tensorflow/compiler/tf2xla/shape_util.h"
+#include "tensorflow/compiler/tf2xla/xla_op_kernel.h"
+#include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/client/xla_builder.h"
+#include "tensorflow/compiler/xla/service/custom_call_status.h"
+#include "tensorflow/compiler/xla/service/custom_call_target_registry.h"
+
+#include "../common/common.h"
+#define OMPI_SKIP_MPICXX
+#include "../common/operations.h"
+
+using namespace tensorflow;
+
+namespace horovod {
+namespace tensorflow {
+
+namespace {
+
+const char* COLLECTIVE_TARGET = "HorovodXlaCollective";
+const char* COLLECTIVE_DONE_TARGET = "HorovodXlaCollectiveDone";
+
+common::DataType GetHorovodDataType(::tensorflow::DataType dtype) {
+  switch (dtype) {
+  case DT_UINT8:
+    return common::HOROVOD_UINT8;
+  case DT_INT8:
+    return common::HOROVOD_INT8;
+  case DT_UINT16:
+    return common::HOROVOD_UINT16;
+  case DT_INT16:
+    return common::HOROVOD_INT16;
+  case DT_INT32:
+    return common::HOROVOD_INT32;
+  case DT_INT64:
+    return common::HOROVOD_INT64;
+  case DT_HALF:
+    return common::HOROVOD_FLOAT16;
+  case DT_BFLOAT16:
+    return common::HOROVOD_BFLOAT16;
+  case DT_FLOAT:
+    return common::HOROVOD_FLOAT32;
+  case DT_DOUBLE:
+    return common::HOROVOD_FLOAT64;
+  case DT_BOOL:
+    return common::HOROVOD_BOOL;
+  default:
+    throw std::logic_error("Invalid tensor type.");
+  }
+}
+
+// Everything the custom calls need to know about the op, passed to them as
+// the opaque string.
+struct CustomCallConfig {
+  std::string tensor_name;
+  common::Request::RequestType request_type = common::Request::ALLREDUCE;
+  common::DataType dtype = common::HOROVOD_FLOAT32;
+  std::vector<int64_t> input_shape;
+  std::vector<int64_t> output_shape;
+  int reduce_op = common::ReduceOp::SUM;
+  float prescale_factor = 1.0;
+  float postscale_factor = 1.0;
+  int root_rank = 0;
+  int process_set_id = 0;
+  int priority = 0;
+
+  std::string Serialize() const;
+  static CustomCallConfig Parse(const char* opaque, size_t opaque_len);
+};
+
+void WriteShape(std::ostream& os, const std::vector<int64_t>& shape) {
+  os << shape.size();
+  for (auto dim : shape) {
+    os << ' ' << dim;
+  }
+  os << ' ';
+}
+
+std::vector<int64_t> ReadShape(std::istream& is) {
+  size_t dims;
+  is >> dims;
+  std::vector<int64_t> shape(dims);
+  for (auto& dim : shape) {
+    is >> dim;
+  }
+  return shape;
+}
+
+std::string CustomCallConfig::Serialize() const {
+  std::ostringstream os;
+  os << std::setprecision(9);
+  os << tensor_name.size() << ' ' << tensor_name << ' ';
+  os << (int)request_type << ' ' << (int)dtype << ' ';
+  WriteShape(os, input_shape);
+  WriteShape(os, output_shape);
+  os << reduce_op << ' ' << prescale_factor << ' ' << postscale_factor << ' '
+     << root_rank << ' ' << process_set_id << ' ' << priority;
+  return os.str();
+}
+
+CustomCallConfig CustomCallConfig::Parse(const char* opaque,
+                                         size_t opaque_len) {
+  std::istringstream is(std::string(opaque, opaque_len));
+  CustomCallConfig config;
+  size_t name_len;
+  is >> name_len;
+  is.get();
+  config.tensor_name.resize(name_len);
+  is.read(&config.tensor_name[0], name_len);
+  int request_type, dtype;
+  is >> request_type >> dtype;
+  config.request_type = (common::Request::RequestType)request_type;
+  config.dtype = (common::DataType)dtype;
+  config.input_shape = ReadShape(is);
+  config.output_shape = ReadShape(is);
+  is >> config.reduce_op >> config.prescale_factor >> config.postscale_factor >>
+      config.root_rank >> config.process_set_id >> config.priority;
+  if (is.fail()) {
+    throw std::logic_error("Invalid Horovod XLA custom call configuration.");
+  }
+  return config;
+}
+
+common::TensorShape ToHorovodShape(const std::vector<int64_t>& dims) {
+  common::TensorShape shape;
+  for (auto dim : dims) {
+    shape.AddDim(dim);
+  }
+  return shape;
+}
+
+// A buffer of the XLA computation.
+class XLATensor : public common::Tensor {
+public:
+  XLATensor(common::DataType dtype, common::TensorShape shape, void* data)
+      : dtype_(dtype), shape_(std::move(shape)), data_(data) {}
+
+  const common::DataType dtype() const override { return dtype_; }
+  const common::TensorShape shape() const override { return shape_; }
+  const void* data() const override { return data_; }
+  int64_t size() const override {
+    return shape_.num_elements() * common::DataType_Size(dtype_);
+  }
+
+private:
+  common::DataType dtype_;
+  common::TensorShape shape_;
+  void* data_;
+};
+
+class XLAPersistentBuffer : public common::PersistentBuffer {
+public:
+  explicit XLAPersistentBuffer(int64_t size) {
+    HVD_GPU_CHECK(cudaMalloc(&data_, (size_t)size));
+  }
+  // Dropped when a buffer grows or buffers are released.
+  ~XLAPersistentBuffer() { cudaFree(data_); }
+
+  const void*
+  AccessData(std::shared_ptr<common::OpContext> context) const override {
+    return data_;
+  }
+
+private:
+  void* data_ = nullptr;
+};
+
+// XLA allocates all buffers statically, so outputs can only be handed out if
+// their shape was known at compile time.
+class XLAOpContext : public common::OpContext {
+public:
+  explicit XLAOpContext(std::shared_ptr<common::Tensor> output)
+      : output_(std::move(output)) {}
+
+  common::Status AllocatePersistent(
+      int64_t size, std::shared_ptr<common::PersistentBuffer>* tensor) override {
+    *tensor = std::make_shared<XLAPersistentBuffer>(size);
+    return common::Status::OK();
+  }
+
+  common::Status
+  AllocateOutput(common::TensorShape shape,
+                 std::shared_ptr<common::Tensor>* tensor) override {
+    if (output_ == nullptr || output_->shape() != shape) {
+      return common::Status::InvalidArgument(
+          "Horovod XLA ops need the output shape " + shape.DebugString() +
+          " at compile time. Allgather requires tensors with the same first "
+          "dimension on all ranks.");
+    }
+    *tensor = output_;
+    return common::Status::OK();
+  }
+
+  common::Status
+  AllocateZeros(int64_t num_elements, common::DataType dtype,
+                std::shared_ptr<common::Tensor>* tensor) override {
+    return common::Status::PreconditionError(
+        "Horovod XLA ops do not support operations that allocate temporary "
+        "tensors.");
+  }
+
+  common::Framework framework() const override {
+    return common::Framework::TENSORFLOW;
+  }
+
+private:
+  std::shared_ptr<common::Tensor> output_;
+};
+
+// Recorded on the XLA stream when the collective is enqueued.
+class XLAReadyEvent : public common::ReadyEvent {
+public:
+  explicit XLAReadyEvent(cudaStream_t stream) {
+    HVD_GPU_CHECK(cudaEventCreateWithFlags(&event_, cudaEventDisableTiming));
+    HVD_GPU_CHECK(cudaEventRecord(event_, stream));
+  }
+  ~XLAReadyEvent() { cudaEventDestroy(event_); }
+
+  // Polled, so the host is not blocked until the XLA stream gets there.
+  bool Ready() const override {
+    cudaError_t result = cudaEventQuery(event_);
+    if (result == cudaErrorNotReady) {
+      return false;
+    }
+    HVD_GPU_CHECK(result);
+    return true;
+  }
+  gpuEvent_t event() const override { return event_; }
+
+private:
+  cudaEvent_t event_;
+};
+
+// Collective enqueued by the first custom call, until the second one has
+// waited for it.
+class PendingCollective {
+public:
+  void Finish(const common::Status& status) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    status_ = status;
+    done_ = true;
+    cond_.notify_all();
+  }
+
+  common::Status Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return done_; });
+    return status_;
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool done_ = false;
+  common::Status status_;
+};
+
+class PendingCollectives {
+public:
+  std::shared_ptr<PendingCollective> Add(const std::string& name) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto& pending = pending_[name];
+    if (pending != nullptr) {
+      return nullptr;
+    }
+    pending = std::make_shared<PendingCollective>();
+    return pending;
+  }
+
+  std::shared_ptr<PendingCollective> Take(const std::string& name) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = pending_.find(name);
+    if (it == pending_.end()) {
+      return nullptr;
+    }
+    auto pending = std::move(it->second);
+    pending_.erase(it);
+    return pending;
+  }
+
+private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<PendingCollective>> pending_;
+};
+
+PendingCollectives pending_collectives;
+
+void SetFailure(XlaCustomCallStatus* status, const std::string& message) {
+  XlaCustomCallStatusSetFailure(status, message.c_str(), message.size());
+}
+
+void HorovodXlaCollective(cudaStream_t stream, void** buffers,
+                          const char* opaque, size_t opaque_len,
+                          XlaCustomCallStatus* status) {
+  auto config = CustomCallConfig::Parse(opaque, opaque_len);
+  auto pending = pending_collectives.Add(config.tensor_name);
+  if (pending == nullptr) {
+    SetFailure(status, "Horovod XLA op " + config.tensor_name +
+                           " is already in progress.");
+    return;
+  }
+
+  int device;
+  HVD_GPU_CHECK(cudaGetDevice(&device));
+  auto input = std::make_shared<XLATensor>(
+      config.dtype, ToHorovodShape(config.input_shape), buffers[0]);
+  auto output = std::make_shared<XLATensor>(
+      config.dtype, ToHorovodShape(config.output_shape), buffers[1]);
+  auto context = std::make_shared<XLAOpContext>(output);
+  common::ReadyEventList ready_event_list;
+  ready_event_list.AddReadyEvent(std::make_shared<XLAReadyEvent>(stream));
+
+  // With async completion the event is only valid during the callback, so the
+  // XLA stream is made to wait for it right away.
+  auto callback = [pending, stream](const common::Status& result) {
+    if (result.ok() && result.event.event) {
+      HVD_GPU_CHECK(cudaStreamWaitEvent(stream, *(result.event.event), 0));
+    }
+    pending->Finish(result);
+  };
+
+  common::Status enqueue_result;
+  switch (config.request_type) {
+  case common::Request::ALLREDUCE:
+    enqueue_result = EnqueueTensorAllreduce(
+        context, input, output, ready_event_list, config.tensor_name, device,
+        callback, static_cast<common::ReduceOp>(config.reduce_op),
+        (double)config.prescale_factor, (double)config.postscale_factor,
+        config.process_set_id, config.priority);
+    break;
+  case common::Request::ALLGATHER:
+    enqueue_result = EnqueueTensorAllgather(context, input, ready_event_list,
+                                            config.tensor_name, device,
+                                            callback, config.process_set_id);
+    break;
+  case common::Request::BROADCAST:
+    // Like the TensorFlow op, the root rank is a global rank, which
+    // EnqueueTensorBroadcast maps to the rank within the process set.
+    if (common::horovod_rank() == config.root_rank) {
+      // The root does not receive, its result is its own input.
+      HVD_GPU_CHECK(cudaMemcpyAsync(buffers[1], buffers[0], input->size(),
+                                    cudaMemcpyDeviceToDevice, stream));
+      output = nullptr;
+    }
+    enqueue_result = EnqueueTensorBroadcast(
+        context, input, output, config.root_rank, ready_event_list,
+        config.tensor_name, device, callback, config.process_set_id);
+    break;
+  default:
+    enqueue_result = common::Status::InvalidArgument(
+        "Unsupported Horovod XLA op " +
+        common::Request::RequestType_Name(config.request_type) + ".");
+  }
+  if (!enqueue_result.ok()) {
+    pending_collectives.Take(config.tensor_name);
+    SetFailure(status, enqueue_result.reason());
+  }
+}
+
+void HorovodXlaCollectiveDone(cudaStream_t stream, void** buffers,
+                              const char* opaque, size_t opaque_len,
+                              XlaCustomCallStatus* status) {
+  auto config = CustomCallConfig::Parse(opaque, opaque_len);
+  auto pending = pending_collectives.Take(config.tensor_name);
+  if (pending == nullptr) {
+    SetFailure(status, "Horovod XLA op " + config.tensor_name +
+                           " was not enqueued.");
+    return;
+  }
+  auto result = pending->Wait();
+  if (!result.ok()) {
+    SetFailure(status, result.reason());
+  }
+}
+
+XLA_REGISTER_CUSTOM_CALL_TARGET_WITH_SYM("HorovodXlaCollective",
+                                         HorovodXlaCollective, "CUDA");
+XLA_REGISTER_CUSTOM_CALL_TARGET_WITH_SYM("HorovodXlaCollectiveDone",
+                                         HorovodXlaCollectiveDone, "CUDA");
+
+class HorovodXlaCollectiveOp : public XlaOpKernel {
+public:
+  HorovodXlaCollectiveOp(OpKernelConstruction* context,
+                         common::Request::RequestType request_type)
+      : XlaOpKernel(context) {
+    config_.request_type = request_type;
+    OP_REQUIRES_OK(context, context->GetAttr("ignore_name_scope", &ignore_name_scope_));
+    OP_REQUIRES_OK(context, context->GetAttr("process_set_id", &config_.process_set_id));
+  }
+
+  void Compile(XlaOpKernelContext* ctx) override {
+    auto initialized = common::CheckInitialized();
+    OP_REQUIRES(ctx, initialized.ok(),
+                errors::FailedPrecondition(initialized.reason()));
+
+    CustomCallConfig config = config_;
+    config.tensor_name = name();
+    if (ignore_name_scope_) {
+      auto pos = config.tensor_name.find_last_of('/');
+      if (pos != std::string::npos) {
+        config.tensor_name = config.tensor_name.substr(pos + 1);
+      }
+    }
+    auto tf_dtype = ctx->input_type(0);
+    config.dtype = GetHorovodDataType(tf_dtype);
+    auto input_shape = ctx->InputShape(0);
+    for (auto dim : input_shape) {
+      config.input_shape.push_back(dim.size);
+    }
+    config.output_shape = config.input_shape;
+    if (config.request_type == common::Request::ALLGATHER) {
+      OP_REQUIRES(ctx, input_shape.dims() > 0,
+                  errors::InvalidArgument("Allgather of a scalar is not supported."));
+      int size = common::horovod_process_set_size(config.process_set_id);
+      OP_REQUIRES(ctx, size > 0,
+                  errors::InvalidArgument("Unknown process set ",
+                                          config.process_set_id, "."));
+      // Static shapes require the same first dimension on all ranks.
+      config.output_shape[0] *= size;
+    }
+    TensorShape output_tf_shape;
+    for (auto dim : config.output_shape) {
+      output_tf_shape.AddDim(dim);
+    }
+    xla::Shape output_shape;
+    OP_REQUIRES_OK(ctx, TensorShapeToXLAShape(tf_dtype, output_tf_shape,
+                                              &output_shape));
+
+    auto opaque = config.Serialize();
+    auto input = ctx->Input(0);
+    auto output = xla::CustomCall(
+        ctx->builder(), COLLECTIVE_TARGET, {input}, output_shape, opaque,
+        /*has_side_effect=*/true, /*output_operand_aliasing=*/{},
+        /*literal=*/nullptr, xla::CustomCallSchedule::SCHEDULE_NONE,
+        xla::CustomCallApiVersion::API_VERSION_STATUS_RETURNING);
+    auto done = xla::CustomCall(
+        ctx->builder(), COLLECTIVE_DONE_TARGET, {input, output}, output_shape,
+        opaque, /*has_side_effect=*/true,
+        /*output_operand_aliasing=*/{{xla::ShapeIndex{}, {1, xla::ShapeIndex{}}}},
+        /*literal=*/nullptr, xla::CustomCallSchedule::SCHEDULE_NONE,
+        xla::CustomCallApiVersion::API_VERSION_STATUS_RETURNING);
+    ctx->SetOutput(0, done);
+  }
+
+protected:
+  CustomCallConfig config_;
+
+private:
+  bool ignore_name_scope_;
+};
+
+class HorovodXlaAllreduceOp : public HorovodXlaCollectiveOp {
+public:
+  explicit HorovodXlaAllreduceOp(OpKernelConstruction* context)
+      : HorovodXlaCollectiveOp(context, common::Request::ALLREDUCE) {
+    OP_REQUIRES_OK(context, context->GetAttr("reduce_op", &config_.reduce_op));
+    OP_REQUIRES_OK(context, context->GetAttr("prescale_factor", &config_.prescale_factor));
+    OP_REQUIRES_OK(context, context->GetAttr("postscale_factor", &config_.postscale_factor));
+    OP_REQUIRES_OK(context, context->GetAttr("priority", &config_.priority));
+  }
+};
+
+class HorovodXlaAllgatherOp : public HorovodXlaCollectiveOp {
+public:
+  explicit HorovodXlaAllgatherOp(OpKernelConstruction* context)
+      : HorovodXlaCollectiveOp(context, common::Request::ALLGATHER) {}
+};
+
+class HorovodXlaBroadcastOp : public HorovodXlaCollectiveOp {
+public:
+  explicit HorovodXlaBroadcastOp(OpKernelConstruction* context)
+      : HorovodXlaCollectiveOp(context, common::Request::BROADCAST) {
+    OP_REQUIRES_OK(context, context->GetAttr("root_rank", &config_.root_rank));
+  }
+};
+
+} // namespace
+
+#if HOROVOD_GPU_ALLREDUCE
+REGISTER_XLA_OP(Name("HorovodAllreduce").Device(DEVICE_GPU_XLA_JIT),
+                HorovodXlaAllreduceOp);
+#endif
+#if HOROVOD_GPU_ALLGATHER
+REGISTER_XLA_OP(Name("HorovodAllgather").Device(DEVICE_GPU_XLA_JIT),
+                HorovodXlaAllgatherOp);
+#endif
+#if HOROVOD_GPU_BROADCAST
+REGISTER_XLA_OP(Name("HorovodBroadcast").Device(DEVICE_GPU_XLA_JIT),
+                HorovodXlaBroadcastOp);
+#endif
+
+} // namespace tensorflow
+} // namespace horovod
+
+#endif // HAVE_CUDA
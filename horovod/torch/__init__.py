@@ -39,17 +39,28 @@ if _MPI_LIB_AVAILABLE:
     from horovod.torch.mpi_ops import grouped_allreduce, grouped_allreduce_async, grouped_allreduce_, grouped_allreduce_async_
     from horovod.torch.mpi_ops import sparse_allreduce_async
     from horovod.torch.mpi_ops import allgather, allgather_async
+    from horovod.torch.mpi_ops import grouped_allgather, grouped_allgather_async
     from horovod.torch.mpi_ops import broadcast, broadcast_async, broadcast_, broadcast_async_
+    from horovod.torch.mpi_ops import grouped_broadcast, grouped_broadcast_async, grouped_broadcast_, grouped_broadcast_async_
     from horovod.torch.mpi_ops import alltoall, alltoall_async
-    from horovod.torch.mpi_ops import join
-    from horovod.torch.mpi_ops import poll, synchronize
+    from horovod.torch.mpi_ops import grouped_alltoall, grouped_alltoall_async
+    from horovod.torch.mpi_ops import reducescatter, reducescatter_async
+    from horovod.torch.mpi_ops import send, send_async, recv, recv_async
+    from horovod.torch.mpi_ops import reduce, reduce_async, gather, gather_async
+    from horovod.torch.mpi_ops import init_capturable_allreduce, capturable_allreduce_
+    from horovod.torch.mpi_ops import join, barrier
+    from horovod.torch.mpi_ops import poll, synchronize, synchronize_all
     from horovod.torch.mpi_ops import init, shutdown
+    from horovod.torch.mpi_ops import register_gradient_arena, unregister_gradient_arena
     from horovod.torch.mpi_ops import is_initialized, start_timeline, stop_timeline
+    from horovod.torch.mpi_ops import metrics, metrics_prometheus
+    from horovod.torch.mpi_ops import step_begin, step_end
+    from horovod.torch.mpi_ops import memory_usage, release_buffers
     from horovod.torch.mpi_ops import size, local_size, cross_size, rank, local_rank, cross_rank
     from horovod.torch.mpi_ops import mpi_threads_supported, mpi_enabled, mpi_built
     from horovod.torch.mpi_ops import gloo_enabled, gloo_built
     from horovod.torch.mpi_ops import nccl_built, ddl_built, ccl_built, cuda_built, rocm_built
-    from horovod.torch.mpi_ops import Average, Sum, Adasum
+    from horovod.torch.mpi_ops import Average, Sum, Adasum, Min, Max, Product
     from horovod.torch.optimizer import DistributedOptimizer
     from horovod.torch.sync_batch_norm import SyncBatchNorm
 
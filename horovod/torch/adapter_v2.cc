@@ -33,6 +33,8 @@ namespace torch {
     return ::torch::kLong;
   case common::HOROVOD_FLOAT16:
     return ::torch::kHalf;
+  case common::HOROVOD_BFLOAT16:
+    return ::torch::kBFloat16;
   case common::HOROVOD_FLOAT32:
     return ::torch::kFloat;
   case common::HOROVOD_FLOAT64:
@@ -73,6 +75,8 @@ const DataType TorchTensor::dtype() const {
     return common::HOROVOD_INT64;
   case ::torch::kHalf:
     return common::HOROVOD_FLOAT16;
+  case ::torch::kBFloat16:
+    return common::HOROVOD_BFLOAT16;
   case ::torch::kFloat:
     return common::HOROVOD_FLOAT32;
   case ::torch::kDouble:
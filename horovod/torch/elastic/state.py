@@ -58,7 +58,9 @@ class TorchState(ObjectState):
         super(TorchState, self).restore()
 
     def sync(self):
+        root_ranks = self._sync_root_ranks(allgather_object)
         for handler in self._handlers.values():
+            handler.root_ranks = root_ranks
             handler.sync()
         super(TorchState, self).sync()
 
@@ -71,6 +73,8 @@ class TorchState(ObjectState):
 class StateHandler(object):
     def __init__(self, value):
         self.value = value
+        # Rank, or ranks sharing the work, that sync() sends the state from.
+        self.root_ranks = 0
 
     def save(self):
         raise NotImplementedError()
@@ -98,7 +102,7 @@ class ModelStateHandler(StateHandler):
         self.value.load_state_dict(self._saved_model_state)
 
     def sync(self):
-        broadcast_parameters(self.value.state_dict(), root_rank=0)
+        broadcast_parameters(self.value.state_dict(), root_rank=self.root_ranks)
 
 
 class OptimizerStateHandler(StateHandler):
@@ -113,7 +117,7 @@ class OptimizerStateHandler(StateHandler):
         self.value.load_state_dict(self._saved_optimizer_state)
 
     def sync(self):
-        broadcast_optimizer_state(self.value, root_rank=0)
+        broadcast_optimizer_state(self.value, root_rank=self.root_ranks)
 
 
 class SamplerStateHandler(StateHandler):
@@ -21,7 +21,7 @@ from collections.abc import Iterable
 import cloudpickle
 import torch
 
-from horovod.torch.mpi_ops import allgather, broadcast_, broadcast_async_
+from horovod.torch.mpi_ops import allgather, broadcast_, broadcast_bytes, grouped_broadcast_async_
 from horovod.torch.mpi_ops import synchronize
 from horovod.torch.mpi_ops import rank, size
 
@@ -37,7 +37,9 @@ def broadcast_parameters(params, root_rank):
             - list of parameters to broadcast
             - dict of parameters to broadcast
         root_rank: The rank of the process from which parameters will be
-                   broadcasted to all other processes.
+                   broadcasted to all other processes, or a list of ranks
+                   holding the same parameters, which then each send a
+                   share of them.
     """
     if isinstance(params, dict):
         params = sorted(params.items())
@@ -47,10 +49,24 @@ def broadcast_parameters(params, root_rank):
     else:
         raise ValueError('invalid params of type: %s' % type(params))
 
-    # Run asynchronous broadcasts.
+    root_ranks = [root_rank] if isinstance(root_rank, int) else list(root_rank)
+
+    # Tensors of a group must be on the same device and have the same root.
+    # Each tensor goes to the root that sends the fewest bytes so far.
+    sent = [0] * len(root_ranks)
+    groups = collections.OrderedDict()
+    for _, p in params:
+        i = sent.index(min(sent))
+        sent[i] += p.numel() * p.element_size()
+        groups.setdefault((p.device, root_ranks[i]), []).append(p)
+
+    # Run one asynchronous grouped broadcast per device and root, so that the
+    # parameters are negotiated together and fused instead of being sent
+    # one by one, and the roots send at the same time.
     handles = []
-    for name, p in params:
-        handle = broadcast_async_(p, root_rank, name)
+    for i, ((_, root), tensors) in enumerate(groups.items()):
+        handle = grouped_broadcast_async_(tensors, root,
+                                          'broadcast_parameters.%d' % i)
         handles.append(handle)
 
     # Wait for completion.
@@ -65,7 +81,8 @@ def broadcast_optimizer_state(optimizer, root_rank):
     Arguments:
         optimizer: An optimizer.
         root_rank: The rank of the process from which the optimizer will be
-                   broadcasted to all other processes.
+                   broadcasted to all other processes, or a list of ranks
+                   as for `broadcast_parameters`.
     """
     from horovod.torch.optimizer import DistributedOptimizer
     if isinstance(optimizer, torch.optim.LBFGS):
@@ -182,7 +199,8 @@ def broadcast_optimizer_state(optimizer, root_rank):
     broadcast_parameters(params, root_rank)
 
     # Broadcast and cleanup for non-tensor parameters
-    scalars = broadcast_object(scalars, root_rank)
+    scalars = broadcast_object(
+        scalars, root_rank if isinstance(root_rank, int) else root_rank[0])
     for key, p in scalars.items():
         callbacks[key](p)
 
@@ -210,6 +228,11 @@ def broadcast_object(obj, root_rank=0, name=None):
     if name is None:
         name = type(obj).__name__
 
+    data = cloudpickle.dumps(obj) if rank() == root_rank else None
+    data = broadcast_bytes(data, root_rank)
+    if data is not None:
+        return obj if rank() == root_rank else cloudpickle.loads(data)
+
     if rank() == root_rank:
         b = io.BytesIO()
         cloudpickle.dump(obj, b)
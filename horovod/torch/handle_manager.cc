@@ -13,47 +13,147 @@
 // limitations under the License.
 // =============================================================================
 
+
 #include "handle_manager.h"
 
 namespace horovod {
 namespace torch {
 
+namespace {
+
+std::invalid_argument UnknownHandle(int handle) {
+  return std::invalid_argument("Handle " + std::to_string(handle) +
+                               " was not created or has been cleared.");
+}
+
+} // namespace
+
+HandleManager::HandleManager() : slots_(new Slot[NUM_SLOTS]) {}
+
+HandleManager::Slot* HandleManager::FindSlot(int handle) {
+  auto& slot = slots_[handle & (NUM_SLOTS - 1)];
+  return slot.handle.load(std::memory_order_acquire) == handle ? &slot
+                                                               : nullptr;
+}
+
 int HandleManager::AllocateHandle() {
   int handle = last_handle_.fetch_add(1) + 1;
+  auto& slot = slots_[handle & (NUM_SLOTS - 1)];
+  int expected = SLOT_FREE;
+  if (slot.state.compare_exchange_strong(expected, SLOT_PENDING,
+                                         std::memory_order_acq_rel)) {
+    slot.handle.store(handle, std::memory_order_release);
+    return handle;
+  }
   std::lock_guard<std::mutex> guard(mutex_);
-  results_[handle] = nullptr;
+  overflow_[handle] = nullptr;
   return handle;
 }
 
 void HandleManager::MarkDone(int handle, const Status& status) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  results_[handle] = std::make_shared<Status>(status);
+  auto slot = FindSlot(handle);
+  if (slot != nullptr) {
+    slot->status = status;
+    slot->state.store(SLOT_DONE);
+  } else {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = overflow_.find(handle);
+    if (it != overflow_.end()) {
+      it->second = std::make_shared<Status>(status);
+    }
+  }
+  // Waiters register before checking their handles, so either they see the
+  // new state or we see them here.
+  if (num_waiters_.load() > 0) {
+    { std::lock_guard<std::mutex> guard(mutex_); }
+    done_cond_.notify_all();
+  }
+}
+
+bool HandleManager::IsDone(int handle) {
+  auto slot = FindSlot(handle);
+  if (slot != nullptr) {
+    return slot->state.load() == SLOT_DONE;
+  }
+  auto it = overflow_.find(handle);
+  if (it == overflow_.end()) {
+    throw UnknownHandle(handle);
+  }
+  return it->second != nullptr;
 }
 
 bool HandleManager::PollHandle(int handle) {
+  auto slot = FindSlot(handle);
+  if (slot != nullptr) {
+    return slot->state.load(std::memory_order_acquire) == SLOT_DONE;
+  }
   std::lock_guard<std::mutex> guard(mutex_);
-  if (results_.find(handle) == results_.end()) {
-    throw std::invalid_argument("Handle " + std::to_string(handle) +
-                                " was not created or has been cleared.");
+  return IsDone(handle);
+}
+
+void HandleManager::WaitForHandle(int handle) {
+  if (PollHandle(handle)) {
+    return;
   }
-  return results_[handle] != nullptr;
+  WaitForHandles(std::vector<int>{handle});
 }
 
-std::shared_ptr<Status> HandleManager::ReleaseHandle(int handle) {
+void HandleManager::WaitForHandles(const std::vector<int>& handles) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  num_waiters_.fetch_add(1);
+  try {
+    // Handles complete roughly in order, so only the first pending one is
+    // checked again after a wakeup.
+    size_t pending = 0;
+    while (pending < handles.size()) {
+      if (IsDone(handles[pending])) {
+        ++pending;
+        continue;
+      }
+      done_cond_.wait(lock);
+    }
+  } catch (...) {
+    num_waiters_.fetch_sub(1);
+    throw;
+  }
+  num_waiters_.fetch_sub(1);
+}
+
+Status HandleManager::ReleaseHandle(int handle) {
+  auto slot = FindSlot(handle);
+  if (slot != nullptr) {
+    Status status = Status::InProgress();
+    if (slot->state.load(std::memory_order_acquire) == SLOT_DONE) {
+      status = std::move(slot->status);
+      slot->status = Status();
+    }
+    slot->handle.store(0, std::memory_order_release);
+    slot->state.store(SLOT_FREE, std::memory_order_release);
+    return status;
+  }
   std::lock_guard<std::mutex> guard(mutex_);
-  if (results_.find(handle) == results_.end()) {
-    throw std::invalid_argument("Handle " + std::to_string(handle) +
-        " was not created or has been cleared.");
+  auto it = overflow_.find(handle);
+  if (it == overflow_.end()) {
+    throw UnknownHandle(handle);
   }
-  auto status = results_[handle];
-  results_.erase(handle);
-  return status;
+  auto status = it->second;
+  overflow_.erase(it);
+  return status != nullptr ? *status : Status::InProgress();
 }
 
 void HandleManager::Reset() {
-  std::lock_guard<std::mutex> guard(mutex_);
-  results_.clear();
-  last_handle_ = 0;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (int i = 0; i < NUM_SLOTS; ++i) {
+      slots_[i].status = Status();
+      slots_[i].handle.store(0);
+      slots_[i].state.store(SLOT_FREE);
+    }
+    overflow_.clear();
+    last_handle_ = 0;
+  }
+  // Waiters find their handles cleared and throw.
+  done_cond_.notify_all();
 }
 
 } // namespace torch
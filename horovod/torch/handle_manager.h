@@ -13,13 +13,16 @@
 // limitations under the License.
 // =============================================================================
 
+
 #ifndef HOROVOD_TORCH_HANDLE_MANAGER_H
 #define HOROVOD_TORCH_HANDLE_MANAGER_H
 
 #include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "../common/common.h"
 
@@ -28,18 +31,59 @@ namespace torch {
 
 using namespace horovod::common;
 
+// Tracks the completion of asynchronous operations by handle.
+//
+// Handles live in a fixed ring of slots, the slot of a handle is its value
+// modulo the capacity. Allocating, marking done, polling and releasing a
+// handle in its slot only takes atomic operations, with the status stored in
+// the slot. A handle whose slot is still taken by an older outstanding handle
+// falls back to a map under a mutex.
 class HandleManager {
 public:
+  HandleManager();
+  HandleManager(const HandleManager&) = delete;
+
   int AllocateHandle();
   void MarkDone(int handle, const Status& status);
   bool PollHandle(int handle);
-  std::shared_ptr<Status> ReleaseHandle(int handle);
+  // Blocks until the handle, or all of the handles, have been marked done.
+  // The handles stay valid until they are released.
+  void WaitForHandle(int handle);
+  void WaitForHandles(const std::vector<int>& handles);
+  Status ReleaseHandle(int handle);
   void Reset();
 
 private:
-  std::atomic_int last_handle_;
-  std::unordered_map<int, std::shared_ptr<Status>> results_;
+  enum SlotState { SLOT_FREE = 0, SLOT_PENDING = 1, SLOT_DONE = 2 };
+
+  struct Slot {
+    // Handle that owns the slot, 0 if the slot is free. Written only by the
+    // thread that moved state from SLOT_FREE to SLOT_PENDING.
+    std::atomic_int handle{0};
+    std::atomic_int state{SLOT_FREE};
+    // Written by MarkDone before state becomes SLOT_DONE.
+    Status status;
+  };
+
+  static constexpr int NUM_SLOTS = 1 << 15;
+
+  // Returns the slot owned by handle, or nullptr if the handle is in
+  // overflow_ or unknown.
+  Slot* FindSlot(int handle);
+
+  // Must be called with mutex_ held.
+  bool IsDone(int handle);
+
+  std::atomic_int last_handle_{0};
+  std::unique_ptr<Slot[]> slots_;
+
+  // Handles that did not get a slot, nullptr until done.
+  std::unordered_map<int, std::shared_ptr<Status>> overflow_;
   std::mutex mutex_;
+
+  // Signalled by MarkDone while any thread is waiting.
+  std::condition_variable done_cond_;
+  std::atomic_int num_waiters_{0};
 };
 
 } // namespace torch
@@ -16,12 +16,14 @@
 # ==============================================================================
 
 # Load all the necessary PyTorch C types.
+import os
 import torch
 
 import warnings
 
 from horovod.common.basics import HorovodBasics as _HorovodBasics
 from horovod.common.exceptions import HorovodInternalError
+from horovod.common.process_sets import global_process_set
 from horovod.common.process_sets import _setup as _setup_process_sets
 from horovod.common.util import check_installed_version, get_average_backwards_compatibility_fun, gpu_available, num_rank_is_power_2
 
@@ -60,14 +62,46 @@ ddl_built = _basics.ddl_built
 ccl_built = _basics.ccl_built
 cuda_built = _basics.cuda_built
 rocm_built = _basics.rocm_built
+metrics = _basics.metrics
+metrics_prometheus = _basics.metrics_prometheus
+step_begin = _basics.step_begin
+step_end = _basics.step_end
+memory_usage = _basics.memory_usage
+release_buffers = _basics.release_buffers
+broadcast_bytes = _basics.broadcast_bytes
 def shutdown(*args, **kwargs):
     mpi_lib.horovod_torch_reset()
     return _basics.shutdown(*args, **kwargs)
 
+
+def register_gradient_arena(tensor, alignment=256):
+    """Registers a contiguous tensor whose views hold gradients that are allreduced
+    in place, e.g. a bucket that gradients are copied into before reduction.
+
+    Every view must start at a multiple of `alignment` bytes from the start of
+    `tensor`. Fused allreduces of views of the same tensor are then reduced directly
+    in it, without copies through the fusion buffer. The tensor must stay alive
+    until it is unregistered.
+
+    Returns:
+      False if the tensor overlaps one that is already registered.
+    """
+    return _basics.register_gradient_arena(tensor.data_ptr(),
+                                           tensor.numel() * tensor.element_size(),
+                                           alignment)
+
+
+def unregister_gradient_arena(tensor):
+    """Unregisters a tensor passed to `register_gradient_arena`."""
+    return _basics.unregister_gradient_arena(tensor.data_ptr())
+
 # import reduction op values
 Average = _basics.Average
 Sum = _basics.Sum
 Adasum = _basics.Adasum
+Min = _basics.Min
+Max = _basics.Max
+Product = _basics.Product
 
 is_homogeneous = _basics.is_homogeneous
 
@@ -95,7 +129,8 @@ def _allreduce_function_factory(tensor):
     return 'horovod_torch_allreduce_async_' + tensor.type().replace('.', '_')
 
 
-def _allreduce_async(tensor, output, name, op, prescale_factor, postscale_factor):
+def _allreduce_async(tensor, output, name, op, prescale_factor, postscale_factor, priority=0,
+                     bucketed=False):
     # Set the divisor for reduced gradients to average when necessary
     if op == Average:
         if rocm_built():
@@ -123,23 +158,69 @@ def _allreduce_async(tensor, output, name, op, prescale_factor, postscale_factor
                               'with HOROVOD_GPU_OPERATIONS=NCCL.')
                 divisor = 1
         else:
-            if not num_rank_is_power_2(size()):
-                raise NotImplementedError('Running Adasum with non-power of 2 ranks is not supported yet.')
             divisor = 1
     else:
         divisor = 1
 
     function = _check_function(_allreduce_function_factory, tensor)
+    if bucketed:
+        function = 'horovod_torch_bucketed_allreduce_async'
     try:
         handle = getattr(mpi_lib, function)(tensor, output, divisor,
                                             name.encode() if name is not None else _NULL, op,
-                                            prescale_factor, postscale_factor)
+                                            prescale_factor, postscale_factor, priority)
     except RuntimeError as e:
         raise HorovodInternalError(e)
     _handle_map[handle] = (tensor, output)
     return handle
 
 
+def _register_allreduce_buckets(names, sizes, bucket_bytes):
+    # Assigns the named allreduces, in the order their tensors were registered,
+    # to buckets of about bucket_bytes, filled in reverse like backward does.
+    mpi_lib.horovod_torch_register_allreduce_buckets([name.encode() for name in names],
+                                                     sizes, bucket_bytes)
+
+
+def _bucketed_allreduce_async_(tensor, name, op, prescale_factor, postscale_factor, priority=0):
+    # Like allreduce_async_, but held back until the whole bucket of name has
+    # been enqueued.
+    return _allreduce_async(tensor, tensor, name, op, prescale_factor, postscale_factor, priority,
+                            bucketed=True)
+
+
+def _skip_bucketed_allreduce(name):
+    # Counts name as done in its bucket for tensors reduced some other way.
+    try:
+        mpi_lib.horovod_torch_skip_bucketed_allreduce(name.encode())
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+
+
+def _accumulation_supported():
+    return hasattr(mpi_lib, 'horovod_torch_accumulate')
+
+
+def _accumulate_(tensor, name):
+    # Adds the dense CUDA tensor to a sum kept by Horovod under name. The tensor
+    # may be reused as soon as this returns.
+    try:
+        mpi_lib.horovod_torch_accumulate(tensor, name.encode())
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+
+
+def _accumulated_allreduce_async_(tensor, name, op, prescale_factor, postscale_factor, priority=0):
+    # Allreduces tensor plus the sum accumulated under name into tensor.
+    try:
+        handle = mpi_lib.horovod_torch_accumulated_allreduce_async(
+            tensor, tensor, name.encode(), op, prescale_factor, postscale_factor, priority)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+    _handle_map[handle] = (tensor, tensor)
+    return handle
+
+
 def allreduce_async(tensor, average=None, name=None, op=None,
                     prescale_factor=1.0, postscale_factor=1.0):
     """
@@ -183,10 +264,19 @@ class HorovodAllreduce(torch.autograd.Function):
         ctx.prescale_factor = prescale_factor
         ctx.postscale_factor = postscale_factor
         handle = allreduce_async(tensor, average, name, op, prescale_factor, postscale_factor)
-        return synchronize(handle)
+        output = synchronize(handle)
+        if op in (Min, Max):
+            # The gradient flows to the ranks that hold the selected value.
+            ctx.selected = tensor == output
+        return output
 
     @staticmethod
     def backward(ctx, grad_output):
+        if ctx.op in (Min, Max):
+            grad_reduced = allreduce(grad_output, op=Sum)
+            return grad_reduced * ctx.selected.type(grad_reduced.dtype), None, None, None, None, None
+        if ctx.op == Product:
+            raise NotImplementedError('The gradient of a Product allreduce is not supported.')
         return allreduce(grad_output, average=ctx.average, op=ctx.op,
                          prescale_factor=ctx.prescale_factor,
                          postscale_factor=ctx.postscale_factor), None, None, None, None, None
@@ -219,7 +309,8 @@ def allreduce(tensor, average=None, name=None, compression=Compression.none, op=
                      of data sent during the each parameter update step.  Defaults to
                      not using compression.
         op: The reduction operation to combine tensors across different ranks. Defaults
-            to Average if None is given.
+            to Average if None is given. Min, Max and Product do not support
+            prescale_factor or postscale_factor.
         prescale_factor: Multiplicative factor to scale tensor before allreduce.
         postscale_factor: Multiplicative factor to scale tensor after allreduce.
 
@@ -234,7 +325,7 @@ def allreduce(tensor, average=None, name=None, compression=Compression.none, op=
 
 
 def allreduce_async_(tensor, average=None, name=None, op=None,
-                     prescale_factor=1.0, postscale_factor=1.0):
+                     prescale_factor=1.0, postscale_factor=1.0, priority=0):
     """
     A function that performs asynchronous in-place averaging or summation of the input
     tensor over all the Horovod processes.
@@ -256,13 +347,17 @@ def allreduce_async_(tensor, average=None, name=None, op=None,
             Average if None is given.
         prescale_factor: Multiplicative factor to scale tensor before allreduce.
         postscale_factor: Multiplicative factor to scale tensor after allreduce.
+        priority: Scheduling priority of the reduction. When several reductions are
+                  ready at the same time, those with a higher priority are
+                  performed first.
 
     Returns:
         A handle to the allreduce operation that can be used with `poll()` or
         `synchronize()`.
     """
     op = handle_average_backwards_compatibility(op, average)
-    return _allreduce_async(tensor, tensor, name, op, prescale_factor, postscale_factor)
+    return _allreduce_async(tensor, tensor, name, op, prescale_factor, postscale_factor,
+                            priority)
 
 
 def allreduce_(tensor, average=None, name=None, op=None,
@@ -301,7 +396,8 @@ def _grouped_allreduce_function_factory(tensor):
     return 'horovod_torch_grouped_allreduce_async_' + tensor.type().replace('.', '_')
 
 
-def _grouped_allreduce_async(tensors, outputs, name, op, prescale_factor, postscale_factor):
+def _grouped_allreduce_async(tensors, outputs, name, op, prescale_factor, postscale_factor,
+                             priority=0):
     # Set the divisor for reduced gradients to average when necessary
     if op == Average:
         if rocm_built():
@@ -328,8 +424,6 @@ def _grouped_allreduce_async(tensors, outputs, name, op, prescale_factor, postsc
                               'with HOROVOD_GPU_OPERATIONS=NCCL.')
                 divisor = 1
         else:
-            if not num_rank_is_power_2(size()):
-                raise NotImplementedError('Running Adasum with non-power of 2 ranks is not supported yet.')
             divisor = 1
     else:
         divisor = 1
@@ -338,7 +432,7 @@ def _grouped_allreduce_async(tensors, outputs, name, op, prescale_factor, postsc
     try:
         handle = getattr(mpi_lib, function)(tensors, outputs, divisor,
                                             name.encode() if name is not None else _NULL, op,
-                                            prescale_factor, postscale_factor)
+                                            prescale_factor, postscale_factor, priority)
     except RuntimeError as e:
         raise HorovodInternalError(e)
     _handle_map[handle] = (tuple(tensors), tuple(outputs))
@@ -394,6 +488,8 @@ class HorovodGroupedAllreduce(torch.autograd.Function):
 
     @staticmethod
     def backward(ctx, *grad_output):
+        if ctx.op in (Min, Max, Product):
+            raise NotImplementedError('The gradient of a grouped Min, Max or Product allreduce is not supported.')
         grad_reduced = grouped_allreduce(list(grad_output), average=ctx.average, op=ctx.op,
                                          prescale_factor=ctx.prescale_factor,
                                          postscale_factor=ctx.postscale_factor)
@@ -445,7 +541,7 @@ def grouped_allreduce(tensors, average=None, name=None, compression=Compression.
 
 
 def grouped_allreduce_async_(tensors, average=None, name=None, op=None,
-                             prescale_factor=1.0, postscale_factor=1.0):
+                             prescale_factor=1.0, postscale_factor=1.0, priority=0):
     """
     A function that performs asynchronous in-place averaging or summation of the input
     tensors over all the Horovod processes.
@@ -469,13 +565,17 @@ def grouped_allreduce_async_(tensors, average=None, name=None, op=None,
             Average if None is given.
         prescale_factor: Multiplicative factor to scale tensor before allreduce.
         postscale_factor: Multiplicative factor to scale tensor after allreduce.
+        priority: Scheduling priority of the reductions. When several reductions are
+                  ready at the same time, those with a higher priority are
+                  performed first.
 
     Returns:
         A handle to the group allreduce operation that can be used with `poll()` or
         `synchronize()`.
     """
     op = handle_average_backwards_compatibility(op, average)
-    return _grouped_allreduce_async(tensors, tensors, name, op, prescale_factor, postscale_factor)
+    return _grouped_allreduce_async(tensors, tensors, name, op, prescale_factor, postscale_factor,
+                                    priority)
 
 
 def grouped_allreduce_(tensors, average=None, name=None, op=None,
@@ -513,6 +613,23 @@ def grouped_allreduce_(tensors, average=None, name=None, op=None,
 
 
 def sparse_allreduce_async(tensor, name, op):
+    """
+    A function that asynchronously reduces a sparse tensor across all Horovod processes.
+
+    By default the indices and values of all processes are allgathered, so the result
+    holds the rows of every process. With `HOROVOD_SPARSE_ALLREDUCE=alltoall` every row
+    is sent to the process that owns it (row index modulo the number of processes)
+    with an alltoall, summed there, and only the reduced rows are allgathered. The
+    result then grows with the number of unique rows instead of the number of
+    processes. Its second stage runs when the handle is called, so all processes must
+    call the handles of their sparse allreduces in the same order.
+
+    Returns:
+        A function that waits for the operation and returns the reduced sparse tensor.
+    """
+    if os.environ.get('HOROVOD_SPARSE_ALLREDUCE', 'allgather').lower() == 'alltoall':
+        return _sparse_allreduce_alltoall_async(tensor, name, op)
+
     # Allgather aggregates along the first dimension, so we need to transpose the
     # indices to enforce correct concatenation behavior, then transpose back prior to
     # constructing the new aggregated sparse gradient
@@ -535,22 +652,55 @@ def sparse_allreduce_async(tensor, name, op):
     return handle
 
 
+def _sparse_allreduce_alltoall_async(tensor, name, op):
+    # Send every row to its owner, ordered by owner as alltoall expects.
+    t = tensor.coalesce()
+    indices = t._indices()
+    values = t._values()
+    owners = indices[0] % size()
+    order = torch.argsort(owners)
+    splits = torch.bincount(owners, minlength=size()).to(dtype=torch.int32, device='cpu')
+    indices_handle = alltoall_async(indices[:, order].transpose(0, 1).contiguous(), splits=splits,
+                                    name=f'{name}.indices')
+    values_handle = alltoall_async(values[order].contiguous(), splits=splits, name=f'{name}.values')
+
+    def handle():
+        values, _ = synchronize(values_handle)
+        indices, _ = synchronize(indices_handle)
+
+        # Sum the duplicate rows this process owns, then share them with all others.
+        owned = t.new(indices.transpose(0, 1), values, t.size()).coalesce()
+        values_handle_ = allgather_async(owned._values(), name=f'{name}.reduced_values')
+        indices_handle_ = allgather_async(owned._indices().transpose(0, 1).contiguous(),
+                                          name=f'{name}.reduced_indices')
+        values = synchronize(values_handle_)
+        indices = synchronize(indices_handle_)
+
+        values = (values / size()) if op == Average else values
+
+        if indices.dim() == 0 or values.dim() == 0:
+            return t.new().resize_as_(t)
+        return t.new(indices.transpose(0, 1), values, t.size())
+
+    return handle
+
+
 def _allgather_function_factory(tensor):
     return 'horovod_torch_allgather_async_' + tensor.type().replace('.', '_')
 
 
-def _allgather_async(tensor, output, name):
+def _allgather_async(tensor, output, name, preallocated=False):
     function = _check_function(_allgather_function_factory, tensor)
     try:
         handle = getattr(mpi_lib, function)(
-            tensor, output, name.encode() if name is not None else _NULL)
+            tensor, output, name.encode() if name is not None else _NULL, preallocated)
     except RuntimeError as e:
         raise HorovodInternalError(e)
     _handle_map[handle] = (tensor, output)
     return handle
 
 
-def allgather_async(tensor, name=None):
+def allgather_async(tensor, name=None, output=None):
     """
     A function that asynchronously concatenates the input tensor with the same input
     tensor on all other Horovod processes. The input tensor is not modified.
@@ -562,11 +712,16 @@ def allgather_async(tensor, name=None):
     Arguments:
         tensor: A tensor to allgather.
         name: A name of the allgather operation.
+        output: A preallocated tensor of the shape of the result to gather into,
+                e.g. for allgathers of the same shape every step. Allgathers that
+                are not fused with others write straight into it.
 
     Returns:
         A handle to the allgather operation that can be used with `poll()` or
         `synchronize()`.
     """
+    if output is not None:
+        return _allgather_async(tensor, output, name, preallocated=True)
     output = tensor.new()
     return _allgather_async(tensor, output, name)
 
@@ -618,6 +773,93 @@ def allgather(tensor, name=None):
     return HorovodAllgather.apply(tensor, name)
 
 
+def _grouped_allgather_function_factory(tensor):
+    return 'horovod_torch_grouped_allgather_async_' + tensor.type().replace('.', '_')
+
+
+def _grouped_allgather_async(tensors, outputs, name):
+    function = _check_function(_grouped_allgather_function_factory, tensors[0])
+    try:
+        handle = getattr(mpi_lib, function)(
+            tensors, outputs, name.encode() if name is not None else _NULL)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+    _handle_map[handle] = (tuple(tensors), outputs)
+    return handle
+
+
+def grouped_allgather_async(tensors, name=None):
+    """
+    A function that asynchronously concatenates each input tensor with the
+    corresponding input tensors on all other Horovod processes, see
+    `allgather_async`. The tensors of the group are negotiated and gathered
+    together. The input tensors are not modified.
+
+    The allgather operations are keyed by the base name. If a base name is not
+    provided, an incremented auto-generated base name is used. All tensors must
+    be on the same device.
+
+    Arguments:
+        tensors: A list of tensors to allgather.
+        name: A base name to use for the group allgather operation.
+
+    Returns:
+        A handle to the group allgather operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    outputs = [t.new() for t in tensors]
+    return _grouped_allgather_async(tensors, outputs, name)
+
+
+class HorovodGroupedAllgather(torch.autograd.Function):
+    """An autograd function that performs allgather on a list of tensors."""
+
+    @staticmethod
+    def forward(ctx, name, *tensors):
+        ctx.dims = [t.shape[0] for t in tensors]
+        handle = grouped_allgather_async(list(tensors), name)
+        return tuple(synchronize(handle))
+
+    @staticmethod
+    def backward(ctx, *grad_output):
+        grad_reduced = grouped_allreduce(list(grad_output), average=True)
+
+        dim_t = torch.IntTensor(ctx.dims)
+        dims = allgather(dim_t).view(size(), len(ctx.dims))
+
+        r = rank()
+        offsets = torch.sum(dims.narrow(0, 0, r), dim=0).tolist() if r != 0 \
+            else [0] * len(ctx.dims)
+        return (None, *[g.narrow(0, offset, dim) for g, offset, dim
+                        in zip(grad_reduced, offsets, ctx.dims)])
+
+
+def grouped_allgather(tensors, name=None):
+    """
+    A function that concatenates each input tensor with the corresponding input
+    tensors on all other Horovod processes, see `allgather`. The tensors of the
+    group are negotiated and gathered together. The input tensors are not
+    modified.
+
+    The allgather operations are keyed by the base name. If a base name is not
+    provided, an incremented auto-generated base name is used. All tensors must
+    be on the same device.
+
+    This acts as a thin wrapper around an autograd function.  If your input
+    tensors require gradients, then callings this function will allow gradients
+    to be computed and backpropagated.
+
+    Arguments:
+        tensors: A list of tensors to allgather.
+        name: A base name to use for the group allgather operation.
+
+    Returns:
+        A list of tensors of the same types as `tensors`, each concatenated on
+        dimension zero across all processes.
+    """
+    return list(HorovodGroupedAllgather.apply(name, *tensors))
+
+
 def _broadcast_function_factory(tensor):
     return 'horovod_torch_broadcast_async_' + tensor.type().replace('.', '_')
 
@@ -743,26 +985,159 @@ def broadcast_(tensor, root_rank, name=None):
     handle = broadcast_async_(tensor, root_rank, name)
     return synchronize(handle)
 
+
+def _grouped_broadcast_function_factory(tensor):
+    return 'horovod_torch_grouped_broadcast_async_' + tensor.type().replace('.', '_')
+
+
+def _grouped_broadcast_async(tensors, outputs, root_rank, name):
+    function = _check_function(_grouped_broadcast_function_factory, tensors[0])
+    try:
+        handle = getattr(mpi_lib, function)(
+            tensors, outputs, root_rank, name.encode() if name is not None else _NULL)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+    _handle_map[handle] = (tuple(tensors), outputs)
+    return handle
+
+
+def grouped_broadcast_async(tensors, root_rank, name=None):
+    """
+    A function that asynchronously broadcasts a list of tensors on root rank to
+    the same tensors on all other Horovod processes, see `broadcast_async`. The
+    tensors of the group are negotiated together and fused into as few
+    broadcasts as the fusion buffer allows. The input tensors are not modified.
+
+    The broadcast operations are keyed by the base name. If a base name is not
+    provided, an incremented auto-generated base name is used. All tensors must
+    be on the same device.
+
+    Arguments:
+        tensors: A list of tensors to broadcast.
+        root_rank: The rank to broadcast the values from.
+        name: A base name to use for the group broadcast operation.
+
+    Returns:
+        A handle to the group broadcast operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    outputs = [t.new(t.shape) for t in tensors]
+    return _grouped_broadcast_async(tensors, outputs, root_rank, name)
+
+
+class HorovodGroupedBroadcast(torch.autograd.Function):
+    """An autograd function that broadcasts a list of tensors."""
+
+    @staticmethod
+    def forward(ctx, root_rank, name, *tensors):
+        ctx.root_rank = root_rank
+        handle = grouped_broadcast_async(list(tensors), root_rank, name)
+        return tuple(synchronize(handle))
+
+    @staticmethod
+    def backward(ctx, *grad_output):
+        grad_reduced = grouped_allreduce(list(grad_output), average=True)
+        if rank() != ctx.root_rank:
+            grad_reduced = [g * 0 for g in grad_reduced]
+        return (None, None, *grad_reduced)
+
+
+def grouped_broadcast(tensors, root_rank, name=None):
+    """
+    A function that broadcasts a list of tensors on root rank to the same
+    tensors on all other Horovod processes, see `broadcast`. The tensors of the
+    group are negotiated together and fused into as few broadcasts as the
+    fusion buffer allows. The input tensors are not modified.
+
+    The broadcast operations are keyed by the base name. If a base name is not
+    provided, an incremented auto-generated base name is used. All tensors must
+    be on the same device.
+
+    This acts as a thin wrapper around an autograd function.  If your input
+    tensors require gradients, then callings this function will allow gradients
+    to be computed and backpropagated.
+
+    Arguments:
+        tensors: A list of tensors to broadcast.
+        root_rank: The rank to broadcast the values from.
+        name: A base name to use for the group broadcast operation.
+
+    Returns:
+        A list of tensors of the same shapes and types as `tensors`, with the
+        values broadcasted from root rank.
+    """
+    return list(HorovodGroupedBroadcast.apply(root_rank, name, *tensors))
+
+
+def grouped_broadcast_async_(tensors, root_rank, name=None):
+    """
+    A function that asynchronously broadcasts a list of tensors on root rank to
+    the same tensors on all other Horovod processes, see `broadcast_async_`. The
+    operation is performed in-place.
+
+    The broadcast operations are keyed by the base name. If a base name is not
+    provided, an incremented auto-generated base name is used. All tensors must
+    be on the same device.
+
+    Arguments:
+        tensors: A list of tensors to broadcast.
+        root_rank: The rank to broadcast the values from.
+        name: A base name to use for the group broadcast operation.
+
+    Returns:
+        A handle to the group broadcast operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    return _grouped_broadcast_async(tensors, tensors, root_rank, name)
+
+
+def grouped_broadcast_(tensors, root_rank, name=None):
+    """
+    A function that broadcasts a list of tensors on root rank to the same
+    tensors on all other Horovod processes, see `broadcast_`. The operation is
+    performed in-place.
+
+    The broadcast operations are keyed by the base name. If a base name is not
+    provided, an incremented auto-generated base name is used. All tensors must
+    be on the same device.
+
+    Arguments:
+        tensors: A list of tensors to broadcast.
+        root_rank: The rank to broadcast the values from.
+        name: A base name to use for the group broadcast operation.
+
+    Returns:
+        A list of tensors of the same shapes and types as `tensors`, with the
+        values broadcasted from root rank.
+    """
+    handle = grouped_broadcast_async_(tensors, root_rank, name)
+    return synchronize(handle)
+
 def _alltoall_function_factory(tensor):
     return 'horovod_torch_alltoall_async_' + tensor.type().replace('.', '_')
 
-def _alltoall_async(tensor, splits, output, output_received_splits, name):
+def _alltoall_async(tensor, splits, output, output_received_splits, name, recv_splits=None):
     if splits is None:
         # If splits not provided, create empty tensor as placeholder
         splits = torch.tensor([], dtype=torch.int32, device='cpu')
     elif not isinstance(splits, torch.Tensor):
         splits = torch.tensor(splits, dtype=torch.int32, device='cpu')
+    if recv_splits is None:
+        recv_splits = torch.tensor([], dtype=torch.int32, device='cpu')
+    elif not isinstance(recv_splits, torch.Tensor):
+        recv_splits = torch.tensor(recv_splits, dtype=torch.int32, device='cpu')
     function = _check_function(_alltoall_function_factory, tensor)
     try:
         handle = getattr(mpi_lib, function)(
-            tensor, splits, output, output_received_splits, name.encode() if name is not None else _NULL)
+            tensor, splits, recv_splits, output, output_received_splits,
+            name.encode() if name is not None else _NULL)
     except RuntimeError as e:
         raise HorovodInternalError(e)
     _handle_map[handle] = (tensor, splits, (output, output_received_splits))
     return handle
 
 
-def alltoall_async(tensor, splits=None, name=None):
+def alltoall_async(tensor, splits=None, name=None, recv_splits=None):
     """
     A function that scatters slices of the input tensor to all other Horovod processes
     and returns a tensor of gathered slices from all other Horovod processes. The input
@@ -780,6 +1155,11 @@ def alltoall_async(tensor, splits=None, name=None):
                 not provided, the first dimension is split equally by the
                 number of Horovod processes.
         name: A name of the alltoall operation.
+        recv_splits: A tensor of integers in rank order describing how many
+                     elements this worker receives from each worker, if known
+                     in advance, e.g. with a fixed capacity. The splits are then
+                     not exchanged before the alltoall. Must be given on all
+                     workers or none.
 
     Returns:
         A handle to the alltoall operation that can be used with `poll()` or
@@ -790,18 +1170,21 @@ def alltoall_async(tensor, splits=None, name=None):
         output_received_splits = splits.new()
     else:
         output_received_splits = torch.empty(size(), dtype=torch.int32, device='cpu')
-    return _alltoall_async(tensor, splits, output, output_received_splits, name)
+    return _alltoall_async(tensor, splits, output, output_received_splits, name, recv_splits)
 
 
 class HorovodAlltoall(torch.autograd.Function):
     """An autograd function that performs alltoall on a tensor."""
 
     @staticmethod
-    def forward(ctx, tensor, splits, name):
-        handle = alltoall_async(tensor, splits, name)
+    def forward(ctx, tensor, splits, name, recv_splits):
+        handle = alltoall_async(tensor, splits, name, recv_splits)
         output, received_splits = synchronize(handle)
 
         ctx.recvsplits = received_splits
+        # The gradients come back in the slices they were sent out in.
+        ctx.sendsplits = splits if splits is not None else \
+            [tensor.shape[0] // size()] * size()
         if splits is None:
             return output
         else:
@@ -810,11 +1193,12 @@ class HorovodAlltoall(torch.autograd.Function):
 
     @staticmethod
     def backward(ctx, grad_output, *dead_gradients):
-        grad_wrt_tensor, _ = alltoall(grad_output, splits=ctx.recvsplits)
-        return grad_wrt_tensor, None, None
+        grad_wrt_tensor, _ = alltoall(grad_output, splits=ctx.recvsplits,
+                                      recv_splits=ctx.sendsplits)
+        return grad_wrt_tensor, None, None, None
 
 
-def alltoall(tensor, splits=None, name=None):
+def alltoall(tensor, splits=None, name=None, recv_splits=None):
     """
     A function that scatters slices of the input tensor to all other Horovod processes
     and returns a tensor of gathered slices from all other Horovod processes. The input
@@ -836,6 +1220,11 @@ def alltoall(tensor, splits=None, name=None):
                 not provided, the first dimension is split equally by the
                 number of Horovod processes.
         name: A name of the alltoall operation.
+        recv_splits: A tensor of integers in rank order describing how many
+                     elements this worker receives from each worker, if known
+                     in advance, e.g. with a fixed capacity. The splits are then
+                     not exchanged before the alltoall. Must be given on all
+                     workers or none.
 
     Returns:
         1) A tensor containing the gathered tensor data from all workers.
@@ -843,7 +1232,461 @@ def alltoall(tensor, splits=None, name=None):
            describing how many elements in the output tensor have been received
            from each worker.
      """
-    return HorovodAlltoall.apply(tensor, splits, name)
+    return HorovodAlltoall.apply(tensor, splits, name, recv_splits)
+
+
+def _grouped_alltoall_function_factory(tensor):
+    return 'horovod_torch_grouped_alltoall_async_' + tensor.type().replace('.', '_')
+
+
+def _grouped_alltoall_async(tensors, splits, outputs, output_received_splits, name):
+    splits = [torch.tensor([], dtype=torch.int32, device='cpu') if s is None
+              else s if isinstance(s, torch.Tensor)
+              else torch.tensor(s, dtype=torch.int32, device='cpu')
+              for s in splits]
+    function = _check_function(_grouped_alltoall_function_factory, tensors[0])
+    try:
+        handle = getattr(mpi_lib, function)(
+            tensors, splits, outputs, output_received_splits,
+            name.encode() if name is not None else _NULL)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+    _handle_map[handle] = (tuple(tensors), tuple(splits),
+                           (outputs, output_received_splits))
+    return handle
+
+
+def grouped_alltoall_async(tensors, splits=None, name=None):
+    """
+    A function that performs asynchronous alltoall on a list of tensors, see
+    `alltoall_async`. The tensors are fused into a single exchange, which saves
+    the latency of one alltoall per tensor, e.g. for the tokens, routing weights
+    and expert indices of a mixture-of-experts layer. The input tensors are not
+    modified.
+
+    The alltoall operations are keyed by the base name. If a base name is not
+    provided, an incremented auto-generated base name is used. The tensors may
+    have different types, but must all be on the same device.
+
+    Arguments:
+        tensors: A list of tensors to distribute with alltoall.
+        splits: A list with the splits of every tensor, see `alltoall_async`.
+                Entries may be None to split the first dimension of their
+                tensor equally. If `splits` is not provided, all tensors are
+                split equally.
+        name: A base name to use for the group alltoall operation.
+
+    Returns:
+        A handle to the group alltoall operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    if splits is None:
+        splits = [None] * len(tensors)
+    if len(splits) != len(tensors):
+        raise ValueError('grouped_alltoall expects one splits entry per tensor.')
+    outputs = [t.new() for t in tensors]
+    output_received_splits = [s.new() if isinstance(s, torch.Tensor)
+                              else torch.empty(size(), dtype=torch.int32, device='cpu')
+                              for s in splits]
+    return _grouped_alltoall_async(tensors, splits, outputs, output_received_splits, name)
+
+
+class HorovodGroupedAlltoall(torch.autograd.Function):
+    """An autograd function that performs alltoall on a list of tensors."""
+
+    @staticmethod
+    def forward(ctx, splits, name, *tensors):
+        handle = grouped_alltoall_async(list(tensors), splits, name)
+        outputs, received_splits = synchronize(handle)
+
+        ctx.recvsplits = received_splits
+        ctx.mark_non_differentiable(*received_splits)
+        return (*outputs, *received_splits)
+
+    @staticmethod
+    def backward(ctx, *grad_output):
+        grad_output = grad_output[:len(ctx.recvsplits)]
+        grad_wrt_tensors, _ = grouped_alltoall(list(grad_output), splits=ctx.recvsplits)
+        return (None, None, *grad_wrt_tensors)
+
+
+def grouped_alltoall(tensors, splits=None, name=None):
+    """
+    A function that performs alltoall on a list of tensors, see `alltoall`. The
+    tensors are fused into a single exchange, which saves the latency of one
+    alltoall per tensor, e.g. for the tokens, routing weights and expert indices
+    of a mixture-of-experts layer. The input tensors are not modified.
+
+    The alltoall operations are keyed by the base name. If a base name is not
+    provided, an incremented auto-generated base name is used. The tensors may
+    have different types, but must all be on the same device.
+
+    This acts as a thin wrapper around an autograd function.  If your input
+    tensors require gradients, then callings this function will allow gradients
+    to be computed and backpropagated.
+
+    Arguments:
+        tensors: A list of tensors to distribute with alltoall.
+        splits: A list with the splits of every tensor, see `alltoall`. Entries
+                may be None to split the first dimension of their tensor
+                equally. If `splits` is not provided, all tensors are split
+                equally.
+        name: A base name to use for the group alltoall operation.
+
+    Returns:
+        1) A list of tensors containing the gathered tensor data from all workers.
+        2) A list of tensors of integers in rank order describing how many
+           elements of each output tensor have been received from each worker.
+    """
+    results = HorovodGroupedAlltoall.apply(splits, name, *tensors)
+    return list(results[:len(tensors)]), list(results[len(tensors):])
+
+
+def _reducescatter_function_factory(tensor):
+    return 'horovod_torch_reducescatter_async_' + tensor.type().replace('.', '_')
+
+
+def _reducescatter_async(tensor, output, name, op):
+    function = _check_function(_reducescatter_function_factory, tensor)
+    try:
+        handle = getattr(mpi_lib, function)(
+            tensor, output, name.encode() if name is not None else _NULL, op)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+    _handle_map[handle] = (tensor, output)
+    return handle
+
+
+def reducescatter_async(tensor, name=None, op=Average):
+    """
+    A function that asynchronously reduces the input tensor across all Horovod
+    processes and scatters the result along the first dimension, so that each
+    process receives a distinct slice. The input tensor is not modified.
+
+    The input tensors on the different processes must have the same shape. If the
+    first dimension is not divisible by the number of processes, the lower ranks
+    receive one extra slice each.
+
+    Arguments:
+        tensor: A tensor to reduce and scatter.
+        name: A name of the reducescatter operation.
+        op: The reduction operation to combine tensors across different ranks.
+            Only Average and Sum are supported. Defaults to Average.
+
+    Returns:
+        A handle to the reducescatter operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    output = tensor.new()
+    return _reducescatter_async(tensor, output, name, op)
+
+
+class HorovodReducescatter(torch.autograd.Function):
+    """An autograd function that performs reducescatter on a tensor."""
+
+    @staticmethod
+    def forward(ctx, tensor, name, op):
+        ctx.op = op
+        handle = reducescatter_async(tensor, name, op)
+        return synchronize(handle)
+
+    @staticmethod
+    def backward(ctx, grad_output):
+        grad_reduced = allgather(grad_output)
+        if ctx.op == Average:
+            grad_reduced /= size()
+        return grad_reduced, None, None
+
+
+def reducescatter(tensor, name=None, op=Average):
+    """
+    A function that reduces the input tensor across all Horovod processes and
+    scatters the result along the first dimension, so that each process receives
+    a distinct slice. The input tensor is not modified.
+
+    The input tensors on the different processes must have the same shape. If the
+    first dimension is not divisible by the number of processes, the lower ranks
+    receive one extra slice each.
+
+    This acts as a thin wrapper around an autograd function.  If your input
+    tensor requires gradients, then callings this function will allow gradients
+    to be computed and backpropagated.
+
+    Arguments:
+        tensor: A tensor to reduce and scatter.
+        name: A name of the reducescatter operation.
+        op: The reduction operation to combine tensors across different ranks.
+            Only Average and Sum are supported. Defaults to Average.
+
+    Returns:
+        A tensor of the same type as `tensor`, reduced across all processes and
+        holding this process's slice of the first dimension.
+    """
+    return HorovodReducescatter.apply(tensor, name, op)
+
+
+def send_async(tensor, dst, name=None):
+    """
+    A function that asynchronously sends the input tensor to the process of rank `dst`,
+    which receives it with `recv` or `recv_async`. The input tensor is not modified.
+
+    Sends and receives are not negotiated with the other processes: the messages
+    between two processes are matched in the order in which they were enqueued, and
+    sends and receives of tensors ready at the same time are posted together. Requires
+    the MPI controller; CUDA tensors are staged through host memory unless Horovod
+    was built with HOROVOD_GPU_BROADCAST=MPI.
+
+    Arguments:
+        tensor: A tensor to send.
+        dst: The rank of the process to send the tensor to.
+        name: A name of the send operation.
+
+    Returns:
+        A handle to the send operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    try:
+        handle = mpi_lib.horovod_torch_send_async(
+            tensor, dst, name.encode() if name is not None else _NULL)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+    _handle_map[handle] = (tensor, tensor)
+    return handle
+
+
+def send(tensor, dst, name=None):
+    """
+    A function that sends the input tensor to the process of rank `dst` and waits until
+    the send has completed. See `send_async`.
+
+    Arguments:
+        tensor: A tensor to send.
+        dst: The rank of the process to send the tensor to.
+        name: A name of the send operation.
+    """
+    synchronize(send_async(tensor, dst, name))
+
+
+def recv_async(tensor, src, name=None):
+    """
+    A function that asynchronously receives a tensor sent by the process of rank `src`
+    with `send` or `send_async` into the input tensor. The operation is performed
+    in-place, the sent tensor must have the same size in bytes. See `send_async`.
+
+    Arguments:
+        tensor: A tensor to receive into.
+        src: The rank of the process to receive the tensor from.
+        name: A name of the receive operation.
+
+    Returns:
+        A handle to the receive operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    try:
+        handle = mpi_lib.horovod_torch_recv_async(
+            tensor, src, name.encode() if name is not None else _NULL)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+    _handle_map[handle] = (tensor, tensor)
+    return handle
+
+
+def recv(tensor, src, name=None):
+    """
+    A function that receives a tensor sent by the process of rank `src` into the input
+    tensor. See `recv_async`.
+
+    Arguments:
+        tensor: A tensor to receive into.
+        src: The rank of the process to receive the tensor from.
+        name: A name of the receive operation.
+
+    Returns:
+        The input tensor, holding the received values.
+    """
+    return synchronize(recv_async(tensor, src, name))
+
+
+def reduce_async(tensor, root_rank, name=None, op=Average):
+    """
+    A function that asynchronously reduces the input tensor across all Horovod
+    processes into the process of rank `root_rank`. The input tensor is not modified.
+
+    Unlike `allreduce_async`, only the root receives the result, which saves the
+    bandwidth of distributing it. The input tensors on the different processes must
+    have the same shape.
+
+    Arguments:
+        tensor: A tensor to reduce.
+        root_rank: The rank of the process to reduce the tensor into.
+        name: A name of the reduce operation.
+        op: The reduction operation to combine tensors across different ranks.
+            Adasum is not supported. Defaults to Average.
+
+    Returns:
+        A handle to the reduce operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    output = tensor.new(tensor.shape) if rank() == root_rank else tensor
+    try:
+        handle = mpi_lib.horovod_torch_reduce_async(
+            tensor, output, root_rank, name.encode() if name is not None else _NULL, op)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+    _handle_map[handle] = (tensor, output)
+    return handle
+
+
+def reduce(tensor, root_rank, name=None, op=Average):
+    """
+    A function that reduces the input tensor across all Horovod processes into the
+    process of rank `root_rank`. See `reduce_async`.
+
+    Arguments:
+        tensor: A tensor to reduce.
+        root_rank: The rank of the process to reduce the tensor into.
+        name: A name of the reduce operation.
+        op: The reduction operation to combine tensors across different ranks.
+            Adasum is not supported. Defaults to Average.
+
+    Returns:
+        On the root, a tensor of the same shape and type as `tensor`, reduced across
+        all processes. On the other processes, the input tensor.
+    """
+    return synchronize(reduce_async(tensor, root_rank, name, op))
+
+
+def gather_async(tensor, root_rank, name=None):
+    """
+    A function that asynchronously concatenates the input tensor with the same input
+    tensor on all other Horovod processes on the process of rank `root_rank`. The input
+    tensor is not modified.
+
+    The concatenation is done on the first dimension, so the input tensors on the
+    different processes must have the same rank and shape, except for the first
+    dimension, which is allowed to be different. Gathering CUDA tensors in device
+    memory requires NCCL 2.7 or later.
+
+    Arguments:
+        tensor: A tensor to gather.
+        root_rank: The rank of the process to gather the tensors on.
+        name: A name of the gather operation.
+
+    Returns:
+        A handle to the gather operation that can be used with `poll()` or
+        `synchronize()`.
+    """
+    output = tensor.new()
+    try:
+        handle = mpi_lib.horovod_torch_gather_async(
+            tensor, output, root_rank, name.encode() if name is not None else _NULL)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+    _handle_map[handle] = (tensor, output)
+    return handle
+
+
+def gather(tensor, root_rank, name=None):
+    """
+    A function that concatenates the input tensor with the same input tensor on all
+    other Horovod processes on the process of rank `root_rank`. See `gather_async`.
+
+    Arguments:
+        tensor: A tensor to gather.
+        root_rank: The rank of the process to gather the tensors on.
+        name: A name of the gather operation.
+
+    Returns:
+        On the root, a tensor of the same type as `tensor`, concatenated on dimension
+        zero across all processes. On the other processes, an empty tensor with a
+        first dimension of zero.
+    """
+    return synchronize(gather_async(tensor, root_rank, name))
+
+
+def barrier(process_set=global_process_set):
+    """
+    A function that blocks until all processes of the process set have called it.
+
+    The barrier runs on the calling thread against the controller of the process set,
+    without going through negotiation. With MPI, that requires multi-threading support;
+    otherwise the barrier falls back to a negotiated allreduce of a dummy tensor, which
+    is only supported for the global process set.
+
+    Arguments:
+        process_set: Process set object to wait for. Defaults to the global process set.
+    """
+    if _basics.barrier(process_set):
+        return
+    if process_set.process_set_id != 0:
+        raise NotImplementedError('Barriers of process sets require MPI with multi-threading '
+                                  'support or Gloo.')
+    synchronize(allreduce_async(torch.zeros(1), name='barrier', op=Sum))
+
+
+def init_capturable_allreduce(process_set=global_process_set):
+    """
+    A function that creates the NCCL communicator `capturable_allreduce_` uses on the
+    current CUDA device for the process set. It must be called by all processes, also
+    those outside of the process set, after `init()` and before the first capturable
+    allreduce of the process set on the device.
+
+    Arguments:
+        process_set: Process set object to reduce over. Defaults to the global process set.
+    """
+    device = torch.cuda.current_device()
+    ranks = process_set.ranks or list(range(size()))
+    # The first rank of the process set makes the id, which reaches the other
+    # ranks of the set through an allgather over all processes.
+    nccl_id = mpi_lib.horovod_torch_capturable_allreduce_id(rank() == ranks[0])
+    nccl_ids = allgather(nccl_id.unsqueeze(0),
+                         name='capturable_allreduce.id.%d.%d' % (process_set.process_set_id, device))
+    if not process_set.included():
+        return
+    try:
+        mpi_lib.horovod_torch_init_capturable_allreduce(nccl_ids[ranks[0]], device,
+                                                        process_set.process_set_id)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+
+
+def capturable_allreduce_(tensors, op=Average, prescale_factor=1.0, postscale_factor=1.0,
+                          process_set=global_process_set):
+    """
+    A function that performs in-place allreduces of the input CUDA tensors over the
+    processes of the process set with NCCL, on the current CUDA stream and from the
+    calling thread, so that it can be captured with `torch.cuda.graph` along with the
+    rest of a training step. The tensors are reduced together in one NCCL group.
+
+    Unlike `allreduce_`, the operation is not negotiated with the other processes:
+    all of them must make the same calls, with tensors of the same sizes and types,
+    in the same order. In exchange it does not wait for a cycle of the background
+    thread, which suits the small allreduces of every layer in tensor-parallel
+    inference. Requires `init_capturable_allreduce()` and Horovod built with NCCL;
+    graph capture also requires NCCL 2.9.6 or later.
+
+    Arguments:
+        tensors: A CUDA tensor or a list of contiguous CUDA tensors of one device.
+        op: The reduction operation, Average, Sum, Min, Max or Product. Min, Max and
+            Product do not support prescale_factor or postscale_factor.
+        prescale_factor: Multiplicative factor to scale tensors before allreduce.
+        postscale_factor: Multiplicative factor to scale tensors after allreduce.
+        process_set: Process set object to reduce over. Defaults to the global process set.
+
+    Returns:
+        The input tensors, holding the reduced values.
+    """
+    if isinstance(tensors, torch.Tensor):
+        tensors = [tensors]
+    if any(not t.is_contiguous() for t in tensors):
+        raise ValueError('capturable_allreduce_ requires contiguous tensors.')
+    try:
+        mpi_lib.horovod_torch_capturable_allreduce(tensors, tensors, op,
+                                                   prescale_factor, postscale_factor,
+                                                   process_set.process_set_id)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+    return tensors
 
 
 def poll(handle):
@@ -864,11 +1707,12 @@ def poll(handle):
 
 def synchronize(handle):
     """
-    Synchronizes an asynchronous allreduce, allgather, alltoall or broadcast operation until
-    it's completed. Returns the result of the operation.
+    Synchronizes an asynchronous allreduce, allgather, alltoall, broadcast or reducescatter
+    operation until it's completed. Returns the result of the operation.
 
     Arguments:
-        handle: A handle returned by an allreduce, allgather, alltoall or broadcast asynchronous
+        handle: A handle returned by an allreduce, allgather, alltoall, broadcast or
+                reducescatter asynchronous
                 operation.
 
     Returns:
@@ -885,6 +1729,26 @@ def synchronize(handle):
         raise HorovodInternalError(e)
 
 
+def synchronize_all(handles):
+    """
+    Synchronizes a list of asynchronous operations, waiting once until all of them
+    have completed instead of waking up for each of them in turn. Returns the results
+    in the order of the handles.
+
+    Arguments:
+        handles: A list of handles returned by asynchronous operations.
+
+    Returns:
+        A list with the output of each operation, see `synchronize`.
+    """
+    pending = [handle for handle in handles if handle in _handle_map]
+    try:
+        mpi_lib.horovod_torch_wait_all(pending)
+    except RuntimeError as e:
+        raise HorovodInternalError(e)
+    return [synchronize(handle) for handle in handles]
+
+
 def join(device=-1):
     """A function that indicates that the rank finished processing data.
 
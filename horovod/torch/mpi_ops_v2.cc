@@ -16,6 +16,7 @@
 // =============================================================================
 
 #if HAVE_GPU
+#include <c10/cuda/CUDAGuard.h>
 #if TORCH_VERSION >= 1005000000
 #include <c10/cuda/CUDAStream.h>
 #include <c10/cuda/CUDAException.h>
@@ -25,8 +26,11 @@
 #endif
 
 #include <chrono>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <torch/extension.h>
 #include <torch/torch.h>
 
@@ -86,9 +90,124 @@ gpuStream_t GetGPUStream(int device) {
 }
 #endif
 
+namespace {
+
+#if HAVE_GPU
+// Stream of device that copies tensors to and from their host staging
+// buffers, so that the copies do not queue behind later compute.
+c10::cuda::CUDAStream GetStagingStream(int device) {
+  static std::mutex mutex;
+  static std::unordered_map<int, c10::cuda::CUDAStream> streams;
+  std::lock_guard<std::mutex> guard(mutex);
+  auto it = streams.find(device);
+  if (it == streams.end()) {
+    it = streams.emplace(device, c10::cuda::getStreamFromPool(false, device))
+             .first;
+  }
+  return it->second;
+}
+
+// Staged tensors whose copies back to the device may still be running, with
+// the event recorded after those copies.
+std::mutex staged_mutex;
+std::deque<std::pair<std::vector<::torch::Tensor>,
+                     std::shared_ptr<common::ReadyEvent>>>
+    staged_in_flight;
+#endif
+
+// Copies CUDA tensors of device to views of one contiguous pinned host
+// buffer, so that the CPU collective of a group can run on it without a
+// fusion buffer copy. The buffer comes from the caching host allocator of
+// PyTorch, which reuses freed buffers by size class. The copies run on the
+// staging stream after the work queued so far on the current stream, and
+// ready_event_list completes with them.
+std::vector<::torch::Tensor>
+StageToHost(const std::vector<::torch::Tensor>& tensors, int device,
+            common::ReadyEventList& ready_event_list) {
+  std::vector<::torch::Tensor> views;
+  views.reserve(tensors.size());
+#if HAVE_GPU
+  std::vector<int64_t> offsets;
+  int64_t size = 0;
+  for (auto& tensor : tensors) {
+    // Views of one type end up back to back.
+    int64_t element_size = tensor.element_size();
+    size = (size + element_size - 1) / element_size * element_size;
+    offsets.push_back(size);
+    size += tensor.numel() * element_size;
+  }
+  with_device device_guard(device);
+  auto buffer = ::torch::empty(
+      {size},
+      ::torch::TensorOptions().dtype(::torch::kUInt8).pinned_memory(true));
+  auto staging_stream = GetStagingStream(device);
+  auto inputs_ready = RecordReadyEvent(device);
+  HVD_GPU_CHECK(gpuStreamWaitEvent(staging_stream, inputs_ready->event(), 0));
+  c10::cuda::CUDAStreamGuard stream_guard(staging_stream);
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    // The view holds on to its input, whose memory must not be reused while
+    // the staging stream may still read it.
+    auto& tensor = tensors[i];
+    auto view = ::torch::from_blob(
+        (uint8_t*)buffer.data_ptr() + offsets[i], tensor.sizes(),
+        [buffer, tensor](void*) {}, tensor.options().device(::torch::kCPU));
+    view.copy_(tensor, /*non_blocking=*/true);
+    views.push_back(view);
+  }
+  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+#else
+  for (auto& tensor : tensors) {
+    views.push_back(tensor.to(::torch::Device(::torch::kCPU)));
+  }
+#endif
+  return views;
+}
+
+// Copies views made by StageToHost() into outputs of the same sizes on the
+// staging stream, dividing them by divisor if it is above 1, and makes the
+// current stream wait for them. The host buffer is released once the copies
+// are done.
+void UnstageFromHost(const std::vector<::torch::Tensor>& views,
+                     const std::vector<::torch::Tensor>& outputs, int device,
+                     int divisor) {
+  with_device device_guard(device);
+#if HAVE_GPU
+  std::shared_ptr<common::ReadyEvent> copied;
+  {
+    c10::cuda::CUDAStreamGuard stream_guard(GetStagingStream(device));
+    for (size_t i = 0; i < views.size(); ++i) {
+      auto output = outputs[i];
+      output.copy_(views[i], /*non_blocking=*/true);
+      if (divisor > 1) {
+        DivideInPlace(output, divisor);
+      }
+    }
+    copied = RecordReadyEvent(device);
+  }
+  HVD_GPU_CHECK(gpuStreamWaitEvent(GetGPUStream(device), copied->event(), 0));
+
+  std::lock_guard<std::mutex> guard(staged_mutex);
+  while (!staged_in_flight.empty() && staged_in_flight.front().second->Ready()) {
+    staged_in_flight.pop_front();
+  }
+  staged_in_flight.emplace_back(views, std::move(copied));
+#else
+  for (size_t i = 0; i < views.size(); ++i) {
+    auto output = outputs[i];
+    output.copy_(views[i]);
+    if (divisor > 1) {
+      DivideInPlace(output, divisor);
+    }
+  }
+#endif
+}
+
+} // namespace
+
 int DoAllreduce(::torch::Tensor tensor, ::torch::Tensor output, int divisor,
                 const std::string& name, int reduce_op_int,
-                double prescale_factor, double postscale_factor) {
+                double prescale_factor, double postscale_factor,
+                int priority) {
   ThrowIfError(common::CheckInitialized());
 
   auto handle = handle_manager.AllocateHandle();
@@ -119,55 +238,161 @@ int DoAllreduce(::torch::Tensor tensor, ::torch::Tensor output, int divisor,
           DivideInPlace(output, divisor);
         }
         handle_manager.MarkDone(handle, status);
-      }, reduce_op, prescale_factor, postscale_factor);
+      }, reduce_op, prescale_factor, postscale_factor, 0, priority);
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+#if HAVE_CUDA
+// Synchronous: returns once Horovod has enqueued the addition, which the
+// current stream then waits for before it may reuse the tensor.
+void DoAccumulate(::torch::Tensor tensor, const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = GetDeviceID(tensor);
+  common::ReadyEventList ready_event_list;
+  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
+
+  Event added;
+  ThrowIfError(AccumulateTensor(hvd_tensor, ready_event_list,
+                                GetOpName("allreduce", name, 0), device,
+                                added));
+  with_device device_guard(device);
+  HVD_GPU_CHECK(gpuStreamWaitEvent(GetGPUStream(device), *(added.event), 0));
+}
+
+int DoAccumulatedAllreduce(::torch::Tensor tensor, ::torch::Tensor output,
+                           const std::string& name, int reduce_op_int,
+                           double prescale_factor, double postscale_factor,
+                           int priority) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto handle = handle_manager.AllocateHandle();
+  auto device = GetDeviceID(tensor);
+  common::ReadyEventList ready_event_list;
+  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
+  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
+  auto hvd_output = std::make_shared<TorchTensor>(output);
+
+  ReduceOp reduce_op = static_cast<ReduceOp>(reduce_op_int);
+
+  auto enqueue_result = EnqueueTensorAccumulatedAllreduce(
+      hvd_context, hvd_tensor, hvd_output, ready_event_list,
+      GetOpName("allreduce", name, 0), device,
+      [handle, device](const Status& status) mutable {
+        auto hvd_event = status.event;
+        if (hvd_event.event) {
+          auto stream = GetGPUStream(device);
+          HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
+        }
+        handle_manager.MarkDone(handle, status);
+      }, reduce_op, prescale_factor, postscale_factor, 0, priority);
   ThrowIfError(enqueue_result);
 
   return handle;
 }
+#endif
 
 int DoAllreduceCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output, int divisor,
                          const std::string& name, int reduce_op_int,
-                         double prescale_factor, double postscale_factor) {
+                         double prescale_factor, double postscale_factor,
+                         int priority) {
   ThrowIfError(common::CheckInitialized());
 
   // Make async copy of input tensor to CPU tensor and record completion event.
   auto device = GetDeviceID(tensor);
-  auto cpu_buffer =
-      tensor.to(::torch::Device(::torch::kCPU), /*non_blocking=*/true);
-  auto hvd_cpu_buffer = std::make_shared<TorchTensor>(cpu_buffer);
   common::ReadyEventList ready_event_list;
-#if HAVE_GPU
-  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
-#endif
+  auto cpu_buffers = StageToHost({tensor}, device, ready_event_list);
+  auto hvd_cpu_buffer = std::make_shared<TorchTensor>(cpu_buffers[0]);
 
   auto hvd_context =
-      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_buffer);
+      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_buffers[0]);
 
   ReduceOp reduce_op = static_cast<ReduceOp>(reduce_op_int);
   auto handle = handle_manager.AllocateHandle();
   auto enqueue_result = EnqueueTensorAllreduce(
       hvd_context, hvd_cpu_buffer, hvd_cpu_buffer, ready_event_list,
       GetOpName("allreduce", name, handle), CPU_DEVICE_ID,
-      [handle, divisor, cpu_buffer, output,
+      [handle, divisor, cpu_buffers, output,
        device](const Status& status) mutable {
-        // Since the operation was on CPU, need to perform copy with the GPU
-        // device guard.
-        with_device device_guard(device);
-        output.copy_(cpu_buffer);
+        UnstageFromHost(cpu_buffers, {output}, device, divisor);
+        handle_manager.MarkDone(handle, status);
+      }, reduce_op, prescale_factor, postscale_factor, 0, priority);
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoBucketedAllreduce(::torch::Tensor tensor, ::torch::Tensor output,
+                        int divisor, const std::string& name,
+                        int reduce_op_int, double prescale_factor,
+                        double postscale_factor, int priority) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = GetDeviceID(tensor);
+#if !HOROVOD_GPU_ALLREDUCE
+  if (device != CPU_DEVICE_ID) {
+    // Staged through host memory one by one instead.
+    return DoAllreduceCudaOnCPU(tensor, output, divisor, name, reduce_op_int,
+                                prescale_factor, postscale_factor, priority);
+  }
+#endif
+  auto handle = handle_manager.AllocateHandle();
+  common::ReadyEventList ready_event_list;
+#if HAVE_GPU
+  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+#endif
+  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
+  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
+  auto hvd_output = std::make_shared<TorchTensor>(output);
+
+  ReduceOp reduce_op = static_cast<ReduceOp>(reduce_op_int);
+
+  auto enqueue_result = EnqueueTensorBucketedAllreduce(
+      hvd_context, hvd_tensor, hvd_output, ready_event_list,
+      GetOpName("allreduce", name, handle), device,
+      [handle, divisor, output, device](const Status& status) mutable {
+#if HAVE_GPU
+        auto hvd_event = status.event;
+        if (hvd_event.event) {
+          auto stream = GetGPUStream(device);
+          HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
+        }
+#endif
+        // Will execute in the `device` context.
         if (divisor > 1) {
           DivideInPlace(output, divisor);
         }
         handle_manager.MarkDone(handle, status);
-      }, reduce_op, prescale_factor, postscale_factor);
+      }, reduce_op, prescale_factor, postscale_factor, priority);
   ThrowIfError(enqueue_result);
 
   return handle;
 }
 
+void DoSkipBucketedAllreduce(const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+  ThrowIfError(SkipBucketedAllreduce(GetOpName("allreduce", name, 0)));
+}
+
+void DoRegisterAllreduceBuckets(const std::vector<std::string>& names,
+                                const std::vector<int64_t>& sizes,
+                                int64_t bucket_bytes) {
+  std::vector<std::string> op_names;
+  for (auto& name : names) {
+    op_names.push_back(GetOpName("allreduce", name, 0));
+  }
+  RegisterAllreduceBuckets(op_names, sizes, bucket_bytes);
+}
+
 int DoGroupedAllreduce(const std::vector<::torch::Tensor>& tensors,
                        const std::vector<::torch::Tensor>& outputs, int divisor,
                        const std::string& name, int reduce_op_int,
-                       double prescale_factor, double postscale_factor) {
+                       double prescale_factor, double postscale_factor,
+                       int priority) {
   ThrowIfError(common::CheckInitialized());
 
   auto handle = handle_manager.AllocateHandle();
@@ -234,7 +459,8 @@ int DoGroupedAllreduce(const std::vector<::torch::Tensor>& tensors,
 
   auto enqueue_result = EnqueueTensorAllreduces(
       hvd_contexts, hvd_tensors, hvd_outputs, ready_event_lists,
-      names, device, callbacks, reduce_op, prescale_factor, postscale_factor);
+      names, device, callbacks, reduce_op, prescale_factor, postscale_factor,
+      0, priority);
   ThrowIfError(enqueue_result);
 
   return handle;
@@ -243,13 +469,769 @@ int DoGroupedAllreduce(const std::vector<::torch::Tensor>& tensors,
 int DoGroupedAllreduceCudaOnCPU(const std::vector<::torch::Tensor>& tensors,
                        const std::vector<::torch::Tensor>& outputs, int divisor,
                        const std::string& name, int reduce_op_int,
-                       double prescale_factor, double postscale_factor) {
+                       double prescale_factor, double postscale_factor,
+                       int priority) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto handle = handle_manager.AllocateHandle();
+  auto device = GetDeviceID(tensors[0]);
+
+  std::vector<std::shared_ptr<Tensor>> cpu_buffers;
+  std::vector<std::shared_ptr<OpContext>> hvd_contexts;
+  std::vector<common::ReadyEventList> ready_event_lists;
+  std::vector<StatusCallback> callbacks;
+  std::vector<std::string> names;
+
+  auto num_tensors = tensors.size();
+  cpu_buffers.reserve(num_tensors);
+  hvd_contexts.reserve(num_tensors);
+  ready_event_lists.reserve(num_tensors);
+  names.reserve(num_tensors);
+  callbacks.reserve(num_tensors);
+
+  auto base_name = GetOpName("grouped_allreduce", name, handle);
+
+  for (int i = 0; i < num_tensors; ++i) {
+    if (GetDeviceID(tensors[i]) != device) {
+      throw std::logic_error("Tensors in list must be on same device.");
+    }
+  }
+  // All tensors are staged in one host buffer and copied back together.
+  common::ReadyEventList ready_event_list;
+  auto cpu_tensors = StageToHost(tensors, device, ready_event_list);
+
+  auto callback_mutex = std::make_shared<std::mutex>();
+  auto callback_count = std::make_shared<int>(0);
+  for (int i = 0; i < num_tensors; ++i) {
+    cpu_buffers.emplace_back(std::make_shared<TorchTensor>(cpu_tensors[i]));
+    hvd_contexts.emplace_back(std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_tensors[i]));
+    ready_event_lists.emplace_back(ready_event_list);
+    names.emplace_back(base_name + "_" + std::to_string(i+1) + "of" + std::to_string(num_tensors));
+    callbacks.emplace_back(
+      [handle, divisor, cpu_tensors, outputs, device, callback_mutex,
+       callback_count, num_tensors](const Status& status) mutable {
+        // Must only copy back and call MarkDone on last tensor.
+        std::lock_guard<std::mutex> guard(*callback_mutex);
+        (*callback_count)++;
+        if (*callback_count == num_tensors) {
+          UnstageFromHost(cpu_tensors, outputs, device, divisor);
+          handle_manager.MarkDone(handle, status);
+        }
+      }
+    );
+  }
+
+  ReduceOp reduce_op = static_cast<ReduceOp>(reduce_op_int);
+
+  auto enqueue_result = EnqueueTensorAllreduces(
+      hvd_contexts, cpu_buffers, cpu_buffers, ready_event_lists,
+      names, device, callbacks, reduce_op, prescale_factor, postscale_factor,
+      0, priority);
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoAllgather(::torch::Tensor tensor, ::torch::Tensor output,
+                const std::string& name, bool preallocated) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = GetDeviceID(tensor);
+  common::ReadyEventList ready_event_list;
+#if HAVE_GPU
+  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+#endif
+  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
+  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
+  // Gathered into as it is, rather than resized by the context.
+  std::shared_ptr<Tensor> hvd_output =
+      preallocated ? std::make_shared<TorchTensor>(output) : nullptr;
+
+  auto handle = handle_manager.AllocateHandle();
+  auto enqueue_result =
+      EnqueueTensorAllgather(hvd_context, hvd_tensor, ready_event_list,
+                             GetOpName("allgather", name, handle), device,
+                             [handle, device](const Status& status) {
+#if HAVE_GPU
+                               auto hvd_event = status.event;
+                               if (hvd_event.event) {
+                                 auto stream = GetGPUStream(device);
+                                 HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
+                               }
+#endif
+                               handle_manager.MarkDone(handle, status);
+                             },
+                             0, std::move(hvd_output));
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+// Gathers on the host and copies into output, preallocated or not.
+int DoAllgatherCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output,
+                         const std::string& name, bool preallocated) {
+  ThrowIfError(common::CheckInitialized());
+
+  // Make async copy of input tensor to CPU tensor and record completion event.
+  auto device = GetDeviceID(tensor);
+  common::ReadyEventList ready_event_list;
+  auto cpu_tensor = StageToHost({tensor}, device, ready_event_list)[0];
+  auto hvd_cpu_tensor = std::make_shared<TorchTensor>(cpu_tensor);
+
+  auto cpu_output = ::torch::empty_like(cpu_tensor);
+  auto hvd_cpu_output = std::make_shared<TorchTensor>(cpu_output);
+  auto hvd_context =
+      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_output);
+
+  auto handle = handle_manager.AllocateHandle();
+  auto enqueue_result = EnqueueTensorAllgather(
+      hvd_context, hvd_cpu_tensor, ready_event_list,
+      GetOpName("allgather", name, handle), CPU_DEVICE_ID,
+      [handle, cpu_output, output, device](const Status& status) mutable {
+        // Since the operation was on CPU, need to perform copy with the GPU
+        // device guard.
+        with_device device_guard(device);
+        // output needs to be resized before copying in the CPU tensor.
+        output.resize_(cpu_output.sizes());
+        output.copy_(cpu_output);
+        handle_manager.MarkDone(handle, status);
+      });
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoGroupedAllgather(const std::vector<::torch::Tensor>& tensors,
+                       const std::vector<::torch::Tensor>& outputs,
+                       const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto handle = handle_manager.AllocateHandle();
+  auto device = GetDeviceID(tensors[0]);
+  common::ReadyEventList ready_event_list;
+#if HAVE_GPU
+  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+#endif
+
+  std::vector<std::shared_ptr<Tensor>> hvd_tensors;
+  std::vector<std::shared_ptr<OpContext>> hvd_contexts;
+  std::vector<common::ReadyEventList> ready_event_lists;
+  std::vector<StatusCallback> callbacks;
+  std::vector<std::string> names;
+
+  auto num_tensors = tensors.size();
+  hvd_tensors.reserve(num_tensors);
+  hvd_contexts.reserve(num_tensors);
+  ready_event_lists.reserve(num_tensors);
+  names.reserve(num_tensors);
+  callbacks.reserve(num_tensors);
+
+  auto base_name = GetOpName("grouped_allgather", name, handle);
+
+  auto callback_mutex = std::make_shared<std::mutex>();
+  auto callback_count = std::make_shared<int>(0);
+  for (int i = 0; i < num_tensors; ++i) {
+    if (GetDeviceID(tensors[i]) != device) {
+      throw std::logic_error("Tensors in list must be on same device.");
+    }
+    hvd_tensors.emplace_back(std::make_shared<TorchTensor>(tensors[i]));
+    hvd_contexts.emplace_back(
+        std::make_shared<TorchOpContext>(device, outputs[i]));
+    ready_event_lists.emplace_back(ready_event_list); // Same for all tensors in group
+    names.emplace_back(base_name + "_" + std::to_string(i+1) + "of" + std::to_string(num_tensors));
+    callbacks.emplace_back(
+      [handle, callback_mutex, callback_count, num_tensors,
+       device](const Status& status) mutable {
+#if HAVE_GPU
+        auto hvd_event = status.event;
+        if (hvd_event.event) {
+          auto stream = GetGPUStream(device);
+          HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
+        }
+#endif
+        // Must only call MarkDone on last tensor.
+        std::lock_guard<std::mutex> guard(*callback_mutex);
+        (*callback_count)++;
+        if (*callback_count == num_tensors) {
+          handle_manager.MarkDone(handle, status);
+        }
+      }
+    );
+  }
+
+  auto enqueue_result = EnqueueTensorAllgathers(
+      hvd_contexts, hvd_tensors, ready_event_lists, names, device, callbacks);
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoGroupedAllgatherCudaOnCPU(const std::vector<::torch::Tensor>& tensors,
+                                const std::vector<::torch::Tensor>& outputs,
+                                const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto handle = handle_manager.AllocateHandle();
+  auto device = GetDeviceID(tensors[0]);
+
+  std::vector<std::shared_ptr<Tensor>> cpu_buffers;
+  std::vector<std::shared_ptr<OpContext>> hvd_contexts;
+  std::vector<common::ReadyEventList> ready_event_lists;
+  std::vector<StatusCallback> callbacks;
+  std::vector<std::string> names;
+
+  auto num_tensors = tensors.size();
+  cpu_buffers.reserve(num_tensors);
+  hvd_contexts.reserve(num_tensors);
+  ready_event_lists.reserve(num_tensors);
+  names.reserve(num_tensors);
+  callbacks.reserve(num_tensors);
+
+  auto base_name = GetOpName("grouped_allgather", name, handle);
+
+  auto callback_mutex = std::make_shared<std::mutex>();
+  auto callback_count = std::make_shared<int>(0);
+  for (int i = 0; i < num_tensors; ++i) {
+    if (GetDeviceID(tensors[i]) != device) {
+      throw std::logic_error("Tensors in list must be on same device.");
+    }
+    // Make async copy of input tensor to CPU tensor and record completion event.
+    common::ReadyEventList ready_event_list;
+    auto cpu_tensor = StageToHost({tensors[i]}, device, ready_event_list)[0];
+    cpu_buffers.emplace_back(std::make_shared<TorchTensor>(cpu_tensor));
+    ready_event_lists.emplace_back(ready_event_list);
+
+    auto cpu_output = ::torch::empty_like(cpu_tensor);
+    hvd_contexts.emplace_back(
+        std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_output));
+
+    names.emplace_back(base_name + "_" + std::to_string(i+1) + "of" + std::to_string(num_tensors));
+    auto output = outputs[i];
+    callbacks.emplace_back(
+      [handle, cpu_output, output, device, callback_mutex, callback_count,
+       num_tensors](const Status& status) mutable {
+        { // Since the operation was on CPU, need to perform copy with the GPU
+          // device guard.
+          with_device device_guard(device);
+          // output needs to be resized before copying in the CPU tensor.
+          output.resize_(cpu_output.sizes());
+          output.copy_(cpu_output);
+        }
+        // Must only call MarkDone on last tensor.
+        std::lock_guard<std::mutex> guard(*callback_mutex);
+        (*callback_count)++;
+        if (*callback_count == num_tensors) {
+          handle_manager.MarkDone(handle, status);
+        }
+      });
+  }
+
+  auto enqueue_result = EnqueueTensorAllgathers(
+      hvd_contexts, cpu_buffers, ready_event_lists, names, CPU_DEVICE_ID,
+      callbacks);
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoReducescatter(::torch::Tensor tensor, ::torch::Tensor output,
+                    const std::string& name, int reduce_op_int) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = GetDeviceID(tensor);
+  common::ReadyEventList ready_event_list;
+#if HAVE_GPU
+  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+#endif
+  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
+  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
+  ReduceOp reduce_op = static_cast<ReduceOp>(reduce_op_int);
+
+  auto handle = handle_manager.AllocateHandle();
+  auto enqueue_result = EnqueueTensorReducescatter(
+      hvd_context, hvd_tensor, ready_event_list,
+      GetOpName("reducescatter", name, handle), device,
+      [handle, device](const Status& status) {
+#if HAVE_GPU
+        auto hvd_event = status.event;
+        if (hvd_event.event) {
+          auto stream = GetGPUStream(device);
+          HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
+        }
+#endif
+        handle_manager.MarkDone(handle, status);
+      },
+      reduce_op);
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoReducescatterCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output,
+                             const std::string& name, int reduce_op_int) {
+  ThrowIfError(common::CheckInitialized());
+
+  // Make async copy of input tensor to CPU tensor and record completion event.
+  auto device = GetDeviceID(tensor);
+  common::ReadyEventList ready_event_list;
+  auto cpu_tensor = StageToHost({tensor}, device, ready_event_list)[0];
+  auto hvd_cpu_tensor = std::make_shared<TorchTensor>(cpu_tensor);
+
+  auto cpu_output = ::torch::empty_like(cpu_tensor);
+  auto hvd_context =
+      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_output);
+  ReduceOp reduce_op = static_cast<ReduceOp>(reduce_op_int);
+
+  auto handle = handle_manager.AllocateHandle();
+  auto enqueue_result = EnqueueTensorReducescatter(
+      hvd_context, hvd_cpu_tensor, ready_event_list,
+      GetOpName("reducescatter", name, handle), CPU_DEVICE_ID,
+      [handle, cpu_output, output, device](const Status& status) mutable {
+        // Since the operation was on CPU, need to perform copy with the GPU
+        // device guard.
+        with_device device_guard(device);
+        // output needs to be resized before copying in the CPU tensor.
+        output.resize_(cpu_output.sizes());
+        output.copy_(cpu_output);
+        handle_manager.MarkDone(handle, status);
+      },
+      reduce_op);
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoBroadcast(::torch::Tensor tensor, ::torch::Tensor output, int root_rank,
+                const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = GetDeviceID(tensor);
+  common::ReadyEventList ready_event_list;
+#if HAVE_GPU
+  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+#endif
+  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
+  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
+  std::shared_ptr<Tensor> hvd_output = nullptr;
+  if (horovod_rank() == root_rank) {
+    if (tensor.data_ptr() != output.data_ptr()) {
+      with_device device_guard(device);
+      output.copy_(tensor);
+    }
+  } else {
+    hvd_output = std::make_shared<TorchTensor>(output);
+  }
+
+  auto handle = handle_manager.AllocateHandle();
+  auto enqueue_result =
+      EnqueueTensorBroadcast(hvd_context, hvd_tensor, hvd_output, root_rank,
+                             ready_event_list, GetOpName("broadcast", name, handle),
+                             device, [handle, device](const Status& status) {
+#if HAVE_GPU
+                               auto hvd_event = status.event;
+                               if (hvd_event.event) {
+                                 auto stream = GetGPUStream(device);
+                                 HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
+                               }
+#endif
+                               handle_manager.MarkDone(handle, status);
+                             });
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoBroadcastCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output, int root_rank,
+                         const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  // Make async copy of input tensor to CPU tensor and record completion event.
+  auto device = GetDeviceID(tensor);
+  common::ReadyEventList ready_event_list;
+  auto cpu_buffers = StageToHost({tensor}, device, ready_event_list);
+  auto hvd_cpu_buffer = std::make_shared<TorchTensor>(cpu_buffers[0]);
+
+  auto hvd_context =
+      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_buffers[0]);
+
+  auto handle = handle_manager.AllocateHandle();
+  auto enqueue_result = EnqueueTensorBroadcast(
+      hvd_context, hvd_cpu_buffer, hvd_cpu_buffer, root_rank, ready_event_list,
+      GetOpName("broadcast", name, handle), CPU_DEVICE_ID,
+      [handle, cpu_buffers, output, device](const Status& status) mutable {
+        UnstageFromHost(cpu_buffers, {output}, device, 1);
+        handle_manager.MarkDone(handle, status);
+      });
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoGroupedBroadcast(const std::vector<::torch::Tensor>& tensors,
+                       const std::vector<::torch::Tensor>& outputs,
+                       int root_rank, const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto handle = handle_manager.AllocateHandle();
+  auto device = GetDeviceID(tensors[0]);
+  common::ReadyEventList ready_event_list;
+#if HAVE_GPU
+  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+#endif
+
+  std::vector<std::shared_ptr<Tensor>> hvd_tensors;
+  std::vector<std::shared_ptr<Tensor>> hvd_outputs;
+  std::vector<std::shared_ptr<OpContext>> hvd_contexts;
+  std::vector<common::ReadyEventList> ready_event_lists;
+  std::vector<StatusCallback> callbacks;
+  std::vector<std::string> names;
+
+  auto num_tensors = tensors.size();
+  hvd_tensors.reserve(num_tensors);
+  hvd_outputs.reserve(num_tensors);
+  hvd_contexts.reserve(num_tensors);
+  ready_event_lists.reserve(num_tensors);
+  names.reserve(num_tensors);
+  callbacks.reserve(num_tensors);
+
+  auto base_name = GetOpName("grouped_broadcast", name, handle);
+  bool is_root = horovod_rank() == root_rank;
+
+  auto callback_mutex = std::make_shared<std::mutex>();
+  auto callback_count = std::make_shared<int>(0);
+  for (int i = 0; i < num_tensors; ++i) {
+    if (GetDeviceID(tensors[i]) != device) {
+      throw std::logic_error("Tensors in list must be on same device.");
+    }
+    hvd_tensors.emplace_back(std::make_shared<TorchTensor>(tensors[i]));
+    hvd_contexts.emplace_back(
+        std::make_shared<TorchOpContext>(device, outputs[i]));
+    if (is_root) {
+      if (tensors[i].data_ptr() != outputs[i].data_ptr()) {
+        with_device device_guard(device);
+        outputs[i].copy_(tensors[i]);
+      }
+      hvd_outputs.emplace_back(nullptr);
+    } else {
+      hvd_outputs.emplace_back(std::make_shared<TorchTensor>(outputs[i]));
+    }
+
+    ready_event_lists.emplace_back(ready_event_list); // Same for all tensors in group
+    names.emplace_back(base_name + "_" + std::to_string(i+1) + "of" + std::to_string(num_tensors));
+    callbacks.emplace_back(
+      [handle, callback_mutex, callback_count, num_tensors,
+       device](const Status& status) mutable {
+#if HAVE_GPU
+        auto hvd_event = status.event;
+        if (hvd_event.event) {
+          auto stream = GetGPUStream(device);
+          HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
+        }
+#endif
+        // Must only call MarkDone on last tensor.
+        std::lock_guard<std::mutex> guard(*callback_mutex);
+        (*callback_count)++;
+        if (*callback_count == num_tensors) {
+          handle_manager.MarkDone(handle, status);
+        }
+      }
+    );
+  }
+
+  auto enqueue_result = EnqueueTensorBroadcasts(
+      hvd_contexts, hvd_tensors, hvd_outputs, root_rank, ready_event_lists,
+      names, device, callbacks);
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoGroupedBroadcastCudaOnCPU(const std::vector<::torch::Tensor>& tensors,
+                                const std::vector<::torch::Tensor>& outputs,
+                                int root_rank, const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto handle = handle_manager.AllocateHandle();
+  auto device = GetDeviceID(tensors[0]);
+
+  std::vector<std::shared_ptr<Tensor>> cpu_buffers;
+  std::vector<std::shared_ptr<OpContext>> hvd_contexts;
+  std::vector<common::ReadyEventList> ready_event_lists;
+  std::vector<StatusCallback> callbacks;
+  std::vector<std::string> names;
+
+  auto num_tensors = tensors.size();
+  cpu_buffers.reserve(num_tensors);
+  hvd_contexts.reserve(num_tensors);
+  ready_event_lists.reserve(num_tensors);
+  names.reserve(num_tensors);
+  callbacks.reserve(num_tensors);
+
+  auto base_name = GetOpName("grouped_broadcast", name, handle);
+
+  for (int i = 0; i < num_tensors; ++i) {
+    if (GetDeviceID(tensors[i]) != device) {
+      throw std::logic_error("Tensors in list must be on same device.");
+    }
+  }
+  // All tensors are staged in one host buffer and copied back together.
+  common::ReadyEventList ready_event_list;
+  auto cpu_tensors = StageToHost(tensors, device, ready_event_list);
+
+  auto callback_mutex = std::make_shared<std::mutex>();
+  auto callback_count = std::make_shared<int>(0);
+  for (int i = 0; i < num_tensors; ++i) {
+    cpu_buffers.emplace_back(std::make_shared<TorchTensor>(cpu_tensors[i]));
+    ready_event_lists.emplace_back(ready_event_list);
+
+    hvd_contexts.emplace_back(
+        std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_tensors[i]));
+
+    names.emplace_back(base_name + "_" + std::to_string(i+1) + "of" + std::to_string(num_tensors));
+    callbacks.emplace_back(
+      [handle, cpu_tensors, outputs, device, callback_mutex, callback_count,
+       num_tensors](const Status& status) mutable {
+        // Must only copy back and call MarkDone on last tensor.
+        std::lock_guard<std::mutex> guard(*callback_mutex);
+        (*callback_count)++;
+        if (*callback_count == num_tensors) {
+          UnstageFromHost(cpu_tensors, outputs, device, 1);
+          handle_manager.MarkDone(handle, status);
+        }
+      });
+  }
+
+  // The CPU copies are broadcast in place.
+  std::vector<std::shared_ptr<Tensor>> cpu_outputs(cpu_buffers);
+  auto enqueue_result = EnqueueTensorBroadcasts(
+      hvd_contexts, cpu_buffers, cpu_outputs, root_rank, ready_event_lists,
+      names, CPU_DEVICE_ID, callbacks);
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+// recv_splits is empty unless the caller knows what it receives.
+std::shared_ptr<Tensor> RecvSplits(::torch::Tensor recv_splits) {
+  if (recv_splits.numel() == 0) {
+    return nullptr;
+  }
+  return std::make_shared<TorchTensor>(
+      recv_splits.to(::torch::Device(::torch::kCPU), /*non_blocking=*/false));
+}
+
+int DoAlltoall(::torch::Tensor tensor, ::torch::Tensor splits,
+               ::torch::Tensor recv_splits, ::torch::Tensor output,
+               ::torch::Tensor output_received_splits,
+               const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto device = GetDeviceID(tensor);
+  common::ReadyEventList ready_event_list;
+#if HAVE_GPU
+  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+#endif
+  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
+
+  // Make sync copy of splits tensor to CPU if needed
+  auto cpu_splits = (GetDeviceID(splits) != CPU_DEVICE_ID) ?
+      splits.to(::torch::Device(::torch::kCPU), /*non_blocking=*/false) :
+      splits;
+  auto hvd_cpu_splits = std::make_shared<TorchTensor>(cpu_splits);
+
+  // Deal with possibility of output_received_splits being on GPU
+  auto received_splits_device = GetDeviceID(output_received_splits);
+  auto cpu_received_splits = (received_splits_device != CPU_DEVICE_ID)
+                                 ? ::torch::empty_like(cpu_splits)
+                                 : output_received_splits;
+  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
+  hvd_context->AddOutput(CPU_DEVICE_ID, cpu_received_splits);
+
+  auto handle = handle_manager.AllocateHandle();
+  auto enqueue_result = EnqueueTensorAlltoall(
+      hvd_context, hvd_tensor, hvd_cpu_splits, ready_event_list,
+      GetOpName("alltoall", name, handle), device,
+      [handle, cpu_received_splits, output_received_splits,
+       received_splits_device, device](const Status& status) mutable {
+#if HAVE_GPU
+        auto hvd_event = status.event;
+        if (hvd_event.event) {
+          auto stream = GetGPUStream(device);
+          HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
+        }
+#endif
+        if (received_splits_device != CPU_DEVICE_ID) {
+          with_device device_guard(received_splits_device);
+          output_received_splits.resize_(cpu_received_splits.sizes());
+          output_received_splits.copy_(cpu_received_splits);
+        }
+        handle_manager.MarkDone(handle, status); 
+      }, 0, RecvSplits(recv_splits));
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoAlltoallCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor splits,
+                        ::torch::Tensor recv_splits, ::torch::Tensor output,
+                        ::torch::Tensor output_received_splits,
+                        const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  // Make sync copy of splits tensor to CPU if needed
+  auto cpu_splits =
+      (GetDeviceID(splits) != CPU_DEVICE_ID)
+          ? splits.to(::torch::Device(::torch::kCPU), /*non_blocking=*/false)
+          : splits;
+  auto hvd_cpu_splits = std::make_shared<TorchTensor>(cpu_splits);
+
+  // Make async copy of input tensor to CPU tensor and record completion event.
+  auto device = GetDeviceID(tensor);
+  common::ReadyEventList ready_event_list;
+  auto cpu_tensor = StageToHost({tensor}, device, ready_event_list)[0];
+  auto hvd_cpu_tensor = std::make_shared<TorchTensor>(cpu_tensor);
+
+  auto cpu_output = ::torch::empty_like(cpu_tensor);
+  auto hvd_cpu_output = std::make_shared<TorchTensor>(cpu_output);
+
+  // Deal with possibility of output_received_splits being on GPU
+  auto received_splits_device = GetDeviceID(output_received_splits);
+  auto cpu_received_splits = (received_splits_device != CPU_DEVICE_ID)
+                                 ? ::torch::empty_like(cpu_splits)
+                                 : output_received_splits;
+  auto hvd_context =
+      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_output);
+  hvd_context->AddOutput(CPU_DEVICE_ID, cpu_received_splits);
+
+  auto handle = handle_manager.AllocateHandle();
+  auto enqueue_result = EnqueueTensorAlltoall(
+      hvd_context, hvd_cpu_tensor, hvd_cpu_splits, ready_event_list,
+      GetOpName("alltoall", name, handle), CPU_DEVICE_ID,
+      [handle, cpu_output, output, device, cpu_received_splits,
+       output_received_splits,
+       received_splits_device](const Status& status) mutable {
+        { // Since the operation was on CPU, need to perform copy with the GPU
+          // device guard.
+          with_device device_guard(device);
+          // output needs to be resized before copying in the CPU tensor.
+          output.resize_(cpu_output.sizes());
+          output.copy_(cpu_output);
+        }
+        if (received_splits_device != CPU_DEVICE_ID) {
+          with_device device_guard(received_splits_device);
+          output_received_splits.resize_(cpu_received_splits.sizes());
+          output_received_splits.copy_(cpu_received_splits);
+        }
+        handle_manager.MarkDone(handle, status);
+      }, 0, RecvSplits(recv_splits));
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoGroupedAlltoall(const std::vector<::torch::Tensor>& tensors,
+                      const std::vector<::torch::Tensor>& splits,
+                      const std::vector<::torch::Tensor>& outputs,
+                      const std::vector<::torch::Tensor>& output_received_splits,
+                      const std::string& name) {
+  ThrowIfError(common::CheckInitialized());
+
+  auto handle = handle_manager.AllocateHandle();
+  auto device = GetDeviceID(tensors[0]);
+  common::ReadyEventList ready_event_list;
+#if HAVE_GPU
+  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+#endif
+
+  std::vector<std::shared_ptr<Tensor>> hvd_tensors;
+  std::vector<std::shared_ptr<Tensor>> hvd_splits;
+  std::vector<std::shared_ptr<OpContext>> hvd_contexts;
+  std::vector<common::ReadyEventList> ready_event_lists;
+  std::vector<StatusCallback> callbacks;
+  std::vector<std::string> names;
+
+  auto num_tensors = tensors.size();
+  hvd_tensors.reserve(num_tensors);
+  hvd_splits.reserve(num_tensors);
+  hvd_contexts.reserve(num_tensors);
+  ready_event_lists.reserve(num_tensors);
+  names.reserve(num_tensors);
+  callbacks.reserve(num_tensors);
+
+  auto base_name = GetOpName("grouped_alltoall", name, handle);
+
+  auto callback_mutex = std::make_shared<std::mutex>();
+  auto callback_count = std::make_shared<int>(0);
+  for (int i = 0; i < num_tensors; ++i) {
+    if (GetDeviceID(tensors[i]) != device) {
+      throw std::logic_error("Tensors in list must be on same device.");
+    }
+    hvd_tensors.emplace_back(std::make_shared<TorchTensor>(tensors[i]));
+
+    // Make sync copy of splits tensor to CPU if needed
+    auto cpu_splits = (GetDeviceID(splits[i]) != CPU_DEVICE_ID) ?
+        splits[i].to(::torch::Device(::torch::kCPU), /*non_blocking=*/false) :
+        splits[i];
+    hvd_splits.emplace_back(std::make_shared<TorchTensor>(cpu_splits));
+
+    // Deal with possibility of output_received_splits being on GPU
+    auto received_splits = output_received_splits[i];
+    auto received_splits_device = GetDeviceID(received_splits);
+    auto cpu_received_splits = (received_splits_device != CPU_DEVICE_ID)
+                                   ? ::torch::empty_like(cpu_splits)
+                                   : received_splits;
+    auto hvd_context = std::make_shared<TorchOpContext>(device, outputs[i]);
+    hvd_context->AddOutput(CPU_DEVICE_ID, cpu_received_splits);
+    hvd_contexts.emplace_back(std::move(hvd_context));
+
+    ready_event_lists.emplace_back(ready_event_list); // Same for all tensors in group
+    names.emplace_back(base_name + "_" + std::to_string(i+1) + "of" + std::to_string(num_tensors));
+    callbacks.emplace_back(
+      [handle, cpu_received_splits, received_splits, received_splits_device,
+       callback_mutex, callback_count, num_tensors,
+       device](const Status& status) mutable {
+#if HAVE_GPU
+        auto hvd_event = status.event;
+        if (hvd_event.event) {
+          auto stream = GetGPUStream(device);
+          HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
+        }
+#endif
+        if (received_splits_device != CPU_DEVICE_ID) {
+          with_device device_guard(received_splits_device);
+          received_splits.resize_(cpu_received_splits.sizes());
+          received_splits.copy_(cpu_received_splits);
+        }
+        // Must only call MarkDone on last tensor.
+        std::lock_guard<std::mutex> guard(*callback_mutex);
+        (*callback_count)++;
+        if (*callback_count == num_tensors) {
+          handle_manager.MarkDone(handle, status);
+        }
+      }
+    );
+  }
+
+  auto enqueue_result = EnqueueTensorAlltoalls(
+      hvd_contexts, hvd_tensors, hvd_splits, ready_event_lists, names, device,
+      callbacks);
+  ThrowIfError(enqueue_result);
+
+  return handle;
+}
+
+int DoGroupedAlltoallCudaOnCPU(const std::vector<::torch::Tensor>& tensors,
+                               const std::vector<::torch::Tensor>& splits,
+                               const std::vector<::torch::Tensor>& outputs,
+                               const std::vector<::torch::Tensor>& output_received_splits,
+                               const std::string& name) {
   ThrowIfError(common::CheckInitialized());
 
   auto handle = handle_manager.AllocateHandle();
   auto device = GetDeviceID(tensors[0]);
 
   std::vector<std::shared_ptr<Tensor>> cpu_buffers;
+  std::vector<std::shared_ptr<Tensor>> hvd_splits;
   std::vector<std::shared_ptr<OpContext>> hvd_contexts;
   std::vector<common::ReadyEventList> ready_event_lists;
   std::vector<StatusCallback> callbacks;
@@ -257,12 +1239,13 @@ int DoGroupedAllreduceCudaOnCPU(const std::vector<::torch::Tensor>& tensors,
 
   auto num_tensors = tensors.size();
   cpu_buffers.reserve(num_tensors);
+  hvd_splits.reserve(num_tensors);
   hvd_contexts.reserve(num_tensors);
   ready_event_lists.reserve(num_tensors);
   names.reserve(num_tensors);
   callbacks.reserve(num_tensors);
 
-  auto base_name = GetOpName("grouped_allreduce", name, handle);
+  auto base_name = GetOpName("grouped_alltoall", name, handle);
 
   auto callback_mutex = std::make_shared<std::mutex>();
   auto callback_count = std::make_shared<int>(0);
@@ -270,107 +1253,125 @@ int DoGroupedAllreduceCudaOnCPU(const std::vector<::torch::Tensor>& tensors,
     if (GetDeviceID(tensors[i]) != device) {
       throw std::logic_error("Tensors in list must be on same device.");
     }
-    auto cpu_buffer =
-        tensors[i].to(::torch::Device(::torch::kCPU), /*non_blocking=*/true);
-    cpu_buffers.emplace_back(std::make_shared<TorchTensor>(cpu_buffer));
-    hvd_contexts.emplace_back(std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_buffer));
+    // Make sync copy of splits tensor to CPU if needed
+    auto cpu_splits = (GetDeviceID(splits[i]) != CPU_DEVICE_ID) ?
+        splits[i].to(::torch::Device(::torch::kCPU), /*non_blocking=*/false) :
+        splits[i];
+    hvd_splits.emplace_back(std::make_shared<TorchTensor>(cpu_splits));
+
+    // Make async copy of input tensor to CPU tensor and record completion event.
     common::ReadyEventList ready_event_list;
-#if HAVE_GPU
-    ready_event_list.AddReadyEvent(RecordReadyEvent(device));
-#endif
+    auto cpu_tensor = StageToHost({tensors[i]}, device, ready_event_list)[0];
+    cpu_buffers.emplace_back(std::make_shared<TorchTensor>(cpu_tensor));
     ready_event_lists.emplace_back(ready_event_list);
+
+    auto cpu_output = ::torch::empty_like(cpu_tensor);
+    auto received_splits = output_received_splits[i];
+    auto received_splits_device = GetDeviceID(received_splits);
+    auto cpu_received_splits = (received_splits_device != CPU_DEVICE_ID)
+                                   ? ::torch::empty_like(cpu_splits)
+                                   : received_splits;
+    auto hvd_context =
+        std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_output);
+    hvd_context->AddOutput(CPU_DEVICE_ID, cpu_received_splits);
+    hvd_contexts.emplace_back(std::move(hvd_context));
+
     names.emplace_back(base_name + "_" + std::to_string(i+1) + "of" + std::to_string(num_tensors));
     auto output = outputs[i];
     callbacks.emplace_back(
-      [handle, divisor, cpu_buffer, output, device, callback_mutex, callback_count,
-       num_tensors](const Status& status) mutable {
-        // Will execute in the `device` context.
-        if (divisor > 1) {
-          DivideInPlace(output, divisor);
+      [handle, cpu_output, output, device, cpu_received_splits,
+       received_splits, received_splits_device, callback_mutex,
+       callback_count, num_tensors](const Status& status) mutable {
+        { // Since the operation was on CPU, need to perform copy with the GPU
+          // device guard.
+          with_device device_guard(device);
+          // output needs to be resized before copying in the CPU tensor.
+          output.resize_(cpu_output.sizes());
+          output.copy_(cpu_output);
+        }
+        if (received_splits_device != CPU_DEVICE_ID) {
+          with_device device_guard(received_splits_device);
+          received_splits.resize_(cpu_received_splits.sizes());
+          received_splits.copy_(cpu_received_splits);
         }
-        with_device device_guard(device);
-        output.copy_(cpu_buffer);
-
         // Must only call MarkDone on last tensor.
         std::lock_guard<std::mutex> guard(*callback_mutex);
         (*callback_count)++;
         if (*callback_count == num_tensors) {
           handle_manager.MarkDone(handle, status);
         }
-      }
-    );
+      });
   }
 
-  ReduceOp reduce_op = static_cast<ReduceOp>(reduce_op_int);
-
-  auto enqueue_result = EnqueueTensorAllreduces(
-      hvd_contexts, cpu_buffers, cpu_buffers, ready_event_lists,
-      names, device, callbacks, reduce_op, prescale_factor, postscale_factor);
+  auto enqueue_result = EnqueueTensorAlltoalls(
+      hvd_contexts, cpu_buffers, hvd_splits, ready_event_lists, names,
+      CPU_DEVICE_ID, callbacks);
   ThrowIfError(enqueue_result);
 
   return handle;
 }
 
-int DoAllgather(::torch::Tensor tensor, ::torch::Tensor output, const std::string& name) {
+int DoSend(::torch::Tensor tensor, int dst_rank, const std::string& name) {
   ThrowIfError(common::CheckInitialized());
 
   auto device = GetDeviceID(tensor);
+  auto buffer = tensor;
+#if HOROVOD_GPU_BROADCAST != 'M'
+  // Sends and receives go through MPI, which needs to be CUDA-aware to send
+  // from device memory.
+  if (device != CPU_DEVICE_ID) {
+    buffer = tensor.to(::torch::Device(::torch::kCPU), /*non_blocking=*/true);
+  }
+#endif
   common::ReadyEventList ready_event_list;
 #if HAVE_GPU
   ready_event_list.AddReadyEvent(RecordReadyEvent(device));
 #endif
-  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
-  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
+  auto buffer_device = GetDeviceID(buffer);
+  auto hvd_buffer = std::make_shared<TorchTensor>(buffer);
+  auto hvd_context = std::make_shared<TorchOpContext>(buffer_device, buffer);
 
   auto handle = handle_manager.AllocateHandle();
-  auto enqueue_result =
-      EnqueueTensorAllgather(hvd_context, hvd_tensor, ready_event_list,
-                             GetOpName("allgather", name, handle), device,
-                             [handle, device](const Status& status) {
-#if HAVE_GPU
-                               auto hvd_event = status.event;
-                               if (hvd_event.event) {
-                                 auto stream = GetGPUStream(device);
-                                 HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
-                               }
-#endif
-                               handle_manager.MarkDone(handle, status);
-                             });
+  auto enqueue_result = EnqueueTensorSend(
+      hvd_context, hvd_buffer, dst_rank, ready_event_list,
+      GetOpName("send", name, handle), buffer_device,
+      [handle, buffer](const Status& status) {
+        handle_manager.MarkDone(handle, status);
+      });
   ThrowIfError(enqueue_result);
 
   return handle;
 }
 
-int DoAllgatherCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output,
-                         const std::string& name) {
+int DoRecv(::torch::Tensor output, int src_rank, const std::string& name) {
   ThrowIfError(common::CheckInitialized());
 
-  // Make async copy of input tensor to CPU tensor and record completion event.
-  auto device = GetDeviceID(tensor);
-  auto cpu_tensor =
-      tensor.to(::torch::Device(::torch::kCPU), /*non_blocking=*/true);
-  auto hvd_cpu_tensor = std::make_shared<TorchTensor>(cpu_tensor);
+  auto device = GetDeviceID(output);
+  auto buffer = output;
+#if HOROVOD_GPU_BROADCAST != 'M'
+  if (device != CPU_DEVICE_ID) {
+    buffer = ::torch::empty(output.sizes(),
+                            output.options().device(::torch::kCPU));
+  }
+#endif
   common::ReadyEventList ready_event_list;
 #if HAVE_GPU
+  // The output must not be overwritten while the framework still uses it.
   ready_event_list.AddReadyEvent(RecordReadyEvent(device));
 #endif
-
-  auto cpu_output = ::torch::empty_like(cpu_tensor);
-  auto hvd_cpu_output = std::make_shared<TorchTensor>(cpu_output);
-  auto hvd_context =
-      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_output);
+  auto buffer_device = GetDeviceID(buffer);
+  auto hvd_buffer = std::make_shared<TorchTensor>(buffer);
+  auto hvd_context = std::make_shared<TorchOpContext>(buffer_device, buffer);
 
   auto handle = handle_manager.AllocateHandle();
-  auto enqueue_result = EnqueueTensorAllgather(
-      hvd_context, hvd_cpu_tensor, ready_event_list,
-      GetOpName("allgather", name, handle), CPU_DEVICE_ID,
-      [handle, cpu_output, output, device](const Status& status) mutable {
-        // Since the operation was on CPU, need to perform copy with the GPU
-        // device guard.
-        with_device device_guard(device);
-        // output needs to be resized before copying in the CPU tensor.
-        output.resize_(cpu_output.sizes());
-        output.copy_(cpu_output);
+  auto enqueue_result = EnqueueTensorRecv(
+      hvd_context, hvd_buffer, src_rank, ready_event_list,
+      GetOpName("recv", name, handle), buffer_device,
+      [handle, buffer, output, device](const Status& status) mutable {
+        if (buffer.data_ptr() != output.data_ptr()) {
+          with_device device_guard(device);
+          output.copy_(buffer);
+        }
         handle_manager.MarkDone(handle, status);
       });
   ThrowIfError(enqueue_result);
@@ -378,111 +1379,88 @@ int DoAllgatherCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output,
   return handle;
 }
 
-int DoBroadcast(::torch::Tensor tensor, ::torch::Tensor output, int root_rank,
-                const std::string& name) {
+int DoReduce(::torch::Tensor tensor, ::torch::Tensor output, int root_rank,
+             const std::string& name, int reduce_op_int) {
   ThrowIfError(common::CheckInitialized());
 
   auto device = GetDeviceID(tensor);
-  common::ReadyEventList ready_event_list;
-#if HAVE_GPU
-  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
-#endif
-  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
-  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
-  std::shared_ptr<Tensor> hvd_output = nullptr;
-  if (horovod_rank() == root_rank) {
-    if (tensor.data_ptr() != output.data_ptr()) {
-      with_device device_guard(device);
-      output.copy_(tensor);
-    }
-  } else {
-    hvd_output = std::make_shared<TorchTensor>(output);
+  auto buffer = tensor;
+  auto output_buffer = output;
+#if HOROVOD_GPU_ALLREDUCE != 'N'
+  // Only NCCL reduces in device memory.
+  if (device != CPU_DEVICE_ID) {
+    buffer = tensor.to(::torch::Device(::torch::kCPU), /*non_blocking=*/true);
+    output_buffer = ::torch::empty(output.sizes(),
+                                   output.options().device(::torch::kCPU));
   }
-
-  auto handle = handle_manager.AllocateHandle();
-  auto enqueue_result =
-      EnqueueTensorBroadcast(hvd_context, hvd_tensor, hvd_output, root_rank,
-                             ready_event_list, GetOpName("broadcast", name, handle),
-                             device, [handle, device](const Status& status) {
-#if HAVE_GPU
-                               auto hvd_event = status.event;
-                               if (hvd_event.event) {
-                                 auto stream = GetGPUStream(device);
-                                 HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
-                               }
 #endif
-                               handle_manager.MarkDone(handle, status);
-                             });
-  ThrowIfError(enqueue_result);
-
-  return handle;
-}
-
-int DoBroadcastCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor output, int root_rank,
-                         const std::string& name) {
-  ThrowIfError(common::CheckInitialized());
-
-  // Make async copy of input tensor to CPU tensor and record completion event.
-  auto device = GetDeviceID(tensor);
-  auto cpu_buffer =
-      tensor.to(::torch::Device(::torch::kCPU), /*non_blocking=*/true);
-  auto hvd_cpu_buffer = std::make_shared<TorchTensor>(cpu_buffer);
   common::ReadyEventList ready_event_list;
 #if HAVE_GPU
   ready_event_list.AddReadyEvent(RecordReadyEvent(device));
 #endif
-
+  auto buffer_device = GetDeviceID(buffer);
+  auto hvd_buffer = std::make_shared<TorchTensor>(buffer);
   auto hvd_context =
-      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_buffer);
+      std::make_shared<TorchOpContext>(buffer_device, output_buffer);
+  // Only the root receives the result.
+  bool is_root = horovod_rank() == root_rank;
+  std::shared_ptr<Tensor> hvd_output =
+      is_root ? std::make_shared<TorchTensor>(output_buffer) : nullptr;
+  ReduceOp reduce_op = static_cast<ReduceOp>(reduce_op_int);
 
   auto handle = handle_manager.AllocateHandle();
-  auto enqueue_result = EnqueueTensorBroadcast(
-      hvd_context, hvd_cpu_buffer, hvd_cpu_buffer, root_rank, ready_event_list,
-      GetOpName("broadcast", name, handle), CPU_DEVICE_ID,
-      [handle, cpu_buffer, output, device](const Status& status) mutable {
-        // Since the operation was on CPU, need to perform copy with the GPU
-        // device guard.
-        with_device device_guard(device);
-        output.copy_(cpu_buffer);
+  auto enqueue_result = EnqueueTensorReduce(
+      hvd_context, hvd_buffer, hvd_output, root_rank, ready_event_list,
+      GetOpName("reduce", name, handle), buffer_device,
+      [handle, is_root, output_buffer, output,
+       device](const Status& status) mutable {
+#if HAVE_GPU
+        auto hvd_event = status.event;
+        if (hvd_event.event) {
+          auto stream = GetGPUStream(device);
+          HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
+        }
+#endif
+        if (is_root && output_buffer.data_ptr() != output.data_ptr()) {
+          with_device device_guard(device);
+          output.copy_(output_buffer);
+        }
         handle_manager.MarkDone(handle, status);
-      });
+      },
+      reduce_op);
   ThrowIfError(enqueue_result);
 
   return handle;
 }
 
-int DoAlltoall(::torch::Tensor tensor, ::torch::Tensor splits,
-               ::torch::Tensor output, ::torch::Tensor output_received_splits,
-               const std::string& name) {
+int DoGather(::torch::Tensor tensor, ::torch::Tensor output, int root_rank,
+             const std::string& name) {
   ThrowIfError(common::CheckInitialized());
 
   auto device = GetDeviceID(tensor);
+  auto buffer = tensor;
+  auto output_buffer = output;
+#if HOROVOD_GPU_ALLGATHER != 'N'
+  // Only NCCL gathers in device memory.
+  if (device != CPU_DEVICE_ID) {
+    buffer = tensor.to(::torch::Device(::torch::kCPU), /*non_blocking=*/true);
+    output_buffer = ::torch::empty({0}, output.options().device(::torch::kCPU));
+  }
+#endif
   common::ReadyEventList ready_event_list;
 #if HAVE_GPU
   ready_event_list.AddReadyEvent(RecordReadyEvent(device));
 #endif
-  auto hvd_tensor = std::make_shared<TorchTensor>(tensor);
-
-  // Make sync copy of splits tensor to CPU if needed
-  auto cpu_splits = (GetDeviceID(splits) != CPU_DEVICE_ID) ?
-      splits.to(::torch::Device(::torch::kCPU), /*non_blocking=*/false) :
-      splits;
-  auto hvd_cpu_splits = std::make_shared<TorchTensor>(cpu_splits);
-
-  // Deal with possibility of output_received_splits being on GPU
-  auto received_splits_device = GetDeviceID(output_received_splits);
-  auto cpu_received_splits = (received_splits_device != CPU_DEVICE_ID)
-                                 ? ::torch::empty_like(cpu_splits)
-                                 : output_received_splits;
-  auto hvd_context = std::make_shared<TorchOpContext>(device, output);
-  hvd_context->AddOutput(CPU_DEVICE_ID, cpu_received_splits);
+  auto buffer_device = GetDeviceID(buffer);
+  auto hvd_buffer = std::make_shared<TorchTensor>(buffer);
+  auto hvd_context =
+      std::make_shared<TorchOpContext>(buffer_device, output_buffer);
 
   auto handle = handle_manager.AllocateHandle();
-  auto enqueue_result = EnqueueTensorAlltoall(
-      hvd_context, hvd_tensor, hvd_cpu_splits, ready_event_list,
-      GetOpName("alltoall", name, handle), device,
-      [handle, cpu_received_splits, output_received_splits,
-       received_splits_device, device](const Status& status) mutable {
+  auto enqueue_result = EnqueueTensorGather(
+      hvd_context, hvd_buffer, root_rank, ready_event_list,
+      GetOpName("gather", name, handle), buffer_device,
+      [handle, output_buffer, output, device](const Status& status) mutable {
 #if HAVE_GPU
         auto hvd_event = status.event;
         if (hvd_event.event) {
@@ -490,88 +1468,76 @@ int DoAlltoall(::torch::Tensor tensor, ::torch::Tensor splits,
           HVD_GPU_CHECK(gpuStreamWaitEvent(stream, *(hvd_event.event), 0));
         }
 #endif
-        if (received_splits_device != CPU_DEVICE_ID) {
-          with_device device_guard(received_splits_device);
-          output_received_splits.resize_(cpu_received_splits.sizes());
-          output_received_splits.copy_(cpu_received_splits);
+        if (output_buffer.data_ptr() != output.data_ptr()) {
+          with_device device_guard(device);
+          // output needs to be resized before copying in the CPU tensor.
+          output.resize_(output_buffer.sizes());
+          output.copy_(output_buffer);
         }
-        handle_manager.MarkDone(handle, status); 
+        handle_manager.MarkDone(handle, status);
       });
   ThrowIfError(enqueue_result);
 
   return handle;
 }
 
-int DoAlltoallCudaOnCPU(::torch::Tensor tensor, ::torch::Tensor splits,
-                        ::torch::Tensor output,
-                        ::torch::Tensor output_received_splits,
-                        const std::string& name) {
+::torch::Tensor DoCapturableAllreduceId(bool generate) {
+  auto id = ::torch::zeros({common::CapturableAllreduceIdSize()},
+                           ::torch::kUInt8);
+  if (generate) {
+    ThrowIfError(common::CapturableAllreduceId(id.data_ptr()));
+  }
+  return id;
+}
+
+void DoInitCapturableAllreduce(::torch::Tensor id, int device,
+                               int process_set_id) {
   ThrowIfError(common::CheckInitialized());
+  auto contiguous_id = id.contiguous();
+  ThrowIfError(common::InitCapturableAllreduce(contiguous_id.data_ptr(),
+                                               device, process_set_id));
+}
 
-  // Make sync copy of splits tensor to CPU if needed
-  auto cpu_splits =
-      (GetDeviceID(splits) != CPU_DEVICE_ID)
-          ? splits.to(::torch::Device(::torch::kCPU), /*non_blocking=*/false)
-          : splits;
-  auto hvd_cpu_splits = std::make_shared<TorchTensor>(cpu_splits);
+void DoCapturableAllreduce(const std::vector<::torch::Tensor>& tensors,
+                           const std::vector<::torch::Tensor>& outputs,
+                           int reduce_op_int, double prescale_factor,
+                           double postscale_factor, int process_set_id) {
+  ThrowIfError(common::CheckInitialized());
+  if (tensors.empty()) {
+    return;
+  }
+  auto device = GetDeviceID(tensors[0]);
+  std::vector<std::shared_ptr<common::Tensor>> hvd_tensors;
+  std::vector<std::shared_ptr<common::Tensor>> hvd_outputs;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    if (GetDeviceID(tensors[i]) != device || device == CPU_DEVICE_ID) {
+      throw std::logic_error(
+          "Capturable allreduces take CUDA tensors of a single device.");
+    }
+    hvd_tensors.push_back(std::make_shared<TorchTensor>(tensors[i]));
+    hvd_outputs.push_back(std::make_shared<TorchTensor>(outputs[i]));
+  }
 
-  // Make async copy of input tensor to CPU tensor and record completion event.
-  auto device = GetDeviceID(tensor);
-  auto cpu_tensor =
-      tensor.to(::torch::Device(::torch::kCPU), /*non_blocking=*/true);
-  auto hvd_cpu_tensor = std::make_shared<TorchTensor>(cpu_tensor);
-  common::ReadyEventList ready_event_list;
+  void* stream = nullptr;
 #if HAVE_GPU
-  ready_event_list.AddReadyEvent(RecordReadyEvent(device));
+  with_device device_guard(device);
+  stream = GetGPUStream(device);
 #endif
-
-  auto cpu_output = ::torch::empty_like(cpu_tensor);
-  auto hvd_cpu_output = std::make_shared<TorchTensor>(cpu_output);
-
-  // Deal with possibility of output_received_splits being on GPU
-  auto received_splits_device = GetDeviceID(output_received_splits);
-  auto cpu_received_splits = (received_splits_device != CPU_DEVICE_ID)
-                                 ? ::torch::empty_like(cpu_splits)
-                                 : output_received_splits;
-  auto hvd_context =
-      std::make_shared<TorchOpContext>(CPU_DEVICE_ID, cpu_output);
-  hvd_context->AddOutput(CPU_DEVICE_ID, cpu_received_splits);
-
-  auto handle = handle_manager.AllocateHandle();
-  auto enqueue_result = EnqueueTensorAlltoall(
-      hvd_context, hvd_cpu_tensor, hvd_cpu_splits, ready_event_list,
-      GetOpName("alltoall", name, handle), CPU_DEVICE_ID,
-      [handle, cpu_output, output, device, cpu_received_splits,
-       output_received_splits,
-       received_splits_device](const Status& status) mutable {
-        { // Since the operation was on CPU, need to perform copy with the GPU
-          // device guard.
-          with_device device_guard(device);
-          // output needs to be resized before copying in the CPU tensor.
-          output.resize_(cpu_output.sizes());
-          output.copy_(cpu_output);
-        }
-        if (received_splits_device != CPU_DEVICE_ID) {
-          with_device device_guard(received_splits_device);
-          output_received_splits.resize_(cpu_received_splits.sizes());
-          output_received_splits.copy_(cpu_received_splits);
-        }
-        handle_manager.MarkDone(handle, status);
-      });
-  ThrowIfError(enqueue_result);
-
-  return handle;
+  ThrowIfError(common::CapturableAllreduce(
+      hvd_tensors, hvd_outputs, static_cast<ReduceOp>(reduce_op_int),
+      prescale_factor, postscale_factor, device, stream, process_set_id));
 }
 
 int PollHandle(int handle) { return handle_manager.PollHandle(handle) ? 1 : 0; }
 
 void WaitAndClear(int handle) {
-  while (true) {
-    if (handle_manager.PollHandle(handle)) break;
-    std::this_thread::yield();
-  }
+  handle_manager.WaitForHandle(handle);
   auto status = handle_manager.ReleaseHandle(handle);
-  ThrowIfError(*status);
+  ThrowIfError(status);
+}
+
+void WaitAll(const std::vector<int>& handles) {
+  handle_manager.WaitForHandles(handles);
 }
 
 int DoJoin(int device) {
@@ -618,14 +1584,21 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
   m.def("horovod_torch_allreduce_async_torch_IntTensor", &DoAllreduce);
   m.def("horovod_torch_allreduce_async_torch_LongTensor", &DoAllreduce);
   m.def("horovod_torch_allreduce_async_torch_HalfTensor", &DoAllreduce);
+  m.def("horovod_torch_allreduce_async_torch_BFloat16Tensor", &DoAllreduce);
   m.def("horovod_torch_allreduce_async_torch_FloatTensor", &DoAllreduce);
   m.def("horovod_torch_allreduce_async_torch_DoubleTensor", &DoAllreduce);
 #if HOROVOD_GPU_ALLREDUCE
   m.def("horovod_torch_allreduce_async_torch_cuda_IntTensor", &DoAllreduce);
   m.def("horovod_torch_allreduce_async_torch_cuda_LongTensor", &DoAllreduce);
   m.def("horovod_torch_allreduce_async_torch_cuda_HalfTensor", &DoAllreduce);
+  m.def("horovod_torch_allreduce_async_torch_cuda_BFloat16Tensor", &DoAllreduce);
   m.def("horovod_torch_allreduce_async_torch_cuda_FloatTensor", &DoAllreduce);
   m.def("horovod_torch_allreduce_async_torch_cuda_DoubleTensor", &DoAllreduce);
+#if HAVE_CUDA
+  // accumulation in Horovod
+  m.def("horovod_torch_accumulate", &DoAccumulate);
+  m.def("horovod_torch_accumulated_allreduce_async", &DoAccumulatedAllreduce);
+#endif
 #else
   m.def("horovod_torch_allreduce_async_torch_cuda_IntTensor",
         &DoAllreduceCudaOnCPU);
@@ -633,22 +1606,31 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
         &DoAllreduceCudaOnCPU);
   m.def("horovod_torch_allreduce_async_torch_cuda_HalfTensor",
         &DoAllreduceCudaOnCPU);
+  m.def("horovod_torch_allreduce_async_torch_cuda_BFloat16Tensor",
+        &DoAllreduceCudaOnCPU);
   m.def("horovod_torch_allreduce_async_torch_cuda_FloatTensor",
         &DoAllreduceCudaOnCPU);
   m.def("horovod_torch_allreduce_async_torch_cuda_DoubleTensor",
         &DoAllreduceCudaOnCPU);
 #endif
 
+  // bucketed allreduce
+  m.def("horovod_torch_bucketed_allreduce_async", &DoBucketedAllreduce);
+  m.def("horovod_torch_skip_bucketed_allreduce", &DoSkipBucketedAllreduce);
+  m.def("horovod_torch_register_allreduce_buckets", &DoRegisterAllreduceBuckets);
+
   // grouped allreduce
   m.def("horovod_torch_grouped_allreduce_async_torch_IntTensor", &DoGroupedAllreduce);
   m.def("horovod_torch_grouped_allreduce_async_torch_LongTensor", &DoGroupedAllreduce);
   m.def("horovod_torch_grouped_allreduce_async_torch_HalfTensor", &DoGroupedAllreduce);
+  m.def("horovod_torch_grouped_allreduce_async_torch_BFloat16Tensor", &DoGroupedAllreduce);
   m.def("horovod_torch_grouped_allreduce_async_torch_FloatTensor", &DoGroupedAllreduce);
   m.def("horovod_torch_grouped_allreduce_async_torch_DoubleTensor", &DoGroupedAllreduce);
 #if HOROVOD_GPU_ALLREDUCE
   m.def("horovod_torch_grouped_allreduce_async_torch_cuda_IntTensor", &DoGroupedAllreduce);
   m.def("horovod_torch_grouped_allreduce_async_torch_cuda_LongTensor", &DoGroupedAllreduce);
   m.def("horovod_torch_grouped_allreduce_async_torch_cuda_HalfTensor", &DoGroupedAllreduce);
+  m.def("horovod_torch_grouped_allreduce_async_torch_cuda_BFloat16Tensor", &DoGroupedAllreduce);
   m.def("horovod_torch_grouped_allreduce_async_torch_cuda_FloatTensor", &DoGroupedAllreduce);
   m.def("horovod_torch_grouped_allreduce_async_torch_cuda_DoubleTensor", &DoGroupedAllreduce);
 #else
@@ -658,6 +1640,8 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
         &DoGroupedAllreduceCudaOnCPU);
   m.def("horovod_torch_grouped_allreduce_async_torch_cuda_HalfTensor",
         &DoGroupedAllreduceCudaOnCPU);
+  m.def("horovod_torch_grouped_allreduce_async_torch_cuda_BFloat16Tensor",
+        &DoGroupedAllreduceCudaOnCPU);
   m.def("horovod_torch_grouped_allreduce_async_torch_cuda_FloatTensor",
         &DoGroupedAllreduceCudaOnCPU);
   m.def("horovod_torch_grouped_allreduce_async_torch_cuda_DoubleTensor",
@@ -671,6 +1655,7 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
   m.def("horovod_torch_allgather_async_torch_IntTensor", &DoAllgather);
   m.def("horovod_torch_allgather_async_torch_LongTensor", &DoAllgather);
   m.def("horovod_torch_allgather_async_torch_HalfTensor", &DoAllgather);
+  m.def("horovod_torch_allgather_async_torch_BFloat16Tensor", &DoAllgather);
   m.def("horovod_torch_allgather_async_torch_FloatTensor", &DoAllgather);
   m.def("horovod_torch_allgather_async_torch_DoubleTensor", &DoAllgather);
 #if HOROVOD_GPU_ALLGATHER
@@ -680,6 +1665,7 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
   m.def("horovod_torch_allgather_async_torch_cuda_IntTensor", &DoAllgather);
   m.def("horovod_torch_allgather_async_torch_cuda_LongTensor", &DoAllgather);
   m.def("horovod_torch_allgather_async_torch_cuda_HalfTensor", &DoAllgather);
+  m.def("horovod_torch_allgather_async_torch_cuda_BFloat16Tensor", &DoAllgather);
   m.def("horovod_torch_allgather_async_torch_cuda_FloatTensor", &DoAllgather);
   m.def("horovod_torch_allgather_async_torch_cuda_DoubleTensor", &DoAllgather);
 #else
@@ -695,12 +1681,105 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
         &DoAllgatherCudaOnCPU);
   m.def("horovod_torch_allgather_async_torch_cuda_HalfTensor",
         &DoAllgatherCudaOnCPU);
+  m.def("horovod_torch_allgather_async_torch_cuda_BFloat16Tensor",
+        &DoAllgatherCudaOnCPU);
   m.def("horovod_torch_allgather_async_torch_cuda_FloatTensor",
         &DoAllgatherCudaOnCPU);
   m.def("horovod_torch_allgather_async_torch_cuda_DoubleTensor",
         &DoAllgatherCudaOnCPU);
 #endif
 
+  // grouped allgather
+  m.def("horovod_torch_grouped_allgather_async_torch_ByteTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_CharTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_ShortTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_IntTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_LongTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_HalfTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_BFloat16Tensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_FloatTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_DoubleTensor", &DoGroupedAllgather);
+#if HOROVOD_GPU_ALLGATHER
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_ByteTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_CharTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_ShortTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_IntTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_LongTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_HalfTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_BFloat16Tensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_FloatTensor", &DoGroupedAllgather);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_DoubleTensor", &DoGroupedAllgather);
+#else
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_ByteTensor",
+        &DoGroupedAllgatherCudaOnCPU);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_CharTensor",
+        &DoGroupedAllgatherCudaOnCPU);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_ShortTensor",
+        &DoGroupedAllgatherCudaOnCPU);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_IntTensor",
+        &DoGroupedAllgatherCudaOnCPU);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_LongTensor",
+        &DoGroupedAllgatherCudaOnCPU);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_HalfTensor",
+        &DoGroupedAllgatherCudaOnCPU);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_BFloat16Tensor",
+        &DoGroupedAllgatherCudaOnCPU);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_FloatTensor",
+        &DoGroupedAllgatherCudaOnCPU);
+  m.def("horovod_torch_grouped_allgather_async_torch_cuda_DoubleTensor",
+        &DoGroupedAllgatherCudaOnCPU);
+#endif
+
+  // reducescatter
+  m.def("horovod_torch_reducescatter_async_torch_ByteTensor", &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_CharTensor", &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_ShortTensor", &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_IntTensor", &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_LongTensor", &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_HalfTensor", &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_BFloat16Tensor", &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_FloatTensor", &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_DoubleTensor", &DoReducescatter);
+#if HOROVOD_GPU_REDUCESCATTER
+  m.def("horovod_torch_reducescatter_async_torch_cuda_ByteTensor",
+        &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_CharTensor",
+        &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_ShortTensor",
+        &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_IntTensor",
+        &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_LongTensor",
+        &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_HalfTensor",
+        &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_BFloat16Tensor",
+        &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_FloatTensor",
+        &DoReducescatter);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_DoubleTensor",
+        &DoReducescatter);
+#else
+  m.def("horovod_torch_reducescatter_async_torch_cuda_ByteTensor",
+        &DoReducescatterCudaOnCPU);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_CharTensor",
+        &DoReducescatterCudaOnCPU);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_ShortTensor",
+        &DoReducescatterCudaOnCPU);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_IntTensor",
+        &DoReducescatterCudaOnCPU);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_LongTensor",
+        &DoReducescatterCudaOnCPU);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_HalfTensor",
+        &DoReducescatterCudaOnCPU);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_BFloat16Tensor",
+        &DoReducescatterCudaOnCPU);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_FloatTensor",
+        &DoReducescatterCudaOnCPU);
+  m.def("horovod_torch_reducescatter_async_torch_cuda_DoubleTensor",
+        &DoReducescatterCudaOnCPU);
+#endif
+
   // broadcast
   m.def("horovod_torch_broadcast_async_torch_ByteTensor", &DoBroadcast);
   m.def("horovod_torch_broadcast_async_torch_CharTensor", &DoBroadcast);
@@ -708,6 +1787,7 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
   m.def("horovod_torch_broadcast_async_torch_IntTensor", &DoBroadcast);
   m.def("horovod_torch_broadcast_async_torch_LongTensor", &DoBroadcast);
   m.def("horovod_torch_broadcast_async_torch_HalfTensor", &DoBroadcast);
+  m.def("horovod_torch_broadcast_async_torch_BFloat16Tensor", &DoBroadcast);
   m.def("horovod_torch_broadcast_async_torch_FloatTensor", &DoBroadcast);
   m.def("horovod_torch_broadcast_async_torch_DoubleTensor", &DoBroadcast);
 #if HOROVOD_GPU_BROADCAST
@@ -717,6 +1797,7 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
   m.def("horovod_torch_broadcast_async_torch_cuda_IntTensor", &DoBroadcast);
   m.def("horovod_torch_broadcast_async_torch_cuda_LongTensor", &DoBroadcast);
   m.def("horovod_torch_broadcast_async_torch_cuda_HalfTensor", &DoBroadcast);
+  m.def("horovod_torch_broadcast_async_torch_cuda_BFloat16Tensor", &DoBroadcast);
   m.def("horovod_torch_broadcast_async_torch_cuda_FloatTensor", &DoBroadcast);
   m.def("horovod_torch_broadcast_async_torch_cuda_DoubleTensor", &DoBroadcast);
 #else
@@ -732,12 +1813,55 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
         &DoBroadcastCudaOnCPU);
   m.def("horovod_torch_broadcast_async_torch_cuda_HalfTensor",
         &DoBroadcastCudaOnCPU);
+  m.def("horovod_torch_broadcast_async_torch_cuda_BFloat16Tensor",
+        &DoBroadcastCudaOnCPU);
   m.def("horovod_torch_broadcast_async_torch_cuda_FloatTensor",
         &DoBroadcastCudaOnCPU);
   m.def("horovod_torch_broadcast_async_torch_cuda_DoubleTensor",
         &DoBroadcastCudaOnCPU);
 #endif
 
+  // grouped broadcast
+  m.def("horovod_torch_grouped_broadcast_async_torch_ByteTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_CharTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_ShortTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_IntTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_LongTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_HalfTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_BFloat16Tensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_FloatTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_DoubleTensor", &DoGroupedBroadcast);
+#if HOROVOD_GPU_BROADCAST
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_ByteTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_CharTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_ShortTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_IntTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_LongTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_HalfTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_BFloat16Tensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_FloatTensor", &DoGroupedBroadcast);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_DoubleTensor", &DoGroupedBroadcast);
+#else
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_ByteTensor",
+        &DoGroupedBroadcastCudaOnCPU);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_CharTensor",
+        &DoGroupedBroadcastCudaOnCPU);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_ShortTensor",
+        &DoGroupedBroadcastCudaOnCPU);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_IntTensor",
+        &DoGroupedBroadcastCudaOnCPU);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_LongTensor",
+        &DoGroupedBroadcastCudaOnCPU);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_HalfTensor",
+        &DoGroupedBroadcastCudaOnCPU);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_BFloat16Tensor",
+        &DoGroupedBroadcastCudaOnCPU);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_FloatTensor",
+        &DoGroupedBroadcastCudaOnCPU);
+  m.def("horovod_torch_grouped_broadcast_async_torch_cuda_DoubleTensor",
+        &DoGroupedBroadcastCudaOnCPU);
+#endif
+
   // alltoall
   m.def("horovod_torch_alltoall_async_torch_ByteTensor", &DoAlltoall);
   m.def("horovod_torch_alltoall_async_torch_CharTensor", &DoAlltoall);
@@ -745,6 +1869,7 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
   m.def("horovod_torch_alltoall_async_torch_IntTensor", &DoAlltoall);
   m.def("horovod_torch_alltoall_async_torch_LongTensor", &DoAlltoall);
   m.def("horovod_torch_alltoall_async_torch_HalfTensor", &DoAlltoall);
+  m.def("horovod_torch_alltoall_async_torch_BFloat16Tensor", &DoAlltoall);
   m.def("horovod_torch_alltoall_async_torch_FloatTensor", &DoAlltoall);
   m.def("horovod_torch_alltoall_async_torch_DoubleTensor", &DoAlltoall);
 #if HOROVOD_GPU_ALLTOALL
@@ -754,6 +1879,7 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
   m.def("horovod_torch_alltoall_async_torch_cuda_IntTensor", &DoAlltoall);
   m.def("horovod_torch_alltoall_async_torch_cuda_LongTensor", &DoAlltoall);
   m.def("horovod_torch_alltoall_async_torch_cuda_HalfTensor", &DoAlltoall);
+  m.def("horovod_torch_alltoall_async_torch_cuda_BFloat16Tensor", &DoAlltoall);
   m.def("horovod_torch_alltoall_async_torch_cuda_FloatTensor", &DoAlltoall);
   m.def("horovod_torch_alltoall_async_torch_cuda_DoubleTensor", &DoAlltoall);
 #else
@@ -769,18 +1895,87 @@ PYBIND11_MODULE(mpi_lib_v2, m) {
         &DoAlltoallCudaOnCPU);
   m.def("horovod_torch_alltoall_async_torch_cuda_HalfTensor",
         &DoAlltoallCudaOnCPU);
+  m.def("horovod_torch_alltoall_async_torch_cuda_BFloat16Tensor",
+        &DoAlltoallCudaOnCPU);
   m.def("horovod_torch_alltoall_async_torch_cuda_FloatTensor",
         &DoAlltoallCudaOnCPU);
   m.def("horovod_torch_alltoall_async_torch_cuda_DoubleTensor",
         &DoAlltoallCudaOnCPU);
 #endif
 
+  // grouped alltoall
+  m.def("horovod_torch_grouped_alltoall_async_torch_ByteTensor", &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_CharTensor", &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_ShortTensor", &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_IntTensor", &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_LongTensor", &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_HalfTensor", &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_BFloat16Tensor", &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_FloatTensor", &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_DoubleTensor", &DoGroupedAlltoall);
+#if HOROVOD_GPU_ALLTOALL
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_ByteTensor",
+        &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_CharTensor",
+        &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_ShortTensor",
+        &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_IntTensor",
+        &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_LongTensor",
+        &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_HalfTensor",
+        &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_BFloat16Tensor",
+        &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_FloatTensor",
+        &DoGroupedAlltoall);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_DoubleTensor",
+        &DoGroupedAlltoall);
+#else
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_ByteTensor",
+        &DoGroupedAlltoallCudaOnCPU);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_CharTensor",
+        &DoGroupedAlltoallCudaOnCPU);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_ShortTensor",
+        &DoGroupedAlltoallCudaOnCPU);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_IntTensor",
+        &DoGroupedAlltoallCudaOnCPU);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_LongTensor",
+        &DoGroupedAlltoallCudaOnCPU);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_HalfTensor",
+        &DoGroupedAlltoallCudaOnCPU);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_BFloat16Tensor",
+        &DoGroupedAlltoallCudaOnCPU);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_FloatTensor",
+        &DoGroupedAlltoallCudaOnCPU);
+  m.def("horovod_torch_grouped_alltoall_async_torch_cuda_DoubleTensor",
+        &DoGroupedAlltoallCudaOnCPU);
+#endif
+
+  // send and receive
+  m.def("horovod_torch_send_async", &DoSend);
+  m.def("horovod_torch_recv_async", &DoRecv);
+
+  // reduce and gather to a root rank
+  m.def("horovod_torch_reduce_async", &DoReduce);
+  m.def("horovod_torch_gather_async", &DoGather);
+
+  // capturable allreduce
+  m.def("horovod_torch_capturable_allreduce_id", &DoCapturableAllreduceId);
+  m.def("horovod_torch_init_capturable_allreduce",
+        &DoInitCapturableAllreduce);
+  m.def("horovod_torch_capturable_allreduce", &DoCapturableAllreduce);
+
   // join
   m.def("horovod_torch_join", &DoJoin);
 
   // basics
   m.def("horovod_torch_poll", &PollHandle);
-  m.def("horovod_torch_wait_and_clear", &WaitAndClear);
+  m.def("horovod_torch_wait_and_clear", &WaitAndClear,
+        py::call_guard<py::gil_scoped_release>());
+  m.def("horovod_torch_wait_all", &WaitAll,
+        py::call_guard<py::gil_scoped_release>());
   m.def("horovod_torch_reset", &Reset);
 }
 
@@ -26,7 +26,9 @@ from horovod.common.util import split_list
 from horovod.torch.compression import Compression
 from horovod.torch.functions import broadcast_object
 from horovod.torch.mpi_ops import allreduce_async_, grouped_allreduce_async_, sparse_allreduce_async
-from horovod.torch.mpi_ops import synchronize
+from horovod.torch.mpi_ops import _accumulate_, _accumulated_allreduce_async_, _accumulation_supported
+from horovod.torch.mpi_ops import _bucketed_allreduce_async_, _register_allreduce_buckets, _skip_bucketed_allreduce
+from horovod.torch.mpi_ops import synchronize, synchronize_all
 from horovod.torch.mpi_ops import size
 from horovod.torch.mpi_ops import Average, Adasum, Sum
 from horovod.torch.mpi_ops import rocm_built
@@ -37,7 +39,9 @@ class _DistributedOptimizer(torch.optim.Optimizer):
                  backward_passes_per_step=1, op=Average,
                  gradient_predivide_factor=1.0,
                  groups=None,
-                 sparse_as_dense=False):
+                 sparse_as_dense=False,
+                 accumulate_in_horovod=False,
+                 bucket_cap_mb=0):
         super(self.__class__, self).__init__(params)
         self._compression = compression
 
@@ -76,6 +80,24 @@ class _DistributedOptimizer(torch.optim.Optimizer):
         self.gradient_predivide_factor = gradient_predivide_factor
         self.sparse_as_dense = sparse_as_dense
 
+        if accumulate_in_horovod and not _accumulation_supported():
+            warnings.warn('accumulate_in_horovod needs Horovod built with CUDA and GPU allreduce, '
+                          'gradients are accumulated by PyTorch instead.')
+        self._accumulate_in_horovod = accumulate_in_horovod and _accumulation_supported()
+        # Parameters with contributions accumulated by Horovod in this step.
+        self._accumulated = set()
+        self._bucket_bytes = int(bucket_cap_mb * 1024 * 1024)
+        # Parameters whose allreduces are held back until their bucket is complete.
+        self._bucketed = set()
+
+        # Parameters of the first layers come first in the param groups and
+        # are needed first by the next forward pass, so their gradients get
+        # the highest scheduling priority.
+        all_params = [v for param_group in self.param_groups
+                      for v in param_group['params']]
+        self._priorities = {v: len(all_params) - i
+                            for i, v in enumerate(all_params)}
+
         self._handles = {}
         self._grad_accs = []
         self._requires_update = set()
@@ -160,6 +182,21 @@ class _DistributedOptimizer(torch.optim.Optimizer):
                 for p in group:
                     self._p_to_group[p] = group
                 self._group_counts[group] = 0
+        elif self._bucket_bytes > 0:
+            # Buckets must be the same on every worker, so use the parameter order of rank 0.
+            p_list = [p for param_group in self.param_groups
+                      for p in param_group['params'] if p.requires_grad]
+            p_by_name = {self._parameter_names.get(p): p for p in p_list}
+            p_list_names = broadcast_object(list(p_by_name), root_rank=0)
+            p_by_device = {}
+            for name in p_list_names:
+                p = p_by_name[name]
+                p_by_device.setdefault(p.device, []).append(p)
+            for ps in p_by_device.values():
+                _register_allreduce_buckets([self._parameter_names.get(p) for p in ps],
+                                            [p.numel() * p.element_size() for p in ps],
+                                            self._bucket_bytes)
+                self._bucketed.update(ps)
 
         for param_group in self.param_groups:
             for p in param_group['params']:
@@ -187,6 +224,8 @@ class _DistributedOptimizer(torch.optim.Optimizer):
             if self.sparse_as_dense:
                 tensor = tensor.to_dense()
             else:
+                if p in self._bucketed:
+                    _skip_bucketed_allreduce(name)
                 return self._sparse_allreduce_grad_async(p, name)
 
         tensor_compressed, ctx = self._compression.compress(tensor)
@@ -200,22 +239,49 @@ class _DistributedOptimizer(torch.optim.Optimizer):
             prescale_factor = 1.0
             postscale_factor = 1.0
 
+        if p in self._accumulated:
+            self._accumulated.discard(p)
+            if p in self._bucketed:
+                _skip_bucketed_allreduce(name)
+            handle = _accumulated_allreduce_async_(tensor, name, self.op,
+                                                   prescale_factor=prescale_factor,
+                                                   postscale_factor=postscale_factor,
+                                                   priority=self._priorities.get(p, 0))
+            return handle, None
+
+        if p in self._bucketed:
+            handle = _bucketed_allreduce_async_(tensor_compressed, name, self.op,
+                                                prescale_factor=prescale_factor,
+                                                postscale_factor=postscale_factor,
+                                                priority=self._priorities.get(p, 0))
+            return handle, ctx
+
         handle = allreduce_async_(tensor_compressed, name=name, op=self.op,
                                   prescale_factor=prescale_factor,
-                                  postscale_factor=postscale_factor)
+                                  postscale_factor=postscale_factor,
+                                  priority=self._priorities.get(p, 0))
         return handle, ctx
 
     def _grouped_allreduce_grad_async(self, ps):
         name = self._parameter_names.get(ps[0])
         tensors_compressed, ctxs = zip(*[self._compression.compress(p.grad) for p in ps])
 
-        handle = grouped_allreduce_async_(tensors_compressed, name=name, op=self.op)
+        priority = max(self._priorities.get(p, 0) for p in ps)
+        handle = grouped_allreduce_async_(tensors_compressed, name=name, op=self.op,
+                                          priority=priority)
         return handle, ctxs
 
     def _sparse_allreduce_grad_async(self, p, name):
         handle = sparse_allreduce_async(p.grad, name=name, op=self.op)
         return handle, None
 
+    def _can_accumulate(self, p):
+        # Only dense CUDA gradients that are allreduced on their own and
+        # uncompressed are summed by Horovod between steps.
+        return (self._accumulate_in_horovod and self._groups is None and
+                self._compression is Compression.none and self.op in (Average, Sum) and
+                p.grad.is_cuda and not p.grad.is_sparse)
+
     def _make_hook(self, p):
         def hook(*ignore):
             if p in self._handles and self._handles[p][0] is not None:
@@ -243,6 +309,12 @@ class _DistributedOptimizer(torch.optim.Optimizer):
                         return
                 else:
                     handle, ctx = self._allreduce_grad_async(p)
+            elif self._can_accumulate(p):
+                # Hand the gradient to Horovod, so that the next backward
+                # pass writes a fresh one instead of adding to it.
+                _accumulate_(p.grad, self._parameter_names.get(p))
+                self._accumulated.add(p)
+                p.grad = None
             self._handles[p] = (handle, ctx)
         return hook
 
@@ -259,11 +331,15 @@ class _DistributedOptimizer(torch.optim.Optimizer):
             if handle is None:
                 handle, ctx = self._allreduce_grad_async(p)
                 self._handles[p] = (handle, ctx)
+
+        # Wait for all allreduces at once rather than waking up for each of them.
+        handles = [handle for handle, _ in self._handles.values() if not callable(handle)]
+        results = dict(zip(handles, synchronize_all(handles)))
         for p, (handle, ctx) in self._handles.items():
 
             if isinstance(p, tuple):
                 # This was a grouped result, need to unpack
-                outputs = synchronize(handle)
+                outputs = results[handle]
                 for gp, output, gctx in zip(p, outputs, ctx):
                     self._allreduce_delay[gp] = self.backward_passes_per_step
                     gp.grad.set_(self._compression.decompress(output, gctx))
@@ -271,7 +347,7 @@ class _DistributedOptimizer(torch.optim.Optimizer):
                     self._group_counts[p] = 0
             else:
                 # When handle is a callable function, it returns the aggregated tensor result
-                output = synchronize(handle) if not callable(handle) else handle()
+                output = results[handle] if not callable(handle) else handle()
                 self._allreduce_delay[p] = self.backward_passes_per_step
                 if self._groups is not None:
                     group = self._p_to_group[p]
@@ -509,7 +585,9 @@ def DistributedOptimizer(optimizer, named_parameters=None,
                          op=Average,
                          gradient_predivide_factor=1.0,
                          num_groups=0, groups=None,
-                         sparse_as_dense=False):
+                         sparse_as_dense=False,
+                         accumulate_in_horovod=False,
+                         bucket_cap_mb=0):
     """
     An optimizer that wraps another torch.optim.Optimizer, using an allreduce to
     combine gradient values before applying gradients to model weights.
@@ -564,6 +642,15 @@ def DistributedOptimizer(optimizer, named_parameters=None,
                 Defaults as None, which is no explicit groups.
         sparse_as_dense: If set True, convert all sparse gradients to dense and perform allreduce, then
                          convert back to sparse before applying the update.
+        accumulate_in_horovod: If set True and backward_passes_per_step > 1, dense CUDA gradients of
+                               all but the last backward pass are summed in device memory owned by
+                               Horovod, and ``p.grad`` is None in between. Needs Horovod built with
+                               CUDA and GPU allreduce, and applies to ungrouped, uncompressed
+                               gradients with op Average or Sum.
+        bucket_cap_mb: If > 0, gradients are allreduced in buckets of about this many megabytes, filled
+                       in the reverse order of the parameters like the backward pass produces them.
+                       Each bucket is enqueued as one group as soon as all of its gradients are
+                       ready, without waiting for the cycle time. Ignored with groups.
     """
     # We dynamically create a new class that inherits from the optimizer that was passed in.
     # The goal is to override the `step()` method with an allreduce implementation.
@@ -583,7 +670,8 @@ def DistributedOptimizer(optimizer, named_parameters=None,
         cls = type(optimizer.__class__.__name__, (optimizer.__class__,),
                    dict(_DistributedOptimizer.__dict__))
         return cls(optimizer.param_groups, named_parameters, compression, backward_passes_per_step, op,
-                   gradient_predivide_factor, groups, sparse_as_dense)
+                   gradient_predivide_factor, groups, sparse_as_dense, accumulate_in_horovod,
+                   bucket_cap_mb)
     else:
         cls = type(optimizer.__class__.__name__, (optimizer.__class__,),
                    dict(_DistributedAdasumOptimizer.__dict__))
@@ -21,15 +21,13 @@
 #include <THC/THC.h>
 #endif
 #include <cassert>
-#include <mutex>
-#include <queue>
-#include <unordered_map>
 #else
 #include <stdexcept>
 #endif
 
 #include "ready_event.h"
 #include "cuda_util.h"
+#include "../common/event_pool.h"
 
 #if TORCH_VERSION < 1005000000
 #if HAVE_GPU
@@ -41,32 +39,21 @@ namespace horovod {
 namespace torch {
 
 #if HAVE_GPU
-struct ReadyEventRegistry {
-  std::unordered_map<int, std::queue<cudaEvent_t>> cuda_events;
-  std::mutex mutex;
-};
-
-static ReadyEventRegistry ready_event_registry;
+static common::EventPool<cudaEvent_t> ready_event_pool;
 
 TorchReadyEvent::TorchReadyEvent(int device) : device_(device) {
   assert(device_ != CPU_DEVICE_ID);
 
   with_device device_context(device_);
-  {
-    std::lock_guard<std::mutex> guard(ready_event_registry.mutex);
-    auto& queue = ready_event_registry.cuda_events[device_];
-    if (!queue.empty()) {
-      cuda_event_ = queue.front();
-      queue.pop();
-    } else {
-      #if TORCH_VERSION >= 1005000000
-      C10_CUDA_CHECK(cudaEventCreateWithFlags(
-          &cuda_event_, cudaEventBlockingSync | cudaEventDisableTiming));
-      #else
-      THCudaCheck(cudaEventCreateWithFlags(
-          &cuda_event_, cudaEventBlockingSync | cudaEventDisableTiming));
-      #endif
-    }
+  cuda_event_ = ready_event_pool.Acquire(device_);
+  if (cuda_event_ == nullptr) {
+    #if TORCH_VERSION >= 1005000000
+    C10_CUDA_CHECK(cudaEventCreateWithFlags(
+        &cuda_event_, cudaEventBlockingSync | cudaEventDisableTiming));
+    #else
+    THCudaCheck(cudaEventCreateWithFlags(
+        &cuda_event_, cudaEventBlockingSync | cudaEventDisableTiming));
+    #endif
   }
   #if TORCH_VERSION >= 1005000000
   auto stream = c10::cuda::getCurrentCUDAStream(device_);
@@ -78,10 +65,8 @@ TorchReadyEvent::TorchReadyEvent(int device) : device_(device) {
 }
 
 TorchReadyEvent::~TorchReadyEvent() {
-  {
-    std::lock_guard<std::mutex> guard(ready_event_registry.mutex);
-    auto& queue = ready_event_registry.cuda_events[device_];
-    queue.push(cuda_event_);
+  if (!ready_event_pool.Release(device_, cuda_event_)) {
+    cudaEventDestroy(cuda_event_);
   }
 }
 
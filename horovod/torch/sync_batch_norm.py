@@ -102,25 +102,25 @@ class _SyncBatchNorm(Function):
         input = input.contiguous()
 
         size = input.numel() // input.size(1)
-        count = torch.tensor([size])
+        num_channels = input.size(1)
 
         # calculate mean/invstd for input.
         mean, invstd = torch.batch_norm_stats(input, eps)
 
-        count_handle = allgather_async(count.unsqueeze(0), name='sync_batch_norm.count')
-        mean_handle = allgather_async(mean.unsqueeze(0), name='sync_batch_norm.mean')
-        invstd_handle = allgather_async(invstd.unsqueeze(0), name='sync_batch_norm.invstd')
-
-        # wait on the async communication to finish
-        count_all = synchronize(count_handle)
-        mean_all = synchronize(mean_handle)
-        invstd_all = synchronize(invstd_handle)
+        # gather mean, invstd and count of all workers with a single collective
+        count = torch.full((1,), size, dtype=mean.dtype, device=mean.device)
+        stats = torch.cat([mean, invstd, count]).unsqueeze(0)
+        stats_all = synchronize(allgather_async(stats, name='sync_batch_norm.stats'))
+        mean_all, invstd_all, count_all = torch.split(
+            stats_all, [num_channels, num_channels, 1], dim=1)
+        mean_all = mean_all.contiguous()
+        invstd_all = invstd_all.contiguous()
 
         if _SYNC_BN_V3:
-            counts_for_bngswc = count_all.view(-1).float().to(input.device)
+            counts_for_bngswc = count_all.reshape(-1).float()
         else:
             # backwards compatibility
-            counts_for_bngswc = count_all.view(-1).tolist()
+            counts_for_bngswc = count_all.reshape(-1).long().tolist()
 
         # calculate global mean & invstd
         mean, invstd = torch.batch_norm_gather_stats_with_counts(
@@ -158,13 +158,11 @@ class _SyncBatchNorm(Function):
         )
 
         if need_input_grad:
-            # synchronizing stats used to calculate input gradient.
-            sum_dy_handle = allreduce_async(sum_dy, op=Sum, name='sync_batch_norm.sum_dy')
-            sum_dy_xmu_handle = allreduce_async(sum_dy_xmu, op=Sum, name='sync_batch_norm.sum_dy_xmu')
-
-            # wait on the async communication to finish
-            sum_dy = synchronize(sum_dy_handle)
-            sum_dy_xmu = synchronize(sum_dy_xmu_handle)
+            # synchronizing stats used to calculate input gradient, both in one allreduce.
+            num_channels = sum_dy.numel()
+            sum_dy_all = synchronize(allreduce_async(
+                torch.cat([sum_dy, sum_dy_xmu]), op=Sum, name='sync_batch_norm.sum_dy'))
+            sum_dy, sum_dy_xmu = torch.split(sum_dy_all, [num_channels, num_channels])
 
             if _SYNC_BN_V4:
                 # from 1.9.0 on we need a count tensor on all devices
@@ -0,0 +1,226 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Checks the completion tokens of the C++ API, in particular a continuation
+// or coroutine chained while another thread completes the token. Runs in a
+// single process without Horovod. Exits with a non-zero status if a check
+// fails.
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "completion.h"
+
+using Completion = horovod::common::BasicCompletion<int>;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      std::cerr << __FILE__ << ":" << __LINE__                                 \
+                << ": check failed: " #condition << std::endl;                 \
+      ++failures;                                                              \
+    }                                                                          \
+  } while (0)
+
+constexpr int RACE_ITERATIONS = 10000;
+
+// Runs first and second on two threads that start at the same time.
+template <class First, class Second> void RunRacing(First first, Second second) {
+  std::atomic<int> ready{0};
+  std::thread thread([&]() {
+    ready.fetch_add(1);
+    while (ready.load() < 2) {
+      std::this_thread::yield();
+    }
+    first();
+  });
+  ready.fetch_add(1);
+  while (ready.load() < 2) {
+    std::this_thread::yield();
+  }
+  second();
+  thread.join();
+}
+
+void TestThen() {
+  // Chained before completion, runs on the completing thread.
+  auto pending = Completion::Make();
+  int calls = 0;
+  int value = 0;
+  pending.Then([&](const int& result) {
+    ++calls;
+    value = result;
+  });
+  CHECK(calls == 0);
+  CHECK(!pending.Poll());
+  pending.Callback()(7);
+  CHECK(pending.Poll());
+  CHECK(calls == 1 && value == 7);
+
+  // Chained after completion, runs right away.
+  auto ready = Completion::Ready(3);
+  ready.Then([&](const int& result) {
+    ++calls;
+    value = result;
+  });
+  CHECK(calls == 2 && value == 3);
+
+  // Only one continuation can be chained.
+  auto twice = Completion::Make();
+  twice.Then([](const int&) {});
+  bool thrown = false;
+  try {
+    twice.Then([](const int&) {});
+  } catch (const std::logic_error&) {
+    thrown = true;
+  }
+  CHECK(thrown);
+  twice.Complete(0);
+}
+
+// Whether Then() finds the token pending or completed, the continuation runs
+// exactly once and sees the result.
+void TestThenRace() {
+  int chained = 0;
+  for (int i = 0; i < RACE_ITERATIONS; ++i) {
+    auto completion = Completion::Make();
+    std::atomic<int> calls{0};
+    std::atomic<int> value{0};
+    std::thread::id continuation_thread;
+    std::thread::id chaining_thread;
+    RunRacing([&]() { completion.Complete(i); },
+              [&]() {
+                chaining_thread = std::this_thread::get_id();
+                completion.Then([&](const int& result) {
+                  continuation_thread = std::this_thread::get_id();
+                  value.store(result);
+                  calls.fetch_add(1);
+                });
+              });
+    CHECK(calls.load() == 1);
+    CHECK(value.load() == i);
+    chained += continuation_thread != chaining_thread;
+    if (failures > 0) {
+      return;
+    }
+  }
+  std::cout << "Then() chained before completion in " << chained << " of "
+            << RACE_ITERATIONS << " races." << std::endl;
+}
+
+void TestWait() {
+  auto completion = Completion::Make();
+  std::thread thread([completion]() { completion.Complete(5); });
+  completion.Wait();
+  CHECK(completion.Poll());
+  CHECK(completion.result() == 5);
+  thread.join();
+}
+
+#if HOROVOD_HAVE_COROUTINES
+// A coroutine that starts right away and frees its frame when it returns.
+struct Task {
+  struct promise_type {
+    Task get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// Counts the live frames of Await() through a local of the frame.
+struct FrameCounter {
+  std::atomic<int>* live;
+  explicit FrameCounter(std::atomic<int>* live) : live(live) {
+    live->fetch_add(1);
+  }
+  ~FrameCounter() { live->fetch_sub(1); }
+};
+
+Task Await(Completion completion, std::atomic<int>* live,
+           std::atomic<int>* resumed, std::atomic<int>* value) {
+  FrameCounter counter(live);
+  int result = co_await completion;
+  value->store(result);
+  resumed->fetch_add(1);
+}
+
+void TestAwait() {
+  std::atomic<int> live{0};
+  std::atomic<int> resumed{0};
+  std::atomic<int> value{0};
+
+  // Already completed, does not suspend.
+  Await(Completion::Ready(4), &live, &resumed, &value);
+  CHECK(resumed.load() == 1 && value.load() == 4 && live.load() == 0);
+
+  // Suspends until completed.
+  auto pending = Completion::Make();
+  Await(pending, &live, &resumed, &value);
+  CHECK(resumed.load() == 1 && live.load() == 1);
+  pending.Complete(6);
+  CHECK(resumed.load() == 2 && value.load() == 6 && live.load() == 0);
+
+  // Completed while the coroutine suspends: it resumes exactly once, and its
+  // frame is freed by whichever thread resumes it. As with the ops, only the
+  // callback and the frame hold the token, so resuming the coroutine may free
+  // it too.
+  for (int i = 0; i < RACE_ITERATIONS; ++i) {
+    auto completion = Completion::Make();
+    auto callback = completion.Callback();
+    resumed.store(0);
+    RunRacing(
+        [&]() {
+          auto complete = std::move(callback);
+          complete(i);
+        },
+        [&]() { Await(std::move(completion), &live, &resumed, &value); });
+    CHECK(resumed.load() == 1);
+    CHECK(value.load() == i);
+    CHECK(live.load() == 0);
+    if (failures > 0) {
+      return;
+    }
+  }
+}
+#endif
+
+} // namespace
+
+int main() {
+  TestThen();
+  TestThenRace();
+  TestWait();
+#if HOROVOD_HAVE_COROUTINES
+  TestAwait();
+#else
+  std::cout << "Coroutines are not available, co_await is not tested."
+            << std::endl;
+#endif
+  if (failures > 0) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
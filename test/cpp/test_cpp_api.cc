@@ -0,0 +1,179 @@
+// Copyright 2021 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Enqueues ops on raw host buffers through the C++ API and checks their
+// results. Launched like a training script, e.g.
+//
+//   horovodrun -np 2 test_cpp_api
+//
+// Exits with a non-zero status if a check fails on this rank.
+
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "horovod.h"
+
+namespace hvd = horovod::cpp;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      std::cerr << "[" << hvd::Rank() << "] " << __FILE__ << ":" << __LINE__   \
+                << ": check failed: " #condition << std::endl;                 \
+      ++failures;                                                              \
+    }                                                                          \
+  } while (0)
+
+hvd::TensorView View(std::vector<float>& data) {
+  hvd::TensorView view;
+  view.data = data.data();
+  view.dtype = hvd::DataType::FLOAT32;
+  view.shape = {(int64_t)data.size()};
+  return view;
+}
+
+hvd::OpOptions Options(const std::string& name) {
+  hvd::OpOptions options;
+  options.name = name;
+  return options;
+}
+
+// Allreduce into a separate output with a callback.
+void TestAllreduceCallback() {
+  int rank = hvd::Rank();
+  int size = hvd::Size();
+  std::vector<float> input(1000, (float)(rank + 1));
+  std::vector<float> output(input.size(), 0.0f);
+
+  std::promise<hvd::Status> done;
+  auto status = hvd::Allreduce(View(input), View(output),
+                               Options("allreduce.callback"),
+                               [&done](const hvd::Status& status) {
+                                 done.set_value(status);
+                               });
+  CHECK(status.ok());
+  auto result = done.get_future().get();
+  CHECK(result.ok());
+
+  float expected = size * (size + 1) / 2.0f;
+  for (auto value : output) {
+    CHECK(value == expected);
+    if (value != expected) {
+      break;
+    }
+  }
+  CHECK(input[0] == (float)(rank + 1));
+}
+
+// In-place allreduces waited for with completion tokens, several at once so
+// that they are fused.
+void TestAllreduceInPlace() {
+  int rank = hvd::Rank();
+  int size = hvd::Size();
+  std::vector<std::vector<float>> tensors;
+  for (int i = 0; i < 8; ++i) {
+    tensors.emplace_back(17 * (i + 1), (float)(rank * i));
+  }
+  std::vector<hvd::Future> futures;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    auto view = View(tensors[i]);
+    auto options = Options("allreduce.inplace." + std::to_string(i));
+    options.reduce_op = hvd::ReduceOp::MAX;
+    futures.push_back(hvd::Allreduce(view, view, options));
+  }
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    futures[i].Wait();
+    CHECK(futures[i].result().ok());
+    for (auto value : tensors[i]) {
+      CHECK(value == (float)((size - 1) * i));
+    }
+  }
+}
+
+// Broadcast and allgather, whose output Horovod allocates.
+void TestBroadcastAllgather() {
+  int rank = hvd::Rank();
+  int size = hvd::Size();
+  std::vector<float> tensor(10, (float)rank);
+  auto broadcast = hvd::Broadcast(View(tensor), size - 1, Options("broadcast"));
+  broadcast.Wait();
+  CHECK(broadcast.result().ok());
+  CHECK(tensor[0] == (float)(size - 1) && tensor[9] == (float)(size - 1));
+
+  std::vector<float> input(rank + 1, (float)rank);
+  auto allgather = hvd::Allgather(View(input), Options("allgather"));
+  allgather.Wait();
+  auto& gathered = allgather.result();
+  CHECK(gathered.status.ok());
+  CHECK(gathered.output != nullptr);
+  if (gathered.output == nullptr) {
+    return;
+  }
+  auto& view = gathered.output->view();
+  CHECK(view.shape == std::vector<int64_t>{size * (size + 1) / 2});
+  auto data = static_cast<const float*>(view.data);
+  // Rank r contributed r + 1 values.
+  int offset = 0;
+  for (int r = 0; r < size; ++r) {
+    for (int i = 0; i <= r; ++i) {
+      CHECK(data[offset + i] == (float)r);
+    }
+    offset += r + 1;
+  }
+}
+
+// Errors of the arguments are returned by the enqueue call, or complete the
+// token right away.
+void TestArgumentErrors() {
+  std::vector<float> input(10, 1.0f);
+  std::vector<float> output(5, 0.0f);
+  auto status = hvd::Allreduce(View(input), View(output),
+                               Options("allreduce.mismatch"),
+                               [](const hvd::Status&) {});
+  CHECK(!status.ok());
+
+  auto future = hvd::Allreduce(View(input), View(input), Options(""));
+  CHECK(future.Poll());
+  CHECK(!future.result().ok());
+}
+
+} // namespace
+
+int main() {
+  if (!hvd::Init()) {
+    std::cerr << "Horovod failed to initialize." << std::endl;
+    return EXIT_FAILURE;
+  }
+  CHECK(hvd::IsInitialized());
+  CHECK(hvd::Rank() >= 0 && hvd::Rank() < hvd::Size());
+
+  TestAllreduceCallback();
+  TestAllreduceInPlace();
+  TestBroadcastAllgather();
+  TestArgumentErrors();
+
+  hvd::Shutdown();
+  if (failures > 0) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -380,6 +380,111 @@ class SparkTorchTests(unittest.TestCase):
                                 predictions = transformer.transform(df)
                                 assert predictions.count() == df.count()
 
+    def test_disk_cache_params(self):
+        est = hvd_spark.TorchEstimator(model=create_xor_model())
+        assert est.getDiskCachePath() is None
+        assert est.getDiskCacheSize() == 10 * 1024 ** 3
+
+        est = hvd_spark.TorchEstimator(model=create_xor_model(),
+                                       disk_cache_path='/tmp/cache',
+                                       disk_cache_size=1024)
+        assert est.getDiskCachePath() == '/tmp/cache'
+        assert est.getDiskCacheSize() == 1024
+
+        est.setDiskCachePath('/tmp/other_cache')
+        est.setDiskCacheSize(2048)
+        copied = est.copy()
+        assert copied.getDiskCachePath() == '/tmp/other_cache'
+        assert copied.getDiskCacheSize() == 2048
+
+        assert util.disk_cache_reader_kwargs(None, 1024, 10, 'run') == {}
+        kwargs = util.disk_cache_reader_kwargs('/tmp/cache', 1024, 0.5, 'run_train_0')
+        assert kwargs['cache_type'] == 'local-disk'
+        assert kwargs['cache_location'] == os.path.join('/tmp/cache', 'run_train_0')
+        assert kwargs['cache_size_limit'] == 1024
+        assert kwargs['cache_row_size_estimate'] == 1
+
+    def test_disk_cache_size_limit(self):
+        from petastorm.local_disk_cache import LocalDiskCache
+
+        size_limit = 1024 ** 2
+        value_size = 50 * 1024
+        with tempdir() as cache_dir:
+            kwargs = util.disk_cache_reader_kwargs(cache_dir, size_limit, value_size, 'run_train_0')
+            # The arguments make_reader passes on to the cache.
+            cache = LocalDiskCache(kwargs['cache_location'], kwargs['cache_size_limit'],
+                                   kwargs['cache_row_size_estimate'],
+                                   **kwargs['cache_extra_settings'])
+            for i in range(50):
+                value = np.full(value_size, i % 256, dtype=np.uint8)
+                assert np.array_equal(cache.get(str(i), lambda: value), value)
+
+            def cached_bytes():
+                return sum(os.path.getsize(os.path.join(root, name))
+                           for root, _, names in os.walk(kwargs['cache_location'])
+                           for name in names)
+
+            # Least recently stored values are evicted, each shard of the cache
+            # may be one value above its share of the limit.
+            assert 0 < cached_bytes() <= 2 * size_limit
+            cache.cleanup()
+            assert not os.path.exists(kwargs['cache_location'])
+
+    def test_fit_with_disk_cache(self):
+        from petastorm.local_disk_cache import LocalDiskCache
+
+        init = LocalDiskCache.__init__
+        cleanup = LocalDiskCache.cleanup
+        caches = {}
+
+        def recording_init(cache, path, size_limit_bytes, *args, **kwargs):
+            init(cache, path, size_limit_bytes, *args, **kwargs)
+            caches[id(cache)] = dict(path=path, size_limit=size_limit_bytes, files=0)
+
+        def recording_cleanup(cache):
+            entry = caches[id(cache)]
+            entry['files'] = sum(len(names) for _, _, names in os.walk(entry['path']))
+            cleanup(cache)
+
+        with spark_session('test_fit_with_disk_cache') as spark:
+            df = create_xor_data_with_val(spark)
+
+            with local_store() as store, tempdir() as cache_dir:
+                model = create_xor_model()
+                optimizer = torch.optim.SGD(model.parameters(), lr=0.1)
+                torch_estimator = hvd_spark.TorchEstimator(
+                    backend=CallbackBackend(),
+                    store=store,
+                    model=model,
+                    optimizer=optimizer,
+                    loss=nn.BCELoss(),
+                    input_shapes=[[2]],
+                    feature_cols=['features'],
+                    label_cols=['y'],
+                    validation='val',
+                    batch_size=1,
+                    epochs=2,
+                    verbose=2,
+                    run_id='disk_cache_run',
+                    disk_cache_path=cache_dir,
+                    disk_cache_size=1024 ** 2)
+
+                with mock.patch.object(LocalDiskCache, '__init__', autospec=True,
+                                       side_effect=recording_init), \
+                        mock.patch.object(LocalDiskCache, 'cleanup', autospec=True,
+                                          side_effect=recording_cleanup):
+                    torch_estimator.fit(df)
+
+                # The train and validation readers have a cache of their own, which
+                # is cleaned up once the reader stops.
+                paths = sorted(entry['path'] for entry in caches.values())
+                assert paths == [os.path.join(cache_dir, 'disk_cache_run_train_0'),
+                                 os.path.join(cache_dir, 'disk_cache_run_val_0')]
+                for entry in caches.values():
+                    assert entry['size_limit'] == 1024 ** 2
+                    assert entry['files'] > 0, 'nothing was cached in %s' % entry['path']
+                    assert not os.path.exists(entry['path'])
+
     def test_calculate_loss_with_sample_weight(self):
         calculate_loss = remote._calculate_loss_fn()
 
@@ -47,6 +47,22 @@ def is_power2(num):
     return num != 0 and ((num & (num -1)) == 0)
 
 def reference_tree_reduction(tensors, hvd_size):
+    if not is_power2(hvd_size):
+        # Ranks are reduced in groups whose sizes are the powers of two that
+        # sum up to the size, largest first, whose results are then combined
+        # in order.
+        answer = None
+        offset = 0
+        for bit in reversed(range(hvd_size.bit_length())):
+            group_size = 1 << bit
+            if hvd_size & group_size:
+                group = reference_tree_reduction(tensors[offset:offset + group_size], group_size)
+                if answer is None:
+                    answer = group
+                else:
+                    answer = [adasum_reference_operation(a, b) for a, b in zip(answer, group)]
+                offset += group_size
+        return answer
     if hvd_size == 1:
         return tensors[0]
     temp = copy.copy(tensors)
@@ -106,10 +122,6 @@ class TensorFlowAdasumTests(tf.test.TestCase):
             self.skipTest("MPI not enabled")
 
         size = hvd.size()
-        # TODO support testing with non-power 2 ranks
-        if not is_power2(size):
-            self.skipTest("MPI rank is not power of 2")
-
         rank = hvd.rank()
         rank_tensors = []
         for _ in range(size):
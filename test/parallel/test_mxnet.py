@@ -104,6 +104,32 @@ class MXTests(unittest.TestCase):
             assert almost_equal(summed.asnumpy(), multiplied.asnumpy(), atol=threshold), \
                 f'hvd.allreduce produces incorrect results: {hvd.rank()} {count} {dtype} {dim}'
 
+    def test_horovod_allreduce_bfloat16(self):
+        """Test that the allreduce correctly sums bfloat16 tensors."""
+        hvd.init()
+        size = hvd.size()
+        if LooseVersion(mx.__version__) < LooseVersion('1.7.0'):
+            self.skipTest("bfloat16 requires MXNet 1.7.0 or newer")
+        if 'CCL_ROOT' in os.environ:
+            self.skipTest("bfloat16 is not supported with oneCCL")
+        # This test does not apply if there are too many workers to sum small
+        # integers exactly in bfloat16.
+        if size > 16:
+            self.skipTest("Too many workers for exact bfloat16 sums")
+        # bfloat16 kernels are only in MXNet's CPU operators.
+        ctx = mx.cpu()
+        shapes = [(17), (17, 17), (17, 17, 17)]
+        for count, shape in enumerate(shapes):
+            mx.random.seed(1234, ctx=ctx)
+            # Small integers are exactly representable in bfloat16, and so are
+            # their sums for the number of ranks tested here.
+            tensor = mx.nd.random.randint(-8, 8, shape=shape, ctx=ctx).astype('float32')
+            summed = hvd.allreduce(mx.nd.amp_cast(tensor, dtype='bfloat16'),
+                                   average=False, name='bfloat16.' + str(count))
+            summed = mx.nd.amp_cast(summed, dtype='float32')
+            assert same(summed.asnumpy(), (tensor * size).asnumpy()), \
+                f'hvd.allreduce produces incorrect results: {hvd.rank()} {count}'
+
     def test_horovod_allreduce_average(self):
         """Test that the allreduce correctly sums 1D, 2D, 3D tensors."""
         hvd.init()
@@ -613,6 +639,45 @@ class MXTests(unittest.TestCase):
                 'hvd.broadcast produces incorrect broadcasted tensor'
             count += 1
 
+    def test_horovod_grouped_broadcast_inplace(self):
+        """Test that the grouped broadcast correctly broadcasts lists of tensors
+           of different shapes and types in-place."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        dtypes = ['int32',   'int64',
+                  'float32', 'float64']
+        ctx = self._current_context()
+        count = 0
+        shapes = [(), (17), (17, 17), (17, 17, 17)]
+        root_ranks = list(range(size))
+        for dtype, root_rank in itertools.product(dtypes, root_ranks):
+            tensors = [(mx.nd.ones(shape, ctx=ctx) * (rank + i)).astype(dtype)
+                       for i, shape in enumerate(shapes)]
+            root_tensors = [(mx.nd.ones(shape, ctx=ctx) * (root_rank + i)).astype(dtype)
+                            for i, shape in enumerate(shapes)]
+            broadcast_tensors = [tensor.copy() for tensor in tensors]
+            outputs = hvd.grouped_broadcast_(broadcast_tensors, root_rank=root_rank,
+                                             name=str(count))
+            assert outputs is broadcast_tensors, \
+                'hvd.grouped_broadcast_ does not return its input tensors'
+            for tensor, broadcast_tensor, root_tensor in zip(tensors, broadcast_tensors,
+                                                             root_tensors):
+                if rank != root_rank:
+                    assert not same(tensor.asnumpy(), root_tensor.asnumpy()), \
+                        'hvd.grouped_broadcast_ modifies source tensor'
+                assert same(broadcast_tensor.asnumpy(), root_tensor.asnumpy()), \
+                    'hvd.grouped_broadcast_ produces incorrect broadcasted tensor'
+            count += 1
+
+        # An empty list is returned as is.
+        assert hvd.grouped_broadcast_([], root_rank=0) == []
+
     def test_horovod_broadcast_parameters(self):
         """Test the correctness of broadcast_parameters."""
         hvd.init()
@@ -767,6 +832,27 @@ class MXTests(unittest.TestCase):
                 assert rank_tensor.min() == i, 'hvd.allgather produces incorrect gathered tensor'
                 assert rank_tensor.max() == i, 'hvd.allgather produces incorrect gathered tensor'
 
+    def test_horovod_reducescatter(self):
+        """Test that the reducescatter correctly sums and scatters 1D, 2D, 3D tensors."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = ['int32',   'int64',
+                  'float32', 'float64']
+        dims = [1, 2, 3]
+        ctx = self._current_context()
+        for dtype, dim in itertools.product(dtypes, dims):
+            tensor = mx.ndarray.ones(shape=[size * 4] + [17] * (dim - 1),
+                                     dtype=dtype, ctx=ctx) * (rank + 1)
+            summed = hvd.reducescatter(tensor, average=False)
+
+            assert list(summed.shape) == [4] + [17] * (dim - 1), \
+                'hvd.reducescatter produces incorrect reduced shape'
+            expected = size * (size + 1) // 2
+            assert summed.min() == expected, 'hvd.reducescatter produces incorrect reduced tensor'
+            assert summed.max() == expected, 'hvd.reducescatter produces incorrect reduced tensor'
+
     def test_horovod_allgather_variable_size(self):
         """Test that the allgather correctly gathers 1D, 2D, 3D tensors,
         even if those tensors have different sizes along the first dim."""
@@ -236,6 +236,24 @@ class TensorFlowTests(tf.test.TestCase):
             diff = self.evaluate(max_difference)
             self.assertTrue(diff <= threshold, "hvd.allreduce produces incorrect results")
 
+    def test_horovod_allreduce_min_max_product_cpu(self):
+        """Test on CPU that the allreduce correctly computes min, max and product."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+        if size > 10:
+            self.skipTest("Horovod cluster too large for an exact product comparison")
+        dtypes = [tf.int32, tf.int64, tf.float32, tf.float64]
+        dims = [1, 2, 3]
+        expected = {hvd.Min: 1, hvd.Max: size, hvd.Product: math.factorial(size)}
+        for dtype, dim, op in itertools.product(dtypes, dims, expected.keys()):
+            with tf.device("/cpu:0"):
+                tensor = tf.fill([17] * dim, tf.constant(rank + 1, dtype=dtype))
+                reduced = hvd.allreduce(tensor, op=op)
+            reduced = self.evaluate(reduced)
+            self.assertTrue(np.all(reduced == expected[op]),
+                            "hvd.allreduce produces incorrect results for op %s" % op)
+
     def test_horovod_allreduce_average_cpu(self):
         """Test on CPU that the allreduce correctly sums 1D, 2D, 3D tensors."""
         hvd.init()
@@ -263,6 +281,34 @@ class TensorFlowTests(tf.test.TestCase):
             diff = self.evaluate(max_difference)
             self.assertTrue(diff <= threshold, "hvd.allreduce produces incorrect results")
 
+    def test_horovod_allreduce_indexed_slices_alltoall(self):
+        """Test on CPU that the alltoall based allreduce of IndexedSlices, which sums
+        duplicate rows on their owner rank, matches a dense allreduce."""
+        hvd.init()
+        size = hvd.size()
+        rank = hvd.rank()
+        os.environ['HOROVOD_SPARSE_ALLREDUCE'] = 'alltoall'
+        try:
+            with tf.device("/cpu:0"):
+                num_rows = 2 * size + 1
+                indices = tf.constant([rank, 2 * rank, rank, num_rows - 1], dtype=tf.int64)
+                values = tf.reshape(tf.range(12, dtype=tf.float32), [4, 3]) + rank
+                slices = tf.IndexedSlices(values, indices,
+                                          dense_shape=tf.constant([num_rows, 3], dtype=tf.int64))
+                reduced = hvd.allreduce(slices, op=hvd.Sum)
+                dense = tf.math.unsorted_segment_sum(reduced.values, reduced.indices, num_rows)
+                expected = hvd.allreduce(tf.math.unsorted_segment_sum(values, indices, num_rows),
+                                         op=hvd.Sum, name='indexed_slices_alltoall_dense')
+                unique_rows = tf.size(reduced.indices)
+                distinct_rows = tf.size(tf.unique(reduced.indices)[0])
+            dense, expected, unique_rows, distinct_rows = self.evaluate(
+                [dense, expected, unique_rows, distinct_rows])
+        finally:
+            del os.environ['HOROVOD_SPARSE_ALLREDUCE']
+        self.assertAllClose(dense, expected)
+        self.assertEqual(unique_rows, distinct_rows,
+                         "hvd.allreduce of IndexedSlices returned duplicate rows")
+
     def test_horovod_allreduce_cpu_fused(self):
         """Test on CPU that the allreduce correctly sums 1D, 2D, 3D tensors
         with Tensor Fusion."""
@@ -295,6 +341,47 @@ class TensorFlowTests(tf.test.TestCase):
         self.assertTrue(self.evaluate(tf.reduce_all(tests)),
                         "hvd.allreduce produces incorrect results")
 
+    def test_horovod_allreduce_cpu_inplace(self):
+        """Test on CPU that allreduce reduces an input no other op reads in
+        place, and allocates an output for an input that is read later."""
+        if not _IS_TF2:
+            self.skipTest("tf.function requires TensorFlow 2")
+        hvd.init()
+        size = hvd.size()
+        pointers = {}
+
+        def record_pointer(key, tensor):
+            def record(value):
+                pointers[key] = value.numpy().ctypes.data
+                return 0
+            return tf.py_function(record, [tensor], tf.int32)
+
+        def reduce(value, keep_input):
+            with tf.device("/cpu:0"):
+                tensor = value * 2.0
+                recorded = record_pointer('input', tensor)
+                with tf.control_dependencies([recorded]):
+                    summed = hvd.allreduce(tensor, op=hvd.Sum,
+                                           name='allreduce_inplace_{}'.format(keep_input))
+                recorded = record_pointer('output', summed)
+                with tf.control_dependencies([recorded]):
+                    summed = tf.identity(summed)
+                if keep_input:
+                    return summed, tensor
+                return summed, None
+
+        value = tf.ones([1024], dtype=tf.float32)
+        for keep_input in [False, True]:
+            pointers.clear()
+            summed, _ = tf.function(lambda v: reduce(v, keep_input))(value)
+            self.assertAllClose(summed.numpy(), np.full([1024], 2.0 * size))
+            if keep_input:
+                self.assertNotEqual(pointers['input'], pointers['output'],
+                                    "hvd.allreduce overwrote an input read by another op")
+            else:
+                self.assertEqual(pointers['input'], pointers['output'],
+                                 "hvd.allreduce did not reduce a dead input in place")
+
     # Note: TF does not support FP64 op attributes so scaling factor is cast to FP32
     # by op and loses precision. We skip FP64 version of pre/postscale tests for this reason.
     # See https://github.com/tensorflow/tensorflow/pull/39452 for PR to resolve this limitation.
@@ -426,6 +513,91 @@ class TensorFlowTests(tf.test.TestCase):
         hvd.remove_process_set(odd_set)
         hvd.remove_process_set(even_set)
 
+    def test_horovod_allreduce_cpu_concurrent_process_sets(self):
+        """Test on CPU that allreduce correctly sums on process sets that run
+        concurrently with HOROVOD_PROCESS_SET_THREADS."""
+        gloo_rank = int(os.getenv('HOROVOD_RANK', -1))
+        if gloo_rank == -1:
+            # Horovod cannot be re-initialized after shutdown when using MPI, so
+            # this test can only be done using the Gloo controller
+            self.skipTest("Gloo is not available")
+
+        hvd.init()
+        size = hvd.size()
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        even_ranks = [rk for rk in range(0, size) if rk % 2 == 0]
+        odd_ranks = [rk for rk in range(0, size) if rk % 2 == 1]
+        even_set = hvd.ProcessSet(even_ranks)
+        odd_set = hvd.ProcessSet(odd_ranks)
+
+        hvd.shutdown()
+        os.environ['HOROVOD_PROCESS_SET_THREADS'] = '2'
+        try:
+            hvd.init(process_sets=[even_set, odd_set])
+            rank = hvd.rank()
+            process_set = even_set if rank in even_ranks else odd_set
+            for dtype in [tf.int32, tf.float32, tf.float64]:
+                with tf.device("/cpu:0"):
+                    tensors = [self.random_uniform([17] * dim, -100, 100, dtype=dtype)
+                               for dim in [1, 2, 3]]
+                    # Global allreduces run on the background thread at the
+                    # same time as those of the process sets.
+                    summed = [hvd.allreduce(t, op=hvd.Sum, process_set=process_set)
+                              for t in tensors]
+                    summed_global = [hvd.allreduce(t, op=hvd.Sum) for t in tensors]
+                    differences = [tf.reduce_max(tf.abs(s - t * process_set.size()))
+                                   for s, t in zip(summed, tensors)]
+                    differences += [tf.reduce_max(tf.abs(s - t * size))
+                                    for s, t in zip(summed_global, tensors)]
+                threshold = 0 if dtype == tf.int32 else 1e-4 * size
+                for diff in self.evaluate(differences):
+                    self.assertTrue(diff <= threshold,
+                                    "hvd.allreduce produces incorrect results")
+        finally:
+            hvd.shutdown()
+            del os.environ['HOROVOD_PROCESS_SET_THREADS']
+            hvd.init()
+
+    def test_horovod_add_process_sets(self):
+        """Test that process sets added in one batch can all be used and removed."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        if hvd.ccl_built():
+            self.skipTest("Multiple process sets currently do not support CCL.")
+
+        rank_lists = [[rk for rk in range(0, size) if rk % 2 == 0],
+                      [rk for rk in range(0, size) if rk % 2 == 1]]
+        if size > 2:
+            rank_lists.append(list(range(1, size)))
+        rank_lists = [ranks for ranks in rank_lists if ranks]
+        process_sets = hvd.add_process_sets(rank_lists)
+        try:
+            self.assertEqual(len(process_sets), len(rank_lists))
+            ids = [process_set.process_set_id for process_set in process_sets]
+            self.assertNotIn(0, ids)
+            self.assertEqual(len(set(ids)), len(ids),
+                             "hvd.add_process_sets returns duplicate process set ids")
+
+            for process_set, ranks in zip(process_sets, rank_lists):
+                self.assertEqual(process_set.included(), rank in ranks)
+                if not process_set.included():
+                    continue
+                self.assertEqual(process_set.size(), len(ranks))
+                self.assertEqual(process_set.rank(), ranks.index(rank))
+                with tf.device("/cpu:0"):
+                    tensor = tf.fill([17, 3], rank + 1)
+                    summed = hvd.allreduce(tensor, op=hvd.Sum, process_set=process_set)
+                expected = sum(ranks) + len(ranks)
+                self.assertTrue(np.all(self.evaluate(summed) == expected),
+                                "hvd.allreduce produces incorrect results on an added process set")
+        finally:
+            for process_set in reversed(process_sets):
+                self.assertTrue(hvd.remove_process_set(process_set),
+                                "hvd.remove_process_set failed")
 
     def test_horovod_allreduce_gpu(self):
         """Test that the allreduce works on GPUs."""
@@ -1425,6 +1597,74 @@ class TensorFlowTests(tf.test.TestCase):
                     "hvd.allgather produces incorrect gathered tensor")
 
 
+    def test_horovod_reducescatter_cpu(self):
+        """Test that the reducescatter correctly sums and scatters 1D, 2D, 3D tensors."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+        dtypes = [tf.int32, tf.int64, tf.float16, tf.float32, tf.float64]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            with tf.device("/cpu:0"):
+                tensor = self.random_uniform(
+                    [size * 4] + [17] * (dim - 1), -100, 100, dtype=dtype)
+                summed = hvd.reducescatter(tensor, op=hvd.Sum)
+            expected = tf.slice(tensor, [rank * 4] + [0] * (dim - 1),
+                                [4] + [-1] * (dim - 1)) * size
+            max_difference = tf.reduce_max(tf.abs(summed - expected))
+
+            # Threshold for floating point equality depends on number of
+            # ranks, since we're comparing against precise multiplication.
+            if size <= 3 or dtype in [tf.int32, tf.int64]:
+                threshold = 0
+            elif size < 10:
+                threshold = 1e-4
+            elif size < 15:
+                threshold = 5e-4
+            else:
+                self.skipTest("Horovod cluster too large for precise multiplication comparison")
+
+            self.assertEqual(list(self.evaluate(tf.shape(summed))),
+                             [4] + [17] * (dim - 1))
+            diff = self.evaluate(max_difference)
+            self.assertTrue(diff <= threshold, "hvd.reducescatter produces incorrect results")
+
+    def test_horovod_reducescatter_average_cpu(self):
+        """Test that the reducescatter correctly averages and scatters 1D, 2D, 3D tensors."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+        dtypes = [tf.float32, tf.float64]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            with tf.device("/cpu:0"):
+                tensor = self.random_uniform(
+                    [size * 4] + [17] * (dim - 1), -100, 100, dtype=dtype)
+                averaged = hvd.reducescatter(tensor, op=hvd.Average)
+            expected = tf.slice(tensor, [rank * 4] + [0] * (dim - 1),
+                                [4] + [-1] * (dim - 1))
+            max_difference = tf.reduce_max(tf.abs(averaged - expected))
+            diff = self.evaluate(max_difference)
+            self.assertTrue(diff <= 1e-4, "hvd.reducescatter produces incorrect results")
+
+    def test_horovod_reducescatter_error(self):
+        """Test that the reducescatter raises an error if the tensor shapes
+        differ among the processes."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        tensor_size = [17] * 3
+        tensor_size[1] = 10 * (rank + 1)
+        with tf.device("/cpu:0"):
+            tensor = tf.ones(tensor_size, dtype=tf.float32) * rank
+            with self.assertRaises(tf.errors.FailedPreconditionError):
+                self.evaluate(hvd.reducescatter(tensor))
+
     def test_horovod_allgather_gpu(self):
         """Test that the allgather correctly gathers 1D, 2D, 3D tensors."""
         # Only do this test if there are GPUs available.
@@ -1889,6 +2129,40 @@ class TensorFlowTests(tf.test.TestCase):
                             "error: %s" %
                             (grad_out, expected, str(err)))
 
+    def test_horovod_reducescatter_grad_cpu(self):
+        """Test the correctness of the reducescatter gradient on CPU."""
+        hvd.init()
+        size = hvd.size()
+
+        # As of TensorFlow v1.9, gradients are not supported on
+        # integer tensors
+        dtypes = [tf.float32, tf.float64]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            with tf.device("/cpu:0"):
+                if _executing_eagerly():
+                    tensor = self.tfe.Variable(self.random_uniform(
+                        [size * 4] + [17] * (dim - 1), -100, 100, dtype=dtype))
+                    with tf.GradientTape() as tape:
+                        summed = hvd.reducescatter(tensor, op=hvd.Sum)
+                else:
+                    tensor = self.random_uniform(
+                        [size * 4] + [17] * (dim - 1), -100, 100, dtype=dtype)
+                    summed = hvd.reducescatter(tensor, op=hvd.Sum)
+
+                grad_ys = tf.ones([4] + [17] * (dim - 1), dtype=dtype)
+                if _executing_eagerly():
+                    grad_out = tape.gradient(summed, tensor, grad_ys)
+                else:
+                    grad = tf.gradients(summed, tensor, grad_ys)[0]
+                    grad_out = self.evaluate(grad)
+
+            expected = np.ones([size * 4] + [17] * (dim - 1))
+            err = np.linalg.norm(expected - grad_out)
+            self.assertLess(err, 0.00000001,
+                            "gradient %s differs from expected %s, "
+                            "error: %s" % (grad_out, expected, str(err)))
+
     def test_horovod_allgather_grad_gpu(self):
         """Test the correctness of the allgather gradient on GPU."""
         # Only do this test if there are GPUs available.
@@ -2336,6 +2610,107 @@ class TensorFlowTests(tf.test.TestCase):
         hvd.remove_process_set(even_set)
 
 
+    def _skip_unless_xla_ops(self):
+        """Skips the test unless Horovod ops compile into XLA clusters on GPU."""
+        if not tf.test.is_gpu_available(cuda_only=True):
+            self.skipTest("No GPUs available")
+        if LooseVersion(tf.__version__) < LooseVersion('2.7.0'):
+            self.skipTest("Horovod XLA ops require TensorFlow 2.7.0 or newer")
+        if int(os.environ.get('HOROVOD_MIXED_INSTALL', 0)):
+            self.skipTest("Not compiled with HOROVOD_GPU_OPERATIONS")
+        hvd.init()
+        with tf.device("/gpu:%d" % hvd.local_rank()):
+            try:
+                tf.function(lambda t: hvd.allreduce(t, name='xla_probe'),
+                            jit_compile=True)(tf.ones([4]))
+            except tf.errors.InvalidArgumentError as e:
+                if 'XLA_GPU_JIT' not in str(e):
+                    raise
+                self.skipTest("Not compiled with HOROVOD_ENABLE_XLA_OPS")
+
+    def test_horovod_allreduce_gpu_xla(self):
+        """Test that the allreduce correctly sums tensors inside an XLA cluster."""
+        self._skip_unless_xla_ops()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        @tf.function(jit_compile=True)
+        def reduce(tensor):
+            tensor = tensor * 2.0
+            summed = hvd.allreduce(tensor, op=hvd.Sum, name='xla_allreduce')
+            averaged = hvd.allreduce(tensor, op=hvd.Average, name='xla_average')
+            return summed + 1.0, averaged
+
+        with tf.device("/gpu:%d" % hvd.local_rank()):
+            tensor = tf.ones([17, 17]) * rank
+            summed, averaged = reduce(tensor)
+        self.assertAllClose(summed.numpy(),
+                            np.full([17, 17], size * (size - 1) + 1.0))
+        self.assertAllClose(averaged.numpy(), np.full([17, 17], size - 1.0))
+
+    def test_horovod_allgather_gpu_xla(self):
+        """Test that the allgather correctly gathers tensors inside an XLA cluster."""
+        self._skip_unless_xla_ops()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        @tf.function(jit_compile=True)
+        def gather(tensor):
+            return hvd.allgather(tensor + 0.0, name='xla_allgather')
+
+        with tf.device("/gpu:%d" % hvd.local_rank()):
+            gathered = gather(tf.ones([2, 3]) * rank)
+        self.assertEqual(gathered.shape, [2 * size, 3])
+        expected = np.repeat(np.arange(size, dtype=np.float32), 2)
+        self.assertAllClose(gathered.numpy(),
+                            np.tile(expected[:, np.newaxis], [1, 3]))
+
+    def test_horovod_broadcast_gpu_xla(self):
+        """Test that the broadcast correctly broadcasts tensors inside an XLA
+        cluster, on the global process set and on non-global ones."""
+        self._skip_unless_xla_ops()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        def broadcast(root_rank, process_set, name):
+            @tf.function(jit_compile=True)
+            def fn(tensor):
+                return hvd.broadcast(tensor + 0.0, root_rank, name=name,
+                                     process_set=process_set)
+            return fn
+
+        with tf.device("/gpu:%d" % hvd.local_rank()):
+            tensor = tf.ones([17, 17]) * rank
+            for root_rank in range(size):
+                result = broadcast(root_rank, hvd.global_process_set,
+                                   'xla_broadcast_%d' % root_rank)(tensor)
+                self.assertAllClose(result.numpy(), np.full([17, 17], root_rank))
+
+        if hvd.ccl_built():
+            return
+        even_ranks = [rk for rk in range(0, size) if rk % 2 == 0]
+        odd_ranks = [rk for rk in range(0, size) if rk % 2 == 1]
+        even_set = hvd.add_process_set(even_ranks)
+        odd_set = hvd.add_process_set(odd_ranks)
+        if rank in even_ranks:
+            set_ranks, this_set = even_ranks, even_set
+        else:
+            set_ranks, this_set = odd_ranks, odd_set
+        try:
+            with tf.device("/gpu:%d" % hvd.local_rank()):
+                for root_rank in set_ranks:
+                    result = broadcast(root_rank, this_set,
+                                       'xla_broadcast_set_%d' % root_rank)(tensor)
+                    self.assertAllClose(result.numpy(),
+                                        np.full([17, 17], root_rank))
+        finally:
+            hvd.remove_process_set(odd_set)
+            hvd.remove_process_set(even_set)
+
     def test_horovod_broadcast_error(self):
         """Test that the broadcast returns an error if any dimension besides
         the first is different among the tensors being broadcasted."""
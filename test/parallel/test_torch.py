@@ -19,6 +19,7 @@ from distutils.version import LooseVersion
 
 import inspect
 import itertools
+import math
 import os
 import platform
 import sys
@@ -80,6 +81,32 @@ class TorchTests(unittest.TestCase):
            types = [t for t in types if t in ccl_supported_types]
         return types
 
+    def train_distributed(self, device, name_prefix, backward_passes_per_step=1, steps=3,
+                          **optimizer_kwargs):
+        """Trains a small model whose last layer gets no gradient with a
+        DistributedOptimizer and returns its parameters. The model starts from
+        the same weights every time, and every rank trains on its own data."""
+        torch.manual_seed(1234)
+        model = torch.nn.ModuleDict({
+            'fc1': torch.nn.Linear(100, 10),
+            'fc2': torch.nn.Linear(10, 10),
+            'unused': torch.nn.Linear(10, 10),
+        }).to(device)
+        optimizer = torch.optim.SGD(model.parameters(), lr=0.1)
+        named_parameters = [(name_prefix + '.' + name, p) for name, p in model.named_parameters()]
+        optimizer = hvd.DistributedOptimizer(optimizer, named_parameters=named_parameters,
+                                             backward_passes_per_step=backward_passes_per_step,
+                                             **optimizer_kwargs)
+        torch.manual_seed(hvd.rank())
+        for _ in range(steps):
+            optimizer.zero_grad()
+            for _ in range(backward_passes_per_step):
+                x = torch.randn(8, 100, device=device)
+                loss = model['fc2'](F.relu(model['fc1'](x))).pow(2).mean()
+                loss.backward()
+            optimizer.step()
+        return [p.detach().cpu().clone() for p in model.parameters()]
+
     def test_gpu_required(self):
         if not torch.cuda.is_available():
             skip_or_fail_gpu_test(self, "No GPUs available")
@@ -151,6 +178,41 @@ class TorchTests(unittest.TestCase):
         else:
             assert gloo_size == size
 
+    def test_horovod_metrics(self):
+        """Test that the performance counters account for completed allreduces."""
+        hvd.init()
+        before = hvd.metrics()
+        tensor = torch.FloatTensor(64).fill_(1)
+        hvd.allreduce(tensor, name='test_horovod_metrics')
+        after = hvd.metrics()
+        assert set(before) == set(after)
+        assert after['allreduce_responses'] > before['allreduce_responses']
+        assert after['allreduce_bytes'] - before['allreduce_bytes'] >= 64 * 4
+        assert after['tensors'] > before['tensors']
+        assert after['cycles'] >= before['cycles']
+        text = hvd.metrics_prometheus()
+        assert 'horovod_allreduce_bytes{rank="%d"}' % hvd.rank() in text
+
+    def test_horovod_step_report(self):
+        """Test that the step report attributes the allreduces of a step."""
+        hvd.init()
+        with self.assertRaises(ValueError):
+            hvd.step_end()
+        hvd.step_begin()
+        for i in range(2):
+            tensor = torch.FloatTensor(64).fill_(1)
+            hvd.allreduce(tensor, name='test_horovod_step_report.%d' % i)
+        report = hvd.step_end(max_critical_tensors=1)
+        assert report['tensors'] == 2
+        assert report['step_time_us'] >= report['compute_end_us']
+        assert report['exposed_communication_us'] <= report['communication_time_us']
+        assert report['exposed_communication_us'] <= report['exposed_time_us']
+        # The last allreduce is waited for right after it is enqueued.
+        assert report['critical_tensors'][0][0] == 'allreduce.test_horovod_step_report.1'
+        assert len(report['critical_tensors']) == 1
+        with self.assertRaises(ValueError):
+            hvd.step_end()
+
     def test_horovod_allreduce(self):
         """Test that the allreduce correctly sums 1D, 2D, 3D tensors."""
         hvd.init()
@@ -184,6 +246,47 @@ class TorchTests(unittest.TestCase):
 
             assert torch.allclose(summed, multiplied, threshold), 'hvd.allreduce produces incorrect results'
 
+    def test_horovod_allreduce_bfloat16(self):
+        """Test that the allreduce correctly sums bfloat16 tensors."""
+        hvd.init()
+        size = hvd.size()
+        dtypes = self.filter_supported_types([torch.BFloat16Tensor])
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.BFloat16Tensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            torch.manual_seed(1234)
+            # Small integers are exactly representable in bfloat16, and so
+            # are their sums for the number of ranks tested here.
+            tensor = torch.FloatTensor(*([17] * dim)).random_(-8, 8)
+            tensor = self.cast_and_place(tensor, dtype)
+            summed = hvd.allreduce(tensor, average=False)
+            multiplied = tensor.float() * size
+            if size > 16:
+                break
+            assert torch.equal(summed.float(), multiplied), 'hvd.allreduce produces incorrect results'
+
+    def test_horovod_allreduce_min_max_product(self):
+        """Test that the allreduce correctly computes min, max and product."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+        if size > 10:
+            self.skipTest("Horovod cluster too large for an exact product comparison")
+        dtypes = self.filter_supported_types([torch.IntTensor, torch.LongTensor,
+                     torch.FloatTensor, torch.DoubleTensor])
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.IntTensor, torch.cuda.LongTensor,
+                       torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        dims = [1, 2, 3]
+        expected = {hvd.Min: 1, hvd.Max: size, hvd.Product: math.factorial(size)}
+        for dtype, dim, op in itertools.product(dtypes, dims, expected.keys()):
+            tensor = torch.FloatTensor(*([17] * dim)).fill_(rank + 1)
+            tensor = self.cast_and_place(tensor, dtype)
+            reduced = hvd.allreduce(tensor, op=op)
+            assert torch.all(reduced == expected[op]), \
+                'hvd.allreduce produces incorrect results for op %s' % op
+
     def test_horovod_allreduce_average(self):
         """Test that the allreduce correctly averages 1D, 2D, 3D tensors."""
         hvd.init()
@@ -248,6 +351,206 @@ class TorchTests(unittest.TestCase):
 
             assert torch.allclose(tensor, multiplied, threshold), 'hvd.allreduce produces incorrect results'
 
+    def test_horovod_allreduce_gradient_arena(self):
+        """Test that in-place allreduces of views of a registered gradient arena
+        are summed correctly, padding included."""
+        hvd.init()
+        size = hvd.size()
+        dtypes = [torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        for dtype in dtypes:
+            torch.manual_seed(1234)
+            arena = self.cast_and_place(torch.zeros(4 * 64), dtype)
+            alignment = 64 * arena.element_size()
+            assert hvd.register_gradient_arena(arena, alignment)
+            assert not hvd.register_gradient_arena(arena[64:], alignment)
+            try:
+                views = [arena[i * 64:i * 64 + 17 + i] for i in range(4)]
+                expected = []
+                for view in views:
+                    view.copy_(torch.FloatTensor(view.numel()).random_(-100, 100))
+                    expected.append(view.clone() * size)
+                handles = [hvd.allreduce_async_(view, op=hvd.Sum,
+                                                name='arena_%d' % i, prescale_factor=2.0,
+                                                postscale_factor=0.5)
+                           for i, view in enumerate(views)]
+                for handle in handles:
+                    hvd.synchronize(handle)
+                for view, multiplied in zip(views, expected):
+                    assert torch.allclose(view, multiplied), \
+                        'hvd.allreduce_ on a gradient arena produces incorrect results'
+            finally:
+                assert hvd.unregister_gradient_arena(arena)
+
+    def test_horovod_allreduce_priority(self):
+        """Test that in-place allreduces with different scheduling priorities,
+        which may also differ between ranks, are summed correctly."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+        dtypes = [torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        for dtype in dtypes:
+            torch.manual_seed(1234)
+            tensors = [self.cast_and_place(torch.FloatTensor(17 + i).random_(-100, 100), dtype)
+                       for i in range(8)]
+            expected = [tensor.clone() * size for tensor in tensors]
+            grouped = [tensor.clone() for tensor in tensors[:2]]
+            handles = [hvd.allreduce_async_(tensor, op=hvd.Sum, name='priority_%d' % i,
+                                            priority=(i + rank) % 3)
+                       for i, tensor in enumerate(tensors)]
+            handles.append(hvd.grouped_allreduce_async_(grouped, op=hvd.Sum,
+                                                        name='priority_grouped', priority=5))
+            for handle in handles:
+                hvd.synchronize(handle)
+            for tensor, multiplied in zip(tensors + grouped, expected + expected[:2]):
+                assert torch.allclose(tensor, multiplied), \
+                    'hvd.allreduce_ with a priority produces incorrect results'
+
+    def test_horovod_allreduce_partitioned(self):
+        """Test that allreduces of tensors larger than HOROVOD_TENSOR_PARTITION_SIZE
+        are reduced correctly in parts."""
+        gloo_rank = int(os.getenv('HOROVOD_RANK', -1))
+        if gloo_rank == -1:
+            # Horovod cannot be re-initialized after shutdown when using MPI, so
+            # this test can only be done using the Gloo controller
+            self.skipTest("Gloo is not available")
+
+        hvd.shutdown()
+        os.environ['HOROVOD_TENSOR_PARTITION_SIZE'] = '1024'
+        try:
+            hvd.init()
+            size = hvd.size()
+            dtypes = [torch.FloatTensor, torch.DoubleTensor]
+            if torch.cuda.is_available():
+                dtypes += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+            for dtype in dtypes:
+                torch.manual_seed(1234)
+                tensors = [self.cast_and_place(torch.FloatTensor(*shape).random_(-100, 100), dtype)
+                           for shape in [(1000,), (17, 33), (3,)]]
+                for step in range(3):
+                    handles = [hvd.allreduce_async(tensor, op=hvd.Sum, name='partitioned_%d' % i)
+                               for i, tensor in enumerate(tensors)]
+                    handles.append(hvd.allreduce_async_(tensors[0].clone(), op=hvd.Sum,
+                                                        name='partitioned_inplace'))
+                    results = [hvd.synchronize(handle) for handle in handles]
+                    for tensor, summed in zip(tensors + tensors[:1], results):
+                        assert summed.shape == tensor.shape
+                        assert torch.allclose(summed, tensor * size), \
+                            'hvd.allreduce of a partitioned tensor produces incorrect results'
+        finally:
+            hvd.shutdown()
+            del os.environ['HOROVOD_TENSOR_PARTITION_SIZE']
+            hvd.init()
+
+    def test_horovod_allreduce_frozen_schedule_divergence(self):
+        """Test that workers leave a frozen response schedule and still produce
+        correct results when one rank stops following it."""
+        gloo_rank = int(os.getenv('HOROVOD_RANK', -1))
+        if gloo_rank == -1:
+            # Horovod cannot be re-initialized after shutdown when using MPI, so
+            # this test can only be done using the Gloo controller
+            self.skipTest("Gloo is not available")
+
+        env = {'HOROVOD_FROZEN_SCHEDULE_STEPS': '2',
+               'HOROVOD_STALL_CHECK_TIME_SECONDS': '1'}
+        hvd.shutdown()
+        os.environ.update(env)
+        try:
+            hvd.init()
+            rank = hvd.rank()
+            size = hvd.size()
+            if size == 1:
+                self.skipTest("Only one worker available")
+
+            tensors = [torch.FloatTensor(16).fill_(i + 1) for i in range(2)]
+
+            def step():
+                handles = [hvd.allreduce_async(tensor, op=hvd.Sum, name='frozen_%d' % i)
+                           for i, tensor in enumerate(tensors)]
+                return [hvd.synchronize(handle) for handle in handles]
+
+            # Enough identical steps to freeze the schedule.
+            for _ in range(6):
+                for tensor, summed in zip(tensors, step()):
+                    assert torch.allclose(summed, tensor * size)
+
+            # Rank 0 submits the second tensor of the step alone, for longer
+            # than the stall check time, and the first one only afterwards.
+            # Without a fallback to regular coordination this never completes.
+            if rank == 0:
+                second = hvd.synchronize(hvd.allreduce_async(
+                    tensors[1], op=hvd.Sum, name='frozen_1'))
+                first = hvd.synchronize(hvd.allreduce_async(
+                    tensors[0], op=hvd.Sum, name='frozen_0'))
+                results = [first, second]
+            else:
+                results = step()
+            for tensor, summed in zip(tensors, results):
+                assert torch.allclose(summed, tensor * size), \
+                    'hvd.allreduce produces incorrect results after leaving the frozen schedule'
+
+            # Workers coordinate as usual again, and refreeze.
+            for _ in range(6):
+                for tensor, summed in zip(tensors, step()):
+                    assert torch.allclose(summed, tensor * size)
+        finally:
+            hvd.shutdown()
+            for key in env:
+                del os.environ[key]
+            hvd.init()
+
+    def test_horovod_grouped_allreduce_fusion_compression_error_feedback(self):
+        """Test that HOROVOD_FUSION_COMPRESSION=fp16_ef sends what the float16
+        conversion rounds away with the next steps."""
+        if not torch.cuda.is_available():
+            self.skipTest("No GPUs available")
+        if int(os.environ.get('HOROVOD_MIXED_INSTALL', 0)):
+            # Skip if compiled with CUDA but without HOROVOD_GPU_OPERATIONS.
+            self.skipTest("Not compiled with HOROVOD_GPU_OPERATIONS")
+        if not hvd.nccl_built():
+            self.skipTest("Fusion compression requires NCCL")
+        gloo_rank = int(os.getenv('HOROVOD_RANK', -1))
+        if gloo_rank == -1:
+            # Horovod cannot be re-initialized after shutdown when using MPI, so
+            # this test can only be done using the Gloo controller
+            self.skipTest("Gloo is not available")
+
+        env = {'HOROVOD_FUSION_COMPRESSION': 'fp16_ef'}
+        hvd.shutdown()
+        os.environ.update(env)
+        try:
+            hvd.init()
+            size = hvd.size()
+            device = torch.device('cuda', hvd.local_rank())
+
+            # A quarter of the smallest float16, which rounds to zero on its
+            # own. With error feedback, every fourth step sends the smallest
+            # float16 instead, so the sum over the steps is exact.
+            smallest = 2.0 ** -24
+            value = smallest / 4
+            steps = 16
+            tensors = [torch.full((17,), value, dtype=torch.float32, device=device),
+                       torch.full((5, 3), value, dtype=torch.float32, device=device)]
+            totals = [torch.zeros_like(tensor, dtype=torch.float64) for tensor in tensors]
+            for _ in range(steps):
+                summed = hvd.grouped_allreduce(tensors, op=hvd.Sum, name='fusion_compression_ef')
+                for total, tensor in zip(totals, summed):
+                    total += tensor.double()
+
+            expected = value * size * steps
+            for total in totals:
+                assert total.min().item() > 0, 'the rounding error was not fed back'
+                assert (total - expected).abs().max().item() <= size * smallest, \
+                    'hvd.grouped_allreduce with error feedback produces incorrect results'
+        finally:
+            hvd.shutdown()
+            for key in env:
+                del os.environ[key]
+            hvd.init()
+
     def test_horovod_allreduce_async_fused(self):
         """Test that the allreduce correctly sums 1D, 2D, 3D tensors
         with Tensor Fusion."""
@@ -294,6 +597,27 @@ class TorchTests(unittest.TestCase):
 
             assert torch.allclose(summed, multiplied, threshold), 'hvd.allreduce produces incorrect results'
 
+    def test_horovod_synchronize_all(self):
+        """Test that synchronize_all waits for a batch of asynchronous allreduces and
+        returns their results in the order of the handles."""
+        hvd.init()
+        size = hvd.size()
+        dtypes = [torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        for dtype in dtypes:
+            torch.manual_seed(1234)
+            tensors = [self.cast_and_place(torch.FloatTensor(17 + i).random_(-100, 100), dtype)
+                       for i in range(16)]
+            handles = [hvd.allreduce_async(tensor, op=hvd.Sum) for tensor in tensors]
+            results = hvd.synchronize_all(list(reversed(handles)))
+            for tensor, summed in zip(reversed(tensors), results):
+                assert torch.allclose(summed, tensor * size), \
+                    'hvd.synchronize_all produces incorrect results'
+            # The handles have been released.
+            with self.assertRaises(ValueError):
+                hvd.poll(handles[0])
+
     def test_horovod_allreduce_multi_gpu(self):
         """Test that the allreduce works on multiple GPUs."""
         # Only do this test if there are GPUs available.
@@ -444,6 +768,79 @@ class TorchTests(unittest.TestCase):
 
             assert torch.allclose(summed, multiplied, threshold), 'hvd.allreduce produces incorrect results'
 
+    def _skip_unless_capturable_allreduce(self):
+        if not torch.cuda.is_available():
+            self.skipTest("No GPUs available")
+        if int(os.environ.get('HOROVOD_MIXED_INSTALL', 0)):
+            # Skip if compiled with CUDA but without HOROVOD_GPU_OPERATIONS.
+            self.skipTest("Not compiled with HOROVOD_GPU_OPERATIONS")
+        hvd.init()
+        if not hvd.nccl_built():
+            self.skipTest("Capturable allreduces require NCCL")
+        torch.cuda.set_device(hvd.local_rank())
+        hvd.init_capturable_allreduce()
+
+    def test_horovod_capturable_allreduce(self):
+        """Test that capturable_allreduce_ matches allreduce for Sum, Average,
+        prescaling and postscaling."""
+        self._skip_unless_capturable_allreduce()
+        rank = hvd.rank()
+        device = torch.device('cuda', hvd.local_rank())
+
+        dtypes = [torch.float16, torch.float32, torch.float64]
+        cases = [(hvd.Sum, 1.0, 1.0), (hvd.Average, 1.0, 1.0),
+                 (hvd.Sum, 0.5, 1.0), (hvd.Sum, 1.0, 0.25),
+                 (hvd.Average, 0.5, 2.0)]
+        for dtype, (op, prescale_factor, postscale_factor) in itertools.product(dtypes, cases):
+            torch.manual_seed(1234 + rank)
+            tensors = [torch.randint(-100, 100, [17] * dim, device=device).to(dtype)
+                       for dim in [1, 2, 3]]
+            expected = [hvd.allreduce(t, op=op, prescale_factor=prescale_factor,
+                                      postscale_factor=postscale_factor)
+                        for t in tensors]
+            reduced = [t.clone() for t in tensors]
+            result = hvd.capturable_allreduce_(reduced, op=op,
+                                               prescale_factor=prescale_factor,
+                                               postscale_factor=postscale_factor)
+            assert result is reduced, 'hvd.capturable_allreduce_ does not return its inputs'
+            torch.cuda.current_stream().synchronize()
+            rtol = 1e-3 if dtype == torch.float16 else 1e-5
+            for r, e in zip(reduced, expected):
+                assert torch.allclose(r, e, rtol=rtol), \
+                    'hvd.capturable_allreduce_ produces incorrect results'
+
+    def test_horovod_capturable_allreduce_cuda_graph(self):
+        """Test that capturable_allreduce_ can be captured and replayed with
+        torch.cuda.graph."""
+        self._skip_unless_capturable_allreduce()
+        if hvd.nccl_built() < 20906:
+            self.skipTest("Capturing NCCL allreduces requires NCCL 2.9.6 or later")
+        if not hasattr(torch.cuda, 'graph'):
+            self.skipTest("torch.cuda.graph is not available")
+        rank = hvd.rank()
+        size = hvd.size()
+        device = torch.device('cuda', hvd.local_rank())
+
+        static = torch.zeros(1024, device=device)
+        # Warm up on a side stream before capturing, as torch.cuda.graph requires.
+        stream = torch.cuda.Stream()
+        stream.wait_stream(torch.cuda.current_stream())
+        with torch.cuda.stream(stream):
+            hvd.capturable_allreduce_(static, op=hvd.Sum)
+        torch.cuda.current_stream().wait_stream(stream)
+
+        graph = torch.cuda.CUDAGraph()
+        with torch.cuda.graph(graph):
+            hvd.capturable_allreduce_(static, op=hvd.Sum, postscale_factor=2.0)
+
+        for step in range(3):
+            static.fill_(float(rank + step))
+            graph.replay()
+            torch.cuda.synchronize()
+            expected = 2.0 * sum(r + step for r in range(size))
+            assert torch.all(static == expected), \
+                'replayed hvd.capturable_allreduce_ produces incorrect results'
+
     def test_horovod_allreduce_error(self):
         """Test that the allreduce raises an error if different ranks try to
         send tensors of different rank or dimension."""
@@ -534,6 +931,74 @@ class TorchTests(unittest.TestCase):
         except (torch.FatalError, RuntimeError):
             pass
 
+    def test_horovod_collectives_gpu_staged_on_cpu(self):
+        """Test that allreduce and allgather of GPU tensors that are performed on
+        the CPU produce correct results on the GPU, and reuse their pinned host
+        staging buffers across calls."""
+        # Only do this test if there are GPUs available.
+        if not torch.cuda.is_available():
+            self.skipTest("No GPUs available")
+
+        if not int(os.environ.get('HOROVOD_MIXED_INSTALL', 0)):
+            # GPU tensors are only staged on the host without HOROVOD_GPU_OPERATIONS.
+            self.skipTest("Compiled with HOROVOD_GPU_OPERATIONS")
+
+        hvd.init()
+        local_rank = hvd.local_rank()
+        rank = hvd.rank()
+        size = hvd.size()
+        device = torch.device('cuda', local_rank)
+
+        def run_collectives(dtype):
+            torch.manual_seed(1234)
+            tensors = [torch.randint(-100, 100, shape, device=device).to(dtype)
+                       for shape in [(17,), (5, 3), (2, 3, 4)]]
+            summed = hvd.allreduce(tensors[0], op=hvd.Sum, name='staged_allreduce')
+            assert summed.device == device
+            assert torch.allclose(summed, tensors[0] * size), \
+                'hvd.allreduce of a staged GPU tensor produces incorrect results'
+
+            averaged = hvd.grouped_allreduce(tensors, op=hvd.Average,
+                                             name='staged_grouped_allreduce')
+            for tensor, result in zip(tensors, averaged):
+                assert result.device == device
+                assert torch.allclose(result, tensor), \
+                    'hvd.grouped_allreduce of staged GPU tensors produces incorrect results'
+
+            inplace = tensors[1].clone()
+            hvd.allreduce_(inplace, op=hvd.Sum, name='staged_allreduce_inplace')
+            assert torch.allclose(inplace, tensors[1] * size), \
+                'hvd.allreduce_ of a staged GPU tensor produces incorrect results'
+
+            # Ranks gather a different number of rows each.
+            rows = torch.ones(rank + 1, 3, device=device).to(dtype) * rank
+            gathered = hvd.allgather(rows, name='staged_allgather')
+            assert gathered.device == device
+            assert list(gathered.shape) == [size * (size + 1) // 2, 3]
+            expected = torch.cat([torch.ones(r + 1, 3, device=device).to(dtype) * r
+                                  for r in range(size)])
+            assert torch.equal(gathered, expected), \
+                'hvd.allgather of a staged GPU tensor produces incorrect results'
+
+        dtypes = [torch.float32, torch.float64, torch.int32, torch.int64]
+        for dtype in dtypes:
+            run_collectives(dtype)
+
+        # The staging buffers come from PyTorch's caching host allocator, so
+        # repeating the same collectives allocates no new pinned memory.
+        if not hasattr(torch.cuda, 'host_memory_stats'):
+            return
+        torch.cuda.synchronize()
+        allocs = torch.cuda.host_memory_stats().get('num_host_alloc')
+        if allocs is None:
+            return
+        for _ in range(3):
+            for dtype in dtypes:
+                run_collectives(dtype)
+        torch.cuda.synchronize()
+        assert torch.cuda.host_memory_stats()['num_host_alloc'] == allocs, \
+            'staging buffers of GPU tensors were not reused'
+
     def test_horovod_allreduce_duplicate_name_error(self):
         """Test that the allreduce raises an error if there are
         two concurrent operations with the same name."""
@@ -848,6 +1313,25 @@ class TorchTests(unittest.TestCase):
                 assert rank_tensor.data.min() == i
                 assert rank_tensor.data.max() == i
 
+    def test_horovod_allgather_variable_size_cached(self):
+        """Test that a named allgather whose first dimension changes between
+        steps gathers the current sizes when its response is cached."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        for step in range(5):
+            tensor_sizes = [(r + step) % 4 + 1 for r in range(size)]
+            tensor = torch.FloatTensor(tensor_sizes[rank], 3).fill_(1).mul_(rank)
+            gathered = hvd.allgather(tensor, name='allgather_variable_size_cached')
+
+            assert list(gathered.shape) == [sum(tensor_sizes), 3]
+            for i in range(size):
+                rank_tensor = gathered[sum(tensor_sizes[:i]):sum(tensor_sizes[:i + 1])]
+                assert rank_tensor.shape[0] == tensor_sizes[i]
+                assert rank_tensor.data.min() == i
+                assert rank_tensor.data.max() == i
+
     def test_horovod_allgather_async_fused(self):
         """Test that the allgather correctly gathers 1D, 2D, 3D tensors
         with Tensor Fusion."""
@@ -889,6 +1373,52 @@ class TorchTests(unittest.TestCase):
                 assert rank_tensor.data.min() == i, 'hvd.allgather produces incorrect gathered tensor'
                 assert rank_tensor.data.max() == i, 'hvd.allgather produces incorrect gathered tensor'
 
+    def test_horovod_allgather_output(self):
+        """Test that the allgather into a preallocated output returns that output,
+        holding the result of an allgather without it, alone and fused."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = [torch.IntTensor, torch.LongTensor, torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.IntTensor, torch.cuda.FloatTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            tensor = torch.FloatTensor(*([rank + 1] + [5] * (dim - 1))).random_(-100, 100)
+            tensor = self.cast_and_place(tensor, dtype)
+            expected = hvd.allgather(tensor)
+            output = tensor.new_zeros(expected.shape)
+            gathered = hvd.synchronize(hvd.allgather_async(tensor, output=output))
+            assert gathered is output, 'hvd.allgather_async does not return its output'
+            assert torch.equal(output, expected), \
+                'hvd.allgather_async produces incorrect results into its output'
+
+        # Several allgathers at once are fused and copied out into the outputs.
+        tensors = [torch.FloatTensor(rank + 1, 3).fill_(i) for i in range(4)]
+        outputs = [torch.zeros(size * (size + 1) // 2, 3) for _ in tensors]
+        handles = [hvd.allgather_async(t, output=o) for t, o in zip(tensors, outputs)]
+        for i, (handle, output) in enumerate(zip(handles, outputs)):
+            assert hvd.synchronize(handle) is output, \
+                'hvd.allgather_async does not return its output'
+            assert torch.equal(output, torch.full_like(output, i)), \
+                'hvd.allgather_async produces incorrect fused results into its output'
+
+    def test_horovod_allgather_output_shape_error(self):
+        """Test that the allgather raises an error if the preallocated output
+        does not have the shape of the result."""
+        hvd.init()
+        size = hvd.size()
+
+        tensor = torch.FloatTensor(4, 3).fill_(1)
+        for shape in [[4 * size + 1, 3], [4 * size, 2]]:
+            output = torch.zeros(*shape)
+            try:
+                hvd.synchronize(hvd.allgather_async(tensor, output=output))
+                assert False, 'hvd.allgather_async did not throw output shape error'
+            except (torch.FatalError, RuntimeError, ValueError):
+                pass
+
     def test_horovod_allgather_error(self):
         """Test that the allgather returns an error if any dimension besides
         the first is different among the tensors being gathered."""
@@ -996,6 +1526,394 @@ class TorchTests(unittest.TestCase):
                             "gradient %s differs from expected %s, "
                             "error: %s" % (grad_out, expected, str(err)))
 
+    def test_horovod_grouped_allgather(self):
+        """Test that the grouped allgather correctly gathers a list of tensors."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = [torch.ByteTensor, torch.CharTensor, torch.ShortTensor,
+                  torch.IntTensor, torch.LongTensor, torch.FloatTensor, torch.DoubleTensor,
+                  torch.HalfTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.ByteTensor, torch.cuda.CharTensor, torch.cuda.ShortTensor,
+                       torch.cuda.IntTensor, torch.cuda.LongTensor,
+                       torch.cuda.FloatTensor, torch.cuda.DoubleTensor,
+                       torch.cuda.HalfTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            # The first dimension differs between the tensors of the group
+            # and between the ranks.
+            tensors = [self.cast_and_place(
+                torch.FloatTensor(*([rank + i + 1] + [17] * (dim - 1))).fill_(1).mul_(rank),
+                dtype) for i in range(5)]
+            gathered = hvd.grouped_allgather(tensors)
+            tensors, gathered = zip(*[self.convert_cpu_fp16_to_fp32(t, g)
+                                      for t, g in zip(tensors, gathered)])
+
+            for i, (tensor, gathered_tensor) in enumerate(zip(tensors, gathered)):
+                assert list(gathered_tensor.shape) == \
+                    [sum(r + i + 1 for r in range(size))] + [17] * (dim - 1)
+                offset = 0
+                for r in range(size):
+                    rank_tensor = gathered_tensor[offset:offset + r + i + 1]
+                    offset += r + i + 1
+                    assert list(rank_tensor.shape) == [r + i + 1] + [17] * (dim - 1), \
+                        'hvd.grouped_allgather produces incorrect gathered shape'
+                    assert rank_tensor.data.min() == r, \
+                        'hvd.grouped_allgather produces incorrect gathered tensor'
+                    assert rank_tensor.data.max() == r, \
+                        'hvd.grouped_allgather produces incorrect gathered tensor'
+
+    def test_horovod_grouped_allgather_grad(self):
+        """Test the correctness of the grouped allgather gradient."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # Only Tensors of floating point dtype can require gradients
+        dtypes = [torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor, torch.cuda.HalfTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            tensors = [self.cast_and_place(
+                torch.FloatTensor(*([rank + i + 1] + [17] * (dim - 1))).fill_(1).mul_(rank),
+                dtype) for i in range(5)]
+            for tensor in tensors:
+                tensor.requires_grad_()
+
+            grad_ys = []
+            for i in range(5):
+                grad_list = [self.cast_and_place(
+                    torch.ones([r + i + 1] + [17] * (dim - 1)), dtype) * r
+                    for r in range(size)]
+                grad_ys.append(torch.cat(grad_list, dim=0))
+
+            gathered = hvd.grouped_allgather(tensors)
+            torch.autograd.backward(gathered, grad_ys)
+
+            for i, tensor in enumerate(tensors):
+                grad_out = tensor.grad.data.cpu().numpy()
+                expected = np.ones([rank + i + 1] + [17] * (dim - 1)) * rank
+                err = np.linalg.norm(expected - grad_out)
+                self.assertLess(err, 0.00000001,
+                                "gradient %s differs from expected %s, "
+                                "error: %s" % (grad_out, expected, str(err)))
+
+    def test_horovod_reducescatter(self):
+        """Test that the reducescatter correctly sums and scatters 1D, 2D, 3D tensors."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = self.filter_supported_types([torch.IntTensor, torch.LongTensor,
+                                              torch.FloatTensor, torch.DoubleTensor])
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.IntTensor, torch.cuda.LongTensor,
+                       torch.cuda.FloatTensor, torch.cuda.DoubleTensor,
+                       torch.cuda.HalfTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            torch.manual_seed(1234)
+            tensor = torch.FloatTensor(*([size * 4] + [17] * (dim - 1))).random_(-100, 100)
+            tensor = self.cast_and_place(tensor, dtype)
+            summed = hvd.reducescatter(tensor, op=hvd.Sum)
+            expected = tensor[rank * 4:(rank + 1) * 4] * size
+            summed, expected = self.convert_cpu_fp16_to_fp32(summed, expected)
+            max_difference = summed.data.sub(expected).max()
+
+            # Threshold for floating point equality depends on number of
+            # ranks, since we're comparing against precise multiplication.
+            if size <= 3 or dtype in [torch.IntTensor, torch.LongTensor,
+                                      torch.cuda.IntTensor, torch.cuda.LongTensor]:
+                threshold = 0
+            elif size < 10:
+                threshold = 1e-4
+            elif size < 15:
+                threshold = 5e-4
+            else:
+                break
+
+            assert list(summed.shape) == [4] + [17] * (dim - 1), \
+                'hvd.reducescatter produces incorrect reduced shape'
+            assert max_difference <= threshold, 'hvd.reducescatter produces incorrect results'
+
+    def test_horovod_reducescatter_average(self):
+        """Test that the reducescatter correctly averages and scatters 1D, 2D, 3D tensors."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = self.filter_supported_types([torch.FloatTensor, torch.DoubleTensor])
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            torch.manual_seed(1234)
+            tensor = torch.FloatTensor(*([size * 4] + [17] * (dim - 1))).random_(-100, 100)
+            tensor = self.cast_and_place(tensor, dtype)
+            averaged = hvd.reducescatter(tensor, op=hvd.Average)
+            expected = tensor[rank * 4:(rank + 1) * 4]
+            max_difference = averaged.data.sub(expected).max()
+
+            assert list(averaged.shape) == [4] + [17] * (dim - 1), \
+                'hvd.reducescatter produces incorrect reduced shape'
+            assert max_difference <= 1e-4, 'hvd.reducescatter produces incorrect results'
+
+    def test_horovod_reducescatter_uneven(self):
+        """Test that the reducescatter gives the lower ranks one extra slice
+        when the first dimension is not divisible by the number of ranks."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        first_dim = size * 2 + 1
+        tensor = torch.FloatTensor(first_dim, 17).fill_(1).mul_(rank + 1)
+        summed = hvd.reducescatter(tensor, op=hvd.Sum)
+
+        expected_dim = 3 if rank < first_dim % size else 2
+        if size == 1:
+            expected_dim = first_dim
+        assert list(summed.shape) == [expected_dim, 17], \
+            'hvd.reducescatter produces incorrect reduced shape'
+        expected_value = size * (size + 1) // 2
+        assert summed.data.min() == expected_value, 'hvd.reducescatter produces incorrect results'
+        assert summed.data.max() == expected_value, 'hvd.reducescatter produces incorrect results'
+
+    def test_horovod_reducescatter_error(self):
+        """Test that the reducescatter raises an error if the tensor shapes
+        differ among the processes."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        tensor_size = [17] * 3
+        tensor_size[1] = 10 * (rank + 1)
+        tensor = torch.FloatTensor(*tensor_size).fill_(1).mul_(rank)
+
+        try:
+            hvd.reducescatter(tensor)
+            assert False, 'hvd.reducescatter did not throw error'
+        except (torch.FatalError, RuntimeError):
+            pass
+
+    def test_horovod_reducescatter_grad(self):
+        """Test the correctness of the reducescatter gradient."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # Only Tensors of floating point dtype can require gradients
+        dtypes = [torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            torch.manual_seed(1234)
+            tensor = torch.FloatTensor(*([size * 4] + [17] * (dim - 1))).random_(-100, 100)
+            tensor = self.cast_and_place(tensor, dtype)
+            tensor.requires_grad_()
+            summed = hvd.reducescatter(tensor, op=hvd.Sum)
+
+            grad_shape = [4] + [17] * (dim - 1)
+            summed.backward(self.cast_and_place(torch.ones(grad_shape), dtype))
+            grad_out = tensor.grad.data.cpu().numpy()
+
+            expected = np.ones([size * 4] + [17] * (dim - 1))
+            err = np.linalg.norm(expected - grad_out)
+            self.assertLess(err, 0.00000001,
+                            "gradient %s differs from expected %s, "
+                            "error: %s" % (grad_out, expected, str(err)))
+
+    def test_horovod_reduce(self):
+        """Test that the reduce correctly sums 1D, 2D, 3D tensors into the root only."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = self.filter_supported_types([torch.IntTensor, torch.LongTensor,
+                                              torch.FloatTensor, torch.DoubleTensor])
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.IntTensor, torch.cuda.LongTensor,
+                       torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        dims = [1, 2, 3]
+        root_ranks = list(range(size))
+        for dtype, dim, root_rank in itertools.product(dtypes, dims, root_ranks):
+            torch.manual_seed(1234)
+            tensor = torch.FloatTensor(*([17] * dim)).random_(-100, 100)
+            tensor = self.cast_and_place(tensor, dtype)
+            reduced = hvd.reduce(tensor, root_rank, op=hvd.Sum)
+            if rank == root_rank:
+                assert torch.equal(reduced, tensor * size), 'hvd.reduce produces incorrect results'
+            else:
+                assert reduced is tensor, 'hvd.reduce modifies the input of non-root ranks'
+
+    def test_horovod_gather(self):
+        """Test that the gather concatenates tensors of varying first dimension on the root."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        dtypes = [torch.ByteTensor, torch.CharTensor, torch.ShortTensor,
+                  torch.IntTensor, torch.LongTensor, torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.IntTensor, torch.cuda.FloatTensor]
+        dims = [1, 2, 3]
+        root_ranks = list(range(size))
+        for dtype, dim, root_rank in itertools.product(dtypes, dims, root_ranks):
+            tensor = torch.FloatTensor(*([rank + 1] + [17] * (dim - 1))).fill_(1).mul_(rank)
+            tensor = self.cast_and_place(tensor, dtype)
+            gathered = hvd.gather(tensor, root_rank)
+            if rank != root_rank:
+                assert gathered.shape[0] == 0, 'hvd.gather produces output on non-root ranks'
+                continue
+            assert list(gathered.shape) == [size * (size + 1) // 2] + [17] * (dim - 1)
+            offset = 0
+            for i in range(size):
+                rank_tensor = gathered[offset:offset + i + 1]
+                assert rank_tensor.data.min() == i, 'hvd.gather produces incorrect gathered tensor'
+                assert rank_tensor.data.max() == i, 'hvd.gather produces incorrect gathered tensor'
+                offset += i + 1
+
+    def test_horovod_send_recv_ring(self):
+        """Test that every rank receives the tensor of its predecessor in a ring."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        if not hvd.mpi_enabled():
+            self.skipTest("Send and receive require the MPI controller")
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        dtypes = [torch.IntTensor, torch.LongTensor, torch.FloatTensor, torch.DoubleTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            tensor = self.cast_and_place(torch.FloatTensor(*([17] * dim)).fill_(rank), dtype)
+            received = self.cast_and_place(torch.FloatTensor(*([17] * dim)).fill_(-1), dtype)
+            recv_handle = hvd.recv_async(received, (rank - 1) % size)
+            send_handle = hvd.send_async(tensor, (rank + 1) % size)
+            hvd.synchronize(send_handle)
+            output = hvd.synchronize(recv_handle)
+            assert output is received, 'hvd.recv_async does not receive in-place'
+            assert torch.equal(received, tensor.new_full(tensor.shape, (rank - 1) % size)), \
+                'hvd.recv produces incorrect results'
+            assert torch.equal(tensor, tensor.new_full(tensor.shape, rank)), \
+                'hvd.send modifies its input'
+
+    def test_horovod_send_recv_pair(self):
+        """Test that two ranks sending to each other at the same time both receive."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        if not hvd.mpi_enabled():
+            self.skipTest("Send and receive require the MPI controller")
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+        if rank > 1:
+            return
+
+        peer = 1 - rank
+        tensor = torch.FloatTensor(3, 5).fill_(rank + 1)
+        received = torch.zeros(3, 5)
+        recv_handle = hvd.recv_async(received, peer, name='pair')
+        hvd.send(tensor, peer, name='pair')
+        hvd.synchronize(recv_handle)
+        assert torch.equal(received, torch.FloatTensor(3, 5).fill_(peer + 1)), \
+            'hvd.recv produces incorrect results'
+
+    def test_horovod_send_recv_ordered(self):
+        """Test that several messages to the same peer are received in the order they were sent."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        if not hvd.mpi_enabled():
+            self.skipTest("Send and receive require the MPI controller")
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        num_messages = 5
+        if rank == 0:
+            handles = [hvd.send_async(torch.FloatTensor(7).fill_(i), 1)
+                       for i in range(num_messages)]
+            for handle in handles:
+                hvd.synchronize(handle)
+        elif rank == 1:
+            received = [torch.zeros(7) for _ in range(num_messages)]
+            handles = [hvd.recv_async(tensor, 0) for tensor in received]
+            for i, handle in enumerate(handles):
+                output = hvd.synchronize(handle)
+                assert torch.equal(output, torch.FloatTensor(7).fill_(i)), \
+                    'hvd.recv_async receives messages out of order'
+            # Blocking receives are matched in order as well.
+            for i in range(num_messages):
+                hvd.send(torch.FloatTensor(7).fill_(i), 0)
+        if rank == 0:
+            for i in range(num_messages):
+                output = hvd.recv(torch.zeros(7), 1)
+                assert torch.equal(output, torch.FloatTensor(7).fill_(i)), \
+                    'hvd.recv receives messages out of order'
+
+    def test_horovod_send_recv_rank_error(self):
+        """Test that sends and receives with an invalid peer rank raise an error."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        if not hvd.mpi_enabled():
+            self.skipTest("Send and receive require the MPI controller")
+
+        tensor = torch.FloatTensor(4).fill_(1)
+        for peer in [-1, size, rank]:
+            try:
+                hvd.send(tensor, peer)
+                assert False, 'hvd.send did not throw rank error'
+            except (ValueError, RuntimeError, torch.FatalError):
+                pass
+            try:
+                hvd.recv(tensor, peer)
+                assert False, 'hvd.recv did not throw rank error'
+            except (ValueError, RuntimeError, torch.FatalError):
+                pass
+
+    def test_horovod_send_recv_gpu(self):
+        """Test that CUDA tensors are sent and received, staged through host memory if needed."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        if not hvd.mpi_enabled():
+            self.skipTest("Send and receive require the MPI controller")
+        if not torch.cuda.is_available():
+            self.skipTest("No GPUs available")
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        local_rank = hvd.local_rank()
+        dtypes = [torch.cuda.IntTensor, torch.cuda.FloatTensor, torch.cuda.DoubleTensor]
+        for dtype in dtypes:
+            tensor = torch.FloatTensor(17, 3).fill_(rank).type(dtype).cuda(local_rank)
+            received = torch.FloatTensor(17, 3).fill_(-1).type(dtype).cuda(local_rank)
+            recv_handle = hvd.recv_async(received, (rank - 1) % size)
+            send_handle = hvd.send_async(tensor, (rank + 1) % size)
+            hvd.synchronize(send_handle)
+            output = hvd.synchronize(recv_handle)
+            assert output.is_cuda and output.device == received.device, \
+                'hvd.recv_async moves the output off its device'
+            expected = torch.FloatTensor(17, 3).fill_((rank - 1) % size).type(dtype).cuda(local_rank)
+            assert torch.equal(output, expected), 'hvd.recv produces incorrect results on GPU'
+
     def test_horovod_broadcast(self):
         """Test that the broadcast correctly broadcasts 1D, 2D, 3D tensors."""
         hvd.init()
@@ -1063,6 +1981,54 @@ class TorchTests(unittest.TestCase):
             assert (broadcasted_tensor == root_tensor).min() == 1, \
                 'hvd.broadcast produces incorrect broadcasted tensor'
 
+    def test_horovod_grouped_broadcast_inplace(self):
+        """Test that the grouped broadcast correctly broadcasts a list of
+        tensors of different types and shapes in place."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        dtypes = [torch.ByteTensor, torch.IntTensor, torch.LongTensor,
+                  torch.FloatTensor, torch.DoubleTensor, torch.HalfTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.ByteTensor, torch.cuda.IntTensor, torch.cuda.LongTensor,
+                       torch.cuda.FloatTensor, torch.cuda.DoubleTensor,
+                       torch.cuda.HalfTensor]
+        root_ranks = list(range(size))
+        for dtype, root_rank in itertools.product(dtypes, root_ranks):
+            dims = [1, 2, 3, 1, 2]
+            tensors = [self.cast_and_place(
+                torch.FloatTensor(*([17] * dim)).fill_(1).mul_(rank), dtype) for dim in dims]
+            root_tensors = [self.cast_and_place(
+                torch.FloatTensor(*([17] * dim)).fill_(1).mul_(root_rank), dtype) for dim in dims]
+            broadcasted_tensors = hvd.grouped_broadcast_(tensors, root_rank)
+            for tensor, root_tensor, broadcasted_tensor in \
+                    zip(tensors, root_tensors, broadcasted_tensors):
+                tensor, root_tensor, broadcasted_tensor = \
+                    self.convert_cpu_fp16_to_fp32(tensor, root_tensor, broadcasted_tensor)
+                assert (tensor == broadcasted_tensor).min() == 1, \
+                    'hvd.grouped_broadcast_ does not modify source tensor'
+                assert (broadcasted_tensor == root_tensor).min() == 1, \
+                    'hvd.grouped_broadcast_ produces incorrect broadcasted tensor'
+
+            # The out of place variant leaves the inputs alone.
+            tensors = [self.cast_and_place(
+                torch.FloatTensor(*([17] * dim)).fill_(1).mul_(rank), dtype) for dim in dims]
+            broadcasted_tensors = hvd.grouped_broadcast(tensors, root_rank)
+            for tensor, root_tensor, broadcasted_tensor in \
+                    zip(tensors, root_tensors, broadcasted_tensors):
+                tensor, root_tensor, broadcasted_tensor = \
+                    self.convert_cpu_fp16_to_fp32(tensor, root_tensor, broadcasted_tensor)
+                if rank != root_rank:
+                    assert (tensor == broadcasted_tensor).max() == 0, \
+                        'hvd.grouped_broadcast modifies source tensor'
+                assert (broadcasted_tensor == root_tensor).min() == 1, \
+                    'hvd.grouped_broadcast produces incorrect broadcasted tensor'
+
     def test_horovod_broadcast_error(self):
         """Test that the broadcast returns an error if any dimension besides
         the first is different among the tensors being broadcasted."""
@@ -1179,6 +2145,42 @@ class TorchTests(unittest.TestCase):
                             "gradient %s differs from expected %s, "
                             "error: %s" % (grad_out, expected, str(err)))
 
+    def test_horovod_grouped_broadcast_grad(self):
+        """Test the correctness of the grouped broadcast gradient."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        # Only Tensors of floating point dtype can require gradients
+        dtypes = [torch.FloatTensor, torch.DoubleTensor]
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor, torch.cuda.HalfTensor]
+        dims = [1, 2, 3]
+        root_ranks = list(range(size))
+        for dtype, root_rank in itertools.product(dtypes, root_ranks):
+            tensors = [self.cast_and_place(
+                torch.FloatTensor(*([17] * dim)).fill_(1).mul_(rank), dtype) for dim in dims]
+            for tensor in tensors:
+                tensor.requires_grad_()
+
+            broadcasted_tensors = hvd.grouped_broadcast(tensors, root_rank)
+            torch.autograd.backward(
+                broadcasted_tensors,
+                [self.cast_and_place(torch.ones([17] * dim), dtype) for dim in dims])
+
+            c = 1 if rank == root_rank else 0
+            for tensor, dim in zip(tensors, dims):
+                grad_out = tensor.grad.data.cpu().numpy()
+                expected = np.ones([17] * dim) * c
+                err = np.linalg.norm(expected - grad_out)
+                self.assertLess(err, 0.00000001,
+                                "gradient %s differs from expected %s, "
+                                "error: %s" % (grad_out, expected, str(err)))
+
     def test_horovod_alltoall(self):
         """Test that the alltoall correctly distributes 1D, 2D, and 3D tensors."""
         hvd.init()
@@ -1219,6 +2221,66 @@ class TorchTests(unittest.TestCase):
             self.assertSequenceEqual(received_splits.tolist(), [rk + 1 for rk in range(size)],
                                      "hvd.alltoall returned incorrect received_splits")
 
+    def test_horovod_alltoall_recv_splits(self):
+        """Test that the alltoall with known receive splits, which are then not exchanged,
+        produces the same results as the one that exchanges them."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # This test does not apply if NCCL version < 2.7.0
+        if hvd.nccl_built() and hvd.nccl_built() < 2700:
+            self.skipTest("NCCL-based Alltoall requires NCCL version >= 2.7.0.")
+
+        dtypes = self.filter_supported_types([torch.IntTensor, torch.LongTensor,
+                                              torch.FloatTensor, torch.DoubleTensor])
+        if torch.cuda.is_available():
+            dtypes += [torch.cuda.IntTensor, torch.cuda.FloatTensor]
+        dims = [1, 2, 3]
+        for dtype, dim in itertools.product(dtypes, dims):
+            # Rank r sends r + i + 1 rows to rank i, so it receives i + r + 1 rows from rank i.
+            splits = [rank + i + 1 for i in range(size)]
+            recv_splits = [i + rank + 1 for i in range(size)]
+            tensor = torch.FloatTensor(*([sum(splits)] + [4] * (dim - 1))).random_(-100, 100)
+            tensor = self.cast_and_place(tensor, dtype)
+            expected, expected_splits = hvd.alltoall(tensor, splits)
+            collected, received_splits = hvd.alltoall(tensor, splits, recv_splits=recv_splits)
+            assert torch.equal(collected, expected), \
+                'hvd.alltoall with recv_splits produces incorrect collected tensor'
+            self.assertSequenceEqual(received_splits.tolist(), expected_splits.tolist(),
+                                     "hvd.alltoall with recv_splits returned incorrect received_splits")
+
+        # Several alltoalls with known receive splits are fused.
+        splits = [rank + 1] * size
+        recv_splits = [i + 1 for i in range(size)]
+        tensors = [torch.FloatTensor(sum(splits), 3).fill_(rank * 10 + n) for n in range(4)]
+        handles = [hvd.alltoall_async(t, splits, recv_splits=recv_splits) for t in tensors]
+        for n, handle in enumerate(handles):
+            collected, received_splits = hvd.synchronize(handle)
+            expected = torch.cat([torch.FloatTensor(i + 1, 3).fill_(i * 10 + n) for i in range(size)])
+            assert torch.equal(collected, expected), \
+                'hvd.alltoall_async with recv_splits produces incorrect fused results'
+            self.assertSequenceEqual(received_splits.tolist(), recv_splits)
+
+    def test_horovod_alltoall_recv_splits_error(self):
+        """Test that the alltoall returns an error if the receive splits do not have one
+        32-bit integer per worker."""
+        hvd.init()
+        size = hvd.size()
+
+        # This test does not apply if NCCL version < 2.7.0
+        if hvd.nccl_built() and hvd.nccl_built() < 2700:
+            self.skipTest("NCCL-based Alltoall requires NCCL version >= 2.7.0.")
+
+        tensor = torch.ones(size, 3)
+        splits = torch.ones(size, dtype=torch.int32)
+        for recv_splits in [[1] * (size + 1), torch.ones(size, dtype=torch.int64)]:
+            try:
+                hvd.alltoall(tensor, splits, recv_splits=recv_splits)
+                assert False, 'hvd.alltoall did not throw recv_splits error'
+            except (torch.FatalError, ValueError):
+                pass
+
     def test_horovod_alltoall_equal_split(self):
         """Test that the alltoall correctly distributes 1D tensors with default splitting."""
         hvd.init()
@@ -1297,6 +2359,71 @@ class TorchTests(unittest.TestCase):
             self.assertSequenceEqual(received_splits.tolist(), [rk + 1 for rk in range(size)],
                                      "hvd.alltoall returned incorrect received_splits")
 
+    def test_horovod_grouped_alltoall(self):
+        """Test that the grouped alltoall distributes tensors of different types, shapes
+        and splits in a single fused exchange."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # This test does not apply if NCCL version < 2.7.0
+        if hvd.nccl_built() and hvd.nccl_built() < 2700:
+            self.skipTest("NCCL-based Alltoall requires NCCL version >= 2.7.0.")
+
+        devices = ['cpu']
+        if torch.cuda.is_available():
+            devices.append('cuda')
+        for device in devices:
+            # Rank r sends r + 1 tokens with 3 features, one routing weight and one
+            # expert index to every rank.
+            tokens = torch.full(((rank + 1) * size, 3), float(rank), device=device)
+            weights = torch.full(((rank + 1) * size,), float(rank), dtype=torch.float64,
+                                 device=device)
+            indices = torch.full(((rank + 1) * size,), rank, dtype=torch.int64, device=device)
+            # Equal split, every rank receives size rows from every rank.
+            equal = torch.full((size * size, 2), rank, dtype=torch.int32, device=device)
+            splits = [torch.tensor([rank + 1] * size, dtype=torch.int32)] * 3 + [None]
+
+            outputs, received_splits = hvd.grouped_alltoall(
+                [tokens, weights, indices, equal], splits)
+
+            expected_splits = [rk + 1 for rk in range(size)]
+            expected = torch.cat([torch.full((rk + 1,), float(rk)) for rk in range(size)])
+            self.assertEqual(list(outputs[0].shape), [sum(expected_splits), 3])
+            self.assertTrue(torch.equal(outputs[0].cpu(), expected.unsqueeze(1).repeat(1, 3)))
+            self.assertTrue(torch.equal(outputs[1].cpu(), expected.double()))
+            self.assertTrue(torch.equal(outputs[2].cpu(), expected.long()))
+            self.assertEqual(outputs[1].dtype, torch.float64)
+            self.assertEqual(outputs[2].dtype, torch.int64)
+            expected_equal = torch.cat([torch.full((size, 2), rk, dtype=torch.int32)
+                                        for rk in range(size)])
+            self.assertTrue(torch.equal(outputs[3].cpu(), expected_equal))
+            for received in received_splits[:3]:
+                self.assertSequenceEqual(received.tolist(), expected_splits,
+                                         "hvd.grouped_alltoall returned incorrect received_splits")
+            self.assertSequenceEqual(received_splits[3].tolist(), [size] * size)
+
+    def test_horovod_grouped_alltoall_grad(self):
+        """Test the correctness of the grouped alltoall gradient."""
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # This test does not apply if NCCL version < 2.7.0
+        if hvd.nccl_built() and hvd.nccl_built() < 2700:
+            self.skipTest("NCCL-based Alltoall requires NCCL version >= 2.7.0.")
+
+        tensors = [torch.full(((rank + 1) * size, 2), float(rank), requires_grad=True),
+                   torch.full(((rank + 1) * size,), float(rank), dtype=torch.float64,
+                              requires_grad=True)]
+        splits = [torch.tensor([rank + 1] * size, dtype=torch.int32)] * 2
+        outputs, _ = hvd.grouped_alltoall(tensors, splits)
+
+        sum(output.sum() for output in outputs).backward()
+        for tensor in tensors:
+            self.assertTrue(torch.equal(tensor.grad, torch.ones_like(tensor)),
+                            "gradient of hvd.grouped_alltoall is incorrect")
+
     def test_horovod_alltoall_type_error(self):
         """Test that the alltoall returns an error if the tensor types differ
            across the processes."""
@@ -1857,6 +2984,62 @@ class TorchTests(unittest.TestCase):
             loss.backward()
             optimizer.step()
 
+    def test_accumulate_in_horovod(self):
+        """Test that gradients accumulated by Horovod over several backward passes
+        give the same parameters as gradients accumulated by PyTorch."""
+        hvd.init()
+        size = hvd.size()
+
+        if not torch.cuda.is_available():
+            self.skipTest("No GPUs available")
+        from horovod.torch.optimizer import _accumulation_supported
+        if not _accumulation_supported():
+            self.skipTest("Not compiled with CUDA and HOROVOD_GPU_OPERATIONS")
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        device = torch.device('cuda', hvd.local_rank())
+        for op, passes in itertools.product([hvd.Average, hvd.Sum], [2, 3]):
+            prefix = 'accumulate.%s.%d' % (op, passes)
+            expected = self.train_distributed(device, prefix + '.framework',
+                                              backward_passes_per_step=passes, op=op)
+            params = self.train_distributed(device, prefix + '.horovod',
+                                            backward_passes_per_step=passes, op=op,
+                                            accumulate_in_horovod=True)
+            for p, e in zip(params, expected):
+                assert torch.allclose(p, e, rtol=1e-5, atol=1e-6), \
+                    'accumulate_in_horovod produces different parameters'
+
+    def test_bucketed_allreduce(self):
+        """Test that gradients allreduced in buckets give the same parameters as
+        gradients allreduced one by one, also with partly filled buckets and
+        parameters that get no gradient."""
+        hvd.init()
+        size = hvd.size()
+
+        # This test does not apply if there is only one worker.
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        devices = [torch.device('cpu')]
+        if torch.cuda.is_available():
+            devices.append(torch.device('cuda', hvd.local_rank()))
+        # The parameters take 4.8KB, the largest 3.9KB: buckets of 1KB and 5KB
+        # split them unevenly, one of 1MB takes all of them.
+        bucket_caps_mb = [1024 / 2 ** 20, 5 * 1024 / 2 ** 20, 1]
+        for device, (i, bucket_cap_mb) in itertools.product(devices, enumerate(bucket_caps_mb)):
+            for passes in [1, 2]:
+                prefix = 'bucketed.%s.%d.%d' % (device.type, i, passes)
+                expected = self.train_distributed(device, prefix + '.unbucketed',
+                                                  backward_passes_per_step=passes)
+                params = self.train_distributed(device, prefix + '.bucketed',
+                                                backward_passes_per_step=passes,
+                                                bucket_cap_mb=bucket_cap_mb)
+                for p, e in zip(params, expected):
+                    assert torch.allclose(p, e, rtol=1e-5, atol=1e-6), \
+                        'bucket_cap_mb=%s produces different parameters' % bucket_cap_mb
+
     def test_model_parallelism(self):
         """Test that tensors on different GPUs are supported."""
         # Only do this test if there are GPUs available.
@@ -2123,6 +3306,140 @@ class TorchTests(unittest.TestCase):
         except ValueError:
             pass
 
+    def test_horovod_memory_usage_release_buffers(self):
+        """Test that the buffers kept after fused allreduces are reported and freed,
+        and that collectives still work after they were freed."""
+        hvd.init()
+        size = hvd.size()
+
+        def fused_allreduces():
+            tensors = [torch.FloatTensor(1024).fill_(i) for i in range(8)]
+            handles = [hvd.allreduce_async(t, op=hvd.Sum) for t in tensors]
+            for i, handle in enumerate(handles):
+                summed = hvd.synchronize(handle)
+                assert torch.equal(summed, torch.FloatTensor(1024).fill_(i * size)), \
+                    'hvd.allreduce produces incorrect results'
+
+        fused_allreduces()
+        usage = hvd.memory_usage()
+        for (device, category), num_bytes in usage.items():
+            assert isinstance(device, int) and isinstance(category, str)
+            assert num_bytes >= 0
+        used = sum(usage.values())
+        assert used > 0, 'hvd.memory_usage reports no buffers after allreduces'
+
+        hvd.release_buffers()
+        released = sum(hvd.memory_usage().values())
+        assert released < used, \
+            'hvd.release_buffers does not free buffers: %d bytes before, %d after' % (used, released)
+
+        # Buffers are allocated again by the next operations.
+        fused_allreduces()
+        gathered = hvd.allgather(torch.FloatTensor(2, 3).fill_(hvd.rank()))
+        assert list(gathered.shape) == [2 * size, 3]
+        assert sum(hvd.memory_usage().values()) > 0
+
+    def test_horovod_barrier(self):
+        """Test that no rank leaves the barrier before the last rank has entered it."""
+        hvd.init()
+        rank = hvd.rank()
+
+        hvd.barrier()
+        start = time.time()
+        if rank == 0:
+            time.sleep(0.2)
+        hvd.barrier()
+        assert time.time() - start >= 0.2, 'hvd.barrier returns before all ranks entered'
+
+    def test_horovod_capturable_allreduce_process_set(self):
+        """Test that the capturable allreduce of a process set only sums over its ranks."""
+        if not torch.cuda.is_available() or not hvd.nccl_built():
+            self.skipTest("Capturable allreduces require CUDA and NCCL")
+        gloo_rank = int(os.getenv('HOROVOD_RANK', -1))
+        if gloo_rank == -1:
+            # Horovod cannot be re-initialized after shutdown when using MPI, so
+            # this test can only be done using the Gloo controller
+            self.skipTest("Gloo is not available")
+
+        hvd.init()
+        size = hvd.size()
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        from horovod.common.process_sets import ProcessSet
+        even_ranks = [rk for rk in range(0, size) if rk % 2 == 0]
+        odd_ranks = [rk for rk in range(0, size) if rk % 2 == 1]
+        even_set = ProcessSet(even_ranks)
+        odd_set = ProcessSet(odd_ranks)
+
+        hvd.shutdown()
+        try:
+            hvd.init(process_sets=[even_set, odd_set])
+            rank = hvd.rank()
+            torch.cuda.set_device(hvd.local_rank())
+            hvd.init_capturable_allreduce(even_set)
+            hvd.init_capturable_allreduce(odd_set)
+            process_set = even_set if rank in even_ranks else odd_set
+            tensor = torch.full([17], float(rank), device='cuda')
+            hvd.capturable_allreduce_(tensor, op=hvd.Sum, process_set=process_set)
+            averaged = torch.full([17], float(rank), device='cuda')
+            hvd.capturable_allreduce_(averaged, process_set=process_set)
+            torch.cuda.synchronize()
+            expected = float(sum(process_set.ranks))
+            assert torch.all(tensor == expected), \
+                'hvd.capturable_allreduce_ produces incorrect results'
+            assert torch.allclose(averaged, torch.full_like(averaged, expected / len(process_set.ranks))), \
+                'hvd.capturable_allreduce_ averages over the wrong number of ranks'
+        finally:
+            hvd.shutdown()
+            hvd.init()
+
+    def test_horovod_add_process_sets(self):
+        """Test that process sets added in one batch can all be used and removed."""
+        gloo_rank = int(os.getenv('HOROVOD_RANK', -1))
+        if gloo_rank == -1:
+            # Horovod cannot be re-initialized after shutdown when using MPI, so
+            # this test can only be done using the Gloo controller
+            self.skipTest("Gloo is not available")
+
+        hvd.init()
+        size = hvd.size()
+        if size == 1:
+            self.skipTest("Only one worker available")
+
+        from horovod.common.process_sets import add_process_sets, remove_process_set
+        hvd.shutdown()
+        os.environ['HOROVOD_DYNAMIC_PROCESS_SETS'] = '1'
+        try:
+            hvd.init()
+            rank = hvd.rank()
+            rank_lists = [[rk for rk in range(0, size) if rk % 2 == 0],
+                          [rk for rk in range(0, size) if rk % 2 == 1]]
+            if size > 2:
+                rank_lists.append(list(range(1, size)))
+            process_sets = add_process_sets(rank_lists)
+            assert len(process_sets) == len(rank_lists)
+            ids = [process_set.process_set_id for process_set in process_sets]
+            assert 0 not in ids and len(set(ids)) == len(ids), \
+                'hvd.add_process_sets returns invalid process set ids %s' % ids
+
+            for process_set, ranks in zip(process_sets, rank_lists):
+                assert process_set.included() == (rank in ranks)
+                if not process_set.included():
+                    continue
+                assert process_set.size() == len(ranks)
+                assert process_set.rank() == ranks.index(rank)
+                hvd.barrier(process_set=process_set)
+
+            # Sets must be removed by all processes, also those outside of them.
+            for process_set in reversed(process_sets):
+                assert remove_process_set(process_set), 'hvd.remove_process_set failed'
+            hvd.barrier()
+        finally:
+            hvd.shutdown()
+            del os.environ['HOROVOD_DYNAMIC_PROCESS_SETS']
+            hvd.init()
+
     def test_horovod_join_allreduce(self):
         """Test Join op with allreduce."""
         hvd.init()
@@ -2298,6 +3615,48 @@ class TorchTests(unittest.TestCase):
             assert torch.allclose(hvd.allreduce(sync_bn.bias.grad, name='sync_bn.bias.grad'), bn.bias.grad, 1e-6)
             assert torch.allclose(hvd.allreduce(ts1.grad, name='ts1.grad'), ts2.grad, 1e-6)
 
+    def test_horovod_sync_batch_norm_uneven_batches(self):
+        """Tests Horovod SyncBatchNorm when the ranks have different batch sizes."""
+        if not torch.cuda.is_available():
+            self.skipTest("No GPUs available")
+
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+        device = torch.device('cuda', hvd.local_rank())
+
+        # rank r holds r + 1 samples of the global batch
+        batch_sizes = [r + 1 for r in range(size)]
+        offset = sum(batch_sizes[:rank])
+        batch_size = batch_sizes[rank]
+
+        torch.manual_seed(1234)
+        ts = torch.randn(sum(batch_sizes), 4, 3).to(device)
+        # the sum of the outputs has no gradient w.r.t. the input, so weigh them
+        loss_weights = torch.randn(sum(batch_sizes), 4, 3).to(device)
+
+        sync_bn = hvd.SyncBatchNorm(num_features=4).to(device)
+        bn = torch.nn.BatchNorm1d(num_features=4).to(device)
+
+        ts1 = ts[offset:offset + batch_size].clone().requires_grad_()
+        ts2 = ts.clone().requires_grad_()
+
+        # Training
+        sync_bn_out = sync_bn(ts1)
+        bn_out = bn(ts2)
+        assert torch.allclose(sync_bn_out, bn_out[offset:offset + batch_size], rtol=1e-4, atol=1e-5)
+        assert torch.allclose(sync_bn.running_mean, bn.running_mean, rtol=1e-4, atol=1e-5)
+        assert torch.allclose(sync_bn.running_var, bn.running_var, rtol=1e-4, atol=1e-5)
+
+        # Gradients
+        (sync_bn_out * loss_weights[offset:offset + batch_size]).sum().backward()
+        (bn_out * loss_weights).sum().backward()
+        weight_grad = hvd.allreduce(sync_bn.weight.grad, op=hvd.Sum, name='sync_bn_uneven.weight.grad')
+        bias_grad = hvd.allreduce(sync_bn.bias.grad, op=hvd.Sum, name='sync_bn_uneven.bias.grad')
+        assert torch.allclose(weight_grad, bn.weight.grad, rtol=1e-4, atol=1e-5)
+        assert torch.allclose(bias_grad, bn.bias.grad, rtol=1e-4, atol=1e-5)
+        assert torch.allclose(ts1.grad, ts2.grad[offset:offset + batch_size], rtol=1e-4, atol=1e-5)
+
     @pytest.mark.skip(reason='https://github.com/horovod/horovod/issues/2496')
     def test_timeline_api(self):
         hvd.init()
@@ -2442,6 +3801,32 @@ class TorchTests(unittest.TestCase):
         for reduced, gathered in zip(allreduced_tensors, allgathered_tensors):
             assert torch.allclose(reduced, gathered.to_dense(), 1e-6)
 
+    def test_async_sparse_allreduce_alltoall(self):
+        """Test that the alltoall based sparse allreduce is equivalent to allreduce
+        and returns every row once."""
+        hvd.init()
+
+        def random_sparse_tensor(*shape):
+            t = torch.rand(*shape)
+            t[t < 0.8] = 0
+            return t.to_sparse()
+
+        tensor_sizes = [17, 32, 81, 12, 15, 23, 22] * 5
+        tensors = [random_sparse_tensor(d0, 10) for d0 in tensor_sizes]
+        allreduced_tensors = [hvd.allreduce(t.to_dense()) for t in tensors]
+
+        os.environ['HOROVOD_SPARSE_ALLREDUCE'] = 'alltoall'
+        try:
+            handles = [hvd.sparse_allreduce_async(t, op=hvd.Average, name='alltoall.' + str(i))
+                       for i, t in enumerate(tensors)]
+            reduced_tensors = [handle() for handle in handles]
+        finally:
+            del os.environ['HOROVOD_SPARSE_ALLREDUCE']
+
+        for reduced, sparse in zip(allreduced_tensors, reduced_tensors):
+            assert torch.allclose(reduced, sparse.to_dense(), 1e-6)
+            assert sparse._nnz() == sparse.coalesce()._nnz()
+
 
 
 if __name__ == "__main__":
@@ -33,13 +33,14 @@ from mock import MagicMock
 
 import horovod
 from horovod.runner import _HorovodArgs
-from horovod.runner.common.util import config_parser, hosts, safe_shell_exec, secret, \
+from horovod.runner.common.util import codec, config_parser, hosts, safe_shell_exec, secret, \
     settings as hvd_settings, timeout
 from horovod.runner.common.util.host_hash import _hash, host_hash
 from horovod.runner.common.util.hosts import SlotInfo, get_host_assignments, parse_hosts
+from horovod.runner.driver import driver_service
 from horovod.runner.gloo_run import gloo_run
 from horovod.runner.js_run import js_run, generate_jsrun_rankfile
-from horovod.runner.launch import gloo_built, parse_args, run_controller, _run
+from horovod.runner.launch import gloo_built, parse_args, run_controller, _run, _run_static
 from horovod.runner.mpi_run import _get_mpi_implementation, _get_mpi_implementation_flags, \
     _LARGE_CLUSTER_THRESHOLD as large_cluster_threshold, mpi_available, mpi_run, \
     _OMPI_IMPL, _SMPI_IMPL, _MPICH_IMPL, _IMPI_IMPL, _UNKNOWN_IMPL, _MISSING_IMPL
@@ -47,7 +48,7 @@ from horovod.runner.util.threads import in_thread, on_event
 
 sys.path.append(os.path.join(os.path.dirname(__file__), os.pardir, 'utils'))
 
-from common import is_built, lsf_and_jsrun, override_args, override_env, temppath, delay, wait
+from common import is_built, lsf_and_jsrun, override_args, override_env, tempdir, temppath, delay, wait
 
 
 class RunTests(unittest.TestCase):
@@ -64,8 +65,10 @@ class RunTests(unittest.TestCase):
                            '--fusion-threshold-mb', '10',
                            '--cycle-time-ms', '20',
                            '--cache-capacity', '512',
+                           '--cache-max-capacity', '4096',
                            '--hierarchical-allreduce',
-                           '--hierarchical-allgather'):
+                           '--hierarchical-allgather',
+                           '--hierarchical-alltoall'):
             args = parse_args()
             env = {}
             config_parser.set_env_from_args(env, args)
@@ -73,13 +76,16 @@ class RunTests(unittest.TestCase):
             self.assertEqual(env.get(config_parser.HOROVOD_FUSION_THRESHOLD), str(10 * 1024 * 1024))
             self.assertEqual(env.get(config_parser.HOROVOD_CYCLE_TIME), '20.0')
             self.assertEqual(env.get(config_parser.HOROVOD_CACHE_CAPACITY), '512')
+            self.assertEqual(env.get(config_parser.HOROVOD_CACHE_MAX_CAPACITY), '4096')
             self.assertEqual(env.get(config_parser.HOROVOD_HIERARCHICAL_ALLREDUCE), '1')
             self.assertEqual(env.get(config_parser.HOROVOD_HIERARCHICAL_ALLGATHER), '1')
+            self.assertEqual(env.get(config_parser.HOROVOD_HIERARCHICAL_ALLTOALL), '1')
 
     def test_autotune_args(self):
         with override_args('horovodrun', '-np', '2',
                            '--autotune',
                            '--autotune-log-file', '/tmp/autotune.txt',
+                           '--autotune-cache-file', '/tmp/autotune_cache.csv',
                            '--autotune-warmup-samples', '1',
                            '--autotune-steps-per-sample', '5',
                            '--autotune-bayes-opt-max-samples', '10',
@@ -90,6 +96,7 @@ class RunTests(unittest.TestCase):
 
             self.assertEqual(env.get(config_parser.HOROVOD_AUTOTUNE), '1')
             self.assertEqual(env.get(config_parser.HOROVOD_AUTOTUNE_LOG), '/tmp/autotune.txt')
+            self.assertEqual(env.get(config_parser.HOROVOD_AUTOTUNE_CACHE), '/tmp/autotune_cache.csv')
             self.assertEqual(env.get(config_parser.HOROVOD_AUTOTUNE_WARMUP_SAMPLES), '1')
             self.assertEqual(env.get(config_parser.HOROVOD_AUTOTUNE_STEPS_PER_SAMPLE), '5')
             self.assertEqual(env.get(config_parser.HOROVOD_AUTOTUNE_BAYES_OPT_MAX_SAMPLES), '10')
@@ -113,13 +120,19 @@ class RunTests(unittest.TestCase):
     def test_timeline_args(self):
         with override_args('horovodrun', '-np', '2',
                            '--timeline-filename', '/tmp/timeline.json',
-                           '--timeline-mark-cycles'):
+                           '--timeline-mark-cycles',
+                           '--timeline-format', 'binary',
+                           '--timeline-sample-cycles', '10',
+                           '--timeline-all-ranks'):
             args = parse_args()
             env = {}
             config_parser.set_env_from_args(env, args)
 
             self.assertEqual(env.get(config_parser.HOROVOD_TIMELINE), '/tmp/timeline.json')
             self.assertEqual(env.get(config_parser.HOROVOD_TIMELINE_MARK_CYCLES), '1')
+            self.assertEqual(env.get(config_parser.HOROVOD_TIMELINE_FORMAT), 'binary')
+            self.assertEqual(env.get(config_parser.HOROVOD_TIMELINE_SAMPLE_CYCLES), '10')
+            self.assertEqual(env.get(config_parser.HOROVOD_TIMELINE_ALL_RANKS), '1')
 
     def test_stall_check_args(self):
         with override_args('horovodrun', '-np', '2',
@@ -146,7 +159,9 @@ class RunTests(unittest.TestCase):
                            '--mpi-threads-disable',
                            '--num-nccl-streams', '2',
                            '--thread-affinity', '1',
-                           '--gloo-timeout-seconds', '60'):
+                           '--gloo-timeout-seconds', '60',
+                           '--gloo-local-transport', 'loopback',
+                           '--gloo-cross-transport', 'ibverbs'):
             args = parse_args()
             env = {}
             config_parser.set_env_from_args(env, args)
@@ -155,6 +170,8 @@ class RunTests(unittest.TestCase):
             self.assertEqual(env.get(config_parser.HOROVOD_NUM_NCCL_STREAMS), '2')
             self.assertEqual(env.get(config_parser.HOROVOD_THREAD_AFFINITY), '1')
             self.assertEqual(env.get(config_parser.HOROVOD_GLOO_TIMEOUT_SECONDS), '60')
+            self.assertEqual(env.get(config_parser.HOROVOD_GLOO_LOCAL_TRANSPORT), 'loopback')
+            self.assertEqual(env.get(config_parser.HOROVOD_GLOO_CROSS_TRANSPORT), 'ibverbs')
 
     def test_library_env_override(self):
         """Tests that environment variables override arg defaults."""
@@ -190,12 +207,14 @@ class RunTests(unittest.TestCase):
             self.assertEqual(args.fusion_threshold_mb, 32)
             self.assertEqual(args.cycle_time_ms, 10)
             self.assertEqual(args.cache_capacity, 2048)
+            self.assertEqual(args.cache_max_capacity, 8192)
             self.assertTrue(args.hierarchical_allreduce)
             self.assertTrue(args.hierarchical_allgather)
 
             # Autotune
             self.assertTrue(args.autotune)
             self.assertEqual(args.autotune_log_file, 'horovod_autotune_log.txt')
+            self.assertEqual(args.autotune_cache_file, 'horovod_autotune_cache.csv')
             self.assertEqual(args.autotune_warmup_samples, 5)
             self.assertEqual(args.autotune_steps_per_sample, 20)
             self.assertEqual(args.autotune_bayes_opt_max_samples, 50)
@@ -204,6 +223,9 @@ class RunTests(unittest.TestCase):
             # Timeline
             self.assertEqual(args.timeline_filename, 'horovod_timeline.json')
             self.assertTrue(args.timeline_mark_cycles)
+            self.assertEqual(args.timeline_format, 'json')
+            self.assertEqual(args.timeline_sample_cycles, 1)
+            self.assertFalse(args.timeline_all_ranks)
 
             # Stall Check
             self.assertFalse(args.no_stall_check)
@@ -215,6 +237,8 @@ class RunTests(unittest.TestCase):
             self.assertEqual(args.num_nccl_streams, 2)
             self.assertEqual(args.thread_affinity, 1)
             self.assertEqual(args.gloo_timeout_seconds, 60)
+            self.assertEqual(args.gloo_local_transport, 'tcp')
+            self.assertEqual(args.gloo_cross_transport, 'tcp')
 
             # Logging
             self.assertEqual(args.log_level, 'INFO')
@@ -1042,6 +1066,160 @@ class RunTests(unittest.TestCase):
             hostnames = hosts.parse_host_files(host_filename)
             self.assertEqual(hostnames, '172.31.32.7:8,172.31.33.9:8')
 
+    def test_ssh_launch_fanout_args(self):
+        with override_args('horovodrun', '-np', '2', 'python', 'train.py'):
+            args = parse_args()
+            self.assertEqual(args.ssh_launch_fanout, 0)
+
+        with override_args('horovodrun', '-np', '2',
+                           '--ssh-launch-fanout', '3',
+                           'python', 'train.py'):
+            args = parse_args()
+            self.assertEqual(args.ssh_launch_fanout, 3)
+
+    def test_split_subtrees(self):
+        hosts = [(index, 'host-{}'.format(index)) for index in range(7)]
+
+        self.assertEqual(driver_service._split_subtrees(hosts, 1), [hosts])
+        self.assertEqual(driver_service._split_subtrees(hosts, 2), [hosts[:3], hosts[3:]])
+        self.assertEqual(driver_service._split_subtrees(hosts, 3), [hosts[:2], hosts[2:4], hosts[4:]])
+        self.assertEqual(driver_service._split_subtrees(hosts, 7), [[host] for host in hosts])
+        self.assertEqual(driver_service._split_subtrees(hosts, 10), [[host] for host in hosts])
+        self.assertEqual(driver_service._split_subtrees([], 2), [])
+
+    """
+    Launches the task servers with the given fanout and follows the launch
+    tree the way the task function does. Returns the hosts launched over ssh
+    by each launcher (None being the driver), and the indices launched locally.
+    """
+    def _launch_tree(self, all_host_names, local_host_names, fanout):
+        settings = hvd_settings.Settings(verbose=0, key=secret.make_secret_key(),
+                                         launch_fanout=fanout)
+        driver_addresses = {'lo': [('127.0.0.1', 12345)]}
+
+        def remote_command(command, host, port, identity_file):
+            return 'ssh {} {}'.format(host, command)
+
+        def decode(command):
+            args = command.split(' horovod.runner.task_fn ')[1].split(' ')
+            index = codec.loads_base64(args[0])
+            subtree = codec.loads_base64(args[4]) if len(args) > 4 else []
+            return index, subtree
+
+        launched = {}
+        local = []
+        with mock.patch('horovod.runner.driver.driver_service.get_remote_command',
+                        side_effect=remote_command), \
+                mock.patch('horovod.runner.driver.driver_service.threads.execute_function_multithreaded') as execute:
+            driver_service._launch_task_servers(all_host_names, local_host_names,
+                                                driver_addresses, settings)
+            execute.assert_called_once()
+            self.assertEqual(execute.call_args[0][0], driver_service._exec_command)
+
+            pending = [(None, execute.call_args[0][1])]
+            while pending:
+                launcher, args_list = pending.pop()
+                for [command] in args_list:
+                    if not command.startswith('ssh '):
+                        self.assertIsNone(launcher)
+                        index, subtree = decode(command)
+                        self.assertEqual(subtree, [])
+                        local.append(index)
+                        continue
+
+                    host = command.split(' ')[1]
+                    index, subtree = decode(command)
+                    self.assertEqual(all_host_names[index], host)
+                    launched.setdefault(launcher, []).append(host)
+                    if subtree:
+                        # this is what task_fn does with its subtree
+                        pending.append((host, driver_service._subtree_commands(
+                            driver_service._split_subtrees(subtree, fanout),
+                            len(all_host_names), driver_addresses, settings)))
+        return launched, local
+
+    def test_launch_task_servers_fanout(self):
+        all_host_names = ['localhost'] + ['host-{}'.format(index) for index in range(1, 10)]
+        remote_host_names = all_host_names[1:]
+
+        # without a fanout, the driver launches all remote hosts
+        launched, local = self._launch_tree(all_host_names, {'localhost'}, 0)
+        self.assertEqual(launched, {None: remote_host_names})
+        self.assertEqual(local, [0])
+
+        for fanout in [1, 2, 3, len(remote_host_names), len(remote_host_names) + 5]:
+            with self.subTest(fanout=fanout):
+                launched, local = self._launch_tree(all_host_names, {'localhost'}, fanout)
+                self.assertEqual(local, [0])
+
+                # every remote host is launched exactly once
+                hosts = list(itertools.chain(*launched.values()))
+                self.assertEqual(sorted(hosts), sorted(remote_host_names))
+
+                # nobody opens more than fanout ssh sessions
+                for launcher, hosts in launched.items():
+                    self.assertLessEqual(len(hosts), fanout, launcher)
+                self.assertEqual(len(launched[None]), min(fanout, len(remote_host_names)))
+
+        # fanout 1 launches the hosts in a chain
+        launched, _ = self._launch_tree(all_host_names, {'localhost'}, 1)
+        chain = [launched[None][0]]
+        while chain[-1] in launched:
+            chain.extend(launched[chain[-1]])
+        self.assertEqual(chain, remote_host_names)
+
+    """
+    Runs horovodrun up to the interface check on the given hosts, with the
+    cache folder in cache_dir, and returns how often the interfaces were probed.
+    """
+    def _run_interface_check(self, cache_dir, *args):
+        with override_args('horovodrun', *args, 'true'):
+            args = parse_args()
+
+        with mock.patch('horovod.runner.launch.CACHE_FOLDER', cache_dir), \
+                mock.patch('horovod.runner.launch.network.filter_local_addresses',
+                           side_effect=lambda host_names: host_names), \
+                mock.patch('horovod.runner.launch._check_all_hosts_ssh_successful',
+                           return_value=True), \
+                mock.patch('horovod.runner.launch._launch_job') as launch_job, \
+                mock.patch('horovod.runner.util.lsf.LSFUtils.using_lsf', return_value=False), \
+                mock.patch('horovod.runner.driver.driver_service.HorovodRunDriverService'), \
+                mock.patch('horovod.runner.driver.driver_service._launch_task_servers') as launch_servers, \
+                mock.patch('horovod.runner.driver.driver_service._run_probe',
+                           return_value={'eth0'}) as probe:
+            _run_static(args)
+
+            launch_job.assert_called_once()
+            self.assertEqual(set(launch_job.call_args[0][2]), {'eth0'})
+            self.assertEqual(launch_servers.call_count, probe.call_count)
+            return probe.call_count
+
+    def test_interface_check_cache(self):
+        with tempdir() as cache_dir:
+            # the first run probes the interfaces
+            self.assertEqual(self._run_interface_check(cache_dir, '-np', '2', '-H', 'host-1:1,host-2:1'), 1)
+
+            # -np, the slots and the order of the hosts do not change the interfaces
+            self.assertEqual(self._run_interface_check(cache_dir, '-np', '2', '-H', 'host-1:1,host-2:1'), 0)
+            self.assertEqual(self._run_interface_check(cache_dir, '-np', '4', '-H', 'host-1:2,host-2:2'), 0)
+            self.assertEqual(self._run_interface_check(cache_dir, '-np', '2', '-H', 'host-2:1,host-1:1'), 0)
+
+            # a different set of hosts is probed
+            self.assertEqual(self._run_interface_check(cache_dir, '-np', '3', '-H', 'host-1:1,host-2:1,host-3:1'), 1)
+            self.assertEqual(self._run_interface_check(cache_dir, '-np', '3', '-H', 'host-1:1,host-2:1,host-3:1'), 0)
+
+            # a different ssh port invalidates the cache
+            self.assertEqual(self._run_interface_check(cache_dir, '-np', '2', '-H', 'host-1:1,host-2:1', '-p', '2222'), 1)
+            self.assertEqual(self._run_interface_check(cache_dir, '-np', '2', '-H', 'host-1:1,host-2:1', '-p', '2222'), 0)
+
+            # the cache can be disabled
+            self.assertEqual(self._run_interface_check(cache_dir, '-np', '2', '-H', 'host-1:1,host-2:1', '-p', '2222',
+                                                       '--disable-cache'), 1)
+
+            # a stale cache entry is probed again
+            with mock.patch('horovod.runner.launch.CACHE_STALENESS_THRESHOLD_MINUTES', 0):
+                self.assertEqual(self._run_interface_check(cache_dir, '-np', '2', '-H', 'host-1:1,host-2:1', '-p', '2222'), 1)
+
     """
     Tests js_run.
     """
@@ -18,12 +18,14 @@ import queue
 import threading
 import time
 import unittest
+import urllib.request
 import warnings
 
 import pytest
 
 from horovod.runner.common.service.task_service import BasicTaskClient, BasicTaskService
 from horovod.runner.common.util import network, secret
+from horovod.runner.http.http_server import RendezvousServer
 from horovod.runner.util.threads import in_thread
 from horovod.runner.util.streams import Pipe
 
@@ -201,3 +203,88 @@ class NetworkTests(unittest.TestCase):
             self.assertGreaterEqual(duration, 2)
         finally:
             service.shutdown()
+
+
+class RendezvousTests(unittest.TestCase):
+    """
+    Tests for the long-polling GET of horovod.runner.http.http_server.RendezvousServer.
+    """
+
+    def __init__(self, *args, **kwargs):
+        super(RendezvousTests, self).__init__(*args, **kwargs)
+        warnings.simplefilter('module')
+
+    def setUp(self):
+        self.server = RendezvousServer()
+        self.port = self.server.start()
+
+    def tearDown(self):
+        self.server.stop()
+
+    def put(self, scope, key, value):
+        request = urllib.request.Request('http://127.0.0.1:{}/{}/{}'.format(self.port, scope, key),
+                                         data=value, method='PUT')
+        with urllib.request.urlopen(request) as response:
+            self.assertEqual(200, response.status)
+
+    def get_keys(self, scope, keys, wait):
+        url = 'http://127.0.0.1:{}/{}/?keys={}&wait={}'.format(self.port, scope, ','.join(keys), wait)
+        with urllib.request.urlopen(url) as response:
+            self.assertEqual(200, response.status)
+            body = response.read()
+
+        # decode "<key length>:<value length>:<key><value>" entries
+        found = {}
+        while body:
+            key_len, value_len, body = body.split(b':', 2)
+            key_len, value_len = int(key_len), int(value_len)
+            found[body[:key_len].decode()] = body[key_len:key_len + value_len]
+            body = body[key_len + value_len:]
+        return found
+
+    def test_get_keys_present(self):
+        self.put('global', 'rank_0', b'value:0')
+        self.put('global', 'rank_1', b'')
+
+        start = time.time()
+        found = self.get_keys('global', ['rank_0', 'rank_1'], 5000)
+        duration = time.time() - start
+
+        self.assertEqual({'rank_0': b'value:0', 'rank_1': b''}, found)
+        self.assertLess(duration, 1.0, 'present keys should be returned without waiting')
+
+    def test_get_keys_set_while_waiting(self):
+        self.put('global', 'rank_0', b'value 0')
+
+        def put_later():
+            time.sleep(1.0)
+            self.put('global', 'rank_1', b'value 1')
+
+        thread = in_thread(put_later, daemon=False)
+        try:
+            start = time.time()
+            found = self.get_keys('global', ['rank_0', 'rank_1'], 5000)
+            duration = time.time() - start
+        finally:
+            thread.join()
+
+        self.assertEqual({'rank_0': b'value 0', 'rank_1': b'value 1'}, found)
+        self.assertGreaterEqual(duration, 1.0)
+        self.assertLess(duration, 3.0, 'request should return once the key is set')
+
+    def test_get_keys_timeout(self):
+        self.put('global', 'rank_0', b'value 0')
+        self.put('local_host', 'rank_1', b'other scope')
+
+        start = time.time()
+        found = self.get_keys('global', ['rank_0', 'rank_1'], 1000)
+        duration = time.time() - start
+
+        self.assertEqual({'rank_0': b'value 0'}, found)
+        self.assertGreaterEqual(duration, 1.0)
+        self.assertLess(duration, 3.0, 'request should return after the wait time')
+
+        # without wait, the request returns immediately
+        start = time.time()
+        self.assertEqual({}, self.get_keys('global', ['rank_1'], 0))
+        self.assertLess(time.time() - start, 1.0)
@@ -14,6 +14,7 @@
 # ==============================================================================
 
 import copy
+import os
 import unittest
 import warnings
 
@@ -88,6 +89,47 @@ class TorchElasticTests(unittest.TestCase):
         assert state.batch == 21
         assert state.epoch == 11
 
+    def test_elastic_state_sharded_sync(self):
+        hvd.init()
+        rank = hvd.rank()
+        size = hvd.size()
+
+        # Even ranks hold the latest commit, odd ranks join as new workers
+        # with stale values and no commits.
+        def fill(value):
+            for w in model.state_dict().values():
+                w.fill_(value)
+
+        model = torch.nn.Sequential(torch.nn.Linear(4, 4), torch.nn.Linear(4, 3),
+                                    torch.nn.Linear(3, 2))
+        optimizer = torch.optim.SGD(model.parameters(), lr=0.1, momentum=0.9)
+        state = hvd.elastic.TorchState(model, optimizer, batch=20 + rank)
+
+        os.environ['HOROVOD_ELASTIC_SHARDED_SYNC'] = '1'
+        try:
+            fill(1.0)
+            state.commit()
+            if rank % 2 == 1:
+                fill(2.0 + rank)
+                state._commits = 0
+
+            # Every worker holding the latest commit sends a share of the state.
+            root_ranks = state._sync_root_ranks(hvd.allgather_object)
+            assert root_ranks == list(range(0, size, 2))
+            state._commits = 1 if rank % 2 == 0 else 0
+
+            state.sync()
+            for w in state.model.state_dict().values():
+                np.testing.assert_allclose(w, np.ones_like(w))
+            assert state.batch == 20
+            assert state._commits == 1
+
+            # The synced state is committed on all workers, so all of them are roots now.
+            state.commit()
+            assert state._sync_root_ranks(hvd.allgather_object) == list(range(size))
+        finally:
+            del os.environ['HOROVOD_ELASTIC_SHARDED_SYNC']
+
     def test_elastic_sampler(self):
         hvd.init()
 